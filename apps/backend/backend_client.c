@@ -44,6 +44,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdarg.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <errno.h>
 #include <signal.h>
@@ -55,6 +56,7 @@
 #include <sys/socket.h>
 #include <sys/param.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <assert.h>
@@ -67,28 +69,229 @@
 #include <clixon/clixon.h>
 
 #include "clixon_backend_handle.h"
+#include "clixon_backend_transaction.h"
 #include "backend_plugin.h"
 #include "backend_commit.h"
 #include "backend_client.h"
 #include "backend_handle.h"
+#include "backend_socket.h"
+#include "backend_push.h"
+#include "backend_rollback.h"
+#include "backend_partial_lock.h"
+#include "backend_private.h"
 
-/*! Find client by session-id 
- * @param[in] ce_list   List of clients
- * @param[in] id        Session id
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static int ce_notify_write_cb(int s, void *arg);
+
+/*! Free notification waiting to be written to client
+ * @param[in]  cn  Client notification
  */
-static struct client_entry *
-ce_find_byid(struct client_entry *ce_list,
-	     uint32_t            id)
+static int
+client_notify_free(struct client_notify *cn)
 {
-    struct client_entry *ce;
+    if (cn->cn_se)
+	stream_event_free(cn->cn_se);
+    else if (cn->cn_msg)
+	free(cn->cn_msg);
+    free(cn);
+    return 0;
+}
+
+/*! Free all notifications waiting to be written to client
+ * @param[in]  ce  Client entry
+ */
+int
+backend_client_notify_free(struct client_entry *ce)
+{
+    struct client_notify *cn;
+
+    while ((cn = ce->ce_notify) != NULL){
+	DELQ(cn, ce->ce_notify, struct client_notify *);
+	client_notify_free(cn);
+    }
+    ce->ce_notify_len = 0;
+    ce->ce_notify_off = 0;
+    if (ce->ce_notify_wreg){
+	clixon_event_unreg_fd(ce->ce_s, ce_notify_write_cb);
+	ce->ce_notify_wreg = 0;
+    }
+    return 0;
+}
+
+/*! Write notifications waiting to client
+ * If not blocking, write what the socket accepts and write the rest when the socket
+ * is writable, so that a client that does not read does not block the backend.
+ * @param[in]  ce     Client entry
+ * @param[in]  block  If set, write all notifications, eg before a reply
+ * @retval     0      OK
+ * @retval    -1      Error, errno is set if write error
+ */
+static int
+ce_notify_write(struct client_entry *ce,
+		int                  block)
+{
+    struct client_notify *cn;
+    char                 *buf;
+    size_t                len;
+    ssize_t               n;
+
+    while ((cn = ce->ce_notify) != NULL){
+	buf = (char*)cn->cn_msg;
+	len = ntohl(cn->cn_msg->op_len);
+	if ((n = send(ce->ce_s, buf + ce->ce_notify_off, len - ce->ce_notify_off,
+		      MSG_NOSIGNAL | (block?0:MSG_DONTWAIT))) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (!block && (errno == EAGAIN || errno == EWOULDBLOCK))
+		break;
+	    return -1;
+	}
+	ce->ce_notify_off += n;
+	if (ce->ce_notify_off < len)
+	    continue;
+	DELQ(cn, ce->ce_notify, struct client_notify *);
+	client_notify_free(cn);
+	ce->ce_notify_len--;
+	ce->ce_notify_off = 0;
+	ce->ce_notify_sent++;
+    }
+    /* Write the rest when socket is writable */
+    if (ce->ce_notify && !ce->ce_notify_wreg){
+	if (clixon_event_reg_fd_write(ce->ce_s, ce_notify_write_cb, (void*)ce,
+				      "client notify") < 0)
+	    return -1;
+	ce->ce_notify_wreg = 1;
+    }
+    else if (ce->ce_notify == NULL && ce->ce_notify_wreg){
+	clixon_event_unreg_fd(ce->ce_s, ce_notify_write_cb);
+	ce->ce_notify_wreg = 0;
+    }
+    return 0;
+}
+
+/*! Client socket is writable, write notifications waiting
+ * @param[in]  s    Socket
+ * @param[in]  arg  Client entry
+ */
+static int
+ce_notify_write_cb(int   s,
+		   void *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
 
-    for (ce = ce_list; ce; ce = ce->ce_next)
-	if (ce->ce_id == id)
-	    return ce;
-    return NULL;
+    if (ce_notify_write(ce, 0) < 0){
+	clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+	backend_client_notify_free(ce);
+    }
+    return 0;
+}
+
+/*! Write all notifications waiting to client, before a reply is written
+ * Notifications and replies are then not interleaved
+ * @param[in]  ce   Client entry
+ */
+static int
+ce_notify_flush(struct client_entry *ce)
+{
+    if (ce->ce_notify && ce_notify_write(ce, 1) < 0){
+	clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+	backend_client_notify_free(ce);
+    }
+    return 0;
+}
+
+/*! Add notification to write to client, apply queue limit
+ * The notify message of the event is shared with other clients if possible, see
+ * stream_event_get.
+ * If CLICON_BACKEND_NOTIFY_QUEUE notifications are waiting, the oldest is dropped, or 
+ * the client disconnected according to CLICON_BACKEND_NOTIFY_POLICY
+ * @param[in]  h      Clicon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  event  Event as XML
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+ce_notify_add(clicon_handle        h,
+	      struct client_entry *ce,
+	      cxobj               *event)
+{
+    int                   retval = -1;
+    struct client_notify *cn = NULL;
+    struct stream_event  *se;
+    struct clicon_msg    *msg;
+    cbuf                 *cb = NULL;
+    int                   max = 0;
+    char                 *policy;
+
+    if (clicon_option_exists(h, "CLICON_BACKEND_NOTIFY_QUEUE"))
+	max = clicon_option_int(h, "CLICON_BACKEND_NOTIFY_QUEUE");
+    if (max && ce->ce_notify_len >= max){
+	policy = clicon_option_str(h, "CLICON_BACKEND_NOTIFY_POLICY");
+	if (policy && strcmp(policy, "disconnect") == 0){
+	    clicon_log(LOG_WARNING, "client %d: %d notifications not read, disconnected",
+		       ce->ce_nr, ce->ce_notify_len);
+	    ce->ce_notify_dropped += ce->ce_notify_len + 1;
+	    backend_client_notify_free(ce);
+	    ce->ce_notify_closed = 1;
+	    /* Client is removed when end-of-file is read */
+	    shutdown(ce->ce_s, SHUT_RDWR);
+	    goto ok;
+	}
+	/* Drop oldest, but not if partly written */
+	cn = ce->ce_notify;
+	if (ce->ce_notify_off)
+	    cn = NEXTQ(struct client_notify *, cn);
+	ce->ce_notify_dropped++;
+	if (cn == ce->ce_notify && ce->ce_notify_off){ /* Drop new */
+	    cn = NULL;
+	    goto ok;
+	}
+	DELQ(cn, ce->ce_notify, struct client_notify *);
+	client_notify_free(cn);
+	ce->ce_notify_len--;
+    }
+    if ((cn = malloc(sizeof(*cn))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(cn, 0, sizeof(*cn));
+    if ((se = stream_event_get(event)) != NULL){ /* Shared with other clients */
+	if ((msg = stream_event_msg(se, FORMAT_XML)) == NULL)
+	    goto done;
+	cn->cn_se = stream_event_ref(se);
+	cn->cn_msg = msg;
+    }
+    else {
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (clicon_xml2cbuf(cb, event, 0, 0, -1) < 0)
+	    goto done;
+	if ((cn->cn_msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
+	    goto done;
+    }
+    ADDQ(cn, ce->ce_notify);
+    cn = NULL;
+    ce->ce_notify_len++;
+    if (ce->ce_notify_len > ce->ce_notify_max)
+	ce->ce_notify_max = ce->ce_notify_len;
+ ok:
+    retval = 0;
+ done:
+    if (cn)
+	client_notify_free(cn);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
 }
 
 /*! Stream callback for netconf stream notification (RFC 5277)
+ * The notification is queued and written when the client socket is writable
  * @param[in]  h     Clicon handle
  * @param[in]  op    0:event, 1:rm
  * @param[in]  event Event as XML
@@ -111,16 +314,49 @@ ce_event_cb(clicon_handle h,
 	    backend_client_rm(h, ce);
 	break;
     default:
-	if (send_msg_notify_xml(h, ce->ce_s, event) < 0){
+	if (ce->ce_notify_closed)
+	    break;
+	if (ce_notify_add(h, ce, event) < 0)
+	    break;
+	if (ce_notify_write(ce, 0) < 0){
 	    if (errno == ECONNRESET || errno == EPIPE){
 		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
 	    }
+	    backend_client_notify_free(ce);
 	    break;
 	}
     }
     return 0;
 }
 
+/*! Send notification to client, queued if the client socket is not writable
+ * Used for notifications not sent via streams, see ce_event_cb
+ * @param[in]  h      Clicon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  event  Notification as XML
+ * @retval     0      OK (or notification dropped)
+ * @retval    -1      Error
+ */
+int
+backend_client_notify(clicon_handle        h,
+		      struct client_entry *ce,
+		      cxobj               *event)
+{
+    if (ce->ce_notify_closed || ce->ce_s == 0)
+	return 0;
+    if (ce_notify_add(h, ce, event) < 0)
+	return -1;
+    if (ce_notify_write(ce, 0) < 0){
+	if (errno == ECONNRESET || errno == EPIPE){
+	    clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+	}
+	backend_client_notify_free(ce);
+    }
+    return 0;
+}
+
+static int rpc_async_client_rm(clicon_handle h, struct client_entry *ce);
+
 /*! Remove client entry state
  * Close down everything wrt clients (eg sockets, subscriptions)
  * Finally actually remove client struct in handle
@@ -132,26 +368,20 @@ int
 backend_client_rm(clicon_handle        h, 
 		  struct client_entry *ce)
 {
-    struct client_entry  *c;
-    struct client_entry  *c0;
-    struct client_entry **ce_prev;
-
     clicon_debug(1, "%s", __FUNCTION__);
     /* for all streams: XXX better to do it top-level? */
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
-    c0 = backend_client_list(h);
-    ce_prev = &c0; /* this points to stack and is not real backpointer */
-    for (c = *ce_prev; c; c = c->ce_next){
-	if (c == ce){
-	    if (ce->ce_s){
-		clixon_event_unreg_fd(ce->ce_s, from_client);
-		close(ce->ce_s);
-		ce->ce_s = 0;
-		xmldb_unlock_all(h, ce->ce_id);
-	    }
-	    break;
-	}
-	ce_prev = &c->ce_next;
+    backend_push_client_rm(h, ce);
+    rpc_async_client_rm(h, ce);
+    if (ce->ce_s){
+	backend_client_notify_free(ce);
+	clixon_event_unreg_fd(ce->ce_s, from_client);
+	close(ce->ce_s);
+	backend_client_sock_set(h, ce, 0);
+	xmldb_unlock_all(h, ce->ce_id);
+	xmldb_bulk_end_all(h, ce->ce_id);
+	backend_partial_lock_release(ce->ce_id);
+	backend_private_release(h, ce->ce_id);
     }
     return backend_client_delete(h, ce); /* actually purge it */
 }
@@ -292,6 +522,60 @@ clixon_stats_get_db(clicon_handle h,
     return retval;
 }
 
+/*! Get memory statistics of a subsystem
+ * @param[in]     name  Name of subsystem
+ * @param[in]     nr    Number of objects, eg yang statements
+ * @param[in]     sz    Size in bytes
+ * @param[out]    cb    Output buffer
+ */
+static int
+clixon_stats_mem1(char    *name,
+		  uint64_t nr,
+		  size_t   sz,
+		  cbuf    *cb)
+{
+    cprintf(cb, "<memory><name>%s</name><nr>%" PRIu64 "</nr>"
+	    "<size>%zu</size></memory>", name, nr, sz);
+    return 0;
+}
+
+/*! Get memory statistics of yang specs, NACM cache and stream replay buffers
+ * @param[in]     h     Clicon handle
+ * @param[out]    cb    Output buffer
+ * @see clixon_stats_get_db  for datastore caches
+ */
+static int
+clixon_stats_get_mem(clicon_handle h,
+		     cbuf         *cb)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    uint64_t   nr;
+    size_t     sz;
+
+    nr = 0; sz = 0;
+    if ((yspec = clicon_dbspec_yang(h)) != NULL &&
+	yang_stats(yspec, &nr, &sz) < 0)
+	goto done;
+    clixon_stats_mem1("yang", nr, sz, cb);
+    nr = 0; sz = 0;
+    if ((yspec = clicon_config_yang(h)) != NULL &&
+	yang_stats(yspec, &nr, &sz) < 0)
+	goto done;
+    clixon_stats_mem1("config-yang", nr, sz, cb);
+    nr = 0; sz = 0;
+    if (nacm_ruleset_stats(h, &nr, &sz) < 0)
+	goto done;
+    clixon_stats_mem1("nacm", nr, sz, cb);
+    nr = 0; sz = 0;
+    if (stream_replay_stats(h, &nr, &sz) < 0)
+	goto done;
+    clixon_stats_mem1("stream-replay", nr, sz, cb);
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Get system state-data, including streams and plugins
  * @param[in]     h       Clicon handle
  * @param[in]     xpath   XPath selection, may be used to filter early
@@ -325,8 +609,9 @@ client_statedata(clicon_handle h,
 	clicon_err(OE_UNIX, errno, "cbuf_new");
 	goto done;
     }
-    /* Add default state to config if present */
-    if (xml_default_recurse(*xret, 1) < 0)
+    /* Add default state to config if present, unless printed when serialized */
+    if (!xml_flag(*xret, XML_FLAG_REPORT_ALL) &&
+	xml_default_recurse(*xret, 1) < 0)
 	goto done;
     /* Add default global state */
     if (xml_global_defaults(h, *xret, nsc, xpath, yspec, 1) < 0)
@@ -391,6 +676,179 @@ client_statedata(clicon_handle h,
     goto done;
 }
 
+/*! Get the offset and limit attributes of get and get-config
+ * Clixon extension for paging of the nodes selected by xpath
+ * @param[in]  xe      Request: <get> or <get-config>
+ * @param[out] cbret   Return xml tree, <rpc-error.. if invalid attribute
+ * @param[out] offset  Number of selected nodes to skip, unchanged if no attribute
+ * @param[out] limit   Max number of selected nodes, unchanged if no attribute
+ * @retval     1       OK
+ * @retval     0       Invalid attribute, cbret set
+ * @retval    -1       Error
+ */
+static int
+client_get_page_attr(cxobj    *xe,
+		     cbuf     *cbret,
+		     uint32_t *offset,
+		     uint32_t *limit)
+{
+    int   retval = -1;
+    char *attr;
+    char *reason = NULL;
+    int   ret;
+
+    if ((attr = xml_find_value(xe, "offset")) != NULL){
+	if ((ret = parse_uint32(attr, offset, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_uint32");
+	    goto done;
+	}
+	if (ret == 0){
+	    if (netconf_bad_attribute(cbret, "application",
+				      "offset", "Unrecognized value of offset attribute") < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+    if ((attr = xml_find_value(xe, "limit")) != NULL){
+	if ((ret = parse_uint32(attr, limit, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_uint32");
+	    goto done;
+	}
+	if (ret == 0){
+	    if (netconf_bad_attribute(cbret, "application",
+				      "limit", "Unrecognized value of limit attribute") < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+    retval = 1;
+ done:
+    if (reason)
+	free(reason);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Send a whole datastore as get-config reply directly from the datastore file
+ *
+ * If the datastore file has the content of the datastore, and neither NACM nor default
+ * values apply to the reply, the content of the top-level element of the file is the
+ * reply. It is then sent to the client without reading or serializing the tree, see
+ * send_msg_reply_file
+ * Only files written without indentation (CLICON_XMLDB_PRETTY false) are sent, otherwise
+ * the reply would differ from the one serialized from the tree
+ * @param[in]  h      Clicon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  db     Datastore
+ * @retval     1      Reply sent, or client closed
+ * @retval     0      Reply not sent: not in sync, or unexpected file content
+ * @retval    -1      Error
+ */
+static int
+client_get_config_file(clicon_handle        h,
+		       struct client_entry *ce,
+		       char                *db)
+{
+    int         retval = -1;
+    char       *filename = NULL;
+    int         fd = -1;
+    struct stat st;
+    char        buf[128];
+    ssize_t     n;
+    char       *p;
+    off_t       start;
+    off_t       end;
+    cbuf       *cb = NULL;
+    int         ret;
+
+    if (clicon_nacm_cache(h) != NULL ||
+	clicon_optv(h)->co_xmldb_format != FORMAT_XML ||
+	clicon_optv(h)->co_xmldb_pretty ||
+	clicon_modst_cache_get(h, 1) != NULL)
+	goto nofile;
+    if ((ret = xmldb_file_synced(h, db)) < 0)
+	goto done;
+    if (ret == 0)
+	goto nofile;
+    if (xmldb_db2file(h, db, &filename) < 0)
+	goto done;
+    if ((fd = open(filename, O_RDONLY)) < 0)
+	goto nofile; /* Eg not created */
+    if (fstat(fd, &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat");
+	goto done;
+    }
+    /* Start tag of top-level element, eg <config clixon-sorted="1a2b3c4d"> */
+    if ((n = pread(fd, buf, sizeof(buf)-1, 0)) < 0){
+	clicon_err(OE_UNIX, errno, "pread");
+	goto done;
+    }
+    buf[n] = '\0';
+    p = buf;
+    while (isspace(*p))
+	p++;
+    if (strncmp(p, "<" DATASTORE_TOP_SYMBOL, strlen("<" DATASTORE_TOP_SYMBOL)) != 0)
+	goto nofile;
+    p += strlen("<" DATASTORE_TOP_SYMBOL);
+    if ((!isspace(*p) && *p != '>' && *p != '/') ||
+	(p = strchr(p, '>')) == NULL)
+	goto nofile;
+    if (*(p-1) == '/') /* Empty */
+	start = end = 0;
+    else{
+	start = p + 1 - buf;
+	/* End tag of top-level element at end of file */
+	end = st.st_size;
+	if ((n = pread(fd, buf, MIN(end, sizeof(buf)-1), end - MIN(end, sizeof(buf)-1))) < 0){
+	    clicon_err(OE_UNIX, errno, "pread");
+	    goto done;
+	}
+	while (n > 0 && isspace(buf[n-1])){
+	    n--;
+	    end--;
+	}
+	buf[n] = '\0';
+	end -= strlen("</" DATASTORE_TOP_SYMBOL ">");
+	if (end < start ||
+	    n < strlen("</" DATASTORE_TOP_SYMBOL ">") ||
+	    strcmp(&buf[n-strlen("</" DATASTORE_TOP_SYMBOL ">")], "</" DATASTORE_TOP_SYMBOL ">") != 0)
+	    goto nofile;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<rpc-reply xmlns=\"%s\"><%s>", NETCONF_BASE_NAMESPACE, NETCONF_OUTPUT_DATA);
+    clicon_debug(1, "%s %s len:%zu", __FUNCTION__, db, (size_t)(end-start));
+    ce_notify_flush(ce);
+    if (send_msg_reply_file(ce->ce_s, cbuf_get(cb), fd, start, end-start,
+			    "</" NETCONF_OUTPUT_DATA "></rpc-reply>") < 0){
+	switch (errno){
+	case EPIPE: /* See from_client_msg */
+	case ECONNRESET:
+	    clicon_log(LOG_WARNING, "client rpc reset");
+	    break;
+	default:
+	    goto done;
+	}
+    }
+    ce->ce_reply_sent = 1;
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (fd != -1)
+	close(fd);
+    if (filename)
+	free(filename);
+    return retval;
+ nofile:
+    retval = 0;
+    goto done;
+}
+
 /*! Retrieve all or part of a specified configuration.
  * 
  * Function reused from both from_client_get() and from_client_get_config
@@ -400,9 +858,14 @@ client_statedata(clicon_handle h,
  * @param[in]  username
  * @param[in]  content
  * @param[in]  depth
+ * @param[in]  offset  Skip this number of nodes selected by xpath (if limit > 0)
+ * @param[in]  limit   Max number of nodes selected by xpath, 0 means all
+ * @param[in]  explicit Only values set explicitly, no default values
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
  * @retval     0       OK
  * @retval    -1       Error
+ * If there is no NACM the page is read directly from the datastore, see xmldb_get_page,
+ * otherwise the page is made of the nodes remaining after NACM read access control.
  * @see from_client_get
  */
 static int
@@ -413,6 +876,9 @@ client_get_config_only(clicon_handle h,
 		       char         *xpath,
 		       char         *username,
 		       int32_t       depth,
+		       uint32_t      offset,
+		       uint32_t      limit,
+		       int           explicit,
 		       cbuf         *cbret)
 {
     int     retval = -1;
@@ -420,18 +886,31 @@ client_get_config_only(clicon_handle h,
     cxobj  *xnacm = NULL;
     cxobj **xvec = NULL;
     size_t  xlen;    
+    int     i;
 
+    xnacm = clicon_nacm_cache(h);
+    if (limit && xnacm == NULL){
+	/* Paging in the datastore: only the page is copied */
+	if (xmldb_get_page(h, db, nsc, xpath, offset, limit, &xret) < 0) {
+	    if (netconf_operation_failed(cbret, "application", "read registry")< 0)
+		goto done;
+	    goto ok;
+	}
+	limit = 0; /* Page done */
+    }
     /* Note xret can be pruned by nacm below (and change name),
      * so zero-copy cant be used
      * Also, must use external namespace context here due to <filter stmt
      */
-    if (xmldb_get0(h, db, YB_MODULE, nsc, xpath, 1, &xret, NULL) < 0) {
+    else if (xmldb_get0(h, db, YB_MODULE, nsc, xpath, 1, &xret, NULL) < 0) {
 	if (netconf_operation_failed(cbret, "application", "read registry")< 0)
 	    goto done;
 	goto ok;
     }
+    /* Remove default values from the copy */
+    if (explicit && xmldb_get0_clear(h, xret) < 0)
+	goto done;
     /* Pre-NACM access step */
-    xnacm = clicon_nacm_cache(h);
     if (xnacm != NULL){ /* Do NACM validation */
 	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
 	    goto done;
@@ -439,6 +918,20 @@ client_get_config_only(clicon_handle h,
 	if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0) 
 	    goto done;
     }
+    /* Page of the nodes selected by xpath: remove the nodes before and after.
+     * In reverse document order, so that descendants are removed before ancestors */
+    if (limit && xret){
+	if (xvec){
+	    free(xvec);
+	    xvec = NULL;
+	}
+	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+	    goto done;
+	for (i = xlen-1; i >= 0; i--)
+	    if ((size_t)i < offset || (size_t)i >= (size_t)offset + limit)
+		if (xml_purge(xvec[i]) < 0)
+		    goto done;
+    }
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
     if (xret==NULL)
 	cprintf(cbret, "<data/>");
@@ -459,6 +952,55 @@ client_get_config_only(clicon_handle h,
     return retval;
 }
 
+/*! Retrieve config of the nodes selected by a RESTCONF api-path
+ *
+ * The nodes are looked up by list keys in the datastore cache, no xpath is parsed or
+ * evaluated. Only without NACM, since read access control is made with xpath.
+ * @param[in]  h        Clicon handle
+ * @param[in]  db       Datastore
+ * @param[in]  api_path According to restconf (Sec 3.5.3.1 in rfc8040)
+ * @param[in]  depth    Nr of levels to print, -1 is all
+ * @param[out] cbret    Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @retval     1        OK, cbret set
+ * @retval     0        Not done, use xpath, see client_get_config_only
+ * @retval    -1        Error
+ * @see xmldb_get_api_path
+ */
+static int
+client_get_api_path(clicon_handle h,
+		    char         *db,
+		    char         *api_path,
+		    int32_t       depth,
+		    cbuf         *cbret)
+{
+    int    retval = -1;
+    cxobj *xret = NULL;
+    int    ret;
+
+    if ((ret = xmldb_get_api_path(h, db, api_path, &xret)) < 0){
+	if (netconf_operation_failed(cbret, "application", "read registry")< 0)
+	    goto done;
+	goto ok;
+    }
+    if (ret == 0)
+	goto fail;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
+	goto done;
+    if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
+	goto done;
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 1;
+ done:
+    if (xret)
+	xml_free(xret);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Retrieve all or part of a specified configuration.
  * 
  * @param[in]  h       Clicon handle 
@@ -468,6 +1010,9 @@ client_get_config_only(clicon_handle h,
  * @param[in]  regarg  User argument given at rpc_callback_register() 
  * @retval     0       OK
  * @retval    -1       Error
+ * Clixon extension: attribute defaults="false" gives only values set explicitly.
+ * Then the whole datastore is sent directly from its file if possible, see
+ * client_get_config_file
  * @see from_client_get
  */
 static int
@@ -478,6 +1023,7 @@ from_client_get_config(clicon_handle h,
 		       void         *regarg)
 {
     int        retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
     char      *db;
     cxobj     *xfilter;
     char      *xpath = NULL;
@@ -490,6 +1036,9 @@ from_client_get_config(clicon_handle h,
     char      *attr;
     char      *xpath0;
     cvec      *nsc1 = NULL;
+    uint32_t   offset = 0;
+    uint32_t   limit = 0; /* Nr of xpath nodes returned, 0 is all */
+    int        explicit = 0;
     
     username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
@@ -510,6 +1059,9 @@ from_client_get_config(clicon_handle h,
 	    goto done;
 	goto ok;
     }
+    /* Private candidate of session, if any */
+    if ((db = backend_private_db(h, ce->ce_id, db)) == NULL)
+	goto done;
     /* XXX should use prefix cf edit_config */
     if ((xfilter = xml_find(xe, "filter")) != NULL){
 	if ((xpath0 = xml_find_value(xfilter, "select"))==NULL)
@@ -541,7 +1093,32 @@ from_client_get_config(clicon_handle h,
 	    goto ok;
 	}
     }
-    if ((ret = client_get_config_only(h, nsc, yspec, db, xpath, username, -1, cbret)) < 0)
+    /* Clixon extensions: offset and limit for paging of the nodes selected by xpath */
+    if ((ret = client_get_page_attr(xe, cbret, &offset, &limit)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    /* Clixon extension: defaults="false" gives no default values, not the
+     * with-defaults parameter of RFC 6243 */
+    if ((attr = xml_find_value(xe, "defaults")) != NULL){
+	if (strcmp(attr, "false") == 0)
+	    explicit = 1;
+	else if (strcmp(attr, "true") != 0){
+	    if (netconf_bad_attribute(cbret, "application",
+				      "defaults", "Unrecognized value of defaults attribute") < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    /* Whole datastore, eg backup: send the datastore file as is */
+    if (explicit && limit == 0 &&
+	(xpath == NULL || strcmp(xpath, "/") == 0)){
+	if ((ret = client_get_config_file(h, (struct client_entry *)arg, db)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+    }
+    if ((ret = client_get_config_only(h, nsc, yspec, db, xpath, username, -1, offset, limit, explicit, cbret)) < 0)
 	goto done;
  ok:
     retval = 0;
@@ -555,44 +1132,426 @@ from_client_get_config(clicon_handle h,
     return retval;
 }
 
-/*! Loads all or part of a specified configuration to target configuration
+/*! Apply a configuration edit to a datastore
  * 
- * @param[in]  h       Clicon handle 
- * @param[in]  xe      Request: <rpc><xn></rpc> 
- * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
- * @param[in]  arg     client-entry
- * @param[in]  regarg  User argument given at rpc_callback_register() 
- * @retval     0       OK
- * @retval    -1       Error
+ * Common to edit-config and edit-batch
+ * @param[in]  h         Clicon handle 
+ * @param[in]  yspec     Yang spec
+ * @param[in]  target    Target datastore
+ * @param[in]  operation Default operation
+ * @param[in]  xc        Edit: <config>...</config>. Bound to yang and sorted
+ * @param[in]  username  User for NACM
+ * @param[in]  id        Session id of edit, for partial locks
+ * @param[out] cbret     Error reply if failed
+ * @retval     1         OK
+ * @retval     0         Failed, error in cbret
+ * @retval    -1         Error
  */
 static int
-from_client_edit_config(clicon_handle h,
-			cxobj        *xn,
-			cbuf         *cbret,
-			void         *arg,
-			void         *regarg)
+client_edit_put(clicon_handle       h,
+		yang_stmt          *yspec,
+		char               *target,
+		enum operation_type operation,
+		cxobj              *xc,
+		char               *username,
+		uint32_t            id,
+		cbuf               *cbret)
 {
-    int                 retval = -1;
-    struct client_entry *ce = (struct client_entry *)arg;
-    uint32_t            myid = ce->ce_id;
-    uint32_t            iddb;
-    char               *target;
-    cxobj              *xc;
-    cxobj              *x;
-    enum operation_type operation = OP_MERGE;
-    int                 non_config = 0;
-    yang_stmt          *yspec;
-    cbuf               *cbx = NULL; /* Assist cbuf */
-    int                 ret;
-    char               *username;
-    cxobj              *xret = NULL;
-    char               *attr;
-    int                 autocommit = 0;
-    char               *val = NULL;
-    cvec               *nsc = NULL;
-    char               *prefix = NULL;
+    int    retval = -1;
+    cxobj *xret = NULL;
+    int    ret;
 
-    username = clicon_username_get(h);
+    /* <config> yang spec may be set to anyxml by ingress yang check,...*/
+    if (xml_spec(xc) != NULL)
+	xml_spec_set(xc, NULL);
+    /* Populate XML with Yang spec (why not do this in parser?) 
+     */
+    if ((ret = xml_bind_yang(xc, YB_MODULE, yspec, &xret)) < 0)
+	goto done;
+    if (ret == 0){
+	if (clicon_xml2cbuf(cbret, xret, 0, 0, -1) < 0)
+	    goto done;
+	goto fail;
+    }
+    /* (Mark all nodes that are not configure data and) set return */
+    if ((ret = xml_non_config_data(xc, &xret)) < 0)
+	goto done;
+    if (ret == 0){
+	if (clicon_xml2cbuf(cbret, xret, 0, 0, -1) < 0)
+	    goto done;
+	goto fail;
+    }
+    /* xmldb_put (difflist handling) requires list keys */
+    if ((ret = xml_yang_validate_list_key_only(xc, &xret)) < 0)
+	goto done;
+    if (ret == 0){
+	if (clicon_xml2cbuf(cbret, xret, 0, 0, -1) < 0)
+	    goto done;
+	goto fail;
+    }
+    /* Cant do this earlier since we dont have a yang spec to
+     * the upper part of the tree, until we get the "config" tree.
+     */
+    if (xml_sort_recurse(xc) < 0)
+	goto done;
+    /* Nodes of running locked by other sessions, RFC 5717 */
+    if (strcmp(target, "running") == 0){
+	if ((ret = backend_partial_lock_edit(h, id, operation, xc, cbret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    if ((ret = xmldb_put(h, target, operation, xc, username, cbret)) < 0){
+	clicon_debug(1, "%s ERROR PUT", __FUNCTION__);	
+	if (netconf_operation_failed(cbret, "protocol", clicon_err_reason)< 0)
+	    goto done;
+	goto fail;
+    }
+    if (ret == 0)
+	goto fail;
+    retval = 1;
+ done:
+    if (xret)
+	xml_free(xret);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/* Autocommit edit waiting for a coalesced commit, see CLICON_COMMIT_COALESCE */
+struct coalesce_edit{
+    qelem_t              co_q;        /* queue header */
+    struct client_entry *co_ce;       /* Suspended client */
+    int                  co_ce_nr;    /* Client number, in case ce is freed and reused */
+    char                *co_target;   /* Target datastore of edit */
+    enum operation_type  co_op;       /* Default operation of edit */
+    cxobj               *co_xc;       /* Copy of config of edit, if committed alone */
+    char                *co_username; /* User of edit, for NACM */
+    int                  co_copystartup; /* Copy running to startup after commit */
+    char                *co_existed;  /* objectexisted reply attribute, or NULL */
+    cbuf                *co_reply;    /* Reply, empty if ok */
+};
+
+/* Autocommit edits of the current coalescing window */
+static struct coalesce_edit *_coalesce_list = NULL;
+
+static int client_exists(clicon_handle h, struct client_entry *ce, int nr);
+static int from_client_buffered(clicon_handle h, struct client_entry *ce);
+
+/*! Copy config of an edit, including namespace declarations of its ancestors
+ * @param[in]  xc   Config element of edit-config
+ * @param[in]  nsc  Namespace context of edit-config element
+ * @retval     xdup Copy of config, free with xml_free
+ * @retval     NULL Error
+ */
+static cxobj *
+commit_coalesce_dup(cxobj *xc,
+		    cvec  *nsc)
+{
+    cxobj  *xdup;
+    cg_var *cv = NULL;
+    char   *prefix;
+
+    if ((xdup = xml_dup(xc)) == NULL)
+	return NULL;
+    while ((cv = cvec_each(nsc, cv)) != NULL){
+	if ((prefix = cv_name_get(cv)) != NULL){
+	    if (xml_find_type_value(xdup, "xmlns", prefix, CX_ATTR) != NULL)
+		continue;
+	}
+	else if (xml_find_type_value(xdup, NULL, "xmlns", CX_ATTR) != NULL)
+	    continue;
+	if (xmlns_set(xdup, prefix, cv_string_get(cv)) < 0){
+	    xml_free(xdup);
+	    return NULL;
+	}
+    }
+    return xdup;
+}
+
+static void
+commit_coalesce_free(struct coalesce_edit *co)
+{
+    if (co->co_target)
+	free(co->co_target);
+    if (co->co_xc)
+	xml_free(co->co_xc);
+    if (co->co_username)
+	free(co->co_username);
+    if (co->co_existed)
+	free(co->co_existed);
+    if (co->co_reply)
+	cbuf_free(co->co_reply);
+    free(co);
+}
+
+/*! Commit candidate to running as in autocommit, reset candidate on failure
+ * @param[in]  h       Clicon handle
+ * @param[out] cbret   Error reply if commit failed
+ * @retval     1       Committed
+ * @retval     0       Commit failed, error in cbret
+ * @retval    -1       Error
+ */
+static int
+commit_coalesce_commit(clicon_handle h,
+		       cbuf         *cbret)
+{
+    int ret;
+
+    if ((ret = candidate_commit(h, "candidate", cbret)) < 0){ /* Assume validation fail, nofatal */
+	if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
+	    return -1;
+	xmldb_copy(h, "running", "candidate");
+	return 0;
+    }
+    if (ret == 0){ /* discard */
+	if (xmldb_copy(h, "running", "candidate") < 0 &&
+	    netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
+	    return -1;
+	return 0;
+    }
+    return 1;
+}
+
+/*! End of coalescing window: commit all queued autocommit edits and reply
+ *
+ * All edits are committed in one transaction. If that fails, candidate is reset
+ * and every edit is applied and committed by itself, in the order received, so
+ * that only the failing edits get an error reply.
+ * Clients are resumed after all commits are done.
+ * @param[in]  s     Not used
+ * @param[in]  arg   Clicon handle
+ */
+static int
+commit_coalesce_timeout(int   s,
+			void *arg)
+{
+    int                   retval = -1;
+    clicon_handle         h = (clicon_handle)arg;
+    struct coalesce_edit *list;
+    struct coalesce_edit *co;
+    struct client_entry  *ce;
+    yang_stmt            *yspec;
+    cbuf                 *cb = NULL;
+    char                 *username;
+    int                   copystartup = 0;
+    int                   ret;
+
+    list = _coalesce_list;
+    _coalesce_list = NULL;
+    if (list == NULL)
+	return 0;
+    clicon_debug(1, "%s", __FUNCTION__);
+    if ((yspec =  clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec9");
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((ret = commit_coalesce_commit(h, cb)) < 0)
+	goto done;
+    if (ret == 0){
+	/* Commit each edit alone, candidate is now reset to running */
+	username = clicon_username_get(h);
+	co = list;
+	do {
+	    clicon_username_set(h, co->co_username);
+	    if ((ret = client_edit_put(h, yspec, co->co_target, co->co_op, co->co_xc,
+				       co->co_username, 0, co->co_reply)) < 0)
+		goto done;
+	    if (ret == 1){
+		xmldb_modified_set(h, co->co_target, 1); /* mark as dirty */
+		if ((ret = commit_coalesce_commit(h, co->co_reply)) < 0)
+		    goto done;
+	    }
+	    co = NEXTQ(struct coalesce_edit *, co);
+	} while (co != list);
+	clicon_username_set(h, username);
+    }
+    /* Clixon extension: copy, once for all committed edits */
+    co = list;
+    do {
+	if (co->co_copystartup && cbuf_len(co->co_reply) == 0)
+	    copystartup++;
+	co = NEXTQ(struct coalesce_edit *, co);
+    } while (co != list);
+    cbuf_reset(cb);
+    if (copystartup &&
+	xmldb_copy(h, "running", "startup") < 0 &&
+	netconf_operation_failed(cb, "application", clicon_err_reason)< 0)
+	goto done;
+    /* Datastore files written by the commits, see CLICON_XMLDB_SYNC */
+    if (xmldb_sync(h) < 0){
+	cbuf_reset(cb);
+	if (netconf_operation_failed(cb, "application", clicon_err_reason)< 0)
+	    goto done;
+	copystartup = -1; /* All fail */
+    }
+    while ((co = list) != NULL){
+	DELQ(co, list, struct coalesce_edit *);
+	if (cbuf_len(co->co_reply) == 0){
+	    if ((co->co_copystartup || copystartup < 0) && cbuf_len(cb))
+		cprintf(co->co_reply, "%s", cbuf_get(cb));
+	    else{
+		cprintf(co->co_reply, "<rpc-reply xmlns=\"%s\"><ok", NETCONF_BASE_NAMESPACE);
+		if (co->co_existed)
+		    cprintf(co->co_reply, " objectexisted=\"%s\"", co->co_existed);
+		cprintf(co->co_reply, "/></rpc-reply>");
+	    }
+	}
+	ce = co->co_ce;
+	if (client_exists(h, ce, co->co_ce_nr) && ce->ce_s){
+	    if (send_msg_reply(ce->ce_s, cbuf_get(co->co_reply), cbuf_len(co->co_reply)+1) < 0){
+		if (errno != ECONNRESET && errno != EPIPE){
+		    commit_coalesce_free(co);
+		    goto done;
+		}
+		clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+	    }
+	    ce->ce_suspended = 0;
+	    if (clixon_event_reg_fd(ce->ce_s, from_client, (void*)ce, "local netconf client socket") < 0){
+		commit_coalesce_free(co);
+		goto done;
+	    }
+	    /* Requests received while suspended */
+	    if (from_client_buffered(h, ce) < 0){
+		commit_coalesce_free(co);
+		goto done;
+	    }
+	}
+	commit_coalesce_free(co);
+    }
+    retval = 0;
+ done:
+    while ((co = list) != NULL){
+	DELQ(co, list, struct coalesce_edit *);
+	commit_coalesce_free(co);
+    }
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Queue an autocommit edit to the commit of the current coalescing window
+ *
+ * The edit has been applied to candidate. The client is suspended until the
+ * window ends and the reply is sent, see commit_coalesce_timeout
+ * @param[in]  h           Clicon handle
+ * @param[in]  ce          Client entry
+ * @param[in]  target      Target datastore of edit
+ * @param[in]  op          Default operation of edit
+ * @param[in]  xc          Copy of config of edit, consumed
+ * @param[in]  copystartup Copy running to startup after commit
+ * @retval     0           OK
+ * @retval    -1           Error
+ * @see CLICON_COMMIT_COALESCE
+ */
+static int
+commit_coalesce_add(clicon_handle        h,
+		    struct client_entry *ce,
+		    char                *target,
+		    enum operation_type  op,
+		    cxobj               *xc,
+		    int                  copystartup)
+{
+    int                   retval = -1;
+    struct coalesce_edit *co = NULL;
+    char                 *username;
+    char                 *val = NULL;
+    struct timeval        t;
+    struct timeval        t1;
+    int                   ms;
+
+    if ((co = malloc(sizeof(*co))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(co, 0, sizeof(*co));
+    co->co_xc = xc;
+    xc = NULL;
+    co->co_ce = ce;
+    co->co_ce_nr = ce->ce_nr;
+    co->co_op = op;
+    co->co_copystartup = copystartup;
+    if ((co->co_target = strdup(target)) == NULL ||
+	((username = clicon_username_get(h)) != NULL &&
+	 (co->co_username = strdup(username)) == NULL) ||
+	(clicon_data_get(h, "objectexisted", &val) == 0 &&
+	 (co->co_existed = strdup(val)) == NULL)){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if ((co->co_reply = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    /* First edit of window starts the window */
+    if (_coalesce_list == NULL){
+	ms = clicon_option_int(h, "CLICON_COMMIT_COALESCE");
+	gettimeofday(&t, NULL);
+	t1.tv_sec = ms/1000;
+	t1.tv_usec = (ms%1000)*1000;
+	timeradd(&t, &t1, &t);
+	if (clixon_event_reg_timeout(t, commit_coalesce_timeout, h, "commit coalesce") < 0)
+	    goto done;
+    }
+    ADDQ(co, _coalesce_list);
+    co = NULL;
+    /* Suspend client until reply */
+    clixon_event_unreg_fd(ce->ce_s, from_client);
+    ce->ce_suspended = 1;
+    ce->ce_reply_sent = 1;
+    retval = 0;
+ done:
+    if (xc)
+	xml_free(xc);
+    if (co)
+	commit_coalesce_free(co);
+    return retval;
+}
+
+/*! Loads all or part of a specified configuration to target configuration
+ * 
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_edit_config(clicon_handle h,
+			cxobj        *xn,
+			cbuf         *cbret,
+			void         *arg,
+			void         *regarg)
+{
+    int                 retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    uint32_t            myid = ce->ce_id;
+    uint32_t            iddb;
+    char               *target;
+    char               *candidate;
+    cxobj              *xc;
+    cxobj              *x;
+    enum operation_type operation = OP_MERGE;
+    yang_stmt          *yspec;
+    cbuf               *cbx = NULL; /* Assist cbuf */
+    int                 ret;
+    char               *username;
+    char               *attr;
+    int                 autocommit = 0;
+    char               *val = NULL;
+    cvec               *nsc = NULL;
+    char               *prefix = NULL;
+    cxobj              *xdup = NULL;
+    int                 copystartup = 0;
+
+    username = clicon_username_get(h);
     if ((yspec =  clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_YANG, ENOENT, "No yang spec9");
 	goto done;
@@ -612,6 +1571,9 @@ from_client_edit_config(clicon_handle h,
 	    goto done;
 	goto ok;
     }
+    /* Private candidate of session, if any */
+    if ((target = backend_private_db(h, myid, target)) == NULL)
+	goto done;
     /* Check if target locked by other client */
     iddb = xmldb_islocked(h, target);
     if (iddb && myid != iddb){
@@ -648,73 +1610,54 @@ from_client_edit_config(clicon_handle h,
 	    goto done;
 	goto ok;
     }
-    /* <config> yang spec may be set to anyxml by ingress yang check,...*/
-    if (xml_spec(xc) != NULL)
-	xml_spec_set(xc, NULL);
-    /* Populate XML with Yang spec (why not do this in parser?) 
-     */
-    if ((ret = xml_bind_yang(xc, YB_MODULE, yspec, &xret)) < 0)
-	goto done;
-    if (ret == 0){
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, -1) < 0)
-	    goto done;
-	goto ok;
-    }
-    /* (Mark all nodes that are not configure data and) set return */
-    if ((ret = xml_non_config_data(xc, &xret)) < 0)
+    /* Clixon extension: autocommit */
+    if ((attr = xml_find_value(xn, "autocommit")) != NULL &&
+	strcmp(attr,"true")==0)
+	autocommit = 1;
+    /* Coalesce autocommit of candidate edits, keep a copy if committed alone */
+    if ((clicon_autocommit(h) || autocommit) &&
+	strcmp(target, "candidate") == 0 &&
+	clicon_option_int(h, "CLICON_COMMIT_COALESCE") > 0 &&
+	(xdup = commit_coalesce_dup(xc, nsc)) == NULL)
 	goto done;
-    if (ret == 0){
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, -1) < 0)
-	    goto done;
-	goto ok;
-    }
-    if (non_config){
-	if (netconf_invalid_value(cbret, "protocol", "State data not allowed")< 0)
-	    goto done;
-	goto ok;
-    }
-    /* xmldb_put (difflist handling) requires list keys */
-    if ((ret = xml_yang_validate_list_key_only(xc, &xret)) < 0)
+    if ((ret = client_edit_put(h, yspec, target, operation, xc, username, myid, cbret)) < 0)
 	goto done;
-    if (ret == 0){
-	if (clicon_xml2cbuf(cbret, xret, 0, 0, -1) < 0)
-	    goto done;
+    if (ret == 0)
 	goto ok;
-    }
-    /* Cant do this earlier since we dont have a yang spec to
-     * the upper part of the tree, until we get the "config" tree.
-     */
-    if (xml_sort_recurse(xc) < 0)
-	goto done;
-    if ((ret = xmldb_put(h, target, operation, xc, username, cbret)) < 0){
-	clicon_debug(1, "%s ERROR PUT", __FUNCTION__);	
-	if (netconf_operation_failed(cbret, "protocol", clicon_err_reason)< 0)
+    xmldb_modified_set(h, target, 1); /* mark as dirty */
+    if (xdup != NULL){
+	if ((attr = xml_find_value(xn, "copystartup")) != NULL &&
+	    strcmp(attr,"true") == 0)
+	    copystartup = 1;
+	ret = commit_coalesce_add(h, ce, target, operation, xdup, copystartup);
+	xdup = NULL;
+	if (ret < 0)
 	    goto done;
 	goto ok;
     }
-    if (ret == 0)
-	goto ok;
-    xmldb_modified_set(h, target, 1); /* mark as dirty */
-    /* Clixon extension: autocommit */
-    if ((attr = xml_find_value(xn, "autocommit")) != NULL &&
-	strcmp(attr,"true")==0)
-	autocommit = 1;
     /* If autocommit option is set or requested by client */
     if (clicon_autocommit(h) || autocommit) {
-	if ((ret = candidate_commit(h, "candidate", cbret)) < 0){ /* Assume validation fail, nofatal */
+	if ((candidate = backend_private_db(h, myid, "candidate")) == NULL)
+	    goto done;
+	if ((ret = backend_private_rebase(h, myid, cbret)) < 0)
+	    goto done;
+	if (ret == 1 &&
+	    (ret = candidate_commit(h, candidate, cbret)) < 0){ /* Assume validation fail, nofatal */
 	    if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
 		goto done;
-	    xmldb_copy(h, "running", "candidate");
+	    backend_private_discard(h, myid);
 	    goto ok;
 	}
 	if (ret == 0){ /* discard */
-	    if (xmldb_copy(h, "running", "candidate") < 0){
+	    if (backend_private_discard(h, myid) < 0){
 		if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
 		    goto done;
 		goto ok;
 	    }
 	    goto ok;
 	}
+	if (backend_private_reset(h, myid) < 0)
+	    goto done;
     }
     /* Clixon extension: copy */
     if ((attr = xml_find_value(xn, "copystartup")) != NULL &&
@@ -733,10 +1676,10 @@ from_client_edit_config(clicon_handle h,
  ok:
     retval = 0;
  done:
+    if (xdup)
+	xml_free(xdup);
     if (nsc)
 	cvec_free(nsc);
-    if (xret)
-	xml_free(xret);
     if (cbx)
 	cbuf_free(cbx);
     clicon_debug(1, "%s done cbret:%s", __FUNCTION__, cbuf_get(cbret));	
@@ -744,7 +1687,11 @@ from_client_edit_config(clicon_handle h,
     
 } /* from_client_edit_config */
 
-/*! Create or replace an entire config with another complete config db
+/*! Apply many independent edits to a datastore in one request
+ *
+ * Each edit is applied as in edit-config, without autocommit. The edits are applied
+ * to the datastore cache and the datastore file is written once after the last edit,
+ * as in a bulk load, unless a bulk load is already active.
  * @param[in]  h       Clicon handle 
  * @param[in]  xe      Request: <rpc><xn></rpc> 
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
@@ -752,26 +1699,179 @@ from_client_edit_config(clicon_handle h,
  * @param[in]  regarg  User argument given at rpc_callback_register() 
  * @retval     0       OK
  * @retval    -1       Error
- * NACM: If source running and target startup --> only exec permission
- * else: 
- * - omit data nodes to which the client does not have read access
- * - access denied if user lacks create/delete/update
+ * @see from_client_edit_config
  */
 static int
-from_client_copy_config(clicon_handle h,
-			cxobj        *xe,
-			cbuf         *cbret,
-			void         *arg,
-			void         *regarg)
+from_client_edit_batch(clicon_handle h,
+		       cxobj        *xe,
+		       cbuf         *cbret,
+		       void         *arg,
+		       void         *regarg)
 {
-    int      retval = -1;
+    int                  retval = -1;
     struct client_entry *ce = (struct client_entry *)arg;
-    char    *source;
-    char    *target;
-    uint32_t iddb;
-    uint32_t myid = ce->ce_id;
-    cbuf    *cbx = NULL; /* Assist cbuf */
-    
+    uint32_t             myid = ce->ce_id;
+    uint32_t             iddb;
+    char                *target;
+    yang_stmt           *yspec;
+    cxobj               *xedit = NULL;
+    cxobj               *xc;
+    cxobj               *xerr = NULL;
+    cxobj               *xr;
+    cxobj               *x;
+    char                *id;
+    char                *str;
+    enum operation_type  operation;
+    cbuf                *cbx = NULL;
+    cbuf                *cbe = NULL;
+    cbuf                *cbr = NULL;
+    int                  bulk = 0;
+    int                  modified = 0;
+    int                  ret;
+
+    if ((yspec =  clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if ((target = xml_find_body(xe, "target")) == NULL)
+	target = "candidate";
+    if ((cbx = cbuf_new()) == NULL ||
+	(cbe = cbuf_new()) == NULL ||
+	(cbr = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }	
+    if (xmldb_validate_db(target) < 0){
+	cprintf(cbx, "No such database: %s", target);
+	if (netconf_invalid_value(cbret, "protocol", cbuf_get(cbx))< 0)
+	    goto done;
+	goto ok;
+    }
+    /* Private candidate of session, if any */
+    if ((target = backend_private_db(h, myid, target)) == NULL)
+	goto done;
+    /* Check if target locked by other client */
+    iddb = xmldb_islocked(h, target);
+    if (iddb && myid != iddb){
+	cprintf(cbx, "<session-id>%u</session-id>", iddb);
+	if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, lock is already held") < 0)
+	    goto done;
+	goto ok;
+    }
+    /* Write the datastore file once after all edits */
+    if (clicon_datastore_cache(h) != DATASTORE_NOCACHE &&
+	xmldb_bulk_get(h, target) == 0){
+	if (xmldb_bulk_begin(h, target, myid) < 0)
+	    goto done;
+	bulk++;
+    }
+    cprintf(cbr, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    while ((xedit = xml_child_each(xe, xedit, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(xedit), "edit") != 0)
+	    continue;
+	id = xml_find_body(xedit, "id");
+	cprintf(cbr, "<edit xmlns=\"%s\"><id>", CLIXON_LIB_NS);
+	if (xml_chardata_cbuf_append(cbr, id?id:"") < 0)
+	    goto done;
+	cprintf(cbr, "</id>");
+	cbuf_reset(cbe);
+	operation = OP_MERGE;
+	if ((str = xml_find_body(xedit, "default-operation")) != NULL &&
+	    xml_operation(str, &operation) < 0){
+	    if (netconf_invalid_value(cbe, "protocol", "Wrong operation")< 0)
+		goto done;
+	}
+	else if ((xc = xml_find_type(xedit, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) == NULL){
+	    if (netconf_missing_element(cbe, "protocol", NETCONF_INPUT_CONFIG, NULL) < 0)
+		goto done;
+	}
+	else {
+	    if ((ret = client_edit_put(h, yspec, target, operation, xc,
+				       clicon_username_get(h), myid, cbe)) < 0)
+		goto done;
+	    if (ret == 1)
+		modified++;
+	}
+	if (cbuf_len(cbe) == 0)
+	    cprintf(cbr, "<ok/>");
+	else {
+	    /* The error is a complete rpc-reply, return its rpc-error */
+	    if (clixon_xml_parse_string(cbuf_get(cbe), YB_NONE, NULL, &xerr, NULL) < 0)
+		goto done;
+	    cprintf(cbr, "<error>");
+	    if ((xr = xml_find_type(xerr, NULL, "rpc-reply", CX_ELMNT)) != NULL){
+		x = NULL;
+		while ((x = xml_child_each(xr, x, CX_ELMNT)) != NULL) {
+		    if (strcmp(xml_name(x), "rpc-error") != 0)
+			continue;
+		    if (xmlns_set(x, NULL, NETCONF_BASE_NAMESPACE) < 0)
+			goto done;
+		    if (clicon_xml2cbuf(cbr, x, 0, 0, -1) < 0)
+			goto done;
+		}
+	    }
+	    cprintf(cbr, "</error>");
+	    xml_free(xerr);
+	    xerr = NULL;
+	}
+	cprintf(cbr, "</edit>");
+    }
+    cprintf(cbr, "</rpc-reply>");
+    if (bulk){
+	bulk = 0;
+	if (xmldb_bulk_end(h, target) < 0){
+	    if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    if (modified)
+	xmldb_modified_set(h, target, 1); /* mark as dirty */
+    cprintf(cbret, "%s", cbuf_get(cbr));
+ ok:
+    retval = 0;
+ done:
+    if (bulk)
+	xmldb_bulk_end(h, target);
+    if (xerr)
+	xml_free(xerr);
+    if (cbx)
+	cbuf_free(cbx);
+    if (cbe)
+	cbuf_free(cbe);
+    if (cbr)
+	cbuf_free(cbr);
+    return retval;
+}
+
+/*! Create or replace an entire config with another complete config db
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * NACM: If source running and target startup --> only exec permission
+ * else: 
+ * - omit data nodes to which the client does not have read access
+ * - access denied if user lacks create/delete/update
+ */
+static int
+from_client_copy_config(clicon_handle h,
+			cxobj        *xe,
+			cbuf         *cbret,
+			void         *arg,
+			void         *regarg)
+{
+    int      retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    char    *source;
+    char    *target;
+    uint32_t iddb;
+    uint32_t myid = ce->ce_id;
+    cbuf    *cbx = NULL; /* Assist cbuf */
+    
     if ((source = netconf_db_find(xe, "source")) == NULL){
 	if (netconf_missing_element(cbret, "protocol", "source", NULL) < 0)
 	    goto done;
@@ -806,12 +1906,35 @@ from_client_copy_config(clicon_handle h,
 	    goto done;
 	goto ok;
     }
+    /* Replacing running replaces nodes partially locked by other clients */
+    if (strcmp(target, "running") == 0 &&
+	(iddb = backend_partial_lock_held(myid)) != 0){
+	cprintf(cbx, "<session-id>%u</session-id>", iddb);
+	if (netconf_lock_denied(cbret, cbuf_get(cbx), "Copy failed, partial lock is already held") < 0)
+	    goto done;
+	goto ok;
+    }
+    /* Copy of running to candidate resets a private candidate */
+    if (strcmp(source, "running") == 0 &&
+	strcmp(target, "candidate") == 0 &&
+	clicon_option_bool(h, "CLICON_PRIVATE_CANDIDATE")){
+	if ((target = backend_private_db(h, myid, target)) == NULL)
+	    goto done;
+	if (backend_private_reset(h, myid) < 0)
+	    goto done;
+	goto reply;
+    }
+    /* Private candidate of session, if any */
+    if ((source = backend_private_db(h, myid, source)) == NULL ||
+	(target = backend_private_db(h, myid, target)) == NULL)
+	goto done;
     if (xmldb_copy(h, source, target) < 0){
 	if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
 	    goto done;
 	goto ok;
     }
     xmldb_modified_set(h, target, 1); /* mark as dirty */
+ reply:
     cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
  ok:
     retval = 0;
@@ -861,6 +1984,9 @@ from_client_delete_config(clicon_handle h,
 	    goto done;
 	goto ok;
     }
+    /* Private candidate of session, if any */
+    if ((target = backend_private_db(h, myid, target)) == NULL)
+	goto done;
     /* Check if target locked by other client */
     iddb = xmldb_islocked(h, target);
     if (iddb && myid != iddb){
@@ -938,6 +2064,14 @@ from_client_lock(clicon_handle h,
 	    goto done;
 	goto ok;
     }
+    /* Or a partial lock of running is held by another session (RFC 5717 2.4.1) */
+    if (strcmp(db, "running") == 0 &&
+	(iddb = backend_partial_lock_held(id)) != 0){
+	cprintf(cbx, "<session-id>%u</session-id>", iddb);
+	if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, partial lock is already held") < 0)
+	    goto done;
+	goto ok;
+    }
     /* 2) The target configuration is <candidate>, it has already been modified, and 
      *    these changes have not been committed or rolled back.
      */
@@ -1032,6 +2166,64 @@ from_client_unlock(clicon_handle h,
     return retval;
 }
 
+/*! Send a large get reply in chunks directly to the client socket
+ *
+ * If the serialized reply is larger than CLICON_BACKEND_REPLY_CHUNK, the reply is not
+ * built in a buffer but written to the client in chunks, see send_msg_reply_xml
+ * @param[in]  h      Clicon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  xdata  Reply data tree, top-level <data>
+ * @param[in]  depth  Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @retval     1      Reply sent, or client closed
+ * @retval     0      Reply not sent: small reply or chunks disabled
+ * @retval    -1      Error
+ */
+static int
+client_reply_chunked(clicon_handle        h,
+		     struct client_entry *ce,
+		     cxobj               *xdata,
+		     int32_t              depth)
+{
+    int    retval = -1;
+    int    chunk;
+    size_t len;
+    cbuf  *cb = NULL;
+
+    if ((chunk = clicon_option_int(h, "CLICON_BACKEND_REPLY_CHUNK")) <= 0)
+	goto nochunk;
+    if (clicon_xml2len(xdata, depth, &len) < 0)
+	goto done;
+    if (len <= chunk)
+	goto nochunk;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    clicon_debug(1, "%s len:%zu", __FUNCTION__, len);
+    ce_notify_flush(ce);
+    if (send_msg_reply_xml(ce->ce_s, cbuf_get(cb), xdata, depth, len,
+			   "</rpc-reply>", chunk) < 0){
+	switch (errno){
+	case EPIPE: /* See from_client_msg */
+	case ECONNRESET:
+	    clicon_log(LOG_WARNING, "client rpc reset");
+	    break;
+	default:
+	    goto done;
+	}
+    }
+    ce->ce_reply_sent = 1;
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ nochunk:
+    retval = 0;
+    goto done;
+}
+
 /*! Retrieve running configuration and device state information.
  * 
  * @param[in]  h       Clicon handle 
@@ -1041,7 +2233,11 @@ from_client_unlock(clicon_handle h,
  * @param[in]  regarg  User argument given at rpc_callback_register() 
  * @retval     0       OK
  * @retval    -1       Error
- *
+ * Clixon extensions: attributes content, depth, and offset and limit for paging of
+ * the nodes selected by the filter. With content=config the page is read directly
+ * from the datastore, see client_get_config_only
+ * Also api-path with the same selection as the filter, with content=config the nodes
+ * are then looked up by list keys, see client_get_api_path
  * @see from_client_get_config 
  */
 static int
@@ -1052,6 +2248,7 @@ from_client_get(clicon_handle h,
 		void         *regarg)
 {
     int             retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
     cxobj          *xfilter;
     char           *xpath = NULL;
     cxobj          *xret = NULL;
@@ -1068,6 +2265,9 @@ from_client_get(clicon_handle h,
     cxobj          *xerr = NULL;
     int             ret;
     char           *reason = NULL;
+    uint32_t        offset = 0;
+    uint32_t        limit = 0;
+    int             validate = 0;
     
     clicon_debug(1, "%s", __FUNCTION__);
     username = clicon_username_get(h);
@@ -1075,6 +2275,37 @@ from_client_get(clicon_handle h,
 	clicon_err(OE_YANG, ENOENT, "No yang spec9");
 	goto done;
     }
+    /* Clixon extensions: content */
+    if ((attr = xml_find_value(xe, "content")) != NULL)
+	content = netconf_content_str2int(attr);
+    /* Clixon extensions: depth */
+    if ((attr = xml_find_value(xe, "depth")) != NULL){
+	if ((ret = parse_int32(attr, &depth, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_int32");
+	    goto done;
+	}
+	if (ret == 0){
+	    if (netconf_bad_attribute(cbret, "application",
+				      "depth", "Unrecognized value of depth attribute") < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    /* Clixon extensions: offset and limit for paging of the nodes selected by xpath */
+    if ((ret = client_get_page_attr(xe, cbret, &offset, &limit)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    /* Clixon extension: api-path of the same nodes as the filter, before the filter
+     * xpath is parsed */
+    if (content == CONTENT_CONFIG && limit == 0 &&
+	(attr = xml_find_value(xe, "api-path")) != NULL &&
+	clicon_nacm_cache(h) == NULL){
+	if ((ret = client_get_api_path(h, "running", attr, depth, cbret)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+    }
     if ((xfilter = xml_find(xe, "filter")) != NULL){
 	char *xpath0;
 	cvec *nsc1 = NULL;
@@ -1093,24 +2324,8 @@ from_client_get(clicon_handle h,
 	    xml_nsctx_free(nsc);
 	nsc = nsc1;
     }
-    /* Clixon extensions: content */
-    if ((attr = xml_find_value(xe, "content")) != NULL)
-	content = netconf_content_str2int(attr);
-    /* Clixon extensions: depth */
-    if ((attr = xml_find_value(xe, "depth")) != NULL){
-	if ((ret = parse_int32(attr, &depth, &reason)) < 0){
-	    clicon_err(OE_XML, errno, "parse_int32");
-	    goto done;
-	}
-	if (ret == 0){
-	    if (netconf_bad_attribute(cbret, "application",
-				      "depth", "Unrecognized value of depth attribute") < 0)
-		goto done;
-	    goto ok;
-	}
-    }
     if (content == CONTENT_CONFIG){ /* config only, no state */
-	if (client_get_config_only(h, nsc, yspec, "running", xpath, username, depth, cbret) < 0)
+	if (client_get_config_only(h, nsc, yspec, "running", xpath, username, depth, offset, limit, 0, cbret) < 0)
 	    goto done;
 	goto ok;
     }
@@ -1119,20 +2334,26 @@ from_client_get(clicon_handle h,
      * merged with state data, so zero-copy cant be used
      * Also, must use external namespace context here due to <filter> stmt
      */
-    if (clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML")){
-	if (xmldb_get0(h, "running", YB_MODULE, nsc, NULL, 1, &xret, NULL) < 0) {
-	    if (netconf_operation_failed(cbret, "application", "read registry")< 0)
-		goto done;
-	    goto ok;
-	}
-    }
-    else{
-	if (xmldb_get0(h, "running", YB_MODULE, nsc, xpath, 1, &xret, NULL) < 0) {
-	    if (netconf_operation_failed(cbret, "application", "read registry")< 0)
-		goto done;
-	    goto ok;
-	}
+    /* Full state validation of sampled requests needs the whole config tree, on
+     * schema level each provider is validated in clixon_plugin_statedata_all
+     */
+    if (clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML") &&
+	!state_validate_schema_level(h) &&
+	(validate = state_validate_sample(h, STATE_VALIDATE_ALL)) < 0)
+	goto done;
+    if (xmldb_get0(h, "running", YB_MODULE, nsc, validate?NULL:xpath, 1, &xret, NULL) < 0) {
+	if (netconf_operation_failed(cbret, "application", "read registry")< 0)
+	    goto done;
+	goto ok;
     }
+    /* Default values of state data are not added to the tree but printed when the reply
+     * is serialized, unless the tree is validated, filtered or access controlled
+     */
+    if (clicon_option_bool(h, "CLICON_DEFAULTS_SERIALIZE") &&
+	content == CONTENT_ALL && !validate && limit == 0 &&
+	(xpath == NULL || strcmp(xpath, "/") == 0) &&
+	clicon_nacm_cache(h) == NULL && xret != NULL)
+	xml_flag_set(xret, XML_FLAG_REPORT_ALL);
     /* If not only config,
      * get state data from plugins as defined by plugin_statedata(), if any 
      */
@@ -1144,7 +2365,7 @@ from_client_get(clicon_handle h,
 	    goto done;
 	goto ok;
     }
-    if (clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML")){
+    if (validate){
 	/* Check XML  by validating it. return internal error with error cause 
 	 * Primarily intended for user-supplied state-data.
 	 * The whole config tree must be present in case the state data references config data
@@ -1155,6 +2376,8 @@ from_client_get(clicon_handle h,
 	    (ret = xml_yang_validate_add(h, xret, &xerr)) < 0)
 	    goto done;
 	if (ret == 0){
+	    if (state_validate_failed(STATE_VALIDATE_ALL) < 0)
+		goto done;
 	    if (clicon_debug_get())
 		clicon_log_xml(LOG_DEBUG, xret, "VALIDATE_STATE");
 	    if (clixon_netconf_internal_error(xerr,
@@ -1214,12 +2437,32 @@ from_client_get(clicon_handle h,
 	if (nacm_datanode_read(h, xret, xvec, xlen, username, xnacm) < 0) 
 	    goto done;
     }
+    /* Page of the nodes selected by xpath, after state data is merged */
+    if (limit && xret){
+	if (xvec){
+	    free(xvec);
+	    xvec = NULL;
+	}
+	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+	    goto done;
+	for (i = xlen-1; i >= 0; i--)
+	    if ((size_t)i < offset || (size_t)i >= (size_t)offset + limit)
+		if (xml_purge(xvec[i]) < 0)
+		    goto done;
+    }
+    if (xret != NULL){
+	if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
+	    goto done;
+	/* Top level is data, so add 1 to depth if significant */
+	if ((ret = client_reply_chunked(h, ce, xret, depth>0?depth+1:depth)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+    }
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);     /* OK */
     if (xret==NULL)
 	cprintf(cbret, "<data/>");
     else{
-	if (xml_name_set(xret, NETCONF_OUTPUT_DATA) < 0)
-	    goto done;
 	/* Top level is data, so add 1 to depth if significant */
 	if (clicon_xml2cbuf(cbret, xret, 0, 0, depth>0?depth+1:depth) < 0)
 	    goto done;
@@ -1244,6 +2487,60 @@ from_client_get(clicon_handle h,
     return retval;
 }
 
+/*! Get config and state data of running datastore selected by xpath
+ * As get with content all, but without NACM, which is made by the caller
+ * @param[in]  h      Clicon handle
+ * @param[in]  xpath  XPath selection, canonical form
+ * @param[in]  nsc    XML Namespace context for xpath
+ * @param[out] xret   Selected data. Free with xml_free. If retval=0, an error message
+ * @retval    -1      Error
+ * @retval     0      Statedata callback failed (error in xret)
+ * @retval     1      OK
+ * @see from_client_get
+ */
+int
+backend_client_get(clicon_handle h,
+		   char         *xpath,
+		   cvec         *nsc,
+		   cxobj       **xret)
+{
+    int     retval = -1;
+    cxobj  *xt = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen;
+    int     i;
+    int     ret;
+
+    if (xmldb_get0(h, "running", YB_MODULE, nsc, xpath, 1, &xt, NULL) < 0)
+	goto done;
+    if ((ret = client_statedata(h, xpath?xpath:"/", nsc, CONTENT_ALL, &xt)) < 0)
+	goto done;
+    if (ret == 0){
+	*xret = xt;
+	xt = NULL;
+	retval = 0;
+	goto done;
+    }
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+	goto done;
+    for (i=0; i<xlen; i++)
+	xml_flag_set(xvec[i], XML_FLAG_MARK);
+    if (!xml_flag(xt, XML_FLAG_MARK))
+	if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
+	    goto done;
+    if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
+	goto done;
+    *xret = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (xvec)
+	free(xvec);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
 /*! Request graceful termination of a NETCONF session.
  * @param[in]  h       Clicon handle 
  * @param[in]  xe      Request: <rpc><xn></rpc> 
@@ -1264,7 +2561,11 @@ from_client_close_session(clicon_handle h,
     uint32_t             id = ce->ce_id;
 
     xmldb_unlock_all(h, id);
+    xmldb_bulk_end_all(h, id);
+    backend_partial_lock_release(id);
+    backend_private_release(h, id);
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
+    backend_push_client_rm(h, ce);
     cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
     return 0;
 }
@@ -1311,8 +2612,11 @@ from_client_kill_session(clicon_handle h,
 	goto done;
     }
     /* may or may not be in active client list, probably not */
-    if ((ce = ce_find_byid(backend_client_list(h), id)) != NULL){
+    if ((ce = backend_client_find_id(h, id)) != NULL){
 	xmldb_unlock_all(h, id);  /* Removes locks on all databases */
+	xmldb_bulk_end_all(h, id);
+	backend_partial_lock_release(id);
+	backend_private_release(h, id);
 	backend_client_rm(h, ce); /* Removes client struct */
     }
     if (xmldb_islocked(h, db) == id)
@@ -1462,7 +2766,857 @@ from_client_debug(clicon_handle h,
     return retval;
 }
 
-/*! Check liveness of backend daemon,  just send a reply
+/*! Check liveness of backend daemon,  just send a reply
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_ping(clicon_handle h,
+		 cxobj        *xe,
+		 cbuf         *cbret,
+		 void         *arg,
+		 void         *regarg)
+{
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+    return 0;
+}
+
+/*! Get change token of a datastore, without reading the datastore
+ *
+ * The token is made of the modification time and the generation of the datastore, so
+ * it changes when the datastore may change, also after a restart of the backend.
+ * @param[in]  h       Clicon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xmldb_generation
+ * @see api_data_get2  Restconf ETag and Last-Modified
+ */
+static int
+from_client_datastore_token(clicon_handle h,
+			    cxobj        *xe,
+			    cbuf         *cbret,
+			    void         *arg,
+			    void         *regarg)
+{
+    char *db;
+
+    if ((db = xml_find_body(xe, "datastore")) == NULL)
+	db = "running";
+    if (xmldb_validate_db(db) < 0)
+	return netconf_invalid_value(cbret, "protocol", "No such database");
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<token xmlns=\"%s\">%" PRIx64 "-%" PRIx64 "</token>",
+	    CLIXON_LIB_NS, xmldb_modified(h, db), xmldb_generation(h, db));
+    cprintf(cbret, "<modified xmlns=\"%s\">%" PRIu64 "</modified>",
+	    CLIXON_LIB_NS, xmldb_modified(h, db));
+    cprintf(cbret, "</rpc-reply>");
+    return 0;
+}
+
+/*! Evaluate an xpath on a datastore with profiling, for debugging of slow xpaths
+ *
+ * Only the counters of the evaluation are returned, not the resulting nodes.
+ * @param[in]  h       Clicon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xpath_profile
+ */
+static int
+from_client_xpath_profile(clicon_handle h,
+			  cxobj        *xe,
+			  cbuf         *cbret,
+			  void         *arg,
+			  void         *regarg)
+{
+    int     retval = -1;
+    char   *db;
+    cxobj  *xp;
+    char   *xpath;
+    cvec   *nsc = NULL;
+    cxobj  *xt = NULL;
+    xp_ctx *xc = NULL;
+    cbuf   *cb = NULL;
+
+    if ((db = xml_find_body(xe, "datastore")) == NULL)
+	db = "running";
+    if (xmldb_validate_db(db) < 0){
+	if (netconf_invalid_value(cbret, "protocol", "No such database") < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((xp = xml_find_type(xe, NULL, "xpath", CX_ELMNT)) == NULL ||
+	(xpath = xml_body(xp)) == NULL){
+	if (netconf_missing_element(cbret, "protocol", "xpath", NULL) < 0)
+	    goto done;
+	goto ok;
+    }
+    /* Namespace prefixes of the xpath are declared on the xpath element */
+    if (xml_nsctx_node(xp, &nsc) < 0)
+	goto done;
+    if (xmldb_get0(h, db, YB_MODULE, NULL, "/", 0, &xt, NULL) < 0){
+	if (netconf_operation_failed(cbret, "application", "read registry") < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (xpath_profile(xt, nsc, xpath, 0, &xc, cb) < 0){
+	if (netconf_invalid_value(cbret, "application", clicon_err_reason) < 0)
+	    goto done;
+	goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    if (xc->xc_type == XT_NODESET)
+	cprintf(cbret, "<nodes xmlns=\"%s\">%d</nodes>", CLIXON_LIB_NS, xc->xc_size);
+    cprintf(cbret, "<profile xmlns=\"%s\">", CLIXON_LIB_NS);
+    if (xml_chardata_cbuf_append(cbret, cbuf_get(cb)) < 0)
+	goto done;
+    cprintf(cbret, "</profile></rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (xc)
+	ctx_free(xc);
+    if (xt)
+	xmldb_get0_free(h, &xt);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Start or stop sampling profiler of backend or of a process started by the backend
+ *
+ * The backend writes folded stacks to a file when sampling stops.
+ * A process, eg restconf, is sent the start or stop signal and writes to
+ * CLICON_SAMPLE_FILE with its process id as suffix.
+ * @param[in]  h       Clicon handle
+ * @param[in]  xe      Request: <rpc><xn></rpc>
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error..
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register()
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see clixon_sample_start
+ */
+static int
+from_client_sample(clicon_handle h,
+		   cxobj        *xe,
+		   cbuf         *cbret,
+		   void         *arg,
+		   void         *regarg)
+{
+    int      retval = -1;
+    char    *op;
+    char    *name;
+    char    *file;
+    char    *str;
+    int      hz = 0;
+    int      ret;
+    char     filebuf[MAXPATHLEN];
+
+    if ((op = xml_find_body(xe, "operation")) == NULL)
+	op = "status";
+    if ((name = xml_find_body(xe, "process")) != NULL){
+	if (strcmp(op, "status") == 0){
+	    if (netconf_invalid_value(cbret, "application", "Status of a process is not supported") < 0)
+		goto done;
+	    goto ok;
+	}
+	if ((ret = clixon_process_signal(h, name,
+					 strcmp(op, "start")==0?CLIXON_SAMPLE_SIG_START:CLIXON_SAMPLE_SIG_STOP)) < 0)
+	    goto done;
+	if (ret == 0){
+	    if (netconf_invalid_value(cbret, "application", "No such running process") < 0)
+		goto done;
+	    goto ok;
+	}
+	cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+	goto ok;
+    }
+    if (strcmp(op, "start") == 0){
+	if ((file = xml_find_body(xe, "file")) == NULL){
+	    if ((file = clicon_option_str(h, "CLICON_SAMPLE_FILE")) == NULL)
+		file = "/var/tmp/clixon_sample";
+	    snprintf(filebuf, sizeof(filebuf), "%s.%u", file, getpid());
+	    file = filebuf;
+	}
+	if ((str = xml_find_body(xe, "frequency")) != NULL)
+	    hz = atoi(str);
+	else
+	    hz = clicon_option_int(h, "CLICON_SAMPLE_FREQUENCY");
+	if (clixon_sample_start(hz, file) < 0){
+	    if (netconf_operation_failed(cbret, "application", clicon_err_reason) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    else if (strcmp(op, "stop") == 0){
+	if (clixon_sample_stop() < 0){
+	    if (netconf_operation_failed(cbret, "application", clicon_err_reason) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<active xmlns=\"%s\">%s</active>", CLIXON_LIB_NS,
+	    clixon_sample_active()?"true":"false");
+    cprintf(cbret, "<samples xmlns=\"%s\">%d</samples>", CLIXON_LIB_NS, clixon_sample_count());
+    cprintf(cbret, "<dropped xmlns=\"%s\">%d</dropped>", CLIXON_LIB_NS, clixon_sample_dropped());
+    if ((file = clixon_sample_file()) != NULL){
+	cprintf(cbret, "<file xmlns=\"%s\">", CLIXON_LIB_NS);
+	if (xml_chardata_cbuf_append(cbret, file) < 0)
+	    goto done;
+	cprintf(cbret, "</file>");
+    }
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/* Number of histogram buckets of rpc statistics, see rpc_stats_le */
+#define RPC_STATS_BUCKETS 7
+
+/* Upper bounds in us of histogram buckets of rpc service time, the last is unbounded */
+static const uint64_t rpc_stats_le[RPC_STATS_BUCKETS-1] = {
+    100, 1000, 10000, 100000, 1000000, 10000000
+};
+
+/* Statistics of rpcs handled by the backend with the same name */
+struct rpc_stats{
+    struct rpc_stats *rs_next;
+    char             *rs_name;      /* Name of rpc, eg edit-config */
+    uint64_t          rs_calls;     /* Number of requests */
+    uint64_t          rs_total;     /* Total service time in us */
+    uint64_t          rs_max;       /* Max service time of a request in us */
+    uint64_t          rs_wait_total;/* Total wait time in receive buffer in us */
+    uint64_t          rs_wait_max;  /* Max wait time in receive buffer in us */
+    uint64_t          rs_bytes_in;  /* Total size of requests */
+    uint64_t          rs_bytes_out; /* Total size of replies */
+    uint64_t          rs_hist[RPC_STATS_BUCKETS]; /* Histogram of service times */
+};
+
+/* Rpc statistics entries, in order of first request */
+static struct rpc_stats *rpc_stats_list = NULL;
+
+/*! Difference in us between two monotonic times, 0 if negative
+ */
+static uint64_t
+rpc_stats_us(struct timespec *t0,
+	     struct timespec *t1)
+{
+    int64_t d;
+
+    d = (int64_t)(t1->tv_sec - t0->tv_sec)*1000000 + (t1->tv_nsec - t0->tv_nsec)/1000;
+    return d<0 ? 0 : (uint64_t)d;
+}
+
+/*! Register a handled rpc request in rpc statistics
+ * @param[in]  name      Name of rpc, eg "get-config"
+ * @param[in]  tr        Monotonic time when request was read from client socket
+ * @param[in]  t0        Monotonic time when request was dispatched
+ * @param[in]  bytes_in  Size of request message
+ * @param[in]  bytes_out Size of reply message, 0 if sent by callback
+ * @retval     0         OK
+ * @retval    -1         Error
+ * Service time is from dispatch until the reply is sent, wait time is from the request
+ * was read until it is dispatched, eg after earlier pipelined requests of the client
+ * @see rpc_stats_cbuf
+ */
+static int
+rpc_stats_add(const char      *name,
+	      struct timespec *tr,
+	      struct timespec *t0,
+	      size_t           bytes_in,
+	      size_t           bytes_out)
+{
+    struct rpc_stats  *rs;
+    struct rpc_stats **rsp;
+    struct timespec    t1;
+    uint64_t           us;
+    uint64_t           wait;
+    int                i;
+
+    for (rsp = &rpc_stats_list; (rs = *rsp) != NULL; rsp = &rs->rs_next)
+	if (strcmp(rs->rs_name, name) == 0)
+	    break;
+    if (rs == NULL){ /* New entry last */
+	if ((rs = malloc(sizeof(*rs))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    return -1;
+	}
+	memset(rs, 0, sizeof(*rs));
+	if ((rs->rs_name = strdup(name)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    free(rs);
+	    return -1;
+	}
+	*rsp = rs;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    us = rpc_stats_us(t0, &t1);
+    wait = (tr->tv_sec || tr->tv_nsec) ? rpc_stats_us(tr, t0) : 0;
+    rs->rs_calls++;
+    rs->rs_total += us;
+    if (us > rs->rs_max)
+	rs->rs_max = us;
+    rs->rs_wait_total += wait;
+    if (wait > rs->rs_wait_max)
+	rs->rs_wait_max = wait;
+    rs->rs_bytes_in += bytes_in;
+    rs->rs_bytes_out += bytes_out;
+    for (i=0; i<RPC_STATS_BUCKETS-1; i++)
+	if (us <= rpc_stats_le[i])
+	    break;
+    rs->rs_hist[i]++;
+    return 0;
+}
+
+/*! Print rpc statistics as XML, see stats rpc in clixon-lib.yang
+ * @param[in,out] cb  CLIgen buffer
+ * @retval        0   OK
+ * @retval       -1   Error
+ */
+static int
+rpc_stats_cbuf(cbuf *cb)
+{
+    struct rpc_stats *rs;
+    int               i;
+
+    for (rs = rpc_stats_list; rs; rs = rs->rs_next){
+	cprintf(cb, "<rpc><name>");
+	if (xml_chardata_cbuf_append(cb, rs->rs_name) < 0)
+	    return -1;
+	cprintf(cb, "</name>");
+	cprintf(cb, "<calls>%" PRIu64 "</calls>"
+		"<time-total>%" PRIu64 "</time-total>"
+		"<time-max>%" PRIu64 "</time-max>",
+		rs->rs_calls, rs->rs_total, rs->rs_max);
+	for (i=0; i<RPC_STATS_BUCKETS; i++){
+	    if (i < RPC_STATS_BUCKETS-1)
+		cprintf(cb, "<histogram><le>%" PRIu64 "</le>", rpc_stats_le[i]);
+	    else
+		cprintf(cb, "<histogram><le>inf</le>");
+	    cprintf(cb, "<count>%" PRIu64 "</count></histogram>", rs->rs_hist[i]);
+	}
+	cprintf(cb, "<wait-total>%" PRIu64 "</wait-total>"
+		"<wait-max>%" PRIu64 "</wait-max>"
+		"<bytes-in>%" PRIu64 "</bytes-in>"
+		"<bytes-out>%" PRIu64 "</bytes-out>",
+		rs->rs_wait_total, rs->rs_wait_max, rs->rs_bytes_in, rs->rs_bytes_out);
+	cprintf(cb, "</rpc>");
+    }
+    return 0;
+}
+
+/*! Free rpc statistics
+ */
+int
+rpc_stats_exit(void)
+{
+    struct rpc_stats *rs;
+
+    while ((rs = rpc_stats_list) != NULL){
+	rpc_stats_list = rs->rs_next;
+	free(rs->rs_name);
+	free(rs);
+    }
+    return 0;
+}
+
+/*! Check liveness of backend daemon,  just send a reply
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_stats(clicon_handle h,
+		  cxobj        *xe,
+		  cbuf         *cbret,
+		  void         *arg,
+		  void         *regarg)
+{
+    int      retval = -1;
+    uint64_t nr;
+    
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    nr=0;
+    xml_stats_global(&nr);
+    cprintf(cbret, "<global><xmlnr>%" PRIu64 "</xmlnr></global>", nr);
+    if (clixon_stats_get_db(h, "running", cbret) < 0)
+	goto done;
+    if (clixon_stats_get_db(h, "candidate", cbret) < 0)
+	goto done;
+    if (clixon_stats_get_db(h, "startup", cbret) < 0)
+	goto done;
+    if (clixon_stats_get_mem(h, cbret) < 0)
+	goto done;
+    if (clixon_event_stats(cbret) < 0)
+	goto done;
+    if (commit_stats_cbuf(cbret) < 0)
+	goto done;
+    if (rpc_stats_cbuf(cbret) < 0)
+	goto done;
+    if (transaction_mem_stats_cbuf(cbret) < 0)
+	goto done;
+    if (backend_accept_stats_cbuf(cbret) < 0)
+	goto done;
+    if (state_validate_stats_cbuf(cbret) < 0)
+	goto done;
+    if (xmldb_parse_cache_stats(cbret) < 0)
+	goto done;
+    cprintf(cbret, "</rpc-reply>");
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get values of nodes selected by an xpath in a datastore, eg for CLI completion
+ *
+ * Only the values are returned, not the tree they are selected from. The values are
+ * returned in document order without duplicates, possibly filtered by a prefix and
+ * limited in number.
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see expand_dbvar  CLI completion using this RPC
+ */
+static int
+from_client_get_values(clicon_handle h,
+		       cxobj        *xe,
+		       cbuf         *cbret,
+		       void         *arg,
+		       void         *regarg)
+{
+    int        retval = -1;
+    char      *db;
+    cxobj     *xp;
+    char      *xpath;
+    char      *filter;
+    char      *prefix;
+    char      *str;
+    uint32_t   limit = 0;
+    uint32_t   nr = 0;
+    cvec      *nsc = NULL;
+    cxobj     *xret = NULL;
+    cxobj     *xnacm;
+    cxobj    **xvec = NULL;
+    size_t     xlen = 0;
+    cxobj     *x;
+    yang_stmt *y;
+    yang_stmt *yp;
+    char      *bodystr;
+    char      *bodystr0 = NULL; /* previous */
+    int        copy = 0;
+    int        i;
+    int        j;
+    char      *reason = NULL;
+    int        ret;
+    
+    if ((db = xml_find_body(xe, "source")) == NULL ||
+	xmldb_validate_db(db) < 0){
+	if (netconf_invalid_value(cbret, "protocol", "No such database")< 0)
+	    goto done;
+	goto ok;
+    }
+    if ((xp = xml_find_type(xe, NULL, "xpath", CX_ELMNT)) == NULL ||
+	(xpath = xml_body(xp)) == NULL){
+	if (netconf_missing_element(cbret, "protocol", "xpath", NULL) < 0)
+	    goto done;
+	goto ok;
+    }
+    /* Namespace context of the xpath:s from the xmlns attributes of <xpath> */
+    if (xml_nsctx_node(xp, &nsc) < 0)
+	goto done;
+    if ((filter = xml_find_body(xe, "filter")) == NULL)
+	filter = xpath;
+    prefix = xml_find_body(xe, "prefix");
+    if ((str = xml_find_body(xe, "limit")) != NULL){
+	if ((ret = parse_uint32(str, &limit, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_uint32");
+	    goto done;
+	}
+	if (ret == 0){
+	    if (netconf_bad_element(cbret, "application", "limit", reason) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    /* Without NACM the shared datastore cache is read directly (no copy) since only
+     * the values are sent, but NACM prunes the tree and needs a copy */
+    xnacm = clicon_nacm_cache(h);
+    copy = xnacm != NULL;
+    if (xmldb_get0(h, db, YB_MODULE, nsc, filter, copy, &xret, NULL) < 0) {
+	if (netconf_operation_failed(cbret, "application", "read registry")< 0)
+	    goto done;
+	goto ok;
+    }
+    if (xnacm != NULL){ /* Do NACM validation */
+	if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, filter) < 0)
+	    goto done;
+	if (nacm_datanode_read(h, xret, xvec, xlen, clicon_username_get(h), xnacm) < 0) 
+	    goto done;
+	if (xvec){
+	    free(xvec);
+	    xvec = NULL;
+	}
+    }
+    if (xpath_vec(xret, nsc, "%s", &xvec, &xlen, xpath) < 0)
+	goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    for (i = 0; i < xlen; i++) {
+	if (limit && nr >= limit)
+	    break;
+	x = xvec[i];
+	if (xml_type(x) == CX_BODY)
+	    bodystr = xml_value(x);
+	else
+	    bodystr = xml_body(x);
+	if (bodystr == NULL)
+	    continue; /* no body, cornercase */
+	if (prefix && strncmp(bodystr, prefix, strlen(prefix)) != 0)
+	    continue;
+	if ((y = xml_spec(x)) != NULL &&
+	    (yp = yang_parent_get(y)) != NULL &&
+	    yang_keyword_get(yp) == Y_LIST &&
+	    yang_find(yp, Y_ORDERED_BY, "user") != NULL){
+	    /* Detect duplicates linearly in earlier values */
+	    for (j = 0; j < i; j++){
+		if (xml_type(xvec[j]) == CX_BODY)
+		    str = xml_value(xvec[j]);
+		else
+		    str = xml_body(xvec[j]);
+		if (str && strcmp(str, bodystr) == 0)
+		    break;
+	    }
+	    if (j < i)
+		continue;
+	}
+	else{
+	    if (bodystr0 && strcmp(bodystr, bodystr0) == 0)
+		continue; /* duplicate, assume sorted */
+	    bodystr0 = bodystr;
+	}
+	cprintf(cbret, "<value xmlns=\"%s\">", CLIXON_LIB_NS);
+	if (xml_chardata_cbuf_append(cbret, bodystr) < 0)
+	    goto done;
+	cprintf(cbret, "</value>");
+	nr++;
+    }
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (reason)
+	free(reason);
+    if (xvec)
+	free(xvec);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (xret){
+	if (copy)
+	    xml_free(xret);
+	else{
+	    xmldb_get0_clear(h, xret);
+	    xmldb_get0_free(h, &xret);
+	}
+    }
+    return retval;
+}
+
+/*! Print one change of a datastore comparison: parent path and deleted/added subtree
+ * @param[in]  cb     Output buffer
+ * @param[in]  x0     Node in first datastore, or NULL
+ * @param[in]  x1     Node in second datastore, or NULL
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see from_client_compare
+ */
+static int
+compare_change2cbuf(cbuf  *cb,
+		    cxobj *x0,
+		    cxobj *x1)
+{
+    int    retval = -1;
+    cxobj *x;
+    cxobj *xp;
+    cxobj *xc = NULL;
+    char  *xpath = NULL;
+    char  *ns = NULL;
+    int    i;
+
+    x = x0?x0:x1;
+    cprintf(cb, "<change xmlns=\"%s\">", CLIXON_LIB_NS);
+    if ((xp = xml_parent(x)) != NULL && xml_parent(xp) != NULL){
+	if (xml2xpath(xp, &xpath) < 0)
+	    goto done;
+	cprintf(cb, "<path>");
+	if (xml_chardata_cbuf_append(cb, xpath) < 0)
+	    goto done;
+	cprintf(cb, "</path>");
+    }
+    else
+	cprintf(cb, "<path>/</path>");
+    for (i=0; i<2; i++){
+	if ((x = i==0?x0:x1) == NULL)
+	    continue;
+	/* Copy so that the namespace can be declared in the cached tree */
+	if ((xc = xml_dup(x)) == NULL)
+	    goto done;
+	if (xml2ns(x, xml_prefix(x), &ns) < 0)
+	    goto done;
+	if (ns && xml_find_type_value(xc, NULL, "xmlns", CX_ATTR) == NULL &&
+	    xml_prefix(x) == NULL)
+	    if (xmlns_set(xc, NULL, ns) < 0)
+		goto done;
+	cprintf(cb, "<%s>", i==0?"deleted":"added");
+	if (clicon_xml2cbuf(cb, xc, 0, 0, -1) < 0)
+	    goto done;
+	cprintf(cb, "</%s>", i==0?"deleted":"added");
+	xml_free(xc);
+	xc = NULL;
+    }
+    cprintf(cb, "</change>");
+    retval = 0;
+ done:
+    if (xc)
+	xml_free(xc);
+    if (xpath)
+	free(xpath);
+    return retval;
+}
+
+/*! Compare two datastores and return the differences
+ *
+ * The differences are computed with xml_diff() as in a commit transaction, and
+ * only the changes are sent: the deleted and added subtrees and the changed leafs.
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see compare_dbs  CLI show compare using this RPC
+ */
+static int
+from_client_compare(clicon_handle h,
+		    cxobj        *xe,
+		    cbuf         *cbret,
+		    void         *arg,
+		    void         *regarg)
+{
+    int                 retval = -1;
+    char               *db0;
+    char               *db1;
+    yang_stmt          *yspec;
+    transaction_data_t *td = NULL;
+    cxobj              *xnacm;
+    cxobj             **xvec = NULL;
+    size_t              xlen;
+    int                 copy = 0;
+    int                 i;
+
+    if ((yspec =  clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if ((db0 = xml_find_body(xe, "source")) == NULL)
+	db0 = "running";
+    if ((db1 = xml_find_body(xe, "target")) == NULL)
+	db1 = "candidate";
+    if (xmldb_validate_db(db0) < 0 || xmldb_validate_db(db1) < 0){
+	if (netconf_invalid_value(cbret, "protocol", "No such database")< 0)
+	    goto done;
+	goto ok;
+    }
+    if ((td = transaction_new()) == NULL)
+	goto done;
+    /* Without NACM the cached trees are compared directly, NACM needs copies */
+    xnacm = clicon_nacm_cache(h);
+    copy = xnacm != NULL;
+    if (xmldb_get0(h, db0, YB_MODULE, NULL, "/", copy, &td->td_src, NULL) < 0 ||
+	xmldb_get0(h, db1, YB_MODULE, NULL, "/", copy, &td->td_target, NULL) < 0){
+	if (netconf_operation_failed(cbret, "application", "read registry")< 0)
+	    goto done;
+	goto ok;
+    }
+    if (xnacm != NULL){ /* NACM datanode/module read validation of both trees */
+	for (i=0; i<2; i++){
+	    if (xpath_vec(i==0?td->td_src:td->td_target, NULL, "/", &xvec, &xlen) < 0)
+		goto done;
+	    if (nacm_datanode_read(h, i==0?td->td_src:td->td_target, xvec, xlen,
+				   clicon_username_get(h), xnacm) < 0) 
+		goto done;
+	    if (xvec){
+		free(xvec);
+		xvec = NULL;
+	    }
+	}
+    }
+    if (xml_diff(yspec, 
+		 td->td_src,
+		 td->td_target,
+		 &td->td_dvec,      /* removed: only in source */
+		 &td->td_dlen,
+		 &td->td_avec,      /* added: only in target */
+		 &td->td_alen,
+		 &td->td_scvec,     /* changed: original values */
+		 &td->td_tcvec,     /* changed: wanted values */
+		 &td->td_clen) < 0)
+	goto done;
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    for (i=0; i<td->td_dlen; i++)
+	if (compare_change2cbuf(cbret, td->td_dvec[i], NULL) < 0)
+	    goto done;
+    for (i=0; i<td->td_alen; i++)
+	if (compare_change2cbuf(cbret, NULL, td->td_avec[i]) < 0)
+	    goto done;
+    for (i=0; i<td->td_clen; i++)
+	if (compare_change2cbuf(cbret, td->td_scvec[i], td->td_tcvec[i]) < 0)
+	    goto done;
+    cprintf(cbret, "</rpc-reply>");
+ ok:
+    retval = 0;
+ done:
+    if (xvec)
+	free(xvec);
+    if (td){
+	if (!copy){
+	    if (td->td_src){
+		xmldb_get0_clear(h, td->td_src);
+		xmldb_get0_free(h, &td->td_src);
+	    }
+	    if (td->td_target){
+		xmldb_get0_clear(h, td->td_target);
+		xmldb_get0_free(h, &td->td_target);
+	    }
+	}
+	transaction_free(td);
+    }
+    return retval;
+}
+
+/*! Begin or end a bulk load of a datastore
+ *
+ * While a bulk load is active, edits of the datastore are applied to the datastore
+ * cache only, and the datastore file is written once when the bulk load ends, or
+ * when the session is closed.
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xmldb_bulk_begin
+ * @see load_config_file  CLI load of a file in chunks using this RPC
+ */
+static int
+from_client_bulk_load(clicon_handle h,
+		      cxobj        *xe,
+		      cbuf         *cbret,
+		      void         *arg,
+		      void         *regarg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    uint32_t             myid = ce->ce_id;
+    uint32_t             iddb;
+    char                *target;
+    char                *op;
+    cbuf                *cbx = NULL;
+
+    if ((target = xml_find_body(xe, "target")) == NULL)
+	target = "candidate";
+    if ((op = xml_find_body(xe, "operation")) == NULL){
+	if (netconf_missing_element(cbret, "protocol", "operation", NULL) < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((cbx = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }	
+    if (xmldb_validate_db(target) < 0){
+	cprintf(cbx, "No such database: %s", target);
+	if (netconf_invalid_value(cbret, "protocol", cbuf_get(cbx))< 0)
+	    goto done;
+	goto ok;
+    }
+    /* Check if target locked by other client */
+    iddb = xmldb_islocked(h, target);
+    if (iddb && myid != iddb){
+	cprintf(cbx, "<session-id>%u</session-id>", iddb);
+	if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, lock is already held") < 0)
+	    goto done;
+	goto ok;
+    }
+    iddb = xmldb_bulk_get(h, target);
+    if (strcmp(op, "begin") == 0){
+	if (iddb && myid != iddb){
+	    cprintf(cbx, "Bulk load of %s already started by session %u", target, iddb);
+	    if (netconf_in_use(cbret, "protocol", cbuf_get(cbx)) < 0)
+		goto done;
+	    goto ok;
+	}
+	if (xmldb_bulk_begin(h, target, myid) < 0)
+	    goto done;
+    }
+    else if (strcmp(op, "end") == 0){
+	if (iddb != myid){
+	    cprintf(cbx, "No bulk load of %s started by this session", target);
+	    if (netconf_operation_failed(cbret, "protocol", cbuf_get(cbx)) < 0)
+		goto done;
+	    goto ok;
+	}
+	if (xmldb_bulk_end(h, target) < 0){
+	    if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    else{
+	if (netconf_invalid_value(cbret, "protocol", "Wrong operation, expected begin or end")< 0)
+	    goto done;
+	goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
+    retval = 0;
+ done:
+    if (cbx)
+	cbuf_free(cbx);
+    return retval;
+}
+
+/*! Write the file of a datastore kept in the datastore cache only
  * @param[in]  h       Clicon handle 
  * @param[in]  xe      Request: <rpc><xn></rpc> 
  * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
@@ -1470,50 +3624,42 @@ from_client_debug(clicon_handle h,
  * @param[in]  regarg  User argument given at rpc_callback_register() 
  * @retval     0       OK
  * @retval    -1       Error
+ * @see CLICON_XMLDB_TRANSIENT
  */
 static int
-from_client_ping(clicon_handle h,
-		 cxobj        *xe,
-		 cbuf         *cbret,
-		 void         *arg,
-		 void         *regarg)
+from_client_flush_datastore(clicon_handle h,
+			    cxobj        *xe,
+			    cbuf         *cbret,
+			    void         *arg,
+			    void         *regarg)
 {
-    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
-    return 0;
-}
+    int    retval = -1;
+    char  *target;
+    cbuf  *cbx = NULL;
 
-/*! Check liveness of backend daemon,  just send a reply
- * @param[in]  h       Clicon handle 
- * @param[in]  xe      Request: <rpc><xn></rpc> 
- * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
- * @param[in]  arg     client-entry
- * @param[in]  regarg  User argument given at rpc_callback_register() 
- * @retval     0       OK
- * @retval    -1       Error
- */
-static int
-from_client_stats(clicon_handle h,
-		  cxobj        *xe,
-		  cbuf         *cbret,
-		  void         *arg,
-		  void         *regarg)
-{
-    int      retval = -1;
-    uint64_t nr;
-    
-    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
-    nr=0;
-    xml_stats_global(&nr);
-    cprintf(cbret, "<global><xmlnr>%" PRIu64 "</xmlnr></global>", nr);
-    if (clixon_stats_get_db(h, "running", cbret) < 0)
-	goto done;
-    if (clixon_stats_get_db(h, "candidate", cbret) < 0)
-	goto done;
-    if (clixon_stats_get_db(h, "startup", cbret) < 0)
-	goto done;
-    cprintf(cbret, "</rpc-reply>");
+    if ((target = xml_find_body(xe, "target")) == NULL)
+	target = "candidate";
+    if (xmldb_validate_db(target) < 0){
+	if ((cbx = cbuf_new()) == NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new");
+	    goto done;
+	}	
+	cprintf(cbx, "No such database: %s", target);
+	if (netconf_invalid_value(cbret, "protocol", cbuf_get(cbx))< 0)
+	    goto done;
+	goto ok;
+    }
+    if (xmldb_flush(h, target) < 0){
+	if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
+	    goto done;
+	goto ok;
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
     retval = 0;
  done:
+    if (cbx)
+	cbuf_free(cbx);
     return retval;
 }
 
@@ -1609,6 +3755,7 @@ from_client_process_control(clicon_handle  h,
 }
 
 /*! Clixon hello to check liveness
+ * Accept binary encoding of requests if offered by client, see clicon_msg_encode_bin
  * @retval     0       OK
  * @retval    -1       Error
  */
@@ -1621,6 +3768,10 @@ from_client_hello(clicon_handle       h,
     int      retval = -1;
     uint32_t id;
     char    *msgid;
+    cxobj   *xcaps;
+    cxobj   *xc;
+    char    *b;
+    int      binary = 0;
 
     if (clicon_session_id_get(h, &id) < 0){
 	clicon_err(OE_NETCONF, ENOENT, "session_id not set");
@@ -1628,17 +3779,211 @@ from_client_hello(clicon_handle       h,
     }
     id++;
     clicon_session_id_set(h, id);
+    if ((xcaps = xml_find_type(x, NULL, "capabilities", CX_ELMNT)) != NULL){
+	xc = NULL;
+	while ((xc = xml_child_each(xcaps, xc, CX_ELMNT)) != NULL)
+	    if (strcmp(xml_name(xc), "capability") == 0 &&
+		(b = xml_body(xc)) != NULL &&
+		strcmp(b, CLIXON_PROTO_BIN_CAPABILITY) == 0)
+		binary++;
+    }
+    cprintf(cbret, "<hello xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
     if ((msgid = xml_find_value(x, "message-id")) != NULL)
-	cprintf(cbret, "<hello xmlns=\"%s\" message-id=\"%s\"><session-id>%u</session-id></hello>",
-		NETCONF_BASE_NAMESPACE, msgid, id);
-    else
-	cprintf(cbret, "<hello xmlns=\"%s\"><session-id>%u</session-id></hello>",
-		NETCONF_BASE_NAMESPACE, id);
+	cprintf(cbret, " message-id=\"%s\"", msgid);
+    cprintf(cbret, ">");
+    if (binary)
+	cprintf(cbret, "<capabilities><capability>%s</capability></capabilities>",
+		CLIXON_PROTO_BIN_CAPABILITY);
+    cprintf(cbret, "<session-id>%u</session-id></hello>", id);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if client has any stream subscription
+ * @param[in]  h    Clicon handle
+ * @param[in]  ce   Client entry
+ * @retval     1    Client has subscription(s)
+ * @retval     0    No subscription
+ */
+static int
+client_subscribed(clicon_handle        h,
+		  struct client_entry *ce)
+{
+    event_stream_t *es;
+    
+    if ((es = clicon_stream(h)) != NULL)
+	do {
+	    if (stream_ss_find(es, ce_event_cb, (void*)ce) != NULL)
+		return 1;
+	    es = NEXTQ(struct event_stream *, es);
+	} while (es && es != clicon_stream(h));
+    return 0;
+}
+
+/* Number of running read workers, see CLICON_BACKEND_READ_WORKERS */
+static int _read_workers = 0;
+
+static int from_client_buffered(clicon_handle h, struct client_entry *ce);
+
+/*! Check if client entry still exists
+ * The entry may have been removed while handling a message, eg by kill-session
+ * @param[in]  h    Clicon handle
+ * @param[in]  ce   Client entry, may be freed
+ * @param[in]  nr   Client number of ce, in case ce is freed and reused
+ * @retval     1    Client exists
+ * @retval     0    Client is removed
+ */
+static int
+client_exists(clicon_handle        h,
+	      struct client_entry *ce,
+	      int                  nr)
+{
+    struct client_entry *c;
+
+    for (c = backend_client_list(h); c; c = c->ce_next)
+	if (c == ce && c->ce_nr == nr)
+	    return 1;
+    return 0;
+}
+
+/* Backend state of a running read worker */
+struct read_worker{
+    clicon_handle        rw_h;
+    struct client_entry *rw_ce;    /* suspended client */
+    int                  rw_ce_nr; /* Client number, in case ce is freed and reused */
+    pid_t                rw_pid;   /* worker process */
+};
+
+/*! Read worker has exited, resume its client
+ * The worker holds the write end of a pipe which is closed when it exits
+ * @param[in]  fd   Read end of pipe
+ * @param[in]  arg  Read worker struct
+ */
+static int
+read_worker_done(int   fd,
+		 void *arg)
+{
+    int                  retval = -1;
+    struct read_worker  *rw = (struct read_worker *)arg;
+    struct client_entry *ce;
+    int                  status = 0;
+    
+    clicon_debug(1, "%s pid:%d", __FUNCTION__, rw->rw_pid);
+    clixon_event_unreg_fd(fd, read_worker_done);
+    close(fd);
+    _read_workers--;
+    if (waitpid(rw->rw_pid, &status, 0) < 0){
+	/* Already reaped by SIGCHLD handler, exit status is not known */
+	if (errno != ECHILD){
+	    clicon_err(OE_UNIX, errno, "waitpid");
+	    goto done;
+	}
+    }
+    else if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+	clicon_log(LOG_WARNING, "%s: read worker %d exited with %d",
+		   __FUNCTION__, rw->rw_pid, WEXITSTATUS(status));
+    /* Client may have been removed, eg by kill-session */
+    ce = rw->rw_ce;
+    if (client_exists(rw->rw_h, ce, rw->rw_ce_nr) && ce->ce_s){
+	ce->ce_suspended = 0;
+	if (clixon_event_reg_fd(ce->ce_s, from_client, (void*)ce, "local netconf client socket") < 0)
+	    goto done;
+	/* Requests received while suspended */
+	if (from_client_buffered(rw->rw_h, ce) < 0)
+	    goto done;
+    }
     retval = 0;
  done:
+    free(rw);
     return retval;
 }
 
+/*! Handle a read-only RPC in a forked worker process
+ * The worker serves the RPC from a copy-on-write snapshot of the backend, ie the
+ * datastore caches, sends the reply to the client and exits, so that the backend
+ * event loop is not blocked by large get requests. The client is suspended until
+ * the worker exits to keep replies in order.
+ * Only single get and get-config RPCs of clients without stream subscriptions are 
+ * served, and at most CLICON_BACKEND_READ_WORKERS at the same time.
+ * Threads are not used since the clixon library is not thread-safe.
+ * @param[in]  h      Clicon handle
+ * @param[in]  ce     Client entry
+ * @param[in]  xrpc   Netconf rpc element
+ * @param[in]  xe     RPC operation element, child of xrpc
+ * @retval     2      In worker: handle RPC, send reply and exit
+ * @retval     1      In backend: worker started and sends the reply
+ * @retval     0      No worker started: handle RPC in backend
+ */
+static int
+read_worker_start(clicon_handle        h,
+		  struct client_entry *ce,
+		  cxobj               *xrpc,
+		  cxobj               *xe)
+{
+    struct read_worker *rw;
+    int                 max;
+    int                 p[2];
+    pid_t               pid;
+    yang_stmt          *ymod;
+
+    if ((max = clicon_option_int(h, "CLICON_BACKEND_READ_WORKERS")) <= 0 ||
+	_read_workers >= max)
+	return 0;
+    if (strcmp(xml_name(xe), "get") != 0 && strcmp(xml_name(xe), "get-config") != 0)
+	return 0;
+    if (xml_spec(xe) == NULL || (ymod = ys_module(xml_spec(xe))) == NULL ||
+	strcmp(yang_argument_get(ymod), "ietf-netconf") != 0)
+	return 0;
+    /* The worker handles all of the rest of the message */
+    if (xml_child_nr_type(xrpc, CX_ELMNT) != 1)
+	return 0;
+    /* Notifications would be interleaved with the reply */
+    if (client_subscribed(h, ce))
+	return 0;
+    if ((rw = malloc(sizeof(*rw))) == NULL){
+	clicon_log(LOG_WARNING, "%s malloc: %s", __FUNCTION__, strerror(errno));
+	return 0;
+    }
+    memset(rw, 0, sizeof(*rw));
+    if (pipe(p) < 0){
+	clicon_log(LOG_WARNING, "%s pipe: %s", __FUNCTION__, strerror(errno));
+	free(rw);
+	return 0;
+    }
+    rw->rw_h = h;
+    rw->rw_ce = ce;
+    rw->rw_ce_nr = ce->ce_nr;
+    /* Registered before fork, so that nothing can fail once the worker may reply */
+    if (clixon_event_reg_fd(p[0], read_worker_done, rw, "read worker") < 0){
+	clicon_log(LOG_WARNING, "%s: %s", __FUNCTION__, clicon_err_reason);
+	clicon_err_reset();
+	close(p[0]);
+	close(p[1]);
+	free(rw);
+	return 0;
+    }
+    if ((pid = fork()) < 0){
+	clicon_log(LOG_WARNING, "%s fork: %s", __FUNCTION__, strerror(errno));
+	clixon_event_unreg_fd(p[0], read_worker_done);
+	close(p[0]);
+	close(p[1]);
+	free(rw);
+	return 0;
+    }
+    if (pid == 0){ /* Worker, write end closed at exit */
+	close(p[0]);
+	return 2;
+    }
+    close(p[1]);
+    rw->rw_pid = pid;
+    clixon_event_unreg_fd(ce->ce_s, from_client);
+    ce->ce_suspended = 1;
+    _read_workers++;
+    clicon_debug(1, "%s pid:%d", __FUNCTION__, pid);
+    return 1;
+}
+
 /*! An internal clicon message has arrived from a client. Receive and dispatch.
  * @param[in]   h    Clicon handle
  * @param[in]   s    Socket where message arrived. read from this.
@@ -1671,8 +4016,16 @@ from_client_msg(clicon_handle        h,
     char                *rpcname;
     char                *rpcprefix;
     char                *namespace = NULL;
+    int                  worker = 0;
+    struct timespec      t0;
+    uint64_t             traceid;
+    struct timespec      tr;
+    int                  handoff = 0; /* Request handed to read worker */
+    size_t               outlen = 0;
     
     clicon_debug(1, "%s", __FUNCTION__);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    tr = ce->ce_rtime; /* ce may be removed by the rpc, eg kill-session */
     yspec = clicon_dbspec_yang(h); 
     /* Return netconf message. Should be filled in by the dispatch(sub) functions 
      * as wither rpc-error or by positive response.
@@ -1746,7 +4099,8 @@ from_client_msg(clicon_handle        h,
 	    goto done;
 	goto reply;
     }
-    ce->ce_id = id;
+    if (backend_client_id_set(h, ce, id) < 0)
+	goto done;
     if ((ret = xml_yang_validate_rpc(h, x, &xret)) < 0)
 	goto done;
     if (ret == 0){
@@ -1758,6 +4112,12 @@ from_client_msg(clicon_handle        h,
     username = xml_find_value(x, "username");
     /* May be used by callbacks, etc */
     clicon_username_set(h, username);
+    /* Use trace id of client, if any, for spans of this request */
+    if (clixon_trace_enabled()){
+	if (clixon_trace_id_parse(xml_find_value(x, "trace-id"), &traceid) == 0)
+	    traceid = clixon_trace_id_new();
+	clixon_trace_id_set(traceid);
+    }
     while ((xe = xml_child_each(x, xe, CX_ELMNT)) != NULL) {
 	rpc = xml_name(xe);
 	if ((ye = xml_spec(xe)) == NULL){
@@ -1792,11 +4152,18 @@ from_client_msg(clicon_handle        h,
 	    if (ret == 0) /* credentials fail */
 		goto reply;
 	    /* NACM rpc operation exec validation */
-	    if ((ret = nacm_rpc(rpc, module, username, xnacm, cbret)) < 0)
+	    if ((ret = nacm_rpc(h, rpc, module, username, xnacm, cbret)) < 0)
 		goto done;
 	    if (ret == 0) /* Not permitted and cbret set */
 		goto reply;
 	}
+	if (!worker){
+	    if ((ret = read_worker_start(h, ce, x, xe)) == 1){
+		handoff = 1;
+		goto ok; /* Reply sent by worker */
+	    }
+	    worker = (ret == 2);
+	}
 	clicon_err_reset();
 	if ((ret = rpc_callback_call(h, xe, cbret, ce)) < 0){
 	    if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
@@ -1809,9 +4176,12 @@ from_client_msg(clicon_handle        h,
 		goto done;
 	    goto reply;
 	}
+	if (ce->ce_reply_sent){ /* Reply already sent by callback */
+	    ce->ce_reply_sent = 0;
+	    goto ok;
+	}
 	if (xnacm){
-	    xml_free(xnacm);
-	    xnacm = NULL;
+	    xnacm = NULL; /* Owned by NACM rule set */
 	    if (clicon_nacm_cache_set(h, NULL) < 0)
 		goto done;
 	}
@@ -1820,9 +4190,17 @@ from_client_msg(clicon_handle        h,
     if (cbuf_len(cbret) == 0)
 	if (netconf_operation_failed(cbret, "application", clicon_errno?clicon_err_reason:"unknown")< 0)
 	    goto done;
+    /* Datastore files written by the request are synced before reply, see CLICON_XMLDB_SYNC */
+    if (xmldb_sync(h) < 0){
+	cbuf_reset(cbret);
+	if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
+	    goto done;
+    }
     clicon_debug(1, "%s cbret:%s", __FUNCTION__, cbuf_get(cbret));
     /* XXX problem here is that cbret has not been parsed so may contain 
        parse errors */
+    ce_notify_flush(ce);
+    outlen = cbuf_len(cbret)+1;
     if (send_msg_reply(ce->ce_s, cbuf_get(cbret), cbuf_len(cbret)+1) < 0){
 	switch (errno){
 	case EPIPE:
@@ -1840,12 +4218,16 @@ from_client_msg(clicon_handle        h,
 	    goto done;
 	}
     }
-    // ok:
+ ok:
     retval = 0;
   done:  
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    clixon_trace_end(&t0, "backend", rpc);
+    clixon_trace_id_set(0);
+    if (retval == 0 && rpc && !handoff && !worker &&
+	rpc_stats_add(rpc, &tr, &t0, ntohl(msg->op_len), outlen) < 0)
+	retval = -1;
     if (xnacm){
-	xml_free(xnacm);
 	if (clicon_nacm_cache_set(h, NULL) < 0)
 	    goto done;
     }
@@ -1860,9 +4242,47 @@ from_client_msg(clicon_handle        h,
 	clicon_log(LOG_NOTICE, "%s: Internal error: No clicon_err call on RPC error (message: %s)",
 		   __FUNCTION__, rpc?rpc:"");
     //    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (worker) /* Read worker process, see read_worker_start */
+	_exit(retval<0?1:0);
     return retval;// -1 here terminates backend
 }
 
+/*! Handle complete messages in the receive buffer of a client
+ *
+ * A client may send several requests without waiting for the replies, they are handled
+ * in order. Stop if the client is suspended by a read worker, or removed.
+ * @param[in]   h    Clicon handle
+ * @param[in]   ce   Client entry
+ * @see clicon_rpc_vec  client side
+ */
+static int
+from_client_buffered(clicon_handle        h,
+		     struct client_entry *ce)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    int                nr = ce->ce_nr;
+    int                ret;
+
+    while (ce->ce_rbuf && !ce->ce_suspended){
+	if ((ret = clicon_msg_rbuf_get(ce->ce_rbuf, &msg)) < 0)
+	    goto done;
+	if (ret == 0)
+	    break;
+	if (from_client_msg(h, ce, msg) < 0)
+	    goto done;
+	free(msg);
+	msg = NULL;
+	if (!client_exists(h, ce, nr))
+	    break;
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    return retval;
+}
+
 /*! An internal clicon message has arrived from a client. Receive and dispatch.
  * @param[in]   s    Socket where message arrived. read from this.
  * @param[in]   arg  Client entry (from).
@@ -1879,16 +4299,39 @@ from_client(int   s,
     struct client_entry *ce = (struct client_entry *)arg;
     clicon_handle        h = ce->ce_handle;
     int                  eof = 0;
+    int                  ret;
+    int                  nr;
 
     clicon_debug(1, "%s", __FUNCTION__);
     // assert(s == ce->ce_s);
-    if (clicon_msg_rcv(ce->ce_s, &msg, &eof) < 0)
+    if (ce->ce_rbuf == NULL &&
+	(ce->ce_rbuf = clicon_msg_rbuf_new()) == NULL)
 	goto done;
-    if (eof)
+    /* Read what is available, a partial message is kept until the rest arrives */
+    if ((ret = clicon_msg_rcv_nb(ce->ce_s, ce->ce_rbuf, &msg, &eof)) < 0)
+	goto done;
+    /* Read time of requests in receive buffer, for wait time in rpc statistics */
+    clock_gettime(CLOCK_MONOTONIC, &ce->ce_rtime);
+    if (eof){
 	backend_client_rm(h, ce); 
-    else
-	if (from_client_msg(h, ce, msg) < 0)
-	    goto done;
+	goto ok;
+    }
+    if (ret == 0)
+	goto ok;
+    /* Peer credentials are translated at first request, see backend_accept_one */
+    if (backend_client_cred(h, ce) < 0)
+	goto done;
+    nr = ce->ce_nr;
+    if (from_client_msg(h, ce, msg) < 0)
+	goto done;
+    /* Pipelined requests already received */
+    if (client_exists(h, ce, nr) &&
+	from_client_buffered(h, ce) < 0)
+	goto done;
+    /* Validate candidate in background if edited, see CLICON_VALIDATE_BACKGROUND */
+    if (validate_background_schedule(h) < 0)
+	goto done;
+ ok:
     retval = 0;
   done:
     clicon_debug(1, "%s retval=%d", __FUNCTION__, retval);
@@ -1897,6 +4340,264 @@ from_client(int   s,
     return retval; /* -1 here terminates backend */
 }
 
+/* Asynchronous reply of a plugin rpc, see rpc_async_start */
+struct rpc_async{
+    qelem_t                    ra_q;       /* queue header */
+    clicon_handle              ra_h;
+    struct client_entry       *ra_ce;      /* Suspended client, NULL if removed */
+    int                        ra_ce_nr;   /* Client number, in case ce is freed and reused */
+    clicon_rpc_async_cancel_cb ra_cancel;  /* Called if client is removed before reply */
+    void                      *ra_arg;     /* Argument of ra_cancel */
+    int                        ra_replied; /* Reply sent, client resumed by rpc_async_resume */
+};
+
+/* Pending asynchronous rpc replies */
+static struct rpc_async *_rpc_async_list = NULL;
+
+static int
+rpc_async_free(struct rpc_async *ra)
+{
+    DELQ(ra, _rpc_async_list, struct rpc_async *);
+    free(ra);
+    return 0;
+}
+
+/*! Input on socket of a client waiting for an asynchronous rpc reply
+ * Requests are buffered until the client is resumed, but eof removes the client
+ * and cancels the rpc, see rpc_async_client_rm
+ * @param[in]  s    Client socket
+ * @param[in]  arg  Asynchronous rpc
+ */
+static int
+rpc_async_input(int   s,
+		void *arg)
+{
+    struct rpc_async    *ra = (struct rpc_async *)arg;
+    struct client_entry *ce = ra->ra_ce;
+    int                  eof = 0;
+
+    if (ce->ce_rbuf == NULL &&
+	(ce->ce_rbuf = clicon_msg_rbuf_new()) == NULL)
+	return -1;
+    if (clicon_msg_rbuf_read(s, ce->ce_rbuf, &eof) < 0)
+	return -1;
+    if (eof)
+	backend_client_rm(ra->ra_h, ce);
+    return 0;
+}
+
+/*! Client is removed, cancel its pending asynchronous rpc
+ * If a cancel callback is set it is called and the rpc is freed, otherwise the
+ * rpc is kept until rpc_async_reply which discards the reply.
+ * @param[in]  h    Clicon handle
+ * @param[in]  ce   Client entry
+ */
+static int
+rpc_async_client_rm(clicon_handle        h,
+		    struct client_entry *ce)
+{
+    int               retval = -1;
+    struct rpc_async *ra;
+
+    while ((ra = _rpc_async_list) != NULL){
+	do {
+	    if (ra->ra_ce == ce)
+		break;
+	    ra = NEXTQ(struct rpc_async *, ra);
+	} while (ra != _rpc_async_list);
+	if (ra->ra_ce != ce)
+	    break;
+	ra->ra_ce = NULL;
+	if (ra->ra_replied) /* Freed by rpc_async_resume */
+	    continue;
+	if (ce->ce_s)
+	    clixon_event_unreg_fd(ce->ce_s, rpc_async_input);
+	if (ra->ra_cancel){
+	    clicon_debug(1, "%s client %d", __FUNCTION__, ra->ra_ce_nr);
+	    if (ra->ra_cancel(h, ra->ra_arg) < 0){
+		rpc_async_free(ra);
+		goto done;
+	    }
+	    rpc_async_free(ra);
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Resume a client after its asynchronous rpc reply is sent
+ * Called from the event loop, since the reply may be sent from the rpc callback
+ * @param[in]  s    Not used
+ * @param[in]  arg  Asynchronous rpc
+ */
+static int
+rpc_async_resume(int   s,
+		 void *arg)
+{
+    struct rpc_async    *ra = (struct rpc_async *)arg;
+    clicon_handle        h = ra->ra_h;
+    struct client_entry *ce = ra->ra_ce;
+    
+    rpc_async_free(ra);
+    if (ce == NULL || ce->ce_s == 0)
+	return 0;
+    ce->ce_suspended = 0;
+    if (clixon_event_reg_fd(ce->ce_s, from_client, (void*)ce, "local netconf client socket") < 0)
+	return -1;
+    /* Requests received while suspended */
+    return from_client_buffered(h, ce);
+}
+
+/*! Reply of a plugin rpc is sent later, eg when a long-running operation completes
+ *
+ * Call from the rpc callback, which then returns without a reply in cbret. The
+ * client is suspended until the reply is sent with rpc_async_reply, while other
+ * clients are served. If the client session is closed before the reply, the cancel
+ * callback of rpc_async_cancel_set is called.
+ * @param[in]  h    Clicon handle
+ * @param[in]  arg  Client entry, ie arg parameter of the rpc callback
+ * @retval     ra   Asynchronous rpc, a reply token for rpc_async_reply
+ * @retval     NULL Error
+ * @code
+ *   static int
+ *   my_rpc(clicon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg)
+ *   {
+ *       struct rpc_async *ra;
+ *       if ((ra = rpc_async_start(h, arg)) == NULL)
+ *           return -1;
+ *       ... start operation, eg a process with a pipe registered with
+ *           clixon_event_reg_fd, whose callback calls rpc_async_reply(h, ra, reply)
+ *       return 0;
+ *   }
+ * @endcode
+ * @note The backend is single-threaded: rpc_async_reply must be called from the
+ *       event loop, eg a timeout or the fd callback of a worker process or thread
+ */
+struct rpc_async *
+rpc_async_start(clicon_handle h,
+		void         *arg)
+{
+    struct client_entry *ce = (struct client_entry *)arg;
+    struct rpc_async    *ra;
+
+    if (ce == NULL || ce->ce_s == 0 || ce->ce_suspended){
+	clicon_err(OE_PLUGIN, EINVAL, "Rpc has no client or client is suspended");
+	return NULL;
+    }
+    if ((ra = malloc(sizeof(*ra))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(ra, 0, sizeof(*ra));
+    ra->ra_h = h;
+    ra->ra_ce = ce;
+    ra->ra_ce_nr = ce->ce_nr;
+    /* Suspend client until reply, but read to detect eof */
+    clixon_event_unreg_fd(ce->ce_s, from_client);
+    if (clixon_event_reg_fd(ce->ce_s, rpc_async_input, ra, "rpc async client socket") < 0){
+	free(ra);
+	return NULL;
+    }
+    ce->ce_suspended = 1;
+    ce->ce_reply_sent = 1;
+    ADDQ(ra, _rpc_async_list);
+    return ra;
+}
+
+/*! Set callback called if the client of an asynchronous rpc is removed before reply
+ * The asynchronous rpc is freed after the callback and cannot be used after it.
+ * @param[in]  ra   Asynchronous rpc, see rpc_async_start
+ * @param[in]  fn   Cancel callback, eg stop the operation
+ * @param[in]  arg  Argument of fn
+ * @retval     0    OK
+ */
+int
+rpc_async_cancel_set(struct rpc_async          *ra,
+		     clicon_rpc_async_cancel_cb fn,
+		     void                      *arg)
+{
+    ra->ra_cancel = fn;
+    ra->ra_arg = arg;
+    return 0;
+}
+
+/*! Send the reply of an asynchronous rpc and resume its client
+ * The asynchronous rpc is freed and cannot be used after the call.
+ * If the client has been removed, the reply is discarded.
+ * @param[in]  h      Clicon handle
+ * @param[in]  ra     Asynchronous rpc, see rpc_async_start
+ * @param[in]  reply  Reply as the rpc callback would write in cbret, eg <rpc-reply>..
+ *                    If NULL an operation-failed error with clicon_err_reason is sent
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+rpc_async_reply(clicon_handle     h,
+		struct rpc_async *ra,
+		char             *reply)
+{
+    int                  retval = -1;
+    struct client_entry *ce = ra->ra_ce;
+    cbuf                *cb = NULL;
+    struct timeval       t;
+
+    if (ra->ra_replied){
+	clicon_err(OE_PLUGIN, EINVAL, "Asynchronous rpc already replied");
+	goto done;
+    }
+    ra->ra_replied = 1;
+    if (ce == NULL || !client_exists(h, ce, ra->ra_ce_nr) || ce->ce_s == 0){
+	clicon_debug(1, "%s client %d removed, reply discarded", __FUNCTION__, ra->ra_ce_nr);
+	rpc_async_free(ra);
+	retval = 0;
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (reply == NULL || *reply == '\0'){
+	if (netconf_operation_failed(cb, "application", clicon_errno?clicon_err_reason:"unknown")< 0)
+	    goto done;
+    }
+    else
+	cprintf(cb, "%s", reply);
+    /* Datastore files written by the rpc are synced before reply, see CLICON_XMLDB_SYNC */
+    if (xmldb_sync(h) < 0){
+	cbuf_reset(cb);
+	if (netconf_operation_failed(cb, "application", clicon_err_reason)< 0)
+	    goto done;
+    }
+    clixon_event_unreg_fd(ce->ce_s, rpc_async_input);
+    ce_notify_flush(ce);
+    if (send_msg_reply(ce->ce_s, cbuf_get(cb), cbuf_len(cb)+1) < 0){
+	if (errno != ECONNRESET && errno != EPIPE)
+	    goto done;
+	clicon_log(LOG_WARNING, "client %d reset", ce->ce_nr);
+    }
+    gettimeofday(&t, NULL);
+    if (clixon_event_reg_timeout(t, rpc_async_resume, ra, "rpc async resume") < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Free pending asynchronous rpcs
+ */
+int
+rpc_async_exit(void)
+{
+    struct rpc_async *ra;
+
+    while ((ra = _rpc_async_list) != NULL)
+	rpc_async_free(ra);
+    return 0;
+}
+
 /*! Init backend rpc: Set up standard netconf rpc callbacks
  * @param[in]  h     Clicon handle
  * @retval       -1       Error (fatal)
@@ -1966,12 +4667,45 @@ backend_rpc_init(clicon_handle h)
     if (rpc_callback_register(h, from_client_stats, NULL,
 			      CLIXON_LIB_NS, "stats") < 0)
 	goto done;
+    if (rpc_callback_register(h, from_client_get_values, NULL,
+			      CLIXON_LIB_NS, "get-values") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_compare, NULL,
+			      CLIXON_LIB_NS, "compare") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_datastore_token, NULL,
+			      CLIXON_LIB_NS, "datastore-token") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_xpath_profile, NULL,
+			      CLIXON_LIB_NS, "xpath-profile") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_sample, NULL,
+			      CLIXON_LIB_NS, "sample") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_edit_batch, NULL,
+			      CLIXON_LIB_NS, "edit-batch") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_bulk_load, NULL,
+			      CLIXON_LIB_NS, "bulk-load") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_flush_datastore, NULL,
+			      CLIXON_LIB_NS, "flush-datastore") < 0)
+	goto done;
     if (rpc_callback_register(h, from_client_restart_plugin, NULL,
 			      CLIXON_LIB_NS, "restart-plugin") < 0)
 	goto done;
     if (rpc_callback_register(h, from_client_process_control, NULL,
 			      CLIXON_LIB_NS, "process-control") < 0)
 	goto done;
+    /* In backend_push.c */
+    if (backend_push_rpc_init(h) < 0)
+	goto done;
+    /* In backend_partial_lock.c */
+    if (backend_partial_lock_rpc_init(h) < 0)
+	goto done;
+    /* In backend_rollback.c */
+    if (backend_rollback_rpc_init(h) < 0)
+	goto done;
     retval =0;
  done:
     return retval;
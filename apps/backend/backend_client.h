@@ -40,12 +40,20 @@
 /*
  * Types
  */ 
+/* Notification waiting to be written to a client, see ce_notify_write */
+struct client_notify{
+    qelem_t              cn_q;   /* queue header */
+    struct stream_event *cn_se;  /* Shared event of cn_msg, or NULL if cn_msg is own */
+    struct clicon_msg   *cn_msg; /* Notify message */
+};
+
 /*
  * Client entry.
  * Keep state about every connected client.
  */
 struct client_entry{
     struct client_entry  *ce_next;    /* The clients linked list */
+    struct client_entry  *ce_prev;    /* Previous client, for removal */
     struct sockaddr       ce_addr;    /* The clients (UNIX domain) address */
     int                   ce_s;       /* stream socket to client */
     int                   ce_nr;      /* Client number (for dbg/tracing) */
@@ -53,14 +61,33 @@ struct client_entry{
     int                   ce_stat_out;/* Nr of sent msgs to client */
     int                   ce_id;      /* Session id */
     char                 *ce_username;/* Translated from peer user cred */
+    uid_t                 ce_uid;     /* Peer user id of unix socket client */
+    int                   ce_cred;    /* ce_uid not yet translated to ce_username */
     clicon_handle         ce_handle;  /* clicon config handle (all clients have same?) */
+    int                   ce_reply_sent; /* Reply already sent by rpc callback, eg chunked */
+    clicon_msg_rbuf      *ce_rbuf;    /* Receive buffer, see clicon_msg_rcv_nb */
+    int                   ce_suspended; /* Requests not handled while read worker or coalesced commit runs */
+    struct client_notify *ce_notify;  /* Notifications to write, first may be partly written */
+    int                   ce_notify_len; /* Number of notifications in ce_notify */
+    size_t                ce_notify_off; /* Bytes written of first notification */
+    int                   ce_notify_wreg; /* Write callback registered for ce_notify */
+    int                   ce_notify_closed; /* Disconnected by queue policy */
+    uint64_t              ce_notify_sent; /* Nr of notifications written to client */
+    uint64_t              ce_notify_dropped; /* Nr of notifications dropped by queue policy */
+    int                   ce_notify_max; /* Max length of ce_notify */
+    struct timespec       ce_rtime;   /* Time when last read from socket, see rpc_stats_add */
 };
 
 /*
  * Prototypes
  */ 
 int backend_client_rm(clicon_handle h, struct client_entry *ce);
+int backend_client_notify_free(struct client_entry *ce);
+int backend_client_notify(clicon_handle h, struct client_entry *ce, cxobj *event);
+int backend_client_get(clicon_handle h, char *xpath, cvec *nsc, cxobj **xret);
 int from_client(int fd, void *arg);
 int backend_rpc_init(clicon_handle h);
+int rpc_stats_exit(void);
+int rpc_async_exit(void);
 
 #endif  /* _BACKEND_CLIENT_H_ */
@@ -48,10 +48,12 @@
 #include <signal.h>
 #include <fcntl.h>
 #include <time.h>
+#include <inttypes.h>
 #include <pwd.h>
 #include <syslog.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <sys/param.h>
 #include <sys/types.h>
@@ -70,6 +72,316 @@
 #include "backend_handle.h"
 #include "backend_commit.h"
 #include "backend_client.h"
+#include "backend_push.h"
+#include "backend_rollback.h"
+#include "backend_partial_lock.h"
+#include "backend_private.h"
+
+/* Number of histogram buckets of commit statistics, see commit_stats_le */
+#define COMMIT_STATS_BUCKETS 7
+
+/* Upper bounds in us of histogram buckets, the last bucket is unbounded */
+static const uint64_t commit_stats_le[COMMIT_STATS_BUCKETS-1] = {
+    100, 1000, 10000, 100000, 1000000, 10000000
+};
+
+/* Timing statistics of a phase of validate/commit, or of a plugin callback */
+struct commit_stats{
+    struct commit_stats *cs_next;
+    char                *cs_name;   /* Phase, or plugin name */
+    char                *cs_cb;     /* Plugin callback, or NULL for phase */
+    uint64_t             cs_calls;  /* Number of times phase was run */
+    uint64_t             cs_total;  /* Total time in phase in us */
+    uint64_t             cs_max;    /* Max time of a single run in us */
+    uint64_t             cs_hist[COMMIT_STATS_BUCKETS]; /* Histogram of times */
+};
+
+/* Statistics entries, in order of first run */
+static struct commit_stats *commit_stats_list = NULL;
+
+/*! Register time spent in a phase of validate/commit or in a plugin callback
+ * @param[in]  name  Phase, eg "diff", or plugin name
+ * @param[in]  cb    Plugin callback, eg "validate", or NULL for phase
+ * @param[in]  t0    Monotonic time when phase started
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @code
+ *   struct timespec t0;
+ *
+ *   clock_gettime(CLOCK_MONOTONIC, &t0);
+ *   ...
+ *   if (commit_stats_add("diff", NULL, &t0) < 0)
+ *      err;
+ * @endcode
+ * The time is also reported as a span if the request is traced, see clixon_trace_span
+ * @see commit_stats_cbuf
+ */
+int
+commit_stats_add(const char      *name,
+		 const char      *cb,
+		 struct timespec *t0)
+{
+    struct commit_stats  *cs;
+    struct commit_stats **csp;
+    struct timespec       t1;
+    int64_t               d;
+    uint64_t              us;
+    int                   i;
+
+    for (csp = &commit_stats_list; (cs = *csp) != NULL; csp = &cs->cs_next)
+	if (strcmp(cs->cs_name, name) == 0 &&
+	    (cs->cs_cb == NULL ? cb == NULL : (cb != NULL && strcmp(cs->cs_cb, cb) == 0)))
+	    break;
+    if (cs == NULL){ /* New entry last */
+	if ((cs = malloc(sizeof(*cs))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    return -1;
+	}
+	memset(cs, 0, sizeof(*cs));
+	if ((cs->cs_name = strdup(name)) == NULL ||
+	    (cb && (cs->cs_cb = strdup(cb)) == NULL)){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    if (cs->cs_name)
+		free(cs->cs_name);
+	    free(cs);
+	    return -1;
+	}
+	*csp = cs;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    d = (int64_t)(t1.tv_sec - t0->tv_sec)*1000000 + (t1.tv_nsec - t0->tv_nsec)/1000;
+    us = d<0 ? 0 : (uint64_t)d;
+    cs->cs_calls++;
+    cs->cs_total += us;
+    if (us > cs->cs_max)
+	cs->cs_max = us;
+    for (i=0; i<COMMIT_STATS_BUCKETS-1; i++)
+	if (us <= commit_stats_le[i])
+	    break;
+    cs->cs_hist[i]++;
+    /* Plugin callback span is eg "validate" of plugin name, otherwise the phase */
+    clixon_trace_end(t0, cb?cb:name, cb?name:NULL);
+    return 0;
+}
+
+/*! Print validate/commit timing statistics as XML, see stats rpc in clixon-lib.yang
+ * @param[in,out] cb  CLIgen buffer
+ * @retval        0   OK
+ * @retval       -1   Error
+ */
+int
+commit_stats_cbuf(cbuf *cb)
+{
+    struct commit_stats *cs;
+    int                  i;
+
+    for (cs = commit_stats_list; cs; cs = cs->cs_next){
+	if (cs->cs_cb == NULL)
+	    cprintf(cb, "<commit-phase><name>%s</name>", cs->cs_name);
+	else{
+	    cprintf(cb, "<commit-plugin><plugin>");
+	    if (xml_chardata_cbuf_append(cb, cs->cs_name) < 0)
+		return -1;
+	    cprintf(cb, "</plugin><callback>%s</callback>", cs->cs_cb);
+	}
+	cprintf(cb, "<calls>%" PRIu64 "</calls>"
+		"<time-total>%" PRIu64 "</time-total>"
+		"<time-max>%" PRIu64 "</time-max>",
+		cs->cs_calls, cs->cs_total, cs->cs_max);
+	for (i=0; i<COMMIT_STATS_BUCKETS; i++){
+	    if (i < COMMIT_STATS_BUCKETS-1)
+		cprintf(cb, "<histogram><le>%" PRIu64 "</le>", commit_stats_le[i]);
+	    else
+		cprintf(cb, "<histogram><le>inf</le>");
+	    cprintf(cb, "<count>%" PRIu64 "</count></histogram>", cs->cs_hist[i]);
+	}
+	cprintf(cb, "</%s>", cs->cs_cb?"commit-plugin":"commit-phase");
+    }
+    return 0;
+}
+
+/* Memory statistics of validate/commit transactions, see transaction_mem_stats */
+struct transaction_mem_stats{
+    uint64_t tm_src_nr;     /* Number of nodes in source tree */
+    uint64_t tm_target_nr;  /* Number of nodes in target tree */
+    uint64_t tm_dlen;       /* Deleted vector length */
+    uint64_t tm_alen;       /* Added vector length */
+    uint64_t tm_clen;       /* Changed vector length */
+    long     tm_rss;        /* Resident set size change in kB */
+    long     tm_maxrss;     /* Max resident set size change in kB */
+};
+
+/* Number of transactions in memory statistics */
+static uint64_t transaction_mem_nr = 0;
+
+/* Memory statistics of last transaction */
+static struct transaction_mem_stats transaction_mem_last = {0,};
+
+/* Max of each field of memory statistics of all transactions */
+static struct transaction_mem_stats transaction_mem_max = {0,};
+
+/*! Get current and max resident set size of backend in kB
+ * @param[out] rss     Current resident set size, 0 if not known on this platform
+ * @param[out] maxrss  Max resident set size since start
+ */
+static void
+transaction_rss(long *rss,
+		long *maxrss)
+{
+    FILE         *f;
+    long          size;
+    long          pages = 0;
+    struct rusage ru;
+
+    if ((f = fopen("/proc/self/statm", "r")) != NULL){
+	if (fscanf(f, "%ld %ld", &size, &pages) != 2)
+	    pages = 0;
+	fclose(f);
+    }
+    *rss = pages * (sysconf(_SC_PAGESIZE) / 1024);
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+	*maxrss = ru.ru_maxrss;
+    else
+	*maxrss = 0;
+}
+
+/*! Register tree sizes and memory usage of a transaction after validation
+ * Source and target trees, diff vectors and the validated tree with defaults all
+ * exist here, so that the memory of the transaction is at its high-water mark.
+ * Logs a warning if the resident set size has grown with more than
+ * CLICON_TRANSACTION_MEM_THRESHOLD kB.
+ * @param[in]  h   Clicon handle
+ * @param[in]  td  Transaction, td_rss and td_maxrss are values at start
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see transaction_mem_stats_cbuf
+ */
+static int
+transaction_mem_stats(clicon_handle       h,
+		      transaction_data_t *td)
+{
+    struct transaction_mem_stats *tm = &transaction_mem_last;
+    struct transaction_mem_stats *tx = &transaction_mem_max;
+    long                          rss;
+    long                          maxrss;
+    size_t                        sz = 0;
+    int                           threshold;
+
+    td->td_src_nr = 0;
+    td->td_target_nr = 0;
+    if (td->td_src && xml_stats(td->td_src, &td->td_src_nr, &sz) < 0)
+	return -1;
+    if (td->td_target && xml_stats(td->td_target, &td->td_target_nr, &sz) < 0)
+	return -1;
+    transaction_rss(&rss, &maxrss);
+    td->td_rss = rss - td->td_rss;
+    td->td_maxrss = maxrss - td->td_maxrss;
+    tm->tm_src_nr = td->td_src_nr;
+    tm->tm_target_nr = td->td_target_nr;
+    tm->tm_dlen = td->td_dlen;
+    tm->tm_alen = td->td_alen;
+    tm->tm_clen = td->td_clen;
+    tm->tm_rss = td->td_rss;
+    tm->tm_maxrss = td->td_maxrss;
+    if (tm->tm_src_nr > tx->tm_src_nr)
+	tx->tm_src_nr = tm->tm_src_nr;
+    if (tm->tm_target_nr > tx->tm_target_nr)
+	tx->tm_target_nr = tm->tm_target_nr;
+    if (tm->tm_dlen > tx->tm_dlen)
+	tx->tm_dlen = tm->tm_dlen;
+    if (tm->tm_alen > tx->tm_alen)
+	tx->tm_alen = tm->tm_alen;
+    if (tm->tm_clen > tx->tm_clen)
+	tx->tm_clen = tm->tm_clen;
+    if (tm->tm_rss > tx->tm_rss)
+	tx->tm_rss = tm->tm_rss;
+    if (tm->tm_maxrss > tx->tm_maxrss)
+	tx->tm_maxrss = tm->tm_maxrss;
+    transaction_mem_nr++;
+    if ((threshold = clicon_option_int(h, "CLICON_TRANSACTION_MEM_THRESHOLD")) > 0 &&
+	(td->td_rss > threshold || td->td_maxrss > threshold))
+	clicon_log(LOG_WARNING, "Transaction %" PRIu64 ": rss +%ldkB maxrss +%ldkB "
+		   "src:%" PRIu64 " target:%" PRIu64 " nodes del:%d add:%d change:%d",
+		   td->td_id, td->td_rss, td->td_maxrss,
+		   td->td_src_nr, td->td_target_nr,
+		   td->td_dlen, td->td_alen, td->td_clen);
+    return 0;
+}
+
+/*! Print one entry of transaction memory statistics as XML
+ */
+static void
+transaction_mem_stats1(cbuf                         *cb,
+		       const char                   *name,
+		       struct transaction_mem_stats *tm)
+{
+    cprintf(cb, "<%s><src-nodes>%" PRIu64 "</src-nodes>"
+	    "<target-nodes>%" PRIu64 "</target-nodes>"
+	    "<deleted>%" PRIu64 "</deleted>"
+	    "<added>%" PRIu64 "</added>"
+	    "<changed>%" PRIu64 "</changed>"
+	    "<rss-delta>%ld</rss-delta>"
+	    "<maxrss-delta>%ld</maxrss-delta></%s>",
+	    name, tm->tm_src_nr, tm->tm_target_nr,
+	    tm->tm_dlen, tm->tm_alen, tm->tm_clen,
+	    tm->tm_rss, tm->tm_maxrss, name);
+}
+
+/*! Print transaction memory statistics as XML, see stats rpc in clixon-lib.yang
+ * @param[in,out] cb  CLIgen buffer
+ * @retval        0   OK
+ */
+int
+transaction_mem_stats_cbuf(cbuf *cb)
+{
+    if (transaction_mem_nr == 0)
+	return 0;
+    cprintf(cb, "<transaction-memory><transactions>%" PRIu64 "</transactions>",
+	    transaction_mem_nr);
+    transaction_mem_stats1(cb, "last", &transaction_mem_last);
+    transaction_mem_stats1(cb, "max", &transaction_mem_max);
+    cprintf(cb, "</transaction-memory>");
+    return 0;
+}
+
+/*! Free validate/commit timing statistics
+ */
+int
+commit_stats_exit(void)
+{
+    struct commit_stats *cs;
+
+    while ((cs = commit_stats_list) != NULL){
+	commit_stats_list = cs->cs_next;
+	free(cs->cs_name);
+	if (cs->cs_cb)
+	    free(cs->cs_cb);
+	free(cs);
+    }
+    return 0;
+}
+
+/*! Find node in target tree corresponding to a node in source tree
+ * @param[in]  xs   Node in source tree
+ * @param[in]  xt   Top of target tree
+ * @retval     x    Corresponding node in target tree
+ * @retval     NULL Not found
+ */
+static cxobj *
+xml_target_find(cxobj *xs,
+		cxobj *xt)
+{
+    cxobj *xp;
+    cxobj *x = NULL;
+
+    if ((xp = xml_parent(xs)) == NULL)
+	return xt;
+    if ((xp = xml_target_find(xp, xt)) == NULL)
+	return NULL;
+    if (match_base_child(xp, xs, xml_spec(xs), &x) < 0)
+	return NULL;
+    return x;
+}
 
 /*! Key values are checked for validity independent of user-defined callbacks
  *
@@ -101,9 +413,27 @@ generic_validate(clicon_handle       h,
     int        ret;
     cbuf      *cb = NULL;
     yang_stmt *yp;
+    int        incremental;
 
+    incremental = clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL");
+    /* Parents of deleted entries are changed in target, if not found validate all */
+    for (i=0; incremental && i<td->td_dlen; i++){
+	x1 = td->td_dvec[i];
+	if ((x2 = xml_target_find(xml_parent(x1), td->td_target)) == NULL){
+	    incremental = 0;
+	    break;
+	}
+	xml_flag_set(x2, XML_FLAG_CHANGE);
+	xml_apply_ancestor(x2, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    if (incremental){
+	/* Changed entries and entries that may depend on them */
+	if ((ret = xml_yang_validate_changed_top(h, td->td_target,
+						 td->td_dvec, td->td_dlen, xret)) < 0) 
+	    goto done;
+    }
     /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0) 
+    else if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0) 
 	goto done;
     if (ret == 0)
 	goto fail;
@@ -157,6 +487,218 @@ generic_validate(clicon_handle       h,
     goto done;
 }
 
+/*! Load target and source trees of a validate/commit transaction
+ * @param[in]  h          Clicon handle
+ * @param[in]  candidate  The candidate database. The wanted backend state
+ * @param[in]  td         Transaction, td_target and td_src are set
+ * @retval     0          OK
+ * @retval    -1          Error
+ * @see validate_diff
+ */
+static int
+validate_load(clicon_handle       h,
+	      char               *candidate,
+	      transaction_data_t *td)
+{
+    /* This is the state we are going to */
+    if (xmldb_get0(h, candidate, YB_MODULE, NULL, "/", 0, &td->td_target, NULL) < 0)
+	return -1;
+    /* Clear flags xpath for get */
+    xml_apply0(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    /* This is the state we are going from */
+    if (xmldb_get0(h, "running", YB_MODULE, NULL, "/", 0, &td->td_src, NULL) < 0)
+	return -1;
+    /* Clear flags xpath for get */
+    xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    return 0;
+}
+
+/*! Compute differences between source and target of a transaction and mark them
+ * @param[in]  yspec  Yang spec
+ * @param[in]  td     Transaction with td_target and td_src loaded
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see validate_load
+ */
+static int
+validate_diff(yang_stmt          *yspec,
+	      transaction_data_t *td)
+{
+    int    i;
+    cxobj *xn;
+
+    if (xml_diff(yspec, 
+		 td->td_src,
+		 td->td_target,
+		 &td->td_dvec,      /* removed: only in running */
+		 &td->td_dlen,
+		 &td->td_avec,      /* added: only in candidate */
+		 &td->td_alen,
+		 &td->td_scvec,     /* changed: original values */
+		 &td->td_tcvec,     /* changed: wanted values */
+		 &td->td_clen) < 0)
+	return -1;
+    if (clicon_debug_get()>1)
+	transaction_print(stderr, td);
+    /* Mark as changed in tree */
+    for (i=0; i<td->td_dlen; i++){ /* Also down */
+	xn = td->td_dvec[i];
+	xml_flag_set(xn, XML_FLAG_DEL);
+	xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_DEL);
+	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    for (i=0; i<td->td_alen; i++){ /* Also down */
+	xn = td->td_avec[i];
+	xml_flag_set(xn, XML_FLAG_ADD);
+	xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_ADD);
+	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    for (i=0; i<td->td_clen; i++){ /* Also up */
+	xn = td->td_scvec[i];
+	xml_flag_set(xn, XML_FLAG_CHANGE);
+	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+	xn = td->td_tcvec[i];
+	xml_flag_set(xn, XML_FLAG_CHANGE);
+	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    return 0;
+}
+
+/* Background validation of candidate, see CLICON_VALIDATE_BACKGROUND */
+struct validate_bg{
+    uint64_t vb_sched;     /* Candidate generation when timer was last set */
+    int      vb_timer;     /* Timer is registered */
+    int      vb_valid;     /* Generic validation succeeded for generations below */
+    uint64_t vb_candidate; /* Generation of validated candidate */
+    uint64_t vb_running;   /* Generation of running validated against */
+};
+
+static struct validate_bg _validate_bg = {0,};
+
+/*! Check if generic validation of a datastore was done in background and is current
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Datastore to be validated
+ * @retval     1    Candidate is valid and neither candidate nor running has changed
+ * @retval     0    Not validated
+ */
+static int
+validate_background_current(clicon_handle h,
+			    char         *db)
+{
+    struct validate_bg *vb = &_validate_bg;
+
+    return vb->vb_valid &&
+	strcmp(db, "candidate") == 0 &&
+	vb->vb_candidate == xmldb_generation(h, "candidate") &&
+	vb->vb_running == xmldb_generation(h, "running");
+}
+
+/*! Timer: generic validation of candidate in background when no edits are made
+ * Only a valid result is kept, a commit of an invalid candidate reports the errors.
+ * Errors are logged, they do not terminate the backend.
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Clicon handle
+ */
+static int
+validate_background_run(int   fd,
+			void *arg)
+{
+    clicon_handle       h = (clicon_handle)arg;
+    struct validate_bg *vb = &_validate_bg;
+    int                 retval = -1;
+    transaction_data_t *td = NULL;
+    yang_stmt          *yspec;
+    cxobj              *xret = NULL;
+    uint64_t            candidate;
+    uint64_t            running;
+    struct timespec     t0;
+    int                 ret;
+
+    vb->vb_timer = 0;
+    vb->vb_valid = 0;
+    candidate = xmldb_generation(h, "candidate");
+    running = xmldb_generation(h, "running");
+    clicon_debug(1, "%s candidate generation:%" PRIu64, __FUNCTION__, candidate);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_FATAL, 0, "No DB_SPEC");
+	goto done;
+    }	
+    if ((td = transaction_new()) == NULL)
+	goto done;
+    if (validate_load(h, "candidate", td) < 0)
+	goto done;
+    if (validate_diff(yspec, td) < 0)
+	goto done;
+    if ((ret = generic_validate(h, yspec, td, &xret)) < 0)
+	goto done;
+    if (ret == 1){
+	vb->vb_valid = 1;
+	vb->vb_candidate = candidate;
+	vb->vb_running = running;
+    }
+    if (commit_stats_add("background-validate", NULL, &t0) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (td){
+	if (xmldb_get0_clear(h, td->td_target) < 0 ||
+	    xmldb_get0_clear(h, td->td_src) < 0)
+	    retval = -1;
+	if (td->td_src)
+	    xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+		       (void*)XML_FLAG_DEL);
+	xmldb_get0_free(h, &td->td_target);
+	xmldb_get0_free(h, &td->td_src);
+	transaction_free(td);
+    }
+    if (xret)
+	xml_free(xret);
+    if (retval < 0){
+	vb->vb_valid = 0;
+	clicon_log(LOG_WARNING, "%s: %s", __FUNCTION__, clicon_err_reason);
+	clicon_err_reset();
+    }
+    return 0;
+}
+
+/*! Schedule background validation of candidate after it has been edited
+ * Validation is made when candidate has not been edited in CLICON_VALIDATE_BACKGROUND ms.
+ * The result is used by validate and commit of candidate if neither candidate nor running
+ * has changed since, so that generic validation is skipped.
+ * @param[in]  h    Clicon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+validate_background_schedule(clicon_handle h)
+{
+    struct validate_bg *vb = &_validate_bg;
+    uint64_t            gen;
+    int                 ms;
+    struct timeval      t;
+    struct timeval      t1;
+
+    if ((ms = clicon_option_int(h, "CLICON_VALIDATE_BACKGROUND")) <= 0)
+	return 0;
+    if ((gen = xmldb_generation(h, "candidate")) == vb->vb_sched)
+	return 0;
+    vb->vb_sched = gen;
+    /* Restart idle time at each edit */
+    if (vb->vb_timer)
+	clixon_event_unreg_timeout(validate_background_run, h);
+    gettimeofday(&t, NULL);
+    t1.tv_sec = ms/1000;
+    t1.tv_usec = (ms%1000)*1000;
+    timeradd(&t, &t1, &t);
+    if (clixon_event_reg_timeout(t, validate_background_run, h, "background validate") < 0)
+	return -1;
+    vb->vb_timer = 1;
+    return 0;
+}
+
 /*! Common startup validation
  * Get db, upgrade it w potential transformed XML, populate it w yang spec,
  * sort it, validate it by triggering a transaction
@@ -201,9 +743,11 @@ startup_common(clicon_handle       h,
 	    goto done;
     clicon_debug(1, "Reading startup config from %s", db);
     /* Get the startup datastore WITHOUT binding to YANG, sorting and default setting. 
-     * It is done below, later in this function
+     * It is done below, later in this function.
+     * The tree is detached from the datastore cache so that it is not held twice, it
+     * is validated in place and becomes the running cache in startup_commit
      */
-    if (xmldb_get0(h, db, YB_NONE, NULL, "/", 0, &xt, msdiff) < 0)
+    if (xmldb_get_detach(h, db, &xt, msdiff) < 0)
 	goto done;
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_YANG, 0, "Yang spec not set");
@@ -289,6 +833,8 @@ startup_common(clicon_handle       h,
 	if (cxvec_append(x, &td->td_avec, &td->td_alen) < 0) 
 	    goto done;
     }
+    if (transaction_ns_index(td) < 0)
+	goto done;
 
     /* 4. Call plugin transaction start callbacks */
     if (plugin_transaction_begin_all(h, td) < 0)
@@ -330,7 +876,7 @@ startup_common(clicon_handle       h,
  *
  * @param[in]  h       Clicon handle
  * @param[in]  db      The startup database. The wanted backend state
- * @param[out] xtr     (Potentially) transformed XML
+ * @param[out] xtr     (Potentially) transformed XML. Free with xml_free
  * @param[out] cbret   CLIgen buffer w error stmt if retval = 0
  * @retval    -1       Error - or validation failed (but cbret not set)
  * @retval     0       Validation failed (with cbret set)
@@ -367,10 +913,8 @@ startup_validate(clicon_handle  h,
     }
     retval = 1;
  done:
-     if (td){
-	 xmldb_get0_free(h, &td->td_target);
-	 transaction_free(td);
-     }
+     if (td)
+	 transaction_free(td); /* Also frees detached target tree */
     return retval;
  fail: /* cbret should be set */
     retval = 0;
@@ -395,6 +939,8 @@ startup_commit(clicon_handle  h,
     int                 retval = -1;
     int                 ret;
     transaction_data_t *td = NULL;
+    cxobj              *xt;
+    int                 cached = 0; /* td_target is the running cache */
 
     if (strcmp(db,"running")==0){
 	clicon_err(OE_FATAL, 0, "Invalid startup db: %s", db);
@@ -417,27 +963,14 @@ startup_commit(clicon_handle  h,
     if (xmldb_get0_clear(h, td->td_target) < 0)
 	goto done;
 
-    /* [Delete and] create running db */
-    if (xmldb_exists(h, "running") == 1){
-	if (xmldb_delete(h, "running") != 0 && errno != ENOENT) 
-	    goto done;;
-    }
-    if (xmldb_create(h, "running") < 0)
-	goto done;
-    /* 9, write (potentially modified) tree to running
-     * XXX note here startup is copied to candidate, which may confuse everything
-     * XXX default values are overwritten
+    /* 9, replace running with the (potentially modified) tree
+     * The tree is not copied: if running is cached, the cache takes it over and it is 
+     * only borrowed by the transaction until the end callbacks
      */
-    if (td->td_target)
-	/* target is datastore, but is here transformed to mimic an incoming 
-	 * edit-config
-	 */
-	xml_name_set(td->td_target,  NETCONF_INPUT_CONFIG);
-    if ((ret = xmldb_put(h, "running", OP_REPLACE, td->td_target,
-			 clicon_username_get(h), cbret)) < 0)
+    xt = td->td_target;
+    if (xmldb_replace(h, "running", &xt) < 0)
 	goto done;
-    if (ret == 0)
-	goto fail;
+    cached = (xt == NULL);
     /* 10. Call plugin transaction end callbacks */
     plugin_transaction_end_all(h, td);
     retval = 1;
@@ -445,7 +978,8 @@ startup_commit(clicon_handle  h,
     if (td){
 	if (retval < 1)
 	    plugin_transaction_abort_all(h, td);
-	xmldb_get0_free(h, &td->td_target);
+	if (cached)
+	    td->td_target = NULL;
 	transaction_free(td);
     }
     return retval;
@@ -475,81 +1009,67 @@ from_validate_common(clicon_handle       h,
 {
     int         retval = -1;
     yang_stmt  *yspec;
-    int         i;
-    cxobj      *xn;
     int         ret;
+    struct timespec t0;
     
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_FATAL, 0, "No DB_SPEC");
 	goto done;
     }	
-    /* This is the state we are going to */
-    if (xmldb_get0(h, candidate, YB_MODULE, NULL, "/", 0, &td->td_target, NULL) < 0)
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    transaction_rss(&td->td_rss, &td->td_maxrss);
+    if (validate_load(h, candidate, td) < 0)
 	goto done;
-
-    /* Clear flags xpath for get */
-    xml_apply0(td->td_target, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
-    /* 2. Parse xml trees 
-     * This is the state we are going from */
-    if (xmldb_get0(h, "running", YB_MODULE, NULL, "/", 0, &td->td_src, NULL) < 0)
+    if (commit_stats_add("load", NULL, &t0) < 0)
 	goto done;
-    /* Clear flags xpath for get */
-    xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-	       (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
+    clock_gettime(CLOCK_MONOTONIC, &t0);
     /* 3. Compute differences */
-    if (xml_diff(yspec, 
-		 td->td_src,
-		 td->td_target,
-		 &td->td_dvec,      /* removed: only in running */
-		 &td->td_dlen,
-		 &td->td_avec,      /* added: only in candidate */
-		 &td->td_alen,
-		 &td->td_scvec,     /* changed: original values */
-		 &td->td_tcvec,     /* changed: wanted values */
-		 &td->td_clen) < 0)
+    if (validate_diff(yspec, td) < 0)
+	goto done;
+    /* Group changes by namespace for plugins, see transaction_ns */
+    if (transaction_ns_index(td) < 0)
+	goto done;
+    if (commit_stats_add("diff", NULL, &t0) < 0)
 	goto done;
-    if (clicon_debug_get()>1)
-	transaction_print(stderr, td);
-    /* Mark as changed in tree */
-    for (i=0; i<td->td_dlen; i++){ /* Also down */
-	xn = td->td_dvec[i];
-	xml_flag_set(xn, XML_FLAG_DEL);
-	xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_DEL);
-	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-    }
-    for (i=0; i<td->td_alen; i++){ /* Also down */
-	xn = td->td_avec[i];
-	xml_flag_set(xn, XML_FLAG_ADD);
-	xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_ADD);
-	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-    }
-    for (i=0; i<td->td_clen; i++){ /* Also up */
-	xn = td->td_scvec[i];
-	xml_flag_set(xn, XML_FLAG_CHANGE);
-	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-	xn = td->td_tcvec[i];
-	xml_flag_set(xn, XML_FLAG_CHANGE);
-	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-    }
     /* 4. Call plugin transaction start callbacks */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
     if (plugin_transaction_begin_all(h, td) < 0)
 	goto done;
-
-    /* 5. Make generic validation on all new or changed data.
-       Note this is only call that uses 3-values */
-    if ((ret = generic_validate(h, yspec, td, xret)) < 0)
+    if (commit_stats_add("begin", NULL, &t0) < 0)
 	goto done;
-    if (ret == 0)
-	goto fail;
+
+    /* 5. Make generic validation on all new or changed data, unless already made
+       in background. Note this is only call that uses 3-values */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (validate_background_current(h, candidate)){
+	clicon_debug(1, "%s %s validated in background", __FUNCTION__, candidate);
+	if (commit_stats_add("generic-validate-background", NULL, &t0) < 0)
+	    goto done;
+    }
+    else{
+	if ((ret = generic_validate(h, yspec, td, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	if (commit_stats_add("generic-validate", NULL, &t0) < 0)
+	    goto done;
+    }
 
     /* 6. Call plugin transaction validate callbacks */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
     if (plugin_transaction_validate_all(h, td) < 0)
 	goto done;
+    if (commit_stats_add("validate", NULL, &t0) < 0)
+	goto done;
 
     /* 7. Call plugin transaction complete callbacks */
+    clock_gettime(CLOCK_MONOTONIC, &t0);
     if (plugin_transaction_complete_all(h, td) < 0)
 	goto done;
+    if (commit_stats_add("complete", NULL, &t0) < 0)
+	goto done;
+    if (transaction_mem_stats(h, td) < 0)
+	goto done;
     retval = 1;
  done:
     return retval;
@@ -578,7 +1098,12 @@ candidate_commit(clicon_handle h,
     transaction_data_t *td = NULL;
     int                 ret;
     cxobj              *xret = NULL;
+    cxobj              *xrb = NULL;
+    xmldb_snapshot     *sn = NULL;
+    struct timespec     t0;
+    struct timespec     t;
 
+    clock_gettime(CLOCK_MONOTONIC, &t0);
      /* 1. Start transaction */
     if ((td = transaction_new()) == NULL)
 	goto done;
@@ -595,22 +1120,60 @@ candidate_commit(clicon_handle h,
     }
 
      /* 7. Call plugin transaction commit callbacks */
+     clock_gettime(CLOCK_MONOTONIC, &t);
      if (plugin_transaction_commit_all(h, td) < 0)
 	 goto done;
+     if (commit_stats_add("commit", NULL, &t) < 0)
+	 goto done;
      /* After commit, make a post-commit call (sure that all plugins have committed) */
+     clock_gettime(CLOCK_MONOTONIC, &t);
      if (plugin_transaction_commit_done_all(h, td) < 0)
 	 goto done;
+     if (commit_stats_add("commit-done", NULL, &t) < 0)
+	 goto done;
+     /* Push changes to on-change subscriptions, before change flags are cleared */
+     clock_gettime(CLOCK_MONOTONIC, &t);
+     if (backend_push_commit(h, td) < 0)
+	 goto done;
+     if (commit_stats_add("push", NULL, &t) < 0)
+	 goto done;
+     /* Reverse change for rollback, also before trees are cleared */
+     if (backend_rollback_change(h, td, &xrb) < 0)
+	 goto done;
      
      /* Clear cached trees from default values and marking */
+     clock_gettime(CLOCK_MONOTONIC, &t);
      if (xmldb_get0_clear(h, td->td_target) < 0)
 	 goto done;
      if (xmldb_get0_clear(h, td->td_src) < 0)
 	 goto done;
+     if (commit_stats_add("clear", NULL, &t) < 0)
+	 goto done;
 
-     /* 8. Success: Copy candidate to running 
+     /* 8. Success: Copy candidate to running, including write of running file
       */
+     clock_gettime(CLOCK_MONOTONIC, &t);
+     /* Keep the replaced running tree for rollback */
+     if (xrb && xmldb_snapshot_get(h, "running", &sn) < 0)
+	 goto done;
      if (xmldb_copy(h, candidate, "running") < 0)
 	 goto done;
+     if (commit_stats_add("copy", NULL, &t) < 0)
+	 goto done;
+     if (xrb){
+	 if (sn == NULL){ /* Running could not be read, nothing to roll back to */
+	     xml_free(xrb);
+	     xrb = NULL;
+	     if (backend_rollback_reset(h) < 0)
+		 goto done;
+	 }
+	 else if (backend_rollback_add(h, sn, xrb) < 0)
+	     goto done;
+	 sn = NULL;
+	 xrb = NULL;
+     }
+     if (xmldb_shm_export(h, "running") < 0)
+	 goto done;
      xmldb_modified_set(h, candidate, 0); /* reset dirty bit */
      /* Here pointers to old (source) tree are obsolete */
      if (td->td_dvec){
@@ -624,7 +1187,12 @@ candidate_commit(clicon_handle h,
      }
 
     /* 9. Call plugin transaction end callbacks */
+    clock_gettime(CLOCK_MONOTONIC, &t);
     plugin_transaction_end_all(h, td);
+    if (commit_stats_add("end", NULL, &t) < 0)
+	goto done;
+    if (commit_stats_add("total", NULL, &t0) < 0)
+	goto done;
     
     retval = 1;
  done:
@@ -638,6 +1206,10 @@ candidate_commit(clicon_handle h,
      }
      if (xret)
 	 xml_free(xret);
+     if (xrb)
+	 xml_free(xrb);
+     if (sn)
+	 xmldb_snapshot_release(h, sn);
      return retval;
  fail:
     retval = 0;
@@ -670,6 +1242,7 @@ from_client_commit(clicon_handle h,
     uint32_t             myid = ce->ce_id;
     uint32_t             iddb;
     cbuf                *cbx = NULL; /* Assist cbuf */
+    char                *db;
     int                  ret;
 
     /* Check if target locked by other client */
@@ -684,15 +1257,30 @@ from_client_commit(clicon_handle h,
 	    goto done;
 	goto ok;
     }
-    if ((ret = candidate_commit(h, "candidate", cbret)) < 0){ /* Assume validation fail, nofatal */
+    /* Private candidate of session, if any, merged with changes of running */
+    if ((db = backend_private_db(h, myid, "candidate")) == NULL)
+	goto done;
+    if ((ret = backend_private_rebase(h, myid, cbret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    /* Check if nodes of running locked by other clients are changed */
+    if ((ret = backend_partial_lock_commit(h, myid, db, cbret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    if ((ret = candidate_commit(h, db, cbret)) < 0){ /* Assume validation fail, nofatal */
 	clicon_debug(1, "Commit candidate failed");
 	if (ret < 0)
 	    if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
 		goto done;
         goto ok;
     }
-    if (ret == 1)
+    if (ret == 1){
+	if (backend_private_reset(h, myid) < 0)
+	    goto done;
 	cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+    }
  ok:
     retval = 0;
  done:
@@ -738,12 +1326,12 @@ from_client_discard_changes(clicon_handle h,
 	    goto done;
 	goto ok;
     }
-    if (xmldb_copy(h, "running", "candidate") < 0){
+    /* Reset private candidate of session, or copy running to candidate */
+    if (backend_private_discard(h, myid) < 0){
 	if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
 	    goto done;
 	goto ok;
     }
-    xmldb_modified_set(h, "candidate", 0); /* reset dirty bit */
     cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
  ok:
     retval = 0;
@@ -798,6 +1386,7 @@ from_client_validate(clicon_handle h,
 		     void         *regarg)
 {
     int                 retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
     transaction_data_t *td = NULL;
     int                 ret;
     char               *db;
@@ -808,6 +1397,9 @@ from_client_validate(clicon_handle h,
 	    goto done;
 	goto ok;
     }
+    /* Private candidate of session, if any */
+    if ((db = backend_private_db(h, ce->ce_id, db)) == NULL)
+	goto done;
     clicon_debug(1, "Validate %s",  db);
 
     /* 1. Start transaction */
@@ -931,6 +1523,8 @@ from_client_restart_one(clicon_handle h,
 	xml_flag_set(xn, XML_FLAG_CHANGE);
 	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
     }
+    if (transaction_ns_index(td) < 0)
+	goto done;
     
     /* Call plugin transaction start callbacks */
     if (plugin_transaction_begin_one(cp, h, td) < 0)
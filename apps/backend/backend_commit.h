@@ -51,5 +51,10 @@ int from_client_discard_changes(clicon_handle h, cxobj *xe, cbuf *cbret, void *a
 int from_client_cancel_commit(clicon_handle h,	cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_validate(clicon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_restart_one(clicon_handle h, clixon_plugin *cp, cbuf *cbret);
+int commit_stats_add(const char *name, const char *cb, struct timespec *t0);
+int commit_stats_cbuf(cbuf *cb);
+int transaction_mem_stats_cbuf(cbuf *cb);
+int commit_stats_exit(void);
+int validate_background_schedule(clicon_handle h);
 
 #endif  /* _BACKEND_COMMIT_H_ */
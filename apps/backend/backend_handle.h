@@ -54,6 +54,29 @@ struct client_entry *backend_client_list(clicon_handle h);
 
 int backend_client_delete(clicon_handle h, struct client_entry *ce);
 
+int backend_client_id_set(clicon_handle h, struct client_entry *ce, uint32_t id);
+
+int backend_client_sock_set(clicon_handle h, struct client_entry *ce, int s);
+
+struct client_entry *backend_client_find_id(clicon_handle h, uint32_t id);
+
+struct client_entry *backend_client_find_sock(clicon_handle h, int s);
+
 int backend_client_print(clicon_handle h, FILE *f);
 
+int statedata_callback_delete_all(clicon_handle h);
+
+struct statedata_callback *statedata_callback_each(clicon_handle h, struct statedata_callback *sc);
+
+char *statedata_callback_path(struct statedata_callback *sc);
+
+int statedata_callback_call(clicon_handle h, struct statedata_callback *sc,
+			    cvec *nsc, char *xpath, cxobj *xtop);
+
+int statedata_cache_get(clicon_handle h, const char *provider, cvec *nsc, char *xpath,
+			cxobj **xp);
+
+int statedata_cache_put(clicon_handle h, const char *provider, cvec *nsc, char *xpath,
+			cxobj *x);
+
 #endif  /* _BACKEND_HANDLE_H_ */
@@ -47,6 +47,7 @@
 #include <errno.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <dirent.h>
 #include <time.h>
 #include <syslog.h>
 #include <ifaddrs.h>
@@ -70,12 +71,16 @@
 #include <clixon/clixon.h>
 
 #include "clixon_backend_transaction.h"
-#include "backend_socket.h"
 #include "backend_client.h"
+#include "backend_socket.h"
 #include "backend_plugin.h"
 #include "backend_commit.h"
 #include "backend_handle.h"
 #include "backend_startup.h"
+#include "backend_rollback.h"
+#include "backend_partial_lock.h"
+#include "backend_private.h"
+#include "backend_plugin_proc.h"
 #include "backend_plugin_restconf.h"
 
 /* Command line options to be passed to getopt(3) */
@@ -102,6 +107,12 @@ backend_terminate(clicon_handle h)
     clicon_debug(1, "%s", __FUNCTION__);
     if ((ss = clicon_socket_get(h)) != -1)
 	close(ss);
+    /* Plugin processes exit when their sockets are closed */
+    plugin_proc_exit(h);
+    /* Release rollback snapshots before the datastore */
+    backend_rollback_exit(h);
+    backend_partial_lock_exit(h);
+    backend_private_exit(h);
     /* Disconnect datastore */
     xmldb_disconnect(h);
     /* Clear module state caches */
@@ -120,6 +131,7 @@ backend_terminate(clicon_handle h)
 	ys_free(yspec);
     if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
 	cvec_free(nsctx);
+    nacm_ruleset_free(h);
     if ((x = clicon_nacm_ext(h)) != NULL)
 	xml_free(x);
     if ((x = clicon_conf_xml(h)) != NULL)
@@ -134,6 +146,12 @@ backend_terminate(clicon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    ctx_nodeset_pool_free();
+    xpath_cache_clear();
+    commit_stats_exit();
+    rpc_stats_exit();
+    rpc_async_exit();
+    state_validate_stats_exit();
 
     if (pidfile)
 	unlink(pidfile);   
@@ -251,8 +269,13 @@ xmldb_drop_priv(clicon_handle h,
 		uid_t         uid,
 		gid_t         gid)
 {
-    int         retval = -1;
-    char       *filename = NULL;
+    int            retval = -1;
+    char          *filename = NULL;
+    cbuf          *cb = NULL;
+    struct dirent *dp = NULL;
+    struct stat    st;
+    int            ndp;
+    int            i;
 
     if (xmldb_db2file(h, db, &filename) < 0)
 	goto done;
@@ -260,8 +283,47 @@ xmldb_drop_priv(clicon_handle h,
 	clicon_err(OE_UNIX, errno, "chown");
 	goto done;
     }
+    if (xmldb_journal_exists(h, db) == 1){
+	free(filename);
+	filename = NULL;
+	if (xmldb_db2journal(h, db, &filename) < 0)
+	    goto done;
+	if (chown(filename, uid, gid) < 0){
+	    clicon_err(OE_UNIX, errno, "chown");
+	    goto done;
+	}
+    }
+    /* Shard files, see CLICON_XMLDB_SHARD */
+    free(filename);
+    filename = NULL;
+    if (xmldb_db2shards(h, db, &filename) < 0)
+	goto done;
+    if (stat(filename, &st) == 0){
+	if (chown(filename, uid, gid) < 0){
+	    clicon_err(OE_UNIX, errno, "chown");
+	    goto done;
+	}
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if ((ndp = clicon_file_dirent(filename, &dp, "\\.xml$", S_IFREG)) < 0)
+	    goto done;
+	for (i = 0; i < ndp; i++){
+	    cbuf_reset(cb);
+	    cprintf(cb, "%s/%s", filename, dp[i].d_name);
+	    if (chown(cbuf_get(cb), uid, gid) < 0){
+		clicon_err(OE_UNIX, errno, "chown");
+		goto done;
+	    }
+	}
+    }
     retval = 0;
  done:
+    if (dp)
+	free(dp);
+    if (cb)
+	cbuf_free(cb);
     if (filename)
 	free(filename);
     return retval;
@@ -511,6 +573,7 @@ main(int    argc,
     size_t        cligen_buflen;
     size_t        cligen_bufthreshold;
     int           dbg;
+    int           warm = 0; /* Warm restart, see startup_warm */
     
     /* In the startup, logs to stderr & syslog and debug flag set later */
     clicon_log_init(__PROGRAM__, LOG_INFO, logdst);
@@ -760,6 +823,10 @@ main(int    argc,
     if (clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA") == 1)
 	xml_bind_yang_unknown_anydata(1);
 
+    /* Keep typed values of list keys from yang binding */
+    if (clicon_option_bool(h, "CLICON_XML_CV_CACHE") == 1)
+	xml_cv_cache_keep(1);
+
     /* Publish stream on pubsub channels.
      * CLICON_STREAM_PUB should be set to URL to where streams are published
      * and configure should be run with --enable-publish
@@ -876,6 +943,9 @@ main(int    argc,
 	/* [Delete and] create running db */
 	if (xmldb_db_reset(h, "running") < 0)
 	    goto done;
+	/* Commits of the old running cannot be rolled back */
+	if (backend_rollback_reset(h) < 0)
+	    goto done;
     case SM_NONE: /* Fall through *
 		   * Load plugins and call plugin_init() */
 	if (clixon_plugin_reset_all(h, "running") < 0)   
@@ -883,6 +953,14 @@ main(int    argc,
 	status = STARTUP_OK;
 	break;
     case SM_RUNNING: /* Use running as startup */
+	/* Warm restart if running is unchanged since last startup */
+	if ((ret = startup_warm(h, "running", extraxml_file)) < 0)
+	    goto done;
+	if (ret == 1){
+	    warm = 1;
+	    status = STARTUP_OK;
+	    break;
+	}
 	/* Copy original running to tmp as backup (restore if error) */
 	if (xmldb_copy(h, "running", "tmp") < 0)
 	    goto done;
@@ -895,6 +973,17 @@ main(int    argc,
 	    goto done;
 	break;
     case SM_STARTUP: 
+	/* Warm restart if startup and running are unchanged since last startup */
+	if ((ret = startup_warm(h, "startup", extraxml_file)) < 0)
+	    goto done;
+	if (ret == 1){
+	    warm = 1;
+	    status = STARTUP_OK;
+	    break;
+	}
+	/* Running is replaced by startup, its commits cannot be rolled back */
+	if (backend_rollback_reset(h) < 0)
+	    goto done;
 	/* Copy original running to tmp as backup (restore if error) */
 	if (xmldb_copy(h, "running", "tmp") < 0)
 	    goto done;
@@ -924,9 +1013,9 @@ main(int    argc,
     /* Merge extra XML from file and reset function to running  
      */
     if (status == STARTUP_OK){
-	if (startup_mode == SM_NONE){
-	    /* Special case for mode none: no commits are made therefore need to go through all processes
-	     * registered in plugins (specifically the restconf pseudo plugin)
+	if (startup_mode == SM_NONE || warm){
+	    /* Special case for mode none and warm restart: no commits are made therefore need to
+	     * go through all processes registered in plugins (specifically the restconf pseudo plugin)
 	     */
 	    if (clixon_process_start_all(h) < 0)
 		goto done;
@@ -937,6 +1026,12 @@ main(int    argc,
 	    if (ret2status(ret, &status) < 0)
 		goto done;
 	    /* if status = STARTUP_INVALID, cbret contains info */
+	    /* Running is now committed from startup, save stamp for next warm restart */
+	    if (status == STARTUP_OK &&
+		(startup_mode == SM_STARTUP || startup_mode == SM_RUNNING) &&
+		startup_warm_save(h, startup_mode==SM_STARTUP?"startup":"running",
+				  extraxml_file) < 0)
+		goto done;
 	}
     }
 
@@ -948,6 +1043,10 @@ main(int    argc,
 	}
     }
     
+    /* Export running to shared memory image, if enabled */
+    if (xmldb_shm_export(h, "running") < 0)
+	goto done;
+
     /* Initiate the shared candidate. */
     if (xmldb_copy(h, "running", "candidate") < 0)
 	goto done;
@@ -1006,6 +1105,11 @@ main(int    argc,
 	clicon_err(OE_DAEMON, errno, "Setting signal");
 	goto done;
     }
+    /* Start and stop sampling profiler, see clixon_sample_pending_run() */
+    if (clixon_sample_sig_register() < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
     /* Initialize server socket and save it to handle */
     if ((ss = backend_server_socket(h)) < 0)
 	goto done;
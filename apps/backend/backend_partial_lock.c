@@ -0,0 +1,657 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Partial locks of the running datastore, RFC 5717, see CLICON_NETCONF_PARTIAL_LOCK
+ * A partial lock locks the nodes of running selected by xpaths, and their descendants,
+ * for a session. The locked nodes are kept as a tree of copies of the locked nodes and
+ * their ancestors, with list keys, where the locked nodes are marked. The tree is
+ * matched against edits, other partial locks and commits, so that sessions editing
+ * disjoint parts of running do not block each other.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_handle.h"
+#include "backend_client.h"
+#include "backend_partial_lock.h"
+
+/* A partial lock of running */
+struct partial_lock{
+    qelem_t   pl_qelem;   /* List header */
+    uint32_t  pl_id;      /* Lock id */
+    uint32_t  pl_session; /* Session holding the lock */
+    cxobj    *pl_xt;      /* Locked nodes with ancestors, locked nodes are XML_FLAG_MARK */
+};
+
+/*
+ * Variables
+ */ 
+static struct partial_lock *_partial_locks = NULL;
+static uint32_t             _partial_lock_id = 0; /* Last lock id */
+
+/*! Print instance-identifier of a datastore node, RFC 7950 Sec 9.13
+ * @param[in]  x    Datastore node bound to yang
+ * @param[in]  cb   Instance-identifier
+ * @param[in]  nsc  Namespace context of prefixes used in cb
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+partial_lock_instance_id(cxobj *x,
+			 cbuf  *cb,
+			 cvec  *nsc)
+{
+    cxobj     *xp;
+    cxobj     *xk;
+    yang_stmt *y;
+    cg_var    *cvi;
+    char      *prefix;
+    char      *ns;
+    char      *b;
+
+    if ((xp = xml_parent(x)) != NULL && xml_parent(xp) != NULL &&
+	partial_lock_instance_id(xp, cb, nsc) < 0)
+	return -1;
+    if ((y = xml_spec(x)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec of %s", xml_name(x));
+	return -1;
+    }
+    prefix = yang_find_myprefix(y);
+    ns = yang_find_mynamespace(y);
+    if (prefix && ns && xml_nsctx_get(nsc, prefix) == NULL &&
+	xml_nsctx_add(nsc, prefix, ns) < 0)
+	return -1;
+    cprintf(cb, "/%s:%s", prefix, xml_name(x));
+    switch (yang_keyword_get(y)){
+    case Y_LEAF_LIST:
+	cprintf(cb, "[.='");
+	if ((b = xml_body(x)) != NULL && xml_chardata_cbuf_append(cb, b) < 0)
+	    return -1;
+	cprintf(cb, "']");
+	break;
+    case Y_LIST:
+	cvi = NULL;
+	while ((cvi = cvec_each(yang_cvec_get(y), cvi)) != NULL){
+	    cprintf(cb, "[%s:%s='", prefix, cv_string_get(cvi));
+	    if ((xk = xml_find_type(x, NULL, cv_string_get(cvi), CX_ELMNT)) != NULL &&
+		(b = xml_body(xk)) != NULL &&
+		xml_chardata_cbuf_append(cb, b) < 0)
+		return -1;
+	    cprintf(cb, "']");
+	}
+	break;
+    default:
+	break;
+    }
+    return 0;
+}
+
+/*! Check if two locks have a node in common
+ * @param[in]  xa   Lock, or node of lock
+ * @param[in]  xb   Other lock, or its node matching xa
+ * @retval     1    A node is locked by both, ie a locked node of one is locked or an
+ *                  ancestor of a locked node in the other
+ * @retval     0    No
+ */
+static int
+partial_lock_overlap(cxobj *xa,
+		     cxobj *xb)
+{
+    cxobj *xac = NULL;
+    cxobj *xbc;
+
+    while ((xac = xml_child_each(xa, xac, CX_ELMNT)) != NULL){
+	if ((xbc = xml_find_node_keys(xb, xac)) == NULL)
+	    continue;
+	if (xml_flag(xac, XML_FLAG_MARK) || xml_flag(xbc, XML_FLAG_MARK))
+	    return 1;
+	if (partial_lock_overlap(xac, xbc))
+	    return 1;
+    }
+    return 0;
+}
+
+/*! Check if an edit modifies a node of a lock
+ * @param[in]  xl   Lock, or node of lock
+ * @param[in]  xe   Edit, or its node matching xl
+ * @param[in]  op   Operation of xe, inherited from its ancestors if not set
+ * @retval     1    A locked node is edited, or an ancestor is replaced or deleted
+ * @retval     0    No
+ * @retval    -1    Error
+ */
+static int
+partial_lock_edited(cxobj              *xl,
+		    cxobj              *xe,
+		    enum operation_type op)
+{
+    cxobj              *xlc = NULL;
+    cxobj              *xec;
+    char               *opstr;
+    enum operation_type op1;
+    int                 ret;
+
+    while ((xlc = xml_child_each(xl, xlc, CX_ELMNT)) != NULL){
+	if ((xec = xml_find_node_keys(xe, xlc)) == NULL)
+	    continue;
+	if (xml_flag(xlc, XML_FLAG_MARK))
+	    return 1;
+	op1 = op;
+	if ((opstr = xml_find_type_value(xec, NULL, "operation", CX_ATTR)) != NULL &&
+	    xml_operation(opstr, &op1) < 0)
+	    return -1;
+	if (op1 == OP_REPLACE || op1 == OP_DELETE || op1 == OP_REMOVE)
+	    return 1;
+	if ((ret = partial_lock_edited(xlc, xec, op1)) != 0)
+	    return ret;
+    }
+    return 0;
+}
+
+/*! Check if the locked nodes of a lock differ between two datastore trees
+ * @param[in]  xl   Lock, or node of lock
+ * @param[in]  x0   First tree, or its node matching xl, or NULL
+ * @param[in]  x1   Second tree, or its node matching xl, or NULL
+ * @param[in]  cb0  Assist buffer
+ * @param[in]  cb1  Assist buffer
+ * @retval     1    A locked node differs
+ * @retval     0    No
+ * @retval    -1    Error
+ */
+static int
+partial_lock_changed(cxobj *xl,
+		     cxobj *x0,
+		     cxobj *x1,
+		     cbuf  *cb0,
+		     cbuf  *cb1)
+{
+    cxobj *xlc = NULL;
+    cxobj *x0c;
+    cxobj *x1c;
+    int    ret;
+
+    while ((xlc = xml_child_each(xl, xlc, CX_ELMNT)) != NULL){
+	x0c = x0 ? xml_find_node_keys(x0, xlc) : NULL;
+	x1c = x1 ? xml_find_node_keys(x1, xlc) : NULL;
+	if (x0c == x1c) /* Both missing, or shared tree */
+	    continue;
+	if (xml_flag(xlc, XML_FLAG_MARK)){
+	    if (x0c == NULL || x1c == NULL)
+		return 1;
+	    cbuf_reset(cb0);
+	    cbuf_reset(cb1);
+	    if (clicon_xml2cbuf(cb0, x0c, 0, 0, -1) < 0)
+		return -1;
+	    if (clicon_xml2cbuf(cb1, x1c, 0, 0, -1) < 0)
+		return -1;
+	    if (strcmp(cbuf_get(cb0), cbuf_get(cb1)) != 0)
+		return 1;
+	    continue;
+	}
+	if ((ret = partial_lock_changed(xlc, x0c, x1c, cb0, cb1)) != 0)
+	    return ret;
+    }
+    return 0;
+}
+
+/*! Free a partial lock
+ * @param[in]  pl   Partial lock, removed from list
+ */
+static void
+partial_lock_free(struct partial_lock *pl)
+{
+    if (pl->pl_xt)
+	xml_free(pl->pl_xt);
+    free(pl);
+}
+
+/*! Get a session holding a partial lock, other than a given session
+ * @param[in]  id   Session id
+ * @retval     id1  Session id of another session holding a partial lock
+ * @retval     0    No other session holds a partial lock
+ */
+uint32_t
+backend_partial_lock_held(uint32_t id)
+{
+    struct partial_lock *pl;
+
+    if ((pl = _partial_locks) != NULL)
+	do {
+	    if (pl->pl_session != id)
+		return pl->pl_session;
+	    pl = NEXTQ(struct partial_lock *, pl);
+	} while (pl && pl != _partial_locks);
+    return 0;
+}
+
+/*! Check if an edit of running modifies nodes locked by other sessions
+ * @param[in]  h     Clicon handle
+ * @param[in]  id    Session id of edit
+ * @param[in]  op    Default operation of edit
+ * @param[in]  xc    Edit: <config>...</config>. Bound to yang
+ * @param[out] cbret Error reply if denied
+ * @retval     1     OK
+ * @retval     0     Denied, error in cbret
+ * @retval    -1     Error
+ */
+int
+backend_partial_lock_edit(clicon_handle       h,
+			  uint32_t            id,
+			  enum operation_type op,
+			  cxobj              *xc,
+			  cbuf               *cbret)
+{
+    int                  retval = -1;
+    struct partial_lock *pl;
+    cbuf                *cbx = NULL;
+    int                  ret = 0;
+
+    if ((pl = _partial_locks) != NULL)
+	do {
+	    if (pl->pl_session != id){
+		/* A top-level replace replaces all nodes */
+		if (op == OP_REPLACE)
+		    ret = 1;
+		else if ((ret = partial_lock_edited(pl->pl_xt, xc, op)) < 0)
+		    goto done;
+		if (ret == 1)
+		    break;
+	    }
+	    pl = NEXTQ(struct partial_lock *, pl);
+	} while (pl && pl != _partial_locks);
+    if (ret == 1){
+	if ((cbx = cbuf_new()) == NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new");
+	    goto done;
+	}
+	cprintf(cbx, "<session-id>%u</session-id>", pl->pl_session);
+	if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, partial lock is already held") < 0)
+	    goto done;
+	goto fail;
+    }
+    retval = 1;
+ done:
+    if (cbx)
+	cbuf_free(cbx);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if a commit of candidate modifies nodes of running locked by other sessions
+ * @param[in]  h     Clicon handle
+ * @param[in]  id    Session id of commit
+ * @param[in]  db    Candidate, eg "candidate" or a private candidate
+ * @param[out] cbret Error reply if denied
+ * @retval     1     OK
+ * @retval     0     Denied, error in cbret
+ * @retval    -1     Error
+ */
+int
+backend_partial_lock_commit(clicon_handle h,
+			    uint32_t      id,
+			    char         *db,
+			    cbuf         *cbret)
+{
+    int                  retval = -1;
+    struct partial_lock *pl;
+    cxobj               *x0 = NULL;
+    cxobj               *x1 = NULL;
+    cbuf                *cb0 = NULL;
+    cbuf                *cb1 = NULL;
+    int                  ret = 0;
+
+    if (backend_partial_lock_held(id) == 0)
+	goto ok;
+    if (xmldb_get0(h, "running", YB_MODULE, NULL, "/", 0, &x0, NULL) < 0)
+	goto done;
+    if (xmldb_get0(h, db, YB_MODULE, NULL, "/", 0, &x1, NULL) < 0)
+	goto done;
+    if ((cb0 = cbuf_new()) == NULL ||
+	(cb1 = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    pl = _partial_locks;
+    do {
+	if (pl->pl_session != id &&
+	    (ret = partial_lock_changed(pl->pl_xt, x0, x1, cb0, cb1)) != 0)
+	    break;
+	pl = NEXTQ(struct partial_lock *, pl);
+    } while (pl && pl != _partial_locks);
+    if (ret < 0)
+	goto done;
+    if (ret == 1){
+	if (netconf_in_use(cbret, "protocol", "Operation failed, partial lock is already held") < 0)
+	    goto done;
+	goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    if (cb0)
+	cbuf_free(cb0);
+    if (cb1)
+	cbuf_free(cb1);
+    if (x0)
+	xmldb_get0_free(h, &x0);
+    if (x1)
+	xmldb_get0_free(h, &x1);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Release all partial locks of a session, eg when it ends
+ * @param[in]  id   Session id, or 0 for all sessions
+ * @retval     0    OK
+ */
+int
+backend_partial_lock_release(uint32_t id)
+{
+    struct partial_lock *pl;
+
+ again:
+    if ((pl = _partial_locks) != NULL)
+	do {
+	    if (id == 0 || pl->pl_session == id){
+		DELQ(pl, _partial_locks, struct partial_lock *);
+		partial_lock_free(pl);
+		goto again;
+	    }
+	    pl = NEXTQ(struct partial_lock *, pl);
+	} while (pl != _partial_locks);
+    return 0;
+}
+
+/*! Lock parts of the running datastore, RFC 5717 partial-lock
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_partial_lock(clicon_handle h,
+			 cxobj        *xe,
+			 cbuf         *cbret,
+			 void         *arg, 
+			 void         *regarg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    uint32_t             id = ce->ce_id;
+    uint32_t             iddb;
+    struct partial_lock *pl = NULL;
+    struct partial_lock *pl1;
+    cxobj               *xt = NULL;
+    cxobj               *x;
+    cxobj               *xc;
+    cxobj              **vec = NULL;
+    size_t               veclen;
+    cvec                *nsc = NULL;
+    cvec                *nscl = NULL;
+    cg_var              *cv;
+    cbuf                *cbx = NULL;
+    cbuf                *cbl = NULL;
+    char                *select;
+    int                  i;
+
+    if ((cbx = cbuf_new()) == NULL ||
+	(cbl = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    /* Not granted if running is locked by another session */
+    if ((iddb = xmldb_islocked(h, "running")) != 0 && iddb != id){
+	cprintf(cbx, "<session-id>%u</session-id>", iddb);
+	if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, lock is already held") < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((pl = calloc(1, sizeof(*pl))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    pl->pl_session = id;
+    if ((pl->pl_xt = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (xmldb_get0(h, "running", YB_MODULE, NULL, "/", 0, &xt, NULL) < 0)
+	goto done;
+    x = NULL;
+    while ((x = xml_child_each(xe, x, CX_ELMNT)) != NULL){
+	if (strcmp(xml_name(x), "select") != 0)
+	    continue;
+	if ((select = xml_body(x)) == NULL)
+	    select = "";
+	/* Namespace context of the select xpath */
+	if (nsc){
+	    xml_nsctx_free(nsc);
+	    nsc = NULL;
+	}
+	if (xml_nsctx_node(x, &nsc) < 0)
+	    goto done;
+	if (xpath_vec(xt, nsc, "%s", &vec, &veclen, select) < 0){
+	    cbuf_reset(cbx);
+	    cprintf(cbx, "Invalid select %s: %s", select, clicon_err_reason);
+	    if (netconf_invalid_value(cbret, "protocol", cbuf_get(cbx)) < 0)
+		goto done;
+	    goto ok;
+	}
+	/* The result must be a node set of configuration data */
+	for (i=0; i<veclen; i++)
+	    if (xml_type(vec[i]) != CX_ELMNT ||
+		xml_parent(vec[i]) == NULL ||
+		xml_spec(vec[i]) == NULL ||
+		yang_config(xml_spec(vec[i])) == 0)
+		break;
+	if (veclen == 0 || i < veclen){
+	    cbuf_reset(cbx);
+	    cprintf(cbx, "Select %s does not select configuration nodes", select);
+	    if (netconf_invalid_value(cbret, "protocol", cbuf_get(cbx)) < 0)
+		goto done;
+	    goto ok;
+	}
+	for (i=0; i<veclen; i++){
+	    if ((xc = xml_copy_node_path(pl->pl_xt, vec[i])) == NULL)
+		goto done;
+	    if (xml_flag(xc, XML_FLAG_MARK))
+		continue; /* Also selected by another select */
+	    xml_flag_set(xc, XML_FLAG_MARK);
+	    if ((nscl = xml_nsctx_init(NULL, NULL)) == NULL)
+		goto done;
+	    cbuf_reset(cbx);
+	    if (partial_lock_instance_id(vec[i], cbx, nscl) < 0)
+		goto done;
+	    cprintf(cbl, "<locked-node xmlns=\"%s\"", NETCONF_PARTIAL_LOCK_NAMESPACE);
+	    cv = NULL;
+	    while ((cv = cvec_each(nscl, cv)) != NULL)
+		cprintf(cbl, " xmlns:%s=\"%s\"", cv_name_get(cv), cv_string_get(cv));
+	    cprintf(cbl, ">%s</locked-node>", cbuf_get(cbx));
+	    xml_nsctx_free(nscl);
+	    nscl = NULL;
+	}
+	if (vec){
+	    free(vec);
+	    vec = NULL;
+	}
+    }
+    /* Not granted if a node is locked by another session */
+    if ((pl1 = _partial_locks) != NULL)
+	do {
+	    if (pl1->pl_session != id && partial_lock_overlap(pl->pl_xt, pl1->pl_xt)){
+		cbuf_reset(cbx);
+		cprintf(cbx, "<session-id>%u</session-id>", pl1->pl_session);
+		if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, partial lock is already held") < 0)
+		    goto done;
+		goto ok;
+	    }
+	    pl1 = NEXTQ(struct partial_lock *, pl1);
+	} while (pl1 && pl1 != _partial_locks);
+    pl->pl_id = ++_partial_lock_id;
+    ADDQ(pl, _partial_locks);
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
+    cprintf(cbret, "<lock-id xmlns=\"%s\">%u</lock-id>", NETCONF_PARTIAL_LOCK_NAMESPACE, pl->pl_id);
+    cprintf(cbret, "%s", cbuf_get(cbl));
+    cprintf(cbret, "</rpc-reply>");
+    pl = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (pl)
+	partial_lock_free(pl);
+    if (xt)
+	xmldb_get0_free(h, &xt);
+    if (vec)
+	free(vec);
+    if (nscl)
+	xml_nsctx_free(nscl);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (cbl)
+	cbuf_free(cbl);
+    if (cbx)
+	cbuf_free(cbx);
+    return retval;
+}
+
+/*! Release a partial lock, RFC 5717 partial-unlock
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_partial_unlock(clicon_handle h,
+			   cxobj        *xe,
+			   cbuf         *cbret,
+			   void         *arg, 
+			   void         *regarg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    uint32_t             id = ce->ce_id;
+    struct partial_lock *pl;
+    char                *str;
+    uint32_t             lockid = 0;
+    char                *reason = NULL;
+    int                  ret;
+
+    if ((str = xml_find_body(xe, "lock-id")) == NULL){
+	if (netconf_missing_element(cbret, "protocol", "lock-id", NULL) < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((ret = parse_uint32(str, &lockid, &reason)) < 0){
+	clicon_err(OE_XML, errno, "parse_uint32"); 
+	goto done;
+    }
+    /* The lock must be held by the session */
+    if ((pl = _partial_locks) != NULL && ret == 1)
+	do {
+	    if (pl->pl_id == lockid && pl->pl_session == id)
+		break;
+	    pl = NEXTQ(struct partial_lock *, pl);
+	} while (pl != _partial_locks);
+    if (ret == 0 || pl == NULL || pl->pl_id != lockid || pl->pl_session != id){
+	if (netconf_invalid_value(cbret, "protocol", "Unlock failed, no such partial lock") < 0)
+	    goto done;
+	goto ok;
+    }
+    DELQ(pl, _partial_locks, struct partial_lock *);
+    partial_lock_free(pl);
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
+    retval = 0;
+ done:
+    if (reason)
+	free(reason);
+    return retval;
+}
+
+/*! Release all partial locks at backend exit
+ * @param[in]  h   Clicon handle
+ * @retval     0   OK
+ */
+int
+backend_partial_lock_exit(clicon_handle h)
+{
+    return backend_partial_lock_release(0);
+}
+
+/*! Register partial-lock and partial-unlock rpcs if CLICON_NETCONF_PARTIAL_LOCK is set
+ * @param[in]  h   Clicon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+backend_partial_lock_rpc_init(clicon_handle h)
+{
+    int retval = -1;
+
+    if (!clicon_option_bool(h, "CLICON_NETCONF_PARTIAL_LOCK"))
+	goto ok;
+    if (rpc_callback_register(h, from_client_partial_lock, NULL,
+			      NETCONF_PARTIAL_LOCK_NAMESPACE, "partial-lock") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_partial_unlock, NULL,
+			      NETCONF_PARTIAL_LOCK_NAMESPACE, "partial-unlock") < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
@@ -44,13 +44,18 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <inttypes.h>
 #include <dlfcn.h>
 #include <dirent.h>
 #include <unistd.h>
 #include <errno.h>
 #include <signal.h>
 #include <syslog.h>
+#include <poll.h>
+#include <time.h>
 #include <sys/types.h>
+#include <sys/time.h>
+#include <sys/wait.h>
 #include <sys/stat.h>
 #include <sys/param.h>
 #include <netinet/in.h>
@@ -64,6 +69,8 @@
 #include "clixon_backend_transaction.h"
 #include "backend_plugin.h"
 #include "backend_commit.h"
+#include "backend_handle.h"
+#include "backend_plugin_proc.h"
 
 /*! Request plugins to reset system state
  * The system 'state' should be the same as the contents of running_db
@@ -118,6 +125,59 @@ clixon_plugin_reset_all(clicon_handle h,
     return retval;
 }
 
+/*! Request plugin to resync system state with running on warm restart
+ * Running has not changed since the system was last committed from it, but the system
+ * state may have, eg after a reboot
+ * @param[in]  cp      Plugin handle
+ * @param[in]  h       Clicon handle
+ * @param[in]  db      Name of datastore
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see startup_warm
+ */
+int
+clixon_plugin_resync_one(clixon_plugin *cp,
+			 clicon_handle  h,
+			 char          *db)
+{
+    int          retval = -1;
+    plgreset_t  *fn;       /* callback */
+
+    if ((fn = cp->cp_api.ca_resync) != NULL){
+	if (fn(h, db) < 0) {
+	    if (clicon_errno < 0) 
+		clicon_log(LOG_WARNING, "%s: Internal error: Resync callback in plugin: %s returned -1 but did not make a clicon_err call",
+			   __FUNCTION__, cp->cp_name);
+	    goto done;
+	}
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Call all plugins resync callbacks
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Name of datastore
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+int
+clixon_plugin_resync_all(clicon_handle h,
+			 char         *db)
+{
+    int             retval = -1;
+    clixon_plugin  *cp = NULL;
+    
+    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+	if (clixon_plugin_resync_one(cp, h, db) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Call single plugin "pre-" daemonize callback
  * @param[in]  cp      Plugin handle
  * @param[in]  h       Clixon handle
@@ -275,6 +335,373 @@ clixon_plugin_statedata_one(clixon_plugin  *cp,
     goto done;
 }
 
+/* State of asynchronous statedata of one plugin, see plgstatedata_start_t */
+struct statedata_async{
+    clixon_plugin *sa_cp;
+    cxobj         *sa_xcache;  /* Cached state, start callback not called */
+    int            sa_fd;      /* Readable when state is ready */
+    enum {SA_WAIT, SA_READY, SA_FAILED, SA_TIMEOUT} sa_status;
+};
+
+/*! Start asynchronous statedata callbacks of all plugins and wait for them concurrently
+ * Each plugin with a ca_statedata_start callback starts fetching its state, then all
+ * returned file descriptors are waited for until readable or until
+ * CLICON_BACKEND_STATEDATA_TIMEOUT milliseconds has passed. The state is then read by
+ * the ordinary ca_statedata callbacks.
+ * @param[in]  h       clicon handle
+ * @param[in]  nsc     Namespace context
+ * @param[in]  xpath   String with XPATH syntax. or NULL for all
+ * @param[out] savec   Vector of plugins with start callbacks, free after use
+ * @param[out] salen   Length of savec
+ * @retval    -1       Error
+ * @retval     0       OK
+ */
+static int
+clixon_plugin_statedata_start_all(clicon_handle            h,
+				  cvec                    *nsc,
+				  char                    *xpath,
+				  struct statedata_async **savec,
+				  int                     *salen)
+{
+    int                     retval = -1;
+    clixon_plugin          *cp = NULL;
+    plgstatedata_start_t   *fn;
+    struct statedata_async *sa = NULL;
+    struct pollfd          *pfds = NULL;
+    int                     len = 0;
+    int                     i;
+    int                     n;
+    int                     ret;
+    int                     timeout;
+    int                     ms;
+    struct timeval          t;
+    struct timeval          t1;
+    struct timeval          tdl;   /* deadline */
+
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	if (cp->cp_api.ca_statedata_start != NULL)
+	    len++;
+    if (len == 0)
+	goto ok;
+    if ((sa = calloc(len, sizeof(*sa))) == NULL ||
+	(pfds = calloc(len, sizeof(*pfds))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    i = 0;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL){
+	if ((fn = cp->cp_api.ca_statedata_start) == NULL)
+	    continue;
+	sa[i].sa_cp = cp;
+	sa[i].sa_fd = -1;
+	/* State is cached: do not start fetching */
+	if ((ret = statedata_cache_get(h, cp->cp_name, nsc, xpath, &sa[i].sa_xcache)) < 0)
+	    goto done;
+	if (ret == 1)
+	    sa[i].sa_status = SA_READY;
+	else if (fn(h, nsc, xpath, &sa[i].sa_fd) < 0){
+	    if (clicon_errno < 0) 
+		clicon_log(LOG_WARNING, "%s: Internal error: State start callback in plugin: %s returned -1 but did not make a clicon_err call",
+			   __FUNCTION__, cp->cp_name);
+	    sa[i].sa_status = SA_FAILED; /* Dont quit here on user callbacks */
+	}
+	else if (sa[i].sa_fd < 0) /* synchronous */
+	    sa[i].sa_status = SA_READY;
+	else
+	    sa[i].sa_status = SA_WAIT;
+	i++;
+    }
+    timeout = clicon_option_int(h, "CLICON_BACKEND_STATEDATA_TIMEOUT");
+    gettimeofday(&tdl, NULL);
+    t.tv_sec = timeout/1000;
+    t.tv_usec = (timeout%1000)*1000;
+    timeradd(&tdl, &t, &tdl);
+    while (1){
+	n = 0;
+	for (i=0; i<len; i++)
+	    if (sa[i].sa_status == SA_WAIT){
+		pfds[n].fd = sa[i].sa_fd;
+		pfds[n].events = POLLIN;
+		pfds[n].revents = 0;
+		n++;
+	    }
+	if (n == 0)
+	    break;
+	ms = -1;
+	if (timeout > 0){
+	    gettimeofday(&t1, NULL);
+	    timersub(&tdl, &t1, &t);
+	    if (t.tv_sec < 0)
+		ms = 0;
+	    else
+		ms = t.tv_sec*1000 + (t.tv_usec+999)/1000;
+	}
+	if ((ret = poll(pfds, n, ms)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "poll");
+	    goto done;
+	}
+	n = 0;
+	for (i=0; i<len; i++)
+	    if (sa[i].sa_status == SA_WAIT){
+		if (ret == 0)
+		    sa[i].sa_status = SA_TIMEOUT;
+		else if (pfds[n].revents)
+		    sa[i].sa_status = SA_READY;
+		n++;
+	    }
+    }
+ ok:
+    *savec = sa;
+    *salen = len;
+    sa = NULL;
+    retval = 0;
+ done:
+    if (sa){
+	for (i=0; i<len; i++)
+	    if (sa[i].sa_xcache)
+		xml_free(sa[i].sa_xcache);
+	free(sa);
+    }
+    if (pfds)
+	free(pfds);
+    return retval;
+}
+
+/* Statistics of validation of state data per provider, see CLICON_VALIDATE_STATE_XML */
+struct state_validate_stats{
+    struct state_validate_stats *sv_next;
+    char    *sv_name;      /* Plugin name, state callback path or STATE_VALIDATE_ALL */
+    uint64_t sv_calls;     /* Number of times state was produced */
+    uint64_t sv_validated; /* Number of times state was validated */
+    uint64_t sv_failures;  /* Number of times state was invalid */
+};
+
+/* State validation entries, in order of first call */
+static struct state_validate_stats *state_validate_list = NULL;
+
+/*! Find or create state validation statistics of a provider
+ * @param[in]  name  Name of provider
+ * @retval     sv    Statistics entry
+ * @retval     NULL  Error
+ */
+static struct state_validate_stats *
+state_validate_stats_get(const char *name)
+{
+    struct state_validate_stats  *sv;
+    struct state_validate_stats **svp;
+
+    for (svp = &state_validate_list; (sv = *svp) != NULL; svp = &sv->sv_next)
+	if (strcmp(sv->sv_name, name) == 0)
+	    return sv;
+    if ((sv = malloc(sizeof(*sv))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(sv, 0, sizeof(*sv));
+    if ((sv->sv_name = strdup(name)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	free(sv);
+	return NULL;
+    }
+    *svp = sv;
+    return sv;
+}
+
+/*! Check if state data should be validated on schema level only
+ * @param[in]  h   Clicon handle
+ * @retval     1   Validate each provider on schema level
+ * @retval     0   Validate merged state with running config, or no validation
+ * @see CLICON_VALIDATE_STATE_XML_LEVEL
+ */
+int
+state_validate_schema_level(clicon_handle h)
+{
+    char *level;
+
+    if (!clicon_option_bool(h, "CLICON_VALIDATE_STATE_XML"))
+	return 0;
+    if ((level = clicon_option_str(h, "CLICON_VALIDATE_STATE_XML_LEVEL")) == NULL)
+	return 0;
+    return strcmp(level, "schema") == 0;
+}
+
+/*! Count state of a provider and check if it should be validated in this call
+ * One in CLICON_VALIDATE_STATE_XML_SAMPLE calls is validated, starting with the first
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Name of provider, or STATE_VALIDATE_ALL for the merged state tree
+ * @retval     1     Validate state
+ * @retval     0     Skip validation
+ * @retval    -1     Error
+ * @see state_validate_failed
+ */
+int
+state_validate_sample(clicon_handle h,
+		      const char   *name)
+{
+    struct state_validate_stats *sv;
+    int                          n;
+
+    if ((sv = state_validate_stats_get(name)) == NULL)
+	return -1;
+    if ((n = clicon_option_int(h, "CLICON_VALIDATE_STATE_XML_SAMPLE")) < 1)
+	n = 1;
+    if (sv->sv_calls++ % n != 0)
+	return 0;
+    sv->sv_validated++;
+    return 1;
+}
+
+/*! Count a state validation failure of a provider
+ * @param[in]  name  Name of provider, or STATE_VALIDATE_ALL
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+state_validate_failed(const char *name)
+{
+    struct state_validate_stats *sv;
+
+    if ((sv = state_validate_stats_get(name)) == NULL)
+	return -1;
+    sv->sv_failures++;
+    return 0;
+}
+
+/*! Print state validation statistics as XML, see stats rpc in clixon-lib.yang
+ * @param[in,out] cb  CLIgen buffer
+ * @retval        0   OK
+ * @retval       -1   Error
+ */
+int
+state_validate_stats_cbuf(cbuf *cb)
+{
+    struct state_validate_stats *sv;
+
+    for (sv = state_validate_list; sv; sv = sv->sv_next){
+	cprintf(cb, "<state-validate><name>");
+	if (xml_chardata_cbuf_append(cb, sv->sv_name) < 0)
+	    return -1;
+	cprintf(cb, "</name>"
+		"<calls>%" PRIu64 "</calls>"
+		"<validated>%" PRIu64 "</validated>"
+		"<failures>%" PRIu64 "</failures>"
+		"</state-validate>",
+		sv->sv_calls, sv->sv_validated, sv->sv_failures);
+    }
+    return 0;
+}
+
+/*! Free state validation statistics
+ */
+int
+state_validate_stats_exit(void)
+{
+    struct state_validate_stats *sv;
+
+    while ((sv = state_validate_list) != NULL){
+	state_validate_list = sv->sv_next;
+	free(sv->sv_name);
+	free(sv);
+    }
+    return 0;
+}
+
+/*! Merge state data of one callback into the state tree
+ * Bind state XML to yang, sort, add defaults and merge
+ * @param[in]     h       clicon handle
+ * @param[in]     yspec   Yang spec
+ * @param[in]     x       State XML of one callback, empty is ignored
+ * @param[in]     errmsg  Error message prefix if state is invalid
+ * @param[in]     name    Name of callback for error message, eg plugin name
+ * @param[in,out] xret    State XML tree is merged with existing tree.
+ * @retval       -1       Error
+ * @retval        0       Invalid state (xret set with netconf-error)
+ * @retval        1       OK
+ */
+static int
+clixon_statedata_merge(clicon_handle h,
+		       yang_stmt    *yspec,
+		       cxobj        *x,
+		       char         *errmsg,
+		       char         *name,
+		       cxobj       **xret)
+{
+    int    retval = -1;
+    int    ret;
+    cxobj *xerr = NULL;
+    int    validate = 0;
+
+    if (xml_child_nr(x) == 0)
+	goto ok;
+#if 1
+    if (clicon_debug_get())
+	clicon_log_xml(LOG_DEBUG, x, "%s STATE:", __FUNCTION__);
+#endif
+    if (state_validate_schema_level(h) &&
+	(validate = state_validate_sample(h, name)) < 0)
+	goto done;
+    /* XXX: ret == 0 invalid yang binding should be handled as internal error */
+    if ((ret = xml_bind_yang(x, YB_MODULE, yspec, &xerr)) < 0)
+	goto done;
+    if (ret == 0){
+	if (validate && state_validate_failed(name) < 0)
+	    goto done;
+	if (clixon_netconf_internal_error(xerr, errmsg, name) < 0)
+	    goto done;
+	xml_free(*xret);
+	*xret = xerr;
+	xerr = NULL;
+	goto fail;
+    }
+    if (xml_sort_recurse(x) < 0)
+	goto done;
+    /* Mark non-presence containers as XML_FLAG_DEFAULT */
+    if (xml_apply(x, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_DEFAULT) < 0)
+	goto done;
+    /* Clear XML tree of defaults */
+    if (xml_tree_prune_flagged(x, XML_FLAG_DEFAULT, 1) < 0)
+	goto done;
+    /* clear mark and change */
+    xml_apply0(x, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
+	       (void*)(0xffff));
+    /* Default values are printed when the tree is serialized, see XML_FLAG_REPORT_ALL */
+    if ((validate || *xret == NULL || !xml_flag(*xret, XML_FLAG_REPORT_ALL)) &&
+	xml_default_recurse(x, 1) < 0)
+	goto done;
+    /* Schema level validation of state of this provider only, no must/when/leafref */
+    if (validate){
+	if ((ret = xml_yang_validate_add(h, x, &xerr)) < 0)
+	    goto done;
+	if (ret == 0){
+	    if (state_validate_failed(name) < 0)
+		goto done;
+	    if (clicon_debug_get())
+		clicon_log_xml(LOG_DEBUG, x, "VALIDATE_STATE");
+	    if (clixon_netconf_internal_error(xerr, errmsg, name) < 0)
+		goto done;
+	    xml_free(*xret);
+	    *xret = xerr;
+	    xerr = NULL;
+	    goto fail;
+	}
+    }
+    if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+ ok:
+    retval = 1;
+ done:
+    if (xerr)
+	xml_free(xerr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Go through all backend statedata callbacks and collect state data
  * This is internal system call, plugin is invoked (does not call) this function
  * Backend plugins can register 
@@ -301,10 +728,54 @@ clixon_plugin_statedata_all(clicon_handle    h,
     clixon_plugin  *cp = NULL;
     cbuf           *cberr = NULL; 
     cxobj          *xerr = NULL;
+    struct statedata_async *savec = NULL;
+    int             salen = 0;
+    int             i;
+    struct statedata_callback *sc = NULL;
     
     clicon_debug(1, "%s", __FUNCTION__);
+    /* Fan out asynchronous statedata, the result is read by ca_statedata below */
+    if (clixon_plugin_statedata_start_all(h, nsc, xpath, &savec, &salen) < 0)
+	goto done;
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-	if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+	for (i=0; i<salen; i++)
+	    if (savec[i].sa_cp == cp)
+		break;
+	if (i<salen && savec[i].sa_status != SA_READY){
+	    if ((cberr = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    if (savec[i].sa_status == SA_TIMEOUT)
+		cprintf(cberr, "Internal error, state callback in plugin %s timed out", cp->cp_name);
+	    else
+		cprintf(cberr, "Internal error, state start callback in plugin %s failed: %s",
+			cp->cp_name, clicon_err_reason);
+	    if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
+		goto done;
+	    xml_free(*xret);
+	    *xret = xerr;
+	    xerr = NULL;
+	    goto fail;
+	}
+	/* Cached state, see statedata_cache_ttl_set */
+	ret = 0;
+	if (i<salen && savec[i].sa_xcache){
+	    x = savec[i].sa_xcache;
+	    savec[i].sa_xcache = NULL;
+	    ret = 2;
+	}
+	else if (i == salen && cp->cp_api.ca_statedata != NULL){
+	    if ((ret = statedata_cache_get(h, cp->cp_name, nsc, xpath, &x)) < 0)
+		goto done;
+	    if (ret == 1)
+		ret = 2;
+	}
+	if (ret != 2 &&
+	    (ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+	    goto done;
+	if (ret == 1 && x &&
+	    statedata_cache_put(h, cp->cp_name, nsc, xpath, x) < 0)
 	    goto done;
 	if (ret == 0){
 	    if ((cberr = cbuf_new()) == NULL){
@@ -323,52 +794,54 @@ clixon_plugin_statedata_all(clicon_handle    h,
 	}
 	if (x == NULL)
 	    continue;
-	if (xml_child_nr(x) == 0){
+	if ((ret = clixon_statedata_merge(h, yspec, x, 
+					  ". Internal error, state callback returned invalid XML from plugin: ",
+					  cp->cp_name, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	if (x){
 	    xml_free(x);
 	    x = NULL;
-	    continue;
 	}
-#if 1
-	if (clicon_debug_get())
-	    clicon_log_xml(LOG_DEBUG, x, "%s STATE:", __FUNCTION__);
-#endif
-	/* XXX: ret == 0 invalid yang binding should be handled as internal error */
-	if ((ret = xml_bind_yang(x, YB_MODULE, yspec, &xerr)) < 0)
+    } /* while plugin */
+    /* Statedata callbacks registered on YANG data nodes, only called if xpath intersects */
+    while ((sc = statedata_callback_each(h, sc)) != NULL) {
+	if ((x = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	    goto done;
+	if ((ret = statedata_callback_call(h, sc, nsc, xpath, x)) < 0)
 	    goto done;
 	if (ret == 0){
-	    if (clixon_netconf_internal_error(xerr,
-					      ". Internal error, state callback returned invalid XML from plugin: ",
-					      cp->cp_name) < 0)
+	    if ((cberr = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cprintf(cberr, "Internal error, state callback of %s failed: %s",
+		    statedata_callback_path(sc), clicon_err_reason);
+	    if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
 		goto done;
 	    xml_free(*xret);
 	    *xret = xerr;
 	    xerr = NULL;
 	    goto fail;
 	}
-	if (xml_sort_recurse(x) < 0)
-	    goto done;
-	/* Mark non-presence containers as XML_FLAG_DEFAULT */
-	if (xml_apply(x, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_DEFAULT) < 0)
-	    goto done;
-	/* Clear XML tree of defaults */
-	if (xml_tree_prune_flagged(x, XML_FLAG_DEFAULT, 1) < 0)
-	    goto done;
-        /* clear mark and change */
-	xml_apply0(x, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
-		   (void*)(0xffff));
-	if (xml_default_recurse(x, 1) < 0)
-	    goto done;
-	if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
+	if ((ret = clixon_statedata_merge(h, yspec, x,
+					  ". Internal error, state callback returned invalid XML of: ",
+					  statedata_callback_path(sc), xret)) < 0)
 	    goto done;
 	if (ret == 0)
 	    goto fail;
-	if (x){
-	    xml_free(x);
-	    x = NULL;
-	}
-    } /* while plugin */
+	xml_free(x);
+	x = NULL;
+    }
     retval = 1;
  done:
+    if (savec){
+	for (i=0; i<salen; i++)
+	    if (savec[i].sa_xcache)
+		xml_free(savec[i].sa_xcache);
+	free(savec);
+    }
     if (xerr)
 	xml_free(xerr);
     if (cberr)
@@ -381,6 +854,8 @@ clixon_plugin_statedata_all(clicon_handle    h,
     goto done;
 }
 
+static int transaction_ns_free(transaction_data_t *td);
+
 /*! Create and initialize a validate/commit transaction 
  * @retval  td     New alloced transaction, 
  * @retval  NULL   Error
@@ -420,10 +895,308 @@ transaction_free(transaction_data_t *td)
 	free(td->td_scvec);
     if (td->td_tcvec)
 	free(td->td_tcvec);
+    transaction_ns_free(td);
+    transaction_changes_free(td);
     free(td);
     return 0;
 }
 
+/*! Get namespace of the top-level ancestor of a changed node
+ * @param[in]  x    Changed node in source or target tree
+ * @param[out] ns   Namespace, or NULL, points into the tree
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+transaction_ns_top(cxobj *x,
+		   char **ns)
+{
+    cxobj *xp;
+
+    *ns = NULL;
+    while ((xp = xml_parent(x)) != NULL && xml_parent(xp) != NULL)
+	x = xp;
+    if (xp == NULL) /* x is top of tree */
+	return 0;
+    return xml2ns(x, xml_prefix(x), ns);
+}
+
+/*! Get namespace view of a transaction, create it if not found
+ * @param[in]  td   Transaction
+ * @param[in]  ns   Namespace
+ * @retval     tv   Transaction view
+ * @retval     NULL Error
+ */
+static transaction_data_t *
+transaction_ns_get(transaction_data_t *td,
+		   char               *ns)
+{
+    struct transaction_ns *tn;
+    int                    i;
+
+    for (i=td->td_nslen-1; i>=0; i--){ /* Last is most likely */
+	tn = &td->td_nsv[i];
+	if (clicon_strcmp(tn->tn_ns, ns) == 0)
+	    return &tn->tn_td;
+    }
+    if ((tn = realloc(td->td_nsv, (td->td_nslen+1)*sizeof(*tn))) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	return NULL;
+    }
+    td->td_nsv = tn;
+    tn = &td->td_nsv[td->td_nslen++];
+    memset(tn, 0, sizeof(*tn));
+    tn->tn_ns = ns;
+    tn->tn_td.td_id = td->td_id;
+    tn->tn_td.td_arg = td->td_arg;
+    tn->tn_td.td_src = td->td_src;
+    tn->tn_td.td_target = td->td_target;
+    return &tn->tn_td;
+}
+
+/*! Free namespace views of a transaction
+ * The trees are owned by the transaction, only the vectors of the views are freed
+ */
+static int
+transaction_ns_free(transaction_data_t *td)
+{
+    transaction_data_t *tv;
+    int                 i;
+
+    for (i=0; i<td->td_nslen; i++){
+	tv = &td->td_nsv[i].tn_td;
+	if (tv->td_dvec)
+	    free(tv->td_dvec);
+	if (tv->td_avec)
+	    free(tv->td_avec);
+	if (tv->td_scvec)
+	    free(tv->td_scvec);
+	if (tv->td_tcvec)
+	    free(tv->td_tcvec);
+	transaction_changes_free(tv);
+    }
+    if (td->td_nsv)
+	free(td->td_nsv);
+    td->td_nsv = NULL;
+    td->td_nslen = 0;
+    return 0;
+}
+
+/*! Group the changes of a transaction by namespace of their top-level nodes
+ * Made once after the changes are computed, so that a plugin can get the changes of
+ * its own module(s) with transaction_ns() without scanning all changes.
+ * Changes keep their order within each namespace.
+ * @param[in]  td   Transaction
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see transaction_ns
+ */
+int
+transaction_ns_index(transaction_data_t *td)
+{
+    int                 retval = -1;
+    transaction_data_t *tv = NULL;
+    char               *ns0 = NULL;
+    char               *ns;
+    int                 len;
+    int                 i;
+
+    transaction_ns_free(td);
+    transaction_changes_free(td); /* Changes are recomputed, rebuild on demand */
+    for (i=0; i<td->td_dlen; i++){
+	if (transaction_ns_top(td->td_dvec[i], &ns) < 0)
+	    goto done;
+	if ((tv == NULL || clicon_strcmp(ns, ns0) != 0) &&
+	    (tv = transaction_ns_get(td, ns)) == NULL)
+	    goto done;
+	ns0 = ns;
+	if (cxvec_append(td->td_dvec[i], &tv->td_dvec, &tv->td_dlen) < 0)
+	    goto done;
+    }
+    for (i=0; i<td->td_alen; i++){
+	if (transaction_ns_top(td->td_avec[i], &ns) < 0)
+	    goto done;
+	if ((tv == NULL || clicon_strcmp(ns, ns0) != 0) &&
+	    (tv = transaction_ns_get(td, ns)) == NULL)
+	    goto done;
+	ns0 = ns;
+	if (cxvec_append(td->td_avec[i], &tv->td_avec, &tv->td_alen) < 0)
+	    goto done;
+    }
+    for (i=0; i<td->td_clen; i++){
+	if (transaction_ns_top(td->td_tcvec[i], &ns) < 0)
+	    goto done;
+	if ((tv == NULL || clicon_strcmp(ns, ns0) != 0) &&
+	    (tv = transaction_ns_get(td, ns)) == NULL)
+	    goto done;
+	ns0 = ns;
+	len = tv->td_clen;
+	if (cxvec_append(td->td_scvec[i], &tv->td_scvec, &len) < 0)
+	    goto done;
+	if (cxvec_append(td->td_tcvec[i], &tv->td_tcvec, &tv->td_clen) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free the change set of a transaction
+ * @param[in]  td   Transaction or namespace view
+ * @see transaction_changes_build
+ */
+int
+transaction_changes_free(transaction_data_t *td)
+{
+    transaction_change *tc;
+    int                 i;
+
+    for (i=0; i<td->td_chlen; i++){
+	tc = &td->td_chv[i];
+	if (tc->tc_path)
+	    free(tc->tc_path);
+	if (tc->tc_old)
+	    cv_free(tc->tc_old);
+	if (tc->tc_new)
+	    cv_free(tc->tc_new);
+    }
+    if (td->td_chv)
+	free(td->td_chv);
+    td->td_chv = NULL;
+    td->td_chlen = 0;
+    return 0;
+}
+
+/*! Get typed value of a changed leaf or leaf-list node
+ * @param[in]  x    XML node
+ * @param[out] cvp  Typed value, free with cv_free, or NULL if not a leaf or invalid
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+transaction_change_value(cxobj   *x,
+			 cg_var **cvp)
+{
+    yang_stmt *y;
+    char      *reason = NULL;
+
+    *cvp = NULL;
+    if ((y = xml_spec(x)) == NULL ||
+	(yang_keyword_get(y) != Y_LEAF && yang_keyword_get(y) != Y_LEAF_LIST))
+	return 0;
+    if (xml_cv_parse(x, y, cvp, &reason) < 0)
+	return -1;
+    if (reason)
+	free(reason);
+    return 0;
+}
+
+/*! Add a change to the change set of a transaction
+ * @param[in]  td   Transaction
+ * @param[in]  op   Operation
+ * @param[in]  xs   Node in source tree or NULL
+ * @param[in]  xt   Node in target tree or NULL
+ * @param[in]  cb   Scratch buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+transaction_change_add(transaction_data_t *td,
+		       enum operation_type op,
+		       cxobj              *xs,
+		       cxobj              *xt,
+		       cbuf               *cb)
+{
+    transaction_change *tc;
+
+    tc = &td->td_chv[td->td_chlen++];
+    tc->tc_op = op;
+    tc->tc_src = xs;
+    tc->tc_target = xt;
+    cbuf_reset(cb);
+    if (xml2instance_id(xt?xt:xs, cb) < 0)
+	return -1;
+    if ((tc->tc_path = strdup(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	return -1;
+    }
+    if (xs && transaction_change_value(xs, &tc->tc_old) < 0)
+	return -1;
+    if (xt && transaction_change_value(xt, &tc->tc_new) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Build the change set of a transaction from its change vectors
+ * Made once per transaction, on demand, so that plugins and plugin processes get
+ * the paths, operations and typed values of changes without walking the trees.
+ * Deletes come first, then creates and then changed leafs, in vector order.
+ * @param[in]  td   Transaction or namespace view
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see transaction_changes
+ */
+int
+transaction_changes_build(transaction_data_t *td)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    int   len;
+    int   i;
+
+    transaction_changes_free(td);
+    if ((len = td->td_dlen + td->td_alen + td->td_clen) == 0)
+	goto ok;
+    if ((td->td_chv = calloc(len, sizeof(*td->td_chv))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    for (i=0; i<td->td_dlen; i++)
+	if (transaction_change_add(td, OP_DELETE, td->td_dvec[i], NULL, cb) < 0)
+	    goto done;
+    for (i=0; i<td->td_alen; i++)
+	if (transaction_change_add(td, OP_CREATE, NULL, td->td_avec[i], cb) < 0)
+	    goto done;
+    for (i=0; i<td->td_clen; i++)
+	if (transaction_change_add(td, OP_REPLACE, td->td_scvec?td->td_scvec[i]:NULL,
+				   td->td_tcvec[i], cb) < 0)
+	    goto done;
+ ok:
+    retval = 0;
+ done:
+    if (retval < 0)
+	transaction_changes_free(td);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Call a transaction callback of a plugin, in its plugin process if it has one
+ * @param[in]  cp      Plugin handle
+ * @param[in]  h       Clixon handle
+ * @param[in]  td      Transaction data
+ * @param[in]  fn      Callback
+ * @param[in]  name    Callback name, eg "validate"
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see plugin_proc_call
+ */
+static int
+plugin_trans_call(clixon_plugin      *cp,
+		  clicon_handle       h, 
+		  transaction_data_t *td,
+		  trans_cb_t         *fn,
+		  const char         *name)
+{
+    if (cp->cp_api.ca_trans_process)
+	return plugin_proc_call(h, cp, td, name);
+    return fn(h, (transaction_data)td);
+}
+
 /*! Call single plugin transaction_begin() before a validate/commit.
  * @param[in]  cp      Plugin handle
  * @param[in]  h       Clixon handle
@@ -440,7 +1213,7 @@ plugin_transaction_begin_one(clixon_plugin      *cp,
     trans_cb_t *fn;
     
     if ((fn = cp->cp_api.ca_trans_begin) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	if (plugin_trans_call(cp, h, td, fn, "begin") < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -466,16 +1239,356 @@ plugin_transaction_begin_all(clicon_handle       h,
 {
     int            retval = -1;
     clixon_plugin *cp = NULL;
+    struct timespec t0;
 
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+	clock_gettime(CLOCK_MONOTONIC, &t0);
 	if (plugin_transaction_begin_one(cp, h, td) < 0)
 	    goto done;
+	if (cp->cp_api.ca_trans_begin != NULL &&
+	    commit_stats_add(cp->cp_name, "begin", &t0) < 0)
+	    goto done;
     }
     retval = 0;
  done:
     return retval;
 }
 
+/*! Revert a commit
+ * @param[in]  h   CLICON handle
+ * @param[in]  td  Transaction data
+ * @param[in]  nr  The plugin where an error occured. 
+ * @retval     0       OK
+ * @retval    -1       Error
+ * The revert is made in plugin before this one. Eg if error occurred in
+ * plugin 2, then the revert will be made in plugins 1 and 0.
+ */
+static int
+plugin_transaction_revert_all(clicon_handle       h, 
+			      transaction_data_t *td,
+			      int                 nr)
+{
+    int                retval = 0;
+    clixon_plugin     *cp = NULL;
+    trans_cb_t        *fn;
+    
+    while ((cp = clixon_plugin_each_revert(h, cp, nr)) != NULL) {
+	if ((fn = cp->cp_api.ca_trans_revert) == NULL)
+	    continue;
+	if ((retval = plugin_trans_call(cp, h, td, fn, "revert")) < 0){
+		clicon_log(LOG_NOTICE, "%s: Plugin '%s' trans_revert callback failed", 
+			   __FUNCTION__, cp->cp_name);
+		break; 
+	}
+    }
+    return retval; /* ignore errors */
+}
+
+/*! Validate or commit callback of a plugin run in a batch of parallel-safe plugins
+ * @see plugin_transaction_batch
+ */
+struct plugin_trans_job{
+    clixon_plugin *pj_cp;     /* Plugin */
+    int            pj_nr;     /* Plugin number in load order, for revert */
+    pid_t          pj_pid;    /* Helper process, 0 if called in backend */
+    int            pj_fd;     /* Read end of pipe from helper, or -1 */
+    int            pj_proc;   /* Called in plugin process, see ca_trans_process */
+    int            pj_ok;     /* Callback succeeded */
+    int            pj_errno;  /* clicon_errno of callback on error */
+    int            pj_suberrno; /* clicon_suberrno of callback on error */
+    char           pj_reason[ERR_STRLEN]; /* clicon_err_reason of callback on error */
+};
+
+/*! Get validate or commit callback of a plugin
+ */
+static trans_cb_t *
+plugin_trans_fn(clixon_plugin *cp,
+		int            commit)
+{
+    return commit ? cp->cp_api.ca_trans_commit : cp->cp_api.ca_trans_validate;
+}
+
+/*! Check if any plugin has a parallel-safe validate or commit callback
+ */
+static int
+plugin_trans_parallel_any(clicon_handle h,
+			  int           commit)
+{
+    clixon_plugin *cp = NULL;
+
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	if (cp->cp_api.ca_trans_parallel && plugin_trans_fn(cp, commit) != NULL)
+	    return 1;
+    return 0;
+}
+
+/*! Check if a plugin is declared to run after any of the plugins in a batch
+ * @param[in]  cp    Plugin
+ * @param[in]  jobs  Batch
+ * @param[in]  n     Length of batch
+ * @retval     1     cp is after a plugin in the batch, ie the batch must be done first
+ * @retval     0     cp is independent of the batch
+ */
+static int
+plugin_trans_after(clixon_plugin           *cp,
+		   struct plugin_trans_job *jobs,
+		   int                      n)
+{
+    char  *s;
+    char  *name;
+    size_t len;
+    int    i;
+
+    if ((s = cp->cp_api.ca_trans_after) == NULL)
+	return 0;
+    while (*s){
+	s += strspn(s, " \t");
+	len = strcspn(s, " \t");
+	for (i=0; i<n && len; i++){
+	    name = jobs[i].pj_cp->cp_api.ca_name;
+	    if (strlen(name) == len && strncmp(name, s, len) == 0)
+		return 1;
+	}
+	s += len;
+    }
+    return 0;
+}
+
+/*! Call validate or commit callbacks of a batch of parallel-safe plugins concurrently
+ * Each callback is called in a forked helper process. The helper sends the result,
+ * including any clicon_err, over a pipe and exits. A plugin with ca_trans_process is
+ * called in its plugin process instead, see plugin_proc_send.
+ * If fork fails, or the batch has a single plugin, the callback is called in the
+ * backend.
+ * Threads are not used since the clixon library is not thread-safe. Therefore changes
+ * a callback makes to memory, eg of the plugin or the transaction, are lost.
+ * @param[in]  h      Clicon handle
+ * @param[in]  td     Transaction data
+ * @param[in]  commit 0: validate, 1: commit
+ * @param[in]  jobs   Batch, pj_ok is set on return
+ * @param[in]  n      Length of batch
+ * @retval     0      OK, all callbacks succeeded
+ * @retval    -1      Error, clicon_err is that of the first plugin that failed
+ */
+static int
+plugin_transaction_batch(clicon_handle            h,
+			 transaction_data_t      *td,
+			 int                      commit,
+			 struct plugin_trans_job *jobs,
+			 int                      n)
+{
+    int                      retval = -1;
+    struct plugin_trans_job *pj;
+    struct plugin_trans_job  pj0;  /* Result from helper */
+    trans_cb_t              *fn;
+    struct timespec          t0;
+    int                      p[2];
+    int                      status;
+    size_t                   len;
+    ssize_t                  ret;
+    int                      i;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (i=0; i<n; i++){
+	pj = &jobs[i];
+	pj->pj_pid = 0;
+	pj->pj_fd = -1;
+	pj->pj_proc = 0;
+	pj->pj_ok = 0;
+	fn = plugin_trans_fn(pj->pj_cp, commit);
+	if (n > 1 && pj->pj_cp->cp_api.ca_trans_process){
+	    /* Plugin process runs the callback, result is received below */
+	    if (plugin_proc_send(h, pj->pj_cp, td, commit?"commit":"validate") == 0){
+		pj->pj_proc = 1;
+		continue;
+	    }
+	    pj->pj_errno = clicon_errno;
+	    pj->pj_suberrno = clicon_suberrno;
+	    strncpy(pj->pj_reason, clicon_err_reason, ERR_STRLEN-1);
+	    continue;
+	}
+	if (n > 1){
+	    if (pipe(p) < 0)
+		clicon_log(LOG_WARNING, "%s pipe: %s", __FUNCTION__, strerror(errno));
+	    else if ((pj->pj_pid = fork()) < 0){
+		clicon_log(LOG_WARNING, "%s fork: %s", __FUNCTION__, strerror(errno));
+		pj->pj_pid = 0;
+		close(p[0]);
+		close(p[1]);
+	    }
+	    else if (pj->pj_pid == 0){ /* Helper */
+		close(p[0]);
+		clicon_err_reset();
+		pj->pj_ok = (fn(h, (transaction_data)td) == 0);
+		pj->pj_errno = clicon_errno;
+		pj->pj_suberrno = clicon_suberrno;
+		strncpy(pj->pj_reason, clicon_err_reason, ERR_STRLEN-1);
+		if (write(p[1], pj, sizeof(*pj)) < 0)
+		    _exit(1);
+		_exit(0);
+	    }
+	    else {
+		close(p[1]);
+		pj->pj_fd = p[0];
+		continue;
+	    }
+	}
+	/* Call in backend */
+	if (commit)
+	    pj->pj_ok = (plugin_transaction_commit_one(pj->pj_cp, h, td) == 0);
+	else
+	    pj->pj_ok = (plugin_transaction_validate_one(pj->pj_cp, h, td) == 0);
+	if (!pj->pj_ok){
+	    pj->pj_errno = clicon_errno;
+	    pj->pj_suberrno = clicon_suberrno;
+	    strncpy(pj->pj_reason, clicon_err_reason, ERR_STRLEN-1);
+	}
+    }
+    /* Wait for all helpers and plugin processes */
+    for (i=0; i<n; i++){
+	pj = &jobs[i];
+	if (pj->pj_proc){
+	    if ((pj->pj_ok = (plugin_proc_rcv(h, pj->pj_cp) == 0)) == 0){
+		pj->pj_errno = clicon_errno;
+		pj->pj_suberrno = clicon_suberrno;
+		strncpy(pj->pj_reason, clicon_err_reason, ERR_STRLEN-1);
+	    }
+	    continue;
+	}
+	if (pj->pj_fd == -1)
+	    continue;
+	len = 0;
+	while (len < sizeof(pj0)){
+	    if ((ret = read(pj->pj_fd, (char*)&pj0 + len, sizeof(pj0) - len)) < 0 &&
+		errno == EINTR)
+		continue;
+	    if (ret <= 0)
+		break;
+	    len += ret;
+	}
+	close(pj->pj_fd);
+	pj->pj_fd = -1;
+	if (waitpid(pj->pj_pid, &status, 0) < 0 && errno != ECHILD)
+	    clicon_log(LOG_WARNING, "%s waitpid: %s", __FUNCTION__, strerror(errno));
+	if (len == sizeof(pj0)){ /* Result of helper */
+	    pj->pj_ok = pj0.pj_ok;
+	    pj->pj_errno = pj0.pj_errno;
+	    pj->pj_suberrno = pj0.pj_suberrno;
+	    memcpy(pj->pj_reason, pj0.pj_reason, ERR_STRLEN);
+	}
+	else {
+	    pj->pj_ok = 0;
+	    pj->pj_errno = OE_PLUGIN;
+	    pj->pj_suberrno = 0;
+	    snprintf(pj->pj_reason, ERR_STRLEN, "Plugin '%s' helper process failed",
+		     pj->pj_cp->cp_name);
+	}
+	if (!pj->pj_ok && pj->pj_errno == 0) /* sanity: clicon_err() is not called */
+	    clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
+		       __FUNCTION__, pj->pj_cp->cp_name);
+    }
+    for (i=0; i<n; i++){
+	pj = &jobs[i];
+	if (!pj->pj_ok){
+	    clicon_err(pj->pj_errno?pj->pj_errno:OE_PLUGIN, pj->pj_suberrno, "%s", pj->pj_reason);
+	    goto done;
+	}
+	if (commit_stats_add(pj->pj_cp->cp_name, commit?"commit":"validate", &t0) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Call validate or commit callbacks in all plugins, parallel-safe plugins concurrently
+ * Consecutive plugins that set ca_trans_parallel form a batch whose callbacks are
+ * called concurrently, see plugin_transaction_batch. A batch ends before a plugin
+ * without ca_trans_parallel, and before a plugin whose ca_trans_after names a plugin
+ * in the batch.
+ * If a commit callback fails, plugins of the batch that succeeded after the failing 
+ * plugin are reverted, and then all plugins before it as in plugin_transaction_commit_all
+ * @param[in]  h      Clicon handle
+ * @param[in]  td     Transaction data
+ * @param[in]  commit 0: validate, 1: commit
+ * @retval     0      OK
+ * @retval    -1      Error: one of the plugin callbacks returned error
+ */
+static int
+plugin_transaction_parallel_all(clicon_handle       h,
+				transaction_data_t *td,
+				int                 commit)
+{
+    int                      retval = -1;
+    clixon_plugin           *cp = NULL;
+    struct plugin_trans_job *jobs = NULL;
+    struct plugin_trans_job *pj;
+    trans_cb_t              *fn;
+    struct timespec          t0;
+    int                      nplugins = 0;
+    int                      n = 0;  /* Length of current batch */
+    int                      nr = 0; /* Plugin number */
+    int                      i;
+
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	nplugins++;
+    if ((jobs = calloc(nplugins, sizeof(*jobs))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    cp = NULL;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+	if ((fn = plugin_trans_fn(cp, commit)) != NULL){
+	    if (cp->cp_api.ca_trans_parallel == 0 || plugin_trans_after(cp, jobs, n)){
+		/* Current batch must be done first */
+		if (n && plugin_transaction_batch(h, td, commit, jobs, n) < 0)
+		    goto fail;
+		n = 0;
+	    }
+	    if (cp->cp_api.ca_trans_parallel){
+		jobs[n].pj_cp = cp;
+		jobs[n].pj_nr = nr;
+		n++;
+	    }
+	    else {
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if ((commit ? plugin_transaction_commit_one(cp, h, td) :
+		     plugin_transaction_validate_one(cp, h, td)) < 0)
+		    goto fail;
+		if (commit_stats_add(cp->cp_name, commit?"commit":"validate", &t0) < 0)
+		    goto done;
+	    }
+	}
+	nr++;
+    }
+    if (n && plugin_transaction_batch(h, td, commit, jobs, n) < 0)
+	goto fail;
+    retval = 0;
+ done:
+    if (jobs)
+	free(jobs);
+    return retval;
+ fail:
+    if (commit){
+	/* Make an effort to revert transaction, nr is first plugin that failed */
+	for (i=0; i<n; i++)
+	    if (!jobs[i].pj_ok){
+		nr = jobs[i].pj_nr;
+		break;
+	    }
+	for (i=n-1; i>=0; i--){
+	    pj = &jobs[i];
+	    if (pj->pj_nr > nr && pj->pj_ok &&
+		(fn = pj->pj_cp->cp_api.ca_trans_revert) != NULL &&
+		plugin_trans_call(pj->pj_cp, h, td, fn, "revert") < 0)
+		clicon_log(LOG_NOTICE, "%s: Plugin '%s' trans_revert callback failed", 
+			   __FUNCTION__, pj->pj_cp->cp_name);
+	}
+	plugin_transaction_revert_all(h, td, nr);
+    }
+    goto done;
+}
+
 /*! Call single plugin transaction_validate() in a validate/commit transaction
  * @param[in]  cp      Plugin handle
  * @param[in]  h       Clixon handle
@@ -492,7 +1605,7 @@ plugin_transaction_validate_one(clixon_plugin      *cp,
     trans_cb_t *fn;
     
     if ((fn = cp->cp_api.ca_trans_validate) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	if (plugin_trans_call(cp, h, td, fn, "validate") < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -516,10 +1629,17 @@ plugin_transaction_validate_all(clicon_handle       h,
 {
     int            retval = -1;
     clixon_plugin *cp = NULL;
+    struct timespec t0;
 
+    if (plugin_trans_parallel_any(h, 0))
+	return plugin_transaction_parallel_all(h, td, 0);
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+	clock_gettime(CLOCK_MONOTONIC, &t0);
 	if (plugin_transaction_validate_one(cp, h, td) < 0)
 	    goto done;
+	if (cp->cp_api.ca_trans_validate != NULL &&
+	    commit_stats_add(cp->cp_name, "validate", &t0) < 0)
+	    goto done;
     }
     retval = 0;
  done:
@@ -543,7 +1663,7 @@ plugin_transaction_complete_one(clixon_plugin      *cp,
     trans_cb_t *fn;
     
     if ((fn = cp->cp_api.ca_trans_complete) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	if (plugin_trans_call(cp, h, td, fn, "complete") < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -569,47 +1689,21 @@ plugin_transaction_complete_all(clicon_handle       h,
 {
     int            retval = -1;
     clixon_plugin *cp = NULL;
+    struct timespec t0;
 
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+	clock_gettime(CLOCK_MONOTONIC, &t0);
 	if (plugin_transaction_complete_one(cp, h, td) < 0)
 	    goto done;
+	if (cp->cp_api.ca_trans_complete != NULL &&
+	    commit_stats_add(cp->cp_name, "complete", &t0) < 0)
+	    goto done;
     }
     retval = 0;
  done:
     return retval;
 }
 
-/*! Revert a commit
- * @param[in]  h   CLICON handle
- * @param[in]  td  Transaction data
- * @param[in]  nr  The plugin where an error occured. 
- * @retval     0       OK
- * @retval    -1       Error
- * The revert is made in plugin before this one. Eg if error occurred in
- * plugin 2, then the revert will be made in plugins 1 and 0.
- */
-static int
-plugin_transaction_revert_all(clicon_handle       h, 
-			      transaction_data_t *td,
-			      int                 nr)
-{
-    int                retval = 0;
-    clixon_plugin     *cp = NULL;
-    trans_cb_t        *fn;
-    
-    while ((cp = clixon_plugin_each_revert(h, cp, nr)) != NULL) {
-	if ((fn = cp->cp_api.ca_trans_revert) == NULL)
-	    continue;
-	if ((retval = fn(h, (transaction_data)td)) < 0){
-		clicon_log(LOG_NOTICE, "%s: Plugin '%s' trans_revert callback failed", 
-			   __FUNCTION__, cp->cp_name);
-		break; 
-	}
-    }
-    return retval; /* ignore errors */
-}
-
-
 /*! Call single plugin transaction_commit() in a commit transaction
  * @param[in]  cp      Plugin handle
  * @param[in]  h       Clixon handle
@@ -626,7 +1720,7 @@ plugin_transaction_commit_one(clixon_plugin      *cp,
     trans_cb_t *fn;
     
     if ((fn = cp->cp_api.ca_trans_commit) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	if (plugin_trans_call(cp, h, td, fn, "commit") < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -653,15 +1747,22 @@ plugin_transaction_commit_all(clicon_handle       h,
 {
     int            retval = -1;
     clixon_plugin *cp = NULL;
+    struct timespec t0;
     int            i=0;
     
+    if (plugin_trans_parallel_any(h, 1))
+	return plugin_transaction_parallel_all(h, td, 1);
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
 	i++;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
 	if (plugin_transaction_commit_one(cp, h, td) < 0){
 	    /* Make an effort to revert transaction */
 	    plugin_transaction_revert_all(h, td, i-1); 
 	    goto done;
 	}
+	if (cp->cp_api.ca_trans_commit != NULL &&
+	    commit_stats_add(cp->cp_name, "commit", &t0) < 0)
+	    goto done;
     }
     retval = 0;
  done:
@@ -685,7 +1786,7 @@ plugin_transaction_commit_done_one(clixon_plugin      *cp,
     trans_cb_t *fn;
     
     if ((fn = cp->cp_api.ca_trans_commit_done) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	if (plugin_trans_call(cp, h, td, fn, "commit-done") < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -710,10 +1811,15 @@ plugin_transaction_commit_done_all(clicon_handle       h,
 {
     int            retval = -1;
     clixon_plugin *cp = NULL;
+    struct timespec t0;
 
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+	clock_gettime(CLOCK_MONOTONIC, &t0);
 	if (plugin_transaction_commit_done_one(cp, h, td) < 0)
 	    goto done;
+	if (cp->cp_api.ca_trans_commit_done != NULL &&
+	    commit_stats_add(cp->cp_name, "commit-done", &t0) < 0)
+	    goto done;
     }
     retval = 0;
  done:
@@ -736,7 +1842,7 @@ plugin_transaction_end_one(clixon_plugin      *cp,
     trans_cb_t *fn;
     
     if ((fn = cp->cp_api.ca_trans_end) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	if (plugin_trans_call(cp, h, td, fn, "end") < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
@@ -760,10 +1866,15 @@ plugin_transaction_end_all(clicon_handle h,
 {
     int            retval = -1;
     clixon_plugin *cp = NULL;
+    struct timespec t0;
 
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+	clock_gettime(CLOCK_MONOTONIC, &t0);
 	if (plugin_transaction_end_one(cp, h, td) < 0)
 	    goto done;
+	if (cp->cp_api.ca_trans_end != NULL &&
+	    commit_stats_add(cp->cp_name, "end", &t0) < 0)
+	    goto done;
     }
     retval = 0;
  done:
@@ -779,7 +1890,7 @@ plugin_transaction_abort_one(clixon_plugin      *cp,
     trans_cb_t *fn;
     
     if ((fn = cp->cp_api.ca_trans_abort) != NULL){
-	if (fn(h, (transaction_data)td) < 0){
+	if (plugin_trans_call(cp, h, td, fn, "abort") < 0){
 	    if (!clicon_errno) /* sanity: log if clicon_err() is not called ! */
 		clicon_log(LOG_NOTICE, "%s: Plugin '%s' callback does not make clicon_err call on error", 
 		       __FUNCTION__, cp->cp_name);
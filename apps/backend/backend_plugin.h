@@ -38,6 +38,12 @@
 #ifndef _BACKEND_PLUGIN_H_
 #define _BACKEND_PLUGIN_H_
 
+/*
+ * Constants
+ */
+/* Name of merged state tree in state validation statistics, see state_validate_sample */
+#define STATE_VALIDATE_ALL "all"
+
 /*
  * Types
  */
@@ -64,21 +70,49 @@ typedef struct {
     cxobj    **td_scvec;    /* Source changed xml vector */
     cxobj    **td_tcvec;    /* Target changed xml vector */
     int        td_clen;     /* Changed xml vector length */
+    uint64_t   td_src_nr;   /* Number of nodes in source tree, see transaction_mem_stats */
+    uint64_t   td_target_nr; /* Number of nodes in target tree */
+    long       td_rss;      /* Resident set size change in kB, or RSS at start while loading */
+    long       td_maxrss;   /* Max resident set size change in kB, or max RSS at start */
+    struct transaction_ns *td_nsv; /* Changes grouped by top-level namespace */
+    int        td_nslen;    /* Length of td_nsv */
+    transaction_change *td_chv; /* Change set, built on demand, see transaction_changes */
+    int        td_chlen;    /* Length of td_chv */
 } transaction_data_t;
 
+/* Changes of a transaction in the top-level nodes of one namespace
+ * The view has the same source and target trees as the transaction, but only
+ * the changes below top-level nodes of the namespace.
+ * @see transaction_ns_index
+ */
+struct transaction_ns{
+    char              *tn_ns;   /* Namespace of top-level nodes */
+    transaction_data_t tn_td;   /* Transaction view */
+};
+
 /*
  * Prototypes
  */
 int clixon_plugin_reset_one(clixon_plugin *cp, clicon_handle h, char *db);
 int clixon_plugin_reset_all(clicon_handle h, char *db);
+int clixon_plugin_resync_one(clixon_plugin *cp, clicon_handle h, char *db);
+int clixon_plugin_resync_all(clicon_handle h, char *db);
 
 int clixon_plugin_pre_daemon_all(clicon_handle h);
 int clixon_plugin_daemon_all(clicon_handle h);
 
 int clixon_plugin_statedata_all(clicon_handle h, yang_stmt *yspec, cvec *nsc, char *xpath, cxobj **xtop);
+int state_validate_schema_level(clicon_handle h);
+int state_validate_sample(clicon_handle h, const char *name);
+int state_validate_failed(const char *name);
+int state_validate_stats_cbuf(cbuf *cb);
+int state_validate_stats_exit(void);
 
 transaction_data_t * transaction_new(void);
 int transaction_free(transaction_data_t *);
+int transaction_ns_index(transaction_data_t *td);
+int transaction_changes_build(transaction_data_t *td);
+int transaction_changes_free(transaction_data_t *td);
 
 int plugin_transaction_begin_one(clixon_plugin *cp, clicon_handle h, transaction_data_t *td);
 int plugin_transaction_begin_all(clicon_handle h, transaction_data_t *td);
@@ -0,0 +1,797 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Plugin processes: transaction callbacks of a backend plugin that sets
+ * ca_trans_process are called in a separate process, so that a plugin that crashes
+ * or is slow does not take the backend with it.
+ * The process is forked from the backend at the first transaction, so that it has the
+ * state of the plugin after its init and start callbacks, and again if it has failed.
+ * It keeps its own memory between callbacks, eg of transaction_arg_set.
+ * Threads are not used since the clixon library is not thread-safe.
+ *
+ * The backend and the process talk over a socket pair with internal clicon messages.
+ * At the first callback of a transaction, the request is followed by the source and
+ * target trees in compact binary encoding (see clixon_xml2bin), and the request has the
+ * changes as positions of changed nodes in the trees, in document order. Later
+ * callbacks of the same transaction only send the transaction id and callback name:
+ *   <transaction><id>7</id><callback>validate</callback>[<data/>
+ *     <dvec>3 9</dvec><avec/><scvec>12</scvec><tcvec>12</tcvec>]</transaction>
+ * The reply is <ok/> or <error><errno/><suberrno/><reason/></error>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_transaction.h"
+#include "backend_plugin.h"
+#include "backend_plugin_proc.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/*
+ * Types
+ */ 
+/* Process of a plugin, see ca_trans_process */
+struct plugin_proc{
+    qelem_t        pp_q;     /* queue header */
+    clixon_plugin *pp_cp;    /* Plugin */
+    pid_t          pp_pid;   /* Plugin process, 0 if not running */
+    int            pp_s;     /* Socket to plugin process */
+    int            pp_sent;  /* Transaction pp_tid has been sent to the process */
+    uint64_t       pp_tid;   /* Id of latest transaction sent */
+};
+
+/* Changed node of a transaction and its position in a change vector */
+struct proc_idx{
+    cxobj *pi_x;
+    int    pi_i;
+};
+
+/*
+ * Variables
+ */ 
+static struct plugin_proc *_plugin_procs = NULL;
+
+/*! Write a clicon message to a plugin process, without SIGPIPE if it has exited
+ * @param[in]  s    Socket
+ * @param[in]  msg  Clicon message
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+plugin_proc_write(int                s,
+		  struct clicon_msg *msg)
+{
+    char   *buf = (char*)msg;
+    size_t  len = ntohl(msg->op_len);
+    ssize_t n;
+
+    while (len > 0){
+	if ((n = send(s, buf, len, MSG_NOSIGNAL)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "send");
+	    return -1;
+	}
+	buf += n;
+	len -= n;
+    }
+    return 0;
+}
+
+/*! Get transaction callback of a plugin by name
+ * @param[in]  cp    Plugin
+ * @param[in]  name  Callback name, eg "validate"
+ * @retval     fn    Callback
+ * @retval     NULL  Plugin has no such callback
+ */
+static trans_cb_t *
+plugin_proc_fn(clixon_plugin *cp,
+	       char          *name)
+{
+    clixon_plugin_api *api = &cp->cp_api;
+
+    if (name == NULL)
+	return NULL;
+    if (strcmp(name, "begin") == 0)
+	return api->ca_trans_begin;
+    if (strcmp(name, "validate") == 0)
+	return api->ca_trans_validate;
+    if (strcmp(name, "complete") == 0)
+	return api->ca_trans_complete;
+    if (strcmp(name, "commit") == 0)
+	return api->ca_trans_commit;
+    if (strcmp(name, "commit-done") == 0)
+	return api->ca_trans_commit_done;
+    if (strcmp(name, "revert") == 0)
+	return api->ca_trans_revert;
+    if (strcmp(name, "end") == 0)
+	return api->ca_trans_end;
+    if (strcmp(name, "abort") == 0)
+	return api->ca_trans_abort;
+    return NULL;
+}
+
+static int
+proc_idx_cmp(const void *a,
+	     const void *b)
+{
+    cxobj *xa = ((struct proc_idx *)a)->pi_x;
+    cxobj *xb = ((struct proc_idx *)b)->pi_x;
+
+    return xa < xb ? -1 : xa > xb ? 1 : 0;
+}
+
+/*! Get positions of changed nodes in document order of the element nodes of a tree
+ * @param[in]  x    Tree, or subtree in recursive call
+ * @param[in]  vec  Changed nodes sorted by pointer
+ * @param[in]  len  Length of vec
+ * @param[in,out] nr  Position of x
+ * @param[out] idx  Position of each changed node, by its place in the change vector
+ */
+static void
+plugin_proc_idx(cxobj           *x,
+		struct proc_idx *vec,
+		int              len,
+		int             *nr,
+		int             *idx)
+{
+    struct proc_idx  key = {x, 0};
+    struct proc_idx *pi;
+    cxobj           *xc;
+
+    if ((pi = bsearch(&key, vec, len, sizeof(*vec), proc_idx_cmp)) != NULL)
+	idx[pi->pi_i] = *nr;
+    (*nr)++;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	plugin_proc_idx(xc, vec, len, nr, idx);
+}
+
+/*! Add a change vector of a transaction as positions of nodes to a request
+ * @param[in]  cb    Request
+ * @param[in]  name  Element name, eg "dvec"
+ * @param[in]  xt    Source or target tree
+ * @param[in]  vec   Change vector, may be NULL
+ * @param[in]  len   Length of vec
+ */
+static int
+plugin_proc_vec2cb(cbuf   *cb,
+		   char   *name,
+		   cxobj  *xt,
+		   cxobj **vec,
+		   int     len)
+{
+    int              retval = -1;
+    struct proc_idx *pvec = NULL;
+    int             *idx = NULL;
+    int              nr = 0;
+    int              i;
+
+    cprintf(cb, "<%s>", name);
+    if (xt != NULL && vec != NULL && len > 0){
+	if ((pvec = calloc(len, sizeof(*pvec))) == NULL ||
+	    (idx = calloc(len, sizeof(*idx))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+	for (i=0; i<len; i++){
+	    pvec[i].pi_x = vec[i];
+	    pvec[i].pi_i = i;
+	    idx[i] = -1;
+	}
+	qsort(pvec, len, sizeof(*pvec), proc_idx_cmp);
+	plugin_proc_idx(xt, pvec, len, &nr, idx);
+	for (i=0; i<len; i++)
+	    if (idx[i] != -1)
+		cprintf(cb, "%s%d", i?" ":"", idx[i]);
+    }
+    cprintf(cb, "</%s>", name);
+    retval = 0;
+ done:
+    if (pvec)
+	free(pvec);
+    if (idx)
+	free(idx);
+    return retval;
+}
+
+/*! Send a tree of a transaction in binary encoding
+ * @param[in]  s    Socket
+ * @param[in]  xt   Source or target tree, or NULL for an empty tree
+ */
+static int
+plugin_proc_tree_send(int    s,
+		      cxobj *xt)
+{
+    int                retval = -1;
+    cxobj             *x0 = NULL;
+    struct clicon_msg *msg = NULL;
+
+    if (xt == NULL){
+	if ((x0 = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+	    goto done;
+	xt = x0;
+    }
+    if ((msg = clicon_msg_encode_bin(0, xt)) == NULL)
+	goto done;
+    if (plugin_proc_write(s, msg) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (x0)
+	xml_free(x0);
+    return retval;
+}
+
+/*! Get element nodes of a tree in document order
+ * @param[in]     x     Tree, or subtree in recursive call
+ * @param[in,out] vec   Nodes
+ * @param[in,out] len   Length of vec
+ */
+static int
+plugin_proc_nodes(cxobj   *x,
+		  cxobj ***vec,
+		  int     *len)
+{
+    cxobj  *xc;
+    cxobj **v;
+
+    if ((*len & 0xff) == 0){
+	if ((v = realloc(*vec, (*len + 0x100)*sizeof(cxobj*))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	*vec = v;
+    }
+    (*vec)[(*len)++] = x;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	if (plugin_proc_nodes(xc, vec, len) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Get a change vector of a transaction from positions of nodes in a request
+ * @param[in]  xreq   Request
+ * @param[in]  name   Element name, eg "dvec"
+ * @param[in]  nodes  Nodes of source or target tree in document order
+ * @param[in]  nlen   Length of nodes
+ * @param[out] vecp   Change vector, malloced
+ * @param[out] lenp   Length of vec
+ */
+static int
+plugin_proc_cb2vec(cxobj   *xreq,
+		   char    *name,
+		   cxobj  **nodes,
+		   int      nlen,
+		   cxobj ***vecp,
+		   int     *lenp)
+{
+    char  *str;
+    char  *s;
+    char  *end;
+    long   i;
+    cxobj **vec = NULL;
+    int    len = 0;
+    
+    if ((str = xml_find_body(xreq, name)) != NULL){
+	if ((vec = calloc(strlen(str)/2 + 1, sizeof(*vec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    return -1;
+	}
+	s = str;
+	while (*s){
+	    i = strtol(s, &end, 10);
+	    if (end == s)
+		break;
+	    if (i < 0 || i >= nlen){
+		free(vec);
+		clicon_err(OE_PLUGIN, EINVAL, "Bad node position %ld in %s", i, name);
+		return -1;
+	    }
+	    vec[len++] = nodes[i];
+	    s = end;
+	}
+    }
+    *vecp = vec;
+    *lenp = len;
+    return 0;
+}
+
+/*! Receive a tree of a transaction in a plugin process
+ * @param[in]  h    Clicon handle
+ * @param[in]  s    Socket
+ * @param[out] xtp  Tree bound to YANG
+ */
+static int
+plugin_proc_tree_rcv(clicon_handle h,
+		     int           s,
+		     cxobj       **xtp)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xt = NULL;
+    int                eof = 0;
+
+    if (clicon_msg_rcv(s, &msg, &eof) < 0)
+	goto done;
+    if (eof){
+	clicon_err(OE_PLUGIN, 0, "Socket closed");
+	goto done;
+    }
+    if ((xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (clixon_bin2xml(msg->op_body, ntohl(msg->op_len) - sizeof(*msg), xt) < 0)
+	goto done;
+    if (xml_rootchild(xt, 0, &xt) < 0)
+	goto done;
+    if (xml_bind_yang(xt, YB_MODULE, clicon_dbspec_yang(h), NULL) < 0)
+	goto done;
+    *xtp = xt;
+    xt = NULL;
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Receive the trees and changes of a transaction in a plugin process
+ * The trees are marked with change flags as in from_validate_common
+ * @param[in]  h     Clicon handle
+ * @param[in]  s     Socket
+ * @param[in]  xreq  Request
+ * @param[in]  td    Transaction
+ */
+static int
+plugin_proc_data(clicon_handle       h,
+		 int                 s,
+		 cxobj              *xreq,
+		 transaction_data_t *td)
+{
+    int     retval = -1;
+    cxobj **snodes = NULL;
+    int     slen = 0;
+    cxobj **tnodes = NULL;
+    int     tlen = 0;
+    int     len;
+    cxobj  *xn;
+    int     i;
+
+    if (plugin_proc_tree_rcv(h, s, &td->td_src) < 0)
+	goto done;
+    if (plugin_proc_tree_rcv(h, s, &td->td_target) < 0)
+	goto done;
+    if (plugin_proc_nodes(td->td_src, &snodes, &slen) < 0)
+	goto done;
+    if (plugin_proc_nodes(td->td_target, &tnodes, &tlen) < 0)
+	goto done;
+    if (plugin_proc_cb2vec(xreq, "dvec", snodes, slen, &td->td_dvec, &td->td_dlen) < 0)
+	goto done;
+    if (plugin_proc_cb2vec(xreq, "avec", tnodes, tlen, &td->td_avec, &td->td_alen) < 0)
+	goto done;
+    if (plugin_proc_cb2vec(xreq, "scvec", snodes, slen, &td->td_scvec, &td->td_clen) < 0)
+	goto done;
+    if (plugin_proc_cb2vec(xreq, "tcvec", tnodes, tlen, &td->td_tcvec, &len) < 0)
+	goto done;
+    if (len < td->td_clen)
+	td->td_clen = len;
+    for (i=0; i<td->td_dlen; i++){ /* Also down */
+	xn = td->td_dvec[i];
+	xml_flag_set(xn, XML_FLAG_DEL);
+	xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_DEL);
+	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    for (i=0; i<td->td_alen; i++){ /* Also down */
+	xn = td->td_avec[i];
+	xml_flag_set(xn, XML_FLAG_ADD);
+	xml_apply(xn, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_ADD);
+	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    for (i=0; i<td->td_clen; i++){ /* Also up */
+	xn = td->td_scvec[i];
+	xml_flag_set(xn, XML_FLAG_CHANGE);
+	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+	xn = td->td_tcvec[i];
+	xml_flag_set(xn, XML_FLAG_CHANGE);
+	xml_apply_ancestor(xn, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    if (transaction_ns_index(td) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (snodes)
+	free(snodes);
+    if (tnodes)
+	free(tnodes);
+    return retval;
+}
+
+/*! Main loop of a plugin process: call transaction callbacks on request
+ * Exits when the backend closes the socket
+ * @param[in]  h     Clicon handle
+ * @param[in]  cp    Plugin
+ * @param[in]  s     Socket to backend
+ */
+static void
+plugin_proc_serve(clicon_handle  h,
+		  clixon_plugin *cp,
+		  int            s)
+{
+    transaction_data_t *td = NULL;
+    struct clicon_msg  *msg = NULL;
+    cxobj              *xt = NULL;
+    cxobj              *xreq;
+    cbuf               *cb = NULL;
+    trans_cb_t         *fn;
+    char               *str;
+    uint64_t            id;
+    int                 eof = 0;
+    int                 ret;
+
+    clicon_debug(1, "%s %s pid:%d", __FUNCTION__, cp->cp_name, getpid());
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    while (1){
+	if (clicon_msg_rcv(s, &msg, &eof) < 0 || eof)
+	    break;
+	if (clixon_xml_parse_string(msg->op_body, YB_NONE, NULL, &xt, NULL) < 0)
+	    break;
+	free(msg);
+	msg = NULL;
+	if ((xreq = xml_find_type(xt, NULL, "transaction", CX_ELMNT)) == NULL ||
+	    (str = xml_find_body(xreq, "id")) == NULL)
+	    break;
+	id = strtoull(str, NULL, 10);
+	clicon_err_reset();
+	ret = 0;
+	if (xml_find_type(xreq, NULL, "data", CX_ELMNT) != NULL){
+	    if (td)
+		transaction_free(td);
+	    if ((td = transaction_new()) == NULL)
+		break;
+	    td->td_id = id;
+	    ret = plugin_proc_data(h, s, xreq, td);
+	}
+	if (ret == 0){
+	    if (td == NULL || td->td_id != id){
+		clicon_err(OE_PLUGIN, 0, "Transaction %" PRIu64 " not received", id);
+		ret = -1;
+	    }
+	    else if ((fn = plugin_proc_fn(cp, xml_find_body(xreq, "callback"))) != NULL)
+		ret = fn(h, (transaction_data)td);
+	}
+	cbuf_reset(cb);
+	if (ret == 0)
+	    cprintf(cb, "<ok/>");
+	else {
+	    cprintf(cb, "<error><errno>%d</errno><suberrno>%d</suberrno><reason>",
+		    clicon_errno, clicon_suberrno);
+	    if (xml_chardata_cbuf_append(cb, clicon_err_reason) < 0)
+		break;
+	    cprintf(cb, "</reason></error>");
+	}
+	if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
+	    break;
+	if (plugin_proc_write(s, msg) < 0)
+	    break;
+	free(msg);
+	msg = NULL;
+	xml_free(xt);
+	xt = NULL;
+    }
+ done:
+    clicon_debug(1, "%s %s exit", __FUNCTION__, cp->cp_name);
+    _exit(0);
+}
+
+/*! Start process of a plugin
+ * @param[in]  h    Clicon handle
+ * @param[in]  pp   Plugin process
+ */
+static int
+plugin_proc_start(clicon_handle       h,
+		  struct plugin_proc *pp)
+{
+    int                 sv[2];
+    pid_t               pid;
+    struct plugin_proc *pp1;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0){
+	clicon_err(OE_UNIX, errno, "socketpair");
+	return -1;
+    }
+    if ((pid = fork()) < 0){
+	clicon_err(OE_UNIX, errno, "fork");
+	close(sv[0]);
+	close(sv[1]);
+	return -1;
+    }
+    if (pid == 0){ /* Plugin process */
+	close(sv[0]);
+	/* Other processes detect that the backend has exited when their socket closes */
+	if ((pp1 = _plugin_procs) != NULL)
+	    do {
+		if (pp1->pp_pid != 0)
+		    close(pp1->pp_s);
+		pp1 = NEXTQ(struct plugin_proc *, pp1);
+	    } while (pp1 && pp1 != _plugin_procs);
+	plugin_proc_serve(h, pp->pp_cp, sv[1]); /* Does not return */
+    }
+    close(sv[1]);
+    pp->pp_pid = pid;
+    pp->pp_s = sv[0];
+    pp->pp_sent = 0;
+    clicon_debug(1, "%s %s pid:%d", __FUNCTION__, pp->pp_cp->cp_name, pid);
+    return 0;
+}
+
+/*! Stop process of a plugin
+ * @param[in]  pp    Plugin process
+ * @param[in]  force Kill the process, eg if it has failed, otherwise it exits when
+ *                   its socket is closed
+ */
+static void
+plugin_proc_stop(struct plugin_proc *pp,
+		 int                 force)
+{
+    int status;
+
+    if (pp->pp_pid == 0)
+	return;
+    close(pp->pp_s);
+    pp->pp_s = -1;
+    if (force)
+	kill(pp->pp_pid, SIGKILL);
+    if (waitpid(pp->pp_pid, &status, 0) < 0 && errno != ECHILD)
+	clicon_log(LOG_WARNING, "%s waitpid: %s", __FUNCTION__, strerror(errno));
+    pp->pp_pid = 0;
+    pp->pp_sent = 0;
+}
+
+/*! Plugin process has failed, stop it and set error, a new process is started later
+ */
+static int
+plugin_proc_fail(struct plugin_proc *pp)
+{
+    clicon_log(LOG_WARNING, "%s: Plugin '%s' process %d failed",
+	       __FUNCTION__, pp->pp_cp->cp_name, pp->pp_pid);
+    plugin_proc_stop(pp, 1);
+    clicon_err(OE_PLUGIN, 0, "Plugin '%s' process failed", pp->pp_cp->cp_name);
+    return -1;
+}
+
+/*! Find process of a plugin
+ */
+static struct plugin_proc *
+plugin_proc_find(clixon_plugin *cp)
+{
+    struct plugin_proc *pp;
+
+    if ((pp = _plugin_procs) != NULL)
+	do {
+	    if (pp->pp_cp == cp)
+		return pp;
+	    pp = NEXTQ(struct plugin_proc *, pp);
+	} while (pp && pp != _plugin_procs);
+    return NULL;
+}
+
+/*! Send a transaction callback request to the process of a plugin
+ * The process is started if it is not running. Get the result with plugin_proc_rcv.
+ * @param[in]  h       Clicon handle
+ * @param[in]  cp      Plugin with ca_trans_process set
+ * @param[in]  td      Transaction
+ * @param[in]  cbname  Callback name, eg "validate", see plugin_proc_fn
+ * @retval     0       OK, request sent
+ * @retval    -1       Error
+ */
+int
+plugin_proc_send(clicon_handle       h,
+		 clixon_plugin      *cp,
+		 transaction_data_t *td,
+		 const char         *cbname)
+{
+    int                 retval = -1;
+    struct plugin_proc *pp;
+    struct clicon_msg  *msg = NULL;
+    cbuf               *cb = NULL;
+    int                 data;
+
+    if ((pp = plugin_proc_find(cp)) == NULL){
+	if ((pp = malloc(sizeof(*pp))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memset(pp, 0, sizeof(*pp));
+	pp->pp_cp = cp;
+	pp->pp_s = -1;
+	ADDQ(pp, _plugin_procs);
+    }
+    if (pp->pp_pid == 0 && plugin_proc_start(h, pp) < 0)
+	goto done;
+    data = !(pp->pp_sent && pp->pp_tid == td->td_id);
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<transaction><id>%" PRIu64 "</id><callback>%s</callback>",
+	    td->td_id, cbname);
+    if (data){
+	cprintf(cb, "<data/>");
+	if (plugin_proc_vec2cb(cb, "dvec", td->td_src, td->td_dvec, td->td_dlen) < 0)
+	    goto done;
+	if (plugin_proc_vec2cb(cb, "avec", td->td_target, td->td_avec, td->td_alen) < 0)
+	    goto done;
+	if (plugin_proc_vec2cb(cb, "scvec", td->td_src, td->td_scvec, td->td_clen) < 0)
+	    goto done;
+	if (plugin_proc_vec2cb(cb, "tcvec", td->td_target, td->td_tcvec, td->td_clen) < 0)
+	    goto done;
+    }
+    cprintf(cb, "</transaction>");
+    if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
+	goto done;
+    if (plugin_proc_write(pp->pp_s, msg) < 0 ||
+	(data &&
+	 (plugin_proc_tree_send(pp->pp_s, td->td_src) < 0 ||
+	  plugin_proc_tree_send(pp->pp_s, td->td_target) < 0))){
+	plugin_proc_fail(pp);
+	goto done;
+    }
+    pp->pp_sent = 1;
+    pp->pp_tid = td->td_id;
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Receive the result of a transaction callback from the process of a plugin
+ * @param[in]  h       Clicon handle
+ * @param[in]  cp      Plugin with ca_trans_process set
+ * @retval     0       OK, callback succeeded
+ * @retval    -1       Error, callback failed or process failed, clicon_err is set
+ * @see plugin_proc_send
+ */
+int
+plugin_proc_rcv(clicon_handle  h,
+		clixon_plugin *cp)
+{
+    int                 retval = -1;
+    struct plugin_proc *pp;
+    struct clicon_msg  *msg = NULL;
+    cxobj              *xt = NULL;
+    cxobj              *xe;
+    char               *str;
+    int                 eof = 0;
+    int                 e;
+    int                 sube = 0;
+
+    if ((pp = plugin_proc_find(cp)) == NULL || pp->pp_pid == 0){
+	clicon_err(OE_PLUGIN, 0, "Plugin '%s' has no process", cp->cp_name);
+	goto done;
+    }
+    if (clicon_msg_rcv(pp->pp_s, &msg, &eof) < 0 || eof){
+	plugin_proc_fail(pp);
+	goto done;
+    }
+    if (clixon_xml_parse_string(msg->op_body, YB_NONE, NULL, &xt, NULL) < 0)
+	goto done;
+    if (xml_find_type(xt, NULL, "ok", CX_ELMNT) != NULL)
+	retval = 0;
+    else if ((xe = xml_find_type(xt, NULL, "error", CX_ELMNT)) != NULL){
+	e = (str = xml_find_body(xe, "errno")) ? atoi(str) : 0;
+	if ((str = xml_find_body(xe, "suberrno")) != NULL)
+	    sube = atoi(str);
+	clicon_err(e?e:OE_PLUGIN, sube, "%s",
+		   (str = xml_find_body(xe, "reason")) ? str : "");
+    }
+    else
+	plugin_proc_fail(pp);
+ done:
+    if (msg)
+	free(msg);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Call a transaction callback in the process of a plugin
+ * @param[in]  h       Clicon handle
+ * @param[in]  cp      Plugin with ca_trans_process set
+ * @param[in]  td      Transaction
+ * @param[in]  cbname  Callback name, eg "validate", see plugin_proc_fn
+ * @retval     0       OK, callback succeeded
+ * @retval    -1       Error, callback failed or process failed, clicon_err is set
+ */
+int
+plugin_proc_call(clicon_handle       h,
+		 clixon_plugin      *cp,
+		 transaction_data_t *td,
+		 const char         *cbname)
+{
+    if (plugin_proc_send(h, cp, td, cbname) < 0)
+	return -1;
+    return plugin_proc_rcv(h, cp);
+}
+
+/*! Stop all plugin processes, on backend exit
+ * @param[in]  h       Clicon handle
+ */
+int
+plugin_proc_exit(clicon_handle h)
+{
+    struct plugin_proc *pp;
+
+    while ((pp = _plugin_procs) != NULL){
+	DELQ(pp, _plugin_procs, struct plugin_proc *);
+	plugin_proc_stop(pp, 0);
+	free(pp);
+    }
+    return 0;
+}
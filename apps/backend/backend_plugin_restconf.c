@@ -284,6 +284,31 @@ restconf_pseudo_process_commit(clicon_handle    h,
     return retval;
 }
 
+/*! Restconf pseduo-plugin resync on warm restart
+ * The restconf process is started by clixon_process_start_all, only its debug flag is
+ * set here, as in restconf_pseudo_process_commit
+ */
+static int
+restconf_pseudo_process_resync(clicon_handle h,
+			       const char   *db)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *xb;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    if (xmldb_get0(h, (char*)db, YB_MODULE, NULL, "/restconf/debug", 0, &xt, NULL) < 0)
+	goto done;
+    if ((xb = xpath_first(xt, NULL, "/restconf/debug")) != NULL){
+	if (restconf_pseudo_set_debug(h, xml_body(xb)) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    xmldb_get0_free(h, &xt);
+    return retval;
+}
+
 /*! Register start/stop restconf RPC and create pseudo-plugin to monitor enable flag
  * @param[in]  h  Clixon handle
  */
@@ -299,6 +324,7 @@ backend_plugin_restconf_register(clicon_handle h,
 
     cp->cp_api.ca_trans_validate = restconf_pseudo_process_validate;
     cp->cp_api.ca_trans_commit = restconf_pseudo_process_commit;
+    cp->cp_api.ca_resync = restconf_pseudo_process_resync;
 
     /* Register generic process-control of restconf daemon, ie start/stop restconf */
     if (restconf_pseudo_process_control(h) < 0)
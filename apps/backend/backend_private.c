@@ -0,0 +1,499 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Private candidates, see CLICON_PRIVATE_CANDIDATE
+ * Each session edits a private candidate datastore instead of the shared candidate.
+ * A private candidate is created on first use by letting it share the tree of running
+ * copy-on-write, and a read snapshot of running is kept as its base. On commit, if
+ * running has changed since, the changes of the session (base to private candidate)
+ * and of running (base to running) are computed. If they have no node in common, the
+ * private candidate is reset to running and the changes of the session are applied to
+ * it as an edit, ie it is rebased, before it is committed as usual.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_handle.h"
+#include "backend_private.h"
+
+/* Private candidate of a session */
+struct private_candidate{
+    qelem_t         pc_qelem;   /* List header */
+    uint32_t        pc_session; /* Session id */
+    char           *pc_db;      /* Datastore name, XMLDB_PRIVATE_CANDIDATE<id> */
+    xmldb_snapshot *pc_base;    /* Running when created or last rebased/committed */
+};
+
+/*
+ * Variables
+ */ 
+static struct private_candidate *_private_list = NULL;
+
+/*! Find private candidate of session
+ * @param[in]  id   Session id
+ * @retval     pc   Private candidate
+ * @retval     NULL Not found
+ */
+static struct private_candidate *
+private_find(uint32_t id)
+{
+    struct private_candidate *pc;
+
+    if ((pc = _private_list) != NULL)
+	do {
+	    if (pc->pc_session == id)
+		return pc;
+	    pc = NEXTQ(struct private_candidate *, pc);
+	} while (pc && pc != _private_list);
+    return NULL;
+}
+
+/*! Free private candidate and remove its datastore
+ * @param[in]  h    Clicon handle
+ * @param[in]  pc   Private candidate, removed from list
+ */
+static int
+private_free(clicon_handle             h,
+	     struct private_candidate *pc)
+{
+    int retval = 0;
+
+    if (pc->pc_base)
+	xmldb_snapshot_release(h, pc->pc_base);
+    if (pc->pc_db){
+	if (xmldb_remove(h, pc->pc_db) < 0)
+	    retval = -1;
+	free(pc->pc_db);
+    }
+    free(pc);
+    return retval;
+}
+
+/*! Reset private candidate to running, and take running as its new base
+ * @param[in]  h    Clicon handle
+ * @param[in]  pc   Private candidate
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+private_reset(clicon_handle             h,
+	      struct private_candidate *pc)
+{
+    int             retval = -1;
+    xmldb_snapshot *sn = NULL;
+
+    if (xmldb_snapshot_get(h, "running", &sn) < 1){
+	if (clicon_errno == 0)
+	    clicon_err(OE_DB, 0, "Running could not be read");
+	goto done;
+    }
+    if (pc->pc_base)
+	xmldb_snapshot_release(h, pc->pc_base);
+    pc->pc_base = sn;
+    sn = NULL;
+    if (xmldb_copy(h, "running", pc->pc_db) < 0)
+	goto done;
+    xmldb_modified_set(h, pc->pc_db, 0);
+    retval = 0;
+ done:
+    if (sn)
+	xmldb_snapshot_release(h, sn);
+    return retval;
+}
+
+/*! Add a changed datastore node, with ancestors, to a change
+ * The copy of the node is marked with XML_FLAG_MARK, see private_overlap
+ * @param[in]  xt      Change, edit-config "config"
+ * @param[in]  x       Datastore node
+ * @param[in]  remove  1: remove x, 0: merge x and its subtree
+ * @see rollback_change_add  Same for rollback, without mark
+ */
+static int
+private_change_add(cxobj *xt,
+		   cxobj *x,
+		   int    remove)
+{
+    cxobj     *xp;
+    cxobj     *xc;
+    cxobj     *xa;
+    cxobj     *xb;
+    yang_stmt *y;
+    int        ret;
+
+    if ((xp = xml_copy_node_path(xt, xml_parent(x))) == NULL)
+	return -1;
+    if ((xc = xml_copy_node_keys(x, xp)) == NULL)
+	return -1;
+    xml_flag_set(xc, XML_FLAG_MARK);
+    if (remove){
+	if ((xa = xml_new("operation", xc, CX_ATTR)) == NULL)
+	    return -1;
+	if (xml_prefix_set(xa, NETCONF_BASE_PREFIX) < 0)
+	    return -1;
+	return xml_value_set(xa, "remove");
+    }
+    y = xml_spec(x);
+    if (y && yang_keyword_get(y) == Y_LEAF_LIST)
+	return 0;
+    xa = NULL;
+    while ((xa = xml_child_each(x, xa, -1)) != NULL){
+	if (xml_type(xa) == CX_ATTR)
+	    continue;
+	/* List keys are already copied */
+	if (xml_type(xa) == CX_ELMNT && y && yang_keyword_get(y) == Y_LIST){
+	    if ((ret = yang_key_match(y, xml_name(xa))) < 0)
+		return -1;
+	    if (ret)
+		continue;
+	}
+	if ((xb = xml_dup(xa)) == NULL)
+	    return -1;
+	if (xml_addsub(xc, xb) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Get change between two datastore trees as an edit-config
+ * Nodes only in the first tree are removed, nodes only in the second tree and
+ * changed leafs are merged. Changed nodes are marked with XML_FLAG_MARK.
+ * @param[in]  h    Clicon handle
+ * @param[in]  x0   From tree
+ * @param[in]  x1   To tree
+ * @param[out] xtp  Change, edit-config "config". Free with xml_free
+ * @param[out] nr   Number of changed nodes
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+private_change(clicon_handle h,
+	       cxobj        *x0,
+	       cxobj        *x1,
+	       cxobj       **xtp,
+	       int          *nr)
+{
+    int     retval = -1;
+    cxobj  *xt = NULL;
+    cxobj **dvec = NULL;
+    int     dlen;
+    cxobj **avec = NULL;
+    int     alen;
+    cxobj **chvec0 = NULL;
+    cxobj **chvec1 = NULL;
+    int     chlen;
+    int     i;
+
+    if (xml_diff(clicon_dbspec_yang(h), x0, x1,
+		 &dvec, &dlen, &avec, &alen, &chvec0, &chvec1, &chlen) < 0)
+	goto done;
+    if ((xt = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (xmlns_set(xt, NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE) < 0)
+	goto done;
+    for (i=0; i<dlen; i++)
+	if (private_change_add(xt, dvec[i], 1) < 0)
+	    goto done;
+    for (i=0; i<alen; i++)
+	if (private_change_add(xt, avec[i], 0) < 0)
+	    goto done;
+    for (i=0; i<chlen; i++)
+	if (private_change_add(xt, chvec1[i], 0) < 0)
+	    goto done;
+    *xtp = xt;
+    xt = NULL;
+    *nr = dlen + alen + chlen;
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    if (dvec)
+	free(dvec);
+    if (avec)
+	free(avec);
+    if (chvec0)
+	free(chvec0);
+    if (chvec1)
+	free(chvec1);
+    return retval;
+}
+
+/*! Check if two changes have a node in common
+ * @param[in]  xa   Change, or node of change
+ * @param[in]  xb   Other change, or its node matching xa
+ * @retval     1    A node changed by one is changed by the other, or is an ancestor of
+ *                  a node changed by the other
+ * @retval     0    No
+ * @see partial_lock_overlap  Same for partial locks
+ */
+static int
+private_overlap(cxobj *xa,
+		cxobj *xb)
+{
+    cxobj *xac = NULL;
+    cxobj *xbc;
+
+    while ((xac = xml_child_each(xa, xac, CX_ELMNT)) != NULL){
+	if ((xbc = xml_find_node_keys(xb, xac)) == NULL)
+	    continue;
+	if (xml_flag(xac, XML_FLAG_MARK) || xml_flag(xbc, XML_FLAG_MARK))
+	    return 1;
+	if (private_overlap(xac, xbc))
+	    return 1;
+    }
+    return 0;
+}
+
+/*! Get datastore of a session, the private candidate if the datastore is candidate
+ *
+ * The private candidate is created if it does not exist.
+ * @param[in]  h    Clicon handle
+ * @param[in]  id   Session id
+ * @param[in]  db   Datastore given by session, eg "candidate"
+ * @retval     db1  Datastore to use, db or private candidate of session
+ * @retval     NULL Error
+ */
+char *
+backend_private_db(clicon_handle h,
+		   uint32_t      id,
+		   char         *db)
+{
+    struct private_candidate *pc;
+    cbuf                     *cb = NULL;
+    char                     *db1 = NULL;
+
+    if (!clicon_option_bool(h, "CLICON_PRIVATE_CANDIDATE") ||
+	strcmp(db, "candidate") != 0)
+	return db;
+    if ((pc = private_find(id)) != NULL)
+	return pc->pc_db;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s%u", XMLDB_PRIVATE_CANDIDATE, id);
+    if ((pc = calloc(1, sizeof(*pc))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    pc->pc_session = id;
+    if ((pc->pc_db = strdup(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (private_reset(h, pc) < 0)
+	goto done;
+    ADDQ(pc, _private_list);
+    db1 = pc->pc_db;
+    pc = NULL;
+ done:
+    if (pc)
+	private_free(h, pc);
+    if (cb)
+	cbuf_free(cb);
+    return db1;
+}
+
+/*! Rebase private candidate of a session on running before commit
+ *
+ * If running has changed since the private candidate was created, reset it to running
+ * and apply the changes of the session again, unless they conflict with the changes
+ * of running.
+ * @param[in]  h        Clicon handle
+ * @param[in]  id       Session id
+ * @param[out] cbret    Error reply if conflict
+ * @retval     1        OK, or no private candidate
+ * @retval     0        Conflict, error in cbret
+ * @retval    -1        Error
+ */
+int
+backend_private_rebase(clicon_handle h,
+		       uint32_t      id,
+		       cbuf         *cbret)
+{
+    int                       retval = -1;
+    struct private_candidate *pc;
+    xmldb_snapshot           *snr = NULL;
+    xmldb_snapshot           *snp = NULL;
+    cxobj                    *xb;
+    cxobj                    *xs = NULL; /* Change of session */
+    cxobj                    *xr = NULL; /* Change of running */
+    int                       ns = 0;
+    int                       nr = 0;
+    int                       ret;
+
+    if ((pc = private_find(id)) == NULL)
+	goto ok;
+    if (xmldb_snapshot_generation(pc->pc_base) == xmldb_generation(h, "running"))
+	goto ok;
+    clicon_debug(1, "%s %s", __FUNCTION__, pc->pc_db);
+    xb = xmldb_snapshot_xml(pc->pc_base);
+    if (xmldb_snapshot_get(h, "running", &snr) < 1 ||
+	xmldb_snapshot_get(h, pc->pc_db, &snp) < 1){
+	if (clicon_errno == 0)
+	    clicon_err(OE_DB, 0, "Datastore could not be read");
+	goto done;
+    }
+    if (private_change(h, xb, xmldb_snapshot_xml(snp), &xs, &ns) < 0)
+	goto done;
+    if (private_change(h, xb, xmldb_snapshot_xml(snr), &xr, &nr) < 0)
+	goto done;
+    xmldb_snapshot_release(h, snp);
+    snp = NULL;
+    xmldb_snapshot_release(h, snr);
+    snr = NULL;
+    if (ns && nr && private_overlap(xs, xr)){
+	if (netconf_operation_failed(cbret, "application",
+				     "Commit failed, running has been changed by another session in the same nodes as the private candidate") < 0)
+	    goto done;
+	goto fail;
+    }
+    if (private_reset(h, pc) < 0)
+	goto done;
+    if (ns){
+	xml_apply0(xs, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK);
+	if ((ret = xmldb_put(h, pc->pc_db, OP_MERGE, xs, clicon_username_get(h), cbret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	xmldb_modified_set(h, pc->pc_db, 1);
+    }
+ ok:
+    retval = 1;
+ done:
+    if (snp)
+	xmldb_snapshot_release(h, snp);
+    if (snr)
+	xmldb_snapshot_release(h, snr);
+    if (xs)
+	xml_free(xs);
+    if (xr)
+	xml_free(xr);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Reset private candidate of a session to running, after commit or discard-changes
+ * @param[in]  h    Clicon handle
+ * @param[in]  id   Session id
+ * @retval     0    OK, or no private candidate
+ * @retval    -1    Error
+ */
+int
+backend_private_reset(clicon_handle h,
+		      uint32_t      id)
+{
+    struct private_candidate *pc;
+
+    if ((pc = private_find(id)) == NULL)
+	return 0;
+    return private_reset(h, pc);
+}
+
+/*! Discard changes of the candidate of a session
+ *
+ * Reset the private candidate of the session to running, or copy running to the
+ * shared candidate if there is none.
+ * @param[in]  h    Clicon handle
+ * @param[in]  id   Session id
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_private_discard(clicon_handle h,
+			uint32_t      id)
+{
+    struct private_candidate *pc;
+
+    if ((pc = private_find(id)) != NULL)
+	return private_reset(h, pc);
+    if (xmldb_copy(h, "running", "candidate") < 0)
+	return -1;
+    xmldb_modified_set(h, "candidate", 0); /* reset dirty bit */
+    return 0;
+}
+
+/*! Remove private candidates of a session, eg when it ends
+ * @param[in]  h    Clicon handle
+ * @param[in]  id   Session id, or 0 for all sessions
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_private_release(clicon_handle h,
+			uint32_t      id)
+{
+    int                       retval = 0;
+    struct private_candidate *pc;
+
+ again:
+    if ((pc = _private_list) != NULL)
+	do {
+	    if (id == 0 || pc->pc_session == id){
+		DELQ(pc, _private_list, struct private_candidate *);
+		if (private_free(h, pc) < 0)
+		    retval = -1;
+		goto again;
+	    }
+	    pc = NEXTQ(struct private_candidate *, pc);
+	} while (pc != _private_list);
+    return retval;
+}
+
+/*! Remove all private candidates at backend exit, before the datastores are freed
+ * @param[in]  h   Clicon handle
+ * @retval     0   OK
+ */
+int
+backend_private_exit(clicon_handle h)
+{
+    return backend_private_release(h, 0);
+}
@@ -0,0 +1,825 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Push subscriptions of running datastore data, a simplified variant of
+ * RFC 8639/8641 YANG-Push. See establish-push in clixon-lib.yang
+ * Periodic subscriptions send the selected data on a timer.
+ * On-change subscriptions send the selected changes of each commit, computed
+ * from the commit transaction, see backend_push_commit.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_handle.h"
+#include "clixon_backend_transaction.h"
+#include "backend_plugin.h"
+#include "backend_client.h"
+#include "backend_push.h"
+
+/*
+ * Types
+ */ 
+/* Push subscription, see establish-push */
+struct push_subscription{
+    qelem_t              ps_q;         /* queue header */
+    uint32_t             ps_id;        /* Subscription id */
+    clicon_handle        ps_h;         /* Clicon handle, used in timer callback */
+    struct client_entry *ps_ce;        /* Client session of subscription */
+    char                *ps_username;  /* Requesting user, for NACM */
+    char                *ps_xpath;     /* Canonical xpath-filter, NULL if all data */
+    cvec                *ps_nsc;       /* Namespace context of ps_xpath */
+    uint32_t             ps_period;    /* Periodic: period in cs, 0 if on-change */
+    uint32_t             ps_dampening; /* On-change: dampening period in cs */
+    struct timeval       ps_last;      /* On-change: time of last push-change-update */
+    cxobj               *ps_changes;   /* On-change: changes waiting for dampening */
+    struct timeval       ps_timer;     /* Time of registered timer, zero if none */
+};
+
+/*
+ * Variables
+ */ 
+static struct push_subscription *_push_list = NULL;
+static uint32_t                  _push_id = 0;
+
+static int push_timeout_cb(int fd, void *arg);
+
+/*! Translate centiseconds to timeval
+ */
+static void
+push_cs2tv(uint32_t        cs,
+	   struct timeval *tv)
+{
+    tv->tv_sec = cs/100;
+    tv->tv_usec = (cs%100)*10000;
+}
+
+/*! Register subscription timer
+ * @param[in]  ps  Push subscription
+ * @param[in]  t   Absolute time of timeout
+ */
+static int
+push_timer_reg(struct push_subscription *ps,
+	       struct timeval           *t)
+{
+    ps->ps_timer = *t;
+    return clixon_event_reg_timeout(*t, push_timeout_cb, ps, "push subscription");
+}
+
+/*! Remove push subscription and free it
+ * @param[in]  ps  Push subscription
+ */
+static int
+push_free(struct push_subscription *ps)
+{
+    if (timerisset(&ps->ps_timer))
+	clixon_event_unreg_timeout(push_timeout_cb, ps);
+    DELQ(ps, _push_list, struct push_subscription *);
+    if (ps->ps_username)
+	free(ps->ps_username);
+    if (ps->ps_xpath)
+	free(ps->ps_xpath);
+    if (ps->ps_nsc)
+	xml_nsctx_free(ps->ps_nsc);
+    if (ps->ps_changes)
+	xml_free(ps->ps_changes);
+    free(ps);
+    return 0;
+}
+
+/*! Find push subscription by id
+ */
+static struct push_subscription *
+push_find(uint32_t id)
+{
+    struct push_subscription *ps;
+
+    if ((ps = _push_list) != NULL)
+	do {
+	    if (ps->ps_id == id)
+		return ps;
+	    ps = NEXTQ(struct push_subscription *, ps);
+	} while (ps && ps != _push_list);
+    return NULL;
+}
+
+/*! Remove data not readable by the user of a subscription
+ * @param[in]  h   Clicon handle
+ * @param[in]  ps  Push subscription
+ * @param[in]  xt  XML tree, top-level data is children of xt
+ */
+static int
+push_nacm(clicon_handle             h,
+	  struct push_subscription *ps,
+	  cxobj                    *xt)
+{
+    int     retval = -1;
+    cxobj  *xnacm = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen;
+    int     ret;
+
+    if ((ret = nacm_access_pre(h, ps->ps_ce->ce_username, ps->ps_username, &xnacm)) < 0)
+	goto done;
+    if (ret == 0){ /* Do NACM validation */
+	if (xpath_vec(xt, NULL, "/", &xvec, &xlen) < 0)
+	    goto done;
+	if (nacm_datanode_read(h, xt, xvec, xlen, ps->ps_username, xnacm) < 0) 
+	    goto done;
+    }
+    retval = 0;
+ done:
+    if (xvec)
+	free(xvec);
+    return retval;
+}
+
+/*! Send a notification of a push subscription to its client
+ * @param[in]  h     Clicon handle
+ * @param[in]  ps    Push subscription
+ * @param[in]  name  Notification name: push-update or push-change-update
+ * @param[in]  xc    Notification data, consumed by this function
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+push_notify(clicon_handle             h,
+	    struct push_subscription *ps,
+	    char                     *name,
+	    cxobj                    *xc)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    cxobj         *xt = NULL;
+    cxobj         *xp;
+    struct timeval tv;
+    char           timestr[28];
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    gettimeofday(&tv, NULL);
+    if (time2str(tv, timestr, sizeof(timestr)) < 0){
+	clicon_err(OE_UNIX, errno, "time2str");
+	goto done;
+    }
+    cprintf(cb, "<notification xmlns=\"%s\"><eventTime>%s</eventTime>"
+	    "<%s xmlns=\"%s\"><id>%u</id></%s></notification>",
+	    NOTIFICATION_RFC5277_NAMESPACE, timestr,
+	    name, CLIXON_LIB_NS, ps->ps_id, name);
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xt, NULL) < 0)
+	goto done;
+    if (xml_rootchild(xt, 0, &xt) < 0)
+	goto done;
+    if ((xp = xml_find_type(xt, NULL, name, CX_ELMNT)) == NULL){
+	clicon_err(OE_XML, ENOENT, "%s not found", name);
+	goto done;
+    }
+    if (xml_addsub(xp, xc) < 0)
+	goto done;
+    xc = NULL;
+    if (backend_client_notify(h, ps->ps_ce, xt) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (xc)
+	xml_free(xc);
+    if (xt)
+	xml_free(xt);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Send selected data of a periodic subscription
+ * @param[in]  h   Clicon handle
+ * @param[in]  ps  Push subscription
+ */
+static int
+push_periodic(clicon_handle             h,
+	      struct push_subscription *ps)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    int    ret;
+
+    if ((ret = backend_client_get(h, ps->ps_xpath, ps->ps_nsc, &xt)) < 0)
+	goto done;
+    if (ret == 0){ /* State data callback failed, skip this period */
+	clicon_log(LOG_WARNING, "push subscription %u: state data failed", ps->ps_id);
+	goto ok;
+    }
+    if (push_nacm(h, ps, xt) < 0)
+	goto done;
+    if (xml_name_set(xt, "datastore-contents") < 0)
+	goto done;
+    if (push_notify(h, ps, "push-update", xt) < 0){
+	xt = NULL;
+	goto done;
+    }
+    xt = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Send changes of an on-change subscription
+ * @param[in]  h   Clicon handle
+ * @param[in]  ps  Push subscription, with changes in ps_changes
+ */
+static int
+push_changes_send(clicon_handle             h,
+		  struct push_subscription *ps)
+{
+    cxobj *xc;
+
+    xc = ps->ps_changes;
+    ps->ps_changes = NULL;
+    gettimeofday(&ps->ps_last, NULL);
+    return push_notify(h, ps, "push-change-update", xc);
+}
+
+/*! Timer callback of periodic subscription or dampened on-change subscription 
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Push subscription
+ */
+static int
+push_timeout_cb(int   fd,
+		void *arg)
+{
+    int                       retval = -1;
+    struct push_subscription *ps = (struct push_subscription *)arg;
+    clicon_handle             h = ps->ps_h;
+    struct timeval            t;
+    struct timeval            t1;
+    
+    t = ps->ps_timer;
+    timerclear(&ps->ps_timer);
+    if (ps->ps_period){
+	if (push_periodic(h, ps) < 0)
+	    goto done;
+	/* Next period from previous, but not in the past if backend was busy */
+	push_cs2tv(ps->ps_period, &t1);
+	timeradd(&t, &t1, &t);
+	gettimeofday(&t1, NULL);
+	if (timercmp(&t, &t1, <))
+	    t = t1;
+	if (push_timer_reg(ps, &t) < 0)
+	    goto done;
+    }
+    else if (ps->ps_changes){
+	if (push_changes_send(h, ps) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if node or an ancestor of it is in a vector
+ * @param[in]  x    XML node
+ * @param[in]  vec  XML node vector
+ * @param[in]  len  Length of vec
+ * @retval     1    x or an ancestor of x is in vec
+ * @retval     0    Not in vec
+ */
+static int
+push_selected(cxobj  *x,
+	      cxobj **vec,
+	      size_t  len)
+{
+    size_t i;
+
+    for (; x != NULL; x = xml_parent(x))
+	for (i=0; i<len; i++)
+	    if (vec[i] == x)
+		return 1;
+    return 0;
+}
+
+/*! Check if node is in a vector
+ */
+static int
+push_in(cxobj  *x,
+	cxobj **vec,
+	size_t  len)
+{
+    size_t i;
+
+    for (i=0; i<len; i++)
+	if (vec[i] == x)
+	    return 1;
+    return 0;
+}
+
+/*! Add a changed datastore node with ancestors to a change tree
+ * @param[in]  xchanges  datastore-changes
+ * @param[in]  name      created, updated or deleted
+ * @param[in]  x         Changed datastore node
+ * @param[in]  subtree   1: copy subtree of x, 0: copy only x with list keys
+ */
+static int
+push_change_add(cxobj *xchanges,
+		char  *name,
+		cxobj *x,
+		int    subtree)
+{
+    cxobj     *xt;
+    cxobj     *xp;
+    cxobj     *xc;
+    cxobj     *xa;
+    cxobj     *xb;
+    yang_stmt *y;
+    int        ret;
+
+    if ((xt = xml_find_type(xchanges, NULL, name, CX_ELMNT)) == NULL &&
+	(xt = xml_new(name, xchanges, CX_ELMNT)) == NULL)
+	return -1;
+    if ((xp = xml_copy_node_path(xt, xml_parent(x))) == NULL)
+	return -1;
+    if ((xc = xml_copy_node_keys(x, xp)) == NULL)
+	return -1;
+    y = xml_spec(x);
+    if (subtree && (y == NULL || yang_keyword_get(y) != Y_LEAF_LIST)){
+	xa = NULL;
+	while ((xa = xml_child_each(x, xa, -1)) != NULL){
+	    if (xml_type(xa) == CX_ATTR)
+		continue;
+	    /* List keys are already copied */
+	    if (xml_type(xa) == CX_ELMNT && y && yang_keyword_get(y) == Y_LIST){
+		if ((ret = yang_key_match(y, xml_name(xa))) < 0)
+		    return -1;
+		if (ret)
+		    continue;
+	    }
+	    if ((xb = xml_dup(xa)) == NULL)
+		return -1;
+	    if (xml_addsub(xc, xb) < 0)
+		return -1;
+	}
+    }
+    return 0;
+}
+
+/*! Add changed datastore nodes selected by a subscription to a change tree
+ * A change is selected if it, or an ancestor, is selected by the subscription xpath.
+ * A selected node in a changed subtree is also a change, eg a leaf of a created list
+ * entry, if no ancestor of it is selected.
+ * @param[in]  xchanges  datastore-changes
+ * @param[in]  name      created, updated or deleted
+ * @param[in]  vec       Changes of transaction
+ * @param[in]  len       Length of vec
+ * @param[in]  svec      Nodes selected by xpath, or NULL if all nodes are selected
+ * @param[in]  slen      Length of svec
+ * @param[in]  flag      Flag of nodes in changed subtrees, or 0
+ * @param[in]  subtree   1: copy subtree of changes, 0: copy only node with list keys
+ */
+static int
+push_changes_vec(cxobj  *xchanges,
+		 char   *name,
+		 cxobj **vec,
+		 int     len,
+		 cxobj **svec,
+		 size_t  slen,
+		 int     all,
+		 int     flag,
+		 int     subtree)
+{
+    int    i;
+    cxobj *x;
+    
+    for (i=0; i<len; i++){
+	x = vec[i];
+	if (all || push_selected(x, svec, slen))
+	    if (push_change_add(xchanges, name, x, subtree) < 0)
+		return -1;
+    }
+    if (all || flag == 0)
+	return 0;
+    for (i=0; i<slen; i++){
+	x = svec[i];
+	if (xml_flag(x, flag) &&
+	    !push_in(x, vec, len) &&
+	    !push_selected(xml_parent(x), svec, slen))
+	    if (push_change_add(xchanges, name, x, subtree) < 0)
+		return -1;
+    }
+    return 0;
+}
+
+/*! Compute changes of a commit selected by an on-change subscription
+ * @param[in]  h         Clicon handle
+ * @param[in]  ps        Push subscription
+ * @param[in]  td        Commit transaction
+ * @param[out] xchanges  datastore-changes, NULL if no changes are selected
+ */
+static int
+push_changes(clicon_handle             h,
+	     struct push_subscription *ps,
+	     transaction_data_t       *td,
+	     cxobj                   **xchanges)
+{
+    int     retval = -1;
+    cxobj  *xc = NULL;
+    cxobj **tvec = NULL;
+    size_t  tlen = 0;
+    cxobj **svec = NULL;
+    size_t  slen = 0;
+    int     all;
+    cxobj  *x;
+
+    all = (ps->ps_xpath == NULL || strcmp(ps->ps_xpath, "/") == 0);
+    if (!all){
+	if (td->td_target &&
+	    xpath_vec(td->td_target, ps->ps_nsc, "%s", &tvec, &tlen, ps->ps_xpath) < 0)
+	    goto done;
+	if (td->td_src &&
+	    xpath_vec(td->td_src, ps->ps_nsc, "%s", &svec, &slen, ps->ps_xpath) < 0)
+	    goto done;
+	if (tlen == 0 && slen == 0)
+	    goto ok;
+    }
+    if ((xc = xml_new("datastore-changes", NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (push_changes_vec(xc, "created", td->td_avec, td->td_alen,
+			 tvec, tlen, all, XML_FLAG_ADD, 1) < 0)
+	goto done;
+    if (push_changes_vec(xc, "updated", td->td_tcvec, td->td_clen,
+			 tvec, tlen, all, 0, 1) < 0)
+	goto done;
+    if (push_changes_vec(xc, "deleted", td->td_dvec, td->td_dlen,
+			 svec, slen, all, XML_FLAG_DEL, 0) < 0)
+	goto done;
+    /* Remove what user may not read */
+    x = NULL;
+    while ((x = xml_child_each(xc, x, CX_ELMNT)) != NULL)
+	if (push_nacm(h, ps, x) < 0)
+	    goto done;
+    if (xml_child_nr_type(xc, CX_ELMNT) == 0)
+	goto ok;
+    *xchanges = xc;
+    xc = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (xc)
+	xml_free(xc);
+    if (tvec)
+	free(tvec);
+    if (svec)
+	free(svec);
+    return retval;
+}
+
+/*! Merge changes of a commit into changes waiting for dampening
+ * @param[in]  ps   Push subscription
+ * @param[in]  xc   datastore-changes, consumed by this function
+ */
+static int
+push_changes_merge(struct push_subscription *ps,
+		   cxobj                    *xc)
+{
+    cxobj *x;
+    cxobj *x0;
+    cxobj *xa;
+
+    if (ps->ps_changes == NULL){
+	ps->ps_changes = xc;
+	return 0;
+    }
+    while ((x = xml_child_i_type(xc, 0, CX_ELMNT)) != NULL){
+	if ((x0 = xml_find_type(ps->ps_changes, NULL, xml_name(x), CX_ELMNT)) == NULL){
+	    if (xml_addsub(ps->ps_changes, x) < 0)
+		goto err;
+	    continue;
+	}
+	while ((xa = xml_child_i_type(x, 0, CX_ELMNT)) != NULL)
+	    if (xml_addsub(x0, xa) < 0)
+		goto err;
+	xml_purge(x);
+    }
+    xml_free(xc);
+    return 0;
+ err:
+    xml_free(xc);
+    return -1;
+}
+
+/*! Send changes of a commit to on-change push subscriptions
+ * Called after commit, while transaction change vectors and flags are valid
+ * @param[in]  h   Clicon handle
+ * @param[in]  td  Commit transaction
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see candidate_commit
+ */
+int
+backend_push_commit(clicon_handle       h,
+		    transaction_data_t *td)
+{
+    int                       retval = -1;
+    struct push_subscription *ps;
+    cxobj                    *xc;
+    struct timeval            t;
+    struct timeval            t1;
+
+    if ((ps = _push_list) != NULL)
+	do {
+	    if (ps->ps_period)
+		goto next;
+	    xc = NULL;
+	    if (push_changes(h, ps, td, &xc) < 0)
+		goto done;
+	    if (xc == NULL)
+		goto next;
+	    if (push_changes_merge(ps, xc) < 0)
+		goto done;
+	    if (timerisset(&ps->ps_timer)) /* Sent when dampening timer expires */
+		goto next;
+	    push_cs2tv(ps->ps_dampening, &t1);
+	    timeradd(&ps->ps_last, &t1, &t);
+	    gettimeofday(&t1, NULL);
+	    if (ps->ps_dampening == 0 || !timercmp(&t1, &t, <)){
+		if (push_changes_send(h, ps) < 0)
+		    goto done;
+	    }
+	    else if (push_timer_reg(ps, &t) < 0)
+		goto done;
+	next:
+	    ps = NEXTQ(struct push_subscription *, ps);
+	} while (ps && ps != _push_list);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Remove push subscriptions of a client
+ * @param[in]  h   Clicon handle
+ * @param[in]  ce  Client entry
+ */
+int
+backend_push_client_rm(clicon_handle        h,
+		       struct client_entry *ce)
+{
+    struct push_subscription *ps;
+    int                       found;
+
+    do {
+	found = 0;
+	if ((ps = _push_list) != NULL)
+	    do {
+		if (ps->ps_ce == ce){
+		    push_free(ps); /* changes _push_list */
+		    found++;
+		    break;
+		}
+		ps = NEXTQ(struct push_subscription *, ps);
+	    } while (ps && ps != _push_list);
+    } while (found);
+    return 0;
+}
+
+/*! Establish a push subscription
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_establish_push(clicon_handle h,
+			   cxobj        *xe,
+			   cbuf         *cbret,
+			   void         *arg, 
+			   void         *regarg)
+{
+    int                       retval = -1;
+    struct client_entry      *ce = (struct client_entry *)arg;
+    struct push_subscription *ps = NULL;
+    yang_stmt                *yspec;
+    cxobj                    *xf;
+    char                     *xpath0;
+    cvec                     *nsc = NULL;
+    char                     *str;
+    char                     *reason = NULL;
+    char                     *username;
+    struct timeval            t;
+    struct timeval            t1;
+    int                       ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if ((ps = malloc(sizeof(*ps))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(ps, 0, sizeof(*ps));
+    ps->ps_h = h;
+    ps->ps_ce = ce;
+    if ((username = clicon_username_get(h)) != NULL &&
+	(ps->ps_username = strdup(username)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if ((xf = xml_find_type(xe, NULL, "xpath-filter", CX_ELMNT)) != NULL &&
+	(xpath0 = xml_body(xf)) != NULL){
+	/* Namespace context from the element, as filter in get */
+	if (xml_nsctx_node(xf, &nsc) < 0)
+	    goto done;
+	if (xpath2canonical(xpath0, nsc, yspec, &ps->ps_xpath, &ps->ps_nsc) < 0)
+	    goto done;
+    }
+    if ((str = xml_find_body(xe, "period")) != NULL){
+	if ((ret = parse_uint32(str, &ps->ps_period, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_uint32");
+	    goto done;
+	}
+	if (ret == 0 || ps->ps_period == 0){
+	    if (netconf_invalid_value(cbret, "application", "Invalid period") < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    else if (xml_find_type(xe, NULL, "on-change", CX_ELMNT) != NULL){
+	if ((str = xml_find_body(xe, "dampening-period")) != NULL){
+	    if ((ret = parse_uint32(str, &ps->ps_dampening, &reason)) < 0){
+		clicon_err(OE_XML, errno, "parse_uint32");
+		goto done;
+	    }
+	    if (ret == 0){
+		if (netconf_invalid_value(cbret, "application", "Invalid dampening-period") < 0)
+		    goto done;
+		goto ok;
+	    }
+	}
+    }
+    else{
+	if (netconf_missing_element(cbret, "application", "period",
+				    "Either period or on-change is required") < 0)
+	    goto done;
+	goto ok;
+    }
+    ps->ps_id = ++_push_id;
+    ADDQ(ps, _push_list);
+    if (ps->ps_period){ /* First update after one period */
+	gettimeofday(&t, NULL);
+	push_cs2tv(ps->ps_period, &t1);
+	timeradd(&t, &t1, &t);
+	if (push_timer_reg(ps, &t) < 0){
+	    push_free(ps);
+	    ps = NULL;
+	    goto done;
+	}
+    }
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><id xmlns=\"%s\">%u</id></rpc-reply>",
+	    NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS, ps->ps_id);
+    ps = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (ps){
+	if (ps->ps_username)
+	    free(ps->ps_username);
+	if (ps->ps_xpath)
+	    free(ps->ps_xpath);
+	if (ps->ps_nsc)
+	    xml_nsctx_free(ps->ps_nsc);
+	free(ps);
+    }
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (reason)
+	free(reason);
+    return retval;
+}
+
+/*! Delete a push subscription
+ * A subscription can be deleted by its own session, or another session of same user,
+ * eg the netconf client which uses a separate session for notifications.
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_delete_push(clicon_handle h,
+			cxobj        *xe,
+			cbuf         *cbret,
+			void         *arg, 
+			void         *regarg)
+{
+    int                       retval = -1;
+    struct client_entry      *ce = (struct client_entry *)arg;
+    struct push_subscription *ps = NULL;
+    char                     *str;
+    char                     *reason = NULL;
+    char                     *username;
+    uint32_t                  id = 0;
+    int                       ret;
+
+    if ((str = xml_find_body(xe, "id")) != NULL){
+	if ((ret = parse_uint32(str, &id, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_uint32");
+	    goto done;
+	}
+	if (ret == 0)
+	    id = 0;
+    }
+    username = clicon_username_get(h);
+    if ((ps = push_find(id)) == NULL ||
+	(ps->ps_ce != ce &&
+	 (username == NULL || ps->ps_username == NULL ||
+	  strcmp(username, ps->ps_username) != 0))){
+	if (netconf_invalid_value(cbret, "application", "No such push subscription") < 0)
+	    goto done;
+	goto ok;
+    }
+    push_free(ps);
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
+    retval = 0;
+ done:
+    if (reason)
+	free(reason);
+    return retval;
+}
+
+/*! Register push subscription RPCs
+ * @param[in]  h     Clicon handle
+ * @retval    -1     Error (fatal)
+ * @retval     0     OK
+ * @see backend_rpc_init
+ */
+int
+backend_push_rpc_init(clicon_handle h)
+{
+    int retval = -1;
+
+    if (rpc_callback_register(h, from_client_establish_push, NULL,
+			      CLIXON_LIB_NS, "establish-push") < 0)
+	goto done;
+    if (rpc_callback_register(h, from_client_delete_push, NULL,
+			      CLIXON_LIB_NS, "delete-push") < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
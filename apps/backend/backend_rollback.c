@@ -0,0 +1,534 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Rollback of commits, see rollback in clixon-lib.yang and CLICON_COMMIT_ROLLBACK
+ * The running datastore before each of the latest commits is kept as a read snapshot
+ * of the datastore, see xmldb_snapshot_get. A commit replaces the cache tree of running
+ * with the tree of candidate, and the snapshot keeps the replaced tree, so no copy is
+ * made. A rollback lets candidate share the tree of the snapshot.
+ * The reverse change of each commit is also saved as an edit-config file in
+ * CLICON_XMLDB_DIR, rollback_0.xml for the latest commit, so that commits made before
+ * a restart can be rolled back, and only the change, not the whole datastore, is saved.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <sys/stat.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "clixon_backend_handle.h"
+#include "clixon_backend_transaction.h"
+#include "backend_plugin.h"
+#include "backend_client.h"
+#include "backend_rollback.h"
+
+/* Reverse change files in CLICON_XMLDB_DIR, latest commit first */
+#define ROLLBACK_FILE "rollback_%u.xml"
+
+/*
+ * Variables
+ */ 
+/* Snapshots of running before the latest commits, latest first */
+static xmldb_snapshot **_rollback_vec = NULL;
+static uint32_t         _rollback_len = 0;
+
+/*! Get filename of reverse change of a commit
+ * @param[in]  h    Clicon handle
+ * @param[in]  id   Commit, 0 is the latest
+ * @param[out] cb   Filename
+ */
+static int
+rollback_filename(clicon_handle h,
+		  uint32_t      id,
+		  cbuf         *cb)
+{
+    char *dir;
+
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+	clicon_err(OE_XML, errno, "dbdir not set");
+	return -1;
+    }
+    cbuf_reset(cb);
+    cprintf(cb, "%s/" ROLLBACK_FILE, dir, id);
+    return 0;
+}
+
+/*! Add a datastore node of a commit, with ancestors, to its reverse change
+ * @param[in]  xt      Reverse change, edit-config "config"
+ * @param[in]  x       Datastore node
+ * @param[in]  remove  1: remove x (added by the commit), 0: merge x and its subtree
+ */
+static int
+rollback_change_add(cxobj *xt,
+		    cxobj *x,
+		    int    remove)
+{
+    cxobj     *xp;
+    cxobj     *xc;
+    cxobj     *xa;
+    cxobj     *xb;
+    yang_stmt *y;
+    int        ret;
+
+    if ((xp = xml_copy_node_path(xt, xml_parent(x))) == NULL)
+	return -1;
+    if ((xc = xml_copy_node_keys(x, xp)) == NULL)
+	return -1;
+    if (remove){
+	if ((xa = xml_new("operation", xc, CX_ATTR)) == NULL)
+	    return -1;
+	if (xml_prefix_set(xa, NETCONF_BASE_PREFIX) < 0)
+	    return -1;
+	return xml_value_set(xa, "remove");
+    }
+    y = xml_spec(x);
+    if (y && yang_keyword_get(y) == Y_LEAF_LIST)
+	return 0;
+    xa = NULL;
+    while ((xa = xml_child_each(x, xa, -1)) != NULL){
+	if (xml_type(xa) == CX_ATTR)
+	    continue;
+	/* List keys are already copied */
+	if (xml_type(xa) == CX_ELMNT && y && yang_keyword_get(y) == Y_LIST){
+	    if ((ret = yang_key_match(y, xml_name(xa))) < 0)
+		return -1;
+	    if (ret)
+		continue;
+	}
+	if ((xb = xml_dup(xa)) == NULL)
+	    return -1;
+	if (xml_addsub(xc, xb) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Get reverse change of a commit transaction, before it is made
+ *
+ * An edit-config that makes the target of the transaction the source again: added
+ * nodes are removed, and deleted and changed nodes are merged from the source.
+ * Call before the trees of the transaction are cleared of default values, which are
+ * not included.
+ * @param[in]  h    Clicon handle
+ * @param[in]  td   Commit transaction
+ * @param[out] xtp  Reverse change, or NULL if rollback is not enabled. Free with xml_free
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see backend_rollback_add
+ */
+int
+backend_rollback_change(clicon_handle       h,
+			transaction_data_t *td,
+			cxobj             **xtp)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    int    i;
+
+    if (clicon_option_int(h, "CLICON_COMMIT_ROLLBACK") <= 0)
+	goto ok;
+    if ((xt = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (xmlns_set(xt, NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE) < 0)
+	goto done;
+    for (i=0; i<td->td_alen; i++)
+	if (rollback_change_add(xt, td->td_avec[i], 1) < 0)
+	    goto done;
+    for (i=0; i<td->td_dlen; i++)
+	if (rollback_change_add(xt, td->td_dvec[i], 0) < 0)
+	    goto done;
+    for (i=0; i<td->td_clen; i++)
+	if (rollback_change_add(xt, td->td_scvec[i], 0) < 0)
+	    goto done;
+    /* Default values copied from the source */
+    if (xml_tree_prune_flagged(xt, XML_FLAG_DEFAULT, 1) < 0)
+	goto done;
+    *xtp = xt;
+    xt = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Save reverse change of latest commit, shift older changes and remove the oldest
+ * @param[in]  h    Clicon handle
+ * @param[in]  xt   Reverse change
+ * @param[in]  max  Max number of commits
+ */
+static int
+rollback_change_save(clicon_handle h,
+		     cxobj        *xt,
+		     uint32_t      max)
+{
+    int      retval = -1;
+    cbuf    *cb = NULL;
+    cbuf    *cb1 = NULL;
+    uint32_t i;
+    FILE    *f = NULL;
+    
+    if ((cb = cbuf_new()) == NULL ||
+	(cb1 = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (rollback_filename(h, max-1, cb) < 0)
+	goto done;
+    if (unlink(cbuf_get(cb)) < 0 && errno != ENOENT){
+	clicon_err(OE_UNIX, errno, "unlink(%s)", cbuf_get(cb));
+	goto done;
+    }
+    for (i=max-1; i>0; i--){
+	if (rollback_filename(h, i-1, cb1) < 0)
+	    goto done;
+	if (rename(cbuf_get(cb1), cbuf_get(cb)) < 0 && errno != ENOENT){
+	    clicon_err(OE_UNIX, errno, "rename(%s)", cbuf_get(cb));
+	    goto done;
+	}
+	if (rollback_filename(h, i-1, cb) < 0)
+	    goto done;
+    }
+    if ((f = fopen(cbuf_get(cb), "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cb));
+	goto done;
+    }
+    if (clicon_xml2file(f, xt, 0, clicon_option_bool(h, "CLICON_XMLDB_PRETTY")) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (cb)
+	cbuf_free(cb);
+    if (cb1)
+	cbuf_free(cb1);
+    return retval;
+}
+
+/*! Add a commit that can be rolled back, after running has been replaced
+ *
+ * @param[in]  h    Clicon handle
+ * @param[in]  sn   Snapshot of running before the commit, consumed
+ * @param[in]  xt   Reverse change of the commit, consumed
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @code
+ *   backend_rollback_change(h, td, &xrb);   // Before clearing td
+ *   if (xrb)
+ *      xmldb_snapshot_get(h, "running", &sn);
+ *   xmldb_copy(h, "candidate", "running");
+ *   if (xrb)
+ *      backend_rollback_add(h, sn, xrb);
+ * @endcode
+ * @see candidate_commit
+ */
+int
+backend_rollback_add(clicon_handle   h,
+		     xmldb_snapshot *sn,
+		     cxobj          *xt)
+{
+    int              retval = -1;
+    int              max;
+    xmldb_snapshot **vec;
+
+    if ((max = clicon_option_int(h, "CLICON_COMMIT_ROLLBACK")) <= 0){
+	retval = 0;
+	goto done;
+    }
+    if (rollback_change_save(h, xt, max) < 0)
+	goto done;
+    while (_rollback_len >= max){
+	_rollback_len--;
+	if (xmldb_snapshot_release(h, _rollback_vec[_rollback_len]) < 0)
+	    goto done;
+    }
+    if ((vec = realloc(_rollback_vec, (_rollback_len+1)*sizeof(*vec))) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	goto done;
+    }
+    _rollback_vec = vec;
+    memmove(&vec[1], &vec[0], _rollback_len*sizeof(*vec));
+    vec[0] = sn;
+    _rollback_len++;
+    sn = NULL;
+    retval = 0;
+ done:
+    if (sn)
+	xmldb_snapshot_release(h, sn);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Forget all commits, eg when running is replaced at startup
+ * Snapshots are released and reverse change files are removed
+ * @param[in]  h    Clicon handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_rollback_reset(clicon_handle h)
+{
+    int         retval = -1;
+    cbuf       *cb = NULL;
+    uint32_t    i;
+    struct stat st;
+
+    if (backend_rollback_exit(h) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    /* Files may remain from a larger CLICON_COMMIT_ROLLBACK */
+    for (i=0; ; i++){
+	if (rollback_filename(h, i, cb) < 0)
+	    goto done;
+	if (lstat(cbuf_get(cb), &st) < 0)
+	    break;
+	if (unlink(cbuf_get(cb)) < 0){
+	    clicon_err(OE_UNIX, errno, "unlink(%s)", cbuf_get(cb));
+	    goto done;
+	}
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Release snapshots of commits, reverse change files are kept
+ * @param[in]  h    Clicon handle
+ */
+int
+backend_rollback_exit(clicon_handle h)
+{
+    int retval = -1;
+    
+    while (_rollback_len > 0){
+	_rollback_len--;
+	if (xmldb_snapshot_release(h, _rollback_vec[_rollback_len]) < 0)
+	    goto done;
+    }
+    if (_rollback_vec){
+	free(_rollback_vec);
+	_rollback_vec = NULL;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Apply a saved reverse change of a commit to candidate
+ * @param[in]  h     Clicon handle
+ * @param[in]  file  Reverse change file
+ * @param[out] cbret Error reply if retval is 0
+ * @retval     1     OK
+ * @retval     0    Failed, error in cbret
+ * @retval    -1    Error
+ */
+static int
+rollback_change_apply(clicon_handle h,
+		      char         *file,
+		      cbuf         *cbret)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    FILE      *fp = NULL;
+    cxobj     *xt = NULL;
+    cxobj     *xerr = NULL;
+    int        ret;
+
+    yspec = clicon_dbspec_yang(h);
+    if ((fp = fopen(file, "r")) == NULL){
+	clicon_err(OE_UNIX, errno, "open(%s)", file);
+	goto done;
+    }
+    if (clixon_xml_parse_file(fp, YB_NONE, yspec, &xt, &xerr) < 0)
+	goto done;
+    /* Replace parent w first child */
+    if (xml_rootchild(xt, 0, &xt) < 0)
+    	goto done;
+    if ((ret = xml_bind_yang(xt, YB_MODULE, yspec, &xerr)) < 0)
+	goto done;
+    if (ret == 0){
+	if (netconf_err2cb(xerr, cbret) < 0)
+	    goto done;
+	retval = 0;
+	goto done;
+    }
+    retval = xmldb_put(h, "candidate", OP_MERGE, xt, clicon_username_get(h), cbret);
+ done:
+    if (fp)
+	fclose(fp);
+    if (xt)
+	xml_free(xt);
+    if (xerr)
+	xml_free(xerr);
+    return retval;
+}
+
+/*! Replace candidate with running as it was before one of the latest commits
+ *
+ * The latest commits are rolled back from snapshots without reading or comparing
+ * the datastore, older commits by applying their saved reverse changes. The rollback
+ * is made when candidate is committed, which computes the change from running.
+ * @param[in]  h       Clicon handle 
+ * @param[in]  xe      Request: <rpc><xn></rpc> 
+ * @param[out] cbret   Return xml tree, eg <rpc-reply>..., <rpc-error.. 
+ * @param[in]  arg     client-entry
+ * @param[in]  regarg  User argument given at rpc_callback_register() 
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+from_client_rollback(clicon_handle h,
+		     cxobj        *xe,
+		     cbuf         *cbret,
+		     void         *arg,
+		     void         *regarg)
+{
+    int                  retval = -1;
+    struct client_entry *ce = (struct client_entry *)arg;
+    uint32_t             myid = ce->ce_id;
+    uint32_t             iddb;
+    uint32_t             id = 0;
+    uint32_t             i;
+    char                *str;
+    char                *reason = NULL;
+    cbuf                *cbx = NULL;
+    cxobj               *xt;
+    struct stat          st;
+    int                  ret;
+
+    if ((cbx = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((str = xml_find_body(xe, "id")) != NULL){
+	if ((ret = parse_uint32(str, &id, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_uint32"); 
+	    goto done;
+	}
+	if (ret == 0){
+	    if (netconf_bad_element(cbret, "protocol", "id", reason) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    /* Check if candidate locked by other client */
+    iddb = xmldb_islocked(h, "candidate");
+    if (iddb && myid != iddb){
+	cprintf(cbx, "<session-id>%u</session-id>", iddb);
+	if (netconf_lock_denied(cbret, cbuf_get(cbx), "Operation failed, lock is already held") < 0)
+	    goto done;
+	goto ok;
+    }
+    /* All reverse changes older than the snapshots must exist */
+    for (i=_rollback_len; i<=id; i++){
+	if (rollback_filename(h, i, cbx) < 0)
+	    goto done;
+	if (i >= (uint32_t)clicon_option_int(h, "CLICON_COMMIT_ROLLBACK") ||
+	    lstat(cbuf_get(cbx), &st) < 0){
+	    cbuf_reset(cbx);
+	    cprintf(cbx, "No commit %u to roll back", id);
+	    if (netconf_invalid_value(cbret, "protocol", cbuf_get(cbx)) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    if (_rollback_len == 0){
+	if (xmldb_copy(h, "running", "candidate") < 0)
+	    goto done;
+    }
+    else {
+	/* Candidate shares the tree of the snapshot until it is modified */
+	i = id < _rollback_len ? id : _rollback_len-1;
+	xt = xmldb_snapshot_xml(_rollback_vec[i]);
+	if (xmldb_replace(h, "candidate", &xt) < 0)
+	    goto done;
+    }
+    for (i=_rollback_len; i<=id; i++){
+	if (rollback_filename(h, i, cbx) < 0)
+	    goto done;
+	if ((ret = rollback_change_apply(h, cbuf_get(cbx), cbret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto ok;
+    }
+    xmldb_modified_set(h, "candidate", 1);
+    cprintf(cbret, "<rpc-reply xmlns=\"%s\"><ok/></rpc-reply>", NETCONF_BASE_NAMESPACE);
+ ok:
+    retval = 0;
+ done:
+    if (cbx)
+	cbuf_free(cbx);
+    return retval;
+}
+
+/*! Register rollback RPC
+ * @param[in]  h     Clicon handle
+ * @retval    -1     Error (fatal)
+ * @retval     0     OK
+ * @see backend_rpc_init
+ */
+int
+backend_rollback_rpc_init(clicon_handle h)
+{
+    int retval = -1;
+
+    if (rpc_callback_register(h, from_client_rollback, NULL,
+			      CLIXON_LIB_NS, "rollback") < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
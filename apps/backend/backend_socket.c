@@ -48,6 +48,7 @@
 #include <signal.h>
 #include <fcntl.h>
 #include <time.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <grp.h>
 #include <sys/time.h>
@@ -71,10 +72,66 @@
 /* clicon */
 #include <clixon/clixon.h>
 
-#include "backend_socket.h"
 #include "backend_client.h"
+#include "backend_socket.h"
 #include "backend_handle.h"
 
+/* Statistics of accepting clients on the backend socket, see backend_accept_stats_cbuf */
+struct accept_stats{
+    uint64_t as_events;     /* Number of times the backend socket was readable */
+    uint64_t as_clients;    /* Number of accepted clients */
+    uint64_t as_batch_max;  /* Max number of clients accepted in one event */
+    uint64_t as_errors;     /* Number of failed accepts */
+    uint64_t as_total;      /* Total time accepting clients in us */
+    uint64_t as_max;        /* Max time accepting a single client in us */
+    uint64_t as_cred_total; /* Total time translating peer credentials in us */
+    uint64_t as_cred_max;   /* Max time translating credentials of a client in us */
+};
+
+static struct accept_stats accept_stats = {0,};
+
+/*! Difference in us between two monotonic times, 0 if negative
+ */
+static uint64_t
+accept_stats_us(struct timespec *t0,
+		struct timespec *t1)
+{
+    int64_t d;
+
+    d = (int64_t)(t1->tv_sec - t0->tv_sec)*1000000 + (t1->tv_nsec - t0->tv_nsec)/1000;
+    return d<0 ? 0 : (uint64_t)d;
+}
+
+/*! Listen on backend socket with backlog CLICON_SOCK_BACKLOG and make it non-blocking
+ *
+ * The socket is non-blocking so that pending clients can be accepted until none is left
+ * @param[in]  h    Clicon handle
+ * @param[in]  s    Bound socket
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see backend_accept_client
+ */
+static int
+config_socket_listen(clicon_handle h,
+		     int           s)
+{
+    int backlog;
+    int flags;
+
+    if ((backlog = clicon_option_int(h, "CLICON_SOCK_BACKLOG")) <= 0)
+	backlog = 5;
+    if (listen(s, backlog) < 0){
+	clicon_err(OE_UNIX, errno, "listen");
+	return -1;
+    }
+    if ((flags = fcntl(s, F_GETFL, 0)) < 0 ||
+	fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	return -1;
+    }
+    return 0;
+}
+
 /*! Open an INET stream socket and bind it to a file descriptor
  *
  * @param[in]  h    Clicon handle
@@ -110,10 +167,8 @@ config_socket_init_ipv4(clicon_handle h,
 	goto err;
     }
     clicon_debug(1, "Listen on server socket at %s:%hu", dst, port);
-    if (listen(s, 5) < 0){
-	clicon_err(OE_UNIX, errno, "listen");
+    if (config_socket_listen(h, s) < 0)
 	goto err;
-    }
     return s;
   err:
     close(s);
@@ -177,10 +232,8 @@ config_socket_init_unix(clicon_handle h,
 	goto err;
     }
     clicon_debug(1, "Listen on server socket at %s", addr.sun_path);
-    if (listen(s, 5) < 0){
-	clicon_err(OE_UNIX, errno, "listen");
+    if (config_socket_listen(h, s) < 0)
 	goto err;
-    }
     return s;
   err:
     close(s);
@@ -217,21 +270,30 @@ backend_socket_init(clicon_handle h)
     return -1;
 }
 
-/*! Accept new socket client
- * @param[in]  fd   Socket (unix or ip)
- * @param[in]  arg  typecast clicon_handle
+/*! Accept one pending client on the backend socket
+ *
+ * Peer credentials of a unix socket client are read here, but the translation to a
+ * user name, which may be slow eg with a remote user database, is deferred to the
+ * first request of the client, see backend_client_cred
+ * @param[in]  h    Clicon handle
+ * @param[in]  fd   Backend socket (unix or ip), non-blocking
+ * @retval     1    Client accepted
+ * @retval     0    No pending client, or client failed and was closed
+ * @retval    -1    Error
  */
-int
-backend_accept_client(int   fd,
-		      void *arg) 
+static int
+backend_accept_one(clicon_handle h,
+		   int           fd)
 {
     int                  retval = -1;
-    clicon_handle        h = (clicon_handle)arg;
-    int                  s;
+    int                  s = -1;
     struct sockaddr      from = {0,};
     socklen_t            len;
-    struct client_entry *ce;
-    char                *name = NULL;
+    struct client_entry *ce = NULL;
+    int                  flags;
+    struct timespec      t0;
+    struct timespec      t1;
+    uint64_t             us;
 #ifdef HAVE_SO_PEERCRED        /* Linux. */
     socklen_t            clen;
     struct ucred         cr = {0,};
@@ -240,10 +302,31 @@ backend_accept_client(int   fd,
     uid_t                guid;
 #endif
 
-    clicon_debug(2, "%s", __FUNCTION__);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
     len = sizeof(from);
     if ((s = accept(fd, &from, &len)) < 0){
-	clicon_err(OE_UNIX, errno, "accept");
+	switch (errno){
+	case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+	case EWOULDBLOCK:
+#endif
+	case EINTR:
+	    break;
+	case ECONNABORTED: /* Client gone before accepted */
+	    accept_stats.as_errors++;
+	    clicon_log(LOG_WARNING, "%s: accept: %s", __FUNCTION__, strerror(errno));
+	    break;
+	default:
+	    clicon_err(OE_UNIX, errno, "accept");
+	    goto done;
+	}
+	retval = 0;
+	goto done;
+    }
+    /* Client socket is blocking, it may inherit O_NONBLOCK of backend socket */
+    if ((flags = fcntl(s, F_GETFL, 0)) < 0 ||
+	fcntl(s, F_SETFL, flags & ~O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
 	goto done;
     }
     if ((ce = backend_client_add(h, &from)) == NULL)
@@ -261,24 +344,15 @@ backend_accept_client(int   fd,
 	    clicon_err(OE_UNIX, errno, "getsockopt");
 	    goto done;
 	}
-	if (uid2name(cr.uid, &name) < 0)
-	    goto done;
+	ce->ce_uid = cr.uid;
 #elif defined(HAVE_GETPEEREID)
 	if (getpeereid(s, &euid, &guid) < 0)
 	    goto done;
-	if (uid2name(euid, &name) < 0)
-	    goto done;
+	ce->ce_uid = euid;
 #else
 #error "Need getsockopt O_PEERCRED or getpeereid for unix socket peer cred"
 #endif
-	if (name != NULL){
-	    if ((ce->ce_username = name) == NULL){
-		clicon_err(OE_UNIX, errno, "strdup");
-		name = NULL;
-		goto done;
-	    }
-	    name = NULL;
-	}
+	ce->ce_cred = 1;
 	break;
     case AF_INET: 	
 	break;
@@ -286,16 +360,133 @@ backend_accept_client(int   fd,
     default:
 	break;
     }
-    ce->ce_s = s;
-
+    if (backend_client_sock_set(h, ce, s) < 0)
+	goto done;
+    s = -1; /* Closed with client */
     /*
      * Here we register callbacks for actual data socket 
      */
-    if (clixon_event_reg_fd(s, from_client, (void*)ce, "local netconf client socket") < 0)
+    if (clixon_event_reg_fd(ce->ce_s, from_client, (void*)ce, "local netconf client socket") < 0)
+	goto done;
+    ce = NULL;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    us = accept_stats_us(&t0, &t1);
+    accept_stats.as_clients++;
+    accept_stats.as_total += us;
+    if (us > accept_stats.as_max)
+	accept_stats.as_max = us;
+    retval = 1;
+ done:
+    if (ce)
+	backend_client_rm(h, ce);
+    if (s != -1)
+	close(s);
+    return retval;
+}
+
+/*! Accept new socket clients
+ *
+ * Clients pending when the backend socket is readable are accepted in one batch, but
+ * at most CLICON_SOCK_BACKLOG so that the requests of already connected clients are
+ * not starved by a connection burst.
+ * @param[in]  fd   Socket (unix or ip)
+ * @param[in]  arg  typecast clicon_handle
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_accept_client(int   fd,
+		      void *arg) 
+{
+    int           retval = -1;
+    clicon_handle h = (clicon_handle)arg;
+    int           max;
+    int           nr = 0;
+    int           ret;
+
+    clicon_debug(2, "%s", __FUNCTION__);
+    if ((max = clicon_option_int(h, "CLICON_SOCK_BACKLOG")) <= 0)
+	max = 1;
+    accept_stats.as_events++;
+    while (nr < max){
+	if ((ret = backend_accept_one(h, fd)) < 0)
+	    goto done;
+	if (ret == 0)
+	    break;
+	nr++;
+    }
+    if (nr > accept_stats.as_batch_max)
+	accept_stats.as_batch_max = nr;
+    clicon_debug(2, "%s accepted %d", __FUNCTION__, nr);
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Translate peer credentials of client to user name, if not done
+ *
+ * Called before the first request of the client is handled, see backend_accept_one
+ * @param[in]  h    Clicon handle
+ * @param[in]  ce   Client entry
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+backend_client_cred(clicon_handle        h,
+		    struct client_entry *ce)
+{
+    int             retval = -1;
+    char           *name = NULL;
+    struct timespec t0;
+    struct timespec t1;
+    uint64_t        us;
+
+    if (ce->ce_cred == 0)
+	goto ok;
+    ce->ce_cred = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (uid2name(ce->ce_uid, &name) < 0)
 	goto done;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    us = accept_stats_us(&t0, &t1);
+    accept_stats.as_cred_total += us;
+    if (us > accept_stats.as_cred_max)
+	accept_stats.as_cred_max = us;
+    if (name != NULL){
+	if (ce->ce_username)
+	    free(ce->ce_username);
+	ce->ce_username = name;
+	name = NULL;
+    }
+ ok:
     retval = 0;
  done:
     if (name)
 	free(name);
     return retval;
 }
+
+/*! Print accept statistics as XML, see stats rpc in clixon-lib.yang
+ * @param[in,out] cb  CLIgen buffer
+ * @retval        0   OK
+ * @retval       -1   Error
+ */
+int
+backend_accept_stats_cbuf(cbuf *cb)
+{
+    struct accept_stats *as = &accept_stats;
+
+    cprintf(cb, "<accept>"
+	    "<events>%" PRIu64 "</events>"
+	    "<clients>%" PRIu64 "</clients>"
+	    "<batch-max>%" PRIu64 "</batch-max>"
+	    "<errors>%" PRIu64 "</errors>"
+	    "<time-total>%" PRIu64 "</time-total>"
+	    "<time-max>%" PRIu64 "</time-max>"
+	    "<cred-total>%" PRIu64 "</cred-total>"
+	    "<cred-max>%" PRIu64 "</cred-max>"
+	    "</accept>",
+	    as->as_events, as->as_clients, as->as_batch_max, as->as_errors,
+	    as->as_total, as->as_max, as->as_cred_total, as->as_cred_max);
+    return 0;
+}
@@ -44,5 +44,7 @@
  */ 
 int backend_socket_init(clicon_handle h);
 int backend_accept_client(int fd, void *arg);
+int backend_client_cred(clicon_handle h, struct client_entry *ce);
+int backend_accept_stats_cbuf(cbuf *cb);
 
 #endif  /* _BACKEND_SOCKET_H_ */
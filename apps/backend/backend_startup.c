@@ -40,6 +40,8 @@
 #endif
 
 #include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -47,6 +49,7 @@
 #include <errno.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <dirent.h>
 #include <time.h>
 #include <pwd.h>
 #include <syslog.h>
@@ -71,6 +74,9 @@
 #include "backend_commit.h"
 #include "backend_startup.h"
 
+/* Warm restart stamp file in CLICON_XMLDB_DIR, see startup_warm */
+#define STARTUP_WARM_FILE "startup_warm"
+
 /*! Merge db1 into db2 without commit 
  * @retval   -1       Error
  * @retval    0       Validation failed (with cbret set)
@@ -284,7 +290,8 @@ startup_extraxml(clicon_handle        h,
  done:
     if (xt0)
 	xml_free(xt0);
-    xmldb_get0_free(h, &xt);
+    if (xt)
+	xml_free(xt);
     if (xmldb_delete(h, tmp_db) != 0 && errno != ENOENT) 
 	return -1;
     return retval;
@@ -375,3 +382,305 @@ startup_module_state(clicon_handle h,
     retval = 0;
     goto done;
 }
+
+/*! Add hash of a file to a warm restart stamp
+ * @param[in]  cb    Stamp
+ * @param[in]  tag   Name of file in stamp
+ * @param[in]  file  Filename, or NULL. A missing file is hashed as empty
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see startup_warm_stamp
+ */
+static int
+startup_warm_file(cbuf       *cb,
+		  const char *tag,
+		  const char *file)
+{
+    int           retval = -1;
+    FILE         *f = NULL;
+    unsigned char buf[8192];
+    size_t        len;
+    size_t        i;
+    uint64_t      hash = 14695981039346656037ULL; /* FNV-1a */
+
+    if (file && (f = fopen(file, "r")) == NULL && errno != ENOENT){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", file);
+	goto done;
+    }
+    if (f){
+	while ((len = fread(buf, 1, sizeof(buf), f)) > 0)
+	    for (i=0; i<len; i++){
+		hash ^= buf[i];
+		hash *= 1099511628211ULL;
+	    }
+	if (ferror(f)){
+	    clicon_err(OE_UNIX, errno, "fread(%s)", file);
+	    goto done;
+	}
+    }
+    cprintf(cb, "%s %016" PRIx64 "\n", tag, hash);
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    return retval;
+}
+
+/*! Add hash of a datastore and its journal to a warm restart stamp
+ * @param[in]  h     Clixon handle
+ * @param[in]  cb    Stamp
+ * @param[in]  db    Name of datastore
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+startup_warm_db(clicon_handle h,
+		cbuf         *cb,
+		char         *db)
+{
+    int            retval = -1;
+    char          *file = NULL;
+    char          *journal = NULL;
+    char          *dir = NULL;
+    cbuf          *cbf = NULL;
+    struct dirent *dp = NULL;
+    struct stat    st;
+    int            ndp;
+    int            i;
+
+    if (xmldb_db2file(h, db, &file) < 0)
+	goto done;
+    if (xmldb_db2journal(h, db, &journal) < 0)
+	goto done;
+    if (startup_warm_file(cb, db, file) < 0)
+	goto done;
+    if (startup_warm_file(cb, "journal", journal) < 0)
+	goto done;
+    /* Shard files, see CLICON_XMLDB_SHARD */
+    if (xmldb_db2shards(h, db, &dir) < 0)
+	goto done;
+    if (stat(dir, &st) == 0){
+	if ((cbf = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if ((ndp = clicon_file_dirent(dir, &dp, "\\.xml$", S_IFREG)) < 0)
+	    goto done;
+	for (i = 0; i < ndp; i++){
+	    cbuf_reset(cbf);
+	    cprintf(cbf, "%s/%s", dir, dp[i].d_name);
+	    if (startup_warm_file(cb, dp[i].d_name, cbuf_get(cbf)) < 0)
+		goto done;
+	}
+    }
+    retval = 0;
+ done:
+    if (dp)
+	free(dp);
+    if (cbf)
+	cbuf_free(cbf);
+    if (dir)
+	free(dir);
+    if (file)
+	free(file);
+    if (journal)
+	free(journal);
+    return retval;
+}
+
+/*! Create warm restart stamp: what the running datastore was validated and committed from
+ *
+ * Content hashes of the startup and running datastores, extra XML file and config file,
+ * and the yang modules and plugins loaded.
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Startup datastore, eg "startup", or "running" in running startup mode
+ * @param[in]  file    Extra XML file, or NULL
+ * @param[in]  cb      Stamp
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+startup_warm_stamp(clicon_handle h,
+		   char         *db,
+		   char         *file,
+		   cbuf         *cb)
+{
+    int            retval = -1;
+    yang_stmt     *yspec;
+    yang_stmt     *ymod = NULL;
+    yang_stmt     *yrev;
+    clixon_plugin *cp = NULL;
+    struct stat    st;
+
+    if (strcmp(db, "running") != 0 &&
+	startup_warm_db(h, cb, db) < 0)
+	goto done;
+    if (startup_warm_db(h, cb, "running") < 0)
+	goto done;
+    if (startup_warm_file(cb, "extraxml", file) < 0)
+	goto done;
+    if (startup_warm_file(cb, "config", clicon_configfile(h)) < 0)
+	goto done;
+    if ((yspec = clicon_dbspec_yang(h)) != NULL)
+	while ((ymod = yn_each(yspec, ymod)) != NULL) {
+	    yrev = yang_find(ymod, Y_REVISION, NULL);
+	    cprintf(cb, "module %s %s\n", yang_argument_get(ymod),
+		    yrev?yang_argument_get(yrev):"-");
+	}
+    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+	memset(&st, 0, sizeof(st));
+	if (stat(cp->cp_name, &st) < 0 && errno != ENOENT){ /* Pseudo plugins have no file */
+	    clicon_err(OE_UNIX, errno, "stat(%s)", cp->cp_name);
+	    goto done;
+	}
+	cprintf(cb, "plugin %s %lld %lld\n", cp->cp_name,
+		(long long)st.st_mtime, (long long)st.st_size);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get filename of warm restart stamp
+ * @param[in]  h    Clixon handle
+ * @param[out] cb   Filename
+ */
+static int
+startup_warm_filename(clicon_handle h,
+		      cbuf         *cb)
+{
+    char *dir;
+
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+	clicon_err(OE_XML, errno, "dbdir not set");
+	return -1;
+    }
+    cprintf(cb, "%s/%s", dir, STARTUP_WARM_FILE);
+    return 0;
+}
+
+/*! Warm restart: keep running if it is unchanged since it was committed from startup
+ *
+ * If CLICON_STARTUP_WARM is set and the warm restart stamp saved at the last start
+ * equals the current stamp, running is kept as is: it is not validated again and the
+ * transaction callbacks of plugins are not called. Instead the resync callback of each
+ * plugin is called to bring the system in line with running.
+ * A plugin with a commit callback but no resync callback prevents warm restart.
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Startup datastore, eg "startup", or "running" in running startup mode
+ * @param[in]  file    Extra XML file, or NULL
+ * @retval     1       Warm restart made
+ * @retval     0       Not possible, make a full startup
+ * @retval    -1       Error
+ * @see startup_warm_save
+ */
+int
+startup_warm(clicon_handle h,
+	     char         *db,
+	     char         *file)
+{
+    int            retval = -1;
+    cbuf          *cbf = NULL;
+    cbuf          *cb = NULL;
+    FILE          *f = NULL;
+    char          *buf = NULL;
+    size_t         len;
+    clixon_plugin *cp = NULL;
+    
+    if (!clicon_option_bool(h, "CLICON_STARTUP_WARM"))
+	goto cold;
+    if (xmldb_exists(h, "running") != 1)
+	goto cold;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	if (cp->cp_api.ca_trans_commit != NULL && cp->cp_api.ca_resync == NULL){
+	    clicon_debug(1, "%s: plugin %s has no resync callback", __FUNCTION__, cp->cp_name);
+	    goto cold;
+	}
+    if ((cbf = cbuf_new()) == NULL ||
+	(cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (startup_warm_filename(h, cbf) < 0)
+	goto done;
+    if ((f = fopen(cbuf_get(cbf), "r")) == NULL)
+	goto cold;
+    if (startup_warm_stamp(h, db, file, cb) < 0)
+	goto done;
+    len = cbuf_len(cb);
+    if ((buf = malloc(len + 1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    if (fread(buf, 1, len + 1, f) != len ||
+	memcmp(buf, cbuf_get(cb), len) != 0){
+	clicon_debug(1, "%s: %s changed", __FUNCTION__, cbuf_get(cbf));
+	goto cold;
+    }
+    clicon_log(LOG_NOTICE, "%s: running unchanged since last startup, warm restart", __FUNCTION__);
+    if (clixon_plugin_resync_all(h, "running") < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (buf)
+	free(buf);
+    if (f)
+	fclose(f);
+    if (cbf)
+	cbuf_free(cbf);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ cold:
+    retval = 0;
+    goto done;
+}
+
+/*! Save warm restart stamp after running has been committed from startup
+ * @param[in]  h       Clixon handle
+ * @param[in]  db      Startup datastore, eg "startup", or "running" in running startup mode
+ * @param[in]  file    Extra XML file, or NULL
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see startup_warm
+ */
+int
+startup_warm_save(clicon_handle h,
+		  char         *db,
+		  char         *file)
+{
+    int   retval = -1;
+    cbuf *cbf = NULL;
+    cbuf *cb = NULL;
+    FILE *f = NULL;
+
+    if (!clicon_option_bool(h, "CLICON_STARTUP_WARM"))
+	goto ok;
+    if ((cbf = cbuf_new()) == NULL ||
+	(cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (startup_warm_filename(h, cbf) < 0)
+	goto done;
+    if (startup_warm_stamp(h, db, file, cb) < 0)
+	goto done;
+    if ((f = fopen(cbuf_get(cbf), "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cbf));
+	goto done;
+    }
+    if (fwrite(cbuf_get(cb), 1, cbuf_len(cb), f) != cbuf_len(cb)){
+	clicon_err(OE_UNIX, errno, "fwrite(%s)", cbuf_get(cbf));
+	goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (cbf)
+	cbuf_free(cbf);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
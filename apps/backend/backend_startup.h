@@ -46,5 +46,7 @@ int startup_mode_startup(clicon_handle h, char *db, cbuf *cbret);
 int startup_extraxml(clicon_handle h, char *file, cbuf *cbret);
 int startup_failsafe(clicon_handle h);
 int startup_module_state(clicon_handle h, yang_stmt *yspec);
+int startup_warm(clicon_handle h, char *db, char *file);
+int startup_warm_save(clicon_handle h, char *db, char *file);
 
 #endif  /* _BACKEND_STARTUP_H_ */
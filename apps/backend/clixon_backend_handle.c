@@ -43,6 +43,7 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include <inttypes.h>
 #include <dirent.h>
 #include <errno.h>
@@ -50,6 +51,7 @@
 #include <assert.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <time.h>
 #include <regex.h>
 #include <syslog.h>
 #include <netinet/in.h>
@@ -89,10 +91,37 @@ struct backend_handle {
     clicon_hash_t           *bh_data;      /* internal clicon data (HDR) */
     clicon_hash_t           *ch_db_elmnt;  /* xml datastore element cache data */
     event_stream_t          *bh_stream;    /* notification streams, see clixon_stream.[ch] */
+    struct clicon_optv      *bh_optv;      /* typed options (HDR) */
     
     /* ------ end of common handle ------ */
     struct client_entry     *bh_ce_list;   /* The client list */
     int                      bh_ce_nr;     /* Number of clients, just increment */
+    clicon_hash_t           *bh_ce_byid;   /* Clients indexed by session id */
+    clicon_hash_t           *bh_ce_bysock; /* Clients indexed by socket */
+    struct statedata_callback *bh_sc_list; /* Statedata callbacks */
+    clicon_hash_t           *bh_sd_cache;  /* Cached state data, see statedata_cache_get */
+    clicon_hash_t           *bh_sd_ttl;    /* Cache time of state data per provider */
+};
+
+/* Cached state data of one provider and request, see statedata_cache_get
+ * Key is provider, xpath and namespace context of request, see statedata_cache_key
+ */
+struct statedata_cache {
+    struct timespec      sdc_expire;   /* Monotonic time when entry expires */
+    cxobj               *sdc_xml;      /* State tree returned by provider */
+};
+
+/* Statedata callback registered on a YANG data node path
+ * @see statedata_callback_register
+ */
+struct statedata_callback {
+    qelem_t              sc_qelem;     /* List header */
+    clicon_statedata_cb  sc_callback;  /* Statedata callback */
+    void                *sc_arg;       /* Application specific argument to cb */
+    char                *sc_namespace; /* Namespace of top-level node of path */
+    char                *sc_path;      /* Registered path, eg /a/b */
+    char               **sc_vec;       /* Path split in node names */
+    int                  sc_len;       /* Length of sc_vec */
 };
 
 /*! Creates and returns a clicon config handle for other CLICON API calls
@@ -110,16 +139,27 @@ backend_handle_init(void)
 int
 backend_handle_exit(clicon_handle h)
 {
+    struct backend_handle *bh = handle(h);
     struct client_entry   *ce;
 
     /* only delete client structs, not close sockets, etc, see backend_client_rm WHY NOT? */
     while ((ce = backend_client_list(h)) != NULL){
 	if (ce->ce_s){
 	    close(ce->ce_s);
-	    ce->ce_s = 0;
+	    backend_client_sock_set(h, ce, 0);
 	}
 	backend_client_delete(h, ce);
     }
+    if (bh->bh_ce_byid)
+	clicon_hash_free(bh->bh_ce_byid);
+    if (bh->bh_ce_bysock)
+	clicon_hash_free(bh->bh_ce_bysock);
+    statedata_callback_delete_all(h);
+    statedata_cache_invalidate(h, NULL);
+    if (bh->bh_sd_cache)
+	clicon_hash_free(bh->bh_sd_cache);
+    if (bh->bh_sd_ttl)
+	clicon_hash_free(bh->bh_sd_ttl);
     clicon_handle_exit(h); /* frees h and options (and streams) */
     return 0;
 }
@@ -144,7 +184,8 @@ backend_client_add(clicon_handle    h,
     memset(ce, 0, sizeof(*ce));
     ce->ce_nr = bh->bh_ce_nr++; /* Session-id ? */
     memcpy(&ce->ce_addr, addr, sizeof(*addr));
-    ce->ce_next = bh->bh_ce_list;
+    if ((ce->ce_next = bh->bh_ce_list) != NULL)
+	ce->ce_next->ce_prev = ce;
     bh->bh_ce_list = ce;
     return ce;
 }
@@ -161,30 +202,179 @@ backend_client_list(clicon_handle h)
     return bh->bh_ce_list;
 }
 
+/*! Get key of a client index
+ * @param[in]  key  Key buffer
+ * @param[in]  len  Length of key buffer
+ * @param[in]  n    Session id or socket
+ */
+static char *
+client_index_key(char    *key,
+		 size_t   len,
+		 uint32_t n)
+{
+    snprintf(key, len, "%u", n);
+    return key;
+}
+
+/*! Find client in index
+ * @param[in]  hash  Index, by session id or by socket
+ * @param[in]  n     Session id or socket
+ * @retval     ce    Client entry
+ * @retval     NULL  Not found
+ */
+static struct client_entry *
+client_index_get(clicon_hash_t *hash,
+		 uint32_t       n)
+{
+    char  key[16];
+    void *p;
+
+    if (hash == NULL ||
+	(p = clicon_hash_value(hash, client_index_key(key, sizeof(key), n), NULL)) == NULL)
+	return NULL;
+    return *(struct client_entry **)p;
+}
+
+/*! Add client to index, replacing any entry of the same key
+ * @param[in,out] hashp  Index, created if NULL
+ * @param[in]     n      Session id or socket
+ * @param[in]     ce     Client entry
+ * @retval        0      OK
+ * @retval       -1      Error
+ */
+static int
+client_index_add(clicon_hash_t      **hashp,
+		 uint32_t             n,
+		 struct client_entry *ce)
+{
+    char key[16];
+
+    if (*hashp == NULL && (*hashp = clicon_hash_init()) == NULL)
+	return -1;
+    if (clicon_hash_add(*hashp, client_index_key(key, sizeof(key), n), &ce, sizeof(ce)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Remove client from index, if it is the entry of the key
+ * @param[in]  hash  Index
+ * @param[in]  n     Session id or socket
+ * @param[in]  ce    Client entry
+ */
+static void
+client_index_del(clicon_hash_t       *hash,
+		 uint32_t             n,
+		 struct client_entry *ce)
+{
+    char key[16];
+
+    if (client_index_get(hash, n) == ce)
+	clicon_hash_del(hash, client_index_key(key, sizeof(key), n));
+}
+
+/*! Set session id of client and index client by it
+ * @param[in]  h   Clicon handle
+ * @param[in]  ce  Client entry
+ * @param[in]  id  Session id
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+backend_client_id_set(clicon_handle        h,
+		      struct client_entry *ce,
+		      uint32_t             id)
+{
+    struct backend_handle *bh = handle(h);
+
+    if (ce->ce_id == id && client_index_get(bh->bh_ce_byid, id) == ce)
+	return 0;
+    if (ce->ce_id)
+	client_index_del(bh->bh_ce_byid, ce->ce_id, ce);
+    ce->ce_id = id;
+    if (id && client_index_add(&bh->bh_ce_byid, id, ce) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Set socket of client and index client by it, 0 closes
+ * @param[in]  h   Clicon handle
+ * @param[in]  ce  Client entry
+ * @param[in]  s   Socket, or 0 if closed
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+backend_client_sock_set(clicon_handle        h,
+			struct client_entry *ce,
+			int                  s)
+{
+    struct backend_handle *bh = handle(h);
+
+    if (ce->ce_s)
+	client_index_del(bh->bh_ce_bysock, ce->ce_s, ce);
+    ce->ce_s = s;
+    if (s && client_index_add(&bh->bh_ce_bysock, s, ce) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Find client by session id
+ * @param[in]  h    Clicon handle
+ * @param[in]  id   Session id
+ * @retval     ce   Client entry
+ * @retval     NULL Not found
+ */
+struct client_entry *
+backend_client_find_id(clicon_handle h,
+		       uint32_t      id)
+{
+    struct backend_handle *bh = handle(h);
+
+    return client_index_get(bh->bh_ce_byid, id);
+}
+
+/*! Find client by socket
+ * @param[in]  h    Clicon handle
+ * @param[in]  s    Socket
+ * @retval     ce   Client entry
+ * @retval     NULL Not found
+ */
+struct client_entry *
+backend_client_find_sock(clicon_handle h,
+			 int           s)
+{
+    struct backend_handle *bh = handle(h);
+
+    return client_index_get(bh->bh_ce_bysock, s);
+}
+
 /*! Actually remove client from client list
  * @param[in]  h   Clicon handle
- * @param[in]  ce  Client handle
+ * @param[in]  ce  Client handle, in client list
  * @see backend_client_rm which is more high-level
  */
 int
 backend_client_delete(clicon_handle        h,
 		      struct client_entry *ce)
 {
-    struct client_entry   *c;
-    struct client_entry  **ce_prev;
     struct backend_handle *bh = handle(h);
 
-    ce_prev = &bh->bh_ce_list;
-    for (c = *ce_prev; c; c = c->ce_next){
-	if (c == ce){
-	    *ce_prev = c->ce_next;
-	    if (ce->ce_username)
-		free(ce->ce_username);
-	    free(ce);
-	    break;
-	}
-	ce_prev = &c->ce_next;
-    }
+    if (ce->ce_prev)
+	ce->ce_prev->ce_next = ce->ce_next;
+    else
+	bh->bh_ce_list = ce->ce_next;
+    if (ce->ce_next)
+	ce->ce_next->ce_prev = ce->ce_prev;
+    if (ce->ce_id)
+	client_index_del(bh->bh_ce_byid, ce->ce_id, ce);
+    if (ce->ce_s)
+	client_index_del(bh->bh_ce_bysock, ce->ce_s, ce);
+    if (ce->ce_username)
+	free(ce->ce_username);
+    if (ce->ce_rbuf)
+	clicon_msg_rbuf_free(ce->ce_rbuf);
+    backend_client_notify_free(ce);
+    free(ce);
     return 0;
 }
 
@@ -206,7 +396,658 @@ backend_client_print(clicon_handle h,
 	fprintf(f, "  Msgs in:  %d\n", ce->ce_stat_in);
 	fprintf(f, "  Msgs out: %d\n", ce->ce_stat_out);
 	fprintf(f, "  Username: %s\n", ce->ce_username);
+	fprintf(f, "  Notify sent:    %" PRIu64 "\n", ce->ce_notify_sent);
+	fprintf(f, "  Notify dropped: %" PRIu64 "\n", ce->ce_notify_dropped);
+	fprintf(f, "  Notify queued:  %d (max %d)\n", ce->ce_notify_len, ce->ce_notify_max);
+    }
+    return 0;
+}
+
+
+/*! Free a statedata callback
+ */
+static void
+statedata_callback_free(struct statedata_callback *sc)
+{
+    int i;
+
+    if (sc->sc_namespace)
+	free(sc->sc_namespace);
+    if (sc->sc_path)
+	free(sc->sc_path);
+    if (sc->sc_vec){
+	for (i=0; i<sc->sc_len; i++)
+	    free(sc->sc_vec[i]);
+	free(sc->sc_vec);
+    }
+    free(sc);
+}
+
+/*! Find end of xpath predicate, ie matching ']', skipping quoted strings
+ * @param[in]  p    Pointer to '['
+ * @retval     end  Pointer to matching ']'
+ * @retval     NULL Not found
+ */
+static char *
+statedata_predicate_end(char *p)
+{
+    char q = 0;
+
+    for (p++; *p; p++){
+	if (q){
+	    if (*p == q)
+		q = 0;
+	}
+	else if (*p == '\'' || *p == '"')
+	    q = *p;
+	else if (*p == ']')
+	    return p;
+    }
+    return NULL;
+}
+
+/*! Parse a key predicate on the form [k='v'] or [pfx:k="v"] and add it to keys
+ * Other predicates, eg positions, are ignored
+ * @param[in]  s     First char after '['
+ * @param[in]  end   Pointer to ']'
+ * @param[in]  keys  Keys vector, add name and value
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+statedata_predicate_key(char *s,
+			char *end,
+			cvec *keys)
+{
+    char *n0;
+    char *n1;
+    char *v0;
+    char *v1;
+    char *c;
+    char  q;
+    char *name = NULL;
+    char *value = NULL;
+    int   retval = -1;
+
+    while (s < end && isspace(*s)) s++;
+    n0 = s;
+    while (s < end && (isalnum(*s) || *s=='_' || *s=='-' || *s=='.' || *s==':')) s++;
+    n1 = s;
+    while (s < end && isspace(*s)) s++;
+    if (n0 == n1 || s == end || *s != '=')
+	goto ok;
+    s++;
+    while (s < end && isspace(*s)) s++;
+    if (s == end || (*s != '\'' && *s != '"'))
+	goto ok;
+    q = *s++;
+    v0 = s;
+    while (s < end && *s != q) s++;
+    if (s == end)
+	goto ok;
+    v1 = s++;
+    while (s < end && isspace(*s)) s++;
+    if (s != end)
+	goto ok;
+    /* Strip prefix */
+    for (c = n0; c < n1; c++)
+	if (*c == ':')
+	    n0 = c+1;
+    if ((name = strndup(n0, n1-n0)) == NULL ||
+	(value = strndup(v0, v1-v0)) == NULL){
+	clicon_err(OE_UNIX, errno, "strndup");
+	goto done;
+    }
+    if (cvec_add_string(keys, name, value) < 0){
+	clicon_err(OE_UNIX, errno, "cvec_add_string");
+	goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (name)
+	free(name);
+    if (value)
+	free(value);
+    return retval;
+}
+
+/*! Match requested xpath with registered statedata path
+ *
+ * Only absolute location paths of child steps are analyzed, eg /a/b[k='v']/c. The
+ * requested xpath matches if the steps are equal along the shortest of the two paths,
+ * ie the requested subtree and the registered subtree intersect.
+ * Other xpaths, eg with // or unions, match all registered paths.
+ * Key predicates on the form [k='v'] on steps of the registered path are added to keys.
+ * @param[in]  sc     Statedata callback
+ * @param[in]  nsc    Namespace context of xpath
+ * @param[in]  xpath  Requested xpath, NULL means all
+ * @param[out] keys   Key predicates along registered path (if match)
+ * @retval     1      Match
+ * @retval     0      No match
+ * @retval    -1      Error
+ */
+static int
+statedata_path_match(struct statedata_callback *sc,
+		     cvec                      *nsc,
+		     char                      *xpath,
+		     cvec                      *keys)
+{
+    char  *p;
+    char  *s;
+    char  *end;
+    char  *c;
+    char  *prefix = NULL;
+    char  *ns;
+    size_t plen;
+    size_t nlen;
+    int    i = 0;
+    int    retval = -1;
+
+    if (xpath == NULL)
+	goto match;
+    p = xpath;
+    while (isspace(*p)) p++;
+    /* Only simple absolute paths */
+    if (*p != '/' ||
+	strstr(p, "//") || strchr(p, '|') || strstr(p, "::") || strstr(p, ".."))
+	goto match;
+    while (*p == '/' && i < sc->sc_len){
+	s = ++p;
+	while (*p && *p != '/' && *p != '[' && !isspace(*p))
+	    p++;
+	if (p == s) /* Eg "/" */
+	    goto match;
+	plen = 0;
+	for (c = s; c < p; c++)
+	    if (*c == ':')
+		plen = c - s;
+	if (strncmp(s, "*", p-s) == 0 || memchr(s, '(', p-s) != NULL)
+	    goto match;
+	nlen = (p - s) - (plen ? plen+1 : 0);
+	if (strlen(sc->sc_vec[i]) != nlen ||
+	    strncmp(sc->sc_vec[i], s + (plen ? plen+1 : 0), nlen) != 0)
+	    goto nomatch;
+	if (i == 0){ /* Top-level namespace */
+	    if (plen){
+		if ((prefix = strndup(s, plen)) == NULL){
+		    clicon_err(OE_UNIX, errno, "strndup");
+		    goto done;
+		}
+	    }
+	    if ((ns = xml_nsctx_get(nsc, prefix)) != NULL &&
+		strcmp(ns, sc->sc_namespace) != 0)
+		goto nomatch;
+	}
+	while (*p == '['){
+	    if ((end = statedata_predicate_end(p)) == NULL)
+		goto match;
+	    if (statedata_predicate_key(p+1, end, keys) < 0)
+		goto done;
+	    p = end + 1;
+	}
+	while (isspace(*p)) p++;
+	if (*p != '/' && *p != '\0')
+	    goto match;
+	i++;
+    }
+ match:
+    retval = 1;
+ done:
+    if (prefix)
+	free(prefix);
+    return retval;
+ nomatch:
+    retval = 0;
+    goto done;
+}
+
+/*! Register a statedata callback for a YANG data node
+ *
+ * The callback is only called if a requested xpath intersects with the registered
+ * path, and list keys of the request along the path are given to the callback, which
+ * need only produce state of those list entries.
+ * @param[in]  h      Clicon handle
+ * @param[in]  cb     Callback called
+ * @param[in]  arg    Domain-specific argument to send to callback 
+ * @param[in]  ns     Namespace of (top-level node of) path
+ * @param[in]  path   Schema node path without prefixes, eg /interfaces-state/interface
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *    if (statedata_callback_register(h, interfaces_state, NULL, 
+ *              "urn:ietf:params:xml:ns:yang:ietf-interfaces", "/interfaces-state/interface") < 0)
+ *	  goto done;
+ * @endcode
+ * @see clicon_statedata_cb
+ */
+int
+statedata_callback_register(clicon_handle       h,
+			    clicon_statedata_cb cb,
+			    void               *arg,
+			    const char         *ns,
+			    const char         *path)
+{
+    struct backend_handle     *bh = handle(h);
+    struct statedata_callback *sc = NULL;
+    char                     **vec = NULL;
+    int                        nvec;
+    int                        i;
+
+    if (ns == NULL || path == NULL || *path != '/'){
+	clicon_err(OE_PLUGIN, EINVAL, "namespace NULL or path not absolute");
+	goto done;
+    }
+    if ((sc = malloc(sizeof(*sc))) == NULL){
+	clicon_err(OE_PLUGIN, errno, "malloc");
+	goto done;
+    }
+    memset(sc, 0, sizeof(*sc));
+    sc->sc_callback = cb;
+    sc->sc_arg = arg;
+    if ((sc->sc_namespace = strdup(ns)) == NULL ||
+	(sc->sc_path = strdup(path)) == NULL){
+	clicon_err(OE_PLUGIN, errno, "strdup");
+	goto done;
+    }
+    if ((vec = clicon_strsep((char*)path, "/", &nvec)) == NULL)
+	goto done;
+    if ((sc->sc_vec = calloc(nvec, sizeof(char*))) == NULL){
+	clicon_err(OE_PLUGIN, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<nvec; i++){
+	if (strlen(vec[i]) == 0)
+	    continue;
+	if ((sc->sc_vec[sc->sc_len++] = strdup(vec[i])) == NULL){
+	    clicon_err(OE_PLUGIN, errno, "strdup");
+	    goto done;
+	}
+    }
+    ADDQ(sc, bh->bh_sc_list);
+    sc = NULL;
+ done:
+    if (vec)
+	free(vec);
+    if (sc){
+	statedata_callback_free(sc);
+	return -1;
     }
     return 0;
 }
 
+/*! Delete all statedata callbacks
+ * @param[in]  h      Clicon handle
+ */
+int
+statedata_callback_delete_all(clicon_handle h)
+{
+    struct backend_handle     *bh = handle(h);
+    struct statedata_callback *sc;
+
+    while ((sc = bh->bh_sc_list) != NULL) {
+	DELQ(sc, bh->bh_sc_list, struct statedata_callback *);
+	statedata_callback_free(sc);
+    }
+    return 0;
+}
+
+/*! Iterate through statedata callbacks
+ * @param[in]  h      Clicon handle
+ * @param[in]  sc     Previous callback, or NULL for first
+ * @retval     sc     Next statedata callback
+ * @retval     NULL   No more
+ */
+struct statedata_callback *
+statedata_callback_each(clicon_handle              h,
+			struct statedata_callback *sc)
+{
+    struct backend_handle *bh = handle(h);
+
+    if (sc == NULL)
+	return bh->bh_sc_list;
+    sc = NEXTQ(struct statedata_callback *, sc);
+    return sc == bh->bh_sc_list ? NULL : sc;
+}
+
+/*! Return registered path of statedata callback
+ */
+char *
+statedata_callback_path(struct statedata_callback *sc)
+{
+    return sc->sc_path;
+}
+
+/*! Call statedata callback if the requested xpath intersects its registered path
+ * @param[in]  h      Clicon handle
+ * @param[in]  sc     Statedata callback
+ * @param[in]  nsc    XPATH namespace context of request
+ * @param[in]  xpath  Requested XPath, or NULL for all
+ * @param[in]  xtop   XML tree where statedata is added
+ * @retval     1      OK, callback called or path does not intersect
+ * @retval     0      Callback failed, clicon_err called
+ * @retval    -1      Error
+ * @note If state of the callback is cached, the cached state is added instead of calling
+ *       the callback, see statedata_cache_ttl_set
+ */
+int
+statedata_callback_call(clicon_handle              h,
+			struct statedata_callback *sc,
+			cvec                      *nsc,
+			char                      *xpath,
+			cxobj                     *xtop)
+{
+    int    retval = -1;
+    cvec  *keys = NULL;
+    int    ret;
+    cxobj *xc = NULL;
+    cxobj *x;
+
+    if ((keys = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if ((ret = statedata_path_match(sc, nsc, xpath, keys)) < 0)
+	goto done;
+    if (ret == 1){
+	if ((ret = statedata_cache_get(h, sc->sc_path, nsc, xpath, &xc)) < 0)
+	    goto done;
+	if (ret == 1){
+	    while ((x = xml_child_i(xc, 0)) != NULL)
+		if (xml_addsub(xtop, x) < 0)
+		    goto done;
+	    goto ok;
+	}
+	clicon_debug(1, "%s %s", __FUNCTION__, sc->sc_path);
+	if (sc->sc_callback(h, nsc, xpath, cvec_len(keys)?keys:NULL, xtop, sc->sc_arg) < 0){
+	    retval = 0; /* Dont quit here on user callbacks */
+	    goto done;
+	}
+	if (statedata_cache_put(h, sc->sc_path, nsc, xpath, xtop) < 0)
+	    goto done;
+    }
+ ok:
+    retval = 1;
+ done:
+    if (xc)
+	xml_free(xc);
+    if (keys)
+	cvec_free(keys);
+    return retval;
+}
+
+/*! Set time state data of a provider is cached
+ *
+ * State data of a provider is kept for this time and returned on requests with the
+ * same xpath and namespace context instead of calling the provider again, so that
+ * bursts of get requests poll the source of state data at a bounded rate.
+ * Overrides CLICON_BACKEND_STATEDATA_CACHE for this provider.
+ * @param[in]  h         Clicon handle
+ * @param[in]  provider  Name of backend plugin (ca_statedata) or registered path of 
+ *                       statedata_callback_register
+ * @param[in]  ttl       Time in ms, 0 means no caching
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @code
+ *    if (statedata_cache_ttl_set(h, "/interfaces-state/interface", 1000) < 0)
+ *	  goto done;
+ * @endcode
+ * @see statedata_cache_invalidate
+ */
+int
+statedata_cache_ttl_set(clicon_handle h,
+			const char   *provider,
+			uint32_t      ttl)
+{
+    struct backend_handle *bh = handle(h);
+
+    if (provider == NULL){
+	clicon_err(OE_PLUGIN, EINVAL, "provider is NULL");
+	return -1;
+    }
+    if (bh->bh_sd_ttl == NULL &&
+	(bh->bh_sd_ttl = clicon_hash_init()) == NULL)
+	return -1;
+    if (clicon_hash_add(bh->bh_sd_ttl, provider, &ttl, sizeof(ttl)) == NULL)
+	return -1;
+    return statedata_cache_invalidate(h, provider);
+}
+
+/*! Remove cached state data of a provider
+ *
+ * Called by plugins when the state of a provider is known to have changed
+ * @param[in]  h         Clicon handle
+ * @param[in]  provider  Name of backend plugin or registered path, or NULL for all
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see statedata_cache_ttl_set
+ */
+int
+statedata_cache_invalidate(clicon_handle h,
+			   const char   *provider)
+{
+    struct backend_handle  *bh = handle(h);
+    struct statedata_cache *sdc;
+    char                  **keys = NULL;
+    size_t                  klen = 0;
+    size_t                  len = 0;
+    int                     i;
+
+    if (bh->bh_sd_cache == NULL)
+	return 0;
+    if (clicon_hash_keys(bh->bh_sd_cache, &keys, &klen) < 0)
+	return -1;
+    if (provider)
+	len = strlen(provider);
+    for (i=0; i<klen; i++){
+	/* Key starts with provider and newline, see statedata_cache_key */
+	if (provider &&
+	    (strncmp(keys[i], provider, len) != 0 || keys[i][len] != '\n'))
+	    continue;
+	if ((sdc = clicon_hash_value(bh->bh_sd_cache, keys[i], NULL)) != NULL &&
+	    sdc->sdc_xml)
+	    xml_free(sdc->sdc_xml);
+	clicon_hash_del(bh->bh_sd_cache, keys[i]);
+    }
+    if (keys)
+	free(keys);
+    return 0;
+}
+
+/*! Get cache time of state data of a provider
+ * @param[in]  h         Clicon handle
+ * @param[in]  provider  Name of backend plugin or registered path
+ * @retval     ttl       Time in ms, 0 if not cached
+ */
+static uint32_t
+statedata_cache_ttl(clicon_handle h,
+		    const char   *provider)
+{
+    struct backend_handle *bh = handle(h);
+    uint32_t              *ttl;
+
+    if (bh->bh_sd_ttl &&
+	(ttl = clicon_hash_value(bh->bh_sd_ttl, provider, NULL)) != NULL)
+	return *ttl;
+    return clicon_option_int(h, "CLICON_BACKEND_STATEDATA_CACHE");
+}
+
+/*! Check if cached state data has expired
+ * @param[in]  sdc  Cached state data
+ * @param[in]  now  Current monotonic time
+ * @retval     1    Expired
+ * @retval     0    Not expired
+ */
+static int
+statedata_cache_expired(struct statedata_cache *sdc,
+			struct timespec        *now)
+{
+    return now->tv_sec > sdc->sdc_expire.tv_sec ||
+	(now->tv_sec == sdc->sdc_expire.tv_sec && now->tv_nsec >= sdc->sdc_expire.tv_nsec);
+}
+
+/*! Remove all expired cached state data
+ * Entries of requests that are not repeated are otherwise never removed
+ * @param[in]  h    Clicon handle
+ * @param[in]  now  Current monotonic time
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+statedata_cache_expire(clicon_handle    h,
+		       struct timespec *now)
+{
+    struct backend_handle  *bh = handle(h);
+    struct statedata_cache *sdc;
+    char                  **keys = NULL;
+    size_t                  klen = 0;
+    int                     i;
+
+    if (clicon_hash_keys(bh->bh_sd_cache, &keys, &klen) < 0)
+	return -1;
+    for (i=0; i<klen; i++){
+	if ((sdc = clicon_hash_value(bh->bh_sd_cache, keys[i], NULL)) == NULL ||
+	    !statedata_cache_expired(sdc, now))
+	    continue;
+	if (sdc->sdc_xml)
+	    xml_free(sdc->sdc_xml);
+	clicon_hash_del(bh->bh_sd_cache, keys[i]);
+    }
+    if (keys)
+	free(keys);
+    return 0;
+}
+
+/*! Make cache key of provider and request
+ * @param[in]  provider  Name of backend plugin or registered path
+ * @param[in]  nsc       XPATH namespace context of request
+ * @param[in]  xpath     Requested XPath, or NULL for all
+ * @retval     cb        Key, free with cbuf_free
+ * @retval     NULL      Error
+ */
+static cbuf *
+statedata_cache_key(const char *provider,
+		    cvec       *nsc,
+		    char       *xpath)
+{
+    cbuf   *cb;
+    cg_var *cv = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	return NULL;
+    }
+    cprintf(cb, "%s\n%s\n", provider, xpath?xpath:"/");
+    while ((cv = cvec_each(nsc, cv)) != NULL)
+	cprintf(cb, "%s=%s ", cv_name_get(cv)?cv_name_get(cv):"", cv_string_get(cv));
+    return cb;
+}
+
+/*! Get cached state data of provider and request
+ * @param[in]  h         Clicon handle
+ * @param[in]  provider  Name of backend plugin or registered path
+ * @param[in]  nsc       XPATH namespace context of request
+ * @param[in]  xpath     Requested XPath, or NULL for all
+ * @param[out] xp        Copy of cached state tree, free with xml_free. If NULL, only check
+ * @retval     1         Cached, xp set
+ * @retval     0         Not cached or expired
+ * @retval    -1         Error
+ * @see statedata_cache_put
+ */
+int
+statedata_cache_get(clicon_handle h,
+		    const char   *provider,
+		    cvec         *nsc,
+		    char         *xpath,
+		    cxobj       **xp)
+{
+    int                     retval = -1;
+    struct backend_handle  *bh = handle(h);
+    struct statedata_cache *sdc;
+    struct timespec         now;
+    cbuf                   *key = NULL;
+
+    if (bh->bh_sd_cache == NULL){
+	retval = 0;
+	goto done;
+    }
+    if ((key = statedata_cache_key(provider, nsc, xpath)) == NULL)
+	goto done;
+    if ((sdc = clicon_hash_value(bh->bh_sd_cache, cbuf_get(key), NULL)) == NULL){
+	retval = 0;
+	goto done;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (statedata_cache_expired(sdc, &now)){
+	if (sdc->sdc_xml)
+	    xml_free(sdc->sdc_xml);
+	clicon_hash_del(bh->bh_sd_cache, cbuf_get(key));
+	retval = 0;
+	goto done;
+    }
+    if (xp && (*xp = xml_dup(sdc->sdc_xml)) == NULL)
+	goto done;
+    clicon_debug(1, "%s %s cached", __FUNCTION__, provider);
+    retval = 1;
+ done:
+    if (key)
+	cbuf_free(key);
+    return retval;
+}
+
+/*! Cache state data of provider and request, if the provider has a cache time
+ * @param[in]  h         Clicon handle
+ * @param[in]  provider  Name of backend plugin or registered path
+ * @param[in]  nsc       XPATH namespace context of request
+ * @param[in]  xpath     Requested XPath, or NULL for all
+ * @param[in]  x         State tree returned by provider, copied
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see statedata_cache_get
+ */
+int
+statedata_cache_put(clicon_handle h,
+		    const char   *provider,
+		    cvec         *nsc,
+		    char         *xpath,
+		    cxobj        *x)
+{
+    int                     retval = -1;
+    struct backend_handle  *bh = handle(h);
+    struct statedata_cache  sdc = {{0,},};
+    struct statedata_cache *sdc0;
+    uint32_t                ttl;
+    cbuf                   *key = NULL;
+
+    if ((ttl = statedata_cache_ttl(h, provider)) == 0)
+	goto ok;
+    if (bh->bh_sd_cache == NULL &&
+	(bh->bh_sd_cache = clicon_hash_init()) == NULL)
+	goto done;
+    if ((key = statedata_cache_key(provider, nsc, xpath)) == NULL)
+	goto done;
+    clock_gettime(CLOCK_MONOTONIC, &sdc.sdc_expire);
+    if (statedata_cache_expire(h, &sdc.sdc_expire) < 0)
+	goto done;
+    sdc.sdc_expire.tv_sec += ttl/1000;
+    sdc.sdc_expire.tv_nsec += (ttl%1000)*1000000;
+    if (sdc.sdc_expire.tv_nsec >= 1000000000){
+	sdc.sdc_expire.tv_sec++;
+	sdc.sdc_expire.tv_nsec -= 1000000000;
+    }
+    if ((sdc.sdc_xml = xml_dup(x)) == NULL)
+	goto done;
+    if ((sdc0 = clicon_hash_value(bh->bh_sd_cache, cbuf_get(key), NULL)) != NULL &&
+	sdc0->sdc_xml)
+	xml_free(sdc0->sdc_xml);
+    if (clicon_hash_add(bh->bh_sd_cache, cbuf_get(key), &sdc, sizeof(sdc)) == NULL){
+	xml_free(sdc.sdc_xml);
+	goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (key)
+	cbuf_free(key);
+    return retval;
+}
@@ -45,9 +45,51 @@
 /*
  * Types
  */
+/*! Registered statedata callback function for a YANG data node
+ * @param[in]  h      Clicon handle
+ * @param[in]  nsc    XPATH namespace context of request
+ * @param[in]  xpath  Requested XPath, or NULL for all
+ * @param[in]  keys   List key names and values given in the request along the 
+ *                    registered path, in order from the top, or NULL
+ * @param[in]  xtop   XML tree where statedata is added
+ * @param[in]  arg    User argument given at statedata_callback_register() 
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see statedata_callback_register
+ */
+typedef int (*clicon_statedata_cb)(
+    clicon_handle h,
+    cvec         *nsc,
+    char         *xpath,
+    cvec         *keys,
+    cxobj        *xtop,
+    void         *arg
+);
+
+/*! Cancel callback of an asynchronous rpc, if the client is removed before reply
+ * @param[in]  h      Clicon handle
+ * @param[in]  arg    User argument given at rpc_async_cancel_set()
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see rpc_async_cancel_set
+ */
+typedef int (*clicon_rpc_async_cancel_cb)(
+    clicon_handle h,
+    void         *arg
+);
+
+/* Asynchronous rpc reply token, see rpc_async_start */
+struct rpc_async;
 
 /*
  * Prototypes
  */
+int statedata_callback_register(clicon_handle h, clicon_statedata_cb cb, void *arg,
+				const char *ns, const char *path);
+int statedata_cache_ttl_set(clicon_handle h, const char *provider, uint32_t ttl);
+int statedata_cache_invalidate(clicon_handle h, const char *provider);
+struct rpc_async *rpc_async_start(clicon_handle h, void *arg);
+int rpc_async_cancel_set(struct rpc_async *ra, clicon_rpc_async_cancel_cb fn, void *arg);
+int rpc_async_reply(clicon_handle h, struct rpc_async *ra, char *reply);
 
 #endif /* _CLIXON_BACKEND_HANDLE_H_ */
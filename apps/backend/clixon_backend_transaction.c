@@ -190,6 +190,141 @@ transaction_clen(transaction_data td)
   return ((transaction_data_t *)td)->td_clen;
 }
 
+/*! Get changes of a transaction in the top-level nodes of a namespace
+ * Instead of scanning all changes of a transaction for those of its own module, a
+ * plugin can get a view with only those changes, grouped once for all plugins when
+ * the transaction is created. The view is accessed with the same functions as the
+ * transaction, eg transaction_dvec(), and has the same source and target trees.
+ * @param[in]  td   transaction_data
+ * @param[in]  ns   Namespace of module, changes below its top-level nodes are included
+ * @retval     tv   transaction_data view, valid as long as the transaction
+ * @retval     NULL No changes in the namespace
+ * @code
+ *   transaction_data tv;
+ *
+ *   if ((tv = transaction_ns(td, "urn:example:clixon")) == NULL)
+ *      return 0;
+ *   for (i=0; i<transaction_alen(tv); i++)
+ *      ... transaction_avec(tv)[i]
+ * @endcode
+ * @note Augmented nodes are included in the namespace of the top-level node
+ */
+transaction_data
+transaction_ns(transaction_data td,
+	       const char      *ns)
+{
+    transaction_data_t    *t = (transaction_data_t *)td;
+    struct transaction_ns *tn;
+    int                    i;
+
+    for (i=0; i<t->td_nslen; i++){
+	tn = &t->td_nsv[i];
+	if (clicon_strcmp(tn->tn_ns, (char*)ns) == 0)
+	    return (transaction_data)&tn->tn_td;
+    }
+    return NULL;
+}
+
+/*! Get the changes of a transaction as a change set
+ * Each change has the instance-identifier of the node, the operation and for leafs
+ * and leaf-lists the old and new typed values, so that a plugin does not need to
+ * walk the trees or make xpath lookups to process the changes.
+ * The change set is built at the first call and kept for the rest of the transaction.
+ * @param[in]  td     transaction_data, or namespace view, see transaction_ns
+ * @param[out] tcv    Vector of changes, valid as long as the transaction
+ * @param[out] tclen  Length of tcv
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   transaction_change *tcv;
+ *   size_t              len;
+ *
+ *   if (transaction_changes(td, &tcv, &len) < 0)
+ *      err;
+ *   for (i=0; i<len; i++)
+ *      if (tcv[i].tc_op == OP_REPLACE && tcv[i].tc_new)
+ *         ... tcv[i].tc_path, cv_uint32_get(tcv[i].tc_new)
+ * @endcode
+ */
+int
+transaction_changes(transaction_data     td,
+		    transaction_change **tcv,
+		    size_t              *tclen)
+{
+    transaction_data_t *t = (transaction_data_t *)td;
+
+    if (t->td_chv == NULL &&
+	transaction_changes_build(t) < 0)
+	return -1;
+    *tcv = t->td_chv;
+    *tclen = t->td_chlen;
+    return 0;
+}
+
+/*! Print the change set of a transaction as XML, eg for a consumer outside the backend
+ * @param[out] cb   Buffer, the change set is appended
+ * @param[in]  td   transaction_data
+ * @retval     0    OK
+ * @retval    -1    Error
+ * Values are in canonical form of their type:
+ *   <changes><change><operation>replace</operation><path>/ex:a/ex:b</path>
+ *     <old>1</old><new>2</new></change></changes>
+ * @see transaction_changes
+ */
+int
+transaction_changes2cbuf(cbuf            *cb,
+			 transaction_data td)
+{
+    int                 retval = -1;
+    transaction_change *tcv;
+    transaction_change *tc;
+    size_t              len;
+    size_t              i;
+    char               *str = NULL;
+
+    if (transaction_changes(td, &tcv, &len) < 0)
+	goto done;
+    cprintf(cb, "<changes>");
+    for (i=0; i<len; i++){
+	tc = &tcv[i];
+	cprintf(cb, "<change><operation>%s</operation><path>", xml_operation2str(tc->tc_op));
+	if (xml_chardata_cbuf_append(cb, tc->tc_path) < 0)
+	    goto done;
+	cprintf(cb, "</path>");
+	if (tc->tc_old){
+	    if ((str = cv2str_dup(tc->tc_old)) == NULL){
+		clicon_err(OE_UNIX, errno, "cv2str_dup");
+		goto done;
+	    }
+	    cprintf(cb, "<old>");
+	    if (xml_chardata_cbuf_append(cb, str) < 0)
+		goto done;
+	    cprintf(cb, "</old>");
+	    free(str);
+	    str = NULL;
+	}
+	if (tc->tc_new){
+	    if ((str = cv2str_dup(tc->tc_new)) == NULL){
+		clicon_err(OE_UNIX, errno, "cv2str_dup");
+		goto done;
+	    }
+	    cprintf(cb, "<new>");
+	    if (xml_chardata_cbuf_append(cb, str) < 0)
+		goto done;
+	    cprintf(cb, "</new>");
+	    free(str);
+	    str = NULL;
+	}
+	cprintf(cb, "</change>");
+    }
+    cprintf(cb, "</changes>");
+    retval = 0;
+ done:
+    if (str)
+	free(str);
+    return retval;
+}
+
 /*! Print transaction on FILE for debug
  * @see transaction_log
  */
@@ -42,6 +42,21 @@
 #ifndef _CLIXON_BACKEND_TRANSACTION_H_
 #define _CLIXON_BACKEND_TRANSACTION_H_
 
+/*
+ * Types
+ */
+/* Change of one node in a transaction, see transaction_changes
+ * Deleted and created nodes may be roots of subtrees, changed nodes are leafs
+ */
+typedef struct {
+    enum operation_type tc_op;     /* OP_DELETE, OP_CREATE or OP_REPLACE */
+    char               *tc_path;   /* Instance-identifier, eg /ex:a/ex:b[ex:k='1'] */
+    cxobj              *tc_src;    /* Node in source tree, or NULL if created */
+    cxobj              *tc_target; /* Node in target tree, or NULL if deleted */
+    cg_var             *tc_old;    /* Old typed value of leaf or leaf-list, or NULL */
+    cg_var             *tc_new;    /* New typed value of leaf or leaf-list, or NULL */
+} transaction_change;
+
 /*
  * Prototypes
  */
@@ -60,6 +75,9 @@ size_t  transaction_alen(transaction_data td);
 cxobj **transaction_scvec(transaction_data td);
 cxobj **transaction_tcvec(transaction_data td);
 size_t  transaction_clen(transaction_data td);
+transaction_data transaction_ns(transaction_data td, const char *ns);
+int     transaction_changes(transaction_data td, transaction_change **tcv, size_t *tclen);
+int     transaction_changes2cbuf(cbuf *cb, transaction_data td);
 
 int transaction_print(FILE *f, transaction_data th);
 int transaction_log(clicon_handle h, transaction_data th, int level, const char *id);
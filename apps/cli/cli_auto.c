@@ -295,6 +295,111 @@ cli_auto_top(clicon_handle h,
     return retval;
 }
 
+/*! Cache of the configuration of an edit mode, see CLICON_CLI_EDIT_CACHE
+ * Kept in the clicon data hash as "cli-edit-cache". The tree is valid for the edit mode
+ * it was read in and all modes below it, as long as the change token of the datastore
+ * is the same. The token changes on local edits, commits and edits of other sessions.
+ */
+struct cli_edit_cache{
+    char  *ec_db;       /* Datastore of tree */
+    char  *ec_api_path; /* Api-path of edit mode when read */
+    char  *ec_token;    /* Change token of datastore when read */
+    cxobj *ec_xt;       /* Configuration of edit mode */
+};
+
+/*! Free the cache of the configuration of an edit mode
+ * @param[in]  h     Clicon handle
+ */
+int
+cli_auto_cache_free(clicon_handle h)
+{
+    struct cli_edit_cache *ec;
+
+    if ((ec = clicon_hash_value(clicon_data(h), "cli-edit-cache", NULL)) == NULL)
+	return 0;
+    if (ec->ec_db)
+	free(ec->ec_db);
+    if (ec->ec_api_path)
+	free(ec->ec_api_path);
+    if (ec->ec_token)
+	free(ec->ec_token);
+    if (ec->ec_xt)
+	xml_free(ec->ec_xt);
+    clicon_hash_del(clicon_data(h), "cli-edit-cache");
+    return 0;
+}
+
+/*! Get cached configuration of an edit mode if the datastore is not changed
+ * @param[in]  h        Clicon handle
+ * @param[in]  db       Datastore
+ * @param[in]  api_path Api-path of edit mode
+ * @param[in]  token    Current change token of datastore
+ * @retval     xt       Configuration including the edit mode, owned by cache
+ * @retval     NULL     Not found
+ */
+static cxobj *
+cli_auto_cache_find(clicon_handle h,
+		    char         *db,
+		    char         *api_path,
+		    char         *token)
+{
+    struct cli_edit_cache *ec;
+    size_t                 len;
+
+    if ((ec = clicon_hash_value(clicon_data(h), "cli-edit-cache", NULL)) == NULL)
+	return NULL;
+    if (strcmp(ec->ec_db, db) != 0 ||
+	strcmp(ec->ec_token, token) != 0)
+	return NULL;
+    /* Tree of edit mode includes all modes below it */
+    if (strcmp(ec->ec_api_path, "/") != 0){
+	len = strlen(ec->ec_api_path);
+	if (strncmp(ec->ec_api_path, api_path, len) != 0 ||
+	    (api_path[len] != '\0' && api_path[len] != '/'))
+	    return NULL;
+    }
+    return ec->ec_xt;
+}
+
+/*! Replace cached configuration of edit mode
+ * @param[in]  h        Clicon handle
+ * @param[in]  db       Datastore
+ * @param[in]  api_path Api-path of edit mode
+ * @param[in]  token    Change token of datastore when read
+ * @param[in]  xt       Configuration including the edit mode, owned by cache
+ */
+static int
+cli_auto_cache_set(clicon_handle h,
+		   char         *db,
+		   char         *api_path,
+		   char         *token,
+		   cxobj        *xt)
+{
+    struct cli_edit_cache  ec = {NULL, NULL, NULL, NULL};
+
+    if (cli_auto_cache_free(h) < 0)
+	return -1;
+    if ((ec.ec_db = strdup(db)) == NULL ||
+	(ec.ec_api_path = strdup(api_path)) == NULL ||
+	(ec.ec_token = strdup(token)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto err;
+    }
+    ec.ec_xt = xt;
+    if (clicon_hash_add(clicon_data(h), "cli-edit-cache", &ec, sizeof(ec)) == NULL)
+	goto err;
+    return 0;
+ err:
+    if (ec.ec_db)
+	free(ec.ec_db);
+    if (ec.ec_api_path)
+	free(ec.ec_api_path);
+    if (ec.ec_token)
+	free(ec.ec_token);
+    xml_free(xt);
+    return -1;
+}
+
 /*! CLI callback: Working point tree show
  * @param[in]  h    CLICON handle
  * @param[in]  cvv  Vector of variables from CLIgen command-line
@@ -306,6 +411,8 @@ cli_auto_top(clicon_handle h,
  *   <pretty>       true|false: pretty-print or not
  *   <state>        true|false: pretty-print or not
  *   <prefix>       to print before cli syntax output
+ * If CLICON_CLI_EDIT_CACHE is set, configuration read in an edit mode is cached and
+ * shown again in the same mode and modes below it, as long as the datastore is not changed
  * @see cli_show_auto
  */
 int
@@ -336,6 +443,8 @@ cli_auto_show(clicon_handle h,
     char       *prefix = NULL;
     int         state;
     cg_var     *boolcv = NULL;
+    char       *token = NULL;
+    cxobj      *xc0 = NULL; /* Cached configuration, not freed */
     
     if (cvec_len(argv) != 5 && cvec_len(argv) != 6){
 	clicon_err(OE_PLUGIN, EINVAL, "Usage: <treename> <database> <format> <pretty> <state> [<prefix>].");
@@ -388,7 +497,24 @@ cli_auto_show(clicon_handle h,
     if (api_path2xpath(api_path, yspec, &xpath, &nsc, NULL) < 0)
 	goto done;
     isroot = (xpath == NULL) || strcmp(xpath,"/")==0;
-    if (state == 0){     /* Get configuration-only from database */
+    if (state == 0 && clicon_option_bool(h, "CLICON_CLI_EDIT_CACHE")){
+	/* Check change token instead of reading configuration again */
+	if (clicon_rpc_datastore_token(h, db, &token, NULL) < 0)
+	    goto done;
+	if ((xc0 = cli_auto_cache_find(h, db, api_path, token)) == NULL){
+	    if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, &xt) < 0)
+		goto done;
+	    if (xpath_first(xt, NULL, "/rpc-error") == NULL){
+		if (cli_auto_cache_set(h, db, api_path, token, xt) < 0){
+		    xt = NULL;
+		    goto done;
+		}
+		xc0 = xt;
+		xt = NULL;
+	    }
+	}
+    }
+    else if (state == 0){     /* Get configuration-only from database */
 	if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, &xt) < 0)
 	    goto done;
     }
@@ -400,13 +526,14 @@ cli_auto_show(clicon_handle h,
 	if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, &xt) < 0)
 	    goto done;
     }
-    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+    if (xt && (xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
 	clixon_netconf_error(xerr, "Get configuration", NULL);
 	goto done;
     }
-    if (xpath_vec(xt, nsc, "%s", &vec, &veclen, xpath) < 0) 
+    if (xpath_vec(xc0?xc0:xt, nsc, "%s", &vec, &veclen, xpath) < 0) 
 	goto done;
     
+    cli_timing_begin(h, CT_RENDER);
     for (i=0; i<veclen; i++){
 	xp = vec[i];
 	/* Print configuration according to format */
@@ -457,12 +584,18 @@ cli_auto_show(clicon_handle h,
 		    clicon_xml2file(stdout, xc, 2, pretty);
 	    fprintf(stdout, "</config></edit-config></rpc>]]>]]>\n");
 	    break;
+	case FORMAT_CBOR: /* Datastore format only, see CLICON_XMLDB_FORMAT */
+	    clicon_err(OE_PLUGIN, EINVAL, "Format cbor not supported");
+	    goto done;
 	} /* switch */
     }
+    cli_timing_render_end(h);
     retval = 0;
  done:
     if (boolcv)
 	cv_free(boolcv);
+    if (token)
+	free(token);
     if (xt)
 	xml_free(xt);
     if (nsc)
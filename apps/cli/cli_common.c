@@ -55,6 +55,7 @@
 #include <netinet/in.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <fcntl.h>
 #include <sys/wait.h>
 #include <sys/param.h>
@@ -211,6 +212,408 @@ dbxml_body(cxobj     *xbot,
     return retval;
 }
 
+/*! State of batched CLI edits, see cli_batch_begin
+ * Kept in the clicon data hash as "cli-batch"
+ */
+struct cli_batch {
+    int    cb_on;   /* Batch mode: edits are accumulated */
+    int    cb_edit; /* Current command is an accumulated edit */
+    cxobj *cb_xt;   /* Accumulated edits as one <config> tree */
+};
+
+/* Edit callbacks that may be accumulated in batch mode */
+static cgv_fnstype_t *cli_batch_fns[] = {
+    cli_set,
+    cli_merge,
+    cli_create,
+    cli_remove,
+    cli_del,
+    cli_auto_set,
+    cli_auto_merge,
+    cli_auto_create,
+    cli_auto_del,
+    NULL
+};
+
+/*! Get batch state from handle, create it if not found
+ * @param[in]  h     Clicon handle
+ * @retval     cb    Batch state
+ * @retval     NULL  Error
+ */
+static struct cli_batch *
+cli_batch_get(clicon_handle h)
+{
+    clicon_hash_t   *cdat = clicon_data(h);
+    size_t           len;
+    void            *p;
+    struct cli_batch cb0 = {0,};
+
+    if ((p = clicon_hash_value(cdat, "cli-batch", &len)) != NULL)
+	return (struct cli_batch *)p;
+    if (clicon_hash_add(cdat, "cli-batch", &cb0, sizeof(cb0)) == NULL)
+	return NULL;
+    return (struct cli_batch *)clicon_hash_value(cdat, "cli-batch", &len);
+}
+
+/*! Merge a new edit into the accumulated edits
+ *
+ * The edits must not overlap: if a node of the new edit with an operation attribute
+ * already exists in the accumulated tree, or if the new edit is under a node with an
+ * operation, the order of the edits matters and they cannot be merged.
+ * @param[in]  x0      Accumulated edits
+ * @param[in]  x1      New edit. Merged subtrees are moved from x1 to x0
+ * @param[in]  dryrun  Only check if the edit can be merged, do not change the trees
+ * @retval     1       OK, merged (or can be merged if dryrun)
+ * @retval     0       Edits overlap, cannot be merged
+ * @retval    -1       Error
+ */
+static int
+cli_batch_merge(cxobj *x0,
+		cxobj *x1,
+		int    dryrun)
+{
+    int        retval = -1;
+    cxobj     *x1c;
+    cxobj     *x0c;
+    yang_stmt *yc;
+    int        i;
+    int        ret;
+
+    i = 0;
+    while ((x1c = xml_child_i_type(x1, i, CX_ELMNT)) != NULL){
+	yc = xml_spec(x1c);
+	if (match_base_child(x0, x1c, yc, &x0c) < 0)
+	    goto done;
+	if (x0c == NULL){ /* New node, move it to the accumulated edits */
+	    if (!dryrun){
+		if (xml_insert(x0, x1c, INS_LAST, NULL, NULL) < 0)
+		    goto done;
+		continue; /* x1c is removed from x1, next child is at i */
+	    }
+	}
+	else if (strcmp(xml_name(x0c), xml_name(x1c)) != 0 || /* Other choice case */
+		 xml_find_type(x0c, NETCONF_BASE_PREFIX, "operation", CX_ATTR) != NULL ||
+		 xml_find_type(x1c, NETCONF_BASE_PREFIX, "operation", CX_ATTR) != NULL)
+	    goto overlap;
+	else if (yc == NULL || yang_keyword_get(yc) != Y_LEAF){ /* Not list key */
+	    if ((ret = cli_batch_merge(x0c, x1c, dryrun)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto overlap;
+	}
+	i++;
+    }
+    retval = 1;
+ done:
+    return retval;
+ overlap:
+    retval = 0;
+    goto done;
+}
+
+/*! Add an edit to the accumulated edits, send the accumulated edits if they overlap
+ * @param[in]     h     Clicon handle
+ * @param[in]     cb    Batch state
+ * @param[in,out] xtp   Edit as <config> tree, may be consumed (set to NULL)
+ * @retval        0     OK
+ * @retval       -1     Error
+ */
+static int
+cli_batch_add(clicon_handle     h,
+	      struct cli_batch *cb,
+	      cxobj           **xtp)
+{
+    int retval = -1;
+    int ret;
+
+    if (xml_sort_recurse(*xtp) < 0)
+	goto done;
+    if (cb->cb_xt != NULL){
+	if ((ret = cli_batch_merge(cb->cb_xt, *xtp, 1)) < 0)
+	    goto done;
+	if (ret == 1){
+	    if (cli_batch_merge(cb->cb_xt, *xtp, 0) < 0)
+		goto done;
+	    goto ok;
+	}
+	/* Overlapping edit: send the earlier edits first */
+	if (cli_batch_flush(h) < 0)
+	    goto done;
+    }
+    cb->cb_xt = *xtp;
+    *xtp = NULL;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send the accumulated edits of batch mode as one edit-config
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see cli_batch_begin
+ */
+int
+cli_batch_flush(clicon_handle h)
+{
+    int               retval = -1;
+    struct cli_batch *cb;
+    cxobj            *xt;
+    cbuf             *cbx = NULL;
+
+    if ((cb = cli_batch_get(h)) == NULL)
+	goto done;
+    if ((xt = cb->cb_xt) == NULL)
+	goto ok;
+    cb->cb_xt = NULL;
+    if ((cbx = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf(cbx, xt, 0, 0, -1) < 0)
+	goto done;
+    if (clicon_rpc_edit_config(h, "candidate", OP_NONE, cbuf_get(cbx)) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cbx)
+	cbuf_free(cbx);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Prepare evaluation of a CLI command in batch mode
+ *
+ * In batch mode, consecutive edits are accumulated. Before any other command, the
+ * accumulated edits are sent to the backend.
+ * @param[in]  h     Clicon handle
+ * @param[in]  co    CLIgen object of matched command
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see clicon_eval
+ */
+int
+cli_batch_eval(clicon_handle h,
+	       cg_obj       *co)
+{
+    struct cli_batch   *cb;
+    struct cg_callback *cc;
+    int                 i;
+
+    if ((cb = cli_batch_get(h)) == NULL)
+	return -1;
+    cb->cb_edit = 0;
+    if (cb->cb_on && co != NULL && (cc = co->co_callbacks) != NULL){
+	for (; cc != NULL; cc = cc->cc_next){
+	    for (i=0; cli_batch_fns[i]; i++)
+		if (cc->cc_fn_vec == cli_batch_fns[i])
+		    break;
+	    if (cli_batch_fns[i] == NULL)
+		break; /* Not an edit */
+	}
+	if (cc == NULL)
+	    cb->cb_edit = 1;
+    }
+    if (!cb->cb_edit && cli_batch_flush(h) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Start batch mode: accumulate consecutive edits and send them as one edit-config
+ *
+ * The edits are sent before the next command that is not an edit, such as show or
+ * commit, or at cli_batch_end, or at end of input.
+ * Edits that overlap earlier accumulated edits are sent separately in order.
+ * Errors of accumulated edits are reported when they are sent.
+ * @param[in]  h     Clicon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables 
+ * @param[in]  argv  Not used
+ * @code
+ *   # cligen spec
+ *   batch begin, cli_batch_begin();
+ *   batch end, cli_batch_end();
+ * @endcode
+ * @see CLICON_CLI_BATCH  Batch mode when reading commands from a pipe or file
+ */
+int
+cli_batch_begin(clicon_handle h,
+		cvec         *cvv,
+		cvec         *argv)
+{
+    struct cli_batch *cb;
+
+    if ((cb = cli_batch_get(h)) == NULL)
+	return -1;
+    cb->cb_on = 1;
+    return 0;
+}
+
+/*! End batch mode, accumulated edits have already been sent
+ * @param[in]  h     Clicon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables 
+ * @param[in]  argv  Not used
+ * @see cli_batch_begin
+ */
+int
+cli_batch_end(clicon_handle h,
+	      cvec         *cvv,
+	      cvec         *argv)
+{
+    struct cli_batch *cb;
+
+    if ((cb = cli_batch_get(h)) == NULL)
+	return -1;
+    if (cli_batch_flush(h) < 0)
+	return -1;
+    cb->cb_on = 0;
+    return 0;
+}
+
+/*! Timing of CLI commands, see CLICON_CLI_TIMING
+ * Kept in the clicon data hash as "cli-timing"
+ * Each of the time vectors has the parse, rpc, render and total time of commands
+ */
+struct cli_timing {
+    struct timeval ct_t0;       /* Start of current command */
+    struct timeval ct_render0;  /* Start of current rendering */
+    uint32_t       ct_rpcnr0;   /* Nr of rpcs at start of command */
+    struct timeval ct_rpc0;     /* Time of rpcs at start of command */
+    struct timeval ct_cur[4];   /* Current command */
+    uint32_t       ct_currpc;   /* Nr of rpcs of current command */
+    struct timeval ct_tot[4];   /* All commands */
+    uint32_t       ct_totrpc;   /* Nr of rpcs of all commands */
+    uint32_t       ct_nr;       /* Nr of commands */
+};
+
+static const char *cli_timing_names[] = {"parse", "rpc", "render", "total"};
+
+/*! Enable timing of CLI commands, see CLICON_CLI_TIMING
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+cli_timing_enable(clicon_handle h)
+{
+    struct cli_timing ct = {0,};
+
+    if (clicon_hash_add(clicon_data(h), "cli-timing", &ct, sizeof(ct)) == NULL)
+	return -1;
+    return clicon_rpc_timing_enable(h);
+}
+
+/*! Start timing of a CLI command, or of a phase of it
+ * @param[in]  h     Clicon handle
+ * @param[in]  phase CT_PARSE: start of command
+ *                   CT_RPC: parse done, start of evaluation
+ *                   CT_RENDER: start of rendering
+ * No-op if timing is not enabled
+ */
+void
+cli_timing_begin(clicon_handle h,
+		 int           phase)
+{
+    struct cli_timing *ct;
+    struct timeval     t;
+
+    if ((ct = clicon_hash_value(clicon_data(h), "cli-timing", NULL)) == NULL)
+	return;
+    gettimeofday(&t, NULL);
+    switch (phase){
+    case CT_PARSE:
+	memset(ct->ct_cur, 0, sizeof(ct->ct_cur));
+	ct->ct_t0 = t;
+	clicon_rpc_timing_get(h, &ct->ct_rpcnr0, &ct->ct_rpc0);
+	break;
+    case CT_RPC:
+	timersub(&t, &ct->ct_t0, &ct->ct_cur[CT_PARSE]);
+	break;
+    case CT_RENDER:
+	ct->ct_render0 = t;
+	break;
+    }
+}
+
+/*! End rendering of output of a CLI command
+ * @param[in]  h     Clicon handle
+ * No-op if timing is not enabled
+ */
+void
+cli_timing_render_end(clicon_handle h)
+{
+    struct cli_timing *ct;
+    struct timeval     t;
+
+    if ((ct = clicon_hash_value(clicon_data(h), "cli-timing", NULL)) == NULL)
+	return;
+    gettimeofday(&t, NULL);
+    timersub(&t, &ct->ct_render0, &t);
+    timeradd(&ct->ct_cur[CT_RENDER], &t, &ct->ct_cur[CT_RENDER]);
+}
+
+/*! End timing of a CLI command and print its timing on stderr
+ * @param[in]  h     Clicon handle
+ * No-op if timing is not enabled
+ */
+void
+cli_timing_end(clicon_handle h)
+{
+    struct cli_timing *ct;
+    struct timeval     t;
+    uint32_t           nr;
+    int                i;
+
+    if ((ct = clicon_hash_value(clicon_data(h), "cli-timing", NULL)) == NULL)
+	return;
+    gettimeofday(&t, NULL);
+    timersub(&t, &ct->ct_t0, &ct->ct_cur[CT_TOTAL]);
+    clicon_rpc_timing_get(h, &nr, &t);
+    timersub(&t, &ct->ct_rpc0, &ct->ct_cur[CT_RPC]);
+    ct->ct_currpc = nr - ct->ct_rpcnr0;
+    ct->ct_totrpc += ct->ct_currpc;
+    ct->ct_nr++;
+    fprintf(stderr, "Timing:");
+    for (i=0; i<4; i++){
+	timeradd(&ct->ct_tot[i], &ct->ct_cur[i], &ct->ct_tot[i]);
+	fprintf(stderr, " %s %ld.%06lds", cli_timing_names[i],
+		(long)ct->ct_cur[i].tv_sec, (long)ct->ct_cur[i].tv_usec);
+	if (i == CT_RPC)
+	    fprintf(stderr, " (%u)", ct->ct_currpc);
+    }
+    fprintf(stderr, "\n");
+}
+
+/*! Show accumulated timing of CLI commands, see CLICON_CLI_TIMING
+ * @param[in]  h     Clicon handle
+ * @param[in]  cvv   Vector of cli string and instantiated variables 
+ * @param[in]  argv  Not used
+ * @code
+ *   show cli timing, cli_show_timing();
+ * @endcode
+ */
+int
+cli_show_timing(clicon_handle h,
+		cvec         *cvv,
+		cvec         *argv)
+{
+    struct cli_timing *ct;
+    int                i;
+
+    if ((ct = clicon_hash_value(clicon_data(h), "cli-timing", NULL)) == NULL){
+	clicon_err(OE_PLUGIN, 0, "CLI timing not enabled, see CLICON_CLI_TIMING");
+	return -1;
+    }
+    cligen_output(stdout, "%-10s%u\n", "commands", ct->ct_nr);
+    cligen_output(stdout, "%-10s%u\n", "rpcs", ct->ct_totrpc);
+    for (i=0; i<4; i++)
+	cligen_output(stdout, "%-10s%ld.%06lds\n", cli_timing_names[i],
+		      (long)ct->ct_tot[i].tv_sec, (long)ct->ct_tot[i].tv_usec);
+    return 0;
+}
+
 /*! Modify xml datastore from a callback using xml key format strings
  * @param[in]  h     Clicon handle
  * @param[in]  cvv   Vector of cli string and instantiated variables 
@@ -252,6 +655,7 @@ cli_dbxml(clicon_handle       h,
     int        ret;
     cg_var    *cv;
     int        cvv_i = 0;
+    struct cli_batch *batch;
 
     if (cvec_len(argv) != 1){
 	clicon_err(OE_PLUGIN, EINVAL, "Requires one element to be xml key format string");
@@ -316,6 +720,14 @@ cli_dbxml(clicon_handle       h,
 		goto done;
 	}
     }
+    /* In batch mode, accumulate edit, see cli_batch_begin */
+    if ((batch = cli_batch_get(h)) == NULL)
+	goto done;
+    if (batch->cb_edit){
+	if (cli_batch_add(h, batch, &xtop) < 0)
+	    goto done;
+	goto ok;
+    }
     if ((cb = cbuf_new()) == NULL){
 	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
@@ -324,6 +736,7 @@ cli_dbxml(clicon_handle       h,
 	goto done;
     if (clicon_rpc_edit_config(h, "candidate", OP_NONE, cbuf_get(cb)) < 0)
 	goto done;
+ ok:
     retval = 0;
  done:
     if (xerr)
@@ -647,75 +1060,61 @@ cli_validate(clicon_handle h,
     return retval;
 }
 
-/*! Compare two dbs using XML. Write to file and run diff
+/* Line prefix of compare_output(), eg "-" or "+" */
+static char *compare_prefix = "";
+/* Set if next output of compare_output() is at beginning of a line */
+static int   compare_bol = 1;
+
+/*! Print callback of compare_dbs, prefixes every line with compare_prefix
+ * @see clicon_output_cb
  */
 static int
-compare_xmls(cxobj *xc1, 
-	     cxobj *xc2, 
-	     int    astext)
+compare_output(FILE       *f,
+	       const char *fmt, ...)
 {
-    int    fd;
-    FILE  *f;
-    char   filename1[MAXPATHLEN];
-    char   filename2[MAXPATHLEN];
-    int    retval = -1;
-    cxobj *xc;
-    cbuf  *cb = NULL;
-
-    snprintf(filename1, sizeof(filename1), "/tmp/cliconXXXXXX");
-    snprintf(filename2, sizeof(filename2), "/tmp/cliconXXXXXX");
-    if ((fd = mkstemp(filename1)) < 0){
-	clicon_err(OE_UNDEF, errno, "tmpfile");
-	goto done;
-    }
-    if ((f = fdopen(fd, "w")) == NULL)
-	goto done;
-    xc = NULL;
-    if (astext)
-	while ((xc = xml_child_each(xc1, xc, -1)) != NULL)
-	    xml2txt_cb(f, xc, cligen_output);
-    else
-	while ((xc = xml_child_each(xc1, xc, -1)) != NULL)
-	    clicon_xml2file_cb(f, xc, 0, 1, cligen_output);
-
-    fclose(f);
-    close(fd);
+    int     retval = -1;
+    va_list ap;
+    char   *str = NULL;
+    char   *s;
+    char   *nl;
+    int     len;
 
-    if ((fd = mkstemp(filename2)) < 0){
-	clicon_err(OE_UNDEF, errno, "mkstemp: %s", strerror (errno));
+    va_start(ap, fmt);
+    len = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+    if ((str = malloc(len+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
 	goto done;
     }
-    if ((f = fdopen(fd, "w")) == NULL)
-	goto done;
-    xc = NULL;
-    if (astext)
-	while ((xc = xml_child_each(xc2, xc, -1)) != NULL)
-	    xml2txt_cb(f, xc, cligen_output);
-    else
-	while ((xc = xml_child_each(xc2, xc, -1)) != NULL)
-	    clicon_xml2file_cb(f, xc, 0, 1, cligen_output);
-    fclose(f);
-    close(fd);
-
-    if ((cb = cbuf_new()) == NULL){
-	clicon_err(OE_CFG, errno, "cbuf_new");
-	goto done;
+    va_start(ap, fmt);
+    vsnprintf(str, len+1, fmt, ap);
+    va_end(ap);
+    s = str;
+    while (*s){
+	if (compare_bol){
+	    cligen_output(f, "%s ", compare_prefix);
+	    compare_bol = 0;
+	}
+	if ((nl = strchr(s, '\n')) == NULL){
+	    cligen_output(f, "%s", s);
+	    break;
+	}
+	cligen_output(f, "%.*s\n", (int)(nl-s), s);
+	compare_bol = 1;
+	s = nl+1;
     }
-    cprintf(cb, "/usr/bin/diff -dU 1 %s %s |  grep -v @@ | sed 1,2d",
-	    filename1, filename2);
-    if (system(cbuf_get(cb)) < 0)
-	goto done;
-
     retval = 0;
-  done:
-    if (cb)
-	cbuf_free(cb);
-    unlink(filename1);
-    unlink(filename2);
+ done:
+    if (str)
+	free(str);
     return retval;
 }
 
-/*! Compare two dbs using XML. Write to file and run diff
+/*! Compare two dbs using XML. 
+ *
+ * The differences are computed by the backend, and only the changes are received.
+ * Each change is printed as the path of its parent followed by the deleted and added
+ * subtrees, prefixed by "-" and "+" respectively.
  * @param[in]   h     Clicon handle
  * @param[in]   cvv  
  * @param[in]   arg   arg: 0 as xml, 1: as text
@@ -725,11 +1124,15 @@ compare_dbs(clicon_handle h,
 	    cvec         *cvv, 
 	    cvec         *argv)
 {
-    cxobj *xc1 = NULL; /* running xml */
-    cxobj *xc2 = NULL; /* candidate xml */
+    cxobj *xt = NULL;
     cxobj *xerr = NULL;
+    cxobj *xch;
+    cxobj *xd;
+    cxobj *xc;
     int    retval = -1;
     int    astext;
+    int    i;
+    char  *path;
 
     if (cvec_len(argv) > 1){
 	clicon_err(OE_PLUGIN, EINVAL, "Requires 0 or 1 element. If given: astext flag 0|1");
@@ -739,26 +1142,428 @@ compare_dbs(clicon_handle h,
 	astext = cv_int32_get(cvec_i(argv, 0));
     else
 	astext = 0;
-    if (clicon_rpc_get_config(h, NULL, "running", "/", NULL, &xc1) < 0)
+    if (clicon_rpc_compare(h, "running", "candidate", &xt) < 0)
 	goto done;
-    if ((xerr = xpath_first(xc1, NULL, "/rpc-error")) != NULL){
-	clixon_netconf_error(xerr, "Get configuration", NULL);
+    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+	clixon_netconf_error(xerr, "Compare", NULL);
 	goto done;
     }
-    if (clicon_rpc_get_config(h, NULL, "candidate", "/", NULL, &xc2) < 0)
+    cli_timing_begin(h, CT_RENDER);
+    xch = NULL;
+    while ((xch = xml_child_each(xt, xch, CX_ELMNT)) != NULL){
+	if (strcmp(xml_name(xch), "change") != 0)
+	    continue;
+	if ((path = xml_find_body(xch, "path")) != NULL)
+	    cligen_output(stdout, "%s:\n", path);
+	for (i=0; i<2; i++){
+	    if ((xd = xml_find_type(xch, NULL, i==0?"deleted":"added", CX_ELMNT)) == NULL)
+		continue;
+	    compare_prefix = i==0?"-":"+";
+	    compare_bol = 1;
+	    xc = NULL;
+	    while ((xc = xml_child_each(xd, xc, CX_ELMNT)) != NULL){
+		if (astext){
+		    if (xml2txt_cb(stdout, xc, compare_output) < 0)
+			goto done;
+		}
+		else if (clicon_xml2file_cb(stdout, xc, 0, 1, compare_output) < 0)
+		    goto done;
+	    }
+	}
+    }
+    cli_timing_render_end(h);
+    retval = 0;
+  done:
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/* Max nesting of elements in a loaded file where the file is split into chunks */
+#define LOAD_DEPTH_MAX 32
+
+/*! State of the streamed load of a configuration file, see load_config_file
+ * Element 1 in the stack is the top-level tag of the file, which is sent as "config"
+ */
+struct load_stream {
+    clicon_handle ls_h;
+    yang_stmt    *ls_yspec;
+    size_t        ls_chunk;   /* Send a chunk when it reaches this size, 0 never */
+    int           ls_replace; /* Next chunk replaces the candidate */
+    int           ls_sent;    /* Nr of chunks sent */
+    cbuf         *ls_cb;      /* Chunk: content since last sent chunk */
+    int           ls_depth;   /* Nr of open elements */
+    int           ls_open;    /* Nr of open elements with start tag not in chunk */
+    struct {
+	char      *le_name;   /* Element name */
+	cbuf      *le_tag;    /* Start tag, re-opened in next chunk */
+	yang_stmt *le_ys;     /* Yang of element, or NULL */
+	int        le_split;  /* Chunk may end inside element: container or top */
+    } ls_stack[LOAD_DEPTH_MAX];
+};
+
+/*! Read the rest of a markup after '<', eg a tag, comment or CDATA
+ * @param[in]  fp   Open file positioned after '<'
+ * @param[out] cb   Complete markup including "<" and ">"
+ * @retval     0    OK
+ * @retval    -1    Error, eg end of file
+ */
+static int
+load_markup_read(FILE *fp,
+		 cbuf *cb)
+{
+    int   retval = -1;
+    int   c;
+    char  quote = 0;
+    char *end = ">";   /* End of markup */
+    char *str;
+    int   len;
+    
+    cbuf_reset(cb);
+    cprintf(cb, "<");
+    while ((c = getc(fp)) != EOF){
+	cbuf_append(cb, c);
+	str = cbuf_get(cb);
+	len = cbuf_len(cb);
+	if (len == 4 && strcmp(str, "<!--") == 0)
+	    end = "-->";
+	else if (len == 9 && strcmp(str, "<![CDATA[") == 0)
+	    end = "]]>";
+	else if (len == 2 && c == '?')
+	    end = "?>";
+	else if (str[1] != '!' && str[1] != '?'){ /* Element: '>' may be quoted */
+	    if (quote == 0 && (c == '"' || c == '\''))
+		quote = c;
+	    else if (quote == c)
+		quote = 0;
+	    if (quote)
+		continue;
+	}
+	if (len > strlen(end) &&
+	    strcmp(str + len - strlen(end), end) == 0)
+	    break;
+    }
+    if (c == EOF){
+	clicon_err(OE_XML, 0, "Unexpected end of file in markup: %.32s", cbuf_get(cb));
 	goto done;
-    if ((xerr = xpath_first(xc2, NULL, "/rpc-error")) != NULL){
-	clixon_netconf_error(xerr, "Get configuration", NULL);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get element name and default namespace of a start tag
+ * @param[in]  tag   Start tag, eg <a xmlns="urn:x">
+ * @param[out] name  Element name, malloced
+ * @param[out] ns    Default namespace, malloced, or NULL
+ * @retval     0     OK
+ * @retval    -1    Error
+ */
+static int
+load_tag_parse(char  *tag,
+	       char **name,
+	       char **ns)
+{
+    int   retval = -1;
+    char *p;
+    char *q;
+    char  quote;
+
+    p = tag + 1;
+    for (q = p; *q && !isspace(*q) && *q != '>' && *q != '/'; q++);
+    if ((*name = strndup(p, q-p)) == NULL){
+	clicon_err(OE_UNIX, errno, "strndup");
 	goto done;
     }
-    if (compare_xmls(xc1, xc2, astext) < 0) /* astext? */
+    *ns = NULL;
+    for (p = q; (p = strstr(p, "xmlns")) != NULL; p += 5){
+	q = p + 5;
+	while (isspace(*q))
+	    q++;
+	if (!isspace(*(p-1)) || *q != '=')
+	    continue;
+	q++;
+	while (isspace(*q))
+	    q++;
+	if ((quote = *q) != '"' && quote != '\'')
+	    continue;
+	p = ++q;
+	if ((q = strchr(p, quote)) == NULL)
+	    break;
+	if ((*ns = strndup(p, q-p)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send the current chunk of a loaded file to the candidate
+ * The open elements whose start tags are in an earlier chunk are re-opened at the
+ * beginning of the chunk, and closed at the end, so that the chunk is a complete
+ * edit-config on its own.
+ * @param[in]  ls   Load state
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+load_chunk_send(struct load_stream *ls)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *attrs;
+    int   len;
+    int   i;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
 	goto done;
+    }
+    /* Top-level tag of file is sent as "config" with its attributes */
+    attrs = cbuf_get(ls->ls_stack[1].le_tag) + 1 + strlen(ls->ls_stack[1].le_name);
+    len = strlen(attrs);
+    if (len >= 2 && strcmp(attrs + len - 2, "/>") == 0) /* Empty element */
+	cprintf(cb, "<%s%.*s>", NETCONF_INPUT_CONFIG, len - 2, attrs);
+    else
+	cprintf(cb, "<%s%s", NETCONF_INPUT_CONFIG, attrs);
+    for (i=2; i<=ls->ls_open; i++)
+	cbuf_append_str(cb, cbuf_get(ls->ls_stack[i].le_tag));
+    cbuf_append_str(cb, cbuf_get(ls->ls_cb));
+    for (i=ls->ls_depth; i>1; i--)
+	cprintf(cb, "</%s>", ls->ls_stack[i].le_name);
+    cprintf(cb, "</%s>", NETCONF_INPUT_CONFIG);
+    if (clicon_rpc_edit_config(ls->ls_h, "candidate",
+			       ls->ls_replace?OP_REPLACE:OP_MERGE, 
+			       cbuf_get(cb)) < 0)
+	goto done;
+    ls->ls_replace = 0;
+    ls->ls_sent++;
+    ls->ls_open = ls->ls_depth;
+    cbuf_reset(ls->ls_cb);
     retval = 0;
-  done:
-    if (xc1)
-	xml_free(xc1);    
-    if (xc2)
-	xml_free(xc2);
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Open an element in a loaded file
+ * @param[in]  ls   Load state
+ * @param[in]  tag  Start tag
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+load_elmnt_open(struct load_stream *ls,
+		char               *tag)
+{
+    int        retval = -1;
+    char      *name = NULL;
+    char      *ns = NULL;
+    yang_stmt *yp;
+    yang_stmt *ys = NULL;
+    int        d;
+
+    if (load_tag_parse(tag, &name, &ns) < 0)
+	goto done;
+    d = ++ls->ls_depth;
+    if (d >= LOAD_DEPTH_MAX) /* Not tracked, and never split */
+	goto ok;
+    ls->ls_stack[d].le_name = name;
+    name = NULL;
+    if ((ls->ls_stack[d].le_tag = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cbuf_append_str(ls->ls_stack[d].le_tag, tag);
+    if (d == 1){ /* Top-level tag of file */
+	ls->ls_stack[d].le_split = 1;
+	ls->ls_open = 1;
+	goto ok;
+    }
+    if (strchr(ls->ls_stack[d].le_name, ':') == NULL){ /* Prefixed names not split */
+	if (d == 2){
+	    if (ns != NULL &&
+		(yp = yang_find_module_by_namespace(ls->ls_yspec, ns)) != NULL)
+		ys = yang_find_datanode(yp, ls->ls_stack[d].le_name);
+	}
+	else if ((yp = ls->ls_stack[d-1].le_ys) != NULL)
+	    ys = yang_find_datanode(yp, ls->ls_stack[d].le_name);
+    }
+    ls->ls_stack[d].le_ys = ys;
+    ls->ls_stack[d].le_split = ls->ls_stack[d-1].le_split &&
+	ys != NULL && yang_keyword_get(ys) == Y_CONTAINER;
+ ok:
+    retval = 0;
+ done:
+    if (name)
+	free(name);
+    if (ns)
+	free(ns);
+    return retval;
+}
+
+/*! Close an element in a loaded file and send a chunk if it is large enough
+ * @param[in]  ls   Load state
+ * @param[in]  tag  End tag, or NULL if empty element
+ * @param[in]  name Name of end tag, or NULL if empty element
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+load_elmnt_close(struct load_stream *ls,
+		 char               *tag,
+		 char               *name)
+{
+    int   retval = -1;
+    int   d = ls->ls_depth;
+    cbuf *cb = NULL;
+    
+    if (d < LOAD_DEPTH_MAX){
+	if (name && strcmp(name, ls->ls_stack[d].le_name) != 0){
+	    clicon_err(OE_XML, 0, "Mismatched end tag: %s, expected %s",
+		       name, ls->ls_stack[d].le_name);
+	    goto done;
+	}
+	/* End of top-level tag of file: send the rest */
+	if (d == 1){
+	    if (cbuf_len(ls->ls_cb) || ls->ls_sent == 0)
+		if (load_chunk_send(ls) < 0)
+		    goto done;
+	    ls->ls_open = 0;
+	}
+	else if (d <= ls->ls_open){ /* Start tag in earlier chunk: wrap chunk in element */
+	    ls->ls_open--;
+	    if (cbuf_len(ls->ls_cb) == 0) /* Nothing new in element */
+		goto closed;
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cbuf_append_str(cb, cbuf_get(ls->ls_stack[d].le_tag));
+	    cbuf_append_str(cb, cbuf_get(ls->ls_cb));
+	    cbuf_append_str(cb, tag);
+	    cbuf_free(ls->ls_cb);
+	    ls->ls_cb = cb;
+	    cb = NULL;
+	}
+	else if (tag)
+	    cbuf_append_str(ls->ls_cb, tag);
+    closed:
+	free(ls->ls_stack[d].le_name);
+	ls->ls_stack[d].le_name = NULL;
+	cbuf_free(ls->ls_stack[d].le_tag);
+	ls->ls_stack[d].le_tag = NULL;
+    }
+    else if (tag)
+	cbuf_append_str(ls->ls_cb, tag);
+    d = --ls->ls_depth;
+    if (d > 0 && d < LOAD_DEPTH_MAX && ls->ls_stack[d].le_split &&
+	ls->ls_chunk && cbuf_len(ls->ls_cb) >= ls->ls_chunk)
+	if (load_chunk_send(ls) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Stream a configuration file to the candidate in chunks
+ * The file is not parsed into a tree. It is split at element boundaries into chunks
+ * that are sent as separate edit-configs. A chunk only ends inside containers, since
+ * a re-opened list entry would lack its keys.
+ * @param[in]  h       Clicon handle
+ * @param[in]  fp      Open file
+ * @param[in]  replace The first chunk replaces the candidate, others are merged
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+load_config_stream(clicon_handle h,
+		   FILE         *fp,
+		   int           replace)
+{
+    int                retval = -1;
+    struct load_stream ls = {0,};
+    cbuf              *cbm = NULL; /* Markup */
+    char              *str;
+    char              *name = NULL;
+    char              *ns = NULL;
+    int                c;
+    int                i;
+
+    ls.ls_h = h;
+    ls.ls_yspec = clicon_dbspec_yang(h);
+    ls.ls_chunk = clicon_option_int(h, "CLICON_CLI_LOAD_CHUNK");
+    ls.ls_replace = replace;
+    if ((ls.ls_cb = cbuf_new()) == NULL ||
+	(cbm = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    while ((c = getc(fp)) != EOF){
+	if (c != '<'){ /* Text outside of top-level tag is ignored */
+	    if (ls.ls_depth > 1)
+		cbuf_append(ls.ls_cb, c);
+	    continue;
+	}
+	if (load_markup_read(fp, cbm) < 0)
+	    goto done;
+	str = cbuf_get(cbm);
+	if (str[1] == '!' || str[1] == '?'){ /* Comment, CDATA, etc */
+	    if (ls.ls_depth > 1)
+		cbuf_append_str(ls.ls_cb, str);
+	}
+	else if (str[1] == '/'){ /* End tag */
+	    if (ls.ls_depth == 0){
+		clicon_err(OE_XML, 0, "Unexpected end tag: %s", str);
+		goto done;
+	    }
+	    if (load_tag_parse(str+1, &name, &ns) < 0)
+		goto done;
+	    if (load_elmnt_close(&ls, str, name) < 0)
+		goto done;
+	    free(name);
+	    name = NULL;
+	    if (ns){
+		free(ns);
+		ns = NULL;
+	    }
+	}
+	else { /* Start tag */
+	    if (ls.ls_depth > 0)
+		cbuf_append_str(ls.ls_cb, str);
+	    if (load_elmnt_open(&ls, str) < 0)
+		goto done;
+	    if (cbuf_len(cbm) > 1 && str[cbuf_len(cbm)-2] == '/')
+		if (load_elmnt_close(&ls, NULL, NULL) < 0)
+		    goto done;
+	}
+    }
+    if (ls.ls_depth != 0){
+	clicon_err(OE_XML, 0, "Unexpected end of file, %d open elements", ls.ls_depth);
+	goto done;
+    }
+    retval = 0;
+ done:
+    for (i=0; i<LOAD_DEPTH_MAX; i++){
+	if (ls.ls_stack[i].le_name)
+	    free(ls.ls_stack[i].le_name);
+	if (ls.ls_stack[i].le_tag)
+	    cbuf_free(ls.ls_stack[i].le_tag);
+    }
+    if (ls.ls_cb)
+	cbuf_free(ls.ls_cb);
+    if (cbm)
+	cbuf_free(cbm);
+    if (name)
+	free(name);
+    if (ns)
+	free(ns);
     return retval;
 }
 
@@ -770,6 +1575,7 @@ compare_dbs(clicon_handle h,
  *   <varname> is name of a variable occuring in "cvv" containing filename
  * @note that "filename" is local on client filesystem not backend. 
  * @note file is assumed to have a dummy top-tag, eg <clicon></clicon>
+ * @note file is streamed to the backend in chunks, see CLICON_CLI_LOAD_CHUNK
  * @code
  *   # cligen spec
  *   load file <name2:string>, load_config_file("name2","merge");
@@ -789,9 +1595,7 @@ load_config_file(clicon_handle h,
     char       *opstr;
     char       *varstr;
     FILE       *fp = NULL;
-    cxobj      *xt = NULL;
-    cxobj      *x;
-    cbuf       *cbxml;
+    int         bulk = 0;
 
     if (cvec_len(argv) != 2){
 	if (cvec_len(argv)==1)
@@ -819,34 +1623,24 @@ load_config_file(clicon_handle h,
  	clicon_err(OE_UNIX, errno, "load_config: stat(%s)", filename);
 	goto done;
     }
-    /* Open and parse local file into xml */
+    /* Open local file and stream it to the backend */
     if ((fp = fopen(filename, "r")) == NULL){
 	clicon_err(OE_UNIX, errno, "open(%s)", filename);
 	goto done;
     }
-    if (clixon_xml_parse_file(fp, YB_NONE, NULL, &xt, NULL) < 0)
+    /* The datastore file is written once after all chunks */
+    if (clicon_rpc_bulk_load(h, "candidate", 1) < 0)
 	goto done;
-    if (xt == NULL)
+    bulk++;
+    if (load_config_stream(h, fp, replace) < 0)
 	goto done;
-    if ((cbxml = cbuf_new()) == NULL)
+    bulk = 0;
+    if (clicon_rpc_bulk_load(h, "candidate", 0) < 0)
 	goto done;
-    x = NULL;
-    while ((x = xml_child_each(xt, x, -1)) != NULL) {
-	/* Read as datastore-top but transformed into an edit-config "config" */
-	xml_name_set(x, NETCONF_INPUT_CONFIG);
-	if (clicon_xml2cbuf(cbxml, x, 0, 0, -1) < 0)
-	    goto done;
-    }
-    if (clicon_rpc_edit_config(h, "candidate",
-			       replace?OP_REPLACE:OP_MERGE, 
-			       cbuf_get(cbxml)) < 0)
-	goto done;
-    cbuf_free(cbxml);
-    //    }
     ret = 0;
  done:
-    if (xt)
-	xml_free(xt);
+    if (bulk)
+	clicon_rpc_bulk_load(h, "candidate", 0);
     if (fp)
 	fclose(fp);
     return ret;
@@ -39,8 +39,26 @@
 #ifndef _CLI_COMMON_H_
 #define _CLI_COMMON_H_
 
+/*
+ * Constants
+ */
+/* Phases of CLI command timing, see cli_timing_begin and CLICON_CLI_TIMING */
+#define CT_PARSE  0
+#define CT_RPC    1
+#define CT_RENDER 2
+#define CT_TOTAL  3
+
+/*
+ * Prototypes
+ */
+
 void cli_signal_block(clicon_handle h);
 void cli_signal_unblock(clicon_handle h);
+int  cli_batch_eval(clicon_handle h, cg_obj *co);
+int  cli_timing_enable(clicon_handle h);
+void cli_timing_begin(clicon_handle h, int phase);
+void cli_timing_render_end(clicon_handle h);
+void cli_timing_end(clicon_handle h);
 
 /* If you do not find a function here it may be in clicon_cli_api.h which is 
    the external API */
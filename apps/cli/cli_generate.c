@@ -51,7 +51,10 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <syslog.h>
+#include <unistd.h>
+#include <inttypes.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -991,6 +994,150 @@ yang2cli_stmt(clicon_handle h,
     return retval;
 }
 
+/*! Get filename of generated CLI syntax in the yang cache directory
+ *
+ * The generated syntax is cached if the yang spec has a cache key, see 
+ * CLICON_YANG_CACHE_DIR. The key covers the yang files and all options.
+ * Not if CLICON_YANG_LAZY is set since modules may then be loaded later.
+ * @param[in]  h         Clixon handle
+ * @param[in]  yspec     Yang spec
+ * @param[in]  state     Set to include state syntax
+ * @param[in]  show_tree Is tree for show cli command
+ * @param[out] cb        Filename
+ * @retval     1         OK
+ * @retval     0         No cache
+ */
+static int
+yang2cli_cache_filename(clicon_handle h,
+			yang_stmt    *yspec,
+			int           state,
+			int           show_tree,
+			cbuf         *cb)
+{
+    uint64_t key;
+
+    if (yang_keyword_get(yspec) != Y_SPEC ||
+	clicon_option_bool(h, "CLICON_YANG_LAZY") ||
+	yang_cache_key_get(h, yspec, &key) == 0)
+	return 0;
+    cprintf(cb, "%s/%016" PRIx64 "-%d%d.cli", 
+	    clicon_option_str(h, "CLICON_YANG_CACHE_DIR"), key, state, show_tree);
+    return 1;
+}
+
+/*! Read generated CLI syntax from cache file
+ * @param[in]  filename  Cache file
+ * @param[out] cb        Generated CLI syntax
+ * @retval     1         OK
+ * @retval     0         No cache file
+ * @retval    -1         Error
+ */
+static int
+yang2cli_cache_read(char *filename,
+		    cbuf *cb)
+{
+    int         retval = -1;
+    FILE       *f = NULL;
+    char        buf[BUFSIZ];
+    size_t      len;
+
+    if ((f = fopen(filename, "r")) == NULL){
+	retval = 0;
+	goto done;
+    }
+    while ((len = fread(buf, 1, sizeof(buf), f)) > 0)
+	if (cbuf_append_buf(cb, buf, len) < 0){
+	    clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+	    goto done;
+	}
+    if (ferror(f)){
+	clicon_err(OE_UNIX, errno, "fread %s", filename);
+	goto done;
+    }
+    retval = 1;
+ done:
+    if (f)
+	fclose(f);
+    return retval;
+}
+
+/*! Write generated CLI syntax to cache file, not fatal if it fails
+ * @param[in]  filename  Cache file
+ * @param[in]  cb        Generated CLI syntax
+ */
+static int
+yang2cli_cache_write(char *filename,
+		     cbuf *cb)
+{
+    int   retval = -1;
+    cbuf *cbtmp = NULL;
+    FILE *f = NULL;
+
+    if ((cbtmp = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cbtmp, "%s.%d", filename, getpid());
+    if ((f = fopen(cbuf_get(cbtmp), "w")) == NULL){
+	clicon_log(LOG_WARNING, "%s: %s: %s", __FUNCTION__, cbuf_get(cbtmp), strerror(errno));
+	goto ok;
+    }
+    if (fwrite(cbuf_get(cb), 1, cbuf_len(cb), f) != cbuf_len(cb) ||
+	fclose(f) < 0){
+	clicon_log(LOG_WARNING, "%s: %s: %s", __FUNCTION__, cbuf_get(cbtmp), strerror(errno));
+	f = NULL;
+	unlink(cbuf_get(cbtmp));
+	goto ok;
+    }
+    f = NULL;
+    if (rename(cbuf_get(cbtmp), filename) < 0){
+	clicon_log(LOG_WARNING, "%s: %s: %s", __FUNCTION__, filename, strerror(errno));
+	unlink(cbuf_get(cbtmp));
+    }
+ ok:
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (cbtmp)
+	cbuf_free(cbtmp);
+    return retval;
+}
+
+/*! Check if a top-level yang node is matched by a word of the command, see CLICON_CLI_AUTOCLI_LAZY
+ *
+ * A word matches if it is a prefix of the node name, since cligen accepts
+ * abbreviated keywords.
+ * @param[in]  ys     Yang statement, child of module
+ * @param[in]  words  Words of command
+ * @param[in]  nwords Length of words
+ * @retval     1      Match, or not a data node
+ * @retval     0      No match
+ */
+static int
+yang2cli_lazy_match(yang_stmt *ys,
+		    char     **words,
+		    int        nwords)
+{
+    char *name;
+    int   i;
+
+    switch (yang_keyword_get(ys)){
+    case Y_CONTAINER:
+    case Y_LIST:
+    case Y_LEAF:
+    case Y_LEAF_LIST:
+	name = yang_argument_get(ys);
+	for (i=0; i<nwords; i++)
+	    if (words[i] && strlen(words[i]) &&
+		strncmp(name, words[i], strlen(words[i])) == 0)
+		return 1;
+	return 0;
+    default:
+	return 1;
+    }
+}
+
 /*! Generate CLI code for Yang specification
  * @param[in]  h         Clixon handle
  * @param[in]  yn        Create parse-tree from this yang node
@@ -1018,6 +1165,13 @@ yang2cli(clicon_handle      h,
     char        **exvec = NULL;
     int           nexvec = 0;
     int           e;
+    cbuf         *cbfile = NULL;
+    int           cached = 0;
+    int           ret;
+    char         *words = NULL;
+    char        **wvec = NULL;
+    int           nwvec = 0;
+    yang_stmt    *ys;
     
     if (pt == NULL){
 	clicon_err(OE_YANG, EINVAL, "pt is NULL");
@@ -1033,6 +1187,24 @@ yang2cli(clicon_handle      h,
 	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
     }
+    if ((cbfile = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    /* Only generate top-level nodes matching the command, see cli_main */
+    if (clicon_data_get(h, "cli-autocli-words", &words) == 0 && words != NULL){
+	if ((wvec = clicon_strsep(words, " \t", &nwvec)) == NULL)
+	    goto done;
+    }
+    /* Use generated CLI syntax of earlier start if cached */
+    if (wvec == NULL &&
+	(cached = yang2cli_cache_filename(h, yn, state, show_tree, cbfile)) == 1 &&
+	(ret = yang2cli_cache_read(cbuf_get(cbfile), cb)) != 0){
+	if (ret < 0)
+	    goto done;
+	clicon_debug(1, "%s %s loaded", __FUNCTION__, cbuf_get(cbfile));
+	goto parse;
+    }
     /* Traverse YANG, loop through all modules and generate CLI */
     yc = NULL;
     while ((yc = yn_each(yn, yc)) != NULL){
@@ -1043,9 +1215,21 @@ yang2cli(clicon_handle      h,
 	}
 	if (e < nexvec)
 	    continue;
+	if (wvec != NULL &&
+	    (yang_keyword_get(yc) == Y_MODULE || yang_keyword_get(yc) == Y_SUBMODULE)){
+	    ys = NULL;
+	    while ((ys = yn_each(yc, ys)) != NULL)
+		if (yang2cli_lazy_match(ys, wvec, nwvec) &&
+		    yang2cli_stmt(h, ys, gt, 1, state, show_tree, cb) < 0)
+		    goto done;
+	    continue;
+	}
 	if (yang2cli_stmt(h, yc, gt, 0, state, show_tree, cb) < 0)
 	    goto done;
     }
+    if (cached && yang2cli_cache_write(cbuf_get(cbfile), cb) < 0)
+	goto done;
+ parse:
     if (printgen)
 	clicon_log(LOG_NOTICE, "%s: Generated CLI spec:\n%s", __FUNCTION__, cbuf_get(cb));
     else
@@ -1069,6 +1253,10 @@ yang2cli(clicon_handle      h,
   done:
     if (exvec)
 	free(exvec);
+    if (wvec)
+	free(wvec);
+    if (cbfile)
+	cbuf_free(cbfile);
     if (cb)
 	cbuf_free(cb);
     return retval;
@@ -70,9 +70,10 @@
 #include "cli_generate.h"
 #include "cli_common.h"
 #include "cli_handle.h"
+#include "cli_server.h"
 
 /* Command line options to be passed to getopt(3) */
-#define CLI_OPTS "hD:f:E:l:F:1a:u:d:m:qp:GLy:c:U:o:"
+#define CLI_OPTS "hD:f:E:l:F:1a:u:d:m:qp:GLy:c:U:o:SA:"
 
 /*! Check if there is a CLI history file and if so dump the CLI histiry to it
  * Just log if file does not exist or is not readable
@@ -177,7 +178,10 @@ cli_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     clicon_data_cvec_del(h, "cli-edit-cvv");;
+    cli_auto_cache_free(h);
     xpath_optimize_exit();
+    ctx_nodeset_pool_free();
+    xpath_cache_clear();
     cli_plugin_finish(h);    
     cli_history_save(h);
     cli_handle_exit(h);
@@ -380,7 +384,9 @@ usage(clicon_handle h,
 	    "\t-y <file>\tOverride yang spec file (dont include .yang suffix)\n"
 	    "\t-c <file>\tSpecify cli spec file.\n"
 	    "\t-U <user>\tOver-ride unix user with a pseudo user for NACM.\n"
-	    "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n",
+	    "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n"
+	    "\t-S \t\tRun as persistent CLI server on CLICON_CLI_SERVER_SOCK\n"
+	    "\t-A <sock>\tAttach to persistent CLI server on <sock>, no other options apply except -1\n",
 	    argv0,
 	    plgdir ? plgdir : "none"
 	);
@@ -414,6 +420,8 @@ main(int    argc,
     size_t         cligen_bufthreshold;
     int            dbg=0;
     int            nr;
+    int            server = 0;
+    char          *attach = NULL;
     
     /* Defaults */
     once = 0;
@@ -475,6 +483,14 @@ main(int    argc,
 		clicon_log_file(optarg+1) < 0)
 		goto done;
 	    break;
+	case 'A': /* attach to persistent cli server */
+	    if (!strlen(optarg))
+		usage(h, argv[0]);
+	    attach = optarg;
+	    break;
+	case '1' : /* see below, also for -A */
+	    once = 1;
+	    break;
 	}
     /* 
      * Logs, error and debug to stderr or syslog, set debug level
@@ -483,6 +499,18 @@ main(int    argc,
 
     clicon_debug_init(dbg, NULL); 
 
+    /* Attach to a persistent cli server, no config, yang or clispec is loaded here */
+    if (attach){
+	if ((restarg = clicon_strjoin(argc-optind, argv+optind, " ")) == NULL){
+	    clicon_err(OE_UNIX, errno, "clicon_strjoin");
+	    goto done;
+	}
+	retval = cli_server_attach(h, attach, once, restarg);
+	free(restarg);
+	cli_handle_exit(h);
+	return retval;
+    }
+
     /* Find, read and parse configfile */
     if (clicon_options_main(h) < 0){
         if (help)
@@ -498,6 +526,7 @@ main(int    argc,
 	case 'f': /* config file */
 	case 'E': /* extra config dir */
 	case 'l': /* Log destination */
+	case 'A': /* Attach to server */
 	    break; /* see above */
 	case 'F': /* read commands from file */
 	    if (freopen(optarg, "r", stdin) == NULL){
@@ -555,6 +584,9 @@ main(int    argc,
 	    if (clicon_username_set(h, optarg) < 0)
 		goto done;
 	    break;
+	case 'S': /* Persistent cli server */
+	    server = 1;
+	    break;
 	case 'o':{ /* Configuration option */
 	    char          *val;
 	    if ((val = index(optarg, '=')) == NULL)
@@ -676,6 +708,15 @@ main(int    argc,
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
 	goto done;
 
+    /* Join rest of argv to a single command */
+    restarg = clicon_strjoin(argc, argv, " ");
+
+    /* Only generate autocli for the command, not for interactive mode */
+    if (once && restarg != NULL && strlen(restarg) &&
+	clicon_option_bool(h, "CLICON_CLI_AUTOCLI_LAZY") &&
+	clicon_data_set(h, "cli-autocli-words", restarg) < 0)
+	goto done;
+
     /* Create autocli from YANG */
     if (autocli_start(h, printgen) < 0)
 	goto done;
@@ -711,9 +752,6 @@ main(int    argc,
     if (dbg)
 	clicon_option_dump(h, dbg);
     
-    /* Join rest of argv to a single command */
-    restarg = clicon_strjoin(argc, argv, " ");
-
     /* If several cligen object variables match same preference, select first */
     cligen_preference_mode_set(cli_cligen(h), 1);
 
@@ -728,6 +766,22 @@ main(int    argc,
 	goto done;
     /* Experimental utf8 mode */
     cligen_utf8_set(cli_cligen(h), clicon_option_int(h,"CLICON_CLI_UTF8"));
+    /* Timing of commands, see CLICON_CLI_TIMING */
+    if (clicon_option_bool(h, "CLICON_CLI_TIMING") &&
+	cli_timing_enable(h) < 0)
+	goto done;
+    /* Persistent cli server: each attach client continues below in a session process */
+    if (server){
+	if (restarg){
+	    free(restarg);
+	    restarg = NULL;
+	}
+	if (cli_server_run(h, &restarg, &once) < 0)
+	    goto done;
+	/* History of the user of the session */
+	if (cli_history_load(h) < 0)
+	    goto done;
+    }
     /* Launch interfactive event loop, unless -1 */
     if (restarg != NULL && strlen(restarg)){
 	char         *mode = cli_syntax_mode(h);
@@ -743,8 +797,16 @@ main(int    argc,
     }
 
     /* Go into event-loop unless -1 command-line */
-    if (!once)
+    if (!once){
+	/* Batch edits of commands from a pipe or file, see CLICON_CLI_BATCH */
+	if (clicon_option_bool(h, "CLICON_CLI_BATCH") && !isatty(0) &&
+	    cli_batch_begin(h, NULL, NULL) < 0)
+	    goto done;
 	retval = cli_interactive(h);
+	/* Send edits accumulated until end of input */
+	if (cli_batch_flush(h) < 0)
+	    retval = -1;
+    }
     else
 	retval = 0;
   done:
@@ -753,7 +815,9 @@ main(int    argc,
     // Gets in your face if we log on stderr
     clicon_log_init(__PROGRAM__, LOG_INFO, 0); /* Log on syslog no stderr */
     clicon_log(LOG_NOTICE, "%s: %u Terminated", __PROGRAM__, getpid());
-    if (h)
+    if (h){
+	cli_server_exit(h, retval);
 	cli_terminate(h);
+    }
     return retval;
 }
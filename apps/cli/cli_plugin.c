@@ -68,6 +68,7 @@
 #include "cli_plugin.h"
 #include "cli_handle.h"
 #include "cli_generate.h"
+#include "cli_common.h"
 
 
 /*
@@ -75,6 +76,11 @@
  */
 #define CLI_DEFAULT_PROMPT	"cli> "
 
+/* Resolved callback functions of clispec files, see clixon_str2fn
+ * Key is "<handle>:<name>", value is the function pointer
+ */
+static clicon_hash_t *_str2fn_cache = NULL;
+
 /*
  *
  * CLI PLUGIN INTERFACE, INTERNAL SECTION
@@ -192,6 +198,17 @@ cli_syntax_unload(clicon_handle h)
     return 0;
 }
 
+/*! Free cache of resolved callback functions, eg when plugins are unloaded
+ */
+static void
+cli_str2fn_cache_free(void)
+{
+    if (_str2fn_cache){
+	clicon_hash_free(_str2fn_cache);
+	_str2fn_cache = NULL;
+    }
+}
+
 /*! Dynamic linking loader string to function mapper
  *
  * Maps strings from the CLI specification file to real funtions using dlopen 
@@ -206,13 +223,16 @@ cli_syntax_unload(clicon_handle h)
  * @retval     NULL    Function not found or symbol NULL (check error for proper handling)
  * @see see cli_plugin_load where (optional) handle opened
  * @note the returned function is not type-checked which may result in segv at runtime
+ * @note resolved names are cached, a plugin handle must not be reused for another .so
  */
 void *
 clixon_str2fn(char  *name, 
 	      void  *handle, 
 	      char **error)
 {
-    void *fn = NULL;
+    void  *fn = NULL;
+    void **fnp;
+    char   key[MAXPATHLEN];
 	
     /* Reset error */
     *error = NULL;
@@ -221,13 +241,23 @@ clixon_str2fn(char  *name,
      */
     if (strcmp(name, GENERATE_CALLBACK) == 0)
 	return NULL;
+    /* The same callbacks are used many times in clispec files, dlsym each name once */
+    snprintf(key, sizeof(key), "%p:%s", handle, name);
+    if (_str2fn_cache != NULL &&
+	(fnp = clicon_hash_value(_str2fn_cache, key, NULL)) != NULL)
+	return *fnp;
+    if (_str2fn_cache == NULL)
+	_str2fn_cache = clicon_hash_init(); /* If NULL, no caching */
 
     /* First check given plugin if any */
     if (handle) {
 	dlerror();	/* Clear any existing error */
 	fn = dlsym(handle, name);
-	if ((*error = (char*)dlerror()) == NULL)
+	if ((*error = (char*)dlerror()) == NULL){
+	    if (_str2fn_cache)
+		clicon_hash_add(_str2fn_cache, key, &fn, sizeof(fn));
 	    return fn;  /* If no error we found the address of the callback */
+	}
     }
 
     /* Now check global namespace which includes any shared object loaded
@@ -238,8 +268,11 @@ clixon_str2fn(char  *name,
     /* RTLD_DEFAULT instead of NULL for linux + FreeBSD:
      * Use default search algorithm. Thanks jdl@netgate.com */
     fn = dlsym(RTLD_DEFAULT, name);
-    if ((*error = (char*)dlerror()) == NULL)
+    if ((*error = (char*)dlerror()) == NULL){
+	if (_str2fn_cache)
+	    clicon_hash_add(_str2fn_cache, key, &fn, sizeof(fn));
 	return fn;  /* If no error we found the address of the callback */
+    }
 
     /* Return value not really relevant here as the error string is set to
      * signal an error. However, just checking the function pointer for NULL
@@ -472,6 +505,7 @@ done:
 	clixon_plugin_exit_all(h);
 	cli_syntax_unload(h);
 	cli_syntax_set(h, NULL);
+	cli_str2fn_cache_free();
     }
     cligen_parsetree_free(ptall, 1);
     if (dp)
@@ -490,6 +524,7 @@ cli_plugin_finish(clicon_handle h)
     /* Remove all cligen syntax modes */
     cli_syntax_unload(h);
     cli_syntax_set(h, NULL);
+    cli_str2fn_cache_free();
     return 0;
 }
 
@@ -529,6 +564,9 @@ clicon_eval(clicon_handle h,
     cli_output_reset();
     if (!cligen_exiting(cli_cligen(h))) {	
 	clicon_err_reset();
+	/* Accumulated edits of batch mode are sent before other commands */
+	if (cli_batch_eval(h, match_obj) < 0)
+	    return -1;
 	if ((retval = cligen_eval(cli_cligen(h), match_obj, cvv)) < 0) {
 #if 0 /* This is removed since we get two error messages on failure.
 	 But maybe only sometime?
@@ -607,8 +645,10 @@ clicon_parse(clicon_handle  h,
 	    clicon_err(OE_UNIX, errno, "cvec_new");
 	    goto done;;
 	}
+	cli_timing_begin(h, CT_PARSE);
 	if (cliread_parse(cli_cligen(h), cmd, pt, &match_obj, cvv, result, &reason) < 0)
 	    goto done;
+	cli_timing_begin(h, CT_RPC);
 	/* Debug command and result code */
 	clicon_debug(1, "%s result:%d command: \"%s\"", __FUNCTION__, *result, cmd);
 	if (*result != CG_MATCH)
@@ -632,6 +672,7 @@ clicon_parse(clicon_handle  h,
 	    }
 	    if ((r = clicon_eval(h, cmd, match_obj, cvv)) < 0)
 		cli_handler_err(stdout);
+	    cli_timing_end(h);
 	    pt_expand_cleanup(pt);
 	    pt_expand_treeref_cleanup(pt);
 	    if (evalres)
@@ -0,0 +1,546 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Persistent CLI server and thin attach client, see CLICON_CLI_SERVER_SOCK
+ *
+ * The server is a clixon_cli started with -S. It makes the full startup once: plugins,
+ * yang, autocli and clispecs, and then listens on a unix socket. An attach client
+ * (clixon_cli -A <sock>) passes its stdin, stdout and stderr to the server which forks a
+ * session process with the parse-trees already in place. The session runs as the uid of
+ * the client, reads and writes the terminal of the client, and has its own backend
+ * session. When it terminates, its exit status is sent back to the client.
+ *
+ * Protocol on the unix socket:
+ *   client -> server:  <once:uint32><len:uint32> + SCM_RIGHTS(0,1,2), then <len> bytes cmd
+ *   server -> client:  <pid:uint32> when the session is started
+ *   server -> client:  <status:uint32> when the session terminates
+ * All integers in network byte order
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <syslog.h>
+#include <errno.h>
+#include <signal.h>
+#include <pwd.h>
+#include <grp.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+#define __USE_GNU   /* for ucred */
+#define _GNU_SOURCE /* for ucred */
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "clixon_cli_api.h"
+
+#include "cli_plugin.h"
+#include "cli_common.h"
+#include "cli_handle.h"
+#include "cli_server.h"
+
+/* Max length of a command sent by an attach client */
+#define CLI_SERVER_CMD_MAX 65536
+
+/* Session process that signals are forwarded to in the attach client */
+static pid_t _attach_pid = 0;
+
+/*! Write all of a buffer to a socket, restart on interrupts
+ * @param[in]  s    Socket
+ * @param[in]  buf  Buffer
+ * @param[in]  len  Length of buffer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+cli_server_write(int    s,
+		 void  *buf,
+		 size_t len)
+{
+    ssize_t n;
+    char   *p = buf;
+
+    while (len > 0){
+	if ((n = write(s, p, len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "write");
+	    return -1;
+	}
+	p += n;
+	len -= n;
+    }
+    return 0;
+}
+
+/*! Read all of a buffer from a socket, restart on interrupts
+ * @param[in]  s    Socket
+ * @param[out] buf  Buffer
+ * @param[in]  len  Length of buffer
+ * @retval     1    OK
+ * @retval     0    Closed by peer
+ * @retval    -1    Error
+ */
+static int
+cli_server_read(int    s,
+		void  *buf,
+		size_t len)
+{
+    ssize_t n;
+    char   *p = buf;
+
+    while (len > 0){
+	if ((n = read(s, p, len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "read");
+	    return -1;
+	}
+	if (n == 0)
+	    return 0;
+	p += n;
+	len -= n;
+    }
+    return 1;
+}
+
+/*! Create, bind and listen to the unix server socket
+ * @param[in]  sockpath  Unix domain file path
+ * @retval     s         Server socket
+ * @retval    -1         Error
+ */
+static int
+cli_server_socket(char *sockpath)
+{
+    int                s = -1;
+    struct sockaddr_un addr = {0,};
+
+    if (strlen(sockpath) >= sizeof(addr.sun_path)){
+	clicon_err(OE_UNIX, EINVAL, "Socket path too long: %s", sockpath);
+	goto err;
+    }
+    if ((s = socket(AF_UNIX, SOCK_STREAM, 0)) < 0){
+	clicon_err(OE_UNIX, errno, "socket");
+	goto err;
+    }
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sockpath, sizeof(addr.sun_path)-1);
+    unlink(sockpath);
+    if (bind(s, (struct sockaddr *)&addr, SUN_LEN(&addr)) < 0){
+	clicon_err(OE_UNIX, errno, "bind: %s", sockpath);
+	goto err;
+    }
+    /* Access is checked per connection with the peer credentials */
+    if (chmod(sockpath, S_IRWXU|S_IRWXG|S_IRWXO) < 0){
+	clicon_err(OE_UNIX, errno, "chmod: %s", sockpath);
+	goto err;
+    }
+    if (listen(s, 5) < 0){
+	clicon_err(OE_UNIX, errno, "listen");
+	goto err;
+    }
+    return s;
+ err:
+    if (s != -1)
+	close(s);
+    return -1;
+}
+
+/*! Get uid of the process connected to a unix socket
+ * @param[in]  s    Connected socket
+ * @param[out] uid  Uid of peer
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+cli_server_peer(int    s,
+		uid_t *uid)
+{
+#if defined(HAVE_SO_PEERCRED)
+    socklen_t    clen;
+    struct ucred cr = {0,};
+
+    clen = sizeof(cr);
+    if (getsockopt(s, SOL_SOCKET, SO_PEERCRED, &cr, &clen) < 0){
+	clicon_err(OE_UNIX, errno, "getsockopt");
+	return -1;
+    }
+    *uid = cr.uid;
+#elif defined(HAVE_GETPEEREID)
+    gid_t        gid;
+
+    if (getpeereid(s, uid, &gid) < 0){
+	clicon_err(OE_UNIX, errno, "getpeereid");
+	return -1;
+    }
+#else
+#error "Need getsockopt O_PEERCRED or getpeereid for unix socket peer cred"
+#endif
+    return 0;
+}
+
+/*! Receive the header and the terminal of an attach client
+ * @param[in]  s     Connected socket
+ * @param[out] once  Do not enter interactive mode
+ * @param[out] len   Length of command that follows
+ * @param[out] fds   Stdin, stdout and stderr of the client
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+cli_server_recv(int       s,
+		int      *once,
+		uint32_t *len,
+		int       fds[3])
+{
+    struct msghdr   msg = {0,};
+    struct cmsghdr *cmsg;
+    struct iovec    iov;
+    uint32_t        hdr[2];
+    char            buf[CMSG_SPACE(3*sizeof(int))];
+    ssize_t         n;
+
+    iov.iov_base = hdr;
+    iov.iov_len = sizeof(hdr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+    if ((n = recvmsg(s, &msg, 0)) < 0){
+	clicon_err(OE_UNIX, errno, "recvmsg");
+	return -1;
+    }
+    if ((cmsg = CMSG_FIRSTHDR(&msg)) == NULL ||
+	cmsg->cmsg_level != SOL_SOCKET ||
+	cmsg->cmsg_type != SCM_RIGHTS ||
+	cmsg->cmsg_len != CMSG_LEN(3*sizeof(int))){
+	clicon_err(OE_PROTO, 0, "No terminal received from attach client");
+	return -1;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), 3*sizeof(int));
+    if (n != sizeof(hdr) && cli_server_read(s, (char*)hdr+n, sizeof(hdr)-n) != 1){
+	clicon_err(OE_PROTO, 0, "Short header from attach client");
+	return -1;
+    }
+    *once = ntohl(hdr[0]);
+    *len = ntohl(hdr[1]);
+    return 0;
+}
+
+/*! Set up a forked session process for an attach client
+ *
+ * Take over the terminal of the client, run as the user of the client and reset the
+ * backend session inherited from the server. HOME is set to the one of the user, the
+ * caller loads the history of the user.
+ * @param[in]  h     Clixon handle
+ * @param[in]  s     Connected socket
+ * @param[out] cmd   Command to run, or NULL. Free with free()
+ * @param[out] once  Do not enter interactive mode
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+cli_server_session(clicon_handle h,
+		   int           s,
+		   char        **cmd,
+		   int          *once)
+{
+    int            retval = -1;
+    int            fds[3] = {-1, -1, -1};
+    uint32_t       len;
+    uid_t          uid;
+    struct passwd *pw;
+    uint32_t       pid;
+    int            i;
+    int            bs;
+
+    if (cli_server_peer(s, &uid) < 0)
+	goto done;
+    /* A server not run as root can only serve its own user */
+    if (geteuid() != 0 && uid != geteuid()){
+	clicon_err(OE_UNIX, EACCES, "Attach client uid %u not allowed", uid);
+	goto done;
+    }
+    if ((pw = getpwuid(uid)) == NULL){
+	clicon_err(OE_UNIX, errno, "getpwuid");
+	goto done;
+    }
+    if (cli_server_recv(s, once, &len, fds) < 0)
+	goto done;
+    if (len > CLI_SERVER_CMD_MAX){
+	clicon_err(OE_PROTO, 0, "Attach command too long: %u", len);
+	goto done;
+    }
+    if (len){
+	if ((*cmd = calloc(len+1, 1)) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+	if (cli_server_read(s, *cmd, len) != 1)
+	    goto done;
+    }
+    for (i=0; i<3; i++){
+	if (dup2(fds[i], i) < 0){
+	    clicon_err(OE_UNIX, errno, "dup2");
+	    goto done;
+	}
+	if (fds[i] > 2)
+	    close(fds[i]);
+	fds[i] = -1;
+    }
+    if (geteuid() == 0 && uid != 0){
+	if (initgroups(pw->pw_name, pw->pw_gid) < 0 ||
+	    setgid(pw->pw_gid) < 0 ||
+	    setuid(uid) < 0){
+	    clicon_err(OE_UNIX, errno, "Drop privileges to %s", pw->pw_name);
+	    goto done;
+	}
+    }
+    if (setenv("HOME", pw->pw_dir, 1) < 0 ||
+	setenv("USER", pw->pw_name, 1) < 0){
+	clicon_err(OE_UNIX, errno, "setenv");
+	goto done;
+    }
+    if (clicon_username_set(h, pw->pw_name) < 0)
+	goto done;
+    /* Open a new backend session on first rpc, do not share the one of the server */
+    if ((bs = clicon_client_socket_get(h)) != -1){
+	close(bs);
+	clicon_client_socket_set(h, -1);
+    }
+    clicon_hash_del(clicon_data(h), "session-id");
+    if (clicon_hash_add(clicon_data(h), "cli-server-session", &s, sizeof(s)) == NULL)
+	goto done;
+    pid = htonl(getpid());
+    if (cli_server_write(s, &pid, sizeof(pid)) < 0)
+	goto done;
+    clicon_debug(1, "%s: %u Session started for %s", __FUNCTION__, getpid(), pw->pw_name);
+    retval = 0;
+ done:
+    for (i=0; i<3; i++)
+	if (fds[i] != -1)
+	    close(fds[i]);
+    return retval;
+}
+
+/*! Run the persistent CLI server, see CLICON_CLI_SERVER_SOCK
+ *
+ * Accept attach clients and fork a session process for each of them. The server
+ * itself never returns unless on error; the session process returns with the
+ * command of the client and then runs as a regular CLI.
+ * @param[in]  h     Clixon handle, fully initialized
+ * @param[out] cmd   Command to run in the session, or NULL. Free with free()
+ * @param[out] once  Do not enter interactive mode in the session
+ * @retval     1     In session process
+ * @retval    -1     Error
+ * @see cli_server_attach  The attach client
+ */
+int
+cli_server_run(clicon_handle h,
+	       char        **cmd,
+	       int          *once)
+{
+    int      retval = -1;
+    char    *sockpath;
+    int      ss = -1;
+    int      s;
+    pid_t    pid;
+
+    if ((sockpath = clicon_option_str(h, "CLICON_CLI_SERVER_SOCK")) == NULL){
+	clicon_err(OE_CFG, 0, "CLICON_CLI_SERVER_SOCK not set");
+	goto done;
+    }
+    if ((ss = cli_server_socket(sockpath)) < 0)
+	goto done;
+    /* Sessions are not waited for */
+    if (set_signal(SIGCHLD, SIG_IGN, NULL) < 0)
+	goto done;
+    clicon_signal_unblock(SIGCHLD);
+    clicon_log(LOG_NOTICE, "%s: %u Server started on %s", __PROGRAM__, getpid(), sockpath);
+    while (1){
+	if ((s = accept(ss, NULL, NULL)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "accept");
+	    goto done;
+	}
+	if ((pid = fork()) < 0){
+	    clicon_err(OE_UNIX, errno, "fork");
+	    close(s);
+	    continue;
+	}
+	if (pid == 0){ /* Session process */
+	    close(ss);
+	    ss = -1;
+	    if (set_signal(SIGCHLD, SIG_DFL, NULL) < 0)
+		exit(1);
+	    cli_signal_block(h);
+	    if (cli_server_session(h, s, cmd, once) < 0){
+		clicon_log(LOG_WARNING, "%s: %u Session failed: %s", __PROGRAM__, getpid(),
+			   clicon_err_reason);
+		exit(1);
+	    }
+	    retval = 1;
+	    goto done;
+	}
+	close(s);
+    }
+ done:
+    if (ss != -1)
+	close(ss);
+    return retval;
+}
+
+/*! Send exit status of a session process to its attach client
+ * @param[in]  h       Clixon handle
+ * @param[in]  status  Return value of main, 0 is OK
+ * @retval     0       OK, also if not a session process
+ * @retval    -1       Error
+ */
+int
+cli_server_exit(clicon_handle h,
+		int           status)
+{
+    int     *sp;
+    uint32_t st;
+
+    if ((sp = clicon_hash_value(clicon_data(h), "cli-server-session", NULL)) == NULL)
+	return 0;
+    st = htonl(status & 0xff); /* As exit status of a cli process */
+    if (cli_server_write(*sp, &st, sizeof(st)) < 0)
+	return -1;
+    close(*sp);
+    clicon_hash_del(clicon_data(h), "cli-server-session");
+    return 0;
+}
+
+/*! Forward a signal of the attach client to its session process
+ */
+static void
+cli_attach_sig(int sig)
+{
+    if (_attach_pid > 0)
+	kill(_attach_pid, sig);
+}
+
+/*! Attach to a persistent CLI server and run a session, see CLICON_CLI_SERVER_SOCK
+ *
+ * Passes stdin, stdout and stderr to the server, forwards signals to the session
+ * process and waits until it terminates. No config, yang or clispec is loaded.
+ * @param[in]  h         Clixon handle
+ * @param[in]  sockpath  Unix socket of the server
+ * @param[in]  once      Do not enter interactive mode
+ * @param[in]  cmd       Command to run, or NULL
+ * @retval     status    Exit status of the session
+ * @retval    -1         Error
+ * @see cli_server_run  The server
+ */
+int
+cli_server_attach(clicon_handle h,
+		  char         *sockpath,
+		  int           once,
+		  char         *cmd)
+{
+    int             retval = -1;
+    int             s = -1;
+    struct msghdr   msg = {0,};
+    struct cmsghdr *cmsg;
+    struct iovec    iov;
+    uint32_t        hdr[2];
+    int             fds[3] = {0, 1, 2};
+    char            buf[CMSG_SPACE(sizeof(fds))];
+    size_t          len;
+    uint32_t        val;
+    int             ret;
+    int             sigs[] = {SIGINT, SIGQUIT, SIGTERM, SIGHUP, SIGWINCH, 0};
+    int             i;
+
+    len = cmd ? strlen(cmd) : 0;
+    if ((s = clicon_connect_unix(h, sockpath)) < 0)
+	goto done;
+    hdr[0] = htonl(once);
+    hdr[1] = htonl(len);
+    memset(buf, 0, sizeof(buf));
+    iov.iov_base = hdr;
+    iov.iov_len = sizeof(hdr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = buf;
+    msg.msg_controllen = sizeof(buf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    if (sendmsg(s, &msg, 0) < 0){
+	clicon_err(OE_UNIX, errno, "sendmsg");
+	goto done;
+    }
+    if (len && cli_server_write(s, cmd, len) < 0)
+	goto done;
+    if ((ret = cli_server_read(s, &val, sizeof(val))) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_PROTO, 0, "Session refused by CLI server %s", sockpath);
+	goto done;
+    }
+    _attach_pid = ntohl(val);
+    for (i=0; sigs[i]; i++)
+	if (set_signal(sigs[i], cli_attach_sig, NULL) < 0)
+	    goto done;
+    if ((ret = cli_server_read(s, &val, sizeof(val))) < 0)
+	goto done;
+    retval = ret ? ntohl(val) : 255; /* Session terminated without status */
+ done:
+    if (s != -1)
+	close(s);
+    return retval;
+}
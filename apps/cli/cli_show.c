@@ -48,6 +48,7 @@
 #include <stdarg.h>
 #include <time.h>
 #include <ctype.h>
+#include <inttypes.h>
 
 #include <unistd.h>
 #include <dirent.h>
@@ -168,20 +169,15 @@ expand_dbvar(void   *h,
     char            *dbstr;    
     cxobj           *xt = NULL;
     char            *xpath = NULL;
-    cxobj          **xvec = NULL;
     cxobj           *xe; /* direct ptr */
     cxobj           *xerr = NULL; /* free */
-    size_t           xlen = 0;
     cxobj           *x;
     char            *bodystr;
-    int              i;
-    char            *bodystr0 = NULL; /* previous */
     cg_var          *cv;
     yang_stmt       *yspec;
     cxobj           *xtop = NULL; /* xpath root */
     cxobj           *xbot = NULL; /* xpath, NULL if datastore */
     yang_stmt       *y = NULL; /* yang spec of xpath */
-    yang_stmt       *yp;
     yang_stmt       *ytype;
     yang_stmt       *ypath;
     char            *reason = NULL;
@@ -290,50 +286,23 @@ expand_dbvar(void   *h,
 	if (xpath_myappend(cbxpath, yang_argument_get(ypath), y, nsc) < 0)
 	    goto done;
     }
-    /* Get configuration based on cbxpath */
-    if (clicon_rpc_get_config(h, NULL, dbstr, cbuf_get(cbxpath), nsc, &xt) < 0) 
+    /* Get values of xpath from configuration based on cbxpath.
+     * The backend removes duplicates and sends only the values
+     */
+    if (clicon_rpc_get_values(h, dbstr,
+			      strcmp(cbuf_get(cbxpath), xpath)==0?NULL:cbuf_get(cbxpath),
+			      xpath, nsc, NULL, 0, &xt) < 0) 
 	goto done;
     if ((xe = xpath_first(xt, NULL, "/rpc-error")) != NULL){
 	clixon_netconf_error(xe, "Get configuration", NULL);
 	goto ok; 
     }
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0) 
-	goto done;
-    /* Loop for inserting into commands cvec. 
-     * Detect duplicates: for ordered-by system assume list is ordered, so you need
-     * just remember previous
-     * but for ordered-by system, check the whole list
-     */
-    bodystr0 = NULL;
-    for (i = 0; i < xlen; i++) {
-	x = xvec[i];
-	if (xml_type(x) == CX_BODY)
-	    bodystr = xml_value(x);
-	else
-	    bodystr = xml_body(x);
-	if (bodystr == NULL)
-	    continue; /* no body, cornercase */
-	if ((y = xml_spec(x)) != NULL &&
-	    (yp = yang_parent_get(y)) != NULL &&
-	    yang_keyword_get(yp) == Y_LIST &&
-	    yang_find(yp, Y_ORDERED_BY, "user") != NULL){
-	    /* Detect duplicates linearly in existing values */
-	    {
-		cg_var *cv = NULL;
-		while ((cv = cvec_each(commands, cv)) != NULL)
-		    if (strcmp(cv_string_get(cv), bodystr) == 0)
-			break;
-		if (cv == NULL)
-		    cvec_add_string(commands, NULL, bodystr);
-	    }
-	}
-	else{
-	    if (bodystr0 && strcmp(bodystr, bodystr0) == 0)
-		continue; /* duplicate, assume sorted */
-	    bodystr0 = bodystr;
-	    /* RFC3986 decode */
-	    cvec_add_string(commands, NULL, bodystr);
-	}
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(x), "value") != 0 ||
+	    (bodystr = xml_body(x)) == NULL)
+	    continue;
+	cvec_add_string(commands, NULL, bodystr);
     }
  ok:
     retval = 0;
@@ -348,8 +317,6 @@ expand_dbvar(void   *h,
 	free(reason);
     if (api_path)
 	free(api_path);
-    if (xvec)
-	free(xvec);
     if (xtop)
 	xml_free(xtop);
     if (xt)
@@ -419,6 +386,10 @@ cli_show_config1(clicon_handle h,
     char            *namespace = NULL;
     cvec            *nsc = NULL;
     char            *prefix = NULL;
+    int              page = 0; /* Page size, 0 is no paging */
+    uint32_t         offset = 0;
+    cxobj          **xvec = NULL;
+    size_t           xlen = 0;
     
     if (cvec_len(argv) < 3 || cvec_len(argv) > 5){
 	clicon_err(OE_PLUGIN, EINVAL, "Got %d arguments. Expected: <dbname>,<format>,<xpath>[,<namespace>, [<prefix>]]", cvec_len(argv));
@@ -455,56 +426,83 @@ cli_show_config1(clicon_handle h,
     if (cvec_len(argv) > 4){
 	prefix = cv_string_get(cvec_i(argv, 4));
     }
-    if (state == 0){     /* Get configuration-only from database */
-	if (clicon_rpc_get_config(h, NULL, db, cbuf_get(cbxpath), nsc, &xt) < 0)
-	    goto done;
-    }
-    else {               /* Get configuration and state from database */
-	if (strcmp(db, "running") != 0){
-	    clicon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
-	    goto done;
+    /* CLI syntax is shown page by page, see CLICON_CLI_SHOW_PAGE.
+     * Each line has the whole path, so the text of the pages can be concatenated */
+    if (state == 0 && format == FORMAT_CLI)
+	page = clicon_option_int(h, "CLICON_CLI_SHOW_PAGE");
+    do {
+	if (state == 0){     /* Get configuration-only from database */
+	    if (clicon_rpc_get_config_page(h, NULL, db, cbuf_get(cbxpath), nsc,
+					   offset, page, &xt) < 0)
+		goto done;
 	}
-	if (clicon_rpc_get(h, cbuf_get(cbxpath), nsc, CONTENT_ALL, -1, &xt) < 0)
+	else {               /* Get configuration and state from database */
+	    if (strcmp(db, "running") != 0){
+		clicon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
+		goto done;
+	    }
+	    if (clicon_rpc_get(h, cbuf_get(cbxpath), nsc, CONTENT_ALL, -1, &xt) < 0)
+		goto done;
+	}
+	if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+	    clixon_netconf_error(xerr, "Get configuration", NULL);
 	    goto done;
-    }
-    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
-	clixon_netconf_error(xerr, "Get configuration", NULL);
-	goto done;
-    }
-    /* Print configuration according to format */
-    switch (format){
-    case FORMAT_XML:
-	xc = NULL; /* Dont print xt itself */
-	while ((xc = xml_child_each(xt, xc, -1)) != NULL)
-	    clicon_xml2file_cb(stdout, xc, 0, 1, cligen_output);
-	break;
-    case FORMAT_JSON:
-	xml2json_cb(stdout, xt, 1, cligen_output);
-	break;
-    case FORMAT_TEXT:
-	xc = NULL; /* Dont print xt itself */
-	while ((xc = xml_child_each(xt, xc, -1)) != NULL)
-	    xml2txt_cb(stdout, xc, cligen_output); /* tree-formed text */
-	break;
-    case FORMAT_CLI:
-	/* get CLI generatade mode: VARS|ALL */
-	if ((gt = clicon_cli_genmodel_type(h)) == GT_ERR)
+	}
+	/* Print configuration according to format */
+	cli_timing_begin(h, CT_RENDER);
+	switch (format){
+	case FORMAT_XML:
+	    xc = NULL; /* Dont print xt itself */
+	    while ((xc = xml_child_each(xt, xc, -1)) != NULL)
+		clicon_xml2file_cb(stdout, xc, 0, 1, cligen_output);
+	    break;
+	case FORMAT_JSON:
+	    xml2json_cb(stdout, xt, 1, cligen_output);
+	    break;
+	case FORMAT_TEXT:
+	    xc = NULL; /* Dont print xt itself */
+	    while ((xc = xml_child_each(xt, xc, -1)) != NULL)
+		xml2txt_cb(stdout, xc, cligen_output); /* tree-formed text */
+	    break;
+	case FORMAT_CLI:
+	    /* get CLI generatade mode: VARS|ALL */
+	    if ((gt = clicon_cli_genmodel_type(h)) == GT_ERR)
+		goto done;
+	    xc = NULL; /* Dont print xt itself */
+	    while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL)
+		xml2cli_cb(stdout, xc, prefix, gt, cligen_output); /* cli syntax */
+	    break;
+	case FORMAT_NETCONF:
+	    cligen_output(stdout, "<rpc xmlns=\"%s\"><edit-config><target><candidate/></target><config>\n",
+			  NETCONF_BASE_NAMESPACE);
+	    xc = NULL; /* Dont print xt itself */
+	    while ((xc = xml_child_each(xt, xc, -1)) != NULL)
+		clicon_xml2file_cb(stdout, xc, 2, 1, cligen_output);
+	    cligen_output(stdout, "</config></edit-config></rpc>]]>]]>\n");
+	    break;
+	case FORMAT_CBOR: /* Datastore format only, see CLICON_XMLDB_FORMAT */
+	    clicon_err(OE_PLUGIN, EINVAL, "Format cbor not supported");
 	    goto done;
-	xc = NULL; /* Dont print xt itself */
-	while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL)
-	    xml2cli_cb(stdout, xc, prefix, gt, cligen_output); /* cli syntax */
-	break;
-    case FORMAT_NETCONF:
-	cligen_output(stdout, "<rpc xmlns=\"%s\"><edit-config><target><candidate/></target><config>\n",
-		      NETCONF_BASE_NAMESPACE);
-	xc = NULL; /* Dont print xt itself */
-	while ((xc = xml_child_each(xt, xc, -1)) != NULL)
-	    clicon_xml2file_cb(stdout, xc, 2, 1, cligen_output);
-	cligen_output(stdout, "</config></edit-config></rpc>]]>]]>\n");
-	break;
-    }
+	}
+	cli_timing_render_end(h);
+	if (page){
+	    /* Last page if fewer nodes than page size is selected */
+	    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen,
+			  strlen(cbuf_get(cbxpath))?cbuf_get(cbxpath):"/") < 0)
+		goto done;
+	    if (xvec){
+		free(xvec);
+		xvec = NULL;
+	    }
+	    offset += page;
+	}
+	xml_free(xt);
+	xt = NULL;
+    } while (page && xlen == (size_t)page);
     retval = 0;
 done:
+    if (xvec)
+	free(xvec);
     if (nsc)
 	xml_nsctx_free(nsc);
     if (xt)
@@ -644,6 +642,63 @@ int cli_show_version(clicon_handle h,
     return 0;
 }
 
+/*! Show memory of backend and cli: XML objects, datastore caches, yang, NACM and streams
+ * @param[in]  h     CLICON handle
+ * @param[in]  cvv   Vector of variables from CLIgen command-line
+ * @param[in]  argv  Not used
+ * Each line is: <process> <subsystem> <number of objects> <size in bytes>
+ * CLIgen parse trees are not included
+ * @see from_client_stats  in the backend
+ */
+int
+cli_show_memory(clicon_handle h,
+		cvec         *cvv,
+		cvec         *argv)
+{
+    int        retval = -1;
+    cxobj     *xret = NULL;
+    cxobj     *xr;
+    cxobj     *x;
+    yang_stmt *yspec;
+    uint64_t   nr;
+    size_t     sz;
+    char      *name;
+
+    if (clicon_rpc_stats(h, &xret) < 0)
+	goto done;
+    fprintf(stdout, "%-8s %-24s %12s %14s\n", "process", "name", "nr", "size");
+    if ((xr = xpath_first(xret, NULL, "rpc-reply")) != NULL){
+	if ((x = xpath_first(xr, NULL, "global/xmlnr")) != NULL)
+	    fprintf(stdout, "%-8s %-24s %12s %14s\n", "backend", "xml", xml_body(x), "-");
+	x = NULL;
+	while ((x = xml_child_each(xr, x, CX_ELMNT)) != NULL){
+	    if (strcmp(xml_name(x), "datastore") != 0 && strcmp(xml_name(x), "memory") != 0)
+		continue;
+	    if ((name = xml_find_body(x, "name")) == NULL)
+		continue;
+	    fprintf(stdout, "%-8s %s%-*s %12s %14s\n", "backend",
+		    strcmp(xml_name(x), "datastore")==0?"datastore ":"",
+		    strcmp(xml_name(x), "datastore")==0?14:24, name,
+		    xml_find_body(x, "nr")?xml_find_body(x, "nr"):"0",
+		    xml_find_body(x, "size")?xml_find_body(x, "size"):"0");
+	}
+    }
+    nr = 0;
+    xml_stats_global(&nr);
+    fprintf(stdout, "%-8s %-24s %12" PRIu64 " %14s\n", "cli", "xml", nr, "-");
+    if ((yspec = clicon_dbspec_yang(h)) != NULL){
+	nr = 0; sz = 0;
+	if (yang_stats(yspec, &nr, &sz) < 0)
+	    goto done;
+	fprintf(stdout, "%-8s %-24s %12" PRIu64 " %14zu\n", "cli", "yang", nr, sz);
+    }
+    retval = 0;
+ done:
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
 /*! Generic show configuration CLIgen callback using generated CLI syntax
  * @param[in]  h     CLICON handle
  * @param[in]  state If set, show both config and state, otherwise only config
@@ -682,6 +737,10 @@ cli_show_auto1(clicon_handle h,
     enum rfc_6020    ys_keyword;
     int		     i = 0;
     int              cvvi = 0;
+    int              page = 0; /* Page size, 0 is no paging */
+    uint32_t         offset = 0;
+    cxobj          **xvec = NULL;
+    size_t           xlen = 0;
 
     if (cvec_len(argv) < 3 || cvec_len(argv) > 4){
 	clicon_err(OE_PLUGIN, EINVAL, "Usage: <api-path-fmt>* <database> <format> <prefix>. (*) generated.");
@@ -715,64 +774,86 @@ cli_show_auto1(clicon_handle h,
     if (xpath[strlen(xpath)-1] == '/')
 	xpath[strlen(xpath)-1] = '\0';
 
-    if (state == 0){   /* Get configuration-only from database */
-	if (clicon_rpc_get_config(h, NULL, db, xpath, nsc, &xt) < 0)
-	    goto done;
-    }
-    else{              /* Get configuration and state from database */
-	if (strcmp(db, "running") != 0){
-	    clicon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
-	    goto done;
+    /* A list is shown page by page, see CLICON_CLI_SHOW_PAGE */
+    if (state == 0 && format != FORMAT_CLI && format != FORMAT_NETCONF)
+	page = clicon_option_int(h, "CLICON_CLI_SHOW_PAGE");
+    do {
+	i = 0;
+	if (state == 0){   /* Get configuration-only from database */
+	    if (clicon_rpc_get_config_page(h, NULL, db, xpath, nsc, offset, page, &xt) < 0)
+		goto done;
 	}
-	if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, &xt) < 0)
-	    goto done;
-    }
-    if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
-	clixon_netconf_error(xerr, "Get configuration", NULL);
-	goto done;
-    }
-    if ((xp = xpath_first(xt, nsc, "%s", xpath)) != NULL){
-	/* Print configuration according to format */
-	ys_keyword = yang_keyword_get(xml_spec(xp));
-	if (ys_keyword == Y_LIST)
-		xp_helper = xml_child_i(xml_parent(xp), i);
-	else
-		xp_helper = xp;
-
-	switch (format){
-	case FORMAT_CLI:
-	    if ((gt = clicon_cli_genmodel_type(h)) == GT_ERR)
+	else{              /* Get configuration and state from database */
+	    if (strcmp(db, "running") != 0){
+		clicon_err(OE_FATAL, 0, "Show state only for running database, not %s", db);
 		goto done;
-	    xml2cli_cb(stdout, xp, prefix, gt, cligen_output); /* cli syntax */
-	    break;
-	case FORMAT_NETCONF:
-	    fprintf(stdout, "<rpc><edit-config><target><candidate/></target><config>\n");
-	    clicon_xml2file(stdout, xp, 2, 1);
-	    fprintf(stdout, "</config></edit-config></rpc>]]>]]>\n");
-	    break;
-	default:
-	    for (; i < xml_child_nr(xml_parent(xp)) ; ++i, xp_helper = xml_child_i(xml_parent(xp), i)) {
-		switch (format){
-		case FORMAT_XML:
-		    clicon_xml2file(stdout, xp_helper, 0, 1);
-		    break;
-		case FORMAT_JSON:
-		    xml2json_cb(stdout, xp_helper, 1, cligen_output);
-		    break;
-		case FORMAT_TEXT:	
-		    xml2txt_cb(stdout, xp_helper, cligen_output);  /* tree-formed text */
-		    break;
-		default: /* see cli_show_config() */
-		    break;
+	    }
+	    if (clicon_rpc_get(h, xpath, nsc, CONTENT_ALL, -1, &xt) < 0)
+		goto done;
+	}
+	if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+	    clixon_netconf_error(xerr, "Get configuration", NULL);
+	    goto done;
+	}
+	if ((xp = xpath_first(xt, nsc, "%s", xpath)) != NULL){
+	    /* Print configuration according to format */
+	    ys_keyword = yang_keyword_get(xml_spec(xp));
+	    if (ys_keyword == Y_LIST)
+		    xp_helper = xml_child_i(xml_parent(xp), i);
+	    else
+		    xp_helper = xp;
+
+	    cli_timing_begin(h, CT_RENDER);
+	    switch (format){
+	    case FORMAT_CLI:
+		if ((gt = clicon_cli_genmodel_type(h)) == GT_ERR)
+		    goto done;
+		xml2cli_cb(stdout, xp, prefix, gt, cligen_output); /* cli syntax */
+		break;
+	    case FORMAT_NETCONF:
+		fprintf(stdout, "<rpc><edit-config><target><candidate/></target><config>\n");
+		clicon_xml2file(stdout, xp, 2, 1);
+		fprintf(stdout, "</config></edit-config></rpc>]]>]]>\n");
+		break;
+	    default:
+		for (; i < xml_child_nr(xml_parent(xp)) ; ++i, xp_helper = xml_child_i(xml_parent(xp), i)) {
+		    switch (format){
+		    case FORMAT_XML:
+			clicon_xml2file(stdout, xp_helper, 0, 1);
+			break;
+		    case FORMAT_JSON:
+			xml2json_cb(stdout, xp_helper, 1, cligen_output);
+			break;
+		    case FORMAT_TEXT:	
+			xml2txt_cb(stdout, xp_helper, cligen_output);  /* tree-formed text */
+			break;
+		    default: /* see cli_show_config() */
+			break;
+		    }
+		    if (ys_keyword != Y_LIST)
+			break;
 		}
-		if (ys_keyword != Y_LIST)
-		    break;
+		break;
 	    }
-	    break;
+	    cli_timing_render_end(h);
 	}
-    }
+	if (page){
+	    /* Last page if fewer nodes than page size is selected */
+	    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath) < 0)
+		goto done;
+	    if (xvec){
+		free(xvec);
+		xvec = NULL;
+	    }
+	    offset += page;
+	}
+	xml_free(xt);
+	xt = NULL;
+    } while (page && xlen == (size_t)page);
     retval = 0;
  done:
+    if (xvec)
+	free(xvec);
     if (nsc)
 	xml_nsctx_free(nsc);
     if (api_path)
@@ -77,6 +77,14 @@ int cli_remove(clicon_handle h, cvec *vars, cvec *argv);
 
 int cli_del(clicon_handle h, cvec *vars, cvec *argv);
 
+int cli_batch_flush(clicon_handle h);
+
+int cli_batch_begin(clicon_handle h, cvec *vars, cvec *argv);
+
+int cli_batch_end(clicon_handle h, cvec *vars, cvec *argv);
+
+int cli_show_timing(clicon_handle h, cvec *vars, cvec *argv);
+
 int cli_debug_cli(clicon_handle h, cvec *vars, cvec *argv);
 
 int cli_debug_backend(clicon_handle h, cvec *vars, cvec *argv);
@@ -132,6 +140,8 @@ int cli_show_auto_state(clicon_handle h, cvec *cvv, cvec *argv);
 
 int cli_show_options(clicon_handle h, cvec *cvv, cvec *argv);
 
+int cli_show_memory(clicon_handle h, cvec *cvv, cvec *argv);
+
 /* cli_auto.c: Autocli mode support */
 
 int cli_auto_edit(clicon_handle h, cvec *cvv1, cvec *argv);
@@ -143,5 +153,6 @@ int cli_auto_merge(clicon_handle h, cvec *cvv, cvec *argv);
 int cli_auto_create(clicon_handle h, cvec *cvv,	cvec *argv);
 int cli_auto_del(clicon_handle h, cvec *cvv, cvec *argv);
 int cli_auto_sub_enter(clicon_handle h, cvec *cvv, cvec *argv);
+int cli_auto_cache_free(clicon_handle h);
 
 #endif /* _CLIXON_CLI_API_H_ */
@@ -0,0 +1,734 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * gRPC over HTTP/2 server of clixon_gnmi, using nghttp2 and optionally OpenSSL
+ * Each connection is a socket in the clixon event loop, with a nghttp2 server session.
+ * A gRPC call is a HTTP/2 stream: request messages are given to gnmi_rpc_message
+ * and responses are sent with gnmi_stream_send. The call ends with trailers carrying
+ * the gRPC status, see gnmi_stream_end.
+ * Each message is prefixed with a compressed flag byte and a 4 byte length.
+ * @see https://github.com/grpc/grpc/blob/master/doc/PROTOCOL-HTTP2.md
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <openssl/ssl.h>
+#include <nghttp2/nghttp2.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "gnmi_proto.h"
+#include "gnmi_lib.h"
+#include "gnmi_rpc.h"
+
+#define ARRLEN(x) (sizeof(x) / sizeof(x[0]))
+
+/* Length of gRPC message prefix: compressed flag and length */
+#define GRPC_PREFIX_LEN 5
+
+/* Max length of a gRPC request message */
+#define GRPC_MESSAGE_MAX (4*1024*1024)
+
+/* Listening socket, TLS context and connections of server */
+static int               _gnmi_s = -1;
+static SSL_CTX          *_gnmi_ctx = NULL;
+static struct gnmi_conn *_gnmi_conns = NULL;
+
+static int gnmi_conn_close(struct gnmi_conn *gc);
+
+/*! Create stream of connection
+ */
+static struct gnmi_stream *
+gnmi_stream_new(struct gnmi_conn *gc,
+		int32_t           id)
+{
+    struct gnmi_stream *gs;
+
+    if ((gs = malloc(sizeof(*gs))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(gs, 0, sizeof(*gs));
+    gs->gs_gc = gc;
+    gs->gs_id = id;
+    if ((gs->gs_in = pbuf_new()) == NULL ||
+	(gs->gs_out = pbuf_new()) == NULL){
+	if (gs->gs_in)
+	    pbuf_free(gs->gs_in);
+	free(gs);
+	return NULL;
+    }
+    ADDQ(gs, gc->gc_streams);
+    return gs;
+}
+
+/*! Free stream and state of its gRPC method
+ */
+static int
+gnmi_stream_free(struct gnmi_stream *gs)
+{
+    struct gnmi_conn *gc = gs->gs_gc;
+
+    gnmi_rpc_free(gc->gc_h, gs);
+    DELQ(gs, gc->gc_streams, struct gnmi_stream *);
+    if (gs->gs_path)
+	free(gs->gs_path);
+    if (gs->gs_message)
+	free(gs->gs_message);
+    pbuf_free(gs->gs_in);
+    pbuf_free(gs->gs_out);
+    free(gs);
+    return 0;
+}
+
+/*! Percent-encode gRPC status message
+ */
+static int
+grpc_message_encode(cbuf *cb,
+		    char *message)
+{
+    unsigned char *p;
+
+    for (p = (unsigned char*)message; *p; p++)
+	if (*p < 0x20 || *p > 0x7e || *p == '%')
+	    cprintf(cb, "%%%02X", *p);
+	else
+	    cprintf(cb, "%c", *p);
+    return 0;
+}
+
+/*! nghttp2 data provider of response, sends gs_out and then trailers
+ */
+static ssize_t
+gnmi_data_read_cb(nghttp2_session     *session,
+		  int32_t              stream_id,
+		  uint8_t             *buf,
+		  size_t               length,
+		  uint32_t            *data_flags,
+		  nghttp2_data_source *source,
+		  void                *user_data)
+{
+    struct gnmi_stream *gs = source->ptr;
+    size_t              len;
+    cbuf               *cb = NULL;
+    char                status[16];
+    nghttp2_nv          nva[2];
+    size_t              nvlen = 1;
+
+    len = gs->gs_out->pb_len - gs->gs_outoff;
+    if (len > 0){
+	if (len > length)
+	    len = length;
+	memcpy(buf, gs->gs_out->pb_buf + gs->gs_outoff, len);
+	gs->gs_outoff += len;
+	if (gs->gs_outoff == gs->gs_out->pb_len){
+	    pbuf_reset(gs->gs_out);
+	    gs->gs_outoff = 0;
+	}
+	return len;
+    }
+    if (!gs->gs_ended){
+	gs->gs_deferred = 1;
+	return NGHTTP2_ERR_DEFERRED;
+    }
+    *data_flags |= NGHTTP2_DATA_FLAG_EOF | NGHTTP2_DATA_FLAG_NO_END_STREAM;
+    snprintf(status, sizeof(status), "%d", gs->gs_status);
+    nva[0] = (nghttp2_nv){(uint8_t*)"grpc-status", (uint8_t*)status,
+			  strlen("grpc-status"), strlen(status), NGHTTP2_NV_FLAG_NONE};
+    if (gs->gs_message){
+	if ((cb = cbuf_new()) == NULL)
+	    return NGHTTP2_ERR_CALLBACK_FAILURE;
+	grpc_message_encode(cb, gs->gs_message);
+	nva[1] = (nghttp2_nv){(uint8_t*)"grpc-message", (uint8_t*)cbuf_get(cb),
+			      strlen("grpc-message"), cbuf_len(cb), NGHTTP2_NV_FLAG_NONE};
+	nvlen++;
+    }
+    if (nghttp2_submit_trailer(session, stream_id, nva, nvlen) != 0){
+	if (cb)
+	    cbuf_free(cb);
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+    if (cb)
+	cbuf_free(cb);
+    return 0;
+}
+
+/*! Submit response headers, or resume data of a deferred response
+ */
+static int
+gnmi_stream_resume(struct gnmi_stream *gs)
+{
+    nghttp2_session      *session = gs->gs_gc->gc_session;
+    nghttp2_data_provider prd;
+    nghttp2_nv            nva[] = {
+	{(uint8_t*)":status", (uint8_t*)"200", 7, 3, NGHTTP2_NV_FLAG_NONE},
+	{(uint8_t*)"content-type", (uint8_t*)"application/grpc", 12, 16, NGHTTP2_NV_FLAG_NONE}
+    };
+
+    if (!gs->gs_responded){
+	prd.source.ptr = gs;
+	prd.read_callback = gnmi_data_read_cb;
+	if (nghttp2_submit_response(session, gs->gs_id, nva, ARRLEN(nva), &prd) != 0){
+	    clicon_err(OE_PROTO, 0, "nghttp2_submit_response");
+	    return -1;
+	}
+	gs->gs_responded = 1;
+    }
+    else if (gs->gs_deferred){
+	gs->gs_deferred = 0;
+	if (nghttp2_session_resume_data(session, gs->gs_id) != 0){
+	    clicon_err(OE_PROTO, 0, "nghttp2_session_resume_data");
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+/*! Send gRPC response message on stream
+ *
+ * The message is sent when the connection is flushed, see gnmi_conn_flush
+ * @param[in]  gs  Stream
+ * @param[in]  pb  Encoded message
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+gnmi_stream_send(struct gnmi_stream *gs,
+		 pbuf               *pb)
+{
+    uint8_t prefix[GRPC_PREFIX_LEN];
+
+    if (gs->gs_ended)
+	return 0;
+    prefix[0] = 0; /* Not compressed */
+    prefix[1] = (pb->pb_len >> 24) & 0xff;
+    prefix[2] = (pb->pb_len >> 16) & 0xff;
+    prefix[3] = (pb->pb_len >> 8) & 0xff;
+    prefix[4] = pb->pb_len & 0xff;
+    if (pbuf_append(gs->gs_out, prefix, GRPC_PREFIX_LEN) < 0 ||
+	pbuf_append(gs->gs_out, pb->pb_buf, pb->pb_len) < 0)
+	return -1;
+    return gnmi_stream_resume(gs);
+}
+
+/*! End gRPC call with status, after messages already sent
+ * @param[in]  gs       Stream
+ * @param[in]  status   gRPC status code, eg GRPC_OK
+ * @param[in]  message  Status message, or NULL
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+int
+gnmi_stream_end(struct gnmi_stream *gs,
+		int                 status,
+		char               *message)
+{
+    if (gs->gs_ended)
+	return 0;
+    gs->gs_ended = 1;
+    gs->gs_status = status;
+    if (message && (gs->gs_message = strdup(message)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	return -1;
+    }
+    if (status != GRPC_OK)
+	clicon_debug(1, "%s %s: %d %s", __FUNCTION__,
+		     gs->gs_path?gs->gs_path:"", status, message?message:"");
+    return gnmi_stream_resume(gs);
+}
+
+/*! nghttp2 send callback, write to socket
+ */
+static ssize_t
+gnmi_send_cb(nghttp2_session *session,
+	     const uint8_t   *data,
+	     size_t           length,
+	     int              flags,
+	     void            *user_data)
+{
+    struct gnmi_conn *gc = user_data;
+    ssize_t           n;
+
+    if (gc->gc_ssl){
+	if ((n = SSL_write(gc->gc_ssl, data, length)) <= 0){
+	    clicon_debug(1, "%s SSL_write: %d", __FUNCTION__,
+			 SSL_get_error(gc->gc_ssl, n));
+	    return NGHTTP2_ERR_CALLBACK_FAILURE;
+	}
+    }
+    else {
+	while ((n = write(gc->gc_s, data, length)) < 0 && errno == EINTR)
+	    ;
+	if (n < 0){
+	    clicon_debug(1, "%s write: %s", __FUNCTION__, strerror(errno));
+	    return NGHTTP2_ERR_CALLBACK_FAILURE;
+	}
+    }
+    return n;
+}
+
+/*! nghttp2 callback of request headers, create stream
+ */
+static int
+gnmi_begin_headers_cb(nghttp2_session     *session,
+		      const nghttp2_frame *frame,
+		      void                *user_data)
+{
+    struct gnmi_conn   *gc = user_data;
+    struct gnmi_stream *gs;
+
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+	frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+	return 0;
+    if ((gs = gnmi_stream_new(gc, frame->hd.stream_id)) == NULL)
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    nghttp2_session_set_stream_user_data(session, frame->hd.stream_id, gs);
+    return 0;
+}
+
+/*! nghttp2 callback of a header, save :path as gRPC method
+ */
+static int
+gnmi_header_cb(nghttp2_session     *session,
+	       const nghttp2_frame *frame,
+	       const uint8_t       *name,
+	       size_t               namelen,
+	       const uint8_t       *value,
+	       size_t               valuelen,
+	       uint8_t              flags,
+	       void                *user_data)
+{
+    struct gnmi_stream *gs;
+
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+	frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+	return 0;
+    if ((gs = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id)) == NULL)
+	return 0;
+    if (namelen == 5 && memcmp(name, ":path", 5) == 0){
+	if (gs->gs_path)
+	    free(gs->gs_path);
+	if ((gs->gs_path = strndup((char*)value, valuelen)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    return NGHTTP2_ERR_CALLBACK_FAILURE;
+	}
+    }
+    return 0;
+}
+
+/*! nghttp2 callback of request data, split in gRPC messages
+ */
+static int
+gnmi_data_chunk_cb(nghttp2_session *session,
+		   uint8_t          flags,
+		   int32_t          stream_id,
+		   const uint8_t   *data,
+		   size_t           len,
+		   void            *user_data)
+{
+    struct gnmi_conn   *gc = user_data;
+    struct gnmi_stream *gs;
+    pbuf               *in;
+    size_t              off = 0;
+    uint32_t            mlen;
+
+    if ((gs = nghttp2_session_get_stream_user_data(session, stream_id)) == NULL)
+	return 0;
+    if (gs->gs_ended)
+	return 0;
+    in = gs->gs_in;
+    if (pbuf_append(in, data, len) < 0)
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    while (in->pb_len - off >= GRPC_PREFIX_LEN){
+	mlen = ((uint32_t)in->pb_buf[off+1] << 24) | (in->pb_buf[off+2] << 16) |
+	    (in->pb_buf[off+3] << 8) | in->pb_buf[off+4];
+	if (in->pb_buf[off] != 0){
+	    if (gnmi_stream_end(gs, GRPC_UNIMPLEMENTED, "Compression not supported") < 0)
+		return NGHTTP2_ERR_CALLBACK_FAILURE;
+	    break;
+	}
+	if (mlen > GRPC_MESSAGE_MAX){
+	    if (gnmi_stream_end(gs, GRPC_INVALID_ARGUMENT, "Message too large") < 0)
+		return NGHTTP2_ERR_CALLBACK_FAILURE;
+	    break;
+	}
+	if (in->pb_len - off - GRPC_PREFIX_LEN < mlen)
+	    break;
+	if (gnmi_rpc_message(gc->gc_h, gs, in->pb_buf + off + GRPC_PREFIX_LEN, mlen) < 0)
+	    return NGHTTP2_ERR_CALLBACK_FAILURE;
+	off += GRPC_PREFIX_LEN + mlen;
+	if (gs->gs_ended)
+	    break;
+    }
+    if (gs->gs_ended)
+	pbuf_reset(in);
+    else if (off > 0){
+	memmove(in->pb_buf, in->pb_buf + off, in->pb_len - off);
+	in->pb_len -= off;
+    }
+    return 0;
+}
+
+/*! nghttp2 callback of received frame, end of request stream
+ */
+static int
+gnmi_frame_recv_cb(nghttp2_session     *session,
+		   const nghttp2_frame *frame,
+		   void                *user_data)
+{
+    struct gnmi_conn   *gc = user_data;
+    struct gnmi_stream *gs;
+
+    if ((frame->hd.type != NGHTTP2_HEADERS && frame->hd.type != NGHTTP2_DATA) ||
+	(frame->hd.flags & NGHTTP2_FLAG_END_STREAM) == 0)
+	return 0;
+    if ((gs = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id)) == NULL)
+	return 0;
+    if (gs->gs_ended)
+	return 0;
+    if (gnmi_rpc_end(gc->gc_h, gs) < 0)
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    return 0;
+}
+
+/*! nghttp2 callback of closed stream, eg ended or cancelled by client
+ */
+static int
+gnmi_stream_close_cb(nghttp2_session *session,
+		     int32_t          stream_id,
+		     uint32_t         error_code,
+		     void            *user_data)
+{
+    struct gnmi_stream *gs;
+
+    if ((gs = nghttp2_session_get_stream_user_data(session, stream_id)) == NULL)
+	return 0;
+    nghttp2_session_set_stream_user_data(session, stream_id, NULL);
+    gnmi_stream_free(gs);
+    return 0;
+}
+
+/*! Send pending frames of connection, and close it if done
+ *
+ * The connection may be freed by this function, and its streams with it.
+ * @param[in]  gc  Connection
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+gnmi_conn_flush(struct gnmi_conn *gc)
+{
+    int ret;
+
+    if ((ret = nghttp2_session_send(gc->gc_session)) != 0){
+	clicon_debug(1, "%s nghttp2_session_send: %s", __FUNCTION__, nghttp2_strerror(ret));
+	return gnmi_conn_close(gc);
+    }
+    if (nghttp2_session_want_read(gc->gc_session) == 0 &&
+	nghttp2_session_want_write(gc->gc_session) == 0)
+	return gnmi_conn_close(gc);
+    return 0;
+}
+
+/*! Data on connection socket
+ */
+static int
+gnmi_conn_recv_cb(int   s,
+		  void *arg)
+{
+    struct gnmi_conn *gc = arg;
+    uint8_t           buf[16384];
+    ssize_t           n;
+    ssize_t           ret;
+
+    do {
+	if (gc->gc_ssl){
+	    if ((n = SSL_read(gc->gc_ssl, buf, sizeof(buf))) <= 0){
+		if (SSL_get_error(gc->gc_ssl, n) == SSL_ERROR_WANT_READ)
+		    return 0;
+		return gnmi_conn_close(gc);
+	    }
+	}
+	else if ((n = read(s, buf, sizeof(buf))) <= 0){
+	    if (n < 0 && errno == EINTR)
+		return 0;
+	    if (n < 0)
+		clicon_debug(1, "%s read: %s", __FUNCTION__, strerror(errno));
+	    return gnmi_conn_close(gc);
+	}
+	if ((ret = nghttp2_session_mem_recv(gc->gc_session, buf, n)) < 0){
+	    clicon_debug(1, "%s nghttp2_session_mem_recv: %s", __FUNCTION__,
+			 nghttp2_strerror(ret));
+	    return gnmi_conn_close(gc);
+	}
+    } while (gc->gc_ssl && SSL_pending(gc->gc_ssl));
+    return gnmi_conn_flush(gc);
+}
+
+/*! Close connection, free its streams and session
+ */
+static int
+gnmi_conn_close(struct gnmi_conn *gc)
+{
+    clicon_debug(1, "%s %d", __FUNCTION__, gc->gc_s);
+    clixon_event_unreg_fd(gc->gc_s, gnmi_conn_recv_cb);
+    /* Streams are not closed by nghttp2_session_del */
+    while (gc->gc_streams)
+	gnmi_stream_free(gc->gc_streams);
+    if (gc->gc_session)
+	nghttp2_session_del(gc->gc_session);
+    if (gc->gc_ssl){
+	SSL_shutdown(gc->gc_ssl);
+	SSL_free(gc->gc_ssl);
+    }
+    close(gc->gc_s);
+    DELQ(gc, _gnmi_conns, struct gnmi_conn *);
+    free(gc);
+    return 0;
+}
+
+/*! Create nghttp2 server session of connection and send settings
+ */
+static int
+gnmi_conn_session(struct gnmi_conn *gc)
+{
+    int                        retval = -1;
+    nghttp2_session_callbacks *cbs = NULL;
+    nghttp2_settings_entry     iv[] = {
+	{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 100}
+    };
+
+    if (nghttp2_session_callbacks_new(&cbs) != 0){
+	clicon_err(OE_UNIX, ENOMEM, "nghttp2_session_callbacks_new");
+	goto done;
+    }
+    nghttp2_session_callbacks_set_send_callback(cbs, gnmi_send_cb);
+    nghttp2_session_callbacks_set_on_begin_headers_callback(cbs, gnmi_begin_headers_cb);
+    nghttp2_session_callbacks_set_on_header_callback(cbs, gnmi_header_cb);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(cbs, gnmi_data_chunk_cb);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(cbs, gnmi_frame_recv_cb);
+    nghttp2_session_callbacks_set_on_stream_close_callback(cbs, gnmi_stream_close_cb);
+    if (nghttp2_session_server_new(&gc->gc_session, cbs, gc) != 0){
+	clicon_err(OE_UNIX, ENOMEM, "nghttp2_session_server_new");
+	goto done;
+    }
+    if (nghttp2_submit_settings(gc->gc_session, NGHTTP2_FLAG_NONE, iv, ARRLEN(iv)) != 0){
+	clicon_err(OE_PROTO, 0, "nghttp2_submit_settings");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cbs)
+	nghttp2_session_callbacks_del(cbs);
+    return retval;
+}
+
+/*! Accept connection of gNMI client on listening socket
+ */
+static int
+gnmi_accept_cb(int   ss,
+	       void *arg)
+{
+    clicon_handle         h = arg;
+    struct gnmi_conn     *gc = NULL;
+    struct sockaddr_in6   from;
+    socklen_t             len = sizeof(from);
+    const unsigned char  *alpn = NULL;
+    unsigned int          alpnlen = 0;
+    int                   s;
+    int                   one = 1;
+
+    if ((s = accept(ss, (struct sockaddr*)&from, &len)) < 0){
+	if (errno == EINTR || errno == ECONNABORTED)
+	    return 0;
+	clicon_err(OE_UNIX, errno, "accept");
+	return -1;
+    }
+    clicon_debug(1, "%s %d", __FUNCTION__, s);
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if ((gc = malloc(sizeof(*gc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	close(s);
+	return -1;
+    }
+    memset(gc, 0, sizeof(*gc));
+    gc->gc_h = h;
+    gc->gc_s = s;
+    ADDQ(gc, _gnmi_conns);
+    if (_gnmi_ctx){
+	if ((gc->gc_ssl = SSL_new(_gnmi_ctx)) == NULL){
+	    clicon_err(OE_SSL, 0, "SSL_new");
+	    goto fail;
+	}
+	SSL_set_fd(gc->gc_ssl, s);
+	if (SSL_accept(gc->gc_ssl) <= 0){
+	    clicon_log(LOG_NOTICE, "%s: TLS handshake failed", __FUNCTION__);
+	    goto fail;
+	}
+	SSL_get0_alpn_selected(gc->gc_ssl, &alpn, &alpnlen);
+	if (alpn == NULL || alpnlen != 2 || memcmp(alpn, "h2", 2) != 0){
+	    clicon_log(LOG_NOTICE, "%s: h2 not negotiated", __FUNCTION__);
+	    goto fail;
+	}
+    }
+    if (gnmi_conn_session(gc) < 0)
+	goto fail;
+    if (clixon_event_reg_fd(s, gnmi_conn_recv_cb, gc, "gnmi connection") < 0)
+	goto fail;
+    return gnmi_conn_flush(gc);
+ fail:
+    gnmi_conn_close(gc);
+    return 0;
+}
+
+/*! ALPN callback of TLS server, select h2
+ */
+static int
+gnmi_alpn_select_cb(SSL                  *ssl,
+		    const unsigned char **out,
+		    unsigned char        *outlen,
+		    const unsigned char  *in,
+		    unsigned int          inlen,
+		    void                 *arg)
+{
+    if (nghttp2_select_next_protocol((unsigned char **)out, outlen, in, inlen) != 1)
+	return SSL_TLSEXT_ERR_NOACK;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+/*! Open listening socket of gNMI server, see CLICON_GNMI_ADDRESS and CLICON_GNMI_PORT
+ *
+ * @param[in]  h    Clicon handle
+ * @param[in]  ctx  TLS context, or NULL for cleartext HTTP/2. Freed by gnmi_server_exit
+ * @param[out] sp   Listening socket
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+gnmi_server_init(clicon_handle h,
+		 SSL_CTX      *ctx,
+		 int          *sp)
+{
+    int              retval = -1;
+    struct addrinfo  hints = {0,};
+    struct addrinfo *ai = NULL;
+    char            *addr;
+    char             port[8];
+    int              s = -1;
+    int              one = 1;
+    int              ret;
+
+    if ((addr = clicon_option_str(h, "CLICON_GNMI_ADDRESS")) == NULL)
+	addr = "127.0.0.1";
+    snprintf(port, sizeof(port), "%d", clicon_option_int(h, "CLICON_GNMI_PORT"));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST | AI_NUMERICSERV;
+    if ((ret = getaddrinfo(addr, port, &hints, &ai)) != 0){
+	clicon_err(OE_UNIX, 0, "getaddrinfo %s: %s", addr, gai_strerror(ret));
+	goto done;
+    }
+    if ((s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol)) < 0){
+	clicon_err(OE_UNIX, errno, "socket");
+	goto done;
+    }
+    if (setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) < 0){
+	clicon_err(OE_UNIX, errno, "setsockopt SO_REUSEADDR");
+	goto done;
+    }
+    if (bind(s, ai->ai_addr, ai->ai_addrlen) < 0){
+	clicon_err(OE_UNIX, errno, "bind %s:%s", addr, port);
+	goto done;
+    }
+    if (listen(s, clicon_option_int(h, "CLICON_SOCK_BACKLOG")) < 0){
+	clicon_err(OE_UNIX, errno, "listen");
+	goto done;
+    }
+    if (ctx)
+	SSL_CTX_set_alpn_select_cb(ctx, gnmi_alpn_select_cb, NULL);
+    if (clixon_event_reg_fd(s, gnmi_accept_cb, h, "gnmi server socket") < 0)
+	goto done;
+    _gnmi_ctx = ctx;
+    _gnmi_s = s;
+    *sp = s;
+    s = -1;
+    clicon_log(LOG_NOTICE, "%s: listening on %s:%s (%s)", __PROGRAM__, addr, port,
+	       ctx?"TLS":"cleartext");
+    retval = 0;
+ done:
+    if (s != -1)
+	close(s);
+    if (ai)
+	freeaddrinfo(ai);
+    return retval;
+}
+
+/*! Close connections and listening socket of gNMI server
+ */
+int
+gnmi_server_exit(clicon_handle h)
+{
+    while (_gnmi_conns)
+	gnmi_conn_close(_gnmi_conns);
+    if (_gnmi_s != -1){
+	clixon_event_unreg_fd(_gnmi_s, gnmi_accept_cb);
+	close(_gnmi_s);
+	_gnmi_s = -1;
+    }
+    if (_gnmi_ctx){
+	SSL_CTX_free(_gnmi_ctx);
+	_gnmi_ctx = NULL;
+    }
+    return 0;
+}
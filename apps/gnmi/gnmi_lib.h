@@ -0,0 +1,98 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * gRPC over HTTP/2 server of clixon_gnmi, using nghttp2 and optionally OpenSSL
+ */
+
+#ifndef _GNMI_LIB_H_
+#define _GNMI_LIB_H_
+
+/*
+ * Constants
+ */
+/* gRPC status codes */
+#define GRPC_OK                0
+#define GRPC_CANCELLED         1
+#define GRPC_UNKNOWN           2
+#define GRPC_INVALID_ARGUMENT  3
+#define GRPC_NOT_FOUND         5
+#define GRPC_PERMISSION_DENIED 7
+#define GRPC_ABORTED          10
+#define GRPC_UNIMPLEMENTED    12
+#define GRPC_INTERNAL         13
+#define GRPC_UNAVAILABLE      14
+
+/*
+ * Types
+ */
+struct gnmi_conn;
+
+/* A gRPC call, ie HTTP/2 stream of a connection */
+struct gnmi_stream{
+    qelem_t           gs_qelem;     /* List of streams of connection */
+    struct gnmi_conn *gs_gc;        /* Connection */
+    int32_t           gs_id;        /* HTTP/2 stream id */
+    char             *gs_path;      /* :path header, ie gRPC method */
+    pbuf             *gs_in;        /* Received data, incomplete gRPC message */
+    pbuf             *gs_out;       /* gRPC messages not yet sent */
+    size_t            gs_outoff;    /* Sent part of gs_out */
+    int               gs_responded; /* Response headers submitted */
+    int               gs_deferred;  /* Data provider deferred, waiting for data */
+    int               gs_ended;     /* Status set, trailers sent when gs_out is sent */
+    int               gs_status;    /* gRPC status code */
+    char             *gs_message;   /* gRPC status message, or NULL */
+    void             *gs_arg;       /* State of method, see gnmi_rpc.c */
+};
+
+/* HTTP/2 connection of a gNMI client */
+struct gnmi_conn{
+    qelem_t             gc_qelem;   /* List of connections */
+    clicon_handle       gc_h;
+    int                 gc_s;       /* Socket */
+    SSL                *gc_ssl;     /* TLS, or NULL if cleartext */
+    nghttp2_session    *gc_session;
+    struct gnmi_stream *gc_streams;
+};
+
+/*
+ * Prototypes
+ */
+int gnmi_stream_send(struct gnmi_stream *gs, pbuf *pb);
+int gnmi_stream_end(struct gnmi_stream *gs, int status, char *message);
+int gnmi_conn_flush(struct gnmi_conn *gc);
+int gnmi_server_init(clicon_handle h, SSL_CTX *ctx, int *sp);
+int gnmi_server_exit(clicon_handle h);
+
+#endif  /* _GNMI_LIB_H_ */
@@ -0,0 +1,365 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * gNMI server daemon: gNMI Capabilities, Get, Set and Subscribe over gRPC, with
+ * protobuf messages. Clients connect with HTTP/2 over TLS if CLICON_GNMI_SSL_CERT and
+ * CLICON_GNMI_SSL_KEY are set, otherwise with cleartext HTTP/2 (h2c).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <syslog.h>
+#include <pwd.h>
+#include <sys/time.h>
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <nghttp2/nghttp2.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "gnmi_proto.h"
+#include "gnmi_lib.h"
+
+/* Command line options to be passed to getopt(3) */
+#define GNMI_OPTS "hD:f:E:l:p:y:a:u:o:"
+
+/*! Clean and close all state of gnmi process (but dont exit).
+ * Cannot use h after this
+ * @param[in]  h  Clixon handle
+ */
+static int
+gnmi_terminate(clicon_handle h)
+{
+    yang_stmt  *yspec;
+    cvec       *nsctx;
+    cxobj      *x;
+
+    gnmi_server_exit(h);
+    clicon_rpc_close_session(h);
+    if ((yspec = clicon_dbspec_yang(h)) != NULL)
+	ys_free(yspec);
+    if ((yspec = clicon_config_yang(h)) != NULL)
+	ys_free(yspec);
+    if ((nsctx = clicon_nsctx_global_get(h)) != NULL)
+	cvec_free(nsctx);
+    if ((x = clicon_conf_xml(h)) != NULL)
+	xml_free(x);
+    xpath_optimize_exit();
+    clixon_event_exit();
+    clicon_handle_exit(h);
+    clixon_err_exit();
+    clicon_log_exit();
+    return 0;
+}
+
+/*! Signal handler for SIGTERM and SIGINT
+ */
+static void
+gnmi_sig_term(int arg)
+{
+    clicon_log(LOG_NOTICE, "%s: %s: pid: %u Signal %d",
+	       __PROGRAM__, __FUNCTION__, getpid(), arg);
+    clicon_exit_set(); /* checked in clixon_event_loop() */
+}
+
+/*! Create TLS context from CLICON_GNMI_SSL_CERT and CLICON_GNMI_SSL_KEY
+ * @param[in]  h    Clicon handle
+ * @param[out] ctx  TLS context, or NULL if not configured
+ */
+static int
+gnmi_ssl_context(clicon_handle h,
+		 SSL_CTX     **ctxp)
+{
+    SSL_CTX *ctx;
+    char    *cert;
+    char    *key;
+
+    *ctxp = NULL;
+    cert = clicon_option_str(h, "CLICON_GNMI_SSL_CERT");
+    key = clicon_option_str(h, "CLICON_GNMI_SSL_KEY");
+    if (cert == NULL || key == NULL)
+	return 0;
+    if ((ctx = SSL_CTX_new(TLS_server_method())) == NULL){
+	clicon_err(OE_SSL, 0, "SSL_CTX_new");
+	return -1;
+    }
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    if (SSL_CTX_use_certificate_chain_file(ctx, cert) != 1){
+	clicon_err(OE_SSL, 0, "%s: %s", cert, ERR_error_string(ERR_get_error(), NULL));
+	SSL_CTX_free(ctx);
+	return -1;
+    }
+    if (SSL_CTX_use_PrivateKey_file(ctx, key, SSL_FILETYPE_PEM) != 1){
+	clicon_err(OE_SSL, 0, "%s: %s", key, ERR_error_string(ERR_get_error(), NULL));
+	SSL_CTX_free(ctx);
+	return -1;
+    }
+    *ctxp = ctx;
+    return 0;
+}
+
+/*! Usage help routine
+ * @param[in]  h      Clicon handle
+ * @param[in]  argv0  command line
+ */
+static void
+usage(clicon_handle h,
+      char         *argv0)
+{
+    fprintf(stderr, "usage:%s\n"
+	    "where options are\n"
+            "\t-h\t\tHelp\n"
+	    "\t-D <level>\tDebug level\n"
+    	    "\t-f <file>\tConfiguration file (mandatory)\n"
+	    "\t-E <dir> \tExtra configuration file directory\n"
+	    "\t-l (e|o|s|f<file>) Log on std(e)rr, std(o)ut, (s)yslog(default), (f)ile\n"
+	    "\t-p <dir>\tYang directory path (see CLICON_YANG_DIR)\n"
+	    "\t-y <file>\tLoad yang spec file (override yang main module)\n"
+    	    "\t-a UNIX|IPv4|IPv6 Internal backend socket family\n"
+    	    "\t-u <path|addr>\tInternal socket domain path or IP addr (see -a)\n"
+	    "\t-o \"<option>=<value>\"\tGive configuration option overriding config file (see clixon-config.yang)\n",
+	    argv0
+	    );
+    exit(0);
+}
+
+int
+main(int    argc,
+     char **argv)
+{
+    int              retval = -1;
+    int              c;
+    char            *argv0 = argv[0];
+    clicon_handle    h;
+    int              logdst = CLICON_LOG_SYSLOG;
+    struct passwd   *pw;
+    yang_stmt       *yspec = NULL;
+    char            *str;
+    uint32_t         id;
+    cvec            *nsctx_global = NULL; /* Global namespace context */
+    SSL_CTX         *ctx = NULL;
+    int              ss = -1;
+    int              dbg = 0;
+
+    /* Create handle */
+    if ((h = clicon_handle_init()) == NULL)
+	return -1;
+    /* In the startup, logs to stderr & debug flag set later */
+    clicon_log_init(__PROGRAM__, LOG_INFO, CLICON_LOG_STDERR);
+
+    /* Set username to clicon handle. Use in all communication to backend */
+    if ((pw = getpwuid(getuid())) == NULL){
+	clicon_err(OE_UNIX, errno, "getpwuid");
+	goto done;
+    }
+    if (clicon_username_set(h, pw->pw_name) < 0)
+	goto done;
+    while ((c = getopt(argc, argv, GNMI_OPTS)) != -1)
+	switch (c) {
+	case 'h' : /* help */
+	    usage(h, argv[0]);
+	    break;
+	case 'D' : /* debug */
+	    if (sscanf(optarg, "%d", &dbg) != 1)
+		usage(h, argv[0]);
+	    break;
+	 case 'f': /* override config file */
+	    if (!strlen(optarg))
+		usage(h, argv[0]);
+	    clicon_option_str_set(h, "CLICON_CONFIGFILE", optarg);
+	    break;
+	case 'E': /* extra config directory */
+	    if (!strlen(optarg))
+		usage(h, argv[0]);
+	    clicon_option_str_set(h, "CLICON_CONFIGDIR", optarg);
+	    break;
+	 case 'l': /* Log destination: s|e|o */
+	    if ((logdst = clicon_log_opt(optarg[0])) < 0)
+		usage(h, argv[0]);
+	    if (logdst == CLICON_LOG_FILE &&
+		strlen(optarg)>1 &&
+		clicon_log_file(optarg+1) < 0)
+		goto done;
+	     break;
+	}
+
+    /*
+     * Logs, error and debug to stderr or syslog, set debug level
+     */
+    clicon_log_init(__PROGRAM__, dbg?LOG_DEBUG:LOG_INFO, logdst);
+    clicon_debug_init(dbg, NULL);
+
+    /* Find, read and parse configfile */
+    if (clicon_options_main(h) < 0)
+	goto done;
+
+    /* Now rest of options */
+    optind = 1;
+    opterr = 0;
+    while ((c = getopt(argc, argv, GNMI_OPTS)) != -1)
+	switch (c) {
+	case 'h' : /* help */
+	case 'D' : /* debug */
+	case 'f':  /* config file */
+	case 'E': /* extra config dir */
+	case 'l':  /* log  */
+	    break; /* see above */
+	case 'p' : /* yang dir path */
+	    if (clicon_option_add(h, "CLICON_YANG_DIR", optarg) < 0)
+		goto done;
+	    break;
+	case 'y' : /* Load yang spec file (override yang main module) */
+	    if (clicon_option_add(h, "CLICON_YANG_MAIN_FILE", optarg) < 0)
+		goto done;
+	    break;
+	case 'a': /* internal backend socket address family */
+	    clicon_option_str_set(h, "CLICON_SOCK_FAMILY", optarg);
+	    break;
+	case 'u': /* internal backend socket unix domain path or ip host */
+	    if (!strlen(optarg))
+		usage(h, argv[0]);
+	    clicon_option_str_set(h, "CLICON_SOCK", optarg);
+	    break;
+	case 'o':{ /* Configuration option */
+	    char          *val;
+	    if ((val = index(optarg, '=')) == NULL)
+		usage(h, argv0);
+	    *val++ = '\0';
+	    if (clicon_option_add(h, optarg, val) < 0)
+		goto done;
+	    break;
+	}
+	default:
+	    usage(h, argv[0]);
+	    break;
+	}
+    argc -= optind;
+    argv += optind;
+
+    /* Access the remaining argv/argc options (after --) w clicon-argv_get() */
+    clicon_argv_set(h, argv0, argc, argv);
+
+    /* Set default namespace according to CLICON_NAMESPACE_NETCONF_DEFAULT */
+    xml_nsctx_namespace_netconf_default(h);
+
+    /* Create top-level yang spec and store as option */
+    if ((yspec = yspec_new()) == NULL)
+	goto done;
+    clicon_dbspec_yang_set(h, yspec);
+
+    /* Load Yang modules
+     * 1. Load a yang module as a specific absolute filename */
+    if ((str = clicon_yang_main_file(h)) != NULL){
+	if (yang_spec_parse_file(h, str, yspec) < 0)
+	    goto done;
+    }
+    /* 2. Load a (single) main module */
+    if ((str = clicon_yang_module_main(h)) != NULL){
+	if (yang_spec_parse_module(h, str, clicon_yang_module_revision(h),
+				   yspec) < 0)
+	    goto done;
+    }
+    /* 3. Load all modules in a directory */
+    if ((str = clicon_yang_main_dir(h)) != NULL){
+	if (yang_spec_load_dir(h, str, yspec) < 0)
+	    goto done;
+    }
+    /* Load clixon lib yang module */
+    if (yang_spec_parse_module(h, "clixon-lib", NULL, yspec) < 0)
+	goto done;
+     /* Load yang module library, RFC7895 */
+    if (yang_modules_init(h) < 0)
+	goto done;
+    /* Add netconf yang spec, used as internal protocol */
+    if (netconf_module_load(h) < 0)
+	goto done;
+    /* Here all modules are loaded
+     * Compute and set canonical namespace context
+     */
+    if (xml_nsctx_yangspec(yspec, &nsctx_global) < 0)
+	goto done;
+    if (clicon_nsctx_global_set(h, nsctx_global) < 0)
+	goto done;
+
+    /* Send hello request to backend to get session-id back, used by all clients */
+    if (clicon_hello_req(h, &id) < 0)
+	goto done;
+    clicon_session_id_set(h, id);
+
+    if (set_signal(SIGTERM, gnmi_sig_term, NULL) < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
+    if (set_signal(SIGINT, gnmi_sig_term, NULL) < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
+    /* Writes on closed client connections fail with EPIPE */
+    if (set_signal(SIGPIPE, SIG_IGN, NULL) < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
+    if (gnmi_ssl_context(h, &ctx) < 0)
+	goto done;
+    if (gnmi_server_init(h, ctx, &ss) < 0){
+	if (ctx)
+	    SSL_CTX_free(ctx);
+	goto done;
+    }
+    if (dbg)
+	clicon_option_dump(h, dbg);
+    if (clixon_event_loop(h) < 0)
+	goto done;
+    retval = 0;
+  done:
+    gnmi_terminate(h);
+    clicon_log_init(__PROGRAM__, LOG_INFO, 0); /* Log on syslog no stderr */
+    clicon_log(LOG_NOTICE, "%s: %u Terminated", __PROGRAM__, getpid());
+    return retval;
+}
@@ -0,0 +1,364 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Translation between gNMI paths and clixon XPaths, api-paths and XML
+ * An element of a gNMI path is a YANG data node name, optionally prefixed with its
+ * module name as in JSON (RFC 7951), eg /ietf-interfaces:interfaces/interface[name=eth0].
+ * Without module name, the first element is searched for in all modules.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "gnmi_proto.h"
+#include "gnmi_path.h"
+
+/*! Find YANG data node of a gNMI path element
+ * @param[in]  yspec    Yang spec
+ * @param[in]  yparent  YANG node of parent element, or NULL if first element
+ * @param[in]  ge       gNMI path element
+ * @param[out] yp       YANG data node
+ * @param[out] reason   Reason if not found
+ * @retval     1        Found
+ * @retval     0        Not found, reason set
+ */
+static int
+gnmi_elem_yang(yang_stmt        *yspec,
+	       yang_stmt        *yparent,
+	       struct gnmi_elem *ge,
+	       yang_stmt       **yp,
+	       cbuf             *reason)
+{
+    int        retval = 0;
+    yang_stmt *ymod = NULL;
+    yang_stmt *y = NULL;
+    char      *name;
+    char      *modname = NULL;
+
+    if ((name = strchr(ge->ge_name, ':')) != NULL){
+	modname = ge->ge_name;
+	*name++ = '\0';
+    }
+    else
+	name = ge->ge_name;
+    if (strcmp(name, "*") == 0 || strcmp(name, "...") == 0){
+	cprintf(reason, "Wildcard element %s not supported", name);
+	goto done;
+    }
+    if (modname &&
+	(ymod = yang_find_module_by_name(yspec, modname)) == NULL){
+	cprintf(reason, "Unknown module %s", modname);
+	goto done;
+    }
+    if (yparent != NULL)
+	y = yang_find_datanode(yparent, name);
+    else if (ymod != NULL)
+	y = yang_find_datanode(ymod, name);
+    else
+	while ((ymod = yn_each(yspec, ymod)) != NULL)
+	    if (yang_keyword_get(ymod) == Y_MODULE &&
+		(y = yang_find_datanode(ymod, name)) != NULL)
+		break;
+    if (y == NULL){
+	cprintf(reason, "Unknown element %s", name);
+	goto done;
+    }
+    *yp = y;
+    retval = 1;
+ done:
+    if (modname) /* Restore element name */
+	*(name-1) = ':';
+    return retval;
+}
+
+/*! Translate gNMI path to XPath, and to api-path if possible
+ *
+ * List keys not given, or given as "*", select all entries. The api-path is used
+ * by the backend to fetch a list by key lookup, and is only given if the path has
+ * all keys and no values that need escaping.
+ * @param[in]  yspec     Yang spec
+ * @param[in]  gp        gNMI path
+ * @param[out] xpath     XPath
+ * @param[out] nsc       Namespace context of XPath, prefixes added
+ * @param[out] api_path  RFC 8040 api-path, or empty
+ * @param[out] reason    Reason if invalid
+ * @retval     1         OK
+ * @retval     0         Invalid path, see reason
+ * @retval    -1         Error
+ */
+int
+gnmi_path2xpath(yang_stmt *yspec,
+		gnmi_path *gp,
+		cbuf      *xpath,
+		cvec      *nsc,
+		cbuf      *api_path,
+		cbuf      *reason)
+{
+    struct gnmi_elem *ge;
+    yang_stmt        *y = NULL;
+    yang_stmt        *ymod;
+    yang_stmt        *ymod0 = NULL;
+    cvec             *cvk;
+    cg_var           *cvi;
+    cg_var           *cv;
+    char             *prefix;
+    char             *key;
+    char             *val;
+    int               apiok = 1;
+    int               i;
+    int               j;
+
+    for (i=0; i<gp->gp_len; i++){
+	ge = &gp->gp_vec[i];
+	if (gnmi_elem_yang(yspec, y, ge, &y, reason) == 0)
+	    return 0;
+	prefix = yang_find_myprefix(y);
+	if (xml_nsctx_get(nsc, prefix) == NULL &&
+	    xml_nsctx_add(nsc, prefix, yang_find_mynamespace(y)) < 0)
+	    return -1;
+	cprintf(xpath, "/%s:%s", prefix, yang_argument_get(y));
+	ymod = ys_module(y);
+	if (ymod != ymod0)
+	    cprintf(api_path, "/%s:%s", yang_argument_get(ymod), yang_argument_get(y));
+	else
+	    cprintf(api_path, "/%s", yang_argument_get(y));
+	ymod0 = ymod;
+	/* Keys in YANG order */
+	if (yang_keyword_get(y) != Y_LIST){
+	    if (ge->ge_keys != NULL){
+		cprintf(reason, "Keys of non-list element %s", yang_argument_get(y));
+		return 0;
+	    }
+	    continue;
+	}
+	cv = NULL;
+	while (ge->ge_keys && (cv = cvec_each(ge->ge_keys, cv)) != NULL)
+	    if (yang_key_match(y, cv_name_get(cv)) == 0){
+		cprintf(reason, "Unknown key %s of %s", cv_name_get(cv), yang_argument_get(y));
+		return 0;
+	    }
+	cvk = yang_cvec_get(y);
+	cvi = NULL;
+	j = 0;
+	while ((cvi = cvec_each(cvk, cvi)) != NULL){
+	    key = cv_string_get(cvi);
+	    if (ge->ge_keys == NULL ||
+		(cv = cvec_find(ge->ge_keys, key)) == NULL ||
+		strcmp((val = cv_string_get(cv)), "*") == 0){
+		apiok = 0;
+		continue;
+	    }
+	    if (strchr(val, '\'') == NULL)
+		cprintf(xpath, "[%s:%s='%s']", prefix, key, val);
+	    else
+		cprintf(xpath, "[%s:%s=\"%s\"]", prefix, key, val);
+	    if (strpbrk(val, ",/=%") != NULL)
+		apiok = 0;
+	    cprintf(api_path, "%s%s", j++?",":"=", val);
+	}
+    }
+    if (gp->gp_len == 0)
+	cprintf(xpath, "/");
+    if (!apiok)
+	cbuf_reset(api_path);
+    return 1;
+}
+
+/*! Create XML skeleton of a gNMI path, for an edit of its last element
+ *
+ * All list keys must be given.
+ * @param[in]  yspec   Yang spec
+ * @param[in]  gp      gNMI path
+ * @param[in]  xtop    Top of XML tree, eg <config>
+ * @param[out] xbot    Last element, or xtop if path is empty
+ * @param[out] reason  Reason if invalid
+ * @retval     1       OK
+ * @retval     0       Invalid path, see reason
+ * @retval    -1       Error
+ */
+int
+gnmi_path2xml(yang_stmt *yspec,
+	      gnmi_path *gp,
+	      cxobj     *xtop,
+	      cxobj    **xbot,
+	      cbuf      *reason)
+{
+    struct gnmi_elem *ge;
+    yang_stmt        *y = NULL;
+    yang_stmt        *yk;
+    cxobj            *x = xtop;
+    cxobj            *xk;
+    cvec             *cvk;
+    cg_var           *cvi;
+    cg_var           *cv;
+    char             *ns;
+    char             *ns0 = NULL;
+    char             *key;
+    int               i;
+
+    for (i=0; i<gp->gp_len; i++){
+	ge = &gp->gp_vec[i];
+	if (gnmi_elem_yang(yspec, y, ge, &y, reason) == 0)
+	    return 0;
+	if ((x = xml_new(yang_argument_get(y), x, CX_ELMNT)) == NULL)
+	    return -1;
+	xml_spec_set(x, y);
+	ns = yang_find_mynamespace(y);
+	if (ns0 == NULL || strcmp(ns, ns0) != 0){
+	    if (xmlns_set(x, NULL, ns) < 0)
+		return -1;
+	}
+	ns0 = ns;
+	if (yang_keyword_get(y) != Y_LIST)
+	    continue;
+	cvk = yang_cvec_get(y);
+	cvi = NULL;
+	while ((cvi = cvec_each(cvk, cvi)) != NULL){
+	    key = cv_string_get(cvi);
+	    if (ge->ge_keys == NULL ||
+		(cv = cvec_find(ge->ge_keys, key)) == NULL ||
+		strcmp(cv_string_get(cv), "*") == 0){
+		cprintf(reason, "Missing key %s of %s", key, yang_argument_get(y));
+		return 0;
+	    }
+	    if ((xk = xml_new_body(key, x, cv_string_get(cv))) == NULL)
+		return -1;
+	    if ((yk = yang_find(y, Y_LEAF, key)) != NULL)
+		xml_spec_set(xk, yk);
+	}
+    }
+    *xbot = x;
+    return 1;
+}
+
+/*! Encode gNMI path of an XML node as a field of a message
+ *
+ * The path is given by the ancestors of the node that have YANG specs. Elements
+ * are prefixed with module name where the module changes.
+ * @param[in,out] pb   Message buffer
+ * @param[in]     num  Field number
+ * @param[in]     x    XML node bound to YANG
+ * @retval        0    OK
+ * @retval       -1    Error
+ */
+int
+gnmi_xml2path(pbuf    *pb,
+	      uint32_t num,
+	      cxobj   *x)
+{
+    int               retval = -1;
+    gnmi_path         gp = {0,};
+    struct gnmi_elem *ge;
+    cxobj            *xp;
+    cxobj           **vec = NULL;
+    yang_stmt        *y;
+    yang_stmt        *ymod0 = NULL;
+    cvec             *cvk;
+    cg_var           *cvi;
+    cbuf             *cb = NULL;
+    char             *key;
+    char             *val;
+    int               n = 0;
+    int               i;
+
+    for (xp = x; xp && xml_spec(xp); xp = xml_parent(xp))
+	n++;
+    if ((vec = calloc(n+1, sizeof(cxobj*))) == NULL ||
+	(gp.gp_vec = calloc(n+1, sizeof(struct gnmi_elem))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    i = n;
+    for (xp = x; xp && xml_spec(xp); xp = xml_parent(xp))
+	vec[--i] = xp;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    for (i=0; i<n; i++){
+	y = xml_spec(vec[i]);
+	cbuf_reset(cb);
+	if (ys_module(y) != ymod0)
+	    cprintf(cb, "%s:", yang_argument_get(ys_module(y)));
+	cprintf(cb, "%s", xml_name(vec[i]));
+	ymod0 = ys_module(y);
+	ge = &gp.gp_vec[gp.gp_len++];
+	if ((ge->ge_name = strdup(cbuf_get(cb))) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	if (yang_keyword_get(y) != Y_LIST)
+	    continue;
+	cvk = yang_cvec_get(y);
+	cvi = NULL;
+	while ((cvi = cvec_each(cvk, cvi)) != NULL){
+	    key = cv_string_get(cvi);
+	    if ((val = xml_find_body(vec[i], key)) == NULL)
+		continue;
+	    if (ge->ge_keys == NULL &&
+		(ge->ge_keys = cvec_new(0)) == NULL){
+		clicon_err(OE_UNIX, errno, "cvec_new");
+		goto done;
+	    }
+	    if (cvec_add_string(ge->ge_keys, key, val) < 0){
+		clicon_err(OE_UNIX, errno, "cvec_add_string");
+		goto done;
+	    }
+	}
+    }
+    if (gnmi_path_encode(pb, num, &gp) < 0)
+	goto done;
+    retval = 0;
+ done:
+    gnmi_path_reset(&gp);
+    if (vec)
+	free(vec);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
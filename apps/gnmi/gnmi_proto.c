@@ -0,0 +1,773 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Protocol buffers wire format, and the gNMI messages used by clixon_gnmi
+ * Messages are encoded and decoded directly on the wire format, field by field,
+ * without generated code. A sub-message is encoded into its own buffer and then
+ * appended as a length-delimited field.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "gnmi_proto.h"
+
+/* Field numbers of gNMI Path and PathElem */
+#define GNMI_PATH_ELEMENT 1 /* Deprecated string elements */
+#define GNMI_PATH_ORIGIN  2
+#define GNMI_PATH_ELEM    3
+#define GNMI_ELEM_NAME    1
+#define GNMI_ELEM_KEY     2
+
+/*! Create a message buffer
+ * @retval  pb    Message buffer, free with pbuf_free
+ * @retval  NULL  Error
+ */
+pbuf *
+pbuf_new(void)
+{
+    pbuf *pb;
+
+    if ((pb = malloc(sizeof(*pb))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(pb, 0, sizeof(*pb));
+    return pb;
+}
+
+int
+pbuf_free(pbuf *pb)
+{
+    if (pb->pb_buf)
+	free(pb->pb_buf);
+    free(pb);
+    return 0;
+}
+
+/*! Empty message buffer, memory is kept
+ */
+int
+pbuf_reset(pbuf *pb)
+{
+    pb->pb_len = 0;
+    return 0;
+}
+
+/*! Append data to message buffer
+ * @param[in]  pb    Message buffer
+ * @param[in]  data  Data
+ * @param[in]  len   Length of data
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+pbuf_append(pbuf       *pb,
+	    const void *data,
+	    size_t      len)
+{
+    size_t   max;
+    uint8_t *buf;
+
+    if (pb->pb_len + len > pb->pb_max){
+	max = pb->pb_max ? pb->pb_max : 256;
+	while (max < pb->pb_len + len)
+	    max *= 2;
+	if ((buf = realloc(pb->pb_buf, max)) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	pb->pb_buf = buf;
+	pb->pb_max = max;
+    }
+    if (len)
+	memcpy(pb->pb_buf + pb->pb_len, data, len);
+    pb->pb_len += len;
+    return 0;
+}
+
+/*! Append varint
+ */
+int
+pb_varint(pbuf    *pb,
+	  uint64_t v)
+{
+    uint8_t buf[10];
+    int     i = 0;
+
+    do {
+	buf[i] = v & 0x7f;
+	v >>= 7;
+	if (v)
+	    buf[i] |= 0x80;
+	i++;
+    } while (v);
+    return pbuf_append(pb, buf, i);
+}
+
+/*! Append varint field, eg int64, uint64, bool and enum
+ */
+int
+pb_field_varint(pbuf    *pb,
+		uint32_t num,
+		uint64_t v)
+{
+    if (pb_varint(pb, ((uint64_t)num << 3) | PB_VARINT) < 0)
+	return -1;
+    return pb_varint(pb, v);
+}
+
+/*! Append double field, 64 bits little-endian
+ */
+int
+pb_field_double(pbuf    *pb,
+		uint32_t num,
+		double   d)
+{
+    uint64_t u;
+    uint8_t  buf[8];
+    int      i;
+
+    if (pb_varint(pb, ((uint64_t)num << 3) | PB_I64) < 0)
+	return -1;
+    memcpy(&u, &d, sizeof(u));
+    for (i=0; i<8; i++)
+	buf[i] = (u >> (8*i)) & 0xff;
+    return pbuf_append(pb, buf, 8);
+}
+
+/*! Append length-delimited field, eg bytes, string or message
+ */
+int
+pb_field_bytes(pbuf       *pb,
+	       uint32_t    num,
+	       const void *data,
+	       size_t      len)
+{
+    if (pb_varint(pb, ((uint64_t)num << 3) | PB_LEN) < 0)
+	return -1;
+    if (pb_varint(pb, len) < 0)
+	return -1;
+    return pbuf_append(pb, data, len);
+}
+
+int
+pb_field_string(pbuf       *pb,
+		uint32_t    num,
+		const char *str)
+{
+    return pb_field_bytes(pb, num, str, strlen(str));
+}
+
+/*! Append encoded message as field
+ */
+int
+pb_field_msg(pbuf    *pb,
+	     uint32_t num,
+	     pbuf    *msg)
+{
+    return pb_field_bytes(pb, num, msg->pb_buf, msg->pb_len);
+}
+
+/*! Decode varint
+ * @retval  1   OK
+ * @retval  0   Truncated or too long
+ */
+static int
+pb_varint_decode(const uint8_t *buf,
+		 size_t         len,
+		 size_t        *off,
+		 uint64_t      *v)
+{
+    uint64_t u = 0;
+    int      shift = 0;
+    uint8_t  c;
+
+    do {
+	if (*off >= len || shift > 63)
+	    return 0;
+	c = buf[(*off)++];
+	u |= (uint64_t)(c & 0x7f) << shift;
+	shift += 7;
+    } while (c & 0x80);
+    *v = u;
+    return 1;
+}
+
+/*! Decode next field of a message
+ * @param[in]     buf  Encoded message
+ * @param[in]     len  Length of buf
+ * @param[in,out] off  Offset of next field, initially 0
+ * @param[out]    pf   Decoded field, data points into buf
+ * @retval        1    Field decoded
+ * @retval        0    End of message
+ * @retval       -1    Malformed message
+ * @code
+ *   size_t   off = 0;
+ *   pb_field pf;
+ *   while ((ret = pb_next(buf, len, &off, &pf)) == 1)
+ *      switch (pf.pf_num) ...
+ *   if (ret < 0)
+ *      malformed;
+ * @endcode
+ */
+int
+pb_next(const uint8_t *buf,
+	size_t         len,
+	size_t        *off,
+	pb_field      *pf)
+{
+    uint64_t tag;
+    uint64_t v;
+    int      i;
+
+    if (*off >= len)
+	return 0;
+    memset(pf, 0, sizeof(*pf));
+    if (pb_varint_decode(buf, len, off, &tag) == 0)
+	return -1;
+    pf->pf_num = tag >> 3;
+    pf->pf_wire = tag & 0x7;
+    switch (pf->pf_wire){
+    case PB_VARINT:
+	if (pb_varint_decode(buf, len, off, &pf->pf_varint) == 0)
+	    return -1;
+	break;
+    case PB_I64:
+    case PB_I32:
+	i = pf->pf_wire == PB_I64 ? 8 : 4;
+	if (*off + i > len)
+	    return -1;
+	v = 0;
+	while (i--)
+	    v = (v << 8) | buf[*off + i];
+	pf->pf_varint = v;
+	*off += pf->pf_wire == PB_I64 ? 8 : 4;
+	break;
+    case PB_LEN:
+	if (pb_varint_decode(buf, len, off, &v) == 0 ||
+	    v > len - *off)
+	    return -1;
+	pf->pf_data = buf + *off;
+	pf->pf_len = v;
+	*off += v;
+	break;
+    default: /* Groups are not used by proto3 */
+	return -1;
+    }
+    return 1;
+}
+
+/*! Copy length-delimited field as a string
+ * @param[in]  pf    Decoded field
+ * @retval     str   Malloced string, free with free
+ * @retval     NULL  Error
+ */
+char *
+pb_string(pb_field *pf)
+{
+    char *str;
+
+    if ((str = malloc(pf->pf_len + 1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    if (pf->pf_len)
+	memcpy(str, pf->pf_data, pf->pf_len);
+    str[pf->pf_len] = '\0';
+    return str;
+}
+
+/*! Add element last to gNMI path
+ * @param[in]  gp    gNMI path
+ * @param[in]  name  Element name, consumed
+ * @retval     ge    New element
+ * @retval     NULL  Error
+ */
+static struct gnmi_elem *
+gnmi_path_add(gnmi_path *gp,
+	      char      *name)
+{
+    struct gnmi_elem *vec;
+    struct gnmi_elem *ge;
+
+    if ((vec = realloc(gp->gp_vec, (gp->gp_len+1)*sizeof(*vec))) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	free(name);
+	return NULL;
+    }
+    gp->gp_vec = vec;
+    ge = &gp->gp_vec[gp->gp_len++];
+    ge->ge_name = name;
+    ge->ge_keys = NULL;
+    return ge;
+}
+
+/*! Decode a key map entry of PathElem and add it to element
+ * @retval  1   OK
+ * @retval  0   Malformed
+ * @retval -1   Error
+ */
+static int
+gnmi_key_decode(const uint8_t    *buf,
+		size_t            len,
+		struct gnmi_elem *ge)
+{
+    int      retval = -1;
+    size_t   off = 0;
+    pb_field pf;
+    char    *key = NULL;
+    char    *val = NULL;
+    int      ret;
+
+    while ((ret = pb_next(buf, len, &off, &pf)) == 1){
+	if (pf.pf_wire != PB_LEN)
+	    continue;
+	if (pf.pf_num == 1){
+	    if (key)
+		free(key);
+	    if ((key = pb_string(&pf)) == NULL)
+		goto done;
+	}
+	else if (pf.pf_num == 2){
+	    if (val)
+		free(val);
+	    if ((val = pb_string(&pf)) == NULL)
+		goto done;
+	}
+    }
+    if (ret < 0 || key == NULL)
+	goto fail;
+    if (ge->ge_keys == NULL &&
+	(ge->ge_keys = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if (cvec_add_string(ge->ge_keys, key, val?val:"") < 0){
+	clicon_err(OE_UNIX, errno, "cvec_add_string");
+	goto done;
+    }
+    retval = 1;
+ done:
+    if (key)
+	free(key);
+    if (val)
+	free(val);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Decode gNMI Path and append its elements to a path
+ *
+ * Appending is used to merge the prefix of a request with each of its paths
+ * @param[in]     buf  Encoded Path message
+ * @param[in]     len  Length of buf
+ * @param[in,out] gp   gNMI path, initially zeroed
+ * @retval        1    OK
+ * @retval        0    Malformed
+ * @retval       -1    Error
+ */
+int
+gnmi_path_decode(const uint8_t *buf,
+		 size_t         len,
+		 gnmi_path     *gp)
+{
+    int               retval = -1;
+    size_t            off = 0;
+    size_t            off1;
+    pb_field          pf;
+    pb_field          pf1;
+    struct gnmi_elem *ge;
+    char             *name;
+    int               ret;
+
+    while ((ret = pb_next(buf, len, &off, &pf)) == 1){
+	if (pf.pf_wire != PB_LEN)
+	    continue;
+	switch (pf.pf_num){
+	case GNMI_PATH_ORIGIN:
+	    if (gp->gp_origin)
+		free(gp->gp_origin);
+	    if ((gp->gp_origin = pb_string(&pf)) == NULL)
+		goto done;
+	    break;
+	case GNMI_PATH_ELEMENT:
+	    if ((name = pb_string(&pf)) == NULL)
+		goto done;
+	    if (gnmi_path_add(gp, name) == NULL)
+		goto done;
+	    break;
+	case GNMI_PATH_ELEM:
+	    name = NULL;
+	    off1 = 0;
+	    while ((ret = pb_next(pf.pf_data, pf.pf_len, &off1, &pf1)) == 1)
+		if (pf1.pf_num == GNMI_ELEM_NAME && pf1.pf_wire == PB_LEN){
+		    if (name)
+			free(name);
+		    if ((name = pb_string(&pf1)) == NULL)
+			goto done;
+		}
+	    if (ret < 0 || name == NULL){
+		if (name)
+		    free(name);
+		goto fail;
+	    }
+	    if ((ge = gnmi_path_add(gp, name)) == NULL)
+		goto done;
+	    off1 = 0;
+	    while ((ret = pb_next(pf.pf_data, pf.pf_len, &off1, &pf1)) == 1)
+		if (pf1.pf_num == GNMI_ELEM_KEY && pf1.pf_wire == PB_LEN){
+		    if ((ret = gnmi_key_decode(pf1.pf_data, pf1.pf_len, ge)) < 0)
+			goto done;
+		    if (ret == 0)
+			goto fail;
+		}
+	    break;
+	default:
+	    break;
+	}
+    }
+    if (ret < 0)
+	goto fail;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Append elements of a path to another path, eg request prefix and path
+ * @param[in,out] gp   gNMI path
+ * @param[in]     gp1  gNMI path to append
+ */
+int
+gnmi_path_append(gnmi_path *gp,
+		 gnmi_path *gp1)
+{
+    struct gnmi_elem *ge;
+    struct gnmi_elem *ge1;
+    char             *name;
+    int               i;
+
+    if (gp->gp_origin == NULL && gp1->gp_origin &&
+	(gp->gp_origin = strdup(gp1->gp_origin)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	return -1;
+    }
+    for (i=0; i<gp1->gp_len; i++){
+	ge1 = &gp1->gp_vec[i];
+	if ((name = strdup(ge1->ge_name)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    return -1;
+	}
+	if ((ge = gnmi_path_add(gp, name)) == NULL)
+	    return -1;
+	if (ge1->ge_keys &&
+	    (ge->ge_keys = cvec_dup(ge1->ge_keys)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_dup");
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+/*! Free elements of gNMI path, the path itself is zeroed but not freed
+ */
+int
+gnmi_path_reset(gnmi_path *gp)
+{
+    int i;
+
+    for (i=0; i<gp->gp_len; i++){
+	free(gp->gp_vec[i].ge_name);
+	if (gp->gp_vec[i].ge_keys)
+	    cvec_free(gp->gp_vec[i].ge_keys);
+    }
+    if (gp->gp_vec)
+	free(gp->gp_vec);
+    if (gp->gp_origin)
+	free(gp->gp_origin);
+    memset(gp, 0, sizeof(*gp));
+    return 0;
+}
+
+/*! Encode gNMI path as a field of a message
+ * @param[in,out] pb   Message buffer
+ * @param[in]     num  Field number
+ * @param[in]     gp   gNMI path
+ */
+int
+gnmi_path_encode(pbuf      *pb,
+		 uint32_t   num,
+		 gnmi_path *gp)
+{
+    int     retval = -1;
+    pbuf   *pp = NULL;
+    pbuf   *pe = NULL;
+    pbuf   *pk = NULL;
+    cg_var *cv;
+    int     i;
+
+    if ((pp = pbuf_new()) == NULL ||
+	(pe = pbuf_new()) == NULL ||
+	(pk = pbuf_new()) == NULL)
+	goto done;
+    if (gp->gp_origin &&
+	pb_field_string(pp, GNMI_PATH_ORIGIN, gp->gp_origin) < 0)
+	goto done;
+    for (i=0; i<gp->gp_len; i++){
+	pbuf_reset(pe);
+	if (pb_field_string(pe, GNMI_ELEM_NAME, gp->gp_vec[i].ge_name) < 0)
+	    goto done;
+	cv = NULL;
+	while (gp->gp_vec[i].ge_keys &&
+	       (cv = cvec_each(gp->gp_vec[i].ge_keys, cv)) != NULL){
+	    pbuf_reset(pk);
+	    if (pb_field_string(pk, 1, cv_name_get(cv)) < 0 ||
+		pb_field_string(pk, 2, cv_string_get(cv)) < 0 ||
+		pb_field_msg(pe, GNMI_ELEM_KEY, pk) < 0)
+		goto done;
+	}
+	if (pb_field_msg(pp, GNMI_PATH_ELEM, pe) < 0)
+	    goto done;
+    }
+    if (pb_field_msg(pb, num, pp) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (pp)
+	pbuf_free(pp);
+    if (pe)
+	pbuf_free(pe);
+    if (pk)
+	pbuf_free(pk);
+    return retval;
+}
+
+/*! Print gNMI path as string for logs and error messages, eg /c/a[b=1]
+ */
+int
+gnmi_path_str(cbuf      *cb,
+	      gnmi_path *gp)
+{
+    cg_var *cv;
+    int     i;
+
+    if (gp->gp_len == 0)
+	cprintf(cb, "/");
+    for (i=0; i<gp->gp_len; i++){
+	cprintf(cb, "/%s", gp->gp_vec[i].ge_name);
+	cv = NULL;
+	while (gp->gp_vec[i].ge_keys &&
+	       (cv = cvec_each(gp->gp_vec[i].ge_keys, cv)) != NULL)
+	    cprintf(cb, "[%s=%s]", cv_name_get(cv), cv_string_get(cv));
+    }
+    return 0;
+}
+
+/*! Add string value to decoded TypedValue
+ * @param[in]  gv   Decoded value
+ * @param[in]  str  String value, consumed
+ */
+static int
+gnmi_value_add(gnmi_value *gv,
+	       char       *str)
+{
+    char **vec;
+
+    if ((vec = realloc(gv->gv_vec, (gv->gv_len+1)*sizeof(char*))) == NULL){
+	clicon_err(OE_UNIX, errno, "realloc");
+	free(str);
+	return -1;
+    }
+    gv->gv_vec = vec;
+    gv->gv_vec[gv->gv_len++] = str;
+    return 0;
+}
+
+/*! Decode scalar field of TypedValue to string
+ * @retval  1   OK
+ * @retval  0   Unsupported type
+ * @retval -1   Error
+ */
+static int
+gnmi_scalar_decode(pb_field *pf,
+		   char    **strp)
+{
+    char     buf[64];
+    double   d;
+    float    f;
+    uint32_t u32;
+
+    switch (pf->pf_num){
+    case GNMI_VAL_STRING:
+    case GNMI_VAL_BYTES:
+    case GNMI_VAL_ASCII:
+    case GNMI_VAL_JSON:
+    case GNMI_VAL_JSON_IETF:
+	if (pf->pf_wire != PB_LEN)
+	    return 0;
+	if ((*strp = pb_string(pf)) == NULL)
+	    return -1;
+	return 1;
+    case GNMI_VAL_INT:
+	snprintf(buf, sizeof(buf), "%" PRId64, (int64_t)pf->pf_varint);
+	break;
+    case GNMI_VAL_UINT:
+	snprintf(buf, sizeof(buf), "%" PRIu64, pf->pf_varint);
+	break;
+    case GNMI_VAL_BOOL:
+	snprintf(buf, sizeof(buf), "%s", pf->pf_varint?"true":"false");
+	break;
+    case GNMI_VAL_DOUBLE:
+	memcpy(&d, &pf->pf_varint, sizeof(d));
+	snprintf(buf, sizeof(buf), "%.17g", d);
+	break;
+    case GNMI_VAL_FLOAT:
+	u32 = (uint32_t)pf->pf_varint;
+	memcpy(&f, &u32, sizeof(f));
+	snprintf(buf, sizeof(buf), "%.9g", (double)f);
+	break;
+    default: /* decimal_val, any_val, proto_bytes */
+	return 0;
+    }
+    if ((*strp = strdup(buf)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	return -1;
+    }
+    return 1;
+}
+
+/*! Decode gNMI TypedValue
+ *
+ * Scalar values are translated to strings as in XML bodies, json_val and json_ietf_val
+ * are kept as JSON text, and each element of leaflist_val gives one string.
+ * @param[in]  buf  Encoded TypedValue message
+ * @param[in]  len  Length of buf
+ * @param[out] gv   Decoded value, initially zeroed, free with gnmi_value_reset
+ * @retval     1    OK
+ * @retval     0    Malformed or unsupported value type
+ * @retval    -1    Error
+ */
+int
+gnmi_value_decode(const uint8_t *buf,
+		  size_t         len,
+		  gnmi_value    *gv)
+{
+    size_t   off = 0;
+    size_t   off1;
+    pb_field pf;
+    pb_field pf1;
+    pb_field pf2;
+    size_t   off2;
+    char    *str;
+    int      ret;
+
+    while ((ret = pb_next(buf, len, &off, &pf)) == 1){
+	if (pf.pf_num == GNMI_VAL_LEAFLIST){ /* ScalarArray of TypedValue elements */
+	    off1 = 0;
+	    while ((ret = pb_next(pf.pf_data, pf.pf_len, &off1, &pf1)) == 1){
+		if (pf1.pf_num != 1 || pf1.pf_wire != PB_LEN)
+		    continue;
+		off2 = 0;
+		if ((ret = pb_next(pf1.pf_data, pf1.pf_len, &off2, &pf2)) < 0)
+		    return 0;
+		if (ret == 0)
+		    continue;
+		if ((ret = gnmi_scalar_decode(&pf2, &str)) < 0)
+		    return -1;
+		if (ret == 0)
+		    return 0;
+		if (gnmi_value_add(gv, str) < 0)
+		    return -1;
+	    }
+	    if (ret < 0)
+		return 0;
+	    continue;
+	}
+	if ((ret = gnmi_scalar_decode(&pf, &str)) < 0)
+	    return -1;
+	if (ret == 0)
+	    return 0;
+	if (gnmi_value_add(gv, str) < 0)
+	    return -1;
+	gv->gv_json = pf.pf_num == GNMI_VAL_JSON || pf.pf_num == GNMI_VAL_JSON_IETF;
+    }
+    if (ret < 0 || gv->gv_len == 0)
+	return 0;
+    return 1;
+}
+
+int
+gnmi_value_reset(gnmi_value *gv)
+{
+    int i;
+
+    for (i=0; i<gv->gv_len; i++)
+	free(gv->gv_vec[i]);
+    if (gv->gv_vec)
+	free(gv->gv_vec);
+    memset(gv, 0, sizeof(*gv));
+    return 0;
+}
+
+/*! Current time in ns since the epoch, as timestamp of gNMI notifications
+ */
+int64_t
+gnmi_timestamp(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
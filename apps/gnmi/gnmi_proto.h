@@ -0,0 +1,159 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Protocol buffers wire format, and the gNMI messages used by clixon_gnmi
+ * @see https://developers.google.com/protocol-buffers/docs/encoding
+ * @see https://github.com/openconfig/gnmi/blob/master/proto/gnmi/gnmi.proto
+ */
+
+#ifndef _GNMI_PROTO_H_
+#define _GNMI_PROTO_H_
+
+/*
+ * Constants
+ */
+/* Protobuf wire types */
+#define PB_VARINT 0
+#define PB_I64    1
+#define PB_LEN    2
+#define PB_I32    5
+
+/* gNMI Encoding enum */
+#define GNMI_ENC_JSON      0
+#define GNMI_ENC_BYTES     1
+#define GNMI_ENC_PROTO     2
+#define GNMI_ENC_ASCII     3
+#define GNMI_ENC_JSON_IETF 4
+
+/* gNMI GetRequest DataType enum */
+#define GNMI_TYPE_ALL         0
+#define GNMI_TYPE_CONFIG      1
+#define GNMI_TYPE_STATE       2
+#define GNMI_TYPE_OPERATIONAL 3
+
+/* gNMI SubscriptionList Mode enum */
+#define GNMI_LIST_STREAM 0
+#define GNMI_LIST_ONCE   1
+#define GNMI_LIST_POLL   2
+
+/* gNMI SubscriptionMode enum */
+#define GNMI_SUB_TARGET_DEFINED 0
+#define GNMI_SUB_ON_CHANGE      1
+#define GNMI_SUB_SAMPLE         2
+
+/* gNMI UpdateResult Operation enum */
+#define GNMI_OP_DELETE  1
+#define GNMI_OP_REPLACE 2
+#define GNMI_OP_UPDATE  3
+
+/* Field numbers of gNMI TypedValue */
+#define GNMI_VAL_STRING    1
+#define GNMI_VAL_INT       2
+#define GNMI_VAL_UINT      3
+#define GNMI_VAL_BOOL      4
+#define GNMI_VAL_BYTES     5
+#define GNMI_VAL_FLOAT     6
+#define GNMI_VAL_DECIMAL   7
+#define GNMI_VAL_LEAFLIST  8
+#define GNMI_VAL_ANY       9
+#define GNMI_VAL_JSON      10
+#define GNMI_VAL_JSON_IETF 11
+#define GNMI_VAL_ASCII     12
+#define GNMI_VAL_DOUBLE    14
+
+/*
+ * Types
+ */
+/* Growable byte buffer of an encoded message */
+typedef struct pbuf{
+    uint8_t *pb_buf;
+    size_t   pb_len;
+    size_t   pb_max;
+} pbuf;
+
+/* A decoded field of a message, see pb_next */
+typedef struct pb_field{
+    uint32_t       pf_num;    /* Field number */
+    int            pf_wire;   /* Wire type */
+    uint64_t       pf_varint; /* Value of varint, i64 and i32 fields */
+    const uint8_t *pf_data;   /* Data of length-delimited field */
+    size_t         pf_len;    /* Length of pf_data */
+} pb_field;
+
+/* Element of gNMI path: name and list keys */
+struct gnmi_elem{
+    char *ge_name;
+    cvec *ge_keys;  /* Key name and value as string variables, or NULL */
+};
+
+/* gNMI path, eg prefix and path of a request appended */
+typedef struct gnmi_path{
+    char             *gp_origin;
+    int               gp_len;
+    struct gnmi_elem *gp_vec;
+} gnmi_path;
+
+/* Decoded gNMI TypedValue: scalar values are translated to strings */
+typedef struct gnmi_value{
+    int    gv_json;  /* Set if json_val or json_ietf_val */
+    int    gv_len;   /* Number of values, more than one for leaflist_val */
+    char **gv_vec;
+} gnmi_value;
+
+/*
+ * Prototypes
+ */
+pbuf *pbuf_new(void);
+int   pbuf_free(pbuf *pb);
+int   pbuf_reset(pbuf *pb);
+int   pbuf_append(pbuf *pb, const void *data, size_t len);
+int   pb_varint(pbuf *pb, uint64_t v);
+int   pb_field_varint(pbuf *pb, uint32_t num, uint64_t v);
+int   pb_field_double(pbuf *pb, uint32_t num, double d);
+int   pb_field_bytes(pbuf *pb, uint32_t num, const void *data, size_t len);
+int   pb_field_string(pbuf *pb, uint32_t num, const char *str);
+int   pb_field_msg(pbuf *pb, uint32_t num, pbuf *msg);
+int   pb_next(const uint8_t *buf, size_t len, size_t *off, pb_field *pf);
+char *pb_string(pb_field *pf);
+int   gnmi_path_decode(const uint8_t *buf, size_t len, gnmi_path *gp);
+int   gnmi_path_append(gnmi_path *gp, gnmi_path *gp1);
+int   gnmi_path_reset(gnmi_path *gp);
+int   gnmi_path_encode(pbuf *pb, uint32_t num, gnmi_path *gp);
+int   gnmi_path_str(cbuf *cb, gnmi_path *gp);
+int   gnmi_value_decode(const uint8_t *buf, size_t len, gnmi_value *gv);
+int   gnmi_value_reset(gnmi_value *gv);
+int64_t gnmi_timestamp(void);
+
+#endif  /* _GNMI_PROTO_H_ */
@@ -0,0 +1,1683 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * gNMI methods of clixon_gnmi: Capabilities, Get, Set and Subscribe
+ * Get and Subscribe read data with get to the backend, using api-path lookup where the
+ * path allows. Set edits candidate and commits. Subscribe STREAM opens a backend push
+ * subscription (see establish-push in clixon-lib.yang) per gNMI subscription:
+ * SAMPLE is a periodic push, ON_CHANGE and TARGET_DEFINED an on-change push.
+ * @see https://github.com/openconfig/reference/blob/master/rpc/gnmi/gnmi-specification.md
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+
+#include <openssl/ssl.h>
+#include <nghttp2/nghttp2.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+#include "gnmi_proto.h"
+#include "gnmi_lib.h"
+#include "gnmi_path.h"
+#include "gnmi_rpc.h"
+
+/* gNMI version of Capabilities */
+#define GNMI_VERSION "0.8.0"
+
+/* Default period of SAMPLE subscription without sample_interval, in centiseconds */
+#define GNMI_SAMPLE_DEFAULT 100
+
+/* gRPC methods of gNMI service */
+enum gnmi_method{
+    GNMI_CAPABILITIES,
+    GNMI_GET,
+    GNMI_SET,
+    GNMI_SUBSCRIBE,
+};
+
+/* Backend push subscription of a gNMI STREAM subscription */
+struct gnmi_sub{
+    qelem_t             su_qelem;
+    struct gnmi_stream *su_gs;    /* Stream of Subscribe call */
+    int                 su_s;     /* Backend session socket, or -1 */
+    char               *su_xpath; /* XPath of subscription path */
+    cvec               *su_nsc;   /* Namespace context of su_xpath */
+};
+
+/* State of a gNMI call, see gs_arg of stream */
+struct gnmi_call{
+    enum gnmi_method cl_method;
+    int              cl_mode;         /* SubscriptionList mode, eg GNMI_LIST_STREAM */
+    int              cl_encoding;     /* Encoding, eg GNMI_ENC_JSON_IETF */
+    int              cl_updates_only; /* Only send updates after sync_response */
+    pbuf            *cl_sublist;      /* SubscriptionList of Subscribe */
+    struct gnmi_sub *cl_subs;         /* Backend push subscriptions */
+};
+
+static int gnmi_push_cb(int s, void *arg);
+
+/*! Check encoding of request
+ * @retval  1  Supported
+ * @retval  0  Not supported
+ */
+static int
+gnmi_encoding_ok(int encoding)
+{
+    return encoding == GNMI_ENC_JSON ||
+	encoding == GNMI_ENC_PROTO ||
+	encoding == GNMI_ENC_JSON_IETF;
+}
+
+/*! Print JSON value of XML node, ie its RFC 7951 JSON without member name
+ */
+static int
+gnmi_json_value(cbuf  *cb,
+		cxobj *x)
+{
+    int   retval = -1;
+    cbuf *cbj = NULL;
+    char *str;
+    char *p;
+    int   len;
+
+    if ((cbj = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (xml2json_cbuf(cbj, x, 0) < 0)
+	goto done;
+    /* Strip {"module:name": and } */
+    str = cbuf_get(cbj);
+    len = cbuf_len(cbj);
+    if ((p = strstr(str, "\":")) == NULL || len < 2 || str[len-1] != '}'){
+	clicon_err(OE_XML, EINVAL, "Unexpected JSON of %s", xml_name(x));
+	goto done;
+    }
+    str[len-1] = '\0';
+    cprintf(cb, "%s", p+2);
+    retval = 0;
+ done:
+    if (cbj)
+	cbuf_free(cbj);
+    return retval;
+}
+
+/*! Encode TypedValue field of a leaf body, with protobuf type given by YANG type
+ * @param[in,out] pv    TypedValue message
+ * @param[in]     y     YANG leaf or leaf-list
+ * @param[in]     body  Body of leaf
+ */
+static int
+gnmi_typed_value(pbuf      *pv,
+		 yang_stmt *y,
+		 char      *body)
+{
+    switch (y?yang_type2cv(y):CGV_STRING){
+    case CGV_INT8:
+    case CGV_INT16:
+    case CGV_INT32:
+    case CGV_INT64:
+	return pb_field_varint(pv, GNMI_VAL_INT, (uint64_t)strtoll(body, NULL, 10));
+    case CGV_UINT8:
+    case CGV_UINT16:
+    case CGV_UINT32:
+    case CGV_UINT64:
+	return pb_field_varint(pv, GNMI_VAL_UINT, strtoull(body, NULL, 10));
+    case CGV_BOOL:
+	return pb_field_varint(pv, GNMI_VAL_BOOL, strcmp(body, "true") == 0);
+    case CGV_DEC64:
+	return pb_field_double(pv, GNMI_VAL_DOUBLE, strtod(body, NULL));
+    default:
+	return pb_field_string(pv, GNMI_VAL_STRING, body);
+    }
+}
+
+/*! Encode Update of a leaf, or of leaf-list entries, to a Notification
+ * @param[in,out] pn        Notification message
+ * @param[in]     vec       Leaf, or entries of a leaf-list
+ * @param[in]     veclen    Length of vec
+ * @param[in]     encoding  Encoding of value
+ */
+static int
+gnmi_leaf_update(pbuf    *pn,
+		 cxobj  **vec,
+		 int      veclen,
+		 int      encoding)
+{
+    int        retval = -1;
+    pbuf      *pu = NULL;
+    pbuf      *pv = NULL;
+    pbuf      *pa = NULL;
+    pbuf      *pe = NULL;
+    cbuf      *cb = NULL;
+    yang_stmt *y;
+    char      *body;
+    int        i;
+
+    if ((pu = pbuf_new()) == NULL ||
+	(pv = pbuf_new()) == NULL ||
+	(pa = pbuf_new()) == NULL ||
+	(pe = pbuf_new()) == NULL)
+	goto done;
+    y = xml_spec(vec[0]);
+    if (gnmi_xml2path(pu, 1, vec[0]) < 0)
+	goto done;
+    if (encoding != GNMI_ENC_PROTO){
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (y && yang_keyword_get(y) == Y_LEAF_LIST)
+	    cprintf(cb, "[");
+	for (i=0; i<veclen; i++){
+	    if (i)
+		cprintf(cb, ",");
+	    if (gnmi_json_value(cb, vec[i]) < 0)
+		goto done;
+	}
+	if (y && yang_keyword_get(y) == Y_LEAF_LIST)
+	    cprintf(cb, "]");
+	if (pb_field_string(pv, encoding==GNMI_ENC_JSON?GNMI_VAL_JSON:GNMI_VAL_JSON_IETF,
+			    cbuf_get(cb)) < 0)
+	    goto done;
+    }
+    else if (y && yang_keyword_get(y) == Y_LEAF_LIST){
+	for (i=0; i<veclen; i++){
+	    pbuf_reset(pe);
+	    if ((body = xml_body(vec[i])) == NULL)
+		body = "";
+	    if (gnmi_typed_value(pe, y, body) < 0 ||
+		pb_field_msg(pa, 1, pe) < 0)
+		goto done;
+	}
+	if (pb_field_msg(pv, GNMI_VAL_LEAFLIST, pa) < 0)
+	    goto done;
+    }
+    else{
+	if ((body = xml_body(vec[0])) == NULL)
+	    body = "";
+	if (gnmi_typed_value(pv, y, body) < 0)
+	    goto done;
+    }
+    if (pb_field_msg(pu, 3, pv) < 0 ||
+	pb_field_msg(pn, 4, pu) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (pu)
+	pbuf_free(pu);
+    if (pv)
+	pbuf_free(pv);
+    if (pa)
+	pbuf_free(pa);
+    if (pe)
+	pbuf_free(pe);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Encode Updates of all leaves of an XML subtree to a Notification
+ *
+ * The entries of a leaf-list are encoded as one Update
+ * @param[in,out] pn        Notification message
+ * @param[in]     x         XML subtree
+ * @param[in]     encoding  Encoding of values
+ */
+static int
+gnmi_leaves_update(pbuf  *pn,
+		   cxobj *x,
+		   int    encoding)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    cxobj     *xc;
+    cxobj     *xprev;
+    cxobj     *xs;
+    cxobj    **vec = NULL;
+    int        veclen;
+
+    y = xml_spec(x);
+    if (y && (yang_keyword_get(y) == Y_LEAF || yang_keyword_get(y) == Y_LEAF_LIST))
+	return gnmi_leaf_update(pn, &x, 1, encoding);
+    xc = NULL;
+    while ((xc = xml_child_each(x, xprev = xc, CX_ELMNT)) != NULL){
+	y = xml_spec(xc);
+	if (y == NULL || yang_keyword_get(y) != Y_LEAF_LIST){
+	    if (gnmi_leaves_update(pn, xc, encoding) < 0)
+		goto done;
+	    continue;
+	}
+	if (xprev && xml_spec(xprev) == y) /* Not first entry of leaf-list */
+	    continue;
+	veclen = 0;
+	for (xs = xc; xs && xml_spec(xs) == y; xs = xml_child_each(x, xs, CX_ELMNT)){
+	    if ((vec = realloc(vec, (veclen+1)*sizeof(cxobj*))) == NULL){
+		clicon_err(OE_UNIX, errno, "realloc");
+		goto done;
+	    }
+	    vec[veclen++] = xs;
+	}
+	if (gnmi_leaf_update(pn, vec, veclen, encoding) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Encode Update of an XML node to a Notification
+ *
+ * With JSON encodings the node is one Update with the subtree as value, with PROTO
+ * encoding each leaf is an Update with scalar value
+ * @param[in,out] pn        Notification message
+ * @param[in]     x         XML node
+ * @param[in]     encoding  Encoding of values
+ */
+static int
+gnmi_node_update(pbuf  *pn,
+		 cxobj *x,
+		 int    encoding)
+{
+    int   retval = -1;
+    pbuf *pu = NULL;
+    pbuf *pv = NULL;
+    cbuf *cb = NULL;
+
+    if (encoding == GNMI_ENC_PROTO)
+	return gnmi_leaves_update(pn, x, encoding);
+    if ((pu = pbuf_new()) == NULL ||
+	(pv = pbuf_new()) == NULL)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (gnmi_json_value(cb, x) < 0)
+	goto done;
+    if (gnmi_xml2path(pu, 1, x) < 0 ||
+	pb_field_string(pv, encoding==GNMI_ENC_JSON?GNMI_VAL_JSON:GNMI_VAL_JSON_IETF,
+			cbuf_get(cb)) < 0 ||
+	pb_field_msg(pu, 3, pv) < 0 ||
+	pb_field_msg(pn, 4, pu) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (pu)
+	pbuf_free(pu);
+    if (pv)
+	pbuf_free(pv);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Get gRPC status and reason of rpc-error
+ */
+static int
+gnmi_rpc_error(cxobj *xerr,
+	       int   *code,
+	       cbuf  *reason)
+{
+    char *tag;
+    char *msg;
+
+    tag = xml_find_body(xerr, "error-tag");
+    if ((msg = xml_find_body(xerr, "error-message")) != NULL)
+	cprintf(reason, "%s", msg);
+    else
+	cprintf(reason, "%s", tag?tag:"Error");
+    if (tag && strcmp(tag, "access-denied") == 0)
+	*code = GRPC_PERMISSION_DENIED;
+    else
+	*code = GRPC_INVALID_ARGUMENT;
+    return 0;
+}
+
+/*! Get data of a gNMI path from backend and encode it as a Notification
+ *
+ * @param[in]  h         Clicon handle
+ * @param[in]  gp        gNMI path
+ * @param[in]  content   Config and/or state data
+ * @param[in]  encoding  Encoding of values
+ * @param[in]  notfound  Fail with NOT_FOUND if there is no data
+ * @param[out] pn        Notification message
+ * @param[out] code      gRPC status if failed
+ * @param[out] reason    Reason if failed
+ * @retval     1         OK
+ * @retval     0         Failed, see code and reason
+ * @retval    -1         Error
+ */
+static int
+gnmi_path_notification(clicon_handle   h,
+		       gnmi_path      *gp,
+		       netconf_content content,
+		       int             encoding,
+		       int             notfound,
+		       pbuf           *pn,
+		       int            *code,
+		       cbuf           *reason)
+{
+    int        retval = -1;
+    yang_stmt *yspec = clicon_dbspec_yang(h);
+    cbuf      *xpath = NULL;
+    cbuf      *api_path = NULL;
+    cvec      *nsc = NULL;
+    cxobj     *xd = NULL;
+    cxobj     *xerr;
+    cxobj    **vec = NULL;
+    size_t     veclen = 0;
+    int        ret;
+    int        i;
+
+    if ((xpath = cbuf_new()) == NULL ||
+	(api_path = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((nsc = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if ((ret = gnmi_path2xpath(yspec, gp, xpath, nsc, api_path, reason)) < 0)
+	goto done;
+    if (ret == 0){
+	*code = GRPC_INVALID_ARGUMENT;
+	goto fail;
+    }
+    if (clicon_rpc_get_page(h, cbuf_get(xpath), nsc,
+			    cbuf_len(api_path)?cbuf_get(api_path):NULL,
+			    content, -1, 0, 0, &xd) < 0){
+	*code = GRPC_INTERNAL;
+	cprintf(reason, "%s", clicon_err_reason);
+	goto fail;
+    }
+    if ((xerr = xpath_first(xd, NULL, "rpc-error")) != NULL){
+	gnmi_rpc_error(xerr, code, reason);
+	goto fail;
+    }
+    if (xpath_vec(xd, nsc, "%s", &vec, &veclen, cbuf_get(xpath)) < 0)
+	goto done;
+    if (veclen == 0 && notfound){
+	*code = GRPC_NOT_FOUND;
+	cprintf(reason, "No data of ");
+	gnmi_path_str(reason, gp);
+	goto fail;
+    }
+    if (pb_field_varint(pn, 1, gnmi_timestamp()) < 0)
+	goto done;
+    for (i=0; i<veclen; i++)
+	if (gnmi_node_update(pn, vec[i], encoding) < 0)
+	    goto done;
+    retval = 1;
+ done:
+    if (xpath)
+	cbuf_free(xpath);
+    if (api_path)
+	cbuf_free(api_path);
+    if (nsc)
+	cvec_free(nsc);
+    if (xd)
+	xml_free(xd);
+    if (vec)
+	free(vec);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Decode Path field of a request and append it to prefix
+ * @param[in]  pf      Path field
+ * @param[in]  prefix  Prefix of request
+ * @param[out] gp      Prefix and path, initially zeroed
+ * @retval     1       OK
+ * @retval     0       Malformed
+ * @retval    -1       Error
+ */
+static int
+gnmi_request_path(pb_field  *pf,
+		  gnmi_path *prefix,
+		  gnmi_path *gp)
+{
+    if (gnmi_path_append(gp, prefix) < 0)
+	return -1;
+    return gnmi_path_decode(pf->pf_data, pf->pf_len, gp);
+}
+
+/*! Capabilities: supported models, encodings and gNMI version
+ */
+static int
+gnmi_capabilities(clicon_handle       h,
+		  struct gnmi_stream *gs)
+{
+    int        retval = -1;
+    yang_stmt *yspec = clicon_dbspec_yang(h);
+    yang_stmt *ymod = NULL;
+    yang_stmt *ys;
+    pbuf      *pr = NULL;
+    pbuf      *pm = NULL;
+    pbuf      *pe = NULL;
+
+    if ((pr = pbuf_new()) == NULL ||
+	(pm = pbuf_new()) == NULL ||
+	(pe = pbuf_new()) == NULL)
+	goto done;
+    while ((ymod = yn_each(yspec, ymod)) != NULL){
+	if (yang_keyword_get(ymod) != Y_MODULE)
+	    continue;
+	pbuf_reset(pm);
+	if (pb_field_string(pm, 1, yang_argument_get(ymod)) < 0)
+	    goto done;
+	if ((ys = yang_find(ymod, Y_ORGANIZATION, NULL)) != NULL &&
+	    pb_field_string(pm, 2, yang_argument_get(ys)) < 0)
+	    goto done;
+	if ((ys = yang_find(ymod, Y_REVISION, NULL)) != NULL &&
+	    pb_field_string(pm, 3, yang_argument_get(ys)) < 0)
+	    goto done;
+	if (pb_field_msg(pr, 1, pm) < 0)
+	    goto done;
+    }
+    /* Packed repeated enum */
+    if (pb_varint(pe, GNMI_ENC_JSON) < 0 ||
+	pb_varint(pe, GNMI_ENC_PROTO) < 0 ||
+	pb_varint(pe, GNMI_ENC_JSON_IETF) < 0 ||
+	pb_field_msg(pr, 2, pe) < 0)
+	goto done;
+    if (pb_field_string(pr, 3, GNMI_VERSION) < 0)
+	goto done;
+    if (gnmi_stream_send(gs, pr) < 0)
+	goto done;
+    if (gnmi_stream_end(gs, GRPC_OK, NULL) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (pr)
+	pbuf_free(pr);
+    if (pm)
+	pbuf_free(pm);
+    if (pe)
+	pbuf_free(pe);
+    return retval;
+}
+
+/*! Get: one Notification per path
+ */
+static int
+gnmi_get(clicon_handle       h,
+	 struct gnmi_stream *gs,
+	 const uint8_t      *buf,
+	 size_t              len)
+{
+    int             retval = -1;
+    gnmi_path       prefix = {0,};
+    gnmi_path       gp = {0,};
+    netconf_content content = CONTENT_ALL;
+    int             encoding = GNMI_ENC_JSON;
+    pbuf           *pr = NULL;
+    pbuf           *pn = NULL;
+    cbuf           *reason = NULL;
+    size_t          off;
+    pb_field        pf;
+    int             code = GRPC_OK;
+    int             ret;
+
+    if ((pr = pbuf_new()) == NULL ||
+	(pn = pbuf_new()) == NULL)
+	goto done;
+    if ((reason = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    off = 0;
+    while ((ret = pb_next(buf, len, &off, &pf)) == 1)
+	switch (pf.pf_num){
+	case 1: /* prefix */
+	    if (pf.pf_wire == PB_LEN &&
+		(ret = gnmi_path_decode(pf.pf_data, pf.pf_len, &prefix)) < 1)
+		goto malformed;
+	    break;
+	case 3: /* type */
+	    switch (pf.pf_varint){
+	    case GNMI_TYPE_CONFIG:
+		content = CONTENT_CONFIG;
+		break;
+	    case GNMI_TYPE_STATE:
+	    case GNMI_TYPE_OPERATIONAL:
+		content = CONTENT_NONCONFIG;
+		break;
+	    default:
+		content = CONTENT_ALL;
+		break;
+	    }
+	    break;
+	case 5: /* encoding */
+	    encoding = pf.pf_varint;
+	    break;
+	}
+    if (ret < 0)
+	goto malformed;
+    if (!gnmi_encoding_ok(encoding)){
+	code = GRPC_UNIMPLEMENTED;
+	cprintf(reason, "Unsupported encoding %d", encoding);
+	goto fail;
+    }
+    off = 0;
+    while ((ret = pb_next(buf, len, &off, &pf)) == 1){
+	if (pf.pf_num != 2 || pf.pf_wire != PB_LEN)
+	    continue;
+	if ((ret = gnmi_request_path(&pf, &prefix, &gp)) < 1)
+	    goto malformed;
+	pbuf_reset(pn);
+	if ((ret = gnmi_path_notification(h, &gp, content, encoding, 1,
+					  pn, &code, reason)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	if (pb_field_msg(pr, 1, pn) < 0)
+	    goto done;
+	gnmi_path_reset(&gp);
+    }
+    if (ret < 0)
+	goto malformed;
+    if (gnmi_stream_send(gs, pr) < 0)
+	goto done;
+ fail:
+    if (gnmi_stream_end(gs, code, cbuf_len(reason)?cbuf_get(reason):NULL) < 0)
+	goto done;
+    retval = 0;
+ done:
+    gnmi_path_reset(&prefix);
+    gnmi_path_reset(&gp);
+    if (pr)
+	pbuf_free(pr);
+    if (pn)
+	pbuf_free(pn);
+    if (reason)
+	cbuf_free(reason);
+    return retval;
+ malformed:
+    if (ret < 0)
+	goto done;
+    code = GRPC_INVALID_ARGUMENT;
+    cprintf(reason, "Malformed GetRequest");
+    goto fail;
+}
+
+/*! Add netconf operation attribute to XML node of edit
+ */
+static int
+gnmi_operation_set(cxobj              *x,
+		   enum operation_type op)
+{
+    cxobj *xa;
+
+    if ((xa = xml_new("operation", x, CX_ATTR)) == NULL)
+	return -1;
+    if (xml_prefix_set(xa, NETCONF_BASE_PREFIX) < 0)
+	return -1;
+    return xml_value_set(xa, xml_operation2str(op));
+}
+
+/*! Set JSON value of an edit
+ *
+ * The value is parsed as member of the parent, and replaces the skeleton of the path.
+ * List keys in the path and not in the value are kept.
+ * @param[in]     yspec   Yang spec
+ * @param[in,out] xbot    Last element of path skeleton, replaced by value
+ * @param[in]     json    JSON value
+ * @param[out]    reason  Reason if invalid
+ * @retval        1       OK
+ * @retval        0       Invalid value, see reason
+ * @retval       -1       Error
+ */
+static int
+gnmi_edit_json(yang_stmt *yspec,
+	       cxobj    **xbot,
+	       char      *json,
+	       cbuf      *reason)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    cxobj     *xn;
+    cxobj     *xk;
+    cxobj     *xe;
+    cxobj     *xerr = NULL;
+    cbuf      *cb = NULL;
+    yang_stmt *y;
+    char      *msg;
+    int        ret;
+
+    xp = xml_parent(*xbot);
+    y = xml_spec(*xbot);
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "{\"%s:%s\":%s}", yang_argument_get(ys_module(y)), yang_argument_get(y), json);
+    if ((ret = clixon_json_parse_string(cbuf_get(cb), xml_spec(xp)?YB_PARENT:YB_MODULE,
+					yspec, &xp, &xerr)) < 0){
+	cprintf(reason, "%s", clicon_err_reason);
+	goto fail;
+    }
+    if (ret == 0){
+	if ((xe = xpath_first(xerr, NULL, "//error-message")) != NULL &&
+	    (msg = xml_body(xe)) != NULL)
+	    cprintf(reason, "%s", msg);
+	else
+	    cprintf(reason, "Invalid value of %s", yang_argument_get(y));
+	goto fail;
+    }
+    xn = xml_child_i_type(xp, xml_child_nr_type(xp, CX_ELMNT)-1, CX_ELMNT);
+    if (xn == NULL || xn == *xbot){
+	cprintf(reason, "Invalid value of %s", yang_argument_get(y));
+	goto fail;
+    }
+    xk = NULL;
+    while ((xk = xml_child_each(*xbot, xk, CX_ELMNT)) != NULL)
+	if (xml_find_type(xn, NULL, xml_name(xk), CX_ELMNT) == NULL &&
+	    xml_addsub(xn, xml_dup(xk)) < 0)
+	    goto done;
+    if (xml_purge(*xbot) < 0)
+	goto done;
+    *xbot = xn;
+    retval = 1;
+ done:
+    if (xerr)
+	xml_free(xerr);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Set scalar value(s) of an edit of a leaf or leaf-list
+ * @retval  1   OK
+ * @retval  0   Invalid value, see reason
+ * @retval -1   Error
+ */
+static int
+gnmi_edit_scalar(cxobj              *xbot,
+		 gnmi_value         *gv,
+		 enum operation_type op,
+		 cbuf               *reason)
+{
+    yang_stmt *y = xml_spec(xbot);
+    cxobj     *x;
+    char      *ns = NULL;
+    int        i;
+
+    if (y == NULL ||
+	(yang_keyword_get(y) != Y_LEAF && yang_keyword_get(y) != Y_LEAF_LIST) ||
+	(yang_keyword_get(y) == Y_LEAF && gv->gv_len != 1)){
+	cprintf(reason, "Scalar value of %s", xml_name(xbot));
+	return 0;
+    }
+    xml2ns(xbot, NULL, &ns);
+    for (i=0; i<gv->gv_len; i++){
+	if (i == 0)
+	    x = xbot;
+	else {
+	    if ((x = xml_new(xml_name(xbot), xml_parent(xbot), CX_ELMNT)) == NULL)
+		return -1;
+	    xml_spec_set(x, y);
+	    if (ns && xml_find_type(xbot, NULL, "xmlns", CX_ATTR) &&
+		xmlns_set(x, NULL, ns) < 0)
+		return -1;
+	    if (gnmi_operation_set(x, op) < 0)
+		return -1;
+	}
+	if (xml_new_body("body", x, gv->gv_vec[i]) == NULL)
+	    return -1;
+    }
+    return 1;
+}
+
+/*! Edit candidate with delete, replace or update of one path of Set
+ * @param[in]  h       Clicon handle
+ * @param[in]  gp      gNMI path
+ * @param[in]  op      OP_REMOVE, OP_REPLACE or OP_MERGE
+ * @param[in]  pv      Encoded TypedValue, or NULL if delete
+ * @param[out] reason  Reason if failed
+ * @retval     1       OK
+ * @retval     0       Failed, see reason
+ * @retval    -1       Error
+ */
+static int
+gnmi_set_edit(clicon_handle       h,
+	      gnmi_path          *gp,
+	      enum operation_type op,
+	      pb_field           *pv,
+	      cbuf               *reason)
+{
+    int                 retval = -1;
+    yang_stmt          *yspec = clicon_dbspec_yang(h);
+    cxobj              *xtop = NULL;
+    cxobj              *xbot;
+    cxobj              *xc;
+    cbuf               *cb = NULL;
+    gnmi_value          gv = {0,};
+    enum operation_type dop = OP_NONE;
+    int                 ret;
+
+    if ((xtop = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if ((ret = gnmi_path2xml(yspec, gp, xtop, &xbot, reason)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if (pv){
+	if ((ret = gnmi_value_decode(pv->pf_data, pv->pf_len, &gv)) < 0)
+	    goto done;
+	if (ret == 0){
+	    cprintf(reason, "Unsupported value");
+	    goto fail;
+	}
+    }
+    if (xbot == xtop){ /* Root */
+	if (op == OP_REMOVE || op == OP_REPLACE)
+	    dop = OP_REPLACE;
+	else
+	    dop = OP_MERGE;
+	if (pv){
+	    if (!gv.gv_json){
+		cprintf(reason, "Scalar value of root");
+		goto fail;
+	    }
+	    if ((ret = clixon_json_parse_string(gv.gv_vec[0], YB_MODULE, yspec, &xtop, NULL)) < 0){
+		cprintf(reason, "%s", clicon_err_reason);
+		goto fail;
+	    }
+	    if (ret == 0){
+		cprintf(reason, "Invalid value of root");
+		goto fail;
+	    }
+	}
+    }
+    else if (op == OP_REMOVE){
+	if (gnmi_operation_set(xbot, op) < 0)
+	    goto done;
+    }
+    else{
+	if (gv.gv_json){
+	    if ((ret = gnmi_edit_json(yspec, &xbot, gv.gv_vec[0], reason)) < 0)
+		goto done;
+	}
+	else if ((ret = gnmi_edit_scalar(xbot, &gv, op, reason)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	if (gnmi_operation_set(xbot, op) < 0)
+	    goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<%s>", NETCONF_INPUT_CONFIG);
+    xc = NULL;
+    while ((xc = xml_child_each(xtop, xc, CX_ELMNT)) != NULL)
+	if (clicon_xml2cbuf(cb, xc, 0, 0, -1) < 0)
+	    goto done;
+    cprintf(cb, "</%s>", NETCONF_INPUT_CONFIG);
+    if (clicon_rpc_edit_config(h, "candidate", dop, cbuf_get(cb)) < 0){
+	cprintf(reason, "%s", clicon_err_reason);
+	goto fail;
+    }
+    retval = 1;
+ done:
+    gnmi_value_reset(&gv);
+    if (xtop)
+	xml_free(xtop);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Set: deletes, replaces and updates in that order, then commit
+ *
+ * All edits of a Set are made in candidate and committed together. If any fails,
+ * candidate is reset and running is not changed
+ */
+static int
+gnmi_set(clicon_handle       h,
+	 struct gnmi_stream *gs,
+	 const uint8_t      *buf,
+	 size_t              len)
+{
+    int                 retval = -1;
+    gnmi_path           prefix = {0,};
+    gnmi_path           gp = {0,};
+    pbuf               *pr = NULL;
+    pbuf               *pu = NULL;
+    cbuf               *reason = NULL;
+    size_t              off;
+    size_t              off1;
+    pb_field            pf;
+    pb_field            pf1;
+    pb_field           *pv;
+    pb_field            path;
+    pb_field            val;
+    uint32_t            num;
+    int                 locked = 0;
+    int                 code = GRPC_OK;
+    int                 gop;
+    enum operation_type op;
+    int                 ret;
+
+    if ((pr = pbuf_new()) == NULL ||
+	(pu = pbuf_new()) == NULL)
+	goto done;
+    if ((reason = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    off = 0;
+    while ((ret = pb_next(buf, len, &off, &pf)) == 1)
+	if (pf.pf_num == 1 && pf.pf_wire == PB_LEN &&
+	    (ret = gnmi_path_decode(pf.pf_data, pf.pf_len, &prefix)) < 1)
+	    goto malformed;
+    if (ret < 0)
+	goto malformed;
+    if (clicon_rpc_lock(h, "candidate") < 0){
+	code = GRPC_ABORTED;
+	cprintf(reason, "%s", clicon_err_reason);
+	goto fail;
+    }
+    locked++;
+    for (num = 2; num <= 4; num++){ /* delete, replace, update */
+	switch (num){
+	case 2:
+	    op = OP_REMOVE;
+	    gop = GNMI_OP_DELETE;
+	    break;
+	case 3:
+	    op = OP_REPLACE;
+	    gop = GNMI_OP_REPLACE;
+	    break;
+	default:
+	    op = OP_MERGE;
+	    gop = GNMI_OP_UPDATE;
+	    break;
+	}
+	off = 0;
+	while ((ret = pb_next(buf, len, &off, &pf)) == 1){
+	    if (pf.pf_num != num || pf.pf_wire != PB_LEN)
+		continue;
+	    pv = NULL;
+	    if (num == 2)
+		path = pf;
+	    else { /* Update: path and val */
+		memset(&path, 0, sizeof(path));
+		off1 = 0;
+		while ((ret = pb_next(pf.pf_data, pf.pf_len, &off1, &pf1)) == 1)
+		    if (pf1.pf_num == 1 && pf1.pf_wire == PB_LEN)
+			path = pf1;
+		    else if (pf1.pf_num == 3 && pf1.pf_wire == PB_LEN){
+			val = pf1;
+			pv = &val;
+		    }
+		if (ret < 0)
+		    goto malformed;
+		if (pv == NULL){
+		    code = GRPC_INVALID_ARGUMENT;
+		    cprintf(reason, "Update without value");
+		    goto fail;
+		}
+	    }
+	    if ((ret = gnmi_request_path(&path, &prefix, &gp)) < 1)
+		goto malformed;
+	    if ((ret = gnmi_set_edit(h, &gp, op, pv, reason)) < 0)
+		goto done;
+	    if (ret == 0){
+		code = GRPC_INVALID_ARGUMENT;
+		goto fail;
+	    }
+	    /* UpdateResult */
+	    pbuf_reset(pu);
+	    if (gnmi_path_encode(pu, 2, &gp) < 0 ||
+		pb_field_varint(pu, 4, gop) < 0 ||
+		pb_field_msg(pr, 2, pu) < 0)
+		goto done;
+	    gnmi_path_reset(&gp);
+	}
+	if (ret < 0)
+	    goto malformed;
+    }
+    if (clicon_rpc_commit(h) < 0){
+	code = GRPC_ABORTED;
+	cprintf(reason, "%s", clicon_err_reason);
+	goto fail;
+    }
+    if (pb_field_varint(pr, 4, gnmi_timestamp()) < 0)
+	goto done;
+    if (gnmi_stream_send(gs, pr) < 0)
+	goto done;
+ fail:
+    if (code != GRPC_OK && locked)
+	clicon_rpc_discard_changes(h);
+    if (locked)
+	clicon_rpc_unlock(h, "candidate");
+    if (gnmi_stream_end(gs, code, cbuf_len(reason)?cbuf_get(reason):NULL) < 0)
+	goto done;
+    retval = 0;
+ done:
+    gnmi_path_reset(&prefix);
+    gnmi_path_reset(&gp);
+    if (pr)
+	pbuf_free(pr);
+    if (pu)
+	pbuf_free(pu);
+    if (reason)
+	cbuf_free(reason);
+    return retval;
+ malformed:
+    if (ret < 0)
+	goto done;
+    code = GRPC_INVALID_ARGUMENT;
+    cprintf(reason, "Malformed SetRequest");
+    goto fail;
+}
+
+/*! Send SubscribeResponse with sync_response
+ */
+static int
+gnmi_sync_send(struct gnmi_stream *gs)
+{
+    int   retval = -1;
+    pbuf *pr = NULL;
+
+    if ((pr = pbuf_new()) == NULL)
+	goto done;
+    if (pb_field_varint(pr, 3, 1) < 0)
+	goto done;
+    if (gnmi_stream_send(gs, pr) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (pr)
+	pbuf_free(pr);
+    return retval;
+}
+
+/*! Send SubscribeResponse with Notification
+ */
+static int
+gnmi_notification_send(struct gnmi_stream *gs,
+		       pbuf               *pn)
+{
+    int   retval = -1;
+    pbuf *pr = NULL;
+
+    if ((pr = pbuf_new()) == NULL)
+	goto done;
+    if (pb_field_msg(pr, 1, pn) < 0)
+	goto done;
+    if (gnmi_stream_send(gs, pr) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (pr)
+	pbuf_free(pr);
+    return retval;
+}
+
+/*! Call function for each Subscription of SubscriptionList
+ * @param[in]  h    Clicon handle
+ * @param[in]  gs   Stream of Subscribe
+ * @param[in]  fn   Function called with path, mode and sample interval of subscription
+ * @retval     1    OK
+ * @retval     0    Failed, stream ended
+ * @retval    -1    Error
+ */
+static int
+gnmi_subscriptions_each(clicon_handle       h,
+			struct gnmi_stream *gs,
+			int (*fn)(clicon_handle, struct gnmi_stream *, gnmi_path *,
+				  int, uint64_t, int *, cbuf *))
+{
+    int               retval = -1;
+    struct gnmi_call *cl = gs->gs_arg;
+    pbuf             *sl = cl->cl_sublist;
+    gnmi_path         prefix = {0,};
+    gnmi_path         gp = {0,};
+    cbuf             *reason = NULL;
+    size_t            off;
+    size_t            off1;
+    pb_field          pf;
+    pb_field          pf1;
+    pb_field          path;
+    int               mode;
+    uint64_t          interval;
+    int               code = GRPC_OK;
+    int               ret;
+
+    if ((reason = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    off = 0;
+    while ((ret = pb_next(sl->pb_buf, sl->pb_len, &off, &pf)) == 1)
+	if (pf.pf_num == 1 && pf.pf_wire == PB_LEN &&
+	    (ret = gnmi_path_decode(pf.pf_data, pf.pf_len, &prefix)) < 1)
+	    goto malformed;
+    if (ret < 0)
+	goto malformed;
+    off = 0;
+    while ((ret = pb_next(sl->pb_buf, sl->pb_len, &off, &pf)) == 1){
+	if (pf.pf_num != 2 || pf.pf_wire != PB_LEN)
+	    continue;
+	memset(&path, 0, sizeof(path));
+	mode = GNMI_SUB_TARGET_DEFINED;
+	interval = 0;
+	off1 = 0;
+	while ((ret = pb_next(pf.pf_data, pf.pf_len, &off1, &pf1)) == 1)
+	    switch (pf1.pf_num){
+	    case 1:
+		if (pf1.pf_wire == PB_LEN)
+		    path = pf1;
+		break;
+	    case 2:
+		mode = pf1.pf_varint;
+		break;
+	    case 3:
+		interval = pf1.pf_varint;
+		break;
+	    }
+	if (ret < 0)
+	    goto malformed;
+	if ((ret = gnmi_request_path(&path, &prefix, &gp)) < 1)
+	    goto malformed;
+	if ((ret = fn(h, gs, &gp, mode, interval, &code, reason)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	gnmi_path_reset(&gp);
+    }
+    if (ret < 0)
+	goto malformed;
+    retval = 1;
+ done:
+    gnmi_path_reset(&prefix);
+    gnmi_path_reset(&gp);
+    if (reason)
+	cbuf_free(reason);
+    return retval;
+ malformed:
+    if (ret < 0)
+	goto done;
+    code = GRPC_INVALID_ARGUMENT;
+    cprintf(reason, "Malformed SubscriptionList");
+ fail:
+    if (gnmi_stream_end(gs, code, cbuf_get(reason)) < 0)
+	goto done;
+    retval = 0;
+    goto done;
+}
+
+/*! Send current data of a subscription, see gnmi_subscriptions_each
+ */
+static int
+gnmi_subscription_update(clicon_handle       h,
+			 struct gnmi_stream *gs,
+			 gnmi_path          *gp,
+			 int                 mode,
+			 uint64_t            interval,
+			 int                *code,
+			 cbuf               *reason)
+{
+    int               retval = -1;
+    struct gnmi_call *cl = gs->gs_arg;
+    pbuf             *pn = NULL;
+    int               ret;
+
+    if ((pn = pbuf_new()) == NULL)
+	goto done;
+    if ((ret = gnmi_path_notification(h, gp, CONTENT_ALL, cl->cl_encoding, 0,
+				      pn, code, reason)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if (gnmi_notification_send(gs, pn) < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (pn)
+	pbuf_free(pn);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Establish backend push subscription of a STREAM subscription, see gnmi_subscriptions_each
+ *
+ * Each subscription has its own backend session, the push notifications are read
+ * from its socket by gnmi_push_cb
+ */
+static int
+gnmi_subscription_push(clicon_handle       h,
+		       struct gnmi_stream *gs,
+		       gnmi_path          *gp,
+		       int                 mode,
+		       uint64_t            interval,
+		       int                *code,
+		       cbuf               *reason)
+{
+    int               retval = -1;
+    struct gnmi_call *cl = gs->gs_arg;
+    struct gnmi_sub  *su = NULL;
+    yang_stmt        *yspec = clicon_dbspec_yang(h);
+    cbuf             *xpath = NULL;
+    cbuf             *api_path = NULL;
+    cbuf             *cb = NULL;
+    cxobj            *xret = NULL;
+    cxobj            *xerr;
+    cg_var           *cv;
+    char             *username;
+    uint64_t          period;
+    int               s = -1;
+    int               ret;
+
+    if ((xpath = cbuf_new()) == NULL ||
+	(api_path = cbuf_new()) == NULL ||
+	(cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((su = malloc(sizeof(*su))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(su, 0, sizeof(*su));
+    su->su_gs = gs;
+    su->su_s = -1;
+    ADDQ(su, cl->cl_subs);
+    if ((su->su_nsc = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if ((ret = gnmi_path2xpath(yspec, gp, xpath, su->su_nsc, api_path, reason)) < 0)
+	goto done;
+    if (ret == 0){
+	*code = GRPC_INVALID_ARGUMENT;
+	goto fail;
+    }
+    if ((su->su_xpath = strdup(cbuf_get(xpath))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    username = clicon_username_get(h);
+    cprintf(cb, "<rpc xmlns=\"%s\" username=\"%s\"><establish-push xmlns=\"%s\">",
+	    NETCONF_BASE_NAMESPACE, username?username:"", CLIXON_LIB_NS);
+    cprintf(cb, "<xpath-filter");
+    cv = NULL;
+    while ((cv = cvec_each(su->su_nsc, cv)) != NULL)
+	cprintf(cb, " xmlns:%s=\"%s\"", cv_name_get(cv), cv_string_get(cv));
+    cprintf(cb, ">");
+    if (xml_chardata_cbuf_append(cb, su->su_xpath) < 0)
+	goto done;
+    cprintf(cb, "</xpath-filter>");
+    if (mode == GNMI_SUB_SAMPLE){
+	/* sample_interval in ns, period in cs */
+	if (interval == 0)
+	    period = GNMI_SAMPLE_DEFAULT;
+	else if ((period = interval/10000000) == 0)
+	    period = 1;
+	if (period > UINT32_MAX)
+	    period = UINT32_MAX;
+	cprintf(cb, "<period>%u</period>", (uint32_t)period);
+    }
+    else
+	cprintf(cb, "<on-change/>");
+    cprintf(cb, "</establish-push></rpc>");
+    if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, &s) < 0){
+	*code = GRPC_UNAVAILABLE;
+	cprintf(reason, "%s", clicon_err_reason);
+	goto fail;
+    }
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	gnmi_rpc_error(xerr, code, reason);
+	goto fail;
+    }
+    if (clixon_event_reg_fd(s, gnmi_push_cb, su, "gnmi push subscription") < 0)
+	goto done;
+    su->su_s = s;
+    s = -1;
+    retval = 1;
+ done:
+    if (s != -1)
+	close(s);
+    if (xret)
+	xml_free(xret);
+    if (xpath)
+	cbuf_free(xpath);
+    if (api_path)
+	cbuf_free(api_path);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Encode deletes of push-change-update deleted data to Notification
+ *
+ * Deleted data is sent with ancestors and list keys, the deleted nodes are the
+ * nodes without other children
+ * @param[in,out] pn  Notification
+ * @param[in]     x   Deleted data
+ */
+static int
+gnmi_deleted_encode(pbuf  *pn,
+		    cxobj *x)
+{
+    yang_stmt *y = xml_spec(x);
+    cxobj     *xc = NULL;
+    int        leaf = 1;
+
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+	if (y && yang_keyword_get(y) == Y_LIST && yang_key_match(y, xml_name(xc)))
+	    continue;
+	leaf = 0;
+	if (gnmi_deleted_encode(pn, xc) < 0)
+	    return -1;
+    }
+    if (leaf && y)
+	return gnmi_xml2path(pn, 5, x);
+    return 0;
+}
+
+/*! Detach and bind anydata data of push notification
+ * @param[in]  xp     Parent, eg push-update
+ * @param[in]  name   Name of anydata, eg datastore-contents
+ * @param[in]  yspec  Yang spec
+ * @retval     x      Data, free with xml_free
+ * @retval     NULL   Not found or invalid
+ */
+static cxobj *
+gnmi_push_data(cxobj     *xp,
+	       char      *name,
+	       yang_stmt *yspec)
+{
+    cxobj *x;
+    cxobj *xerr = NULL;
+    int    ret;
+
+    if ((x = xml_find_type(xp, NULL, name, CX_ELMNT)) == NULL)
+	return NULL;
+    if (xml_rm(x) < 0)
+	return NULL;
+    if ((ret = xml_bind_yang(x, YB_MODULE, yspec, &xerr)) < 1){
+	clicon_log(LOG_WARNING, "%s: invalid %s of push notification", __FUNCTION__, name);
+	xml_free(x);
+	x = NULL;
+    }
+    if (xerr)
+	xml_free(xerr);
+    return x;
+}
+
+/*! Push notification from backend, send it as SubscribeResponse
+ *
+ * push-update: the data selected by the subscription path.
+ * push-change-update: leaves of created and updated data, and paths of deleted data.
+ */
+static int
+gnmi_push_cb(int   s,
+	     void *arg)
+{
+    int                 retval = -1;
+    struct gnmi_sub    *su = arg;
+    struct gnmi_stream *gs = su->su_gs;
+    struct gnmi_conn   *gc = gs->gs_gc;
+    struct gnmi_call   *cl = gs->gs_arg;
+    clicon_handle       h = gc->gc_h;
+    yang_stmt          *yspec = clicon_dbspec_yang(h);
+    struct clicon_msg  *reply = NULL;
+    cxobj              *xt = NULL;
+    cxobj              *xerr = NULL;
+    cxobj              *xn;
+    cxobj              *xp;
+    cxobj              *xd = NULL;
+    cxobj              *xc;
+    cxobj             **vec = NULL;
+    size_t              veclen;
+    pbuf               *pn = NULL;
+    char               *names[] = {"created", "updated", "deleted"};
+    int                 eof;
+    int                 ret;
+    int                 i;
+
+    if (clicon_msg_rcv(s, &reply, &eof) < 0)
+	goto done;
+    if (eof){
+	clixon_event_unreg_fd(s, gnmi_push_cb);
+	close(s);
+	su->su_s = -1;
+	if (gnmi_stream_end(gs, GRPC_UNAVAILABLE, "Backend closed subscription") < 0)
+	    goto done;
+	goto flush;
+    }
+    if ((ret = clicon_msg_decode(reply, yspec, NULL, &xt, &xerr)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_log(LOG_WARNING, "%s: invalid notification", __FUNCTION__);
+	goto ok;
+    }
+    if ((xn = xml_find_type(xt, NULL, "notification", CX_ELMNT)) == NULL)
+	goto ok;
+    if ((pn = pbuf_new()) == NULL)
+	goto done;
+    if (pb_field_varint(pn, 1, gnmi_timestamp()) < 0)
+	goto done;
+    if ((xp = xml_find_type(xn, NULL, "push-update", CX_ELMNT)) != NULL){
+	if ((xd = gnmi_push_data(xp, "datastore-contents", yspec)) == NULL)
+	    goto ok;
+	if (xpath_vec(xd, su->su_nsc, "%s", &vec, &veclen, su->su_xpath) < 0)
+	    goto done;
+	for (i=0; i<veclen; i++)
+	    if (gnmi_node_update(pn, vec[i], cl->cl_encoding) < 0)
+		goto done;
+    }
+    else if ((xp = xml_find_type(xn, NULL, "push-change-update", CX_ELMNT)) != NULL){
+	if ((xp = xml_find_type(xp, NULL, "datastore-changes", CX_ELMNT)) == NULL)
+	    goto ok;
+	for (i=0; i<3; i++){
+	    if ((xd = gnmi_push_data(xp, names[i], yspec)) == NULL)
+		continue;
+	    xc = NULL;
+	    while ((xc = xml_child_each(xd, xc, CX_ELMNT)) != NULL)
+		if ((i < 2 ?
+		     gnmi_leaves_update(pn, xc, cl->cl_encoding) :
+		     gnmi_deleted_encode(pn, xc)) < 0)
+		    goto done;
+	    xml_free(xd);
+	    xd = NULL;
+	}
+    }
+    else
+	goto ok;
+    if (gnmi_notification_send(gs, pn) < 0)
+	goto done;
+ flush:
+    /* May free stream and this subscription */
+    if (gnmi_conn_flush(gc) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (reply)
+	free(reply);
+    if (xt)
+	xml_free(xt);
+    if (xerr)
+	xml_free(xerr);
+    if (xd)
+	xml_free(xd);
+    if (vec)
+	free(vec);
+    if (pn)
+	pbuf_free(pn);
+    return retval;
+}
+
+/*! Subscribe: first request with SubscriptionList, and Poll requests of POLL mode
+ */
+static int
+gnmi_subscribe(clicon_handle       h,
+	       struct gnmi_stream *gs,
+	       const uint8_t      *buf,
+	       size_t              len)
+{
+    int               retval = -1;
+    struct gnmi_call *cl = gs->gs_arg;
+    size_t            off;
+    pb_field          pf;
+    pb_field          pf1;
+    pb_field         *sl = NULL;
+    int               poll = 0;
+    int               ret;
+
+    off = 0;
+    while ((ret = pb_next(buf, len, &off, &pf)) == 1)
+	if (pf.pf_num == 1 && pf.pf_wire == PB_LEN){
+	    pf1 = pf;
+	    sl = &pf1;
+	}
+	else if (pf.pf_num == 3)
+	    poll++;
+    if (ret < 0){
+	if (gnmi_stream_end(gs, GRPC_INVALID_ARGUMENT, "Malformed SubscribeRequest") < 0)
+	    goto done;
+	goto ok;
+    }
+    if (cl->cl_sublist == NULL){ /* First request */
+	if (sl == NULL){
+	    if (gnmi_stream_end(gs, GRPC_INVALID_ARGUMENT, "Expected SubscriptionList") < 0)
+		goto done;
+	    goto ok;
+	}
+	if ((cl->cl_sublist = pbuf_new()) == NULL ||
+	    pbuf_append(cl->cl_sublist, sl->pf_data, sl->pf_len) < 0)
+	    goto done;
+	off = 0;
+	while ((ret = pb_next(sl->pf_data, sl->pf_len, &off, &pf)) == 1)
+	    switch (pf.pf_num){
+	    case 5:
+		cl->cl_mode = pf.pf_varint;
+		break;
+	    case 8:
+		cl->cl_encoding = pf.pf_varint;
+		break;
+	    case 9:
+		cl->cl_updates_only = pf.pf_varint != 0;
+		break;
+	    }
+	if (!gnmi_encoding_ok(cl->cl_encoding)){
+	    if (gnmi_stream_end(gs, GRPC_UNIMPLEMENTED, "Unsupported encoding") < 0)
+		goto done;
+	    goto ok;
+	}
+	if (cl->cl_mode != GNMI_LIST_STREAM &&
+	    cl->cl_mode != GNMI_LIST_ONCE &&
+	    cl->cl_mode != GNMI_LIST_POLL){
+	    if (gnmi_stream_end(gs, GRPC_INVALID_ARGUMENT, "Unknown subscription mode") < 0)
+		goto done;
+	    goto ok;
+	}
+	if (!cl->cl_updates_only){
+	    if ((ret = gnmi_subscriptions_each(h, gs, gnmi_subscription_update)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto ok;
+	}
+	if (gnmi_sync_send(gs) < 0)
+	    goto done;
+	switch (cl->cl_mode){
+	case GNMI_LIST_ONCE:
+	    if (gnmi_stream_end(gs, GRPC_OK, NULL) < 0)
+		goto done;
+	    break;
+	case GNMI_LIST_STREAM:
+	    if (gnmi_subscriptions_each(h, gs, gnmi_subscription_push) < 0)
+		goto done;
+	    break;
+	default:
+	    break;
+	}
+    }
+    else if (cl->cl_mode == GNMI_LIST_POLL && poll){
+	if ((ret = gnmi_subscriptions_each(h, gs, gnmi_subscription_update)) < 0)
+	    goto done;
+	if (ret == 1 && gnmi_sync_send(gs) < 0)
+	    goto done;
+    }
+    else if (gnmi_stream_end(gs, GRPC_INVALID_ARGUMENT, "Unexpected SubscribeRequest") < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! gRPC request message of a stream
+ *
+ * The method is given by the :path header of the stream
+ * @param[in]  h    Clicon handle
+ * @param[in]  gs   Stream
+ * @param[in]  buf  Encoded request message
+ * @param[in]  len  Length of buf
+ * @retval     0    OK, or call ended with error status
+ * @retval    -1    Error
+ */
+int
+gnmi_rpc_message(clicon_handle       h,
+		 struct gnmi_stream *gs,
+		 const uint8_t      *buf,
+		 size_t              len)
+{
+    struct gnmi_call *cl;
+    char             *path = gs->gs_path;
+
+    if ((cl = gs->gs_arg) == NULL){
+	if ((cl = malloc(sizeof(*cl))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    return -1;
+	}
+	memset(cl, 0, sizeof(*cl));
+	cl->cl_encoding = GNMI_ENC_JSON;
+	gs->gs_arg = cl;
+	if (path == NULL)
+	    return gnmi_stream_end(gs, GRPC_UNIMPLEMENTED, "No method");
+	if (strcmp(path, "/gnmi.gNMI/Capabilities") == 0)
+	    cl->cl_method = GNMI_CAPABILITIES;
+	else if (strcmp(path, "/gnmi.gNMI/Get") == 0)
+	    cl->cl_method = GNMI_GET;
+	else if (strcmp(path, "/gnmi.gNMI/Set") == 0)
+	    cl->cl_method = GNMI_SET;
+	else if (strcmp(path, "/gnmi.gNMI/Subscribe") == 0)
+	    cl->cl_method = GNMI_SUBSCRIBE;
+	else
+	    return gnmi_stream_end(gs, GRPC_UNIMPLEMENTED, path);
+	clicon_debug(1, "%s %s", __FUNCTION__, path);
+    }
+    switch (cl->cl_method){
+    case GNMI_CAPABILITIES:
+	return gnmi_capabilities(h, gs);
+    case GNMI_GET:
+	return gnmi_get(h, gs, buf, len);
+    case GNMI_SET:
+	return gnmi_set(h, gs, buf, len);
+    case GNMI_SUBSCRIBE:
+	return gnmi_subscribe(h, gs, buf, len);
+    }
+    return 0;
+}
+
+/*! Client has sent all request messages of stream
+ *
+ * Unary calls have ended unless the request is missing. A POLL subscription ends,
+ * a STREAM subscription continues until the stream is closed.
+ */
+int
+gnmi_rpc_end(clicon_handle       h,
+	     struct gnmi_stream *gs)
+{
+    struct gnmi_call *cl = gs->gs_arg;
+
+    if (cl == NULL){
+	/* Capabilities request may be empty, ie no message */
+	if (gs->gs_path && strcmp(gs->gs_path, "/gnmi.gNMI/Capabilities") == 0)
+	    return gnmi_rpc_message(h, gs, NULL, 0);
+	return gnmi_stream_end(gs, GRPC_INVALID_ARGUMENT, "Missing request");
+    }
+    if (cl->cl_method == GNMI_SUBSCRIBE && cl->cl_mode == GNMI_LIST_STREAM &&
+	cl->cl_sublist != NULL)
+	return 0;
+    return gnmi_stream_end(gs, GRPC_OK, NULL);
+}
+
+/*! Free state of gNMI call of stream, and close its backend push subscriptions
+ */
+int
+gnmi_rpc_free(clicon_handle       h,
+	      struct gnmi_stream *gs)
+{
+    struct gnmi_call *cl = gs->gs_arg;
+    struct gnmi_sub  *su;
+
+    if (cl == NULL)
+	return 0;
+    while ((su = cl->cl_subs) != NULL){
+	DELQ(su, cl->cl_subs, struct gnmi_sub *);
+	if (su->su_s != -1){
+	    clixon_event_unreg_fd(su->su_s, gnmi_push_cb);
+	    close(su->su_s);
+	}
+	if (su->su_xpath)
+	    free(su->su_xpath);
+	if (su->su_nsc)
+	    cvec_free(su->su_nsc);
+	free(su);
+    }
+    if (cl->cl_sublist)
+	pbuf_free(cl->cl_sublist);
+    free(cl);
+    gs->gs_arg = NULL;
+    return 0;
+}
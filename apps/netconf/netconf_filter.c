@@ -211,3 +211,133 @@ xml_filter(cxobj *xfilter,
     return retval;
 }
 
+/*! Add a namespace of a filter element to an xpath, ie its prefix
+ * @param[in]  x    Filter element
+ * @param[in]  nsc  Namespace context of xpath, namespace added with new prefix if not found
+ * @param[out] cb   Xpath, prefix added on the form <prefix>:
+ * @retval     1    OK
+ * @retval     0    No namespace of element, or the netconf namespace
+ * @retval    -1    Error
+ */
+static int
+xml_filter_xpath_ns(cxobj *x,
+		    cvec  *nsc,
+		    cbuf  *cb)
+{
+    char *ns = NULL;
+    char *prefix = NULL;
+    char  pstr[16];
+
+    if (xml2ns(x, xml_prefix(x), &ns) < 0)
+	return -1;
+    if (ns == NULL || strcmp(ns, NETCONF_BASE_NAMESPACE) == 0)
+	return 0;
+    if (xml_nsctx_get_prefix(nsc, ns, &prefix) == 0){
+	snprintf(pstr, sizeof(pstr), "n%d", cvec_len(nsc));
+	if (xml_nsctx_add(nsc, pstr, ns) < 0)
+	    return -1;
+	prefix = pstr;
+    }
+    cprintf(cb, "%s:", prefix);
+    return 1;
+}
+
+/*! Translate a subtree filter to an xpath selecting a superset of the filter
+ *
+ * The xpath follows the filter from its top element as long as there is a single
+ * containment or selection node and no content match. Content match nodes of the last
+ * element are translated to predicates. The whole subtree of the last element is
+ * selected, so xml_filter still needs to be applied on the result, but only on the part
+ * selected by the xpath.
+ * Example:
+ *   <filter type="subtree"><interfaces xmlns="urn:example:if"><interface>
+ *      <name>eth0</name><mtu/>
+ *   </interface></interfaces></filter>
+ * is translated to:
+ *   /n0:interfaces/n0:interface[n0:name='eth0']   with n0 = urn:example:if
+ * @param[in]  xfilter  Filter xml, ie <filter>
+ * @param[out] xpath    Xpath, free with free
+ * @param[out] nsc      Namespace context of xpath, free with xml_nsctx_free
+ * @retval     1        OK, xpath and nsc set
+ * @retval     0        Filter can not be translated, eg several top elements
+ * @retval    -1        Error
+ * @see xml_filter  Filtering of a tree
+ */
+int
+xml_filter_xpath(cxobj *xfilter,
+		 char **xpath,
+		 cvec **nsc)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cvec  *nsc1 = NULL;
+    cxobj *x;
+    cxobj *f;
+    cxobj *next;
+    cxobj *a;
+    char  *fstr;
+    int    nr;
+    int    ret;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((nsc1 = xml_nsctx_init(NULL, NULL)) == NULL)
+	goto done;
+    if (xml_child_nr_type(xfilter, CX_ELMNT) != 1)
+	goto fail;
+    x = xml_child_i_type(xfilter, 0, CX_ELMNT);
+    while (x != NULL){
+	/* Attribute match, other than namespace declarations */
+	a = NULL;
+	while ((a = xml_child_each(x, a, CX_ATTR)) != NULL)
+	    if (!(xml_prefix(a) == NULL && strcmp(xml_name(a), "xmlns") == 0) &&
+		!(xml_prefix(a) != NULL && strcmp(xml_prefix(a), "xmlns") == 0))
+		goto fail;
+	cprintf(cb, "/");
+	if ((ret = xml_filter_xpath_ns(x, nsc1, cb)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	cprintf(cb, "%s", xml_name(x));
+	/* Content match nodes end the path, as predicates */
+	nr = 0;
+	next = NULL;
+	f = NULL;
+	while ((f = xml_child_each(x, f, CX_ELMNT)) != NULL) {
+	    if ((fstr = leafstring(f)) == NULL){
+		next = f;
+		continue;
+	    }
+	    if (strchr(fstr, '\'') != NULL) /* Skip, xpath is still a superset */
+		continue;
+	    cprintf(cb, "[");
+	    if ((ret = xml_filter_xpath_ns(f, nsc1, cb)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	    cprintf(cb, "%s='%s']", xml_name(f), fstr);
+	    nr++;
+	}
+	if (nr || xml_child_nr_type(x, CX_ELMNT) != 1)
+	    break;
+	x = next;
+    }
+    if ((*xpath = strdup(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    *nsc = nsc1;
+    nsc1 = NULL;
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    if (nsc1)
+	xml_nsctx_free(nsc1);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
@@ -43,5 +43,6 @@
  * Prototypes
  */ 
 int xml_filter(cxobj *xf, cxobj *xn);
+int xml_filter_xpath(cxobj *xfilter, char **xpath, cvec **nsc);
 
 #endif  /* _NETCONF_FILTER_H_ */
@@ -71,6 +71,7 @@
  */
 enum transport_type    transport = NETCONF_SSH; /* XXX Remove SOAP support */
 int cc_closed = 0; /* XXX Please remove (or at least hide in handle) this global variable */
+enum framing_type netconf_framing = NETCONF_FRAME_EOM; /* Set to chunked after hello */
 
 /*! Add netconf xml postamble of message. I.e, xml after the body of the message.
  * @param[in]  cb  Netconf packet (cligen buffer)
@@ -217,6 +218,34 @@ netconf_output(int   s,
     return retval;
 }
 
+
+/*! Write all of a buffer on a socket
+ * @param[in]   s    Socket
+ * @param[in]   buf  Buffer
+ * @param[in]   len  Length of buffer
+ * @retval      0    OK
+ * @retval     -1    Error
+ */
+static int
+netconf_write(int     s,
+	      char   *buf,
+	      size_t  len)
+{
+    ssize_t n;
+
+    while (len > 0){
+	if ((n = write(s, buf, len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    if (errno != EPIPE)
+		clicon_log(LOG_ERR, "%s: write: %s", __FUNCTION__, strerror(errno));
+	    return -1;
+	}
+	buf += n;
+	len -= n;
+    }
+    return 0;
+}
 	    
 /*! Encapsulate and send outgoing netconf packet as cbuf on socket
  * @param[in]   s    
@@ -239,12 +268,76 @@ netconf_output_encap(int   s,
 	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
     }
-    add_preamble(cb1);
-    cprintf(cb1, "%s", cbuf_get(cb));
-    add_postamble(cb1);
+    if (transport == NETCONF_SSH && netconf_framing == NETCONF_FRAME_CHUNKED){
+	/* One chunk and end-of-chunks, RFC 6242 Sec 4.2 */
+	cprintf(cb1, "\n#%lu\n", (unsigned long)cbuf_len(cb));
+	if (cbuf_append_buf(cb1, cbuf_get(cb), cbuf_len(cb)) < 0){
+	    clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+	    goto done;
+	}
+	cprintf(cb1, "\n##\n");
+    }
+    else{
+	add_preamble(cb1);
+	cprintf(cb1, "%s", cbuf_get(cb));
+	add_postamble(cb1);
+    }
     retval = netconf_output(s, cb1, msg);
  done:
     if (cb1)
 	cbuf_free(cb1);
     return retval;
 }
+
+/*! Encapsulate and send outgoing netconf packet given as a start and a body string
+ *
+ * The parts are written one by one and not copied, eg for a large reply from the
+ * backend that is passed through without parsing
+ * @param[in]   s     Socket
+ * @param[in]   cb    Start of the message, eg a start tag
+ * @param[in]   body  Rest of the message
+ * @param[in]   msg   Only for debug
+ * @retval      0     OK
+ * @retval     -1     Error
+ * @note Assumes "cb" and "body" together are valid XML
+ * @see netconf_output_encap  message as one cbuf
+ */
+int 
+netconf_output_encap_str(int   s, 
+			 cbuf *cb, 
+			 char *body,
+			 char *msg)
+{
+    int   retval = -1;
+    cbuf *cbpre = NULL;
+    cbuf *cbpost = NULL;
+    size_t len;
+    
+    if ((cbpre = cbuf_new()) == NULL ||
+	(cbpost = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    len = strlen(body);
+    if (transport == NETCONF_SSH && netconf_framing == NETCONF_FRAME_CHUNKED){
+	cprintf(cbpre, "\n#%lu\n", (unsigned long)(cbuf_len(cb) + len));
+	cprintf(cbpost, "\n##\n");
+    }
+    else{
+	add_preamble(cbpre);
+	add_postamble(cbpost);
+    }
+    clicon_debug(1, "SEND %s", msg);
+    if (netconf_write(s, cbuf_get(cbpre), cbuf_len(cbpre)) < 0 ||
+	netconf_write(s, cbuf_get(cb), cbuf_len(cb)) < 0 ||
+	netconf_write(s, body, len) < 0 ||
+	netconf_write(s, cbuf_get(cbpost), cbuf_len(cbpost)) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cbpre)
+	cbuf_free(cbpre);
+    if (cbpost)
+	cbuf_free(cbpost);
+    return retval;
+}
@@ -51,6 +51,11 @@ enum transport_type{
     NETCONF_SOAP,  /* RFC 4743 */
 };
 
+enum framing_type{
+    NETCONF_FRAME_EOM,     /* End-of-message ]]>]]>, RFC 6242 Sec 4.3 */
+    NETCONF_FRAME_CHUNKED, /* Chunked framing, RFC 6242 Sec 4.2 */
+};
+
 enum test_option{ /* edit-config */
     SET,
     TEST_THEN_SET,
@@ -67,6 +72,7 @@ enum error_option{ /* edit-config */
  */ 
 extern enum transport_type transport;
 extern int cc_closed;
+extern enum framing_type netconf_framing;
 
 /*
  * Prototypes
@@ -78,5 +84,6 @@ char *netconf_get_target(cxobj *xn, char *path);
 int add_error_postamble(cbuf *xf);
 int netconf_output(int s, cbuf *xf, char *msg);
 int netconf_output_encap(int s, cbuf *cb, char *msg);
+int netconf_output_encap_str(int s, cbuf *cb, char *body, char *msg);
 
 #endif  /* _NETCONF_LIB_H_ */
@@ -87,6 +87,21 @@ static int ignore_packet_errors = 1;
 /* Hello request received */
 static int _netconf_hello_nr = 0;
 
+/* Max chunk-size, RFC 6242 Sec 4.2 */
+#define CHUNK_SIZE_MAX 4294967295UL
+
+/* Chunked framing input state, see netconf_input_chunk */
+enum chunk_state{
+    CHUNK_LF,    /* Expect LF of chunk header */
+    CHUNK_HASH,  /* Expect HASH */
+    CHUNK_SIZE0, /* Expect first digit of chunk-size or HASH of end-of-chunks */
+    CHUNK_SIZE,  /* Expect digits of chunk-size or LF */
+    CHUNK_DATA,  /* Chunk-data, _chunk_size bytes remaining */
+    CHUNK_END    /* Expect LF of end-of-chunks */
+};
+static enum chunk_state _chunk_state = CHUNK_LF;
+static unsigned long    _chunk_size = 0;
+
 /*! Copy attributes from incoming request to reply. Skip already present (dont overwrite)
  *
  * RFC 6241:
@@ -134,6 +149,7 @@ netconf_hello_msg(clicon_handle h,
     cxobj  *x;
     cxobj  *xcap;
     int     foundbase;
+    int     found11;
     char   *body;
 
     _netconf_hello_nr++;
@@ -146,6 +162,7 @@ netconf_hello_msg(clicon_handle h,
 	goto done;
     /* Each peer MUST send at least the base NETCONF capability, "urn:ietf:params:netconf:base:1.1"*/
     foundbase=0;
+    found11=0;
     if ((xcap = xml_find_type(xn, NULL, "capabilities", CX_ELMNT)) != NULL) {
 	x = NULL;
 	while ((x = xml_child_each(xcap, x, CX_ELMNT)) != NULL) {
@@ -157,8 +174,10 @@ netconf_hello_msg(clicon_handle h,
 	     * event any parameters are encoded at the end of the URI string. */
 	    if (strncmp(body, NETCONF_BASE_CAPABILITY_1_0, strlen(NETCONF_BASE_CAPABILITY_1_0)) == 0) /* RFC 4741 */
 		foundbase++;
-	    else if (strncmp(body, NETCONF_BASE_CAPABILITY_1_1, strlen(NETCONF_BASE_CAPABILITY_1_1)) == 0) /* RFC 6241 */
+	    else if (strncmp(body, NETCONF_BASE_CAPABILITY_1_1, strlen(NETCONF_BASE_CAPABILITY_1_1)) == 0){ /* RFC 6241 */
 		foundbase++;
+		found11++;
+	    }
 	}
     }
     if (foundbase == 0){
@@ -167,6 +186,9 @@ netconf_hello_msg(clicon_handle h,
 	cc_closed++;
 	goto done;
     }
+    /* Both peers have base:1.1, use chunked framing after hello, RFC 6242 Sec 4.1 */
+    if (found11 && clicon_option_bool(h, "CLICON_NETCONF_CHUNKED"))
+	netconf_framing = NETCONF_FRAME_CHUNKED;
     retval = 0;
  done:
     if (vec)
@@ -174,6 +196,55 @@ netconf_hello_msg(clicon_handle h,
     return retval;
 }
 
+/*! Send a reply from the backend as string without parsing it
+ *
+ * Attributes of the request are added to the start tag of the reply, see
+ * netconf_add_request_attr. This requires the reply to start with the rpc-reply start
+ * tag of the backend, otherwise it is not sent.
+ * @param[in]   xrpc  Incoming message on the form <rpc>...
+ * @param[in]   xraw  Reply from the backend on the form <rpc-reply xmlns="...">...
+ * @retval      1     OK, reply sent
+ * @retval      0     Reply is not on the expected form, not sent
+ * @retval     -1    Error
+ */
+static int
+netconf_output_raw(cxobj *xrpc,
+		   char  *xraw)
+{
+    int    retval = -1;
+    cbuf  *cb = NULL;
+    cxobj *xa;
+    size_t len;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<rpc-reply xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    len = cbuf_len(cb);
+    if (strncmp(xraw, cbuf_get(cb), len) != 0 || xraw[len] != '>'){
+	retval = 0;
+	goto done;
+    }
+    xa = NULL;
+    while ((xa = xml_child_each(xrpc, xa, CX_ATTR)) != NULL){
+	/* Default namespace already present (dont overwrite) */
+	if (xml_prefix(xa) == NULL && strcmp(xml_name(xa), "xmlns") == 0)
+	    continue;
+	if (xml_prefix(xa))
+	    cprintf(cb, " %s:%s=\"%s\"", xml_prefix(xa), xml_name(xa), xml_value(xa));
+	else
+	    cprintf(cb, " %s=\"%s\"", xml_name(xa), xml_value(xa));
+    }
+    if (netconf_output_encap_str(1, cb, xraw + len, "rpc-reply") < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Process incoming Netconf RPC netconf message 
  * @param[in]   h     Clicon handle
  * @param[in]   xreq  XML tree containing netconf RPC message
@@ -191,6 +262,7 @@ netconf_rpc_message(clicon_handle h,
     int    ret;
     cbuf  *cbret = NULL;
     cxobj *xc;
+    char  *xraw = NULL; /* Return (out) as string from backend */
 
     if (_netconf_hello_nr == 0 &&
 	clicon_option_bool(h, "CLICON_NETCONF_HELLO_OPTIONAL") == 0){
@@ -225,9 +297,18 @@ netconf_rpc_message(clicon_handle h,
 	    goto done;
 	goto ok;
     }
-    if (netconf_rpc_dispatch(h, xrpc, &xret) < 0){
+    if (netconf_rpc_dispatch(h, xrpc, &xret, &xraw) < 0){
 	goto done;
     }
+    /* Reply from backend not transformed, send it without parsing */
+    if (xraw != NULL){
+	if ((ret = netconf_output_raw(xrpc, xraw)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+	if (clixon_xml_parse_string(xraw, YB_NONE, NULL, &xret, NULL) < 0)
+	    goto done;
+    }
     /* Is there a return message in xret? */
     if (xret == NULL){
 	if (netconf_operation_failed_xml(&xret, "rpc", "Internal error: no xml return")< 0)
@@ -262,6 +343,8 @@ netconf_rpc_message(clicon_handle h,
 	cbuf_free(cbret);
     if (xret)
 	xml_free(xret);
+    if (xraw)
+	free(xraw);
     return retval;
 }
 
@@ -447,6 +530,94 @@ netconf_input_frame(clicon_handle h,
     return retval;
 }
 
+/*! Decode input with chunked framing, RFC 6242 Sec 4.2
+ *
+ * Chunk data is copied in blocks to the buffer, only the chunk headers are scanned.
+ *   Chunked-Message = 1*chunk end-of-chunks
+ *   chunk           = LF HASH chunk-size LF chunk-data
+ *   end-of-chunks   = LF HASH HASH LF
+ * The decoder state is kept between calls since a message may be split between reads.
+ * @param[in]  cb    Buffer where chunk data is appended
+ * @param[in]  buf   New input
+ * @param[in]  len   Length of new input
+ * @param[out] used  Number of bytes of input consumed
+ * @retval     1     End of chunks, complete message in cb. Input after used is not consumed
+ * @retval     0     No complete message, all input consumed
+ * @retval    -1     Error, malformed framing
+ */
+static int
+netconf_input_chunk(cbuf   *cb,
+		    char   *buf,
+		    size_t  len,
+		    size_t *used)
+{
+    char    *p = buf;
+    char    *end = buf + len;
+    size_t   n;
+    char     ch;
+
+    while (p < end){
+	if (_chunk_state == CHUNK_DATA){
+	    n = end - p;
+	    if (n > _chunk_size)
+		n = _chunk_size;
+	    if (cbuf_append_buf(cb, p, n) < 0){
+		clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+		return -1;
+	    }
+	    p += n;
+	    if ((_chunk_size -= n) == 0)
+		_chunk_state = CHUNK_LF;
+	    continue;
+	}
+	ch = *p++;
+	switch (_chunk_state){
+	case CHUNK_LF:
+	    if (ch != '\n')
+		goto malformed;
+	    _chunk_state = CHUNK_HASH;
+	    break;
+	case CHUNK_HASH:
+	    if (ch != '#')
+		goto malformed;
+	    _chunk_state = CHUNK_SIZE0;
+	    break;
+	case CHUNK_SIZE0: /* First digit of size, or end-of-chunks */
+	    if (ch == '#')
+		_chunk_state = CHUNK_END;
+	    else if (ch >= '1' && ch <= '9'){
+		_chunk_size = ch - '0';
+		_chunk_state = CHUNK_SIZE;
+	    }
+	    else
+		goto malformed;
+	    break;
+	case CHUNK_SIZE:
+	    if (ch == '\n')
+		_chunk_state = CHUNK_DATA;
+	    else if (ch >= '0' && ch <= '9' &&
+		     _chunk_size <= (CHUNK_SIZE_MAX - (ch - '0')) / 10)
+		_chunk_size = _chunk_size*10 + (ch - '0');
+	    else
+		goto malformed;
+	    break;
+	case CHUNK_DATA: /* see above */
+	    break;
+	case CHUNK_END:
+	    if (ch != '\n')
+		goto malformed;
+	    _chunk_state = CHUNK_LF;
+	    *used = p - buf;
+	    return 1;
+	}
+    }
+    *used = len;
+    return 0;
+ malformed:
+    clicon_err(OE_PROTO, 0, "Malformed chunked framing (see RFC 6242 Sec 4.2)");
+    return -1;
+}
+
 /*! Get netconf message: detect end-of-msg 
  * @param[in]   s    Socket where input arrived. read from this.
  * @param[in]   arg  Clicon handle.
@@ -464,11 +635,12 @@ netconf_input_cb(int   s,
 {
     int           retval = -1;
     clicon_handle h = arg;
-    unsigned char buf[BUFSIZ]; /* from stdio.h, typically 8K */
-    int           i;
+    char          buf[BUFSIZ]; /* from stdio.h, typically 8K */
+    char         *p;
     int           len;
+    size_t        used;
+    int           ret;
     cbuf         *cb=NULL;
-    int           xml_state = 0;
     int           poll;
     clicon_hash_t *cdat = clicon_data(h); /* Save cbuf between calls if not done */
     size_t         cdatlen = 0;
@@ -505,24 +677,28 @@ netconf_input_cb(int   s,
 	    retval = 0;
 	    goto done;
 	}
-	for (i=0; i<len; i++){
-	    if (buf[i] == 0)
-		continue; /* Skip NULL chars (eg from terminals) */
-	    cprintf(cb, "%c", buf[i]);
-	    if (detect_endtag("]]>]]>",
-			      buf[i],
-			      &xml_state)) {
-		/* OK, we have an xml string from a client */
-		/* Remove trailer */
-		*(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-		if (netconf_input_frame(h, cb) < 0 &&
-		    !ignore_packet_errors) // default is to ignore errors
-		    goto done; 
-		if (cc_closed){
-		    break;
-		}
-		cbuf_reset(cb);
+	/* Scan input in blocks, there may be several frames in one read
+	 * Framing may change to chunked after a hello frame */
+	p = buf;
+	while (len > 0){
+	    if (netconf_framing == NETCONF_FRAME_CHUNKED)
+		ret = netconf_input_chunk(cb, p, len, &used);
+	    else
+		ret = detect_endtag_buf("]]>]]>", cb, p, len, &used);
+	    if (ret < 0)
+		goto done;
+	    p += used;
+	    len -= used;
+	    if (ret == 0)
+		break;
+	    /* OK, we have an xml string from a client, trailer is removed */
+	    if (netconf_input_frame(h, cb) < 0 &&
+		!ignore_packet_errors) // default is to ignore errors
+		goto done; 
+	    if (cc_closed){
+		break;
 	    }
+	    cbuf_reset(cb);
 	}
 	/* poll==1 if more, poll==0 if none */
 	if ((poll = clixon_event_poll(s)) < 0)
@@ -596,6 +772,8 @@ netconf_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     xpath_optimize_exit();
+    ctx_nodeset_pool_free();
+    xpath_cache_clear();
     clixon_event_exit();
     clicon_handle_exit(h);
     clixon_err_exit();
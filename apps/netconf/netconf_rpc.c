@@ -108,10 +108,86 @@ ok:
     return retval;
 }
 
+/*! Send get or get-config with subtree filter to backend, as xpath filter if possible
+ *
+ * The backend selects with the xpath in its datastore so that not all of it is
+ * serialized. The xpath selects a superset, the subtree filter is then applied on the
+ * reply, see netconf_get_config_subtree.
+ * @param[in]  h        Clicon handle
+ * @param[in]  xn       Sub-tree (under xorig) at <rpc>...</rpc> level.
+ * @param[in]  xfilter  Subtree filter in xn
+ * @param[out] xret     Return XML, error or OK
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xml_filter_xpath
+ */
+static int
+netconf_subtree_rpc(clicon_handle h, 
+		    cxobj        *xn, 
+		    cxobj        *xfilter,
+		    cxobj       **xret)
+{
+    int     retval = -1;
+    char   *xpath = NULL;
+    cvec   *nsc = NULL;
+    cxobj  *xrpc = NULL;
+    cxobj  *xe;
+    cxobj  *xf;
+    cxobj  *x;
+    cxobj  *xa;
+    cg_var *cv = NULL;
+    int     ret;
+
+    if ((ret = xml_filter_xpath(xfilter, &xpath, &nsc)) < 0)
+	goto done;
+    if (ret == 0){ /* Get whole datastore */
+	if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
+	    goto done;
+	goto ok;
+    }
+    clicon_debug(1, "%s xpath:%s", __FUNCTION__, xpath);
+    /* Copy of request with xpath filter instead of subtree */
+    if ((xrpc = xml_dup(xml_parent(xn))) == NULL)
+	goto done;
+    if ((xe = xml_find_type(xrpc, xml_prefix(xn), xml_name(xn), CX_ELMNT)) == NULL ||
+	(xf = xml_find_type(xe, xml_prefix(xfilter), xml_name(xfilter), CX_ELMNT)) == NULL){
+	clicon_err(OE_XML, EFAULT, "No filter in copy of request (shouldnt happen)");
+	goto done;
+    }
+    while ((x = xml_child_i_type(xf, 0, CX_ELMNT)) != NULL)
+	if (xml_purge(x) < 0)
+	    goto done;
+    if ((xa = xml_find_type(xf, NULL, "type", CX_ATTR)) != NULL &&
+	xml_value_set(xa, "xpath") < 0)
+	goto done;
+    if ((xa = xml_new("select", xf, CX_ATTR)) == NULL ||
+	xml_value_set(xa, xpath) < 0)
+	goto done;
+    while ((cv = cvec_each(nsc, cv)) != NULL){
+	if ((xa = xml_new(cv_name_get(cv), xf, CX_ATTR)) == NULL ||
+	    xml_prefix_set(xa, "xmlns") < 0 ||
+	    xml_value_set(xa, cv_string_get(cv)) < 0)
+	    goto done;
+    }
+    if (clicon_rpc_netconf_xml(h, xrpc, xret, NULL) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xpath)
+	free(xpath);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (xrpc)
+	xml_free(xrpc);
+    return retval;
+}
+
 /*! Get configuration
  * @param[in]  h       Clicon handle
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
+ * @param[out] xraw    Return as string from backend if passed through. Free with free
  * @note filter type subtree and xpath is supported, but xpath is preferred, and
  *              better performance and tested. Please use xpath.
  *
@@ -155,11 +231,14 @@ ok:
      <rpc><get-config><source><candidate/></source><filter type="subtree"><configuration><interfaces><interface><ipv4><enabled/></ipv4></interface></interfaces></configuration></filter></get-config></rpc>]]>]]>
  * filter xpath + select:
      <rpc><get-config><source><candidate/></source><filter type="xpath" select="/interfaces/interface/ipv4"/></get-config></rpc>]]>]]>
+ * Without subtree filter the reply of the backend is not changed, it is returned as a
+ * string in xraw and sent without parsing it.
  */
 static int
 netconf_get_config(clicon_handle h, 
 		   cxobj        *xn, 
-		   cxobj       **xret)
+		   cxobj       **xret,
+		   char        **xraw)
 {
      int        retval = -1;
      cxobj     *xfilter; /* filter */
@@ -179,13 +258,13 @@ netconf_get_config(clicon_handle h,
      if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
 	 ftype = xml_find_value(xfilter, "type");
      if (xfilter == NULL || ftype == NULL || strcmp(ftype, "xpath")==0){
-	 if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
+	 /* Reply is not transformed here, pass it through */
+	 if (clicon_rpc_netconf_xml_str(h, xml_parent(xn), xraw) < 0)
 	     goto done;	
      }
      else if (strcmp(ftype, "subtree")==0){
-	 /* Get whole config first, then filter. This is suboptimal
-	  */
-	 if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
+	 /* Get config selected by filter translated to xpath first, then filter */
+	 if (netconf_subtree_rpc(h, xn, xfilter, xret) < 0)
 	     goto done;	
 	 /* Now filter on whole tree */
 	 if (netconf_get_config_subtree(h, xfilter, xret) < 0)
@@ -361,6 +440,7 @@ netconf_edit_config(clicon_handle h,
  * @param[in]  h       Clicon handle
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
+ * @param[out] xraw    Return as string from backend if passed through. Free with free
  * @note filter type subtree and xpath is supported, but xpath is preferred, and
  *              better performance and tested. Please use xpath.
  *
@@ -371,7 +451,8 @@ netconf_edit_config(clicon_handle h,
 static int
 netconf_get(clicon_handle h, 
 	    cxobj        *xn, 
-	    cxobj       **xret)
+	    cxobj       **xret,
+	    char        **xraw)
 {
      int        retval = -1;
      cxobj     *xfilter; /* filter */
@@ -391,13 +472,13 @@ netconf_get(clicon_handle h,
      if ((xfilter = xpath_first(xn, nsc, "%s%sfilter", prefix ? prefix : "", prefix ? ":" : "")) != NULL)
 	 ftype = xml_find_value(xfilter, "type");
      if (xfilter == NULL || ftype == NULL || strcmp(ftype, "xpath")==0){
-	 if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
+	 /* Reply is not transformed here, pass it through */
+	 if (clicon_rpc_netconf_xml_str(h, xml_parent(xn), xraw) < 0)
 	     goto done;	
      }
      else if (strcmp(ftype, "subtree")==0){
-	 /* Get whole config + state first, then filter. This is suboptimal
-	  */
-	 if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, NULL) < 0)
+	 /* Get config + state selected by filter translated to xpath first, then filter */
+	 if (netconf_subtree_rpc(h, xn, xfilter, xret) < 0)
 	     goto done;	
 	 /* Now filter on whole tree */
 	 if (netconf_get_config_subtree(h, xfilter, xret) < 0)
@@ -562,6 +643,39 @@ netconf_create_subscription(clicon_handle h,
     return retval;
 }
 
+/*! Establish push subscription in the backend, see clixon-lib.yang
+ * As create-subscription, the subscription uses its own backend session, where
+ * push-update and push-change-update notifications are sent.
+ * @param[in]  h       clicon handle
+ * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
+ * @param[out] xret    Return XML, error or OK
+ * @see netconf_notification_cb for asynchronous notifications
+ */
+static int
+netconf_establish_push(clicon_handle h, 
+		       cxobj        *xn, 
+		       cxobj       **xret)
+{
+    int retval = -1;
+    int s;
+
+    if (clicon_rpc_netconf_xml(h, xml_parent(xn), xret, &s) < 0)
+	goto done;
+    if (xpath_first(*xret, NULL, "rpc-reply/rpc-error") != NULL){
+	close(s);
+	goto ok;
+    }
+    if (clixon_event_reg_fd(s, 
+		     netconf_notification_cb, 
+		     h,
+		     "push socket") < 0)
+	goto done;
+ ok:
+    retval = 0;
+  done:
+    return retval;
+}
+
 /*! See if there is any application defined RPC for this tag
  *
  * This may either be local client-side or backend. If backend send as netconf 
@@ -678,18 +792,21 @@ netconf_application_rpc(clicon_handle h,
  * @param[in]  h       clicon handle
  * @param[in]  xn      Sub-tree (under xorig) at <rpc>...</rpc> level.
  * @param[out] xret    Return XML, error or OK
+ * @param[out] xraw    Or, return as string from backend, to be sent unparsed. Free with free
  * @retval     0       OK, can also be netconf error 
  * @retval    -1       Error, fatal
  */
 int
 netconf_rpc_dispatch(clicon_handle h,
 		     cxobj        *xn, 
-		     cxobj       **xret)
+		     cxobj       **xret,
+		     char        **xraw)
 {
     int         retval = -1;
     cxobj      *xe;
     char       *username;
     cxobj      *xa;
+    char       *ns = NULL;
     
     /* Tag username on all incoming requests in case they are forwarded as internal messages
      * This may be unecesary since not all are forwarded. 
@@ -721,7 +838,7 @@ netconf_rpc_dispatch(clicon_handle h,
 		goto done;	
 	}
 	else if (strcmp(xml_name(xe), "get-config") == 0){
-	    if (netconf_get_config(h, xe, xret) < 0)
+	    if (netconf_get_config(h, xe, xret, xraw) < 0)
 		goto done;
 	}
 	else if (strcmp(xml_name(xe), "edit-config") == 0){
@@ -729,7 +846,7 @@ netconf_rpc_dispatch(clicon_handle h,
 		goto done;
 	}
 	else if (strcmp(xml_name(xe), "get") == 0){
-	    if (netconf_get(h, xe, xret) < 0)
+	    if (netconf_get(h, xe, xret, xraw) < 0)
 		goto done;
 	}
 	else if (strcmp(xml_name(xe), "close-session") == 0){
@@ -742,6 +859,13 @@ netconf_rpc_dispatch(clicon_handle h,
 	    if (netconf_create_subscription(h, xe, xret) < 0)
 		goto done;
 	}
+	/* Clixon push subscription */
+	else if (strcmp(xml_name(xe), "establish-push") == 0 &&
+		 xml2ns(xe, xml_prefix(xe), &ns) == 0 &&
+		 ns && strcmp(ns, CLIXON_LIB_NS) == 0){
+	    if (netconf_establish_push(h, xe, xret) < 0)
+		goto done;
+	}
 	/* Others */
 	else {
 	    /* Look for application-defined RPC. This may either be local
@@ -47,7 +47,11 @@ int restconf_reply_header(void *req, const char *name, const char *vfmt, ...)  _
 int restconf_reply_header(FCGX_Request *req, const char *name, const char *vfmt, ...);
 #endif
 
+int restconf_compress_init(clicon_handle h);
 int restconf_reply_send(void *req, int code, cbuf *cb);
+int restconf_reply_chunk_start(void *req, int code);
+int restconf_reply_chunk(void *req, cbuf *cb);
+int restconf_reply_chunk_end(void *req);
 
 cbuf *restconf_get_indata(void *req);
 
@@ -183,6 +183,17 @@ restconf_reply_body_add(void     *req0,
     return retval;
 }
 
+/*! Set compression of HTTP reply bodies from clixon options
+ * @param[in]  h     Clicon handle
+ * Not done in fcgi: Accept-Encoding is passed through and the reverse proxy compresses
+ * the body of the HTTP reply, eg nginx gzip.
+ */
+int
+restconf_compress_init(clicon_handle h)
+{
+    return 0;
+}
+
 /*! Send HTTP reply with potential message body
  * @param[in]     req   Fastcgi request handle
  * @param[in]     code  Status code
@@ -216,6 +227,64 @@ restconf_reply_send(void  *req0,
     return retval;
 }
 
+/*! Start HTTP reply with a message body sent in chunks
+ * @param[in]  req   Fastcgi request handle
+ * @param[in]  code  Status code
+ * Headers are given before. The reverse proxy encodes the body of the HTTP reply.
+ * @see restconf_reply_chunk
+ * @see restconf_reply_chunk_end
+ */
+int
+restconf_reply_chunk_start(void *req0,
+			   int   code)
+{
+    FCGX_Request *req = (FCGX_Request *)req0;
+    int           retval = -1;
+    const char   *reason_phrase;
+
+    FCGX_SetExitStatus(code, req->out);
+    if ((reason_phrase = restconf_code2reason(code)) == NULL)
+	reason_phrase="";
+    if (restconf_reply_header(req, "Status", "%d %s", code, reason_phrase) < 0)
+	goto done;
+    FCGX_FPrintF(req->out, "\r\n");
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send a chunk of HTTP reply message body
+ * @param[in]  req   Fastcgi request handle
+ * @param[in]  cb    Part of body
+ * @see restconf_reply_chunk_start
+ */
+int
+restconf_reply_chunk(void *req0,
+		     cbuf *cb)
+{
+    FCGX_Request *req = (FCGX_Request *)req0;
+
+    if (cbuf_len(cb) &&
+	FCGX_PutStr(cbuf_get(cb), cbuf_len(cb), req->out) < 0){
+	clicon_err(OE_RESTCONF, errno, "FCGX_PutStr");
+	return -1;
+    }
+    return 0;
+}
+
+/*! End HTTP reply with a message body sent in chunks
+ * @param[in]  req   Fastcgi request handle
+ * @see restconf_reply_chunk_start
+ */
+int
+restconf_reply_chunk_end(void *req0)
+{
+    FCGX_Request *req = (FCGX_Request *)req0;
+
+    FCGX_FFlush(req->out);
+    return 0;
+}
+
 /*!
  * @param[in]  req        Fastcgi request handle
  */
@@ -44,10 +44,14 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <syslog.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 /* evhtp */ 
 #define EVHTP_DISABLE_REGEX
@@ -115,6 +119,272 @@ restconf_reply_header(void       *req0,
     return retval;
 }
 
+#ifdef HAVE_LIBZ
+/* Compression of HTTP reply bodies, see CLICON_RESTCONF_COMPRESS_LEVEL */
+static int    _compress_level = 0;      /* zlib level 1-9, 0 is off */
+static size_t _compress_threshold = 0;  /* Bodies shorter than this are not compressed */
+
+/* Compression state of a chunked reply body */
+struct compress_stream{
+    qelem_t          cs_q;   /* Replies being sent */
+    evhtp_request_t *cs_req; /* Evhtp http request handle */
+    z_stream         cs_zs;  /* Zlib stream */
+};
+static struct compress_stream *_compress_streams = NULL;
+
+/*! Negotiate content-coding of reply from Accept-Encoding of request, RFC 7231 Sec 5.3.4
+ * @param[in]  req   Evhtp http request handle
+ * @retval     wbits zlib window bits: 31 for gzip, 15 for deflate
+ * @retval     0     No compression, also if not acceptable by client
+ */
+static int
+compress_negotiate(evhtp_request_t *req)
+{
+    const char *ae;
+    const char *s;
+    const char *e;
+    size_t      len;
+    double      q;
+    double      qgzip = -1;
+    double      qdeflate = 0;
+    double      qany = -1;
+
+    if ((ae = evhtp_header_find(req->headers_in, "Accept-Encoding")) == NULL)
+	return 0;
+    s = ae;
+    while (*s){
+	while (*s == ' ' || *s == '\t' || *s == ',')
+	    s++;
+	if (*s == '\0')
+	    break;
+	e = s;
+	while (*e && *e != ',' && *e != ';' && *e != ' ' && *e != '\t')
+	    e++;
+	len = e - s;
+	q = 1;
+	while (*e && *e != ','){
+	    if (*e == ';'){
+		e++;
+		while (*e == ' ' || *e == '\t')
+		    e++;
+		if (*e == 'q' && *(e+1) == '=')
+		    q = strtod(e+2, NULL);
+	    }
+	    else
+		e++;
+	}
+	if ((len == 4 && strncasecmp(s, "gzip", 4) == 0) ||
+	    (len == 6 && strncasecmp(s, "x-gzip", 6) == 0))
+	    qgzip = q;
+	else if (len == 7 && strncasecmp(s, "deflate", 7) == 0)
+	    qdeflate = q;
+	else if (len == 1 && *s == '*')
+	    qany = q;
+	s = e;
+    }
+    /* Codings not listed are acceptable if * is */
+    if (qgzip < 0)
+	qgzip = qany;
+    if (qgzip > 0 && qgzip >= qdeflate)
+	return 31;
+    if (qdeflate > 0)
+	return 15;
+    return 0;
+}
+
+/*! Check if reply body may be compressed
+ * Event streams are not compressed since each event must reach the client when sent,
+ * nor are bodies already encoded by a plugin.
+ * @param[in]  req   Evhtp http request handle
+ * @retval     1     Yes
+ * @retval     0     No
+ */
+static int
+compress_reply(evhtp_request_t *req)
+{
+    const char *ct;
+
+    if (_compress_level == 0)
+	return 0;
+    if (evhtp_header_find(req->headers_out, "Content-Encoding") != NULL)
+	return 0;
+    if ((ct = evhtp_header_find(req->headers_out, "Content-Type")) != NULL &&
+	strncmp(ct, "text/event-stream", strlen("text/event-stream")) == 0)
+	return 0;
+    return 1;
+}
+
+/*! Add Content-Encoding and Vary reply headers
+ * @param[in]  req   Evhtp http request handle
+ * @param[in]  wbits zlib window bits, see compress_negotiate
+ */
+static int
+compress_headers(evhtp_request_t *req,
+		 int              wbits)
+{
+    if (restconf_reply_header(req, "Content-Encoding", "%s", wbits==31?"gzip":"deflate") < 0)
+	return -1;
+    if (restconf_reply_header(req, "Vary", "Accept-Encoding") < 0)
+	return -1;
+    return 0;
+}
+
+/*! Deflate data into an evbuffer
+ * @param[in]  zs    Zlib stream
+ * @param[in]  buf   Data to compress
+ * @param[in]  len   Length of data
+ * @param[in]  flush Z_NO_FLUSH, Z_SYNC_FLUSH or Z_FINISH
+ * @param[in]  eb    Evbuffer, compressed data is appended
+ */
+static int
+compress_deflate(z_stream        *zs,
+		 char            *buf,
+		 size_t           len,
+		 int              flush,
+		 struct evbuffer *eb)
+{
+    unsigned char out[16384];
+    int           ret;
+
+    zs->next_in = (Bytef *)buf;
+    zs->avail_in = len;
+    do {
+	zs->next_out = out;
+	zs->avail_out = sizeof(out);
+	if ((ret = deflate(zs, flush)) == Z_STREAM_ERROR){
+	    clicon_err(OE_RESTCONF, 0, "deflate: %s", zs->msg?zs->msg:"stream error");
+	    return -1;
+	}
+	if (sizeof(out) - zs->avail_out &&
+	    evbuffer_add(eb, out, sizeof(out) - zs->avail_out) < 0){
+	    clicon_err(OE_CFG, errno, "evbuffer_add");
+	    return -1;
+	}
+    } while (zs->avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+    return 0;
+}
+
+/*! Compress a whole reply body
+ * @param[in]  buf   Body
+ * @param[in]  len   Length of body
+ * @param[in]  wbits zlib window bits, see compress_negotiate
+ * @param[in]  eb    Evbuffer, compressed body is appended
+ */
+static int
+compress_body(char            *buf,
+	      size_t           len,
+	      int              wbits,
+	      struct evbuffer *eb)
+{
+    int      retval = -1;
+    z_stream zs = {0,};
+
+    if (deflateInit2(&zs, _compress_level, Z_DEFLATED, wbits, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+	clicon_err(OE_RESTCONF, 0, "deflateInit2");
+	return -1;
+    }
+    if (compress_deflate(&zs, buf, len, Z_FINISH, eb) < 0)
+	goto done;
+    retval = 0;
+ done:
+    deflateEnd(&zs);
+    return retval;
+}
+
+/*! Find compression state of a chunked reply
+ * @param[in]  req   Evhtp http request handle
+ * @retval     cs    Compression state
+ * @retval     NULL  Reply is not compressed
+ */
+static struct compress_stream *
+compress_stream_find(evhtp_request_t *req)
+{
+    struct compress_stream *cs;
+
+    if ((cs = _compress_streams) != NULL)
+	do {
+	    if (cs->cs_req == req)
+		return cs;
+	    cs = NEXTQ(struct compress_stream *, cs);
+	} while (cs != _compress_streams);
+    return NULL;
+}
+
+/*! Free compression state of a chunked reply
+ * @param[in]  cs    Compression state
+ */
+static int
+compress_stream_free(struct compress_stream *cs)
+{
+    DELQ(cs, _compress_streams, struct compress_stream *);
+    deflateEnd(&cs->cs_zs);
+    free(cs);
+    return 0;
+}
+
+/*! Request freed by evhtp, also if the reply was not ended, eg connection closed
+ * @param[in]  req   Evhtp http request handle
+ * @param[in]  arg   Compression state
+ */
+static evhtp_res
+compress_stream_fini(evhtp_request_t *req,
+		     void            *arg)
+{
+    struct compress_stream *cs;
+
+    if ((cs = compress_stream_find(req)) != NULL)
+	compress_stream_free(cs);
+    return EVHTP_RES_OK;
+}
+
+/*! Start compression of a chunked reply if negotiated with client
+ * @param[in]  req   Evhtp http request handle
+ */
+static int
+compress_stream_start(evhtp_request_t *req)
+{
+    struct compress_stream *cs;
+    int                     wbits;
+
+    if (!compress_reply(req) ||
+	(wbits = compress_negotiate(req)) == 0)
+	return 0;
+    if ((cs = malloc(sizeof(*cs))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return -1;
+    }
+    memset(cs, 0, sizeof(*cs));
+    cs->cs_req = req;
+    if (deflateInit2(&cs->cs_zs, _compress_level, Z_DEFLATED, wbits, 8, Z_DEFAULT_STRATEGY) != Z_OK){
+	clicon_err(OE_RESTCONF, 0, "deflateInit2");
+	free(cs);
+	return -1;
+    }
+    INSQ(cs, _compress_streams);
+    evhtp_request_set_hook(req, evhtp_hook_on_request_fini, (evhtp_hook)compress_stream_fini, cs);
+    return compress_headers(req, wbits);
+}
+#endif /* HAVE_LIBZ */
+
+/*! Set compression of HTTP reply bodies from clixon options
+ * @param[in]  h     Clicon handle
+ * @see CLICON_RESTCONF_COMPRESS_LEVEL, CLICON_RESTCONF_COMPRESS_THRESHOLD
+ */
+int
+restconf_compress_init(clicon_handle h)
+{
+#ifdef HAVE_LIBZ
+    _compress_level = clicon_option_int(h, "CLICON_RESTCONF_COMPRESS_LEVEL");
+    if (_compress_level < 0 || _compress_level > 9)
+	_compress_level = 0;
+    _compress_threshold = clicon_option_int(h, "CLICON_RESTCONF_COMPRESS_THRESHOLD");
+#else
+    if (clicon_option_int(h, "CLICON_RESTCONF_COMPRESS_LEVEL") > 0)
+	clicon_log(LOG_WARNING, "CLICON_RESTCONF_COMPRESS_LEVEL set but clixon built without zlib");
+#endif
+    return 0;
+}
+
 /*! Send HTTP reply with potential message body
  * @param[in]     req         Evhtp http request handle
  * @param[in]     cb          Body as a cbuf, send if 
@@ -131,6 +401,9 @@ restconf_reply_send(void  *req0,
     const char         *reason_phrase;
     evhtp_connection_t *conn;
     struct evbuffer    *eb = NULL;
+#ifdef HAVE_LIBZ
+    int                 wbits;
+#endif
     
     req->status = code;
     if ((reason_phrase = restconf_code2reason(code)) == NULL)
@@ -147,24 +420,34 @@ restconf_reply_send(void  *req0,
     /* If body, add a content-length header */
     if (cb != NULL && cbuf_len(cb)){
 	cprintf(cb, "\r\n");
-	if (restconf_reply_header(req, "Content-Length", "%d", cbuf_len(cb)) < 0)
-	    goto done;
-    }
-    evhtp_send_reply(req, req->status);
-
-    /* Write a body if cbuf is nonzero */
-    if (cb != NULL && cbuf_len(cb)){
 	/* Suboptimal, copy from cbuf to evbuffer */
 	if ((eb = evbuffer_new()) == NULL){
 	    clicon_err(OE_RESTCONF, errno, "evbuffer_new");
 	    goto done;
 	}
+#ifdef HAVE_LIBZ
+	if (cbuf_len(cb) >= _compress_threshold &&
+	    compress_reply(req) &&
+	    (wbits = compress_negotiate(req)) != 0){
+	    if (compress_body(cbuf_get(cb), cbuf_len(cb), wbits, eb) < 0)
+		goto done;
+	    if (compress_headers(req, wbits) < 0)
+		goto done;
+	}
+	else
+#endif
 	if (evbuffer_add(eb, cbuf_get(cb), cbuf_len(cb)) < 0){
 	    clicon_err(OE_CFG, errno, "evbuffer_add");
 	    goto done;
 	}
-	evhtp_send_reply_body(req, eb); /* conn->bev = eb, body is different */
+	if (restconf_reply_header(req, "Content-Length", "%zu", evbuffer_get_length(eb)) < 0)
+	    goto done;
     }
+    evhtp_send_reply(req, req->status);
+
+    /* Write a body if cbuf is nonzero */
+    if (eb != NULL)
+	evhtp_send_reply_body(req, eb); /* conn->bev = eb, body is different */
     evhtp_send_reply_end(req);      /* just flag finished */
     retval = 0;
  done:
@@ -173,6 +456,108 @@ restconf_reply_send(void  *req0,
     return retval;
 }
 
+/*! Start HTTP reply with a message body sent in chunks
+ * @param[in]  req   Evhtp http request handle
+ * @param[in]  code  Status code
+ * Headers are given before. The body is sent with chunked transfer encoding if the
+ * request is HTTP/1.1, otherwise the connection is closed after the body.
+ * The body is compressed while sent if negotiated, see CLICON_RESTCONF_COMPRESS_LEVEL
+ * @see restconf_reply_chunk
+ * @see restconf_reply_chunk_end
+ */
+int
+restconf_reply_chunk_start(void *req0,
+			   int   code)
+{
+    evhtp_request_t *req = (evhtp_request_t *)req0;
+
+    req->status = code;
+#ifdef HAVE_LIBZ
+    if (compress_stream_start(req) < 0)
+	return -1;
+#endif
+    evhtp_send_reply_chunk_start(req, code);
+    return 0;
+}
+
+/*! Send a chunk of HTTP reply message body
+ * @param[in]  req   Evhtp http request handle
+ * @param[in]  cb    Part of body
+ * @see restconf_reply_chunk_start
+ */
+int
+restconf_reply_chunk(void *req0,
+		     cbuf *cb)
+{
+    evhtp_request_t        *req = (evhtp_request_t *)req0;
+    int                     retval = -1;
+    struct evbuffer        *eb = NULL;
+#ifdef HAVE_LIBZ
+    struct compress_stream *cs;
+#endif
+
+    if (cbuf_len(cb) == 0) /* An empty chunk ends the body */
+	goto ok;
+    if ((eb = evbuffer_new()) == NULL){
+	clicon_err(OE_RESTCONF, errno, "evbuffer_new");
+	goto done;
+    }
+#ifdef HAVE_LIBZ
+    if ((cs = compress_stream_find(req)) != NULL){
+	/* Flush so that each chunk can be decoded by client when received */
+	if (compress_deflate(&cs->cs_zs, cbuf_get(cb), cbuf_len(cb), Z_SYNC_FLUSH, eb) < 0)
+	    goto done;
+    }
+    else
+#endif
+    if (evbuffer_add(eb, cbuf_get(cb), cbuf_len(cb)) < 0){
+	clicon_err(OE_CFG, errno, "evbuffer_add");
+	goto done;
+    }
+    if (evbuffer_get_length(eb))
+	evhtp_send_reply_chunk(req, eb);
+ ok:
+    retval = 0;
+ done:
+    if (eb)
+	evhtp_safe_free(eb, evbuffer_free);
+    return retval;
+}
+
+/*! End HTTP reply with a message body sent in chunks
+ * @param[in]  req   Evhtp http request handle
+ * @see restconf_reply_chunk_start
+ */
+int
+restconf_reply_chunk_end(void *req0)
+{
+    evhtp_request_t        *req = (evhtp_request_t *)req0;
+    int                     retval = -1;
+#ifdef HAVE_LIBZ
+    struct compress_stream *cs;
+    struct evbuffer        *eb = NULL;
+
+    if ((cs = compress_stream_find(req)) != NULL){
+	if ((eb = evbuffer_new()) == NULL){
+	    clicon_err(OE_RESTCONF, errno, "evbuffer_new");
+	    goto done;
+	}
+	if (compress_deflate(&cs->cs_zs, NULL, 0, Z_FINISH, eb) < 0)
+	    goto done;
+	compress_stream_free(cs);
+	evhtp_send_reply_chunk(req, eb);
+    }
+#endif
+    evhtp_send_reply_chunk_end(req);
+    retval = 0;
+#ifdef HAVE_LIBZ
+ done:
+    if (eb)
+	evhtp_safe_free(eb, evbuffer_free);
+#endif
+    return retval;
+}
+
 /*! get input data
  * @param[in]  req        Fastcgi request handle
  * @note Pulls up an event buffer and then copies it to a cbuf. This is not efficient.
@@ -0,0 +1,706 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * HTTP/2 framing of native restconf requests, using nghttp2, see --enable-http2
+ * A connection uses HTTP/2 if "h2" is selected by TLS ALPN, see restconf_alpn_select_cb,
+ * or if a cleartext connection starts with the HTTP/2 client preface (prior knowledge).
+ * Each connection has a nghttp2 server session fed with data read from the socket.
+ * The frames it produces are written via the evhtp output buffer of the connection,
+ * see restconf_output_flush.
+ * A request stream is served by evhtp as a HTTP/1.1 request on the same connection, and
+ * the HTTP/1.1 reply is converted to HTTP/2 response headers and data, see
+ * restconf_h2_request. Requests of several streams are served one after the other as
+ * they end, while their replies are interleaved by nghttp2 on the connection.
+ * Event streams, see CLICON_STREAM_PATH, are only served on HTTP/1.1.
+ * @see RFC 7540 Hypertext Transfer Protocol Version 2 (HTTP/2)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <syslog.h>
+
+#include <openssl/ssl.h>
+#include <nghttp2/nghttp2.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+/* evhtp */
+#include <event2/buffer.h> /* evbuffer */
+#include <event2/bufferevent.h>
+#define EVHTP_DISABLE_REGEX
+#define EVHTP_DISABLE_EVTHR
+#define EVHTP_EXPORT
+#include <evhtp/evhtp.h>
+
+/* restconf */
+#include "restconf_lib.h"
+#include "restconf_handle.h"
+#include "restconf_openssl.h"
+#include "restconf_http2.h"
+
+#define ARRLEN(x) (sizeof(x) / sizeof(x[0]))
+
+/* HTTP/2 session of a restconf connection
+ */
+struct restconf_h2{
+    nghttp2_session           *h2_session; /* nghttp2 server session */
+    restconf_conn             *h2_rc;      /* Restconf connection */
+    struct restconf_h2_stream *h2_streams; /* Open streams */
+};
+
+/* HTTP/2 stream, ie a request and its reply
+ */
+struct restconf_h2_stream{
+    qelem_t             hs_qelem;   /* List header */
+    struct restconf_h2 *hs_h2;      /* Session of stream */
+    int32_t             hs_id;      /* Stream id */
+    cbuf               *hs_method;  /* :method */
+    cbuf               *hs_path;    /* :path */
+    cbuf               *hs_host;    /* :authority, or host header */
+    cbuf               *hs_headers; /* Other request headers on HTTP/1.1 form */
+    struct evbuffer    *hs_in;      /* Request body */
+    struct evbuffer    *hs_out;     /* Reply body */
+};
+
+/* Connection-specific headers, not allowed in HTTP/2, see RFC 7540 Sec 8.1.2.2
+ */
+static const char *restconf_h2_hop_headers[] = {
+    "connection",
+    "keep-alive",
+    "proxy-connection",
+    "transfer-encoding",
+    "upgrade",
+    "te",
+    NULL
+};
+
+/*! Check if header name is connection-specific
+ * @param[in]  name  Header name in lower case
+ * @retval     1     Connection-specific
+ * @retval     0     Not connection-specific
+ */
+static int
+restconf_h2_hop_header(const char *name)
+{
+    int i;
+
+    for (i=0; restconf_h2_hop_headers[i]; i++)
+	if (strcmp(name, restconf_h2_hop_headers[i]) == 0)
+	    return 1;
+    return 0;
+}
+
+/*! Create stream of session
+ */
+static struct restconf_h2_stream *
+restconf_h2_stream_new(struct restconf_h2 *h2,
+		       int32_t             id)
+{
+    struct restconf_h2_stream *hs;
+
+    if ((hs = malloc(sizeof(*hs))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(hs, 0, sizeof(*hs));
+    hs->hs_h2 = h2;
+    hs->hs_id = id;
+    if ((hs->hs_method = cbuf_new()) == NULL ||
+	(hs->hs_path = cbuf_new()) == NULL ||
+	(hs->hs_host = cbuf_new()) == NULL ||
+	(hs->hs_headers = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto fail;
+    }
+    if ((hs->hs_in = evbuffer_new()) == NULL ||
+	(hs->hs_out = evbuffer_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "evbuffer_new");
+	goto fail;
+    }
+    ADDQ(hs, h2->h2_streams);
+    return hs;
+ fail:
+    if (hs->hs_method)
+	cbuf_free(hs->hs_method);
+    if (hs->hs_path)
+	cbuf_free(hs->hs_path);
+    if (hs->hs_host)
+	cbuf_free(hs->hs_host);
+    if (hs->hs_headers)
+	cbuf_free(hs->hs_headers);
+    if (hs->hs_in)
+	evbuffer_free(hs->hs_in);
+    free(hs);
+    return NULL;
+}
+
+/*! Free stream
+ */
+static int
+restconf_h2_stream_free(struct restconf_h2_stream *hs)
+{
+    DELQ(hs, hs->hs_h2->h2_streams, struct restconf_h2_stream *);
+    cbuf_free(hs->hs_method);
+    cbuf_free(hs->hs_path);
+    cbuf_free(hs->hs_host);
+    cbuf_free(hs->hs_headers);
+    evbuffer_free(hs->hs_in);
+    evbuffer_free(hs->hs_out);
+    free(hs);
+    return 0;
+}
+
+/*! nghttp2 data provider of response, sends reply body of stream
+ */
+static ssize_t
+restconf_h2_data_read_cb(nghttp2_session     *session,
+			 int32_t              stream_id,
+			 uint8_t             *buf,
+			 size_t               length,
+			 uint32_t            *data_flags,
+			 nghttp2_data_source *source,
+			 void                *user_data)
+{
+    struct restconf_h2_stream *hs = source->ptr;
+    int                        n;
+
+    if ((n = evbuffer_remove(hs->hs_out, buf, length)) < 0)
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    if (evbuffer_get_length(hs->hs_out) == 0)
+	*data_flags |= NGHTTP2_DATA_FLAG_EOF;
+    return n;
+}
+
+/*! Submit response of stream with status only, eg on error
+ * @param[in]  hs      Stream
+ * @param[in]  status  HTTP status code as string, eg "400"
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+restconf_h2_status(struct restconf_h2_stream *hs,
+		   char                      *status)
+{
+    nghttp2_nv nva[] = {
+	{(uint8_t*)":status", (uint8_t*)status, 7, strlen(status), NGHTTP2_NV_FLAG_NONE}
+    };
+
+    if (nghttp2_submit_response(hs->hs_h2->h2_session, hs->hs_id, nva, ARRLEN(nva), NULL) != 0){
+	clicon_err(OE_PROTO, 0, "nghttp2_submit_response");
+	return -1;
+    }
+    return 0;
+}
+
+/*! Submit HTTP/1.1 reply of stream as HTTP/2 response
+ *
+ * The reply in hs_out starts with status line and headers, they are removed and
+ * what is left is the body.
+ * Header names are made lower case, and connection-specific headers are removed.
+ * @param[in]  hs   Stream
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+restconf_h2_reply(struct restconf_h2_stream *hs)
+{
+    int                   retval = -1;
+    struct evbuffer_ptr   pos;
+    size_t                len;
+    char                 *hdrs = NULL;
+    char                 *line;
+    char                 *next;
+    char                 *value;
+    char                 *p;
+    char                  status[4];
+    nghttp2_nv           *nva = NULL;
+    size_t                nvlen = 0;
+    nghttp2_data_provider prd;
+
+    pos = evbuffer_search(hs->hs_out, "\r\n\r\n", 4, NULL);
+    if (pos.pos < 0 ||
+	evbuffer_get_length(hs->hs_out) < strlen("HTTP/1.1 200")){
+	clicon_debug(1, "%s no reply", __FUNCTION__);
+	evbuffer_drain(hs->hs_out, evbuffer_get_length(hs->hs_out));
+	retval = restconf_h2_status(hs, "500");
+	goto done;
+    }
+    len = pos.pos + 4;
+    if ((hdrs = malloc(len + 1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    if (evbuffer_remove(hs->hs_out, hdrs, len) < 0){
+	clicon_err(OE_UNIX, errno, "evbuffer_remove");
+	goto done;
+    }
+    hdrs[len] = '\0';
+    /* Reply of HEAD has no body, also if content-length is set */
+    if (strcmp(cbuf_get(hs->hs_method), "HEAD") == 0)
+	evbuffer_drain(hs->hs_out, evbuffer_get_length(hs->hs_out));
+    /* Status line, eg: HTTP/1.1 200 OK */
+    if (strncmp(hdrs, "HTTP/1.", strlen("HTTP/1.")) != 0 ||
+	(p = strchr(hdrs, ' ')) == NULL ||
+	!isdigit(p[1]) || !isdigit(p[2]) || !isdigit(p[3])){
+	clicon_debug(1, "%s bad status line", __FUNCTION__);
+	evbuffer_drain(hs->hs_out, evbuffer_get_length(hs->hs_out));
+	retval = restconf_h2_status(hs, "500");
+	goto done;
+    }
+    memcpy(status, p+1, 3);
+    status[3] = '\0';
+    /* At most one header per line, and :status */
+    if ((nva = calloc(len/2 + 1, sizeof(*nva))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    nva[nvlen++] = (nghttp2_nv){(uint8_t*)":status", (uint8_t*)status,
+				7, 3, NGHTTP2_NV_FLAG_NONE};
+    line = strstr(hdrs, "\r\n") + 2;
+    while ((next = strstr(line, "\r\n")) != NULL && next != line){
+	*next = '\0';
+	if ((value = strchr(line, ':')) != NULL){
+	    *value++ = '\0';
+	    while (*value == ' ' || *value == '\t')
+		value++;
+	    for (p = line; *p; p++)
+		*p = tolower(*p);
+	    if (!restconf_h2_hop_header(line))
+		nva[nvlen++] = (nghttp2_nv){(uint8_t*)line, (uint8_t*)value,
+					    strlen(line), strlen(value),
+					    NGHTTP2_NV_FLAG_NONE};
+	}
+	line = next + 2;
+    }
+    prd.source.ptr = hs;
+    prd.read_callback = restconf_h2_data_read_cb;
+    /* Headers and data are copied by nghttp2 */
+    if (nghttp2_submit_response(hs->hs_h2->h2_session, hs->hs_id, nva, nvlen,
+				evbuffer_get_length(hs->hs_out)?&prd:NULL) != 0){
+	clicon_err(OE_PROTO, 0, "nghttp2_submit_response");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (nva)
+	free(nva);
+    if (hdrs)
+	free(hdrs);
+    return retval;
+}
+
+/*! Serve request of stream by evhtp, and submit its reply
+ *
+ * The request is given to the evhtp parser of the connection as a HTTP/1.1 request,
+ * and is served by the same callbacks as on HTTP/1.1, eg restconf_path_root.
+ * The reply is written by evhtp to the output buffer of the connection. That buffer is
+ * set aside meanwhile, since it may hold frames of the session not yet written.
+ * Event streams are refused with HTTP_1_1_REQUIRED, the client may then retry the request
+ * on a HTTP/1.1 connection.
+ * nghttp2 has already checked that header names and values are valid, ie cannot add
+ * lines to the HTTP/1.1 request.
+ * @param[in]  hs   Stream
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+restconf_h2_request(struct restconf_h2_stream *hs)
+{
+    int                 retval = -1;
+    restconf_conn      *rc = hs->hs_h2->h2_rc;
+    nghttp2_session    *session = hs->hs_h2->h2_session;
+    evhtp_connection_t *conn = rc->rc_conn;
+    char               *path;
+    char               *stream_path;
+    size_t              len;
+    struct evbuffer    *out;
+    struct evbuffer    *req = NULL;
+    struct evbuffer    *saved = NULL;
+    int                 ret;
+
+    path = cbuf_get(hs->hs_path);
+    clicon_debug(1, "%s %d %s %s", __FUNCTION__, hs->hs_id, cbuf_get(hs->hs_method), path);
+    if (*path != '/'){ /* eg CONNECT or OPTIONS * */
+	if (restconf_h2_status(hs, "400") < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((stream_path = clicon_option_str(rc->rc_h, "CLICON_STREAM_PATH")) != NULL){
+	len = strlen(stream_path);
+	if (strncmp(path+1, stream_path, len) == 0 &&
+	    (path[len+1] == '\0' || path[len+1] == '/' || path[len+1] == '?')){
+	    if (nghttp2_submit_rst_stream(session, NGHTTP2_FLAG_NONE, hs->hs_id,
+					  NGHTTP2_HTTP_1_1_REQUIRED) != 0){
+		clicon_err(OE_PROTO, 0, "nghttp2_submit_rst_stream");
+		goto done;
+	    }
+	    goto ok;
+	}
+    }
+    if (conn->bev == NULL || (out = bufferevent_get_output(conn->bev)) == NULL){
+	clicon_err(OE_RESTCONF, EFAULT, "No evhtp output buffer");
+	goto done;
+    }
+    if ((req = evbuffer_new()) == NULL ||
+	(saved = evbuffer_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "evbuffer_new");
+	goto done;
+    }
+    evbuffer_add_printf(req, "%s %s HTTP/1.1\r\n", cbuf_get(hs->hs_method), path);
+    if (cbuf_len(hs->hs_host))
+	evbuffer_add_printf(req, "Host: %s\r\n", cbuf_get(hs->hs_host));
+    evbuffer_add_printf(req, "%sContent-Length: %zu\r\n\r\n",
+			cbuf_get(hs->hs_headers), evbuffer_get_length(hs->hs_in));
+    if (evbuffer_add_buffer(req, hs->hs_in) < 0 ||
+	evbuffer_add_buffer(saved, out) < 0){
+	clicon_err(OE_UNIX, errno, "evbuffer_add_buffer");
+	goto done;
+    }
+    ret = connection_parse_nobev((char*)evbuffer_pullup(req, -1), evbuffer_get_length(req), conn);
+    if (evbuffer_add_buffer(hs->hs_out, out) < 0 ||
+	evbuffer_add_buffer(out, saved) < 0){
+	clicon_err(OE_UNIX, errno, "evbuffer_add_buffer");
+	goto done;
+    }
+    if (ret < 0){
+	/* The parser of the connection cannot be used for more requests */
+	clicon_debug(1, "%s connection_parse error", __FUNCTION__);
+	evbuffer_drain(hs->hs_out, evbuffer_get_length(hs->hs_out));
+	if (restconf_h2_status(hs, "400") < 0)
+	    goto done;
+	/* No new streams, the connection is closed when the reply is sent */
+	if (nghttp2_submit_goaway(session, NGHTTP2_FLAG_NONE, hs->hs_id,
+				  NGHTTP2_INTERNAL_ERROR, NULL, 0) != 0){
+	    clicon_err(OE_PROTO, 0, "nghttp2_submit_goaway");
+	    goto done;
+	}
+	goto ok;
+    }
+    if (restconf_h2_reply(hs) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (req)
+	evbuffer_free(req);
+    if (saved)
+	evbuffer_free(saved);
+    return retval;
+}
+
+/*! nghttp2 callback of request headers, create stream
+ */
+static int
+restconf_h2_begin_headers_cb(nghttp2_session     *session,
+			     const nghttp2_frame *frame,
+			     void                *user_data)
+{
+    struct restconf_h2        *h2 = user_data;
+    struct restconf_h2_stream *hs;
+
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+	frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+	return 0;
+    if ((hs = restconf_h2_stream_new(h2, frame->hd.stream_id)) == NULL)
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    nghttp2_session_set_stream_user_data(session, frame->hd.stream_id, hs);
+    return 0;
+}
+
+/*! nghttp2 callback of a request header
+ *
+ * Pseudo-headers are saved for the request line. Other headers are saved on
+ * HTTP/1.1 form, except connection-specific headers and those set by
+ * restconf_h2_request.
+ */
+static int
+restconf_h2_header_cb(nghttp2_session     *session,
+		      const nghttp2_frame *frame,
+		      const uint8_t       *name,
+		      size_t               namelen,
+		      const uint8_t       *value,
+		      size_t               valuelen,
+		      uint8_t              flags,
+		      void                *user_data)
+{
+    struct restconf_h2_stream *hs;
+    const char                *n = (const char*)name;
+    cbuf                      *cb = NULL;
+
+    if (frame->hd.type != NGHTTP2_HEADERS ||
+	frame->headers.cat != NGHTTP2_HCAT_REQUEST)
+	return 0;
+    if ((hs = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id)) == NULL)
+	return 0;
+    if (strcmp(n, ":method") == 0)
+	cb = hs->hs_method;
+    else if (strcmp(n, ":path") == 0)
+	cb = hs->hs_path;
+    else if (strcmp(n, ":authority") == 0)
+	cb = hs->hs_host;
+    else if (strcmp(n, "host") == 0){
+	if (cbuf_len(hs->hs_host) == 0) /* :authority has precedence */
+	    cb = hs->hs_host;
+    }
+    else if (*n != ':' &&
+	     strcmp(n, "content-length") != 0 &&
+	     strcmp(n, "expect") != 0 &&
+	     !restconf_h2_hop_header(n))
+	cprintf(hs->hs_headers, "%s: %.*s\r\n", n, (int)valuelen, (char*)value);
+    if (cb)
+	cprintf(cb, "%.*s", (int)valuelen, (char*)value);
+    return 0;
+}
+
+/*! nghttp2 callback of request data, append to request body
+ */
+static int
+restconf_h2_data_chunk_cb(nghttp2_session *session,
+			  uint8_t          flags,
+			  int32_t          stream_id,
+			  const uint8_t   *data,
+			  size_t           len,
+			  void            *user_data)
+{
+    struct restconf_h2_stream *hs;
+
+    if ((hs = nghttp2_session_get_stream_user_data(session, stream_id)) == NULL)
+	return 0;
+    if (evbuffer_add(hs->hs_in, data, len) < 0){
+	clicon_err(OE_UNIX, errno, "evbuffer_add");
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    }
+    return 0;
+}
+
+/*! nghttp2 callback of received frame, serve request at end of stream
+ */
+static int
+restconf_h2_frame_recv_cb(nghttp2_session     *session,
+			  const nghttp2_frame *frame,
+			  void                *user_data)
+{
+    struct restconf_h2_stream *hs;
+
+    if ((frame->hd.type != NGHTTP2_HEADERS && frame->hd.type != NGHTTP2_DATA) ||
+	(frame->hd.flags & NGHTTP2_FLAG_END_STREAM) == 0)
+	return 0;
+    if ((hs = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id)) == NULL)
+	return 0;
+    if (restconf_h2_request(hs) < 0)
+	return NGHTTP2_ERR_CALLBACK_FAILURE;
+    return 0;
+}
+
+/*! nghttp2 callback of closed stream, eg reply sent or cancelled by client
+ */
+static int
+restconf_h2_stream_close_cb(nghttp2_session *session,
+			    int32_t          stream_id,
+			    uint32_t         error_code,
+			    void            *user_data)
+{
+    struct restconf_h2_stream *hs;
+
+    if ((hs = nghttp2_session_get_stream_user_data(session, stream_id)) == NULL)
+	return 0;
+    nghttp2_session_set_stream_user_data(session, stream_id, NULL);
+    restconf_h2_stream_free(hs);
+    return 0;
+}
+
+/*! Check if data starts with the HTTP/2 client connection preface
+ *
+ * Used on cleartext connections where HTTP/2 is used with prior knowledge
+ * @param[in]  buf  Data first read on connection
+ * @param[in]  len  Length of buf
+ * @retval     1    HTTP/2 client preface
+ * @retval     0    Not HTTP/2, eg HTTP/1.1
+ */
+int
+restconf_http2_preface(const char *buf,
+		       size_t      len)
+{
+    return len >= NGHTTP2_CLIENT_MAGIC_LEN &&
+	memcmp(buf, NGHTTP2_CLIENT_MAGIC, NGHTTP2_CLIENT_MAGIC_LEN) == 0;
+}
+
+/*! Start HTTP/2 on connection, create nghttp2 server session and submit settings
+ *
+ * Frames are written by restconf_http2_send
+ * @param[in]  rc   Restconf connection
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+restconf_http2_start(restconf_conn *rc)
+{
+    int                        retval = -1;
+    struct restconf_h2        *h2;
+    nghttp2_session_callbacks *cbs = NULL;
+    nghttp2_settings_entry     iv[] = {
+	{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 100}
+    };
+
+    clicon_debug(1, "%s %d", __FUNCTION__, rc->rc_s);
+    if ((h2 = malloc(sizeof(*h2))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(h2, 0, sizeof(*h2));
+    h2->h2_rc = rc;
+    rc->rc_h2 = h2;
+    if (nghttp2_session_callbacks_new(&cbs) != 0){
+	clicon_err(OE_UNIX, ENOMEM, "nghttp2_session_callbacks_new");
+	goto done;
+    }
+    nghttp2_session_callbacks_set_on_begin_headers_callback(cbs, restconf_h2_begin_headers_cb);
+    nghttp2_session_callbacks_set_on_header_callback(cbs, restconf_h2_header_cb);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(cbs, restconf_h2_data_chunk_cb);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(cbs, restconf_h2_frame_recv_cb);
+    nghttp2_session_callbacks_set_on_stream_close_callback(cbs, restconf_h2_stream_close_cb);
+    if (nghttp2_session_server_new(&h2->h2_session, cbs, h2) != 0){
+	clicon_err(OE_UNIX, ENOMEM, "nghttp2_session_server_new");
+	goto done;
+    }
+    if (nghttp2_submit_settings(h2->h2_session, NGHTTP2_FLAG_NONE, iv, ARRLEN(iv)) != 0){
+	clicon_err(OE_PROTO, 0, "nghttp2_submit_settings");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cbs)
+	nghttp2_session_callbacks_del(cbs);
+    return retval;
+}
+
+/*! Write pending frames of HTTP/2 session, and close connection if session is done
+ *
+ * Frames are added to the evhtp output buffer and written by restconf_output_flush.
+ * The connection may be freed by this function.
+ * @param[in]  rc   Restconf connection
+ * @retval     1    All output written, connection open
+ * @retval     0    Output pending, or connection closed
+ * @retval    -1    Error
+ */
+int
+restconf_http2_send(restconf_conn *rc)
+{
+    int                 retval = -1;
+    nghttp2_session    *session = rc->rc_h2->h2_session;
+    evhtp_connection_t *conn = rc->rc_conn;
+    struct evbuffer    *out;
+    const uint8_t      *data;
+    ssize_t             n;
+
+    if (conn->bev == NULL || (out = bufferevent_get_output(conn->bev)) == NULL){
+	clicon_err(OE_RESTCONF, EFAULT, "No evhtp output buffer");
+	goto done;
+    }
+    while ((n = nghttp2_session_mem_send(session, &data)) > 0){
+	if (evbuffer_add(out, data, n) < 0){
+	    clicon_err(OE_UNIX, errno, "evbuffer_add");
+	    goto done;
+	}
+    }
+    if (n < 0){
+	clicon_debug(1, "%s nghttp2_session_mem_send: %s", __FUNCTION__, nghttp2_strerror(n));
+	rc->rc_close = 1;
+    }
+    else if (nghttp2_session_want_read(session) == 0 &&
+	     nghttp2_session_want_write(session) == 0){
+	clicon_debug(1, "%s session done", __FUNCTION__);
+	rc->rc_close = 1;
+    }
+    retval = restconf_output_flush(rc);
+ done:
+    return retval;
+}
+
+/*! Data read on HTTP/2 connection, give it to the session and write its frames
+ *
+ * Requests that end are served before this function returns.
+ * The connection may be freed by this function.
+ * @param[in]  rc   Restconf connection
+ * @param[in]  buf  Data read from socket
+ * @param[in]  len  Length of buf
+ * @retval     1    All output written, connection open
+ * @retval     0    Output pending, or connection closed
+ * @retval    -1    Error
+ */
+int
+restconf_http2_recv(restconf_conn *rc,
+		    const char    *buf,
+		    size_t         len)
+{
+    ssize_t ret;
+
+    if ((ret = nghttp2_session_mem_recv(rc->rc_h2->h2_session, (const uint8_t*)buf, len)) < 0){
+	clicon_debug(1, "%s nghttp2_session_mem_recv: %s", __FUNCTION__, nghttp2_strerror(ret));
+	rc->rc_close = 1;
+	return restconf_output_flush(rc);
+    }
+    return restconf_http2_send(rc);
+}
+
+/*! Free HTTP/2 session of connection, if any
+ * @param[in]  rc   Restconf connection
+ */
+int
+restconf_http2_free(restconf_conn *rc)
+{
+    struct restconf_h2 *h2;
+
+    if ((h2 = rc->rc_h2) == NULL)
+	return 0;
+    /* Streams are not closed by nghttp2_session_del */
+    while (h2->h2_streams)
+	restconf_h2_stream_free(h2->h2_streams);
+    if (h2->h2_session)
+	nghttp2_session_del(h2->h2_session);
+    free(h2);
+    rc->rc_h2 = NULL;
+    return 0;
+}
@@ -57,6 +57,9 @@
 #include <sys/time.h>
 #include <sys/wait.h>
 #include <arpa/inet.h>
+#ifdef HAVE_LIBCRYPTO
+#include <openssl/evp.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -249,7 +252,10 @@ restconf_terminate(clicon_handle h)
 	close(fs);
     clixon_plugin_exit_all(h);
     rpc_callback_delete_all(h);
+    clicon_rpc_session_pool_free(h);
     clicon_rpc_close_session(h);
+    restconf_get_cache_free(h);
+    restconf_auth_cache_free(h);
     if ((yspec = clicon_dbspec_yang(h)) != NULL)
 	ys_free(yspec);
     if ((yspec = clicon_config_yang(h)) != NULL)
@@ -259,6 +265,8 @@ restconf_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
 	xml_free(x);
     xpath_optimize_exit();
+    ctx_nodeset_pool_free();
+    xpath_cache_clear();
     restconf_handle_exit(h);
     clixon_err_exit();
     clicon_debug(1, "%s done", __FUNCTION__);
@@ -503,6 +511,258 @@ restconf_drop_privileges(clicon_handle h,
     return retval;
 }
 
+/*! Cache of authentication results, see CLICON_RESTCONF_AUTH_CACHE
+ * Kept in the clicon data hash as "restconf-auth-cache"
+ * Entries are keyed by a digest of the credentials of a request and expire after
+ * CLICON_RESTCONF_AUTH_CACHE_TTL seconds. All entries are of the same change token of
+ * running, if another token is seen, NACM or users in running may have changed and all
+ * entries are removed.
+ */
+struct restconf_auth_cache {
+    clicon_hash_t *ra_hash;  /* Entries, key: credential digest, value: restconf_auth_entry */
+    char          *ra_token; /* Change token of running of all entries */
+    uint32_t       ra_nr;    /* Nr of entries */
+};
+
+/*! Authentication cache entry, user name follows the struct */
+struct restconf_auth_entry {
+    time_t         ae_expire; /* Entry is not used after this time */
+    char           ae_user[]; /* Authenticated user */
+};
+
+/*! Get cache of authentication results, create it if enabled
+ * @param[in]  h   Clicon handle
+ * @retval     ra  Cache
+ * @retval     NULL Not enabled, or error
+ */
+static struct restconf_auth_cache *
+restconf_auth_cache_get(clicon_handle h)
+{
+    struct restconf_auth_cache *ra;
+    struct restconf_auth_cache  ra0 = {NULL, NULL, 0};
+
+    if ((ra = clicon_hash_value(clicon_data(h), "restconf-auth-cache", NULL)) != NULL)
+	return ra;
+    if (clicon_option_int(h, "CLICON_RESTCONF_AUTH_CACHE") <= 0 ||
+	clicon_option_int(h, "CLICON_RESTCONF_AUTH_CACHE_TTL") <= 0)
+	return NULL;
+    if ((ra0.ra_hash = clicon_hash_init()) == NULL)
+	return NULL;
+    if (clicon_hash_add(clicon_data(h), "restconf-auth-cache", &ra0, sizeof(ra0)) == NULL){
+	clicon_hash_free(ra0.ra_hash);
+	return NULL;
+    }
+    /* The hash stores a copy of ra0 */
+    return clicon_hash_value(clicon_data(h), "restconf-auth-cache", NULL);
+}
+
+/*! Remove all entries of the authentication cache
+ * @param[in]  ra     Cache
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+restconf_auth_cache_clear(struct restconf_auth_cache *ra)
+{
+    if (ra->ra_nr == 0)
+	return 0;
+    clicon_hash_free(ra->ra_hash);
+    ra->ra_nr = 0;
+    if ((ra->ra_hash = clicon_hash_init()) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Make the key of the credentials of a request in the authentication cache
+ *
+ * The credentials are the HTTP Authorization header and the client certificate.
+ * The key is a SHA-256 digest of the credentials if built with libcrypto, so that
+ * passwords are not kept in memory.
+ * @param[in]  h         Clicon handle
+ * @param[in]  auth_type Authentication type of restconf
+ * @param[out] key       Cache key
+ * @retval     1         OK
+ * @retval     0         No credentials in request, do not cache
+ * @retval    -1         Error
+ */
+static int
+restconf_auth_cache_key(clicon_handle      h,
+			clixon_auth_type_t auth_type,
+			cbuf              *key)
+{
+    int   retval = -1;
+    char *authz;
+    char *cn;
+    char *digest;
+    cbuf *cb = NULL;
+#ifdef HAVE_LIBCRYPTO
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int  mdlen = 0;
+    unsigned int  i;
+#endif
+
+    authz = restconf_param_get(h, "HTTP_AUTHORIZATION");
+    cn = restconf_param_get(h, "SSL_CN");
+    digest = restconf_param_get(h, "SSL_CERT_DIGEST");
+    if (authz == NULL && cn == NULL && digest == NULL)
+	goto fail;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%d\n%s\n%s\n%s", auth_type, authz?authz:"", cn?cn:"", digest?digest:"");
+#ifdef HAVE_LIBCRYPTO
+    if (EVP_Digest(cbuf_get(cb), cbuf_len(cb), md, &mdlen, EVP_sha256(), NULL) != 1){
+	clicon_err(OE_SSL, 0, "EVP_Digest");
+	goto done;
+    }
+    for (i=0; i<mdlen; i++)
+	cprintf(key, "%02x", md[i]);
+#else
+    cprintf(key, "%s", cbuf_get(cb));
+#endif
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Look up the user of the credentials of a request in the authentication cache
+ * @param[in]  h         Clicon handle
+ * @param[in]  auth_type Authentication type of restconf
+ * @param[out] key       Cache key, set if cache is enabled and request has credentials
+ * @param[out] token     Change token of running, free with free()
+ * @param[out] username  Authenticated user if found, free with free()
+ * @retval     1         Found
+ * @retval     0         Not found, or cache not enabled
+ * @retval    -1         Error
+ * @see restconf_auth_cache_add
+ */
+static int
+restconf_auth_cache_find(clicon_handle      h,
+			 clixon_auth_type_t auth_type,
+			 cbuf              *key,
+			 char             **token,
+			 char             **username)
+{
+    struct restconf_auth_cache *ra;
+    struct restconf_auth_entry *ae;
+    int                         ret;
+
+    if ((ra = restconf_auth_cache_get(h)) == NULL)
+	return 0;
+    if ((ret = restconf_auth_cache_key(h, auth_type, key)) <= 0)
+	return ret;
+    if (clicon_rpc_datastore_token(h, "running", token, NULL) < 0)
+	return -1;
+    if (ra->ra_token == NULL || strcmp(ra->ra_token, *token) != 0){
+	if (restconf_auth_cache_clear(ra) < 0)
+	    return -1;
+	return 0;
+    }
+    if ((ae = clicon_hash_value(ra->ra_hash, cbuf_get(key), NULL)) == NULL)
+	return 0;
+    if (ae->ae_expire <= time(NULL))
+	return 0;
+    if ((*username = strdup(ae->ae_user)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	return -1;
+    }
+    return 1;
+}
+
+/*! Add the authenticated user of the credentials of a request to the cache
+ * @param[in]  h         Clicon handle
+ * @param[in]  key       Cache key, see restconf_auth_cache_find
+ * @param[in]  token     Change token of running read before authentication
+ * @param[in]  username  Authenticated user
+ * @retval     0         OK, also if cache not enabled
+ * @retval    -1         Error
+ * When the cache is full, all entries are removed
+ * @see restconf_auth_cache_find
+ */
+static int
+restconf_auth_cache_add(clicon_handle h,
+			char         *key,
+			char         *token,
+			char         *username)
+{
+    int                         retval = -1;
+    struct restconf_auth_cache *ra;
+    struct restconf_auth_entry *ae = NULL;
+    size_t                      len;
+
+    if ((ra = restconf_auth_cache_get(h)) == NULL)
+	return 0;
+    if (ra->ra_token == NULL || strcmp(ra->ra_token, token) != 0){
+	if (restconf_auth_cache_clear(ra) < 0)
+	    goto done;
+	if (ra->ra_token)
+	    free(ra->ra_token);
+	if ((ra->ra_token = strdup(token)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+    }
+    if (ra->ra_nr >= clicon_option_int(h, "CLICON_RESTCONF_AUTH_CACHE"))
+	if (restconf_auth_cache_clear(ra) < 0)
+	    goto done;
+    len = sizeof(*ae) + strlen(username) + 1;
+    if ((ae = malloc(len)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    ae->ae_expire = time(NULL) + clicon_option_int(h, "CLICON_RESTCONF_AUTH_CACHE_TTL");
+    strcpy(ae->ae_user, username);
+    if (clicon_hash_lookup(ra->ra_hash, key) == NULL)
+	ra->ra_nr++;
+    if (clicon_hash_add(ra->ra_hash, key, ae, len) == NULL)
+	goto done;
+    retval = 0;
+ done:
+    if (ae)
+	free(ae);
+    return retval;
+}
+
+/*! Remove all entries of the authentication cache
+ *
+ * For plugins whose user database changes outside of running, eg at a password change.
+ * @param[in]  h      Clicon handle
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+restconf_auth_cache_flush(clicon_handle h)
+{
+    struct restconf_auth_cache *ra;
+
+    if ((ra = clicon_hash_value(clicon_data(h), "restconf-auth-cache", NULL)) == NULL)
+	return 0;
+    return restconf_auth_cache_clear(ra);
+}
+
+/*! Free the cache of authentication results
+ * @param[in]  h      Clicon handle
+ */
+void
+restconf_auth_cache_free(clicon_handle h)
+{
+    struct restconf_auth_cache *ra;
+
+    if ((ra = clicon_hash_value(clicon_data(h), "restconf-auth-cache", NULL)) == NULL)
+	return;
+    if (ra->ra_hash)
+	clicon_hash_free(ra->ra_hash);
+    if (ra->ra_token)
+	free(ra->ra_token);
+    clicon_hash_del(clicon_data(h), "restconf-auth-cache");
+}
+
 /*!
  * @param[in]  h    Clicon handle
  * @param[in]  req  Generic Www handle (can be part of clixon handle)
@@ -524,16 +784,30 @@ restconf_authentication_cb(clicon_handle  h,
     cxobj             *xret = NULL;
     cxobj             *xerr;
     char              *anonymous = NULL;
+    cbuf              *key = NULL;
+    char              *token = NULL;
     
     auth_type = restconf_auth_type_get(h);
     clicon_debug(1, "%s auth-type:%s", __FUNCTION__, clixon_auth_type_int2str(auth_type));
     ret = 0;
     authenticated = 0;
-    /* ret: -1 Error, 0: Ignore/not handled, 1: OK see authenticated parameter */
-    if ((ret = clixon_plugin_auth_all(h, req,
-				      auth_type,
-				      &username)) < 0)
+    if ((key = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    /* Credentials authenticated before and unchanged running, skip plugins */
+    if ((ret = restconf_auth_cache_find(h, auth_type, key, &token, &username)) < 0)
 	goto done;
+    if (ret == 0){
+	/* ret: -1 Error, 0: Ignore/not handled, 1: OK see authenticated parameter */
+	if ((ret = clixon_plugin_auth_all(h, req,
+					  auth_type,
+					  &username)) < 0)
+	    goto done;
+	if (ret == 1 && username != NULL && token != NULL)
+	    if (restconf_auth_cache_add(h, cbuf_get(key), token, username) < 0)
+		goto done;
+    }
     if (ret == 1){ /* OK, tag username to handle */
 	if (username != NULL){
 	    authenticated = 1;
@@ -575,6 +849,10 @@ restconf_authentication_cb(clicon_handle  h,
 	retval = 0;
 	goto notauth;
     }
+    /* Use backend session of user, see CLICON_RESTCONF_BACKEND_SESSIONS */
+    if (clicon_rpc_session_select(h, clicon_username_get(h),
+				  clicon_option_int(h, "CLICON_RESTCONF_BACKEND_SESSIONS")) < 0)
+	goto done;
     /* If set but no user, set a dummy user */
     retval = 1;
  done:
@@ -582,6 +860,10 @@ restconf_authentication_cb(clicon_handle  h,
 		 __FUNCTION__, retval, authenticated, clicon_username_get(h));
     if (username)
 	free(username);
+    if (token)
+	free(token);
+    if (key)
+	cbuf_free(key);
     if (xret)
 	xml_free(xret);
     return retval;
@@ -809,3 +1091,253 @@ restconf_socket_extract(clicon_handle h,
 	free(reason);
     return retval;
 }
+
+/*! Cache of encoded GET replies, see CLICON_RESTCONF_GET_CACHE
+ * Kept in the clicon data hash as "restconf-get-cache"
+ * All entries are of the same change token of running, if another token is seen, the
+ * running datastore has changed and all entries are removed.
+ */
+struct restconf_get_cache {
+    clicon_hash_t *rc_hash;  /* Encoded reply bodies, key: user, api-path, query, media */
+    char          *rc_token; /* Change token of running of all entries */
+    uint32_t       rc_nr;    /* Nr of entries */
+};
+
+/*! Get cache of GET replies, create it if enabled
+ * @param[in]  h   Clicon handle
+ * @retval     rc  Cache
+ * @retval     NULL Not enabled, or error
+ */
+static struct restconf_get_cache *
+restconf_get_cache_get(clicon_handle h)
+{
+    struct restconf_get_cache *rc;
+    struct restconf_get_cache  rc0 = {NULL, NULL, 0};
+
+    if ((rc = clicon_hash_value(clicon_data(h), "restconf-get-cache", NULL)) != NULL)
+	return rc;
+    if (clicon_option_int(h, "CLICON_RESTCONF_GET_CACHE") <= 0)
+	return NULL;
+    if ((rc0.rc_hash = clicon_hash_init()) == NULL)
+	return NULL;
+    if (clicon_hash_add(clicon_data(h), "restconf-get-cache", &rc0, sizeof(rc0)) == NULL){
+	clicon_hash_free(rc0.rc_hash);
+	return NULL;
+    }
+    /* The hash stores a copy of rc0 */
+    return clicon_hash_value(clicon_data(h), "restconf-get-cache", NULL);
+}
+
+/*! Remove all entries of the GET cache if they are not of a change token
+ * @param[in]  rc     Cache
+ * @param[in]  token  Current change token of running
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+restconf_get_cache_token(struct restconf_get_cache *rc,
+			 char                      *token)
+{
+    if (rc->rc_token && strcmp(rc->rc_token, token) == 0)
+	return 0;
+    if (rc->rc_nr){
+	clicon_hash_free(rc->rc_hash);
+	rc->rc_nr = 0;
+	if ((rc->rc_hash = clicon_hash_init()) == NULL)
+	    return -1;
+    }
+    if (rc->rc_token)
+	free(rc->rc_token);
+    if ((rc->rc_token = strdup(token)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	return -1;
+    }
+    return 0;
+}
+
+/*! Look up an encoded GET reply in the cache
+ * @param[in]  h      Clicon handle
+ * @param[in]  key    Cache key, eg user, api-path, query and media of request
+ * @param[in]  token  Current change token of running, see clicon_rpc_datastore_token
+ * @param[out] cb     Reply body is appended if found
+ * @retval     1      Found
+ * @retval     0      Not found, or cache not enabled
+ * @retval    -1      Error
+ * @see restconf_get_cache_add
+ */
+int
+restconf_get_cache_find(clicon_handle h,
+			char         *key,
+			char         *token,
+			cbuf         *cb)
+{
+    struct restconf_get_cache *rc;
+    char                      *body;
+
+    if ((rc = restconf_get_cache_get(h)) == NULL)
+	return 0;
+    if (restconf_get_cache_token(rc, token) < 0)
+	return -1;
+    if ((body = clicon_hash_value(rc->rc_hash, key, NULL)) == NULL)
+	return 0;
+    cprintf(cb, "%s", body);
+    return 1;
+}
+
+/*! Add an encoded GET reply to the cache
+ * @param[in]  h      Clicon handle
+ * @param[in]  key    Cache key, eg user, api-path, query and media of request
+ * @param[in]  token  Change token of running when the reply was read
+ * @param[in]  body   Encoded reply body
+ * @retval     0      OK, also if cache not enabled
+ * @retval    -1      Error
+ * When the cache is full, all entries are removed
+ * @see restconf_get_cache_find
+ */
+int
+restconf_get_cache_add(clicon_handle h,
+		       char         *key,
+		       char         *token,
+		       char         *body)
+{
+    struct restconf_get_cache *rc;
+
+    if ((rc = restconf_get_cache_get(h)) == NULL)
+	return 0;
+    if (restconf_get_cache_token(rc, token) < 0)
+	return -1;
+    if (rc->rc_nr >= clicon_option_int(h, "CLICON_RESTCONF_GET_CACHE")){
+	clicon_hash_free(rc->rc_hash);
+	rc->rc_nr = 0;
+	if ((rc->rc_hash = clicon_hash_init()) == NULL)
+	    return -1;
+    }
+    if (clicon_hash_lookup(rc->rc_hash, key) == NULL)
+	rc->rc_nr++;
+    if (clicon_hash_add(rc->rc_hash, key, body, strlen(body)+1) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Free the cache of GET replies
+ * @param[in]  h      Clicon handle
+ */
+void
+restconf_get_cache_free(clicon_handle h)
+{
+    struct restconf_get_cache *rc;
+
+    if ((rc = clicon_hash_value(clicon_data(h), "restconf-get-cache", NULL)) == NULL)
+	return;
+    if (rc->rc_hash)
+	clicon_hash_free(rc->rc_hash);
+    if (rc->rc_token)
+	free(rc->rc_token);
+    clicon_hash_del(clicon_data(h), "restconf-get-cache");
+}
+
+/* Placeholder of the original request body when printing edit-config, see
+ * restconf_edit_body_xml */
+#define RESTCONF_BODY_MARK "clixon-restconf-body"
+
+/*! Check if the original XML request body can be forwarded to the backend as is
+ * @param[in]  media_in  Media of request body
+ * @param[in]  xdata     Parsed top element of body
+ * @param[in]  qvec      Vector of query string (QUERY_STRING)
+ * @retval     1         Yes, see restconf_edit_body_xml
+ * @retval     0         No, the body must be serialized from xdata
+ * Not if the body is JSON, or if insert and point attributes are added to xdata, or if
+ * the added attributes may conflict with attributes of the body.
+ */
+int
+restconf_edit_body_forward(restconf_media media_in,
+			   cxobj         *xdata,
+			   cvec          *qvec)
+{
+    if (media_in != YANG_DATA_XML)
+	return 0;
+    if (cvec_find(qvec, "insert") != NULL || cvec_find(qvec, "point") != NULL)
+	return 0;
+    if (xml_find_type(xdata, NULL, "operation", CX_ATTR) != NULL ||
+	xml_find_type(xdata, NULL, "objectcreate", CX_ATTR) != NULL ||
+	xml_find_type(xdata, "xmlns", NETCONF_BASE_PREFIX, CX_ATTR) != NULL)
+	return 0;
+    return 1;
+}
+
+/*! Print an edit-config tree with the original XML request body instead of its data
+ *
+ * The tree of the api-path is printed, with the original body text in place of the
+ * parsed data, so that the body is not serialized again. The parsed data is freed
+ * before the tree is printed, the body text is expected to be valid since it is parsed.
+ * @param[in]  cb     Output buffer
+ * @param[in]  xtop   Top of edit-config tree <config>
+ * @param[in]  xdata  Parsed top element of body in xtop, is freed
+ * @param[in]  data   Original XML body
+ * @param[in]  attrs  Attributes added to the top element of body, eg " nc:operation=\"create\""
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see restconf_edit_body_forward  Check if the body can be forwarded
+ */
+int
+restconf_edit_body_xml(cbuf  *cb,
+		       cxobj *xtop,
+		       cxobj *xdata,
+		       char  *data,
+		       char  *attrs)
+{
+    int    retval = -1;
+    cxobj *xp;
+    cxobj *xm;
+    cbuf  *cbt = NULL;
+    char  *mark;
+    char  *p;
+    char  *q;
+    int    ret;
+
+    xp = xml_parent(xdata);
+    if (xml_purge(xdata) < 0)
+	goto done;
+    if ((xm = xml_new(RESTCONF_BODY_MARK, xp, CX_ELMNT)) == NULL)
+	goto done;
+    if ((cbt = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    ret = clicon_xml2cbuf(cbt, xtop, 0, 0, -1);
+    if (xml_purge(xm) < 0 || ret < 0)
+	goto done;
+    /* Bodies and key values are escaped, so the mark element is unique */
+    if ((mark = strstr(cbuf_get(cbt), "<" RESTCONF_BODY_MARK "/>")) == NULL){
+	clicon_err(OE_XML, EFAULT, "Body mark not found (internal error)");
+	goto done;
+    }
+    cbuf_append_buf(cb, cbuf_get(cbt), mark - cbuf_get(cbt));
+    /* Skip prolog: white space, xml declaration and comments before top element */
+    p = data;
+    while (*p){
+	if (isspace(*p))
+	    p++;
+	else if (strncmp(p, "<?", 2) == 0 && (q = strstr(p, "?>")) != NULL)
+	    p = q + 2;
+	else if (strncmp(p, "<!--", 4) == 0 && (q = strstr(p, "-->")) != NULL)
+	    p = q + 3;
+	else
+	    break;
+    }
+    if (*p != '<'){
+	clicon_err(OE_XML, EINVAL, "No top element in body");
+	goto done;
+    }
+    /* Add attributes after name of top element */
+    for (q = p+1; *q && !isspace(*q) && *q != '/' && *q != '>'; q++);
+    cbuf_append_buf(cb, p, q - p);
+    cbuf_append_str(cb, attrs);
+    cbuf_append_str(cb, q);
+    cbuf_append_str(cb, mark + strlen("<" RESTCONF_BODY_MARK "/>"));
+    retval = 0;
+ done:
+    if (cbt)
+	cbuf_free(cbt);
+    return retval;
+}
@@ -82,10 +82,17 @@ int   restconf_insert_attributes(cxobj *xdata, cvec *qvec);
 int   restconf_main_extension_cb(clicon_handle h, yang_stmt *yext, yang_stmt *ys);
 char *restconf_uripath(clicon_handle h);
 int   restconf_drop_privileges(clicon_handle h, char *user);
+int   restconf_auth_cache_flush(clicon_handle h);
+void  restconf_auth_cache_free(clicon_handle h);
 int   restconf_authentication_cb(clicon_handle h, void *req, int pretty, restconf_media media_out);
 int   restconf_config_init(clicon_handle h, cxobj *xrestconf);
 int   restconf_socket_init(const char *netns0, const char *addr, const char *addrtype, uint16_t port, int backlog, int flags, int *ss);
 int   restconf_socket_extract(clicon_handle h, cxobj *xs, cvec *nsc, char **namespace, char **address, char **addrtype, uint16_t *port, uint16_t *ssl);
+int   restconf_get_cache_find(clicon_handle h, char *key, char *token, cbuf *cb);
+int   restconf_get_cache_add(clicon_handle h, char *key, char *token, char *body);
+void  restconf_get_cache_free(clicon_handle h);
+int   restconf_edit_body_forward(restconf_media media_in, cxobj *xdata, cvec *qvec);
+int   restconf_edit_body_xml(cbuf *cb, cxobj *xtop, cxobj *xdata, char *data, char *attrs);
 
 #endif /* _RESTCONF_LIB_H_ */
 
@@ -128,18 +128,27 @@ fcgi_params_set(clicon_handle h,
 /* Need global variable to for signal handler XXX */
 static clicon_handle _CLICON_HANDLE = NULL;
 
+/* Worker processes of parent if CLICON_RESTCONF_FCGI_WORKERS > 1, see fcgi_workers_run */
+static pid_t *_FCGI_WORKERS = NULL;
+static int    _FCGI_NWORKERS = 0;
+
 /*! Signall terminates process
  */
 static void
 restconf_sig_term(int arg)
 {
     static int i=0;
+    int        w;
 
     if (i++ == 0)
 	clicon_log(LOG_NOTICE, "%s: %s: pid: %u Signal %d", 
 		   __PROGRAM__, __FUNCTION__, getpid(), arg);
     else
 	exit(-1);
+    /* Parent of workers: terminate workers */
+    for (w=0; w<_FCGI_NWORKERS; w++)
+	if (_FCGI_WORKERS[w] > 0)
+	    kill(_FCGI_WORKERS[w], SIGTERM);
     if (_CLICON_HANDLE){
 	stream_child_freeall(_CLICON_HANDLE);
 	restconf_terminate(_CLICON_HANDLE);
@@ -162,6 +171,107 @@ restconf_sig_child(int arg)
 	stream_child_free(_CLICON_HANDLE, pid);
 }
 
+/*! Fork a fastcgi worker process
+ * The worker has its own backend session, the session of the parent is not used.
+ * @param[in]  h    Clicon handle
+ * @retval     pid  Parent: process id of worker
+ * @retval     0    Worker
+ * @retval    -1    Error
+ */
+static pid_t
+fcgi_worker_fork(clicon_handle h)
+{
+    pid_t pid;
+    int   s;
+
+    if ((pid = fork()) < 0){
+	clicon_err(OE_UNIX, errno, "fork");
+	return -1;
+    }
+    if (pid == 0){ /* Worker */
+	_FCGI_NWORKERS = 0;
+	if ((s = clicon_client_socket_get(h)) >= 0){
+	    close(s);
+	    clicon_client_socket_set(h, -1);
+	}
+	/* New session made by hello on first rpc, see session_id_check */
+	clicon_data_del(h, "session-id");
+	if (set_signal(SIGCHLD, restconf_sig_child, NULL) < 0){
+	    clicon_err(OE_DAEMON, errno, "Setting signal");
+	    return -1;
+	}
+	clicon_log(LOG_NOTICE, "%s fcgi: %u Worker started", __PROGRAM__, getpid());
+    }
+    return pid;
+}
+
+/*! Run fastcgi requests in several worker processes sharing the fastcgi socket
+ *
+ * The parent forks the workers and restarts a worker if it exits. It does not return
+ * unless there is an error, it is terminated by a signal which also terminates
+ * the workers, see restconf_sig_term.
+ * Each worker returns and handles requests as a single restconf process. Several
+ * requests are then handled concurrently, and a slow request does not stall the
+ * others.
+ * @param[in]  h    Clicon handle
+ * @param[in]  nw   Number of workers, see CLICON_RESTCONF_FCGI_WORKERS
+ * @retval     0    Worker: handle requests
+ * @retval    -1    Error
+ */
+static int
+fcgi_workers_run(clicon_handle h,
+		 int           nw)
+{
+    int   retval = -1;
+    pid_t pid;
+    int   status;
+    int   w;
+
+    /* Streams are forked by workers, the parent only waits for its workers */
+    if (set_signal(SIGCHLD, SIG_DFL, NULL) < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
+    if ((_FCGI_WORKERS = calloc(nw, sizeof(pid_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    _FCGI_NWORKERS = nw;
+    for (w=0; w<nw; w++){
+	if ((pid = fcgi_worker_fork(h)) < 0)
+	    goto done;
+	if (pid == 0)
+	    goto worker;
+	_FCGI_WORKERS[w] = pid;
+    }
+    while (1){
+	if ((pid = waitpid(-1, &status, 0)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "waitpid");
+	    goto done;
+	}
+	for (w=0; w<nw; w++)
+	    if (_FCGI_WORKERS[w] == pid)
+		break;
+	if (w == nw)
+	    continue;
+	clicon_log(LOG_WARNING, "%s fcgi: worker %u exited with status %d, restarting",
+		   __PROGRAM__, pid, status);
+	_FCGI_WORKERS[w] = 0;
+	sleep(1); /* Avoid busy loop if worker fails on start */
+	if ((pid = fcgi_worker_fork(h)) < 0)
+	    goto done;
+	if (pid == 0)
+	    goto worker;
+	_FCGI_WORKERS[w] = pid;
+    }
+ worker:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Usage help routine
  * @param[in]  argv0  command line
  * @param[in]  h      Clicon handle
@@ -226,6 +336,7 @@ main(int    argc,
     cvec          *nsc = NULL;
     cxobj         *xerr = NULL;
     struct passwd *pw;
+    int            nw;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__PROGRAM__, LOG_INFO, logdst); 
@@ -402,6 +513,9 @@ main(int    argc,
     /* Load yang restconf module */
     if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
 	goto done;
+    /* Load yang patch module, RFC8072 */
+    if (yang_spec_parse_module(h, "ietf-yang-patch", NULL, yspec)< 0)
+	goto done;
     
     /* Add netconf yang spec, used as internal protocol */
     if (netconf_module_load(h) < 0)
@@ -515,6 +629,10 @@ main(int    argc,
 	if (restconf_drop_privileges(h, WWWUSER) < 0)
 	    goto done;
     }
+    /* Several worker processes accepting requests on the socket */
+    nw = clicon_option_int(h, "CLICON_RESTCONF_FCGI_WORKERS");
+    if (nw > 1 && fcgi_workers_run(h, nw) < 0)
+	goto done;
     if (FCGX_InitRequest(req, sock, 0) != 0){
 	clicon_err(OE_CFG, errno, "FCGX_InitRequest");
 	goto done;
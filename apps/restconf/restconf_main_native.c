@@ -130,12 +130,16 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <pwd.h>
 #include <ctype.h>
 #include <assert.h>
 #include <signal.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 
@@ -143,6 +147,10 @@
 #include <openssl/rand.h>
 #include <openssl/err.h>
 #include <openssl/x509v3.h>
+#include <openssl/hmac.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -164,10 +172,14 @@
 #include "restconf_api.h"       /* generic not shared with plugins */
 #include "restconf_err.h"
 #include "restconf_root.h"
+#include "restconf_stream.h"
 #include "restconf_openssl.h"   /* Restconf-openssl mode specific headers*/
+#ifdef CLIXON_RESTCONF_HTTP2
+#include "restconf_http2.h"
+#endif
 
 /* Command line options to be passed to getopt(3) */
-#define RESTCONF_OPTS "hD:f:E:l:p:y:a:u:ro:"
+#define RESTCONF_OPTS "hD:f:E:l:p:y:a:u:ro:W"
 
 /* If set, open outwards socket non-blocking, as opposed to blocking
  * Should work both ways, but in the ninblocking case,
@@ -184,8 +196,22 @@
 /* Cert verify depth: dont know what to set here? */
 #define VERIFY_DEPTH 5
 
+/* Default TLS session timeout in seconds, same as openssl default, see tls-session-timeout */
+#define TLS_SESSION_TIMEOUT_DEFAULT 300
+
+/* Default TLS ticket key rotation in seconds, see tls-ticket-key-rotation */
+#define TLS_TICKET_ROTATE_DEFAULT 3600
+
+/* HMAC context of session ticket key callback, changed in openssl 3.0 */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#define RESTCONF_TICKET_HMAC_CTX EVP_MAC_CTX
+#else
+#define RESTCONF_TICKET_HMAC_CTX HMAC_CTX
+#endif
+
 /* Forward */
 static int restconf_connection(int s, void* arg);
+static int restconf_connection_write(int s, void* arg);
 
 /*! Get restconf openssl global handle
  * @param[in]  h     Clicon handle
@@ -473,6 +499,11 @@ evhtp_params_set(clicon_handle    h,
     char         *subject = NULL;
     cvec         *cvv = NULL;
     char         *cn;
+    X509         *peer = NULL;
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int  mdlen = 0;
+    unsigned int  i;
+    char          digest[2*EVP_MAX_MD_SIZE+1] = {0,};
 
     if ((uri = req->uri) == NULL){
 	clicon_err(OE_DAEMON, EFAULT, "No uri");
@@ -517,6 +548,15 @@ evhtp_params_set(clicon_handle    h,
 		    goto done;
 	    }
 	}
+	/* Client certificate fingerprint, eg for the authentication cache */
+	if ((peer = SSL_get_peer_certificate(ssl)) != NULL){
+	    if (X509_digest(peer, EVP_sha256(), md, &mdlen) == 1){
+		for (i=0; i<mdlen; i++)
+		    snprintf(&digest[2*i], 3, "%02x", md[i]);
+		if (restconf_param_set(h, "SSL_CERT_DIGEST", digest) < 0)
+		    goto done;
+	    }
+	}
     }
 
     /* Translate all http headers by capitalizing, prepend w HTTP_ and - -> _
@@ -531,12 +571,55 @@ evhtp_params_set(clicon_handle    h,
 	free(subject);
     if (cvv)
 	cvec_free(cvv);
+    if (peer)
+	X509_free(peer);
     return retval;
  fail:
     retval = 0;
     goto done;
 }
 
+/*! Find restconf connection of an evhtp connection
+ * @param[in]  h     Clicon handle
+ * @param[in]  conn  Evhtp connection
+ * @retval     rc    Restconf connection
+ * @retval     NULL  Not found
+ */
+restconf_conn *
+restconf_conn_find(clicon_handle       h,
+		   evhtp_connection_t *conn)
+{
+    restconf_handle *rh;
+    restconf_conn   *rc;
+
+    if ((rh = restconf_handle_get(h)) == NULL ||
+	(rc = rh->rh_conns) == NULL)
+	return NULL;
+    do {
+	if (rc->rc_conn == conn)
+	    return rc;
+	rc = NEXTQ(restconf_conn *, rc);
+    } while (rc && rc != rh->rh_conns);
+    return NULL;
+}
+
+/*! Mark connection to be closed after reply unless the request keeps it alive
+ * Evhtp sets keep-alive for HTTP/1.1 unless "Connection: close", and for
+ * HTTP/1.0 with "Connection: keep-alive"
+ * @param[in] h    Clicon handle
+ * @param[in] req  evhtp http request structure defining the incoming message
+ */
+static void
+restconf_keepalive_set(clicon_handle    h,
+		       evhtp_request_t *req)
+{
+    restconf_conn *rc;
+
+    if ((req->flags & EVHTP_REQ_FLAG_KEEPALIVE) == 0 &&
+	(rc = restconf_conn_find(h, req->conn)) != NULL)
+	rc->rc_close = 1;
+}
+
 /*! Callback for each incoming http request for path /
  *
  * This are all messages except /.well-known, Registered with evhtp_set_cb
@@ -568,6 +651,7 @@ restconf_path_root(evhtp_request_t *req,
 	clicon_err(OE_RESTCONF, EINVAL, "req->conn is NULL");
 	goto done;
     }
+    restconf_keepalive_set(h, req);
     /* input debug */
     if (clicon_debug_get())
 	evhtp_headers_for_each(req->headers_in, print_header, h);
@@ -602,6 +686,62 @@ restconf_path_root(evhtp_request_t *req,
     return; /* void */
 }
 
+/*! Callback for each incoming http request for the stream path, eg /streams
+ *
+ * Registered with evhtp_set_cb using CLICON_STREAM_PATH
+ *
+ * @param[in] req  evhtp http request structure defining the incoming message
+ * @param[in] arg  cx_evhtp handle clixon specific fields
+ * @retval    void
+ * @see api_stream  The stream reply is kept open and written from the event loop
+ */
+static void
+restconf_path_stream(evhtp_request_t *req,
+		     void            *arg)
+{
+    int                 retval = -1;
+    clicon_handle       h;
+    int                 ret;
+    int                 finish = 1;
+    cvec               *qvec = NULL;
+
+    clicon_debug(1, "------------");
+    if ((h = (clicon_handle)arg) == NULL){
+	clicon_err(OE_RESTCONF, EINVAL, "arg is NULL");
+	goto done;
+    }
+    if (req->conn == NULL){
+	clicon_err(OE_RESTCONF, EINVAL, "req->conn is NULL");
+	goto done;
+    }
+    restconf_keepalive_set(h, req);
+    if (clicon_debug_get())
+	evhtp_headers_for_each(req->headers_in, print_header, h);
+    if ((qvec = cvec_new(0)) ==NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if ((ret = evhtp_params_set(h, req, qvec)) < 0)
+	goto done;
+    if (ret == 1){
+	if (api_stream(h, req, qvec, clicon_option_str(h, "CLICON_STREAM_PATH"), &finish) < 0)
+	    goto done;   
+    }
+    /* Clear (fcgi) paramaters from this request */
+    if (restconf_param_del_all(h) < 0)
+	goto done;
+    retval = 0;
+ done:
+    clicon_debug(1, "%s %d", __FUNCTION__, retval);
+    /* Catch all on fatal error. This does not terminate the process but closes request stream */
+    if (retval < 0){
+	evhtp_send_reply(req, EVHTP_RES_ERROR);
+    }
+    if (qvec)
+	cvec_free(qvec);
+    return; /* void */
+}
+
 /*! /.well-known callback
  *
  * @param[in] req  evhtp http request structure defining the incoming message
@@ -626,6 +766,7 @@ restconf_path_wellknown(evhtp_request_t *req,
 	clicon_err(OE_RESTCONF, EINVAL, "req->conn is NULL");
 	goto done;
     }
+    restconf_keepalive_set(h, req);
     /* input debug */
     if (clicon_debug_get())
 	evhtp_headers_for_each(req->headers_in, print_header, h);
@@ -720,7 +861,167 @@ restconf_verify_certs(int                     preverify_ok,
 }
 
 static int             session_id_context = 1;
+
+/*! ALPN callback: select application protocol among those offered by the client
+ *
+ * Clients such as curl and gRPC-style collectors offer "h2" and "http/1.1" and use
+ * the one selected by the server. If built with --enable-http2, "h2" is selected if
+ * offered, and requests are multiplexed on the connection, see restconf_http2.c.
+ * Otherwise "http/1.1" is selected, where keep-alive and pipelining still let many
+ * requests share one TLS session. If no offered protocol is supported, the handshake
+ * continues without ALPN, rather than being aborted.
+ * @param[in]  ssl     SSL connection
+ * @param[out] out     Selected protocol, pointer into in
+ * @param[out] outlen  Length of selected protocol
+ * @param[in]  in      Client protocols in wire format: length-prefixed strings
+ * @param[in]  inlen   Length of in
+ * @param[in]  arg     Not used
+ * @see restconf_ssl_context_create where this callback is registered
+ */
+static int
+restconf_alpn_select_cb(SSL                  *ssl,
+			const unsigned char **out,
+			unsigned char        *outlen,
+			const unsigned char  *in,
+			unsigned int          inlen,
+			void                 *arg)
+{
+    const unsigned char *p = in;
+    unsigned int         len;
+    const unsigned char *h1 = NULL;
+
+    while (p < in + inlen){
+	len = *p++;
+	if (p + len > in + inlen)
+	    break;
+	clicon_debug(1, "%s client offers: %.*s", __FUNCTION__, (int)len, p);
+#ifdef CLIXON_RESTCONF_HTTP2
+	if (len == strlen("h2") && memcmp(p, "h2", len) == 0){
+	    *out = p;
+	    *outlen = len;
+	    return SSL_TLSEXT_ERR_OK;
+	}
+#endif
+	if (len == strlen("http/1.1") && memcmp(p, "http/1.1", len) == 0)
+	    h1 = p;
+	p += len;
+    }
+    if (h1 == NULL)
+	return SSL_TLSEXT_ERR_NOACK;
+    *out = h1;
+    *outlen = strlen("http/1.1");
+    return SSL_TLSEXT_ERR_OK;
+}
  
+/*! Create a new session ticket key, the current key is kept as previous key
+ * @param[in]  rh   Restconf handle
+ * @param[in]  now  Current time
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+restconf_ticket_key_rotate(restconf_handle *rh,
+			   time_t           now)
+{
+    restconf_ticket_key *tk = &rh->rh_tickets[0];
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    rh->rh_tickets[1] = *tk;
+    if (RAND_bytes(tk->tk_name, sizeof(tk->tk_name)) != 1 ||
+	RAND_bytes(tk->tk_aes, sizeof(tk->tk_aes)) != 1 ||
+	RAND_bytes(tk->tk_hmac, sizeof(tk->tk_hmac)) != 1){
+	clicon_err(OE_SSL, 0, "RAND_bytes");
+	return -1;
+    }
+    tk->tk_created = now;
+    return 0;
+}
+
+/*! Initialize HMAC-SHA256 of a session ticket with a ticket key
+ * @param[in]  hctx  HMAC context
+ * @param[in]  tk    Ticket key
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+restconf_ticket_hmac_init(RESTCONF_TICKET_HMAC_CTX *hctx,
+			  restconf_ticket_key      *tk)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM params[2];
+
+    params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA256", 0);
+    params[1] = OSSL_PARAM_construct_end();
+    if (EVP_MAC_CTX_set_params(hctx, params) != 1 ||
+	EVP_MAC_init(hctx, tk->tk_hmac, sizeof(tk->tk_hmac), NULL) != 1)
+	return -1;
+#else
+    if (HMAC_Init_ex(hctx, tk->tk_hmac, sizeof(tk->tk_hmac), EVP_sha256(), NULL) != 1)
+	return -1;
+#endif
+    return 0;
+}
+
+/*! Session ticket key callback: encrypt new tickets, and decrypt tickets from clients
+ *
+ * New tickets are encrypted with the current key, which is replaced every rotation
+ * interval. Tickets encrypted with the previous key are accepted and renewed. Tickets
+ * with unknown keys give a full handshake.
+ * @param[in]     ssl   SSL connection
+ * @param[in,out] name  Key name: set if enc, otherwise from ticket
+ * @param[in,out] iv    IV: set if enc, otherwise from ticket
+ * @param[in]     ectx  Cipher context to initialize
+ * @param[in]     hctx  HMAC context to initialize
+ * @param[in]     enc   1: encrypt new ticket, 0: decrypt ticket
+ * @retval        2     Ticket decrypted with previous key, renew it
+ * @retval        1     OK
+ * @retval        0     Ticket key not found, make full handshake
+ * @retval       -1     Error
+ * @see restconf_ssl_context_configure where this callback is registered
+ */
+static int
+restconf_ticket_key_cb(SSL                      *ssl,
+		       unsigned char            *name,
+		       unsigned char            *iv,
+		       EVP_CIPHER_CTX           *ectx,
+		       RESTCONF_TICKET_HMAC_CTX *hctx,
+		       int                       enc)
+{
+    clicon_handle        h;
+    restconf_handle     *rh;
+    restconf_ticket_key *tk;
+    time_t               now = time(NULL);
+    int                  i;
+
+    if ((h = SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl))) == NULL ||
+	(rh = restconf_handle_get(h)) == NULL)
+	return -1;
+    tk = &rh->rh_tickets[0];
+    if (tk->tk_created == 0 || now - tk->tk_created >= rh->rh_ticket_rotate)
+	if (restconf_ticket_key_rotate(rh, now) < 0)
+	    return -1;
+    if (enc){
+	if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1)
+	    return -1;
+	memcpy(name, tk->tk_name, sizeof(tk->tk_name));
+	if (EVP_EncryptInit_ex(ectx, EVP_aes_256_cbc(), NULL, tk->tk_aes, iv) != 1 ||
+	    restconf_ticket_hmac_init(hctx, tk) < 0)
+	    return -1;
+	return 1;
+    }
+    for (i=0; i<2; i++){
+	tk = &rh->rh_tickets[i];
+	if (tk->tk_created && memcmp(name, tk->tk_name, sizeof(tk->tk_name)) == 0)
+	    break;
+    }
+    if (i == 2)
+	return 0;
+    if (restconf_ticket_hmac_init(hctx, tk) < 0 ||
+	EVP_DecryptInit_ex(ectx, EVP_aes_256_cbc(), NULL, tk->tk_aes, iv) != 1)
+	return -1;
+    return i==0?1:2;
+}
+
 /*
  * see restconf_config ->cv_evhtp_init(x2) -> cx_evhtp_socket -> 
  * evhtp_ssl_init:4794
@@ -747,6 +1048,7 @@ restconf_ssl_context_create(clicon_handle h)
 
     SSL_CTX_set_options(ctx, SSL_MODE_RELEASE_BUFFERS | SSL_OP_NO_COMPRESSION);
     //    SSL_CTX_set_timeout(ctx, cfg->ssl_ctx_timeout); /* default 300s */
+    SSL_CTX_set_alpn_select_cb(ctx, restconf_alpn_select_cb, NULL);
  done:
     return ctx;
 }
@@ -758,6 +1060,8 @@ restconf_ssl_context_create(clicon_handle h)
  * @param[in]  server_cert_path    Server cert
  * @param[in]  server_key_path     Server private key
  * @param[in]  server_ca_cert_path CA cert Only if auth-type = client cert
+ * @param[in]  session_timeout     TLS session timeout in seconds, 0: no session resumption
+ * @param[in]  ticket_rotate       Session ticket key rotation in seconds, 0: no tickets
  * @see restconf_ssl_context_create
  */
 static int
@@ -765,9 +1069,12 @@ restconf_ssl_context_configure(clixon_handle h,
 			       SSL_CTX      *ctx,
 			       const char   *server_cert_path,
 			       const char   *server_key_path,
-			       const char   *server_ca_cert_path)
+			       const char   *server_ca_cert_path,
+			       uint32_t      session_timeout,
+			       uint32_t      ticket_rotate)
 {
-    int retval = -1;
+    int              retval = -1;
+    restconf_handle *rh;
 
     SSL_CTX_set_ecdh_auto(ctx, 1);
 
@@ -792,7 +1099,29 @@ restconf_ssl_context_configure(clixon_handle h,
 
     SSL_CTX_set_session_id_context(ctx, (void *)&session_id_context, sizeof(session_id_context));
     SSL_CTX_set_app_data(ctx, h);
-    SSL_CTX_set_session_cache_mode(ctx, 0);
+    if (session_timeout == 0){ /* Full handshake on every connection */
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+	SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    }
+    else {
+	/* Resume sessions from server cache (session-id) or from tickets */
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+	SSL_CTX_set_timeout(ctx, session_timeout);
+	if (ticket_rotate == 0)
+	    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+	else {
+	    if ((rh = restconf_handle_get(h)) == NULL){
+		clicon_err(OE_XML, EFAULT, "No openssl handle");
+		goto done;
+	    }
+	    rh->rh_ticket_rotate = ticket_rotate;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, restconf_ticket_key_cb);
+#else
+	    SSL_CTX_set_tlsext_ticket_key_cb(ctx, restconf_ticket_key_cb);
+#endif
+	}
+    }
 
     /* Set the key and cert */
     if (SSL_CTX_use_certificate_chain_file(ctx, server_cert_path) != 1) {
@@ -866,10 +1195,157 @@ send_badrequest(clicon_handle       h,
     return retval;
 }
 
+/*! Close restconf connection and free it
+ * @param[in]  rc        Restconf connection
+ * @param[in]  shutdown  If set, shutdown SSL connection
+ */
+static int
+restconf_conn_close(restconf_conn *rc,
+		    int            shutdown)
+{
+    int              retval = -1;
+    restconf_handle *rh;
+
+    if (rc->rc_wait)
+	clixon_event_unreg_fd(rc->rc_s, restconf_connection_write);
+    restconf_stream_conn_close(rc);
+#ifdef CLIXON_RESTCONF_HTTP2
+    restconf_http2_free(rc);
+#endif
+    if ((rh = restconf_handle_get(rc->rc_h)) != NULL)
+	DELQ(rc, rh->rh_conns, restconf_conn *);
+    if (close_ssl_evhtp_socket(rc->rc_s, rc->rc_conn, shutdown) < 0)
+	goto done;
+    retval = 0;
+ done:
+    free(rc);
+    return retval;
+}
+
+/*! Write pending output of a connection without blocking
+ *
+ * Written data is drained from the evhtp output buffer. If not all could be written,
+ * input is paused and restconf_connection_write is registered to continue when the
+ * socket is writable. When all is written input is resumed, or the connection is
+ * closed if the request did not keep it alive.
+ * @param[in]  rc   Restconf connection
+ * @retval     1    All output written, connection open
+ * @retval     0    Output pending, or connection closed
+ * @retval    -1    Error
+ * An open event stream reply keeps the connection until the stream is ended
+ */
+int
+restconf_output_flush(restconf_conn *rc)
+{
+    int                 retval = -1;
+    evhtp_connection_t *conn = rc->rc_conn;
+    struct evbuffer    *ev;
+    char               *buf;
+    size_t              buflen;
+    ssize_t             len;
+    int                 er;
+
+    if ((ev = bufferevent_get_output(conn->bev)) == NULL){
+	clicon_err(OE_RESTCONF, EFAULT, "No evhtp output buffer");
+	goto done;
+    }
+    while ((buflen = evbuffer_get_length(ev)) > 0){
+	buf = (char*)evbuffer_pullup(ev, -1);
+	clicon_debug(1, "%s %lu", __FUNCTION__, buflen);
+	if (conn->ssl){
+	    if ((len = SSL_write(conn->ssl, buf, buflen)) <= 0){
+		er = errno;
+		switch (SSL_get_error(conn->ssl, len)){
+		case SSL_ERROR_WANT_READ:            /* 2 */
+		case SSL_ERROR_WANT_WRITE:           /* 3 */
+		    goto pending;
+		    break;
+		case SSL_ERROR_SYSCALL:              /* 5 */
+		    if (er == EAGAIN)
+			goto pending;
+		    if (er == ECONNRESET || er == EPIPE){ /* Closed by peer */
+			if (restconf_conn_close(rc, 0) < 0)
+			    goto done;
+			goto closed;
+		    }
+		    clicon_err(OE_RESTCONF, er, "SSL_write %d", er);
+		    goto done;
+		    break;
+		default:
+		    clicon_err(OE_SSL, 0, "SSL_write");
+		    goto done;
+		    break;
+		}
+	    }
+	}
+	else if ((len = write(rc->rc_s, buf, buflen)) < 0){
+	    if (errno == EAGAIN || errno == EWOULDBLOCK)
+		goto pending;
+	    if (errno == ECONNRESET || errno == EPIPE){ /* Closed by peer */
+		if (restconf_conn_close(rc, 0) < 0)
+		    goto done;
+		goto closed;
+	    }
+	    clicon_err(OE_UNIX, errno, "write");
+	    goto done;
+	}
+	evbuffer_drain(ev, len);
+    }
+    /* All output written */
+    if (rc->rc_wait){
+	rc->rc_wait = 0;
+	if (clixon_event_unreg_fd(rc->rc_s, restconf_connection_write) < 0)
+	    goto done;
+	if (clixon_event_reg_fd(rc->rc_s, restconf_connection, (void*)rc, "restconf client socket") < 0)
+	    goto done;
+    }
+    if (rc->rc_close && !rc->rc_stream){
+	clicon_debug(1, "%s no keep-alive, closing socket", __FUNCTION__);
+	if (restconf_conn_close(rc, 1) < 0)
+	    goto done;
+	goto closed;
+    }
+    retval = 1;
+    goto done;
+ pending:
+    clicon_debug(1, "%s write would block", __FUNCTION__);
+    if (rc->rc_wait == 0){
+	rc->rc_wait = 1;
+	if (clixon_event_unreg_fd(rc->rc_s, restconf_connection) < 0)
+	    goto done;
+	if (clixon_event_reg_fd_write(rc->rc_s, restconf_connection_write, (void*)rc, "restconf client write") < 0)
+	    goto done;
+    }
+ closed:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Client socket is writable, continue writing pending output
+ * @param[in]   s    Client socket
+ * @param[in]   arg  Restconf connection
+ * @see restconf_output_flush where this callback is registered
+ */
+static int
+restconf_connection_write(int   s, 
+			  void *arg)
+{
+    restconf_conn *rc;
+
+    if ((rc = (restconf_conn*)arg) == NULL){
+	clicon_err(OE_RESTCONF, EINVAL, "arg is NULL");
+	return -1;
+    }
+    if (restconf_output_flush(rc) < 0)
+	return -1;
+    return 0;
+}
+
 /*! New data connection after accept, receive and reply on data sockte
  *
  * @param[in]   s    Socket where message arrived. read from this.
- * @param[in]   arg  Client entry (from).
+ * @param[in]   arg  Restconf connection
  * @retval      0    OK
  * @retval      -1   Error Terminates backend and is never called). Instead errors are
  *                   propagated back to client.
@@ -878,24 +1354,31 @@ send_badrequest(clicon_handle       h,
  * with 100 Continue, in which case that is replied and the function returns and the client sends 
  * more data.
  * OR evhtp returns 0 with no reply, then this is assumed to mean read more data from the socket.
+ * The socket is non-blocking: if no more data is available, return and wait for more input.
+ * Replies are written with restconf_output_flush, and the connection is kept open for 
+ * more requests unless the request did not keep it alive.
  */
 static int
 restconf_connection(int   s, 
 		    void *arg)
 {
     int                 retval = -1;
+    restconf_conn      *rc;
     evhtp_connection_t *conn = NULL;
     ssize_t             n;
     char                buf[BUFSIZ]; /* from stdio.h, typically 8K */
     clicon_handle       h;
     int                 readmore = 1;
+    int                 ret;
+    restconf_handle    *rh;
 
     clicon_debug(1, "%s", __FUNCTION__);
-    if ((conn = (evhtp_connection_t*)arg) == NULL){
+    if ((rc = (restconf_conn*)arg) == NULL){
 	clicon_err(OE_RESTCONF, EINVAL, "arg is NULL");
 	goto done;
     }
-    h = (clicon_handle*)conn->htp->arg;
+    conn = rc->rc_conn;
+    h = rc->rc_h;
     while (readmore) {
 	readmore = 0;
 	/* Example: curl -Ssik -u wilma:bar -X GET https://localhost/restconf/data/example:x */
@@ -904,22 +1387,44 @@ restconf_connection(int   s,
 	       curl -Ssik --key /var/tmp/./test_restconf_ssl_certs.sh/certs/limited.key --cert /var/tmp/./test_restconf_ssl_certs.sh/certs/limited.crt -X GET https://localhost/restconf/data/example:x
 	    */
 	    if ((n = SSL_read(conn->ssl, buf, sizeof(buf))) < 0){
+		ret = SSL_get_error(conn->ssl, n);
+		if (ret == SSL_ERROR_WANT_READ || ret == SSL_ERROR_WANT_WRITE)
+		    goto ok; /* Wait for more data */
 		clicon_err(OE_XML, errno, "SSL_read");
 		goto done;
 	    }
 	}
 	else{
 	    if ((n = read(conn->sock, buf, sizeof(buf))) < 0){ /* XXX atomicio ? */
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+		    goto ok; /* Wait for more data */
 		clicon_err(OE_XML, errno, "SSL_read");
 		goto done;
 	    }
 	}
 	if (n == 0){
 	    clicon_debug(1, "%s n=0 closing socket", __FUNCTION__);
-	    if (close_ssl_evhtp_socket(s, conn, 1) < 0)
+	    if (restconf_conn_close(rc, 1) < 0)
 		goto done;
 	    goto ok;
 	}
+#ifdef CLIXON_RESTCONF_HTTP2
+	/* Cleartext HTTP/2 with prior knowledge, the preface is expected in first read */
+	if (!rc->rc_h2_checked){
+	    rc->rc_h2_checked = 1;
+	    if (conn->ssl == NULL && restconf_http2_preface(buf, n) &&
+		restconf_http2_start(rc) < 0)
+		goto done;
+	}
+	if (rc->rc_h2){
+	    if ((ret = restconf_http2_recv(rc, buf, n)) < 0)
+		goto done;
+	    /* Decrypted data may be buffered in SSL, not signalled by socket */
+	    if (ret == 1 && conn->ssl && SSL_pending(conn->ssl))
+		readmore = 1;
+	    continue;
+	}
+#endif
 	/* parse incoming packet 
 	 * signature: 
 	 */
@@ -936,21 +1441,22 @@ restconf_connection(int   s,
 	    conn->ssl = NULL;
 	    clicon_debug(1, "%s conn-free (%p) 2", __FUNCTION__, conn);
 	    evhtp_connection_free(conn);
+	    if ((rh = restconf_handle_get(h)) != NULL)
+		DELQ(rc, rh->rh_conns, restconf_conn *);
+	    free(rc);
 	    goto ok;
 	}
 	clicon_debug(1, "%s connection_parse OK", __FUNCTION__);
 	if (conn->bev != NULL){
-	    char     *buf = NULL;
-	    size_t    buflen;
 	    struct evbuffer *ev;
 
 	    if ((ev = bufferevent_get_output(conn->bev)) != NULL){
-		buf = (char*)evbuffer_pullup(ev, -1);
-		buflen = evbuffer_get_length(ev);
-		clicon_debug(1, "%s buf:%s", __FUNCTION__, buf);
-		if (buflen){
-		    if (buf_write(buf, buflen, conn->sock, conn->ssl) < 0)
+		if (evbuffer_get_length(ev)){
+		    if ((ret = restconf_output_flush(rc)) < 0)
 			goto done;
+		    /* Decrypted data may be buffered in SSL, not signalled by socket */
+		    if (ret == 1 && conn->ssl && SSL_pending(conn->ssl))
+			readmore = 1;
 		}
 		else{
 		    /* Return 0 from evhtp parser can be that it needs more data.
@@ -1041,6 +1547,46 @@ restconf_checkcert_file(cxobj      *xrestconf,
     return retval;
 }
 
+/*! Get an uint32 parameter from restconf config
+ * 
+ * @param[in]  xrestconf XML tree containing restconf config
+ * @param[in]  name      Name of parameter
+ * @param[in]  dflt      Default value if not in config
+ * @param[out] val       Value
+ * @retval     0         OK
+ * @retval    -1         Error, invalid value
+ */
+static int
+restconf_config_uint32(cxobj      *xrestconf,
+		       const char *name,
+		       uint32_t    dflt,
+		       uint32_t   *val)
+{
+    int    retval = -1;
+    cxobj *x;
+    char  *str;
+    char  *reason = NULL;
+    int    ret;
+
+    *val = dflt;
+    if ((x = xpath_first(xrestconf, NULL, "%s", name)) != NULL &&
+	(str = xml_body(x)) != NULL){
+	if ((ret = parse_uint32(str, val, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_uint32");
+	    goto done;
+	}
+	if (ret == 0){
+	    clicon_err(OE_CFG, EINVAL, "%s: %s", name, reason);
+	    goto done;
+	}
+    }
+    retval = 0;
+ done:
+    if (reason)
+	free(reason);
+    return retval;
+}
+
 /*! Accept new socket client
  * @param[in]  fd   Socket (unix or ip)
  * @param[in]  arg  typecast clicon_handle
@@ -1066,6 +1612,10 @@ restconf_accept_client(int   fd,
     int                 er;
     int                 readmore;
     X509               *peercert;
+    restconf_conn      *rc;
+#ifdef RESTCONF_OPENSSL_NONBLOCKING
+    int                 flags;
+#endif
     
     clicon_debug(1, "%s %d", __FUNCTION__, fd);
     if (rsock == NULL){
@@ -1119,6 +1669,8 @@ restconf_accept_client(int   fd,
 	}
 #endif
 	conn->ssl = ssl; /* evhtp */
+	/* Output buffer may be moved by evbuffer_pullup when a write is retried */
+	SSL_set_mode(ssl, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
 	if (SSL_set_fd(ssl, s) != 1){
 	    clicon_err(OE_SSL, 0, "SSL_set_fd");
 	    goto done;
@@ -1187,6 +1739,12 @@ restconf_accept_client(int   fd,
 		}
 	    }
 	} /* while(readmore) */
+	if (SSL_session_reused(ssl))
+	    rh->rh_tls_resumed++;
+	else
+	    rh->rh_tls_full++;
+	clicon_debug(1, "%s TLS handshake full:%" PRIu64 " resumed:%" PRIu64, __FUNCTION__,
+		     rh->rh_tls_full, rh->rh_tls_resumed);
 	/* For client-cert authentication, check if any certs are present,
 	* if not, send bad request
 	* Alt: set SSL_CTX_set_verify(ctx, SSL_VERIFY_FAIL_IF_NO_PEER_CERT)
@@ -1224,14 +1782,57 @@ restconf_accept_client(int   fd,
 	    }
 	}
 
-	if (clicon_debug_get())
+	if (clicon_debug_get()){
+	    const unsigned char *alpn = NULL;
+	    unsigned int         alpnlen = 0;
+
+	    SSL_get0_alpn_selected(ssl, &alpn, &alpnlen);
+	    clicon_debug(1, "%s ALPN: %.*s", __FUNCTION__, (int)alpnlen, alpn?(char*)alpn:"");
 	    restconf_listcerts(ssl);
+	}
+    }
+#ifdef RESTCONF_OPENSSL_NONBLOCKING
+    /* The accepted socket does not inherit non-blocking from the server socket.
+     * Set it after the SSL handshake so that reads and writes do not block on slow
+     * clients, see restconf_output_flush */
+    if ((flags = fcntl(s, F_GETFL, 0)) < 0 ||
+	fcntl(s, F_SETFL, flags | O_NONBLOCK) < 0){
+	clicon_err(OE_UNIX, errno, "fcntl");
+	goto done;
+    }
+#endif
+    if ((rc = malloc(sizeof(*rc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(rc, 0, sizeof(*rc));
+    rc->rc_h = h;
+    rc->rc_s = s;
+    rc->rc_conn = conn;
+    INSQ(rc, rh->rh_conns);
+#ifdef CLIXON_RESTCONF_HTTP2
+    if (ssl){
+	const unsigned char *alpn = NULL;
+	unsigned int         alpnlen = 0;
+
+	SSL_get0_alpn_selected(ssl, &alpn, &alpnlen);
+	if (alpnlen == strlen("h2") && memcmp(alpn, "h2", alpnlen) == 0){
+	    rc->rc_h2_checked = 1;
+	    if (restconf_http2_start(rc) < 0)
+		goto done;
+	}
     }
+#endif
     /*
      * Register callbacks for actual data socket 
      */
-    if (clixon_event_reg_fd(s, restconf_connection, (void*)conn, "restconf client socket") < 0)
+    if (clixon_event_reg_fd(s, restconf_connection, (void*)rc, "restconf client socket") < 0)
+	goto done;
+#ifdef CLIXON_RESTCONF_HTTP2
+    /* Server connection preface, ie settings */
+    if (rc->rc_h2 && restconf_http2_send(rc) < 0)
 	goto done;
+#endif
  ok:
     retval = 0;
  done:
@@ -1246,9 +1847,16 @@ restconf_openssl_terminate(clicon_handle h)
 {
     restconf_handle *rh;
     restconf_socket *rsock;
+    restconf_conn   *rc;
 
     clicon_debug(1, "%s", __FUNCTION__);
     if ((rh = restconf_handle_get(h)) != NULL){
+	if (rh->rh_tls_full || rh->rh_tls_resumed)
+	    clicon_log(LOG_NOTICE, "%s: TLS handshakes full: %" PRIu64 " resumed: %" PRIu64,
+		       __PROGRAM__, rh->rh_tls_full, rh->rh_tls_resumed);
+	while ((rc = rh->rh_conns) != NULL)
+	    restconf_conn_close(rc, 0);
+	restconf_stream_freeall(h);
 	while ((rsock = rh->rh_sockets) != NULL){
 	    clixon_event_unreg_fd(rsock->rs_ss, restconf_accept_client);
 	    close(rsock->rs_ss);
@@ -1358,26 +1966,28 @@ openssl_init_socket(clicon_handle h,
     int             ss = -1;
     restconf_handle *rh = NULL;
     restconf_socket *rsock = NULL; /* openssl per socket struct */
+    int             flags = 0;
 
     clicon_debug(1, "%s", __FUNCTION__);
     /* Extract socket parameters from single socket config: ns, addr, port, ssl */
     if (restconf_socket_extract(h, xs, nsc, &netns, &address, &addrtype, &port, &ssl) < 0)
 	goto done;
+    if ((rh = restconf_handle_get(h)) == NULL){
+	clicon_err(OE_XML, EFAULT, "No openssl handle");
+	goto done;
+    }
+#ifdef RESTCONF_OPENSSL_NONBLOCKING
+    flags |= SOCK_NONBLOCK; /* Also 0 is possible */
+#endif
+    if (rh->rh_workers > 1) /* Worker processes bind the same address and port */
+	flags |= CLIXON_SOCK_REUSEPORT;
     /* Open restconf socket and bind */
     if (restconf_socket_init(netns, address, addrtype, port,
 			     SOCKET_LISTEN_BACKLOG,
-#ifdef RESTCONF_OPENSSL_NONBLOCKING
-			     SOCK_NONBLOCK, /* Also 0 is possible */
-#else /* blocking */
-			     0,
-#endif
+			     flags,
 			     &ss
 			     ) < 0)
 	goto done;
-    if ((rh = restconf_handle_get(h)) == NULL){
-	clicon_err(OE_XML, EFAULT, "No openssl handle");
-	goto done;
-    }
     /*
      * Create per-socket openssl handle
      */
@@ -1429,6 +2039,10 @@ restconf_openssl_init(clicon_handle h,
     int                i;
     evhtp_t           *evhtp = NULL;
     struct event_base *evbase = NULL;
+    uint32_t           session_timeout;
+    uint32_t           ticket_rotate;
+    char              *stream_path;
+    cbuf              *cbpath = NULL;
 
     clicon_debug(1, "%s", __FUNCTION__);
     /* flag used for sanity of certs */
@@ -1463,7 +2077,14 @@ restconf_openssl_init(clicon_handle h,
 	if (auth_type == CLIXON_AUTH_CLIENT_CERTIFICATE)
 	    if (restconf_checkcert_file(xrestconf, "server-ca-cert-path", &server_ca_cert_path) < 0)
 		goto done;
-	if (restconf_ssl_context_configure(h, ctx, server_cert_path, server_key_path, server_ca_cert_path) < 0)
+	if (restconf_config_uint32(xrestconf, "tls-session-timeout",
+				   TLS_SESSION_TIMEOUT_DEFAULT, &session_timeout) < 0)
+	    goto done;
+	if (restconf_config_uint32(xrestconf, "tls-ticket-key-rotation",
+				   TLS_TICKET_ROTATE_DEFAULT, &ticket_rotate) < 0)
+	    goto done;
+	if (restconf_ssl_context_configure(h, ctx, server_cert_path, server_key_path, server_ca_cert_path,
+					   session_timeout, ticket_rotate) < 0)
 	    goto done;
     }
     rh = restconf_handle_get(h);
@@ -1483,6 +2104,18 @@ restconf_openssl_init(clicon_handle h,
     	clicon_err(OE_EVENTS, errno, "evhtp_set_cb");
     	goto done;
     }
+    /* Event streams, eg /streams/NETCONF */
+    if ((stream_path = clicon_option_str(h, "CLICON_STREAM_PATH")) != NULL){
+	if ((cbpath = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	cprintf(cbpath, "/%s", stream_path);
+	if (evhtp_set_cb(evhtp, cbuf_get(cbpath), restconf_path_stream, h) == NULL){
+	    clicon_err(OE_EVENTS, errno, "evhtp_set_cb");
+	    goto done;
+	}
+    }
     /* Callback to be executed for all /restconf api calls */
     if (evhtp_set_cb(evhtp, RESTCONF_WELL_KNOWN, restconf_path_wellknown, h) == NULL){
     	clicon_err(OE_EVENTS, errno, "evhtp_set_cb");
@@ -1497,6 +2130,8 @@ restconf_openssl_init(clicon_handle h,
     }
     retval = 1;
  done:
+    if (cbpath)
+	cbuf_free(cbpath);
     if (vec)
 	free(vec);
     return retval;
@@ -1537,6 +2172,9 @@ restconf_clixon_init(clicon_handle h,
     cligen_buflen = clicon_option_int(h, "CLICON_CLI_BUF_START");
     cligen_bufthreshold = clicon_option_int(h, "CLICON_CLI_BUF_THRESHOLD");
     cbuf_alloc_set(cligen_buflen, cligen_bufthreshold);
+    /* Compression of reply bodies */
+    if (restconf_compress_init(h) < 0)
+	goto done;
 
     /* Add (hardcoded) netconf features in case ietf-netconf loaded here
      * Otherwise it is loaded in netconf_module_load below
@@ -1590,6 +2228,9 @@ restconf_clixon_init(clicon_handle h,
     /* Load yang restconf module */
     if (yang_spec_parse_module(h, "ietf-restconf", NULL, yspec)< 0)
 	goto done;
+    /* Load yang patch module, RFC8072 */
+    if (yang_spec_parse_module(h, "ietf-yang-patch", NULL, yspec)< 0)
+	goto done;
     
     /* Add netconf yang spec, used as internal protocol */
     if (netconf_module_load(h) < 0)
@@ -1659,6 +2300,112 @@ restconf_sig_term(int arg)
     clicon_exit_set(); /* XXX should rather signal event_base_loop */
 }
 
+/*! Signal child process exited, reaped in event loop, see clixon_process_waitpid
+ */
+static void
+restconf_sig_child(int arg)
+{
+    clicon_sig_child_set(1);
+}
+
+/*! Start worker processes that are not running, called every second
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Clicon handle
+ */
+static int
+restconf_workers_check(int   fd,
+		       void *arg)
+{
+    clicon_handle  h = (clicon_handle)arg;
+    struct timeval t;
+
+    if (clixon_process_start_all(h) < 0)
+	return -1;
+    gettimeofday(&t, NULL);
+    t.tv_sec++;
+    return clixon_event_reg_timeout(t, restconf_workers_check, h, "restconf workers");
+}
+
+/*! Start worker processes serving restconf requests
+ *
+ * Each worker is this program started with the same arguments and -W. It reads the
+ * restconf config, opens the server sockets with SO_REUSEPORT so that the kernel
+ * distributes connections among the workers, and has its own backend session.
+ * Workers are supervised with the clixon process functions and started again if they
+ * exit.
+ * @param[in]  h        Clicon handle
+ * @param[in]  workers  Number of worker processes
+ * @param[in]  argc     Number of program arguments
+ * @param[in]  argv     Program arguments, argv[0] is program
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+restconf_workers_start(clicon_handle h,
+		       uint32_t      workers,
+		       int           argc,
+		       char        **argv)
+{
+    int      retval = -1;
+    char   **wargv = NULL;
+    int      wargc;
+    cbuf    *cb = NULL;
+    cbuf    *cbname = NULL;
+    int      i;
+    uint32_t w;
+
+    clicon_debug(1, "%s %u", __FUNCTION__, workers);
+    if ((cb = cbuf_new()) == NULL ||
+	(cbname = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    /* Process is started with execv which needs a path */
+    if (strchr(argv[0], '/') != NULL)
+	cprintf(cb, "%s", argv[0]);
+    else
+	cprintf(cb, "%s/clixon_restconf", clicon_option_str(h, "CLICON_WWWDIR"));
+    wargc = argc + 2; /* -W and NULL */
+    if ((wargv = calloc(wargc, sizeof(char *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    i = 0;
+    wargv[i++] = cbuf_get(cb);
+    while (i < argc){
+	wargv[i] = argv[i];
+	i++;
+    }
+    wargv[i++] = "-W";
+    wargv[i++] = NULL;
+    for (w=0; w<workers; w++){
+	cbuf_reset(cbname);
+	cprintf(cbname, "restconf-worker-%u", w);
+	if (clixon_process_register(h, cbuf_get(cbname),
+				    "Clixon RESTCONF worker process",
+				    NULL,
+				    NULL,
+				    wargv, wargc) < 0)
+	    goto done;
+    }
+    if (set_signal(SIGCHLD, restconf_sig_child, NULL) < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
+    if (restconf_workers_check(0, h) < 0)
+	goto done;
+    clicon_log(LOG_NOTICE, "%s: %u worker processes", __PROGRAM__, workers);
+    retval = 0;
+ done:
+    if (wargv)
+	free(wargv);
+    if (cb)
+	cbuf_free(cb);
+    if (cbname)
+	cbuf_free(cbname);
+    return retval;
+}
+
 /*! Usage help routine
  * @param[in]  argv0  command line
  * @param[in]  h      Clicon handle
@@ -1681,6 +2428,7 @@ usage(clicon_handle h,
     	    "\t-u <path|addr>\t  Internal socket domain path or IP addr (see -a)\n"
 	    "\t-r \t\t  Do not drop privileges if run as root\n"
 	    "\t-o <option>=<value> Set configuration option overriding config file (see clixon-config.yang)\n"
+	    "\t-W \t\t  Worker process, started by restconf daemon if config workers > 1\n"
 	    ,
 	    argv0
 	    );
@@ -1701,9 +2449,24 @@ main(int    argc,
     restconf_handle *rh = NULL;
     int             ret;
     cxobj          *xrestconf = NULL;
+    int             worker = 0;
+    uint32_t        workers = 1;
+    char          **argv1 = NULL;
+    int             argc1 = argc;
+    int             i;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__PROGRAM__, LOG_INFO, logdst);
+    /* Copy of arguments for starting worker processes, getopt may modify argv */
+    if ((argv1 = calloc(argc1+1, sizeof(char *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<argc1; i++)
+	if ((argv1[i] = strdup(argv[i])) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
     
     /* Create handle */
     if ((h = restconf_handle_init()) == NULL)
@@ -1765,11 +2528,14 @@ main(int    argc,
 	clicon_err(OE_DAEMON, errno, "Setting signal");
 	goto done;
     }
+    /* Start and stop sampling profiler, see clixon_sample_pending_run() */
+    if (clixon_sample_sig_register() < 0){
+	clicon_err(OE_DAEMON, errno, "Setting signal");
+	goto done;
+    }
     /* Find and read configfile */
     if (clicon_options_main(h) < 0)
 	goto done;
-    //    stream_path = clicon_option_str(h, "CLICON_STREAM_PATH");
-    
     /* Now rest of options, some overwrite option file */
     optind = 1;
     opterr = 0;
@@ -1809,6 +2575,9 @@ main(int    argc,
 		goto done;
 	    break;
 	}
+	case 'W': /* Worker process */
+	    worker = 1;
+	    break;
         default:
             usage(h, argv0);
             break;
@@ -1846,15 +2615,25 @@ main(int    argc,
     memset(rh, 0, sizeof *rh);
     if (openspec_handle_set(h, rh) < 0)
 	goto done;
-    /* Openssl inits */ 
-    if (restconf_openssl_init(h, dbg, xrestconf) < 0)
+    if (restconf_config_uint32(xrestconf, "workers", 1, &workers) < 0)
 	goto done;
-    /* Drop privileges after clixon and openssl init */
-    if (drop_privileges){
-	/* Drop privileges to WWWUSER if started as root */
-	if (restconf_drop_privileges(h, WWWUSER) < 0)
+    rh->rh_workers = workers;
+    if (workers > 1 && !worker){
+	/* Only start and supervise workers, which open sockets and drop privileges */
+	if (restconf_workers_start(h, workers, argc1, argv1) < 0)
 	    goto done;
     }
+    else {
+	/* Openssl inits */ 
+	if (restconf_openssl_init(h, dbg, xrestconf) < 0)
+	    goto done;
+	/* Drop privileges after clixon and openssl init */
+	if (drop_privileges){
+	    /* Drop privileges to WWWUSER if started as root */
+	    if (restconf_drop_privileges(h, WWWUSER) < 0)
+		goto done;
+	}
+    }
     /* Main event loop */ 
     if (clixon_event_loop(h) < 0)
 	goto done;
@@ -1862,6 +2641,16 @@ main(int    argc,
     retval = 0;
  done:
     clicon_debug(1, "restconf_main_openssl done");
+    if (workers > 1 && !worker){
+	clixon_process_stop_all(h);
+	clixon_process_delete_all(h);
+    }
+    if (argv1){
+	for (i=0; i<argc1; i++)
+	    if (argv1[i])
+		free(argv1[i]);
+	free(argv1);
+    }
     if (xrestconf)
 	xml_free(xrestconf);
     restconf_openssl_terminate(h);
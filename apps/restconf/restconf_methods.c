@@ -275,6 +275,7 @@ api_data_write(clicon_handle h,
     yang_bind      yb;
     char          *xpath = NULL;
     char          *attr;
+    int            forward;  /* Forward original body, see restconf_edit_body_xml */
 	
     clicon_debug(1, "%s api_path:\"%s\"",  __FUNCTION__, api_path0);
     clicon_debug(1, "%s data:\"%s\"", __FUNCTION__, data);
@@ -458,6 +459,8 @@ api_data_write(clicon_handle h,
 	}
     }
 
+    /* Check before attributes are added, not top-of-tree where data is renamed */
+    forward = api_path && restconf_edit_body_forward(media_in, xdata, qvec);
     /* Add operation create as attribute. If that fails with Conflict, then 
      * try "replace" (see comment in function header)
      */
@@ -626,7 +629,15 @@ api_data_write(clicon_handle h,
     cprintf(cbx, " autocommit=\"true\"");
     cprintf(cbx, "><target><candidate /></target>");
     cprintf(cbx, "<default-operation>none</default-operation>");
-    if (clicon_xml2cbuf(cbx, xtop, 0, 0, -1) < 0)
+    if (forward){ /* Original XML body instead of serialized xdata, xdata is freed */
+	char attrs[64];
+	snprintf(attrs, sizeof(attrs), " %s:operation=\"%s\" objectcreate=\"%s\"",
+		 NETCONF_BASE_PREFIX, xml_operation2str(op), plain_patch?"false":"true");
+	if (restconf_edit_body_xml(cbx, xtop, xdata, data, attrs) < 0)
+	    goto done;
+	xdata = NULL;
+    }
+    else if (clicon_xml2cbuf(cbx, xtop, 0, 0, -1) < 0)
 	goto done;
     cprintf(cbx, "</edit-config></rpc>");
     clicon_debug(1, "%s xml: %s api_path:%s",__FUNCTION__, cbuf_get(cbx), api_path);
@@ -725,6 +736,492 @@ api_data_put(clicon_handle h,
 			  media_in, media_out, 0, ds);
 } 
 
+/*! Translate one edit of a YANG patch to a config tree of an edit-config
+ * @param[in]  yspec    Yang spec
+ * @param[in]  api_path Api-path of the target resource, or NULL for the datastore
+ * @param[in]  xedit    Edit of YANG patch: <edit><edit-id>..</edit-id><operation>..
+ * @param[out] xtopp    Config tree: <config>..., free with xml_free
+ * @param[out] xerr     Error tree if retval is 0, free with xml_free
+ * @retval     1        OK
+ * @retval     0        Invalid edit, error in xerr
+ * @retval    -1        Error
+ * The value replaces the target node, with the edit operation as netconf operation.
+ * Insert and move are translated to netconf insert attributes as query parameters
+ * are in a plain PUT or POST, see restconf_insert_attributes.
+ * @see RFC 8072 Sec 2.5
+ */
+static int
+api_data_yang_patch_edit(yang_stmt *yspec,
+			 char      *api_path,
+			 cxobj     *xedit,
+			 cxobj    **xtopp,
+			 cxobj    **xerr)
+{
+    int                 retval = -1;
+    char               *opstr;
+    char               *target;
+    char               *where;
+    char               *point;
+    cbuf               *cb = NULL;
+    cxobj              *xtop = NULL;
+    cxobj              *xbot = NULL;
+    yang_stmt          *ybot = NULL;
+    cxobj              *xvalue;
+    cxobj              *xdata;
+    cxobj              *xparent;
+    cxobj              *xa;
+    cvec               *qvec = NULL;
+    enum operation_type op;
+    int                 ret;
+
+    if ((opstr = xml_find_body(xedit, "operation")) == NULL){
+	if (netconf_missing_element_xml(xerr, "protocol", "operation", NULL) < 0)
+	    goto done;
+	goto fail;
+    }
+    if ((target = xml_find_body(xedit, "target")) == NULL){
+	if (netconf_missing_element_xml(xerr, "protocol", "target", NULL) < 0)
+	    goto done;
+	goto fail;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    /* The target is relative to the target resource, "/" is the resource itself */
+    cprintf(cb, "%s", api_path?api_path:"");
+    if (strcmp(target, "/") != 0)
+	cprintf(cb, "%s", target);
+    if ((xtop = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+	goto done;
+    xbot = xtop;
+    if (cbuf_len(cb)){
+	if ((ret = api_path2xml(cbuf_get(cb), yspec, xtop, YC_DATANODE, 1, &xbot, &ybot, xerr)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    if (ybot == NULL){
+	if (netconf_invalid_value_xml(xerr, "protocol", "Edit target must be a data resource") < 0)
+	    goto done;
+	goto fail;
+    }
+    if (strcmp(opstr, "delete") == 0 || strcmp(opstr, "remove") == 0 ||
+	strcmp(opstr, "move") == 0){
+	/* The operation is made on the target node itself */
+	xdata = xbot;
+	if (strcmp(opstr, "delete") == 0)
+	    op = OP_DELETE;
+	else if (strcmp(opstr, "remove") == 0)
+	    op = OP_REMOVE;
+	else
+	    op = OP_MERGE;
+    }
+    else {
+	if (strcmp(opstr, "insert") == 0)
+	    op = OP_CREATE;
+	else if (xml_operation(opstr, &op) < 0 ||
+		 (op != OP_CREATE && op != OP_MERGE && op != OP_REPLACE)){
+	    if (netconf_invalid_value_xml(xerr, "protocol", "Invalid edit operation") < 0)
+		goto done;
+	    goto fail;
+	}
+	if ((xvalue = xml_find_type(xedit, NULL, "value", CX_ELMNT)) == NULL ||
+	    xml_child_nr_type(xvalue, CX_ELMNT) != 1){
+	    if (netconf_malformed_message_xml(xerr, "The edit value MUST contain exactly one instance of the edit target") < 0)
+		goto done;
+	    goto fail;
+	}
+	xdata = xml_child_i_type(xvalue, 0, CX_ELMNT);
+	if (strcmp(xml_name(xdata), xml_name(xbot)) != 0){
+	    if (netconf_bad_element_xml(xerr, "application", xml_name(xdata),
+					"Data element does not match edit target") < 0)
+		goto done;
+	    goto fail;
+	}
+	if (match_list_keys(ybot, xdata, xbot) < 0){
+	    if (netconf_operation_failed_xml(xerr, "protocol", "edit target keys do not match data keys") < 0)
+		goto done;
+	    goto fail;
+	}
+	/* Replace bottom of target with the value */
+	xparent = xml_parent(xbot);
+	xml_purge(xbot);
+	if (xml_addsub(xparent, xdata) < 0)
+	    goto done;
+	xml_spec_set(xdata, ybot);
+    }
+    if ((xa = xml_new("operation", xdata, CX_ATTR)) == NULL)
+	goto done;
+    if (xml_prefix_set(xa, NETCONF_BASE_PREFIX) < 0)
+	goto done;
+    if (xml_value_set(xa, xml_operation2str(op)) < 0)
+	goto done;
+    if (strcmp(opstr, "insert") == 0 || strcmp(opstr, "move") == 0){
+	if ((where = xml_find_body(xedit, "where")) == NULL)
+	    where = "last";
+	if ((qvec = cvec_new(0)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_new");
+	    goto done;
+	}
+	if (cvec_add_string(qvec, "insert", where) < 0){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    goto done;
+	}
+	if ((point = xml_find_body(xedit, "point")) != NULL){
+	    /* The point is relative to the target resource as the target */
+	    cbuf_reset(cb);
+	    cprintf(cb, "%s%s", api_path?api_path:"", point);
+	    if (cvec_add_string(qvec, "point", cbuf_get(cb)) < 0){
+		clicon_err(OE_UNIX, errno, "cvec_add_string");
+		goto done;
+	    }
+	}
+	else if (strcmp(where, "before") == 0 || strcmp(where, "after") == 0){
+	    if (netconf_missing_element_xml(xerr, "protocol", "point", NULL) < 0)
+		goto done;
+	    goto fail;
+	}
+	if (restconf_insert_attributes(xdata, qvec) < 0)
+	    goto done;
+    }
+    *xtopp = xtop;
+    xtop = NULL;
+    retval = 1;
+ done:
+    if (qvec)
+	cvec_free(qvec);
+    if (cb)
+	cbuf_free(cb);
+    if (xtop)
+	xml_free(xtop);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Send a YANG patch status reply
+ * @param[in]  req     Generic Www handle
+ * @param[in]  xs      Status tree: <yang-patch-status><patch-id>..</patch-id>...
+ * @param[in]  pretty  Set to 1 for pretty-printed xml/json output
+ * @param[in]  media   Output media
+ * @param[in]  code    HTTP status code
+ * @retval     0       OK
+ * @retval    -1       Error
+ * The status tree is not bound to yang, and is encoded as in api_return_err
+ */
+static int
+api_data_yang_patch_status(void          *req,
+			   cxobj         *xs,
+			   int            pretty,
+			   restconf_media media,
+			   int            code)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    switch (media){
+    case YANG_DATA_XML:
+	if (xmlns_set(xs, NULL, "urn:ietf:params:xml:ns:yang:ietf-yang-patch") < 0)
+	    goto done;
+	if (clicon_xml2cbuf(cb, xs, 0, pretty, -1) < 0)
+	    goto done;
+	break;
+    case YANG_DATA_JSON:
+	cprintf(cb, "{%s\"ietf-yang-patch:yang-patch-status\":", pretty?"\n":"");
+	if (xml2json_cbuf_vec(cb, xml_childvec_get(xs), xml_child_nr(xs), pretty) < 0)
+	    goto done;
+	cprintf(cb, "}");
+	break;
+    default:
+	clicon_err(OE_YANG, EINVAL, "Invalid media type %d", media);
+	goto done;
+	break;
+    }
+    if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media)) < 0)
+	goto done;
+    if (restconf_reply_send(req, code, cb) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Add an edit with errors to a YANG patch status
+ * @param[in]  xs      Status tree: <yang-patch-status>
+ * @param[in]  editid  Edit id, or NULL for global errors
+ * @param[in]  xerr    Parent of rpc-error elements, they are moved to the status
+ * @retval     code    HTTP status code of the first error
+ * @retval    -1       Error
+ */
+static int
+api_data_yang_patch_errors(cxobj *xs,
+			   char  *editid,
+			   cxobj *xerr)
+{
+    int    retval = -1;
+    cxobj *xp;
+    cxobj *xe;
+    cxobj *xa;
+    int    code = 0;
+    char  *tag;
+
+    xp = xs;
+    if (editid != NULL){
+	if ((xp = xml_find_type(xs, NULL, "edit-status", CX_ELMNT)) == NULL &&
+	    (xp = xml_new("edit-status", xs, CX_ELMNT)) == NULL)
+	    goto done;
+	if ((xp = xml_new("edit", xp, CX_ELMNT)) == NULL)
+	    goto done;
+	if (xml_new_body("edit-id", xp, editid) == NULL)
+	    goto done;
+    }
+    if ((xp = xml_new("errors", xp, CX_ELMNT)) == NULL)
+	goto done;
+    while ((xe = xml_find_type(xerr, NULL, "rpc-error", CX_ELMNT)) != NULL){
+	if (code == 0){
+	    if ((tag = xml_find_body(xe, "error-tag")) == NULL ||
+		(code = restconf_err2code(tag)) < 0)
+		code = 500; /* internal server error */
+	}
+	if (xml_addsub(xp, xe) < 0)
+	    goto done;
+	if (xml_name_set(xe, "error") < 0)
+	    goto done;
+	if ((xa = xml_find_type(xe, NULL, "xmlns", CX_ATTR)) != NULL)
+	    xml_purge(xa);
+    }
+    retval = code?code:500;
+ done:
+    return retval;
+}
+
+/*! YANG patch of a target resource: many edits in one transaction
+ * @param[in]  h        Clixon handle
+ * @param[in]  req      Generic Www handle
+ * @param[in]  api_path0 According to restconf (Sec 3.5.3.1 in rfc8040)
+ * @param[in]  pi       Offset, where to start pcvec
+ * @param[in]  data     Stream input data
+ * @param[in]  pretty   Set to 1 for pretty-printed xml/json output
+ * @param[in]  media_in  Input media: yang-patch xml or json
+ * @param[in]  media_out Output media
+ * @param[in]  ds       0 if "data" resource, 1 if rfc8527 "ds" resource
+ * All edits are sent in one edit-batch to the candidate, which is committed only if
+ * all edits succeed, otherwise the candidate is discarded and no edit is applied.
+ * The reply is a yang-patch-status with ok, or with the errors of the failed edits.
+ * @see RFC 8072 YANG Patch Media Type
+ * @see from_client_edit_batch
+ */
+static int
+api_data_yang_patch(clicon_handle  h,
+		    void          *req,
+		    char          *api_path0,
+		    int            pi,
+		    char          *data,
+		    int            pretty,
+		    restconf_media media_in,
+		    restconf_media media_out,
+		    ietf_ds_t      ds)
+{
+    int        retval = -1;
+    int        i;
+    char      *api_path;
+    yang_stmt *yspec;
+    cxobj     *xpatch0 = NULL; /* Parsed body, including top symbol */
+    cxobj     *xpatch;
+    cxobj     *xedit;
+    cxobj     *xtop = NULL;
+    cxobj     *xret = NULL;
+    cxobj     *xerr = NULL;
+    cxobj     *xs = NULL;      /* yang-patch-status */
+    cxobj     *xe;
+    cxobj     *x;
+    char      *patchid;
+    char      *editid;
+    char      *username;
+    cbuf      *cbx = NULL;
+    int        code = 0;
+    int        ret;
+
+    clicon_debug(1, "%s api_path:\"%s\"",  __FUNCTION__, api_path0);
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_FATAL, 0, "No DB_SPEC");
+	goto done;
+    }
+    api_path = api_path0;
+    for (i=0; i<pi; i++)
+	api_path = index(api_path+1, '/');
+    if (media_in == YANG_PATCH_XML)
+	ret = clixon_xml_parse_string(data, YB_MODULE, yspec, &xpatch0, &xerr);
+    else
+	ret = clixon_json_parse_string(data, YB_MODULE, yspec, &xpatch0, &xerr);
+    if (ret < 0 &&
+	netconf_malformed_message_xml(&xerr, clicon_err_reason) < 0)
+	goto done;
+    if (ret <= 0){
+	if ((xe = xpath_first(xerr, NULL, "rpc-error")) == NULL){
+	    clicon_err(OE_XML, EINVAL, "rpc-error not found (internal error)");
+	    goto done;
+	}
+	if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((xpatch = xml_find_type(xpatch0, NULL, "yang-patch", CX_ELMNT)) == NULL ||
+	(patchid = xml_find_body(xpatch, "patch-id")) == NULL){
+	if (netconf_malformed_message_xml(&xerr, "The message-body MUST contain a yang-patch with a patch-id") < 0)
+	    goto done;
+	if ((xe = xpath_first(xerr, NULL, "rpc-error")) == NULL){
+	    clicon_err(OE_XML, EINVAL, "rpc-error not found (internal error)");
+	    goto done;
+	}
+	if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((xs = xml_new("yang-patch-status", NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (xml_new_body("patch-id", xs, patchid) == NULL)
+	goto done;
+    /* For internal XML protocol: add username attribute for access control
+     */
+    username = clicon_username_get(h);
+    if ((cbx = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cbx, "<rpc xmlns=\"%s\" username=\"%s\" xmlns:%s=\"%s\">",
+	    NETCONF_BASE_NAMESPACE,
+	    username?username:"",
+	    NETCONF_BASE_PREFIX,
+	    NETCONF_BASE_NAMESPACE); /* bind nc to netconf namespace */
+    cprintf(cbx, "<edit-batch xmlns=\"%s\"><target>candidate</target>", CLIXON_LIB_NS);
+    /* Check all edits before anything is sent to the backend */
+    xedit = NULL;
+    while ((xedit = xml_child_each(xpatch, xedit, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(xedit), "edit") != 0)
+	    continue;
+	editid = xml_find_body(xedit, "edit-id");
+	if ((ret = api_data_yang_patch_edit(yspec, api_path, xedit, &xtop, &xerr)) < 0)
+	    goto done;
+	if (ret == 0){
+	    if ((code = api_data_yang_patch_errors(xs, editid?editid:"", xerr)) < 0)
+		goto done;
+	    if (api_data_yang_patch_status(req, xs, pretty, media_out, code) < 0)
+		goto done;
+	    goto ok;
+	}
+	cprintf(cbx, "<edit><id>");
+	if (xml_chardata_cbuf_append(cbx, editid?editid:"") < 0)
+	    goto done;
+	cprintf(cbx, "</id><default-operation>none</default-operation>");
+	if (clicon_xml2cbuf(cbx, xtop, 0, 0, -1) < 0)
+	    goto done;
+	cprintf(cbx, "</edit>");
+	xml_free(xtop);
+	xtop = NULL;
+    }
+    cprintf(cbx, "</edit-batch></rpc>");
+    clicon_debug(1, "%s xml: %s", __FUNCTION__, cbuf_get(cbx));
+    if (clicon_rpc_netconf(h, cbuf_get(cbx), &xret, NULL) < 0)
+	goto done;
+    xe = NULL;
+    if ((x = xml_find_type(xret, NULL, "rpc-reply", CX_ELMNT)) == NULL ||
+	(xe = xml_find_type(x, NULL, "rpc-error", CX_ELMNT)) != NULL){
+	if (api_return_err(h, req, xe?xe:xret, pretty, media_out, 0) < 0)
+	    goto done;
+	goto ok;
+    }
+    /* Status of the failed edits, in edit order */
+    xedit = NULL;
+    while ((xedit = xml_child_each(x, xedit, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(xedit), "edit") != 0 ||
+	    (xe = xml_find_type(xedit, NULL, "error", CX_ELMNT)) == NULL)
+	    continue;
+	editid = xml_find_body(xedit, "id");
+	if ((ret = api_data_yang_patch_errors(xs, editid?editid:"", xe)) < 0)
+	    goto done;
+	if (code == 0)
+	    code = ret;
+    }
+    cbuf_reset(cbx);
+    cprintf(cbx, "<rpc xmlns=\"%s\" username=\"%s\">",
+	    NETCONF_BASE_NAMESPACE,
+	    username?username:"");
+    if (code == 0)
+	cprintf(cbx, "<commit/></rpc>");
+    else
+	cprintf(cbx, "<discard-changes/></rpc>");
+    xml_free(xret);
+    xret = NULL;
+    if (clicon_rpc_netconf(h, cbuf_get(cbx), &xret, NULL) < 0)
+	goto done;
+    if (code == 0 &&
+	(xe = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	/* Validation or commit failed: no edit is applied */
+	if ((code = api_data_yang_patch_errors(xs, NULL, xml_parent(xe))) < 0)
+	    goto done;
+	cbuf_reset(cbx);
+	cprintf(cbx, "<rpc xmlns=\"%s\" username=\"%s\"><discard-changes/></rpc>",
+		NETCONF_BASE_NAMESPACE,
+		username?username:"");
+	xml_free(xret);
+	xret = NULL;
+	if (clicon_rpc_netconf(h, cbuf_get(cbx), &xret, NULL) < 0)
+	    goto done;
+    }
+    if (code != 0){
+	if (api_data_yang_patch_status(req, xs, pretty, media_out, code) < 0)
+	    goto done;
+	goto ok;
+    }
+    /* RFC8040 Sec 1.4: update startup after running is altered, see api_data_write */
+    if ((IETF_DS_NONE == ds) && if_feature(yspec, "ietf-netconf", "startup")){
+	cbuf_reset(cbx);
+	cprintf(cbx, "<rpc xmlns=\"%s\" username=\"%s\">",
+		NETCONF_BASE_NAMESPACE,
+		username?username:"");
+	cprintf(cbx, "<copy-config><source><running/></source><target><startup/></target></copy-config></rpc>");
+	xml_free(xret);
+	xret = NULL;
+	if (clicon_rpc_netconf(h, cbuf_get(cbx), &xret, NULL) < 0)
+	    goto done;
+	if ((xe = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	    if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
+		goto done;
+	    goto ok;
+	}
+    }
+    if (xml_new("ok", xs, CX_ELMNT) == NULL)
+	goto done;
+    if (api_data_yang_patch_status(req, xs, pretty, media_out, 200) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (xs)
+	xml_free(xs);
+    if (xpatch0)
+	xml_free(xpatch0);
+    if (xtop)
+	xml_free(xtop);
+    if (xret)
+	xml_free(xret);
+    if (xerr)
+	xml_free(xerr);
+    if (cbx)
+	cbuf_free(cbx);
+    return retval;
+}
+
 /*! Generic REST PATCH method for plain patch 
  * @param[in]  h        Clixon handle
  * @param[in]  req      Generic Www handle
@@ -741,6 +1238,8 @@ api_data_put(clicon_handle h,
  * resource within the target resource.
  * NOTE:    If the target resource instance does not exist, the server MUST NOT
  *   create it. (CANT BE DONE WITH NETCONF)
+ * YANG patch (RFC 8072) is made with media application/yang-patch+xml/json, see
+ * api_data_yang_patch
  */
 int
 api_data_patch(clicon_handle h,
@@ -766,7 +1265,8 @@ api_data_patch(clicon_handle h,
 	break;
     case YANG_PATCH_XML:
     case YANG_PATCH_JSON: 	/* RFC 8072 patch */
-	ret = restconf_notimplemented(req);
+	ret = api_data_yang_patch(h, req, api_path0, pi, data, pretty,
+				  media_in, media_out, ds);
 	break;
     default:
 	ret = restconf_unsupported_media(req);
@@ -40,6 +40,7 @@
 #endif
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <errno.h>
 #include <signal.h>
@@ -63,6 +64,197 @@
 #include "restconf_err.h"
 #include "restconf_methods_get.h"
 
+/* State of a streamed JSON GET reply, see api_data_get_flush */
+struct get_stream{
+    void          *gs_req;     /* Generic Www handle */
+    restconf_media gs_media;   /* Output media */
+    int            gs_started; /* Reply and headers are sent */
+    char          *gs_etag;    /* Change token of running, or NULL, see api_data_get_cache_headers */
+    uint64_t       gs_modified;/* Time of last change of running */
+};
+
+/*! Check if all data nodes of a yang subtree are config data
+ * @param[in]  y   Yang node
+ * @retval     1   Node and all its data node descendants are config
+ * @retval     0   Node or some descendant is state data (config false)
+ */
+static int
+api_data_config_only(yang_stmt *y)
+{
+    yang_stmt *yc = NULL;
+
+    if (yang_config(y) == 0)
+	return 0;
+    while ((yc = yn_each(y, yc)) != NULL){
+	if (!yang_datanode(yc) &&
+	    yang_keyword_get(yc) != Y_CHOICE && yang_keyword_get(yc) != Y_CASE)
+	    continue;
+	if (api_data_config_only(yc) == 0)
+	    return 0;
+    }
+    return 1;
+}
+
+/*! Check if a HTTP If-None-Match header matches an entity tag
+ * @param[in]  inm   Value of If-None-Match: "*" or comma-separated list of entity tags
+ * @param[in]  etag  Entity tag (without quotes)
+ * @retval     1     Match, the resource is not modified
+ * @retval     0     No match
+ * @retval    -1     Error
+ * Weak comparison is used, see RFC 7232 Sec 3.2
+ */
+static int
+api_data_etag_match(char *inm,
+		    char *etag)
+{
+    char **vec = NULL;
+    int    nvec;
+    char  *t;
+    size_t len;
+    int    match = 0;
+    int    i;
+
+    if (strcmp(clixon_trim(inm), "*") == 0)
+	return 1;
+    if ((vec = clicon_strsep(inm, ",", &nvec)) == NULL)
+	return -1;
+    len = strlen(etag);
+    for (i=0; i<nvec; i++){
+	t = clixon_trim(vec[i]);
+	if (strncmp(t, "W/", 2) == 0)
+	    t += 2;
+	if (strlen(t) == len+2 && t[0] == '"' && t[len+1] == '"' &&
+	    strncmp(t+1, etag, len) == 0){
+	    match = 1;
+	    break;
+	}
+    }
+    free(vec);
+    return match;
+}
+
+/*! Make the key of a GET reply in the reply cache, see CLICON_RESTCONF_GET_CACHE
+ * @param[in]  h         Clicon handle
+ * @param[in]  api_path  According to restconf (Sec 3.5.3.1 in rfc8040)
+ * @param[in]  qvec      Vector of query string (QUERY_STRING)
+ * @param[in]  pretty    Set to 1 for pretty-printed xml/json output
+ * @param[in]  media_out Output media
+ * @param[out] cb        Cache key
+ * The user is part of the key since NACM may give different replies to different users
+ */
+static void
+api_data_get_cache_key(clicon_handle  h,
+		       char          *api_path,
+		       cvec          *qvec,
+		       int            pretty,
+		       restconf_media media_out,
+		       cbuf          *cb)
+{
+    char   *user;
+    cg_var *cv = NULL;
+
+    user = clicon_username_get(h);
+    cprintf(cb, "%s %s %d %s?",
+	    user?user:"", restconf_media_int2str(media_out), pretty, api_path?api_path:"/");
+    while ((cv = cvec_each(qvec, cv)) != NULL)
+	cprintf(cb, "%s=%s&", cv_name_get(cv), cv_string_get(cv));
+}
+
+/*! Append the data of a get reply from the backend as is, without parsing it
+ * @param[in]  raw   Reply from backend: <rpc-reply ...><data>...</data></rpc-reply>
+ * @param[out] cb    The data element is appended, empty data as <data/>
+ * @retval     1     OK
+ * @retval     0     Not a plain data reply, eg an error: the reply must be parsed
+ * @see clicon_rpc_get_page_str
+ */
+static int
+api_data_get_relay(char *raw,
+		   cbuf *cb)
+{
+    char  *p;
+    char  *end;
+    size_t len;
+    size_t tlen = strlen("</rpc-reply>");
+
+    if (raw == NULL ||
+	strncmp(raw, "<rpc-reply", strlen("<rpc-reply")) != 0 ||
+	strstr(raw, "<rpc-error") != NULL)
+	return 0;
+    len = strlen(raw);
+    while (len && isspace(raw[len-1]))
+	len--;
+    if (len < tlen || strncmp(raw+len-tlen, "</rpc-reply>", tlen) != 0)
+	return 0;
+    end = raw + len - tlen;
+    if ((p = index(raw, '>')) == NULL || ++p > end)
+	return 0;
+    if (p == end) /* No data */
+	cprintf(cb, "<%s/>", NETCONF_OUTPUT_DATA);
+    else if (strncmp(p, "<data>", strlen("<data>")) == 0 ||
+	     strncmp(p, "<data/>", strlen("<data/>")) == 0)
+	cbuf_append_buf(cb, p, end-p);
+    else
+	return 0;
+    return 1;
+}
+
+/*! Add ETag and Last-Modified headers of a GET reply of datastore content
+ * @param[in]  req       Generic Www handle
+ * @param[in]  etag      Change token of running, if NULL no headers are added
+ * @param[in]  modified  Time of last change of running in seconds since epoch
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+api_data_get_cache_headers(void    *req,
+			   char    *etag,
+			   uint64_t modified)
+{
+    time_t    t = (time_t)modified;
+    struct tm tm;
+    char      date[64];
+
+    if (etag == NULL)
+	return 0;
+    if (restconf_reply_header(req, "ETag", "\"%s\"", etag) < 0)
+	return -1;
+    if (gmtime_r(&t, &tm) != NULL &&
+	strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm) > 0 &&
+	restconf_reply_header(req, "Last-Modified", "%s", date) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Send JSON encoded so far as a chunk of the GET reply, start reply if first chunk
+ * @param[in]  arg  Stream state
+ * @param[in]  cb   JSON encoded so far
+ * @see xml2json_stream
+ */
+static int
+api_data_get_flush(void *arg,
+		   cbuf *cb)
+{
+    int                retval = -1;
+    struct get_stream *gs = (struct get_stream *)arg;
+
+    if (!gs->gs_started){
+	if (restconf_reply_header(gs->gs_req, "Content-Type", "%s", restconf_media_int2str(gs->gs_media)) < 0)
+	    goto done;
+	if (restconf_reply_header(gs->gs_req, "Cache-Control", "no-cache") < 0)
+	    goto done;
+	if (api_data_get_cache_headers(gs->gs_req, gs->gs_etag, gs->gs_modified) < 0)
+	    goto done;
+	if (restconf_reply_chunk_start(gs->gs_req, 200) < 0)
+	    goto done;
+	gs->gs_started = 1;
+    }
+    if (restconf_reply_chunk(gs->gs_req, cb) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Generic GET (both HEAD and GET)
  * According to restconf 
  * @param[in]  h        Clixon handle
@@ -90,6 +282,12 @@
  * encoding is used in the response, then an error response containing a
  * "400 Bad Request" status-line MUST be returned by the server.
  * Netconf: <get-config>, <get>                        
+ * If the reply only contains config data, the change token of running is returned as
+ * ETag, and a request with a matching If-None-Match is replied with 304 Not Modified
+ * before the data is read from the backend. See RFC 8040 Sec 3.4.1 and RFC 7232.
+ * Such replies are also kept in a cache of encoded replies of the same change token,
+ * see CLICON_RESTCONF_GET_CACHE.
+ * The data root in non-pretty XML is relayed from the backend reply without parsing it
  */
 static int
 api_data_get2(clicon_handle  h,
@@ -119,15 +317,78 @@ api_data_get2(clicon_handle  h,
     char      *attr; /* attribute value string */
     netconf_content content = CONTENT_ALL;
     int32_t    depth = -1;  /* Nr of levels to print, -1 is all, 0 is none */
+    uint32_t   offset = 0;  /* Nr of list entries to skip */
+    uint32_t   limit = 0;   /* Max nr of list entries, 0 is all */
     cxobj     *xtop = NULL;
     cxobj     *xbot = NULL;
     yang_stmt *y = NULL;
+    uint32_t   chunk;
+    struct get_stream gs = {req, media_out, 0, NULL, 0};
+    char      *etag = NULL; /* Change token of running, malloced */
+    uint64_t   modified = 0;
+    char      *inm;
+    cbuf      *cbkey = NULL; /* Key of reply cache */
+    char      *raw = NULL;   /* Reply from backend as string */
+    int        relayed = 0;  /* Data in cbx relayed from raw */
     
     clicon_debug(1, "%s", __FUNCTION__);
+    /* JSON is streamed in chunks, see CLICON_RESTCONF_STREAM_CHUNK */
+    chunk = clicon_option_int(h, "CLICON_RESTCONF_STREAM_CHUNK");
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_FATAL, 0, "No DB_SPEC");
 	goto done;
     }
+    /* Check for list pagination attributes: limit and offset
+     * Sent to the backend, which returns only the page of the selected entries.
+     * Checked first since a list (or leaf-list) may then be the target as a whole */
+    if ((attr = cvec_find_str(qvec, "limit")) != NULL){
+	clicon_debug(1, "%s limit=%s", __FUNCTION__, attr);
+	if (strcmp(attr, "unbounded") != 0){
+	    char *reason = NULL;
+	    if ((ret = parse_uint32(attr, &limit, &reason)) < 0){
+		clicon_err(OE_XML, errno, "parse_uint32");
+		goto done;
+	    }
+	    if (reason)
+		free(reason);
+	    if (ret==0 || limit == 0){
+		if (netconf_bad_attribute_xml(&xerr, "application",
+					      "limit", "Unrecognized value of limit attribute") < 0)
+		    goto done;
+		if ((xe = xpath_first(xerr, NULL, "rpc-error")) == NULL){
+		    clicon_err(OE_XML, EINVAL, "rpc-error not found (internal error)");
+		    goto done;
+		}
+		if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
+		    goto done;
+		goto ok;
+	    }
+	}
+    }
+    if ((attr = cvec_find_str(qvec, "offset")) != NULL){
+	char *reason = NULL;
+	clicon_debug(1, "%s offset=%s", __FUNCTION__, attr);
+	if ((ret = parse_uint32(attr, &offset, &reason)) < 0){
+	    clicon_err(OE_XML, errno, "parse_uint32");
+	    goto done;
+	}
+	if (reason)
+	    free(reason);
+	if (ret==0){
+	    if (netconf_bad_attribute_xml(&xerr, "application",
+					  "offset", "Unrecognized value of offset attribute") < 0)
+		goto done;
+	    if ((xe = xpath_first(xerr, NULL, "rpc-error")) == NULL){
+		clicon_err(OE_XML, EINVAL, "rpc-error not found (internal error)");
+		goto done;
+	    }
+	    if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
+		goto done;
+	    goto ok;
+	}
+	if (limit == 0) /* offset without limit */
+	    limit = UINT32_MAX;
+    }
     /* strip /... from start */
     for (i=0; i<pi; i++)
 	api_path = index(api_path+1, '/');
@@ -135,9 +396,10 @@ api_data_get2(clicon_handle  h,
 	if ((xtop = xml_new("top", NULL, CX_ELMNT)) == NULL)
 	    goto done;
 	/* Translate api-path to xml, but to validate the api-path, note: strict=1 
+	 * unless paging, where list keys may be omitted to get entries of the list.
 	 * xtop and xbot unnecessary for this function but needed by function
 	 */
-	if ((ret = api_path2xml(api_path, yspec, xtop, YC_DATANODE, 1, &xbot, &y, &xerr)) < 0)
+	if ((ret = api_path2xml(api_path, yspec, xtop, YC_DATANODE, limit==0, &xbot, &y, &xerr)) < 0)
 	    goto done;
 	/* Translate api-path to xpath: xpath (cbpath) and namespace context (nsc) */
 	if (ret != 0 &&
@@ -193,13 +455,70 @@ api_data_get2(clicon_handle  h,
 	    }
 	}
     }
+    /* Entity tag if only config data, which only changes with running */
+    if (content == CONTENT_CONFIG ||
+	(content == CONTENT_ALL && y != NULL &&
+	 yang_config_ancestor(y) && api_data_config_only(y))){
+	if (clicon_rpc_datastore_token(h, "running", &etag, &modified) < 0)
+	    goto done;
+	if ((inm = restconf_param_get(h, "HTTP_IF_NONE_MATCH")) != NULL){
+	    if ((ret = api_data_etag_match(inm, etag)) < 0)
+		goto done;
+	    if (ret == 1){ /* Not modified: no data is read */
+		if (api_data_get_cache_headers(req, etag, modified) < 0)
+		    goto done;
+		if (restconf_reply_send(req, 304, NULL) < 0)
+		    goto done;
+		goto ok;
+	    }
+	}
+	gs.gs_etag = etag;
+	gs.gs_modified = modified;
+	/* Reply cache: same reply as long as running is not changed */
+	if (!head && clicon_option_int(h, "CLICON_RESTCONF_GET_CACHE") > 0){
+	    if ((cbkey = cbuf_new()) == NULL)
+		goto done;
+	    api_data_get_cache_key(h, api_path, qvec, pretty, media_out, cbkey);
+	    if ((cbx = cbuf_new()) == NULL)
+		goto done;
+	    if ((ret = restconf_get_cache_find(h, cbuf_get(cbkey), etag, cbx)) < 0)
+		goto done;
+	    if (ret == 1){ /* Cached: no data is read or encoded */
+		clicon_debug(1, "%s cached:%s", __FUNCTION__, cbuf_get(cbkey));
+		if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
+		    goto done;
+		if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+		    goto done;
+		if (api_data_get_cache_headers(req, etag, modified) < 0)
+		    goto done;
+		if (restconf_reply_send(req, 200, cbx) < 0)
+		    goto done;
+		goto ok;
+	    }
+	}
+    }
 
     clicon_debug(1, "%s path:%s", __FUNCTION__, xpath);
     switch (content){
     case CONTENT_CONFIG:
     case CONTENT_NONCONFIG:
     case CONTENT_ALL:
-	ret = clicon_rpc_get(h, xpath, nsc, content, depth, &xret);
+	if ((xpath==NULL || strcmp(xpath,"/")==0) &&
+	    media_out == YANG_DATA_XML && !pretty && !head){
+	    /* Data root is printed as received, no need to parse and bind the reply */
+	    if ((ret = clicon_rpc_get_page_str(h, xpath, nsc, NULL,
+					       content, depth, offset, limit, &raw)) < 0)
+		break;
+	    if (cbx == NULL && (cbx = cbuf_new()) == NULL)
+		goto done;
+	    if ((relayed = api_data_get_relay(raw, cbx)) == 1)
+		break;
+	}
+	/* The api-path is also sent so that the backend can look up config by list keys,
+	 * but not percent-encoded key values since they are not decoded by api_path_parse */
+	ret = clicon_rpc_get_page(h, xpath, nsc,
+				  (limit==0 && api_path && strchr(api_path, '%')==NULL)?api_path:NULL,
+				  content, depth, offset, limit, &xret);
 	break;
     default:
 	clicon_err(OE_XML, EINVAL, "Invalid content attribute %d", content);
@@ -225,13 +544,14 @@ api_data_get2(clicon_handle  h,
 	clicon_log_xml(LOG_DEBUG, xret, "%s xret:", __FUNCTION__);
 #endif
     /* Check if error return  */
-    if ((xe = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+    if (!relayed &&
+	(xe = xpath_first(xret, NULL, "//rpc-error")) != NULL){
 	if (api_return_err(h, req, xe, pretty, media_out, 0) < 0)
 	    goto done;
 	goto ok;
     }
     /* Normal return, no error */
-    if ((cbx = cbuf_new()) == NULL)
+    if (cbx == NULL && (cbx = cbuf_new()) == NULL)
 	goto done;
     if (head){
 	/* Same headers as the GET, but no body */
@@ -239,18 +559,26 @@ api_data_get2(clicon_handle  h,
 	    goto done;
 	if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
 	    goto done;
+	if (api_data_get_cache_headers(req, etag, modified) < 0)
+	    goto done;
 	if (restconf_reply_send(req, 200, NULL) < 0)
 	    goto done;
 	goto ok;
     }
-    if (xpath==NULL || strcmp(xpath,"/")==0){ /* Special case: data root */
+    if (relayed)
+	clicon_debug(1, "%s data relayed from backend", __FUNCTION__);
+    else if (xpath==NULL || strcmp(xpath,"/")==0){ /* Special case: data root */
 	switch (media_out){
 	case YANG_DATA_XML:
 	    if (clicon_xml2cbuf(cbx, xret, 0, pretty, -1) < 0) /* Dont print top object?  */
 		goto done;
 	    break;
 	case YANG_DATA_JSON:
-	    if (xml2json_cbuf(cbx, xret, pretty) < 0)
+	    if (chunk > 0){
+		if (xml2json_stream(cbx, xret, pretty, chunk, api_data_get_flush, &gs) < 0)
+		    goto done;
+	    }
+	    else if (xml2json_cbuf(cbx, xret, pretty) < 0)
 		goto done;
 	    break;
 	default:
@@ -305,24 +633,47 @@ api_data_get2(clicon_handle  h,
 	    /* In: <x xmlns="urn:example:clixon">0</x>
 	     * Out: {"example:x": {"0"}}
 	     */
-	    if (xml2json_cbuf_vec(cbx, xvec, xlen, pretty) < 0)
+	    if (chunk > 0){
+		if (xml2json_stream_vec(cbx, xvec, xlen, pretty, chunk, api_data_get_flush, &gs) < 0)
+		    goto done;
+	    }
+	    else if (xml2json_cbuf_vec(cbx, xvec, xlen, pretty) < 0)
 		goto done;
 	    break;
 	default:
 	    break;
 	}
     }
+    if (gs.gs_started){ /* Streamed: send the remainder as last chunk */
+	cprintf(cbx, "\r\n");
+	if (restconf_reply_chunk(req, cbx) < 0)
+	    goto done;
+	if (restconf_reply_chunk_end(req) < 0)
+	    goto done;
+	goto ok;
+    }
     clicon_debug(1, "%s cbuf:%s", __FUNCTION__, cbuf_get(cbx));
     if (restconf_reply_header(req, "Content-Type", "%s", restconf_media_int2str(media_out)) < 0)
 	goto done;
     if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
 	goto done;
+    if (api_data_get_cache_headers(req, etag, modified) < 0)
+	goto done;
+    /* Before send since a line end is added to the body */
+    if (cbkey && restconf_get_cache_add(h, cbuf_get(cbkey), etag, cbuf_get(cbx)) < 0)
+	goto done;
     if (restconf_reply_send(req, 200, cbx) < 0)
 	goto done;
  ok:
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (etag)
+	free(etag);
+    if (cbkey)
+	cbuf_free(cbkey);
+    if (raw)
+	free(raw);
     if (xpath)
 	free(xpath);
     if (nsc)
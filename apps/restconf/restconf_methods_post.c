@@ -67,48 +67,32 @@
 
 /*! Print location header from 
  * @param[in]  req    Generic Www handle
- * @param[in]  xobj   If set (eg POST) add to api-path
+ * @param[in]  path   If set (eg POST) api-path of object added to request uri
  * $https  “on” if connection operates in SSL mode, or an empty string otherwise 
  * @note ports are ignored
+ * @see xml2api_path_1  To get api-path of object
  */
 static int
 http_location_header(clicon_handle h,
 		     void         *req,
-		     cxobj        *xobj)
+		     char         *path)
 {
     int   retval = -1;
     char *https;
     char *host;
     char *request_uri;
-    cbuf *cb = NULL;
 
     https = restconf_param_get(h, "HTTPS");
     host = restconf_param_get(h, "HTTP_HOST");
     request_uri = restconf_param_get(h, "REQUEST_URI");
-    if (xobj != NULL){
-	if ((cb = cbuf_new()) == NULL){
-	    clicon_err(OE_UNIX, 0, "cbuf_new");
-	    goto done;
-	}
-	if (xml2api_path_1(xobj, cb) < 0)
-	    goto done;
-	if (restconf_reply_header(req, "Location", "http%s://%s%s%s",
-				  https?"s":"",
-				  host,
-				  request_uri,
-				  cbuf_get(cb)) < 0)
-	    goto done;
-    }
-    else
-	if (restconf_reply_header(req, "Location", "http%s://%s%s",
-				  https?"s":"",
-				  host,
-				  request_uri) < 0)
-	    goto done;
+    if (restconf_reply_header(req, "Location", "http%s://%s%s%s",
+			      https?"s":"",
+			      host,
+			      request_uri,
+			      path?path:"") < 0)
+	goto done;
     retval = 0;
  done:
-    if (cb)
-	cbuf_free(cb);
     return retval;
 }
 
@@ -178,6 +162,8 @@ api_data_post(clicon_handle h,
     restconf_media media_in;
     int            nrchildren0 = 0;
     yang_bind      yb;
+    int            forward;      /* Forward original body, see restconf_edit_body_xml */
+    cbuf          *cbloc = NULL; /* api-path of new object for location header */
     
     clicon_debug(1, "%s api_path:\"%s\"", __FUNCTION__, api_path);
     clicon_debug(1, "%s data:\"%s\"", __FUNCTION__, data);
@@ -312,6 +298,8 @@ api_data_post(clicon_handle h,
 	}
 	xdata = x;
     }
+    /* Check before attributes are added */
+    forward = restconf_edit_body_forward(media_in, xdata, qvec);
 
     /* Add operation (create/replace) as attribute */
     if ((xa = xml_new("operation", xdata, CX_ATTR)) == NULL)
@@ -362,6 +350,13 @@ api_data_post(clicon_handle h,
 	clicon_log_xml(LOG_DEBUG, xdata, "%s xdata:", __FUNCTION__);
 #endif
 
+    /* Location of new object, before xdata may be freed */
+    if ((cbloc = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, 0, "cbuf_new");
+	goto done;
+    }
+    if (xml2api_path_1(xdata, cbloc) < 0)
+	goto done;
     /* Create text buffer for transfer to backend */
     if ((cbx = cbuf_new()) == NULL){
 	clicon_err(OE_UNIX, 0, "cbuf_new");
@@ -388,7 +383,12 @@ api_data_post(clicon_handle h,
     cprintf(cbx, " autocommit=\"true\"");
     cprintf(cbx, "><target><candidate /></target>");
     cprintf(cbx, "<default-operation>none</default-operation>");
-    if (clicon_xml2cbuf(cbx, xtop, 0, 0, -1) < 0)
+    if (forward){ /* Original XML body instead of serialized xdata, xdata is freed */
+	if (restconf_edit_body_xml(cbx, xtop, xdata, data, " " NETCONF_BASE_PREFIX ":operation=\"create\"") < 0)
+	    goto done;
+	xdata = NULL;
+    }
+    else if (clicon_xml2cbuf(cbx, xtop, 0, 0, -1) < 0)
 	goto done;
     cprintf(cbx, "</edit-config></rpc>");
     clicon_debug(1, "%s xml: %s api_path:%s",__FUNCTION__, cbuf_get(cbx), api_path);
@@ -399,7 +399,7 @@ api_data_post(clicon_handle h,
 	    goto done;
 	goto ok;
     }
-    if (http_location_header(h, req, xdata) < 0)
+    if (http_location_header(h, req, cbuf_get(cbloc)) < 0)
 	goto done;
     if (restconf_reply_send(req, 201, NULL) < 0)
 	goto done;	
@@ -417,6 +417,8 @@ api_data_post(clicon_handle h,
 	xml_free(xretdis);
     if (xtop)
 	xml_free(xtop);
+    if (cbloc)
+	cbuf_free(cbloc);
      if (cbx)
 	cbuf_free(cbx); 
    return retval;
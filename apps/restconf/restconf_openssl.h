@@ -69,6 +69,32 @@ typedef struct {
     int           rs_ssl;   /* 0: Not SSL socket, 1:SSL socket */
 } restconf_socket;
 
+/* Restconf connection
+ * Per accepted client socket, kept over several requests using HTTP/1.1 keep-alive
+ */
+typedef struct {
+    qelem_t             rc_qelem; /* List header */
+    clicon_handle       rc_h;     /* Clixon handle */
+    int                 rc_s;     /* Client socket */
+    evhtp_connection_t *rc_conn;  /* Evhtp connection */
+    int                 rc_wait;  /* Output pending, wait for socket writable, input paused */
+    int                 rc_close; /* Close connection when all output is written */
+    int                 rc_stream; /* Event stream reply open, see api_stream */
+#ifdef CLIXON_RESTCONF_HTTP2
+    struct restconf_h2 *rc_h2;    /* HTTP/2 session if h2 is used, see restconf_http2.c */
+    int                 rc_h2_checked; /* First data checked for HTTP/2 client preface */
+#endif
+} restconf_conn;
+
+/* TLS session ticket key, rotated, see restconf_ticket_key_cb
+ */
+typedef struct {
+    unsigned char tk_name[16];  /* Key name, sent in clear in ticket */
+    unsigned char tk_aes[32];   /* AES-256 encryption key */
+    unsigned char tk_hmac[32];  /* HMAC-SHA256 key */
+    time_t        tk_created;   /* When key was created, 0 if not set */
+} restconf_ticket_key;
+
 /* Restconf handle 
  * Global data about ssl (not per packet/request)
  */
@@ -76,12 +102,22 @@ typedef struct {
     SSL_CTX         *rh_ctx;       /* SSL context */
     evhtp_t         *rh_evhtp;     /* Evhtp struct */
     restconf_socket *rh_sockets;   /* List of restconf server (ready for accept) sockets */
+    restconf_conn   *rh_conns;     /* List of accepted client connections */
+    restconf_ticket_key rh_tickets[2]; /* Current and previous session ticket key */
+    uint32_t         rh_ticket_rotate; /* Ticket key rotation interval in seconds */
+    uint64_t         rh_tls_full;    /* Nr of full TLS handshakes */
+    uint64_t         rh_tls_resumed; /* Nr of resumed TLS handshakes */
+    uint32_t         rh_workers;   /* Nr of worker processes sharing server ports */
 } restconf_handle;
 
 /*
  * Prototypes
  */
 int restconf_parse(void *req, const char *buf, size_t buflen);
+restconf_conn *restconf_conn_find(clicon_handle h, evhtp_connection_t *conn);
+int restconf_output_flush(restconf_conn *rc);
+int restconf_stream_conn_close(restconf_conn *rc);
+int restconf_stream_freeall(clicon_handle h);
 
 #endif /* _RESTCONF_OPENSSL_H_ */
 
@@ -373,6 +373,40 @@ api_operations(clicon_handle h,
     return retval;
 }
 
+/*! Set trace id of a restconf request
+ * The trace-id of a W3C traceparent header is used if present and valid, eg
+ *   traceparent: 00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01
+ * otherwise a new trace id is created. Only the last 64 bits of the trace-id are used.
+ * @param[in]  h         Clicon handle
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+restconf_trace_id(clicon_handle h)
+{
+    int      retval = -1;
+    char    *tp;
+    char   **vec = NULL;
+    int      nvec = 0;
+    uint64_t id = 0;
+
+    if ((tp = restconf_param_get(h, "HTTP_TRACEPARENT")) != NULL){
+	if ((vec = clicon_strsep(tp, "-", &nvec)) == NULL)
+	    goto done;
+	if (nvec < 2 || strlen(vec[1]) != 32 ||
+	    clixon_trace_id_parse(vec[1], &id) == 0)
+	    id = 0;
+    }
+    if (id == 0)
+	id = clixon_trace_id_new();
+    clixon_trace_id_set(id);
+    retval = 0;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+}
+
 /*! Process a /restconf root input, this is the root of the restconf processing
  * @param[in]  h         Clicon handle
  * @param[in]  req       Generic Www handle (can be part of clixon handle)
@@ -398,12 +432,16 @@ api_root_restconf(clicon_handle        h,
     char          *indata = NULL;
     char          *username = NULL;
     int            ret;
+    struct timespec t0;
 
     clicon_debug(1, "%s", __FUNCTION__);
+    clixon_trace_start(&t0);
     if (req == NULL){
 	errno = EINVAL;
 	goto done;
     }
+    if (clixon_trace_enabled() && restconf_trace_id(h) < 0)
+	goto done;
     request_method = restconf_param_get(h, "REQUEST_METHOD");
     path = restconf_uripath(h);
     /* XXX see restconf_config_init access directly */
@@ -521,6 +559,8 @@ api_root_restconf(clicon_handle        h,
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    clixon_trace_end(&t0, "restconf", request_method);
+    clixon_trace_id_set(0);
     if (username)
 	free(username);
     if (pcvec)
@@ -0,0 +1,511 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  Restconf event stream implementation for native restconf.
+  See RFC 8040  RESTCONF Protocol
+  Sections 3.8, 6, 9.3
+
+   * Streams are served in the single event loop of the native restconf daemon, there
+   * is no fork per stream as in the fcgi variant.
+   * A backend subscription is shared by all clients of the same stream without
+   * start-time or stop-time query parameters. Each notification from the backend is
+   * formatted once and written as a server-sent event to all its clients.
+   * A client with start-time or stop-time gets a subscription of its own, since replay
+   * and stop are per subscription in the backend.
+   * A subscription is closed when its last client is closed, and all its clients are
+   * ended when the backend closes it.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <syslog.h>
+#include <time.h>
+
+#include <openssl/ssl.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+/* evhtp */
+#define EVHTP_DISABLE_REGEX
+#define EVHTP_DISABLE_EVTHR
+#define EVHTP_EXPORT
+#include <evhtp/evhtp.h>
+
+/* restconf */
+#include "restconf_lib.h"
+#include "restconf_handle.h"
+#include "restconf_api.h"
+#include "restconf_err.h"
+#include "restconf_stream.h"
+#include "restconf_openssl.h"
+
+/* A client of a stream subscription, ie an open stream request
+ */
+struct stream_client{
+    qelem_t          sc_qelem; /* List header */
+    evhtp_request_t *sc_req;   /* Evhtp request of the stream reply */
+    restconf_conn   *sc_rc;    /* Restconf connection of the request */
+};
+
+/* A backend subscription of a stream shared by one or several clients
+ */
+struct stream_sub{
+    qelem_t               ss_qelem;   /* List header */
+    char                 *ss_name;    /* Stream name if shared, NULL if dedicated */
+    int                   ss_s;       /* Backend notification socket */
+    struct stream_client *ss_clients; /* Clients of this subscription */
+    int                   ss_busy;    /* Notification is sent, do not free, see stream_native_cb */
+};
+
+/* Linked list of backend subscriptions
+ * @note could hang STREAM_SUB list on restconf handle instead.
+ */
+static struct stream_sub *STREAM_SUB = NULL;
+
+static int stream_native_cb(int s, void *arg);
+
+/*! Close backend socket of a subscription and free it
+ * @param[in]  ss   Stream subscription
+ */
+static int
+stream_sub_free(struct stream_sub *ss)
+{
+    struct stream_client *sc;
+
+    clicon_debug(1, "%s %s", __FUNCTION__, ss->ss_name?ss->ss_name:"");
+    DELQ(ss, STREAM_SUB, struct stream_sub *);
+    while ((sc = ss->ss_clients) != NULL){
+	DELQ(sc, ss->ss_clients, struct stream_client *);
+	free(sc);
+    }
+    if (ss->ss_s != -1){
+	clixon_event_unreg_fd(ss->ss_s, stream_native_cb);
+	close(ss->ss_s);
+    }
+    if (ss->ss_name)
+	free(ss->ss_name);
+    free(ss);
+    return 0;
+}
+
+/*! End the stream replies of all clients of a subscription
+ * Used when the backend closes the subscription, eg stop-time or backend exit
+ * @param[in]  ss   Stream subscription
+ */
+static int
+stream_sub_end(struct stream_sub *ss)
+{
+    int                   retval = -1;
+    struct stream_client *sc;
+    restconf_conn       **rcvec = NULL;
+    int                   n = 0;
+    int                   i;
+
+    if ((sc = ss->ss_clients) != NULL){
+	do {
+	    n++;
+	    sc = NEXTQ(struct stream_client *, sc);
+	} while (sc && sc != ss->ss_clients);
+    }
+    if (n && (rcvec = calloc(n, sizeof(restconf_conn *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    /* Take the clients first, so that closing a connection does not find them */
+    i = 0;
+    while ((sc = ss->ss_clients) != NULL){
+	DELQ(sc, ss->ss_clients, struct stream_client *);
+	restconf_reply_chunk_end(sc->sc_req);
+	sc->sc_rc->rc_stream = 0;
+	rcvec[i++] = sc->sc_rc;
+	free(sc);
+    }
+    for (i=0; i<n; i++)
+	if (restconf_output_flush(rcvec[i]) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    if (rcvec)
+	free(rcvec);
+    return retval;
+}
+
+/*! Callback when stream notifications arrive from backend
+ * The notification is formatted once and written to all clients of the subscription
+ * @param[in]  s    Backend notification socket
+ * @param[in]  arg  Stream subscription
+ */
+static int
+stream_native_cb(int   s, 
+		 void *arg)
+{
+    int                   retval = -1;
+    struct stream_sub    *ss = (struct stream_sub *)arg;
+    struct stream_client *sc;
+    int                   eof;
+    struct clicon_msg    *reply = NULL;
+    cxobj                *xtop = NULL; /* top xml */
+    cxobj                *xn;        /* notification xml */
+    cbuf                 *cb = NULL;
+    restconf_conn       **rcvec = NULL;
+    int                   n = 0;
+    int                   i;
+    int                   ret;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    if (clicon_msg_rcv(s, &reply, &eof) < 0){
+	clicon_debug(1, "%s msg_rcv error", __FUNCTION__);
+	goto done;
+    }
+    if (eof){ /* Subscription closed by backend */
+	clicon_debug(1, "%s eof", __FUNCTION__);
+	if (stream_sub_end(ss) < 0)
+	    goto done;
+	stream_sub_free(ss);
+	goto ok;
+    }
+    clicon_debug(1, "%s msg: %s", __FUNCTION__, reply?reply->op_body:"null");
+    if ((ret = clicon_msg_decode(reply, NULL, NULL, &xtop, NULL)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_XML, EFAULT, "Invalid notification");
+	goto done;
+    }
+    if ((xn = xpath_first(xtop, NULL, "notification")) == NULL)
+	goto ok;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "data: ");
+    if (clicon_xml2cbuf(cb, xn, 0, 0, -1) < 0)
+	goto done;
+    cprintf(cb, "\r\n\r\n");
+    /* Add event to all clients, then write (which may close connections) */
+    if ((sc = ss->ss_clients) != NULL){
+	do {
+	    if (restconf_reply_chunk(sc->sc_req, cb) < 0)
+		goto done;
+	    n++;
+	    sc = NEXTQ(struct stream_client *, sc);
+	} while (sc && sc != ss->ss_clients);
+    }
+    if (n && (rcvec = calloc(n, sizeof(restconf_conn *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    i = 0;
+    if ((sc = ss->ss_clients) != NULL){
+	do {
+	    rcvec[i++] = sc->sc_rc;
+	    sc = NEXTQ(struct stream_client *, sc);
+	} while (sc && sc != ss->ss_clients);
+    }
+    ss->ss_busy = 1;
+    for (i=0; i<n; i++)
+	if (restconf_output_flush(rcvec[i]) < 0)
+	    break;
+    ss->ss_busy = 0;
+    if (i < n)
+	goto done;
+    if (ss->ss_clients == NULL) /* All clients closed during write */
+	stream_sub_free(ss);
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval: %d", __FUNCTION__, retval);
+    if (rcvec)
+	free(rcvec);
+    if (xtop != NULL)
+	xml_free(xtop);
+    if (reply)
+	free(reply);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Find a shared subscription of a stream
+ * @param[in]  name  Stream name
+ * @retval     ss    Stream subscription
+ * @retval     NULL  Not found
+ */
+static struct stream_sub *
+stream_sub_find(char *name)
+{
+    struct stream_sub *ss;
+
+    if ((ss = STREAM_SUB) != NULL){
+	do {
+	    if (ss->ss_name && strcmp(ss->ss_name, name) == 0)
+		return ss;
+	    ss = NEXTQ(struct stream_sub *, ss);
+	} while (ss && ss != STREAM_SUB);
+    }
+    return NULL;
+}
+
+/*! Send subscription to backend and create a stream subscription
+ * @param[in]  h      Clicon handle
+ * @param[in]  req    Evhtp http request
+ * @param[in]  name   Stream name
+ * @param[in]  qvec   Query parameters, start-time and stop-time
+ * @param[in]  shared If set, subscription may be shared by other clients
+ * @param[in]  pretty Pretty-print of error reply
+ * @param[out] ssp    Stream subscription, NULL if error reply is sent
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+stream_sub_create(clicon_handle      h,
+		  evhtp_request_t   *req,
+		  char              *name,
+		  cvec              *qvec,
+		  int                shared,
+		  int                pretty,
+		  struct stream_sub **ssp)
+{
+    int                retval = -1;
+    cxobj             *xret = NULL;
+    cxobj             *xe;
+    cbuf              *cb = NULL;
+    int                s = -1;
+    int                i;
+    cg_var            *cv;
+    char              *vname;
+    struct stream_sub *ss;
+
+    *ssp = NULL;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<rpc xmlns=\"%s\"><create-subscription xmlns=\"%s\"><stream>%s</stream>",
+	    NETCONF_BASE_NAMESPACE, EVENT_RFC5277_NAMESPACE, name);
+    for (i=0; i<cvec_len(qvec); i++){
+        cv = cvec_i(qvec, i);
+	vname = cv_name_get(cv);
+	if (strcmp(vname, "start-time") == 0){
+	    cprintf(cb, "<startTime>");
+	    cv2cbuf(cv, cb);
+	    cprintf(cb, "</startTime>");
+	}
+	else if (strcmp(vname, "stop-time") == 0){
+	    cprintf(cb, "<stopTime>");
+	    cv2cbuf(cv, cb);
+	    cprintf(cb, "</stopTime>");
+	}
+    }
+    cprintf(cb, "</create-subscription></rpc>]]>]]>");
+    if (clicon_rpc_netconf(h, cbuf_get(cb), &xret, &s) < 0)
+	goto done;
+    if ((xe = xpath_first(xret, NULL, "rpc-reply/rpc-error")) != NULL){
+	if (api_return_err(h, req, xe, pretty, YANG_DATA_XML, 0) < 0)
+	    goto done;
+	goto ok;
+    }
+    if ((ss = malloc(sizeof(*ss))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(ss, 0, sizeof(*ss));
+    ss->ss_s = s;
+    s = -1;
+    ADDQ(ss, STREAM_SUB);
+    if (shared && (ss->ss_name = strdup(name)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	stream_sub_free(ss);
+	goto done;
+    }
+    if (clixon_event_reg_fd(ss->ss_s, stream_native_cb, ss, "stream socket") < 0){
+	stream_sub_free(ss);
+	goto done;
+    }
+    *ssp = ss;
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval: %d", __FUNCTION__, retval);
+    if (s != -1)
+	close(s);
+    if (xret)
+	xml_free(xret);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Process a stream request
+ * The reply is kept open as a chunked server-sent event stream, see stream_native_cb
+ * @param[in]  h          Clicon handle
+ * @param[in]  req        Generic Www handle (can be part of clixon handle)
+ * @param[in]  qvec       Query parameters, ie the ?<id>=<val>&<id>=<val> stuff
+ * @param[in]  streampath URI path for streams, eg /streams, see CLICON_STREAM_PATH
+ * @param[out] finish 	  Set to zero if a stream is started
+ */
+int
+api_stream(clicon_handle h,
+	   void         *req0,
+	   cvec         *qvec,
+	   char         *streampath,
+	   int          *finish)
+{
+    int                   retval = -1;
+    evhtp_request_t      *req = (evhtp_request_t *)req0;
+    char                 *path;
+    char                 *name;
+    char                **pvec = NULL;
+    int                   pn;
+    int                   pretty;
+    restconf_media        media_out = YANG_DATA_XML;
+    restconf_conn        *rc;
+    struct stream_sub    *ss = NULL;
+    struct stream_client *sc;
+    int                   shared;
+    int                   ret;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    path = restconf_uripath(h);
+    pretty = clicon_option_bool(h, "CLICON_RESTCONF_PRETTY");
+    if ((pvec = clicon_strsep(path, "/", &pn)) == NULL)
+	goto done;
+    /* Sanity check of path. Should be /stream/<name> */
+    if (pn != 3 || strlen(pvec[0]) != 0 || strcmp(pvec[1], streampath) ||
+	(name = pvec[2]) == NULL || strlen(name) == 0){
+	if (restconf_notfound(h, req) < 0)
+	    goto done;
+	goto ok;
+    }
+    clicon_debug(1, "%s: stream=%s", __FUNCTION__, name);
+    if ((rc = restconf_conn_find(h, req->conn)) == NULL){
+	clicon_err(OE_RESTCONF, EFAULT, "No restconf connection");
+	goto done;
+    }
+    /* If present, check credentials. See "plugin_credentials" in plugin  
+     * See RFC 8040 section 2.5
+     */
+    if ((ret = restconf_authentication_cb(h, req, pretty, media_out)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    shared = cvec_find(qvec, "start-time") == NULL && cvec_find(qvec, "stop-time") == NULL;
+    if (!shared || (ss = stream_sub_find(name)) == NULL){
+	if (stream_sub_create(h, req, name, qvec, shared, pretty, &ss) < 0)
+	    goto done;
+	if (ss == NULL) /* Error reply sent */
+	    goto ok;
+    }
+    if ((sc = malloc(sizeof(*sc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(sc, 0, sizeof(*sc));
+    sc->sc_req = req;
+    sc->sc_rc = rc;
+    ADDQ(sc, ss->ss_clients);
+    rc->rc_stream = 1;
+    /* Setting up stream */
+    if (restconf_reply_header(req, "Content-Type", "text/event-stream") < 0)
+	goto done;
+    if (restconf_reply_header(req, "Cache-Control", "no-cache") < 0)
+	goto done;
+    if (restconf_reply_header(req, "Connection", "keep-alive") < 0)
+	goto done;
+    if (restconf_reply_header(req, "X-Accel-Buffering", "no") < 0)
+	goto done;
+    if (restconf_reply_chunk_start(req, 200) < 0)
+	goto done;
+    *finish = 0;
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (pvec)
+	free(pvec);
+    return retval;
+}
+
+/*! Remove the stream client of a restconf connection being closed
+ * A subscription without clients is closed, unless a notification is being sent
+ * @param[in]  rc   Restconf connection
+ * @see restconf_conn_close
+ */
+int
+restconf_stream_conn_close(restconf_conn *rc)
+{
+    struct stream_sub    *ss;
+    struct stream_client *sc;
+
+    if (rc->rc_stream == 0 || (ss = STREAM_SUB) == NULL)
+	return 0;
+    rc->rc_stream = 0;
+    do {
+	if ((sc = ss->ss_clients) != NULL){
+	    do {
+		if (sc->sc_rc == rc){ /* Only one stream request per connection */
+		    DELQ(sc, ss->ss_clients, struct stream_client *);
+		    free(sc);
+		    if (ss->ss_clients == NULL && !ss->ss_busy)
+			stream_sub_free(ss);
+		    return 0;
+		}
+		sc = NEXTQ(struct stream_client *, sc);
+	    } while (sc && sc != ss->ss_clients);
+	}
+	ss = NEXTQ(struct stream_sub *, ss);
+    } while (ss && ss != STREAM_SUB);
+    return 0;
+}
+
+/*! Close all stream subscriptions
+ * @param[in]  h   Clicon handle
+ */
+int
+restconf_stream_freeall(clicon_handle h)
+{
+    struct stream_sub *ss;
+
+    while ((ss = STREAM_SUB) != NULL)
+	stream_sub_free(ss);
+    return 0;
+}
@@ -55,6 +55,7 @@
 #include <syslog.h>
 #include <fcntl.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 
 /* clicon */
 #include <cligen/cligen.h>
@@ -66,7 +67,7 @@
 #include <clixon/clixon_backend.h> 
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_EXAMPLE_OPTS "rsS:iuUt:v:"
+#define BACKEND_EXAMPLE_OPTS "rsS:iuUt:v:a:kp:Px:"
 
 /*! Variable to control if reset code is run.
  * The reset code inserts "extra XML" which assumes ietf-interfaces is
@@ -94,6 +95,20 @@ static char *_state_file = NULL;
 static int _state_file_init = 0;
 static cxobj *_state_xstate = NULL;
 
+/*! Asynchronous state: fetching state is simulated to take this many ms (requires -s)
+ * See example_statedata_start
+ * Start backend with -- -sa <ms>
+ */
+static int   _state_async_ms = -1;
+static int   _state_async_fd = -1;  /* Readable when simulated fetch is done */
+static pid_t _state_async_pid = 0;  /* Process simulating fetch */
+
+/*! Register statedata callback for /table/parameter, see example_statedata_parameter
+ * Start backend with -- -k
+ */
+static int   _state_keys = 0;
+static int   _state_keys_nr = 0; /* Number of calls, returned as stat */
+
 /*! Variable to control module-specific upgrade callbacks.
  * If set, call test-case for upgrading ietf-interfaces, otherwise call 
  * auto-upgrade
@@ -119,6 +134,17 @@ static int _transaction_log = 0;
 static char *_validate_fail_xpath = NULL;
 static int   _validate_fail_toggle = 0; /* fail at validate and commit */
 
+/*! Validate and commit callbacks are parallel-safe, see ca_trans_parallel
+ * Commit takes the given number of seconds, to test that plugins commit concurrently
+ * Start backend with -- -p <s>
+ */
+static int _parallel_sleep = 0;
+
+/*! Crash in commit callback if xpath matches target, requires a plugin process (-P)
+ * Start backend with -- -P -x <xpath>
+ */
+static char *_commit_crash_xpath = NULL;
+
 /* forward */
 static int example_stream_timer_setup(clicon_handle h);
 
@@ -172,6 +198,11 @@ main_commit(clicon_handle    h,
 
     if (_transaction_log)
 	transaction_log(h, td, LOG_NOTICE, __FUNCTION__);
+    if (_parallel_sleep)
+	sleep(_parallel_sleep);
+    if (_commit_crash_xpath &&
+	xpath_first(target, NULL, "%s", _commit_crash_xpath))
+	abort();
 
     if (_validate_fail_xpath){
 	if (_validate_fail_toggle==1 &&
@@ -326,6 +357,96 @@ example_rpc(clicon_handle h,            /* Clicon handle */
     return retval;
 }
 
+/* Pending reply of async rpc, see example_async_rpc */
+struct example_async{
+    clicon_handle     ea_h;
+    struct rpc_async *ea_ra;    /* Reply token */
+    cbuf             *ea_reply; /* Reply sent when timer expires */
+};
+
+/*! Timer of async rpc expired: send the reply
+ */
+static int
+example_async_timer(int   fd,
+		    void *arg)
+{
+    struct example_async *ea = (struct example_async *)arg;
+    int                   retval;
+
+    retval = rpc_async_reply(ea->ea_h, ea->ea_ra, cbuf_get(ea->ea_reply));
+    cbuf_free(ea->ea_reply);
+    free(ea);
+    return retval;
+}
+
+/*! Client of async rpc closed before reply: stop timer
+ */
+static int
+example_async_cancel(clicon_handle h,
+		     void         *arg)
+{
+    struct example_async *ea = (struct example_async *)arg;
+
+    clixon_event_unreg_timeout(example_async_timer, ea);
+    cbuf_free(ea->ea_reply);
+    free(ea);
+    return 0;
+}
+
+/*! Asynchronous RPC, replies the incoming parameters after a delay
+ * Emulates a long-running operation, eg ping, without blocking other clients
+ */
+static int 
+example_async_rpc(clicon_handle h,            /* Clicon handle */
+		  cxobj        *xe,           /* Request: <rpc><xn></rpc> */
+		  cbuf         *cbret,        /* Reply eg <rpc-reply>... */
+		  void         *arg,          /* client_entry */
+		  void         *regarg)       /* Argument given at register */
+{
+    int                   retval = -1;
+    struct example_async *ea = NULL;
+    cxobj                *xd;
+    struct timeval        t;
+    struct timeval        t1;
+    int                   ms = 0;
+
+    if ((ea = malloc(sizeof(*ea))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(ea, 0, sizeof(*ea));
+    ea->ea_h = h;
+    if ((ea->ea_reply = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((xd = xml_find_type(xe, NULL, "delay", CX_ELMNT)) != NULL){
+	ms = atoi(xml_body(xd));
+	xml_purge(xd);
+    }
+    /* Same reply as example rpc */
+    if (example_rpc(h, xe, ea->ea_reply, arg, regarg) < 0)
+	goto done;
+    if ((ea->ea_ra = rpc_async_start(h, arg)) == NULL)
+	goto done;
+    rpc_async_cancel_set(ea->ea_ra, example_async_cancel, ea);
+    gettimeofday(&t, NULL);
+    t1.tv_sec = ms/1000;
+    t1.tv_usec = (ms%1000)*1000;
+    timeradd(&t, &t1, &t);
+    if (clixon_event_reg_timeout(t, example_async_timer, ea, "example async rpc") < 0)
+	goto done;
+    ea = NULL;
+    retval = 0;
+ done:
+    if (ea){
+	if (ea->ea_reply)
+	    cbuf_free(ea->ea_reply);
+	free(ea);
+    }
+    return retval;
+}
+
 /*! This will be called as a hook right after the original system copy-config
  */
 static int 
@@ -343,6 +464,138 @@ example_copy_extra(clicon_handle h,            /* Clicon handle */
     return retval;
 }
 
+/*! Discard outstanding asynchronous state fetch, if any
+ */
+static void
+example_statedata_async_reset(void)
+{
+    int status;
+    
+    if (_state_async_fd != -1){
+	close(_state_async_fd);
+	_state_async_fd = -1;
+    }
+    if (_state_async_pid > 0){
+	kill(_state_async_pid, SIGTERM);
+	waitpid(_state_async_pid, &status, 0);
+	_state_async_pid = 0;
+    }
+}
+
+/*! Start fetching state data asynchronously, when -sa <ms> is given
+ * A process is forked which simulates fetching state, eg from hardware, by sleeping
+ * <ms> milliseconds. It then writes on a pipe which is returned to the backend, and
+ * example_statedata is called when it is readable.
+ * @param[in]    h      Clicon handle
+ * @param[in]    nsc    External XML namespace context, or NULL
+ * @param[in]    xpath  String with XPATH syntax. or NULL for all
+ * @param[out]   fdp    File descriptor readable when state is ready, or -1
+ * @retval       0      OK
+ * @retval      -1      Error
+ * @see example_statedata
+ */
+int 
+example_statedata_start(clicon_handle h, 
+			cvec         *nsc,
+			char         *xpath,
+			int          *fdp)
+{
+    int p[2];
+    
+    *fdp = -1;
+    if (!_state || _state_async_ms < 0)
+	return 0;
+    /* Previous fetch may have timed out */
+    example_statedata_async_reset();
+    if (pipe(p) < 0){
+	clicon_err(OE_UNIX, errno, "pipe");
+	return -1;
+    }
+    if ((_state_async_pid = fork()) < 0){
+	clicon_err(OE_UNIX, errno, "fork");
+	close(p[0]);
+	close(p[1]);
+	return -1;
+    }
+    if (_state_async_pid == 0){ /* child */
+	close(p[0]);
+	usleep(_state_async_ms*1000);
+	if (write(p[1], "", 1) < 0)
+	    _exit(1);
+	_exit(0);
+    }
+    close(p[1]);
+    _state_async_fd = p[0];
+    *fdp = _state_async_fd;
+    return 0;
+}
+
+/*! State data callback registered for /table/parameter, when -k is given
+ * Returns the number of calls of this callback as stat of the parameters requested by 
+ * key, or of all configured parameters
+ * @param[in]    h      Clicon handle
+ * @param[in]    nsc    External XML namespace context, or NULL
+ * @param[in]    xpath  String with XPATH syntax. or NULL for all
+ * @param[in]    keys   Requested list keys, or NULL
+ * @param[in]    xstate XML tree, <config/> on entry. 
+ * @param[in]    arg    Argument given at registration
+ * @retval       0      OK
+ * @retval      -1      Error
+ * @see statedata_callback_register
+ */
+static int 
+example_statedata_parameter(clicon_handle h, 
+			    cvec         *nsc,
+			    char         *xpath,
+			    cvec         *keys,
+			    cxobj        *xstate,
+			    void         *arg)
+{
+    int     retval = -1;
+    cvec   *nsc1 = NULL;
+    cxobj  *xt = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen = 0;
+    cbuf   *cb = NULL;
+    cg_var *cv;
+    int     i;
+
+    _state_keys_nr++;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<table xmlns=\"urn:example:clixon\">");
+    if (keys && (cv = cvec_find(keys, "name")) != NULL)
+	cprintf(cb, "<parameter><name>%s</name><stat>%d</stat></parameter>",
+		cv_string_get(cv), _state_keys_nr);
+    else {
+	if ((nsc1 = xml_nsctx_init(NULL, "urn:example:clixon")) == NULL)
+	    goto done;
+	if (xmldb_get0(h, "running", YB_MODULE, nsc1, "/table/parameter/name", 1, &xt, NULL) < 0)
+	    goto done;
+	if (xpath_vec(xt, nsc1, "/table/parameter/name", &xvec, &xlen) < 0)
+	    goto done;
+	for (i=0; i<xlen; i++)
+	    cprintf(cb, "<parameter><name>%s</name><stat>%d</stat></parameter>",
+		    xml_body(xvec[i]), _state_keys_nr);
+    }
+    cprintf(cb, "</table>");
+    if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xstate, NULL) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (nsc1)
+	xml_nsctx_free(nsc1);
+    if (xt)
+	xml_free(xt);
+    if (xvec)
+	free(xvec);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Called to get state data from plugin
  * @param[in]    h      Clicon handle
  * @param[in]    nsc    External XML namespace context, or NULL
@@ -381,6 +634,8 @@ example_statedata(clicon_handle h,
 
     if (!_state)
 	goto ok;
+    /* Asynchronous fetch is done, see example_statedata_start */
+    example_statedata_async_reset();
     yspec = clicon_dbspec_yang(h);
     
     /* If -S is set, then read state data from file, otherwise construct it programmatically */
@@ -903,6 +1158,21 @@ upgrade_interfaces(clicon_handle h,
     return retval;
 }
 
+/*! Resync system state with running on warm restart, see CLICON_STARTUP_WARM
+ * Called instead of the transaction callbacks when running is unchanged since the last
+ * start. In this example, it is only logged
+ * @param[in] h   Clicon handle
+ * @param[in] db  Name of database, "running"
+ */
+int
+main_resync(clicon_handle h,
+	    const char   *db)
+{
+    if (_transaction_log)
+	clicon_log(LOG_NOTICE, "%s %s", __FUNCTION__, db);
+    return 0;
+}
+
 /*! Plugin state reset. Add xml or set state in backend machine.
  * Called in each backend plugin. plugin_reset is called after all plugins
  * have been initialized. This give the application a chance to reset
@@ -1009,6 +1279,7 @@ example_daemon(clicon_handle h)
 int 
 example_exit(clicon_handle h)
 {
+    example_statedata_async_reset();
     return 0;
 }
 
@@ -1022,6 +1293,7 @@ static clixon_plugin_api api = {
     .ca_extension=example_extension,        /* yang extensions */
     .ca_daemon=example_daemon,              /* daemon */
     .ca_reset=example_reset,                /* reset */
+    .ca_resync=main_resync,                 /* resync on warm restart */
     .ca_statedata=example_statedata,        /* statedata */
     .ca_trans_begin=main_begin,             /* trans begin */
     .ca_trans_validate=main_validate,       /* trans validate */
@@ -1032,6 +1304,7 @@ static clixon_plugin_api api = {
     .ca_trans_end=main_end,                 /* trans end */
     .ca_trans_abort=main_abort,             /* trans abort */
     .ca_datastore_upgrade=example_upgrade,  /* general-purpose upgrade. */
+    .ca_statedata_start=example_statedata_start, /* async statedata */
 };
 
 /*! Backend plugin initialization
@@ -1082,6 +1355,22 @@ clixon_plugin_init(clicon_handle h)
 	case 'v': /* validate fail */
 	    _validate_fail_xpath = optarg;
 	    break;
+	case 'a': /* async state (requires -s) */
+	    _state_async_ms = atoi(optarg);
+	    break;
+	case 'k': /* statedata callback for /table/parameter */
+	    _state_keys = 1;
+	    break;
+	case 'p': /* parallel-safe validate and commit */
+	    api.ca_trans_parallel = 1;
+	    _parallel_sleep = atoi(optarg);
+	    break;
+	case 'P': /* transaction callbacks in plugin process */
+	    api.ca_trans_process = 1;
+	    break;
+	case 'x': /* commit crash (requires -P) */
+	    _commit_crash_xpath = optarg;
+	    break;
 	}
 
     /* Example stream initialization:
@@ -1101,6 +1390,10 @@ clixon_plugin_init(clicon_handle h)
 	goto done;
     if (example_stream_timer_setup(h) < 0)
 	goto done;
+    if (_state_keys &&
+	statedata_callback_register(h, example_statedata_parameter, NULL,
+				    "urn:example:clixon", "/table/parameter") < 0)
+	goto done;
 
     /* Register callback for routing rpc calls 
      */
@@ -1125,6 +1418,13 @@ clixon_plugin_init(clicon_handle h)
 			      "example"/* Xml tag when callback is made */
 			      ) < 0)
 	goto done;
+    /* Replies later, without blocking other clients */
+    if (rpc_callback_register(h, example_async_rpc, 
+			      NULL, 
+			      "urn:example:clixon",
+			      "async"/* Xml tag when callback is made */
+			      ) < 0)
+	goto done;
     /* Called before the regular system copy_config callback 
      * If you want to have it called _after_ the system callback, place this call in 
      * the _start function.
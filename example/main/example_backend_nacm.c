@@ -59,7 +59,7 @@
 #include <clixon/clixon_backend.h> 
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_NACM_OPTS "tv:"
+#define BACKEND_NACM_OPTS "tv:p:"
 
 /*! Variable to control transaction logging (for debug)
  * If set, call syslog for every transaction callback
@@ -74,6 +74,12 @@ static int _transaction_log = 0;
 static char *_validate_fail_xpath = NULL;
 static int   _validate_fail_toggle = 0; /* fail at validate and commit */
 
+/*! Validate and commit callbacks are parallel-safe, see ca_trans_parallel
+ * Commit takes the given number of seconds
+ * Start backend with -- -p <s>
+ */
+static int _parallel_sleep = 0;
+
 int
 nacm_begin(clicon_handle    h, 
 	   transaction_data td)
@@ -118,6 +124,8 @@ nacm_commit(clicon_handle    h,
 {
     if (_transaction_log)
 	transaction_log(h, td, LOG_NOTICE, __FUNCTION__);
+    if (_parallel_sleep)
+	sleep(_parallel_sleep);
     if (_validate_fail_xpath){
 	if (_validate_fail_toggle==1 &&
 	    xpath_first(transaction_target(td), NULL, "%s", _validate_fail_xpath)){
@@ -199,6 +207,17 @@ nacm_statedata(clicon_handle h,
     return retval;
 }
 
+/*! Resync system state with running on warm restart, see CLICON_STARTUP_WARM
+ */
+int
+nacm_resync(clicon_handle h,
+	    const char   *db)
+{
+    if (_transaction_log)
+	clicon_log(LOG_NOTICE, "%s %s", __FUNCTION__, db);
+    return 0;
+}
+
 clixon_plugin_api *clixon_plugin_init(clicon_handle h);
 
 static clixon_plugin_api api = {
@@ -207,6 +226,7 @@ static clixon_plugin_api api = {
     NULL,               /* start */
     NULL,               /* exit */
     .ca_statedata=nacm_statedata, /* statedata */
+    .ca_resync=nacm_resync,       /* resync on warm restart */
     .ca_trans_begin=nacm_begin,             /* trans begin */
     .ca_trans_validate=nacm_validate,       /* trans validate */
     .ca_trans_complete=nacm_complete,       /* trans complete */
@@ -244,6 +264,10 @@ clixon_plugin_init(clicon_handle h)
 	case 'v': /* validate fail */
 	    _validate_fail_xpath = optarg;
 	    break;
+	case 'p': /* parallel-safe validate and commit */
+	    api.ca_trans_parallel = 1;
+	    _parallel_sleep = atoi(optarg);
+	    break;
 	}
 
     nacm_mode = clicon_option_str(h, "CLICON_NACM_MODE");
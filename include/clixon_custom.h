@@ -47,6 +47,13 @@
  */
 #undef RPC_USERNAME_ASSERT
 
+/*! Remove all clixon_debug() calls at compile time, eg in release builds
+ * The clixon_debug() macro is used in hot paths (event loop, internal messages, xpath)
+ * instead of clicon_debug(). If set, no code is generated for it and -D and
+ * CLICON_DEBUG_CATEGORIES have no effect on those calls. clicon_debug() is not affected.
+ */
+#undef CLIXON_DEBUG_DISABLE
+
 /*! Tag for wrong handling of identityref prefixes (XML encoding)
  * See https://github.com/clicon/clixon/issues/90
  * Instead of using generic xmlns prefix bindings, the module's own prefix
@@ -72,6 +79,36 @@
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Hash table of list entries on list keys
+ * Lookups of list entries with all keys given, eg from xpath or api-path, use a hash table 
+ * in the parent instead of binary search. The table is built on first lookup in parents
+ * with many children and maintained on insert and remove, see xml_key_hash_find
+ */
+#define XML_KEY_HASH
+
+/*! Cached content hash of XML subtrees
+ * The hash is invalidated up the parent chain when a subtree is modified, see xml_hash.
+ * xml_diff skips subtrees with equal hashes, so that diffs of large trees with few
+ * changes, eg in commit, are proportional to the changes.
+ */
+#define XML_SUBTREE_HASH
+
+/*! Cached paths of list entries
+ * The xpath and instance-identifier of a list entry are cached when computed, so that
+ * paths of nodes below it, eg in error-paths and change logs, are not rebuilt from
+ * the root. All cached paths are obsolete when a node is moved or renamed or a key
+ * changes, see xml_path_cache_get
+ */
+#define XML_PATH_CACHE
+
+/*! Cache of xpath parse trees keyed by xpath string
+ * xpath_vec_ctx() and the functions using it, eg xpath_vec_bool() for YANG when and must,
+ * reuse the parse tree of an xpath evaluated before instead of parsing it again.
+ * XPATH_CACHE_SIZE is the max number of cached trees, the least recently used is evicted.
+ */
+#define XPATH_CACHE
+#define XPATH_CACHE_SIZE 1024
+
 /*! Let state data be ordered-by system
  * RFC 7950 is cryptic about this
  * It says in 7.7.7:
@@ -89,3 +126,35 @@
  * Consider making this an option or configure option 
  */
 #define DATASTORE_TOP_SYMBOL "config"
+
+/*! Use epoll(7) instead of select(2) in the clixon event loop
+ * Registration and dispatch of file descriptors are then O(1) per event instead of
+ * scanning all registered descriptors, and there is no FD_SETSIZE limit.
+ * Only available on Linux, other platforms use select(2).
+ */
+#ifdef __linux__
+#define EVENT_EPOLL
+#endif
+
+/*! Supervise processes started by the backend, eg restconf, with pidfd_open(2)
+ * The exit of a process is then an event on its pidfd in the event loop, and it is
+ * reaped directly instead of by searching all processes on SIGCHLD.
+ * Requires Linux 5.3, on older kernels SIGCHLD is used, see clixon_process_waitpid
+ */
+#ifdef __linux__
+#define PROC_PIDFD
+#endif
+
+/*! Intern XML element names and prefixes
+ * All XML nodes with the same name share one string from a reference-counted intern table
+ * instead of a private strdup. This saves memory in large lists, and equal names of two 
+ * nodes can be compared by pointer, see xml_name_eq
+ */
+#define XML_INTERN_NAMES
+
+/*! Allocate XML nodes of parsed files from arena blocks
+ * clixon_xml_parse_file() and clixon_json_parse_file() allocate nodes from large blocks
+ * instead of one malloc per node, see xml_arena_begin
+ * Disable to debug memory errors of XML nodes with eg valgrind
+ */
+#define XML_ARENA
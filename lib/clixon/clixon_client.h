@@ -41,6 +41,7 @@
  */
 typedef void *clixon_handle;
 typedef void *clixon_client_handle;
+typedef void *clixon_client_shm;
 
 /* Connection type as parameter to connect */
 typedef enum {
@@ -49,6 +50,32 @@ typedef enum {
     CLIXON_CLIENT_SSH       /* NYI External Netconf over SSH */
 } clixon_client_type;
 
+/* Type of a value in a batched get, see clixon_client_get_batch */
+typedef enum {
+    CLIXON_CLIENT_BOOL,
+    CLIXON_CLIENT_STR,
+    CLIXON_CLIENT_UINT8,
+    CLIXON_CLIENT_UINT16,
+    CLIXON_CLIENT_UINT32,
+    CLIXON_CLIENT_UINT64
+} clixon_client_vtype;
+
+/* One value of a batched get, see clixon_client_get_batch */
+typedef struct {
+    const char         *cv_xpath;  /* XPath of leaf */
+    clixon_client_vtype cv_type;   /* Type of value */
+    char               *cv_str;    /* Buffer of string value, set by caller */
+    int                 cv_strlen; /* Length of string buffer */
+    int                 cv_found;  /* Out: 1 if value was found, 0 if not */
+    union {
+	int      cv_bool;
+	uint8_t  cv_uint8;
+	uint16_t cv_uint16;
+	uint32_t cv_uint32;
+	uint64_t cv_uint64;
+    } cv_u;                        /* Out: value, if found and not string */
+} clixon_client_value;
+
 /*
  * Prototypes
  */
@@ -67,6 +94,24 @@ int   clixon_client_get_uint8(clixon_client_handle ch, uint8_t *rval, const char
 int   clixon_client_get_uint16(clixon_client_handle ch, uint16_t *rval, const char *xnamespace, const char *xpath);
 int   clixon_client_get_uint32(clixon_client_handle ch, uint32_t *rval, const char *xnamespace, const char *xpath);
 int   clixon_client_get_uint64(clixon_client_handle ch, uint64_t *rval, const char *xnamespace, const char *xpath);
+int   clixon_client_get_batch(clixon_client_handle ch, const char *xnamespace, const char *xpath,
+			      clixon_client_value *vec, int len);
+int   clixon_client_cache_set(clixon_client_handle ch, int enable);
+int   clixon_client_set_bool(clixon_client_handle ch, int val, const char *xnamespace, const char *xpath);
+int   clixon_client_set_str(clixon_client_handle ch, const char *val, const char *xnamespace, const char *xpath);
+int   clixon_client_set_uint8(clixon_client_handle ch, uint8_t val, const char *xnamespace, const char *xpath);
+int   clixon_client_set_uint16(clixon_client_handle ch, uint16_t val, const char *xnamespace, const char *xpath);
+int   clixon_client_set_uint32(clixon_client_handle ch, uint32_t val, const char *xnamespace, const char *xpath);
+int   clixon_client_set_uint64(clixon_client_handle ch, uint64_t val, const char *xnamespace, const char *xpath);
+int   clixon_client_delete(clixon_client_handle ch, const char *xnamespace, const char *xpath);
+int   clixon_client_merge(clixon_client_handle ch, const char *xnamespace, const char *xpath, const char *xml);
+int   clixon_client_flush(clixon_client_handle ch);
+int   clixon_client_flush_send(clixon_client_handle ch);
+int   clixon_client_flush_recv(clixon_client_handle ch);
+clixon_client_shm clixon_client_shm_open(const char *path);
+int   clixon_client_shm_close(clixon_client_shm shm);
+int   clixon_client_shm_get(clixon_client_shm shm, clixon_client_value *vec, int len);
+int   clixon_client_shm_generation(clixon_client_shm shm, uint64_t *gen);
     
 /* Access functions */
 int   clixon_client_socket_get(clixon_client_handle ch);
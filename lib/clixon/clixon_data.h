@@ -56,6 +56,10 @@ typedef struct {
     cxobj    *de_xml;      /* cache */
     int       de_modified; /* Dirty since loaded/copied/committed/etc XXX:nocache? */
     int       de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
+    int       de_journal;  /* Nr of edit records in journal file, see CLICON_XMLDB_PERSIST */
+    uint32_t  de_bulk;     /* Session id of bulk load, file written at end, see xmldb_bulk_begin */
+    int       de_defaults; /* Cache may have default values, set by zero-copy read */
+    int       de_unsaved;  /* Cache not written to file, see CLICON_XMLDB_TRANSIENT */
 } db_elmnt;
 
 /*
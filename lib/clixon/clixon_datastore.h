@@ -38,12 +38,31 @@
 #ifndef _CLIXON_DATASTORE_H
 #define _CLIXON_DATASTORE_H
 
+/*
+ * Constants
+ */
+/* Prefix of private candidate datastores, followed by session id, see
+ * CLICON_PRIVATE_CANDIDATE */
+#define XMLDB_PRIVATE_CANDIDATE "candidate-"
+
+/*
+ * Types
+ */
+/* Read snapshot of a datastore, opaque, see xmldb_snapshot_get */
+typedef struct xmldb_snapshot xmldb_snapshot;
+
 /*
  * Prototypes
  * API
  */
 /* Internal functions */
 int xmldb_db2file(clicon_handle h, const char *db, char **filename);
+int xmldb_db2journal(clicon_handle h, const char *db, char **filename);
+int xmldb_db2shards(clicon_handle h, const char *db, char **dirname);
+int xmldb_journal_rm(clicon_handle h, const char *db);
+int xmldb_cache_unshare(clicon_handle h, const char *db);
+int xmldb_cache_defaults_clear(clicon_handle h, const char *db);
+int xmldb_snapshot_pinned(clicon_handle h, cxobj *xt);
 
 /* API */
 int xmldb_validate_db(const char *db);
@@ -54,22 +73,49 @@ int xmldb_get(clicon_handle h, const char *db, cvec *nsc, char *xpath, cxobj **x
 int xmldb_get0(clicon_handle h, const char *db, yang_bind yb,
 	       cvec *nsc, const char *xpath,
 	       int copy, cxobj **xtop, modstate_diff_t *msd); 
+int xmldb_get_page(clicon_handle h, const char *db, cvec *nsc, char *xpath,
+		   uint32_t offset, uint32_t limit, cxobj **xtop);
+int xmldb_get_api_path(clicon_handle h, const char *db, char *api_path, cxobj **xret);
+int xmldb_get_detach(clicon_handle h, const char *db, cxobj **xret, modstate_diff_t *msd);
 int xmldb_get0_clear(clicon_handle h, cxobj *x);
 int xmldb_get0_free(clicon_handle h, cxobj **xp);
+cxobj *xml_find_node_keys(cxobj *xp, cxobj *x); /* in clixon_datastore_read.[ch] */
+cxobj *xml_copy_node_keys(cxobj *x, cxobj *xp);
+cxobj *xml_copy_node_path(cxobj *xt, cxobj *x);
+int xmldb_parse_cache_stats(cbuf *cb);
+int xmldb_parse_cache_clear(void);
 int xmldb_put(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret); /* in clixon_datastore_write.[ch] */
+int xmldb_replace(clicon_handle h, const char *db, cxobj **xtp); /* in clixon_datastore_write.[ch] */
+int xmldb_bulk_begin(clicon_handle h, const char *db, uint32_t id); /* in clixon_datastore_write.[ch] */
+int xmldb_bulk_end(clicon_handle h, const char *db);
+int xmldb_bulk_end_all(clicon_handle h, uint32_t id);
+uint32_t xmldb_bulk_get(clicon_handle h, const char *db);
 int xmldb_copy(clicon_handle h, const char *from, const char *to);
+int xmldb_sync(clicon_handle h); /* in clixon_datastore_write.[ch] */
+int xmldb_transient(clicon_handle h, const char *db);
+int xmldb_flush(clicon_handle h, const char *db); /* in clixon_datastore_write.[ch] */
 int xmldb_lock(clicon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clicon_handle h, const char *db);
 int xmldb_unlock_all(clicon_handle h, uint32_t id);
 uint32_t xmldb_islocked(clicon_handle h, const char *db);
 int xmldb_exists(clicon_handle h, const char *db);
+int xmldb_journal_exists(clicon_handle h, const char *db);
+int xmldb_file_synced(clicon_handle h, const char *db);
 int xmldb_clear(clicon_handle h, const char *db);
 int xmldb_delete(clicon_handle h, const char *db);
+int xmldb_remove(clicon_handle h, const char *db);
 int xmldb_create(clicon_handle h, const char *db);
 /* utility functions */
 int xmldb_db_reset(clicon_handle h, const char *db);
 
 cxobj *xmldb_cache_get(clicon_handle h, const char *db);
+uint64_t xmldb_generation(clicon_handle h, const char *db);
+int xmldb_generation_incr(clicon_handle h, const char *db);
+uint64_t xmldb_modified(clicon_handle h, const char *db);
+int xmldb_snapshot_get(clicon_handle h, const char *db, xmldb_snapshot **snp);
+cxobj *xmldb_snapshot_xml(xmldb_snapshot *sn);
+uint64_t xmldb_snapshot_generation(xmldb_snapshot *sn);
+int xmldb_snapshot_release(clicon_handle h, xmldb_snapshot *sn);
 
 int xmldb_modified_get(clicon_handle h, const char *db);
 int xmldb_modified_set(clicon_handle h, const char *db, int value);
@@ -0,0 +1,94 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Read-only image of a datastore in shared memory, for local readers without rpc.
+ * The image is a file, eg in /dev/shm, that readers map. It is never changed once
+ * written: a new image is written to a temporary file and renamed, and then the old
+ * image is marked obsolete, so that a reader remaps on its next lookup.
+ *
+ * Layout: header, node array, string table. Nodes are in breadth-first order so that
+ * the children of a node are consecutive, sorted on name and key, which is the key
+ * index of lists. Strings are offsets into the string table, offset 0 is "".
+ *
+ * The same image is written next to a datastore file if CLICON_XMLDB_IMAGE is set,
+ * and is then used to read the datastore without parsing the file in nocache mode.
+ */
+#ifndef _CLIXON_DATASTORE_SHM_H
+#define _CLIXON_DATASTORE_SHM_H
+
+/*
+ * Constants
+ */
+#define XMLDB_SHM_MAGIC   0x434c5853 /* "CLXS" */
+#define XMLDB_SHM_VERSION 2
+
+/* Separator of key values of a list entry in the key of a node */
+#define XMLDB_SHM_KEYSEP  '\x1f'
+
+/*
+ * Types
+ */
+/* Header of a datastore image */
+struct xmldb_shm_header{
+    uint32_t          sh_magic;      /* XMLDB_SHM_MAGIC */
+    uint32_t          sh_version;    /* XMLDB_SHM_VERSION */
+    volatile uint32_t sh_obsolete;   /* Set when image is replaced, reader should remap */
+    uint32_t          sh_nodes;      /* Number of nodes, node 0 is the top node */
+    uint64_t          sh_generation; /* Generation of datastore, see xmldb_generation */
+    uint64_t          sh_size;       /* Size of image in bytes */
+    uint64_t          sh_strings;    /* Offset of string table in image */
+    uint64_t          sh_src_ino;    /* Datastore file of a file image: inode, */
+    uint64_t          sh_src_size;   /* size and */
+    uint64_t          sh_src_mtime;  /* modification time in ns, otherwise 0 */
+};
+
+/* Element node of a datastore image */
+struct xmldb_shm_node{
+    uint32_t sn_name;    /* Name, without prefix */
+    uint32_t sn_key;     /* Key values of a list entry separated by XMLDB_SHM_KEYSEP,
+			    value of a leaf-list entry, otherwise "" */
+    uint32_t sn_body;    /* Body, or "" */
+    uint32_t sn_child;   /* Index of first child */
+    uint32_t sn_nchild;  /* Number of children */
+};
+
+/*
+ * Prototypes
+ */
+int xmldb_shm_export(clicon_handle h, const char *db);
+int xmldb_image_write(clicon_handle h, const char *dbfile, cxobj *xt);
+int xmldb_image_get(clicon_handle h, const char *db, cvec *nsc, const char *xpath, cxobj **xtp);
+
+#endif /* _CLIXON_DATASTORE_SHM_H */
@@ -58,6 +58,7 @@ int clicon_sig_ignore_set(int val);
 int clicon_sig_ignore_get(void);
 
 int clixon_event_reg_fd(int fd, int (*fn)(int, void*), void *arg, char *str);
+int clixon_event_reg_fd_write(int fd, int (*fn)(int, void*), void *arg, char *str);
 
 int clixon_event_unreg_fd(int s, int (*fn)(int, void*));
 
@@ -70,6 +71,8 @@ int clixon_event_poll(int fd);
 
 int clixon_event_loop(clicon_handle h);
 
+int clixon_event_stats(cbuf *cb);
+
 int clixon_event_exit(void);
 
 #endif  /* _CLIXON_EVENT_H_ */
@@ -84,6 +84,10 @@ int clicon_handle_check(clicon_handle h);
 /* Return clicon options (hash-array) given a handle.*/
 clicon_hash_t *clicon_options(clicon_handle h);
 
+/* Return typed options given a handle.*/
+struct clicon_optv;
+struct clicon_optv *clicon_optv(clicon_handle h);
+
 /* Return internal clicon data (hash-array) given a handle.*/
 clicon_hash_t *clicon_data(clicon_handle h);
 
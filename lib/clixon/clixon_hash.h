@@ -38,14 +38,16 @@
 #ifndef _CLIXON_HASH_H_
 #define _CLIXON_HASH_H_
 
+/* Hash entry */
 struct clicon_hash {
-    qelem_t	h_qelem;
     char       *h_key;
+    uint32_t	h_hash;  /* Hash value of key */
     size_t	h_vlen;
     void       *h_val;
 };
 typedef struct clicon_hash *clicon_hash_t;
 
+/* A hash table is referenced as clicon_hash_t*, the table itself is opaque */
 clicon_hash_t *clicon_hash_init (void);
 int            clicon_hash_free (clicon_hash_t *);
 clicon_hash_t  clicon_hash_lookup (clicon_hash_t *head, const char *key);
@@ -40,12 +40,25 @@
 #ifndef _CLIXON_JSON_H
 #define _CLIXON_JSON_H
 
+/*
+ * Types
+ */
+/*! Flush callback of streaming JSON output, see xml2json_stream
+ * @param[in]  arg  Callback argument
+ * @param[in]  cb   Buffer with JSON output so far, reset after call
+ */
+typedef int (json_stream_fn)(void *arg, cbuf *cb);
+
 /*
  * Prototypes
  */
 int json2xml_decode(cxobj *x, cxobj **xerr);
+int xml2json_encode_identityref(cxobj *xb, char *body, yang_stmt *yp, cbuf *cb);
+int json_xmlns_translate(yang_stmt *yspec, cxobj *x, cxobj **xerr);
 int xml2json_cbuf(cbuf *cb, cxobj *x, int pretty);
 int xml2json_cbuf_vec(cbuf *cb, cxobj **vec, size_t veclen, int pretty);
+int xml2json_stream(cbuf *cb, cxobj *x, int pretty, size_t chunk, json_stream_fn *fn, void *arg);
+int xml2json_stream_vec(cbuf *cb, cxobj **vec, size_t veclen, int pretty, size_t chunk, json_stream_fn *fn, void *arg);
 int xml2json(FILE *f, cxobj *x, int pretty);
 int xml2json_cb(FILE *f, cxobj *x, int pretty, clicon_output_cb *fn);
 int json_print(FILE *f, cxobj *x);
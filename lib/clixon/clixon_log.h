@@ -48,6 +48,54 @@
 #define CLICON_LOG_STDOUT 4 /* print logs on stdout */
 #define CLICON_LOG_FILE   8 /* print logs on clicon_log_filename */
 
+/* Debug categories, each category has its own debug level, see clixon_debug()
+ * Add new categories before CLIXON_DBG_NR and to clixon_debug_category_parse()
+ */
+#define CLIXON_DBG_DEFAULT   0 /* Everything not in a category below */
+#define CLIXON_DBG_EVENT     1 /* Event loop: fd and timer callbacks */
+#define CLIXON_DBG_MSG       2 /* Internal protocol messages and rpcs */
+#define CLIXON_DBG_XPATH     3 /* XPath evaluation */
+#define CLIXON_DBG_DATASTORE 4 /* Datastore read and write */
+#define CLIXON_DBG_NR        5 /* Number of categories */
+
+/*! Check if debug of a category is enabled at a level
+ * Use as guard for code that only computes debug output, eg printing of trees
+ * @param[in] cat  Debug category, eg CLIXON_DBG_EVENT
+ * @param[in] lvl  Debug level, 1 is default level of -D
+ */
+#ifdef CLIXON_DEBUG_DISABLE
+#define clixon_debug_enabled(cat, lvl) 0
+#else
+#define clixon_debug_enabled(cat, lvl) ((lvl) <= _clixon_debug_level[(cat)])
+#endif
+
+/*! Print a debug message of a category if its debug level is enabled
+ * As clicon_debug() but the arguments are not evaluated unless the level is enabled,
+ * and no code at all is generated if CLIXON_DEBUG_DISABLE is defined (see clixon_custom.h)
+ * Use in hot paths, eg per event, message or node.
+ * @param[in] cat  Debug category, eg CLIXON_DBG_EVENT
+ * @param[in] lvl  Debug level, 1 is default level of -D
+ * @param[in] fmt  Format string as printf followed by arguments
+ * @code
+ *   clixon_debug(CLIXON_DBG_MSG, 1, "%s request:%s", __FUNCTION__, msg->op_body);
+ * @endcode
+ */
+#ifdef CLIXON_DEBUG_DISABLE
+#define clixon_debug(cat, lvl, fmt, ...) do {} while (0)
+#else
+#define clixon_debug(cat, lvl, fmt, ...)				\
+    do {								\
+	if (clixon_debug_enabled((cat), (lvl)))				\
+	    clicon_debug_print(fmt, ##__VA_ARGS__);			\
+    } while (0)
+#endif
+
+/*
+ * Variables
+ */
+/* Effective debug level per category, use clixon_debug() not this directly */
+extern int _clixon_debug_level[CLIXON_DBG_NR];
+
 /*
  * Prototypes
  */
@@ -59,12 +107,16 @@ int clicon_get_logflags(void);
 #if defined(__GNUC__) && __GNUC__ >= 3
 int clicon_log(int level, const char *format, ...) __attribute__ ((format (printf, 2, 3)));
 int clicon_debug(int dbglevel, const char *format, ...) __attribute__ ((format (printf, 2, 3)));
+int clicon_debug_print(const char *format, ...) __attribute__ ((format (printf, 1, 2)));
 #else
 int clicon_log(int level, const char *format, ...);
 int clicon_debug(int dbglevel, const char *format, ...);
+int clicon_debug_print(const char *format, ...);
 #endif
 int clicon_debug_init(int dbglevel, FILE *f);
 int clicon_debug_get(void);
+int clixon_debug_category_set(int cat, int dbglevel);
+int clixon_debug_category_parse(char *str);
 
 char *mon2name(int md);
 
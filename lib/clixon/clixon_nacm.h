@@ -56,12 +56,14 @@ enum nacm_access{
 /*
  * Prototypes
  */
-int nacm_rpc(char *rpc, char *module, char *username, cxobj *xnacm, cbuf *cbret);
+int nacm_rpc(clicon_handle h, char *rpc, char *module, char *username, cxobj *xnacm, cbuf *cbret);
 int nacm_datanode_read(clicon_handle h, cxobj *xt, cxobj **xvec, size_t xlen, char *username,
 		       cxobj *nacm_xtree);
 int nacm_datanode_write(clicon_handle h, cxobj *xr, cxobj *xt,
 			enum nacm_access access,
 			char *username, cxobj *xnacm, cbuf *cbret);
+int nacm_ruleset_free(clicon_handle h);
+int nacm_ruleset_stats(clicon_handle h, uint64_t *nrp, size_t *szp);
 int nacm_access_pre(clicon_handle h, char *peername, char *username, cxobj **xnacmp);
 int verify_nacm_user(enum nacm_credentials_t cred, char *peername, char *nacmname, cbuf *cbret);
 
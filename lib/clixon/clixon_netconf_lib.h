@@ -60,6 +60,11 @@
  */
 #define NETCONF_BASE_CAPABILITY_1_1 "urn:ietf:params:netconf:base:1.1"
 
+/* Netconf partial lock capability and namespace as defined in RFC5717, Sec 2.1, 2.4
+ */
+#define NETCONF_PARTIAL_LOCK_CAPABILITY "urn:ietf:params:netconf:capability:partial-lock:1.0"
+#define NETCONF_PARTIAL_LOCK_NAMESPACE "urn:ietf:params:xml:ns:netconf:partial-lock:1.0"
+
 /* See RFC 7950 Sec 5.3.1: YANG defines an XML namespace for NETCONF <edit-config> 
  * operations, <error-info> content, and the <action> element.
  */
@@ -111,6 +111,23 @@ enum datastore_cache{
     DATASTORE_CACHE_ZEROCOPY
 };
 
+/*! Datastore write method, see clixon_datastore_write.c
+ * See config option type datastore_persist in clixon-config.yang
+ */
+enum datastore_persist{
+    DATASTORE_SNAPSHOT,
+    DATASTORE_JOURNAL
+};
+
+/*! Datastore file durability, see clixon_datastore_write.c
+ * See config option type datastore_sync in clixon-config.yang
+ */
+enum datastore_sync{
+    DATASTORE_SYNC_NONE,
+    DATASTORE_SYNC_DATA,
+    DATASTORE_SYNC_GROUP
+};
+
 /*! yang clixon regexp engine
  * @see regexp_mode in clixon-config.yang
  */
@@ -119,6 +136,26 @@ enum regexp_mode{
     REGEXP_LIBXML2
 };
 
+/*! Options resolved to typed values, for hot paths that would otherwise parse the
+ * option string on each call. Updated when options are loaded or set.
+ * @see clicon_optv  Access via handle
+ * @see clicon_options_resolve
+ */
+struct clicon_optv{
+    int                    co_xmldb_format;          /* CLICON_XMLDB_FORMAT as enum format_enum,
+							-1 if not set */
+    int                    co_xmldb_pretty;          /* CLICON_XMLDB_PRETTY */
+    int                    co_xmldb_compress;        /* CLICON_XMLDB_COMPRESS, <= 0 if not compressed */
+    int                    co_xmldb_journal_compact; /* CLICON_XMLDB_JOURNAL_COMPACT, -1 if not set */
+    enum datastore_cache   co_datastore_cache;       /* CLICON_DATASTORE_CACHE */
+    enum datastore_persist co_xmldb_persist;         /* CLICON_XMLDB_PERSIST */
+    enum datastore_sync    co_xmldb_sync;            /* CLICON_XMLDB_SYNC */
+    int                    co_xmldb_transient;       /* CLICON_XMLDB_TRANSIENT */
+    int                    co_xmldb_shard;           /* CLICON_XMLDB_SHARD */
+    int                    co_nacm_disabled_on_empty; /* CLICON_NACM_DISABLED_ON_EMPTY */
+    int                    co_yang_unknown_anydata;  /* CLICON_YANG_UNKNOWN_ANYDATA */
+};
+
 /*
  * Prototypes
  */
@@ -132,6 +169,9 @@ int clicon_option_add(clicon_handle h, const char *name, char *value);
 /* Initialize options: set defaults, read config-file, etc */
 int clicon_options_main(clicon_handle h);
 
+/* Update typed options from option strings */
+int clicon_options_resolve(clicon_handle h, const char *name);
+
 /*! Check if a clicon option has a value */
 int clicon_option_exists(clicon_handle h, const char *name);
 
@@ -222,6 +262,8 @@ enum priv_mode_t clicon_backend_privileges_mode(clicon_handle h);
 enum nacm_credentials_t clicon_nacm_credentials(clicon_handle h);
 
 enum datastore_cache clicon_datastore_cache(clicon_handle h);
+enum datastore_persist clicon_datastore_persist(clicon_handle h);
+enum datastore_sync clicon_datastore_sync(clicon_handle h);
 enum regexp_mode clicon_yang_regexp(clicon_handle h);
 /*-- Specific option access functions for non-yang options --*/
 int clicon_quiet_mode(clicon_handle h);
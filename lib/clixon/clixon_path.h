@@ -75,6 +75,7 @@ typedef struct {
 /*
  * Prototypes
  */
+int clixon_path_free(clixon_path *cplist);
 int xml_yang_root(cxobj *x, cxobj **xr);
 int yang2api_path_fmt(yang_stmt *ys, int inclkey, char **api_path_fmt);
 int api_path_fmt2api_path(const char *api_path_fmt, cvec *cvv, char **api_path, int *cvvi);
@@ -84,6 +85,9 @@ int api_path2xml(char *api_path, yang_stmt *yspec, cxobj *xtop,
 		 yang_class nodeclass, int strict,
 		 cxobj **xpathp, yang_stmt **ypathp, cxobj **xerr);
 int xml2api_path_1(cxobj *x, cbuf *cb);
+int xml2instance_id(cxobj *x, cbuf *cb);
+int clixon_instance_id_compile(yang_stmt *yt, char *path, clixon_path **cplistp);
+int clixon_xml_find_instance_id_cp(cxobj *xt, yang_stmt *yt, clixon_path *cplist, cxobj ***xvec, int *xlen);
 #if defined(__GNUC__) && __GNUC__ >= 3
 int clixon_xml_find_api_path(cxobj *xt, yang_stmt *yt, cxobj ***xvec, int *xlen, const char *format,
 		     ...) __attribute__ ((format (printf, 5, 6)));;
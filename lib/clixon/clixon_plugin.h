@@ -206,6 +206,22 @@ typedef int (plgreset_t)(clicon_handle h, const char *db);
  */
 typedef int (plgstatedata_t)(clicon_handle h, cvec *nsc, char *xpath, cxobj *xtop);
 
+/* Plugin statedata start, optional asynchronous first step of statedata
+ * Start fetching state data, eg send requests to hardware, without waiting for the result.
+ * The backend then waits concurrently for all plugins on their file descriptors, and when
+ * fd is readable, calls plgstatedata_t to read the result and add it to the XML tree.
+ * If fd does not become readable within CLICON_BACKEND_STATEDATA_TIMEOUT, the get fails
+ * and plgstatedata_t is not called, the plugin should then discard the request on a
+ * consecutive start call.
+ * @param[in]  Clicon handle
+ * @param[in]  nsc    XPATH namespace context.
+ * @param[in]  xpath  Part of state requested
+ * @param[out] fdp    File descriptor readable when state is ready, or -1 for synchronous
+ * @retval    -1      Fatal error
+ * @retval     0      OK
+ */
+typedef int (plgstatedata_start_t)(clicon_handle h, cvec *nsc, char *xpath, int *fdp);
+
 typedef void *transaction_data;
 
 /* Transaction callback */
@@ -283,6 +299,11 @@ struct clixon_plugin_api{
 	    trans_cb_t       *cb_trans_end;	 /* Transaction completed  */
     	    trans_cb_t       *cb_trans_abort;	 /* Transaction aborted */
 	    datastore_upgrade_t *cb_datastore_upgrade; /* General-purpose datastore upgrade */
+	    plgstatedata_start_t *cb_statedata_start; /* Start async state data (backend only) */
+	    plgreset_t       *cb_resync;         /* Resync system with unchanged running on warm restart */
+	    int               cb_trans_parallel; /* Validate/commit may run in a helper process concurrently with other plugins */
+	    char             *cb_trans_after;    /* Space-separated names (ca_name) of earlier plugins whose validate/commit must be done first */
+	    int               cb_trans_process;  /* Transaction callbacks are called in a separate plugin process */
 	} cau_backend;
     } u;
 };
@@ -295,6 +316,7 @@ struct clixon_plugin_api{
 #define ca_daemon         u.cau_backend.cb_daemon
 #define ca_reset          u.cau_backend.cb_reset
 #define ca_statedata      u.cau_backend.cb_statedata
+#define ca_statedata_start u.cau_backend.cb_statedata_start
 #define ca_trans_begin    u.cau_backend.cb_trans_begin
 #define ca_trans_validate u.cau_backend.cb_trans_validate
 #define ca_trans_complete u.cau_backend.cb_trans_complete
@@ -304,6 +326,10 @@ struct clixon_plugin_api{
 #define ca_trans_end      u.cau_backend.cb_trans_end
 #define ca_trans_abort    u.cau_backend.cb_trans_abort
 #define ca_datastore_upgrade  u.cau_backend.cb_datastore_upgrade
+#define ca_resync         u.cau_backend.cb_resync
+#define ca_trans_parallel u.cau_backend.cb_trans_parallel
+#define ca_trans_after    u.cau_backend.cb_trans_after
+#define ca_trans_process  u.cau_backend.cb_trans_process
 
 /*
  * Macros
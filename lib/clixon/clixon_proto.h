@@ -48,7 +48,8 @@ enum format_enum{
     FORMAT_JSON,  
     FORMAT_TEXT,  
     FORMAT_CLI,
-    FORMAT_NETCONF
+    FORMAT_NETCONF,
+    FORMAT_CBOR
 };
 
 /* Protocol message header */
@@ -58,6 +59,12 @@ struct clicon_msg {
     char        op_body[0]; /* rest of message, actual data */
 };
 
+/* Capability in internal hello for compact binary encoding, see clicon_msg_encode_bin */
+#define CLIXON_PROTO_BIN_CAPABILITY "http://clicon.org/lib/binary"
+
+/* Receive buffer of a stream socket, see clicon_msg_rcv_nb */
+typedef struct clicon_msg_rbuf clicon_msg_rbuf;
+
 /*
  * Prototypes
  */ 
@@ -69,6 +76,7 @@ struct clicon_msg *clicon_msg_encode(uint32_t id, const char *format, ...) __att
 #else
 struct clicon_msg *clicon_msg_encode(uint32_t id, const char *format, ...);
 #endif
+struct clicon_msg *clicon_msg_encode_bin(uint32_t id, cxobj *x);
 int clicon_msg_decode(struct clicon_msg *msg, yang_stmt *yspec, uint32_t *id, cxobj **xml, cxobj **xerr);
 
 int clicon_connect_unix(clicon_handle h, char *sockpath);
@@ -85,20 +93,38 @@ int clicon_rpc_connect_inet(clicon_handle         h,
 
 int clicon_rpc(int sock, struct clicon_msg *msg, char **xret);
 
+int clicon_rpc_cbuf(int sock, uint32_t id, cbuf *cb, char **ret);
+
+int clicon_rpc_vec(int sock, struct clicon_msg **msgv, int len, char **retv);
+
 int clicon_rpc1(int sock, cbuf *msgin, cbuf *msgret);
 
 int clicon_msg_send(int s, struct clicon_msg *msg);
 
+int clicon_msg_send_cbuf(int s, uint32_t id, cbuf *cb);
+
 int clicon_msg_send1(int s, cbuf *cb);
 
 int clicon_msg_rcv(int s, struct clicon_msg **msg, int *eof);
 
+clicon_msg_rbuf *clicon_msg_rbuf_new(void);
+
+int clicon_msg_rbuf_free(clicon_msg_rbuf *mr);
+
+int clicon_msg_rbuf_get(clicon_msg_rbuf *mr, struct clicon_msg **msg);
+int clicon_msg_rbuf_read(int s, clicon_msg_rbuf *mr, int *eof);
+
+int clicon_msg_rcv_nb(int s, clicon_msg_rbuf *mr, struct clicon_msg **msg, int *eof);
+
 int clicon_msg_rcv1(int s, cbuf *cb, int *eof);
 
 int send_msg_notify_xml(clicon_handle h, int s, cxobj *xev);
 
 int send_msg_reply(int s, char *data, uint32_t datalen);
+int send_msg_reply_xml(int s, char *head, cxobj *x, int32_t depth, size_t xlen, char *tail, size_t chunk);
+int send_msg_reply_file(int s, char *head, int fd, off_t offset, size_t len, char *tail);
 
 int detect_endtag(char *tag, char  ch, int  *state);
+int detect_endtag_buf(char *tag, cbuf *cb, char *buf, size_t len, size_t *used);
 
 #endif  /* _CLIXON_PROTO_H_ */
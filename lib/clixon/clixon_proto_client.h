@@ -43,11 +43,21 @@
 #define _CLIXON_PROTO_CLIENT_H_
 
 int clicon_rpc_connect(clicon_handle h, int *sock0);
+int clicon_rpc_timing_enable(clicon_handle h);
+int clicon_rpc_timing_get(clicon_handle h, uint32_t *nr, struct timeval *tv);
+int clicon_rpc_msg_str(clicon_handle h, struct clicon_msg *msg, char **retdata);
+int clicon_rpc_cbuf_str(clicon_handle h, uint32_t id, cbuf *cb, char **retdata);
 int clicon_rpc_msg(clicon_handle h, struct clicon_msg *msg, cxobj **xret0);
+int clicon_rpc_msg_vec(clicon_handle h, struct clicon_msg **msgv, int len, cxobj **xretv);
 int clicon_rpc_msg_persistent(clicon_handle h, struct clicon_msg *msg, cxobj **xret0, int *sock0);
 int clicon_rpc_netconf(clicon_handle h, char *xmlst, cxobj **xret, int *sp);
 int clicon_rpc_netconf_xml(clicon_handle h, cxobj *xml, cxobj **xret, int *sp);
+int clicon_rpc_netconf_xml_str(clicon_handle h, cxobj *xml, char **retdata);
 int clicon_rpc_get_config(clicon_handle h, char *username, char *db, char *xpath, cvec *nsc, cxobj **xret);
+int clicon_rpc_get_config_page(clicon_handle h, char *username, char *db, char *xpath, cvec *nsc,
+			       uint32_t offset, uint32_t limit, cxobj **xret);
+int clicon_rpc_get_values(clicon_handle h, char *db, char *filter, char *xpath, cvec *nsc,
+			  char *prefix, uint32_t limit, cxobj **xret);
 int clicon_rpc_edit_config(clicon_handle h, char *db, enum operation_type op, 
 			   char *xml);
 int clicon_rpc_copy_config(clicon_handle h, char *db1, char *db2);
@@ -55,13 +65,23 @@ int clicon_rpc_delete_config(clicon_handle h, char *db);
 int clicon_rpc_lock(clicon_handle h, char *db);
 int clicon_rpc_unlock(clicon_handle h, char *db);
 int clicon_rpc_get(clicon_handle h, char *xpath, cvec *nsc, netconf_content content, int32_t depth, cxobj **xret);
+int clicon_rpc_get_page(clicon_handle h, char *xpath, cvec *nsc, char *api_path, netconf_content content, int32_t depth,
+			uint32_t offset, uint32_t limit, cxobj **xret);
+int clicon_rpc_get_page_str(clicon_handle h, char *xpath, cvec *nsc, char *api_path, netconf_content content, int32_t depth,
+			uint32_t offset, uint32_t limit, char **retdata);
 int clicon_rpc_close_session(clicon_handle h);
+int clicon_rpc_session_select(clicon_handle h, char *username, int max);
+int clicon_rpc_session_pool_free(clicon_handle h);
 int clicon_rpc_kill_session(clicon_handle h, uint32_t session_id);
 int clicon_rpc_validate(clicon_handle h, char *db);
 int clicon_rpc_commit(clicon_handle h);
 int clicon_rpc_discard_changes(clicon_handle h);
 int clicon_rpc_create_subscription(clicon_handle h, char *stream, char *filter, int *s);
+int clicon_rpc_compare(clicon_handle h, char *db0, char *db1, cxobj **xret);
+int clicon_rpc_bulk_load(clicon_handle h, char *db, int begin);
+int clicon_rpc_datastore_token(clicon_handle h, char *db, char **token, uint64_t *modified);
 int clicon_rpc_debug(clicon_handle h, int level);
+int clicon_rpc_stats(clicon_handle h, cxobj **xret);
 int clicon_rpc_restconf_debug(clicon_handle h, int level);
 int clicon_hello_req(clicon_handle h, uint32_t *id);
 
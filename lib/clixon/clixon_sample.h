@@ -0,0 +1,67 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Built-in sampling profiler of a daemon.
+ * The call stack is sampled on SIGPROF and written as folded stacks, one line per
+ * unique stack with its count, which is the input format of flame graph tools.
+ */
+
+#ifndef _CLIXON_SAMPLE_H_
+#define _CLIXON_SAMPLE_H_
+
+/*
+ * Constants
+ */
+/* Signal that starts sampling of a daemon, see clixon_sample_sig() */
+#define CLIXON_SAMPLE_SIG_START SIGUSR1
+
+/* Signal that stops sampling of a daemon and writes folded stacks */
+#define CLIXON_SAMPLE_SIG_STOP  SIGUSR2
+
+/*
+ * Prototypes
+ */
+int  clixon_sample_start(int hz, const char *file);
+int  clixon_sample_stop(void);
+int  clixon_sample_active(void);
+int  clixon_sample_count(void);
+int  clixon_sample_dropped(void);
+char *clixon_sample_file(void);
+void clixon_sample_sig(int sig);
+int  clixon_sample_sig_register(void);
+int  clixon_sample_pending(void);
+int  clixon_sample_pending_run(clicon_handle h);
+
+#endif  /* _CLIXON_SAMPLE_H_ */
@@ -70,21 +70,80 @@
  */
 typedef	int (*stream_fn_t)(clicon_handle h, int op, cxobj *event, void *arg);
 
+/* Subscription filter parsed once and shared by subscriptions with the same xpath
+ * The filter is evaluated at most once per event
+ */
+struct stream_filter{
+    qelem_t                     sf_q;      /* queue header */
+    char                       *sf_xpath;  /* Filter selector as xpath */
+    struct xpath_tree          *sf_tree;   /* Parsed xpath */
+    char                       *sf_root;   /* Event element of first step or NULL */
+    int                         sf_refcnt; /* Number of subscriptions using filter */
+    uint64_t                    sf_gen;    /* Event generation of sf_match */
+    int                         sf_match;  /* Set if filter matches event of sf_gen */
+};
+
 struct stream_subscription{
     qelem_t                     ss_q;   /* queue header */
     char                       *ss_stream; /* Name of associated stream */
     char                       *ss_xpath;  /* Filter selector as xpath */
+    struct stream_filter       *ss_filter; /* Parsed filter or NULL if no filter */
     struct timeval              ss_starttime; /* Replay starttime */
     struct timeval              ss_stoptime; /* Replay stoptime */
     stream_fn_t                 ss_fn;     /* Callback when event occurs */
     void                       *ss_arg;    /* Callback argument */
 };
 
-/* Replay time-series */
+/* Event encoded once and shared by all subscriptions of a notification
+ * @see stream_event_get
+ */
+struct stream_event{
+    cxobj             *se_xml;    /* Event as XML, only valid during notification */
+    int                se_refcnt; /* Reference count */
+    struct clicon_msg *se_msg[2]; /* Encoded notify messages: XML, JSON */
+};
+
+/* Replay time index entry, the event is serialized in the replay data ring */
+struct stream_replay_entry{
+    struct timeval re_tv;  /* time index */
+    size_t         re_off; /* Offset of event in data ring */
+    size_t         re_len; /* Length of event including NUL */
+};
+
+/* Replay time-series as ring buffer of serialized events with a time index
+ * Entries are time ordered starting with the oldest at r_head. Each event is stored
+ * contiguously in the data ring, ie it starts at offset 0 if it does not fit at the end
+ */
 struct stream_replay{
-    qelem_t        r_q;   /* queue header */
-    struct timeval r_tv;  /* time index */
-    cxobj         *r_xml; /* event in xml form */
+    struct stream_replay_entry *r_vec; /* Time index ring */
+    size_t         r_vecmax;  /* Allocated entries in r_vec */
+    size_t         r_head;    /* Index of oldest entry in r_vec */
+    size_t         r_len;     /* Number of entries */
+    char          *r_data;    /* Data ring of serialized events */
+    size_t         r_datamax; /* Allocated size of r_data */
+    char          *r_file;    /* If set, r_data is mmap:ed from this file */
+    int            r_fd;      /* Open file descriptor of r_file */
+};
+
+/* Segment file of persistent replay log, named <seq>.log in the log directory
+ * Each event is a record: struct stream_log_rec header followed by event as XML
+ */
+struct stream_log_segment{
+    qelem_t         ls_q;     /* queue header, oldest first */
+    uint64_t        ls_seq;   /* Sequence number of segment */
+    struct timeval  ls_first; /* Time of first event, time index of segment */
+    size_t          ls_size;  /* Size of segment file */
+};
+
+/* Persistent replay log as append-only segment files, see CLICON_STREAM_REPLAY_LOG
+ * Only the time index of segments is kept in memory
+ */
+struct stream_log{
+    char                      *l_dir;    /* Directory of segment files of stream */
+    size_t                     l_segmax; /* Size of segment before rotated */
+    struct stream_log_segment *l_seg;    /* Segments in time order */
+    int                        l_fd;     /* Append fd of last segment or -1 */
+    uint64_t                   l_nr;     /* Events appended since started */
 };
 
 /* See RFC8040 9.3, stream list, no replay support for now
@@ -96,7 +155,10 @@ struct event_stream{
     struct stream_subscription *es_subscription;
     int                  es_replay_enabled; /* set if replay is enables */
     struct timeval       es_retention; /* replay retention - how much to save */
-    struct stream_replay *es_replay;
+    struct stream_replay es_replay; /* replay buffer */
+    struct stream_filter *es_filter; /* Subscription filters */
+    uint64_t             es_gen;     /* Event generation, see sf_gen */
+    struct stream_log   *es_log;     /* Persistent replay log or NULL */
 
 };
 typedef struct event_stream event_stream_t;
@@ -126,6 +188,12 @@ int stream_notify(clicon_handle h, char *stream, const char *event, ...)  __attr
 int stream_notify(clicon_handle h, char *stream, const char *event, ...);
 #endif
 
+/* Shared event encodings */
+struct stream_event *stream_event_get(cxobj *xev);
+struct stream_event *stream_event_ref(struct stream_event *se);
+int stream_event_free(struct stream_event *se);
+struct clicon_msg *stream_event_msg(struct stream_event *se, int format);
+
 /* Replay */
 int stream_replay_add(event_stream_t *es, struct timeval *tv, cxobj *xv);
 int stream_replay_trigger(clicon_handle h, char *stream, stream_fn_t fn, void *arg);
@@ -134,5 +202,7 @@ int stream_replay_trigger(clicon_handle h, char *stream, stream_fn_t fn, void *a
 int stream_publish(clicon_handle h, char *stream);
 int stream_publish_init();
 int stream_publish_exit();
+int stream_publish_stats(uint64_t *sent, uint64_t *dropped, uint64_t *failed);
+int stream_replay_stats(clicon_handle h, uint64_t *nrp, size_t *szp);
 
 #endif /* _CLIXON_STREAM_H_ */
@@ -99,6 +99,8 @@ int    uri_percent_encode(char **encp, const char *str, ...);
 int    xml_chardata_encode(char **escp, const char *fmt, ...);
 #endif
 int    xml_chardata_cbuf_append(cbuf *cb, char *str);
+int    clicon_cbuf_indent(cbuf *cb, int n);
+int    xml_chardata_write(const char *str, int (*fn)(void *arg, const char *s, size_t len), void *arg);
 int    uri_percent_decode(char *enc, char **str);
 const char *clicon_int2str(const map_str2int *mstab, int i);
 int    clicon_str2int(const map_str2int *mstab, char *str);
@@ -0,0 +1,111 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Tracing of spans of a request across frontend and backend processes.
+ * A trace id is propagated in internal messages, and each completed span is reported
+ * to a pluggable sink, eg a log or an exporter to an external tracing system.
+ */
+
+#ifndef _CLIXON_TRACE_H_
+#define _CLIXON_TRACE_H_
+
+/*
+ * Types
+ */
+/*! Trace sink callback, called once for each completed span
+ * @param[in]  arg   Argument given to clixon_trace_sink_set()
+ * @param[in]  id    Trace id of request, 0 if no request is traced
+ * @param[in]  span  Span, eg "rpc", "xmldb-put" or transaction callback, eg "validate"
+ * @param[in]  name  Detail of span or NULL, eg rpc name, datastore or plugin name
+ * @param[in]  t0    Monotonic time when span started
+ * @param[in]  t1    Monotonic time when span ended
+ * @retval     0     OK
+ * @retval    -1     Error, is logged but does not affect the request
+ */
+typedef int (clixon_trace_sink)(void *arg, uint64_t id, const char *span, const char *name,
+				struct timespec *t0, struct timespec *t1);
+
+/*
+ * Macros
+ */
+/* Tracing is enabled if a sink is set */
+#define clixon_trace_enabled() (_clixon_trace_sink_fn != NULL)
+
+/*! Start a span: get monotonic start time if tracing is enabled
+ * @param[out] t0    struct timespec, start time of span
+ */
+#define clixon_trace_start(t0)						\
+    do {								\
+	if (clixon_trace_enabled())					\
+	    clock_gettime(CLOCK_MONOTONIC, (t0));			\
+    } while (0)
+
+/*! End a span and report it to the trace sink if tracing is enabled
+ * @param[in]  t0    struct timespec, start time of span set by clixon_trace_start()
+ * @param[in]  span  Span, constant string
+ * @param[in]  name  Detail of span, or NULL
+ * @code
+ *   struct timespec t0;
+ *
+ *   clixon_trace_start(&t0);
+ *   ...
+ *   clixon_trace_end(&t0, "xmldb-put", db);
+ * @endcode
+ */
+#define clixon_trace_end(t0, span, name)				\
+    do {								\
+	if (clixon_trace_enabled())					\
+	    clixon_trace_span((t0), (span), (name));			\
+    } while (0)
+
+/*
+ * Variables
+ */
+/* Trace sink, use clixon_trace_sink_set(), not this directly */
+extern clixon_trace_sink *_clixon_trace_sink_fn;
+
+/*
+ * Prototypes
+ */
+int      clixon_trace_sink_set(clixon_trace_sink *fn, void *arg);
+int      clixon_trace_sink_log(void *arg, uint64_t id, const char *span, const char *name,
+			       struct timespec *t0, struct timespec *t1);
+uint64_t clixon_trace_id_get(void);
+int      clixon_trace_id_set(uint64_t id);
+uint64_t clixon_trace_id_new(void);
+int      clixon_trace_id_parse(const char *str, uint64_t *id);
+int      clixon_trace_span(struct timespec *t0, const char *span, const char *name);
+
+#endif  /* _CLIXON_TRACE_H_ */
@@ -68,6 +68,20 @@
 /*
  * Types
  */
+/* Backing of arena blocks that XML nodes are allocated from, see xml_arena_pages_set */
+enum xml_arena_pages{
+    XML_ARENA_PAGES_NONE,        /* Regular pages, blocks are malloced */
+    XML_ARENA_PAGES_TRANSPARENT, /* Transparent huge pages advised on chunks of blocks */
+    XML_ARENA_PAGES_EXPLICIT,    /* Chunks of blocks mapped from reserved huge pages */
+};
+
+/* Format of cached paths of list entries, see xml_path_cache_get */
+enum xml_path_type{
+    XML_PATH_XPATH,       /* Unqualified xpath, see xml2xpath */
+    XML_PATH_INSTANCE_ID, /* Instance-identifier, see xml2instance_id */
+    XML_PATH_NR
+};
+
 /* Netconf operation type */
 enum operation_type{ /* edit-config operation */
     OP_MERGE,  /* merge config-data */
@@ -153,6 +167,16 @@ typedef int (xml_applyfn_t)(cxobj *x, void *arg);
 
 typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c */
 
+/*! External iterator over the children of an XML node, see xml_child_iter_init
+ * The cursor is kept in the iterator, not in the nodes, so that loops over the same
+ * parent may be nested and a tree may be read concurrently.
+ */
+typedef struct {
+    cxobj          *xi_parent; /* Parent node */
+    int             xi_i;      /* Index of next child */
+    enum cxobj_type xi_type;   /* Type of children, or CX_ERROR for all */
+} clixon_xml_iter;
+
 /*
  * xml_flag() flags:
  */
@@ -163,6 +187,16 @@ typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c
 #define XML_FLAG_NONE    0x10  /* Node is added as NONE */
 #define XML_FLAG_DEFAULT 0x20  /* Added when a value is set as default @see xml_default */
 #define XML_FLAG_TOP     0x40  /* Top datastore symbol */
+#define XML_FLAG_SORTED  0x80  /* Children are sorted, reset when unsorted @see xml_sort */
+#define XML_FLAG_LAZY    0x100 /* Node bound but not its children @see xml_bind_yang_lazy */
+#define XML_FLAG_REPORT_ALL 0x200 /* Top node: default values not in the tree are printed
+				    * when serialized, @see xml_default_next */
+
+/* Compare XML names or prefixes, eg xml_name(x) with a name.
+ * If XML_INTERN_NAMES, names of XML nodes are shared and equal names of two nodes are 
+ * equal pointers, then strcmp is only made if pointers differ.
+ */
+#define xml_name_eq(n1, n2) ((n1) == (n2) || strcmp((n1), (n2)) == 0)
 
 /*
  * Prototypes
@@ -170,6 +204,9 @@ typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c
 char     *xml_type2str(enum cxobj_type type);
 int       xml_stats_global(uint64_t *nr);
 int       xml_stats(cxobj *xt, uint64_t *nrp, size_t *szp);
+int       xml_arena_begin(void);
+int       xml_arena_end(void);
+int       xml_arena_pages_set(enum xml_arena_pages pages, int numa);
 char     *xml_name(cxobj *xn);
 int       xml_name_set(cxobj *xn, char *name);
 char     *xml_prefix(cxobj *xn);
@@ -192,6 +229,7 @@ int       xml_flag_reset(cxobj *xn, uint16_t flag);
 char     *xml_value(cxobj *xn);
 int       xml_value_set(cxobj *xn, char *val);
 int       xml_value_append(cxobj *xn, char *val);
+int       xml_value_intern(cxobj *xn);
 enum cxobj_type xml_type(cxobj *xn);
 
 int       xml_child_nr(cxobj *xn);
@@ -202,12 +240,15 @@ cxobj    *xml_child_i_type(cxobj *xn, int i, enum cxobj_type type);
 cxobj    *xml_child_i_set(cxobj *xt, int i, cxobj *xc);
 int       xml_child_order(cxobj *xn, cxobj *xc);
 cxobj    *xml_child_each(cxobj *xparent, cxobj *xprev,  enum cxobj_type type);
+int       xml_child_iter_init(clixon_xml_iter *it, cxobj *xparent, enum cxobj_type type);
+cxobj    *xml_child_iter_next(clixon_xml_iter *it);
 
 int       xml_child_insert_pos(cxobj *x, cxobj *xc, int i);
 int       xml_childvec_set(cxobj *x, int len);
 cxobj   **xml_childvec_get(cxobj *x);
 cxobj    *xml_new(char *name, cxobj *xn_parent, enum cxobj_type type);
 cxobj    *xml_new_body(char *name, cxobj *parent, char *val);
+int       xml_spec_lazy_enable(void);
 yang_stmt *xml_spec(cxobj *x);
 int       xml_spec_set(cxobj *x, yang_stmt *spec);
 cg_var   *xml_cv(cxobj *x);
@@ -220,6 +261,7 @@ int       xml_purge(cxobj *xc);
 int       xml_child_rm(cxobj *xp, int i);
 int       xml_rm(cxobj *xc);
 int       xml_rm_children(cxobj *x, enum cxobj_type type);
+int       xml_purge_children(cxobj *xp, xml_applyfn_t *fn, void *arg);
 int       xml_rootchild(cxobj  *xp, int i, cxobj **xcp);
 int       xml_rootchild_node(cxobj  *xp, cxobj *xc);
 int       xml_enumerate_children(cxobj *xp);
@@ -264,9 +306,20 @@ int       xml_search_index_p(cxobj *x);
 int       xml_search_vector_get(cxobj *x, char *name, clixon_xvec **xvec);
 int       xml_search_child_insert(cxobj *xp, cxobj *x);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
+int       xml_search_index_build(cxobj *xp, yang_stmt *yc, char *indexvar, clixon_xvec **xvec);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
 
+#endif
+#ifdef XML_KEY_HASH
+int       xml_key_hash_find(cxobj *xp, yang_stmt *yc, cvec *cvk, clixon_xvec *xvec);
+#endif
+#ifdef XML_SUBTREE_HASH
+uint64_t  xml_hash(cxobj *x);
+#endif
+#ifdef XML_PATH_CACHE
+char     *xml_path_cache_get(cxobj *x, enum xml_path_type type);
+int       xml_path_cache_set(cxobj *x, enum xml_path_type type, char *path);
 #endif
 
 #endif /* _CLIXON_XML_H */
@@ -48,5 +48,9 @@ int xml_bind_yang_rpc(cxobj *xrpc, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang_rpc_reply(cxobj *xrpc, char *name, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang0(cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
 int xml_bind_yang(cxobj *xt, yang_bind yb, yang_stmt *yspec, cxobj **xerr);
+int xml_bind_yang_lazy(cxobj *xt, yang_stmt *yspec, cxobj **xerr);
+int xml_bind_yang_lazy_children(cxobj *xt);
+int xml_bind_yang_parse(cxobj *xt, yang_bind yb, cxobj *xsibling, yang_stmt *yspec, cxobj **xerr);
+int xml_bind_yang_parse_done(cxobj *xt);
 
 #endif  /* _CLIXON_XML_BIND_H_ */
@@ -40,6 +40,18 @@
 #ifndef _CLIXON_XML_IO_H_
 #define _CLIXON_XML_IO_H_
 
+/*
+ * Types
+ */
+/*! Callback for chunked XML output, see clicon_xml2chunk
+ * @param[in]  arg   User argument
+ * @param[in]  buf   Serialized XML chunk, not NULL-terminated
+ * @param[in]  len   Length of chunk
+ * @retval     0     OK
+ * @retval    -1     Error, clicon_err called
+ */
+typedef int (clicon_xml_chunk_cb)(void *arg, char *buf, size_t len);
+
 /*
  * Prototypes
  */
@@ -48,9 +60,12 @@ int clicon_xml2file(FILE *f, cxobj *x, int level, int prettyprint);
 int xml_print(FILE *f, cxobj *xn);
 int clicon_xml2cbuf(cbuf *cb, cxobj *x, int level, int prettyprint, int32_t depth);
 char *clicon_xml2str(cxobj *x);
+int clicon_xml2chunk(cxobj *x, int32_t depth, size_t chunk, clicon_xml_chunk_cb *fn, void *arg);
+int clicon_xml2len(cxobj *x, int32_t depth, size_t *len);
 int xmltree2cbuf(cbuf *cb, cxobj *x, int level);
 
 int clixon_xml_parse_file(FILE *f, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
+int clixon_xml_parse_file_presorted(FILE *f, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 int clixon_xml_parse_string(const char *str, yang_bind yb, yang_stmt *yspec, cxobj **xt, cxobj **xerr);
 
 #if defined(__GNUC__) && __GNUC__ >= 3
@@ -65,6 +65,7 @@ int xml_tree_prune_flagged_sub(cxobj *xt, int flag, int test, int *upmark);
 int xml_tree_prune_flagged(cxobj *xt, int flag, int test);
 int xml_namespace_change(cxobj *x, char *ns, char *prefix);
 int xml_default_recurse(cxobj *xn, int state);
+int xml_default_next(yang_stmt *ys, cxobj *x, int state, yang_stmt **ycp);
 int xml_global_defaults(clicon_handle h, cxobj *xn, cvec *nsc, const char *xpath, yang_stmt *yspec, int state);
 int xml_nopresence_default(cxobj *xt);
 int xml_nopresence_default_mark(cxobj *x, void *arg);
@@ -76,5 +77,7 @@ int assign_namespace_body(cxobj *x0, char *x0bstr, cxobj *x1);
 int xml_merge(cxobj *x0, cxobj *x1, yang_stmt *yspec, char **reason);
 int yang_enum_int_value(cxobj *node, int32_t *val);
 int xml_copy_marked(cxobj *x0, cxobj *x1);
+int xml_copy_mark(cxobj **vec, size_t len);
+int xml_copy_mark_reset(cxobj **vec, size_t len);
 
 #endif  /* _CLIXON_XML_MAP_H_ */
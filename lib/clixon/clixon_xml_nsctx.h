@@ -58,6 +58,7 @@ int     xml_nsctx_get_prefix(cvec *cvv,	char *ns, char **prefix);
 int     xml_nsctx_add(cvec *nsc, char *prefix, char *ns);
 int     xml_nsctx_node(cxobj *x, cvec **ncp);
 int     xml_nsctx_yang(yang_stmt *yn, cvec **ncp);
+cvec   *xml_nsctx_yang_get(yang_stmt *yn);
 int     xml_nsctx_yangspec(yang_stmt *yspec, cvec **ncp);
 int     xml_nsctx_cbuf(cbuf *cb, cvec *nsc);
 
@@ -41,6 +41,9 @@
 /*
  * Prototypes
  */
+int xml_cv_cache_keep(int val);
+int xml_cv_parse(cxobj *x, yang_stmt *y, cg_var **cvp, char **reason);
+int xml_cv_cache_bind(cxobj *x, yang_stmt *y);
 int xml_cmp(cxobj *x1, cxobj *x2, int same, int skip1, char *expl);
 int xml_sort(cxobj *x0);
 int xml_sort_recurse(cxobj *xn);
@@ -54,5 +57,7 @@ int match_base_child(cxobj *x0, cxobj *x1c, yang_stmt *yc, cxobj **x0cp);
 int clixon_xml_find_index(cxobj *xp, yang_stmt *yp, char *ns, char *name,
 			  cvec *cvk, clixon_xvec *xvec);
 int clixon_xml_find_pos(cxobj *xp, yang_stmt *yc, uint32_t pos, clixon_xvec *xvec);
+int clixon_xml_find_range(cxobj *xp, yang_stmt *yc, char *lower, char *upper, int prefix,
+			  clixon_xvec *xvec);
 
 #endif /* _CLIXON_XML_SORT_H */
@@ -55,7 +55,10 @@ int          clixon_xvec_extract(clixon_xvec *xv, cxobj ***xvec, int *xlen);
 int          clixon_xvec_append(clixon_xvec *xv, cxobj *x);
 int          clixon_xvec_prepend(clixon_xvec *xv, cxobj *x);
 int          clixon_xvec_insert_pos(clixon_xvec *xv, cxobj *x, int i);
+int          clixon_xvec_insert_vec(clixon_xvec *xv, int i, cxobj **vec, int n);
 int          clixon_xvec_rm_pos(clixon_xvec *xv, int i);
+int          clixon_xvec_rm_marked(clixon_xvec *xv, uint8_t *rm);
+int          clixon_xvec_sort(clixon_xvec *xv, int (*cmp)(const void *, const void *));
 int          clixon_xvec_print(FILE *f, clixon_xvec *xv);
 
 #endif /* _CLIXON_XML_VEC_H */
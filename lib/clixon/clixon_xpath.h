@@ -102,6 +102,17 @@ enum xp_type{
     XP_PRIME_FN,
 };
 
+/*! Profiling counters of an xpath_tree node, see xpath_profile
+ */
+struct xpath_prof{
+    uint32_t           xp_evals;    /* Nr of evaluations of the node */
+    uint32_t           xp_visits;   /* Nr of XML nodes tested by a step */
+    uint32_t           xp_preds;    /* Nr of predicate evaluations, one per context node */
+    uint32_t           xp_opthit;   /* Nr of list lookups made by the optimizer */
+    uint32_t           xp_optmiss;  /* Nr of optimizer checks not leading to a lookup */
+    uint64_t           xp_usec;     /* Time in node including its children */
+};
+
 /*! XPATH Parsing generates a tree of nodes that is later traversed
  * That is, a tree-structured XPATH.
  * Note that the structure follows XPATH 1.0 closely. The drawback wit this is that the tree gets
@@ -117,6 +128,7 @@ struct xpath_tree{
     struct xpath_tree *xs_c0;     /* child 0 */
     struct xpath_tree *xs_c1;     /* child 1 */
     int                xs_match;  /* meta: match this node */
+    struct xpath_prof *xs_prof;   /* meta: profiling counters, see xpath_profile */
 };
 typedef struct xpath_tree xpath_tree;
 
@@ -132,7 +144,11 @@ int   xpath_tree_eq(xpath_tree *xt1, xpath_tree *xt2, xpath_tree ***vec, size_t
 xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
+int   xpath_cache_clear(void);
+int   xpath_cache_stats(int *hits, int *misses, int *len);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx  **xrp);
+int   xpath_profile(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx **xrp, cbuf *cb);
+cxobj *xpath_first_tree(cxobj *xcur, cvec *nsc, xpath_tree *xptree);
 
 #if defined(__GNUC__) && __GNUC__ >= 3
 int    xpath_vec_bool(cxobj *xcur, cvec *nsc, const char *xpformat, ...) __attribute__ ((format (printf, 3, 4)));
@@ -38,10 +38,24 @@
 #ifndef _CLIXON_XPATH_OPTIMIZE_H
 #define _CLIXON_XPATH_OPTIMIZE_H
 
+/*
+ * Types
+ */
+/* Optimized xpath patterns, see xpath_list_optimize_stats */
+enum xpath_optimize_pattern{
+    XPO_KEY,     /* All list keys as predicates: y[k1='x'][k2='y'] */
+    XPO_KEY_AND, /* All list keys with and-expressions: y[k1='x' and k2='y'] */
+    XPO_INDEX,   /* Explicit search index: y[i='x'] */
+    XPO_RANGE,   /* Range of first key: y[k>1 and k<9] or y[starts-with(k,'x')] */
+    XPO_NR       /* Number of patterns */
+};
 
-int  xpath_list_optimize_stats(int *hits);
+/*
+ * Prototypes
+ */
+int  xpath_list_optimize_stats(int *hits, int *pattern);
 int  xpath_list_optimize_set(int enable); 
 void xpath_optimize_exit(void);
-int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, cxobj ***xvec0, int *xlen0);
+int  xpath_optimize_check(xpath_tree *xs, cxobj *xv, xp_ctx *xr);
 
 #endif /* _CLIXON_XPATH_OPTIMIZE_H */
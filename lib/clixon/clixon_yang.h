@@ -53,6 +53,21 @@
  */
 #define YANG_FLAG_MARK  0x01  /* (Dynamic) marker for dynamic algorithms, eg expand and DAG */
 #define YANG_FLAG_TMP   0x02  /* (Dynamic) marker for dynamic algorithms, eg DAG detection */
+#define YANG_FLAG_INTERN_DONE 0x08 /* (Cached) Leaf type checked for YANG_FLAG_INTERN */
+#define YANG_FLAG_INTERN 0x10 /* (Cached) Leaf values are interned, see xml_value_intern */
+#define YANG_FLAG_XPATH_DEP 0x20 /* (Cached) Node or descendant has leafref, must or when
+				  * that may depend on other nodes */
+#define YANG_FLAG_DEP_SELF 0x40 /* (Dynamic) Constraints of node may depend on changed nodes,
+				 * see xml_yang_validate_changed_top */
+#define YANG_FLAG_DEP_DESC 0x80 /* (Dynamic) Descendant has YANG_FLAG_DEP_SELF */
+#define YANG_FLAG_MAPPED 0x100 /* Argument is in a shared read-only mapping of a yang cache
+				* file and is not freed, see yang_cache_load */
+#define YANG_FLAG_DEFAULT 0x200 /* (Cached) Node or descendant is leaf with default value,
+				 * see xml_default_recurse */
+#define YANG_FLAG_DESCNAMES 0x400 /* (Dynamic) Descendant name filter is computed,
+				   * see yang_desc_names_get */
+#define YANG_FLAG_SHARED 0x800 /* Argument is owned by the grouping statement this node is
+				* expanded from and is not freed, see ys_dup_shared */
 #ifdef XML_EXPLICIT_INDEX
 #define YANG_FLAG_INDEX 0x04  /* This yang node under list is (extra) index. --> you can access
 			       * list elements using this index with binary search */
@@ -153,7 +168,20 @@ enum yang_class{
 };
 typedef enum yang_class yang_class;
 
+/* JSON encoding of values of a leaf or leaf-list, derived from its resolved type
+ * See yang_json_enc_get() and RFC 7951 Sec 6
+ */
+enum yang_json_enc{
+    YJ_NONE,            /* Not derived yet */
+    YJ_STRING,          /* Quoted string, eg string, enumeration, union */
+    YJ_LITERAL,         /* Unquoted number or boolean */
+    YJ_IDENTITYREF,     /* Quoted, with module name instead of XML prefix */
+    YJ_EMPTY,           /* Empty type: [null] */
+    YJ_OTHER            /* Type not resolved, quoted */
+};
+
 struct xml;
+struct yang_validator; /* Defined in clixon_yang_type.c */
 
 typedef struct yang_stmt yang_stmt; /* Defined in clixon_yang_internal */
 
@@ -205,6 +233,12 @@ char      *yang_when_xpath_get(yang_stmt *ys);
 int        yang_when_xpath_set(yang_stmt *ys, char *xpath);
 cvec      *yang_when_nsc_get(yang_stmt *ys);
 int        yang_when_nsc_set(yang_stmt *ys, cvec *nsc);
+cvec      *yang_nsc_get(yang_stmt *ys);
+int        yang_nsc_set(yang_stmt *ys, cvec *nsc);
+int        yang_json_name_get(yang_stmt *ys, yang_stmt **ymod, char **qname);
+int        yang_json_enc_get(yang_stmt *ys, enum yang_json_enc *enc);
+uint64_t   yang_name_bits(const char *name);
+uint64_t   yang_desc_names_get(yang_stmt *ys);
 
 /* Other functions */
 yang_stmt *yspec_new(void);
@@ -214,6 +248,7 @@ yang_stmt *ys_prune(yang_stmt *yp, int i);
 int        ys_free(yang_stmt *ys);
 int        ys_cp(yang_stmt *nw, yang_stmt *old);
 yang_stmt *ys_dup(yang_stmt *old);
+yang_stmt *ys_dup_shared(yang_stmt *old);
 int        yn_insert(yang_stmt *ys_parent, yang_stmt *ys_child);
 yang_stmt *yn_each(yang_stmt *yn, yang_stmt *ys);
 char      *yang_key2str(int keyword);
@@ -235,6 +270,7 @@ int        yang_print_cb(FILE *f, yang_stmt *yn, clicon_output_cb *fn);
 int        yang_print(FILE *f, yang_stmt *yn);
 int        yang_print_cbuf(cbuf *cb, yang_stmt *yn, int marginal);
 int        yang_spec_dump(yang_stmt *yspec, int debuglevel);
+int        yang_stats(yang_stmt *yt, uint64_t *nrp, size_t *szp);
 int        if_feature(yang_stmt *yspec, char *module, char *feature);
 int        ys_populate(yang_stmt *ys, void *arg);
 int        ys_populate2(yang_stmt *ys, void *arg);
@@ -247,6 +283,11 @@ int        yang_mandatory(yang_stmt *ys);
 int        yang_config(yang_stmt *ys);
 int        yang_config_ancestor(yang_stmt *ys);
 int        yang_features(clicon_handle h, yang_stmt *yt);
+int        yang_features_populate(clicon_handle h, yang_stmt *ymod);
+int        yang_if_feature_memo_init(void);
+void       yang_if_feature_memo_free(void);
+int        yang_schema_nodeid_memo_init(void);
+void       yang_schema_nodeid_memo_free(void);
 cvec      *yang_arg2cvec(yang_stmt *ys, char *delimi);
 int        yang_container_cli_hide(yang_stmt *ys, int gt);
 int        yang_key_match(yang_stmt *yn, char *name);
@@ -254,9 +295,17 @@ int        yang_key_match(yang_stmt *yn, char *name);
 int        yang_type_cache_regexp_set(yang_stmt *ytype, int rxmode, cvec *regexps);
 int        yang_type_cache_get(yang_stmt *ytype, yang_stmt **resolved, int *options,
 		   cvec **cvv, cvec *patterns, int *rxmode, cvec *regexps, uint8_t *fraction);
+int        yang_index_reset(yang_stmt *ys);
+yang_stmt *yang_base_identity(yang_stmt *ybase);
+int        yang_identity_derived(yang_stmt *yid, yang_stmt *ybaseid);
 int        yang_type_cache_set(yang_stmt *ys, yang_stmt *resolved, int options, cvec *cvv,
 			       cvec *patterns, uint8_t fraction);
+int        yang_type_cache_validator_get(yang_stmt *ytype, struct yang_validator **yvp);
+int        yang_type_cache_validator_set(yang_stmt *ytype, struct yang_validator *yv);
 yang_stmt *yang_anydata_add(yang_stmt *yp, char *name);
 int        yang_extension_value(yang_stmt *ys, char *name, char *ns, char **value);
+#ifdef XML_EXPLICIT_INDEX
+int        yang_search_index_config(clicon_handle h, yang_stmt *yspec);
+#endif
 
 #endif  /* _CLIXON_YANG_H_ */
@@ -0,0 +1,883 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * CBOR encoding of XML trees bound to YANG, used as datastore format
+ *
+ * The encoding follows RFC 9254 (YANG-CBOR) with member names, in the same way as the
+ * JSON encoding of RFC 7951 which it is a binary form of:
+ * - A container or list entry is a map, with the names of its children as keys.
+ *   Names are qualified as "module:name" at top-level and where the module changes.
+ * - A list or leaf-list is an array of its entries.
+ * - Integers, booleans and decimal64 are encoded as CBOR numbers, the latter as a
+ *   decimal fraction (tag 4) with the exponent given by the number of fraction digits
+ *   so that the string is restored. Values that are not canonical are encoded as text.
+ * - An empty leaf is [null], other values are text strings.
+ * All lengths are definite. Binary is text (base64) as in XML.
+ * The encoding is preceded by the self-described CBOR tag, see CLIXON_CBOR_MAGIC
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_yang_type.h"
+#include "clixon_yang_module.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_bind.h"
+#include "clixon_json.h"
+#include "clixon_cbor.h"
+
+/* CBOR major types, RFC 8949 Sec 3.1 */
+#define CBOR_UINT   0
+#define CBOR_NINT   1
+#define CBOR_BSTR   2
+#define CBOR_TSTR   3
+#define CBOR_ARRAY  4
+#define CBOR_MAP    5
+#define CBOR_TAG    6
+#define CBOR_SIMPLE 7
+
+/* Simple values */
+#define CBOR_FALSE  20
+#define CBOR_TRUE   21
+#define CBOR_NULL   22
+
+/* Tag of decimal fraction [exponent, mantissa] */
+#define CBOR_TAG_DECFRAC 4
+
+/* Max nesting of decoded maps and arrays */
+#define CBOR_DEPTH_MAX 1024
+
+/* Decoder state */
+struct cbor_dec{
+    uint8_t *cd_buf;   /* Input buffer */
+    size_t   cd_len;   /* Length of input buffer */
+    size_t   cd_pos;   /* Position in input buffer */
+};
+
+/*! Encode major type and argument, RFC 8949 Sec 3
+ */
+static int
+cbor_enc_head(cbuf    *cb,
+	      int      major,
+	      uint64_t n)
+{
+    char buf[9];
+    int  len;
+    int  i;
+
+    if (n < 24){
+	buf[0] = (major<<5) | n;
+	len = 1;
+    }
+    else{
+	if (n <= 0xff)
+	    len = 1;
+	else if (n <= 0xffff)
+	    len = 2;
+	else if (n <= 0xffffffff)
+	    len = 4;
+	else
+	    len = 8;
+	buf[0] = (major<<5) | (len==1?24:len==2?25:len==4?26:27);
+	for (i=len; i>0; i--){
+	    buf[i] = n & 0xff;
+	    n >>= 8;
+	}
+	len++;
+    }
+    return cbuf_append_buf(cb, buf, len);
+}
+
+/*! Encode a signed integer
+ */
+static int
+cbor_enc_int(cbuf   *cb,
+	     int64_t n)
+{
+    if (n >= 0)
+	return cbor_enc_head(cb, CBOR_UINT, n);
+    else
+	return cbor_enc_head(cb, CBOR_NINT, (uint64_t)(-(n+1)));
+}
+
+/*! Encode a text string
+ */
+static int
+cbor_enc_text(cbuf *cb,
+	      char *str)
+{
+    size_t len;
+
+    if (str == NULL)
+	str = "";
+    len = strlen(str);
+    if (cbor_enc_head(cb, CBOR_TSTR, len) < 0)
+	return -1;
+    return cbuf_append_buf(cb, str, len);
+}
+
+/*! Encode a decimal64 string as decimal fraction if canonical, eg "-1.50" -> 4([-2, -150])
+ * @retval  1  Encoded
+ * @retval  0  Not canonical, not encoded
+ */
+static int
+cbor_enc_dec64(cbuf *cb,
+	       char *str)
+{
+    char    *s = str;
+    int      neg = 0;
+    int64_t  m = 0;
+    int      fd = -1; /* Fraction digits, -1 before point */
+    int      nd = 0;  /* Integer digits */
+
+    if (*s == '-'){
+	neg = 1;
+	s++;
+    }
+    /* No leading zeros */
+    if (s[0] == '0' && s[1] != '.' && s[1] != '\0')
+	return 0;
+    for (; *s; s++){
+	if (*s == '.' && fd < 0 && nd > 0)
+	    fd = 0;
+	else if (*s >= '0' && *s <= '9'){
+	    if (m > (INT64_MAX - 9)/10)
+		return 0;
+	    m = m*10 + (*s - '0');
+	    if (fd < 0)
+		nd++;
+	    else
+		fd++;
+	}
+	else
+	    return 0;
+    }
+    if (nd == 0 || fd == 0 || (neg && m == 0))
+	return 0;
+    if (fd < 0)
+	fd = 0;
+    if (cbor_enc_head(cb, CBOR_TAG, CBOR_TAG_DECFRAC) < 0 ||
+	cbor_enc_head(cb, CBOR_ARRAY, 2) < 0 ||
+	cbor_enc_int(cb, -fd) < 0 ||
+	cbor_enc_int(cb, neg?-m:m) < 0)
+	return -1;
+    return 1;
+}
+
+/*! Encode the value of a leaf or leaf-list entry according to its YANG type
+ * @param[out] cb   Output buffer
+ * @param[in]  x    XML leaf or leaf-list entry
+ * @param[in]  y    YANG leaf or leaf-list
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+cbor_enc_leaf(cbuf      *cb,
+	      cxobj     *x,
+	      yang_stmt *y)
+{
+    int          retval = -1;
+    char        *body;
+    char        *origtype = NULL;
+    yang_stmt   *ytype = NULL;
+    char        *restype = NULL;
+    char        *ep;
+    char         num[32];
+    int64_t      i;
+    uint64_t     u;
+    cbuf        *cbi = NULL;
+    int          ret;
+
+    body = xml_body(x);
+    if (yang_type_get(y, &origtype, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+	goto done;
+    restype = ytype?yang_argument_get(ytype):NULL;
+    switch (yang_type2cv(y)){
+    case CGV_INT8:
+    case CGV_INT16:
+    case CGV_INT32:
+    case CGV_INT64:
+	if (body == NULL)
+	    break;
+	errno = 0;
+	i = strtoll(body, &ep, 10);
+	if (errno || *ep != '\0')
+	    break;
+	/* Canonical, so that the same string is decoded */
+	snprintf(num, sizeof(num), "%" PRId64, i);
+	if (strcmp(num, body) != 0)
+	    break;
+	if (cbor_enc_int(cb, i) < 0)
+	    goto done;
+	goto ok;
+    case CGV_UINT8:
+    case CGV_UINT16:
+    case CGV_UINT32:
+    case CGV_UINT64:
+	if (body == NULL)
+	    break;
+	errno = 0;
+	u = strtoull(body, &ep, 10);
+	if (errno || *ep != '\0')
+	    break;
+	snprintf(num, sizeof(num), "%" PRIu64, u);
+	if (strcmp(num, body) != 0)
+	    break;
+	if (cbor_enc_head(cb, CBOR_UINT, u) < 0)
+	    goto done;
+	goto ok;
+    case CGV_BOOL:
+	if (body == NULL)
+	    break;
+	if (strcmp(body, "true") == 0 || strcmp(body, "false") == 0){
+	    if (cbor_enc_head(cb, CBOR_SIMPLE, body[0]=='t'?CBOR_TRUE:CBOR_FALSE) < 0)
+		goto done;
+	    goto ok;
+	}
+	break;
+    case CGV_DEC64:
+	if (body == NULL)
+	    break;
+	if ((ret = cbor_enc_dec64(cb, body)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+	break;
+    case CGV_VOID: /* YANG empty type */
+	if (body == NULL && restype && strcmp(restype, "empty") == 0){
+	    if (cbor_enc_head(cb, CBOR_ARRAY, 1) < 0 ||
+		cbor_enc_head(cb, CBOR_SIMPLE, CBOR_NULL) < 0)
+		goto done;
+	    goto ok;
+	}
+	break;
+    default:
+	if (body && restype && strcmp(restype, "identityref") == 0){
+	    /* Prefix as module name, as JSON */
+	    if ((cbi = cbuf_new()) == NULL){
+		clicon_err(OE_XML, errno, "cbuf_new");
+		goto done;
+	    }
+	    if (xml2json_encode_identityref(xml_body_get(x), body, y, cbi) < 0)
+		goto done;
+	    if (cbor_enc_text(cb, cbuf_get(cbi)) < 0)
+		goto done;
+	    goto ok;
+	}
+	break;
+    }
+    if (cbor_enc_text(cb, body) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cbi)
+	cbuf_free(cbi);
+    if (origtype)
+	free(origtype);
+    return retval;
+}
+
+static int cbor_enc_children(cbuf *cb, cxobj *x);
+
+/*! Encode an XML element as value: a leaf value, or a map of its children
+ */
+static int
+cbor_enc_node(cbuf  *cb,
+	      cxobj *x)
+{
+    yang_stmt *y;
+    char      *body;
+
+    if ((y = xml_spec(x)) != NULL &&
+	(yang_keyword_get(y) == Y_LEAF || yang_keyword_get(y) == Y_LEAF_LIST))
+	return cbor_enc_leaf(cb, x, y);
+    if (xml_child_nr_type(x, CX_ELMNT) == 0 &&
+	(body = xml_body(x)) != NULL) /* eg anydata */
+	return cbor_enc_text(cb, body);
+    return cbor_enc_children(cb, x);
+}
+
+/*! Check if two siblings are entries of the same list or leaf-list
+ */
+static int
+cbor_same(cxobj *x1,
+	  cxobj *x2)
+{
+    if (xml_spec(x1) != xml_spec(x2))
+	return 0;
+    if (xml_spec(x1) != NULL)
+	return 1;
+    return strcmp(xml_name(x1), xml_name(x2)) == 0;
+}
+
+/*! Encode the element children of an XML element as a map
+ *
+ * Entries of a list or leaf-list are adjacent siblings and are encoded as an array
+ */
+static int
+cbor_enc_children(cbuf  *cb,
+		  cxobj *x)
+{
+    int        retval = -1;
+    cxobj     *xc;
+    cxobj     *xn;
+    cxobj     *xprev;
+    yang_stmt *y;
+    yang_stmt *yc;
+    cbuf      *cbn = NULL;
+    int        nr = 0;
+    int        len;
+    int        keyword;
+
+    /* Number of map entries, ie runs of siblings */
+    xprev = NULL;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+	if (xprev == NULL || !cbor_same(xprev, xc))
+	    nr++;
+	xprev = xc;
+    }
+    if (cbor_enc_head(cb, CBOR_MAP, nr) < 0)
+	goto done;
+    if ((cbn = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    y = xml_spec(x);
+    xc = xml_child_each(x, NULL, CX_ELMNT);
+    while (xc != NULL){
+	/* Name, qualified with module at top-level or if module changes */
+	cbuf_reset(cbn);
+	if ((yc = xml_spec(xc)) != NULL &&
+	    (y == NULL || ys_module(yc) != ys_module(y)))
+	    cprintf(cbn, "%s:", yang_argument_get(ys_module(yc)));
+	cprintf(cbn, "%s", xml_name(xc));
+	if (cbor_enc_text(cb, cbuf_get(cbn)) < 0)
+	    goto done;
+	/* Length of run */
+	len = 1;
+	xn = xc;
+	while ((xn = xml_child_each(x, xn, CX_ELMNT)) != NULL && cbor_same(xc, xn))
+	    len++;
+	keyword = yc?yang_keyword_get(yc):Y_CONTAINER;
+	if (keyword == Y_LIST || keyword == Y_LEAF_LIST || len > 1){
+	    if (cbor_enc_head(cb, CBOR_ARRAY, len) < 0)
+		goto done;
+	}
+	for (; len > 0; len--){
+	    if (cbor_enc_node(cb, xc) < 0)
+		goto done;
+	    xc = xml_child_each(x, xc, CX_ELMNT);
+	}
+    }
+    retval = 0;
+ done:
+    if (cbn)
+	cbuf_free(cbn);
+    return retval;
+}
+
+/*! Encode the children of an XML tree as CBOR
+ *
+ * @param[out] cb   Output buffer, CBOR is appended
+ * @param[in]  x    XML top node, eg <config>, which itself is not encoded
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @note Attributes are not encoded
+ * @see clixon_cbor_parse_buf  for the reverse
+ */
+int
+clixon_xml2cbor(cbuf  *cb,
+		cxobj *x)
+{
+    if (cbor_enc_head(cb, CBOR_TAG, CLIXON_CBOR_MAGIC) < 0)
+	return -1;
+    return cbor_enc_children(cb, x);
+}
+
+/*! Decode major type and argument
+ * @retval  0  OK
+ * @retval -1  Error: truncated or not supported
+ */
+static int
+cbor_dec_head(struct cbor_dec *cd,
+	      int             *major,
+	      uint64_t        *n)
+{
+    uint8_t b;
+    int     ai;
+    int     len;
+
+    if (cd->cd_pos >= cd->cd_len)
+	goto trunc;
+    b = cd->cd_buf[cd->cd_pos++];
+    *major = b >> 5;
+    ai = b & 0x1f;
+    if (ai < 24){
+	*n = ai;
+	return 0;
+    }
+    switch (ai){
+    case 24: len = 1; break;
+    case 25: len = 2; break;
+    case 26: len = 4; break;
+    case 27: len = 8; break;
+    default:
+	clicon_err(OE_XML, EINVAL, "CBOR indefinite length or reserved value %d at %zu not supported",
+		   ai, cd->cd_pos-1);
+	return -1;
+    }
+    if (*major == CBOR_SIMPLE){
+	clicon_err(OE_XML, EINVAL, "CBOR floating point at %zu not supported", cd->cd_pos-1);
+	return -1;
+    }
+    if (cd->cd_pos + len > cd->cd_len)
+	goto trunc;
+    *n = 0;
+    while (len--)
+	*n = (*n << 8) | cd->cd_buf[cd->cd_pos++];
+    return 0;
+ trunc:
+    clicon_err(OE_XML, EINVAL, "CBOR truncated at %zu", cd->cd_pos);
+    return -1;
+}
+
+/*! Decode a signed integer
+ */
+static int
+cbor_dec_int(struct cbor_dec *cd,
+	     int64_t         *i)
+{
+    int      major;
+    uint64_t n;
+
+    if (cbor_dec_head(cd, &major, &n) < 0)
+	return -1;
+    if ((major != CBOR_UINT && major != CBOR_NINT) || n > INT64_MAX){
+	clicon_err(OE_XML, EINVAL, "CBOR integer expected at %zu", cd->cd_pos);
+	return -1;
+    }
+    *i = major==CBOR_UINT ? (int64_t)n : -(int64_t)n - 1;
+    return 0;
+}
+
+/*! Decode a text string of length len, return it in a cbuf
+ */
+static int
+cbor_dec_text(struct cbor_dec *cd,
+	      uint64_t         len,
+	      cbuf            *cb)
+{
+    if (len > cd->cd_len - cd->cd_pos){
+	clicon_err(OE_XML, EINVAL, "CBOR truncated at %zu", cd->cd_pos);
+	return -1;
+    }
+    if (memchr(cd->cd_buf + cd->cd_pos, '\0', len) != NULL){
+	clicon_err(OE_XML, EINVAL, "CBOR text with NUL at %zu", cd->cd_pos);
+	return -1;
+    }
+    cbuf_reset(cb);
+    if (cbuf_append_buf(cb, (char*)cd->cd_buf + cd->cd_pos, len) < 0)
+	return -1;
+    cd->cd_pos += len;
+    return 0;
+}
+
+/*! Add body to XML element
+ */
+static int
+cbor_dec_body(cxobj *x,
+	      char  *val)
+{
+    cxobj *xb;
+
+    if ((xb = xml_new("body", x, CX_BODY)) == NULL)
+	return -1;
+    return xml_value_set(xb, val);
+}
+
+static int cbor_dec_map(struct cbor_dec *cd, uint64_t nr, cxobj *xp, int depth);
+
+/*! Decode a value into an XML element
+ * @param[in]  cd     Decoder state
+ * @param[in]  x      XML element, the value is added as body or children
+ * @param[in]  depth  Nesting depth
+ */
+static int
+cbor_dec_value(struct cbor_dec *cd,
+	       cxobj           *x,
+	       int              depth)
+{
+    int      retval = -1;
+    int      major;
+    uint64_t n;
+    int64_t  e;
+    int64_t  m;
+    char     num[48];
+    char     digits[24];
+    int      dlen;
+    cbuf    *cb = NULL;
+
+    if (depth > CBOR_DEPTH_MAX){
+	clicon_err(OE_XML, EINVAL, "CBOR nesting too deep");
+	goto done;
+    }
+    if (cbor_dec_head(cd, &major, &n) < 0)
+	goto done;
+    switch (major){
+    case CBOR_UINT:
+	snprintf(num, sizeof(num), "%" PRIu64, n);
+	if (cbor_dec_body(x, num) < 0)
+	    goto done;
+	break;
+    case CBOR_NINT:
+	if (n == UINT64_MAX){
+	    clicon_err(OE_XML, EINVAL, "CBOR integer out of range");
+	    goto done;
+	}
+	snprintf(num, sizeof(num), "-%" PRIu64, n+1);
+	if (cbor_dec_body(x, num) < 0)
+	    goto done;
+	break;
+    case CBOR_TSTR:
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new");
+	    goto done;
+	}
+	if (cbor_dec_text(cd, n, cb) < 0)
+	    goto done;
+	if (cbor_dec_body(x, cbuf_get(cb)) < 0)
+	    goto done;
+	break;
+    case CBOR_ARRAY: /* Only [null] of empty leaf, other arrays are decoded by map */
+	if (n != 1 ||
+	    cbor_dec_head(cd, &major, &n) < 0 ||
+	    major != CBOR_SIMPLE || n != CBOR_NULL){
+	    clicon_err(OE_XML, EINVAL, "CBOR unexpected array at %zu", cd->cd_pos);
+	    goto done;
+	}
+	break;
+    case CBOR_MAP:
+	if (cbor_dec_map(cd, n, x, depth+1) < 0)
+	    goto done;
+	break;
+    case CBOR_TAG: /* Decimal fraction: 4([exponent, mantissa]) */
+	if (n != CBOR_TAG_DECFRAC ||
+	    cbor_dec_head(cd, &major, &n) < 0 ||
+	    major != CBOR_ARRAY || n != 2 ||
+	    cbor_dec_int(cd, &e) < 0 ||
+	    cbor_dec_int(cd, &m) < 0 ||
+	    e > 0 || e < -18){
+	    clicon_err(OE_XML, EINVAL, "CBOR unexpected tag at %zu", cd->cd_pos);
+	    goto done;
+	}
+	/* Digits, at least one before the point */
+	dlen = snprintf(digits, sizeof(digits), "%0*" PRIu64, (int)(1-e),
+			m<0 ? (uint64_t)(-(m+1))+1 : (uint64_t)m);
+	snprintf(num, sizeof(num), "%s%.*s%s%s", m<0?"-":"",
+		 (int)(dlen+e), digits, e?".":"", digits+dlen+e);
+	if (cbor_dec_body(x, num) < 0)
+	    goto done;
+	break;
+    case CBOR_SIMPLE:
+	if (n == CBOR_TRUE || n == CBOR_FALSE){
+	    if (cbor_dec_body(x, n==CBOR_TRUE?"true":"false") < 0)
+		goto done;
+	}
+	else if (n != CBOR_NULL){
+	    clicon_err(OE_XML, EINVAL, "CBOR unexpected simple value %" PRIu64, n);
+	    goto done;
+	}
+	break;
+    default: /* Byte strings are not used */
+	clicon_err(OE_XML, EINVAL, "CBOR unexpected major type %d at %zu", major, cd->cd_pos);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Decode a map into children of an XML element
+ *
+ * A member name "module:name" is split, the module is stored as prefix and translated
+ * to a namespace by the caller, as for JSON. An array value, except [null], is decoded
+ * as one element for each entry.
+ * @param[in]  cd     Decoder state
+ * @param[in]  nr     Number of map entries
+ * @param[in]  xp     XML parent
+ * @param[in]  depth  Nesting depth
+ */
+static int
+cbor_dec_map(struct cbor_dec *cd,
+	     uint64_t         nr,
+	     cxobj           *xp,
+	     int              depth)
+{
+    int      retval = -1;
+    cbuf    *cb = NULL;
+    char    *name;
+    char    *prefix;
+    char    *p;
+    int      major;
+    uint64_t n;
+    uint64_t len;
+    uint64_t i;
+    size_t   pos;
+    cxobj   *x;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    for (; nr > 0; nr--){
+	if (cbor_dec_head(cd, &major, &n) < 0)
+	    goto done;
+	if (major != CBOR_TSTR){
+	    clicon_err(OE_XML, EINVAL, "CBOR map key is not text at %zu", cd->cd_pos);
+	    goto done;
+	}
+	if (cbor_dec_text(cd, n, cb) < 0)
+	    goto done;
+	name = cbuf_get(cb);
+	prefix = NULL;
+	if ((p = strchr(name, ':')) != NULL){
+	    *p = '\0';
+	    prefix = name;
+	    name = p+1;
+	}
+	/* Array of entries, or single value incl [null] */
+	pos = cd->cd_pos;
+	len = 1;
+	if (cbor_dec_head(cd, &major, &n) < 0)
+	    goto done;
+	if (major == CBOR_ARRAY &&
+	    !(n == 1 && cd->cd_pos < cd->cd_len &&
+	      cd->cd_buf[cd->cd_pos] == ((CBOR_SIMPLE<<5) | CBOR_NULL)))
+	    len = n;
+	else
+	    cd->cd_pos = pos;
+	for (i = 0; i < len; i++){
+	    if ((x = xml_new(name, xp, CX_ELMNT)) == NULL)
+		goto done;
+	    if (prefix && xml_prefix_set(x, prefix) < 0)
+		goto done;
+	    if (cbor_dec_value(cd, x, depth) < 0)
+		goto done;
+	}
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Parse a buffer containing CBOR and add the decoded XML tree to xt
+ *
+ * @param[in]  buf    Buffer containing CBOR, see clixon_xml2cbor
+ * @param[in]  len    Length of buf
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  yspec  Yang spec, mandatory for module->xmlns translation
+ * @param[in]  xt     XML top, decoded nodes are added as children
+ * @param[out] xerr   Reason for invalid returned as netconf err msg
+ * @retval     1      OK and valid
+ * @retval     0      Invalid (only if yang spec) w xerr set
+ * @retval    -1      Error with clicon_err called, eg malformed CBOR
+ * @see clixon_json_parse_string  for the corresponding JSON steps
+ */
+int
+clixon_cbor_parse_buf(char      *buf,
+		      size_t     len,
+		      yang_bind  yb,
+		      yang_stmt *yspec,
+		      cxobj     *xt,
+		      cxobj    **xerr)
+{
+    int             retval = -1;
+    struct cbor_dec cd = {(uint8_t*)buf, len, 0};
+    int             major;
+    uint64_t        n;
+    int             pos;
+    cxobj          *x;
+    int             failed = 0;
+    int             ret;
+
+    if (cbor_dec_head(&cd, &major, &n) < 0)
+	goto done;
+    if (major == CBOR_TAG && n == CLIXON_CBOR_MAGIC){
+	if (cbor_dec_head(&cd, &major, &n) < 0)
+	    goto done;
+    }
+    if (major != CBOR_MAP){
+	clicon_err(OE_XML, EINVAL, "CBOR top-level is not a map");
+	goto done;
+    }
+    pos = xml_child_nr_type(xt, CX_ELMNT);
+    if (cbor_dec_map(&cd, n, xt, 0) < 0)
+	goto done;
+    if (cd.cd_pos != cd.cd_len){
+	clicon_err(OE_XML, EINVAL, "CBOR trailing data at %zu", cd.cd_pos);
+	goto done;
+    }
+    /* Translate module names to namespaces, bind yang and decode identityrefs */
+    for (; yspec && pos < xml_child_nr_type(xt, CX_ELMNT); pos++){
+	if ((x = xml_child_i_type(xt, pos, CX_ELMNT)) == NULL)
+	    continue;
+	if ((ret = json_xmlns_translate(yspec, x, xerr)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	switch (yb){
+	case YB_MODULE_NEXT:
+	    if ((ret = xml_bind_yang(x, YB_MODULE, yspec, xerr)) < 0)
+		goto done;
+	    break;
+	case YB_RPC:
+	    if ((ret = xml_bind_yang_rpc(x, yspec, xerr)) < 0)
+		goto done;
+	    break;
+	case YB_NONE:
+	    ret = 1;
+	    break;
+	default:
+	    if ((ret = xml_bind_yang0(x, yb, yspec, xerr)) < 0)
+		goto done;
+	    break;
+	}
+	if (ret == 0)
+	    failed++;
+	if ((ret = json2xml_decode(x, xerr)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    if (failed)
+	goto fail;
+    if (yb != YB_NONE)
+	if (xml_sort_recurse(xt) < 0)
+	    goto done;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read a CBOR file and parse it into an XML tree
+ *
+ * @param[in]     fp    File descriptor to the CBOR file
+ * @param[in]     yb    How to bind yang to XML top-level when parsing
+ * @param[in]     yspec Yang specification, or NULL
+ * @param[in,out] xt    Pointer to XML parse tree. If empty, create "top"
+ * @param[out]    xerr  Reason for invalid returned as netconf err msg
+ * @retval        1     OK and valid
+ * @retval        0     Invalid (only if yang spec) w xerr set
+ * @retval       -1     Error with clicon_err called
+ * @note An empty file gives an empty tree
+ * @see clixon_json_parse_file
+ */
+int
+clixon_cbor_parse_file(FILE      *fp,
+		       yang_bind  yb,
+		       yang_stmt *yspec,
+		       cxobj    **xt,
+		       cxobj    **xerr)
+{
+    int     retval = -1;
+    char   *buf = NULL;
+    size_t  buflen = 1024;
+    size_t  len = 0;
+    size_t  n;
+    char   *p;
+
+    if (xt==NULL){
+	clicon_err(OE_XML, EINVAL, "xt is NULL");
+	goto done;
+    }
+    if ((buf = malloc(buflen)) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    while ((n = fread(buf+len, 1, buflen-len, fp)) > 0){
+	len += n;
+	if (len == buflen){
+	    buflen *= 2;
+	    if ((p = realloc(buf, buflen)) == NULL){
+		clicon_err(OE_XML, errno, "realloc");
+		goto done;
+	    }
+	    buf = p;
+	}
+    }
+    if (ferror(fp)){
+	clicon_err(OE_XML, errno, "read");
+	goto done;
+    }
+    if (*xt == NULL &&
+	(*xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (len == 0)
+	retval = 1;
+    else
+	retval = clixon_cbor_parse_buf(buf, len, yb, yspec, *xt, xerr);
+ done:
+    if (buf)
+	free(buf);
+    return retval;
+}
@@ -37,12 +37,16 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
 #include <unistd.h>
 #include <syslog.h>
 #include <string.h>
 #include <errno.h>
 #include <assert.h>
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <netinet/in.h>
 
 /* cligen */
@@ -65,6 +69,7 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_proto.h"
 #include "clixon_proto_client.h"
+#include "clixon_datastore_shm.h"
 #include "clixon_client.h"
 
 /*
@@ -77,6 +82,9 @@
 
 #define CLIXON_CLIENT_MAGIC 0x54fe649a
 
+/* Max number of keys in a step of an xpath of an edit, eg [name='a'] */
+#define CLIXON_CLIENT_KEYS 8
+
 #define chandle(ch) (assert(clixon_client_handle_check(ch)==0),(struct clixon_client_handle *)(ch))
 
 /*! Internal structure of clixon client handle. 
@@ -87,6 +95,13 @@ struct clixon_client_handle{
     int                cch_socket; /* Input/output socket */
     int                cch_pid;    /* Sub-process-id Only applies for NETCONF/SSH */
     int                cch_locked; /* State variable: 1 means locked */
+    int                cch_cache;  /* If set, cache data of batched get */
+    cxobj             *cch_xdata;  /* Cached data of last batched get, or NULL */
+    char              *cch_xpath;  /* XPath of cached data */
+    char              *cch_ns;     /* Namespace of cached data */
+    char              *cch_token;  /* Change token of running when data was read */
+    cxobj             *cch_xedit;  /* Accumulated edits as <config> tree, or NULL */
+    int                cch_flushing; /* Edits sent, reply not yet received */
 };
 
 /*! Check struct magic number for sanity checks
@@ -315,6 +330,30 @@ clixon_client_connect(clicon_handle      h,
     goto done;
 }
 
+/*! Free cached data of batched get
+ * @param[in]  cch   Clixon client handle
+ */
+static void
+clixon_client_cache_clear(struct clixon_client_handle *cch)
+{
+    if (cch->cch_xdata){
+	xml_free(cch->cch_xdata);
+	cch->cch_xdata = NULL;
+    }
+    if (cch->cch_xpath){
+	free(cch->cch_xpath);
+	cch->cch_xpath = NULL;
+    }
+    if (cch->cch_ns){
+	free(cch->cch_ns);
+	cch->cch_ns = NULL;
+    }
+    if (cch->cch_token){
+	free(cch->cch_token);
+	cch->cch_token = NULL;
+    }
+}
+
 /*! Connect client to clixon backend according to config and return a socket
  * @param[in]    ch        Clixon client session handle
  * @see clixon_client_connect where the handle is created
@@ -347,6 +386,9 @@ clixon_client_disconnect(clixon_client_handle ch)
     case CLIXON_CLIENT_SSH:
 	break;
     }
+    clixon_client_cache_clear(cch);
+    if (cch->cch_xedit)
+	xml_free(cch->cch_xedit);
     free(cch);
     retval = 0;
  done:
@@ -745,6 +787,1050 @@ clixon_client_get_uint64(clixon_client_handle  ch,
     return retval;
 }
 
+/*! Get change token of running, which changes when running may change
+ * @param[in]  sock    Open socket
+ * @param[out] token   Change token, free with free()
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see from_client_datastore_token in backend
+ */
+static int
+clixon_client_token(int    sock,
+		    char **token)
+{
+    int    retval = -1;
+    cxobj *xret = NULL;
+    cxobj *xd;
+    cbuf  *msg = NULL;
+    cbuf  *msgret = NULL;
+    char  *str;
+
+    if ((msg = cbuf_new()) == NULL){
+	clicon_err(OE_PLUGIN, errno, "cbuf_new");
+	goto done;
+    }
+    if ((msgret = cbuf_new()) == NULL){
+	clicon_err(OE_PLUGIN, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(msg, "<rpc xmlns=\"%s\"><datastore-token xmlns=\"%s\"/></rpc>",
+	    NETCONF_BASE_NAMESPACE, CLIXON_LIB_NS);
+    if (clicon_rpc1(sock, msg, msgret) < 0)
+	goto done;
+    if (clixon_xml_parse_string(cbuf_get(msgret), YB_NONE, NULL, &xret, NULL) < 0)
+	goto done;
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL){
+	xd = xml_parent(xd); /* point to rpc-reply */
+	clixon_netconf_error(xd, "Datastore token", NULL);
+	goto done;
+    }
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply/token")) == NULL ||
+	(str = xml_body(xd)) == NULL){
+	clicon_err(OE_XML, EINVAL, "No token in reply");
+	goto done;
+    }
+    if ((*token = strdup(str)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (xret)
+	xml_free(xret);
+    if (msg)
+	cbuf_free(msg);
+    if (msgret)
+	cbuf_free(msgret);
+    return retval;
+}
+
+/*! Parse the body of a leaf as a value of a batched get
+ * @param[in]     val   Body of leaf
+ * @param[in,out] cv    Value, type is given and value is set
+ * @retval        0     OK
+ * @retval        -1    Error, eg invalid value
+ */
+static int
+clixon_client_value_parse(char                *val,
+			  clixon_client_value *cv)
+{
+    int     retval = -1;
+    char   *reason = NULL;
+    int     ret = 1;
+    uint8_t b;
+
+    switch (cv->cv_type){
+    case CLIXON_CLIENT_BOOL:
+	if ((ret = parse_bool(val, &b, &reason)) > 0)
+	    cv->cv_u.cv_bool = (int)b;
+	break;
+    case CLIXON_CLIENT_STR:
+	if (cv->cv_str == NULL || cv->cv_strlen <= 0){
+	    clicon_err(OE_XML, EINVAL, "No string buffer for %s", cv->cv_xpath);
+	    goto done;
+	}
+	strncpy(cv->cv_str, val, cv->cv_strlen-1);
+	cv->cv_str[cv->cv_strlen-1] = '\0';
+	break;
+    case CLIXON_CLIENT_UINT8:
+	ret = parse_uint8(val, &cv->cv_u.cv_uint8, &reason);
+	break;
+    case CLIXON_CLIENT_UINT16:
+	ret = parse_uint16(val, &cv->cv_u.cv_uint16, &reason);
+	break;
+    case CLIXON_CLIENT_UINT32:
+	ret = parse_uint32(val, &cv->cv_u.cv_uint32, &reason);
+	break;
+    case CLIXON_CLIENT_UINT64:
+	ret = parse_uint64(val, &cv->cv_u.cv_uint64, &reason);
+	break;
+    }
+    if (ret < 0){
+	clicon_err(OE_XML, errno, "parse %s", cv->cv_xpath);
+	goto done;
+    }
+    if (ret == 0){
+	clicon_err(OE_XML, EINVAL, "%s: %s", cv->cv_xpath, reason);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (reason)
+	free(reason);
+    return retval;
+}
+
+/*! Client-api get many values in one request
+ *
+ * The data selected by xpath is read from running with one get-config, and each
+ * value is then looked up locally with its own xpath. Use a common subtree as xpath,
+ * or NULL for all of running.
+ * If caching is enabled with clixon_client_cache_set(), the data is kept and only
+ * read again if the change token of running has changed, so that a poll of an
+ * unchanged config only costs one small request.
+ * @param[in]     ch        Clixon client handle
+ * @param[in]     namespace Default namespace used for non-prefixed entries in xpaths
+ * @param[in]     xpath     XPath of data to read, or NULL for all
+ * @param[in,out] vec       Values: xpath and type given, value and cv_found set
+ * @param[in]     len       Length of vec
+ * @retval        n         Number of values found
+ * @retval        -1        Error, eg a value is invalid for its type
+ * @code
+ *   clixon_client_value vec[2] = {{"/table/parameter[name='a']/value", CLIXON_CLIENT_UINT32},
+ *                                 {"/table/parameter[name='b']/value", CLIXON_CLIENT_UINT32}};
+ *
+ *   if (clixon_client_get_batch(ch, "urn:example:clixon-client", "/table", vec, 2) < 0)
+ *      err;
+ *   if (vec[0].cv_found)
+ *      printf("%u\n", vec[0].cv_u.cv_uint32);
+ * @endcode
+ */
+int
+clixon_client_get_batch(clixon_client_handle ch,
+			const char          *namespace,
+			const char          *xpath,
+			clixon_client_value *vec,
+			int                  len)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    cxobj                       *xdata = NULL;
+    cxobj                       *x;
+    cvec                        *nsc = NULL;
+    char                        *token = NULL;
+    char                        *val;
+    int                          found = 0;
+    int                          i;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    if (cch->cch_flushing && clixon_client_flush_recv(ch) < 0)
+	goto done;
+    if (cch->cch_cache){
+	if (clixon_client_token(cch->cch_socket, &token) < 0)
+	    goto done;
+	if (cch->cch_xdata &&
+	    strcmp(token, cch->cch_token) == 0 &&
+	    clicon_strcmp(cch->cch_xpath, (char*)xpath) == 0 &&
+	    clicon_strcmp(cch->cch_ns, (char*)namespace) == 0)
+	    xdata = cch->cch_xdata;
+    }
+    if (xdata == NULL){
+	if (clixon_client_get_xdata(cch->cch_socket, namespace, xpath, &xdata) < 0)
+	    goto done;
+	if (cch->cch_cache){
+	    /* Token is read before data, so that a later change is detected */
+	    clixon_client_cache_clear(cch);
+	    cch->cch_xdata = xdata;
+	    cch->cch_token = token;
+	    token = NULL;
+	    if ((xpath && (cch->cch_xpath = strdup(xpath)) == NULL) ||
+		(namespace && (cch->cch_ns = strdup(namespace)) == NULL)){
+		clicon_err(OE_UNIX, errno, "strdup");
+		clixon_client_cache_clear(cch);
+		goto done;
+	    }
+	}
+    }
+    if ((nsc = xml_nsctx_init(NULL, (char*)namespace)) == NULL)
+	goto done;
+    for (i=0; i<len; i++){
+	vec[i].cv_found = 0;
+	if ((x = xpath_first(xdata, nsc, "%s", vec[i].cv_xpath)) == NULL ||
+	    (val = xml_body(x)) == NULL)
+	    continue;
+	if (clixon_client_value_parse(val, &vec[i]) < 0)
+	    goto done;
+	vec[i].cv_found = 1;
+	found++;
+    }
+    retval = found;
+ done:
+    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (xdata && xdata != cch->cch_xdata)
+	xml_free(xdata);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (token)
+	free(token);
+    return retval;
+}
+
+/*! Enable or disable caching of data of batched get
+ * @param[in]  ch      Clixon client handle
+ * @param[in]  enable  1: cache data until running changes, 0: no cache
+ * @retval     0       OK
+ * @see clixon_client_get_batch
+ */
+int
+clixon_client_cache_set(clixon_client_handle ch,
+			int                  enable)
+{
+    struct clixon_client_handle *cch = chandle(ch);
+
+    cch->cch_cache = enable;
+    if (!enable)
+	clixon_client_cache_clear(cch);
+    return 0;
+}
+
+/*! Get or set the netconf operation of a node in the edit tree
+ * @param[in]  x     XML node
+ * @param[in]  op    Operation to set, eg "remove", or NULL to remove operation
+ * @retval     0     OK
+ * @retval     -1    Error
+ */
+static int
+clixon_client_edit_op(cxobj      *x,
+		      const char *op)
+{
+    cxobj *xa;
+
+    if ((xa = xml_find_type(x, NETCONF_BASE_PREFIX, "operation", CX_ATTR)) != NULL){
+	if (op == NULL)
+	    return xml_purge(xa);
+    }
+    else if (op != NULL){
+	if ((xa = xml_new("operation", x, CX_ATTR)) == NULL)
+	    return -1;
+	if (xml_prefix_set(xa, NETCONF_BASE_PREFIX) < 0)
+	    return -1;
+    }
+    else
+	return 0;
+    return xml_value_set(xa, (char*)op);
+}
+
+/*! Find or create the node of an xpath in the edit tree
+ *
+ * The xpath is a path of data nodes where list entries are given by all their keys,
+ * eg /table/parameter[name='a']/value. Prefixes are ignored, all nodes are in
+ * the given namespace.
+ * A removed node on the path is changed to be replaced, so that an edit after a
+ * delete is applied in the same order.
+ * @param[in]  cch       Clixon client handle
+ * @param[in]  namespace Namespace of nodes
+ * @param[in]  xpath     XPath of node
+ * @param[in]  clear     If set, remove earlier edits below node except its keys
+ * @param[out] xnp       Node
+ * @retval     0         OK
+ * @retval     -1        Error, eg xpath syntax
+ */
+static int
+clixon_client_edit_node(struct clixon_client_handle *cch,
+			const char                  *namespace,
+			const char                  *xpath,
+			int                          clear,
+			cxobj                      **xnp)
+{
+    int         retval = -1;
+    const char *p = xpath;
+    const char *s;
+    char       *name = NULL;
+    char       *kname[CLIXON_CLIENT_KEYS] = {NULL,};
+    char       *kval[CLIXON_CLIENT_KEYS] = {NULL,};
+    int         nk = 0;
+    int         i;
+    int         j;
+    char        q;
+    cxobj      *xp;
+    cxobj      *x;
+    cxobj      *xk;
+    char       *op;
+
+    if (xpath == NULL || *p != '/'){
+	clicon_err(OE_XML, EINVAL, "Expected absolute xpath: %s", xpath?xpath:"null");
+	goto done;
+    }
+    if (cch->cch_xedit == NULL &&
+	(cch->cch_xedit = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+	goto done;
+    xp = cch->cch_xedit;
+    x = NULL;
+    while (*p == '/'){
+	s = ++p;
+	while (*p && *p != '/' && *p != '[')
+	    p++;
+	if (p == s)
+	    goto syntax;
+	if ((name = strndup(s, p-s)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	while (*p == '['){
+	    if (nk == CLIXON_CLIENT_KEYS)
+		goto syntax;
+	    s = ++p;
+	    while (*p && *p != '=')
+		p++;
+	    if (*p != '=' || p == s)
+		goto syntax;
+	    kname[nk] = strndup(s, p-s);
+	    if ((q = *++p) != '\'' && q != '"')
+		goto syntax;
+	    s = ++p;
+	    while (*p && *p != q)
+		p++;
+	    if (*p != q)
+		goto syntax;
+	    kval[nk] = strndup(s, p-s);
+	    if (kname[nk] == NULL || kval[nk] == NULL){
+		nk++;
+		clicon_err(OE_UNIX, errno, "strndup");
+		goto done;
+	    }
+	    nk++;
+	    if (*++p != ']')
+		goto syntax;
+	    p++;
+	}
+	if (*p && *p != '/')
+	    goto syntax;
+	/* Find existing node with same keys */
+	x = NULL;
+	while ((x = xml_child_each(xp, x, CX_ELMNT)) != NULL){
+	    if (strcmp(xml_name(x), name) != 0)
+		continue;
+	    for (i=0; i<nk; i++)
+		if (clicon_strcmp(xml_find_body(x, kname[i]), kval[i]) != 0)
+		    break;
+	    if (i == nk)
+		break;
+	}
+	if (x == NULL){
+	    if ((x = xml_new(name, xp, CX_ELMNT)) == NULL)
+		goto done;
+	    if (xp == cch->cch_xedit && xmlns_set(x, NULL, (char*)namespace) < 0)
+		goto done;
+	    for (i=0; i<nk; i++)
+		if ((xk = xml_new_body(kname[i], x, kval[i])) == NULL)
+		    goto done;
+	}
+	else if (*p == '/' &&
+		 (op = xml_find_value(x, "operation")) != NULL &&
+		 strcmp(op, "remove") == 0){
+	    if (clixon_client_edit_op(x, "replace") < 0)
+		goto done;
+	}
+	free(name);
+	name = NULL;
+	if (*p == '/'){
+	    for (i=0; i<nk; i++){
+		free(kname[i]);
+		free(kval[i]);
+		kname[i] = kval[i] = NULL;
+	    }
+	    nk = 0;
+	}
+	xp = x;
+    }
+    /* Remove earlier edits below node except keys, they are overridden */
+    if (clear){
+	i = 0;
+	while ((xk = xml_child_i(x, i)) != NULL){
+	    if (xml_type(xk) == CX_ATTR){
+		i++;
+		continue;
+	    }
+	    if (xml_type(xk) == CX_ELMNT){
+		for (j=0; j<nk; j++)
+		    if (strcmp(xml_name(xk), kname[j]) == 0)
+			break;
+		if (j < nk){
+		    i++;
+		    continue;
+		}
+	    }
+	    if (xml_purge(xk) < 0)
+		goto done;
+	}
+    }
+    *xnp = x;
+    retval = 0;
+ done:
+    if (name)
+	free(name);
+    for (i=0; i<nk; i++){
+	if (kname[i])
+	    free(kname[i]);
+	if (kval[i])
+	    free(kval[i]);
+    }
+    return retval;
+ syntax:
+    clicon_err(OE_XML, EINVAL, "Invalid xpath of edit: %s", xpath);
+    goto done;
+}
+
+/*! Set value of a leaf in the edit tree
+ * @param[in]  ch        Clixon client handle
+ * @param[in]  namespace Namespace of nodes
+ * @param[in]  xpath     XPath of leaf
+ * @param[in]  val       Value
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+static int
+clixon_client_set_body(clixon_client_handle ch,
+		       const char          *namespace,
+		       const char          *xpath,
+		       char                *val)
+{
+    struct clixon_client_handle *cch = chandle(ch);
+    cxobj                       *x;
+    cxobj                       *xb;
+
+    clicon_debug(1, "%s %s", __FUNCTION__, xpath);
+    if (clixon_client_edit_node(cch, namespace, xpath, 1, &x) < 0)
+	return -1;
+    if (clixon_client_edit_op(x, NULL) < 0)
+	return -1;
+    if ((xb = xml_new("body", x, CX_BODY)) == NULL)
+	return -1;
+    return xml_value_set(xb, val);
+}
+
+/*! Client-api set boolean, sent by clixon_client_flush()
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  val    Value
+ * @param[in]  namespace Namespace of nodes in xpath
+ * @param[in]  xpath  XPath of leaf, list entries are given by all keys
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+int
+clixon_client_set_bool(clixon_client_handle ch,
+		       int                  val,
+		       const char          *namespace,
+		       const char          *xpath)
+{
+    return clixon_client_set_body(ch, namespace, xpath, val?"true":"false");
+}
+
+/*! Client-api set string, sent by clixon_client_flush()
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  val    Value
+ * @param[in]  namespace Namespace of nodes in xpath
+ * @param[in]  xpath  XPath of leaf, list entries are given by all keys
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+int
+clixon_client_set_str(clixon_client_handle ch,
+		      const char          *val,
+		      const char          *namespace,
+		      const char          *xpath)
+{
+    return clixon_client_set_body(ch, namespace, xpath, (char*)val);
+}
+
+/*! Client-api set uint8, sent by clixon_client_flush()
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  val    Value
+ * @param[in]  namespace Namespace of nodes in xpath
+ * @param[in]  xpath  XPath of leaf, list entries are given by all keys
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+int
+clixon_client_set_uint8(clixon_client_handle ch,
+			uint8_t              val,
+			const char          *namespace,
+			const char          *xpath)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%u", val);
+    return clixon_client_set_body(ch, namespace, xpath, buf);
+}
+
+/*! Client-api set uint16, sent by clixon_client_flush()
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  val    Value
+ * @param[in]  namespace Namespace of nodes in xpath
+ * @param[in]  xpath  XPath of leaf, list entries are given by all keys
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+int
+clixon_client_set_uint16(clixon_client_handle ch,
+			 uint16_t             val,
+			 const char          *namespace,
+			 const char          *xpath)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%u", val);
+    return clixon_client_set_body(ch, namespace, xpath, buf);
+}
+
+/*! Client-api set uint32, sent by clixon_client_flush()
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  val    Value
+ * @param[in]  namespace Namespace of nodes in xpath
+ * @param[in]  xpath  XPath of leaf, list entries are given by all keys
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+int
+clixon_client_set_uint32(clixon_client_handle ch,
+			 uint32_t             val,
+			 const char          *namespace,
+			 const char          *xpath)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%u", val);
+    return clixon_client_set_body(ch, namespace, xpath, buf);
+}
+
+/*! Client-api set uint64, sent by clixon_client_flush()
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  val    Value
+ * @param[in]  namespace Namespace of nodes in xpath
+ * @param[in]  xpath  XPath of leaf, list entries are given by all keys
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+int
+clixon_client_set_uint64(clixon_client_handle ch,
+			 uint64_t             val,
+			 const char          *namespace,
+			 const char          *xpath)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%" PRIu64, val);
+    return clixon_client_set_body(ch, namespace, xpath, buf);
+}
+
+/*! Client-api delete a node if it exists, sent by clixon_client_flush()
+ * Earlier edits below the node are dropped.
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  namespace Namespace of nodes in xpath
+ * @param[in]  xpath  XPath of node, list entries are given by all keys
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+int
+clixon_client_delete(clixon_client_handle ch,
+		     const char          *namespace,
+		     const char          *xpath)
+{
+    struct clixon_client_handle *cch = chandle(ch);
+    cxobj                       *x;
+
+    clicon_debug(1, "%s %s", __FUNCTION__, xpath);
+    if (clixon_client_edit_node(cch, namespace, xpath, 1, &x) < 0)
+	return -1;
+    return clixon_client_edit_op(x, "remove");
+}
+
+/*! Client-api merge XML into a node, sent by clixon_client_flush()
+ * The XML is added as children of the node as is. Unprefixed elements are in the
+ * namespace of the node.
+ * @param[in]  ch     Clixon client handle
+ * @param[in]  namespace Namespace of nodes in xpath
+ * @param[in]  xpath  XPath of node, or "/" for top-level
+ * @param[in]  xml    XML string of children, eg "<value>42</value>"
+ * @retval     0         OK
+ * @retval     -1        Error
+ */
+int
+clixon_client_merge(clixon_client_handle ch,
+		    const char          *namespace,
+		    const char          *xpath,
+		    const char          *xml)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    cxobj                       *x;
+    cxobj                       *xt = NULL;
+    cxobj                       *xc;
+
+    clicon_debug(1, "%s %s", __FUNCTION__, xpath);
+    if (xpath && strcmp(xpath, "/") == 0){
+	if (cch->cch_xedit == NULL &&
+	    (cch->cch_xedit = xml_new(NETCONF_INPUT_CONFIG, NULL, CX_ELMNT)) == NULL)
+	    goto done;
+	x = cch->cch_xedit;
+    }
+    else if (clixon_client_edit_node(cch, namespace, xpath, 0, &x) < 0)
+	goto done;
+    if (clixon_xml_parse_string(xml, YB_NONE, NULL, &xt, NULL) < 0)
+	goto done;
+    while ((xc = xml_child_i_type(xt, 0, CX_ELMNT)) != NULL)
+	if (xml_addsub(x, xc) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Send accumulated edits as one edit-config with commit, do not wait for reply
+ *
+ * The edits are applied to candidate and committed in one request using the
+ * autocommit extension of edit-config. If the commit fails, candidate is reverted.
+ * New edits may be made while waiting, but no other requests on this handle
+ * until clixon_client_flush_recv().
+ * @param[in]  ch     Clixon client handle
+ * @retval     0      OK, also if no edits
+ * @retval     -1     Error
+ * @see clixon_client_flush_recv
+ */
+int
+clixon_client_flush_send(clixon_client_handle ch)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    cbuf                        *msg = NULL;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    if (cch->cch_flushing){
+	clicon_err(OE_PROTO, EBUSY, "Earlier flush not received");
+	goto done;
+    }
+    if (cch->cch_xedit == NULL)
+	goto ok;
+    if ((msg = cbuf_new()) == NULL){
+	clicon_err(OE_PLUGIN, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(msg, "<rpc xmlns=\"%s\" xmlns:%s=\"%s\">",
+	    NETCONF_BASE_NAMESPACE, NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
+    cprintf(msg, "<edit-config autocommit=\"true\"><target><candidate/></target>");
+    if (clicon_xml2cbuf(msg, cch->cch_xedit, 0, 0, -1) < 0)
+	goto done;
+    cprintf(msg, "</edit-config></rpc>");
+    if (clicon_msg_send1(cch->cch_socket, msg) < 0)
+	goto done;
+    xml_free(cch->cch_xedit);
+    cch->cch_xedit = NULL;
+    cch->cch_flushing = 1;
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (msg)
+	cbuf_free(msg);
+    return retval;
+}
+
+/*! Wait for reply of edits sent by clixon_client_flush_send()
+ * @param[in]  ch     Clixon client handle
+ * @retval     0      OK, edits are committed, or nothing was sent
+ * @retval     -1     Error, eg edit or commit failed
+ */
+int
+clixon_client_flush_recv(clixon_client_handle ch)
+{
+    int                          retval = -1;
+    struct clixon_client_handle *cch = chandle(ch);
+    cbuf                        *msgret = NULL;
+    cxobj                       *xret = NULL;
+    cxobj                       *xd;
+    int                          eof;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    if (cch->cch_flushing == 0)
+	goto ok;
+    cch->cch_flushing = 0;
+    if ((msgret = cbuf_new()) == NULL){
+	clicon_err(OE_PLUGIN, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_msg_rcv1(cch->cch_socket, msgret, &eof) < 0)
+	goto done;
+    if (eof){
+	clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of socket");
+	goto done;
+    }
+    if (clixon_xml_parse_string(cbuf_get(msgret), YB_NONE, NULL, &xret, NULL) < 0)
+	goto done;
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply/rpc-error")) != NULL){
+	xd = xml_parent(xd); /* point to rpc-reply */
+	clixon_netconf_error(xd, "Edit config", NULL);
+	goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
+    if (xret)
+	xml_free(xret);
+    if (msgret)
+	cbuf_free(msgret);
+    return retval;
+}
+
+/*! Send accumulated edits as one edit-config with commit and wait for reply
+ * @param[in]  ch     Clixon client handle
+ * @retval     0      OK, edits are committed
+ * @retval     -1     Error, eg edit or commit failed
+ * @code
+ *   clixon_client_set_uint32(ch, 42, "urn:example:clixon-client", "/table/parameter[name='a']/value");
+ *   clixon_client_delete(ch, "urn:example:clixon-client", "/table/parameter[name='b']");
+ *   if (clixon_client_flush(ch) < 0)
+ *      err;
+ * @endcode
+ * @see clixon_client_flush_send  for asynchronous variant
+ */
+int
+clixon_client_flush(clixon_client_handle ch)
+{
+    if (clixon_client_flush_send(ch) < 0)
+	return -1;
+    return clixon_client_flush_recv(ch);
+}
+
+/*! Internal structure of a mapped datastore image, see clixon_client_shm_open
+ */
+struct clixon_client_shm{
+    char                    *cs_path;  /* File of image */
+    struct xmldb_shm_header *cs_hdr;   /* Mapped image, or NULL */
+    size_t                   cs_size;  /* Size of mapping */
+};
+
+/*! Map the current datastore image of a reader
+ * @param[in]  cs    Reader
+ * @retval     0     OK
+ * @retval     -1    Error
+ */
+static int
+clixon_client_shm_map(struct clixon_client_shm *cs)
+{
+    int                      retval = -1;
+    int                      fd = -1;
+    struct stat              st;
+    struct xmldb_shm_header *sh;
+    void                    *p;
+
+    if (cs->cs_hdr){
+	munmap(cs->cs_hdr, cs->cs_size);
+	cs->cs_hdr = NULL;
+    }
+    if ((fd = open(cs->cs_path, O_RDONLY)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s)", cs->cs_path);
+	goto done;
+    }
+    if (fstat(fd, &st) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", cs->cs_path);
+	goto done;
+    }
+    if (st.st_size < (off_t)sizeof(*sh)){
+	clicon_err(OE_XML, EINVAL, "%s: not a datastore image", cs->cs_path);
+	goto done;
+    }
+    if ((p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED){
+	clicon_err(OE_UNIX, errno, "mmap(%s)", cs->cs_path);
+	goto done;
+    }
+    sh = (struct xmldb_shm_header *)p;
+    if (sh->sh_magic != XMLDB_SHM_MAGIC ||
+	sh->sh_version != XMLDB_SHM_VERSION ||
+	sh->sh_size != (uint64_t)st.st_size ||
+	sh->sh_nodes == 0 ||
+	sh->sh_strings != sizeof(*sh) + sh->sh_nodes*sizeof(struct xmldb_shm_node) ||
+	sh->sh_strings >= sh->sh_size ||
+	((char*)p)[sh->sh_size-1] != '\0'){
+	munmap(p, st.st_size);
+	clicon_err(OE_XML, EINVAL, "%s: not a datastore image", cs->cs_path);
+	goto done;
+    }
+    cs->cs_hdr = sh;
+    cs->cs_size = st.st_size;
+    retval = 0;
+ done:
+    if (fd != -1)
+	close(fd);
+    return retval;
+}
+
+/*! Open a read-only datastore image written by the backend
+ *
+ * Values are read from the image in memory without any rpc or parsing. The image is
+ * written by the backend after each commit if CLICON_XMLDB_SHM is set, and a reader
+ * remaps it when it is replaced. Use this for frequent local reads of running.
+ * @param[in]  path  File of image, value of CLICON_XMLDB_SHM
+ * @retval     cs    Reader handle, free with clixon_client_shm_close
+ * @retval     NULL  Error, eg image not written
+ * @see clixon_client_shm_get
+ */
+clixon_client_shm
+clixon_client_shm_open(const char *path)
+{
+    struct clixon_client_shm *cs;
+
+    if ((cs = malloc(sizeof(*cs))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(cs, 0, sizeof(*cs));
+    if ((cs->cs_path = strdup(path)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	free(cs);
+	return NULL;
+    }
+    if (clixon_client_shm_map(cs) < 0){
+	clixon_client_shm_close(cs);
+	return NULL;
+    }
+    return cs;
+}
+
+/*! Close a datastore image reader
+ * @param[in]  shm   Reader handle
+ */
+int
+clixon_client_shm_close(clixon_client_shm shm)
+{
+    struct clixon_client_shm *cs = (struct clixon_client_shm *)shm;
+
+    if (cs == NULL)
+	return 0;
+    if (cs->cs_hdr)
+	munmap(cs->cs_hdr, cs->cs_size);
+    if (cs->cs_path)
+	free(cs->cs_path);
+    free(cs);
+    return 0;
+}
+
+/*! Find a child of a node in a datastore image with binary search
+ * @param[in]  sh    Image
+ * @param[in]  sn    Parent node
+ * @param[in]  name  Name of child
+ * @param[in]  key   Key of child, "" if not list or leaf-list entry
+ * @retval     sc    Child node
+ * @retval     NULL  Not found
+ */
+static struct xmldb_shm_node *
+clixon_client_shm_child(struct xmldb_shm_header *sh,
+			struct xmldb_shm_node   *sn,
+			const char              *name,
+			const char              *key)
+{
+    struct xmldb_shm_node *nodes = (struct xmldb_shm_node *)(sh + 1);
+    char                  *str = (char*)sh + sh->sh_strings;
+    uint32_t               lo = sn->sn_child;
+    uint32_t               hi = sn->sn_child + sn->sn_nchild;
+    uint32_t               mid;
+    int                    eq;
+
+    if (hi > sh->sh_nodes)
+	return NULL;
+    while (lo < hi){
+	mid = lo + (hi - lo)/2;
+	if ((eq = strcmp(name, str + nodes[mid].sn_name)) == 0)
+	    eq = strcmp(key, str + nodes[mid].sn_key);
+	if (eq == 0)
+	    return &nodes[mid];
+	if (eq < 0)
+	    hi = mid;
+	else
+	    lo = mid + 1;
+    }
+    return NULL;
+}
+
+/*! Look up a node of a datastore image with a canonical xpath
+ *
+ * Only absolute paths of child steps with optional key predicates are supported,
+ * eg /table/parameter[name='a']/value. A list entry must have all keys given in the
+ * order of the yang key statement, a leaf-list entry is given as [.='v'].
+ * Prefixes are ignored.
+ * @param[in]  sh    Image
+ * @param[in]  xpath XPath
+ * @param[in]  cb    Buffer for keys
+ * @param[out] snp   Node, or NULL if not found
+ * @retval     0     OK
+ * @retval     -1    Error, invalid xpath
+ */
+static int
+clixon_client_shm_lookup(struct xmldb_shm_header *sh,
+			 const char              *xpath,
+			 cbuf                    *cb,
+			 struct xmldb_shm_node  **snp)
+{
+    int                    retval = -1;
+    struct xmldb_shm_node *sn = (struct xmldb_shm_node *)(sh + 1);
+    const char            *p = xpath;
+    const char            *s;
+    const char            *c;
+    char                  *name = NULL;
+    char                   q;
+
+    *snp = NULL;
+    if (xpath == NULL || *p != '/')
+	goto syntax;
+    while (sn && *p == '/'){
+	s = ++p;
+	while (*p && *p != '/' && *p != '[')
+	    p++;
+	if ((c = memchr(s, ':', p-s)) != NULL)
+	    s = c + 1;
+	if (p == s)
+	    goto syntax;
+	if ((name = strndup(s, p-s)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	cbuf_reset(cb);
+	while (*p == '['){
+	    while (*p && *p != '=')
+		p++;
+	    if (*p != '=')
+		goto syntax;
+	    if ((q = *++p) != '\'' && q != '"')
+		goto syntax;
+	    s = ++p;
+	    while (*p && *p != q)
+		p++;
+	    if (*p != q)
+		goto syntax;
+	    if (cbuf_len(cb))
+		cprintf(cb, "%c", XMLDB_SHM_KEYSEP);
+	    cprintf(cb, "%.*s", (int)(p-s), s);
+	    if (*++p != ']')
+		goto syntax;
+	    p++;
+	}
+	if (*p && *p != '/')
+	    goto syntax;
+	sn = clixon_client_shm_child(sh, sn, name, cbuf_get(cb));
+	free(name);
+	name = NULL;
+    }
+    *snp = sn;
+    retval = 0;
+ done:
+    if (name)
+	free(name);
+    return retval;
+ syntax:
+    clicon_err(OE_XML, EINVAL, "Invalid xpath: %s", xpath?xpath:"null");
+    goto done;
+}
+
+/*! Get many values from a datastore image without rpc
+ *
+ * If the image has been replaced since the last call, the new image is mapped first.
+ * Each value is given by a canonical xpath, see clixon_client_shm_lookup.
+ * @param[in]     shm   Reader handle
+ * @param[in,out] vec   Values: xpath and type given, value and cv_found set
+ * @param[in]     len   Length of vec
+ * @retval        n     Number of values found
+ * @retval        -1    Error, eg invalid xpath or value
+ * @code
+ *   clixon_client_shm   shm;
+ *   clixon_client_value vec[1] = {{"/table/parameter[name='a']/value", CLIXON_CLIENT_UINT32}};
+ *
+ *   if ((shm = clixon_client_shm_open("/dev/shm/clixon-running")) == NULL)
+ *      err;
+ *   if (clixon_client_shm_get(shm, vec, 1) < 0)
+ *      err;
+ * @endcode
+ * @see clixon_client_get_batch  Same values read with rpc
+ */
+int
+clixon_client_shm_get(clixon_client_shm    shm,
+		      clixon_client_value *vec,
+		      int                  len)
+{
+    int                       retval = -1;
+    struct clixon_client_shm *cs = (struct clixon_client_shm *)shm;
+    struct xmldb_shm_node    *sn;
+    cbuf                     *cb = NULL;
+    int                       found = 0;
+    int                       i;
+
+    if (cs->cs_hdr == NULL || cs->cs_hdr->sh_obsolete){
+	if (clixon_client_shm_map(cs) < 0)
+	    goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    for (i=0; i<len; i++){
+	vec[i].cv_found = 0;
+	if (clixon_client_shm_lookup(cs->cs_hdr, vec[i].cv_xpath, cb, &sn) < 0)
+	    goto done;
+	if (sn == NULL || sn->sn_body == 0)
+	    continue;
+	if (clixon_client_value_parse((char*)cs->cs_hdr + cs->cs_hdr->sh_strings + sn->sn_body,
+				      &vec[i]) < 0)
+	    goto done;
+	vec[i].cv_found = 1;
+	found++;
+    }
+    retval = found;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Get generation of the mapped datastore image, remapping if replaced
+ * @param[in]  shm   Reader handle
+ * @param[out] gen   Generation of running when image was written
+ * @retval     0     OK
+ * @retval     -1    Error
+ */
+int
+clixon_client_shm_generation(clixon_client_shm shm,
+			     uint64_t         *gen)
+{
+    struct clixon_client_shm *cs = (struct clixon_client_shm *)shm;
+
+    if ((cs->cs_hdr == NULL || cs->cs_hdr->sh_obsolete) &&
+	clixon_client_shm_map(cs) < 0)
+	return -1;
+    *gen = cs->cs_hdr->sh_generation;
+    return 0;
+}
+
 /* Access functions */
 /*! Client-api get uint64
  * @param[in]  ch     Clixon client handle
@@ -45,6 +45,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <assert.h>
 #include <signal.h>
 #include <syslog.h>
 #include <dlfcn.h>
@@ -74,6 +75,8 @@
 #include "clixon_yang_module.h"
 #include "clixon_plugin.h"
 #include "clixon_options.h"
+#include "clixon_xml_map.h"
+#include "clixon_xml_bind.h"
 #include "clixon_data.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
@@ -120,6 +123,314 @@ xmldb_db2file(clicon_handle  h,
     return retval;
 }
 
+/*! Translate from symbolic database name to journal filename in file-system
+ * @param[in]   h        Clicon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see xmldb_db2file  The journal resides next to the datastore file
+ * @see CLICON_XMLDB_PERSIST
+ */
+int
+xmldb_db2journal(clicon_handle  h, 
+		 const char    *db,
+		 char         **filename)
+{
+    int   retval = -1;
+    char *dbfile = NULL;
+    cbuf *cb = NULL;
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s.journal", dbfile);
+    if ((*filename = strdup4(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (dbfile)
+	free(dbfile);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Translate from symbolic database name to directory of its shard files
+ * @param[in]   h        Clicon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  dirname  Directory name. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see CLICON_XMLDB_SHARD
+ */
+int
+xmldb_db2shards(clicon_handle  h, 
+		const char    *db,
+		char         **dirname)
+{
+    int   retval = -1;
+    char *dbfile = NULL;
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+	goto done;
+    if (xmldb_shard_dir(dbfile, dirname) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (dbfile)
+	free(dbfile);
+    return retval;
+}
+
+/*! Remove journal file of a database, if any
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Symbolic database name, eg "candidate", "running"
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+xmldb_journal_rm(clicon_handle h, 
+		 const char   *db)
+{
+    int       retval = -1;
+    char     *filename = NULL;
+    db_elmnt *de;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+	goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+	clicon_err(OE_UNIX, errno, "unlink(%s)", filename);
+	goto done;
+    }
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de->de_journal = 0;
+    retval = 0;
+ done:
+    if (filename)
+	free(filename);
+    return retval;
+}
+
+/* Read snapshot of a datastore, see xmldb_snapshot_get
+ * The tree is pinned: it is not modified or freed until the snapshot is released.
+ */
+struct xmldb_snapshot{
+    qelem_t   sn_q;    /* List header */
+    char     *sn_db;   /* Database name */
+    cxobj    *sn_xml;  /* Pinned tree */
+    uint64_t  sn_gen;  /* Generation of database when snapshot was taken */
+    int       sn_own;  /* Tree read from file (no cache), freed on release */
+};
+
+/*! Get list of read snapshots of a handle
+ * @param[in]  h    Clicon handle
+ * @retval     sn   List of snapshots, or NULL
+ */
+static xmldb_snapshot *
+xmldb_snapshot_list(clicon_handle h)
+{
+    void *p;
+
+    if ((p = clicon_hash_value(clicon_data(h), "xmldb-snapshots", NULL)) != NULL)
+	return *(xmldb_snapshot **)p;
+    return NULL;
+}
+
+/*! Set list of read snapshots of a handle
+ * @param[in]  h    Clicon handle
+ * @param[in]  list List of snapshots, or NULL. Direct pointer, no copying
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+xmldb_snapshot_list_set(clicon_handle   h,
+			xmldb_snapshot *list)
+{
+    if (clicon_hash_add(clicon_data(h), "xmldb-snapshots", &list, sizeof(list)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Check if a tree is pinned by a read snapshot
+ * @param[in]  h   Clicon handle
+ * @param[in]  xt  Cache tree
+ * @retval     0   Not pinned
+ * @retval     1   Pinned, the tree may not be modified or freed
+ * @see xmldb_snapshot_get
+ */
+int
+xmldb_snapshot_pinned(clicon_handle h,
+		      cxobj        *xt)
+{
+    xmldb_snapshot *list;
+    xmldb_snapshot *sn;
+
+    if ((sn = list = xmldb_snapshot_list(h)) != NULL){
+	do {
+	    if (sn->sn_xml == xt)
+		return 1;
+	    sn = NEXTQ(xmldb_snapshot *, sn);
+	} while (sn && sn != list);
+    }
+    return 0;
+}
+
+/*! Check if the cache tree of a database is shared with another database
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @param[in]  xt  Cache tree of db
+ * @retval    -1   Error
+ * @retval     0   Not shared
+ * @retval     1   Shared, another database cache or a read snapshot refers to the tree
+ * @see xmldb_copy  where cache trees become shared
+ * @see xmldb_snapshot_get  where cache trees become pinned
+ */
+static int
+xmldb_cache_shared(clicon_handle h, 
+		   const char   *db,
+		   cxobj        *xt)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+    db_elmnt *de;
+
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+	goto done;
+    retval = 0;
+    for (i = 0; i < klen; i++){
+	if (strcmp(keys[i], db) == 0)
+	    continue;
+	if ((de = clicon_db_elmnt_get(h, keys[i])) != NULL &&
+	    de->de_xml == xt){
+	    retval = 1;
+	    break;
+	}
+    }
+    if (retval == 0)
+	retval = xmldb_snapshot_pinned(h, xt);
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Ensure the cache tree of a database is not shared before it is modified
+ * Copy-on-write: xmldb_copy lets the source and target share the same tree and the
+ * actual copy is made here, when one of them is first modified. 
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval    -1   Error
+ * @retval     0   OK, cache of db (if any) is not shared with another database
+ * The copy is of the whole tree, not of the modified part. Paths that modify a cache
+ * tree in place:
+ * - xmldb_put and xmldb_get_detach (also used by startup upgrade) copy it here
+ * - a zero-copy read of xmldb_get0 adds defaults and flags, it copies it here
+ * - xmldb_cache_defaults_clear removes defaults, only present on a tree that is not shared
+ * - xmldb_get0_clear after a zero-copy read, the tree was copied by the read
+ * Binding a tree to YANG sets the same specs for all databases sharing it and is allowed.
+ */
+int
+xmldb_cache_unshare(clicon_handle h, 
+		    const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    cxobj    *x1;
+    cxobj    *x2 = NULL;
+    int       ret;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	(x1 = de->de_xml) == NULL)
+	goto ok;
+    if ((ret = xmldb_cache_shared(h, db, x1)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    clicon_debug(1, "%s %s", __FUNCTION__, db);
+    if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
+	goto done;
+    xml_flag_set(x2, XML_FLAG_TOP);
+    if (xml_copy(x1, x2) < 0) 
+	goto done;
+    de->de_xml = x2;
+    x2 = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (x2)
+	xml_free(x2);
+    return retval;
+}
+
+/*! Remove default values left in the cache tree of a database by a zero-copy read
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval    -1   Error
+ * @retval     0   OK
+ * Defaults are only added to a tree that is not shared, see xmldb_get0, and removed
+ * before the tree becomes shared, see xmldb_copy.
+ */
+int
+xmldb_cache_defaults_clear(clicon_handle h, 
+			   const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    cxobj    *xt;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	(xt = de->de_xml) == NULL ||
+	de->de_defaults == 0)
+	goto ok;
+    assert(xmldb_cache_shared(h, db, xt) == 0);
+    /* Mark non-presence containers as XML_FLAG_DEFAULT */
+    if (xml_apply(xt, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_DEFAULT) < 0)
+	goto done;
+    /* Clear XML tree of defaults */
+    if (xml_tree_prune_flagged(xt, XML_FLAG_DEFAULT, 1) < 0)
+	goto done;
+    de->de_defaults = 0;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free cache tree of a database, unless it is shared with another database or pinned
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval    -1   Error
+ * @retval     0   OK, cache of db is NULL
+ */
+static int
+xmldb_cache_free(clicon_handle h, 
+		 const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    int       ret;
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL &&
+	de->de_xml != NULL){
+	if ((ret = xmldb_cache_shared(h, db, de->de_xml)) < 0)
+	    goto done;
+	if (ret == 0)
+	    xml_free(de->de_xml);
+	de->de_xml = NULL;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Ensure database name is correct
  * @param[in]   db    Name of database 
  * @retval  0   OK
@@ -141,13 +452,54 @@ xmldb_validate_db(const char *db)
  * @param[in]  h    Clicon handle
  * @retval     0    OK
  * @retval    -1    Error
+ * The time of connect is the modification time of datastores not changed since,
+ * see xmldb_modified
+ * Also sets the pages that parsed trees are allocated from, see CLICON_XMLDB_HUGEPAGES
  */
 int
 xmldb_connect(clicon_handle h)
 {
+    uint64_t             t;
+    char                *str;
+    enum xml_arena_pages pages = XML_ARENA_PAGES_NONE;
+
+    t = (uint64_t)time(NULL);
+    if (clicon_hash_add(clicon_data(h), "xmldb-start", &t, sizeof(t)) == NULL)
+	return -1;
+    /* Huge pages of trees parsed into the datastore cache */
+    if ((str = clicon_option_str(h, "CLICON_XMLDB_HUGEPAGES")) != NULL){
+	if (strcmp(str, "transparent") == 0)
+	    pages = XML_ARENA_PAGES_TRANSPARENT;
+	else if (strcmp(str, "explicit") == 0)
+	    pages = XML_ARENA_PAGES_EXPLICIT;
+    }
+    if (xml_arena_pages_set(pages, clicon_option_bool(h, "CLICON_XMLDB_NUMA")) < 0)
+	return -1;
     return 0;
 }
 
+/*! Check if a datastore is kept in the datastore cache only
+ * The file of such a datastore is written by xmldb_flush. Private candidates are
+ * always kept in cache only, since they do not outlive their sessions.
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval     1   Cache only
+ * @retval     0   File written on each change
+ * @see CLICON_XMLDB_TRANSIENT
+ * @see CLICON_PRIVATE_CANDIDATE
+ */
+int
+xmldb_transient(clicon_handle h,
+		const char   *db)
+{
+    if (clicon_datastore_cache(h) == DATASTORE_NOCACHE)
+	return 0;
+    if (strncmp(db, XMLDB_PRIVATE_CANDIDATE, strlen(XMLDB_PRIVATE_CANDIDATE)) == 0)
+	return 1;
+    return clicon_optv(h)->co_xmldb_transient &&
+	(strcmp(db, "candidate") == 0 || strcmp(db, "tmp") == 0);
+}
+
 /*! Disconnect from a datastore plugin and deallocate resources
  * @param[in]  handle  Disconect and deallocate from this handle
  * @retval     0       OK
@@ -160,17 +512,28 @@ xmldb_disconnect(clicon_handle h)
     char    **keys = NULL;
     size_t    klen;
     int       i;
-    db_elmnt *de;
+    xmldb_snapshot *sn;
     
     if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
 	goto done;
+    /* Datastores kept in cache only are written before the cache is freed */
     for(i = 0; i < klen; i++) 
-	if ((de = clicon_hash_value(clicon_db_elmnt(h), keys[i], NULL)) != NULL){
-	    if (de->de_xml){
-		xml_free(de->de_xml);
-		de->de_xml = NULL;
-	    }
-	}
+	if (xmldb_flush(h, keys[i]) < 0)
+	    goto done;
+    /* A shared tree is freed with the last database referring to it */
+    for(i = 0; i < klen; i++) 
+	if (xmldb_cache_free(h, keys[i]) < 0)
+	    goto done;
+    /* Snapshots not released by their users */
+    while ((sn = xmldb_snapshot_list(h)) != NULL)
+	if (xmldb_snapshot_release(h, sn) < 0)
+	    goto done;
+    /* Files written but not synced, see CLICON_XMLDB_SYNC */
+    if (xmldb_sync(h) < 0)
+	goto done;
+    /* Trees parsed in nocache mode, see CLICON_XMLDB_PARSE_CACHE */
+    if (xmldb_parse_cache_clear() < 0)
+	goto done;
     retval = 0;
  done:
     if (keys)
@@ -198,52 +561,87 @@ xmldb_copy(clicon_handle h,
     db_elmnt            de0 = {0,};
     cxobj              *x1 = NULL;  /* from */
     cxobj              *x2 = NULL;  /* to */
+    int                 ret;
 
     /* XXX lock */
+    if (xmldb_generation_incr(h, to) < 0)
+	goto done;
     if (clicon_datastore_cache(h) != DATASTORE_NOCACHE){
 	/* Copy in-memory cache */
+	/* A shared tree has no defaults */
+	if (xmldb_cache_defaults_clear(h, from) < 0)
+	    goto done;
 	/* 1. "to" xml tree in x1 */
 	if ((de1 = clicon_db_elmnt_get(h, from)) != NULL)
 	    x1 = de1->de_xml;
 	if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
 	    x2 = de2->de_xml;
-	if (x1 == NULL && x2 == NULL){
-	    /* do nothing */
-	}
-	else if (x1 == NULL){  /* free x2 and set to NULL */
-	    xml_free(x2);
-	    x2 = NULL;
-	}
-	else  if (x2 == NULL){ /* create x2 and copy from x1 */
-	    if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
-		goto done;
-	    xml_flag_set(x2, XML_FLAG_TOP);
-	    if (xml_copy(x1, x2) < 0) 
-		goto done;
-	}
-	else{ /* copy x1 to x2 */
-	    xml_free(x2);
-	    if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
-		goto done;
-	    xml_flag_set(x2, XML_FLAG_TOP);
-	    if (xml_copy(x1, x2) < 0) 
+	/* Let x2 share the tree of x1 instead of making a deep copy. The tree is
+	 * copied when either of them is modified, see xmldb_cache_unshare
+	 */
+	if (x1 != x2){
+	    if (xmldb_cache_free(h, to) < 0)
 		goto done;
+	    x2 = x1;
 	}
-	/* always set cache although not strictly necessary in case 1
-	 * above, but logic gets complicated due to differences with
+	/* always set cache although not strictly necessary if x1 and x2
+	 * are both NULL, but logic gets complicated due to differences with
 	 * de and de->de_xml */
 	if (de2)
 	    de0 = *de2;
 	de0.de_xml = x2; /* The new tree */
     }
+    /* The file of a datastore being bulk loaded is written at end, write it now */
+    if (de1 && de1->de_bulk && !xmldb_transient(h, from)){
+	if (xmldb_bulk_write(h, from) < 0)
+	    goto done;
+	de1 = clicon_db_elmnt_get(h, from);
+    }
+    de0.de_journal = de1?de1->de_journal:0;
+    de0.de_defaults = 0; /* Cleared above */
+    de0.de_unsaved = xmldb_transient(h, to);
+    if (de0.de_unsaved)
+	de0.de_journal = 0;
     clicon_db_elmnt_set(h, to, &de0);
+    /* The file of a datastore kept in cache only is written by xmldb_flush */
+    if (de0.de_unsaved){
+	retval = 0;
+	goto done;
+    }
+    /* The file of from is not up to date, write the file of to from the shared tree */
+    if (de1 && de1->de_unsaved){
+	if (xmldb_bulk_write(h, to) < 0)
+	    goto done;
+	retval = 0;
+	goto done;
+    }
 
     /* Copy the files themselves (above only in-memory cache) */
     if (xmldb_db2file(h, from, &fromfile) < 0)
 	goto done;
     if (xmldb_db2file(h, to, &tofile) < 0)
 	goto done;
-    if (clicon_file_copy(fromfile, tofile) < 0)
+    /* Shard files first, they are not read unless the file marks them */
+    if (xmldb_shard_copy(h, fromfile, tofile) < 0)
+	goto done;
+    if (xmldb_file_copy(h, fromfile, tofile) < 0)
+	goto done;
+    /* The journal, if any, is part of the datastore content */
+    free(fromfile);
+    fromfile = NULL;
+    free(tofile);
+    tofile = NULL;
+    if ((ret = xmldb_journal_exists(h, from)) < 0)
+	goto done;
+    if (ret == 1){
+	if (xmldb_db2journal(h, from, &fromfile) < 0)
+	    goto done;
+	if (xmldb_db2journal(h, to, &tofile) < 0)
+	    goto done;
+	if (xmldb_file_copy(h, fromfile, tofile) < 0)
+	    goto done;
+    }
+    else if (xmldb_journal_rm(h, to) < 0)
 	goto done;
     retval = 0;
  done:
@@ -374,6 +772,62 @@ xmldb_exists(clicon_handle h,
     return retval;
 }
 
+/*! Check if journal of db exists 
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval -1  Error
+ * @retval  0  No it does not exist
+ * @retval  1  Yes it exists
+ * @see CLICON_XMLDB_PERSIST
+ */
+int 
+xmldb_journal_exists(clicon_handle h, 
+		     const char   *db)
+{
+    int                 retval = -1;
+    char               *filename = NULL;
+    struct stat         sb;
+
+    if (xmldb_db2journal(h, db, &filename) < 0)
+	goto done;
+    if (lstat(filename, &sb) < 0)
+	retval = 0;
+    else
+	retval = 1;
+ done:
+    if (filename)
+	free(filename);
+    return retval;
+}
+
+/*! Check if the file of a datastore has the same content as the datastore
+ *
+ * Not if edits are only in the cache, ie in a bulk load or a transient datastore, or
+ * if edits are appended to a journal. Default values are never in the file.
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval -1  Error
+ * @retval  0  No, the datastore must be read via the cache
+ * @retval  1  Yes, the file has the content of the datastore
+ * @see xmldb_journal_exists
+ */
+int 
+xmldb_file_synced(clicon_handle h, 
+		  const char   *db)
+{
+    db_elmnt *de;
+    int       ret;
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL &&
+	(de->de_journal || de->de_bulk || de->de_unsaved))
+	return 0;
+    if (clicon_optv(h)->co_xmldb_shard)
+	return 0;
+    if ((ret = xmldb_journal_exists(h, db)) < 0)
+	return -1;
+    return ret?0:1;
+}
+
 /*! Clear database cache if any for mem/size optimization only, not file itself
  * @param[in]  h   Clicon handle
  * @param[in]  db  Database
@@ -384,16 +838,9 @@ int
 xmldb_clear(clicon_handle h, 
 	    const char   *db)
 {
-    cxobj    *xt = NULL;
-    db_elmnt *de = NULL;
-    
-    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-	if ((xt = de->de_xml) != NULL){
-	    xml_free(xt);
-	    de->de_xml = NULL;
-	}
-    }
-    return 0;
+    if (xmldb_generation_incr(h, db) < 0)
+	return -1;
+    return xmldb_cache_free(h, db);
 }
 
 /*! Delete database, clear cache if any. Remove file 
@@ -412,6 +859,8 @@ xmldb_delete(clicon_handle h,
     
     if (xmldb_clear(h, db) < 0)
 	goto done;
+    if (xmldb_journal_rm(h, db) < 0)
+	goto done;
     if (xmldb_db2file(h, db, &filename) < 0)
 	goto done;
     if (lstat(filename, &sb) == 0)
@@ -419,6 +868,49 @@ xmldb_delete(clicon_handle h,
 	    clicon_err(OE_DB, errno, "truncate %s", filename);
 	    goto done;
 	}
+    if (xmldb_shard_rm(h, filename, NULL) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (filename)
+	free(filename);
+    return retval;
+}
+
+/*! Remove database, clear cache if any, remove file and forget the database
+ *
+ * As xmldb_delete but the file is removed instead of truncated, and the state kept
+ * for the database in the handle is freed, eg for a private candidate of a session
+ * that has ended.
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval -1  Error
+ * @retval  0  OK
+ */
+int 
+xmldb_remove(clicon_handle h, 
+	     const char   *db)
+{
+    int   retval = -1;
+    char *filename = NULL;
+    char  key[64];
+
+    if (xmldb_delete(h, db) < 0)
+	goto done;
+    if (xmldb_db2file(h, db, &filename) < 0)
+	goto done;
+    if (unlink(filename) < 0 && errno != ENOENT){
+	clicon_err(OE_DB, errno, "unlink %s", filename);
+	goto done;
+    }
+    if (clicon_db_elmnt_get(h, db) != NULL)
+	clicon_hash_del(clicon_db_elmnt(h), db);
+    snprintf(key, sizeof(key), "xmldb-generation-%s", db);
+    if (clicon_hash_value(clicon_data(h), key, NULL) != NULL)
+	clicon_hash_del(clicon_data(h), key);
+    snprintf(key, sizeof(key), "xmldb-modified-%s", db);
+    if (clicon_hash_value(clicon_data(h), key, NULL) != NULL)
+	clicon_hash_del(clicon_data(h), key);
     retval = 0;
  done:
     if (filename)
@@ -439,21 +931,19 @@ xmldb_create(clicon_handle h,
     int                 retval = -1;
     char               *filename = NULL;
     int                 fd = -1;
-    db_elmnt           *de = NULL;
-    cxobj              *xt = NULL;
 
-    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
-	if ((xt = de->de_xml) != NULL){
-	    xml_free(xt);
-	    de->de_xml = NULL;
-	}
-    }
+    if (xmldb_clear(h, db) < 0)
+	goto done;
+    if (xmldb_journal_rm(h, db) < 0)
+	goto done;
     if (xmldb_db2file(h, db, &filename) < 0)
 	goto done;
     if ((fd = open(filename, O_CREAT|O_WRONLY, S_IRWXU)) == -1) {
 	clicon_err(OE_UNIX, errno, "open(%s)", filename);
 	goto done;
     }
+    if (xmldb_shard_rm(h, filename, NULL) < 0)
+	goto done;
    retval = 0;
  done:
     if (filename)
@@ -481,6 +971,79 @@ xmldb_db_reset(clicon_handle h,
     return 0;
 }
 
+/*! Get generation of datastore
+ *
+ * The generation is incremented each time the content of the datastore may change,
+ * eg on xmldb_put and xmldb_copy. Data derived from a datastore, such as the compiled
+ * NACM rules of running, can be kept until the generation changes.
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Database name
+ * @retval     gen  Generation, 0 if not changed since start
+ * @see xmldb_generation_incr
+ */
+uint64_t
+xmldb_generation(clicon_handle h,
+		 const char   *db)
+{
+    char  key[64];
+    void *p;
+
+    snprintf(key, sizeof(key), "xmldb-generation-%s", db);
+    if ((p = clicon_hash_value(clicon_data(h), key, NULL)) == NULL)
+	return 0;
+    return *(uint64_t*)p;
+}
+
+/*! Increment generation of datastore, the content of the datastore may change
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Database name
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_generation
+ * @see xmldb_modified
+ */
+int
+xmldb_generation_incr(clicon_handle h,
+		      const char   *db)
+{
+    char     key[64];
+    uint64_t gen;
+    uint64_t t;
+
+    gen = xmldb_generation(h, db) + 1;
+    snprintf(key, sizeof(key), "xmldb-generation-%s", db);
+    if (clicon_hash_add(clicon_data(h), key, &gen, sizeof(gen)) == NULL)
+	return -1;
+    t = (uint64_t)time(NULL);
+    snprintf(key, sizeof(key), "xmldb-modified-%s", db);
+    if (clicon_hash_add(clicon_data(h), key, &t, sizeof(t)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Get time when the generation of datastore was last incremented
+ *
+ * Together with the generation, this is a cheap change token of a datastore, eg for
+ * HTTP ETag and Last-Modified headers.
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Database name
+ * @retval     t    Seconds since epoch, time of xmldb_connect if not changed since
+ * @see xmldb_generation_incr
+ */
+uint64_t
+xmldb_modified(clicon_handle h,
+	       const char   *db)
+{
+    char  key[64];
+    void *p;
+
+    snprintf(key, sizeof(key), "xmldb-modified-%s", db);
+    if ((p = clicon_hash_value(clicon_data(h), key, NULL)) == NULL &&
+	(p = clicon_hash_value(clicon_data(h), "xmldb-start", NULL)) == NULL)
+	return 0;
+    return *(uint64_t*)p;
+}
+
 /*! Get datastore XML cache
  * @param[in]  h    Clicon handle
  * @param[in]  db   Database name
@@ -497,6 +1060,171 @@ xmldb_cache_get(clicon_handle h,
     return de->de_xml;
 }
 
+/*! Take a read snapshot of a datastore
+ *
+ * The snapshot is an immutable view of the datastore as stored, ie without default
+ * values. The cache tree is read directly (no copy) and is pinned until the snapshot
+ * is released: a write to the datastore copies the tree first (copy-on-write, see
+ * xmldb_cache_unshare), as does a zero-copy read of xmldb_get0.
+ * Therefore the tree does not change while it is read, and it need not be cleared
+ * after use as a zero-copy read of xmldb_get0.
+ * The caller must not modify the tree. Copy subtrees that need to be changed, eg
+ * pruned by NACM.
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Name of database, eg "running"
+ * @param[out] snp  Snapshot. Release with xmldb_snapshot_release
+ * @retval     1    OK
+ * @retval     0    Datastore could not be read
+ * @retval    -1    Error
+ * @code
+ *   xmldb_snapshot *sn = NULL;
+ *
+ *   if (xmldb_snapshot_get(h, "running", &sn) < 1)
+ *      err;
+ *   if (xpath_vec(xmldb_snapshot_xml(sn), nsc, "%s", &xvec, &xlen, xpath) < 0)
+ *      err;
+ *   ...
+ *   xmldb_snapshot_release(h, sn);
+ * @endcode
+ * @note With CLICON_DATASTORE_CACHE = nocache the datastore is read from file and the
+ *       snapshot owns the tree
+ * @see xmldb_snapshot_generation  Compare with xmldb_generation if snapshot is current
+ */
+int
+xmldb_snapshot_get(clicon_handle    h,
+		   const char      *db,
+		   xmldb_snapshot **snp)
+{
+    int             retval = -1;
+    yang_stmt      *yspec;
+    xmldb_snapshot *sn = NULL;
+    xmldb_snapshot *list;
+    db_elmnt       *de;
+    db_elmnt        de0 = {0,};
+    cxobj          *xt = NULL;
+    int             own = 0;
+    int             ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if (clicon_datastore_cache(h) == DATASTORE_NOCACHE){
+	if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, &xt, &de0, NULL)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	own++;
+    }
+    else if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_xml == NULL){
+	/* Cache miss, read XML from file */
+	if ((ret = xmldb_readfile(h, db, YB_MODULE_NEXT, yspec, &xt, &de0, NULL)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	de0.de_xml = xt;
+	clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
+    }
+    else {
+	xt = de->de_xml;
+	/* Remove defaults left in cache by a zero-copy read */
+	if (xmldb_cache_defaults_clear(h, db) < 0)
+	    goto done;
+	if (!xml_spec(xt))
+	    if (xml_bind_yang(xt, YB_MODULE, yspec, NULL) < 0)
+		goto done;
+    }
+    if ((sn = malloc(sizeof(*sn))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(sn, 0, sizeof(*sn));
+    if ((sn->sn_db = strdup(db)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    sn->sn_xml = xt;
+    sn->sn_gen = xmldb_generation(h, db);
+    sn->sn_own = own;
+    list = xmldb_snapshot_list(h);
+    ADDQ(sn, list);
+    if (xmldb_snapshot_list_set(h, list) < 0)
+	goto done;
+    *snp = sn;
+    sn = NULL;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (sn){
+	if (sn->sn_db)
+	    free(sn->sn_db);
+	free(sn);
+    }
+    if (own && xt)
+	xml_free(xt);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get the pinned XML tree of a read snapshot
+ * @param[in]  sn   Snapshot
+ * @retval     xt   XML tree, eg <config>...</config>. Do not modify or free
+ * @see xmldb_snapshot_get
+ */
+cxobj *
+xmldb_snapshot_xml(xmldb_snapshot *sn)
+{
+    return sn->sn_xml;
+}
+
+/*! Get the datastore generation of a read snapshot
+ * @param[in]  sn   Snapshot
+ * @retval     gen  Generation of the datastore when the snapshot was taken
+ * @see xmldb_generation  If equal, the snapshot is the current content of the datastore
+ */
+uint64_t
+xmldb_snapshot_generation(xmldb_snapshot *sn)
+{
+    return sn->sn_gen;
+}
+
+/*! Release a read snapshot, the tree is freed if no datastore or snapshot refers to it
+ * @param[in]  h    Clicon handle
+ * @param[in]  sn   Snapshot, freed by this function
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xmldb_snapshot_get
+ */
+int
+xmldb_snapshot_release(clicon_handle   h,
+		       xmldb_snapshot *sn)
+{
+    int             retval = -1;
+    xmldb_snapshot *list;
+    int             ret;
+
+    list = xmldb_snapshot_list(h);
+    DELQ(sn, list, xmldb_snapshot *);
+    if (xmldb_snapshot_list_set(h, list) < 0)
+	goto done;
+    if (sn->sn_own)
+	xml_free(sn->sn_xml);
+    else {
+	/* The empty name matches no database, all are checked */
+	if ((ret = xmldb_cache_shared(h, "", sn->sn_xml)) < 0)
+	    goto done;
+	if (ret == 0)
+	    xml_free(sn->sn_xml);
+    }
+    retval = 0;
+ done:
+    free(sn->sn_db);
+    free(sn);
+    return retval;
+}
+
 /*! Get modified flag from datastore
  * @param[in]  h     Clicon handle
  * @param[in]  db    Database name
@@ -586,6 +1314,8 @@ xmldb_print(clicon_handle h,
 	fprintf(f, "  XML:      %p\n", de->de_xml);
 	fprintf(f, "  Modified: %d\n", de->de_modified);
 	fprintf(f, "  Empty:    %d\n", de->de_empty);
+	fprintf(f, "  Journal:  %d\n", de->de_journal);
+	fprintf(f, "  Unsaved:  %d\n", de->de_unsaved);
     }
     retval = 0;
  done:
@@ -0,0 +1,313 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Compressed datastore files, see CLICON_XMLDB_COMPRESS
+ *
+ * Datastore files are compressed with zstd as a stream: the XML, JSON or CBOR
+ * writers and parsers use a FILE that compresses or decompresses on the fly, so
+ * the uncompressed file is never kept in memory or on disk.
+ * Compressed files are recognized by the zstd frame magic number regardless of
+ * CLICON_XMLDB_COMPRESS, so that the option can be changed between restarts.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#define _GNU_SOURCE /* for fopencookie */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_log.h"
+
+#include "clixon_datastore_compress.h"
+
+/* zstd frame magic number 0xFD2FB528 as stored, ie little-endian */
+static const uint8_t _zstd_magic[4] = {0x28, 0xb5, 0x2f, 0xfd};
+
+/*! Check if a datastore file is compressed
+ * @param[in]  fp   Open file, rewound on return
+ * @retval     1    Compressed with zstd
+ * @retval     0    Not compressed, or empty
+ */
+int
+xmldb_file_compressed(FILE *fp)
+{
+    uint8_t buf[4];
+    size_t  n;
+
+    n = fread(buf, 1, sizeof(buf), fp);
+    rewind(fp);
+    return n == sizeof(buf) && memcmp(buf, _zstd_magic, sizeof(buf)) == 0;
+}
+
+#ifdef HAVE_LIBZSTD
+/* State of a compressed stream, fopencookie(3) cookie */
+struct xmldb_zstd{
+    FILE          *xz_f;      /* Underlying file, not closed by the stream */
+    ZSTD_DCtx     *xz_dctx;   /* Decompression context, if reader */
+    ZSTD_CCtx     *xz_cctx;   /* Compression context, if writer */
+    void          *xz_buf;    /* Buffer of compressed data */
+    size_t         xz_buflen;
+    ZSTD_inBuffer  xz_in;     /* Compressed input of reader, in xz_buf */
+    size_t         xz_ret;    /* Last decompress return, 0 if at end of frame */
+};
+
+/*! Free state of compressed stream */
+static void
+xmldb_zstd_free(struct xmldb_zstd *xz)
+{
+    if (xz->xz_dctx)
+	ZSTD_freeDCtx(xz->xz_dctx);
+    if (xz->xz_cctx)
+	ZSTD_freeCCtx(xz->xz_cctx);
+    if (xz->xz_buf)
+	free(xz->xz_buf);
+    free(xz);
+}
+
+/*! Read decompressed data, fopencookie read function
+ */
+static ssize_t
+xmldb_zstd_read(void  *cookie,
+		char  *buf,
+		size_t size)
+{
+    struct xmldb_zstd *xz = (struct xmldb_zstd *)cookie;
+    ZSTD_outBuffer     out = {buf, size, 0};
+    size_t             n;
+
+    while (out.pos == 0){
+	if (xz->xz_in.pos == xz->xz_in.size){
+	    if ((n = fread(xz->xz_buf, 1, xz->xz_buflen, xz->xz_f)) == 0){
+		if (ferror(xz->xz_f))
+		    return -1;
+		if (xz->xz_ret != 0){ /* Truncated frame */
+		    errno = EIO;
+		    return -1;
+		}
+		break; /* EOF */
+	    }
+	    xz->xz_in.src = xz->xz_buf;
+	    xz->xz_in.size = n;
+	    xz->xz_in.pos = 0;
+	}
+	xz->xz_ret = ZSTD_decompressStream(xz->xz_dctx, &out, &xz->xz_in);
+	if (ZSTD_isError(xz->xz_ret)){
+	    errno = EBADMSG;
+	    return -1;
+	}
+    }
+    return out.pos;
+}
+
+/*! Write data to be compressed, fopencookie write function
+ */
+static ssize_t
+xmldb_zstd_write(void       *cookie,
+		 const char *buf,
+		 size_t      size)
+{
+    struct xmldb_zstd *xz = (struct xmldb_zstd *)cookie;
+    ZSTD_inBuffer      in = {buf, size, 0};
+    ZSTD_outBuffer     out;
+    size_t             ret;
+
+    while (in.pos < in.size){
+	out.dst = xz->xz_buf;
+	out.size = xz->xz_buflen;
+	out.pos = 0;
+	ret = ZSTD_compressStream2(xz->xz_cctx, &out, &in, ZSTD_e_continue);
+	if (ZSTD_isError(ret)){
+	    errno = EINVAL;
+	    return -1;
+	}
+	if (out.pos && fwrite(xz->xz_buf, 1, out.pos, xz->xz_f) != out.pos)
+	    return -1;
+    }
+    return size;
+}
+
+/*! Rewind a reader, fopencookie seek function
+ * Only rewind is supported, eg after checking the start of the file
+ */
+static int
+xmldb_zstd_seek(void    *cookie,
+		off64_t *offset,
+		int      whence)
+{
+    struct xmldb_zstd *xz = (struct xmldb_zstd *)cookie;
+
+    if (xz->xz_dctx == NULL || *offset != 0 || whence != SEEK_SET){
+	errno = EINVAL;
+	return -1;
+    }
+    if (fseek(xz->xz_f, 0, SEEK_SET) < 0)
+	return -1;
+    ZSTD_DCtx_reset(xz->xz_dctx, ZSTD_reset_session_only);
+    xz->xz_in.size = xz->xz_in.pos = 0;
+    xz->xz_ret = 0;
+    return 0;
+}
+
+/*! End the frame of a writer and free the stream, fopencookie close function
+ * The underlying file is not closed
+ */
+static int
+xmldb_zstd_close(void *cookie)
+{
+    struct xmldb_zstd *xz = (struct xmldb_zstd *)cookie;
+    ZSTD_inBuffer      in = {NULL, 0, 0};
+    ZSTD_outBuffer     out;
+    size_t             ret;
+    int                retval = 0;
+
+    if (xz->xz_cctx){
+	do {
+	    out.dst = xz->xz_buf;
+	    out.size = xz->xz_buflen;
+	    out.pos = 0;
+	    ret = ZSTD_compressStream2(xz->xz_cctx, &out, &in, ZSTD_e_end);
+	    if (ZSTD_isError(ret)){
+		errno = EINVAL;
+		retval = -1;
+		break;
+	    }
+	    if (out.pos && fwrite(xz->xz_buf, 1, out.pos, xz->xz_f) != out.pos){
+		retval = -1;
+		break;
+	    }
+	} while (ret != 0);
+    }
+    xmldb_zstd_free(xz);
+    return retval;
+}
+
+/*! Open a compressed stream on a file
+ * @param[in]  f      Underlying file
+ * @param[in]  level  Compression level of writer, or 0 for reader
+ */
+static FILE *
+xmldb_zstd_open(FILE *f,
+		int   level)
+{
+    struct xmldb_zstd      *xz;
+    cookie_io_functions_t   fns = {xmldb_zstd_read, xmldb_zstd_write,
+				   xmldb_zstd_seek, xmldb_zstd_close};
+    FILE                   *fz;
+
+    if ((xz = calloc(1, sizeof(*xz))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	return NULL;
+    }
+    xz->xz_f = f;
+    if (level == 0){
+	xz->xz_buflen = ZSTD_DStreamInSize();
+	if ((xz->xz_dctx = ZSTD_createDCtx()) == NULL){
+	    clicon_err(OE_UNIX, ENOMEM, "ZSTD_createDCtx");
+	    goto fail;
+	}
+    }
+    else{
+	xz->xz_buflen = ZSTD_CStreamOutSize();
+	if ((xz->xz_cctx = ZSTD_createCCtx()) == NULL){
+	    clicon_err(OE_UNIX, ENOMEM, "ZSTD_createCCtx");
+	    goto fail;
+	}
+	if (ZSTD_isError(ZSTD_CCtx_setParameter(xz->xz_cctx, ZSTD_c_compressionLevel, level))){
+	    clicon_err(OE_CFG, EINVAL, "zstd compression level %d", level);
+	    goto fail;
+	}
+    }
+    if ((xz->xz_buf = malloc(xz->xz_buflen)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto fail;
+    }
+    if ((fz = fopencookie(xz, level?"w":"r", fns)) == NULL){
+	clicon_err(OE_UNIX, errno, "fopencookie");
+	goto fail;
+    }
+    return fz;
+ fail:
+    xmldb_zstd_free(xz);
+    return NULL;
+}
+#endif /* HAVE_LIBZSTD */
+
+/*! Open a stream decompressing a datastore file
+ * @param[in]  f    Compressed file, see xmldb_file_compressed
+ * @retval     fz   Stream of decompressed data, close with fclose before f
+ * @retval     NULL Error
+ */
+FILE *
+xmldb_zstd_reader(FILE *f)
+{
+#ifdef HAVE_LIBZSTD
+    return xmldb_zstd_open(f, 0);
+#else
+    clicon_err(OE_CFG, ENOTSUP, "Compressed datastore file but clixon is not configured --with-zstd");
+    return NULL;
+#endif
+}
+
+/*! Open a stream compressing data written to a datastore file
+ * @param[in]  f      File
+ * @param[in]  level  zstd compression level, > 0
+ * @retval     fz     Stream to write to, close with fclose to complete the file before f
+ * @retval     NULL   Error
+ */
+FILE *
+xmldb_zstd_writer(FILE *f,
+		  int   level)
+{
+#ifdef HAVE_LIBZSTD
+    return xmldb_zstd_open(f, level);
+#else
+    clicon_err(OE_CFG, ENOTSUP, "CLICON_XMLDB_COMPRESS set but clixon is not configured --with-zstd");
+    return NULL;
+#endif
+}
@@ -44,6 +44,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -51,6 +52,7 @@
 #include <assert.h>
 #include <syslog.h>       
 #include <fcntl.h>
+#include <time.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -65,13 +67,16 @@
 #include "clixon_file.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
+#include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 #include "clixon_xml_bind.h"
 #include "clixon_options.h"
+#include "clixon_proto.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_json.h"
+#include "clixon_cbor.h"
 #include "clixon_nacm.h"
 #include "clixon_path.h"
 #include "clixon_netconf_lib.h"
@@ -82,6 +87,9 @@
 
 #include "clixon_datastore.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_compress.h"
+#include "clixon_datastore_shm.h"
+#include "clixon_datastore_write.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
@@ -241,6 +249,105 @@ xml_copy_from_bottom(cxobj  *x0t,
     return retval;
 }
 
+/*! Find child of a node matching a datastore node, ie same yang spec and list keys
+ * @param[in]  xp   Parent
+ * @param[in]  x    Datastore node bound to yang
+ * @retval     xc   Child of xp matching x
+ * @retval     NULL Not found
+ * @see match_base_child  Uses the sorted children of a datastore node instead
+ */
+cxobj *
+xml_find_node_keys(cxobj *xp,
+		   cxobj *x)
+{
+    cxobj *xc = NULL;
+
+    while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL)
+	if (xml_spec(xc) && xml_spec(xc) == xml_spec(x) &&
+	    xml_cmp(xc, x, 0, 0, NULL) == 0)
+	    return xc;
+    return NULL;
+}
+
+/*! Copy element of datastore node, with namespace, list keys and leaf-list value
+ *
+ * Other children are not copied, eg for a change or a lock of a node identified by
+ * its path in the datastore
+ * @param[in]  x    Datastore node bound to yang
+ * @param[in]  xp   Parent of copy
+ * @retval     xc   Copy of x
+ * @retval     NULL Error
+ * @see xml_copy_node_path  Copy also ancestors
+ */
+cxobj *
+xml_copy_node_keys(cxobj *x,
+		   cxobj *xp)
+{
+    cxobj     *xc;
+    cxobj     *xk;
+    yang_stmt *y;
+    cg_var    *cvi;
+    char      *ns = NULL;
+    char      *nsp = NULL;
+
+    if ((y = xml_spec(x)) != NULL && yang_keyword_get(y) == Y_LEAF_LIST){
+	if ((xc = xml_dup(x)) == NULL)
+	    return NULL;
+	if (xml_addsub(xp, xc) < 0)
+	    return NULL;
+    }
+    else{
+	if ((xc = xml_new(xml_name(x), xp, CX_ELMNT)) == NULL)
+	    return NULL;
+	xml_spec_set(xc, y);
+	if (y && yang_keyword_get(y) == Y_LIST){
+	    cvi = NULL;
+	    while ((cvi = cvec_each(yang_cvec_get(y), cvi)) != NULL){
+		if ((xk = xml_find_type(x, NULL, cv_string_get(cvi), CX_ELMNT)) == NULL)
+		    continue;
+		if ((xk = xml_dup(xk)) == NULL)
+		    return NULL;
+		if (xml_addsub(xc, xk) < 0)
+		    return NULL;
+	    }
+	}
+    }
+    /* Namespace of copy is set if it differs from parent */
+    if (xml2ns(x, xml_prefix(x), &ns) < 0)
+	return NULL;
+    if (xml2ns(xp, NULL, &nsp) < 0)
+	return NULL;
+    xml_prefix_set(xc, NULL);
+    if (ns && (nsp == NULL || strcmp(ns, nsp) != 0))
+	if (xmlns_set(xc, NULL, ns) < 0)
+	    return NULL;
+    return xc;
+}
+
+/*! Get copy of a datastore node in a tree, copy it and its ancestors if not found
+ *
+ * The ancestors are copied with xml_copy_node_keys
+ * @param[in]  xt   Tree corresponding to datastore top, eg a change
+ * @param[in]  x    Datastore node bound to yang
+ * @retval     xc   Copy of x, or xt if x is the datastore top
+ * @retval     NULL Error
+ */
+cxobj *
+xml_copy_node_path(cxobj *xt,
+		   cxobj *x)
+{
+    cxobj *xp;
+    cxobj *xc;
+
+    if (xml_parent(x) == NULL)
+	return xt;
+    if ((xp = xml_copy_node_path(xt, xml_parent(x))) == NULL)
+	return NULL;
+    if ((xc = xml_find_node_keys(xp, x)) != NULL)
+	return xc;
+    return xml_copy_node_keys(x, xp);
+}
+
 /*! Read module-state in an XML tree
  *
  * @param[in]  th     Datastore text handle
@@ -412,6 +519,136 @@ disable_nacm_on_empty(cxobj     *xt,
     return retval;
 }
 
+/*! Check if a datastore file is in canonical (sorted) order for the yang modules
+ * Only the start of the file is read, see xmldb_write_file
+ * @param[in]  fp     Datastore file, rewound after check
+ * @param[in]  yspec  Top-level yang spec
+ * @retval     1      File starts with <config clixon-sorted="<value>", see xmldb_sorted_value
+ * @retval     0      Not known to be sorted, eg written with other yang modules
+ * @retval    -1      Error
+ */
+static int
+xmldb_file_sorted(FILE      *fp,
+		  yang_stmt *yspec)
+{
+    char   buf[64];
+    char   value[XMLDB_SORTED_LEN];
+    cbuf  *cb = NULL;
+    size_t n;
+    int    sorted = -1;
+
+    if (yspec == NULL)
+	return 0;
+    if (xmldb_sorted_value(yspec, value, sizeof(value)) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<%s %s=\"%s\"", DATASTORE_TOP_SYMBOL, XMLDB_SORTED_ATTR, value);
+    n = fread(buf, 1, sizeof(buf)-1, fp);
+    buf[n] = '\0';
+    sorted = strncmp(buf, cbuf_get(cb), cbuf_len(cb)) == 0;
+    rewind(fp);
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return sorted;
+}
+
+/*! Read the shard files of a datastore file into its tree, see CLICON_XMLDB_SHARD
+ * @param[in]  dbfile Datastore filename
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  x0     Datastore top-level tree, top-level nodes of shards are added
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_shard_write
+ */
+static int
+xmldb_shard_read(const char *dbfile,
+		 yang_bind   yb,
+		 yang_stmt  *yspec,
+		 cxobj      *x0)
+{
+    int            retval = -1;
+    char          *dir = NULL;
+    cbuf          *cb = NULL;
+    struct dirent *dp = NULL;
+    struct stat    st;
+    FILE          *fp = NULL;
+    FILE          *fz = NULL;
+    FILE          *fr;
+    cxobj         *xt = NULL;
+    cxobj         *x;
+    int            ndp;
+    int            i;
+    int            ret;
+
+    if (xmldb_shard_dir(dbfile, &dir) < 0)
+	goto done;
+    if (stat(dir, &st) < 0){ /* No module has content */
+	retval = 0;
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((ndp = clicon_file_dirent(dir, &dp, "\\.xml$", S_IFREG)) < 0)
+	goto done;
+    for (i = 0; i < ndp; i++){
+	cbuf_reset(cb);
+	cprintf(cb, "%s/%s", dir, dp[i].d_name);
+	if ((fp = fopen(cbuf_get(cb), "r")) == NULL) {
+	    clicon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cb));
+	    goto done;
+	}
+	fr = fp;
+	if (xmldb_file_compressed(fp) &&
+	    (fr = fz = xmldb_zstd_reader(fp)) == NULL)
+	    goto done;
+	if ((ret = xmldb_file_sorted(fr, yspec)) < 0)
+	    goto done;
+	if (ret == 1)
+	    ret = clixon_xml_parse_file_presorted(fr, yb, yspec, &xt, NULL);
+	else
+	    ret = clixon_xml_parse_file(fr, yb, yspec, &xt, NULL);
+	if (ret < 0)
+	    goto done;
+	if (singleconfigroot(xt, &xt) < 0)
+	    goto done;
+	while ((x = xml_child_i_type(xt, 0, CX_ELMNT)) != NULL)
+	    if (xml_addsub(x0, x) < 0)
+		goto done;
+	xml_free(xt);
+	xt = NULL;
+	if (fz){
+	    fclose(fz);
+	    fz = NULL;
+	}
+	fclose(fp);
+	fp = NULL;
+    }
+    if (xml_sort(x0) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    if (fz)
+	fclose(fz);
+    if (fp)
+	fclose(fp);
+    if (dp)
+	free(dp);
+    if (cb)
+	cbuf_free(cb);
+    if (dir)
+	free(dir);
+    return retval;
+}
+
 /*! Common read function that reads an XML tree from file
  * @param[in]  th     Datastore text handle
  * @param[in]  db     Symbolic database name, eg "candidate", "running"
@@ -438,10 +675,14 @@ xmldb_readfile(clicon_handle    h,
 {
     int        retval = -1;
     cxobj     *x0 = NULL;
+    cxobj     *xa;
     char      *dbfile = NULL;
     FILE      *fp = NULL;
-    char      *format;
+    FILE      *fz = NULL;
+    FILE      *fr;
+    int        format;
     int        ret;
+    int        nr = 0;
 
     if (xmldb_db2file(h, db, &dbfile) < 0)
 	goto done;
@@ -449,7 +690,7 @@ xmldb_readfile(clicon_handle    h,
 	clicon_err(OE_XML, 0, "dbfile NULL");
 	goto done;
     }
-    if ((format = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
+    if ((format = clicon_optv(h)->co_xmldb_format) < 0){
 	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
 	goto done;
     }
@@ -458,12 +699,28 @@ xmldb_readfile(clicon_handle    h,
 	clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
 	goto done;
     }    
-    if (strcmp(format, "json")==0){
-	if ((ret = clixon_json_parse_file(fp, yb, yspec, &x0, NULL)) < 0) /* XXX: ret == 0*/
+    /* Compressed file is decompressed while parsed, see CLICON_XMLDB_COMPRESS */
+    fr = fp;
+    if (xmldb_file_compressed(fp) &&
+	(fr = fz = xmldb_zstd_reader(fp)) == NULL)
+	goto done;
+    if (format == FORMAT_JSON){
+	if ((ret = clixon_json_parse_file(fr, yb, yspec, &x0, NULL)) < 0) /* XXX: ret == 0*/
+	    goto done;
+    }
+    else if (format == FORMAT_CBOR){
+	if ((ret = clixon_cbor_parse_file(fr, yb, yspec, &x0, NULL)) < 0)
+	    goto done;
+    }
+    else if ((ret = xmldb_file_sorted(fr, yspec)) < 0)
+	goto done;
+    else if (ret == 1){
+	/* Written by clixon in canonical order: flag as sorted instead of sorting */
+	if ((ret = clixon_xml_parse_file_presorted(fr, yb, yspec, &x0, NULL)) < 0)
 	    goto done;
     }
     else {
-	if ((ret = clixon_xml_parse_file(fp, yb, yspec, &x0, NULL)) < 0){
+	if ((ret = clixon_xml_parse_file(fr, yb, yspec, &x0, NULL)) < 0){
 	    goto done;
 	}
     }
@@ -474,8 +731,9 @@ xmldb_readfile(clicon_handle    h,
     /* Always assert a top-level called "config". 
      * To ensure that, deal with two cases:
      * 1. File is empty <top/> -> rename top-level to "config" 
+     *    CBOR encodes only the children of "config" and is handled the same way
      */
-    if (xml_child_nr(x0) == 0){ 
+    if (xml_child_nr(x0) == 0 || format == FORMAT_CBOR){ 
 	if (xml_name_set(x0, DATASTORE_TOP_SYMBOL) < 0)
 	    goto done;     
     }
@@ -484,6 +742,16 @@ xmldb_readfile(clicon_handle    h,
 	/* There should only be one element and called config */
 	if (singleconfigroot(x0, &x0) < 0)
 	    goto done;
+	if ((xa = xml_find_type(x0, NULL, XMLDB_SORTED_ATTR, CX_ATTR)) != NULL &&
+	    xml_purge(xa) < 0)
+	    goto done;
+	/* Content is in shard files, see CLICON_XMLDB_SHARD */
+	if ((xa = xml_find_type(x0, NULL, XMLDB_SHARDED_ATTR, CX_ATTR)) != NULL){
+	    if (xml_purge(xa) < 0)
+		goto done;
+	    if (xmldb_shard_read(dbfile, yb, yspec, x0) < 0)
+		goto done;
+	}
     }
     xml_flag_set(x0, XML_FLAG_TOP);
     if (xml_child_nr(x0) == 0 && de)
@@ -494,12 +762,37 @@ xmldb_readfile(clicon_handle    h,
      */
     if (text_read_modstate(h, yspec, x0, msdiff) < 0)
 	goto done;
+    /* Apply edits appended to the journal since the file was last written,
+     * see CLICON_XMLDB_PERSIST. Replaying requires a tree bound to yang.
+     */
+    if (xmldb_journal_exists(h, db) == 1){
+	if (yb == YB_NONE){
+	    if ((ret = xml_bind_yang(x0, YB_MODULE, yspec, NULL)) < 0)
+		goto done;
+	    if (ret == 0){
+		clicon_err(OE_DB, 0, "Cannot replay journal of %s: yang binding failed", db);
+		goto done;
+	    }
+	    if (xml_sort_recurse(x0) < 0)
+		goto done;
+	}
+	if (xmldb_journal_replay(h, db, yspec, x0, &nr) < 0)
+	    goto done;
+	if (de){
+	    de->de_journal = nr;
+	    de->de_empty = (xml_child_nr(x0) == 0);
+	}
+    }
+    else if (de)
+	de->de_journal = 0;
     if (xp){
 	*xp = x0;
 	x0 = NULL;
     }
     retval = 1;
  done:
+    if (fz)
+	fclose(fz);
     if (fp)
 	fclose(fp);
     if (dbfile)
@@ -514,6 +807,275 @@ xmldb_readfile(clicon_handle    h,
 #endif
 }
 
+/* Tree parsed from a datastore file in nocache mode, see CLICON_XMLDB_PARSE_CACHE
+ * The tree is valid as long as the file (and its shard directory) is not changed, ie as
+ * long as its inode, size and modification time are the same.
+ */
+struct parse_cache{
+    qelem_t          pc_q;      /* LRU queue, most recently used first */
+    char            *pc_file;   /* Datastore filename */
+    yang_bind        pc_yb;     /* How yang was bound when parsed */
+    yang_stmt       *pc_yspec;  /* Yang spec used when parsed */
+    dev_t            pc_dev;    /* Device of file */
+    ino_t            pc_ino;    /* Inode of file, files are replaced on write */
+    off_t            pc_size;   /* Size of file */
+    struct timespec  pc_mtim;   /* Modification time of file */
+    struct timespec  pc_dmtim;  /* Modification time of shard directory, or 0 */
+    int              pc_empty;  /* Datastore is empty, see db_elmnt */
+    cxobj           *pc_xt;     /* Parsed tree, copied on each read */
+    size_t           pc_sz;     /* Memory of parsed tree */
+};
+
+/* Parse cache shared by all datastores, bounded by CLICON_XMLDB_PARSE_CACHE */
+static struct parse_cache *_parse_cache = NULL;
+static size_t              _parse_cache_sz = 0;   /* Memory of all cached trees */
+static uint64_t            _parse_cache_hits = 0;
+static uint64_t            _parse_cache_misses = 0;
+
+/*! Remove an entry from the parse cache and free it
+ * @param[in]  pc    Parse cache entry
+ */
+static int
+parse_cache_free(struct parse_cache *pc)
+{
+    DELQ(pc, _parse_cache, struct parse_cache *);
+    _parse_cache_sz -= pc->pc_sz;
+    if (pc->pc_file)
+	free(pc->pc_file);
+    if (pc->pc_xt)
+	xml_free(pc->pc_xt);
+    free(pc);
+    return 0;
+}
+
+/*! Get file status of a datastore file as parse cache key
+ * @param[in]  dbfile  Datastore filename
+ * @param[out] key     Key fields of parse cache entry
+ * @retval     1       OK
+ * @retval     0       File does not exist
+ */
+static int
+parse_cache_key(const char         *dbfile,
+		struct parse_cache *key)
+{
+    struct stat st;
+    char       *dir = NULL;
+
+    memset(key, 0, sizeof(*key));
+    if (stat(dbfile, &st) < 0)
+	return 0;
+    key->pc_dev = st.st_dev;
+    key->pc_ino = st.st_ino;
+    key->pc_size = st.st_size;
+    key->pc_mtim = st.st_mtim;
+    /* Shard files are replaced by rename in the shard directory, see xmldb_shard_write */
+    if (xmldb_shard_dir(dbfile, &dir) == 0 && dir){
+	if (stat(dir, &st) == 0)
+	    key->pc_dmtim = st.st_mtim;
+	free(dir);
+    }
+    return 1;
+}
+
+/*! Find parse cache entry of a datastore file not changed since it was parsed
+ * @param[in]  key  Parse cache key, see parse_cache_key
+ * @retval     pc   Parse cache entry, moved first in LRU queue
+ * @retval     NULL Not found
+ */
+static struct parse_cache *
+parse_cache_find(struct parse_cache *key)
+{
+    struct parse_cache *pc;
+
+    if ((pc = _parse_cache) == NULL)
+	return NULL;
+    do {
+	if (strcmp(pc->pc_file, key->pc_file) == 0 &&
+	    pc->pc_yb == key->pc_yb &&
+	    pc->pc_yspec == key->pc_yspec &&
+	    pc->pc_dev == key->pc_dev &&
+	    pc->pc_ino == key->pc_ino &&
+	    pc->pc_size == key->pc_size &&
+	    pc->pc_mtim.tv_sec == key->pc_mtim.tv_sec &&
+	    pc->pc_mtim.tv_nsec == key->pc_mtim.tv_nsec &&
+	    pc->pc_dmtim.tv_sec == key->pc_dmtim.tv_sec &&
+	    pc->pc_dmtim.tv_nsec == key->pc_dmtim.tv_nsec){
+	    if (pc != _parse_cache){
+		DELQ(pc, _parse_cache, struct parse_cache *);
+		INSQ(pc, _parse_cache);
+	    }
+	    return pc;
+	}
+	pc = NEXTQ(struct parse_cache *, pc);
+    } while (pc != _parse_cache);
+    return NULL;
+}
+
+/*! Add a copy of a parsed tree to the parse cache, evict least recently used trees
+ * @param[in]  key  Parse cache key, see parse_cache_key
+ * @param[in]  xt   Parsed tree, copied
+ * @param[in]  max  Max memory of all cached trees
+ * @retval     0    OK, also if tree is larger than max and not added
+ * @retval    -1    Error
+ */
+static int
+parse_cache_add(struct parse_cache *key,
+		cxobj              *xt,
+		size_t              max)
+{
+    int                 retval = -1;
+    struct parse_cache *pc;
+    struct parse_cache *pcnext;
+    uint64_t            nr = 0;
+    size_t              sz = 0;
+    int                 last;
+
+    /* Trees of older versions of the same file are obsolete */
+    if ((pc = _parse_cache) != NULL)
+	do {
+	    pcnext = NEXTQ(struct parse_cache *, pc);
+	    last = (pcnext == _parse_cache);
+	    if (strcmp(pc->pc_file, key->pc_file) == 0 &&
+		parse_cache_free(pc) < 0)
+		goto done;
+	    pc = pcnext;
+	} while (!last && _parse_cache);
+    if (xml_stats(xt, &nr, &sz) < 0)
+	goto done;
+    if (sz > max)
+	goto ok;
+    while (_parse_cache && _parse_cache_sz + sz > max)
+	if (parse_cache_free(PREVQ(struct parse_cache *, _parse_cache)) < 0)
+	    goto done;
+    if ((pc = malloc(sizeof(*pc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    *pc = *key;
+    pc->pc_xt = NULL;
+    if ((pc->pc_file = strdup(key->pc_file)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	free(pc);
+	goto done;
+    }
+    if ((pc->pc_xt = xml_dup(xt)) == NULL){
+	free(pc->pc_file);
+	free(pc);
+	goto done;
+    }
+    pc->pc_sz = sz;
+    INSQ(pc, _parse_cache);
+    _parse_cache_sz += sz;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Read a datastore file, or copy its tree from the parse cache if not changed
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  yspec  Top-level yang spec
+ * @param[out] xp     XML tree read from file
+ * @param[out] de     Return db-element status (eg empty flag)
+ * @param[out] msdiff If set, return modules-state differences, the cache is then not used
+ * @retval     -1     General error, check specific clicon_errno, clicon_suberrno
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval     1      OK
+ * @see xmldb_readfile
+ */
+static int
+xmldb_readfile_cached(clicon_handle    h,
+		      const char      *db,
+		      yang_bind        yb,
+		      yang_stmt       *yspec,
+		      cxobj          **xp,
+		      db_elmnt        *de,
+		      modstate_diff_t *msdiff)
+{
+    int                 retval = -1;
+    int                 max;
+    char               *dbfile = NULL;
+    struct parse_cache  key;
+    struct parse_cache *pc;
+    int                 ret;
+
+    /* A journal is replayed on the tree when read, see CLICON_XMLDB_PERSIST */
+    if ((max = clicon_option_int(h, "CLICON_XMLDB_PARSE_CACHE")) <= 0 ||
+	msdiff != NULL ||
+	xmldb_journal_exists(h, db) == 1)
+	return xmldb_readfile(h, db, yb, yspec, xp, de, msdiff);
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+	goto done;
+    if (parse_cache_key(dbfile, &key) == 0){ /* Missing file is reported by readfile */
+	retval = xmldb_readfile(h, db, yb, yspec, xp, de, msdiff);
+	goto done;
+    }
+    key.pc_file = dbfile;
+    key.pc_yb = yb;
+    key.pc_yspec = yspec;
+    if ((pc = parse_cache_find(&key)) != NULL){
+	_parse_cache_hits++;
+	if ((*xp = xml_dup(pc->pc_xt)) == NULL)
+	    goto done;
+	de->de_empty = pc->pc_empty;
+	de->de_journal = 0;
+	retval = 1;
+	goto done;
+    }
+    _parse_cache_misses++;
+    if ((ret = xmldb_readfile(h, db, yb, yspec, xp, de, msdiff)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    key.pc_empty = de->de_empty;
+    if (parse_cache_add(&key, *xp, (size_t)max) < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (dbfile)
+	free(dbfile);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Print statistics of the parse cache of nocache mode, see CLICON_XMLDB_PARSE_CACHE
+ * @param[in]  cb   CLIgen buffer, statistics are appended
+ * @retval     0    OK
+ */
+int
+xmldb_parse_cache_stats(cbuf *cb)
+{
+    struct parse_cache *pc;
+    int                 nr = 0;
+
+    if ((pc = _parse_cache) != NULL)
+	do {
+	    nr++;
+	    pc = NEXTQ(struct parse_cache *, pc);
+	} while (pc != _parse_cache);
+    cprintf(cb, "<parse-cache><entries>%d</entries><size>%zu</size>"
+	    "<hits>%" PRIu64 "</hits><misses>%" PRIu64 "</misses></parse-cache>",
+	    nr, _parse_cache_sz, _parse_cache_hits, _parse_cache_misses);
+    return 0;
+}
+
+/*! Free all trees of the parse cache
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xmldb_parse_cache_clear(void)
+{
+    while (_parse_cache)
+	if (parse_cache_free(_parse_cache) < 0)
+	    return -1;
+    return 0;
+}
+
 /*! Get content of database using xpath. return a set of matching sub-trees
  * The function returns a minimal tree that includes all sub-trees that match
  * xpath.
@@ -556,10 +1118,17 @@ xmldb_get_nocache(clicon_handle    h,
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
 	goto done;
     }
+    /* Read from the image of the file if there is one, see CLICON_XMLDB_IMAGE */
+    if (yb != YB_NONE && msdiff == NULL){
+	if ((ret = xmldb_image_get(h, db, nsc, xpath, &xt)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto filtered;
+    }
     /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-    if ((ret = xmldb_readfile(h, db,
-			      yb==YB_MODULE?YB_MODULE_NEXT:yb,
-			      yspec, &xt, &de0, msdiff)) < 0)
+    if ((ret = xmldb_readfile_cached(h, db,
+				     yb==YB_MODULE?YB_MODULE_NEXT:yb,
+				     yspec, &xt, &de0, msdiff)) < 0)
 	goto done;
     if (ret == 0)
 	goto fail;
@@ -586,7 +1155,7 @@ xmldb_get_nocache(clicon_handle    h,
     /* reset flag */
     if (xml_apply(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)XML_FLAG_MARK) < 0)
 	goto done;
-
+ filtered:
     if (yb != YB_NONE){
 	/* Add global defaults. */
 	if (xml_global_defaults(h, xt, nsc, xpath, yspec, 0) < 0)
@@ -597,7 +1166,7 @@ xmldb_get_nocache(clicon_handle    h,
     }
     /* If empty NACM config, then disable NACM if loaded
      */
-    if (clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
+    if (clicon_optv(h)->co_nacm_disabled_on_empty){
 	if (disable_nacm_on_empty(xt, yspec) < 0)
 	    goto done;
     }
@@ -605,7 +1174,7 @@ xmldb_get_nocache(clicon_handle    h,
     if (xml_apply0(xt, -1, xml_sort_verify, NULL) < 0)
 	clicon_log(LOG_NOTICE, "%s: sort verify failed #2", __FUNCTION__);
 #endif
-    if (clicon_debug_get()>1)
+    if (clixon_debug_enabled(CLIXON_DBG_DATASTORE, 2))
     	clicon_xml2file(stderr, xt, 0, 1);
     *xtop = xt;
     xt = NULL;
@@ -625,6 +1194,111 @@ xmldb_get_nocache(clicon_handle    h,
     goto done;
 }
 
+/*! Get a page of the entries of a list selected by a simple xpath without evaluating it
+ *
+ * If the xpath is a path to all entries of a list or leaf-list, eg /a:x/a:y, the
+ * parent of the list is found using xpath of the path without the last step, and
+ * the entries of the page are found by position in the sorted children of the parent.
+ * The cost is then proportional to the page, not to the list.
+ * @param[in]  x0t    Top of (cached) tree
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPATH syntax
+ * @param[in]  offset Number of entries to skip
+ * @param[in]  limit  Max number of entries
+ * @param[out] xvecp  Vector of entries of page, free with free()
+ * @param[out] xlenp  Length of vector
+ * @retval     1      OK, xvecp and xlenp set
+ * @retval     0      Not a simple list path, evaluate xpath instead
+ * @retval    -1      Error
+ * @see clixon_xml_find_pos
+ */
+static int
+xmldb_page_list(cxobj       *x0t,
+		cvec        *nsc,
+		const char  *xpath,
+		uint32_t     offset,
+		uint32_t     limit,
+		cxobj     ***xvecp,
+		size_t      *xlenp)
+{
+    int          retval = -1;
+    char        *parent = NULL;
+    const char  *step;
+    char        *name = NULL;
+    char        *prefix = NULL;
+    char        *ns;
+    cxobj      **xvec = NULL;
+    size_t       xlen;
+    cxobj       *xp;
+    yang_stmt   *yp;
+    yang_stmt   *yc;
+    clixon_xvec *xv = NULL;
+    cxobj      **xpage = NULL;
+    size_t       n = 0;
+
+    if (xpath == NULL || (step = strrchr(xpath, '/')) == NULL ||
+	step == xpath || *(step-1) == '/')
+	goto fail;
+    step++;
+    if (*step == '\0' || strspn(step, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.:") != strlen(step))
+	goto fail;
+    if ((parent = strdup(xpath)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    parent[step-xpath-1] = '\0';
+    if (nodeid_split((char*)step, &prefix, &name) < 0)
+	goto done;
+    if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, parent) < 0)
+	goto done;
+    if (xlen != 1 || (xp = xvec[0]) == x0t || (yp = xml_spec(xp)) == NULL)
+	goto fail;
+    if ((yc = yang_find_datanode(yp, name)) == NULL ||
+	(yang_keyword_get(yc) != Y_LIST && yang_keyword_get(yc) != Y_LEAF_LIST))
+	goto fail;
+    if (prefix != NULL &&
+	((ns = xml_nsctx_get(nsc, prefix)) == NULL ||
+	 strcmp(ns, yang_find_mynamespace(yc)) != 0))
+	goto fail;
+    if ((xv = clixon_xvec_new()) == NULL)
+	goto done;
+    if (limit > xml_child_nr(xp)) /* limit may be large, eg only offset given */
+	limit = xml_child_nr(xp);
+    if ((xpage = calloc(limit+1, sizeof(cxobj *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    /* Each position is a binary search in the sorted children */
+    for (n = 0; n < limit; n++){
+	if (clixon_xml_find_pos(xp, yc, offset+n, xv) < 0)
+	    goto done;
+	if ((size_t)clixon_xvec_len(xv) == n) /* End of list */
+	    break;
+	xpage[n] = clixon_xvec_i(xv, n);
+    }
+    *xvecp = xpage;
+    *xlenp = n;
+    xpage = NULL;
+    retval = 1;
+ done:
+    if (xpage)
+	free(xpage);
+    if (xv)
+	clixon_xvec_free(xv);
+    if (xvec)
+	free(xvec);
+    if (prefix)
+	free(prefix);
+    if (name)
+	free(name);
+    if (parent)
+	free(parent);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Get content of database using xpath. return a set of matching sub-trees
  * The function returns a minimal tree that includes all sub-trees that match
  * xpath.
@@ -634,6 +1308,9 @@ xmldb_get_nocache(clicon_handle    h,
  * @param[in]  yb     How to bind yang to XML top-level when parsing
  * @param[in]  nsc    External XML namespace context, or NULL
  * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[in]  api_path Select nodes with api-path instead of xpath, or NULL
+ * @param[in]  offset Skip this number of nodes selected by xpath (if limit > 0)
+ * @param[in]  limit  Max number of nodes selected by xpath, 0 means all
  * @param[out] xret   Single return XML tree. Free with xml_free()
  * @param[out] msdiff    If set, return modules-state differences
  * @retval     -1     General error, check specific clicon_errno, clicon_suberrno
@@ -648,6 +1325,9 @@ xmldb_get_cache(clicon_handle    h,
 		yang_bind        yb,
 		cvec            *nsc,
 		const char      *xpath,
+		const char      *api_path,
+		uint32_t         offset,
+		uint32_t         limit,
 		cxobj          **xtop,
 		modstate_diff_t *msdiff)
 {
@@ -662,6 +1342,7 @@ xmldb_get_cache(clicon_handle    h,
     cxobj          *x1t = NULL;
     db_elmnt        de0 = {0,};
     int             ret;
+    int             n;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
 	clicon_err(OE_YANG, ENOENT, "No yang spec");
@@ -699,8 +1380,30 @@ xmldb_get_cache(clicon_handle    h,
      *   a) for every node that is found, copy to new tree
      *   b) if config dont dont state data
      */
-    if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+    ret = 0;
+    if (api_path){ /* Index lookup of list keys, no xpath parsing and evaluation */
+	if ((ret = clixon_xml_find_api_path(x0t, yspec, &xvec, &n, "%s", api_path)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	xlen = n;
+    }
+    else if (limit && (ret = xmldb_page_list(x0t, nsc, xpath, offset, limit, &xvec, &xlen)) < 0)
 	goto done;
+    if (ret == 0){
+	if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+	    goto done;
+	if (limit){ /* Keep the page of the nodes selected by xpath */
+	    if (offset >= xlen)
+		xlen = 0;
+	    else{
+		memmove(xvec, xvec+offset, (xlen-offset)*sizeof(cxobj *));
+		xlen -= offset;
+		if (xlen > limit)
+		    xlen = limit;
+	    }
+	}
+    }
 
     /* Make new tree by copying top-of-tree from x0t to x1t */
     if ((x1t = xml_new(xml_name(x0t), NULL, CX_ELMNT)) == NULL)
@@ -722,26 +1425,16 @@ xmldb_get_cache(clicon_handle    h,
     else {
 	/* Iterate through the match vector
 	 * For every node found in x0, mark the tree up to t1
-	 * XXX can we do this directly from xvec?
+	 * Marks are not copied to x1t and are reset from xvec, not by traversing x0t
 	 */
-	for (i=0; i<xlen; i++){
-	    x0 = xvec[i];
-	    xml_flag_set(x0, XML_FLAG_MARK);
-	    xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-	}
-	if (xml_copy_marked(x0t, x1t) < 0) /* config */
-	    goto done;
-	if (xml_apply(x0t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
-	    goto done;
-	if (xml_apply(x1t, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
+	xml_copy_mark(xvec, xlen);
+	ret = xml_copy_marked(x0t, x1t);
+	xml_copy_mark_reset(xvec, xlen);
+	if (ret < 0)
 	    goto done;
     }
-    /* Remove global defaults from cache 
-     * Mark non-presence containers as XML_FLAG_DEFAULT */
-    if (xml_apply(x0t, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_DEFAULT) < 0)
-	goto done;
-    /* Clear XML tree of defaults */
-    if (xml_tree_prune_flagged(x0t, XML_FLAG_DEFAULT, 1) < 0)
+    /* Remove defaults left in cache by a zero-copy read, otherwise the cache has none */
+    if (xmldb_cache_defaults_clear(h, db) < 0)
 	goto done;
     if (yb != YB_NONE){
 	/* Add default global values */
@@ -753,19 +1446,19 @@ xmldb_get_cache(clicon_handle    h,
     }
     /* If empty NACM config, then disable NACM if loaded
      */
-    if (clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
+    if (clicon_optv(h)->co_nacm_disabled_on_empty){
 	if (disable_nacm_on_empty(x1t, yspec) < 0)
 	    goto done;
     }
     /* Copy the matching parts of the (relevant) XML tree.
      * If cache was empty, also update to datastore cache
      */
-    if (clicon_debug_get()>1)
+    if (clixon_debug_enabled(CLIXON_DBG_DATASTORE, 2))
     	clicon_xml2file(stderr, x1t, 0, 1);
     *xtop = x1t;
     retval = 1;
  done:
-    clicon_debug(2, "%s retval:%d", __FUNCTION__, retval);
+    clixon_debug(CLIXON_DBG_DATASTORE, 2, "%s retval:%d", __FUNCTION__, retval);
     if (xvec)
 	free(xvec);
     return retval;
@@ -804,8 +1497,6 @@ xmldb_get_zerocopy(clicon_handle    h,
     cxobj          *x0t = NULL; /* (cached) top of tree */
     cxobj         **xvec = NULL;
     size_t          xlen;
-    int             i;
-    cxobj          *x0;
     db_elmnt       *de = NULL;
     db_elmnt        de0 = {0,};
     int             ret;
@@ -830,8 +1521,13 @@ xmldb_get_zerocopy(clicon_handle    h,
 	de0.de_xml = x0t;
 	clicon_db_elmnt_set(h, db, &de0);
     } /* x0t == NULL */
-    else
+    else{
+	/* Defaults and flags are added below, copy a tree shared with another database
+	 * or pinned by a read snapshot */
+	if (xmldb_cache_unshare(h, db) < 0)
+	    goto done;
 	x0t = de->de_xml;
+    }
 
     /* Here xt looks like: <config>...</config> */
     if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
@@ -839,11 +1535,11 @@ xmldb_get_zerocopy(clicon_handle    h,
     /* Iterate through the match vector
      * For every node found in x0, mark the tree up to t1
      */
-    for (i=0; i<xlen; i++){
-	x0 = xvec[i];
-	xml_flag_set(x0, XML_FLAG_MARK);
-	xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-    }
+    xml_copy_mark(xvec, xlen);
+    /* Defaults may be added to the cache, by this function or by caller.
+     * Removed by xmldb_get0_clear, and by xmldb_get_cache if not cleared */
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de->de_defaults = 1;
     if (yb != YB_NONE){
 	/* Add global defaults. */
 	if (xml_global_defaults(h, x0t, nsc, xpath, yspec, 0) < 0)
@@ -854,16 +1550,16 @@ xmldb_get_zerocopy(clicon_handle    h,
     }
     /* If empty NACM config, then disable NACM if loaded
      */
-    if (clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY")){
+    if (clicon_optv(h)->co_nacm_disabled_on_empty){
 	if (disable_nacm_on_empty(x0t, yspec) < 0)
 	    goto done;
     }
-    if (clicon_debug_get()>1)
+    if (clixon_debug_enabled(CLIXON_DBG_DATASTORE, 2))
     	clicon_xml2file(stderr, x0t, 0, 1);
     *xtop = x0t;
     retval = 1;
  done:
-    clicon_debug(2, "%s retval:%d", __FUNCTION__, retval);
+    clixon_debug(CLIXON_DBG_DATASTORE, 2, "%s retval:%d", __FUNCTION__, retval);
     if (xvec)
 	free(xvec);
     return retval;
@@ -978,12 +1674,170 @@ xmldb_get0(clicon_handle    h,
 	 * Add default values in copy, return copy
 	 * Copy deleted by xmldb_free
 	 */
-	retval = xmldb_get_cache(h, db, yb, nsc, xpath, xret, msdiff);
+	retval = xmldb_get_cache(h, db, yb, nsc, xpath, NULL, 0, 0, xret, msdiff);
 	break;
     }
     return retval;
 }
 
+/*! Get the whole content of a database as a tree owned by caller, without copy or cache
+ *
+ * For one-time reads of large datastores, eg startup, where only one copy should be
+ * held. If the datastore is cached, the tree is moved out of the cache instead of
+ * copied. Otherwise the file is read without filling the cache. Either way the cache
+ * of the datastore is empty after the call and the next read is made from file.
+ * The tree is not bound to YANG and has no default values (as YB_NONE).
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Name of datastore, eg "startup"
+ * @param[out] xret   Top of XML tree. Free with xml_free()
+ * @param[out] msdiff If set, return modules-state differences (only if read from file)
+ * @retval     -1     General error, check specific clicon_errno, clicon_suberrno
+ * @retval     0      Parse OK but yang assigment not made (or only partial)
+ * @retval     1      OK
+ * @note A cache tree shared with another datastore or a read snapshot is copied
+ * @see xmldb_get0
+ */
+int
+xmldb_get_detach(clicon_handle    h,
+		 const char      *db,
+		 cxobj          **xret,
+		 modstate_diff_t *msdiff)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    db_elmnt  *de;
+    db_elmnt   de0 = {0,};
+    cxobj     *xt = NULL;
+    int        ret;
+
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "No yang spec");
+	goto done;
+    }
+    if (clicon_datastore_cache(h) != DATASTORE_NOCACHE &&
+	(de = clicon_db_elmnt_get(h, db)) != NULL &&
+	de->de_xml != NULL){
+	/* Copy-on-write if shared, then the tree is only referred to by the cache */
+	if (xmldb_cache_unshare(h, db) < 0)
+	    goto done;
+	xt = de->de_xml;
+	de->de_xml = NULL;
+	/* Remove defaults left in cache by a zero-copy read */
+	if (de->de_defaults){
+	    if (xmldb_get0_clear(h, xt) < 0)
+		goto done;
+	    de->de_defaults = 0;
+	}
+    }
+    else {
+	if ((ret = xmldb_readfile(h, db, YB_NONE, yspec, &xt,
+				  (de = clicon_db_elmnt_get(h, db))?de:&de0,
+				  msdiff)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	if (de == NULL)
+	    clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
+    }
+    *xret = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (xt)
+	xml_free(xt);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get a page of the nodes selected by xpath and return a copy of the XML tree
+ *
+ * Same as xmldb_get but only the nodes selected by xpath with position offset to
+ * offset+limit-1 in document order are returned, with their ancestors.
+ * If the datastore is cached and xpath selects all entries of a list, eg /a:x/a:y,
+ * the page is found directly in the sorted cache, and the cost is proportional to the
+ * page, not to the list.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Name of datastore, eg "running"
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[in]  offset Number of selected nodes to skip
+ * @param[in]  limit  Max number of selected nodes, 0 means all (no paging)
+ * @param[out] xret   Single return XML tree. Free with xml_free()
+ * @retval     -1     General error, check specific clicon_errno, clicon_suberrno
+ * @retval     0      Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval     1      OK
+ * @see xmldb_get
+ */
+int
+xmldb_get_page(clicon_handle h,
+	       const char   *db,
+	       cvec         *nsc,
+	       char         *xpath,
+	       uint32_t      offset,
+	       uint32_t      limit,
+	       cxobj       **xret)
+{
+    int     retval = -1;
+    cxobj  *xt = NULL;
+    cxobj **xvec = NULL;
+    size_t  xlen;
+    int     i;
+
+    if (clicon_datastore_cache(h) != DATASTORE_NOCACHE)
+	return xmldb_get_cache(h, db, YB_MODULE, nsc, xpath, NULL, offset, limit, xret, NULL);
+    if ((retval = xmldb_get_nocache(h, db, YB_MODULE, nsc, xpath, &xt, NULL)) < 1)
+	goto done;
+    /* Remove the nodes before and after the page. In reverse document order, so that
+     * descendants are removed before ancestors */
+    if (limit){
+	retval = -1;
+	if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
+	    goto done;
+	for (i = xlen-1; i >= 0; i--)
+	    if ((size_t)i < offset || (size_t)i >= (size_t)offset + limit)
+		if (xml_purge(xvec[i]) < 0)
+		    goto done;
+	retval = 1;
+    }
+    *xret = xt;
+    xt = NULL;
+ done:
+    if (xvec)
+	free(xvec);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Get the nodes selected by a RESTCONF api-path and return a copy of the XML tree
+ *
+ * Same as xmldb_get but the nodes are selected with an api-path, which is parsed to a
+ * clixon-path and resolved with index lookups of list keys in the sorted cache, see
+ * clixon_xml_find_api_path, instead of parsing and evaluating an xpath.
+ * @param[in]  h        Clicon handle
+ * @param[in]  db       Name of datastore, eg "running"
+ * @param[in]  api_path According to restconf (Sec 3.5.3.1 in rfc8040), eg /a:x/y=1
+ * @param[out] xret     Single return XML tree. Free with xml_free()
+ * @retval     -1       General error, check specific clicon_errno, clicon_suberrno
+ * @retval     0        Not done: api-path does not resolve to yang, or datastore is not 
+ *                      cached. Use xmldb_get with the corresponding xpath instead
+ * @retval     1        OK
+ * @see xmldb_get
+ * @see api_path2xpath
+ */
+int
+xmldb_get_api_path(clicon_handle h,
+		   const char   *db,
+		   char         *api_path,
+		   cxobj       **xret)
+{
+    if (clicon_datastore_cache(h) == DATASTORE_NOCACHE)
+	return 0;
+    return xmldb_get_cache(h, db, YB_MODULE, NULL, NULL, api_path, 0, 0, xret, NULL);
+}
+
 /*! Clear cached xml tree obtained with xmldb_get0, if zerocopy
  *
  * @param[in]  h    Clicon handle
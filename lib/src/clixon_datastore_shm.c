@@ -0,0 +1,1030 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Export of a datastore to a read-only image in shared memory
+ * @see clixon_datastore_shm.h for the layout
+ * @see clixon_client_shm_open for the reader
+ * Also images of datastore files, which are mapped to read a datastore in nocache mode
+ * @see xmldb_image_get
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <syslog.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_yang_module.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_sort.h"
+#include "clixon_datastore.h"
+#include "clixon_datastore_shm.h"
+
+/* Image under construction */
+struct shm_build{
+    cxobj                 **sb_xvec;    /* XML node of each image node */
+    struct xmldb_shm_node  *sb_nodes;   /* Image nodes */
+    size_t                  sb_nlen;    /* Number of nodes */
+    size_t                  sb_nmax;    /* Allocated nodes */
+    char                   *sb_str;     /* String table */
+    size_t                  sb_slen;    /* Used length of string table */
+    size_t                  sb_smax;    /* Allocated length of string table */
+    clicon_hash_t          *sb_names;   /* Offsets of names, names are shared */
+};
+
+/* Child of a node with its key, for sorting */
+struct shm_child{
+    cxobj *sc_x;
+    char  *sc_name;
+    char  *sc_key;
+};
+
+/*! Add a string to the string table
+ * @param[in]  sb    Image under construction
+ * @param[in]  str   String
+ * @param[out] off   Offset of string
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+shm_string(struct shm_build *sb,
+	   const char       *str,
+	   uint32_t         *off)
+{
+    size_t len;
+    size_t n;
+    char  *s;
+
+    if (str == NULL || *str == '\0'){
+	*off = 0;
+	return 0;
+    }
+    len = strlen(str) + 1;
+    if (sb->sb_slen + len > sb->sb_smax){
+	n = sb->sb_smax ? sb->sb_smax*2 : 4096;
+	while (n < sb->sb_slen + len)
+	    n *= 2;
+	if ((s = realloc(sb->sb_str, n)) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	sb->sb_str = s;
+	sb->sb_smax = n;
+    }
+    if (sb->sb_slen + len > UINT32_MAX){
+	clicon_err(OE_XML, EFBIG, "Datastore image string table too large");
+	return -1;
+    }
+    memcpy(sb->sb_str + sb->sb_slen, str, len);
+    *off = (uint32_t)sb->sb_slen;
+    sb->sb_slen += len;
+    return 0;
+}
+
+/*! Add a name to the string table, once for each distinct name
+ */
+static int
+shm_name(struct shm_build *sb,
+	 const char       *name,
+	 uint32_t         *off)
+{
+    void *p;
+
+    if ((p = clicon_hash_value(sb->sb_names, name, NULL)) != NULL){
+	*off = *(uint32_t*)p;
+	return 0;
+    }
+    if (shm_string(sb, name, off) < 0)
+	return -1;
+    if (clicon_hash_add(sb->sb_names, name, off, sizeof(*off)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Add a node to the image, children are added later
+ */
+static int
+shm_node_add(struct shm_build *sb,
+	     cxobj            *x,
+	     char             *key)
+{
+    struct xmldb_shm_node *sn;
+    size_t                 n;
+    void                  *p;
+
+    if (sb->sb_nlen == sb->sb_nmax){
+	n = sb->sb_nmax ? sb->sb_nmax*2 : 1024;
+	if ((p = realloc(sb->sb_nodes, n*sizeof(*sb->sb_nodes))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	sb->sb_nodes = p;
+	if ((p = realloc(sb->sb_xvec, n*sizeof(*sb->sb_xvec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	sb->sb_xvec = p;
+	sb->sb_nmax = n;
+    }
+    sn = &sb->sb_nodes[sb->sb_nlen];
+    memset(sn, 0, sizeof(*sn));
+    if (shm_name(sb, xml_name(x), &sn->sn_name) < 0)
+	return -1;
+    if (shm_string(sb, key, &sn->sn_key) < 0)
+	return -1;
+    if (shm_string(sb, xml_body(x), &sn->sn_body) < 0)
+	return -1;
+    sb->sb_xvec[sb->sb_nlen++] = x;
+    return 0;
+}
+
+/*! Compare children on name and key, the order of the image
+ */
+static int
+shm_child_cmp(const void *a,
+	      const void *b)
+{
+    const struct shm_child *ca = a;
+    const struct shm_child *cb = b;
+    int                     eq;
+
+    if ((eq = strcmp(ca->sc_name, cb->sc_name)) != 0)
+	return eq;
+    return strcmp(ca->sc_key, cb->sc_key);
+}
+
+/*! Get key of a node: key values of a list entry or value of a leaf-list entry
+ * @param[in]  x    XML node
+ * @param[in]  cb   Buffer
+ * @retval     key  Key string, valid until cb is changed
+ */
+static char *
+shm_key(cxobj *x,
+	cbuf  *cb)
+{
+    yang_stmt *y;
+    cvec      *cvk;
+    cg_var    *cvi = NULL;
+    char      *body;
+
+    cbuf_reset(cb);
+    if ((y = xml_spec(x)) != NULL){
+	if (yang_keyword_get(y) == Y_LIST && (cvk = yang_cvec_get(y)) != NULL){
+	    while ((cvi = cvec_each(cvk, cvi)) != NULL){
+		if (cbuf_len(cb))
+		    cprintf(cb, "%c", XMLDB_SHM_KEYSEP);
+		if ((body = xml_find_body(x, cv_string_get(cvi))) != NULL)
+		    cprintf(cb, "%s", body);
+	    }
+	}
+	else if (yang_keyword_get(y) == Y_LEAF_LIST &&
+		 (body = xml_body(x)) != NULL)
+	    cprintf(cb, "%s", body);
+    }
+    return cbuf_get(cb);
+}
+
+/*! Build image of a tree in breadth-first order
+ */
+static int
+shm_build(struct shm_build *sb,
+	  cxobj            *xt)
+{
+    int               retval = -1;
+    cbuf             *cb = NULL;
+    struct shm_child *cvec0 = NULL;
+    int               clen;
+    size_t            i;
+    int               j;
+    cxobj            *x;
+    cxobj            *xc;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (shm_node_add(sb, xt, NULL) < 0)
+	goto done;
+    for (i=0; i<sb->sb_nlen; i++){
+	x = sb->sb_xvec[i];
+	if ((clen = xml_child_nr_type(x, CX_ELMNT)) == 0)
+	    continue;
+	if ((cvec0 = calloc(clen, sizeof(*cvec0))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+	j = 0;
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL && j < clen){
+	    cvec0[j].sc_x = xc;
+	    cvec0[j].sc_name = xml_name(xc);
+	    if ((cvec0[j].sc_key = strdup(shm_key(xc, cb))) == NULL){
+		clicon_err(OE_UNIX, errno, "strdup");
+		goto done;
+	    }
+	    j++;
+	}
+	qsort(cvec0, clen, sizeof(*cvec0), shm_child_cmp);
+	sb->sb_nodes[i].sn_child = sb->sb_nlen;
+	sb->sb_nodes[i].sn_nchild = clen;
+	for (j=0; j<clen; j++)
+	    if (shm_node_add(sb, cvec0[j].sc_x, cvec0[j].sc_key) < 0)
+		goto done;
+	for (j=0; j<clen; j++)
+	    free(cvec0[j].sc_key);
+	free(cvec0);
+	cvec0 = NULL;
+    }
+    retval = 0;
+ done:
+    if (cvec0){
+	for (j=0; j<clen; j++)
+	    if (cvec0[j].sc_key)
+		free(cvec0[j].sc_key);
+	free(cvec0);
+    }
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Modification time of a file in ns, to check that a file image is of the file
+ */
+static uint64_t
+shm_mtime(struct stat *st)
+{
+    return (uint64_t)st->st_mtim.tv_sec*1000000000 + st->st_mtim.tv_nsec;
+}
+
+/*! Write image to a temporary file and replace the current image
+ * @param[in]  path  File name of image
+ * @param[in]  sb    Image
+ * @param[in]  gen   Generation of datastore
+ * @param[in]  src   Datastore file of a file image, or NULL
+ */
+static int
+shm_write(const char       *path,
+	  struct shm_build *sb,
+	  uint64_t          gen,
+	  struct stat      *src)
+{
+    int                     retval = -1;
+    char                    tmp[MAXPATHLEN];
+    int                     fd = -1;
+    int                     fdold = -1;
+    struct xmldb_shm_header sh = {0,};
+    uint32_t                obsolete = 1;
+    size_t                  nsize;
+
+    snprintf(tmp, sizeof(tmp), "%s.%u", path, getpid());
+    nsize = sb->sb_nlen*sizeof(struct xmldb_shm_node);
+    sh.sh_magic = XMLDB_SHM_MAGIC;
+    sh.sh_version = XMLDB_SHM_VERSION;
+    sh.sh_nodes = sb->sb_nlen;
+    sh.sh_generation = gen;
+    sh.sh_strings = sizeof(sh) + nsize;
+    sh.sh_size = sh.sh_strings + sb->sb_slen;
+    if (src){
+	sh.sh_src_ino = src->st_ino;
+	sh.sh_src_size = src->st_size;
+	sh.sh_src_mtime = shm_mtime(src);
+    }
+    if ((fd = open(tmp, O_CREAT|O_TRUNC|O_WRONLY, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s)", tmp);
+	goto done;
+    }
+    if (write(fd, &sh, sizeof(sh)) != sizeof(sh) ||
+	write(fd, sb->sb_nodes, nsize) != (ssize_t)nsize ||
+	write(fd, sb->sb_str, sb->sb_slen) != (ssize_t)sb->sb_slen){
+	clicon_err(OE_UNIX, errno, "write(%s)", tmp);
+	unlink(tmp);
+	goto done;
+    }
+    /* Old image is marked obsolete after the new is in place */
+    fdold = open(path, O_WRONLY);
+    if (rename(tmp, path) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s)", path);
+	unlink(tmp);
+	goto done;
+    }
+    if (fdold != -1 &&
+	pwrite(fdold, &obsolete, sizeof(obsolete),
+	       offsetof(struct xmldb_shm_header, sh_obsolete)) < 0){
+	clicon_err(OE_UNIX, errno, "pwrite(%s)", path);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+	close(fd);
+    if (fdold != -1)
+	close(fdold);
+    return retval;
+}
+
+/*! Export a datastore to a read-only image for local readers, if enabled
+ *
+ * The image is written to the file given by CLICON_XMLDB_SHM, eg in /dev/shm.
+ * Call after each change of the datastore, eg after commit.
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Name of datastore, eg "running"
+ * @retval     0     OK, or not enabled
+ * @retval    -1     Error
+ * @see clixon_client_shm_open  Reader
+ */
+int
+xmldb_shm_export(clicon_handle h,
+		 const char   *db)
+{
+    int               retval = -1;
+    char             *path;
+    xmldb_snapshot   *sn = NULL;
+    struct shm_build  sb = {0,};
+    int               ret;
+
+    if ((path = clicon_option_str(h, "CLICON_XMLDB_SHM")) == NULL || *path == '\0')
+	return 0;
+    if ((ret = xmldb_snapshot_get(h, db, &sn)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_DB, 0, "Datastore %s could not be read", db);
+	goto done;
+    }
+    if ((sb.sb_names = clicon_hash_init()) == NULL)
+	goto done;
+    if (shm_build(&sb, xmldb_snapshot_xml(sn)) < 0)
+	goto done;
+    if (shm_write(path, &sb, xmldb_snapshot_generation(sn), NULL) < 0)
+	goto done;
+    clicon_debug(1, "%s %s nodes:%zu strings:%zu", __FUNCTION__, db, sb.sb_nlen, sb.sb_slen);
+    retval = 0;
+ done:
+    if (sn)
+	xmldb_snapshot_release(h, sn);
+    if (sb.sb_names)
+	clicon_hash_free(sb.sb_names);
+    if (sb.sb_nodes)
+	free(sb.sb_nodes);
+    if (sb.sb_xvec)
+	free(sb.sb_xvec);
+    if (sb.sb_str)
+	free(sb.sb_str);
+    return retval;
+}
+
+/*! Write an image of a datastore file next to it, if enabled
+ *
+ * The image is written to <dbfile>.img if CLICON_XMLDB_IMAGE is set and the datastore
+ * is not cached. Call after the datastore file has been written.
+ * @param[in]  h      Clicon handle
+ * @param[in]  dbfile Datastore file
+ * @param[in]  xt     Tree written to the file, bound to yang
+ * @retval     0      OK, or not enabled
+ * @retval    -1      Error
+ * @see xmldb_image_get
+ */
+int
+xmldb_image_write(clicon_handle h,
+		  const char   *dbfile,
+		  cxobj        *xt)
+{
+    int               retval = -1;
+    char              path[MAXPATHLEN];
+    struct stat       st;
+    struct shm_build  sb = {0,};
+    cxobj            *x = NULL;
+
+    if (clicon_datastore_cache(h) != DATASTORE_NOCACHE ||
+	!clicon_option_bool(h, "CLICON_XMLDB_IMAGE"))
+	return 0;
+    snprintf(path, sizeof(path), "%s.img", dbfile);
+    /* Keys of list entries are only known if bound to yang */
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+	if (xml_spec(x) == NULL){
+	    unlink(path);
+	    return 0;
+	}
+    if (stat(dbfile, &st) < 0){
+	clicon_err(OE_UNIX, errno, "stat(%s)", dbfile);
+	goto done;
+    }
+    if ((sb.sb_names = clicon_hash_init()) == NULL)
+	goto done;
+    if (shm_build(&sb, xt) < 0)
+	goto done;
+    if (shm_write(path, &sb, 0, &st) < 0)
+	goto done;
+    clicon_debug(1, "%s %s nodes:%zu strings:%zu", __FUNCTION__, path, sb.sb_nlen, sb.sb_slen);
+    retval = 0;
+ done:
+    if (sb.sb_names)
+	clicon_hash_free(sb.sb_names);
+    if (sb.sb_nodes)
+	free(sb.sb_nodes);
+    if (sb.sb_xvec)
+	free(sb.sb_xvec);
+    if (sb.sb_str)
+	free(sb.sb_str);
+    return retval;
+}
+
+/* Mapped file image being read */
+struct image_read{
+    struct xmldb_shm_header *ir_sh;     /* Mapped image */
+    struct xmldb_shm_node   *ir_nodes;  /* Node array */
+    char                    *ir_str;    /* String table */
+};
+
+/* Node of image with the XML node it is copied to */
+struct image_match{
+    uint32_t im_node;
+    cxobj   *im_x;
+};
+
+/*! Find yang of a child node, with namespace if given
+ * @param[in]  yspec  Yang spec
+ * @param[in]  yp     Yang of parent, or NULL if top-level
+ * @param[in]  name   Name of child
+ * @param[in]  ns     Namespace of child, or NULL if not known
+ * @retval     y      Yang of child
+ * @retval     NULL   Not found or ambiguous
+ */
+static yang_stmt *
+image_yang(yang_stmt *yspec,
+	   yang_stmt *yp,
+	   char      *name,
+	   char      *ns)
+{
+    yang_stmt *ymod = NULL;
+    yang_stmt *y = NULL;
+    yang_stmt *yc;
+
+    if (yp != NULL)
+	y = yang_find_datanode(yp, name);
+    else if (ns != NULL){
+	if ((ymod = yang_find_module_by_namespace(yspec, ns)) != NULL)
+	    y = yang_find_datanode(ymod, name);
+    }
+    else
+	while ((ymod = yn_each(yspec, ymod)) != NULL){
+	    if (yang_keyword_get(ymod) != Y_MODULE ||
+		(yc = yang_find_datanode(ymod, name)) == NULL)
+		continue;
+	    if (y != NULL)
+		return NULL; /* Ambiguous */
+	    y = yc;
+	}
+    if (y && ns && strcmp(yang_find_mynamespace(y), ns) != 0)
+	return NULL;
+    return y;
+}
+
+/*! Create XML node of an image node
+ * @param[in]  ir     Image
+ * @param[in]  sn     Image node
+ * @param[in]  y      Yang of node
+ * @param[in]  xp     XML parent
+ * @retval     x      XML node
+ * @retval     NULL   Error
+ */
+static cxobj *
+image_node_xml(struct image_read     *ir,
+	       struct xmldb_shm_node *sn,
+	       yang_stmt             *y,
+	       cxobj                 *xp)
+{
+    cxobj     *x;
+    cxobj     *xb;
+    yang_stmt *yp;
+    char      *ns;
+
+    if ((x = xml_new(ir->ir_str + sn->sn_name, xp, CX_ELMNT)) == NULL)
+	return NULL;
+    xml_spec_set(x, y);
+    ns = yang_find_mynamespace(y);
+    if ((yp = xml_spec(xp)) == NULL || strcmp(yang_find_mynamespace(yp), ns) != 0)
+	if (xmlns_set(x, NULL, ns) < 0)
+	    return NULL;
+    if (sn->sn_body){
+	if ((xb = xml_new("body", x, CX_BODY)) == NULL)
+	    return NULL;
+	if (xml_value_set(xb, ir->ir_str + sn->sn_body) < 0)
+	    return NULL;
+    }
+    return x;
+}
+
+/*! Copy the children of an image node recursively to XML
+ * @param[in]  ir     Image
+ * @param[in]  sn     Image node
+ * @param[in]  x      XML node of image node, bound to yang
+ * @param[in]  keys   Only copy key leaves of a list entry
+ * @retval     1      OK
+ * @retval     0      Node without yang, eg anydata content
+ * @retval    -1      Error
+ */
+static int
+image_copy(struct image_read     *ir,
+	   struct xmldb_shm_node *sn,
+	   cxobj                 *x,
+	   int                    keys)
+{
+    struct xmldb_shm_node *sc;
+    yang_stmt             *yc;
+    cxobj                 *xc;
+    uint32_t               i;
+    int                    ret;
+
+    if (sn->sn_child + sn->sn_nchild > ir->ir_sh->sh_nodes)
+	return 0;
+    if (keys && yang_keyword_get(xml_spec(x)) != Y_LIST)
+	return 1;
+    for (i=0; i<sn->sn_nchild; i++){
+	sc = &ir->ir_nodes[sn->sn_child + i];
+	if (keys && !yang_key_match(xml_spec(x), ir->ir_str + sc->sn_name))
+	    continue;
+	if ((yc = yang_find_datanode(xml_spec(x), ir->ir_str + sc->sn_name)) == NULL)
+	    return 0;
+	if ((xc = image_node_xml(ir, sc, yc, x)) == NULL)
+	    return -1;
+	if (!keys && (ret = image_copy(ir, sc, xc, 0)) != 1)
+	    return ret;
+    }
+    return 1;
+}
+
+/*! Parse a step of a simple xpath: /prefix:name[prefix:key='value']...
+ * @param[in,out] pp     Position in xpath, after the step on return
+ * @param[in]     nsc    Namespace context
+ * @param[out]    name   Name of step, free with free()
+ * @param[out]    ns     Namespace of step, or NULL if no prefix and no default namespace
+ * @param[out]    preds  Predicates as name/value pairs, free with cvec_free()
+ * @retval        1      OK
+ * @retval        0      Not a simple step
+ * @retval       -1      Error
+ */
+static int
+image_step(const char **pp,
+	   cvec        *nsc,
+	   char       **name,
+	   char       **ns,
+	   cvec       **preds)
+{
+    const char *p = *pp;
+    const char *s;
+    const char *c;
+    char       *prefix = NULL;
+    char       *kname = NULL;
+    cg_var     *cv;
+    char        q;
+    int         retval = -1;
+
+    *name = NULL;
+    *preds = NULL;
+    s = ++p; /* skip '/' */
+    p += strspn(p, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.:");
+    if (p == s || (*p && *p != '/' && *p != '['))
+	goto fail;
+    if ((c = memchr(s, ':', p-s)) != NULL){
+	if ((prefix = strndup(s, c-s)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	if (nsc == NULL || (*ns = xml_nsctx_get(nsc, prefix)) == NULL)
+	    goto fail;
+	s = c + 1;
+    }
+    else
+	*ns = nsc ? xml_nsctx_get(nsc, NULL) : NULL;
+    if (p == s || (*name = strndup(s, p-s)) == NULL){
+	if (p != s)
+	    clicon_err(OE_UNIX, errno, "strndup");
+	goto fail;
+    }
+    if ((*preds = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    while (*p == '['){
+	s = ++p;
+	p += strspn(p, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_.:");
+	if (p == s || *p != '=')
+	    goto fail;
+	if ((c = memchr(s, ':', p-s)) != NULL)
+	    s = c + 1;
+	if ((kname = strndup(s, p-s)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	if ((q = *++p) != '\'' && q != '"')
+	    goto fail;
+	s = ++p;
+	while (*p && *p != q)
+	    p++;
+	if (*p != q || *(p+1) != ']')
+	    goto fail;
+	if ((cv = cvec_add(*preds, CGV_STRING)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_add");
+	    goto done;
+	}
+	cv_name_set(cv, kname);
+	free(kname);
+	if ((kname = strndup(s, p-s)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	if (cv_string_set(cv, kname) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv_string_set");
+	    goto done;
+	}
+	free(kname);
+	kname = NULL;
+	p += 2;
+    }
+    if (*p && *p != '/')
+	goto fail;
+    *pp = p;
+    retval = 1;
+ done:
+    if (prefix)
+	free(prefix);
+    if (kname)
+	free(kname);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Find the key of a list or leaf-list entry from the predicates of a step
+ * @param[in]  y      Yang of step
+ * @param[in]  preds  Predicates
+ * @param[in]  cb     Buffer for key, see shm_key
+ * @retval     1      OK, key in cb, empty if no predicates
+ * @retval     0      Predicates are not exactly the key
+ */
+static int
+image_step_key(yang_stmt *y,
+	       cvec      *preds,
+	       cbuf      *cb)
+{
+    cvec   *cvk;
+    cg_var *cvi = NULL;
+    cg_var *cv;
+
+    cbuf_reset(cb);
+    if (cvec_len(preds) == 0)
+	return 1;
+    if (yang_keyword_get(y) == Y_LEAF_LIST){
+	if (cvec_len(preds) != 1 ||
+	    strcmp(cv_name_get(cvec_i(preds, 0)), ".") != 0)
+	    return 0;
+	cprintf(cb, "%s", cv_string_get(cvec_i(preds, 0)));
+	return 1;
+    }
+    if (yang_keyword_get(y) != Y_LIST ||
+	(cvk = yang_cvec_get(y)) == NULL ||
+	cvec_len(cvk) != cvec_len(preds))
+	return 0;
+    while ((cvi = cvec_each(cvk, cvi)) != NULL){
+	if ((cv = cvec_find(preds, cv_string_get(cvi))) == NULL)
+	    return 0;
+	if (cbuf_len(cb))
+	    cprintf(cb, "%c", XMLDB_SHM_KEYSEP);
+	cprintf(cb, "%s", cv_string_get(cv));
+    }
+    return 1;
+}
+
+/*! Append the children of an image node matching a step
+ * Children are sorted on name and key, so matches are found with binary search
+ * @param[in]  ir     Image
+ * @param[in]  im     Parent
+ * @param[in]  y      Yang of step
+ * @param[in]  key    Key of list or leaf-list entry, or "" for all with name
+ * @param[in]  last   Last step: copy the complete subtree, otherwise list keys only
+ * @param[out] vec    Vector of matches
+ * @param[out] len    Length of vector
+ * @retval     1      OK
+ * @retval     0      Content without yang
+ * @retval    -1      Error
+ */
+static int
+image_step_match(struct image_read   *ir,
+		 struct image_match  *im,
+		 yang_stmt           *y,
+		 char                *key,
+		 int                  last,
+		 struct image_match **vec,
+		 size_t              *len)
+{
+    struct xmldb_shm_node *sp = &ir->ir_nodes[im->im_node];
+    struct xmldb_shm_node *sc;
+    char                  *name = yang_argument_get(y);
+    uint32_t               lo = sp->sn_child;
+    uint32_t               hi = sp->sn_child + sp->sn_nchild;
+    uint32_t               mid;
+    int                    eq;
+    cxobj                 *x;
+    void                  *p;
+    int                    ret;
+
+    if (hi > ir->ir_sh->sh_nodes)
+	return 0;
+    /* First child with name, and key if given */
+    while (lo < hi){
+	mid = lo + (hi - lo)/2;
+	if ((eq = strcmp(ir->ir_str + ir->ir_nodes[mid].sn_name, name)) == 0 && *key)
+	    eq = strcmp(ir->ir_str + ir->ir_nodes[mid].sn_key, key);
+	if (eq < 0)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    hi = sp->sn_child + sp->sn_nchild;
+    for (; lo < hi; lo++){
+	sc = &ir->ir_nodes[lo];
+	if (strcmp(ir->ir_str + sc->sn_name, name) != 0 ||
+	    (*key && strcmp(ir->ir_str + sc->sn_key, key) != 0))
+	    break;
+	if ((x = image_node_xml(ir, sc, y, im->im_x)) == NULL)
+	    return -1;
+	if ((ret = image_copy(ir, sc, x, !last)) != 1)
+	    return ret;
+	if ((p = realloc(*vec, (*len+1)*sizeof(**vec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	*vec = p;
+	(*vec)[*len].im_node = lo;
+	(*vec)[*len].im_x = x;
+	(*len)++;
+    }
+    return 1;
+}
+
+/*! Map the image of a datastore file if it is of the current file
+ * @param[in]  dbfile  Datastore file
+ * @param[out] ir      Mapped image
+ * @param[out] size    Size of mapping
+ * @retval     1       OK
+ * @retval     0       No valid image of the current file
+ * @retval    -1       Error
+ */
+static int
+image_map(const char        *dbfile,
+	  struct image_read *ir,
+	  size_t            *size)
+{
+    int                      retval = -1;
+    char                     path[MAXPATHLEN];
+    struct stat              st;
+    struct stat              sti;
+    struct xmldb_shm_header *sh;
+    void                    *p;
+    int                      fd = -1;
+
+    snprintf(path, sizeof(path), "%s.img", dbfile);
+    if (stat(dbfile, &st) < 0 ||
+	(fd = open(path, O_RDONLY)) < 0)
+	goto fail;
+    if (fstat(fd, &sti) < 0){
+	clicon_err(OE_UNIX, errno, "fstat(%s)", path);
+	goto done;
+    }
+    if (sti.st_size < (off_t)sizeof(*sh))
+	goto fail;
+    if ((p = mmap(NULL, sti.st_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED){
+	clicon_err(OE_UNIX, errno, "mmap(%s)", path);
+	goto done;
+    }
+    sh = (struct xmldb_shm_header *)p;
+    if (sh->sh_magic != XMLDB_SHM_MAGIC ||
+	sh->sh_version != XMLDB_SHM_VERSION ||
+	sh->sh_obsolete ||
+	sh->sh_size != (uint64_t)sti.st_size ||
+	sh->sh_nodes == 0 ||
+	sh->sh_strings != sizeof(*sh) + sh->sh_nodes*sizeof(struct xmldb_shm_node) ||
+	sh->sh_strings >= sh->sh_size ||
+	((char*)p)[sh->sh_size-1] != '\0' ||
+	sh->sh_src_ino != (uint64_t)st.st_ino ||
+	sh->sh_src_size != (uint64_t)st.st_size ||
+	sh->sh_src_mtime != shm_mtime(&st)){
+	munmap(p, sti.st_size);
+	goto fail;
+    }
+    ir->ir_sh = sh;
+    ir->ir_nodes = (struct xmldb_shm_node *)(sh + 1);
+    ir->ir_str = (char*)sh + sh->sh_strings;
+    *size = sti.st_size;
+    retval = 1;
+ done:
+    if (fd != -1)
+	close(fd);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Read a datastore from the image of its file, without parsing the file
+ *
+ * The image is mapped and the nodes selected by the xpath are found with binary
+ * search of the sorted children and copied to XML, with their ancestors and the keys
+ * of ancestor list entries, as xpath_vec and xml_tree_prune_flagged_sub would.
+ * Only simple xpaths are supported: absolute paths of child steps where a predicate
+ * is the complete key of a list entry or [.='v'] of a leaf-list entry.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Name of datastore, eg "running"
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  XPath, or NULL for all
+ * @param[out] xtp    Tree with top-level DATASTORE_TOP_SYMBOL bound to yang and sorted
+ * @retval     1      OK
+ * @retval     0      Not enabled, no valid image, or not a simple xpath: read the file
+ * @retval    -1      Error
+ * @see xmldb_image_write
+ */
+int
+xmldb_image_get(clicon_handle h,
+		const char   *db,
+		cvec         *nsc,
+		const char   *xpath,
+		cxobj       **xtp)
+{
+    int                 retval = -1;
+    yang_stmt          *yspec;
+    yang_stmt          *y;
+    char               *dbfile = NULL;
+    struct image_read   ir = {0,};
+    size_t              size = 0;
+    cxobj              *xt = NULL;
+    struct image_match *vec = NULL;
+    size_t              len = 0;
+    struct image_match *next = NULL;
+    size_t              nlen;
+    const char         *p;
+    char               *name = NULL;
+    char               *ns;
+    cvec               *preds = NULL;
+    cbuf               *cb = NULL;
+    size_t              i;
+    int                 ret;
+
+    if (!clicon_option_bool(h, "CLICON_XMLDB_IMAGE") ||
+	(yspec = clicon_dbspec_yang(h)) == NULL)
+	goto fail;
+    if ((ret = xmldb_journal_exists(h, db)) < 0)
+	goto done;
+    if (ret == 1) /* Image is of the file without the journal */
+	goto fail;
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+	goto done;
+    if ((ret = image_map(dbfile, &ir, &size)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((xt = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	goto done;
+    xml_flag_set(xt, XML_FLAG_TOP);
+    if ((vec = malloc(sizeof(*vec))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    vec[0].im_node = 0;
+    vec[0].im_x = xt;
+    len = 1;
+    p = (xpath == NULL || strcmp(xpath, "/") == 0) ? "" : xpath;
+    if (*p != '\0' && *p != '/')
+	goto fail;
+    if (*p == '\0'){ /* All */
+	for (i=0; i<ir.ir_nodes[0].sn_nchild; i++){
+	    struct xmldb_shm_node *sc = &ir.ir_nodes[ir.ir_nodes[0].sn_child + i];
+	    cxobj                 *x;
+
+	    if (sc->sn_child + sc->sn_nchild > ir.ir_sh->sh_nodes ||
+		(y = image_yang(yspec, NULL, ir.ir_str + sc->sn_name, NULL)) == NULL)
+		goto fail;
+	    if ((x = image_node_xml(&ir, sc, y, xt)) == NULL)
+		goto done;
+	    if ((ret = image_copy(&ir, sc, x, 0)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+    }
+    while (*p == '/' && len > 0){
+	if ((ret = image_step(&p, nsc, &name, &ns, &preds)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	nlen = 0;
+	for (i=0; i<len; i++){
+	    if ((y = image_yang(yspec, xml_spec(vec[i].im_x), name, ns)) == NULL)
+		goto fail;
+	    if ((ret = image_step_key(y, preds, cb)) == 0)
+		goto fail;
+	    if ((ret = image_step_match(&ir, &vec[i], y, cbuf_get(cb), *p == '\0',
+					&next, &nlen)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+	free(vec);
+	vec = next;
+	len = nlen;
+	next = NULL;
+	free(name);
+	name = NULL;
+	cvec_free(preds);
+	preds = NULL;
+    }
+    if (*p != '\0' && len > 0)
+	goto fail;
+    if (xml_sort_recurse(xt) < 0)
+	goto done;
+    *xtp = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (ir.ir_sh)
+	munmap(ir.ir_sh, size);
+    if (xt)
+	xml_free(xt);
+    if (vec)
+	free(vec);
+    if (next)
+	free(next);
+    if (name)
+	free(name);
+    if (preds)
+	cvec_free(preds);
+    if (cb)
+	cbuf_free(cb);
+    if (dbfile)
+	free(dbfile);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
@@ -45,6 +45,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -62,15 +63,18 @@
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_log.h"
+#include "clixon_trace.h"
 #include "clixon_file.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
 #include "clixon_xml_sort.h"
 #include "clixon_options.h"
+#include "clixon_proto.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_json.h"
+#include "clixon_cbor.h"
 #include "clixon_nacm.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_yang_type.h"
@@ -81,6 +85,813 @@
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_compress.h"
+#include "clixon_datastore_shm.h"
+
+/* Size of stdio buffer of a datastore file being written, so that a large datastore
+ * is written in few system calls */
+#define XMLDB_WRITE_BUFSIZE (256*1024)
+
+/* Datastore file written but not yet synced, with CLICON_XMLDB_SYNC group */
+struct xmldb_sync_file{
+    char *sf_path;  /* Filename */
+    int   sf_fd;    /* Open file descriptor of written file */
+};
+
+/* Files to sync with CLICON_XMLDB_SYNC group, see xmldb_sync */
+static struct xmldb_sync_file *_sync_files = NULL;
+static int                     _sync_len = 0;
+static int                     _sync_dir = 0; /* Datastore directory to sync */
+
+/*! Sync the directory of the datastore files
+ * Needed for a renamed or created file to survive a crash
+ * @param[in]  h      Clicon handle
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_dir_fsync(clicon_handle h)
+{
+    char *dir;
+    int   fd;
+
+    if ((dir = clicon_xmldb_dir(h)) == NULL)
+	return 0;
+    if ((fd = open(dir, O_RDONLY)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s)", dir);
+	return -1;
+    }
+    if (fsync(fd) < 0){
+	clicon_err(OE_UNIX, errno, "fsync(%s)", dir);
+	close(fd);
+	return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+/*! Sync a written datastore file according to CLICON_XMLDB_SYNC
+ *
+ * With group, the sync is deferred to xmldb_sync. A file written again before that
+ * replaces the earlier pending version, which then need not be synced.
+ * @param[in]  h      Clicon handle
+ * @param[in]  fd     File descriptor of written file
+ * @param[in]  path   Filename the file is renamed to after sync
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_file_sync(clicon_handle h,
+		int           fd,
+		const char   *path)
+{
+    struct xmldb_sync_file *sf;
+    int                     i;
+    int                     fd1;
+
+    switch (clicon_datastore_sync(h)){
+    case DATASTORE_SYNC_NONE:
+	break;
+    case DATASTORE_SYNC_DATA:
+	if (fdatasync(fd) < 0){
+	    clicon_err(OE_UNIX, errno, "fdatasync(%s)", path);
+	    return -1;
+	}
+	break;
+    case DATASTORE_SYNC_GROUP:
+	if ((fd1 = dup(fd)) < 0){
+	    clicon_err(OE_UNIX, errno, "dup(%s)", path);
+	    return -1;
+	}
+	for (i=0; i<_sync_len; i++)
+	    if (strcmp(_sync_files[i].sf_path, path) == 0)
+		break;
+	if (i < _sync_len)
+	    close(_sync_files[i].sf_fd);
+	else{
+	    if ((sf = realloc(_sync_files, (_sync_len+1)*sizeof(*sf))) == NULL){
+		clicon_err(OE_UNIX, errno, "realloc");
+		close(fd1);
+		return -1;
+	    }
+	    _sync_files = sf;
+	    if ((_sync_files[i].sf_path = strdup(path)) == NULL){
+		clicon_err(OE_UNIX, errno, "strdup");
+		close(fd1);
+		return -1;
+	    }
+	    _sync_len++;
+	}
+	_sync_files[i].sf_fd = fd1;
+	break;
+    }
+    return 0;
+}
+
+/*! Sync the datastore directory after a file is created or renamed in it
+ * @param[in]  h      Clicon handle
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_file_sync
+ */
+static int
+xmldb_dir_sync(clicon_handle h)
+{
+    switch (clicon_datastore_sync(h)){
+    case DATASTORE_SYNC_NONE:
+	break;
+    case DATASTORE_SYNC_DATA:
+	return xmldb_dir_fsync(h);
+    case DATASTORE_SYNC_GROUP:
+	_sync_dir = 1;
+	break;
+    }
+    return 0;
+}
+
+/*! Sync datastore files written since the last call, with CLICON_XMLDB_SYNC group
+ *
+ * Call before replying to a request that may have written datastores, so that all
+ * files written while handling it are synced once.
+ * @param[in]  h      Clicon handle
+ * @retval     0      OK, or nothing to sync
+ * @retval    -1      Error
+ */
+int
+xmldb_sync(clicon_handle h)
+{
+    int retval = 0;
+    int i;
+
+    for (i=0; i<_sync_len; i++){
+	if (retval == 0 && fdatasync(_sync_files[i].sf_fd) < 0){
+	    clicon_err(OE_UNIX, errno, "fdatasync(%s)", _sync_files[i].sf_path);
+	    retval = -1;
+	}
+	close(_sync_files[i].sf_fd);
+	free(_sync_files[i].sf_path);
+    }
+    _sync_len = 0;
+    if (_sync_dir){
+	_sync_dir = 0;
+	if (retval == 0 && xmldb_dir_fsync(h) < 0)
+	    retval = -1;
+    }
+    return retval;
+}
+
+/*! Open a temporary file for writing a datastore file
+ * The file is written to <path>.tmp which replaces path in xmldb_file_commit, so
+ * that a crash while writing leaves the old file intact.
+ * @param[in]  path   Filename of datastore file
+ * @param[out] tmp    Temporary filename, free with free()
+ * @param[out] buf    Stdio buffer, free with free() after fclose
+ * @retval     f      Open file
+ * @retval     NULL   Error
+ */
+static FILE *
+xmldb_file_open(const char *path,
+		char      **tmp,
+		char      **buf)
+{
+    FILE       *f = NULL;
+    size_t      len;
+    struct stat st;
+
+    len = strlen(path) + strlen(".tmp") + 1;
+    if ((*tmp = malloc(len)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    snprintf(*tmp, len, "%s.tmp", path);
+    if ((f = fopen(*tmp, "w")) == NULL){
+	clicon_err(OE_CFG, errno, "Creating file %s", *tmp);
+	goto fail;
+    }
+    /* Keep mode of existing file */
+    if (stat(path, &st) == 0)
+	(void)fchmod(fileno(f), st.st_mode & 07777);
+    if ((*buf = malloc(XMLDB_WRITE_BUFSIZE)) != NULL)
+	setvbuf(f, *buf, _IOFBF, XMLDB_WRITE_BUFSIZE);
+    return f;
+ fail:
+    free(*tmp);
+    *tmp = NULL;
+    return NULL;
+}
+
+/*! Complete a datastore file written to a temporary file, and replace the old file
+ * @param[in]  h      Clicon handle
+ * @param[in]  f      File opened by xmldb_file_open, closed
+ * @param[in]  tmp    Temporary filename, removed on error
+ * @param[in]  path   Filename of datastore file
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_file_commit(clicon_handle h,
+		  FILE         *f,
+		  const char   *tmp,
+		  const char   *path)
+{
+    int retval = -1;
+
+    if (fflush(f) != 0 || ferror(f)){
+	clicon_err(OE_UNIX, errno, "write(%s)", tmp);
+	goto done;
+    }
+    if (xmldb_file_sync(h, fileno(f), path) < 0)
+	goto done;
+    if (fclose(f) != 0){
+	f = NULL;
+	clicon_err(OE_UNIX, errno, "close(%s)", tmp);
+	goto done;
+    }
+    f = NULL;
+    if (rename(tmp, path) < 0){
+	clicon_err(OE_UNIX, errno, "rename(%s)", path);
+	goto done;
+    }
+    if (xmldb_dir_sync(h) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    if (retval < 0)
+	unlink(tmp);
+    return retval;
+}
+
+/*! Copy a datastore file, replacing the target atomically
+ * @param[in]  h      Clicon handle
+ * @param[in]  from   Source filename
+ * @param[in]  to     Target filename
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clicon_file_copy  which overwrites the target in place
+ */
+int
+xmldb_file_copy(clicon_handle h,
+		const char   *from,
+		const char   *to)
+{
+    int    retval = -1;
+    FILE  *fin = NULL;
+    FILE  *f = NULL;
+    char  *tmp = NULL;
+    char  *buf = NULL;
+    char   line[4096];
+    size_t n;
+
+    if ((fin = fopen(from, "r")) == NULL){
+	clicon_err(OE_UNIX, errno, "open(%s) for read", from);
+	goto done;
+    }
+    if ((f = xmldb_file_open(to, &tmp, &buf)) == NULL)
+	goto done;
+    while ((n = fread(line, 1, sizeof(line), fin)) > 0)
+	if (fwrite(line, 1, n, f) != n){
+	    clicon_err(OE_UNIX, errno, "write(%s)", tmp);
+	    unlink(tmp);
+	    goto done;
+	}
+    if (ferror(fin)){
+	clicon_err(OE_UNIX, errno, "read(%s)", from);
+	unlink(tmp);
+	goto done;
+    }
+    retval = xmldb_file_commit(h, f, tmp, to);
+    f = NULL;
+ done:
+    if (f)
+	fclose(f);
+    if (fin)
+	fclose(fin);
+    if (buf)
+	free(buf);
+    if (tmp)
+	free(tmp);
+    return retval;
+}
+
+/*! Get value of sorted attribute of datastore files, see XMLDB_SORTED_ATTR
+ *
+ * The canonical order depends on the yang modules. The value is a hash (FNV-1a) of
+ * the names and latest revisions of the modules, so that a file written with other
+ * modules, or by another program, is sorted when read.
+ * @param[in]  yspec  Top-level yang spec
+ * @param[out] buf    Hash value as hex string
+ * @param[in]  len    Length of buf, at least XMLDB_SORTED_LEN
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xmldb_sorted_value(yang_stmt *yspec,
+		   char      *buf,
+		   size_t     len)
+{
+    uint32_t   hash = 2166136261U;
+    yang_stmt *ym = NULL;
+    yang_stmt *yrev;
+    uint32_t   rev;
+    char      *str;
+    size_t     i;
+
+    if (len < XMLDB_SORTED_LEN){
+	clicon_err(OE_XML, EINVAL, "buffer too short");
+	return -1;
+    }
+    while ((ym = yn_each(yspec, ym)) != NULL){
+	if (yang_keyword_get(ym) != Y_MODULE && yang_keyword_get(ym) != Y_SUBMODULE)
+	    continue;
+	str = yang_argument_get(ym);
+	for (i = 0; i <= strlen(str); i++){ /* Including null */
+	    hash ^= (uint8_t)str[i];
+	    hash *= 16777619U;
+	}
+	rev = 0;
+	if ((yrev = yang_find(ym, Y_REVISION, NULL)) != NULL)
+	    rev = cv_uint32_get(yang_cv_get(yrev));
+	for (i = 0; i < sizeof(rev); i++){
+	    hash ^= (uint8_t)(rev >> (8*i));
+	    hash *= 16777619U;
+	}
+    }
+    snprintf(buf, len, "%08x", hash);
+    return 0;
+}
+
+/*! Get the directory of the shard files of a datastore file, see CLICON_XMLDB_SHARD
+ * @param[in]  dbfile Datastore filename
+ * @param[out] dir    Directory name <dbfile>.d, free with free()
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xmldb_shard_dir(const char *dbfile,
+		char      **dir)
+{
+    size_t len;
+
+    len = strlen(dbfile) + strlen(XMLDB_SHARD_DIR_SUFFIX) + 1;
+    if ((*dir = malloc(len)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return -1;
+    }
+    snprintf(*dir, len, "%s%s", dbfile, XMLDB_SHARD_DIR_SUFFIX);
+    return 0;
+}
+
+/*! Get the module name of the shard a top-level datastore node is written to
+ * @param[in]  x      Top-level node of datastore or edit
+ * @retval     name   Module name
+ * @retval     NULL   Not bound to yang
+ */
+static char *
+xmldb_shard_module(cxobj *x)
+{
+    yang_stmt *ys;
+    yang_stmt *ymod = NULL;
+
+    if ((ys = xml_spec(x)) == NULL)
+	return NULL;
+    if (ys_real_module(ys, &ymod) < 0 || ymod == NULL)
+	return NULL;
+    return yang_argument_get(ymod);
+}
+
+/*! Sync a shard directory after files are renamed or removed in it
+ * @param[in]  h      Clicon handle
+ * @param[in]  dir    Shard directory
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_dir_sync  for the datastore directory
+ */
+static int
+xmldb_shard_dir_sync(clicon_handle h,
+		     const char   *dir)
+{
+    int fd;
+    int ret;
+
+    if (clicon_datastore_sync(h) == DATASTORE_SYNC_NONE)
+	return 0;
+    if ((fd = open(dir, O_RDONLY)) < 0){
+	clicon_err(OE_UNIX, errno, "open(%s)", dir);
+	return -1;
+    }
+    ret = xmldb_file_sync(h, fd, dir);
+    close(fd);
+    return ret;
+}
+
+/*! Check if a datastore file marks the datastore as sharded
+ * The file is written uncompressed so that only its start needs to be read
+ * @param[in]  dbfile Datastore filename
+ * @retval     1      File starts with <config clixon-sharded="true"
+ * @retval     0      No, or no file
+ */
+static int
+xmldb_file_sharded(const char *dbfile)
+{
+    FILE       *f;
+    char        buf[64];
+    size_t      n;
+    const char *mark = "<" DATASTORE_TOP_SYMBOL " " XMLDB_SHARDED_ATTR "=\"true\"";
+
+    if ((f = fopen(dbfile, "r")) == NULL)
+	return 0;
+    n = fread(buf, 1, sizeof(buf)-1, f);
+    buf[n] = '\0';
+    fclose(f);
+    return strncmp(buf, mark, strlen(mark)) == 0;
+}
+
+/*! Write the top-level nodes of one module of a datastore tree to its shard file
+ * @param[in]  h      Clicon handle
+ * @param[in]  path   Shard filename
+ * @param[in]  x0     Datastore top-level tree
+ * @param[in]  module Module name
+ * @param[in]  sorted Value of XMLDB_SORTED_ATTR if tree is in canonical order, or NULL
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_shard_file_write(clicon_handle h,
+		       const char   *path,
+		       cxobj        *x0,
+		       const char   *module,
+		       const char   *sorted)
+{
+    int    retval = -1;
+    FILE  *f = NULL;
+    FILE  *fz = NULL;
+    FILE  *fw;
+    char  *tmp = NULL;
+    char  *buf = NULL;
+    cxobj *x;
+    char  *name;
+    int    pretty;
+    int    level;
+    int    ret;
+
+    if ((f = xmldb_file_open(path, &tmp, &buf)) == NULL)
+	goto done;
+    fw = f;
+    if ((level = clicon_optv(h)->co_xmldb_compress) > 0 &&
+	(fw = fz = xmldb_zstd_writer(f, level)) == NULL)
+	goto done;
+    pretty = clicon_optv(h)->co_xmldb_pretty;
+    if (sorted)
+	fprintf(fw, "<%s %s=\"%s\">", DATASTORE_TOP_SYMBOL, XMLDB_SORTED_ATTR, sorted);
+    else
+	fprintf(fw, "<%s>", DATASTORE_TOP_SYMBOL);
+    if (pretty)
+	fprintf(fw, "\n");
+    x = NULL;
+    while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL){
+	if ((name = xmldb_shard_module(x)) == NULL || strcmp(name, module) != 0)
+	    continue;
+	if (clicon_xml2file(fw, x, 1, pretty) < 0)
+	    goto done;
+    }
+    fprintf(fw, "</%s>", DATASTORE_TOP_SYMBOL);
+    if (pretty)
+	fprintf(fw, "\n");
+    if (fz){
+	ret = fclose(fz);
+	fz = NULL;
+	if (ret != 0){
+	    clicon_err(OE_UNIX, errno, "write(%s)", tmp);
+	    goto done;
+	}
+    }
+    retval = xmldb_file_commit(h, f, tmp, path);
+    f = NULL;
+ done:
+    if (fz)
+	fclose(fz);
+    if (f){
+	fclose(f);
+	unlink(tmp);
+    }
+    if (buf)
+	free(buf);
+    if (tmp)
+	free(tmp);
+    return retval;
+}
+
+/*! Write the shard files of a datastore tree, one per top-level module
+ *
+ * Only the shards of the modules in dirty are written if the datastore file is
+ * already sharded, otherwise all are.
+ * @param[in]  h      Clicon handle
+ * @param[in]  dbfile Datastore filename
+ * @param[in]  x0     Datastore top-level tree
+ * @param[in]  dirty  Names of modules changed since last write, or NULL for all
+ * @param[in]  sorted Value of XMLDB_SORTED_ATTR if tree is in canonical order, or NULL
+ * @param[out] modsp  Names of modules with content, free with cvec_free
+ * @retval     1      OK, shards written
+ * @retval     0      Tree has nodes not bound to yang, not written
+ * @retval    -1      Error
+ * @see xmldb_shard_read
+ */
+static int
+xmldb_shard_write(clicon_handle h,
+		  const char   *dbfile,
+		  cxobj        *x0,
+		  cvec         *dirty,
+		  const char   *sorted,
+		  cvec        **modsp)
+{
+    int    retval = -1;
+    char  *dir = NULL;
+    cbuf  *cb = NULL;
+    cvec  *mods = NULL;
+    cxobj *x;
+    char  *module;
+    int    all;
+
+    x = NULL;
+    while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL)
+	if (xmldb_shard_module(x) == NULL)
+	    goto fail;
+    all = (dirty == NULL || xmldb_file_sharded(dbfile) == 0);
+    if (xmldb_shard_dir(dbfile, &dir) < 0)
+	goto done;
+    if (mkdir(dir, S_IRWXU) < 0 && errno != EEXIST){
+	clicon_err(OE_UNIX, errno, "mkdir(%s)", dir);
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((mods = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    x = NULL;
+    while ((x = xml_child_each(x0, x, CX_ELMNT)) != NULL){
+	module = xmldb_shard_module(x);
+	if (cvec_find(mods, module) != NULL)
+	    continue;
+	if (cvec_add_string(mods, module, NULL) < 0){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    goto done;
+	}
+	if (!all && cvec_find(dirty, module) == NULL)
+	    continue;
+	cbuf_reset(cb);
+	cprintf(cb, "%s/%s%s", dir, module, XMLDB_SHARD_SUFFIX);
+	if (xmldb_shard_file_write(h, cbuf_get(cb), x0, module, sorted) < 0)
+	    goto done;
+    }
+    if (xmldb_shard_dir_sync(h, dir) < 0)
+	goto done;
+    *modsp = mods;
+    mods = NULL;
+    retval = 1;
+ done:
+    if (mods)
+	cvec_free(mods);
+    if (cb)
+	cbuf_free(cb);
+    if (dir)
+	free(dir);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Remove shard files of a datastore file
+ * @param[in]  h      Clicon handle
+ * @param[in]  dbfile Datastore filename
+ * @param[in]  keep   Names of modules whose shards are kept, or NULL to remove all
+ *                    shards and the directory
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xmldb_shard_rm(clicon_handle h,
+	       const char   *dbfile,
+	       cvec         *keep)
+{
+    int            retval = -1;
+    char          *dir = NULL;
+    cbuf          *cb = NULL;
+    struct dirent *dp = NULL;
+    struct stat    st;
+    int            ndp;
+    int            i;
+    size_t         len;
+    int            removed = 0;
+
+    if (xmldb_shard_dir(dbfile, &dir) < 0)
+	goto done;
+    if (stat(dir, &st) < 0){
+	retval = 0;
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((ndp = clicon_file_dirent(dir, &dp, "\\.xml$", S_IFREG)) < 0)
+	goto done;
+    for (i = 0; i < ndp; i++){
+	if (keep){
+	    cbuf_reset(cb);
+	    len = strlen(dp[i].d_name) - strlen(XMLDB_SHARD_SUFFIX);
+	    cprintf(cb, "%.*s", (int)len, dp[i].d_name);
+	    if (cvec_find(keep, cbuf_get(cb)) != NULL)
+		continue;
+	}
+	cbuf_reset(cb);
+	cprintf(cb, "%s/%s", dir, dp[i].d_name);
+	if (unlink(cbuf_get(cb)) < 0 && errno != ENOENT){
+	    clicon_err(OE_UNIX, errno, "unlink(%s)", cbuf_get(cb));
+	    goto done;
+	}
+	removed++;
+    }
+    if (keep == NULL){
+	if (rmdir(dir) < 0 && errno != ENOENT){
+	    clicon_err(OE_UNIX, errno, "rmdir(%s)", dir);
+	    goto done;
+	}
+	if (xmldb_dir_sync(h) < 0)
+	    goto done;
+    }
+    else if (removed && xmldb_shard_dir_sync(h, dir) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (dp)
+	free(dp);
+    if (cb)
+	cbuf_free(cb);
+    if (dir)
+	free(dir);
+    return retval;
+}
+
+/*! Copy the shard files of a datastore file, replacing those of the target
+ *
+ * Shard files are never modified in place but replaced, see xmldb_file_commit, so
+ * they are linked instead of copied. A shard that is already linked is not touched.
+ * @param[in]  h      Clicon handle
+ * @param[in]  from   Source datastore filename
+ * @param[in]  to     Target datastore filename
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_file_copy
+ */
+int
+xmldb_shard_copy(clicon_handle h,
+		 const char   *from,
+		 const char   *to)
+{
+    int            retval = -1;
+    char          *fromdir = NULL;
+    char          *todir = NULL;
+    cbuf          *cbf = NULL;
+    cbuf          *cbt = NULL;
+    cbuf          *cbtmp = NULL;
+    struct dirent *dp = NULL;
+    struct stat    st;
+    struct stat    st1;
+    cvec          *mods = NULL;
+    int            ndp;
+    int            i;
+    size_t         len;
+
+    if (xmldb_shard_dir(from, &fromdir) < 0)
+	goto done;
+    if (stat(fromdir, &st) < 0){
+	retval = xmldb_shard_rm(h, to, NULL);
+	goto done;
+    }
+    if (xmldb_shard_dir(to, &todir) < 0)
+	goto done;
+    if (mkdir(todir, S_IRWXU) < 0 && errno != EEXIST){
+	clicon_err(OE_UNIX, errno, "mkdir(%s)", todir);
+	goto done;
+    }
+    if ((cbf = cbuf_new()) == NULL ||
+	(cbt = cbuf_new()) == NULL ||
+	(cbtmp = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if ((mods = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if ((ndp = clicon_file_dirent(fromdir, &dp, "\\.xml$", S_IFREG)) < 0)
+	goto done;
+    for (i = 0; i < ndp; i++){
+	cbuf_reset(cbf);
+	cprintf(cbf, "%s/%s", fromdir, dp[i].d_name);
+	cbuf_reset(cbt);
+	cprintf(cbt, "%s/%s", todir, dp[i].d_name);
+	cbuf_reset(cbtmp);
+	len = strlen(dp[i].d_name) - strlen(XMLDB_SHARD_SUFFIX);
+	cprintf(cbtmp, "%.*s", (int)len, dp[i].d_name);
+	if (cvec_add_string(mods, cbuf_get(cbtmp), NULL) < 0){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    goto done;
+	}
+	if (stat(cbuf_get(cbf), &st) < 0){
+	    clicon_err(OE_UNIX, errno, "stat(%s)", cbuf_get(cbf));
+	    goto done;
+	}
+	if (stat(cbuf_get(cbt), &st1) == 0 &&
+	    st.st_ino == st1.st_ino && st.st_dev == st1.st_dev)
+	    continue;
+	cbuf_reset(cbtmp);
+	cprintf(cbtmp, "%s.tmp", cbuf_get(cbt));
+	unlink(cbuf_get(cbtmp));
+	if (link(cbuf_get(cbf), cbuf_get(cbtmp)) < 0){
+	    /* Eg file system without hard links */
+	    if (xmldb_file_copy(h, cbuf_get(cbf), cbuf_get(cbt)) < 0)
+		goto done;
+	    continue;
+	}
+	if (rename(cbuf_get(cbtmp), cbuf_get(cbt)) < 0){
+	    clicon_err(OE_UNIX, errno, "rename(%s)", cbuf_get(cbt));
+	    unlink(cbuf_get(cbtmp));
+	    goto done;
+	}
+    }
+    /* Shards of modules without content in from */
+    if (xmldb_shard_rm(h, to, mods) < 0)
+	goto done;
+    if (xmldb_shard_dir_sync(h, todir) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (mods)
+	cvec_free(mods);
+    if (dp)
+	free(dp);
+    if (cbf)
+	cbuf_free(cbf);
+    if (cbt)
+	cbuf_free(cbt);
+    if (cbtmp)
+	cbuf_free(cbtmp);
+    if (fromdir)
+	free(fromdir);
+    if (todir)
+	free(todir);
+    return retval;
+}
+
+/*! Get the modules of the top-level nodes of an edit, see CLICON_XMLDB_SHARD
+ * @param[in]  x1     Edit tree
+ * @param[out] dirtyp Names of modules, free with cvec_free, or NULL if a node is not
+ *                    bound to yang
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_shard_dirty(cxobj *x1,
+		  cvec **dirtyp)
+{
+    int    retval = -1;
+    cvec  *dirty = NULL;
+    cxobj *x;
+    char  *module;
+
+    if ((dirty = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    x = NULL;
+    while ((x = xml_child_each(x1, x, CX_ELMNT)) != NULL){
+	if ((module = xmldb_shard_module(x)) == NULL){
+	    cvec_free(dirty);
+	    dirty = NULL;
+	    break;
+	}
+	if (cvec_find(dirty, module) == NULL &&
+	    cvec_add_string(dirty, module, NULL) < 0){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    goto done;
+	}
+    }
+    *dirtyp = dirty;
+    dirty = NULL;
+    retval = 0;
+ done:
+    if (dirty)
+	cvec_free(dirty);
+    return retval;
+}
 
 /*! Given an attribute name and its expected namespace, find its value
  * 
@@ -617,7 +1428,7 @@ text_modify(clicon_handle       h,
 		/* Get yang spec of the child by child matching */
 		yc = yang_find_datanode(y0, x1cname);
 		if (yc == NULL){
-		    if (clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA") == 1){
+		    if (clicon_optv(h)->co_yang_unknown_anydata){
 			/* Add dummy Y_ANYDATA yang stmt, see ysp_add */
 			if ((yc = yang_anydata_add(y0, x1cname)) < 0)
 			    goto done;
@@ -781,9 +1592,8 @@ text_modify_top(clicon_handle       h,
 			goto fail;
 		    permit = 1;
 		}
-		while ((x0c = xml_child_i(x0, 0)) != 0)
-		    if (xml_purge(x0c) < 0)
-			goto done;
+		if (xml_purge_children(x0, NULL, NULL) < 0)
+		    goto done;
 		break;
 	    default:
 		break;
@@ -821,9 +1631,8 @@ text_modify_top(clicon_handle       h,
 		goto fail;
 	    permit = 1;
 	}
-	while ((x0c = xml_child_i(x0, 0)) != 0)
-	    if (xml_purge(x0c) < 0)
-		goto done;
+	if (xml_purge_children(x0, NULL, NULL) < 0)
+	    goto done;
     }
     /* Loop through children of the modification tree */
     x1c = NULL;
@@ -837,7 +1646,7 @@ text_modify_top(clicon_handle       h,
 	    yc = yang_find_datanode(ymod, x1cname);
 	if (yc == NULL){
 	    if (ymod != NULL &&
-		clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA") == 1){
+		clicon_optv(h)->co_yang_unknown_anydata){
 		/* Add dummy Y_ANYDATA yang stmt, see ysp_add */
 		if ((yc = yang_anydata_add(ymod, x1cname)) < 0)
 		    goto done;
@@ -878,7 +1687,414 @@ text_modify_top(clicon_handle       h,
     goto done;
 } /* text_modify_top */
 
-/*! Modify database given an xml tree and an operation
+/*! Clean up a datastore tree after modification
+ * Remove NONE nodes, non-presence containers and defaults: the datastore is
+ * stored without defaults.
+ * @param[in]  x0     Datastore top-level tree
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+text_modify_cleanup(cxobj *x0)
+{
+    int retval = -1;
+
+    /* Remove NONE nodes if all subs recursively are also NONE */
+    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+	goto done;
+    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, 
+		  (void*)(XML_FLAG_NONE|XML_FLAG_MARK)) < 0)
+	goto done;
+    /* Mark non-presence containers as XML_FLAG_DEFAULT */
+    if (xml_apply(x0, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_DEFAULT) < 0)
+	goto done;
+    /* Clear XML tree of defaults */
+    if (xml_tree_prune_flagged(x0, XML_FLAG_DEFAULT, 1) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Write the children of a datastore tree as CBOR to a file
+ * @param[in]  f      File
+ * @param[in]  x0     Datastore top-level tree
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clixon_cbor_parse_file
+ */
+static int
+xmldb_cbor2file(FILE  *f,
+		cxobj *x0)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    if (clixon_xml2cbor(cb, x0) < 0)
+	goto done;
+    if (fwrite(cbuf_get(cb), 1, cbuf_len(cb), f) != cbuf_len(cb)){
+	clicon_err(OE_UNIX, errno, "fwrite");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Check if children of an XML node are sorted, see XML_FLAG_SORTED
+ * Nodes flagged as sorted are not checked again, nodes found sorted are flagged
+ * @param[in]  x    XML node
+ * @param[in]  arg  Not used
+ * @retval     0    Sorted
+ * @retval     1    Not sorted, abort
+ * @see xml_apply0
+ */
+static int
+xml_sorted_check(cxobj *x,
+		 void  *arg)
+{
+    if (xml_child_nr_type(x, CX_ELMNT) > 1 && xml_sort_verify(x, NULL) != 0)
+	return 1;
+    return 0;
+}
+
+/*! Write a complete datastore tree to its file, including module state
+ *
+ * With CLICON_XMLDB_SHARD, the content is written to shard files and the file only
+ * marks the datastore as sharded.
+ * @param[in]  h      Clicon handle
+ * @param[in]  dbfile Datastore filename
+ * @param[in]  x0     Datastore top-level tree
+ * @param[in]  dirty  Modules changed since the file was written, or NULL if not known
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_write_file(clicon_handle h,
+		 char         *dbfile,
+		 cxobj        *x0,
+		 cvec         *dirty)
+{
+    int    retval = -1;
+    FILE  *f = NULL;
+    FILE  *fz = NULL;
+    FILE  *fw;
+    char  *tmp = NULL;
+    char  *buf = NULL;
+    cxobj *x;
+    cxobj *xw;        /* Tree written to file */
+    cxobj *xs = NULL; /* Top of sharded datastore file */
+    cxobj *xmodst = NULL;
+    cxobj *xa = NULL;
+    cvec  *mods = NULL;
+    int    format;
+    int    pretty;
+    int    level;
+    int    sorted = 0;
+    char   value[XMLDB_SORTED_LEN];
+    yang_stmt *yspec;
+    int    ret;
+
+    if ((format = clicon_optv(h)->co_xmldb_format) < 0){
+	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
+	goto done;
+    }
+    /* Mark XML file as sorted if all nodes are, then it is not sorted when read, see
+     * xmldb_readfile. The attribute is first, so it can be found at file start
+     * Its value identifies the yang modules the order is valid for
+     */
+    if (format == FORMAT_XML &&
+	(yspec = clicon_dbspec_yang(h)) != NULL){
+	if ((ret = xml_apply0(x0, CX_ELMNT, xml_sorted_check, NULL)) < 0)
+	    goto done;
+	if (ret == 0){
+	    sorted = 1; /* Restored after the attribute is removed */
+	    if ((xa = xml_new(XMLDB_SORTED_ATTR, NULL, CX_ATTR)) == NULL)
+		goto done;
+	    if (xmldb_sorted_value(yspec, value, sizeof(value)) < 0)
+		goto done;
+	    if (xml_value_set(xa, value) < 0)
+		goto done;
+	    if (xml_child_insert_pos(x0, xa, 0) < 0)
+		goto done;
+	    xml_parent_set(xa, x0);
+	}
+    }
+    xw = x0;
+    /* Content of each module to a shard file of its own, see CLICON_XMLDB_SHARD */
+    if (format == FORMAT_XML && clicon_optv(h)->co_xmldb_shard){
+	if ((ret = xmldb_shard_write(h, dbfile, x0, dirty, xa ? value : NULL, &mods)) < 0)
+	    goto done;
+	if (ret == 1){
+	    if ((xs = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+		goto done;
+	    if ((x = xml_new(XMLDB_SHARDED_ATTR, xs, CX_ATTR)) == NULL)
+		goto done;
+	    if (xml_value_set(x, "true") < 0)
+		goto done;
+	    xw = xs;
+	}
+    }
+    /* Add module revision info before writing to file)
+     * Only if CLICON_XMLDB_MODSTATE is set
+     */
+    if ((x = clicon_modst_cache_get(h, 1)) != NULL){
+	if ((xmodst = xml_dup(x)) == NULL)
+	    goto done;
+	if (xml_addsub(xw, xmodst) < 0)
+	    goto done;
+    }
+    /* Written to a temporary file that replaces the datastore file when complete */
+    if ((f = xmldb_file_open(dbfile, &tmp, &buf)) == NULL)
+	goto done;
+    /* Compressed while written, see CLICON_XMLDB_COMPRESS
+     * A sharded file is not, see xmldb_file_sharded */
+    fw = f;
+    if (xs == NULL &&
+	(level = clicon_optv(h)->co_xmldb_compress) > 0 &&
+	(fw = fz = xmldb_zstd_writer(f, level)) == NULL)
+	goto done;
+    pretty = clicon_optv(h)->co_xmldb_pretty;
+    if (format == FORMAT_JSON){
+	if (xml2json(fw, xw, pretty) < 0)
+	    goto done;
+    }
+    else if (format == FORMAT_CBOR){
+	if (xmldb_cbor2file(fw, xw) < 0)
+	    goto done;
+    }
+    else if (clicon_xml2file(fw, xw, 0, pretty) < 0)
+	goto done;
+    if (fz){
+	/* Ends the compressed frame */
+	ret = fclose(fz);
+	fz = NULL;
+	if (ret != 0){
+	    clicon_err(OE_UNIX, errno, "write(%s)", tmp);
+	    goto done;
+	}
+    }
+    ret = xmldb_file_commit(h, f, tmp, dbfile);
+    f = NULL;
+    if (ret < 0)
+	goto done;
+    if (xmodst){
+	if (xml_purge(xmodst) < 0)
+	    goto done;
+	xmodst = NULL;
+    }
+    /* Shards of modules without content, or all if not sharded */
+    if (xmldb_shard_rm(h, dbfile, mods) < 0)
+	goto done;
+    if (xmldb_image_write(h, dbfile, x0) < 0)
+	goto done;
+    retval = 0;
+ done:
+    /* Remove modules state and sorted attribute after writing to file
+     */
+    if (xmodst && xml_purge(xmodst) < 0)
+	retval = -1;
+    if (xa && xml_parent(xa) == x0 && xml_purge(xa) < 0)
+	retval = -1;
+    else if (xa && xml_parent(xa) == NULL)
+	xml_free(xa);
+    if (sorted)
+	xml_flag_set(x0, XML_FLAG_SORTED);
+    if (xs)
+	xml_free(xs);
+    if (mods)
+	cvec_free(mods);
+    if (fz)
+	fclose(fz);
+    if (f != NULL){
+	fclose(f);
+	unlink(tmp);
+    }
+    if (buf)
+	free(buf);
+    if (tmp)
+	free(tmp);
+    return retval;
+}
+
+/*! Serialize an edit as a journal record
+ * A record looks like: <edit operation="merge" xmlns...><config>...</config></edit>
+ * Namespace declarations of the ancestors of x1 (eg the rpc) are added to the record so
+ * that it can be parsed on its own when replayed.
+ * @param[in]  x1     Modification tree, top-level is "config"
+ * @param[in]  op     Top-level operation
+ * @param[out] cb     Record is appended to this buffer
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_journal_replay
+ */
+static int
+xmldb_journal_record(cxobj              *x1,
+		     enum operation_type op,
+		     cbuf               *cb)
+{
+    int     retval = -1;
+    cvec   *nsc = NULL;
+    cg_var *cv = NULL;
+    char   *prefix;
+
+    cprintf(cb, "<%s operation=\"%s\"", XMLDB_JOURNAL_EDIT, xml_operation2str(op));
+    if (xml_parent(x1) != NULL){
+	if (xml_nsctx_node(xml_parent(x1), &nsc) < 0)
+	    goto done;
+	while ((cv = cvec_each(nsc, cv)) != NULL){
+	    if ((prefix = cv_name_get(cv)) == NULL)
+		cprintf(cb, " xmlns=\"%s\"", cv_string_get(cv));
+	    else
+		cprintf(cb, " xmlns:%s=\"%s\"", prefix, cv_string_get(cv));
+	}
+    }
+    cprintf(cb, ">");
+    if (clicon_xml2cbuf(cb, x1, 0, 0, -1) < 0)
+	goto done;
+    cprintf(cb, "</%s>\n", XMLDB_JOURNAL_EDIT);
+    retval = 0;
+ done:
+    if (nsc)
+	xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Append a serialized edit record to the journal of a datastore
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  cbj    Journal record as created by xmldb_journal_record
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_journal_append(clicon_handle h,
+		     const char   *db,
+		     cbuf         *cbj)
+{
+    int   retval = -1;
+    char *jfile = NULL;
+    FILE *f = NULL;
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+	goto done;
+    if ((f = fopen(jfile, "a")) == NULL){
+	clicon_err(OE_CFG, errno, "Opening journal %s", jfile);
+	goto done;
+    }
+    if (fwrite(cbuf_get(cbj), 1, cbuf_len(cbj), f) != cbuf_len(cbj) ||
+	fflush(f) != 0){
+	clicon_err(OE_UNIX, errno, "fwrite(%s)", jfile);
+	goto done;
+    }
+    if (xmldb_file_sync(h, fileno(f), jfile) < 0)
+	goto done;
+    /* The journal may have been created */
+    if (xmldb_dir_sync(h) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (f != NULL)
+	fclose(f);
+    if (jfile)
+	free(jfile);
+    return retval;
+}
+
+/*! Replay the journal of a datastore, if any, on a datastore tree read from file
+ * Each record is applied as an edit with NACM disabled, since it was already
+ * authorized when it was first applied.
+ * A record that fails is logged and skipped: it may be a remnant of an interrupted
+ * compaction whose changes are already in the datastore file.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  x0     Datastore top-level tree, bound to yang and sorted
+ * @param[out] nrp    Number of records replayed (if not NULL)
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_journal_record
+ */
+int
+xmldb_journal_replay(clicon_handle h,
+		     const char   *db,
+		     yang_stmt    *yspec,
+		     cxobj        *x0,
+		     int          *nrp)
+{
+    int                 retval = -1;
+    char               *jfile = NULL;
+    FILE               *fp = NULL;
+    cxobj              *xj = NULL;
+    cxobj              *xe;
+    cxobj              *x1;
+    char               *opstr;
+    enum operation_type op;
+    cbuf               *cbret = NULL;
+    int                 nr = 0;
+    int                 ret;
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+	goto done;
+    if ((fp = fopen(jfile, "r")) == NULL){
+	if (errno != ENOENT){
+	    clicon_err(OE_UNIX, errno, "open(%s)", jfile);
+	    goto done;
+	}
+	goto ok;
+    }
+    if (clixon_xml_parse_file(fp, YB_NONE, yspec, &xj, NULL) < 0)
+	goto done;
+    if ((cbret = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    xe = NULL;
+    while ((xe = xml_child_each(xj, xe, CX_ELMNT)) != NULL){
+	if (strcmp(xml_name(xe), XMLDB_JOURNAL_EDIT) != 0 ||
+	    (x1 = xml_find_type(xe, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) == NULL)
+	    continue;
+	nr++;
+	op = OP_MERGE;
+	if ((opstr = xml_find_value(xe, "operation")) != NULL)
+	    if (xml_operation(opstr, &op) < 0)
+		goto done;
+	cbuf_reset(cbret);
+	clicon_data_del(h, "objectexisted");
+	if ((ret = text_modify_top(h, x0, x0, x1, x1, yspec, op, NULL, NULL, 1, cbret)) < 0)
+	    goto done;
+	if (ret == 0){
+	    clicon_log(LOG_WARNING, "%s: %s: skipping record %d: %s",
+		       __FUNCTION__, jfile, nr, cbuf_get(cbret));
+	    continue;
+	}
+	if (text_modify_cleanup(x0) < 0)
+	    goto done;
+    }
+    clicon_debug(1, "%s %s: %d records", __FUNCTION__, db, nr);
+ ok:
+    if (nrp)
+	*nrp = nr;
+    retval = 0;
+ done:
+    if (cbret)
+	cbuf_free(cbret);
+    if (xj)
+	xml_free(xj);
+    if (fp)
+	fclose(fp);
+    if (jfile)
+	free(jfile);
+    return retval;
+}
+
+/*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
  * @param[in]  db     running or candidate
@@ -912,21 +2128,25 @@ xmldb_put(clicon_handle       h,
 {
     int                 retval = -1;
     char               *dbfile = NULL;
-    FILE               *f = NULL;
     cbuf               *cb = NULL;
     yang_stmt          *yspec;
     cxobj              *x0 = NULL;
     db_elmnt           *de = NULL;
+    db_elmnt            de1 = {0,}; /* If no db element, read status from file here */
     int                 ret;
     cxobj              *xnacm = NULL;
-    cxobj              *xmodst = NULL;
-    cxobj              *x;
     int                 permit = 0; /* nacm permit all */
-    char               *format;
     cvec               *nsc = NULL; /* nacm namespace context */
     int                 firsttime = 0;
-    int                 pretty;
+    cbuf               *cbj = NULL; /* Journal record */
+    int                 njournal;   /* Nr of records in journal */
+    int                 compact;
+    int                 bulk;       /* Bulk load, file is written at end */
+    int                 transient;  /* Cache only, file is written by xmldb_flush */
+    cvec               *dirty = NULL; /* Modules of edit, see CLICON_XMLDB_SHARD */
+    struct timespec     t0;
 
+    clixon_trace_start(&t0);
     if (cbret == NULL){
 	clicon_err(OE_XML, EINVAL, "cbret is NULL");
 	goto done;
@@ -940,6 +2160,12 @@ xmldb_put(clicon_handle       h,
 		   xml_name(x1), NETCONF_INPUT_CONFIG);
 	goto done;
     }
+    if (xmldb_generation_incr(h, db) < 0)
+	goto done;
+    if (clicon_datastore_cache(h) != DATASTORE_NOCACHE)
+	/* Copy-on-write if the cache is shared with another datastore */
+	if (xmldb_cache_unshare(h, db) < 0)
+	    goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
 	if (clicon_datastore_cache(h) != DATASTORE_NOCACHE)
 	    x0 = de->de_xml; /* XXX flag is not XML_FLAG_TOP */
@@ -948,7 +2174,7 @@ xmldb_put(clicon_handle       h,
     if (x0 == NULL){
 	firsttime++; /* to avoid leakage on error, see fail from text_modify */
 	/* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-	if ((ret = xmldb_readfile(h, db, YB_MODULE_NEXT, yspec, &x0, de, NULL)) < 0)
+	if ((ret = xmldb_readfile(h, db, YB_MODULE_NEXT, yspec, &x0, de?de:&de1, NULL)) < 0)
 	    goto done;
 	if (ret == 0)
 	    goto fail;
@@ -971,6 +2197,28 @@ xmldb_put(clicon_handle       h,
 
     /* Here assume if xnacm is set and !permit do NACM */
     clicon_data_del(h, "objectexisted");
+    bulk = (clicon_datastore_cache(h) != DATASTORE_NOCACHE &&
+	    de != NULL && de->de_bulk != 0);
+    transient = xmldb_transient(h, db);
+    /* Serialize the edit for the journal before it is applied since text_modify may
+     * add attributes to x1. A top-level replace rewrites the whole datastore anyway.
+     */
+    if (!bulk && !transient && clicon_datastore_persist(h) == DATASTORE_JOURNAL &&
+	x1 != NULL && op != OP_REPLACE){
+	if ((cbj = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	if (xmldb_journal_record(x1, op, cbj) < 0)
+	    goto done;
+    }
+    /* Only the shards of the modules of the edit are written, unless edits in a
+     * journal are written with it
+     */
+    if (clicon_optv(h)->co_xmldb_shard && x1 != NULL && op != OP_REPLACE &&
+	(de?de->de_journal:de1.de_journal) == 0)
+	if (xmldb_shard_dirty(x1, &dirty) < 0)
+	    goto done;
     /* 
      * Modify base tree x with modification x1. This is where the
      * new tree is made.
@@ -987,23 +2235,25 @@ xmldb_put(clicon_handle       h,
 	goto fail;
     }
 
-    /* Remove NONE nodes if all subs recursively are also NONE */
-    if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
-	goto done;
-    if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, 
-		  (void*)(XML_FLAG_NONE|XML_FLAG_MARK)) < 0)
-	goto done;
-    /* Mark non-presence containers as XML_FLAG_DEFAULT */
-    if (xml_apply(x0, CX_ELMNT, xml_nopresence_default_mark, (void*)XML_FLAG_DEFAULT) < 0)
-	goto done;
-    /* Clear XML tree of defaults */
-    if (xml_tree_prune_flagged(x0, XML_FLAG_DEFAULT, 1) < 0)
+    if (text_modify_cleanup(x0) < 0)
 	goto done;
 #if 0 /* debug */
     if (xml_apply0(x0, -1, xml_sort_verify, NULL) < 0)
 	clicon_log(LOG_NOTICE, "%s: verify failed #3", __FUNCTION__);
 #endif
-
+    /* Append to journal unless it is time to compact it into the datastore file */
+    njournal = de?de->de_journal:de1.de_journal;
+    if (cbj != NULL){
+	compact = clicon_optv(h)->co_xmldb_journal_compact;
+	if (compact > 0 && njournal >= compact){
+	    cbuf_free(cbj);
+	    cbj = NULL;
+	}
+    }
+    if (cbj != NULL)
+	njournal++;
+    else if (!bulk)
+	njournal = 0;
     /* Write back to datastore cache if first time */
     if (clicon_datastore_cache(h) != DATASTORE_NOCACHE){
 	db_elmnt de0 = {0,};
@@ -1012,58 +2262,281 @@ xmldb_put(clicon_handle       h,
 	if (de0.de_xml == NULL)
 	    de0.de_xml = x0;
 	de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
+	de0.de_journal = njournal;
+	if (transient)
+	    de0.de_unsaved = 1;
 	clicon_db_elmnt_set(h, db, &de0);
     }
+    if (transient){
+	/* The datastore file is written by xmldb_flush */
+    }
+    else if (bulk){
+	/* The datastore file is written when the bulk load ends, see xmldb_bulk_end */
+    }
+    else if (cbj != NULL){
+	if (xmldb_journal_append(h, db, cbj) < 0)
+	    goto done;
+    }
+    else {
+	if (xmldb_db2file(h, db, &dbfile) < 0)
+	    goto done;
+	if (dbfile==NULL){
+	    clicon_err(OE_XML, 0, "dbfile NULL");
+	    goto done;
+	}
+	if (xmldb_write_file(h, dbfile, x0, dirty) < 0)
+	    goto done;
+	/* The datastore file is now complete, any journal is obsolete */
+	if (xmldb_journal_rm(h, db) < 0)
+	    goto done;
+    }
+    retval = 1;
+ done:
+    if (dirty)
+	cvec_free(dirty);
+    if (cbj)
+	cbuf_free(cbj);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (dbfile)
+	free(dbfile);
+    if (cb)
+	cbuf_free(cb);
+    if (x0 && clicon_datastore_cache(h) == DATASTORE_NOCACHE)
+	xml_free(x0);
+    clixon_trace_end(&t0, "xmldb-put", db);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Replace the whole content of a database with a tree without copying it
+ *
+ * As xmldb_put with a top-level replace but without comparing and copying xt into
+ * the existing tree. The tree should be bound to YANG and sorted, without default
+ * values and flags, as after xmldb_get0_clear.
+ * No NACM check is made.
+ * @param[in]     h   Clicon handle
+ * @param[in]     db  Name of database, eg "running"
+ * @param[in,out] xtp XML tree with top-level "config". If the datastore is cached the
+ *                    tree is moved into the cache and *xtp is set to NULL, otherwise
+ *                    the caller still owns it
+ * @retval        0   OK
+ * @retval       -1   Error
+ * @see xmldb_get_detach  for the corresponding read
+ */
+int
+xmldb_replace(clicon_handle h,
+	      const char   *db,
+	      cxobj       **xtp)
+{
+    int       retval = -1;
+    cxobj    *xt = *xtp;
+    db_elmnt *de;
+    db_elmnt  de0 = {0,};
+    char     *dbfile = NULL;
+
+    if (xml_name_set(xt, DATASTORE_TOP_SYMBOL) < 0)
+	goto done;
+    xml_flag_set(xt, XML_FLAG_TOP);
+    /* Free old cache (if any) */
+    if (xmldb_clear(h, db) < 0)
+	goto done;
     if (xmldb_db2file(h, db, &dbfile) < 0)
 	goto done;
     if (dbfile==NULL){
 	clicon_err(OE_XML, 0, "dbfile NULL");
 	goto done;
     }
-    /* Add module revision info before writing to file)
-     * Only if CLICON_XMLDB_MODSTATE is set
-     */
-    if ((x = clicon_modst_cache_get(h, 1)) != NULL){
-	if ((xmodst = xml_dup(x)) == NULL)
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de0 = *de;
+    /* The file of a datastore kept in cache only is written by xmldb_flush */
+    if ((de0.de_unsaved = xmldb_transient(h, db)) == 0){
+	if (xmldb_write_file(h, dbfile, xt, NULL) < 0)
 	    goto done;
-	if (xml_addsub(x0, xmodst) < 0)
+	/* The datastore file is now complete, any journal is obsolete */
+	if (xmldb_journal_rm(h, db) < 0)
 	    goto done;
     }
-    if ((format = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
-	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
+    de0.de_empty = (xml_child_nr(xt) == 0);
+    de0.de_journal = 0;
+    de0.de_defaults = 0;
+    if (clicon_datastore_cache(h) != DATASTORE_NOCACHE){
+	de0.de_xml = xt;
+	*xtp = NULL;
+    }
+    clicon_db_elmnt_set(h, db, &de0);
+    retval = 0;
+ done:
+    if (dbfile)
+	free(dbfile);
+    return retval;
+}
+
+/*! Write the cache of a datastore being bulk loaded to its file
+ * Any journal is removed since the datastore file is complete.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see xmldb_bulk_end
+ */
+int
+xmldb_bulk_write(clicon_handle h,
+		 const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+    char     *dbfile = NULL;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	de->de_xml == NULL){
+	retval = 0;
 	goto done;
     }
-    if ((f = fopen(dbfile, "w")) == NULL){
-	clicon_err(OE_CFG, errno, "Creating file %s", dbfile);
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+	goto done;
+    if (dbfile==NULL){
+	clicon_err(OE_XML, 0, "dbfile NULL");
 	goto done;
-    } 
-    pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
-    if (strcmp(format,"json")==0){
-	if (xml2json(f, x0, pretty) < 0)
-	    goto done;
     }
-    else if (clicon_xml2file(f, x0, 0, pretty) < 0)
+    if (xmldb_write_file(h, dbfile, de->de_xml, NULL) < 0)
 	goto done;
-    /* Remove modules state after writing to file
-     */
-    if (xmodst && xml_purge(xmodst) < 0)
+    if (xmldb_journal_rm(h, db) < 0)
 	goto done;
-    retval = 1;
+    de->de_journal = 0;
+    de->de_unsaved = 0;
+    clicon_db_elmnt_set(h, db, de);
+    retval = 0;
  done:
-    if (f != NULL)
-	fclose(f);
-    if (nsc)
-	xml_nsctx_free(nsc);
     if (dbfile)
 	free(dbfile);
-    if (cb)
-	cbuf_free(cb);
-    if (x0 && clicon_datastore_cache(h) == DATASTORE_NOCACHE)
-	xml_free(x0);
     return retval;
- fail:
+}
+
+/*! Start a bulk load of a datastore
+ * While a bulk load is active, xmldb_put only modifies the datastore cache and the
+ * datastore file is written once by xmldb_bulk_end. This avoids writing a large
+ * datastore on each of many edits, eg when a configuration file is loaded in chunks.
+ * Without datastore cache, the datastore file is written on each edit as usual.
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @param[in]  id  Session id
+ * @retval -1  Error
+ * @retval  0  OK
+ * @see xmldb_bulk_end
+ */
+int
+xmldb_bulk_begin(clicon_handle h,
+		 const char   *db,
+		 uint32_t      id)
+{
+    db_elmnt  *de = NULL;
+    db_elmnt   de0 = {0,};
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+	de0 = *de;
+    de0.de_bulk = id;
+    clicon_db_elmnt_set(h, db, &de0);
+    clicon_debug(1, "%s: bulk load by %u",  db, id);
+    return 0;
+}
+
+/*! End a bulk load of a datastore and write the datastore file
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval -1  Error
+ * @retval  0  OK
+ * @see xmldb_bulk_begin
+ */
+int
+xmldb_bulk_end(clicon_handle h,
+	       const char   *db)
+{
+    int       retval = -1;
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	de->de_bulk == 0){
+	retval = 0;
+	goto done;
+    }
+    de->de_bulk = 0;
+    clicon_db_elmnt_set(h, db, de);
+    /* The file of a datastore kept in cache only is written by xmldb_flush */
+    if (!xmldb_transient(h, db) &&
+	xmldb_bulk_write(h, db) < 0)
+	goto done;
     retval = 0;
-    goto done;
+ done:
+    return retval;
+}
+
+/*! Write the file of a datastore kept in cache only, if changed since last written
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval -1  Error
+ * @retval  0  OK
+ * @see CLICON_XMLDB_TRANSIENT
+ */
+int
+xmldb_flush(clicon_handle h,
+	    const char   *db)
+{
+    db_elmnt *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+	de->de_unsaved == 0)
+	return 0;
+    return xmldb_bulk_write(h, db);
+}
+
+/*! End all bulk loads of a session (eg process dies)
+ * @param[in]    h   Clicon handle
+ * @param[in]    id  Session id
+ * @retval -1    Error
+ * @retval  0   OK
+ */
+int
+xmldb_bulk_end_all(clicon_handle h,
+		   uint32_t      id)
+{
+    int                 retval = -1;
+    char              **keys = NULL;
+    size_t              klen;
+    int                 i;
+    db_elmnt           *de;
+
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+	goto done;
+    for (i = 0; i < klen; i++) 
+	if ((de = clicon_db_elmnt_get(h, keys[i])) != NULL &&
+	    de->de_bulk == id)
+	    if (xmldb_bulk_end(h, keys[i]) < 0)
+		goto done;
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Check if a datastore is being bulk loaded
+ * @param[in] h   Clicon handle
+ * @param[in] db  Database
+ * @retval    0   No bulk load
+ * @retval    >0  Session id of bulk load
+ */
+uint32_t
+xmldb_bulk_get(clicon_handle h,
+	       const char   *db)
+{
+    db_elmnt  *de;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+	return 0;
+    return de->de_bulk;
 }
 
 /* Dump a datastore to file including modstate
@@ -1076,7 +2549,7 @@ xmldb_dump(clicon_handle   h,
     int    retval = -1;
     cxobj *x;
     cxobj *xmodst = NULL;
-    char  *format;
+    int    format;
     int    pretty;
     
     /* clear XML tree of defaults */
@@ -1089,15 +2562,19 @@ xmldb_dump(clicon_handle   h,
 	if (xml_child_insert_pos(xt, xmodst, 0) < 0)
 	    goto done;
     }
-    if ((format = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
+    if ((format = clicon_optv(h)->co_xmldb_format) < 0){
 	clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
 	goto done;
     }
-    pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
-    if (strcmp(format,"json")==0){
+    pretty = clicon_optv(h)->co_xmldb_pretty;
+    if (format == FORMAT_JSON){
 	if (xml2json(f, xt, pretty) < 0)
 	    goto done;
     }
+    else if (format == FORMAT_CBOR){
+	if (xmldb_cbor2file(f, xt) < 0)
+	    goto done;
+    }
     else if (clicon_xml2file(f, xt, 0, pretty) < 0)
 	goto done;
     retval = 0;
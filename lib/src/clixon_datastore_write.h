@@ -38,6 +38,23 @@
 #ifndef _CLIXON_DATASTORE_WRITE_H
 #define _CLIXON_DATASTORE_WRITE_H
 
+/*
+ * Constants
+ */
+/* Element name of an edit record in a datastore journal, see CLICON_XMLDB_PERSIST */
+#define XMLDB_JOURNAL_EDIT "edit"
+/* Attribute of top-level element of a datastore file in canonical (sorted) order,
+ * eg <config clixon-sorted="1a2b3c4d">, value see xmldb_sorted_value */
+#define XMLDB_SORTED_ATTR "clixon-sorted"
+/* Length of value of XMLDB_SORTED_ATTR including null */
+#define XMLDB_SORTED_LEN 9
+/* Attribute of top-level element of a datastore file whose content is in shard files,
+ * eg <config clixon-sharded="true">, see CLICON_XMLDB_SHARD */
+#define XMLDB_SHARDED_ATTR "clixon-sharded"
+/* Shard files of <db>_db are <db>_db.d/<module>.xml */
+#define XMLDB_SHARD_DIR_SUFFIX ".d"
+#define XMLDB_SHARD_SUFFIX ".xml"
+
 /*
  * Types
  */
@@ -45,6 +62,13 @@
 /*
  * Prototypes
  */
+int xmldb_sorted_value(yang_stmt *yspec, char *buf, size_t len);
 int xmldb_put(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
+int xmldb_bulk_write(clicon_handle h, const char *db);
+int xmldb_journal_replay(clicon_handle h, const char *db, yang_stmt *yspec, cxobj *x0, int *nrp);
+int xmldb_file_copy(clicon_handle h, const char *from, const char *to);
+int xmldb_shard_dir(const char *dbfile, char **dir);
+int xmldb_shard_rm(clicon_handle h, const char *dbfile, cvec *keep);
+int xmldb_shard_copy(clicon_handle h, const char *from, const char *to);
 
 #endif /* _CLIXON_DATASTORE_WRITE_H */
@@ -44,13 +44,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
 #include <syslog.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#ifdef EVENT_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -61,6 +66,9 @@
 #include "clixon_err.h"
 #include "clixon_sig.h"
 #include "clixon_proc.h"
+#include "clixon_sample.h"
+#include "clixon_options.h"
+#include "clixon_string.h"
 #include "clixon_event.h"
 
 /*
@@ -68,17 +76,37 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of ready file descriptors returned from one epoll_wait */
+#define EVENT_EPOLL_MAX 64
+
 /*
  * Types
  */
+/* Callback statistics, aggregated on the describing string of the registration */
+struct event_stats{
+    struct event_stats *es_next;
+    char                es_name[EVENT_STRLEN]; /* describing string of callback */
+    uint64_t            es_calls;     /* Number of calls */
+    uint64_t            es_total;     /* Total time in callback in us */
+    uint64_t            es_max;       /* Max time of a single call in us */
+};
+
 struct event_data{
     struct event_data *e_next;     /* next in list */
     int (*e_fn)(int, void*);            /* function */
     enum {EVENT_FD, EVENT_TIME} e_type;        /* type of event */
     int e_fd;                      /* File descriptor */
+    int e_write;                   /* Wait for fd to be writable instead of readable */
     struct timeval e_time;         /* Timeout */
     void *e_arg;                   /* function argument */
     char e_string[EVENT_STRLEN];             /* string for debugging */
+    uint64_t e_seq;                /* Registration order, FIFO for equal timer times */
+    uint64_t e_round;              /* Last dispatch round fd callback was called in */
+    struct event_stats *e_stats;   /* Callback statistics */
+#ifdef EVENT_EPOLL
+    struct event_data *e_fdnext;   /* next with same fd in ee_fdtab */
+    int e_nopoll;                  /* fd cannot be polled (eg regular file), always ready */
+#endif
 };
 
 /*
@@ -86,7 +114,27 @@ struct event_data{
  * XXX consider use handle variables instead of global
  */
 static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
+
+/* Timers as a binary min-heap on e_time (and e_seq) */
+static struct event_data **ee_timers = NULL;
+static size_t              ee_timers_len = 0;
+static size_t              ee_timers_max = 0;
+
+/* Registration counter, events registered during a dispatch round are not called */
+static uint64_t            ee_seq = 0;
+
+/* Dispatch round, incremented in every wait for file descriptors */
+static uint64_t            ee_round = 0;
+
+static struct event_stats *ee_stats = NULL;
+
+#ifdef EVENT_EPOLL
+static int                 ee_epfd = -1;    /* epoll instance */
+static pid_t               ee_eppid = 0;    /* process that created ee_epfd */
+static struct event_data **ee_fdtab = NULL; /* fd -> events registered on fd */
+static int                 ee_fdtab_max = 0;
+static int                 ee_nopoll = 0;   /* Nr of registered non-pollable fds */
+#endif
 
 /* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
 static int _ee_unreg = 0;
@@ -155,6 +203,300 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
+/*! Compare two timers in heap order: time first, then registration order
+ * @retval 1   e0 should be called before e1
+ * @retval 0   e1 should be called before e0
+ */
+static int
+event_timer_lt(struct event_data *e0,
+	       struct event_data *e1)
+{
+    if (timercmp(&e0->e_time, &e1->e_time, <))
+	return 1;
+    if (timercmp(&e0->e_time, &e1->e_time, ==) && e0->e_seq < e1->e_seq)
+	return 1;
+    return 0;
+}
+
+/*! Move timer at index i up in the heap until heap order holds
+ */
+static void
+event_timer_up(size_t i)
+{
+    struct event_data *e = ee_timers[i];
+    size_t             p;
+
+    while (i > 0){
+	p = (i - 1) / 2;
+	if (!event_timer_lt(e, ee_timers[p]))
+	    break;
+	ee_timers[i] = ee_timers[p];
+	i = p;
+    }
+    ee_timers[i] = e;
+}
+
+/*! Move timer at index i down in the heap until heap order holds
+ */
+static void
+event_timer_down(size_t i)
+{
+    struct event_data *e = ee_timers[i];
+    size_t             c;
+
+    while ((c = 2*i + 1) < ee_timers_len){
+	if (c + 1 < ee_timers_len && event_timer_lt(ee_timers[c+1], ee_timers[c]))
+	    c++;
+	if (!event_timer_lt(ee_timers[c], e))
+	    break;
+	ee_timers[i] = ee_timers[c];
+	i = c;
+    }
+    ee_timers[i] = e;
+}
+
+/*! Remove timer at index i from the heap and return it
+ */
+static struct event_data *
+event_timer_remove(size_t i)
+{
+    struct event_data *e = ee_timers[i];
+
+    if (--ee_timers_len > i){
+	ee_timers[i] = ee_timers[ee_timers_len];
+	if (i > 0 && event_timer_lt(ee_timers[i], ee_timers[(i-1)/2]))
+	    event_timer_up(i);
+	else
+	    event_timer_down(i);
+    }
+    ee_timers[ee_timers_len] = NULL;
+    return e;
+}
+
+#ifdef EVENT_EPOLL
+/*! Get epoll event mask of all events registered on a file descriptor
+ * @param[in]  fd    File descriptor, must be in fd table
+ * @retval     mask  EPOLLIN and/or EPOLLOUT
+ */
+static uint32_t
+event_epoll_mask(int fd)
+{
+    struct event_data *e;
+    uint32_t           mask = 0;
+
+    for (e = ee_fdtab[fd]; e; e = e->e_fdnext)
+	mask |= e->e_write?EPOLLOUT:EPOLLIN;
+    return mask;
+}
+
+/*! Get epoll instance, create it if not done or if created by parent process
+ * An epoll instance inherited over fork is shared with the parent, ie a registration
+ * in the child would also change the parent. Therefore create a new instance in the
+ * child and add all existing file descriptors to it.
+ * @retval  fd  epoll file descriptor
+ * @retval  -1  Error
+ */
+static int
+event_epoll_fd(void)
+{
+    struct event_data *e;
+    struct epoll_event ev = {0,};
+
+    if (ee_epfd != -1 && ee_eppid == getpid())
+	return ee_epfd;
+    if (ee_epfd != -1)
+	close(ee_epfd);
+    if ((ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+	clicon_err(OE_EVENTS, errno, "epoll_create1");
+	return -1;
+    }
+    ee_eppid = getpid();
+    for (e=ee; e; e=e->e_next){
+	if (e->e_nopoll)
+	    continue;
+	ev.events = event_epoll_mask(e->e_fd);
+	ev.data.fd = e->e_fd;
+	if (epoll_ctl(ee_epfd, EPOLL_CTL_ADD, e->e_fd, &ev) < 0 && errno != EEXIST){
+	    clicon_err(OE_EVENTS, errno, "epoll_ctl");
+	    return -1;
+	}
+    }
+    return ee_epfd;
+}
+
+/*! Add fd event to epoll instance and fd table
+ * If other events are registered on the fd, the epoll mask is the union of them.
+ * @param[in]  e   Event of type EVENT_FD
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_epoll_add(struct event_data *e)
+{
+    int                epfd;
+    struct epoll_event ev = {0,};
+    struct event_data **tab;
+    int                max;
+
+    if (e->e_fd < 0){
+	clicon_err(OE_EVENTS, EBADF, "Invalid file descriptor: %d", e->e_fd);
+	return -1;
+    }
+    if ((epfd = event_epoll_fd()) < 0)
+	return -1;
+    if (e->e_fd >= ee_fdtab_max){
+	max = ee_fdtab_max?ee_fdtab_max:64;
+	while (max <= e->e_fd)
+	    max *= 2;
+	if ((tab = realloc(ee_fdtab, max*sizeof(*tab))) == NULL){
+	    clicon_err(OE_EVENTS, errno, "realloc");
+	    return -1;
+	}
+	memset(&tab[ee_fdtab_max], 0, (max-ee_fdtab_max)*sizeof(*tab));
+	ee_fdtab = tab;
+	ee_fdtab_max = max;
+    }
+    e->e_fdnext = ee_fdtab[e->e_fd];
+    ee_fdtab[e->e_fd] = e;
+    ev.events = event_epoll_mask(e->e_fd);
+    ev.data.fd = e->e_fd;
+    /* Always add: a closed fd is silently removed from epoll, its number may be reused */
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, e->e_fd, &ev) < 0){
+	if (errno == EPERM){ /* Eg regular file, select considers it always readable */
+	    e->e_nopoll = 1;
+	    ee_nopoll++;
+	}
+	else if (errno != EEXIST ||
+		 epoll_ctl(epfd, EPOLL_CTL_MOD, e->e_fd, &ev) < 0){
+	    clicon_err(OE_EVENTS, errno, "epoll_ctl");
+	    ee_fdtab[e->e_fd] = e->e_fdnext;
+	    return -1;
+	}
+    }
+    return 0;
+}
+
+/*! Remove fd event from fd table, and from epoll instance if last on that fd
+ * Otherwise the epoll mask is changed to that of the remaining events on the fd.
+ * @param[in]  e   Event of type EVENT_FD
+ */
+static void
+event_epoll_del(struct event_data *e)
+{
+    struct event_data **ep;
+    struct epoll_event  ev = {0,};
+
+    if (e->e_nopoll)
+	ee_nopoll--;
+    if (e->e_fd < 0 || e->e_fd >= ee_fdtab_max)
+	return;
+    for (ep = &ee_fdtab[e->e_fd]; *ep; ep = &(*ep)->e_fdnext)
+	if (*ep == e){
+	    *ep = e->e_fdnext;
+	    break;
+	}
+    /* Fd may already be closed which also removes it from epoll, ignore errors */
+    if (e->e_nopoll || ee_epfd == -1 || ee_eppid != getpid())
+	return;
+    if (ee_fdtab[e->e_fd] == NULL)
+	epoll_ctl(ee_epfd, EPOLL_CTL_DEL, e->e_fd, NULL);
+    else {
+	ev.events = event_epoll_mask(e->e_fd);
+	ev.data.fd = e->e_fd;
+	epoll_ctl(ee_epfd, EPOLL_CTL_MOD, e->e_fd, &ev);
+    }
+}
+#endif /* EVENT_EPOLL */
+
+/*! Get statistics entry of a callback describing string, create if not found
+ * @param[in]  str  Describing string of callback registration
+ * @retval     es   Statistics entry
+ * @retval     NULL Error
+ */
+static struct event_stats *
+event_stats_get(char *str)
+{
+    struct event_stats *es;
+
+    for (es = ee_stats; es; es = es->es_next)
+	if (strncmp(es->es_name, str, EVENT_STRLEN-1) == 0)
+	    return es;
+    if ((es = (struct event_stats *)malloc(sizeof(struct event_stats))) == NULL){
+	clicon_err(OE_EVENTS, errno, "malloc");
+	return NULL;
+    }
+    memset(es, 0, sizeof(struct event_stats));
+    strncpy(es->es_name, str, EVENT_STRLEN-1);
+    es->es_next = ee_stats;
+    ee_stats = es;
+    return es;
+}
+
+/*! Register time spent in a callback in its statistics entry
+ * @param[in]  es  Statistics entry
+ * @param[in]  t0  Time when callback was called
+ */
+static void
+event_stats_add(struct event_stats *es,
+		struct timeval     *t0)
+{
+    struct timeval t1;
+    struct timeval t;
+    uint64_t       us;
+
+    gettimeofday(&t1, NULL);
+    timersub(&t1, t0, &t);
+    us = t.tv_sec<0 ? 0 : (uint64_t)t.tv_sec*1000000 + t.tv_usec;
+    es->es_calls++;
+    es->es_total += us;
+    if (us > es->es_max)
+	es->es_max = us;
+}
+
+/*! Register a file descriptor callback, either on input or when fd is writable
+ * @param[in]  fd    File descriptor
+ * @param[in]  fn    Function to call
+ * @param[in]  arg   Argument to function fn
+ * @param[in]  str   Describing string for logging
+ * @param[in]  write If set, call fn when fd is writable, otherwise on input
+ */
+static int
+event_reg_fd(int   fd, 
+	     int (*fn)(int, void*), 
+	     void *arg, 
+	     char *str,
+	     int   write)
+{
+    struct event_data *e;
+
+    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
+	clicon_err(OE_EVENTS, errno, "malloc");
+	return -1;
+    }
+    memset(e, 0, sizeof(struct event_data));
+    strncpy(e->e_string, str, EVENT_STRLEN);
+    e->e_fd = fd;
+    e->e_write = write;
+    e->e_fn = fn;
+    e->e_arg = arg;
+    e->e_type = EVENT_FD;
+    e->e_seq = ee_seq++;
+    if ((e->e_stats = event_stats_get(e->e_string)) == NULL){
+	free(e);
+	return -1;
+    }
+#ifdef EVENT_EPOLL
+    if (event_epoll_add(e) < 0){
+	free(e);
+	return -1;
+    }
+#endif
+    e->e_next = ee;
+    ee = e;
+    clicon_debug(2, "%s, registering %s", __FUNCTION__, e->e_string);
+    return 0;
+}
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * @param[in]  fd  File descriptor
@@ -173,22 +515,27 @@ clixon_event_reg_fd(int   fd,
 		    void *arg, 
 		    char *str)
 {
-    struct event_data *e;
+    return event_reg_fd(fd, fn, arg, str, 0);
+}
 
-    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
-	clicon_err(OE_EVENTS, errno, "malloc");
-	return -1;
-    }
-    memset(e, 0, sizeof(struct event_data));
-    strncpy(e->e_string, str, EVENT_STRLEN);
-    e->e_fd = fd;
-    e->e_fn = fn;
-    e->e_arg = arg;
-    e->e_type = EVENT_FD;
-    e->e_next = ee;
-    ee = e;
-    clicon_debug(2, "%s, registering %s", __FUNCTION__, e->e_string);
-    return 0;
+/*! Register a callback function to be called when a file descriptor is writable
+ *
+ * Typically used for non-blocking output: register when a write would block, and
+ * deregister using clixon_event_unreg_fd when all output is written, otherwise fn
+ * is called in every round.
+ * @param[in]  fd  File descriptor
+ * @param[in]  fn  Function to call when fd is writable
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @see clixon_event_reg_fd
+ */
+int
+clixon_event_reg_fd_write(int   fd, 
+			  int (*fn)(int, void*), 
+			  void *arg, 
+			  char *str)
+{
+    return event_reg_fd(fd, fn, arg, str, 1);
 }
 
 /*! Deregister a file descriptor callback
@@ -196,6 +543,7 @@ clixon_event_reg_fd(int   fd,
  * @param[in]  fn  Function to call when input available on fd
  * Note: deregister when exactly function and socket match, not argument
  * @see clixon_event_reg_fd
+ * @see clixon_event_reg_fd_write
  * @see clixon_event_unreg_timeout
  */
 int
@@ -211,6 +559,9 @@ clixon_event_unreg_fd(int   s,
 	    found++;
 	    *e_prev = e->e_next;
 	    _ee_unreg++;
+#ifdef EVENT_EPOLL
+	    event_epoll_del(e);
+#endif
 	    free(e);
 	    break;
 	}
@@ -239,6 +590,7 @@ clixon_event_unreg_fd(int   s,
  * registration for each period, see example above.
  * Note also that the first argument to fn is a dummy, just to get the same
  * signature as for file-descriptor callbacks.
+ * Timers with equal time are called in registration order.
  * @see clixon_event_reg_fd
  * @see clixon_event_unreg_timeout
  */
@@ -248,8 +600,19 @@ clixon_event_reg_timeout(struct timeval t,
 			 void          *arg, 
 			 char          *str)
 {
-    struct event_data *e, *e1, **e_prev;
+    struct event_data  *e;
+    struct event_data **timers;
+    size_t              max;
 
+    if (ee_timers_len == ee_timers_max){
+	max = ee_timers_max?2*ee_timers_max:16;
+	if ((timers = realloc(ee_timers, max*sizeof(*timers))) == NULL){
+	    clicon_err(OE_EVENTS, errno, "realloc");
+	    return -1;
+	}
+	ee_timers = timers;
+	ee_timers_max = max;
+    }
     if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
 	clicon_err(OE_EVENTS, errno, "malloc");
 	return -1;
@@ -260,16 +623,14 @@ clixon_event_reg_timeout(struct timeval t,
     e->e_arg = arg;
     e->e_type = EVENT_TIME;
     e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-	if (timercmp(&e->e_time, &e1->e_time, <))
-	    break;
-	e_prev = &e1->e_next;
+    e->e_seq = ee_seq++;
+    if ((e->e_stats = event_stats_get(e->e_string)) == NULL){
+	free(e);
+	return -1;
     }
-    e->e_next = e1;
-    *e_prev = e;
-    clicon_debug(2, "%s: %s", __FUNCTION__, str); 
+    ee_timers[ee_timers_len++] = e;
+    event_timer_up(ee_timers_len-1);
+    clixon_debug(CLIXON_DBG_EVENT, 2, "%s: %s", __FUNCTION__, str); 
     return 0;
 }
 
@@ -277,6 +638,7 @@ clixon_event_reg_timeout(struct timeval t,
  * Note: deregister when exactly function and function arguments match, not time. So you
  * cannot have same function and argument callback on different timeouts. This is a little
  * different from clixon_event_unreg_fd.
+ * If several match, the one called first is removed.
  * @param[in]  fn  Function to call at time t
  * @param[in]  arg Argument to function fn
  * @see clixon_event_reg_timeout
@@ -286,20 +648,20 @@ int
 clixon_event_unreg_timeout(int (*fn)(int, void*), 
 			   void *arg)
 {
-    struct event_data *e, **e_prev;
-    int found = 0;
+    struct event_data *e;
+    size_t             i;
+    size_t             found = ee_timers_len;
 
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
-	if (fn == e->e_fn && arg == e->e_arg) {
-	    found++;
-	    *e_prev = e->e_next;
-	    free(e);
-	    break;
-	}
-	e_prev = &e->e_next;
+    for (i=0; i<ee_timers_len; i++){
+	e = ee_timers[i];
+	if (fn == e->e_fn && arg == e->e_arg &&
+	    (found == ee_timers_len || event_timer_lt(e, ee_timers[found])))
+	    found = i;
     }
-    return found?0:-1;
+    if (found == ee_timers_len)
+	return -1;
+    free(event_timer_remove(found));
+    return 0;
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
@@ -311,59 +673,271 @@ clixon_event_unreg_timeout(int (*fn)(int, void*),
 int 
 clixon_event_poll(int fd)
 {
-    int            retval = -1;
-    fd_set         fdset;
-    struct timeval tnull = {0,};
+    int           retval = -1;
+    struct pollfd pfd = {0,};
 
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-    if ((retval = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull)) < 0)
-	clicon_err(OE_EVENTS, errno, "select");
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if ((retval = poll(&pfd, 1, 0)) < 0)
+	clicon_err(OE_EVENTS, errno, "poll");
     return retval;
 }
 
-/*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
- * There is an issue with fairness that timeouts may take over all events
- * One could try to poll the file descriptors after a timeout?
+/*! Call a file descriptor callback
+ * @param[in]  e   Event of type EVENT_FD
+ * @retval     0   OK
+ * @retval    -1   Error in callback
+ */
+static int
+event_fd_call(struct event_data *e)
+{
+    struct timeval t0;
+    int            ret;
+
+    clixon_debug(CLIXON_DBG_EVENT, 2, "%s: FD_ISSET: %s", __FUNCTION__, e->e_string);
+    e->e_round = ee_round;
+    gettimeofday(&t0, NULL);
+    ret = (*e->e_fn)(e->e_fd, e->e_arg);
+    event_stats_add(e->e_stats, &t0); /* stats entries are never freed here */
+    if (ret < 0){
+	clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
+	return -1;
+    }
+    return 0;
+}
+
+/*! Check if fd callback should be called in this dispatch round
+ * Not if already called, or if registered after the wait, its fd was not waited for.
+ * @param[in]  e    Event of type EVENT_FD
+ * @param[in]  seq  Registration counter when waiting
+ */
+static int
+event_fd_callable(struct event_data *e,
+		  uint64_t           seq)
+{
+    return e->e_round != ee_round && e->e_seq < seq;
+}
+
+#ifdef EVENT_EPOLL
+/*! Check if fd callback should be called given the epoll events returned for its fd
+ * Errors and hangups are dispatched to both input and write callbacks.
+ * @param[in]  e       Event of type EVENT_FD
+ * @param[in]  events  Events returned from epoll_wait
+ */
+static int
+event_epoll_ready(struct event_data *e,
+		  uint32_t           events)
+{
+    if (e->e_write)
+	return (events & (EPOLLOUT|EPOLLERR|EPOLLHUP)) != 0;
+    return (events & (EPOLLIN|EPOLLERR|EPOLLHUP)) != 0;
+}
+
+/*! Wait for file descriptor events using epoll and dispatch them
+ * A callback may deregister file descriptors, in which case the remaining callbacks
+ * of the same fd are left to the next round. Since epoll is level-triggered they are
+ * returned again.
+ * @param[in]  tp      Timeout, or NULL for no timeout
+ * @param[in]  budget  Max number of callbacks to call, 0 means no limit
+ * @retval     n       Number of callbacks called
+ * @retval    -1       Error, errno set if wait failed, see clixon_event_loop
+ */
+static int
+event_wait_dispatch(struct timeval *tp,
+		    int             budget)
+{
+    struct epoll_event evs[EVENT_EPOLL_MAX];
+    struct event_data *e;
+    struct event_data *e_next;
+    int                epfd;
+    int                timeout = -1;
+    int                nev;
+    int                n = 0;
+    int                i;
+    uint64_t           seq;
+
+    if ((epfd = event_epoll_fd()) < 0){
+	errno = 0;
+	return -1;
+    }
+    if (ee_nopoll)
+	timeout = 0;
+    else if (tp) /* round up to not wake up before the timer */
+	timeout = tp->tv_sec*1000 + (tp->tv_usec+999)/1000;
+    if ((nev = epoll_wait(epfd, evs, EVENT_EPOLL_MAX, timeout)) < 0)
+	return -1;
+    ee_round++;
+    seq = ee_seq;
+    for (i=0; i<nev; i++){
+	_ee_unreg = 0;
+	for (e = ee_fdtab[evs[i].data.fd]; e; e = e_next){
+	    if (clicon_exit_get() || (budget && n >= budget))
+		return n;
+	    e_next = e->e_fdnext;
+	    if (!event_fd_callable(e, seq) || !event_epoll_ready(e, evs[i].events))
+		continue;
+	    n++;
+	    if (event_fd_call(e) < 0){
+		errno = 0;
+		return -1;
+	    }
+	    if (_ee_unreg) /* e_next may be freed */
+		break;
+	}
+    }
+    if (ee_nopoll){
+    again:
+	_ee_unreg = 0;
+	for (e=ee; e; e=e_next){
+	    if (clicon_exit_get() || (budget && n >= budget))
+		return n;
+	    e_next = e->e_next;
+	    if (!e->e_nopoll || !event_fd_callable(e, seq))
+		continue;
+	    n++;
+	    if (event_fd_call(e) < 0){
+		errno = 0;
+		return -1;
+	    }
+	    if (_ee_unreg)
+		goto again;
+	}
+    }
+    return n;
+}
+
+#else /* EVENT_EPOLL */
+/*! Wait for file descriptor events using select and dispatch them
+ * @param[in]  tp      Timeout, or NULL for no timeout
+ * @param[in]  budget  Max number of callbacks to call, 0 means no limit
+ * @retval     n       Number of callbacks called
+ * @retval    -1       Error, errno set if wait failed, see clixon_event_loop
+ */
+static int
+event_wait_dispatch(struct timeval *tp,
+		    int             budget)
+{
+    struct event_data *e;
+    struct event_data *e_next;
+    fd_set             fdset;
+    fd_set             wfdset;
+    int                n = 0;
+    uint64_t           seq;
+
+    FD_ZERO(&fdset);
+    FD_ZERO(&wfdset);
+    for (e=ee; e; e=e->e_next)
+	if (e->e_type == EVENT_FD)
+	    FD_SET(e->e_fd, e->e_write?&wfdset:&fdset);
+    if (select(FD_SETSIZE, &fdset, &wfdset, NULL, tp) < 0)
+	return -1;
+    ee_round++;
+    seq = ee_seq;
+ again:
+    _ee_unreg = 0;
+    for (e=ee; e; e=e_next){
+	if (clicon_exit_get() || (budget && n >= budget))
+	    break;
+	e_next = e->e_next;
+	if (e->e_type == EVENT_FD && FD_ISSET(e->e_fd, e->e_write?&wfdset:&fdset) &&
+	    event_fd_callable(e, seq)){
+	    n++;
+	    if (event_fd_call(e) < 0){
+		errno = 0;
+		return -1;
+	    }
+	    if (_ee_unreg) /* e_next may be freed, restart */
+		goto again;
+	}
+    }
+    return n;
+}
+#endif /* EVENT_EPOLL */
+
+/*! Call all expired timers
+ * Timers registered by the callbacks are left to the next round, also if expired.
+ * @param[in]  budget  Max number of timers to call, 0 means no limit
+ * @retval     n       Number of timers called
+ * @retval    -1       Error in callback
+ */
+static int
+event_timers_dispatch(int budget)
+{
+    struct event_data *e;
+    struct timeval     t0;
+    uint64_t           seq = ee_seq;
+    int                n = 0;
+    int                ret;
+
+    gettimeofday(&t0, NULL);
+    while (ee_timers_len &&
+	   !timercmp(&ee_timers[0]->e_time, &t0, >) &&
+	   ee_timers[0]->e_seq < seq &&
+	   (budget == 0 || n < budget)){
+	if (clicon_exit_get())
+	    break;
+	e = event_timer_remove(0);
+	n++;
+	clixon_debug(CLIXON_DBG_EVENT, 2, "%s timeout: %s", __FUNCTION__, e->e_string);
+	gettimeofday(&t0, NULL);
+	ret = (*e->e_fn)(0, e->e_arg);
+	event_stats_add(e->e_stats, &t0);
+	free(e);
+	if (ret < 0)
+	    return -1;
+    }
+    return n;
+}
+
+/*! Dispatch file descriptor events and timeouts by invoking callbacks.
+ * File descriptors are waited for using epoll(7) if EVENT_EPOLL is set, otherwise 
+ * using select(2). Timers are kept in a min-heap.
+ * In each round, first all ready file descriptors and then all expired timers are
+ * dispatched, each limited by CLICON_EVENT_DISPATCH_BUDGET callbacks. Left-overs are
+ * dispatched in the next round, so that neither timers nor file descriptors starve.
+ * @param[in]  h   Clicon handle
  * @retval  0  OK
  * @retval -1  Error: eg select, callback, timer, 
  */
 int
 clixon_event_loop(clicon_handle h)
 {
-    struct event_data *e;
-    struct event_data *e_next;
     int                n;
     struct timeval     t;
     struct timeval     t0;
     struct timeval     tnull = {0,};
-    fd_set             fdset;
+    int                budget;
     int                retval = -1;
 
+    /* Not set if no options, eg some util programs */
+    if ((budget = clicon_option_int(h, "CLICON_EVENT_DISPATCH_BUDGET")) < 0)
+	budget = 0;
     while (!clicon_exit_get()){
-	FD_ZERO(&fdset);
 	if (clicon_sig_child_get()){
 	    /* Go through processes and wait for child processes */
 	    if (clixon_process_waitpid(h) < 0)
 		goto err;
 	    clicon_sig_child_set(0);
 	}
-	for (e=ee; e; e=e->e_next)
-	    if (e->e_type == EVENT_FD)
-		FD_SET(e->e_fd, &fdset);
-	if (ee_timers != NULL){
+	/* Start or stop sampling on signal, see clixon_sample_sig() */
+	if (clixon_sample_pending() &&
+	    clixon_sample_pending_run(h) < 0)
+	    goto err;
+	if (ee_timers_len){
 	    gettimeofday(&t0, NULL);
-	    timersub(&ee_timers->e_time, &t0, &t); 
+	    timersub(&ee_timers[0]->e_time, &t0, &t); 
 	    if (t.tv_sec < 0)
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull); 
+		n = event_wait_dispatch(&tnull, budget);
 	    else
-		n = select(FD_SETSIZE, &fdset, NULL, NULL, &t); 
+		n = event_wait_dispatch(&t, budget);
 	}
 	else
-	    n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL);
+	    n = event_wait_dispatch(NULL, budget);
 	if (clicon_exit_get())
 	    break;
 	if (n == -1) {
+	    if (errno == 0) /* Error in callback, already logged */
+		goto err;
 	    if (errno == EINTR){
 		/* Signals are checked and are in three classes:
 		 * (1) Signals that exit gracefully, the function returns 0
@@ -398,34 +972,8 @@ clixon_event_loop(clicon_handle h)
 		clicon_err(OE_EVENTS, errno, "select");
 	    goto err;
 	}
-	if (n==0){ /* Timeout */
-	    e = ee_timers;
-	    ee_timers = ee_timers->e_next;
-	    clicon_debug(2, "%s timeout: %s", __FUNCTION__, e->e_string);
-	    if ((*e->e_fn)(0, e->e_arg) < 0){
-		free(e);
-		goto err;
-	    }
-	    free(e);
-	}
-	_ee_unreg = 0;
-	for (e=ee; e; e=e_next){
-	    if (clicon_exit_get())
-		break;
-	    e_next = e->e_next;
-	    if(e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)){
-		clicon_debug(2, "%s: FD_ISSET: %s", __FUNCTION__, e->e_string);
-		if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
-		    clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
-		    goto err;
-
-		}
-		if (_ee_unreg){
-		    _ee_unreg = 0;
-		    break;
-		}
-	    }
-	}
+	if (event_timers_dispatch(budget) < 0)
+	    goto err;
 	continue;
       err:
 	break;
@@ -434,10 +982,34 @@ clixon_event_loop(clicon_handle h)
     return retval;
 }
 
+/*! Print event callback statistics as XML
+ * One entry per callback describing string, see clixon-lib.yang stats rpc
+ * @param[in,out] cb  CLIgen buffer
+ * @retval        0   OK
+ * @retval       -1   Error
+ */
+int
+clixon_event_stats(cbuf *cb)
+{
+    struct event_stats *es;
+
+    for (es = ee_stats; es; es = es->es_next){
+	cprintf(cb, "<event><name>");
+	if (xml_chardata_cbuf_append(cb, es->es_name) < 0)
+	    return -1;
+	cprintf(cb, "</name><calls>%" PRIu64 "</calls>"
+		"<time-total>%" PRIu64 "</time-total>"
+		"<time-max>%" PRIu64 "</time-max></event>",
+		es->es_calls, es->es_total, es->es_max);
+    }
+    return 0;
+}
+
 int
 clixon_event_exit(void)
 {
-    struct event_data *e, *e_next;
+    struct event_data  *e, *e_next;
+    struct event_stats *es;
     
     e_next = ee;
     while ((e = e_next) != NULL){
@@ -445,11 +1017,27 @@ clixon_event_exit(void)
 	free(e);
     }
     ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-	e_next = e->e_next;
-	free(e);
+    while (ee_timers_len)
+	free(ee_timers[--ee_timers_len]);
+    if (ee_timers){
+	free(ee_timers);
+	ee_timers = NULL;
     }
-    ee_timers = NULL;
+    ee_timers_max = 0;
+    while ((es = ee_stats) != NULL){
+	ee_stats = es->es_next;
+	free(es);
+    }
+#ifdef EVENT_EPOLL
+    if (ee_fdtab){
+	free(ee_fdtab);
+	ee_fdtab = NULL;
+    }
+    ee_fdtab_max = 0;
+    ee_nopoll = 0;
+    if (ee_epfd != -1 && ee_eppid == getpid())
+	close(ee_epfd);
+    ee_epfd = -1;
+#endif
     return 0;
 }
@@ -80,6 +80,7 @@
  *    that is, not only strings. And has separate namespace from options.
  * 4) ch_db_elmnt. Only reason it is not in ch_data is its own namespace and
  *    need to dump all hashes
+ * 5) ch_optv are typed values of some options in ch_copt, see clicon_optv()
  * XXX: put ch_stream under ch_data
  * @see struct cli_handle
  * @see struct backend_handle
@@ -91,6 +92,7 @@ struct clicon_handle {
     clicon_hash_t    *ch_data;     /* internal clicon data (HDR) */
     clicon_hash_t    *ch_db_elmnt; /* xml datastore element cache data */
     event_stream_t   *ch_stream;   /* notification streams, see clixon_stream.[ch] */
+    struct clicon_optv *ch_optv;   /* typed options, see clicon_options_resolve */
 };
 
 /*! Internal call to allocate a CLICON handle. 
@@ -126,6 +128,16 @@ clicon_handle_init0(int size)
 	clicon_handle_exit((clicon_handle)ch);
 	goto done;
     }
+    if ((ch->ch_optv = malloc(sizeof(*ch->ch_optv))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	clicon_handle_exit((clicon_handle)ch);
+	goto done;
+    }
+    /* Defaults of unset options */
+    if (clicon_options_resolve((clicon_handle)ch, NULL) < 0){
+	clicon_handle_exit((clicon_handle)ch);
+	goto done;
+    }
     h = (clicon_handle)ch;
   done:
     return h;
@@ -162,6 +174,8 @@ clicon_handle_exit(clicon_handle h)
 	clicon_hash_free(ha);
     if ((ha = clicon_db_elmnt(h)) != NULL)
 	clicon_hash_free(ha);
+    if (ch->ch_optv)
+	free(ch->ch_optv);
     stream_delete_all(h, 1);
     free(ch);
     retval = 0;
@@ -193,6 +207,18 @@ clicon_options(clicon_handle h)
     return ch->ch_copt;
 }
 
+/*! Return typed options given a handle.
+ * @param[in]  h        Clicon handle
+ * @see clicon_options_resolve
+ */
+struct clicon_optv *
+clicon_optv(clicon_handle h)
+{
+    struct clicon_handle *ch = handle(h);
+
+    return ch->ch_optv;
+}
+
 /*! Return clicon data (hash-array) given a handle.
  * @param[in]  h        Clicon handle
  */
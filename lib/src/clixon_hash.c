@@ -88,6 +88,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <stdint.h>
 #include <inttypes.h>
 
 /* cligen */
@@ -98,19 +99,109 @@
 #include "clixon_err.h"
 #include "clixon_hash.h"
 
-#define HASH_SIZE	1031	/* Number of hash buckets. Should be a prime */ 
+#define HASH_INIT	16	/* Initial number of slots. Must be a power of two */
 #define align4(s) (((s)/4)*4 + 4)
 
-/*! A very simplistic algorithm to calculate a hash bucket index
+/* Hash table: open addressing with linear probing of a power of two number of
+ * slots, resized when three quarters of the slots are used.
+ * The handle clicon_hash_t* returned by clicon_hash_init points to this struct.
+ * Entries are allocated separately so that an entry returned by clicon_hash_lookup
+ * or clicon_hash_add stays valid until it is deleted.
+ */
+struct clicon_hash_table{
+    size_t         ht_size;   /* Number of slots */
+    size_t         ht_count;  /* Number of entries */
+    size_t         ht_used;   /* Number of entries and deleted slots */
+    clicon_hash_t *ht_slots;  /* Slot is an entry, NULL or HASH_DELETED */
+};
+
+#define htable(hash) ((struct clicon_hash_table *)(hash))
+
+/* Marker of a deleted slot, so that probing continues past it */
+static struct clicon_hash hash_deleted;
+#define HASH_DELETED (&hash_deleted)
+
+/*! FNV-1a hash of a string
  */
 static uint32_t
-hash_bucket(const char *str)
+hash_fnv1a(const char *str)
+{
+    uint32_t n = 2166136261U;
+
+    while (*str){
+	n ^= (uint8_t)*str++;
+	n *= 16777619U;
+    }
+    return n;
+}
+
+/*! Find slot of key, or the slot where it should be inserted
+ * @param[in]  ht    Hash table
+ * @param[in]  key   Key
+ * @param[in]  hv    Hash value of key
+ * @param[out] found 1 if key was found in slot, 0 if not
+ * @retval     i     Index of slot
+ */
+static size_t
+hash_slot(struct clicon_hash_table *ht,
+	  const char               *key,
+	  uint32_t                  hv,
+	  int                      *found)
 {
-    uint32_t n = 0;
+    size_t        mask = ht->ht_size - 1;
+    size_t        i = hv & mask;
+    size_t        free = SIZE_MAX;
+    clicon_hash_t h;
+
+    *found = 0;
+    while ((h = ht->ht_slots[i]) != NULL){
+	if (h == HASH_DELETED){
+	    if (free == SIZE_MAX)
+		free = i;
+	}
+	else if (h->h_hash == hv && strcmp(h->h_key, key) == 0){
+	    *found = 1;
+	    return i;
+	}
+	i = (i + 1) & mask;
+    }
+    return free != SIZE_MAX ? free : i;
+}
 
-    while(*str)
-	n += (uint32_t)*str++;
-    return n % HASH_SIZE;
+/*! Rebuild slots of hash table, grow if needed, and remove deleted slots
+ * @param[in]  ht    Hash table
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+hash_resize(struct clicon_hash_table *ht)
+{
+    size_t         size = ht->ht_size;
+    clicon_hash_t *slots;
+    clicon_hash_t  h;
+    size_t         i;
+    size_t         j;
+
+    while ((ht->ht_count + 1)*2 > size)
+	size *= 2;
+    if ((slots = calloc(size, sizeof(*slots))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	return -1;
+    }
+    for (i = 0; i < ht->ht_size; i++){
+	h = ht->ht_slots[i];
+	if (h == NULL || h == HASH_DELETED)
+	    continue;
+	j = h->h_hash & (size - 1);
+	while (slots[j] != NULL)
+	    j = (j + 1) & (size - 1);
+	slots[j] = h;
+    }
+    free(ht->ht_slots);
+    ht->ht_slots = slots;
+    ht->ht_size = size;
+    ht->ht_used = ht->ht_count;
+    return 0;
 }
 
 /*! Initialize hash table.
@@ -122,14 +213,20 @@ hash_bucket(const char *str)
 clicon_hash_t *
 clicon_hash_init(void)
 {
-  clicon_hash_t *hash;
-
-  if ((hash = (clicon_hash_t *)malloc(sizeof(clicon_hash_t) * HASH_SIZE)) == NULL){
-      clicon_err(OE_UNIX, errno, "malloc");
-      return NULL;
-  }
-  memset(hash, 0, sizeof(clicon_hash_t)*HASH_SIZE);
-  return hash;
+    struct clicon_hash_table *ht;
+
+    if ((ht = malloc(sizeof(*ht))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(ht, 0, sizeof(*ht));
+    if ((ht->ht_slots = calloc(HASH_INIT, sizeof(*ht->ht_slots))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	free(ht);
+	return NULL;
+    }
+    ht->ht_size = HASH_INIT;
+    return (clicon_hash_t *)ht;
 }
 
 /*! Free hash table.
@@ -141,18 +238,21 @@ clicon_hash_init(void)
 int
 clicon_hash_free(clicon_hash_t *hash)
 {
-    int i;
-    clicon_hash_t tmp;
-    for (i = 0; i < HASH_SIZE; i++) {
-	while (hash[i]) {
-	    tmp = hash[i];
-	    DELQ(tmp, hash[i], clicon_hash_t);
-	    free(tmp->h_key);
-	    free(tmp->h_val);
-	    free(tmp);
-	}
+    struct clicon_hash_table *ht = htable(hash);
+    clicon_hash_t             h;
+    size_t                    i;
+
+    for (i = 0; i < ht->ht_size; i++) {
+	h = ht->ht_slots[i];
+	if (h == NULL || h == HASH_DELETED)
+	    continue;
+	free(h->h_key);
+	if (h->h_val)
+	    free(h->h_val);
+	free(h);
     }
-    free(hash);
+    free(ht->ht_slots);
+    free(ht);
     return 0;
 }
 
@@ -167,19 +267,12 @@ clicon_hash_t
 clicon_hash_lookup(clicon_hash_t *hash, 
 		   const char    *key)
 {
-    uint32_t      bkt;
-    clicon_hash_t h;
+    struct clicon_hash_table *ht = htable(hash);
+    size_t                    i;
+    int                       found;
 
-    bkt = hash_bucket(key);
-    h = hash[bkt];
-    if (h) {
-	do {
-	    if (!strcmp(h->h_key, key))
-		return h;
-	    h = NEXTQ(clicon_hash_t, h);
-	} while (h != hash[bkt]);
-    }
-    return NULL;
+    i = hash_slot(ht, key, hash_fnv1a(key), &found);
+    return found ? ht->ht_slots[i] : NULL;
 }
 
 /*! Get value of hash
@@ -225,9 +318,13 @@ clicon_hash_add(clicon_hash_t *hash,
 		void          *val, 
 		size_t         vlen)
 {
-    void         *newval = NULL;
-    clicon_hash_t h;
-    clicon_hash_t new = NULL;
+    struct clicon_hash_table *ht = htable(hash);
+    void                     *newval = NULL;
+    clicon_hash_t             h;
+    clicon_hash_t             new = NULL;
+    uint32_t                  hv;
+    size_t                    i;
+    int                       found;
     
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
@@ -239,9 +336,18 @@ clicon_hash_add(clicon_hash_t *hash,
 	clicon_err(OE_UNIX, EINVAL, "Mismatch in value and length, only one is zero");
 	goto catch;
     }
+    hv = hash_fnv1a(key);
+    i = hash_slot(ht, key, hv, &found);
     /* If variable exist, don't allocate a new. just replace value */
-    h = clicon_hash_lookup(hash, key);
-    if (h == NULL) {
+    if (found)
+	h = ht->ht_slots[i];
+    else {
+	/* Make room before insert, slot may move */
+	if ((ht->ht_used + 1)*4 > ht->ht_size*3){
+	    if (hash_resize(ht) < 0)
+		goto catch;
+	    i = hash_slot(ht, key, hv, &found);
+	}
 	if ((new = (clicon_hash_t)malloc(sizeof(*new))) == NULL){
 	    clicon_err(OE_UNIX, errno, "malloc");
 	    goto catch;
@@ -253,7 +359,7 @@ clicon_hash_add(clicon_hash_t *hash,
 	    clicon_err(OE_UNIX, errno, "strdup");
 	    goto catch;
 	}
-	
+	new->h_hash = hv;
 	h = new;
     }
     
@@ -273,10 +379,13 @@ clicon_hash_add(clicon_hash_t *hash,
     h->h_val = newval;
     h->h_vlen =  vlen;
 
-    /* Add to list only if new variable */
-    if (new)
-	INSQ(h, hash[hash_bucket(key)]);
-
+    /* Add to table only if new variable */
+    if (new){
+	if (ht->ht_slots[i] == NULL)
+	    ht->ht_used++;
+	ht->ht_slots[i] = h;
+	ht->ht_count++;
+    }
     return h;
 
 catch:
@@ -301,20 +410,31 @@ int
 clicon_hash_del(clicon_hash_t *hash, 
 		const char    *key)
 {
-    clicon_hash_t h;
+    struct clicon_hash_table *ht = htable(hash);
+    clicon_hash_t             h;
+    size_t                    i;
+    int                       found;
 
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
 	return -1;
     }
-    h = clicon_hash_lookup(hash, key);
-    if (h == NULL)
+    i = hash_slot(ht, key, hash_fnv1a(key), &found);
+    if (!found)
 	return -1;
-    
-    DELQ(h, hash[hash_bucket(key)], clicon_hash_t);
+    h = ht->ht_slots[i];
+    /* A slot followed by an empty slot ends no probe sequence and can be emptied */
+    if (ht->ht_slots[(i + 1) & (ht->ht_size - 1)] == NULL){
+	ht->ht_slots[i] = NULL;
+	ht->ht_used--;
+    }
+    else
+	ht->ht_slots[i] = HASH_DELETED;
+    ht->ht_count--;
   
     free(h->h_key);
-    free(h->h_val);
+    if (h->h_val)
+	free(h->h_val);
     free(h);
 
     return 0;
@@ -334,42 +454,32 @@ clicon_hash_keys(clicon_hash_t *hash,
 		 char        ***vector,
 		 size_t        *nkeys)
 {
-    int           retval = -1;
-    int           bkt;
-    clicon_hash_t h;
-    char        **tmp;
-    char        **keys = NULL;
+    struct clicon_hash_table *ht = htable(hash);
+    clicon_hash_t             h;
+    char                    **keys = NULL;
+    size_t                    i;
 
     if (hash == NULL){
 	clicon_err(OE_UNIX, EINVAL, "hash is NULL");
 	return -1;
     }
     *nkeys = 0;
-    for (bkt = 0; bkt < HASH_SIZE; bkt++) {
-	h = hash[bkt];
-	do {
-	    if (h == NULL)
-		break;
-	    tmp = realloc(keys, ((*nkeys)+1) * sizeof(char *));
-	    if (tmp == NULL){
-		clicon_err(OE_UNIX, errno, "realloc");
-		goto catch;
-	    }
-	    keys = tmp;
-	    keys[*nkeys] = h->h_key;
-	    (*nkeys)++;
-	    h = NEXTQ(clicon_hash_t, h);
-	} while (h != hash[bkt]);
+    if (ht->ht_count &&
+	(keys = malloc(ht->ht_count * sizeof(char *))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return -1;
     }
-    if (vector){
-	*vector = keys;
-	keys = NULL;
+    for (i = 0; i < ht->ht_size; i++) {
+	h = ht->ht_slots[i];
+	if (h == NULL || h == HASH_DELETED)
+	    continue;
+	keys[(*nkeys)++] = h->h_key;
     }
-    retval = 0;
-catch:
-    if (keys)
+    if (vector)
+	*vector = keys;
+    else if (keys)
 	free(keys);
-    return retval;
+    return 0;
 }
 
 /*! Dump contents of hash to FILE pointer.
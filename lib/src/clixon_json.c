@@ -76,6 +76,7 @@
 #include "clixon_json_parse.h"
 
 #define JSON_INDENT 2 /* maybe we should set this programmatically? */
+#define JSON_FILE_CHUNK (64*1024) /* Output buffer size when printing JSON to a file */
 
 /* Let xml2json_cbuf_vec() return json array: [a,b].
    ALternative is to create a pseudo-object and return that: {top:{a,b}}
@@ -88,6 +89,13 @@
 /* Name of xml top object created by xml parse functions */
 #define JSON_TOP_SYMBOL "top"
 
+/* Streaming output state, see xml2json_stream */
+struct json_stream{
+    size_t          js_chunk; /* Flush when buffer is at least this long */
+    json_stream_fn *js_fn;    /* Flush callback */
+    void           *js_arg;   /* Flush callback argument */
+};
+
 enum array_element_type{
     NO_ARRAY=0,
     FIRST_ARRAY,  /* [a, */
@@ -179,6 +187,37 @@ arraytype2str(enum array_element_type lt)
     return "";
 }
 
+/*! Check if sibling y is a member of the same JSON array as x
+ *
+ * If both are yang bound, same name and namespace is the same yang node, otherwise
+ * compare names and xmlns attributes
+ * @param[in]  x   XML element
+ * @param[in]  y   Sibling of x or NULL
+ * @retval     1   Same array
+ * @retval     0   Not same array
+ */
+static int
+array_sibling_eq(cxobj *x,
+		 cxobj *y)
+{
+    yang_stmt *ys;
+    yang_stmt *ys2;
+    char      *nsx;
+    char      *ns2;
+
+    if (y == NULL || xml_type(y) != CX_ELMNT)
+	return 0;
+    ys = xml_spec(x);
+    ys2 = xml_spec(y);
+    if (ys && ys2)
+	return ys == ys2;
+    if (strcmp(xml_name(x), xml_name(y)) != 0)
+	return 0;
+    nsx = xml_find_type_value(x, NULL, "xmlns", CX_ATTR);
+    ns2 = xml_find_type_value(y, NULL, "xmlns", CX_ATTR);
+    return (!nsx && !ns2) || (nsx && ns2 && strcmp(nsx, ns2)==0);
+}
+
 /*! Check typeof x in array
  * Some complexity when x is in different namespaces
  */
@@ -188,34 +227,17 @@ array_eval(cxobj *xprev,
 	   cxobj *xnext)
 {
     enum array_element_type array = NO_ARRAY;
-    int                     eqprev=0;
-    int                     eqnext=0;
+    int                     eqprev;
+    int                     eqnext;
     yang_stmt              *ys;
-    char                   *nsx; /* namespace of x */
-    char                   *ns2;
 
-    nsx = xml_find_type_value(x, NULL, "xmlns", CX_ATTR);
     if (xml_type(x) != CX_ELMNT){
 	array=BODY_ARRAY;
 	goto done;
     }
     ys = xml_spec(x);
-    if (xnext && 
-	xml_type(xnext)==CX_ELMNT &&
-	strcmp(xml_name(x), xml_name(xnext))==0){
-        ns2 = xml_find_type_value(xnext, NULL, "xmlns", CX_ATTR);
-	if ((!nsx && !ns2)
-	    || (nsx && ns2 && strcmp(nsx,ns2)==0))
-	    eqnext++;
-    }
-    if (xprev &&
-	xml_type(xprev)==CX_ELMNT &&
-	strcmp(xml_name(x),xml_name(xprev))==0){
-	ns2 = xml_find_type_value(xprev, NULL, "xmlns", CX_ATTR);
-	if ((!nsx && !ns2)
-	    || (nsx && ns2 && strcmp(nsx,ns2)==0))
-	    eqprev++;
-    }
+    eqnext = array_sibling_eq(x, xnext);
+    eqprev = array_sibling_eq(x, xprev);
     if (eqprev && eqnext)
 	array = MIDDLE_ARRAY;
     else if (eqprev)
@@ -238,43 +260,52 @@ static int
 json_str_escape_cdata(cbuf *cb,
 		      char *str)
 {
-    int   retval = -1;
-    int   i;
-    int   esc = 0; /* cdata escape */
+    int     retval = -1;
+    char   *s = str;
+    size_t  n;
+    int     esc = 0; /* cdata escape */
 
-    for (i=0;i<strlen(str);i++)
-	switch (str[i]){
+    while (*s != '\0'){
+	/* Append run of characters that need no escaping in one go */
+	if ((n = strcspn(s, "\n\"\\<]")) > 0){
+	    cbuf_append_buf(cb, s, n);
+	    s += n;
+	}
+	switch (*s){
 	case '\n':
-	    cprintf(cb, "\\n");
+	    cbuf_append_str(cb, "\\n");
+	    s++;
 	    break;
 	case '\"':
-	    cprintf(cb, "\\\"");
+	    cbuf_append_str(cb, "\\\"");
+	    s++;
 	    break;
 	case '\\':
-	    cprintf(cb, "\\\\");
+	    cbuf_append_str(cb, "\\\\");
+	    s++;
 	    break;
 	case '<':
 	    if (!esc &&
-		strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
+		strncmp(s, "<![CDATA[", strlen("<![CDATA[")) == 0){
 		esc=1;
-		i += strlen("<![CDATA[")-1;
+		s += strlen("<![CDATA[");
 	    }
 	    else
-		cprintf(cb, "%c", str[i]);
+		cbuf_append_buf(cb, s++, 1);
 	    break;
 	case ']':
 	    if (esc &&
-		strncmp(&str[i], "]]>", strlen("]]>")) == 0){
+		strncmp(s, "]]>", strlen("]]>")) == 0){
 		esc=0;
-		i += strlen("]]>")-1;
+		s += strlen("]]>");
 	    }
 	    else
-		cprintf(cb, "%c", str[i]);
+		cbuf_append_buf(cb, s++, 1);
 	    break;
-	default: /* fall thru */
-	    cprintf(cb, "%c", str[i]);
+	default: /* end of string */
 	    break;
 	}
+    }
     retval = 0;
     // done:
     return retval;
@@ -409,28 +440,24 @@ int
 json2xml_decode(cxobj     *x,
 		cxobj    **xerr)
 {
-    int           retval = -1;
-    yang_stmt    *y;
-    enum rfc_6020 keyword;
-    cxobj        *xc;
-    int           ret;
-    yang_stmt    *ytype;
+    int                retval = -1;
+    yang_stmt         *y;
+    enum rfc_6020      keyword;
+    cxobj             *xc;
+    int                ret;
+    enum yang_json_enc enc;
 
     if ((y = xml_spec(x)) != NULL){
 	keyword = yang_keyword_get(y);
 	if (keyword == Y_LEAF || keyword == Y_LEAF_LIST){
-	    if (yang_type_get(y, NULL, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+	    if (yang_json_enc_get(y, &enc) < 0)
 		goto done;
-
-	    if (ytype){
-		if (strcmp(yang_argument_get(ytype), "identityref")==0){
-		    if ((ret = json2xml_decode_identityref(x, y, xerr)) < 0)
-			goto done;
-		    if (ret == 0)
-			goto fail;
-		}
-		else if (strcmp(yang_argument_get(ytype), "empty")==0)
-		    ; /* dont need to do anything */
+	    /* Only identityref values differ, empty and other types are as in XML */
+	    if (enc == YJ_IDENTITYREF){
+		if ((ret = json2xml_decode_identityref(x, y, xerr)) < 0)
+		    goto done;
+		if (ret == 0)
+		    goto fail;
 	    }
 	}
     }
@@ -455,7 +482,7 @@ json2xml_decode(cxobj     *x,
  * @param[in]     ys   Yang spec of parent
  * @param[out]    cb   Encoded string
  */
-static int
+int
 xml2json_encode_identityref(cxobj     *xb,
 			    char      *body,
 			    yang_stmt *yp,
@@ -474,6 +501,14 @@ xml2json_encode_identityref(cxobj     *xb,
     yspec = ys_spec(yp);
     if (nodeid_split(body, &prefix, &id) < 0)
 	goto done;
+    /* Default value not in XML tree: prefix is yang local, see XML_FLAG_REPORT_ALL */
+    if (xb == NULL){
+	if ((ymod = yang_find_module_by_prefix(yp, prefix)) != NULL && ymod != my_ymod)
+	    cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
+	else
+	    cprintf(cb, "%s", id);
+	goto ok;
+    }
     /* prefix is xml local -> get namespace */
     if (xml2ns(xb, prefix, &namespace) < 0)
 	goto done;
@@ -504,6 +539,7 @@ xml2json_encode_identityref(cxobj     *xb,
     else
 	cprintf(cb, "%s", id);
 	}
+ ok:
     retval = 0;
  done:
     if (prefix)
@@ -514,108 +550,69 @@ xml2json_encode_identityref(cxobj     *xb,
 }
 
 /*! Encode leaf/leaf_list types from XML to JSON
- * @param[in]     x   XML body
- * @param[in]     ys  Yang spec of parent
+ * Quoting is given by the JSON encoding cached in the yang leaf, so the type is not
+ * resolved for each value, see yang_json_enc_get
+ * @param[in]     xb   XML body, or NULL
+ * @param[in]     body Body string, eg value of xb, or NULL
+ * @param[in]     ys   Yang spec of parent
  * @param[out]    cb0  Encoded string
  */
 static int
 xml2json_encode_leafs(cxobj     *xb,
-		      cxobj     *xp,
+		      char      *body,
 		      yang_stmt *yp,
 		      cbuf      *cb0)
 {
-    int           retval = -1;
-    enum rfc_6020 keyword;
-    yang_stmt    *ytype;
-    char         *restype;  /* resolved type */
-    char         *origtype=NULL;   /* original type */
-    char         *body;
-    enum cv_type  cvtype;
-    int           quote = 1; /* Quote value w string: "val" */
-    cbuf         *cb = NULL; /* the variable itself */
+    int                retval = -1;
+    enum rfc_6020      keyword;
+    enum yang_json_enc enc = YJ_OTHER;
+    cbuf              *cb = NULL; /* Encoded identityref */
 
-    if ((cb = cbuf_new()) ==NULL){
-	clicon_err(OE_XML, errno, "cbuf_new");
-	goto done;
-    }
-    body = xb?xml_value(xb):NULL;
     if (yp == NULL){
-	cprintf(cb, "%s", body?body:"null"); 
-	goto ok; /* unknown */
+	body = body?body:"null";  /* unknown */
+	enc = YJ_STRING;
     }
-    keyword = yang_keyword_get(yp);
-    switch (keyword){
-    case Y_LEAF:
-    case Y_LEAF_LIST:
-	if (yang_type_get(yp, &origtype, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+    else if ((keyword = yang_keyword_get(yp)) == Y_LEAF || keyword == Y_LEAF_LIST){
+	if (yang_json_enc_get(yp, &enc) < 0)
 	    goto done;
-	restype = ytype?yang_argument_get(ytype):NULL;
-	cvtype = yang_type2cv(yp);
-	switch (cvtype){ 
-	case CGV_STRING:
-	case CGV_REST:
-	    if (body==NULL)
-		; /* empty: "" */
-	    else if (ytype){
-		if (strcmp(restype, "identityref")==0){
-		    if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
-			goto done;
-		}
-		else
-		    cprintf(cb, "%s", body);
-	    }
-	    else
-		cprintf(cb, "%s", body);
-	    break;
-	case CGV_INT8:
-	case CGV_INT16:
-	case CGV_INT32:
-	case CGV_INT64:
-	case CGV_UINT8:
-	case CGV_UINT16:
-	case CGV_UINT32:
-	case CGV_UINT64:
-	case CGV_DEC64:
-	case CGV_BOOL:
-	    cprintf(cb, "%s", body);
-	    quote = 0;
-	    break;
-	case CGV_VOID:
-	    /* special case YANG empty type */
-	    if (body == NULL && strcmp(restype, "empty")==0){
-		quote = 0;
-		cprintf(cb, "[null]");
+    }
+    else
+	enc = YJ_STRING;
+    switch (enc){
+    case YJ_LITERAL:
+	cprintf(cb0, "%s", body);
+	break;
+    case YJ_EMPTY:
+	if (body == NULL)
+	    cbuf_append_str(cb0, "[null]");
+	else
+	    cbuf_append_str(cb0, "\"\"");
+	break;
+    case YJ_IDENTITYREF:
+	if (body){
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_XML, errno, "cbuf_new");
+		goto done;
 	    }
-	    break;
-	default:
-	    if (body)
-		cprintf(cb, "%s", body);
-	    else
-		cprintf(cb, "{}"); /* dont know */
+	    if (xml2json_encode_identityref(xb, body, yp, cb) < 0)
+		goto done;
+	    body = cbuf_get(cb);
 	}
+	/* fall through */
+    case YJ_STRING:
+    case YJ_OTHER:
+    case YJ_NONE:
+	if (body == NULL)
+	    body = enc==YJ_OTHER?"{}":""; /* dont know */
+	cbuf_append_str(cb0, "\"");
+	json_str_escape_cdata(cb0, body);
+	cbuf_append_str(cb0, "\"");
 	break;
-    default:
-	cprintf(cb, "%s", body);
-	break;
-    }
- ok:
-    /* write into original cb0
-     * includign quoting and encoding 
-     */
-    if (quote){
-	cprintf(cb0, "\"");
-	json_str_escape_cdata(cb0, cbuf_get(cb));
     }
-    else
-	cprintf(cb0, "%s", cbuf_get(cb));
-    if (quote)
-	cprintf(cb0, "\"");
     retval = 0;
  done:
     if (cb)
 	cbuf_free(cb);
-    if (origtype)
-	free(origtype);
     return retval;
 }
 
@@ -646,7 +643,7 @@ nullchild(cbuf      *cb,
 	    break;
 	case Y_LEAF:
 	case Y_LEAF_LIST:
-	    if (xml2json_encode_leafs(NULL, x, y, cb) < 0)
+	    if (xml2json_encode_leafs(NULL, NULL, y, cb) < 0)
 		goto done;
 	    break;
 	default:
@@ -662,6 +659,85 @@ nullchild(cbuf      *cb,
     return retval;
 }
 
+/*! Append end of JSON object, ie newline and indentation if pretty, then "}"
+ * @param[out] cb      Cligen buffer
+ * @param[in]  level   Indentation level
+ * @param[in]  pretty  Pretty-print output
+ */
+static int
+json_close_brace(cbuf *cb,
+		 int   level,
+		 int   pretty)
+{
+    if (pretty){
+	cbuf_append_str(cb, "\n");
+	clicon_cbuf_indent(cb, level*JSON_INDENT);
+    }
+    return cbuf_append_str(cb, "}");
+}
+
+/*! Translate a default value that is not in the XML tree to JSON
+ *
+ * A leaf with its default value, or a non-presence container with its default values
+ * @param[out]   cb        Cligen text buffer
+ * @param[in]    yd        Yang leaf or non-presence container, see xml_default_next
+ * @param[in]    level     Indentation level
+ * @param[in]    pretty    Pretty-print output
+ * @param[in]    ymod0     Ancestor module
+ * @see XML_FLAG_REPORT_ALL
+ */
+static int
+json_default_print(cbuf      *cb,
+		   yang_stmt *yd,
+		   int        level,
+		   int        pretty,
+		   yang_stmt *ymod0)
+{
+    int        retval = -1;
+    yang_stmt *ymod = NULL;
+    char      *qname = NULL;
+    char      *val = NULL;
+    yang_stmt *yc = NULL;
+    int        n = 0;
+
+    if (yang_json_name_get(yd, &ymod, &qname) < 0)
+	goto done;
+    if (ymod0 && ymod == ymod0)
+	qname = NULL;
+    if (pretty)
+	clicon_cbuf_indent(cb, level*JSON_INDENT);
+    cbuf_append_str(cb, "\"");
+    cbuf_append_str(cb, qname?qname:yang_argument_get(yd));
+    cbuf_append_str(cb, pretty?"\": ":"\":");
+    if (yang_keyword_get(yd) == Y_LEAF){
+	if ((val = cv2str_dup(yang_cv_get(yd))) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv2str_dup");
+	    goto done;
+	}
+	if (xml2json_encode_leafs(NULL, val, yd, cb) < 0)
+	    goto done;
+    }
+    else { /* Non-presence container */
+	cbuf_append_str(cb, pretty?"{\n":"{");
+	do {
+	    if (xml_default_next(yd, NULL, 1, &yc) < 0)
+		goto done;
+	    if (yc == NULL)
+		break;
+	    if (n++)
+		cbuf_append_str(cb, pretty?",\n":",");
+	    if (json_default_print(cb, yc, level+1, pretty, ymod) < 0)
+		goto done;
+	} while (yc);
+	json_close_brace(cb, level, pretty);
+    }
+    retval = 0;
+ done:
+    if (val)
+	free(val);
+    return retval;
+}
+
 /*! Do the actual work of translating XML to JSON 
  * @param[out]   cb        Cligen text buffer containing json on exit
  * @param[in]    x         XML tree structure containing XML to translate
@@ -671,6 +747,7 @@ nullchild(cbuf      *cb,
  * @param[in]    pretty    Pretty-print output (2 means debug)
  * @param[in]    flat      Dont print NO_ARRAY object name (for _vec call)
  * @param[in]    bodystr   Set if value is string, 0 otherwise. Only if body
+ * @param[in]    defaults  Translate default values not in tree, see XML_FLAG_REPORT_ALL
  *
  * @note Does not work with XML attributes
  * The following matrix explains how the mapping is done.
@@ -707,7 +784,9 @@ xml2json1_cbuf(cbuf                   *cb,
 	       int                     level,
 	       int                     pretty,
 	       int                     flat,
-	       char                   *modname0)
+	       yang_stmt              *ymod0,
+	       int                     defaults,
+	       struct json_stream     *js)
 {
     int              retval = -1;
     int              i;
@@ -718,18 +797,26 @@ xml2json1_cbuf(cbuf                   *cb,
     yang_stmt       *ys;
     yang_stmt       *ymod = NULL; /* yang module */
     int              commas;
-    char            *modname = NULL;
+    char            *qname = NULL; /* Qualified name "module:name" if module differs */
+    yang_stmt       *yc;
+    yang_stmt       *yd = NULL;    /* Next default value not in tree */
+    int              n = 0;
 
     if ((ys = xml_spec(x)) != NULL){
-	if (ys_real_module(ys, &ymod) < 0)
+	if (yang_json_name_get(ys, &ymod, &qname) < 0)
 	    goto done;
-	modname = yang_argument_get(ymod);
-	if (modname0 && strcmp(modname, modname0) == 0)
-	    modname=NULL;
+	if (ymod0 && ymod == ymod0)
+	    qname = NULL;
 	else
-	    modname0 = modname; /* modname0 is ancestor ns passed to child */
+	    ymod0 = ymod; /* ymod0 is ancestor module passed to child */
     }
     childt = child_type(x);
+    if (defaults && ys && childt != BODY_CHILD){
+	if (xml_default_next(ys, x, 1, &yd) < 0)
+	    goto done;
+	if (yd)
+	    childt = ANY_CHILD;
+    }
     if (pretty==2)
 	cprintf(cb, "#%s_array, %s_child ", 
 		arraytype2str(arraytype),
@@ -737,15 +824,16 @@ xml2json1_cbuf(cbuf                   *cb,
     switch(arraytype){
     case BODY_ARRAY: /* Only place in fn where body is printed (except nullchild) */
 	xp = xml_parent(x);
-	if (xml2json_encode_leafs(x, xp, xml_spec(xp), cb) < 0)
+	if (xml2json_encode_leafs(x, xml_value(x), xml_spec(xp), cb) < 0)
 	    goto done;
 	break;
     case NO_ARRAY:
 	if (!flat){
-	    cprintf(cb, "%*s\"", pretty?(level*JSON_INDENT):0, "");
-	    if (modname) 
-		cprintf(cb, "%s:", modname);
-	    cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+	    if (pretty)
+		clicon_cbuf_indent(cb, level*JSON_INDENT);
+	    cbuf_append_str(cb, "\"");
+	    cbuf_append_str(cb, qname?qname:xml_name(x));
+	    cbuf_append_str(cb, pretty?"\": ":"\":");
 	}
 	switch (childt){
 	case NULL_CHILD:
@@ -755,7 +843,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append_str(cb, pretty?"{\n":"{");
 	    break;
 	default:
 	    break;
@@ -763,14 +851,15 @@ xml2json1_cbuf(cbuf                   *cb,
 	break;
     case FIRST_ARRAY:
     case SINGLE_ARRAY:
-	cprintf(cb, "%*s\"", pretty?(level*JSON_INDENT):0, "");
-	if (modname)
-	    cprintf(cb, "%s:", modname);
-	cprintf(cb, "%s\":%s", xml_name(x), pretty?" ":"");
+	if (pretty)
+	    clicon_cbuf_indent(cb, level*JSON_INDENT);
+	cbuf_append_str(cb, "\"");
+	cbuf_append_str(cb, qname?qname:xml_name(x));
+	cbuf_append_str(cb, pretty?"\": ":"\":");
 	level++;
-	cprintf(cb, "[%s%*s", 
-		pretty?"\n":"",
-		pretty?(level*JSON_INDENT):0, "");
+	cbuf_append_str(cb, pretty?"[\n":"[");
+	if (pretty)
+	    clicon_cbuf_indent(cb, level*JSON_INDENT);
 	switch (childt){
 	case NULL_CHILD:
 	    if (nullchild(cb, x, ys) < 0)
@@ -779,7 +868,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append_str(cb, pretty?"{\n":"{");
 	    break;
 	default:
 	    break;
@@ -788,8 +877,8 @@ xml2json1_cbuf(cbuf                   *cb,
     case MIDDLE_ARRAY:
     case LAST_ARRAY:
 	level++;
-	cprintf(cb, "%*s", 
-		pretty?(level*JSON_INDENT):0, "");
+	if (pretty)
+	    clicon_cbuf_indent(cb, level*JSON_INDENT);
 	switch (childt){
 	case NULL_CHILD:
 	    if (nullchild(cb, x, ys) < 0)
@@ -798,7 +887,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "{%s", pretty?"\n":"");
+	    cbuf_append_str(cb, pretty?"{\n":"{");
 	    break;
 	default:
 	    break;
@@ -816,19 +905,40 @@ xml2json1_cbuf(cbuf                   *cb,
 	xc = xml_child_i(x, i);
 	if (xml_type(xc) == CX_ATTR)
 	    continue; /* XXX Only xmlns attributes mapped */
-
+	/* Default values before xc in yang order */
+	while (yd && (yc = xml_spec(xc)) != NULL && yang_order(yd) < yang_order(yc)){
+	    if (json_default_print(cb, yd, level+1, pretty, ymod0) < 0)
+		goto done;
+	    cbuf_append_str(cb, pretty?",\n":",");
+	    if (xml_default_next(ys, x, 1, &yd) < 0)
+		goto done;
+	}
 	xc_arraytype = array_eval(i?xml_child_i(x,i-1):NULL, 
 				xc, 
 				xml_child_i(x, i+1));
 	if (xml2json1_cbuf(cb, 
 			   xc, 
 			   xc_arraytype,
-			   level+1, pretty, 0, modname0) < 0)
+			   level+1, pretty, 0, ymod0, defaults, js) < 0)
 	    goto done;
+	n++;
 	if (commas > 0) {
-	    cprintf(cb, ",%s", pretty?"\n":"");
+	    cbuf_append_str(cb, pretty?",\n":",");
 	    --commas;
 	}
+	if (js && cbuf_len(cb) >= js->js_chunk){
+	    if ((*js->js_fn)(js->js_arg, cb) < 0)
+		goto done;
+	    cbuf_reset(cb);
+	}
+    }
+    while (yd){
+	if (n++)
+	    cbuf_append_str(cb, pretty?",\n":",");
+	if (json_default_print(cb, yd, level+1, pretty, ymod0) < 0)
+	    goto done;
+	if (xml_default_next(ys, x, 1, &yd) < 0)
+	    goto done;
     }
     switch (arraytype){
     case BODY_ARRAY:
@@ -839,9 +949,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
+	    json_close_brace(cb, level, pretty);
 	    break;
 	default:
 	    break;
@@ -855,9 +963,7 @@ xml2json1_cbuf(cbuf                   *cb,
 	case BODY_CHILD:
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
+	    json_close_brace(cb, level, pretty);
 	    level--;
 	    break;
 	default:
@@ -869,20 +975,21 @@ xml2json1_cbuf(cbuf                   *cb,
 	switch (childt){
 	case NULL_CHILD:
 	case BODY_CHILD:
-	    cprintf(cb, "%s",pretty?"\n":"");
+	    if (pretty)
+		cbuf_append_str(cb, "\n");
 	    break;
 	case ANY_CHILD:
-	    cprintf(cb, "%s%*s}", 
-		    pretty?"\n":"",
-		    pretty?(level*JSON_INDENT):0, "");
-	    cprintf(cb, "%s",pretty?"\n":"");
+	    json_close_brace(cb, level, pretty);
+	    if (pretty)
+		cbuf_append_str(cb, "\n");
 	    level--;
 	    break;
 	default:
 	    break;
 	}
-	cprintf(cb, "%*s]",
-		pretty?(level*JSON_INDENT):0,"");
+	if (pretty)
+	    clicon_cbuf_indent(cb, level*JSON_INDENT);
+	cbuf_append_str(cb, "]");
 	break;
     default:
 	break;
@@ -930,7 +1037,9 @@ xml2json_cbuf(cbuf      *cb,
 		       level+1,
 		       pretty,
 		       0,
-		       NULL /* ancestor modname / namespace */
+		       NULL, /* ancestor module / namespace */
+		       xml_flag(x, XML_FLAG_REPORT_ALL) != 0,
+		       NULL
 		       ) < 0)
 	goto done;
     cprintf(cb, "%s%*s}%s", 
@@ -990,7 +1099,7 @@ xml2json_cbuf_vec(cbuf      *cb,
 		       xp, 
 		       NO_ARRAY,
 		       level+1, pretty,
-		       1, NULL) < 0)
+		       1, NULL, 0, NULL) < 0)
 	goto done;
 
     if (0){
@@ -1008,6 +1117,117 @@ xml2json_cbuf_vec(cbuf      *cb,
     return retval;
 }
 
+/*! Translate an XML tree to JSON incrementally using a flush callback
+ *
+ * Same output as xml2json_cbuf, but the JSON is not built in memory as a whole. Each
+ * time the buffer is at least chunk bytes, it is given to the callback and reset.
+ * The callback may for example send the data as HTTP chunked transfer encoding.
+ * @param[in,out] cb     Cligen buffer to write to, the remainder is left on return
+ * @param[in]     x      XML tree to translate from
+ * @param[in]     pretty Set if output is pretty-printed
+ * @param[in]     chunk  Call fn when buffer is at least this long
+ * @param[in]     fn     Flush callback, called with arg and cb
+ * @param[in]     arg    Flush callback argument
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @see xml2json_cbuf
+ */
+int 
+xml2json_stream(cbuf           *cb, 
+		cxobj          *x, 
+		int             pretty,
+		size_t          chunk,
+		json_stream_fn *fn,
+		void           *arg)
+{
+    int                retval = -1;
+    int                level = 0;
+    struct json_stream js = {chunk, fn, arg};
+
+    cprintf(cb, "%*s{%s", 
+	    pretty?level*JSON_INDENT:0,"", 
+	    pretty?"\n":"");
+    if (xml2json1_cbuf(cb, x, NO_ARRAY, level+1, pretty, 0, NULL,
+		       xml_flag(x, XML_FLAG_REPORT_ALL) != 0, &js) < 0)
+	goto done;
+    cprintf(cb, "%s%*s}%s", 
+	    pretty?"\n":"",
+	    pretty?level*JSON_INDENT:0,"",
+	    pretty?"\n":"");
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Translate a vector of xml objects to JSON incrementally using a flush callback
+ *
+ * Same output as xml2json_cbuf_vec, but the objects are not copied to a pseudo-object
+ * and the JSON is not built in memory as a whole, see xml2json_stream.
+ * @param[in,out] cb     Cligen buffer to write to, the remainder is left on return
+ * @param[in]     vec    Vector of xml objects
+ * @param[in]     veclen Length of vector
+ * @param[in]     pretty Set if output is pretty-printed
+ * @param[in]     chunk  Call fn when buffer is at least this long
+ * @param[in]     fn     Flush callback, called with arg and cb
+ * @param[in]     arg    Flush callback argument
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @note This only works if the vector is uniform, ie same object name.
+ * @see xml2json_cbuf_vec
+ */
+int 
+xml2json_stream_vec(cbuf           *cb, 
+		    cxobj         **vec,
+		    size_t          veclen,
+		    int             pretty,
+		    size_t          chunk,
+		    json_stream_fn *fn,
+		    void           *arg)
+{
+    int                retval = -1;
+    int                level = 1; /* As the flat pseudo-object of xml2json_cbuf_vec */
+    int                i;
+    struct json_stream js = {chunk, fn, arg};
+
+    if (veclen == 0)
+	goto ok;
+    cprintf(cb, "{%s", pretty?"\n":"");
+    for (i=0; i<veclen; i++){
+	if (xml2json1_cbuf(cb, vec[i],
+			   array_eval(i?vec[i-1]:NULL, vec[i], i<veclen-1?vec[i+1]:NULL),
+			   level+1, pretty, 0, NULL,
+			   xml_flag(vec[i], XML_FLAG_REPORT_ALL) != 0, &js) < 0)
+	    goto done;
+	if (i < veclen-1)
+	    cprintf(cb, ",%s", pretty?"\n":"");
+	if (cbuf_len(cb) >= chunk){
+	    if ((*fn)(arg, cb) < 0)
+		goto done;
+	    cbuf_reset(cb);
+	}
+    }
+    cprintf(cb, "%s%*s}", 
+	    pretty?"\n":"",
+	    pretty?(level*JSON_INDENT):0, "");
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Flush callback of xml2json_stream writing the buffer to an output stream
+ */
+static int
+json_file_flush(void *arg,
+		cbuf *cb)
+{
+    if (fwrite(cbuf_get(cb), 1, cbuf_len(cb), (FILE *)arg) != cbuf_len(cb)){
+	clicon_err(OE_UNIX, errno, "fwrite");
+	return -1;
+    }
+    return 0;
+}
+
 /*! Translate from xml tree to JSON and print to file using a callback
  * @param[in]  f      File to print to
  * @param[in]  x      XML tree to translate from
@@ -1031,6 +1251,17 @@ xml2json_cb(FILE             *f,
     int   retval = 1;
     cbuf *cb = NULL;
 
+    if (fn == fprintf){ /* Write directly via a large output buffer */
+	if ((cb = cbuf_new_alloc(JSON_FILE_CHUNK+1024)) == NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new_alloc");
+	    goto done;
+	}
+	if (xml2json_stream(cb, x, pretty, JSON_FILE_CHUNK, json_file_flush, f) < 0)
+	    goto done;
+	if (json_file_flush(f, cb) < 0) /* remainder */
+	    goto done;
+	goto ok;
+    }
     if ((cb = cbuf_new()) ==NULL){
 	clicon_err(OE_XML, errno, "cbuf_new");
 	goto done;
@@ -1038,6 +1269,7 @@ xml2json_cb(FILE             *f,
     if (xml2json_cbuf(cb, x, pretty) < 0)
 	goto done;
     (*fn)(f, "%s", cbuf_get(cb));
+ ok:
     retval = 0;
  done:
     if (cb)
@@ -1130,7 +1362,7 @@ xml2json_vec(FILE      *f,
  * Example: <top><module:input> --> <top><input xmlns="">
  * @see RFC7951 Sec 4
  */
-static int
+int
 json_xmlns_translate(yang_stmt *yspec,
 		     cxobj     *x,
 		     cxobj    **xerr)
@@ -1178,7 +1410,7 @@ json_xmlns_translate(yang_stmt *yspec,
 
 /*! Parse a string containing JSON and return an XML tree
  *
- * Parsing using yacc according to JSON syntax. Names with <prefix>:<id>
+ * Parsing according to JSON syntax. Names with <prefix>:<id>
  * are split and interpreted as in RFC7951
  *
  * @param[in]  str    Input string containing JSON
@@ -1202,7 +1434,7 @@ _json_parse(char      *str,
 	    cxobj    **xerr)
 {
     int              retval = -1;
-    clixon_json_yacc jy = {0,};
+    clixon_json_parse jp = {0,};
     int              ret;
     cxobj           *x;
     cbuf            *cberr = NULL;
@@ -1210,23 +1442,18 @@ _json_parse(char      *str,
     int              failed = 0; /* yang assignment */
     
     clicon_debug(1, "%s %d %s", __FUNCTION__, yb, str);
-    jy.jy_parse_string = str;
-    jy.jy_linenum = 1;
-    jy.jy_current = xt;
-    jy.jy_xtop = xt;
-    if (json_scan_init(&jy) < 0)
+    jp.jp_parse_string = str;
+    jp.jp_linenum = 1;
+    jp.jp_xtop = xt;
+    if (json_parse_init(&jp) < 0)
 	goto done;
-    if (json_parse_init(&jy) < 0)
-	goto done;
-    if (clixon_json_parseparse(&jy) != 0) { /* yacc returns 1 on error */
-	clicon_log(LOG_NOTICE, "JSON error: line %d", jy.jy_linenum);
-	if (clicon_errno == 0)
-	    clicon_err(OE_XML, 0, "JSON parser error with no error code (should not happen)");
+    if (json_parse(&jp) < 0){
+	clicon_log(LOG_NOTICE, "JSON error: line %d", jp.jp_linenum);
 	goto done;
     }
     /* Traverse new objects */
-    for (i = 0; i < jy.jy_xlen; i++) {
-	x = jy.jy_xvec[i];
+    for (i = 0; i < jp.jp_xlen; i++) {
+	x = jp.jp_xvec[i];
 	/* RFC 7951 Section 4: A namespace-qualified member name MUST be used for all 
 	 * members of a top-level JSON object 
 	 */
@@ -1297,10 +1524,9 @@ _json_parse(char      *str,
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
     if (cberr)
 	cbuf_free(cberr);
-    json_parse_exit(&jy);
-    json_scan_exit(&jy);
-    if (jy.jy_xvec)
-	free(jy.jy_xvec);
+    json_parse_exit(&jp);
+    if (jp.jp_xvec)
+	free(jp.jp_xvec);
     return retval; 
  fail: /* invalid */
     retval = 0;
@@ -1392,9 +1618,7 @@ clixon_json_parse_file(FILE      *fp,
     int       ret;
     char     *jsonbuf = NULL;
     int       jsonbuflen = BUFLEN; /* start size */
-    int       oldjsonbuflen;
-    char     *ptr;
-    char      ch;
+    size_t    ret1;
     int       len = 0;
 
     if (xt==NULL){
@@ -1405,42 +1629,39 @@ clixon_json_parse_file(FILE      *fp,
 	clicon_err(OE_XML, errno, "malloc");
 	goto done;
     }
-    memset(jsonbuf, 0, jsonbuflen);
-    ptr = jsonbuf;
-    while (1){
-	if ((ret = fread(&ch, 1, 1, fp)) < 0){
-	    clicon_err(OE_XML, errno, "read");
-	    break;
-	}
-	if (ret != 0)
-	    jsonbuf[len++] = ch;
-	if (ret == 0){
-	    if (*xt == NULL)
-		if ((*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-		    goto done;
-	    if (len){
-		if ((ret = _json_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-		    goto done;
-		if (ret == 0)
-		    goto fail;
-	    }
-	    break;
-	}
-	if (len >= jsonbuflen-1){ /* Space: one for the null character */
-	    oldjsonbuflen = jsonbuflen;
+    /* Read whole file in blocks, space for the null character */
+    while ((ret1 = fread(jsonbuf+len, 1, jsonbuflen-1-len, fp)) > 0){
+	len += ret1;
+	if (len >= jsonbuflen-1){ 
 	    jsonbuflen *= 2;
 	    if ((jsonbuf = realloc(jsonbuf, jsonbuflen)) == NULL){
 		clicon_err(OE_XML, errno, "realloc");
 		goto done;
 	    }
-	    memset(jsonbuf+oldjsonbuflen, 0, jsonbuflen-oldjsonbuflen);
-	    ptr = jsonbuf;
 	}
     }
+    if (ferror(fp)){
+	clicon_err(OE_XML, errno, "read");
+	goto done;
+    }
+    jsonbuf[len] = '\0';
+    xml_arena_begin(); /* Allocate nodes of parsed tree from arena blocks */
+    if (*xt == NULL &&
+	(*xt = xml_new(JSON_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	ret = -1;
+    else if (len)
+	ret = _json_parse(jsonbuf, yb, yspec, *xt, xerr);
+    else
+	ret = 1;
+    xml_arena_end();
+    if (ret < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
     retval = 1;
  done:
     if (retval < 0 && *xt){
-	free(*xt);
+	xml_free(*xt);
 	*xt = NULL;
     }
     if (jsonbuf)
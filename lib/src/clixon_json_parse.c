@@ -0,0 +1,586 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * JSON Parser
+ * From http://www.ecma-international.org/publications/files/ECMA-ST/ECMA-404.pdf
+ * And RFC7951 JSON Encoding of Data Modeled with YANG
+ *
+ * Hand-written recursive descent parser building the XML tree directly from the
+ * parse string. Names and strings are copied once into a reused buffer, and plain
+ * runs of string characters are copied as a whole.
+
+value    ::= object  |
+             array   |
+	     number  |
+	     string  |
+	     'true'  |
+	     'false' |
+	     'null'  ;
+
+object   ::= '{' [objlist] '}';
+objlist  ::= pair [',' objlist];
+pair     ::= string ':' value;
+
+array    ::= '[' [vallist] ']';
+vallist  ::= value [',' vallist];
+
+XML translation:
+<a>34</a>  <--> { "a": "34" }
+Easiest if top-object is single xml-tree <--> single object
+JSON lists are translated to repeated XML elements with the same name:
+{ "a": [1, 2] } <--> <a>1</a><a>2</a>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <ctype.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_queue.h"
+#include "clixon_string.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_json_parse.h"
+
+/* Max length of token in syntax error messages */
+#define JSON_TOKEN_MAX 32
+
+/* Max nesting of objects and arrays, same as YYMAXDEPTH of the former bison parser.
+ * The parser is recursive, deeper input would overflow the stack
+ */
+#define JSON_DEPTH_MAX 10000
+
+static int json_parse_value(clixon_json_parse *jp, cxobj *x);
+
+/*! Report syntax error at current position
+ * The token at the current position is given in the error message
+ * @param[in]  jp   JSON parse state
+ * @retval    -1    Always
+ */
+static int
+json_parse_error(clixon_json_parse *jp)
+{
+    char *p = jp->jp_p;
+    int   len = 0;
+
+    if (isalnum(*p) || *p == '-' || *p == '.'){
+	while ((isalnum(p[len]) || p[len] == '-' || p[len] == '+' || p[len] == '.') &&
+	       len < JSON_TOKEN_MAX)
+	    len++;
+    }
+    else if (*p != '\0')
+	len = 1;
+    clicon_err(OE_XML, XMLPARSE_ERRNO, "json_parse: line %d: syntax error at or before: '%.*s'", 
+	       jp->jp_linenum, len, p);
+    return -1;
+}
+
+/*! Skip white space, count lines
+ * @param[in]  jp   JSON parse state
+ */
+static void
+json_parse_ws(clixon_json_parse *jp)
+{
+    char *p = jp->jp_p;
+
+    while (1){
+	switch (*p){
+	case '\n':
+	    jp->jp_linenum++;
+	    /* fall thru */
+	case ' ':
+	case '\t':
+	case '\r':
+	    p++;
+	    break;
+	default:
+	    jp->jp_p = p;
+	    return;
+	}
+    }
+}
+
+/*! Append a unicode code point to buffer encoded as UTF-8
+ * @param[in]  cb   Buffer
+ * @param[in]  u    Unicode code point
+ */
+static void
+json_utf8_append(cbuf    *cb,
+		 uint32_t u)
+{
+    char buf[4];
+    int  len;
+
+    if (u < 0x80){
+	buf[0] = u;
+	len = 1;
+    }
+    else if (u < 0x800){
+	buf[0] = 0xc0 | (u >> 6);
+	buf[1] = 0x80 | (u & 0x3f);
+	len = 2;
+    }
+    else if (u < 0x10000){
+	buf[0] = 0xe0 | (u >> 12);
+	buf[1] = 0x80 | ((u >> 6) & 0x3f);
+	buf[2] = 0x80 | (u & 0x3f);
+	len = 3;
+    }
+    else {
+	buf[0] = 0xf0 | (u >> 18);
+	buf[1] = 0x80 | ((u >> 12) & 0x3f);
+	buf[2] = 0x80 | ((u >> 6) & 0x3f);
+	buf[3] = 0x80 | (u & 0x3f);
+	len = 4;
+    }
+    cbuf_append_buf(cb, buf, len);
+}
+
+/*! Parse four hex digits of a \\u escape
+ * @param[in]  p    Parse string after \\u
+ * @param[out] u    Value
+ * @retval     0    OK
+ * @retval    -1    Not four hex digits
+ */
+static int
+json_parse_hex4(char     *p,
+		uint32_t *u)
+{
+    int  i;
+    char c;
+
+    *u = 0;
+    for (i=0; i<4; i++){
+	c = p[i];
+	if (c >= '0' && c <= '9')
+	    *u = (*u << 4) | (c - '0');
+	else if (c >= 'a' && c <= 'f')
+	    *u = (*u << 4) | (c - 'a' + 10);
+	else if (c >= 'A' && c <= 'F')
+	    *u = (*u << 4) | (c - 'A' + 10);
+	else
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Parse a quoted string into the reused buffer jp_cb
+ *
+ * Runs of characters without escapes are appended as a whole.
+ * Escapes are decoded, including \\uXXXX to UTF-8. An unknown escape is the escaped
+ * character itself.
+ * @param[in]  jp   JSON parse state, current position at starting double quote
+ * @retval     0    OK, string in jp_cb, position after ending double quote
+ * @retval    -1    Error
+ */
+static int
+json_parse_str(clixon_json_parse *jp)
+{
+    char    *p = jp->jp_p + 1;
+    char    *p0;
+    char     c;
+    uint32_t u;
+    uint32_t u2;
+
+    cbuf_reset(jp->jp_cb);
+    while (1){
+	p0 = p;
+	while ((c = *p) != '"' && c != '\\' && c != '\n' && c != '\0')
+	    p++;
+	if (p > p0)
+	    cbuf_append_buf(jp->jp_cb, p0, p-p0);
+	switch (c){
+	case '"':
+	    jp->jp_p = p + 1;
+	    return 0;
+	case '\n':
+	    jp->jp_linenum++;
+	    cbuf_append_buf(jp->jp_cb, p, 1);
+	    p++;
+	    break;
+	case '\\':
+	    p++;
+	    switch (c = *p){
+	    case 'b':
+		cbuf_append_buf(jp->jp_cb, "\b", 1);
+		break;
+	    case 'f':
+		cbuf_append_buf(jp->jp_cb, "\f", 1);
+		break;
+	    case 'n':
+		cbuf_append_buf(jp->jp_cb, "\n", 1);
+		break;
+	    case 'r':
+		cbuf_append_buf(jp->jp_cb, "\r", 1);
+		break;
+	    case 't':
+		cbuf_append_buf(jp->jp_cb, "\t", 1);
+		break;
+	    case 'u':
+		if (json_parse_hex4(p+1, &u) < 0){
+		    jp->jp_p = p;
+		    return json_parse_error(jp);
+		}
+		p += 4;
+		/* Surrogate pair */
+		if (u >= 0xd800 && u < 0xdc00 &&
+		    p[1] == '\\' && p[2] == 'u' &&
+		    json_parse_hex4(p+3, &u2) == 0 &&
+		    u2 >= 0xdc00 && u2 < 0xe000){
+		    u = 0x10000 + ((u - 0xd800) << 10) + (u2 - 0xdc00);
+		    p += 6;
+		}
+		json_utf8_append(jp->jp_cb, u);
+		break;
+	    case '\0':
+		jp->jp_p = p;
+		return json_parse_error(jp);
+		break;
+	    case '\n':
+		jp->jp_linenum++;
+		/* fall thru */
+	    default: /* Also \" \\ and \/ */
+		cbuf_append_buf(jp->jp_cb, p, 1);
+		break;
+	    }
+	    p++;
+	    break;
+	default: /* End of string before ending double quote */
+	    jp->jp_p = p;
+	    return json_parse_error(jp);
+	}
+    }
+}
+
+/*! Add a body with value to XML element 
+ * @param[in]  x     XML element
+ * @param[in]  value Body value, or NULL for no value (null)
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+json_parse_body(cxobj *x,
+		char  *value)
+{
+    cxobj *xb;
+
+    if ((xb = xml_new("body", x, CX_BODY)) == NULL)
+	return -1;
+    if (value && xml_value_set(xb, value) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Parse a number, copy it as a body of the XML element
+ * @param[in]  jp   JSON parse state, current position at number
+ * @param[in]  x    XML element
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+json_parse_number(clixon_json_parse *jp,
+		  cxobj             *x)
+{
+    char *p = jp->jp_p;
+    int   digits = 0;
+
+    if (*p == '-')
+	p++;
+    while (isdigit(*p)){
+	p++;
+	digits++;
+    }
+    if (*p == '.'){
+	p++;
+	while (isdigit(*p)){
+	    p++;
+	    digits++;
+	}
+    }
+    if (digits == 0)
+	return json_parse_error(jp);
+    if (*p == 'e' || *p == 'E'){
+	p++;
+	if (*p == '+' || *p == '-')
+	    p++;
+	if (!isdigit(*p))
+	    return json_parse_error(jp);
+	while (isdigit(*p))
+	    p++;
+    }
+    cbuf_reset(jp->jp_cb);
+    cbuf_append_buf(jp->jp_cb, jp->jp_p, p - jp->jp_p);
+    jp->jp_p = p;
+    return json_parse_body(x, cbuf_get(jp->jp_cb));
+}
+
+/*! Parse an object, members are created as children of the XML element
+ *
+ * Names with <prefix>:<id> are split as in RFC7951. Members of the top element are
+ * added to the vector of created top-level nodes.
+ * @param[in]  jp   JSON parse state, current position at '{'
+ * @param[in]  x    XML element
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+json_parse_object(clixon_json_parse *jp,
+		  cxobj             *x)
+{
+    cxobj *xc;
+    char  *name;
+    char  *id;
+
+    jp->jp_p++;
+    json_parse_ws(jp);
+    if (*jp->jp_p == '}'){
+	jp->jp_p++;
+	return 0;
+    }
+    while (1){
+	if (*jp->jp_p != '"')
+	    return json_parse_error(jp);
+	if (json_parse_str(jp) < 0)
+	    return -1;
+	/* Split name into prefix:id in place */
+	name = cbuf_get(jp->jp_cb);
+	if ((id = strchr(name, ':')) != NULL)
+	    *id++ = '\0';
+	if ((xc = xml_new(id?id:name, x, CX_ELMNT)) == NULL)
+	    return -1;
+	if (id && xml_prefix_set(xc, name) < 0)
+	    return -1;
+	if (x == jp->jp_xtop &&
+	    cxvec_append(xc, &jp->jp_xvec, &jp->jp_xlen) < 0)
+	    return -1;
+	json_parse_ws(jp);
+	if (*jp->jp_p != ':')
+	    return json_parse_error(jp);
+	jp->jp_p++;
+	json_parse_ws(jp);
+	if (json_parse_value(jp, xc) < 0)
+	    return -1;
+	json_parse_ws(jp);
+	if (*jp->jp_p == '}'){
+	    jp->jp_p++;
+	    return 0;
+	}
+	if (*jp->jp_p != ',')
+	    return json_parse_error(jp);
+	jp->jp_p++;
+	json_parse_ws(jp);
+    }
+}
+
+/*! Parse an array as repeated XML elements with the same name
+ *
+ * The first value is the value of the XML element. Each following value is the value
+ * of a new sibling with the same name and prefix. The XML element is removed if the
+ * array is empty.
+ * @param[in]  jp   JSON parse state, current position at '['
+ * @param[in]  x    XML element
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+json_parse_array(clixon_json_parse *jp,
+		 cxobj             *x)
+{
+    cxobj *xp;
+    char  *prefix;
+    char  *p;
+
+    jp->jp_p++;
+    json_parse_ws(jp);
+    xp = xml_parent(x);
+    if (*jp->jp_p == ']'){
+	jp->jp_p++;
+	if (xp == NULL)
+	    return json_parse_error(jp);
+	if (jp->jp_xlen && jp->jp_xvec[jp->jp_xlen-1] == x)
+	    jp->jp_xlen--;
+	if (xml_purge(x) < 0)
+	    return -1;
+	return 0;
+    }
+    while (1){
+	/* An empty array removes x, which is then used by this array */
+	if (*jp->jp_p == '['){
+	    p = jp->jp_p + 1;
+	    while (isspace(*p))
+		p++;
+	    if (*p == ']')
+		return json_parse_error(jp);
+	}
+	if (json_parse_value(jp, x) < 0)
+	    return -1;
+	json_parse_ws(jp);
+	if (*jp->jp_p == ']'){
+	    jp->jp_p++;
+	    return 0;
+	}
+	if (*jp->jp_p != ',' || xp == NULL) /* No siblings of top */
+	    return json_parse_error(jp);
+	jp->jp_p++;
+	json_parse_ws(jp);
+	prefix = xml_prefix(x);
+	if ((x = xml_new(xml_name(x), xp, CX_ELMNT)) == NULL)
+	    return -1;
+	if (prefix && xml_prefix_set(x, prefix) < 0)
+	    return -1;
+	if (xp == jp->jp_xtop &&
+	    cxvec_append(x, &jp->jp_xvec, &jp->jp_xlen) < 0)
+	    return -1;
+    }
+}
+
+/*! Parse a value of an XML element
+ * @param[in]  jp   JSON parse state, current position at value
+ * @param[in]  x    XML element
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+json_parse_value(clixon_json_parse *jp,
+		 cxobj             *x)
+{
+    char *p = jp->jp_p;
+    int   ret;
+
+    switch (*p){
+    case '{':
+    case '[':
+	if (jp->jp_depth >= JSON_DEPTH_MAX){
+	    clicon_err(OE_XML, XMLPARSE_ERRNO,
+		       "json_parse: line %d: syntax error: nesting deeper than %d",
+		       jp->jp_linenum, JSON_DEPTH_MAX);
+	    return -1;
+	}
+	jp->jp_depth++;
+	if (*p == '{')
+	    ret = json_parse_object(jp, x);
+	else
+	    ret = json_parse_array(jp, x);
+	jp->jp_depth--;
+	return ret;
+    case '"':
+	if (json_parse_str(jp) < 0)
+	    return -1;
+	return json_parse_body(x, cbuf_get(jp->jp_cb));
+    case 't':
+	if (strncmp(p, "true", 4) != 0)
+	    break;
+	jp->jp_p += 4;
+	return json_parse_body(x, "true");
+    case 'f':
+	if (strncmp(p, "false", 5) != 0)
+	    break;
+	jp->jp_p += 5;
+	return json_parse_body(x, "false");
+    case 'n':
+	if (strncmp(p, "null", 4) != 0)
+	    break;
+	jp->jp_p += 4;
+	return json_parse_body(x, NULL);
+    case '-':
+    case '.':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+	return json_parse_number(jp, x);
+    default:
+	break;
+    }
+    return json_parse_error(jp);
+}
+
+/*! Initialize JSON parser
+ * @param[in]  jp   JSON parse state with parse string and top element set
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+json_parse_init(clixon_json_parse *jp)
+{
+    jp->jp_p = jp->jp_parse_string;
+    jp->jp_depth = 0;
+    if ((jp->jp_cb = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	return -1;
+    }
+    return 0;
+}
+
+/*! Free JSON parser state, but not the created tree
+ * @param[in]  jp   JSON parse state
+ */
+int
+json_parse_exit(clixon_json_parse *jp)
+{
+    if (jp->jp_cb){
+	cbuf_free(jp->jp_cb);
+	jp->jp_cb = NULL;
+    }
+    return 0;
+}
+
+/*! Parse the JSON string and create XML nodes under the top element
+ * @param[in]  jp   JSON parse state
+ * @retval     0    OK, created top-level nodes in jp_xvec
+ * @retval    -1    Error, syntax error with clicon_err called
+ */
+int
+json_parse(clixon_json_parse *jp)
+{
+    json_parse_ws(jp);
+    if (json_parse_value(jp, jp->jp_xtop) < 0)
+	return -1;
+    json_parse_ws(jp);
+    if (*jp->jp_p != '\0')
+	return json_parse_error(jp);
+    return 0;
+}
@@ -57,6 +57,8 @@
 #include <cligen/cligen.h>
 
 /* clicon */
+#include "clixon_queue.h"
+#include "clixon_string.h"
 #include "clixon_err.h"
 #include "clixon_log.h"
 
@@ -67,12 +69,36 @@
  */
 static int _clixon_debug = 0;
 
+/* Debug level per category set with clixon_debug_category_set(), -1 means the global
+ * level is used */
+static int _clixon_debug_cat[CLIXON_DBG_NR] = {-1, -1, -1, -1, -1};
+
+/* Effective debug level per category, checked inline by clixon_debug() macro */
+int _clixon_debug_level[CLIXON_DBG_NR] = {0, };
+
+/* Names of debug categories, index is category, see clixon_debug_category_parse() */
+static const char *_clixon_debug_catname[CLIXON_DBG_NR] = {
+    "default", "event", "msg", "xpath", "datastore"
+};
+
 /* Bitmask whether to log to syslog or stderr: CLICON_LOG_STDERR | CLICON_LOG_SYSLOG */
 static int _logflags = 0x0;
 
 /* Set to open file to write debug messages directly to file */
 static FILE *_logfile = NULL;
 
+/*! Recompute effective debug level of all categories
+ */
+static void
+clixon_debug_level_update(void)
+{
+    int cat;
+
+    for (cat=0; cat<CLIXON_DBG_NR; cat++)
+	_clixon_debug_level[cat] = _clixon_debug_cat[cat] >= 0 ?
+	    _clixon_debug_cat[cat] : _clixon_debug;
+}
+
 /*! Initialize system logger.
  *
  * Make syslog(3) calls with specified ident and gates calls of level upto specified level (upto).
@@ -316,7 +342,7 @@ clicon_debug_init(int   dbglevel,
 		  FILE *f)
 {
     _clixon_debug = dbglevel; /* Global variable */
-    
+    clixon_debug_level_update();
     if (f != NULL){
 	if (_logfile)
 	    fclose(_logfile);
@@ -331,32 +357,96 @@ clicon_debug_get(void)
     return _clixon_debug;
 }
 
-/*! Print a debug message with debug-level. Settings determine where msg appears.
- *
- * If the dbglevel passed in the function is equal to or lower than the one set by 
- * clicon_debug_init(level).  That is, only print debug messages <= than what you want:
- *      print message if level >= dbglevel.
- * The message is sent to clicon_log. EIther to syslog, stderr or both, depending on 
- * clicon_log_init() setting
- * 
- * @param[in] dbglevel   0 always called (dont do this: not really a dbg message)
- *                       1 default level if passed -D
- *                       2.. Higher debug levels
- * @param[in] format     Message to print as argv.
+/*! Set debug level of a debug category, overriding the global debug level
+ * @param[in] cat       Debug category, eg CLIXON_DBG_EVENT
+ * @param[in] dbglevel  Debug level of category, -1 means use global level again
+ * @retval    0         OK
+ * @retval   -1         Error: no such category
+ * @see clicon_debug_init  for the global level
  */
 int
-clicon_debug(int         dbglevel, 
-	     const char *format, ...)
+clixon_debug_category_set(int cat,
+			  int dbglevel)
+{
+    if (cat < 0 || cat >= CLIXON_DBG_NR){
+	clicon_err(OE_CFG, EINVAL, "No such debug category: %d", cat);
+	return -1;
+    }
+    _clixon_debug_cat[cat] = dbglevel < 0 ? -1 : dbglevel;
+    clixon_debug_level_update();
+    return 0;
+}
+
+/*! Set debug levels of debug categories from a string
+ * @param[in] str  Comma-separated list of <category>=<level>, eg "event=0,msg=2"
+ * @retval    0    OK
+ * @retval   -1    Error: syntax error or no such category
+ * @code
+ *   if (clixon_debug_category_parse("xpath=0") < 0)
+ *      err;
+ * @endcode
+ */
+int
+clixon_debug_category_parse(char *str)
+{
+    int    retval = -1;
+    char **vec = NULL;
+    int    nvec;
+    int    i;
+    int    cat;
+    char  *name;
+    char  *val;
+    char  *ep;
+    long   level;
+
+    if ((vec = clicon_strsep(str, ",", &nvec)) == NULL)
+	goto done;
+    for (i=0; i<nvec; i++){
+	name = clixon_trim(vec[i]);
+	if (strlen(name) == 0)
+	    continue;
+	if ((val = index(name, '=')) == NULL){
+	    clicon_err(OE_CFG, EINVAL, "Debug category %s: expected <category>=<level>", name);
+	    goto done;
+	}
+	*val++ = '\0';
+	for (cat=0; cat<CLIXON_DBG_NR; cat++)
+	    if (strcmp(_clixon_debug_catname[cat], clixon_trim(name)) == 0)
+		break;
+	if (cat == CLIXON_DBG_NR){
+	    clicon_err(OE_CFG, EINVAL, "No such debug category: %s", name);
+	    goto done;
+	}
+	level = strtol(val, &ep, 10);
+	if (ep == val || *clixon_trim(ep) != '\0'){
+	    clicon_err(OE_CFG, EINVAL, "Debug category %s: invalid level: %s", name, val);
+	    goto done;
+	}
+	if (clixon_debug_category_set(cat, (int)level) < 0)
+	    goto done;
+    }
+    retval = 0;
+ done:
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Format and log a debug message given as va_list
+ * @param[in] format     Message to print as argv.
+ * @param[in] ap         Arguments of format
+ */
+static int
+clicon_debug_vprint(const char *format,
+		    va_list     ap)
 {
     va_list args;
     int     len;
     char   *msg    = NULL;
     int     retval = -1;
 
-    if (dbglevel > _clixon_debug) /* compare debug mask with global variable */
-	return 0;
     /* first round: compute length of debug message */
-    va_start(args, format);
+    va_copy(args, ap);
     len = vsnprintf(NULL, 0, format, args);
     va_end(args);
 
@@ -366,7 +456,7 @@ clicon_debug(int         dbglevel,
 	goto done;
     }
     /* second round: compute write message from format and args */
-    va_start(args, format);
+    va_copy(args, ap);
     if (vsnprintf(msg, len+1, format, args) < 0){
 	va_end(args);
 	clicon_err(OE_UNIX, errno, "vsnprintf");
@@ -381,6 +471,52 @@ clicon_debug(int         dbglevel,
     return retval;
 }
 
+/*! Print a debug message with debug-level. Settings determine where msg appears.
+ *
+ * If the dbglevel passed in the function is equal to or lower than the one set by 
+ * clicon_debug_init(level).  That is, only print debug messages <= than what you want:
+ *      print message if level >= dbglevel.
+ * The message is sent to clicon_log. EIther to syslog, stderr or both, depending on 
+ * clicon_log_init() setting
+ * 
+ * @param[in] dbglevel   0 always called (dont do this: not really a dbg message)
+ *                       1 default level if passed -D
+ *                       2.. Higher debug levels
+ * @param[in] format     Message to print as argv.
+ */
+int
+clicon_debug(int         dbglevel, 
+	     const char *format, ...)
+{
+    va_list args;
+    int     retval;
+
+    if (dbglevel > _clixon_debug) /* compare debug mask with global variable */
+	return 0;
+    va_start(args, format);
+    retval = clicon_debug_vprint(format, args);
+    va_end(args);
+    return retval;
+}
+
+/*! Print a debug message without checking the debug level
+ *
+ * Called by the clixon_debug() macro after the level of the category is checked
+ * @param[in] format     Message to print as argv.
+ * @see clixon_debug     Use the macro, not this function directly
+ */
+int
+clicon_debug_print(const char *format, ...)
+{
+    va_list args;
+    int     retval;
+
+    va_start(args, format);
+    retval = clicon_debug_vprint(format, args);
+    va_end(args);
+    return retval;
+}
+
 /*! Translate month number (0..11) to a three letter month name
  * @param[in] md  month number, where 0 is january
  */
@@ -103,10 +103,436 @@ match_access(char *access_operations,
     return 0;
 }
 
+/*---------------------------------------------------------------
+ * Compiled NACM rule set
+ */
+
+/* Access operation bit of compiled rule, see enum nacm_access */
+#define NACM_ACCESS_BIT(a) (1<<(a))
+
+/* NACM rule compiled from NACM tree, strings point into the tree */
+struct nacm_rule{
+    cxobj       *nr_xrule;  /* Rule in NACM tree */
+    char        *nr_module; /* module-name, or NULL */
+    char        *nr_rpc;    /* rpc-name, or NULL */
+    char        *nr_notif;  /* notification-name, or NULL */
+    char        *nr_path;   /* path, trimmed, or NULL */
+    clixon_path *nr_cplist; /* Resolved path, or NULL if path is not resolved */
+    int          nr_resolve;/* -1: path could not be parsed, 0: does not resolve, 1: resolved */
+    yang_stmt   *nr_target; /* Schema node of resolved path */
+    int          nr_keyed;  /* Resolved path has key or position predicates */
+    int          nr_access; /* Matching access operations, NACM_ACCESS_BIT */
+    char        *nr_action; /* action: permit or deny */
+};
+
+/* Rules of a NACM user: rules of the rule-lists of the groups of the user, in order */
+struct nacm_user{
+    char             **nu_groups; /* Groups of user */
+    int                nu_glen;
+    struct nacm_rule **nu_rules;  /* Rules of user */
+    int                nu_rlen;
+    clicon_hash_t     *nu_read;   /* Read rules of schema nodes, struct nacm_read */
+};
+
+/* Read rules of a NACM user that may match data nodes of a schema node, in order.
+ * The rules are ended by the first rule that always matches, ie has no path or a path
+ * without predicates. The other rules match depending on the instance of the data node.
+ */
+struct nacm_read{
+    int *nrd_rules;   /* Index of rules in nu_rules */
+    int  nrd_len;
+    int  nrd_uniform; /* No other rule may match descendants */
+};
+
+/* NACM rule set compiled from NACM tree, kept until the NACM config changes */
+struct nacm_ruleset{
+    cxobj            *nrs_xnacm;   /* NACM tree, or NULL if no NACM config */
+    int               nrs_copy;    /* nrs_xnacm is a copy owned by the rule set */
+    cxobj            *nrs_xext;    /* External NACM tree compiled from, or NULL */
+    uint64_t          nrs_gen;     /* Generation of running datastore compiled from */
+    int               nrs_enabled; /* enable-nacm is true */
+    struct nacm_rule *nrs_rules;   /* All rules in order of rule-lists */
+    int               nrs_rlen;
+    clicon_hash_t    *nrs_users;   /* Users of groups, struct nacm_user */
+};
+typedef struct nacm_ruleset nacm_ruleset;
+
+/*! Free read rules of schema nodes
+ * @param[in]  hash  Read rules of schema nodes, struct nacm_read
+ */
+static int
+nacm_read_free(clicon_hash_t *hash)
+{
+    char            **keys = NULL;
+    size_t            klen;
+    int               i;
+    struct nacm_read *nrd;
+
+    if (clicon_hash_keys(hash, &keys, &klen) == 0)
+	for (i=0; i<klen; i++)
+	    if ((nrd = clicon_hash_value(hash, keys[i], NULL)) != NULL &&
+		nrd->nrd_rules)
+		free(nrd->nrd_rules);
+    if (keys)
+	free(keys);
+    clicon_hash_free(hash);
+    return 0;
+}
+
+/*! Free compiled NACM rule set
+ * @param[in]  nrs   NACM rule set
+ */
+static int
+nacm_ruleset_free1(nacm_ruleset *nrs)
+{
+    char            **keys = NULL;
+    size_t            klen;
+    int               i;
+    struct nacm_user *nu;
+
+    if (nrs->nrs_users){
+	if (clicon_hash_keys(nrs->nrs_users, &keys, &klen) == 0)
+	    for (i=0; i<klen; i++)
+		if ((nu = clicon_hash_value(nrs->nrs_users, keys[i], NULL)) != NULL){
+		    if (nu->nu_groups)
+			free(nu->nu_groups);
+		    if (nu->nu_rules)
+			free(nu->nu_rules);
+		    if (nu->nu_read)
+			nacm_read_free(nu->nu_read);
+		}
+	if (keys)
+	    free(keys);
+	clicon_hash_free(nrs->nrs_users);
+    }
+    if (nrs->nrs_rules){
+	for (i=0; i<nrs->nrs_rlen; i++)
+	    if (nrs->nrs_rules[i].nr_cplist)
+		clixon_path_free(nrs->nrs_rules[i].nr_cplist);
+	free(nrs->nrs_rules);
+    }
+    if (nrs->nrs_copy && nrs->nrs_xnacm)
+	xml_free(nrs->nrs_xnacm);
+    free(nrs);
+    return 0;
+}
+
+/*! Compile a single NACM rule
+ * @param[in]  h     Clicon handle
+ * @param[in]  xrule NACM rule XML
+ * @param[out] nr    Compiled rule
+ * @retval     0     OK
+ */
+static int
+nacm_rule_compile(clicon_handle     h,
+		  cxobj            *xrule,
+		  struct nacm_rule *nr)
+{
+    char        *ao;
+    cxobj       *xpath;
+    yang_stmt   *yspec;
+    clixon_path *cp;
+
+    nr->nr_xrule = xrule;
+    nr->nr_module = xml_find_body(xrule, "module-name");
+    nr->nr_rpc = xml_find_body(xrule, "rpc-name");
+    nr->nr_notif = xml_find_body(xrule, "notification-name");
+    nr->nr_action = xml_find_body(xrule, "action");
+    ao = xml_find_body(xrule, "access-operations");
+    if (match_access(ao, "read", NULL))
+	nr->nr_access |= NACM_ACCESS_BIT(NACM_READ);
+    if (match_access(ao, "create", "write"))
+	nr->nr_access |= NACM_ACCESS_BIT(NACM_CREATE);
+    if (match_access(ao, "update", "write"))
+	nr->nr_access |= NACM_ACCESS_BIT(NACM_UPDATE);
+    if (match_access(ao, "delete", "write"))
+	nr->nr_access |= NACM_ACCESS_BIT(NACM_DELETE);
+    if (match_access(ao, "exec", NULL))
+	nr->nr_access |= NACM_ACCESS_BIT(NACM_EXEC);
+    if ((xpath = xml_find_type(xrule, NULL, "path", CX_ELMNT)) != NULL &&
+	xml_body(xpath) != NULL){
+	nr->nr_path = clixon_trim2(xml_body(xpath), " \t\n");
+	yspec = clicon_dbspec_yang(h);
+	/* Parse errors are reported when the path is used, as before compiling */
+	if ((nr->nr_resolve = clixon_instance_id_compile(yspec, nr->nr_path, &nr->nr_cplist)) < 0)
+	    clicon_err_reset();
+	if ((cp = nr->nr_cplist) != NULL){
+	    do {
+		if (cp->cp_cvk && cvec_len(cp->cp_cvk))
+		    nr->nr_keyed = 1;
+		nr->nr_target = cp->cp_yang;
+		cp = NEXTQ(clixon_path *, cp);
+	    } while (cp && cp != nr->nr_cplist);
+	}
+    }
+    return 0;
+}
+
+/*! Compile NACM rule set from NACM tree
+ *
+ * The rule set has the groups and rules of each user, and the rules with pre-parsed fields
+ * and paths.
+ * @param[in]  h      Clicon handle
+ * @param[in]  xnacm  NACM XML tree, root is "nacm". Is not copied
+ * @param[out] nrsp   NACM rule set, free with nacm_ruleset_free1
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_ruleset_compile(clicon_handle  h,
+		     cxobj         *xnacm,
+		     nacm_ruleset **nrsp)
+{
+    int               retval = -1;
+    nacm_ruleset     *nrs = NULL;
+    cvec             *nsc = NULL;
+    cxobj            *x;
+    cxobj            *xc;
+    cxobj           **gvec = NULL;
+    size_t            glen;
+    cxobj           **rlistvec = NULL;
+    size_t            rlistlen;
+    cxobj           **rvec = NULL;
+    size_t            rlen;
+    char            **keys = NULL;
+    size_t            klen;
+    struct nacm_user  nu0;
+    struct nacm_user *nu;
+    char             *gname;
+    char             *uname;
+    char             *body;
+    int               i, j, k, l;
+    int               n;
+
+    if ((nrs = malloc(sizeof(*nrs))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(nrs, 0, sizeof(*nrs));
+    nrs->nrs_xnacm = xnacm;
+    if ((nrs->nrs_users = clicon_hash_init()) == NULL)
+	goto done;
+    if (xnacm == NULL)
+	goto ok;
+    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+	goto done;
+    if ((x = xpath_first(xnacm, nsc, "enable-nacm")) != NULL &&
+	(body = xml_body(x)) != NULL &&
+	strcmp(body, "true") == 0)
+	nrs->nrs_enabled = 1;
+    /* Users and their groups */
+    if (xpath_vec(xnacm, nsc, "groups/group", &gvec, &glen) < 0)
+	goto done;
+    for (i=0; i<glen; i++){
+	gname = xml_find_body(gvec[i], "name");
+	xc = NULL;
+	while ((xc = xml_child_each(gvec[i], xc, CX_ELMNT)) != NULL){
+	    if (strcmp(xml_name(xc), "user-name") != 0 ||
+		(uname = xml_body(xc)) == NULL)
+		continue;
+	    if ((nu = clicon_hash_value(nrs->nrs_users, uname, NULL)) == NULL){
+		memset(&nu0, 0, sizeof(nu0));
+		if (clicon_hash_add(nrs->nrs_users, uname, &nu0, sizeof(nu0)) == NULL)
+		    goto done;
+		nu = clicon_hash_value(nrs->nrs_users, uname, NULL);
+	    }
+	    if ((nu->nu_groups = realloc(nu->nu_groups, (nu->nu_glen+1)*sizeof(char*))) == NULL){
+		clicon_err(OE_UNIX, errno, "realloc");
+		goto done;
+	    }
+	    nu->nu_groups[nu->nu_glen++] = gname;
+	}
+    }
+    /* Rules in the order of the rule-lists */
+    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
+	goto done;
+    n = 0;
+    for (i=0; i<rlistlen; i++){
+	xc = NULL;
+	while ((xc = xml_child_each(rlistvec[i], xc, CX_ELMNT)) != NULL)
+	    if (strcmp(xml_name(xc), "rule") == 0)
+		n++;
+    }
+    if (n && (nrs->nrs_rules = calloc(n, sizeof(struct nacm_rule))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    if (clicon_hash_keys(nrs->nrs_users, &keys, &klen) < 0)
+	goto done;
+    for (i=0; i<rlistlen; i++){
+	if (xpath_vec(rlistvec[i], nsc, "rule", &rvec, &rlen) < 0)
+	    goto done;
+	n = nrs->nrs_rlen;
+	for (j=0; j<rlen && nrs->nrs_rlen < n+rlen; j++)
+	    if (nacm_rule_compile(h, rvec[j], &nrs->nrs_rules[nrs->nrs_rlen++]) < 0)
+		goto done;
+	/* Add rules to users with a group of this rule-list */
+	for (k=0; k<klen; k++){
+	    nu = clicon_hash_value(nrs->nrs_users, keys[k], NULL);
+	    for (l=0; l<nu->nu_glen; l++)
+		if (nu->nu_groups[l] &&
+		    xpath_first(rlistvec[i], nsc, ".[group='%s']", nu->nu_groups[l]) != NULL)
+		    break;
+	    if (l == nu->nu_glen) /* not found */
+		continue;
+	    if ((nu->nu_rules = realloc(nu->nu_rules,
+					(nu->nu_rlen+nrs->nrs_rlen-n)*sizeof(struct nacm_rule*))) == NULL){
+		clicon_err(OE_UNIX, errno, "realloc");
+		goto done;
+	    }
+	    for (j=n; j<nrs->nrs_rlen; j++)
+		nu->nu_rules[nu->nu_rlen++] = &nrs->nrs_rules[j];
+	}
+	if (rvec){
+	    free(rvec);
+	    rvec = NULL;
+	}
+    }
+ ok:
+    *nrsp = nrs;
+    nrs = NULL;
+    retval = 0;
+ done:
+    if (nrs)
+	nacm_ruleset_free1(nrs);
+    if (nsc)
+	xml_nsctx_free(nsc);
+    if (gvec)
+	free(gvec);
+    if (rlistvec)
+	free(rlistvec);
+    if (rvec)
+	free(rvec);
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Get NACM rule set of NACM tree, compile a temporary rule set if not the cached
+ * @param[in]  h      Clicon handle
+ * @param[in]  xnacm  NACM XML tree
+ * @param[out] nrsp   NACM rule set
+ * @param[out] tmpp   Temporary NACM rule set if compiled, free after use
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see nacm_access_pre  Where the cached rule set is compiled
+ */
+static int
+nacm_ruleset_get(clicon_handle  h,
+		 cxobj         *xnacm,
+		 nacm_ruleset **nrsp,
+		 nacm_ruleset **tmpp)
+{
+    nacm_ruleset *nrs;
+    void         *p;
+
+    *tmpp = NULL;
+    if ((p = clicon_hash_value(clicon_data(h), "nacm_ruleset", NULL)) != NULL &&
+	(nrs = *(nacm_ruleset **)p) != NULL &&
+	nrs->nrs_xnacm == xnacm){
+	*nrsp = nrs;
+	return 0;
+    }
+    if (nacm_ruleset_compile(h, xnacm, tmpp) < 0)
+	return -1;
+    *nrsp = *tmpp;
+    return 0;
+}
+
+/*! Get user of NACM rule set
+ * @param[in]  nrs      NACM rule set
+ * @param[in]  username User name
+ * @retval     nu       User with groups and rules
+ * @retval     NULL     User is not in any group
+ */
+static struct nacm_user *
+nacm_ruleset_user(nacm_ruleset *nrs,
+		  char         *username)
+{
+    return clicon_hash_value(nrs->nrs_users, username, NULL);
+}
+
+/*! Free the NACM rule set cached in the handle
+ * @param[in]  h   Clicon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see nacm_access_pre
+ */
+int
+nacm_ruleset_free(clicon_handle h)
+{
+    nacm_ruleset *nrs = NULL;
+    void         *p;
+
+    if ((p = clicon_hash_value(clicon_data(h), "nacm_ruleset", NULL)) != NULL &&
+	(nrs = *(nacm_ruleset **)p) != NULL){
+	nacm_ruleset_free1(nrs);
+	nrs = NULL;
+	if (clicon_hash_add(clicon_data(h), "nacm_ruleset", &nrs, sizeof(nrs)) == NULL)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Get number of rules and alloced memory of the NACM rule set cached in the handle
+ * @param[in]     h    Clicon handle
+ * @param[in,out] nrp  Number of compiled rules, incremented
+ * @param[in,out] szp  Size in bytes of cached rule set, incremented
+ * @retval        0    OK
+ * The NACM tree, the resolved paths of the rules and the hash tables are not included
+ * @see nacm_access_pre
+ */
+int
+nacm_ruleset_stats(clicon_handle h,
+		   uint64_t     *nrp,
+		   size_t       *szp)
+{
+    nacm_ruleset     *nrs;
+    void             *p;
+    char            **keys = NULL;
+    size_t            klen;
+    char            **rkeys = NULL;
+    size_t            rklen;
+    struct nacm_user *nu;
+    struct nacm_read *nrd;
+    size_t            sz = 0;
+    int               i;
+    int               j;
+
+    if ((p = clicon_hash_value(clicon_data(h), "nacm_ruleset", NULL)) == NULL ||
+	(nrs = *(nacm_ruleset **)p) == NULL)
+	return 0;
+    *nrp += nrs->nrs_rlen;
+    sz += sizeof(*nrs) + nrs->nrs_rlen*sizeof(struct nacm_rule);
+    if (nrs->nrs_users &&
+	clicon_hash_keys(nrs->nrs_users, &keys, &klen) == 0)
+	for (i=0; i<klen; i++){
+	    if ((nu = clicon_hash_value(nrs->nrs_users, keys[i], NULL)) == NULL)
+		continue;
+	    sz += strlen(keys[i]) + 1 + sizeof(*nu);
+	    sz += nu->nu_glen*sizeof(char*) + nu->nu_rlen*sizeof(struct nacm_rule*);
+	    if (nu->nu_read &&
+		clicon_hash_keys(nu->nu_read, &rkeys, &rklen) == 0){
+		for (j=0; j<rklen; j++)
+		    if ((nrd = clicon_hash_value(nu->nu_read, rkeys[j], NULL)) != NULL)
+			sz += strlen(rkeys[j]) + 1 + sizeof(*nrd) + nrd->nrd_len*sizeof(int);
+		if (rkeys){
+		    free(rkeys);
+		    rkeys = NULL;
+		}
+	    }
+	}
+    if (keys)
+	free(keys);
+    if (szp)
+	*szp += sz;
+    return 0;
+}
+
 /*! Match nacm single rule. Either match with access or deny. Or not match.
  * @param[in]  rpc    rpc name
  * @param[in]  module Yang module name
- * @param[in]  xrule  NACM rule XML tree
+ * @param[in]  nr     Compiled NACM rule
  * @param[out] cbret  Cligen buffer result. Set to an error msg if retval=0.
  * @retval -1  Error
  * @retval  0  Matching rule AND Not access and cbret set
@@ -126,18 +552,17 @@ match_access(char *access_operations,
            has the special value "*".
  */
 static int
-nacm_rule_rpc(char         *rpc,
-	      char         *module,
-	      cxobj        *xrule)
+nacm_rule_rpc(char             *rpc,
+	      char             *module,
+	      struct nacm_rule *nr)
 {
     int    retval = -1;
     char  *module_rule; /* rule module name */
     char  *rpc_rule;
-    char  *access_operations;
     
     /*  7a) The rule's "module-name" leaf is "*" or equals the name of
 	the YANG module where the protocol operation is defined. */
-    if ((module_rule = xml_find_body(xrule, "module-name")) == NULL)
+    if ((module_rule = nr->nr_module) == NULL)
 	goto nomatch;
     if (strcmp(module_rule,"*") && strcmp(module_rule,module))
 	goto nomatch;
@@ -145,16 +570,15 @@ nacm_rule_rpc(char         *rpc,
 	(2) the "rule-type" is "protocol-operation" and the
 	"rpc-name" is "*" or equals the name of the requested
 	protocol operation. */
-    if ((rpc_rule = xml_find_body(xrule, "rpc-name")) == NULL){
-	if (xml_find_body(xrule, "path") || xml_find_body(xrule, "notification-name"))
+    if ((rpc_rule = nr->nr_rpc) == NULL){
+	if (nr->nr_path || nr->nr_notif)
 	    goto nomatch;
     }
     if (rpc_rule && (strcmp(rpc_rule, "*") && strcmp(rpc_rule, rpc)))
 	goto nomatch;
     /* 7c) The rule's "access-operations" leaf has the "exec" bit set or
 	has the special value "*". */
-    access_operations = xml_find_body(xrule, "access-operations");
-    if (!match_access(access_operations, "exec", NULL))
+    if ((nr->nr_access & NACM_ACCESS_BIT(NACM_EXEC)) == 0)
 	goto nomatch;
     retval = 1;
  done:
@@ -165,6 +589,7 @@ nacm_rule_rpc(char         *rpc,
 }
 
 /*! Process nacm incoming RPC message validation steps
+ * @param[in]  h        Clicon handle
  * @param[in]  module   Yang module name
  * @param[in]  rpc      rpc name
  * @param[in]  username User name of requestor
@@ -178,31 +603,23 @@ nacm_rule_rpc(char         *rpc,
  * @see nacm_datanode_read
  */
 int
-nacm_rpc(char         *rpc,
+nacm_rpc(clicon_handle h,
+	 char         *rpc,
 	 char         *module,
 	 char         *username,
 	 cxobj        *xnacm,
 	 cbuf         *cbret)
 {
-    int     retval = -1;
-    cxobj  *xrule;
-    cxobj **gvec = NULL; /* groups */
-    size_t  glen;
-    cxobj  *rlist;
-    cxobj **rlistvec = NULL; /* rule-list */
-    size_t  rlistlen;
-    cxobj **rvec = NULL; /* rules */
-    size_t  rlen;
-    int     i, j;
-    char   *exec_default = NULL;
-    char   *gname;
-    char   *action;
-    int     match= 0;
-    cvec   *nsc = NULL;
+    int               retval = -1;
+    nacm_ruleset     *nrs = NULL;
+    nacm_ruleset     *nrstmp = NULL;
+    struct nacm_user *nu;
+    struct nacm_rule *nr = NULL;
+    int               i;
+    char             *exec_default = NULL;
+    char             *action;
+    int               match= 0;
     
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-	goto done;
     /* 3.   If the requested operation is the NETCONF <close-session>
        protocol operation, then the protocol operation is permitted.
     */
@@ -215,51 +632,29 @@ nacm_rpc(char         *rpc,
        transport layer.)	       */
     if (username == NULL)
 	goto step10;
-
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    if (nacm_ruleset_get(h, xnacm, &nrs, &nrstmp) < 0)
 	goto done;
     /* 5. If no groups are found, continue with step 10. */
-    if (glen == 0)
+    if ((nu = nacm_ruleset_user(nrs, username)) == NULL)
 	goto step10;
     /* 6. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-	goto done;
-    for (i=0; i<rlistlen; i++){
-	rlist = rlistvec[i];
-	/* Loop through user's group to find match in this rule-list */
-	for (j=0; j<glen; j++){
-	    gname = xml_find_body(gvec[j], "name");
-	    if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-		break; /* found */
-	}
-	if (j==glen) /* not found */
-	    continue;
-	/* 7. For each rule-list entry found, process all rules, in order,
+        entry. 
+       7. For each rule-list entry found, process all rules, in order,
 	   until a rule that matches the requested access operation is
 	   found. 
-	*/
-	if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
+       The rules of the user's rule-lists are compiled in order, see nacm_ruleset_compile
+    */
+    for (i=0; i<nu->nu_rlen; i++){
+	nr = nu->nu_rules[i];
+	if ((match = nacm_rule_rpc(rpc, module, nr)) < 0)
 	    goto done;
-	for (j=0; j<rlen; j++){
-	    xrule = rvec[j];
-	    if ((match = nacm_rule_rpc(rpc, module, xrule)) < 0)
-		goto done;
-	    if (match)
-		break;
-	}
 	if (match)
 	    break;
-	if (rvec){
-	    free(rvec);
-	    rvec=NULL;
-	}
     }
     if (match){
-	if ((action = xml_find_body(xrule, "action")) == NULL)
+	if ((action = nr->nr_action) == NULL)
 	    goto step10;
 	if (strcmp(action, "deny")==0){
 	    if (netconf_access_denied(cbret, "application", "access denied") < 0)
@@ -295,14 +690,8 @@ nacm_rpc(char         *rpc,
     retval = 1;
  done:
     clicon_debug(1, "%s retval:%d (0:deny 1:permit)", __FUNCTION__, retval);
-    if (nsc)
-	xml_nsctx_free(nsc);
-    if (gvec)
-	free(gvec);
-    if (rlistvec)
-	free(rlistvec);
-    if (rvec)
-	free(rvec);
+    if (nrstmp)
+	nacm_ruleset_free1(nrstmp);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -312,9 +701,9 @@ nacm_rpc(char         *rpc,
 
 /* Local struct for keeping preparation/compiled data in NACM data path code */
 struct prepvec{
-    qelem_t       pv_q;
-    cxobj        *pv_xrule;
-    clixon_xvec  *pv_xpathvec;
+    qelem_t           pv_q;
+    struct nacm_rule *pv_rule;
+    clixon_xvec      *pv_xpathvec;
 };
 typedef struct prepvec prepvec;
 
@@ -335,8 +724,8 @@ prepvec_free(prepvec *pv_list)
 }
 
 prepvec *
-prepvec_add(prepvec  **pv_listp,
-	    cxobj     *xrule)
+prepvec_add(prepvec         **pv_listp,
+	    struct nacm_rule *nr)
 {
     prepvec *pv;
 
@@ -346,7 +735,7 @@ prepvec_add(prepvec  **pv_listp,
     }
     memset(pv, 0, sizeof(*pv));
     ADDQ(pv, *pv_listp);
-    pv->pv_xrule = xrule;
+    pv->pv_rule = nr;
     if ((pv->pv_xpathvec = clixon_xvec_new()) == NULL)
 	return NULL;
     return pv;
@@ -358,156 +747,100 @@ prepvec_add(prepvec  **pv_listp,
  *  - user/group
  *  - have read access-op, etc
  * Also make instance-id lookups on top object for each rule. Assume at most one result
+ * @param[in]  h        Clicon handle
+ * @param[in]  xt       XML root tree
+ * @param[in]  access   NACM access: read, create, update or delete
+ * @param[in]  nu       Compiled rules of user
+ * @param[out] pv_listp Rules that apply with instance-id lookups, free with prepvec_free
+ * @retval     0        OK
+ * @retval    -1        Error
  */
 static int
 nacm_datanode_prepare(clicon_handle     h,
 		      cxobj            *xt,
 		      enum nacm_access  access,
-		      cxobj           **gvec,
-		      size_t            glen,
-		      cxobj           **rlistvec,
-		      size_t            rlistlen,
-		      cvec             *nsc,
+		      struct nacm_user *nu,
 		      prepvec         **pv_listp)
 {
-    int        retval = -1;
-    cxobj     *rlist;
-    int        i;
-    int        j;
-    int        k;
-    char      *gname;
-    cxobj    **rvec = NULL; /* rules */
-    size_t     rlen;	
-    cxobj     *xrule;
-    cxobj     *pathobj;
-    char      *access_operations;
-    char      *path0;         /* Non-canonical path */
-    char      *path=NULL;     /* Canonical path */
-    cvec      *nsc0 = NULL;   /* Non-canonical namespace context */
-    yang_stmt *yspec;
-    cxobj   **xvec = NULL;
-    int       xlen = 0;
-    int       ret;
-    prepvec *pv;
+    int               retval = -1;
+    int               i;
+    int               k;
+    struct nacm_rule *nr;
+    yang_stmt        *yspec;
+    cxobj           **xvec = NULL;
+    int               xlen = 0;
+    int               ret;
+    prepvec          *pv;
 
+    switch (access){
+    case NACM_READ: 
+	/* 6c) For a "read" access operation, the rule's "access-operations"
+	   leaf has the "read" bit set or has the special value "*" */
+    case NACM_CREATE:
+	/* 6d) For a "create" access operation, the rule's "access-operations" 
+	   leaf has the "create" bit set or has the special value "*". */
+    case NACM_DELETE:
+	/* 6e) For a "delete" access operation, the rule's "access-operations" 
+	   leaf has the "delete" bit set or has the  special value "*". */
+    case NACM_UPDATE:
+	/* 6f) For an "update" access operation, the rule's "access-operations"
+	   leaf has the "update" bit set or has the special value "*". */ 
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+	goto done;
+	break;
+    }
     yspec = clicon_dbspec_yang(h);
-    for (i=0; i<rlistlen; i++){ 	/* Loop through rule list */
-	rlist = rlistvec[i];
-	/* Loop through user's group to find match in this rule-list */
-	for (j=0; j<glen; j++){
-	    gname = xml_find_body(gvec[j], "name");
-	    if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-		break; /* found */
+    /* 6. For each rule-list entry found, process all rules, in order,
+       until a rule that matches the requested access operation is
+       found. (see 6 sub rules in nacm_rule_datanode
+    */
+    for (i=0; i<nu->nu_rlen; i++){ /* Loop through rules of user's rule-lists */
+	nr = nu->nu_rules[i];
+	if ((nr->nr_access & NACM_ACCESS_BIT(access)) == 0)
+	    continue;
+	/*  6b) Either (1) the rule does not have a "rule-type" defined or
+	    (2) the "rule-type" is "data-node" and the "path" matches the
+	    requested data node, action node, or notification node. */    
+	if (nr->nr_path == NULL){
+	    if (nr->nr_rpc || nr->nr_notif)
+		continue;
+	    /* Here a new xrule is found, add it */
+	    if (prepvec_add(pv_listp, nr) == NULL)
+		goto done;
+	    continue;
 	}
-	if (j==glen) /* not found */
+	/* Path is resolved when compiled, see https://github.com/clicon/clixon/issues/129
+	 * for why the path is not made canonical
+	 */
+	if (nr->nr_cplist)
+	    ret = clixon_xml_find_instance_id_cp(xt, yspec, nr->nr_cplist, &xvec, &xlen);
+	else if (nr->nr_resolve == 0)
+	    ret = 0;
+	else /* Not parsed: same error as when not compiled */
+	    ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", nr->nr_path);
+	if (ret < 0)
+	    goto done;
+	if (ret == 0)
 	    continue;
-	/* 6. For each rule-list entry found, process all rules, in order,
-	   until a rule that matches the requested access operation is
-	   found. (see 6 sub rules in nacm_rule_datanode
-	*/
-	if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
+	/* Here a new xrule is found, add it */
+	if ((pv = prepvec_add(pv_listp, nr)) == NULL)
 	    goto done;
-	for (j=0; j<rlen; j++){ /* Loop through rules */
-	    xrule = rvec[j];
-	    /* 6c) For a "read" access operation, the rule's "access-operations"
-	       leaf has the "read" bit set or has the special value "*" */
-	    access_operations = xml_find_body(xrule, "access-operations");
-	    switch (access){
-	    case NACM_READ: 
-		/* 6c) For a "read" access operation, the rule's "access-operations"
-		   leaf has the "read" bit set or has the special value "*" */
-		if (!match_access(access_operations, "read", NULL))
-		    continue;
-		break;
-	    case NACM_CREATE:
-		/* 6d) For a "create" access operation, the rule's "access-operations" 
-		   leaf has the "create" bit set or has the special value "*". */
-		if (!match_access(access_operations, "create", "write"))
-		    continue;
-		break;
-	    case NACM_DELETE:
-		/* 6e) For a "delete" access operation, the rule's "access-operations" 
-		   leaf has the "delete" bit set or has the  special value "*". */
-		if (!match_access(access_operations, "delete", "write"))
-		    continue;
-		break;
-	    case NACM_UPDATE:
-		/* 6f) For an "update" access operation, the rule's "access-operations"
-		   leaf has the "update" bit set or has the special value "*". */ 
-		if (!match_access(access_operations, "update", "write"))
-		    continue;
-		break;
-	    default:
-		clicon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+	for (k=0; k<xlen; k++){
+	    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
 		goto done;
-		break;
-	    }
-	    /*  6b) Either (1) the rule does not have a "rule-type" defined or
-		(2) the "rule-type" is "data-node" and the "path" matches the
-		requested data node, action node, or notification node. */    
-	    if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL){
-		if (xml_find_body(xrule, "rpc-name") || xml_find_body(xrule, "notification-name"))
-		    continue;
-		/* Here a new xrule is found, add it */
-		if (prepvec_add(pv_listp, xrule) == NULL)
-		    goto done;
-	    }
-	    else{
-		path0 = clixon_trim2(xml_body(pathobj), " \t\n");
-		/* Get canonical namespace context for nacm paths */
-		if ((path = strdup(path0)) == NULL){
-		    clicon_err(OE_UNIX, errno, "strdup");
-		    goto done;
-		}
-#if 0
-		/* See https://github.com/clicon/clixon/issues/129:
-		 * If this is enabled, you are back to the problem of JSON encodings
-		 */
-		/* Create namespace context for with nacm namespace as default */
-		if (xml_nsctx_node(pathobj, &nsc0) < 0)
-		    goto done;
-		/* instance-id requires canonical paths */
-		if (xpath2canonical(path0, nsc0, yspec, &path, NULL) < 0)
-		    goto done;
-#endif
-		if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", path)) < 0)
-		    goto done;
-		if (ret == 0)
-		    continue;
-		/* Here a new xrule is found, add it */
-		if ((pv = prepvec_add(pv_listp, xrule)) == NULL)
-		    goto done;
-		for (k=0; k<xlen; k++){
-		    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
-			goto done;
-		}
-		if (xvec){
-		    free(xvec);
-		    xvec = NULL;
-		}
-		if (nsc0){
-		    cvec_free(nsc0);
-		    nsc0 = NULL;
-		}
-		if (path){
-		    free(path);
-		    path = NULL;
-		}
-	    }
 	}
-	if (rvec){
-	    free(rvec);
-	    rvec=NULL;
-	}	
+	if (xvec){
+	    free(xvec);
+	    xvec = NULL;
+	}
+	xlen = 0;
     }
     retval = 0;
  done:
     if (xvec)
 	free(xvec);
-    if (path)
-	free(path);
-    if (nsc0)
-	cvec_free(nsc0);
     return retval;
 }
 
@@ -517,7 +850,7 @@ nacm_datanode_prepare(clicon_handle     h,
 
 /*! Match specific rule to specific requested node
  * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
+ * @param[in]  nr       Compiled NACM rule
  * @param[in]  xp       Xpath match
  * @param[in]  yspec    YANG spec
  * @retval -1  Error
@@ -526,10 +859,10 @@ nacm_datanode_prepare(clicon_handle     h,
  * @retval  2  OK and rule matches permit
  */
 static int
-nacm_data_write_xrule_xml(cxobj       *xn,
-			  cxobj       *xrule,
-			  clixon_xvec *xpathvec,
-			  yang_stmt   *yspec)
+nacm_data_write_xrule_xml(cxobj            *xn,
+			  struct nacm_rule *nr,
+			  clixon_xvec      *xpathvec,
+			  yang_stmt        *yspec)
 {
     int        retval = -1;
     yang_stmt *ymod;
@@ -538,7 +871,7 @@ nacm_data_write_xrule_xml(cxobj       *xn,
     cxobj     *xp;
     int        i;
 
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
+    if ((module_pattern = nr->nr_module) == NULL)
 	goto nomatch;
     /* 6a) The rule's "module-name" leaf is "*" or equals the name of
      * the YANG module where the requested data node is defined. 
@@ -550,11 +883,11 @@ nacm_data_write_xrule_xml(cxobj       *xn,
 	if (ymod && strcmp(yang_argument_get(ymod), module_pattern) != 0)
 	    goto nomatch;
     }
-    action = xml_find_body(xrule, "action"); /* mandatory */
+    action = nr->nr_action; /* mandatory */
     /*  6b) Either (1) the rule does not have a "rule-type" defined or
 	(2) the "rule-type" is "data-node" and the "path" matches the
 	Requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
+    if (nr->nr_path == NULL){
 	if (strcmp(action, "deny")==0)
 	    goto deny;
 	goto permit;
@@ -615,7 +948,7 @@ nacm_datanode_write_recurse(clicon_handle h,
 	do {
 	    /* return values: -1:Error /0:no match /1: deny /2: permit
 	     */
-	    if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_xrule, pv->pv_xpathvec, yspec)) < 0) 
+	    if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_rule, pv->pv_xpathvec, yspec)) < 0) 
 		goto done;
 	    switch(ret){
 	    case 0: /* No match, continue with next rule */
@@ -682,20 +1015,14 @@ nacm_datanode_write(clicon_handle    h,
 		    cxobj           *xnacm,
 		    cbuf            *cbret)
 {
-    int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
-    cxobj         **rvec = NULL; /* rules */
-    char           *write_default = NULL;
-    cvec           *nsc = NULL;
-    int             ret;
-    prepvec        *pv_list = NULL;
-
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-	goto done;
+    int               retval = -1;
+    char             *write_default = NULL;
+    int               ret;
+    prepvec          *pv_list = NULL;
+    nacm_ruleset     *nrs = NULL;
+    nacm_ruleset     *nrstmp = NULL;
+    struct nacm_user *nu;
+
     if (xnacm == NULL)
 	goto permit;
     /* write-default (create, update, or delete) has default deny so should never be NULL */
@@ -710,21 +1037,18 @@ nacm_datanode_write(clicon_handle    h,
        transport layer.)	       */
     if (username == NULL)
 	goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    if (nacm_ruleset_get(h, xnacm, &nrs, &nrstmp) < 0)
 	goto done;
     /* 4. If no groups are found, continue with step 9. */
-    if (glen == 0)
+    if ((nu = nacm_ruleset_user(nrs, username)) == NULL)
 	goto step9;
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-	goto done;
-    /* First run through rules and cache rules as well as lookup objects in xt. 
+        entry. 
+       First run through the user's rules and cache rules as well as lookup objects in xt. 
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, access, nu, &pv_list) < 0)
 	goto done;
     /* Then recursivelyy traverse all requested nodes */
     if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
@@ -761,14 +1085,8 @@ nacm_datanode_write(clicon_handle    h,
     clicon_debug(1, "%s retval:%d (0:deny 1:permit)", __FUNCTION__, retval);
     if (pv_list)
 	prepvec_free(pv_list);
-    if (nsc)
-	xml_nsctx_free(nsc);
-    if (gvec)
-	free(gvec);
-    if (rlistvec)
-	free(rlistvec);
-    if (rvec)
-	free(rvec);
+    if (nrstmp)
+	nacm_ruleset_free1(nrstmp);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -781,19 +1099,19 @@ nacm_datanode_write(clicon_handle    h,
  */
 
 /*! Perform NACM action: mark if permit, del if deny
- * @param[in] xrule    NACM rule
+ * @param[in] nr       Compiled NACM rule
  * @param[in] xn       XML node (requested node)
  * @retval    -1       Error
  * @retval    0        OK
  */
 static int
-nacm_data_read_action(cxobj *xrule,
-		      cxobj *xn)
+nacm_data_read_action(struct nacm_rule *nr,
+		      cxobj            *xn)
 {
     int   retval = -1;
     char *action;
 
-    if ((action = xml_find_body(xrule, "action")) != NULL){
+    if ((action = nr->nr_action) != NULL){
 	if (strcmp(action, "deny")==0)
 	    xml_flag_set(xn, XML_FLAG_DEL);
 	else if (strcmp(action, "permit")==0)
@@ -804,12 +1122,124 @@ nacm_data_read_action(cxobj *xrule,
     return retval;
 }
 
-/*! Match specific rule to specific requested node
+/*! Check if yang node is an ancestor of, or the same as, another yang node
+ * @param[in]  ys   Yang node
+ * @param[in]  ya   Potential ancestor of ys
+ * @retval     0    No, ya is not ys or an ancestor of ys
+ * @retval     1    Yes, ya is ys or an ancestor of ys
+ */
+static int
+nacm_yang_isancestor(yang_stmt *ys,
+		     yang_stmt *ya)
+{
+    for (; ys != NULL; ys = yang_parent_get(ys))
+	if (ys == ya)
+	    return 1;
+    return 0;
+}
+
+/*! Get read rules of a user that may match data nodes of a schema node
+ *
+ * The read rules are computed from the schema once per compiled user, and do not
+ * depend on the instance of the data node.
+ * @param[in]  nu     Compiled rules of user
+ * @param[in]  xn     XML node (requested node), used for module of the node
+ * @param[in]  ys     Yang spec of xn
+ * @param[in]  yspec  YANG spec
+ * @param[out] nrdp   Read rules of schema node
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_read_get(struct nacm_user  *nu,
+	      cxobj             *xn,
+	      yang_stmt         *ys,
+	      yang_stmt         *yspec,
+	      struct nacm_read **nrdp)
+{
+    int               retval = -1;
+    char              key[32];
+    struct nacm_read  nrd0 = {NULL, 0, 1};
+    struct nacm_rule *nr;
+    yang_stmt        *ymod;
+    char             *modname = NULL;
+    int               modmatch;
+    int               i;
+
+    snprintf(key, sizeof(key), "%p", ys);
+    if (nu->nu_read == NULL &&
+	(nu->nu_read = clicon_hash_init()) == NULL)
+	goto done;
+    if ((*nrdp = clicon_hash_value(nu->nu_read, key, NULL)) != NULL)
+	goto ok;
+    if (ys_module_by_xml(yspec, xn, &ymod) < 0)
+	goto done;
+    if (ymod)
+	modname = yang_argument_get(ymod);
+    if ((nrd0.nrd_rules = calloc(nu->nu_rlen+1, sizeof(int))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<nu->nu_rlen; i++){
+	nr = nu->nu_rules[i];
+	/* 6c) For a "read" access operation, the rule's "access-operations"
+	   leaf has the "read" bit set or has the special value "*" */
+	if ((nr->nr_access & NACM_ACCESS_BIT(NACM_READ)) == 0)
+	    continue;
+	if (nr->nr_path == NULL && (nr->nr_rpc || nr->nr_notif))
+	    continue;
+	if (nr->nr_module == NULL)
+	    continue;
+	/* 6a) The rule's "module-name" leaf is "*" or equals the name of
+	 * the YANG module where the requested data node is defined. 
+	 */
+	modmatch = strcmp(nr->nr_module, "*") == 0 ||
+	    (modname && strcmp(modname, nr->nr_module) == 0);
+	/*  6b) Either (1) the rule does not have a "rule-type" defined or
+	    (2) the "rule-type" is "data-node" and the "path" matches the
+	    requested data node, action node, or notification node. */    
+	if (nr->nr_path == NULL){
+	    if (modmatch){
+		nrd0.nrd_rules[nrd0.nrd_len++] = i;
+		break; /* Always matches */
+	    }
+	    nrd0.nrd_uniform = 0; /* May match descendants of other module */
+	    continue;
+	}
+	if (nr->nr_target == NULL) /* Not resolved, never matches */
+	    continue;
+	if (!nacm_yang_isancestor(ys, nr->nr_target)){
+	    if (nacm_yang_isancestor(nr->nr_target, ys))
+		nrd0.nrd_uniform = 0; /* Path of descendants */
+	    continue;
+	}
+	if (!modmatch){
+	    nrd0.nrd_uniform = 0;
+	    continue;
+	}
+	nrd0.nrd_rules[nrd0.nrd_len++] = i;
+	if (!nr->nr_keyed)
+	    break; /* Always matches */
+    }
+    if (clicon_hash_add(nu->nu_read, key, &nrd0, sizeof(nrd0)) == NULL)
+	goto done;
+    nrd0.nrd_rules = NULL;
+    *nrdp = clicon_hash_value(nu->nu_read, key, NULL);
+ ok:
+    retval = 0;
+ done:
+    if (nrd0.nrd_rules)
+	free(nrd0.nrd_rules);
+    return retval;
+}
+
+/*! Match read rules of schema node to specific requested node
  * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  yspec    YANG spec
+ * @param[in]  nu       Compiled rules of user
+ * @param[in]  nrd      Read rules of schema node of xn
+ * @param[in]  xpv      Instance-id lookups of rules with predicates, indexed as nu_rules
  * @retval -1  Error
- * @retval  0  OK and rule does not match
+ * @retval  0  OK and no rule matches
  * @retval  1  OK and rule matches
  * Two distinct cases:
  * (1) read_default is permit
@@ -818,46 +1248,37 @@ nacm_data_read_action(cxobj *xrule,
  *     mark all permit rules and ancestors, remove everything else
  */
 static int
-nacm_data_read_xrule_xml(cxobj        *xn,
-			 cxobj        *xrule,
-			 clixon_xvec  *xpathvec,
-			 yang_stmt    *yspec)
+nacm_data_read_xrule_xml(cxobj            *xn,
+			 struct nacm_user *nu,
+			 struct nacm_read *nrd,
+			 clixon_xvec     **xpv)
 {
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
-    cxobj     *xp;
-    int        i;
+    int               retval = -1;
+    struct nacm_rule *nr;
+    clixon_xvec      *xpathvec;
+    cxobj            *xp;
+    int               i;
+    int               j;
     
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-	goto nomatch;
-    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
-     */
-    if (strcmp(module_pattern, "*") != 0){
-	if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-	    goto done;
-	if (strcmp(yang_argument_get(ymod), module_pattern) != 0)
-	    goto nomatch;
-    }
-    /*  6b) Either (1) the rule does not have a "rule-type" defined or
-	(2) the "rule-type" is "data-node" and the "path" matches the
-	requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-	if (nacm_data_read_action(xrule, xn) < 0)
-	    goto done;
-	goto match;
-    }
-    for (i=0; i<clixon_xvec_len(xpathvec); i++){
-	xp = clixon_xvec_i(xpathvec, i);
-	/* Check if ancestor is xp (for every xpathvec?) */
-	if (xn == xp || xml_isancestor(xn, xp)){
-	    if (nacm_data_read_action(xrule, xn) < 0)
+    for (i=0; i<nrd->nrd_len; i++){
+	nr = nu->nu_rules[nrd->nrd_rules[i]];
+	if (nr->nr_path == NULL || !nr->nr_keyed){
+	    if (nacm_data_read_action(nr, xn) < 0)
 		goto done;
 	    goto match;
 	}
+	if ((xpathvec = xpv[nrd->nrd_rules[i]]) == NULL)
+	    continue;
+	for (j=0; j<clixon_xvec_len(xpathvec); j++){
+	    xp = clixon_xvec_i(xpathvec, j);
+	    /* Check if ancestor is xp (for every xpathvec?) */
+	    if (xn == xp || xml_isancestor(xn, xp)){
+		if (nacm_data_read_action(nr, xn) < 0)
+		    goto done;
+		goto match;
+	    }
+	}
     }
- nomatch:
     retval = 0;
  done:
     return retval;
@@ -869,53 +1290,41 @@ nacm_data_read_xrule_xml(cxobj        *xn,
 /*! Recursive check for NACM read rules among all XML nodes
  * @param[in]  h        Clicon handle
  * @param[in]  xn       XML node (requested node)
- * @param[in]  rulevec  Precomputed rules that apply to this user group
- * @param[in]  xpathvec Precomputed xpath results that apply to this XML tree
+ * @param[in]  nu       Compiled rules of user
+ * @param[in]  xpv      Instance-id lookups of rules with predicates, indexed as nu_rules
  * @param[in]  yspec    YANG spec
  * @retval  0  OK
  * @retval -1  Error
+ * If no other rule may match the descendants of a node, the descendants get the same
+ * result as the node and are not checked
  */
 static int
-nacm_datanode_read_recurse(clicon_handle h,
-			   cxobj        *xn,
-			   prepvec      *pv_list,
-			   yang_stmt    *yspec)
+nacm_datanode_read_recurse(clicon_handle     h,
+			   cxobj            *xn,
+			   struct nacm_user *nu,
+			   clixon_xvec     **xpv,
+			   yang_stmt        *yspec)
 {
-    int      retval = -1;
-    cxobj   *x;
-    cxobj   *xprev;
-    int      ret;
-    prepvec *pv;
+    int               retval = -1;
+    cxobj            *x;
+    cxobj            *xprev;
+    yang_stmt        *ys;
+    struct nacm_read *nrd;
     
-    if (xml_spec(xn)){ /* Check this node */
-	pv = pv_list;
-	if (pv){
-	    do {
-		if ((ret = nacm_data_read_xrule_xml(xn,
-						    pv->pv_xrule,
-						    pv->pv_xpathvec,
-						    yspec)) < 0) 
-		    goto done;	    
-		if (ret == 1)
-		    break; /* stop at first match */		    
-		pv = NEXTQ(prepvec *, pv);
-	    } while (pv && pv != pv_list);
-	}
-
-#if 0 /* 6(A) in algorithm 
-       * If N did not match any rule R, and default rule is deny, remove that subtree */
-	if (strcmp(read_default, "deny") == 0)
-	    if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
-		goto done;
-#endif
+    if ((ys = xml_spec(xn)) != NULL){ /* Check this node */
+	if (nacm_read_get(nu, xn, ys, yspec, &nrd) < 0)
+	    goto done;
+	if (nacm_data_read_xrule_xml(xn, nu, nrd, xpv) < 0) 
+	    goto done;	    
+	if (nrd->nrd_uniform)
+	    goto ok;
     }
-
     /* If node should be purged, dont recurse and defer removal to caller */
     if (xml_flag(xn, XML_FLAG_DEL) == 0){
 	x = NULL; 	/* Recursively check XML */
 	xprev = NULL;
 	while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-	    if (nacm_datanode_read_recurse(h, x, pv_list, yspec) < 0)
+	    if (nacm_datanode_read_recurse(h, x, nu, xpv, yspec) < 0)
 		goto done;
 	    /* check for delayed remove */
 	    if (xml_flag(x, XML_FLAG_DEL)){
@@ -925,11 +1334,98 @@ nacm_datanode_read_recurse(clicon_handle h,
 	    }
 	}
     }
+ ok:
     retval = 0;
  done:
     return retval;
 }
 
+/*! Free instance-id lookups of read rules
+ * @param[in]  xpv   Vector indexed as nu_rules
+ * @param[in]  len   Length of vector
+ */
+static int
+nacm_datanode_read_xpv_free(clixon_xvec **xpv,
+			    int           len)
+{
+    int i;
+
+    for (i=0; i<len; i++)
+	if (xpv[i])
+	    clixon_xvec_free(xpv[i]);
+    free(xpv);
+    return 0;
+}
+
+/*! Instance-id lookups of read rules with predicates
+ * @param[in]  h     Clicon handle
+ * @param[in]  xt    XML root tree
+ * @param[in]  nu    Compiled rules of user
+ * @param[out] xpvp  Vector indexed as nu_rules, NULL if no matching nodes
+ * @retval     0     OK
+ * @retval    -1     Error
+ * Rules without predicates match by schema node, see nacm_read_get
+ */
+static int
+nacm_datanode_read_prepare(clicon_handle      h,
+			   cxobj             *xt,
+			   struct nacm_user  *nu,
+			   clixon_xvec     ***xpvp)
+{
+    int               retval = -1;
+    clixon_xvec     **xpv = NULL;
+    struct nacm_rule *nr;
+    yang_stmt        *yspec;
+    cxobj           **xvec = NULL;
+    int               xlen = 0;
+    int               i;
+    int               k;
+    int               ret;
+
+    yspec = clicon_dbspec_yang(h);
+    if ((xpv = calloc(nu->nu_rlen+1, sizeof(clixon_xvec *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<nu->nu_rlen; i++){
+	nr = nu->nu_rules[i];
+	if ((nr->nr_access & NACM_ACCESS_BIT(NACM_READ)) == 0 ||
+	    nr->nr_path == NULL)
+	    continue;
+	if (nr->nr_cplist == NULL){
+	    if (nr->nr_resolve < 0 && /* Not parsed: same error as when not compiled */
+		clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", nr->nr_path) < 0)
+		goto done;
+	    continue;
+	}
+	if (!nr->nr_keyed)
+	    continue;
+	if ((ret = clixon_xml_find_instance_id_cp(xt, yspec, nr->nr_cplist, &xvec, &xlen)) < 0)
+	    goto done;
+	if (ret == 1){
+	    if ((xpv[i] = clixon_xvec_new()) == NULL)
+		goto done;
+	    for (k=0; k<xlen; k++)
+		if (clixon_xvec_append(xpv[i], xvec[k]) < 0)
+		    goto done;
+	}
+	if (xvec){
+	    free(xvec);
+	    xvec = NULL;
+	}
+	xlen = 0;
+    }
+    *xpvp = xpv;
+    xpv = NULL;
+    retval = 0;
+ done:
+    if (xpv)
+	nacm_datanode_read_xpv_free(xpv, nu->nu_rlen);
+    if (xvec)
+	free(xvec);
+    return retval;
+}
+
 /*! Make nacm datanode and module rule read access validation
  * Just purge nodes that fail validation (dont send netconf error message)
  * @param[in]  h        Clicon handle
@@ -986,19 +1482,14 @@ nacm_datanode_read(clicon_handle h,
 		   char         *username,
 		   cxobj        *xnacm)
 {
-    int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
-    int             i;
-    char           *read_default = NULL;
-    cvec           *nsc = NULL;
-    prepvec        *pv_list = NULL;
+    int               retval = -1;
+    int               i;
+    char             *read_default = NULL;
+    clixon_xvec     **xpv = NULL;
+    nacm_ruleset     *nrs = NULL;
+    nacm_ruleset     *nrstmp = NULL;
+    struct nacm_user *nu;
     
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-	goto done;
     /* 3.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
        making the request.  (If the "enable-external-groups" leaf is
@@ -1006,30 +1497,31 @@ nacm_datanode_read(clicon_handle h,
        transport layer.)	       */
     if (username == NULL)
 	goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    if (nacm_ruleset_get(h, xnacm, &nrs, &nrstmp) < 0)
 	goto done;
-    /* 4. If no groups are found (glen=0), continue and check read-default 
+    /* 4. If no groups are found (nu=NULL), continue and check read-default 
           in step 11. */
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
         entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-	goto done;
+    nu = nacm_ruleset_user(nrs, username);
     /* read-default has default permit so should never be NULL */
     if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
 	clicon_err(OE_XML, EINVAL, "No nacm read-default rule");
 	goto done;
     }
-    /* First run through rules and cache rules as well as lookup objects in xt. 
-     * DANGER: objects could be stale if they are removed?
-     */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
-	goto done;
-    /* Then recursivelyy traverse all nodes */
-    if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
-	goto done;
+    if (nu){
+	/* First lookup objects in xt of rules with predicates, other rules match by
+	 * schema node
+	 * DANGER: objects could be stale if they are removed?
+	 */
+	if (nacm_datanode_read_prepare(h, xt, nu, &xpv) < 0)
+	    goto done;
+	/* Then recursivelyy traverse all nodes */
+	if (nacm_datanode_read_recurse(h, xt, nu, xpv, clicon_dbspec_yang(h)) < 0)
+	    goto done;
+    }
 #if 1
     /* Step 8(B) above:
      * If default rule is deny, recursively remove all subtrees that are not marked
@@ -1059,14 +1551,10 @@ nacm_datanode_read(clicon_handle h,
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
-    if (pv_list)
-	prepvec_free(pv_list);
-    if (nsc)
-	xml_nsctx_free(nsc);
-    if (gvec)
-	free(gvec);
-    if (rlistvec)
-	free(rlistvec);
+    if (xpv)
+	nacm_datanode_read_xpv_free(xpv, nu->nu_rlen);
+    if (nrstmp)
+	nacm_ruleset_free1(nrstmp);
     return retval;
 }
 
@@ -1080,46 +1568,38 @@ nacm_datanode_read(clicon_handle h,
  * If retval=0 continue with next NACM step, eg rpc, module, 
  * etc. If retval = 1 access is OK and skip next NACM step.
  * @param[in]  h        Clicon handle
- * @param[in]  xnacm    NACM XML tree, root should be "nacm"
+ * @param[in]  enabled  NACM is enabled, ie enable-nacm is true
+ * @param[in]  peername Peer username if any
  * @param[in]  username User name of requestor
  * @retval -1  Error
  * @retval  0  OK but not validated. Need to do NACM step using xnacm
  * @retval  1  OK permitted. You do not need to do next NACM step
  * @code
- *   if ((ret = nacm_access_check(h, mode, xnacm, peername, username)) < 0)
+ *   if ((ret = nacm_access_check(h, nrs->nrs_enabled, peername, username)) < 0)
  *     err;
  *   if (ret == 0){
  *      // Next step NACM processing
- *      xml_free(xnacm);
  *   }
  * @endcode
  * @see RFC8341 3.4 Access Control Enforcement Procedures
  */
 static int
 nacm_access_check(clicon_handle h,
-		  cxobj        *xnacm,
+		  int           enabled,
 		  char         *peername,
 		  char         *username)
 {
     int     retval = -1;
-    char   *enabled;
-    cxobj  *x;
-    cvec  *nsc = NULL;
     char  *recovery_user;
     
     clicon_debug(1, "%s", __FUNCTION__);
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-	goto done;
     /* Do initial nacm processing common to all access validation in
      * RFC8341 3.4 */
     /* 1.   If the "enable-nacm" leaf is set to "false", then the protocol
      * operation is permitted. 
      * note option CLICON_NACM_DISABLED_ON_EMPTY
     */
-    if ((x = xpath_first(xnacm, nsc, "enable-nacm")) == NULL)
-	goto permit;
-    enabled = xml_body(x);
-    if (strcmp(enabled, "true") != 0)
+    if (!enabled)
 	goto permit;
     recovery_user=clicon_nacm_recovery_user(h);
     /* 2.   If the requesting session is identified as a recovery session,
@@ -1157,8 +1637,6 @@ nacm_access_check(clicon_handle h,
     }
     retval = 0; /* not permitted yet. continue with next NACM step */
  done:
-    if (nsc)
-	xml_nsctx_free(nsc);
     clicon_debug(1, "%s retval:%d (0:deny 1:permit)", __FUNCTION__, retval);
     return retval;
  permit:
@@ -1170,9 +1648,12 @@ nacm_access_check(clicon_handle h,
  * Initial NACM steps and common to all NACM access validation.
  * If retval=0 continue with next NACM step, eg rpc, module, 
  * etc. If retval = 1 access is OK and skip next NACM step.
+ * The NACM rules are compiled into a rule set kept in the handle, which is reused until
+ * the NACM config changes: in internal mode when the running datastore is changed, in 
+ * external mode when the external NACM tree is changed.
  * @param[in]  h        Clicon handle
  * @param[in]  username User name of requestor
- * @param[out] xncam    NACM XML tree, set if retval=0. Free after use
+ * @param[out] xncam    NACM XML tree, set if retval=0. Owned by the NACM rule set, do not free
  * @retval -1  Error
  * @retval  0  OK but not validated. Need to do NACM step using xnacm
  * @retval  1  OK permitted. You do not need to do next NACM step.
@@ -1182,10 +1663,10 @@ nacm_access_check(clicon_handle h,
  *     err;
  *   if (ret == 0){
  *      // Next step NACM processing
- *      xml_free(xnacm);
  *   }
  * @endcode
  * @see RFC8341 3.4 Access Control Enforcement Procedures
+ * @see xmldb_generation  Changes of running datastore
  */
 int
 nacm_access_pre(clicon_handle  h,
@@ -1193,12 +1674,15 @@ nacm_access_pre(clicon_handle  h,
 		char          *username,
 		cxobj        **xnacmp)
 {
-    int    retval = -1;
-    char  *mode;
-    cxobj *x;
-    cxobj *xnacm0 = NULL;
-    cxobj *xnacm = NULL;
-    cvec  *nsc = NULL;
+    int           retval = -1;
+    char         *mode;
+    cxobj        *xext = NULL;
+    uint64_t      gen = 0;
+    cxobj        *xnacm0 = NULL;
+    cxobj        *xnacm = NULL;
+    cvec         *nsc = NULL;
+    nacm_ruleset *nrs = NULL;
+    void         *p;
     
     /* Check clixon option: disabled, external tree or internal */
     mode = clicon_option_str(h, "CLICON_NACM_MODE");
@@ -1206,45 +1690,66 @@ nacm_access_pre(clicon_handle  h,
 	goto permit;
     else if (strcmp(mode, "disabled")==0)
 	goto permit;
-    else if (strcmp(mode, "external")==0){
-	if ((x = clicon_nacm_ext(h)))
-	    if ((xnacm0 = xml_dup(x)) == NULL)
-		goto done;
-    }
-    else if (strcmp(mode, "internal")==0){
-	if (xmldb_get0(h, "running", YB_MODULE, nsc, "nacm", 1, &xnacm0, NULL) < 0)
-	    goto done;
-    }
+    else if (strcmp(mode, "external")==0)
+	xext = clicon_nacm_ext(h);
+    else if (strcmp(mode, "internal")==0)
+	gen = xmldb_generation(h, "running");
     else{
 	clicon_err(OE_XML, 0, "Invalid NACM mode: %s", mode);
 	goto done;
     }
-    
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-	goto done;
-    /* If config does not exist then the operation is permitted(?) */
-    if (xnacm0 == NULL)
-	goto permit;
+    if ((p = clicon_hash_value(clicon_data(h), "nacm_ruleset", NULL)) != NULL)
+	nrs = *(nacm_ruleset **)p;
+    /* Compile rule set if NACM config is changed */
+    if (nrs == NULL || 
+	nrs->nrs_xext != xext ||
+	nrs->nrs_gen != gen){
+	if (nacm_ruleset_free(h) < 0)
+	    goto done;
+	nrs = NULL;
+	if (xext){
+	    if ((xnacm0 = xml_dup(xext)) == NULL)
+		goto done;
+	}
+	else if (strcmp(mode, "internal")==0){
+	    if (xmldb_get0(h, "running", YB_MODULE, nsc, "nacm", 1, &xnacm0, NULL) < 0)
+		goto done;
+	}
+	if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
+	    goto done;
+	/* If config does not exist then the operation is permitted(?) */
+	if (xnacm0 &&
+	    (xnacm = xpath_first(xnacm0, nsc, "nacm")) != NULL){
+	    if (xml_rootchild_node(xnacm0, xnacm) < 0)
+		goto done;
+	    xnacm0 = NULL;
+	}
+	if (nacm_ruleset_compile(h, xnacm, &nrs) < 0){
+	    if (xnacm)
+		xml_free(xnacm);
+	    goto done;
+	}
+	nrs->nrs_copy = 1;
+	nrs->nrs_xext = xext;
+	nrs->nrs_gen = gen;
+	if (clicon_hash_add(clicon_data(h), "nacm_ruleset", &nrs, sizeof(nrs)) == NULL){
+	    nacm_ruleset_free1(nrs);
+	    goto done;
+	}
+    }
     /* If config does not exist then the operation is permitted(?) */
-    if ((xnacm = xpath_first(xnacm0, nsc, "nacm")) == NULL)
+    if ((xnacm = nrs->nrs_xnacm) == NULL)
 	goto permit;
-    if (xml_rootchild_node(xnacm0, xnacm) < 0)
-	goto done;
-    xnacm0 = NULL;
     /* Initial NACM steps and common to all NACM access validation. */
-    if ((retval = nacm_access_check(h, xnacm, peername, username)) < 0)
+    if ((retval = nacm_access_check(h, nrs->nrs_enabled, peername, username)) < 0)
 	goto done;
-    if (retval == 0){ /* if retval == 0 then return an xml nacm tree */
+    if (retval == 0) /* if retval == 0 then return an xml nacm tree */
 	*xnacmp = xnacm;
-	xnacm = NULL;
-    }
  done:
     if (nsc)
 	xml_nsctx_free(nsc);
     if (xnacm0)
 	xml_free(xnacm0);
-    else if (xnacm)
-	xml_free(xnacm);
     return retval;
  permit:
     retval = 1;
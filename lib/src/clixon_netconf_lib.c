@@ -1380,6 +1380,10 @@ netconf_module_load(clicon_handle h)
     if (clicon_option_bool(h, "CLICON_STREAM_DISCOVERY_RFC8040") &&
 	yang_spec_parse_module(h, "ietf-restconf-monitoring", NULL, yspec)< 0)
 	goto done;
+    /* Partial locks of running, RFC 5717 */
+    if (clicon_option_bool(h, "CLICON_NETCONF_PARTIAL_LOCK") &&
+	yang_spec_parse_module(h, "ietf-netconf-partial-lock", NULL, yspec)< 0)
+	goto done;
     /* YANG module revision change management */
     if (clicon_option_bool(h, "CLICON_XML_CHANGELOG"))
 	if (yang_spec_parse_module(h, "clixon-xml-changelog", NULL, yspec)< 0)
@@ -1566,6 +1570,8 @@ netconf_hello_server(clicon_handle h,
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:startup:1.0</capability>");
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:xpath:1.0</capability>");
     cprintf(cb, "<capability>urn:ietf:params:netconf:capability:notification:1.0</capability>");
+    if (clicon_option_bool(h, "CLICON_NETCONF_PARTIAL_LOCK"))
+	cprintf(cb, "<capability>%s</capability>", NETCONF_PARTIAL_LOCK_CAPABILITY);
     cprintf(cb, "</capabilities>");
     if (session_id) 
 	cprintf(cb, "<session-id>%lu</session-id>", (long unsigned int)session_id);
@@ -112,6 +112,7 @@ get_sock(int  usock,
  * @param[in]  sa_len   Length of sa. Tecynicaliyu to be independent of sockaddr sa_len
  * @param[in]  backlog  Listen backlog, queie of pending connections
  * @param[in]  flags    Socket flags Or:ed in with the socket(2) type parameter
+ *                      and CLIXON_SOCK_REUSEPORT
  * @param[out] sock     Server socket (bound for accept)
  */
 static int
@@ -132,7 +133,7 @@ create_socket(struct sockaddr *sa,
     }
     /* create inet socket */
     if ((s = socket(sa->sa_family,
-		    SOCK_STREAM | SOCK_CLOEXEC | flags,
+		    SOCK_STREAM | SOCK_CLOEXEC | (flags & ~CLIXON_SOCK_REUSEPORT),
 		    0)) < 0) {
 	clicon_err(OE_UNIX, errno, "socket");
 	goto done;
@@ -145,6 +146,13 @@ create_socket(struct sockaddr *sa,
 	clicon_err(OE_UNIX, errno, "setsockopt SO_REUSEADDR");
 	goto done;
     }
+#ifdef SO_REUSEPORT
+    if ((flags & CLIXON_SOCK_REUSEPORT) &&
+	setsockopt(s, SOL_SOCKET, SO_REUSEPORT, (void *)&on, sizeof(on)) == -1) {
+	clicon_err(OE_UNIX, errno, "setsockopt SO_REUSEPORT");
+	goto done;
+    }
+#endif
 
     /* only bind ipv6, otherwise it may bind to ipv4 as well which is strange but seems default */
     if (sa->sa_family == AF_INET6 &&
@@ -257,6 +265,7 @@ fork_netns_socket(const char      *netns,
  * @param[in]  sa_len   Length of sa. Tecynicaliyu to be independent of sockaddr sa_len
  * @param[in]  backlog  Listen backlog, queie of pending connections
  * @param[in]  flags    Socket flags OR:ed in with the socket(2) type parameter
+ *                      and CLIXON_SOCK_REUSEPORT
  * @param[out] sock     Server socket (bound for accept)
  */
 int
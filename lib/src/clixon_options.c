@@ -69,9 +69,11 @@
 #include "clixon_handle.h"
 #include "clixon_file.h"
 #include "clixon_log.h"
+#include "clixon_trace.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
 #include "clixon_options.h"
+#include "clixon_proto.h"
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
@@ -130,6 +132,23 @@ static const map_str2int datastore_cache_map[] = {
     {NULL,                    -1}
 };
 
+/* Mapping between datastore persist string <--> constants, 
+ * see clixon-config.yang type datastore_persist */
+static const map_str2int datastore_persist_map[] = {
+    {"snapshot",              DATASTORE_SNAPSHOT},
+    {"journal",               DATASTORE_JOURNAL},
+    {NULL,                    -1}
+};
+
+/* Mapping between datastore sync string <--> constants, 
+ * see clixon-config.yang type datastore_sync */
+static const map_str2int datastore_sync_map[] = {
+    {"none",                  DATASTORE_SYNC_NONE},
+    {"fdatasync",             DATASTORE_SYNC_DATA},
+    {"group",                 DATASTORE_SYNC_GROUP},
+    {NULL,                    -1}
+};
+
 /* Mapping between regular expression type string <--> constants, 
  * see clixon-config.yang type regexp_mode */
 static const map_str2int yang_regexp_map[] = {
@@ -343,7 +362,8 @@ parse_configfile(clicon_handle  h,
 		    continue;
 		/* List options for configure options that are lists or leaf-lists: append to main */
 		if (strcmp(name,"CLICON_FEATURE")==0 ||
-		    strcmp(name,"CLICON_YANG_DIR")==0){
+		    strcmp(name,"CLICON_YANG_DIR")==0 ||
+		    strcmp(name,"CLICON_YANG_SEARCH_INDEX")==0){
 		    if (xml_addsub(xt, xec) < 0)
 			goto done;
 		    continue;
@@ -391,6 +411,8 @@ parse_configfile(clicon_handle  h,
 	    continue;
 	if (strcmp(name,"CLICON_YANG_DIR")==0)
 	    continue;
+	if (strcmp(name,"CLICON_YANG_SEARCH_INDEX")==0)
+	    continue;
 	if (clicon_hash_add(copt, 
 			    name,
 			    body,
@@ -434,7 +456,8 @@ clicon_option_add(clicon_handle h,
     cxobj         *x;
 
     if (strcmp(name, "CLICON_FEATURE")==0 ||
-	strcmp(name, "CLICON_YANG_DIR")==0){
+	strcmp(name, "CLICON_YANG_DIR")==0 ||
+	strcmp(name, "CLICON_YANG_SEARCH_INDEX")==0){
 	if ((x = clicon_conf_xml(h)) == NULL){
 	    clicon_err(OE_UNIX, ENOENT, "option %s not found (clicon_conf_xml_set has not been called?)", name);
 	    goto done;
@@ -448,6 +471,8 @@ clicon_option_add(clicon_handle h,
 		 value,
 		 strlen(value)+1) == NULL)
 	goto done;
+    if (clicon_options_resolve(h, name) < 0)
+	goto done;
     retval = 0;
  done:
     return retval;
@@ -475,6 +500,7 @@ clicon_options_main(clicon_handle h)
     cxobj         *xconfig = NULL;
     yang_stmt     *yspec = NULL;
     char          *extraconfdir = NULL;
+    char          *str;
 
     /* Create configure yang-spec */
     if ((yspec = yspec_new()) == NULL)
@@ -556,7 +582,16 @@ clicon_options_main(clicon_handle h)
     /* Set clixon_conf pointer to handle */
     if (clicon_conf_xml_set(h, xconfig) < 0)
 	goto done;
-
+    /* Typed options of hot paths, see clicon_optv() */
+    if (clicon_options_resolve(h, NULL) < 0)
+	goto done;
+    /* Debug levels of debug categories, see clixon_debug() */
+    if ((str = clicon_option_str(h, "CLICON_DEBUG_CATEGORIES")) != NULL &&
+	clixon_debug_category_parse(str) < 0)
+	goto done;
+    /* Log spans of traced requests, see clixon_trace_span() */
+    if (clicon_option_bool(h, "CLICON_TRACE_LOG"))
+	clixon_trace_sink_set(clixon_trace_sink_log, NULL);
     retval = 0;
  done:
     if (yspec)
@@ -566,6 +601,69 @@ clicon_options_main(clicon_handle h)
     return retval;
 }
 
+/*! Update typed options from option strings
+ *
+ * Called when options are loaded and when an option is set or deleted, so that hot
+ * paths read the typed value directly instead of looking up and parsing the string.
+ * @param[in]  h     Clicon handle
+ * @param[in]  name  Name of changed option, or NULL for all
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see struct clicon_optv
+ */
+int
+clicon_options_resolve(clicon_handle h,
+		       const char   *name)
+{
+    struct clicon_optv *co;
+    char               *str;
+
+    if ((co = clicon_optv(h)) == NULL){
+	clicon_err(OE_CFG, EINVAL, "No typed options in handle");
+	return -1;
+    }
+    if (name == NULL || strcmp(name, "CLICON_XMLDB_FORMAT") == 0){
+	if ((str = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL)
+	    co->co_xmldb_format = -1;
+	else
+	    co->co_xmldb_format = strcmp(str, "json")==0 ? FORMAT_JSON :
+		strcmp(str, "cbor")==0 ? FORMAT_CBOR : FORMAT_XML;
+    }
+    if (name == NULL || strcmp(name, "CLICON_XMLDB_PRETTY") == 0)
+	co->co_xmldb_pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
+    if (name == NULL || strcmp(name, "CLICON_XMLDB_COMPRESS") == 0)
+	co->co_xmldb_compress = clicon_option_int(h, "CLICON_XMLDB_COMPRESS");
+    if (name == NULL || strcmp(name, "CLICON_XMLDB_JOURNAL_COMPACT") == 0)
+	co->co_xmldb_journal_compact = clicon_option_int(h, "CLICON_XMLDB_JOURNAL_COMPACT");
+    if (name == NULL || strcmp(name, "CLICON_DATASTORE_CACHE") == 0){
+	if ((str = clicon_option_str(h, "CLICON_DATASTORE_CACHE")) == NULL)
+	    co->co_datastore_cache = DATASTORE_CACHE;
+	else
+	    co->co_datastore_cache = clicon_str2int(datastore_cache_map, str);
+    }
+    if (name == NULL || strcmp(name, "CLICON_XMLDB_PERSIST") == 0){
+	if ((str = clicon_option_str(h, "CLICON_XMLDB_PERSIST")) == NULL)
+	    co->co_xmldb_persist = DATASTORE_SNAPSHOT;
+	else
+	    co->co_xmldb_persist = clicon_str2int(datastore_persist_map, str);
+    }
+    if (name == NULL || strcmp(name, "CLICON_XMLDB_SYNC") == 0){
+	if ((str = clicon_option_str(h, "CLICON_XMLDB_SYNC")) == NULL)
+	    co->co_xmldb_sync = DATASTORE_SYNC_NONE;
+	else
+	    co->co_xmldb_sync = clicon_str2int(datastore_sync_map, str);
+    }
+    if (name == NULL || strcmp(name, "CLICON_XMLDB_TRANSIENT") == 0)
+	co->co_xmldb_transient = clicon_option_bool(h, "CLICON_XMLDB_TRANSIENT");
+    if (name == NULL || strcmp(name, "CLICON_XMLDB_SHARD") == 0)
+	co->co_xmldb_shard = clicon_option_bool(h, "CLICON_XMLDB_SHARD");
+    if (name == NULL || strcmp(name, "CLICON_NACM_DISABLED_ON_EMPTY") == 0)
+	co->co_nacm_disabled_on_empty = clicon_option_bool(h, "CLICON_NACM_DISABLED_ON_EMPTY");
+    if (name == NULL || strcmp(name, "CLICON_YANG_UNKNOWN_ANYDATA") == 0)
+	co->co_yang_unknown_anydata = clicon_option_bool(h, "CLICON_YANG_UNKNOWN_ANYDATA");
+    return 0;
+}
+
 /*! Check if a clicon option has a value
  * @param[in] h     clicon_handle
  * @param[in] name  option name
@@ -616,7 +714,9 @@ clicon_option_str_set(clicon_handle h,
 {
     clicon_hash_t *copt = clicon_options(h);
 
-    return clicon_hash_add(copt, (char*)name, val, strlen(val)+1)==NULL?-1:0;
+    if (clicon_hash_add(copt, (char*)name, val, strlen(val)+1) == NULL)
+	return -1;
+    return clicon_options_resolve(h, name);
 }
 
 /*! Get options as integer but stored as string
@@ -727,7 +827,9 @@ clicon_option_del(clicon_handle h,
 {
     clicon_hash_t *copt = clicon_options(h);
 
-    return clicon_hash_del(copt, (char*)name);
+    if (clicon_hash_del(copt, (char*)name) < 0)
+	return -1;
+    return clicon_options_resolve(h, name);
 }
 
 /*-----------------------------------------------------------------
@@ -907,12 +1009,29 @@ clicon_nacm_credentials(clicon_handle h)
 enum datastore_cache
 clicon_datastore_cache(clicon_handle h)
 {
-    char *str;
+    return clicon_optv(h)->co_datastore_cache;
+}
 
-    if ((str = clicon_option_str(h, "CLICON_DATASTORE_CACHE")) == NULL)
-	return DATASTORE_CACHE;
-    else
-	return clicon_str2int(datastore_cache_map, str);
+/*! Which datastore write method to use
+ * @param[in] h      Clicon handle
+ * @retval    method Datastore write method
+ * @see clixon-config@<date>.yang CLICON_XMLDB_PERSIST
+ */
+enum datastore_persist
+clicon_datastore_persist(clicon_handle h)
+{
+    return clicon_optv(h)->co_xmldb_persist;
+}
+
+/*! How datastore files are synced to disk when written
+ * @param[in] h      Clicon handle
+ * @retval    sync   Datastore sync policy
+ * @see clixon-config@<date>.yang CLICON_XMLDB_SYNC
+ */
+enum datastore_sync
+clicon_datastore_sync(clicon_handle h)
+{
+    return clicon_optv(h)->co_xmldb_sync;
 }
 
 /*! Which Yang regexp/pattern engine to use
@@ -196,7 +196,7 @@ instance_id_parse(char         *path,
     return retval;
 }
 
-static int
+int
 clixon_path_free(clixon_path *cplist)
 {
     clixon_path *cp;
@@ -1289,6 +1289,100 @@ xml2api_path_1(cxobj *x,
     return retval;
 }
 
+/*! Append a quoted value to an instance-identifier predicate
+ * Apostrophes are used unless the value contains one, see RFC 7950 9.13
+ */
+static void
+instance_id_value(cbuf *cb,
+		  char *val)
+{
+    if (val == NULL)
+	val = "";
+    if (strchr(val, '\'') == NULL)
+	cprintf(cb, "'%s'", val);
+    else
+	cprintf(cb, "\"%s\"", val);
+}
+
+/*! Construct an instance-identifier of an XML node from the root
+ *
+ * Every node name has the prefix of its module, and list entries and leaf-list entries
+ * have key and value predicates, eg /ex:a/ex:b[ex:k='1']/ex:c
+ * @param[in]  x     XML node (need to be yang populated)
+ * @param[out] cb    Instance-identifier is appended, must be initialized
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see xml2api_path_1  for api-path of a single level
+ * @see instance_id_parse  for the reverse
+ */
+int
+xml2instance_id(cxobj *x,
+		cbuf  *cb)
+{
+    int           retval = -1;
+    yang_stmt    *y;
+    cxobj        *xp;
+    cvec         *cvk;
+    cg_var       *cvi;
+    char         *keyname;
+    char         *prefix = NULL;
+#ifdef XML_PATH_CACHE
+    size_t        start;
+    char         *path;
+#endif
+
+    if ((xp = xml_parent(x)) == NULL)
+	goto ok;
+#ifdef XML_PATH_CACHE
+    if ((path = xml_path_cache_get(x, XML_PATH_INSTANCE_ID)) != NULL){
+	cprintf(cb, "%s", path);
+	goto ok;
+    }
+    start = cbuf_len(cb);
+#endif
+    if (xml2instance_id(xp, cb) < 0)
+	goto done;
+    if ((y = xml_spec(x)) == NULL){
+	cprintf(cb, "/%s", xml_name(x));
+	goto ok;
+    }
+    prefix = yang_find_myprefix(y);
+    if (prefix)
+	cprintf(cb, "/%s:%s", prefix, xml_name(x));
+    else
+	cprintf(cb, "/%s", xml_name(x));
+    switch (yang_keyword_get(y)){
+    case Y_LEAF_LIST:
+	cprintf(cb, "[.=");
+	instance_id_value(cb, xml_body(x));
+	cprintf(cb, "]");
+	break;
+    case Y_LIST:
+	cvk = yang_cvec_get(y); /* Use Y_LIST cache, see ys_populate_list() */
+	cvi = NULL;
+	while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+	    keyname = cv_string_get(cvi);
+	    if (prefix)
+		cprintf(cb, "[%s:%s=", prefix, keyname);
+	    else
+		cprintf(cb, "[%s=", keyname);
+	    instance_id_value(cb, xml_find_body(x, keyname));
+	    cprintf(cb, "]");
+	}
+#ifdef XML_PATH_CACHE
+	if (xml_path_cache_set(x, XML_PATH_INSTANCE_ID, cbuf_get(cb)+start) < 0)
+	    goto done;
+#endif
+	break;
+    default:
+	break;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Resolve api-path module:names to yang statements
  * @param[in]  cplist   Lisp of clixon-path
  * @param[in]  yt       Yang statement of top symbol (can be yang-spec if top-level)
@@ -1640,6 +1734,82 @@ clixon_xml_find_api_path(cxobj        *xt,
     goto done;
 }
 
+/*! Parse and resolve instance-id path once, for repeated searches
+ *
+ * @param[in]  yt      Yang statement of top symbol (can be yang-spec if top-level)
+ * @param[in]  path    Instance-id path
+ * @param[out] cplistp Resolved clixon-path, free with clixon_path_free
+ * @retval    -1       Error, eg parse error
+ * @retval     0       Fail: path does not resolve to yang
+ * @retval     1       OK and cplistp set
+ * @see clixon_xml_find_instance_id_cp  Search with resolved path
+ */
+int
+clixon_instance_id_compile(yang_stmt    *yt,
+			   char         *path,
+			   clixon_path **cplistp)
+{
+    int          retval = -1;
+    clixon_path *cplist = NULL;
+    int          ret;
+
+    if (instance_id_parse(path, &cplist) < 0)
+	goto done;
+    if ((ret = instance_id_resolve(cplist, yt)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    *cplistp = cplist;
+    cplist = NULL;
+    retval = 1;
+ done:
+    if (cplist)
+	clixon_path_free(cplist);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Given resolved (instance-id) path and XML tree, return matching xml node vector
+ *
+ * @param[in]  xt      Top xml-tree where to search
+ * @param[in]  yt      Yang statement of top symbol (can be yang-spec if top-level)
+ * @param[in]  cplist  Resolved clixon-path, see clixon_instance_id_compile
+ * @param[out] xvec    Vector of xml-trees. Vector must be free():d after use
+ * @param[out] xlen    Returns length of vector in return value
+ * @retval    -1       Error
+ * @retval     0       Fail
+ * @retval     1       OK with found xml nodes in xvec (if any)
+ * @see clixon_xml_find_instance_id
+ */
+int
+clixon_xml_find_instance_id_cp(cxobj       *xt, 
+			       yang_stmt   *yt,
+			       clixon_path *cplist,
+			       cxobj     ***xvec,
+			       int         *xlen)
+{
+    int          retval = -1;
+    int          ret;
+    clixon_xvec *xv = NULL;
+
+    if ((ret = clixon_path_search(xt, yt, cplist, &xv)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if (xv && clixon_xvec_extract(xv, xvec, xlen) < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (xv)
+	clixon_xvec_free(xv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Given (instance-id) path and XML tree, return matching xml node vector using stdarg
  *
  * Instance-identifier is a subset of XML XPaths and defined in Yang, used in NACM for 
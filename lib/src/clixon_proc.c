@@ -41,6 +41,7 @@
   In RUNNING several things can happen:
   - It is killed externally: the process then gets a SIGCHLD which triggers a wait and it goes into STOPPED:
        RUNNING  --sigchld/wait-->  STOPPED
+    With PROC_PIDFD, the exit is instead an event on a pidfd of the process, see clixon_process_pidfd
   It is stopped due to an rpc or by config commit removing the config. In that case the parent 
   process kills the process and enters into EXITING waiting for a SIGCHLD that triggers a wait:
        RUNNING --stop--> EXITING --sigchld/wait--> STOPPED
@@ -75,6 +76,9 @@
 #include <sys/param.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#ifdef PROC_PIDFD
+#include <sys/syscall.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -110,6 +114,7 @@ struct process_entry_t {
     int            pe_exiting;  /* If set process is in the process of dying needs reaping */
     int            pe_clone;    /* Duplicate when restarting, delete when reaped */
     pid_t          pe_status;   /* Status on exit as defined in waitpid */
+    int            pe_pidfd;    /* pidfd of running process or -1, see clixon_process_pidfd */
     proc_operation pe_op;       /* Operation pending? */
     struct timeval pe_starttime; /* Start time */
     proc_cb_t     *pe_callback; /* Wrapper function, may be called from process_operation  */
@@ -320,6 +325,8 @@ static const map_str2int proc_operation_map[] = {
 /* List of process callback entries XXX move to handle */
 static process_entry_t *_proc_entry_list = NULL;
 
+static int clixon_process_pidfd_cb(int fd, void *arg);
+
 proc_operation
 clixon_process_op_str2int(char *opstr)
 {
@@ -384,6 +391,7 @@ clixon_process_register_dup(process_entry_t  *pe0,
     memcpy(pe1, pe0, sizeof(process_entry_t)); /* Note lots of malloced memory that needs to be handled after this copy*/
     pe1->pe_exiting = 0;
     pe1->pe_clone = 0;
+    pe1->pe_pidfd = -1;
     if ((pe1->pe_name = strdup(pe0->pe_name)) == NULL){
 	clicon_err(OE_DB, errno, "strdup name");
 	goto done;
@@ -479,6 +487,7 @@ clixon_process_register(clicon_handle h,
 	}
     }
     pe->pe_callback = callback;
+    pe->pe_pidfd = -1;
     ADDQ(pe, _proc_entry_list);
     retval = 0;
  done:
@@ -490,6 +499,10 @@ clixon_process_delete_only(process_entry_t *pe)
 {
     char           **pa;
 
+    if (pe->pe_pidfd != -1){
+	clixon_event_unreg_fd(pe->pe_pidfd, clixon_process_pidfd_cb);
+	close(pe->pe_pidfd);
+    }
     if (pe->pe_name)
 	free(pe->pe_name);
     if (pe->pe_description)
@@ -669,6 +682,49 @@ clixon_process_status(clicon_handle  h,
     return retval;
 }
 
+/*! Send a signal to a running process, eg to start sampling in it
+ *
+ * @param[in]  h       clicon handle
+ * @param[in]  name    Name of process
+ * @param[in]  sig     Signal number
+ * @retval -1  Error
+ * @retval  0  No such process or it is not running
+ * @retval  1  Signal sent
+ */
+int
+clixon_process_signal(clicon_handle  h,
+		      const char    *name,
+		      int            sig)
+{
+    int              retval = -1;
+    process_entry_t *pe;
+    int              run = 0;
+
+    if (_proc_entry_list == NULL)
+	goto ok;
+    pe = _proc_entry_list;
+    do {
+	if (strcmp(pe->pe_name, name) == 0 && !pe->pe_clone && !pe->pe_exiting){
+	    if (pe->pe_pid && proc_op_run(pe->pe_pid, &run) < 0)
+		goto done;
+	    if (run == 0)
+		break;
+	    clicon_debug(1, "%s name:%s pid:%d sig:%d", __FUNCTION__, name, pe->pe_pid, sig);
+	    if (kill(pe->pe_pid, sig) < 0){
+		clicon_err(OE_UNIX, errno, "kill(%d)", pe->pe_pid);
+		goto done;
+	    }
+	    retval = 1;
+	    goto done;
+	}
+	pe = NEXTQ(process_entry_t *, pe);
+    } while (pe != _proc_entry_list);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Go through process list and start all processes that are enabled via config wrap function
  * @param[in]  h   Clixon handle
  * Commit rules should have done this, but there are some cases such as backend -s none mode
@@ -707,6 +763,113 @@ clixon_process_start_all(clicon_handle h)
     return retval;
 }
 
+/*! A process has exited and is reaped, update its entry
+ * @param[in]  h       Clixon handle
+ * @param[in]  pe      Process entry, deleted if it is a clone
+ * @param[in]  status  Status on exit as defined in waitpid
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+clixon_process_reaped(clicon_handle    h,
+		      process_entry_t *pe,
+		      int              status)
+{
+    int retval = -1;
+
+    clicon_debug(1, "%s %s pid:%d status:%d", __FUNCTION__, pe->pe_name, pe->pe_pid, status);
+    if (pe->pe_pidfd != -1){
+	clixon_event_unreg_fd(pe->pe_pidfd, clixon_process_pidfd_cb);
+	close(pe->pe_pidfd);
+	pe->pe_pidfd = -1;
+    }
+    pe->pe_exiting = 0;
+    pe->pe_pid = 0;       /* mark as dead */
+    pe->pe_status = status;   
+    if (pe->pe_clone){
+	/* Delete it */
+	DELQ(pe, _proc_entry_list, process_entry_t *);
+	clixon_process_delete_only(pe);
+    }
+    /* Operation was pending until the process exited, eg a start after stop */
+    else if (pe->pe_op != PROC_OP_NONE &&
+	     clixon_process_sched_register(h) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! A pidfd of a process is readable, ie the process has exited
+ * @param[in]  fd   pidfd
+ * @param[in]  arg  Clixon handle
+ * @see clixon_process_pidfd
+ */
+static int
+clixon_process_pidfd_cb(int   fd,
+			void *arg)
+{
+    clicon_handle    h = (clicon_handle)arg;
+    process_entry_t *pe;
+    int              status = 0;
+    pid_t            wpid;
+
+    if ((pe = _proc_entry_list) == NULL)
+	return 0;
+    do {
+	if (pe->pe_pidfd == fd){
+	    if ((wpid = waitpid(pe->pe_pid, &status, WNOHANG)) == 0)
+		return 0; /* Not exited */
+	    if (wpid < 0 && errno != ECHILD){
+		clicon_err(OE_UNIX, errno, "waitpid(%d)", pe->pe_pid);
+		return -1;
+	    }
+	    return clixon_process_reaped(h, pe, status);
+	}
+	pe = NEXTQ(process_entry_t *, pe);
+    } while (pe != _proc_entry_list);
+    return 0;
+}
+
+/*! Supervise a started process with a pidfd registered in the event loop
+ *
+ * If pidfd_open(2) is not supported, the process is reaped on SIGCHLD instead, see
+ * clixon_process_waitpid. A process that exits before the pidfd is opened is a zombie
+ * until reaped, and its pidfd is then readable at once.
+ * @param[in]  h   Clixon handle
+ * @param[in]  pe  Process entry with pid of started process
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+clixon_process_pidfd(clicon_handle    h,
+		     process_entry_t *pe)
+{
+    int retval = -1;
+#if defined(PROC_PIDFD) && defined(SYS_pidfd_open)
+    int fd;
+
+    if (pe->pe_pid == 0)
+	goto ok;
+    if ((fd = syscall(SYS_pidfd_open, pe->pe_pid, 0)) < 0){
+	clicon_debug(1, "%s pidfd_open(%d): %s, using SIGCHLD", __FUNCTION__,
+		     pe->pe_pid, strerror(errno));
+	goto ok;
+    }
+    if (clixon_event_reg_fd(fd, clixon_process_pidfd_cb, h, "process") < 0){
+	close(fd);
+	goto done;
+    }
+    pe->pe_pidfd = fd;
+ ok:
+#endif
+    retval = 0;
+#if defined(PROC_PIDFD) && defined(SYS_pidfd_open)
+ done:
+#endif
+    return retval;
+}
+
 /*! Traverse all processes and check pending start/stop/restarts
  * @param[in]  h   Clixon handle
  * Typical cases where postponing process start/stop is necessary:
@@ -734,7 +897,13 @@ clixon_process_sched(int           fd,
     do {
 	clicon_debug(1, "%s name: %s pid:%d op: %s", __FUNCTION__,
 		     pe->pe_name, pe->pe_pid, clicon_int2str(proc_operation_map, pe->pe_op));
-	/* Execute pending operations and not already exiting */
+	/* Operations on an exiting process are kept pending until it is reaped,
+	 * see clixon_process_reaped */
+	if (pe->pe_op != PROC_OP_NONE && pe->pe_exiting && !pe->pe_clone){
+	    pe = NEXTQ(process_entry_t *, pe);
+	    continue;
+	}
+	/* Execute pending operations */
 	if ((op = pe->pe_op) != PROC_OP_NONE &&
 	    pe->pe_exiting == 0){
 	    /* Check if running */
@@ -760,6 +929,8 @@ clixon_process_sched(int           fd,
 			goto done;
 		    gettimeofday(&pe->pe_starttime, NULL);
 		    clicon_debug(1, "%s started pid:%d", __FUNCTION__, pe->pe_pid);
+		    if (clixon_process_pidfd(h, pe) < 0)
+			goto done;
 		}
 		else {
 		    /* This is the case where there is an existing process running.
@@ -774,6 +945,8 @@ clixon_process_sched(int           fd,
 		    pe->pe_clone = 1; /* Delete when reaped */
 		    pe1->pe_op = PROC_OP_NONE; /* Dont restart again */
 		    pe1->pe_pid = newpid;
+		    if (clixon_process_pidfd(h, pe1) < 0)
+			goto done;
 		}
 		break;
 	    case PROC_OP_START:
@@ -783,6 +956,8 @@ clixon_process_sched(int           fd,
 		    goto done;
 		gettimeofday(&pe->pe_starttime, NULL);
 		clicon_debug(1, "%s started pid:%d", __FUNCTION__, pe->pe_pid);
+		if (clixon_process_pidfd(h, pe) < 0)
+		    goto done;
 		break;
 	    default:
 		break;
@@ -838,20 +1013,16 @@ clixon_process_waitpid(clicon_handle h)
     pid_t            wpid;
 
     clicon_debug(1, "%s", __FUNCTION__);
-    pe = _proc_entry_list;
+    if ((pe = _proc_entry_list) == NULL)
+	goto ok;
     do {
-	if (pe->pe_pid != 0){
+	/* Processes with a pidfd are reaped when it is readable, see clixon_process_pidfd */
+	if (pe->pe_pid != 0 && pe->pe_pidfd == -1){
 	    clicon_debug(1, "%s waitpid(%d)", __FUNCTION__, pe->pe_pid);
 	    if ((wpid = waitpid(pe->pe_pid, &status, WNOHANG)) == pe->pe_pid){
 		clicon_debug(1, "%s waitpid(%d) waited", __FUNCTION__, pe->pe_pid);
-		pe->pe_exiting = 0;
-		pe->pe_pid = 0;       /* mark as dead */
-		pe->pe_status = status;   
-		if (pe->pe_clone){
-		    /* Delete it */
-		    DELQ(pe, _proc_entry_list, process_entry_t *);
-		    clixon_process_delete_only(pe);
-		}
+		if (clixon_process_reaped(h, pe, status) < 0)
+		    goto done;
 		break; /* pid is unique */
 	    }
 	    else
@@ -859,8 +1030,36 @@ clixon_process_waitpid(clicon_handle h)
 	}
     	pe = NEXTQ(process_entry_t *, pe);
     } while (pe != _proc_entry_list);
+ ok:
     retval = 0;
-    // done:
+ done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
     return retval;
 }
+
+/*! Stop all running processes directly, without scheduling
+ * Used when the parent exits and no more scheduling is made. The processes are sent
+ * SIGTERM but are not waited for.
+ * @param[in]  h  Clixon handle
+ * @see clixon_process_operation for scheduled stop
+ */
+int
+clixon_process_stop_all(clicon_handle h)
+{
+    process_entry_t *pe;
+    int              run;
+
+    clicon_debug(1, "%s", __FUNCTION__);
+    if ((pe = _proc_entry_list) == NULL)
+	return 0;
+    do {
+	if (pe->pe_pid && pe->pe_exiting == 0 &&
+	    proc_op_run(pe->pe_pid, &run) == 0 && run){
+	    clicon_log(LOG_NOTICE, "Killing old process %s with pid: %d", pe->pe_name, pe->pe_pid);
+	    kill(pe->pe_pid, SIGTERM);
+	    pe->pe_exiting = 1;
+	}
+	pe = NEXTQ(process_entry_t *, pe);
+    } while (pe != _proc_entry_list);
+    return 0;
+}
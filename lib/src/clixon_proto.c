@@ -49,15 +49,22 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <signal.h>
 #include <ctype.h>
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#ifdef HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif
 #include <sys/stat.h>
 #include <netinet/in.h>
 #include <sys/un.h>
+#include <poll.h>
 #include <arpa/inet.h>
 #include <assert.h>
 
@@ -71,12 +78,18 @@
 #include "clixon_handle.h"
 #include "clixon_event.h"
 #include "clixon_log.h"
+#include "clixon_trace.h"
 #include "clixon_yang.h"
 #include "clixon_sig.h"
 #include "clixon_xml.h"
 #include "clixon_xml_io.h"
+#include "clixon_xml_bin.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_xml_bind.h"
+#include "clixon_xml_sort.h"
 #include "clixon_options.h"
 #include "clixon_proto.h"
+#include "clixon_stream.h"
 
 static int _atomicio_sig = 0;
 
@@ -93,6 +106,7 @@ static struct formatvec _FORMATS[] = {
     {"json",    FORMAT_JSON},
     {"cli",     FORMAT_CLI},
     {"netconf", FORMAT_NETCONF},
+    {"cbor",    FORMAT_CBOR},
     {NULL,   -1}
 };
 
@@ -126,6 +140,30 @@ format_str2int(char *str)
     return fv?fv->fv_int:-1;
 }
 
+/*! Get trace-id attribute to insert in an <rpc> message if tracing is enabled
+ * @param[out] trace  Buffer for attribute, eg trace-id="..."
+ * @param[in]  len    Length of trace buffer
+ * @retval     tlen   Length of attribute, 0 if no trace
+ */
+static size_t
+msg_trace_attr(char  *trace,
+	       size_t len)
+{
+    if (!clixon_trace_enabled() || clixon_trace_id_get() == 0)
+	return 0;
+    snprintf(trace, len, " trace-id=\"%016" PRIx64 "\"", clixon_trace_id_get());
+    return strlen(trace);
+}
+
+/*! Check if a message body is an <rpc> where a trace-id attribute can be inserted
+ */
+static int
+msg_is_rpc(char *body)
+{
+    return strncmp(body, "<rpc", 4) == 0 &&
+	(body[4] == ' ' || body[4] == '>' || body[4] == '/');
+}
+
 /*! Encode a clicon netconf message using variable argument lists
  * @param[in] id      Session id of client
  * @param[in] format  Variable agrument list format an XML netconf string
@@ -134,6 +172,8 @@ format_str2int(char *str)
  * @note if format includes %, they will be expanded according to printf rules.
  *       if this is a problem, use ("%s", xml) instaead of (xml)
  *       Notaly this may an issue of RFC 3896 encoded strings
+ * @note If a request is traced, the trace id is added as trace-id attribute to <rpc>,
+ *       see clixon_trace_id_get
  */
 struct clicon_msg *
 clicon_msg_encode(uint32_t      id,
@@ -144,18 +184,20 @@ clicon_msg_encode(uint32_t      id,
     uint32_t           len;
     struct clicon_msg *msg = NULL;
     int                hdrlen = sizeof(*msg);
+    char               trace[32] = {0,}; /* trace-id attribute */
+    size_t             tlen;
 
     va_start(args, format);
     xmllen = vsnprintf(NULL, 0, format, args) + 1;
     va_end(args);
 
-    len = hdrlen + xmllen;
+    tlen = msg_trace_attr(trace, sizeof(trace));
+    len = hdrlen + xmllen + tlen;
     if ((msg = (struct clicon_msg *)malloc(len)) == NULL){
 	clicon_err(OE_PROTO, errno, "malloc");
 	return NULL;
     }
-    memset(msg, 0, len);
-    /* hdr */
+    /* hdr, body is written by vsnprintf including NULL */
     msg->op_len = htonl(len);
     msg->op_id = htonl(id);
     
@@ -163,11 +205,104 @@ clicon_msg_encode(uint32_t      id,
     va_start(args, format);
     vsnprintf(msg->op_body, xmllen, format, args);
     va_end(args);
+    /* Insert trace-id attribute after "<rpc" */
+    if (tlen){
+	if (msg_is_rpc(msg->op_body)){
+	    memmove(msg->op_body + 4 + tlen, msg->op_body + 4, xmllen - 4);
+	    memcpy(msg->op_body + 4, trace, tlen);
+	}
+	else
+	    msg->op_len = htonl(hdrlen + xmllen);
+    }
+    return msg;
+}
 
+/*! Encode a clicon netconf message from an XML tree in compact binary format
+ * @param[in] id      Session id of client
+ * @param[in] x       XML netconf tree, eg <rpc>
+ * @retval    NULL    Error
+ * @retval    msg     Clicon message to send to eg clicon_msg_send()
+ * @note Only send to a backend that has accepted CLIXON_PROTO_BIN_CAPABILITY in hello
+ * @see clixon_xml2bin
+ */
+struct clicon_msg *
+clicon_msg_encode_bin(uint32_t id,
+		      cxobj   *x)
+{
+    struct clicon_msg *msg = NULL;
+    cbuf              *cb = NULL;
+    uint32_t           len;
+    int                hdrlen = sizeof(*msg);
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_PROTO, errno, "cbuf_new");
+	goto done;
+    }
+    if (clixon_xml2bin(cb, x) < 0)
+	goto done;
+    len = hdrlen + cbuf_len(cb) + 1; /* Terminating NUL for debug printouts */
+    if ((msg = (struct clicon_msg *)malloc(len)) == NULL){
+	clicon_err(OE_PROTO, errno, "malloc");
+	goto done;
+    }
+    memset(msg, 0, len);
+    msg->op_len = htonl(len);
+    msg->op_id = htonl(id);
+    memcpy(msg->op_body, cbuf_get(cb), cbuf_len(cb));
+ done:
+    if (cb)
+	cbuf_free(cb);
     return msg;
 }
 
+/*! Decode a binary clicon netconf message and bind yang as an rpc
+ * @see clicon_msg_decode
+ */
+static int
+clicon_msg_decode_bin(struct clicon_msg *msg, 
+		      yang_stmt         *yspec,
+		      cxobj            **xml,
+		      cxobj            **xerr)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cxobj *x;
+    int    ret;
+    int    failed = 0;
+
+    clixon_debug(CLIXON_DBG_MSG, 1, "%s len:%u", __FUNCTION__, ntohl(msg->op_len));
+    if ((xt = xml_new("top", NULL, CX_ELMNT)) == NULL)
+	goto done;
+    if (clixon_bin2xml(msg->op_body, ntohl(msg->op_len) - sizeof(*msg), xt) < 0)
+	goto done;
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+	if (xml2ns_recurse(x) < 0)
+	    goto done;
+	if (yspec == NULL)
+	    continue;
+	if ((ret = xml_bind_yang_rpc(x, yspec, xerr)) < 0)
+	    goto done;
+	if (ret == 0){ /* Add message-id */
+	    if (*xerr && clixon_xml_attr_copy(x, *xerr, "message-id") < 0)
+		goto done;
+	    failed++;
+	}
+    }
+    if (yspec && failed == 0)
+	if (xml_sort_recurse(xt) < 0)
+	    goto done;
+    *xml = xt;
+    xt = NULL;
+    retval = failed?0:1;
+ done:
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
 /*! Decode a clicon netconf message
+ * The message is either XML text or in compact binary format, see clicon_msg_encode_bin
  * @param[in]  msg    CLICON msg
  * @param[in]  yspec  Yang specification, (can be NULL)
  * @param[out] id     Session id
@@ -193,7 +328,9 @@ clicon_msg_decode(struct clicon_msg *msg,
 	*id = ntohl(msg->op_id);
     /* body */
     xmlstr = msg->op_body;
-    clicon_debug(1, "%s %s", __FUNCTION__, xmlstr);
+    if (xmlstr[0] == CLIXON_BIN_MAGIC)
+	return clicon_msg_decode_bin(msg, yspec, xml, xerr);
+    clixon_debug(CLIXON_DBG_MSG, 1, "%s %s", __FUNCTION__, xmlstr);
     if ((ret = clixon_xml_parse_string(xmlstr, yspec?YB_RPC:YB_NONE, yspec, xml, xerr)) < 0)
 	goto done;
     if (ret == 0)
@@ -288,6 +425,60 @@ atomicio(ssize_t (*fn) (int, void *, size_t),
     return (pos);
 }
 
+/*! Ensure all of a vector of buffers is written, as atomicio but with writev
+ * @param[in]  fd      File descriptor, eg socket
+ * @param[in]  iov     Vector of buffers, modified on partial writes
+ * @param[in]  iovcnt  Length of iov
+ * @retval     n       Number of bytes written
+ * @retval     0       EOF, eg connection reset
+ * @retval    -1       Error
+ * @see atomicio
+ */
+static ssize_t
+atomicio_writev(int           fd,
+		struct iovec *iov,
+		int           iovcnt)
+{
+    ssize_t res;
+    ssize_t pos = 0;
+
+    while (iovcnt > 0){
+	if (iov->iov_len == 0){
+	    iov++;
+	    iovcnt--;
+	    continue;
+	}
+	_atomicio_sig = 0;
+	res = writev(fd, iov, iovcnt);
+	switch (res) {
+	case -1:
+	    if (errno == EINTR){
+		if (!_atomicio_sig)
+		    continue;
+	    }
+	    else if (errno == EAGAIN)
+		continue;
+	    else if (errno == ECONNRESET)/* Connection reset by peer */
+		res = 0;
+	case 0: /* fall thru */
+	    return (res);
+	default:
+	    pos += res;
+	    /* Skip written buffers and advance into partially written */
+	    while (iovcnt > 0 && res >= iov->iov_len){
+		res -= iov->iov_len;
+		iov++;
+		iovcnt--;
+	    }
+	    if (iovcnt > 0){
+		iov->iov_base = (char*)iov->iov_base + res;
+		iov->iov_len -= res;
+	    }
+	}
+    }
+    return (pos);
+}
+
 /*! Print message on debug. Log if syslog, stderr if not
  * @param[in]  msg    CLICON msg
  */
@@ -333,9 +524,9 @@ clicon_msg_send(int                s,
     int retval = -1;
     int e;
 
-    clicon_debug(2, "%s: send msg len=%d", 
+    clixon_debug(CLIXON_DBG_MSG, 2, "%s: send msg len=%d", 
 		 __FUNCTION__, ntohl(msg->op_len));
-    if (clicon_debug_get() > 2)
+    if (clixon_debug_enabled(CLIXON_DBG_MSG, 3))
 	msg_dump(msg);
     if (atomicio((ssize_t (*)(int, void *, size_t))write, 
 		 s, msg, ntohl(msg->op_len)) < 0){
@@ -350,6 +541,69 @@ clicon_msg_send(int                s,
     return retval;
 }
 
+/*! Send a CLICON netconf message from a cbuf without copying it
+ *
+ * Same as clicon_msg_send() of clicon_msg_encode(id, "%s", cbuf_get(cb)), but the
+ * header and the cbuf are written with one writev(), without an intermediate message
+ * @param[in]   s      Socket (unix or inet) to communicate with backend
+ * @param[in]   id     Session id of client
+ * @param[in]   cb     Message body, eg <rpc>, not changed
+ * @retval      0      OK
+ * @retval     -1      Error
+ * @see clicon_msg_encode  for trace-id insertion
+ */
+int
+clicon_msg_send_cbuf(int       s,
+		     uint32_t  id,
+		     cbuf     *cb)
+{
+    int               retval = -1;
+    struct clicon_msg hdr;
+    struct iovec      iov[4];
+    int               iovcnt = 0;
+    char              trace[32] = {0,}; /* trace-id attribute */
+    char             *body;
+    size_t            blen;
+    size_t            tlen;
+    size_t            len;
+
+    body = cbuf_get(cb);
+    blen = cbuf_len(cb) + 1; /* Include terminating NULL */
+    if ((tlen = msg_trace_attr(trace, sizeof(trace))) != 0 && !msg_is_rpc(body))
+	tlen = 0;
+    len = sizeof(hdr) + blen + tlen;
+    if (len > UINT32_MAX){
+	clicon_err(OE_PROTO, EMSGSIZE, "Message too large: %zu bytes", len);
+	goto done;
+    }
+    clixon_debug(CLIXON_DBG_MSG, 2, "%s: send msg len=%zu", __FUNCTION__, len);
+    hdr.op_len = htonl(len);
+    hdr.op_id = htonl(id);
+    iov[iovcnt].iov_base = &hdr;
+    iov[iovcnt++].iov_len = sizeof(hdr);
+    if (tlen){ /* Insert trace-id attribute after "<rpc" */
+	iov[iovcnt].iov_base = body;
+	iov[iovcnt++].iov_len = 4;
+	iov[iovcnt].iov_base = trace;
+	iov[iovcnt++].iov_len = tlen;
+	iov[iovcnt].iov_base = body + 4;
+	iov[iovcnt++].iov_len = blen - 4;
+    }
+    else{
+	iov[iovcnt].iov_base = body;
+	iov[iovcnt++].iov_len = blen;
+    }
+    if (atomicio_writev(s, iov, iovcnt) < 0){
+	clicon_err(OE_CFG, errno, "atomicio");
+	clicon_log(LOG_WARNING, "%s: write: %s len:%zu", __FUNCTION__,
+		   strerror(errno), len);
+	goto done;
+    }
+    retval = 0;
+  done:
+    return retval;
+}
+
 /*! Receive a CLICON message using IPC message struct
  *
  * XXX: timeout? and signals?
@@ -395,7 +649,7 @@ clicon_msg_rcv(int                s,
 	goto done;
     }
     mlen = ntohl(hdr.op_len);
-    clicon_debug(2, "%s: rcv msg len=%d",  
+    clixon_debug(CLIXON_DBG_MSG, 2, "%s: rcv msg len=%d",  
 		 __FUNCTION__, mlen);
     if ((*msg = (struct clicon_msg *)malloc(mlen)) == NULL){
 	clicon_err(OE_CFG, errno, "malloc");
@@ -410,7 +664,7 @@ clicon_msg_rcv(int                s,
 	clicon_err(OE_CFG, errno, "body too short");
 	goto done;
     }
-    if (clicon_debug_get() > 1)
+    if (clixon_debug_enabled(CLIXON_DBG_MSG, 2))
 	msg_dump(*msg);
     retval = 0;
   done:
@@ -419,6 +673,177 @@ clicon_msg_rcv(int                s,
     return retval;
 }
 
+/* Receive buffer of a stream socket, see clicon_msg_rcv_nb */
+struct clicon_msg_rbuf{
+    char   *mr_buf;  /* Received bytes, mr_start..mr_len are not yet consumed */
+    size_t  mr_start;/* Start of first message not consumed */
+    size_t  mr_len;  /* End of received bytes */
+    size_t  mr_max;  /* Allocated length of mr_buf */
+};
+
+/*! Create receive buffer of a stream socket
+ * @retval  mr    Receive buffer, free with clicon_msg_rbuf_free
+ * @retval  NULL  Error
+ * @see clicon_msg_rcv_nb
+ */
+clicon_msg_rbuf *
+clicon_msg_rbuf_new(void)
+{
+    clicon_msg_rbuf *mr;
+
+    if ((mr = malloc(sizeof(*mr))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(mr, 0, sizeof(*mr));
+    return mr;
+}
+
+/*! Free receive buffer of a stream socket
+ * @param[in]  mr  Receive buffer
+ */
+int
+clicon_msg_rbuf_free(clicon_msg_rbuf *mr)
+{
+    if (mr->mr_buf)
+	free(mr->mr_buf);
+    free(mr);
+    return 0;
+}
+
+/*! Get next complete message from a receive buffer, if any
+ * @param[in]  mr    Receive buffer
+ * @param[out] msg   Message if retval is 1. Free with free()
+ * @retval     1     Message returned
+ * @retval     0     No complete message in buffer
+ * @retval    -1     Error, eg malformed header
+ */
+int
+clicon_msg_rbuf_get(clicon_msg_rbuf    *mr,
+		    struct clicon_msg **msg)
+{
+    struct clicon_msg hdr;
+    uint32_t          mlen;
+    size_t            len;
+
+    len = mr->mr_len - mr->mr_start;
+    if (len < sizeof(hdr))
+	return 0;
+    memcpy(&hdr, mr->mr_buf + mr->mr_start, sizeof(hdr));
+    mlen = ntohl(hdr.op_len);
+    if (mlen < sizeof(hdr)){
+	clicon_err(OE_PROTO, EBADMSG, "message length too short (%u)", mlen);
+	return -1;
+    }
+    if (len < mlen)
+	return 0;
+    if ((*msg = (struct clicon_msg *)malloc(mlen)) == NULL){
+	clicon_err(OE_CFG, errno, "malloc");
+	return -1;
+    }
+    memcpy(*msg, mr->mr_buf + mr->mr_start, mlen);
+    mr->mr_start += mlen;
+    if (mr->mr_start == mr->mr_len)
+	mr->mr_start = mr->mr_len = 0;
+    clixon_debug(CLIXON_DBG_MSG, 2, "%s: rcv msg len=%d", __FUNCTION__, mlen);
+    if (clixon_debug_enabled(CLIXON_DBG_MSG, 2))
+	msg_dump(*msg);
+    return 1;
+}
+
+/*! Read the bytes available on a stream socket into its receive buffer
+ *
+ * No message is consumed, get them with clicon_msg_rbuf_get. Use this to keep
+ * reading from a peer whose requests are not handled for the moment, eg to detect
+ * that it closes the socket.
+ * @param[in]   s      Socket, typically non-blocking
+ * @param[in]   mr     Receive buffer of socket, see clicon_msg_rbuf_new
+ * @param[out]  eof    Set if eof encountered
+ * @retval      0      OK, also if no bytes were available
+ * @retval     -1      Error
+ * @note caller must ensure that s is closed if eof is set after call.
+ * @see clicon_msg_rcv_nb
+ */
+int
+clicon_msg_rbuf_read(int              s,
+		     clicon_msg_rbuf *mr,
+		     int             *eof)
+{
+    ssize_t n;
+    size_t  len;
+    char   *buf;
+
+    *eof = 0;
+    /* Move unconsumed bytes first and make room for at least a chunk */
+    len = mr->mr_len - mr->mr_start;
+    if (mr->mr_start){
+	memmove(mr->mr_buf, mr->mr_buf + mr->mr_start, len);
+	mr->mr_start = 0;
+	mr->mr_len = len;
+    }
+    if (mr->mr_max - mr->mr_len < BUFSIZ){
+	if ((buf = realloc(mr->mr_buf, mr->mr_max*2 + BUFSIZ)) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+	mr->mr_buf = buf;
+	mr->mr_max = mr->mr_max*2 + BUFSIZ;
+    }
+    if ((n = read(s, mr->mr_buf + mr->mr_len, mr->mr_max - mr->mr_len)) < 0){
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+	    return 0;
+	if (errno != ECONNRESET){
+	    clicon_err(OE_CFG, errno, "read");
+	    return -1;
+	}
+	n = 0; /* Connection reset by peer, emulate EOF */
+    }
+    if (n == 0){
+	if (mr->mr_len != 0)
+	    clicon_log(LOG_WARNING, "%s: eof in message, %zu bytes ignored",
+		       __FUNCTION__, mr->mr_len);
+	*eof = 1;
+	return 0;
+    }
+    mr->mr_len += n;
+    return 0;
+}
+
+/*! Receive a CLICON message without blocking
+ *
+ * Reads the bytes available on the socket into a receive buffer of the socket and
+ * returns the first complete message, if any. The buffer may contain further received
+ * messages, eg if the peer pipelines requests, get them with clicon_msg_rbuf_get.
+ * Use this instead of clicon_msg_rcv from an event loop, so that a peer stalled in the
+ * middle of a message does not block the reader.
+ * @param[in]   s      Socket, typically non-blocking
+ * @param[in]   mr     Receive buffer of socket, see clicon_msg_rbuf_new
+ * @param[out]  msg    Message if retval is 1. Free with free()
+ * @param[out]  eof    Set if eof encountered
+ * @retval      1      Message returned
+ * @retval      0      No complete message yet, or eof
+ * @retval     -1      Error
+ * @note caller must ensure that s is closed if eof is set after call.
+ * @see clicon_msg_rcv  blocking variant
+ */
+int
+clicon_msg_rcv_nb(int                 s,
+		  clicon_msg_rbuf    *mr,
+		  struct clicon_msg **msg,
+		  int                *eof)
+{
+    int retval;
+
+    *eof = 0;
+    if ((retval = clicon_msg_rbuf_get(mr, msg)) != 0)
+	return retval;
+    if (clicon_msg_rbuf_read(s, mr, eof) < 0)
+	return -1;
+    if (*eof)
+	return 0;
+    return clicon_msg_rbuf_get(mr, msg);
+}
+
 /*! Receive a message using plain ascii 
  * @param[in]   s      socket (unix or inet) to communicate with backend
  * @param[out]  cb1    cligen buf struct containing the incoming message
@@ -431,10 +856,10 @@ clicon_msg_rcv1(int   s,
 		int  *eof)
 {
     int           retval = -1;
-    unsigned char buf[BUFSIZ];
-    int           i;
+    char          buf[BUFSIZ];
     int           len;
-    int           xml_state = 0;
+    size_t        used;
+    int           ret;
     int           poll;
 
     clicon_debug(1, "%s", __FUNCTION__);
@@ -454,19 +879,10 @@ clicon_msg_rcv1(int   s,
            close(s);
            goto ok;
        }
-       for (i=0; i<len; i++){
-           if (buf[i] == 0)
-               continue; /* Skip NULL chars (eg from terminals) */
-           cprintf(cb, "%c", buf[i]);
-           if (detect_endtag("]]>]]>",
-                             buf[i],
-                             &xml_state)) {
-               /* OK, we have an xml string from a client */
-               /* Remove trailer */
-               *(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-               goto ok;
-           }
-       }
+       if ((ret = detect_endtag_buf("]]>]]>", cb, buf, len, &used)) < 0)
+           goto done;
+       if (ret == 1) /* OK, we have an xml string from a client */
+           goto ok;
        /* poll==1 if more, poll==0 if none */
        if ((poll = clixon_event_poll(s)) < 0)
            goto done;
@@ -638,6 +1054,146 @@ clicon_rpc(int                sock,
     return retval;
 }
 
+/*! Send a message from a cbuf on a socket and wait for result
+ * Same as clicon_rpc() but the message is not encoded in a separate buffer
+ * @param[in]  sock    Socket / file descriptor
+ * @param[in]  id      Session id of client
+ * @param[in]  cb      Message body, eg <rpc>
+ * @param[out] ret     Returned data as string. Free with free()
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see clicon_msg_send_cbuf
+ */
+int
+clicon_rpc_cbuf(int       sock,
+		uint32_t  id,
+		cbuf     *cb,
+		char    **ret)
+{
+    int                retval = -1;
+    struct clicon_msg *reply = NULL;
+    int                eof;
+    char              *data = NULL;
+
+    if (clicon_msg_send_cbuf(sock, id, cb) < 0)
+	goto done;
+    if (clicon_msg_rcv(sock, &reply, &eof) < 0)
+	goto done;
+    if (eof){
+	clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+	close(sock); /* assume socket */
+	errno = ESHUTDOWN;
+	goto done;
+    }
+    data = reply->op_body; /* assume string */
+    if (ret && data)
+	if ((*ret = strdup(data)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+    retval = 0;
+  done:
+    if (reply)
+	free(reply);
+    return retval;
+}
+
+/*! Send several clicon_msg messages on a socket and wait for all results
+ *
+ * The requests are pipelined: they are sent without waiting for earlier replies, and
+ * the replies are read while sending, so that neither side blocks on a full socket
+ * buffer. The backend handles the requests of a session in order, so the replies are
+ * correlated with the requests by order: a request is not handled until the reply of
+ * the previous request is sent, also if the reply is sent later, eg by a read worker,
+ * a coalesced commit or an asynchronous rpc, since the client is suspended until then.
+ * Message-ids are therefore not needed, and internal rpc replies do not carry them.
+ * The session should not have a notification subscription, as for clicon_rpc.
+ * @param[in]  sock    Socket / file descriptor
+ * @param[in]  msgv    Vector of messages
+ * @param[in]  len     Length of msgv
+ * @param[out] retv    Vector of len returned data strings, free each with free()
+ * @retval     0       OK
+ * @retval    -1       Error, strings already returned in retv must be freed
+ * @see clicon_rpc  for a single request
+ */
+int
+clicon_rpc_vec(int                 sock,
+	       struct clicon_msg **msgv,
+	       int                 len,
+	       char              **retv)
+{
+    int                retval = -1;
+    clicon_msg_rbuf   *mr = NULL;
+    struct clicon_msg *reply = NULL;
+    struct pollfd      pfd;
+    int                sent = 0;  /* Requests sent */
+    size_t             off = 0;   /* Bytes sent of request sent */
+    int                rcvd = 0;  /* Replies received */
+    uint32_t           mlen;
+    ssize_t            n;
+    int                eof;
+    int                ret;
+    int                i;
+
+    for (i=0; i<len; i++)
+	retv[i] = NULL;
+    if ((mr = clicon_msg_rbuf_new()) == NULL)
+	goto done;
+    while (rcvd < len){
+	pfd.fd = sock;
+	pfd.events = POLLIN | (sent<len?POLLOUT:0);
+	pfd.revents = 0;
+	if (poll(&pfd, 1, -1) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "poll");
+	    goto done;
+	}
+	if (sent < len && (pfd.revents & POLLOUT)){
+	    mlen = ntohl(msgv[sent]->op_len);
+	    if ((n = send(sock, (char*)msgv[sent] + off, mlen - off, MSG_DONTWAIT)) < 0){
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR){
+		    clicon_err(OE_CFG, errno, "send");
+		    goto done;
+		}
+	    }
+	    else if ((off += n) == mlen){
+		sent++;
+		off = 0;
+	    }
+	}
+	if ((pfd.revents & (POLLIN|POLLHUP|POLLERR)) == 0)
+	    continue;
+	/* Read once, then get all buffered replies */
+	if ((ret = clicon_msg_rcv_nb(sock, mr, &reply, &eof)) < 0)
+	    goto done;
+	if (eof){
+	    clicon_err(OE_PROTO, ESHUTDOWN, "Unexpected close of CLICON_SOCK. Clixon backend daemon may have crashed.");
+	    close(sock); /* assume socket */
+	    errno = ESHUTDOWN;
+	    goto done;
+	}
+	while (ret == 1){
+	    if (rcvd < len &&
+		(retv[rcvd++] = strdup(reply->op_body)) == NULL){ /* assume string */
+		clicon_err(OE_UNIX, errno, "strdup");
+		goto done;
+	    }
+	    free(reply);
+	    reply = NULL;
+	    if ((ret = clicon_msg_rbuf_get(mr, &reply)) < 0)
+		goto done;
+	}
+    }
+    retval = 0;
+  done:
+    if (reply)
+	free(reply);
+    if (mr)
+	clicon_msg_rbuf_free(mr);
+    return retval;
+}
+
 /*! Send a netconf message and recevive result.
  *
  * TBD: timeout, interrupt?
@@ -679,6 +1235,7 @@ clicon_rpc1(int   sock,
 
 /*! Send a clicon_msg message as reply to a clicon rpc request
  *
+ * The header and data are written with one writev(), data is not copied
  * @param[in]  s       Socket to communicate with client
  * @param[in]  data    Returned data as byte-string.
  * @param[in]  datalen Length of returned data XXX  may be unecessary if always string?
@@ -690,23 +1247,203 @@ send_msg_reply(int      s,
 	       char    *data, 
 	       uint32_t datalen)
 {
-    int                retval = -1;
-    struct clicon_msg *reply = NULL;
-    uint32_t           len;
+    int               retval = -1;
+    struct clicon_msg hdr;
+    struct iovec      iov[2];
+    size_t            len;
 
-    len = sizeof(*reply) + datalen;
-    if ((reply = (struct clicon_msg *)malloc(len)) == NULL)
+    len = sizeof(hdr) + datalen;
+    if (len > UINT32_MAX){
+	clicon_err(OE_PROTO, EMSGSIZE, "Reply too large: %zu bytes", len);
 	goto done;
-    memset(reply, 0, len);
-    reply->op_len = htonl(len);
-    if (datalen > 0)
-      memcpy(reply->op_body, data, datalen);
-    if (clicon_msg_send(s, reply) < 0)
+    }
+    clixon_debug(CLIXON_DBG_MSG, 2, "%s: send msg len=%zu", __FUNCTION__, len);
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.op_len = htonl(len);
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = data;
+    iov[1].iov_len = datalen;
+    if (atomicio_writev(s, iov, 2) < 0){
+	clicon_err(OE_CFG, errno, "atomicio");
+	clicon_log(LOG_WARNING, "%s: write: %s len:%zu", __FUNCTION__,
+		   strerror(errno), len);
 	goto done;
+    }
     retval = 0;
   done:
-    if (reply)
-	free(reply);
+    return retval;
+}
+
+/* Argument to chunk callback of send_msg_reply_xml */
+struct msg_chunk{
+    int      mc_s;   /* Socket to write chunks to */
+    size_t   mc_len; /* Accumulated length of written chunks */
+};
+
+/*! Chunk callback of send_msg_reply_xml, write chunk to socket
+ * @see clicon_xml_chunk_cb
+ */
+static int
+msg_chunk_cb(void  *arg,
+	     char  *buf,
+	     size_t len)
+{
+    int               retval = -1;
+    struct msg_chunk *mc = (struct msg_chunk *)arg;
+
+    if (atomicio((ssize_t (*)(int, void *, size_t))write, mc->mc_s, buf, len) < 0){
+	clicon_err(OE_CFG, errno, "atomicio");
+	goto done;
+    }
+    mc->mc_len += len;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send an XML tree as reply to a clicon rpc request in bounded chunks
+ *
+ * The reply is the same as send_msg_reply() of the string <head><x><tail>, but the XML
+ * tree is serialized and written to the socket in chunks, so that the whole reply is
+ * never built in memory. 
+ * The message header needs the length of the serialized tree, which is computed by
+ * the caller in a first pass using clicon_xml2len().
+ * Writes are blocking, the socket buffer provides backpressure to the writer.
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  head    String to send before the XML tree, eg "<rpc-reply>"
+ * @param[in]  x       XML tree
+ * @param[in]  depth   Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]  xlen    Length of serialized XML tree, see clicon_xml2len
+ * @param[in]  tail    String to send after the XML tree, eg "</rpc-reply>"
+ * @param[in]  chunk   Chunk size in bytes
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see send_msg_reply
+ */
+int
+send_msg_reply_xml(int     s,
+		   char   *head,
+		   cxobj  *x,
+		   int32_t depth,
+		   size_t  xlen,
+		   char   *tail,
+		   size_t  chunk)
+{
+    int               retval = -1;
+    struct clicon_msg hdr;
+    struct msg_chunk  mc = {s, 0};
+    size_t            len;
+
+    len = sizeof(hdr) + strlen(head) + xlen + strlen(tail) + 1;
+    if (len > UINT32_MAX){
+	clicon_err(OE_PROTO, EMSGSIZE, "Reply too large: %zu bytes", len);
+	goto done;
+    }
+    clixon_debug(CLIXON_DBG_MSG, 2, "%s: send msg len=%zu", __FUNCTION__, len);
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.op_len = htonl(len);
+    if (msg_chunk_cb(&mc, (char*)&hdr, sizeof(hdr)) < 0)
+	goto done;
+    if (msg_chunk_cb(&mc, head, strlen(head)) < 0)
+	goto done;
+    if (clicon_xml2chunk(x, depth, chunk, msg_chunk_cb, &mc) < 0)
+	goto done;
+    /* Include terminating NULL as send_msg_reply */
+    if (msg_chunk_cb(&mc, tail, strlen(tail)+1) < 0)
+	goto done;
+    if (mc.mc_len != len){ /* Length was wrong, stream is out of sync */
+	clicon_err(OE_PROTO, EINVAL, "Reply length mismatch: %zu != %zu", mc.mc_len, len);
+	goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Send part of a file as reply to a clicon rpc request, without reading it to memory
+ *
+ * The reply is the same as send_msg_reply() of the string <head><content><tail>, where
+ * content is len bytes of the file from offset. The content is copied from the file
+ * to the socket by the kernel with sendfile() if available.
+ * @param[in]  s       Socket to communicate with client
+ * @param[in]  head    String to send before the file content, eg "<rpc-reply>"
+ * @param[in]  fd      Open file
+ * @param[in]  offset  Offset of content in file
+ * @param[in]  len     Length of content
+ * @param[in]  tail    String to send after the file content, eg "</rpc-reply>"
+ * @retval     0       OK
+ * @retval     -1      Error
+ * @see send_msg_reply_xml
+ */
+int
+send_msg_reply_file(int    s,
+		    char  *head,
+		    int    fd,
+		    off_t  offset,
+		    size_t len,
+		    char  *tail)
+{
+    int               retval = -1;
+    struct clicon_msg hdr;
+    struct iovec      iov[2];
+    size_t            mlen;
+    ssize_t           n;
+#ifndef HAVE_SENDFILE
+    char              buf[8192];
+#endif
+
+    mlen = sizeof(hdr) + strlen(head) + len + strlen(tail) + 1;
+    if (mlen > UINT32_MAX){
+	clicon_err(OE_PROTO, EMSGSIZE, "Reply too large: %zu bytes", mlen);
+	goto done;
+    }
+    clixon_debug(CLIXON_DBG_MSG, 2, "%s: send msg len=%zu", __FUNCTION__, mlen);
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.op_len = htonl(mlen);
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = head;
+    iov[1].iov_len = strlen(head);
+    if (atomicio_writev(s, iov, 2) < 0){
+	clicon_err(OE_CFG, errno, "atomicio");
+	goto done;
+    }
+    while (len > 0){
+#ifdef HAVE_SENDFILE
+	if ((n = sendfile(s, fd, &offset, len)) < 0){
+	    if (errno == EINTR || errno == EAGAIN)
+		continue;
+	    clicon_err(OE_UNIX, errno, "sendfile");
+	    goto done;
+	}
+#else
+	if ((n = pread(fd, buf, len<sizeof(buf)?len:sizeof(buf), offset)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "pread");
+	    goto done;
+	}
+	if (n > 0 &&
+	    atomicio((ssize_t (*)(int, void *, size_t))write, s, buf, n) < 0){
+	    clicon_err(OE_CFG, errno, "atomicio");
+	    goto done;
+	}
+	offset += n;
+#endif
+	if (n == 0){ /* File truncated, stream is out of sync */
+	    clicon_err(OE_PROTO, EIO, "Reply file shorter than %zu bytes", len);
+	    goto done;
+	}
+	len -= n;
+    }
+    /* Include terminating NULL as send_msg_reply */
+    if (atomicio((ssize_t (*)(int, void *, size_t))write, s, tail, strlen(tail)+1) < 0){
+	clicon_err(OE_CFG, errno, "atomicio");
+	goto done;
+    }
+    retval = 0;
+ done:
     return retval;
 }
 
@@ -739,21 +1476,33 @@ send_msg_notify(int           s,
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
  *
+ * If the event is being notified to stream subscriptions, the message encoded once for
+ * all subscriptions is sent
  * @param[in]  h       Clicon handle
  * @param[in]  s       Socket to communicate with client
  * @param[in]  xev     Event as XML
  * @retval     0       OK
  * @retval     -1      Error
  * @see send_msg_notify XXX beauty contest
+ * @see stream_event_get
  */
 int
 send_msg_notify_xml(clicon_handle h,
 		    int           s, 
 		    cxobj        *xev)
 {
-    int                retval = -1;
-    cbuf              *cb = NULL;
+    int                  retval = -1;
+    cbuf                *cb = NULL;
+    struct stream_event *se;
+    struct clicon_msg   *msg;
 
+    if ((se = stream_event_get(xev)) != NULL){
+	if ((msg = stream_event_msg(se, FORMAT_XML)) == NULL)
+	    goto done;
+	if (clicon_msg_send(s, msg) < 0)
+	    goto done;
+	goto ok;
+    }
     if ((cb = cbuf_new()) == NULL){
 	clicon_err(OE_PLUGIN, errno, "cbuf_new");
 	goto done;
@@ -762,6 +1511,7 @@ send_msg_notify_xml(clicon_handle h,
 	goto done;
     if (send_msg_notify(s, cbuf_get(cb)) < 0)
 	goto done;
+ ok:
     retval = 0;
   done:
     if (cb)
@@ -794,3 +1544,65 @@ detect_endtag(char *tag,
 	*state = 0;
     return retval;
 }
+
+/*! Look for a text pattern in an input buffer, a block at a time
+ *
+ * Append input to a buffer until the pattern is found. The pattern may start in earlier
+ * input already in the buffer. NULL chars in the input are skipped (eg from terminals).
+ * @param[in]  tag     What to look for, eg "]]>]]>"
+ * @param[in]  cb      Buffer where input is appended
+ * @param[in]  buf     New input
+ * @param[in]  len     Length of new input
+ * @param[out] used    Number of bytes of input consumed, including the pattern
+ * @retval     1       Yes, we have detected end tag. It is removed from cb.
+ *                     Input after used is not consumed
+ * @retval     0       No, we havent detected end tag, all input is appended to cb
+ * @retval    -1       Error
+ * @see detect_endtag  One char at a time
+ */
+int
+detect_endtag_buf(char   *tag,
+		  cbuf   *cb,
+		  char   *buf,
+		  size_t  len,
+		  size_t *used)
+{
+    size_t taglen = strlen(tag);
+    char  *p = buf;
+    char  *end = buf + len;
+    char  *q;
+    char  *s;
+    char  *f;
+    size_t oldlen;
+    size_t start;
+
+    while (p < end){
+	if (*p == '\0'){ /* Skip NULL chars */
+	    p++;
+	    continue;
+	}
+	if ((q = memchr(p, '\0', end-p)) == NULL)
+	    q = end;
+	oldlen = cbuf_len(cb);
+	if (cbuf_append_buf(cb, p, q-p) < 0){
+	    clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+	    return -1;
+	}
+	/* Search from where the tag may start in earlier input */
+	start = oldlen >= taglen ? oldlen - taglen + 1 : 0;
+	s = cbuf_get(cb) + start;
+	while ((f = memchr(s, tag[0], cbuf_get(cb) + cbuf_len(cb) - s)) != NULL &&
+	       f + taglen <= cbuf_get(cb) + cbuf_len(cb)){
+	    if (memcmp(f, tag, taglen) == 0){
+		p += f + taglen - cbuf_get(cb) - oldlen;
+		*f = '\0'; /* Remove trailer */
+		*used = p - buf;
+		return 1;
+	    }
+	    s = f + 1;
+	}
+	p = q;
+    }
+    *used = len;
+    return 0;
+}
@@ -51,8 +51,11 @@
 #include <unistd.h>
 #include <sys/param.h>
 #include <sys/stat.h>
+#include <time.h>
+#include <sys/time.h>
 #include <sys/socket.h>
 #include <sys/syslog.h>
+#include <poll.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -62,6 +65,7 @@
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_log.h"
+#include "clixon_trace.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
 #include "clixon_options.h"
@@ -82,6 +86,88 @@
 #include "clixon_netconf_lib.h"
 #include "clixon_proto_client.h"
 
+/* Backend session of one user, see clicon_rpc_session_select */
+struct rpc_session{
+    qelem_t   rs_q;        /* LRU list, most recently used first */
+    char     *rs_username; /* User of session */
+    int       rs_s;        /* Cached socket, or -1 */
+    uint32_t  rs_id;       /* Session-id if rs_idset */
+    int       rs_idset;    /* Hello made, session-id is set */
+};
+
+static struct rpc_session *_rpc_sessions = NULL;    /* LRU list of sessions */
+static struct rpc_session *_rpc_session_cur = NULL; /* Session in handle */
+static int                 _rpc_sessions_len = 0;
+
+/* Accumulated time of rpcs to the backend, see clicon_rpc_timing_enable 
+ * Kept in the clicon data hash as "rpc-timing"
+ */
+struct rpc_timing{
+    uint32_t       rt_nr;   /* Nr of rpcs */
+    struct timeval rt_time; /* Time from send until reply is parsed */
+};
+
+/*! Enable accounting of time spent in rpcs to the backend
+ * @param[in]  h     CLICON handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see clicon_rpc_timing_get
+ */
+int
+clicon_rpc_timing_enable(clicon_handle h)
+{
+    struct rpc_timing rt = {0,};
+
+    if (clicon_hash_value(clicon_data(h), "rpc-timing", NULL) != NULL)
+	return 0;
+    if (clicon_hash_add(clicon_data(h), "rpc-timing", &rt, sizeof(rt)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Get accumulated time spent in rpcs to the backend
+ * @param[in]  h     CLICON handle
+ * @param[out] nr    Nr of rpcs since enabled
+ * @param[out] tv    Accumulated time of the rpcs
+ * @retval     1     OK
+ * @retval     0     Not enabled
+ * @see clicon_rpc_timing_enable
+ */
+int
+clicon_rpc_timing_get(clicon_handle   h,
+		      uint32_t       *nr,
+		      struct timeval *tv)
+{
+    struct rpc_timing *rt;
+
+    if ((rt = clicon_hash_value(clicon_data(h), "rpc-timing", NULL)) == NULL)
+	return 0;
+    *nr = rt->rt_nr;
+    *tv = rt->rt_time;
+    return 1;
+}
+
+/*! Add the time of rpcs to the accumulated time, if enabled
+ * @param[in]  h     CLICON handle
+ * @param[in]  t0    Start time of rpcs
+ * @param[in]  nr    Nr of rpcs
+ */
+static void
+rpc_timing_add(clicon_handle   h,
+	       struct timeval *t0,
+	       int             nr)
+{
+    struct rpc_timing *rt;
+    struct timeval     t;
+
+    if ((rt = clicon_hash_value(clicon_data(h), "rpc-timing", NULL)) == NULL)
+	return;
+    gettimeofday(&t, NULL);
+    timersub(&t, t0, &t);
+    timeradd(&rt->rt_time, &t, &rt->rt_time);
+    rt->rt_nr += nr;
+}
+
 /*! Connect to internal netconf socket
  */
 int
@@ -126,7 +212,133 @@ clicon_rpc_connect(clicon_handle h,
  done:
     return retval;
 }
+
+/*! Get the cached socket to the backend, check it and reconnect if needed
+ *
+ * No data is expected on the cached socket between rpcs, so if it is readable, the
+ * backend has closed it, eg on backend restart or close-session. Then a new socket
+ * is connected, instead of failing the next rpc.
+ * @param[in]  h     CLICON handle
+ * @param[out] sock  Socket to backend, cached in the handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+clicon_rpc_socket(clicon_handle h,
+		  int          *sock)
+{
+    int           s;
+    struct pollfd pfd;
+    int           ret;
+
+    if ((s = clicon_client_socket_get(h)) >= 0){
+	pfd.fd = s;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if ((ret = poll(&pfd, 1, 0)) < 0){
+	    clicon_err(OE_UNIX, errno, "poll");
+	    return -1;
+	}
+	if (ret == 0){ /* Nothing to read: socket is alive */
+	    *sock = s;
+	    return 0;
+	}
+	clicon_debug(1, "%s socket %d closed by backend, reconnect", __FUNCTION__, s);
+	close(s);
+	clicon_client_socket_set(h, -1);
+    }
+    if (clicon_rpc_connect(h, &s) < 0)
+	return -1;
+    clicon_client_socket_set(h, s);
+    *sock = s;
+    return 0;
+}
     
+/*! Send internal netconf rpc from client to backend and get the reply as a string
+ * @param[in]    h        CLICON handle
+ * @param[in]    msg      Encoded message. Deallocate with free
+ * @param[out]   retdata  Reply from backend as string, not parsed. Free with free
+ * @retval       0        OK
+ * @retval      -1        Error
+ * @note side-effect, a socket created here is cached, and reconnected if closed by
+ *       the backend, see clicon_rpc_socket
+ * @see clicon_rpc_msg  Reply as xml tree
+ */
+int
+clicon_rpc_msg_str(clicon_handle      h, 
+		   struct clicon_msg *msg, 
+		   char             **retdata)
+{
+    int     retval = -1;
+    int     s = -1;
+    struct timeval t0;
+    struct timespec ts;
+
+#ifdef RPC_USERNAME_ASSERT
+    assert(strstr(msg->op_body, "username")!=NULL); /* XXX */
+#endif
+    clixon_debug(CLIXON_DBG_MSG, 1, "%s request:%s", __FUNCTION__, msg->op_body);
+    gettimeofday(&t0, NULL);
+    clixon_trace_start(&ts);
+    /* Create a socket and connect to it, either UNIX, IPv4 or IPv6 per config options */
+    if (clicon_rpc_socket(h, &s) < 0)
+	goto done;
+    if (clicon_rpc(s, msg, retdata) < 0)
+	goto done;
+    clixon_debug(CLIXON_DBG_MSG, 1, "%s retdata:%s", __FUNCTION__, *retdata);
+    rpc_timing_add(h, &t0, 1);
+    clixon_trace_end(&ts, "rpc", NULL);
+    retval = 0;
+ done:
+    if (retval < 0 && s >= 0){
+	close(s);
+	clicon_client_socket_set(h, -1);
+    }
+    return retval;
+}
+
+/*! Send internal netconf rpc from a cbuf to backend and get the reply as a string
+ *
+ * Same as clicon_rpc_msg_str() of clicon_msg_encode(id, "%s", cbuf_get(cb)), but the
+ * cbuf is sent as is, without encoding a copy of it
+ * @param[in]    h        CLICON handle
+ * @param[in]    id       Session id
+ * @param[in]    cb       Message body, eg <rpc>
+ * @param[out]   retdata  Reply from backend as string, not parsed. Free with free
+ * @retval       0        OK
+ * @retval      -1        Error
+ * @see clicon_rpc_msg_str
+ */
+int
+clicon_rpc_cbuf_str(clicon_handle h, 
+		    uint32_t      id,
+		    cbuf         *cb,
+		    char        **retdata)
+{
+    int     retval = -1;
+    int     s = -1;
+    struct timeval t0;
+    struct timespec ts;
+
+    clixon_debug(CLIXON_DBG_MSG, 1, "%s request:%s", __FUNCTION__, cbuf_get(cb));
+    gettimeofday(&t0, NULL);
+    clixon_trace_start(&ts);
+    if (clicon_rpc_socket(h, &s) < 0)
+	goto done;
+    if (clicon_rpc_cbuf(s, id, cb, retdata) < 0)
+	goto done;
+    clixon_debug(CLIXON_DBG_MSG, 1, "%s retdata:%s", __FUNCTION__, *retdata);
+    rpc_timing_add(h, &t0, 1);
+    clixon_trace_end(&ts, "rpc", NULL);
+    retval = 0;
+ done:
+    if (retval < 0 && s >= 0){
+	close(s);
+	clicon_client_socket_set(h, -1);
+    }
+    return retval;
+}
+
 /*! Send internal netconf rpc from client to backend
  * @param[in]    h      CLICON handle
  * @param[in]    msg    Encoded message. Deallocate with free
@@ -144,23 +356,9 @@ clicon_rpc_msg(clicon_handle      h,
     int     retval = -1;
     char   *retdata = NULL;
     cxobj  *xret = NULL;
-    int     s = -1;
 
-#ifdef RPC_USERNAME_ASSERT
-    assert(strstr(msg->op_body, "username")!=NULL); /* XXX */
-#endif
-    clicon_debug(1, "%s request:%s", __FUNCTION__, msg->op_body);
-    /* Create a socket and connect to it, either UNIX, IPv4 or IPv6 per config options */
-    if ((s = clicon_client_socket_get(h)) < 0){
-	if (clicon_rpc_connect(h, &s) < 0)
-	    goto done;
-	clicon_client_socket_set(h, s);
-    }
-    if (clicon_rpc(s, msg, &retdata) < 0)
+    if (clicon_rpc_msg_str(h, msg, &retdata) < 0)
 	goto done;
-
-    clicon_debug(1, "%s retdata:%s", __FUNCTION__, retdata);
-
     if (retdata){
 	/* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
 	 * to reply.
@@ -174,10 +372,6 @@ clicon_rpc_msg(clicon_handle      h,
     }
     retval = 0;
  done:
-    if (retval < 0 && s >= 0){
-	close(s);
-	clicon_client_socket_set(h, -1);
-    }
     if (retdata)
 	free(retdata);
     if (xret)
@@ -185,6 +379,72 @@ clicon_rpc_msg(clicon_handle      h,
     return retval;
 }
 
+/*! Send several internal netconf rpcs from client to backend pipelined on one session
+ *
+ * All requests are sent without waiting for the replies of earlier requests, which
+ * saves a round-trip per request, eg for a batch of get requests
+ * @param[in]    h      CLICON handle
+ * @param[in]    msgv   Vector of encoded messages. Deallocate with free
+ * @param[in]    len    Length of msgv
+ * @param[out]   xretv  Vector of len return values from backend as xml trees, in order
+ *                      of requests. Free each with xml_free
+ * @retval       0      OK
+ * @retval      -1      Error, no trees returned
+ * @note side-effect, a socket created here is cached
+ * @see clicon_rpc_msg  for a single rpc
+ */
+int
+clicon_rpc_msg_vec(clicon_handle       h, 
+		   struct clicon_msg **msgv,
+		   int                 len,
+		   cxobj             **xretv)
+{
+    int     retval = -1;
+    char  **retv = NULL;
+    int     s = -1;
+    int     i;
+    struct timeval t0;
+
+    gettimeofday(&t0, NULL);
+    for (i=0; i<len; i++)
+	xretv[i] = NULL;
+    if ((retv = calloc(len, sizeof(char*))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    if (clicon_rpc_socket(h, &s) < 0)
+	goto done;
+    if (clicon_rpc_vec(s, msgv, len, retv) < 0)
+	goto done;
+    for (i=0; i<len; i++){
+	clicon_debug(1, "%s retdata:%s", __FUNCTION__, retv[i]);
+	if (retv[i] &&
+	    clixon_xml_parse_string(retv[i], YB_NONE, NULL, &xretv[i], NULL) < 0)
+	    goto done;
+    }
+    rpc_timing_add(h, &t0, len);
+    retval = 0;
+ done:
+    if (retval < 0){
+	if (s >= 0){
+	    close(s);
+	    clicon_client_socket_set(h, -1);
+	}
+	for (i=0; i<len; i++)
+	    if (xretv[i]){
+		xml_free(xretv[i]);
+		xretv[i] = NULL;
+	    }
+    }
+    if (retv){
+	for (i=0; i<len; i++)
+	    if (retv[i])
+		free(retv[i]);
+	free(retv);
+    }
+    return retval;
+}
+
 /*! Send internal netconf rpc from client to backend and return a persistent socket
  * @param[in]   h      CLICON handle
  * @param[in]   msg    Encoded message. Deallocate with free
@@ -203,6 +463,7 @@ clicon_rpc_msg_persistent(clicon_handle      h,
     char   *retdata = NULL;
     cxobj  *xret = NULL;
     int     s = -1;
+    struct timespec ts;
 
     if (sock0 == NULL){
 	clicon_err(OE_NETCONF, EINVAL, "Missing socket pointer");
@@ -211,14 +472,15 @@ clicon_rpc_msg_persistent(clicon_handle      h,
 #ifdef RPC_USERNAME_ASSERT
     assert(strstr(msg->op_body, "username")!=NULL); /* XXX */
 #endif
-    clicon_debug(1, "%s request:%s", __FUNCTION__, msg->op_body);
+    clixon_debug(CLIXON_DBG_MSG, 1, "%s request:%s", __FUNCTION__, msg->op_body);
+    clixon_trace_start(&ts);
     /* Create a socket and connect to it, either UNIX, IPv4 or IPv6 per config options */
     if (clicon_rpc_connect(h, &s) < 0)
 	goto done;
     if (clicon_rpc(s, msg, &retdata) < 0)
 	goto done;
-
-    clicon_debug(1, "%s retdata:%s", __FUNCTION__, retdata);
+    clixon_trace_end(&ts, "rpc", NULL);
+    clixon_debug(CLIXON_DBG_MSG, 1, "%s retdata:%s", __FUNCTION__, retdata);
 
     if (retdata){
 	/* Cannot populate xret here because need to know RPC name (eg "lock") in order to associate yang
@@ -341,14 +603,17 @@ clicon_rpc_netconf_xml(clicon_handle  h,
 		       cxobj        **xret,
 		       int           *sp)
 {
-    int        retval = -1;
-    cbuf      *cb = NULL;
-    cxobj     *xname;
-    char      *rpcname;
-    cxobj     *xreply;
-    yang_stmt *yspec;
-    cxobj     *xerr = NULL;
-    int        ret;
+    int                retval = -1;
+    cbuf              *cb = NULL;
+    cxobj             *xname;
+    char              *rpcname;
+    cxobj             *xreply;
+    yang_stmt         *yspec;
+    cxobj             *xerr = NULL;
+    int                ret;
+    uint32_t           session_id;
+    struct clicon_msg *msg = NULL;
+    char              *retdata = NULL;
 
     if ((cb = cbuf_new()) == NULL){
 	clicon_err(OE_XML, errno, "cbuf_new");
@@ -359,10 +624,35 @@ clicon_rpc_netconf_xml(clicon_handle  h,
 	goto done;
     }
     rpcname = xml_name(xname); /* Store rpc name and use in yang binding after reply */
-    if (clicon_xml2cbuf(cb, xml, 0, 0, -1) < 0)
-	goto done;
-    if (clicon_rpc_netconf(h, cbuf_get(cb), xret, sp) < 0)
+    if (session_id_check(h, &session_id) < 0)
 	goto done;
+    /* Binary encoding accepted by backend in hello, see clicon_hello_req */
+    if (clicon_data_get(h, "proto-binary", NULL) == 0){
+	if ((msg = clicon_msg_encode_bin(session_id, xml)) == NULL)
+	    goto done;
+	if (sp){
+	    if (clicon_rpc_msg_persistent(h, msg, xret, sp) < 0)
+		goto done;
+	}
+	else
+	    if (clicon_rpc_msg(h, msg, xret) < 0)
+		goto done;
+    }
+    else {
+	if (clicon_xml2cbuf(cb, xml, 0, 0, -1) < 0)
+	    goto done;
+	if (sp){
+	    if (clicon_rpc_netconf(h, cbuf_get(cb), xret, sp) < 0)
+		goto done;
+	}
+	else{
+	    if (clicon_rpc_cbuf_str(h, session_id, cb, &retdata) < 0)
+		goto done;
+	    if (retdata &&
+		clixon_xml_parse_string(retdata, YB_NONE, NULL, xret, NULL) < 0)
+		goto done;
+	}
+    }
     if ((xreply = xml_find_type(*xret, NULL, "rpc-reply", CX_ELMNT)) != NULL &&
 	xml_find_type(xreply, NULL, "rpc-error", CX_ELMNT) == NULL){
 	yspec = clicon_dbspec_yang(h);
@@ -383,6 +673,10 @@ clicon_rpc_netconf_xml(clicon_handle  h,
     }
     retval = 0;
  done:
+    if (retdata)
+	free(retdata);
+    if (msg)
+	free(msg);
     if (xerr)
 	xml_free(xerr);
     if (cb)
@@ -390,6 +684,55 @@ clicon_rpc_netconf_xml(clicon_handle  h,
     return retval;
 }
 
+/*! Generic xml netconf clicon rpc with the reply as a string
+ *
+ * Same as clicon_rpc_netconf_xml but the reply is neither parsed nor bound to yang,
+ * eg for passing a reply through unchanged
+ * @param[in]  h        clicon handle
+ * @param[in]  xml      XML netconf tree 
+ * @param[out] retdata  Reply from backend as string. Free with free
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see clicon_rpc_netconf_xml  Reply as xml tree
+ */
+int
+clicon_rpc_netconf_xml_str(clicon_handle  h, 
+			   cxobj         *xml,
+			   char         **retdata)
+{
+    int                retval = -1;
+    cbuf              *cb = NULL;
+    uint32_t           session_id;
+    struct clicon_msg *msg = NULL;
+
+    if (session_id_check(h, &session_id) < 0)
+	goto done;
+    /* Binary encoding accepted by backend in hello, see clicon_hello_req */
+    if (clicon_data_get(h, "proto-binary", NULL) == 0){
+	if ((msg = clicon_msg_encode_bin(session_id, xml)) == NULL)
+	    goto done;
+    }
+    else {
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new");
+	    goto done;
+	}
+	if (clicon_xml2cbuf(cb, xml, 0, 0, -1) < 0)
+	    goto done;
+	if (clicon_rpc_cbuf_str(h, session_id, cb, retdata) < 0)
+	    goto done;
+    }
+    if (msg && clicon_rpc_msg_str(h, msg, retdata) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Get database configuration
  * Same as clicon_proto_change just with a cvec instead of lvec
  * @param[in]  h        CLICON handle
@@ -429,6 +772,37 @@ clicon_rpc_get_config(clicon_handle h,
 		      char         *xpath,
 		      cvec         *nsc,
 		      cxobj       **xt)
+{
+    return clicon_rpc_get_config_page(h, username, db, xpath, nsc, 0, 0, xt);
+}
+
+/*! Get a page of database configuration: some of the nodes selected by xpath
+ *
+ * Same as clicon_rpc_get_config but only the nodes selected by xpath with position
+ * offset to offset+limit-1 in document order are returned, with their ancestors.
+ * This is typically used to show a large list in pieces.
+ * @param[in]  h        CLICON handle
+ * @param[in]  username If NULL, use default
+ * @param[in]  db       Name of database
+ * @param[in]  xpath    XPath (or "")
+ * @param[in]  nsc      Namespace context for filter
+ * @param[in]  offset   Number of selected nodes to skip
+ * @param[in]  limit    Max number of selected nodes, 0 means all (no paging)
+ * @param[out] xt       XML tree. Free with xml_free. 
+ *                      Either <config> or <rpc-error>. 
+ * @retval    0         OK
+ * @retval   -1         Error, fatal or xml
+ * @see clicon_rpc_get_config
+ */
+int
+clicon_rpc_get_config_page(clicon_handle h, 
+			   char         *username,
+			   char         *db, 
+			   char         *xpath,
+			   cvec         *nsc,
+			   uint32_t      offset,
+			   uint32_t      limit,
+			   cxobj       **xt)
 {
     int                retval = -1;
     struct clicon_msg *msg = NULL;
@@ -451,7 +825,10 @@ clicon_rpc_get_config(clicon_handle h,
 	cprintf(cb, " username=\"%s\"", username);
     cprintf(cb, " xmlns:%s=\"%s\"",
 	    NETCONF_BASE_PREFIX, NETCONF_BASE_NAMESPACE);
-    cprintf(cb, "><get-config><source><%s/></source>", db);
+    cprintf(cb, "><get-config");
+    if (limit)
+	cprintf(cb, " offset=\"%u\" limit=\"%u\"", offset, limit);
+    cprintf(cb, "><source><%s/></source>", db);
     if (xpath && strlen(xpath)){
 	cprintf(cb, "<%s:filter %s:type=\"xpath\" %s:select=\"%s\"",
 		NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX, NETCONF_BASE_PREFIX,
@@ -474,7 +851,8 @@ clicon_rpc_get_config(clicon_handle h,
     }
     else{
 	yspec = clicon_dbspec_yang(h);
-	if ((ret = xml_bind_yang(xd, YB_MODULE, yspec, &xerr)) < 0)
+	/* Bind on access: callers often only look at part of a large reply */
+	if ((ret = xml_bind_yang_lazy(xd, yspec, &xerr)) < 0)
 	    goto done;
 	if (ret == 0){
 	    if (clixon_netconf_internal_error(xerr,
@@ -505,6 +883,108 @@ clicon_rpc_get_config(clicon_handle h,
     return retval;
 }
 
+/*! Get values of the nodes selected by an xpath in a database, eg for CLI completion
+ *
+ * Only the values are sent from the backend, not the configuration they are part of.
+ * @param[in]  h        CLICON handle
+ * @param[in]  db       Name of database
+ * @param[in]  filter   XPath of configuration to read, if NULL same as xpath
+ * @param[in]  xpath    XPath selecting the nodes whose values are returned
+ * @param[in]  nsc      Namespace context for filter and xpath
+ * @param[in]  prefix   Only return values starting with prefix, or NULL
+ * @param[in]  limit    Max number of values returned, 0 means no limit
+ * @param[out] xt       XML tree. Free with xml_free. 
+ *                      <rpc-reply> with <value> or <rpc-error> children
+ * @retval    0         OK
+ * @retval   -1         Error, fatal or xml
+ * @code
+ *   cxobj *xt = NULL;
+ *   cxobj *x = NULL;
+ *
+ *   if (clicon_rpc_get_values(h, "running", NULL, "/ex:a/ex:b", nsc, NULL, 0, &xt) < 0)
+ *       err;
+ *   if ((xerr = xpath_first(xt, NULL, "/rpc-error")) != NULL){
+ *	clixon_netconf_error(xerr, "msg", "/ex:a/ex:b");
+ *      err;
+ *   }
+ *   while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+ *      printf("%s\n", xml_body(x));
+ *   xml_free(xt);
+ * @endcode
+ * @see clicon_rpc_get_config  which returns the configuration tree
+ */
+int
+clicon_rpc_get_values(clicon_handle h, 
+		      char         *db, 
+		      char         *filter,
+		      char         *xpath,
+		      cvec         *nsc,
+		      char         *prefix,
+		      uint32_t      limit,
+		      cxobj       **xt)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cbuf              *cb = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xd;
+    uint32_t           session_id;
+    char              *username;
+    
+    if (session_id_check(h, &session_id) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL)
+	goto done;
+    cprintf(cb, "<rpc xmlns=\"%s\"", NETCONF_BASE_NAMESPACE);
+    if ((username = clicon_username_get(h)) != NULL)
+	cprintf(cb, " username=\"%s\"", username);
+    cprintf(cb, "><get-values xmlns=\"%s\"><source>%s</source>", CLIXON_LIB_NS, db);
+    if (filter){
+	cprintf(cb, "<filter>");
+	if (xml_chardata_cbuf_append(cb, filter) < 0)
+	    goto done;
+	cprintf(cb, "</filter>");
+    }
+    cprintf(cb, "<xpath");
+    if (xml_nsctx_cbuf(cb, nsc) < 0)
+	goto done;
+    cprintf(cb, ">");
+    if (xml_chardata_cbuf_append(cb, xpath) < 0)
+	goto done;
+    cprintf(cb, "</xpath>");
+    if (prefix){
+	cprintf(cb, "<prefix>");
+	if (xml_chardata_cbuf_append(cb, prefix) < 0)
+	    goto done;
+	cprintf(cb, "</prefix>");
+    }
+    if (limit)
+	cprintf(cb, "<limit>%u</limit>", limit);
+    cprintf(cb, "</get-values></rpc>");
+    if ((msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb))) == NULL)
+	goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+	goto done;
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply")) == NULL){
+	clicon_err(OE_XML, ENOENT, "Expected rpc-reply tag but none found(internal)");
+	goto done;
+    }
+    if (xt){
+	if (xml_rm(xd) < 0)
+	    goto done;
+	*xt = xd;
+    }
+    retval = 0;
+  done:
+    if (cb)
+	cbuf_free(cb);
+    if (xret)
+	xml_free(xret);
+    if (msg)
+	free(msg);
+    return retval;
+}
+
 /*! Send database entries as XML to backend daemon
  * @param[in] h          CLICON handle
  * @param[in] db         Name of database
@@ -785,17 +1265,28 @@ clicon_rpc_get(clicon_handle   h,
 	       int32_t         depth,
 	       cxobj         **xt)
 {
-    int                retval = -1;
+    return clicon_rpc_get_page(h, xpath, nsc, NULL, content, depth, 0, 0, xt);
+}
+
+/*! Encode a get request, see clicon_rpc_get_page for parameters
+ * @retval  msg   Encoded message. Free with free
+ * @retval  NULL  Error
+ */
+static struct clicon_msg *
+rpc_get_msg(clicon_handle   h, 
+	    char           *xpath,
+	    cvec           *nsc,
+	    char           *api_path,
+	    netconf_content content,
+	    int32_t         depth,
+	    uint32_t        offset,
+	    uint32_t        limit)
+{
     struct clicon_msg *msg = NULL;
     cbuf              *cb = NULL;
-    cxobj             *xret = NULL;
-    cxobj             *xerr = NULL;
-    cxobj             *xd;
     char              *username;
     uint32_t           session_id;
-    int                ret;
-    yang_stmt         *yspec;
-    
+
     if (session_id_check(h, &session_id) < 0)
 	goto done;
     if ((cb = cbuf_new()) == NULL)
@@ -812,6 +1303,16 @@ clicon_rpc_get(clicon_handle   h,
     /* Clixon extension, depth=<level> */
     if (depth != -1)
 	cprintf(cb, " depth=\"%d\"", depth);
+    /* Clixon extension, paging of selected nodes */
+    if (limit)
+	cprintf(cb, " offset=\"%u\" limit=\"%u\"", offset, limit);
+    /* Clixon extension, api-path of the same nodes as the filter */
+    if (api_path){
+	cprintf(cb, " api-path=\"");
+	if (xml_chardata_cbuf_append(cb, api_path) < 0)
+	    goto done;
+	cprintf(cb, "\"");
+    }
     cprintf(cb, ">");
     if (xpath && strlen(xpath)) {
 	cprintf(cb, "<%s:filter %s:type=\"xpath\" %s:select=\"%s\"",
@@ -822,8 +1323,55 @@ clicon_rpc_get(clicon_handle   h,
 	cprintf(cb, "/>");
     }
     cprintf(cb, "</get></rpc>");
-    if ((msg = clicon_msg_encode(session_id,
-				 "%s", cbuf_get(cb))) == NULL)
+    msg = clicon_msg_encode(session_id, "%s", cbuf_get(cb));
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return msg;
+}
+
+/*! Get a page of configuration and state data: some of the nodes selected by xpath
+ *
+ * Same as clicon_rpc_get but only the nodes selected by xpath with position
+ * offset to offset+limit-1 in document order are returned, with their ancestors.
+ * With content=config, the page of a list is read directly from the datastore.
+ * @param[in]  h         Clicon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  api_path  Same selection as xpath as RESTCONF api-path, or NULL. With
+ *                       content=config, the backend may then look up the nodes by list
+ *                       keys directly instead of parsing and evaluating xpath
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  offset    Number of selected nodes to skip
+ * @param[in]  limit     Max number of selected nodes, 0 means all (no paging)
+ * @param[out] xt        XML tree. Free with xml_free. 
+ *                       Either <config> or <rpc-error>. 
+ * @retval    0          OK
+ * @retval   -1          Error, fatal or xml
+ * @see clicon_rpc_get
+ * @see clicon_rpc_get_config_page
+ */
+int
+clicon_rpc_get_page(clicon_handle   h, 
+		    char           *xpath,
+		    cvec           *nsc,
+		    char           *api_path,
+		    netconf_content content,
+		    int32_t         depth,
+		    uint32_t        offset,
+		    uint32_t        limit,
+		    cxobj         **xt)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xerr = NULL;
+    cxobj             *xd;
+    int                ret;
+    yang_stmt         *yspec;
+    
+    if ((msg = rpc_get_msg(h, xpath, nsc, api_path, content, depth, offset, limit)) == NULL)
 	goto done;
     if (clicon_rpc_msg(h, msg, &xret) < 0)
 	goto done;
@@ -836,7 +1384,8 @@ clicon_rpc_get(clicon_handle   h,
     }
     else{
 	yspec = clicon_dbspec_yang(h);
-	if ((ret = xml_bind_yang(xd, YB_MODULE, yspec, &xerr)) < 0)
+	/* Bind on access: callers often only look at part of a large reply */
+	if ((ret = xml_bind_yang_lazy(xd, yspec, &xerr)) < 0)
 	    goto done;
 	if (ret == 0){
 	    if (clixon_netconf_internal_error(xerr,
@@ -856,8 +1405,6 @@ clicon_rpc_get(clicon_handle   h,
     }
     retval = 0;
   done:
-    if (cb)
-	cbuf_free(cb);
     if (xerr)
 	xml_free(xerr);
     if (xret)
@@ -867,6 +1414,49 @@ clicon_rpc_get(clicon_handle   h,
     return retval;
 }
 
+/*! Get a page of configuration and state data with the reply as a string
+ *
+ * Same as clicon_rpc_get_page but the reply is neither parsed nor bound to yang, eg
+ * for relaying the data unchanged
+ * @param[in]  h         Clicon handle
+ * @param[in]  xpath     XPath in a filter stmt (or NULL/"" for no filter)
+ * @param[in]  nsc       Namespace context for filter
+ * @param[in]  api_path  Same selection as xpath as RESTCONF api-path, or NULL
+ * @param[in]  content   Clixon extension: all, config, noconfig. -1 means all
+ * @param[in]  depth     Nr of XML levels to get, -1 is all, 0 is none
+ * @param[in]  offset    Number of selected nodes to skip
+ * @param[in]  limit     Max number of selected nodes, 0 means all (no paging)
+ * @param[out] retdata   Reply: <rpc-reply><data>... or <rpc-reply><rpc-error>...
+ *                       Free with free
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see clicon_rpc_get_page  Reply as xml tree
+ */
+int
+clicon_rpc_get_page_str(clicon_handle   h, 
+			char           *xpath,
+			cvec           *nsc,
+			char           *api_path,
+			netconf_content content,
+			int32_t         depth,
+			uint32_t        offset,
+			uint32_t        limit,
+			char          **retdata)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+
+    if ((msg = rpc_get_msg(h, xpath, nsc, api_path, content, depth, offset, limit)) == NULL)
+	goto done;
+    if (clicon_rpc_msg_str(h, msg, retdata) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    return retval;
+}
+
 /*! Send a close a netconf user session. Socket is also closed if still open
  * @param[in] h        CLICON handle
  * @retval    0        OK
@@ -911,6 +1501,190 @@ clicon_rpc_close_session(clicon_handle h)
     return retval;
 }
 
+/*! Save session state of handle in session entry
+ */
+static void
+rpc_session_save(clicon_handle       h,
+		 struct rpc_session *rs)
+{
+    rs->rs_s = clicon_client_socket_get(h);
+    rs->rs_idset = clicon_session_id_get(h, &rs->rs_id) == 0;
+}
+
+/*! Set session state of handle from session entry
+ */
+static int
+rpc_session_load(clicon_handle       h,
+		 struct rpc_session *rs)
+{
+    if (clicon_client_socket_set(h, rs->rs_s) < 0)
+	return -1;
+    if (rs->rs_idset)
+	return clicon_session_id_set(h, rs->rs_id);
+    /* No session yet: made by hello on first rpc, see session_id_check */
+    clicon_data_del(h, "session-id");
+    return 0;
+}
+
+/*! Close a session entry and remove it from the pool
+ * The session is closed in the backend if hello was made, which also releases its locks
+ * @param[in]  h    Clicon handle
+ * @param[in]  rs   Session entry, not the current session of the handle
+ */
+static int
+rpc_session_close(clicon_handle       h,
+		  struct rpc_session *rs)
+{
+    int   retval = -1;
+    char *username = NULL;
+
+    if (rs->rs_idset){
+	if ((username = clicon_username_get(h)) != NULL &&
+	    (username = strdup(username)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    goto done;
+	}
+	/* Close session as its user */
+	clicon_username_set(h, rs->rs_username);
+	if (rpc_session_load(h, rs) < 0)
+	    goto done;
+	if (clicon_rpc_close_session(h) < 0)
+	    clicon_log(LOG_WARNING, "%s: close of session %u of user %s failed",
+		       __FUNCTION__, rs->rs_id, rs->rs_username);
+	clicon_username_set(h, username);
+    }
+    else if (rs->rs_s != -1)
+	close(rs->rs_s);
+    DELQ(rs, _rpc_sessions, struct rpc_session *);
+    _rpc_sessions_len--;
+    free(rs->rs_username);
+    free(rs);
+    retval = 0;
+ done:
+    if (username)
+	free(username);
+    return retval;
+}
+
+/*! Select the backend session of a user, create it if not found
+ *
+ * A client serving many users, eg restconf, keeps one backend session per user, so that
+ * session-ids and locks are per user, and not shared by all users of the client.
+ * The socket and session-id of the handle used by clicon_rpc_* are switched to those of
+ * the user. A new session is made by hello on the first rpc.
+ * The least recently used session is closed if there are more than max users.
+ * The session of the handle when the pool is first used is given to the first user.
+ * @param[in]  h         Clicon handle
+ * @param[in]  username  User, typically the authenticated user of a request
+ * @param[in]  max       Max number of sessions, if 0 all users share the session of h
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see clicon_rpc_session_pool_free
+ */
+int
+clicon_rpc_session_select(clicon_handle h,
+			  char         *username,
+			  int           max)
+{
+    int                 retval = -1;
+    struct rpc_session *rs;
+    struct rpc_session *rs1;
+    int                 first;
+
+    if (max <= 0)
+	goto ok;
+    if (username == NULL)
+	username = "";
+    first = (_rpc_session_cur == NULL && _rpc_sessions == NULL);
+    if ((rs = _rpc_session_cur) != NULL){
+	if (strcmp(rs->rs_username, username) == 0)
+	    goto ok;
+	rpc_session_save(h, rs);
+    }
+    /* Find session of user */
+    if ((rs = _rpc_sessions) != NULL){
+	do {
+	    if (strcmp(rs->rs_username, username) == 0)
+		break;
+	    rs = NEXTQ(struct rpc_session *, rs);
+	} while (rs != _rpc_sessions);
+	if (strcmp(rs->rs_username, username) != 0)
+	    rs = NULL;
+    }
+    if (rs == NULL){
+	/* Evict least recently used sessions */
+	while (_rpc_sessions_len >= max){
+	    rs1 = PREVQ(struct rpc_session *, _rpc_sessions);
+	    if (rs1 == _rpc_session_cur)
+		_rpc_session_cur = NULL;
+	    if (rpc_session_close(h, rs1) < 0)
+		goto done;
+	}
+	if ((rs = malloc(sizeof(*rs))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	memset(rs, 0, sizeof(*rs));
+	if ((rs->rs_username = strdup(username)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    free(rs);
+	    goto done;
+	}
+	rs->rs_s = -1;
+	if (first) /* Adopt session of handle */
+	    rpc_session_save(h, rs);
+	_rpc_sessions_len++;
+    }
+    else
+	DELQ(rs, _rpc_sessions, struct rpc_session *);
+    INSQ(rs, _rpc_sessions);
+    if (rpc_session_load(h, rs) < 0)
+	goto done;
+    _rpc_session_cur = rs;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Close all pooled backend sessions except the current session of the handle
+ *
+ * The current session is kept in the handle and is closed as usual with
+ * clicon_rpc_close_session
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see clicon_rpc_session_select
+ */
+int
+clicon_rpc_session_pool_free(clicon_handle h)
+{
+    int                 retval = -1;
+    struct rpc_session *rs;
+    struct rpc_session *cur;
+
+    if ((cur = _rpc_session_cur) != NULL){
+	rpc_session_save(h, cur);
+	DELQ(cur, _rpc_sessions, struct rpc_session *);
+	_rpc_sessions_len--;
+    }
+    while ((rs = _rpc_sessions) != NULL)
+	if (rpc_session_close(h, rs) < 0)
+	    goto done;
+    if (cur){
+	if (clicon_username_set(h, cur->rs_username) < 0)
+	    goto done;
+	if (rpc_session_load(h, cur) < 0)
+	    goto done;
+	free(cur->rs_username);
+	free(cur);
+	_rpc_session_cur = NULL;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Kill other user sessions
  * @param[in] h           CLICON handle
  * @param[in] session_id  Session id of other user session
@@ -1118,6 +1892,180 @@ clicon_rpc_create_subscription(clicon_handle    h,
     return retval;
 }
 
+/*! Compare two databases in the backend and get the differences
+ *
+ * Only the changes are sent from the backend, not the two configurations
+ * @param[in]  h        CLICON handle
+ * @param[in]  db0      Name of first database, eg "running"
+ * @param[in]  db1      Name of second database, eg "candidate"
+ * @param[out] xt       XML tree. Free with xml_free. 
+ *                      <rpc-reply> with <change> or <rpc-error> children
+ * @retval    0         OK
+ * @retval   -1         Error, fatal or xml
+ * @see compare_dbs  CLI callback
+ */
+int
+clicon_rpc_compare(clicon_handle h, 
+		   char         *db0,
+		   char         *db1,
+		   cxobj       **xt)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xd;
+    char              *username;
+    uint32_t           session_id;
+    
+    if (session_id_check(h, &session_id) < 0)
+	goto done;
+    username = clicon_username_get(h);
+    if ((msg = clicon_msg_encode(session_id,
+				 "<rpc xmlns=\"%s\" username=\"%s\"><compare xmlns=\"%s\"><source>%s</source><target>%s</target></compare></rpc>",
+				 NETCONF_BASE_NAMESPACE,
+				 username?username:"",
+				 CLIXON_LIB_NS,
+				 db0, db1)) == NULL)
+	goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+	goto done;
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply")) == NULL){
+	clicon_err(OE_XML, ENOENT, "Expected rpc-reply tag but none found(internal)");
+	goto done;
+    }
+    if (xt){
+	if (xml_rm(xd) < 0)
+	    goto done;
+	*xt = xd;
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
+/*! Get change token of a database, without reading the database
+ *
+ * The token changes when the content of the database may change. It is only
+ * meaningful to compare tokens for equality, eg as a HTTP ETag.
+ * @param[in]  h        CLICON handle
+ * @param[in]  db       Name of database, eg "running"
+ * @param[out] token    Change token, free with free()
+ * @param[out] modified Time of last change in seconds since epoch, or NULL
+ * @retval    0         OK
+ * @retval   -1         Error and logged to syslog
+ * @see api_data_get2  Restconf ETag and Last-Modified
+ */
+int
+clicon_rpc_datastore_token(clicon_handle h, 
+			   char         *db,
+			   char        **token,
+			   uint64_t     *modified)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xerr;
+    cxobj             *xd;
+    char              *username;
+    char              *str;
+    uint32_t           session_id;
+    
+    if (session_id_check(h, &session_id) < 0)
+	goto done;
+    username = clicon_username_get(h);
+    if ((msg = clicon_msg_encode(session_id,
+				 "<rpc xmlns=\"%s\" username=\"%s\"><datastore-token xmlns=\"%s\"><datastore>%s</datastore></datastore-token></rpc>",
+				 NETCONF_BASE_NAMESPACE,
+				 username?username:"",
+				 CLIXON_LIB_NS,
+				 db)) == NULL)
+	goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+	goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	clixon_netconf_error(xerr, "Datastore token", NULL);
+	goto done;
+    }
+    if ((xd = xpath_first(xret, NULL, "/rpc-reply")) == NULL ||
+	(str = xml_find_body(xd, "token")) == NULL){
+	clicon_err(OE_XML, ENOENT, "Expected token but none found(internal)");
+	goto done;
+    }
+    if ((*token = strdup(str)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (modified){
+	*modified = 0;
+	if ((str = xml_find_body(xd, "modified")) != NULL)
+	    *modified = strtoull(str, NULL, 10);
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
+/*! Begin or end a bulk load of a database
+ *
+ * While a bulk load is active, edits of the database are only applied to the
+ * datastore cache in the backend, and the datastore file is written when it ends.
+ * @param[in]  h        CLICON handle
+ * @param[in]  db       Name of database, eg "candidate"
+ * @param[in]  begin    1: begin bulk load, 0: end bulk load
+ * @retval    0         OK
+ * @retval   -1         Error and logged to syslog
+ * @see load_config_file  CLI callback
+ */
+int
+clicon_rpc_bulk_load(clicon_handle h, 
+		     char         *db,
+		     int           begin)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xret = NULL;
+    cxobj             *xerr;
+    char              *username;
+    uint32_t           session_id;
+    
+    if (session_id_check(h, &session_id) < 0)
+	goto done;
+    username = clicon_username_get(h);
+    if ((msg = clicon_msg_encode(session_id,
+				 "<rpc xmlns=\"%s\" username=\"%s\"><bulk-load xmlns=\"%s\"><target>%s</target><operation>%s</operation></bulk-load></rpc>",
+				 NETCONF_BASE_NAMESPACE,
+				 username?username:"",
+				 CLIXON_LIB_NS,
+				 db,
+				 begin?"begin":"end")) == NULL)
+	goto done;
+    if (clicon_rpc_msg(h, msg, &xret) < 0)
+	goto done;
+    if ((xerr = xpath_first(xret, NULL, "//rpc-error")) != NULL){
+	clixon_netconf_error(xerr, "Bulk load", NULL);
+	goto done;
+    }
+    if (xpath_first(xret, NULL, "//rpc-reply/ok") == NULL){
+	clicon_err(OE_XML, 0, "rpc error"); /* XXX extract info from rpc-error */
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    if (xret)
+	xml_free(xret);
+    return retval;
+}
+
 /*! Send a debug request to backend server
  * @param[in] h        CLICON handle
  * @param[in] level    Debug level
@@ -1164,6 +2112,45 @@ clicon_rpc_debug(clicon_handle h,
     return retval;
 }
 
+/*! Get statistics of backend server, eg number of XML objects and memory
+ * @param[in]  h        CLICON handle
+ * @param[out] xret     Reply: <rpc-reply><global>..<datastore>..<memory>.., free with xml_free
+ * @retval     0        OK
+ * @retval    -1        Error and logged to syslog
+ * @see from_client_stats  in the backend
+ */
+int
+clicon_rpc_stats(clicon_handle h, 
+		 cxobj       **xret)
+{
+    int                retval = -1;
+    struct clicon_msg *msg = NULL;
+    cxobj             *xerr;
+    char              *username;
+    uint32_t           session_id;
+    
+    if (session_id_check(h, &session_id) < 0)
+	goto done;
+    username = clicon_username_get(h);
+    if ((msg = clicon_msg_encode(session_id,
+				 "<rpc xmlns=\"%s\" username=\"%s\"><stats xmlns=\"%s\"/></rpc>",
+				 NETCONF_BASE_NAMESPACE,
+				 username?username:"",
+				 CLIXON_LIB_NS)) == NULL)
+	goto done;
+    if (clicon_rpc_msg(h, msg, xret) < 0)
+	goto done;
+    if ((xerr = xpath_first(*xret, NULL, "//rpc-error")) != NULL){
+	clixon_netconf_error(xerr, "Stats", NULL);
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (msg)
+	free(msg);
+    return retval;
+}
+
 /*! Send a debug request to backend server to set restconf debug
  * @param[in] h        CLICON handle
  * @param[in] level    Debug level
@@ -1223,6 +2210,8 @@ clicon_rpc_restconf_debug(clicon_handle h,
  * @note this is internal netconf to backend, not northbound to user client
  * @note this deviates from RFC6241 slightly in that it waits for a reply, the RFC does not
  *       stipulate that.
+ * If CLICON_PROTO_BINARY is set, binary encoding is offered, and used in subsequent
+ * requests if the backend accepts it, see clicon_msg_encode_bin
  */
 int
 clicon_hello_req(clicon_handle h,
@@ -1233,15 +2222,21 @@ clicon_hello_req(clicon_handle h,
     cxobj             *xret = NULL;
     cxobj             *xerr;
     cxobj             *x;
+    cxobj             *xc;
     char              *username;
     char              *b;
     int                ret;
+    int                binary;
 
     username = clicon_username_get(h);
-    if ((msg = clicon_msg_encode(0, "<hello username=\"%s\" xmlns=\"%s\" message-id=\"42\"><capabilities><capability>%s</capability></capabilities></hello>",
+    binary = clicon_option_bool(h, "CLICON_PROTO_BINARY");
+    if ((msg = clicon_msg_encode(0, "<hello username=\"%s\" xmlns=\"%s\" message-id=\"42\"><capabilities><capability>%s</capability>%s%s%s</capabilities></hello>",
 				 username?username:"",
 				 NETCONF_BASE_NAMESPACE,
-				 NETCONF_BASE_CAPABILITY_1_1)) == NULL)
+				 NETCONF_BASE_CAPABILITY_1_1,
+				 binary?"<capability>":"",
+				 binary?CLIXON_PROTO_BIN_CAPABILITY:"",
+				 binary?"</capability>":"")) == NULL)
 	goto done;
     if (clicon_rpc_msg(h, msg, &xret) < 0)
 	goto done;
@@ -1258,6 +2253,19 @@ clicon_hello_req(clicon_handle h,
 	clicon_err(OE_XML, errno, "parse_uint32"); 
 	goto done;
     }
+    clicon_data_del(h, "proto-binary");
+    if (binary &&
+	(x = xpath_first(xret, NULL, "hello/capabilities")) != NULL){
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+	    if (strcmp(xml_name(xc), "capability") == 0 &&
+		(b = xml_body(xc)) != NULL &&
+		strcmp(b, CLIXON_PROTO_BIN_CAPABILITY) == 0){
+		if (clicon_data_set(h, "proto-binary", "true") < 0)
+		    goto done;
+		break;
+	    }
+    }
     retval = 0;
  done:
     if (msg)
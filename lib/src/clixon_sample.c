@@ -0,0 +1,459 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Built-in sampling profiler, for capturing hot spots of a daemon under production
+ * load where an external profiler cannot be attached.
+ * A profiling timer sends SIGPROF at a given frequency of consumed cpu time, and the
+ * signal handler copies the return addresses of the call stack to a buffer allocated
+ * at start. When sampling stops, the addresses are resolved to symbols and written to
+ * a file as folded stacks, eg:
+ *   main;clixon_event_loop;from_client_msg;from_client_commit;candidate_commit 17
+ * The signal handler does not allocate memory or lock, and the profiler does not
+ * cost anything when not sampling.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <sys/param.h>
+#ifdef HAVE_BACKTRACE
+#include <execinfo.h>
+#endif
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_sig.h"
+#include "clixon_event.h"
+#include "clixon_options.h"
+#include "clixon_sample.h"
+
+/*
+ * Constants
+ */
+/* Max number of frames of one sample */
+#define SAMPLE_DEPTH   64
+
+/* Size of sample buffer in frames, each sample uses its depth + 1 */
+#define SAMPLE_FRAMES  (1<<20)
+
+/* Frames of signal handler and signal trampoline on top of each sample */
+#define SAMPLE_SKIP    2
+
+/* Default sampling frequency if not given, a prime to not be in phase with periodic work */
+#define SAMPLE_HZ      99
+
+/*
+ * Variables
+ */
+/* Sample buffer: a sequence of samples, each a frame count followed by the frames */
+static void        **_sample_buf = NULL;
+
+/* Number of used frames in sample buffer */
+static volatile size_t _sample_len = 0;
+
+/* Number of samples in buffer */
+static volatile int  _sample_count = 0;
+
+/* Number of samples dropped since buffer is full */
+static volatile int  _sample_dropped = 0;
+
+/* File that folded stacks are written to when sampling stops */
+static char         *_sample_file = NULL;
+
+/* Start or stop signal received but not yet handled by clixon_sample_pending_run() */
+static volatile int  _sample_pending = 0;
+
+#ifdef HAVE_BACKTRACE
+/*! SIGPROF handler: copy call stack to sample buffer
+ * @param[in]  sig   SIGPROF
+ * backtrace() is called once in clixon_sample_start() so that it does not allocate here.
+ */
+static void
+sample_sigprof(int sig)
+{
+    int saved_errno = errno;
+    int n;
+
+    if (_sample_buf != NULL && _sample_len + SAMPLE_DEPTH + 1 <= SAMPLE_FRAMES){
+	n = backtrace(&_sample_buf[_sample_len+1], SAMPLE_DEPTH);
+	_sample_buf[_sample_len] = (void*)(intptr_t)n;
+	_sample_len += n + 1;
+	_sample_count++;
+    }
+    else
+	_sample_dropped++;
+    /* The event loop does not treat an interrupted select as an error */
+    clicon_sig_ignore_set(1);
+    errno = saved_errno;
+}
+
+/*! Append symbol of a frame to a folded stack
+ * A symbol from backtrace_symbols() is "module(function+offset) [address]". If the
+ * function is not known, eg static, module and offset is used instead, which can be
+ * resolved afterwards with eg addr2line.
+ * @param[in]  cb    Folded stack
+ * @param[in]  sym   Symbol from backtrace_symbols()
+ */
+static void
+sample_frame_append(cbuf *cb,
+		    char *sym)
+{
+    char *mod;
+    char *fn;
+    char *off;
+    char *end;
+
+    if ((fn = strchr(sym, '(')) == NULL ||
+	(end = strchr(fn, ')')) == NULL){
+	cprintf(cb, "%s", sym);
+	return;
+    }
+    if ((off = strchr(fn, '+')) == NULL || off > end)
+	off = end;
+    if (off > fn + 1)
+	cprintf(cb, "%.*s", (int)(off-fn-1), fn+1);
+    else{
+	if ((mod = strrchr(sym, '/')) == NULL || mod > fn)
+	    mod = sym;
+	else
+	    mod++;
+	cprintf(cb, "%.*s%.*s", (int)(fn-mod), mod, (int)(end-off), off);
+    }
+}
+
+/*! Resolve samples in buffer and write them as folded stacks to file
+ * @param[in]  file  File name
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+sample_write(const char *file)
+{
+    int            retval = -1;
+    clicon_hash_t *hash = NULL;
+    FILE          *f = NULL;
+    cbuf          *cb = NULL;
+    char         **syms = NULL;
+    char         **keys = NULL;
+    size_t         nkeys = 0;
+    size_t         i;
+    int            n;
+    int            j;
+    int           *count;
+    int            one = 1;
+
+    if ((hash = clicon_hash_init()) == NULL)
+	goto done;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    for (i=0; i<_sample_len; i += n+1){
+	n = (int)(intptr_t)_sample_buf[i];
+	if (n <= SAMPLE_SKIP)
+	    continue;
+	if ((syms = backtrace_symbols(&_sample_buf[i+1], n)) == NULL){
+	    clicon_err(OE_UNIX, errno, "backtrace_symbols");
+	    goto done;
+	}
+	/* Folded stacks start with the outermost frame */
+	cbuf_reset(cb);
+	for (j=n-1; j>=SAMPLE_SKIP; j--){
+	    sample_frame_append(cb, syms[j]);
+	    if (j > SAMPLE_SKIP)
+		cprintf(cb, ";");
+	}
+	free(syms);
+	syms = NULL;
+	if ((count = clicon_hash_value(hash, cbuf_get(cb), NULL)) != NULL)
+	    (*count)++;
+	else if (clicon_hash_add(hash, cbuf_get(cb), &one, sizeof(one)) == NULL)
+	    goto done;
+    }
+    if ((f = fopen(file, "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", file);
+	goto done;
+    }
+    if (clicon_hash_keys(hash, &keys, &nkeys) < 0)
+	goto done;
+    for (i=0; i<nkeys; i++){
+	count = clicon_hash_value(hash, keys[i], NULL);
+	fprintf(f, "%s %d\n", keys[i], *count);
+    }
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    if (f)
+	fclose(f);
+    if (syms)
+	free(syms);
+    if (cb)
+	cbuf_free(cb);
+    if (hash)
+	clicon_hash_free(hash);
+    return retval;
+}
+#endif /* HAVE_BACKTRACE */
+
+/*! Start sampling of this process
+ * @param[in]  hz    Samples per second of consumed cpu time, or 0 for default
+ * @param[in]  file  File that folded stacks are written to by clixon_sample_stop()
+ * @retval     0     OK
+ * @retval    -1     Error, eg already sampling or not supported on this platform
+ * @see clixon_sample_stop
+ */
+int
+clixon_sample_start(int         hz,
+		    const char *file)
+{
+#ifdef HAVE_BACKTRACE
+    int              retval = -1;
+    struct itimerval it = {{0,},};
+    void            *frame;
+
+    if (_sample_buf != NULL){
+	clicon_err(OE_UNIX, EBUSY, "Sampling already started");
+	goto done;
+    }
+    if (file == NULL){
+	clicon_err(OE_UNIX, EINVAL, "No sample file");
+	goto done;
+    }
+    if (hz <= 0)
+	hz = SAMPLE_HZ;
+    if (hz > 1000000)
+	hz = 1000000;
+    if (_sample_file != NULL)
+	free(_sample_file);
+    if ((_sample_file = strdup(file)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if ((_sample_buf = malloc(SAMPLE_FRAMES*sizeof(void*))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    _sample_len = 0;
+    _sample_count = 0;
+    _sample_dropped = 0;
+    /* First call of backtrace may load libgcc, which allocates, not safe in handler */
+    backtrace(&frame, 1);
+    if (set_signal(SIGPROF, sample_sigprof, NULL) < 0)
+	goto done;
+    it.it_interval.tv_usec = 1000000/hz;
+    it.it_value = it.it_interval;
+    if (setitimer(ITIMER_PROF, &it, NULL) < 0){
+	clicon_err(OE_UNIX, errno, "setitimer");
+	goto done;
+    }
+    clicon_log(LOG_NOTICE, "%s: sampling at %d Hz to %s", __FUNCTION__, hz, file);
+    retval = 0;
+ done:
+    if (retval < 0){
+	if (_sample_buf != NULL){
+	    free(_sample_buf);
+	    _sample_buf = NULL;
+	}
+	if (_sample_file != NULL){
+	    free(_sample_file);
+	    _sample_file = NULL;
+	}
+    }
+    return retval;
+#else
+    clicon_err(OE_UNIX, ENOTSUP, "Sampling requires backtrace(), not available on this platform");
+    return -1;
+#endif /* HAVE_BACKTRACE */
+}
+
+/*! Stop sampling and write folded stacks to the file given at start
+ * The sample counters remain until next start.
+ * @retval     0     OK
+ * @retval    -1     Error, eg not sampling
+ * @see clixon_sample_start
+ */
+int
+clixon_sample_stop(void)
+{
+#ifdef HAVE_BACKTRACE
+    int              retval = -1;
+    struct itimerval it = {{0,},};
+
+    if (_sample_buf == NULL){
+	clicon_err(OE_UNIX, EINVAL, "Sampling not started");
+	goto done;
+    }
+    if (setitimer(ITIMER_PROF, &it, NULL) < 0){
+	clicon_err(OE_UNIX, errno, "setitimer");
+	goto done;
+    }
+    if (set_signal(SIGPROF, SIG_IGN, NULL) < 0)
+	goto done;
+    if (sample_write(_sample_file) < 0)
+	goto done;
+    clicon_log(LOG_NOTICE, "%s: %d samples (%d dropped) written to %s",
+	       __FUNCTION__, _sample_count, _sample_dropped, _sample_file);
+    retval = 0;
+ done:
+    if (_sample_buf){
+	free(_sample_buf);
+	_sample_buf = NULL;
+    }
+    return retval;
+#else
+    clicon_err(OE_UNIX, ENOTSUP, "Sampling requires backtrace(), not available on this platform");
+    return -1;
+#endif /* HAVE_BACKTRACE */
+}
+
+/*! Check if this process is sampling
+ * @retval  1  Sampling
+ * @retval  0  Not sampling
+ */
+int
+clixon_sample_active(void)
+{
+    return _sample_buf != NULL;
+}
+
+/*! Get number of samples of ongoing or last sampling
+ */
+int
+clixon_sample_count(void)
+{
+    return _sample_count;
+}
+
+/*! Get number of samples dropped since the sample buffer was full
+ */
+int
+clixon_sample_dropped(void)
+{
+    return _sample_dropped;
+}
+
+/*! Get file of ongoing or last sampling, or NULL
+ */
+char *
+clixon_sample_file(void)
+{
+    return _sample_file;
+}
+
+/*! Signal handler of start and stop signals of sampling
+ * Sampling is started or stopped by clixon_sample_pending_run() called from the
+ * event loop, not in the handler.
+ * @param[in]  sig   CLIXON_SAMPLE_SIG_START or CLIXON_SAMPLE_SIG_STOP
+ */
+void
+clixon_sample_sig(int sig)
+{
+    _sample_pending = sig;
+    clicon_sig_ignore_set(1);
+}
+
+/*! Register handler of start and stop signals of sampling in a daemon
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @code
+ *   kill -USR1 <pid>   # start sampling
+ *   kill -USR2 <pid>   # stop, write folded stacks to CLICON_SAMPLE_FILE.<pid>
+ * @endcode
+ */
+int
+clixon_sample_sig_register(void)
+{
+    if (set_signal(CLIXON_SAMPLE_SIG_START, clixon_sample_sig, NULL) < 0)
+	return -1;
+    if (set_signal(CLIXON_SAMPLE_SIG_STOP, clixon_sample_sig, NULL) < 0)
+	return -1;
+    return 0;
+}
+
+/*! Check if a start or stop signal is received but not handled
+ */
+int
+clixon_sample_pending(void)
+{
+    return _sample_pending != 0;
+}
+
+/*! Start or stop sampling on a received signal, called from the event loop
+ * Sampling frequency is CLICON_SAMPLE_FREQUENCY and the folded stacks are written to
+ * CLICON_SAMPLE_FILE with the process id as suffix.
+ * Errors are logged, eg start when already sampling, but do not stop the daemon.
+ * @param[in]  h     Clicon handle
+ * @retval     0     OK
+ */
+int
+clixon_sample_pending_run(clicon_handle h)
+{
+    int   sig;
+    char *prefix;
+    char  file[MAXPATHLEN];
+
+    sig = _sample_pending;
+    _sample_pending = 0;
+    if (sig == CLIXON_SAMPLE_SIG_START){
+	if ((prefix = clicon_option_str(h, "CLICON_SAMPLE_FILE")) == NULL)
+	    prefix = "/var/tmp/clixon_sample";
+	snprintf(file, sizeof(file), "%s.%u", prefix, getpid());
+	if (clixon_sample_start(clicon_option_int(h, "CLICON_SAMPLE_FREQUENCY"), file) < 0)
+	    clicon_log(LOG_WARNING, "%s: %s", __FUNCTION__, clicon_err_reason);
+    }
+    else if (sig == CLIXON_SAMPLE_SIG_STOP){
+	if (clixon_sample_stop() < 0)
+	    clicon_log(LOG_WARNING, "%s: %s", __FUNCTION__, clicon_err_reason);
+    }
+    return 0;
+}
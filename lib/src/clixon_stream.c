@@ -64,7 +64,13 @@
 #include <errno.h>
 #include <inttypes.h>
 #include <syslog.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
 #include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -74,6 +80,7 @@
 #include "clixon_err.h"
 #include "clixon_log.h"
 #include "clixon_string.h"
+#include "clixon_file.h"
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_event.h"
@@ -84,11 +91,560 @@
 #include "clixon_data.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_json.h"
+#include "clixon_proto.h"
 #include "clixon_stream.h"
 
 /* Go through and timeout subscription timers [s] */
 #define STREAM_TIMER_TIMEOUT_S 5
 
+/* Shared encodings of event currently notified to subscriptions, see stream_notify1 */
+static struct stream_event *_stream_event = NULL;
+
+/* Initial number of entries in replay time index */
+#define STREAM_REPLAY_VEC_SIZE 64
+
+/* Initial size of replay data ring [bytes] */
+#define STREAM_REPLAY_DATA_SIZE 4096
+
+/* Replay entry i in time order, 0 is the oldest */
+#define REPLAY_ENTRY(r, i) (&(r)->r_vec[((r)->r_head + (i)) % (r)->r_vecmax])
+
+/*! Resize replay data ring and move events to its start in time order
+ * @param[in]  r     Replay buffer
+ * @param[in]  size  New size, assume it is larger than the events
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+stream_replay_resize(struct stream_replay *r,
+		     size_t                size)
+{
+    int                         retval = -1;
+    char                       *data = NULL;
+    size_t                      off = 0;
+    size_t                      i;
+    struct stream_replay_entry *re;
+
+    if ((data = malloc(size)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    for (i=0; i<r->r_len; i++){
+	re = REPLAY_ENTRY(r, i);
+	memcpy(data+off, r->r_data+re->re_off, re->re_len);
+	re->re_off = off;
+	off += re->re_len;
+    }
+    if (r->r_file == NULL){
+	if (r->r_data)
+	    free(r->r_data);
+	r->r_data = data;
+	data = NULL;
+	r->r_datamax = size;
+    }
+    else { /* Copy to re-mapped file */
+	if (r->r_data && munmap(r->r_data, r->r_datamax) < 0){
+	    clicon_err(OE_UNIX, errno, "munmap");
+	    goto done;
+	}
+	r->r_data = NULL;
+	r->r_datamax = 0;
+	r->r_len = 0; /* Events are lost if file cannot be re-mapped */
+	if (ftruncate(r->r_fd, size) < 0){
+	    clicon_err(OE_UNIX, errno, "ftruncate %s", r->r_file);
+	    goto done;
+	}
+	if ((r->r_data = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED,
+			      r->r_fd, 0)) == MAP_FAILED){
+	    r->r_data = NULL;
+	    clicon_err(OE_UNIX, errno, "mmap %s", r->r_file);
+	    goto done;
+	}
+	memcpy(r->r_data, data, off);
+	r->r_datamax = size;
+	r->r_len = i;
+    }
+    retval = 0;
+ done:
+    if (data)
+	free(data);
+    return retval;
+}
+
+/*! Find space in replay data ring for an event
+ * @param[in]  r     Replay buffer
+ * @param[in]  len   Length of event
+ * @param[out] offp  Offset in data ring of event
+ * @retval     1     OK, offset found
+ * @retval     0     No space in data ring
+ */
+static int
+stream_replay_space(struct stream_replay *r,
+		    size_t                len,
+		    size_t               *offp)
+{
+    struct stream_replay_entry *first;
+    struct stream_replay_entry *last;
+    size_t                      head;
+    size_t                      tail;
+
+    if (r->r_len == 0){
+	if (len > r->r_datamax)
+	    return 0;
+	*offp = 0;
+	return 1;
+    }
+    first = REPLAY_ENTRY(r, 0);
+    last = REPLAY_ENTRY(r, r->r_len-1);
+    head = first->re_off;
+    tail = last->re_off + last->re_len;
+    if (head < tail){ /* Not wrapped: space at end or at start */
+	if (len <= r->r_datamax - tail){
+	    *offp = tail;
+	    return 1;
+	}
+	if (len <= head){
+	    *offp = 0;
+	    return 1;
+	}
+    }
+    else if (len <= head - tail){
+	*offp = tail;
+	return 1;
+    }
+    return 0;
+}
+
+/*! Find first replay entry with time equal or later than tv
+ * @param[in]  r     Replay buffer
+ * @param[in]  tv    Timestamp
+ * @retval     i     Entry in time order, or r_len if no such entry
+ */
+static size_t
+stream_replay_search(struct stream_replay *r,
+		     struct timeval       *tv)
+{
+    size_t lo = 0;
+    size_t hi = r->r_len;
+    size_t mid;
+
+    while (lo < hi){
+	mid = lo + (hi - lo)/2;
+	if (timercmp(&REPLAY_ENTRY(r, mid)->re_tv, tv, <))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+/*! Remove replay entries older than tv
+ * @param[in]  r     Replay buffer
+ * @param[in]  tv    Timestamp
+ */
+static int
+stream_replay_prune(struct stream_replay *r,
+		    struct timeval       *tv)
+{
+    size_t i;
+
+    if ((i = stream_replay_search(r, tv)) == 0)
+	return 0;
+    r->r_len -= i;
+    if (r->r_len == 0)
+	r->r_head = 0;
+    else
+	r->r_head = (r->r_head + i) % r->r_vecmax;
+    return 0;
+}
+
+/*! Free replay buffer
+ * @param[in]  r     Replay buffer
+ */
+static int
+stream_replay_free(struct stream_replay *r)
+{
+    if (r->r_vec)
+	free(r->r_vec);
+    if (r->r_file){
+	if (r->r_data)
+	    munmap(r->r_data, r->r_datamax);
+	close(r->r_fd);
+	unlink(r->r_file);
+	free(r->r_file);
+    }
+    else if (r->r_data)
+	free(r->r_data);
+    memset(r, 0, sizeof(*r));
+    return 0;
+}
+
+/* Record header of event in persistent replay log segment, followed by event as XML */
+struct stream_log_rec{
+    uint64_t lr_sec;  /* Time of event, seconds */
+    uint32_t lr_usec; /* Time of event, microseconds */
+    uint32_t lr_len;  /* Length of event, without NUL */
+};
+
+/*! Get filename of segment of persistent replay log
+ * @param[in]  l     Replay log
+ * @param[in]  seq   Sequence number of segment
+ * @param[out] cb    Filename, reset first
+ */
+static int
+stream_log_path(struct stream_log *l,
+		uint64_t           seq,
+		cbuf              *cb)
+{
+    cbuf_reset(cb);
+    /* Zero-padded so that segments are sorted by name */
+    cprintf(cb, "%s/%020" PRIu64 ".log", l->l_dir, seq);
+    return 0;
+}
+
+/*! Add segment last in time index of persistent replay log
+ * @param[in]  l     Replay log
+ * @param[in]  seq   Sequence number of segment
+ * @param[in]  tv    Time of first event
+ * @param[in]  size  Size of segment file
+ * @retval     ls    Segment
+ * @retval     NULL  Error
+ */
+static struct stream_log_segment *
+stream_log_segment_add(struct stream_log *l,
+		       uint64_t           seq,
+		       struct timeval    *tv,
+		       size_t             size)
+{
+    struct stream_log_segment *ls;
+
+    if ((ls = malloc(sizeof(*ls))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(ls, 0, sizeof(*ls));
+    ls->ls_seq = seq;
+    ls->ls_first = *tv;
+    ls->ls_size = size;
+    ADDQ(ls, l->l_seg);
+    return ls;
+}
+
+/*! Remove oldest segment of persistent replay log and its file
+ * @param[in]  l     Replay log
+ * @param[in]  cb    Buffer for filename
+ */
+static int
+stream_log_segment_rm(struct stream_log *l,
+		      cbuf              *cb)
+{
+    struct stream_log_segment *ls = l->l_seg;
+
+    stream_log_path(l, ls->ls_seq, cb);
+    if (unlink(cbuf_get(cb)) < 0 && errno != ENOENT){
+	clicon_err(OE_UNIX, errno, "unlink %s", cbuf_get(cb));
+	return -1;
+    }
+    DELQ(ls, l->l_seg, struct stream_log_segment *);
+    free(ls);
+    return 0;
+}
+
+/*! Free persistent replay log, the segment files are kept
+ * @param[in]  l     Replay log
+ */
+static int
+stream_log_free(struct stream_log *l)
+{
+    struct stream_log_segment *ls;
+
+    if (l->l_fd != -1)
+	close(l->l_fd);
+    while ((ls = l->l_seg) != NULL){
+	DELQ(ls, l->l_seg, struct stream_log_segment *);
+	free(ls);
+    }
+    if (l->l_dir)
+	free(l->l_dir);
+    free(l);
+    return 0;
+}
+
+/*! Open persistent replay log of a stream, build time index from existing segments
+ * Only the first record of each segment is read. Segments without a complete record,
+ * eg if the backend was killed while creating it, are removed. Events of a restart are
+ * appended to a new segment.
+ * @param[in]  h     Clicon handle
+ * @param[in]  dir   Log directory, see CLICON_STREAM_REPLAY_LOG
+ * @param[in]  name  Name of stream, segments are stored in <dir>/<name>
+ * @retval     l     Replay log
+ * @retval     NULL  Error
+ */
+static struct stream_log *
+stream_log_open(clicon_handle h,
+		const char   *dir,
+		const char   *name)
+{
+    int                   retval = -1;
+    struct stream_log    *l = NULL;
+    cbuf                 *cb = NULL;
+    struct dirent        *dp = NULL;
+    int                   ndp;
+    int                   i;
+    int                   fd = -1;
+    struct stat           st;
+    struct stream_log_rec lr;
+    struct timeval        tv;
+    uint64_t              seq;
+
+    if ((l = malloc(sizeof(*l))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(l, 0, sizeof(*l));
+    l->l_fd = -1;
+    l->l_segmax = clicon_option_int(h, "CLICON_STREAM_REPLAY_LOG_SEGMENT");
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%s/%s", dir, name);
+    if ((l->l_dir = strdup(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (mkdir(l->l_dir, S_IRWXU) < 0 && errno != EEXIST){
+	clicon_err(OE_UNIX, errno, "mkdir %s", l->l_dir);
+	goto done;
+    }
+    if ((ndp = clicon_file_dirent(l->l_dir, &dp, "^[0-9]+\\.log$", S_IFREG)) < 0)
+	goto done;
+    for (i = 0; i < ndp; i++){
+	seq = strtoull(dp[i].d_name, NULL, 10);
+	stream_log_path(l, seq, cb);
+	if ((fd = open(cbuf_get(cb), O_RDONLY)) < 0){
+	    clicon_err(OE_UNIX, errno, "open %s", cbuf_get(cb));
+	    goto done;
+	}
+	if (fstat(fd, &st) < 0){
+	    clicon_err(OE_UNIX, errno, "fstat %s", cbuf_get(cb));
+	    goto done;
+	}
+	if (read(fd, &lr, sizeof(lr)) != sizeof(lr) ||
+	    st.st_size < sizeof(lr) + lr.lr_len){
+	    clicon_log(LOG_WARNING, "%s: Removing empty replay log segment %s",
+		       __FUNCTION__, cbuf_get(cb));
+	    unlink(cbuf_get(cb));
+	}
+	else {
+	    tv.tv_sec = lr.lr_sec;
+	    tv.tv_usec = lr.lr_usec;
+	    if (stream_log_segment_add(l, seq, &tv, st.st_size) == NULL)
+		goto done;
+	}
+	close(fd);
+	fd = -1;
+    }
+    retval = 0;
+ done:
+    if (fd != -1)
+	close(fd);
+    if (dp)
+	free(dp);
+    if (cb)
+	cbuf_free(cb);
+    if (retval < 0 && l){
+	stream_log_free(l);
+	l = NULL;
+    }
+    return l;
+}
+
+/*! Append event to persistent replay log, rotate segment if full
+ * @param[in]  l     Replay log
+ * @param[in]  tv    Timestamp, assume not earlier than last event
+ * @param[in]  str   Event as XML
+ * @param[in]  len   Length of event
+ * @note The segment is not synced to disk on every event
+ */
+static int
+stream_log_append(struct stream_log *l,
+		  struct timeval    *tv,
+		  char              *str,
+		  size_t             len)
+{
+    int                        retval = -1;
+    struct stream_log_segment *ls;
+    struct stream_log_rec      lr;
+    struct iovec               iov[2];
+    cbuf                      *cb = NULL;
+    uint64_t                   seq = 0;
+    ssize_t                    n;
+
+    ls = l->l_seg ? PREVQ(struct stream_log_segment *, l->l_seg) : NULL;
+    /* Rotate: start a new segment if full or not opened by this process */
+    if (ls == NULL || l->l_fd == -1 || ls->ls_size >= l->l_segmax){
+	if (l->l_fd != -1){
+	    close(l->l_fd);
+	    l->l_fd = -1;
+	}
+	if (ls)
+	    seq = ls->ls_seq + 1;
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	stream_log_path(l, seq, cb);
+	if ((l->l_fd = open(cbuf_get(cb), O_WRONLY|O_CREAT|O_TRUNC|O_APPEND|O_CLOEXEC,
+			    S_IRUSR|S_IWUSR)) < 0){
+	    clicon_err(OE_UNIX, errno, "open %s", cbuf_get(cb));
+	    goto done;
+	}
+	if ((ls = stream_log_segment_add(l, seq, tv, 0)) == NULL)
+	    goto done;
+    }
+    memset(&lr, 0, sizeof(lr));
+    lr.lr_sec = tv->tv_sec;
+    lr.lr_usec = tv->tv_usec;
+    lr.lr_len = len;
+    iov[0].iov_base = &lr;
+    iov[0].iov_len = sizeof(lr);
+    iov[1].iov_base = str;
+    iov[1].iov_len = len;
+    if ((n = writev(l->l_fd, iov, 2)) < 0){
+	clicon_err(OE_UNIX, errno, "writev");
+	goto done;
+    }
+    if (n != sizeof(lr) + len){
+	clicon_err(OE_UNIX, 0, "writev: short write to replay log %s", l->l_dir);
+	goto done;
+    }
+    ls->ls_size += n;
+    l->l_nr++;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Remove segments of persistent replay log with only events older than tv
+ * All events of a segment are older than the first event of the next segment
+ * @param[in]  l     Replay log
+ * @param[in]  tv    Timestamp
+ */
+static int
+stream_log_prune(struct stream_log *l,
+		 struct timeval    *tv)
+{
+    int                        retval = -1;
+    struct stream_log_segment *next;
+    cbuf                      *cb = NULL;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    while (l->l_seg &&
+	   (next = NEXTQ(struct stream_log_segment *, l->l_seg)) != l->l_seg &&
+	   timercmp(&next->ls_first, tv, <=))
+	if (stream_log_segment_rm(l, cb) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Replay events from persistent replay log by sequential reads of segments
+ * The time index is used to find the segment of the start time
+ * @param[in]  h     Clicon handle
+ * @param[in]  l     Replay log
+ * @param[in]  ss    Subscription with start time and optional stop time
+ */
+static int
+stream_log_replay(clicon_handle               h,
+		  struct stream_log          *l,
+		  struct stream_subscription *ss)
+{
+    int                        retval = -1;
+    struct stream_log_segment *ls;
+    struct stream_log_segment *next;
+    struct stream_log_rec      lr;
+    struct timeval             tv;
+    cbuf                      *cb = NULL;
+    FILE                      *f = NULL;
+    char                      *buf = NULL;
+    size_t                     bufmax = 0;
+    cxobj                     *xt = NULL;
+
+    if ((ls = l->l_seg) == NULL)
+	goto ok;
+    /* Last segment with first event not later than start time */
+    while ((next = NEXTQ(struct stream_log_segment *, ls)) != l->l_seg &&
+	   !timercmp(&next->ls_first, &ss->ss_starttime, >))
+	ls = next;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    do {
+	stream_log_path(l, ls->ls_seq, cb);
+	if ((f = fopen(cbuf_get(cb), "r")) == NULL){
+	    clicon_err(OE_UNIX, errno, "fopen %s", cbuf_get(cb));
+	    goto done;
+	}
+	/* A truncated last record ends the segment */
+	while (fread(&lr, sizeof(lr), 1, f) == 1){
+	    tv.tv_sec = lr.lr_sec;
+	    tv.tv_usec = lr.lr_usec;
+	    if (timerisset(&ss->ss_stoptime) &&
+		timercmp(&tv, &ss->ss_stoptime, >))
+		goto ok;
+	    if (timercmp(&tv, &ss->ss_starttime, <)){
+		if (fseek(f, lr.lr_len, SEEK_CUR) < 0)
+		    break;
+		continue;
+	    }
+	    if (lr.lr_len + 1 > bufmax){
+		bufmax = lr.lr_len + 1;
+		if ((buf = realloc(buf, bufmax)) == NULL){
+		    clicon_err(OE_UNIX, errno, "realloc");
+		    goto done;
+		}
+	    }
+	    if (lr.lr_len && fread(buf, lr.lr_len, 1, f) != 1)
+		break;
+	    buf[lr.lr_len] = '\0';
+	    if (clixon_xml_parse_string(buf, YB_NONE, NULL, &xt, NULL) < 0)
+		goto done;
+	    if (xml_rootchild(xt, 0, &xt) < 0)
+		goto done;
+	    if ((*ss->ss_fn)(h, 0, xt, ss->ss_arg) < 0)
+		goto done;
+	    xml_free(xt);
+	    xt = NULL;
+	}
+	fclose(f);
+	f = NULL;
+	ls = NEXTQ(struct stream_log_segment *, ls);
+    } while (ls != l->l_seg);
+ ok:
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    if (f)
+	fclose(f);
+    if (buf)
+	free(buf);
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
 /*! Find an event notification stream given name
  * @param[in]  h    Clicon handle
  * @param[in]  name Name of stream
@@ -112,12 +668,143 @@ stream_find(clicon_handle h,
     return NULL;
 }
 
+/*! Get name of event element selected by first step of a subscription filter
+ *
+ * Only a relative location path with a child step and a name is indexed, eg "event" 
+ * in "event[event-class='fault']". An event whose notification has no such element
+ * cannot match the filter
+ * @param[in]  xpt   Parsed xpath
+ * @retval     name  Element name
+ * @retval     NULL  Any event may match
+ */
+static char *
+stream_filter_root(xpath_tree *xpt)
+{
+    while (xpt != NULL){
+	switch (xpt->xs_type){
+	case XP_EXP:
+	case XP_AND:
+	case XP_RELEX:
+	case XP_ADD:
+	case XP_UNION:
+	case XP_PATHEXPR:
+	case XP_LOCPATH:
+	    if (xpt->xs_c1 != NULL)
+		return NULL;
+	    xpt = xpt->xs_c0;
+	    break;
+	case XP_RELLOCPATH: /* First step is leftmost */
+	    xpt = xpt->xs_c0;
+	    break;
+	case XP_STEP:
+	    if (xpt->xs_int != A_CHILD ||
+		xpt->xs_c0 == NULL ||
+		xpt->xs_c0->xs_type != XP_NODE)
+		return NULL;
+	    return xpt->xs_c0->xs_s1;
+	    break;
+	default:
+	    return NULL;
+	}
+    }
+    return NULL;
+}
+
+/*! Get subscription filter of stream given xpath, create it if not found
+ * @param[in]  es    Event stream
+ * @param[in]  xpath Filter selector as xpath
+ * @retval     sf    Subscription filter, release with stream_filter_put
+ * @retval     NULL  Error
+ */
+static struct stream_filter *
+stream_filter_get(event_stream_t *es,
+		  char           *xpath)
+{
+    struct stream_filter *sf;
+
+    if ((sf = es->es_filter) != NULL)
+	do {
+	    if (strcmp(sf->sf_xpath, xpath) == 0){
+		sf->sf_refcnt++;
+		return sf;
+	    }
+	    sf = NEXTQ(struct stream_filter *, sf);
+	} while (sf && sf != es->es_filter);
+    if ((sf = malloc(sizeof(*sf))) == NULL){
+	clicon_err(OE_CFG, errno, "malloc");
+	return NULL;
+    }
+    memset(sf, 0, sizeof(*sf));
+    if ((sf->sf_xpath = strdup(xpath)) == NULL){
+	clicon_err(OE_CFG, errno, "strdup");
+	free(sf);
+	return NULL;
+    }
+    if (xpath_parse(xpath, &sf->sf_tree) < 0){
+	free(sf->sf_xpath);
+	free(sf);
+	return NULL;
+    }
+    sf->sf_root = stream_filter_root(sf->sf_tree);
+    sf->sf_refcnt = 1;
+    ADDQ(sf, es->es_filter);
+    return sf;
+}
+
+/*! Release subscription filter, free it if last
+ * @param[in]  es    Event stream
+ * @param[in]  sf    Subscription filter
+ */
+static int
+stream_filter_put(event_stream_t       *es,
+		  struct stream_filter *sf)
+{
+    if (--sf->sf_refcnt > 0)
+	return 0;
+    DELQ(sf, es->es_filter, struct stream_filter *);
+    if (sf->sf_xpath)
+	free(sf->sf_xpath);
+    if (sf->sf_tree)
+	xpath_tree_free(sf->sf_tree);
+    free(sf);
+    return 0;
+}
+
+/*! Check if event matches subscription filter, evaluate filter once per event
+ * @param[in]  es     Event stream, es_gen identifies event
+ * @param[in]  sf     Subscription filter or NULL
+ * @param[in]  xevent Event as XML
+ * @retval     1      Match
+ * @retval     0      No match
+ */
+static int
+stream_filter_match(event_stream_t       *es,
+		    struct stream_filter *sf,
+		    cxobj                *xevent)
+{
+    if (sf == NULL)
+	return 1;
+    if (sf->sf_gen != es->es_gen){
+	sf->sf_gen = es->es_gen;
+	if (sf->sf_root &&
+	    xml_find_type(xevent, NULL, sf->sf_root, CX_ELMNT) == NULL)
+	    sf->sf_match = 0;
+	else
+	    sf->sf_match = xpath_first_tree(xevent, NULL, sf->sf_tree) != NULL;
+    }
+    return sf->sf_match;
+}
+
 /*! Add notification event stream
  * @param[in]  h              Clicon handle
  * @param[in]  name           Name of stream
  * @param[in]  description    Description of stream
  * @param[in]  replay_enabled Set if replay possible in stream
  * @param[in]  retention      For replay buffer how much relative to save
+ * If CLICON_STREAM_REPLAY_LOG is set, events are replayed from a persistent log in
+ * that directory instead of a replay buffer.
+ * If CLICON_STREAM_REPLAY_DIR is set, the replay buffer is mmap:ed from a file in
+ * that directory
  */
 int
 stream_add(clicon_handle   h,
@@ -128,6 +815,8 @@ stream_add(clicon_handle   h,
 {
     int             retval = -1;
     event_stream_t *es;
+    char           *dir;
+    cbuf           *cb = NULL;
 
     if ((es = stream_find(h, name)) != NULL)
 	goto ok;
@@ -147,10 +836,35 @@ stream_add(clicon_handle   h,
     es->es_replay_enabled = replay_enabled;
     if (retention)
 	es->es_retention = *retention;
+    if (replay_enabled &&
+	(dir = clicon_option_str(h, "CLICON_STREAM_REPLAY_LOG")) != NULL){
+	if ((es->es_log = stream_log_open(h, dir, name)) == NULL)
+	    goto done;
+    }
+    else if (replay_enabled &&
+	(dir = clicon_option_str(h, "CLICON_STREAM_REPLAY_DIR")) != NULL){
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	cprintf(cb, "%s/%s.replay", dir, name);
+	if ((es->es_replay.r_fd = open(cbuf_get(cb), O_RDWR|O_CREAT|O_TRUNC,
+				       S_IRUSR|S_IWUSR)) < 0){
+	    clicon_err(OE_UNIX, errno, "open %s", cbuf_get(cb));
+	    goto done;
+	}
+	if ((es->es_replay.r_file = strdup(cbuf_get(cb))) == NULL){
+	    clicon_err(OE_UNIX, errno, "strdup");
+	    close(es->es_replay.r_fd);
+	    goto done;
+	}
+    }
     clicon_stream_append(h, es);
  ok:
     retval = 0;
  done:
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
@@ -162,8 +876,8 @@ int
 stream_delete_all(clicon_handle h,
 		  int           force)
 {
-    struct stream_replay *r;
     struct stream_subscription *ss;
+    struct stream_filter *sf;
     event_stream_t       *es;
     event_stream_t       *head = clicon_stream(h);
     
@@ -176,11 +890,12 @@ stream_delete_all(clicon_handle h,
 	    free(es->es_description);
 	while ((ss = es->es_subscription) != NULL)
 	    stream_ss_rm(h, es, ss, force); /* XXX in some cases leaks memory due to DONT clause in stream_ss_rm() */
-	while ((r = es->es_replay) != NULL){
-	    DELQ(r, es->es_replay, struct stream_replay *);
-	    if (r->r_xml)
-		xml_free(r->r_xml);
-	    free(r);
+	stream_replay_free(&es->es_replay);
+	if (es->es_log)
+	    stream_log_free(es->es_log);
+	while ((sf = es->es_filter) != NULL){
+	    sf->sf_refcnt = 1;
+	    stream_filter_put(es, sf);
 	}
 	free(es);
     }
@@ -247,8 +962,6 @@ stream_timer_setup(int   fd,
     event_stream_t              *es;
     struct stream_subscription  *ss;
     struct stream_subscription  *ss1;
-    struct stream_replay        *r;
-    struct stream_replay        *r1;
     
     clicon_debug(2, "%s", __FUNCTION__);
     /* Go thru callbacks and see if any have timed out, if so remove them 
@@ -277,20 +990,16 @@ stream_timer_setup(int   fd,
 		} while (ss && ss != es->es_subscription);
   /* 2) Go throughreplay buffer and remove entries with passed retention time */
 	    if (timerisset(&es->es_retention) &&
-		(r = es->es_replay) != NULL){
+		es->es_replay.r_len){
 		timersub(&now, &es->es_retention, &tret);
-		do {
-		    if (timercmp(&r->r_tv, &tret, <)){
-			r1 = NEXTQ(struct stream_replay *, r);
-			DELQ(r, es->es_replay, struct stream_replay *);
-			if (r->r_xml)
-			    xml_free(r->r_xml);
-			free(r);
-			r = r1;
-		    }
-		    else
-			r = NEXTQ(struct stream_replay *, r);
-		} while (r && r!=es->es_replay);
+		if (stream_replay_prune(&es->es_replay, &tret) < 0)
+		    goto done;
+	    }
+	    if (timerisset(&es->es_retention) &&
+		es->es_log){
+		timersub(&now, &es->es_retention, &tret);
+		if (stream_log_prune(es->es_log, &tret) < 0)
+		    goto done;
 	    }
 	    es = NEXTQ(struct event_stream *, es);
 	} while (es && es != clicon_stream(h));
@@ -363,13 +1072,22 @@ stream_ss_add(clicon_handle     h,
 	clicon_err(OE_CFG, errno, "strdup");
 	goto done;
     }
+    /* Parse filter once, shared with other subscriptions of stream */
+    if (xpath && strlen(xpath) &&
+	(ss->ss_filter = stream_filter_get(es, xpath)) == NULL)
+	goto done;
     ss->ss_fn     = fn;
     ss->ss_arg    = arg;
     ADDQ(ss, es->es_subscription);
     return ss;
   done:
-    if (ss)
+    if (ss){
+	if (ss->ss_stream)
+	    free(ss->ss_stream);
+	if (ss->ss_xpath)
+	    free(ss->ss_xpath);
 	free(ss);
+    }
     return NULL;
 }
 
@@ -389,6 +1107,10 @@ stream_ss_rm(clicon_handle                h,
 {
     clicon_debug(1, "%s", __FUNCTION__);
     DELQ(ss, es->es_subscription, struct stream_subscription *);
+    if (ss->ss_filter){
+	stream_filter_put(es, ss->ss_filter);
+	ss->ss_filter = NULL;
+    }
     /* Remove from upper layers - close socket etc. */
     (*ss->ss_fn)(h, 1, NULL, ss->ss_arg);
     if (force){
@@ -482,7 +1204,126 @@ stream_ss_delete(clicon_handle     h,
     return retval;
 }
 
+/*! Create shared event encodings of an event being notified
+ * @param[in]  xev   Event as XML
+ * @retval     se    Shared event with reference count 1, free with stream_event_free
+ * @retval     NULL  Error
+ */
+static struct stream_event *
+stream_event_new(cxobj *xev)
+{
+    struct stream_event *se;
+
+    if ((se = malloc(sizeof(*se))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    memset(se, 0, sizeof(*se));
+    se->se_xml = xev;
+    se->se_refcnt = 1;
+    return se;
+}
+
+/*! Get shared encodings of event, if it is being notified to subscriptions
+ * A subscription callback can use this to send the same encoded bytes as all other
+ * subscriptions of the event, instead of encoding it again.
+ * @param[in]  xev   Event as XML given to subscription callback
+ * @retval     se    Shared event, valid during callback, see stream_event_ref
+ * @retval     NULL  Event is not being notified, eg replay
+ * @see send_msg_notify_xml
+ */
+struct stream_event *
+stream_event_get(cxobj *xev)
+{
+    if (_stream_event != NULL && _stream_event->se_xml == xev)
+	return _stream_event;
+    return NULL;
+}
+
+/*! Keep shared event after subscription callback, eg for deferred write
+ * Only encodings made before the callback returns are valid thereafter
+ * @param[in]  se    Shared event
+ * @retval     se    Shared event, free with stream_event_free
+ */
+struct stream_event *
+stream_event_ref(struct stream_event *se)
+{
+    se->se_refcnt++;
+    return se;
+}
+
+/*! Release reference of shared event, free it if last
+ * @param[in]  se    Shared event
+ */
+int
+stream_event_free(struct stream_event *se)
+{
+    int i;
+
+    if (--se->se_refcnt > 0)
+	return 0;
+    for (i=0; i<2; i++)
+	if (se->se_msg[i])
+	    free(se->se_msg[i]);
+    free(se);
+    return 0;
+}
+
+/*! Get notify message of shared event in an encoding, encode it if first
+ * @param[in]  se     Shared event
+ * @param[in]  format FORMAT_XML or FORMAT_JSON, see enum format_enum
+ * @retval     msg    Encoded notify message, owned by se
+ * @retval     NULL   Error
+ */
+struct clicon_msg *
+stream_event_msg(struct stream_event *se,
+		 int                  format)
+{
+    struct clicon_msg *msg = NULL;
+    cbuf              *cb = NULL;
+    int                i;
+
+    switch (format){
+    case FORMAT_XML:
+	i = 0;
+	break;
+    case FORMAT_JSON:
+	i = 1;
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Encoding %s of event not supported",
+		   format_int2str(format));
+	goto done;
+	break;
+    }
+    if ((msg = se->se_msg[i]) != NULL)
+	goto done;
+    if (se->se_xml == NULL){
+	clicon_err(OE_XML, EINVAL, "Event is not encoded and XML is no longer valid");
+	goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (i == 0){
+	if (clicon_xml2cbuf(cb, se->se_xml, 0, 0, -1) < 0)
+	    goto done;
+    }
+    else if (xml2json_cbuf(cb, se->se_xml, 0) < 0)
+	goto done;
+    if ((msg = clicon_msg_encode(0, "%s", cbuf_get(cb))) == NULL)
+	goto done;
+    se->se_msg[i] = msg;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return msg;
+}
+
 /*! Stream notify event and distribute to all registered callbacks
+ * The event is encoded at most once per encoding for all subscriptions, see
+ * stream_event_get
  * @param[in]  h       Clicon handle
  * @param[in]  stream  Name of event stream. CLICON is predefined as LOG stream
  * @param[in]  tv      Timestamp. Dont notify if subscription has stoptime<tv
@@ -500,8 +1341,14 @@ stream_notify1(clicon_handle   h,
 {
     int                         retval = -1;
     struct stream_subscription *ss;
+    struct stream_event        *se;
+    struct stream_event        *se0 = _stream_event; /* In case of recursion */
     
     clicon_debug(2, "%s", __FUNCTION__);
+    if ((se = stream_event_new(xevent)) == NULL)
+	goto done;
+    _stream_event = se;
+    es->es_gen++; /* New event for subscription filters */
     /* Go thru all subscriptions and find matches */
     if ((ss = es->es_subscription) != NULL)
 	do {
@@ -514,10 +1361,8 @@ stream_notify1(clicon_handle   h,
 		    goto done;
 		ss = ss1;
 	    }
-	    else{  /* xpath match */
-		if (ss->ss_xpath == NULL ||
-		    strlen(ss->ss_xpath)==0 ||
-		    xpath_first(xevent, NULL, "%s", ss->ss_xpath) != NULL)
+	    else{  /* xpath match, filter is evaluated once per event */
+		if (stream_filter_match(es, ss->ss_filter, xevent))
 		    if ((*ss->ss_fn)(h, 0, xevent, ss->ss_arg) < 0)
 			goto done;
 		ss = NEXTQ(struct stream_subscription *, ss);
@@ -525,6 +1370,11 @@ stream_notify1(clicon_handle   h,
 	} while (es->es_subscription && ss != es->es_subscription);
     retval = 0;
   done:
+    _stream_event = se0;
+    if (se){
+	se->se_xml = NULL; /* Not valid after notification, may be kept by subscription */
+	stream_event_free(se);
+    }
     return retval;
 }
 
@@ -595,7 +1445,6 @@ stream_notify(clicon_handle h,
     if (es->es_replay_enabled){
 	if (stream_replay_add(es, &tv, xev) < 0)
 	    goto done;
-	xev = NULL; /* xml stored in replay_add and should not be freed */
     }
  ok:
     retval = 0;
@@ -664,7 +1513,6 @@ stream_notify_xml(clicon_handle h,
     if (es->es_replay_enabled){
 	if (stream_replay_add(es, &tv, xev) < 0)
 	    goto done;
-	xev = NULL; /* xml stored in replay_add and should not be freed */
     }
  ok:
     retval = 0;
@@ -703,69 +1551,124 @@ stream_notify_xml(clicon_handle h,
          zones.
 	 
  * Assume no future sample timestamps.
+ * Events are parsed from the replay buffer one at a time
  */
 static int
 stream_replay_notify(clicon_handle               h,
 		     event_stream_t             *es,
 		     struct stream_subscription *ss)
 {
-    int                   retval = -1;
-    struct stream_replay *r;
+    int                         retval = -1;
+    struct stream_replay       *r = &es->es_replay;
+    struct stream_replay_entry *re;
+    size_t                      i;
+    cxobj                      *xt = NULL;
 
     /* If <startTime> is not present, this is not a replay */
     if (!timerisset(&ss->ss_starttime))
 	goto ok;
     if (!es->es_replay_enabled)
 	goto ok;
-    /* Get replay linked list */
-    if ((r = es->es_replay) == NULL)
+    if (es->es_log){
+	if (stream_log_replay(h, es->es_log, ss) < 0)
+	    goto done;
 	goto ok;
-    /* First loop to skip until start */
-    do {
-	if (timercmp(&r->r_tv, &ss->ss_starttime, >=))
-	    break;
-	r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
-    if (r == NULL)
-	goto ok; /* No samples to replay */
-    /* Then notify until stop */
-    do {
+    }
+    /* Skip until start using time index, then notify until stop */
+    for (i = stream_replay_search(r, &ss->ss_starttime); i < r->r_len; i++){
+	re = REPLAY_ENTRY(r, i);
 	if (timerisset(&ss->ss_stoptime) &&
-	    timercmp(&r->r_tv, &ss->ss_stoptime, >))
+	    timercmp(&re->re_tv, &ss->ss_stoptime, >))
 	    break;
-	if ((*ss->ss_fn)(h, 0, r->r_xml, ss->ss_arg) < 0)
+	if (clixon_xml_parse_string(r->r_data + re->re_off, YB_NONE, NULL, &xt, NULL) < 0)
 	    goto done;
-	r = NEXTQ(struct stream_replay *, r);
-    } while (r && r!=es->es_replay);
+	if (xml_rootchild(xt, 0, &xt) < 0)
+	    goto done;
+	if ((*ss->ss_fn)(h, 0, xt, ss->ss_arg) < 0)
+	    goto done;
+	xml_free(xt);
+	xt = NULL;
+    }
  ok:
     retval = 0;
  done:
+    if (xt)
+	xml_free(xt);
     return retval;
 }
 
 /*! Add replay sample to stream with timestamp
+ * The event is serialized and appended to the replay ring buffer, which grows if full,
+ * or to the persistent replay log if the stream has one
  * @param[in] es   Stream
- * @param[in] tv   Timestamp
- * @param[in] xv   XML
+ * @param[in] tv   Timestamp, assume not earlier than last sample
+ * @param[in] xv   XML, is not stored in the buffer and should be freed by caller
  */
 int
 stream_replay_add(event_stream_t *es,
 		  struct timeval *tv,
 		  cxobj          *xv)
 {
-    int                   retval = -1;
-    struct stream_replay *new;
+    int                         retval = -1;
+    struct stream_replay       *r = &es->es_replay;
+    struct stream_replay_entry *vec;
+    struct stream_replay_entry *re;
+    cbuf                       *cb = NULL;
+    size_t                      len;
+    size_t                      off = 0;
+    size_t                      size;
+    size_t                      i;
 
-    if ((new = malloc(sizeof *new)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc");
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (clicon_xml2cbuf(cb, xv, 0, 0, -1) < 0)
 	goto done;
+    if (es->es_log){
+	if (stream_log_append(es->es_log, tv, cbuf_get(cb), cbuf_len(cb)) < 0)
+	    goto done;
+	goto ok;
     }
-    memset(new, 0, (sizeof *new));
-    new->r_tv = *tv;
-    new->r_xml = xv;
-    ADDQ(new, es->es_replay);
+    len = cbuf_len(cb) + 1;
+    /* Grow time index if full */
+    if (r->r_len == r->r_vecmax){
+	size = r->r_vecmax ? 2*r->r_vecmax : STREAM_REPLAY_VEC_SIZE;
+	if ((vec = malloc(size*sizeof(*vec))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    goto done;
+	}
+	for (i=0; i<r->r_len; i++)
+	    vec[i] = *REPLAY_ENTRY(r, i);
+	if (r->r_vec)
+	    free(r->r_vec);
+	r->r_vec = vec;
+	r->r_vecmax = size;
+	r->r_head = 0;
+    }
+    /* Grow data ring if no space */
+    if (stream_replay_space(r, len, &off) == 0){
+	size = r->r_datamax ? 2*r->r_datamax : STREAM_REPLAY_DATA_SIZE;
+	while (size < r->r_datamax + len)
+	    size *= 2;
+	if (stream_replay_resize(r, size) < 0)
+	    goto done;
+	if (stream_replay_space(r, len, &off) == 0){
+	    clicon_err(OE_UNIX, 0, "No space in replay buffer (shouldnt happen)");
+	    goto done;
+	}
+    }
+    memcpy(r->r_data + off, cbuf_get(cb), len);
+    re = &r->r_vec[(r->r_head + r->r_len) % r->r_vecmax];
+    re->re_tv = *tv;
+    re->re_off = off;
+    re->re_len = len;
+    r->r_len++;
+ ok:
     retval = 0;
  done:
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
@@ -890,74 +1793,241 @@ curl_get_cb(void *ptr,
     return len;
 }
 
-/*! Send a curl POST request
+/* Timeout of a publish post [s] */
+#define STREAM_PUB_TIMEOUT_S 10
+
+/* A publish post in progress */
+struct stream_pub{
+    qelem_t        sp_q;    /* queue header */
+    CURL          *sp_curl; /* Easy handle of post */
+    struct curlbuf sp_buf;  /* Reply data */
+    char           sp_err[CURL_ERROR_SIZE];
+};
+
+/* Posts are made without blocking by a curl multi handle driven by the event loop */
+static CURLM             *_pub_multi = NULL;
+static struct stream_pub *_pub_list = NULL;  /* Posts in progress */
+static int                _pub_len = 0;      /* Number of posts in progress */
+static uint64_t           _pub_sent = 0;     /* Posts done */
+static uint64_t           _pub_dropped = 0;  /* Events dropped since queue is full */
+static uint64_t           _pub_failed = 0;   /* Posts failed */
+
+/*! Free publish post
+ * @param[in]  sp  Publish post
+ */
+static int
+stream_pub_free(struct stream_pub *sp)
+{
+    DELQ(sp, _pub_list, struct stream_pub *);
+    _pub_len--;
+    if (sp->sp_curl){
+	if (_pub_multi)
+	    curl_multi_remove_handle(_pub_multi, sp->sp_curl);
+	curl_easy_cleanup(sp->sp_curl);
+    }
+    if (sp->sp_buf.b_buf)
+	free(sp->sp_buf.b_buf);
+    free(sp);
+    return 0;
+}
+
+/*! Let curl act on a socket or timeout, then free done posts
+ * @param[in]  fd     Socket, or CURL_SOCKET_TIMEOUT
+ * @param[in]  flags  CURL_CSELECT_IN or CURL_CSELECT_OUT
+ */
+static int
+stream_pub_action(int fd,
+		  int flags)
+{
+    int                running;
+    int                nr;
+    CURLMsg           *msg;
+    struct stream_pub *sp;
+
+    if (_pub_multi == NULL)
+	return 0;
+    curl_multi_socket_action(_pub_multi, fd, flags, &running);
+    while ((msg = curl_multi_info_read(_pub_multi, &nr)) != NULL){
+	if (msg->msg != CURLMSG_DONE)
+	    continue;
+	sp = NULL;
+	curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&sp);
+	if (sp == NULL)
+	    continue;
+	if (msg->data.result != CURLE_OK){
+	    _pub_failed++;
+	    clicon_debug(1, "%s: curl: %s(%d)", __FUNCTION__,
+			 sp->sp_err, msg->data.result);
+	}
+	else{
+	    _pub_sent++;
+	    if (sp->sp_buf.b_buf)
+		clicon_debug(1, "%s: %s", __FUNCTION__, sp->sp_buf.b_buf);
+	}
+	stream_pub_free(sp);
+    }
+    return 0;
+}
+
+/*! Socket of publish post is readable
+ */
+static int
+stream_pub_read_cb(int   fd,
+		   void *arg)
+{
+    return stream_pub_action(fd, CURL_CSELECT_IN);
+}
+
+/*! Socket of publish post is writable
+ */
+static int
+stream_pub_write_cb(int   fd,
+		    void *arg)
+{
+    return stream_pub_action(fd, CURL_CSELECT_OUT);
+}
+
+/*! Timeout of curl multi handle
+ */
+static int
+stream_pub_timeout_cb(int   fd,
+		      void *arg)
+{
+    return stream_pub_action(CURL_SOCKET_TIMEOUT, 0);
+}
+
+/*! Curl socket callback: register socket of a post in the event loop
+ * The events registered on a socket are kept as socket pointer in curl
+ */
+static int
+stream_pub_socket_fn(CURL         *easy,
+		     curl_socket_t s,
+		     int           what,
+		     void         *userp,
+		     void         *socketp)
+{
+    int old = (int)(intptr_t)socketp; /* CURL_POLL_IN/OUT registered */
+    int new = (what == CURL_POLL_REMOVE) ? 0 : what;
+
+    if ((old & CURL_POLL_IN) && !(new & CURL_POLL_IN))
+	clixon_event_unreg_fd(s, stream_pub_read_cb);
+    if ((old & CURL_POLL_OUT) && !(new & CURL_POLL_OUT))
+	clixon_event_unreg_fd(s, stream_pub_write_cb);
+    if (!(old & CURL_POLL_IN) && (new & CURL_POLL_IN) &&
+	clixon_event_reg_fd(s, stream_pub_read_cb, NULL, "stream publish") < 0)
+	return -1;
+    if (!(old & CURL_POLL_OUT) && (new & CURL_POLL_OUT) &&
+	clixon_event_reg_fd_write(s, stream_pub_write_cb, NULL, "stream publish") < 0)
+	return -1;
+    if (what != CURL_POLL_REMOVE)
+	curl_multi_assign(_pub_multi, s, (void*)(intptr_t)new);
+    return 0;
+}
+
+/*! Curl timer callback: register timeout of curl multi handle in the event loop
+ * @param[in]  timeout_ms  Milliseconds from now, or -1 to remove timeout
+ */
+static int
+stream_pub_timer_fn(CURLM *multi,
+		    long   timeout_ms,
+		    void  *userp)
+{
+    struct timeval t;
+    struct timeval t1;
+
+    clixon_event_unreg_timeout(stream_pub_timeout_cb, NULL);
+    if (timeout_ms >= 0){
+	gettimeofday(&t, NULL);
+	t1.tv_sec = timeout_ms/1000;
+	t1.tv_usec = (timeout_ms%1000)*1000;
+	timeradd(&t, &t1, &t);
+	if (clixon_event_reg_timeout(t, stream_pub_timeout_cb, NULL,
+				     "stream publish timeout") < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Start a curl POST request without blocking
+ * @param[in]  url         URL
+ * @param[in]  postfields  Data to post, is copied
+ * @param[in]  max         Max number of posts in progress, 0 means no limit
  * @retval  -1   fatal error
- * @retval   0   expect set but did not expected return or other non-fatal error
- * @retval   1   ok
- * Note: curl_easy_perform blocks
- * Note: New handle is created every time, the handle can be re-used for better TCP performance
- * @see same function (url_post) in grideye_curl.c
+ * @retval   0   dropped since max posts are in progress, or other non-fatal error
+ * @retval   1   ok, post is started
+ * The post is done and freed in stream_pub_action.
  */
 static int
 url_post(char *url, 
-	 char *postfields, 
-	 char **getdata)
+	 char *postfields,
+	 int   max)
 {
-    int            retval = -1;
-    CURL          *curl = NULL;
-    char          *err = NULL;
-    struct curlbuf cb = {0, };
-    CURLcode       errcode;
+    int                retval = -1;
+    struct stream_pub *sp = NULL;
+    CURL              *curl;
 
-    /* Try it with  curl -X PUT -d '*/
     clicon_debug(1, "%s:  curl -X POST -d '%s' %s",
 	__FUNCTION__, postfields, url);
-    /* Set up curl for doing the communication with the controller */
-    if ((curl = curl_easy_init()) == NULL) {
-	clicon_debug(1, "curl_easy_init");
+    if (_pub_multi == NULL){
+	clicon_err(OE_PLUGIN, EINVAL, "stream_publish_init not called");
 	goto done;
     }
-    if ((err = malloc(CURL_ERROR_SIZE)) == NULL) {
-	clicon_debug(1, "%s: malloc", __FUNCTION__);
+    if (max && _pub_len >= max){ /* Drop new event, posts in progress are kept */
+	_pub_dropped++;
+	clicon_debug(1, "%s: %d posts in progress, event dropped", __FUNCTION__, _pub_len);
+	retval = 0;
+	goto done;
+    }
+    if ((sp = malloc(sizeof(*sp))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
 	goto done;
     }
+    memset(sp, 0, sizeof(*sp));
+    ADDQ(sp, _pub_list);
+    _pub_len++;
+    if ((curl = curl_easy_init()) == NULL) {
+	clicon_debug(1, "curl_easy_init");
+	retval = 0;
+	goto done;
+    }
+    sp->sp_curl = curl;
     curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, sp);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_get_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &cb);
-    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, err);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sp->sp_buf);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, sp->sp_err);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, STREAM_PUB_TIMEOUT_S);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
     curl_easy_setopt(curl, CURLOPT_POST, 1);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, postfields);
     curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, strlen(postfields));
-
+    curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, postfields);
     if (clicon_debug_get())
 	curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);   
-    if ((errcode = curl_easy_perform(curl)) != CURLE_OK){
-	clicon_debug(1, "%s: curl: %s(%d)", __FUNCTION__, err, errcode);
+    if (curl_multi_add_handle(_pub_multi, curl) != CURLM_OK){
+	clicon_debug(1, "curl_multi_add_handle");
 	retval = 0;
-	goto done; 
-    }
-    if (getdata && cb.b_buf){
-	*getdata = cb.b_buf;
-	cb.b_buf = NULL;
+	goto done;
     }
+    sp = NULL; /* In progress */
     retval = 1;
   done:
-    if (err)
-	free(err);
-    if (cb.b_buf)
-	free(cb.b_buf);
-    if (curl)
-	curl_easy_cleanup(curl);   /* cleanup */ 
+    if (sp){
+	_pub_failed++;
+	stream_pub_free(sp);
+    }
     return retval;
 }
 
 /*! Stream callback for example stream notification 
- * Push via curl_post to publish stream event
+ * Push via curl_post to publish stream event, the post is made asynchronously
+ * and at most CLICON_STREAM_PUB_QUEUE posts are in progress, new events are dropped
+ * if more
  * @param[in]  h     Clicon handle
  * @param[in]  op    Operation: 0 OK, 1 Close
  * @param[in]  event Event as XML
  * @param[in]  arg   Extra argument provided in stream_ss_add
  * @see stream_ss_add
+ * @see stream_publish_stats
  */
 static int 
 stream_publish_cb(clicon_handle h, 
@@ -969,8 +2039,8 @@ stream_publish_cb(clicon_handle h,
     cbuf *u = NULL; /* stream pub (push) url */
     cbuf *d = NULL; /* (XML) data to push */
     char *pub_prefix;
-    char *result = NULL;
     char *stream = (char*)arg;
+    int   max = 0;
 
     clicon_debug(1, "%s", __FUNCTION__); 
     if (op != 0)
@@ -992,12 +2062,12 @@ stream_publish_cb(clicon_handle h,
     }
     if (clicon_xml2cbuf(d, event, 0, 0, -1) < 0)
 	goto done;
+    if (clicon_option_exists(h, "CLICON_STREAM_PUB_QUEUE"))
+	max = clicon_option_int(h, "CLICON_STREAM_PUB_QUEUE");
     if (url_post(cbuf_get(u),     /* url+stream */
 		 cbuf_get(d),     /* postfields */
-		 &result) < 0)    /* result as xml */
+		 max) < 0)
 	goto done;
-    if (result)
-	clicon_debug(1, "%s: %s", __FUNCTION__, result);
  ok:
     retval = 0;
  done:
@@ -1005,8 +2075,6 @@ stream_publish_cb(clicon_handle h,
 	cbuf_free(u);
     if (d)
 	cbuf_free(d);
-    if (result)
-	free(result);
     return retval;
 }
 #endif /* CLIXON_PUBLISH_STREAMS */
@@ -1042,6 +2110,12 @@ stream_publish_init()
 	clicon_err(OE_PLUGIN, errno, "curl_global_init");
 	goto done;
     }    
+    if ((_pub_multi = curl_multi_init()) == NULL){
+	clicon_err(OE_PLUGIN, errno, "curl_multi_init");
+	goto done;
+    }
+    curl_multi_setopt(_pub_multi, CURLMOPT_SOCKETFUNCTION, stream_pub_socket_fn);
+    curl_multi_setopt(_pub_multi, CURLMOPT_TIMERFUNCTION, stream_pub_timer_fn);
     retval = 0;
  done:
     return retval;
@@ -1054,7 +2128,74 @@ int
 stream_publish_exit()
 {
 #ifdef CLIXON_PUBLISH_STREAMS
+    clicon_debug(1, "%s sent:%" PRIu64 " dropped:%" PRIu64 " failed:%" PRIu64,
+		 __FUNCTION__, _pub_sent, _pub_dropped, _pub_failed);
+    while (_pub_list != NULL)
+	stream_pub_free(_pub_list);
+    if (_pub_multi){
+	curl_multi_cleanup(_pub_multi);
+	_pub_multi = NULL;
+    }
+    clixon_event_unreg_timeout(stream_pub_timeout_cb, NULL);
     curl_global_cleanup();
 #endif 
     return 0;
 }
+
+/*! Get number of events and alloced memory of replay buffers of all streams
+ * @param[in]     h    Clicon handle
+ * @param[in,out] nrp  Number of replay events, incremented
+ * @param[in,out] szp  Size in bytes of replay time index and data rings, incremented
+ * @retval        0    OK
+ * A data ring mmap:ed from a file, see CLICON_STREAM_REPLAY_DIR, is included.
+ * Of a persistent replay log, see CLICON_STREAM_REPLAY_LOG, events appended since
+ * started and the time index of segments are included
+ */
+int
+stream_replay_stats(clicon_handle h,
+		    uint64_t     *nrp,
+		    size_t       *szp)
+{
+    event_stream_t            *es0;
+    event_stream_t            *es;
+    struct stream_log_segment *ls;
+
+    if ((es = es0 = clicon_stream(h)) != NULL)
+	do {
+	    *nrp += es->es_replay.r_len;
+	    if (szp)
+		*szp += es->es_replay.r_vecmax*sizeof(struct stream_replay_entry) +
+		    es->es_replay.r_datamax;
+	    if (es->es_log){
+		*nrp += es->es_log->l_nr;
+		if (szp && (ls = es->es_log->l_seg) != NULL)
+		    do {
+			*szp += sizeof(*ls);
+			ls = NEXTQ(struct stream_log_segment *, ls);
+		    } while (ls != es->es_log->l_seg);
+	    }
+	    es = NEXTQ(struct event_stream *, es);
+	} while (es && es != es0);
+    return 0;
+}
+
+/*! Get counters of stream publishing
+ * @param[out] sent     Number of events posted
+ * @param[out] dropped  Number of events dropped since CLICON_STREAM_PUB_QUEUE posts 
+ *                      were in progress
+ * @param[out] failed   Number of posts that failed
+ */
+int
+stream_publish_stats(uint64_t *sent,
+		     uint64_t *dropped,
+		     uint64_t *failed)
+{
+#ifdef CLIXON_PUBLISH_STREAMS
+    *sent = _pub_sent;
+    *dropped = _pub_dropped;
+    *failed = _pub_failed;
+#else
+    *sent = *dropped = *failed = 0;
+#endif 
+    return 0;
+}
@@ -380,11 +380,7 @@ xml_chardata_encode(char      **escp,
     int     retval = -1;
     char   *str = NULL;  /* Expanded format string w stdarg */
     int     fmtlen;
-    char   *esc = NULL;
-    int     l;
-    int     len;
-    int     i, j;
-    int     cdata; /* when set, skip encoding */
+    cbuf   *cb = NULL;
     va_list args;
     
     /* Two steps: (1) read in the complete format string */
@@ -402,144 +398,130 @@ xml_chardata_encode(char      **escp,
     /* Now str is the combined fmt + ... */
 
     /* Step (2) encode and expand str --> enc */
-    /* First compute length (do nothing) */
-    len = 0; cdata = 0;
-    for (i=0; i<strlen(str); i++){
-	if (cdata){
-	    if (strncmp(&str[i], "]]>", strlen("]]>")) == 0)
-		cdata = 0;
-	    len++;
-	}
-	else
-	    switch (str[i]){
-	    case '&':
-		len += strlen("&amp;");
-		break;
-	    case '<':
-		if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		    len++;
-		    cdata++;
-		}
-		else
-		    len += strlen("&lt;");
-		break;
-	    case '>':
-		len += strlen("&gt;");
-		break;
-	    default:
-		len++;
-	    }
-    }
-    len++; /* trailing \0 */
-    /* We know length, allocate encoding buffer  */
-    if ((esc = malloc(len)) == NULL){
-	clicon_err(OE_UNIX, errno, "malloc"); 
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new"); 
 	goto done;
     }
-    memset(esc, 0, len);
-
-    /* Same code again, but now actually encode into output buffer */
-    j = 0; cdata = 0;
-    for (i=0; i<strlen(str); i++){
-	if (cdata){
-	    if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-		cdata = 0;
-		esc[j++] = str[i++];
-		esc[j++] = str[i++];
-	    }
-	    esc[j++] = str[i];
-	}
-	else
-	switch (str[i]){
-	case '&':
-	    if ((l=snprintf(&esc[j], 6, "&amp;")) < 0){
-		clicon_err(OE_UNIX, errno, "snprintf");
-		goto done;
-	    }
-	    j += l;
-	    break;
-	case '<':
-	    if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		esc[j++] = str[i];
-		cdata++;
-		break;
-	    }
-	    if ((l=snprintf(&esc[j], 5, "&lt;")) < 0){
-		clicon_err(OE_UNIX, errno, "snprintf");
-		goto done;
-	    }
-	    j += l;
-	    break;
-	case '>':
-	    if ((l=snprintf(&esc[j], 5, "&gt;")) < 0){
-		clicon_err(OE_UNIX, errno, "snprintf");
-		goto done;
-	    }
-	    j += l;
-	    break;
-	default:
-	    esc[j++] = str[i];
-	}
+    if (xml_chardata_cbuf_append(cb, str) < 0)
+	goto done;
+    if ((*escp = strdup(cbuf_get(cb))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup"); 
+	goto done;
     }
-    *escp = esc;
     retval = 0;
  done:
     if (str)
 	free(str);
-    if (retval < 0 && esc)
-	free(esc);
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
-/*! Escape characters according to XML definition and append to cbuf
+/*! Append n spaces of indentation to cbuf
+ *
+ * Faster than cprintf(cb, "%*s", n, "") since no format string is parsed
  * @param[in]   cb     CLIgen buf
+ * @param[in]   n      Number of spaces
+ * @retval      0      OK
+ * @retval     -1      Error
+ */
+int
+clicon_cbuf_indent(cbuf *cb,
+		   int   n)
+{
+    static const char spaces[] = "                                                                ";
+    int               len;
+
+    while (n > 0){
+	len = n < sizeof(spaces)-1 ? n : sizeof(spaces)-1;
+	if (cbuf_append_buf(cb, (void *)spaces, len) < 0)
+	    return -1;
+	n -= len;
+    }
+    return 0;
+}
+
+/*! Escape characters according to XML definition and write the result with a callback
+ *
+ * The string is scanned once. Each run of characters that need no escaping, and each
+ * CDATA section, is written with one call. The runs are found with strcspn and strstr,
+ * which are vectorized in common C libraries.
  * @param[in]   str    Not-encoded input string
- * @see xml_chardata_encode for the generic function
+ * @param[in]   fn     Write callback, called with a segment and its length
+ * @param[in]   arg    Argument to callback
+ * @retval      0      OK
+ * @retval     -1      Error from callback
+ * @see xml_chardata_encode for the encoding
  */
 int
-xml_chardata_cbuf_append(cbuf *cb,
-			 char *str)
+xml_chardata_write(const char *str,
+		   int       (*fn)(void *arg, const char *s, size_t len),
+		   void       *arg)
 {
-    int  retval = -1;
-    int  i;
-    int  cdata; /* when set, skip encoding */
-
-    /* The orignal of this code is in xml_chardata_encode */
-    /* Step: encode and expand str --> enc */
-    /* Same code again, but now actually encode into output buffer */
-    cdata = 0;
-    for (i=0; i<strlen(str); i++){
-	if (cdata){
-	    if (strncmp(&str[i], "]]>", strlen("]]>")) == 0){
-		cdata = 0;
-		cbuf_append(cb, str[i++]);
-		cbuf_append(cb, str[i++]);
-	    }
-	    cbuf_append(cb, str[i]);
+    const char *s = str;
+    const char *e;
+    size_t      n;
+
+    while (*s != '\0'){
+	if ((n = strcspn(s, "&<>")) > 0){
+	    if ((*fn)(arg, s, n) < 0)
+		return -1;
+	    s += n;
 	}
-	else
-	switch (str[i]){
+	switch (*s){
 	case '&':
-	    cbuf_append_str(cb, "&amp;");
+	    if ((*fn)(arg, "&amp;", strlen("&amp;")) < 0)
+		return -1;
+	    s++;
 	    break;
 	case '<':
-	    if (strncmp(&str[i], "<![CDATA[", strlen("<![CDATA[")) == 0){
-		cbuf_append(cb, str[i]);
-		cdata++;
+	    if (strncmp(s, "<![CDATA[", strlen("<![CDATA[")) == 0){
+		/* Not encoded up to and including end of CDATA section */
+		if ((e = strstr(s + strlen("<![CDATA["), "]]>")) != NULL)
+		    n = e + strlen("]]>") - s;
+		else
+		    n = strlen(s);
+		if ((*fn)(arg, s, n) < 0)
+		    return -1;
+		s += n;
 		break;
 	    }
-	    cbuf_append_str(cb, "&lt;");
+	    if ((*fn)(arg, "&lt;", strlen("&lt;")) < 0)
+		return -1;
+	    s++;
 	    break;
 	case '>':
-	    cbuf_append_str(cb, "&gt;");
+	    if ((*fn)(arg, "&gt;", strlen("&gt;")) < 0)
+		return -1;
+	    s++;
+	    break;
+	default: /* end of string */
 	    break;
-	default:
-	    cbuf_append(cb, str[i]);
 	}
     }
-    retval = 0;
-    // done:
-    return retval;
+    return 0;
+}
+
+/*! Append segment to cbuf, callback of xml_chardata_write
+ */
+static int
+xml_chardata_cbuf_fn(void       *arg,
+		     const char *s,
+		     size_t      len)
+{
+    return cbuf_append_buf((cbuf *)arg, (void *)s, len);
+}
+
+/*! Escape characters according to XML definition and append to cbuf
+ * @param[in]   cb     CLIgen buf
+ * @param[in]   str    Not-encoded input string
+ * @see xml_chardata_encode for the generic function
+ */
+int
+xml_chardata_cbuf_append(cbuf *cb,
+			 char *str)
+{
+    return xml_chardata_write(str, xml_chardata_cbuf_fn, cb);
 }
 
 /*! Split a string into a cligen variable vector using 1st and 2nd delimiter
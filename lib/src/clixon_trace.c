@@ -0,0 +1,210 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, indicate
+  your decision by deleting the provisions above and replace them with the 
+  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ *
+ * Tracing of spans of a request across frontend and backend processes.
+ * The frontend sets a trace id per request (eg restconf), the id is sent to the backend
+ * as trace-id attribute of the internal <rpc> message and the backend uses it for its
+ * spans of the request. Each completed span is reported to a trace sink callback,
+ * which is NULL by default, so that tracing only costs a test of a pointer.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <syslog.h>
+#include <time.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_trace.h"
+
+/* Trace sink, NULL if tracing is disabled */
+clixon_trace_sink *_clixon_trace_sink_fn = NULL;
+
+/* Argument of trace sink */
+static void *_clixon_trace_sink_arg = NULL;
+
+/* Trace id of current request, 0 if none */
+static uint64_t _clixon_trace_id = 0;
+
+/*! Set trace sink, enabling or disabling tracing
+ * @param[in]  fn    Trace sink callback, or NULL to disable tracing
+ * @param[in]  arg   Argument given to fn
+ * @retval     0     OK
+ * @code
+ *   clixon_trace_sink_set(clixon_trace_sink_log, NULL);
+ * @endcode
+ */
+int
+clixon_trace_sink_set(clixon_trace_sink *fn,
+		      void              *arg)
+{
+    _clixon_trace_sink_fn = fn;
+    _clixon_trace_sink_arg = arg;
+    return 0;
+}
+
+/*! Trace sink logging each span with its duration
+ * Enabled with option CLICON_TRACE_LOG
+ * @see clixon_trace_sink
+ */
+int
+clixon_trace_sink_log(void            *arg,
+		      uint64_t         id,
+		      const char      *span,
+		      const char      *name,
+		      struct timespec *t0,
+		      struct timespec *t1)
+{
+    int64_t us;
+
+    us = (t1->tv_sec - t0->tv_sec)*1000000 + (t1->tv_nsec - t0->tv_nsec)/1000;
+    clicon_log(LOG_INFO, "trace %016" PRIx64 " %s%s%s %" PRId64 "us",
+	       id, span, name?" ":"", name?name:"", us);
+    return 0;
+}
+
+/*! Get trace id of current request
+ * @retval  id   Trace id, 0 if no request is traced
+ */
+uint64_t
+clixon_trace_id_get(void)
+{
+    return _clixon_trace_id;
+}
+
+/*! Set trace id of current request
+ * @param[in]  id    Trace id, 0 to end tracing of request
+ * @retval     0     OK
+ */
+int
+clixon_trace_id_set(uint64_t id)
+{
+    _clixon_trace_id = id;
+    return 0;
+}
+
+/*! Create a new random trace id
+ * @retval  id   Trace id, not 0
+ */
+uint64_t
+clixon_trace_id_new(void)
+{
+    static int     seeded = 0;
+    struct timeval tv;
+    uint64_t       id;
+
+    if (!seeded){
+	gettimeofday(&tv, NULL);
+	srandom(tv.tv_sec ^ tv.tv_usec ^ getpid());
+	seeded++;
+    }
+    do {
+	id = ((uint64_t)random() << 33) ^ ((uint64_t)random() << 2) ^ (uint64_t)random();
+    } while (id == 0);
+    return id;
+}
+
+/*! Parse a trace id from a string
+ * The id is hexadecimal, only the last 16 digits are used, so it can be the trace-id of
+ * a W3C traceparent header.
+ * @param[in]  str   String, eg "4bf92f3577b34da6a3ce929d0e0e4736"
+ * @param[out] id    Trace id
+ * @retval     1     OK
+ * @retval     0     Invalid string
+ */
+int
+clixon_trace_id_parse(const char *str,
+		      uint64_t   *id)
+{
+    size_t   len;
+    size_t   i;
+    uint64_t v = 0;
+    char     c;
+
+    if (str == NULL || (len = strlen(str)) == 0)
+	return 0;
+    i = len > 16 ? len - 16 : 0;
+    for (; i<len; i++){
+	c = str[i];
+	if (c >= '0' && c <= '9')
+	    v = (v << 4) | (c - '0');
+	else if (c >= 'a' && c <= 'f')
+	    v = (v << 4) | (c - 'a' + 10);
+	else if (c >= 'A' && c <= 'F')
+	    v = (v << 4) | (c - 'A' + 10);
+	else
+	    return 0;
+    }
+    if (v == 0)
+	return 0;
+    *id = v;
+    return 1;
+}
+
+/*! Report a completed span to the trace sink
+ * @param[in]  t0    Monotonic time when span started
+ * @param[in]  span  Span
+ * @param[in]  name  Detail of span, or NULL
+ * @retval     0     OK
+ * @note Use clixon_trace_end() which only calls this if tracing is enabled
+ */
+int
+clixon_trace_span(struct timespec *t0,
+		  const char      *span,
+		  const char      *name)
+{
+    struct timespec t1;
+
+    if (_clixon_trace_sink_fn == NULL)
+	return 0;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if (_clixon_trace_sink_fn(_clixon_trace_sink_arg, _clixon_trace_id, span, name, t0, &t1) < 0)
+	clicon_log(LOG_WARNING, "%s: trace sink failed for span %s", __FUNCTION__, span);
+    return 0;
+}
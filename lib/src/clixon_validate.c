@@ -53,6 +53,8 @@
 #include <assert.h>
 #include <arpa/inet.h>
 #include <sys/param.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 
 /* cligen */
@@ -71,16 +73,176 @@
 #include "clixon_xml.h"
 #include "clixon_netconf_lib.h"
 #include "clixon_options.h"
+#include "clixon_data.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xml_io.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_yang_module.h"
 #include "clixon_yang_type.h"
+#include "clixon_yang_dep.h"
 #include "clixon_xml_map.h"
 #include "clixon_validate.h"
 
+/* Key of per-validation leafref target index in clicon_data, see validate_leafref_index */
+#define VALIDATE_LEAFREF_INDEX "validate-leafref-index"
+
+/*! Start a per-validation index of leafref targets
+ *
+ * While the index is active, the target values of a leafref path are collected once
+ * in a hash set, which is used for all leafref instances with the same path and
+ * context, instead of evaluating the path for each instance.
+ * The tree may not be changed while the index is active.
+ * @param[in]  h   Clicon handle
+ * @retval     1   Index started, end with validate_leafref_index_end
+ * @retval     0   Index already active (nested validation)
+ * @retval    -1   Error
+ */
+static int
+validate_leafref_index_begin(clicon_handle h)
+{
+    clicon_hash_t *idx;
+
+    if (clicon_hash_lookup(clicon_data(h), VALIDATE_LEAFREF_INDEX) != NULL)
+	return 0;
+    if ((idx = clicon_hash_init()) == NULL)
+	return -1;
+    if (clicon_hash_add(clicon_data(h), VALIDATE_LEAFREF_INDEX, &idx, sizeof(idx)) == NULL){
+	clicon_hash_free(idx);
+	return -1;
+    }
+    return 1;
+}
+
+/*! End a per-validation index of leafref targets and free it
+ * @param[in]  h   Clicon handle
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see validate_leafref_index_begin
+ */
+static int
+validate_leafref_index_end(clicon_handle h)
+{
+    int             retval = -1;
+    void           *p;
+    clicon_hash_t  *idx;
+    clicon_hash_t  *set;
+    char          **keys = NULL;
+    size_t          klen;
+    int             i;
+
+    if ((p = clicon_hash_value(clicon_data(h), VALIDATE_LEAFREF_INDEX, NULL)) == NULL)
+	goto ok;
+    idx = *(clicon_hash_t **)p;
+    if (clicon_hash_keys(idx, &keys, &klen) < 0)
+	goto done;
+    for (i=0; i<klen; i++)
+	if ((p = clicon_hash_value(idx, keys[i], NULL)) != NULL){
+	    set = *(clicon_hash_t **)p;
+	    clicon_hash_free(set);
+	}
+    clicon_hash_free(idx);
+    clicon_hash_del(clicon_data(h), VALIDATE_LEAFREF_INDEX);
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+	free(keys);
+    return retval;
+}
+
+/*! Get the set of target values of a leafref path from the per-validation index
+ *
+ * The target values only depend on the context node if the path is relative, and then
+ * only on the ancestor of the leading "../" steps, which is part of the key.
+ * Paths with current() or deref() depend on the context node and are not indexed.
+ * @param[in]  h     Clicon handle
+ * @param[in]  xt    XML leaf node of type leafref (context node)
+ * @param[in]  ypath Yang path statement of leafref
+ * @param[in]  ymod  Yang module of namespace context nsc
+ * @param[in]  nsc   Namespace context of path
+ * @param[out] setp  Set of target values (hash keys), NULL if not indexed
+ * @retval     0     OK
+ * @retval    -1    Error
+ */
+static int
+validate_leafref_index(clicon_handle   h,
+		       cxobj          *xt,
+		       yang_stmt      *ypath,
+		       yang_stmt      *ymod,
+		       cvec           *nsc,
+		       clicon_hash_t **setp)
+{
+    int            retval = -1;
+    void          *p;
+    clicon_hash_t *idx;
+    clicon_hash_t *set = NULL;
+    char          *path;
+    char          *s;
+    cxobj         *xa = NULL; /* Context ancestor, NULL if absolute path */
+    cxobj        **xvec = NULL;
+    size_t         xlen = 0;
+    char          *body;
+    cbuf          *cb = NULL;
+    int            i;
+
+    *setp = NULL;
+    if (h == NULL ||
+	(p = clicon_hash_value(clicon_data(h), VALIDATE_LEAFREF_INDEX, NULL)) == NULL)
+	goto ok;
+    idx = *(clicon_hash_t **)p;
+    path = yang_argument_get(ypath);
+    if (strstr(path, "current") != NULL || strstr(path, "deref") != NULL)
+	goto ok;
+    s = path;
+    while (isspace(*s))
+	s++;
+    if (*s != '/'){
+	xa = xt;
+	while (strncmp(s, "../", 3) == 0){
+	    if ((xa = xml_parent(xa)) == NULL)
+		goto ok;
+	    s += 3;
+	}
+	if (xa == xt) /* Only for this node */
+	    goto ok;
+    }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "%p %p %p", ypath, ymod, xa);
+    if ((p = clicon_hash_value(idx, cbuf_get(cb), NULL)) != NULL){
+	*setp = *(clicon_hash_t **)p;
+	goto ok;
+    }
+    /* First instance: collect target values */
+    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path) < 0)
+	goto done;
+    if ((set = clicon_hash_init()) == NULL)
+	goto done;
+    for (i = 0; i < xlen; i++)
+	if ((body = xml_body(xvec[i])) != NULL &&
+	    clicon_hash_add(set, body, NULL, 0) == NULL)
+	    goto done;
+    if (clicon_hash_add(idx, cbuf_get(cb), &set, sizeof(set)) == NULL)
+	goto done;
+    *setp = set;
+    set = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (set)
+	clicon_hash_free(set);
+    if (cb)
+	cbuf_free(cb);
+    if (xvec)
+	free(xvec);
+    return retval;
+}
+
 /*! Validate xml node of type leafref, ensure the value is one of that path's reference
+ * @param[in]  h     Clicon handle, or NULL
  * @param[in]  xt    XML leaf node of type leafref
  * @param[in]  ys    Yang spec of leaf
  * @param[in]  ytype Yang type statement belonging to the XML node
@@ -96,26 +258,31 @@
  *      references the typedef. (ie ys)
  *   o  Otherwise, the context node is the node in the data tree for which
  *      the "path" statement is defined. (ie yc)
+ * If a leafref index is active, the target values are looked up in the index, see
+ * validate_leafref_index
  */
 static int
-validate_leafref(cxobj     *xt,
-		 yang_stmt *ys,
-		 yang_stmt *ytype,
-		 cxobj    **xret)
+validate_leafref(clicon_handle h,
+		 cxobj        *xt,
+		 yang_stmt    *ys,
+		 yang_stmt    *ytype,
+		 cxobj       **xret)
 {
-    int          retval = -1;
-    yang_stmt   *ypath;
-    yang_stmt   *yp;
-    cxobj      **xvec = NULL;
-    cxobj       *x;
-    int          i;
-    size_t       xlen = 0;
-    char        *leafrefbody;
-    char        *leafbody;
-    cvec        *nsc = NULL;
-    cbuf        *cberr = NULL;
-    char        *path;
-    
+    int            retval = -1;
+    yang_stmt     *ypath;
+    yang_stmt     *yp;
+    yang_stmt     *ymod;
+    cxobj        **xvec = NULL;
+    cxobj         *x;
+    int            i;
+    size_t         xlen = 0;
+    char          *leafrefbody;
+    char          *leafbody;
+    cvec          *nsc;             /* Shared, not freed */
+    cbuf          *cberr = NULL;
+    char          *path;
+    clicon_hash_t *set = NULL;
+
     if ((leafrefbody = xml_body(xt)) == NULL)
 	goto ok;
     if ((ypath = yang_find(ytype, Y_PATH, NULL)) == NULL){
@@ -126,39 +293,46 @@ validate_leafref(cxobj     *xt,
     /* See comment^: If path is defined in typedef or not */
     if ((yp = yang_parent_get(ytype)) != NULL &&
 	yang_keyword_get(yp) == Y_TYPEDEF){
-	if (xml_nsctx_yang(ys, &nsc) < 0)
+	if ((nsc = xml_nsctx_yang_get(ys)) == NULL)
 	    goto done;
+	ymod = ys_module(ys);
     }
-    else
-	if (xml_nsctx_yang(ytype, &nsc) < 0)
+    else{
+	if ((nsc = xml_nsctx_yang_get(ytype)) == NULL)
 	    goto done;
+	ymod = ys_module(ytype);
+    }
     path = yang_argument_get(ypath);
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path) < 0) 
+    if (validate_leafref_index(h, xt, ypath, ymod, nsc, &set) < 0)
 	goto done;
-    for (i = 0; i < xlen; i++) {
-	x = xvec[i];
-	if ((leafbody = xml_body(x)) == NULL)
-	    continue;
-	if (strcmp(leafbody, leafrefbody) == 0)
-	    break;
+    if (set != NULL){
+	if (clicon_hash_lookup(set, leafrefbody) != NULL)
+	    goto ok;
     }
-    if (i==xlen){
-	if ((cberr = cbuf_new()) == NULL){
-	    clicon_err(OE_UNIX, errno, "cbuf_new");
+    else {
+	if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path) < 0)
 	    goto done;
+	for (i = 0; i < xlen; i++) {
+	    x = xvec[i];
+	    if ((leafbody = xml_body(x)) == NULL)
+		continue;
+	    if (strcmp(leafbody, leafrefbody) == 0)
+		goto ok;
 	}
-	cprintf(cberr, "Leafref validation failed: No leaf %s matching path %s", leafrefbody, path);
-	if (netconf_bad_element_xml(xret, "application", leafrefbody, cbuf_get(cberr)) < 0)
-	    goto done;
-	goto fail;
     }
+    if ((cberr = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cberr, "Leafref validation failed: No leaf %s matching path %s", leafrefbody, path);
+    if (netconf_bad_element_xml(xret, "application", leafrefbody, cbuf_get(cberr)) < 0)
+	goto done;
+    goto fail;
  ok:
     retval = 1;
  done:
     if (cberr)
 	cbuf_free(cberr);
-    if (nsc)
-	xml_nsctx_free(nsc);
     if (xvec)
 	free(xvec);
     return retval;
@@ -206,15 +380,8 @@ validate_identityref(cxobj     *xt,
     cbuf       *cb = NULL;
     cvec       *idrefvec; /* Derived identityref list: (module:id)**/
     yang_stmt  *ymod;
+    yang_stmt  *yid;
     
-    if ((cb = cbuf_new()) == NULL){
-	clicon_err(OE_UNIX, errno, "cbuf_new"); 
-	goto done;
-    }
-    if ((cberr = cbuf_new()) == NULL){
-	clicon_err(OE_UNIX, errno, "cbuf_new"); 
-	goto done;
-    }
     /* Get idref value. Then see if this value is derived from ytype.
      */
     if ((node = xml_body(xt)) == NULL){ /* It may not be empty */
@@ -230,8 +397,8 @@ validate_identityref(cxobj     *xt,
 	    goto done;
 	goto fail;
     }
-    /* This is the actual base identity */
-    if ((ybaseid = yang_find_identity(ybaseref, yang_argument_get(ybaseref))) == NULL){
+    /* This is the actual base identity, resolved once */
+    if ((ybaseid = yang_base_identity(ybaseref)) == NULL){
 	if (netconf_missing_element_xml(xret, "application", yang_argument_get(ybaseref), "Identityref validation failed, no base identity") < 0)
 	    goto done;
 	goto fail;
@@ -245,6 +412,15 @@ validate_identityref(cxobj     *xt,
 	ymod = yang_find_module_by_prefix_yspec(ys_spec(ys), prefix);
 #endif
     }
+    /* First check derivation with resolved identities */
+    if (ymod != NULL &&
+	(yid = yang_find(ymod, Y_IDENTITY, id)) != NULL &&
+	yang_identity_derived(yid, ybaseid))
+	goto ok;
+    if ((cberr = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new"); 
+	goto done;
+    }
     if (ymod == NULL){
 	cprintf(cberr, "Identityref validation failed, %s not derived from %s", 
 		node, yang_argument_get(ybaseid));
@@ -252,6 +428,10 @@ validate_identityref(cxobj     *xt,
 	    goto done;
 	goto fail;
     }
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new"); 
+	goto done;
+    }
     cprintf(cb, "%s:%s", yang_argument_get(ymod), id);
     idref = cbuf_get(cb);	
     /* Here check if node is in the derived node list of the base identity 
@@ -265,6 +445,7 @@ validate_identityref(cxobj     *xt,
 	    goto done;
 	goto fail;
     }
+ ok:
     retval = 1;
  done:
     if (cberr)
@@ -603,134 +784,237 @@ check_mandatory(cxobj     *xt,
     goto done;
 }
 
-/*! New element last in list, check if already exists if sp return -1
- * @param[in]  vec   Vector of existing entries (new is last)
- * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Lenght of entry
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
+/* One unique constraint of a list, list keys or a unique statement, see check_unique_list
+ */
+struct unique_check{
+    cvec      *uc_cvk;    /* Names of leafs of constraint */
+    int        uc_len;    /* Number of leafs */
+    int        uc_sorted; /* Entries are sorted on the leafs (keys of list sorted by system) */
+    char     **uc_vec;    /* Values of leafs of each entry, uc_len per entry (2xmatrix) */
+    int       *uc_tab;    /* Hash table of entries (index+1, 0 is empty), if not sorted */
+    uint32_t  *uc_hv;     /* Hash values of uc_tab slots */
+    cxobj     *uc_dup;    /* First entry that is a duplicate, if any */
+};
+
+/*! Hash value of the leaf values of a list entry (FNV-1a)
+ * @param[in]  vals  Values
+ * @param[in]  vlen  Number of values
+ * @retval     h     Hash value
+ */
+static uint32_t
+unique_hash(char **vals,
+	    int    vlen)
+{
+    uint32_t h = 2166136261;
+    char    *s;
+    int      v;
+
+    for (v=0; v<vlen; v++){
+	s = vals[v];
+	do {
+	    h ^= (uint8_t)*s;
+	    h *= 16777619;
+	} while (*s++ != '\0');
+    }
+    return h;
+}
+
+/*! New entry of a list, check if an entry with the same leaf values already exists
+ * @param[in]  uc    Unique constraint
+ * @param[in]  i1    The new entry is placed at uc_vec[i1]
+ * @param[in]  size  Size of hash table, a power of two larger than number of entries
  * @retval     0     OK, entry is unique
  * @retval    -1     Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
  */
 static int
-check_insert_duplicate(char **vec,
-		       int    i1,
-		       int    vlen,
-		       int    sorted)
+unique_insert(struct unique_check *uc,
+	      int                  i1,
+	      int                  size)
 {
-    int i;
-    int v;
-    char *b;
+    char   **vals = &uc->uc_vec[i1*uc->uc_len];
+    char   **ev;
+    char    *b;
+    uint32_t h;
+    int      k;
+    int      v;
 
-    if (sorted){
+    if (uc->uc_sorted){
 	/* Just go look at previous element to see if it is duplicate (sorted by system) */
 	if (i1 == 0)
 	    return 0;
-	i = i1-1;
-	for (v=0; v<vlen; v++){
-	    b = vec[i*vlen+v];
-	    if (b == NULL || strcmp(b, vec[i1*vlen+v]))
+	ev = &uc->uc_vec[(i1-1)*uc->uc_len];
+	for (v=0; v<uc->uc_len; v++){
+	    b = ev[v];
+	    if (b == NULL || strcmp(b, vals[v]))
 		return 0;
 	}
 	/* here we have passed thru all keys of previous element and they are all equal */
 	return -1;
     }
-    else{
-	for (i=0; i<i1; i++){
-	    for (v=0; v<vlen; v++){
-		b = vec[i*vlen+v];
-		if (b == NULL || strcmp(b, vec[i1*vlen+v]))
+    h = unique_hash(vals, uc->uc_len);
+    k = h & (size-1);
+    while (uc->uc_tab[k] != 0){
+	if (uc->uc_hv[k] == h){
+	    ev = &uc->uc_vec[(uc->uc_tab[k]-1)*uc->uc_len];
+	    for (v=0; v<uc->uc_len; v++)
+		if (strcmp(ev[v], vals[v]))
 		    break;
-	    }
-	    if (v==vlen) /* duplicate */
-		break;
+	    if (v == uc->uc_len) /* duplicate */
+		return -1;
 	}
-	return i==i1?0:-1;
+	k = (k+1) & (size-1);
     }
+    uc->uc_tab[k] = i1+1;
+    uc->uc_hv[k] = h;
+    return 0;
 }
 
-/*! Given a list with unique constraint, detect duplicates
- * @param[in]  x     The first element in the list (on return the last)
+/*! Add a unique constraint of a list
+ * @param[in]  uc      Unique constraint, zeroed
+ * @param[in]  cvk     Names of leafs of constraint
+ * @param[in]  sorted  Entries are sorted on the leafs
+ * @param[in]  nx      Max number of entries
+ * @param[in]  size    Size of hash table
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+unique_check_init(struct unique_check *uc,
+		  cvec                *cvk,
+		  int                  sorted,
+		  int                  nx,
+		  int                  size)
+{
+    uc->uc_cvk = cvk;
+    uc->uc_len = cvec_len(cvk);
+    uc->uc_sorted = sorted;
+    if ((uc->uc_vec = calloc(uc->uc_len*nx, sizeof(char*))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	return -1;
+    }
+    if (!sorted &&
+	((uc->uc_tab = calloc(size, sizeof(int))) == NULL ||
+	 (uc->uc_hv = calloc(size, sizeof(uint32_t))) == NULL)){
+	clicon_err(OE_UNIX, errno, "calloc");
+	return -1;
+    }
+    return 0;
+}
+
+/*! Given a list, detect duplicates of the list keys and of the unique constraints
+ *
+ * All constraints are checked in a single pass over the list entries, duplicates are
+ * detected with a hash table of each constraint, or by comparing with the previous
+ * entry if the entries are sorted by the list keys.
+ * The number of entries is counted for min/max-elements checks.
+ * @param[in]  x     The first element in the list
  * @param[in]  xt    The parent of x
  * @param[in]  y     Its yang spec (Y_LIST)
- * @param[in]  yu    A yang unique spec (Y_UNIQUE) for unique keyword or (Y_LIST) for list keys
+ * @param[out] nrp   Number of elements in the list
+ * @param[out] xlast The last element in the list
  * @param[out] xret  Error XML tree. Free with xml_free after use
  * @retval     1     Validation OK
  * @retval     0     Validation failed (cbret set)
  * @retval    -1     Error
- * @note It would be possible to cache the vector built below
  * All key leafs MUST be present for all list entries.
  * The combined values of all the leafs specified in the key are used to
  * uniquely identify a list entry.  All key leafs MUST be given values
  * when a list entry is created.
+ * The list keys are checked before the unique constraints, in yang order, ie if
+ * both are violated, the list key error is returned.
  */
 static int
-check_unique_list(cxobj     *x, 
-		  cxobj     *xt, 
+check_unique_list(cxobj     *x,
+		  cxobj     *xt,
 		  yang_stmt *y,
-		  yang_stmt *yu,
+		  int       *nrp,
+		  cxobj    **xlast,
 		  cxobj    **xret)
 {
-    int       retval = -1;
-    cvec      *cvk; /* unique vector */
-    cg_var    *cvi; /* unique node name */
-    cxobj     *xi;
-    char     **vec = NULL; /* 2xmatrix */
-    int        vlen;
-    int        i;
-    int        v;
-    char      *bi;
-    int        sorted;
-    
-    /* If list and is sorted by system, then it is assumed elements are in key-order which is optimized
-     * Other cases are "unique" constraint or list sorted by user which is quadratic in complexity
-     * This second case COULD be optimized if binary insert is made on the vec vector.
-     */
-    sorted = (yang_keyword_get(yu) == Y_LIST &&
-	      yang_find(y, Y_ORDERED_BY, "user") == NULL);
-    cvk = yang_cvec_get(yu);
-    /* nr of unique elements to check */
-    if ((vlen = cvec_len(cvk)) == 0){ 
-	/* No keys: no checks necessary */
-	goto ok;
-    }
-    if ((vec = calloc(vlen*xml_child_nr(xt), sizeof(char*))) == NULL){
+    int                  retval = -1;
+    struct unique_check *ucv = NULL;
+    struct unique_check *uc;
+    int                  nu = 0;
+    cvec                *cvk;
+    cg_var              *cvi; /* unique node name */
+    cxobj               *xi;
+    yang_stmt           *yu;
+    char                *bi;
+    int                  nx;
+    int                  size;
+    int                  i;
+    int                  j;
+    int                  v;
+
+    nx = xml_child_nr(xt);
+    for (size = 2; size < 2*nx; size <<= 1)
+	;
+    if ((ucv = calloc(yang_len_get(y)+1, sizeof(*ucv))) == NULL){
 	clicon_err(OE_UNIX, errno, "calloc");
 	goto done;
     }
-    /* A vector is built with key-values, for each iteration check "backward" in the vector
-     * for duplicates
-     */
+    /* If list is sorted by system, then it is assumed elements are in key-order */
+    if ((cvk = yang_cvec_get(y)) != NULL && cvec_len(cvk) > 0)
+	if (unique_check_init(&ucv[nu++], cvk,
+			      yang_find(y, Y_ORDERED_BY, "user") == NULL, nx, size) < 0)
+	    goto done;
+    yu = NULL;
+    while ((yu = yn_each(y, yu)) != NULL) {
+	if (yang_keyword_get(yu) != Y_UNIQUE)
+	    continue;
+	if ((cvk = yang_cvec_get(yu)) == NULL || cvec_len(cvk) == 0)
+	    continue;
+	if (unique_check_init(&ucv[nu++], cvk, 0, nx, size) < 0)
+	    goto done;
+    }
     i = 0; /* x element index */
     do {
-	cvi = NULL;
-	v = 0; /* index in each tuple */
-	while ((cvi = cvec_each(cvk, cvi)) != NULL){
-	    /* RFC7950: Sec 7.8.3.1: entries that do not have value for all
-	     * referenced leafs are not taken into account */
-	    if ((xi = xml_find(x, cv_string_get(cvi))) ==NULL)
-		break;
-	    if ((bi = xml_body(xi)) == NULL)
-		break;
-	    vec[i*vlen + v++] = bi;
-	}
-	if (cvi==NULL){
-	    /* Last element (i) is newly inserted, see if it is already there */
-	    if (check_insert_duplicate(vec, i, vlen, sorted) < 0){
-		if (netconf_data_not_unique_xml(xret, x, cvk) < 0)
-		    goto done;
-		goto fail;
+	for (j=0; j<nu; j++){
+	    uc = &ucv[j];
+	    if (uc->uc_dup != NULL)
+		continue;
+	    cvi = NULL;
+	    v = 0; /* index in each tuple */
+	    while ((cvi = cvec_each(uc->uc_cvk, cvi)) != NULL){
+		/* RFC7950: Sec 7.8.3.1: entries that do not have value for all
+		 * referenced leafs are not taken into account */
+		if ((xi = xml_find(x, cv_string_get(cvi))) ==NULL)
+		    break;
+		if ((bi = xml_body(xi)) == NULL)
+		    break;
+		uc->uc_vec[i*uc->uc_len + v++] = bi;
 	    }
+	    /* Last element (i) is newly inserted, see if it is already there */
+	    if (cvi == NULL && unique_insert(uc, i, size) < 0)
+		uc->uc_dup = x;
 	}
+	*xlast = x;
 	x = xml_child_each(xt, x, CX_ELMNT);
 	i++;
     } while (x && y == xml_spec(x));  /* stop if list ends, others may follow */
- ok:
-    /* It would be possible to cache vec here as an optimization */
+    *nrp = i;
+    for (j=0; j<nu; j++){
+	uc = &ucv[j];
+	if (uc->uc_dup != NULL){
+	    if (netconf_data_not_unique_xml(xret, uc->uc_dup, uc->uc_cvk) < 0)
+		goto done;
+	    goto fail;
+	}
+    }
     retval = 1;
  done:
-    if (vec)
-	free(vec);
+    if (ucv){
+	for (j=0; j<nu; j++){
+	    uc = &ucv[j];
+	    if (uc->uc_vec)
+		free(uc->uc_vec);
+	    if (uc->uc_tab)
+		free(uc->uc_tab);
+	    if (uc->uc_hv)
+		free(uc->uc_hv);
+	}
+	free(ucv);
+    }
     return retval;
  fail:
     retval = 0;
@@ -833,7 +1117,6 @@ check_list_unique_minmax(cxobj  *xt,
     yang_stmt  *yprev = NULL; /* previous in list */
     yang_stmt  *ye = NULL;    /* yang each list to catch emtpy */
     yang_stmt  *ych;          /* y:s parent node (if choice that ye can compare to) */
-    yang_stmt  *yu;           /* yang unique */
     int         ret;
     int         nr=0;   /* Nr of list elements for min/max check */
     enum rfc_6020 keyw;
@@ -910,27 +1193,13 @@ check_list_unique_minmax(cxobj  *xt,
 	if (keyw != Y_LIST)
 	    continue;
 	/* Here new (first element) of lists only
-	 * First check unique keys
+	 * Check unique keys and unique constraints, and count the elements. Continue
+	 * after the last element of the list.
 	 */
-	if ((ret = check_unique_list(x, xt, y, y, xret)) < 0)
+	if ((ret = check_unique_list(x, xt, y, &nr, &x, xret)) < 0)
 	    goto done;
 	if (ret == 0)
 	    goto fail;
-	/* Check if there is a unique constraint on the list
-	 */
-	yu = NULL;
-	while ((yu = yn_each(y, yu)) != NULL) {
-	    if (yang_keyword_get(yu) != Y_UNIQUE)
-		continue;
-	    /* Here is a list w unique constraints identified by:
-	     * its first element x, its yang spec y, its parent xt, and 
-	     * a unique yang spec yu,
-	     */
-	    if ((ret = check_unique_list(x, xt, y, yu, xret)) < 0)
-		goto done;
-	    if (ret == 0)
-		goto fail;
-	}
     } /* while x */
 
     /* yprev if set, is a list that has been traversed 
@@ -997,6 +1266,7 @@ xml_yang_validate_add(clicon_handle h,
     char      *body;
     int        ret;
     cxobj     *x;
+    clixon_xml_iter it;
     enum cv_type cvtype;
     
     /* if not given by argument (overide) use default link 
@@ -1052,8 +1322,8 @@ xml_yang_validate_add(clicon_handle h,
 	    break;
 	}
     }
-    x = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+    xml_child_iter_init(&it, xt, CX_ELMNT);
+    while ((x = xml_child_iter_next(&it)) != NULL) {
 	if ((ret = xml_yang_validate_add(h, x, xret)) < 0)
 	    goto done;
 	if (ret == 0)
@@ -1083,6 +1353,7 @@ xml_yang_validate_list_key_only(cxobj        *xt,
     yang_stmt *yt;   /* yang spec of xt going in */
     int        ret;
     cxobj     *x;
+    clixon_xml_iter it;
     
     /* if not given by argument (overide) use default link 
        and !Node has a config sub-statement and it is false */
@@ -1094,8 +1365,8 @@ xml_yang_validate_list_key_only(cxobj        *xt,
 	if (ret == 0)
 	    goto fail;
     }
-    x = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+    xml_child_iter_init(&it, xt, CX_ELMNT);
+    while ((x = xml_child_iter_next(&it)) != NULL) {
 	if ((ret = xml_yang_validate_list_key_only(x, xret)) < 0)
 	    goto done;
 	if (ret == 0)
@@ -1109,6 +1380,132 @@ xml_yang_validate_list_key_only(cxobj        *xt,
     goto done;
 }
 
+/*! Node-specific validation of a single XML node, not recursive
+ * Check leafref, identityref, must, when and augmented when of the node
+ * @param[in]  h         Clicon handle
+ * @param[in]  xt        XML node to be validated
+ * @param[in]  ys        Yang spec of xt
+ * @param[in]  xpathonly Only check constraints that may depend on other nodes: leafref,
+ *                       must and when, see YANG_FLAG_XPATH_DEP
+ * @param[out] xret      Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1         Validation OK
+ * @retval     0         Validation failed (xret set)
+ * @retval    -1         Error
+ */
+static int
+xml_yang_validate_node(clicon_handle h,
+		       cxobj        *xt,
+		       yang_stmt    *ys,
+		       int           xpathonly,
+		       cxobj       **xret)
+{
+    int        retval = -1;
+    yang_stmt *yc;  /* yang child */
+    yang_stmt *ye;  /* yang must error-message */
+    char      *xpath;
+    int        nr;
+    int        ret;
+    cbuf      *cb = NULL;
+    cvec      *nsc;        /* Shared, not freed */
+
+    switch (yang_keyword_get(ys)){
+    case Y_LEAF:
+	/* fall thru */
+    case Y_LEAF_LIST:
+	/* Special case if leaf is leafref, then first check against
+	   current xml tree
+	*/
+	/* Get base type yc */
+	if (yang_type_get(ys, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
+	    goto done;
+	if (strcmp(yang_argument_get(yc), "leafref") == 0){
+	    if ((ret = validate_leafref(h, xt, ys, yc, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+	else if (!xpathonly &&
+		 strcmp(yang_argument_get(yc), "identityref") == 0){
+	    if ((ret = validate_identityref(xt, ys, yc, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+	break;
+    default:
+	break;
+    }
+    /* must sub-node RFC 7950 Sec 7.5.3. Can be several. 
+     * XXX. use yang path instead? */
+    yc = NULL;
+    while ((yc = yn_each(ys, yc)) != NULL) {
+	if (yang_keyword_get(yc) != Y_MUST)
+	    continue;
+	xpath = yang_argument_get(yc); /* "must" has xpath argument */
+	if ((nsc = xml_nsctx_yang_get(yc)) == NULL)
+	    goto done;
+	if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
+	    goto done;
+	if (!nr){
+	    ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
+	    if (netconf_operation_failed_xml(xret, "application", 
+					     ye?yang_argument_get(ye):"must xpath validation failed") < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+    /* "when" sub-node RFC 7950 Sec 7.21.5. Can only be one. */
+    if ((yc = yang_find(ys, Y_WHEN, NULL)) != NULL){
+	xpath = yang_argument_get(yc); /* "when" has xpath argument */
+	/* WHEN xpath needs namespace context */
+	if ((nsc = xml_nsctx_yang_get(ys)) == NULL)
+	    goto done;
+	if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
+	    goto done;
+	if (nr == 0){
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cprintf(cb, "Failed WHEN condition of %s in module %s",
+		    xml_name(xt),
+		    yang_argument_get(ys_module(ys)));
+	    if (netconf_operation_failed_xml(xret, "application", 
+					     cbuf_get(cb)) < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+    /* Augmented when using special struct. */
+    if ((xpath = yang_when_xpath_get(ys)) != NULL){
+	if ((nr = xpath_vec_bool(xml_parent(xt), yang_when_nsc_get(ys),
+				 "%s", xpath)) < 0)
+	    goto done;
+	if (nr == 0){
+	    if ((cb = cbuf_new()) == NULL){
+		clicon_err(OE_UNIX, errno, "cbuf_new");
+		goto done;
+	    }
+	    cprintf(cb, "Failed augmented WHEN condition %s of node %s in module %s",
+		    xpath,
+		    xml_name(xt),
+		    yang_argument_get(ys_module(ys)));
+	    if (netconf_operation_failed_xml(xret, "application", 
+					     cbuf_get(cb)) < 0)
+		goto done;
+	    goto fail;
+	}
+    }
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Validate a single XML node with yang specification for all (not only added) entries
  * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
  * @param[in]  xt  XML node to be validated
@@ -1136,16 +1533,12 @@ xml_yang_validate_all(clicon_handle h,
 {
     int        retval = -1;
     yang_stmt *ys;  /* yang node */
-    yang_stmt *yc;  /* yang child */
-    yang_stmt *ye;  /* yang must error-message */
-    char      *xpath;
-    int        nr;
     int        ret;
     cxobj     *x;
+    clixon_xml_iter it;
     cxobj     *xp;
     char      *ns = NULL;
     cbuf      *cb = NULL;
-    cvec      *nsc = NULL;
 
     /* if not given by argument (overide) use default link 
        and !Node has a config sub-statement and it is false */
@@ -1179,103 +1572,16 @@ xml_yang_validate_all(clicon_handle h,
 	case Y_ANYDATA:
 	    goto ok;
 	    break;
-	case Y_LEAF:
-	    /* fall thru */
-	case Y_LEAF_LIST:
-	    /* Special case if leaf is leafref, then first check against
-	       current xml tree
- 	    */
-	    /* Get base type yc */
-	    if (yang_type_get(ys, NULL, &yc, NULL, NULL, NULL, NULL, NULL) < 0)
-		goto done;
-	    if (strcmp(yang_argument_get(yc), "leafref") == 0){
-		if ((ret = validate_leafref(xt, ys, yc, xret)) < 0)
-		    goto done;
-		if (ret == 0)
-		    goto fail;
-		}
-	    else if (strcmp(yang_argument_get(yc), "identityref") == 0){
-		if ((ret = validate_identityref(xt, ys, yc, xret)) < 0)
-		    goto done;
-		if (ret == 0)
-		    goto fail;
-	    }
-	    break;
 	default:
 	    break;
 	}
-	/* must sub-node RFC 7950 Sec 7.5.3. Can be several. 
-	 * XXX. use yang path instead? */
-	yc = NULL;
-	while ((yc = yn_each(ys, yc)) != NULL) {
-	    if (yang_keyword_get(yc) != Y_MUST)
-		continue;
-	    xpath = yang_argument_get(yc); /* "must" has xpath argument */
-	    if (xml_nsctx_yang(yc, &nsc) < 0)
-		goto done;
-	    if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
-		goto done;
-	    if (!nr){
-		ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
-		if (netconf_operation_failed_xml(xret, "application", 
-						 ye?yang_argument_get(ye):"must xpath validation failed") < 0)
-		    goto done;
-		goto fail;
-	    }
-	    if (nsc){
-		xml_nsctx_free(nsc);
-		nsc = NULL;
-	    }
-	}
-	/* "when" sub-node RFC 7950 Sec 7.21.5. Can only be one. */
-	if ((yc = yang_find(ys, Y_WHEN, NULL)) != NULL){
-	    xpath = yang_argument_get(yc); /* "when" has xpath argument */
-	    /* WHEN xpath needs namespace context */
-	    if (xml_nsctx_yang(ys, &nsc) < 0)
-		goto done;
-	    if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
-		goto done;
-	    if (nsc){
-		xml_nsctx_free(nsc);
-		nsc = NULL;
-	    }
-	    if (nr == 0){
-		if ((cb = cbuf_new()) == NULL){
-		    clicon_err(OE_UNIX, errno, "cbuf_new");
-		    goto done;
-		}
-		cprintf(cb, "Failed WHEN condition of %s in module %s",
-			xml_name(xt),
-			yang_argument_get(ys_module(ys)));
-		if (netconf_operation_failed_xml(xret, "application", 
-						 cbuf_get(cb)) < 0)
-		    goto done;
-		goto fail;
-	    }
-	}
-	/* Augmented when using special struct. */
-	if ((xpath = yang_when_xpath_get(ys)) != NULL){
-	    if ((nr = xpath_vec_bool(xml_parent(xt), yang_when_nsc_get(ys),
-				     "%s", xpath)) < 0)
-		goto done;
-	    if (nr == 0){
-		if ((cb = cbuf_new()) == NULL){
-		    clicon_err(OE_UNIX, errno, "cbuf_new");
-		    goto done;
-		}
-		cprintf(cb, "Failed augmented WHEN condition %s of node %s in module %s",
-			xpath,
-			xml_name(xt),
-			yang_argument_get(ys_module(ys)));
-		if (netconf_operation_failed_xml(xret, "application", 
-						 cbuf_get(cb)) < 0)
-		    goto done;
-		goto fail;
-	    }
-	}
+	if ((ret = xml_yang_validate_node(h, xt, ys, 0, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
     }
-    x = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+    xml_child_iter_init(&it, xt, CX_ELMNT);
+    while ((x = xml_child_iter_next(&it)) != NULL) {
 	if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
 	    goto done;
 	if (ret == 0)
@@ -1294,33 +1600,449 @@ xml_yang_validate_all(clicon_handle h,
  done:
     if (cb)
 	cbuf_free(cb);
-    if (nsc)
-	xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
     goto done;
 }
+/*! Validate top-level children of an XML tree in parallel worker processes
+ *
+ * Used by xml_yang_validate_all_top if CLICON_VALIDATE_WORKERS is larger than one.
+ * The children are divided between the workers. Each worker validates its children
+ * in order with xml_yang_validate_all and sends the index of the first child that is
+ * not valid to the parent. Constraints referencing other subtrees are validated as
+ * usual since each worker has a copy of the whole tree.
+ * The result is the same as if validated serially: the first child (in tree order)
+ * that is not valid is validated again by the parent to get the error.
+ * @param[in]  h     Clicon handle
+ * @param[in]  xt    XML tree whose element children are validated
+ * @param[in]  nw    Number of workers
+ * @param[out] xret  Error XML tree (if ret == 0). Free with xml_free after use
+ * @retval     2     Workers failed, validate serially
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ */
+static int
+xml_yang_validate_parallel(clicon_handle h,
+			   cxobj        *xt,
+			   int           nw,
+			   cxobj       **xret)
+{
+    int     retval = -1;
+    int    *fds = NULL;
+    pid_t  *pids = NULL;
+    int     fd[2];
+    int     w;
+    int     i;
+    int     first = -1; /* First child that is not valid */
+    int     index;
+    size_t  len;
+    ssize_t n;
+    cxobj  *x;
+    cxobj  *xerr = NULL;
+    int     ret;
+
+    if ((fds = calloc(nw, sizeof(int))) == NULL ||
+	(pids = calloc(nw, sizeof(pid_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (w=0; w<nw; w++)
+	fds[w] = -1;
+    for (w=0; w<nw; w++){
+	if (pipe(fd) < 0){
+	    clicon_err(OE_UNIX, errno, "pipe");
+	    goto done;
+	}
+	if ((pids[w] = fork()) < 0){
+	    clicon_err(OE_UNIX, errno, "fork");
+	    close(fd[0]);
+	    close(fd[1]);
+	    goto done;
+	}
+	if (pids[w] == 0){ /* Worker: validate every nw:th child */
+	    close(fd[0]);
+	    index = -1;
+	    i = 0;
+	    x = NULL;
+	    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+		if (i % nw == w){
+		    if ((ret = xml_yang_validate_all(h, x, &xerr)) < 1){
+			index = i;
+			break;
+		    }
+		}
+		i++;
+	    }
+	    if (write(fd[1], &index, sizeof(index)) != sizeof(index))
+		_exit(1);
+	    _exit(0);
+	}
+	close(fd[1]);
+	fds[w] = fd[0];
+    }
+    /* Parent: the first child not valid of all workers */
+    for (w=0; w<nw; w++){
+	len = 0;
+	while (len < sizeof(index)){
+	    if ((n = read(fds[w], (char*)&index + len, sizeof(index) - len)) < 0){
+		if (errno == EINTR)
+		    continue;
+		clicon_err(OE_UNIX, errno, "read");
+		goto done;
+	    }
+	    if (n == 0)
+		break;
+	    len += n;
+	}
+	close(fds[w]);
+	fds[w] = -1;
+	waitpid(pids[w], NULL, 0);
+	pids[w] = 0;
+	if (len < sizeof(index))
+	    goto serial; /* Worker did not finish */
+	if (index != -1 && (first == -1 || index < first))
+	    first = index;
+    }
+    if (first == -1)
+	goto ok;
+    /* Children before first are valid, validate first again to get the error */
+    i = 0;
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL && i < first)
+	i++;
+    if (x == NULL)
+	goto serial;
+    if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+ ok:
+    retval = 1;
+ done:
+    if (fds){
+	for (w=0; w<nw; w++)
+	    if (fds[w] != -1)
+		close(fds[w]);
+	free(fds);
+    }
+    if (pids){
+	for (w=0; w<nw; w++)
+	    if (pids[w] > 0)
+		waitpid(pids[w], NULL, 0);
+	free(pids);
+    }
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+ serial:
+    retval = 2;
+    goto done;
+}
+
 /*! Translate a single xml node to a cligen variable vector. Note not recursive 
  * @param[out] xret    Error XML tree (if ret == 0). Free with xml_free after use
  * @retval     1     Validation OK
  * @retval     0     Validation failed (xret set)
  * @retval    -1     Error
+ * If CLICON_VALIDATE_WORKERS is larger than one, the top-level children are validated
+ * in parallel, see xml_yang_validate_parallel
  */
 int
 xml_yang_validate_all_top(clicon_handle h,
 			  cxobj        *xt, 
 			  cxobj       **xret)
 {
+    int    retval = -1;
     int    ret;
     cxobj *x;
+    clixon_xml_iter it;
+    int    nw;
+    int    nx;
+    int    idx = 0;
+
+    if ((idx = validate_leafref_index_begin(h)) < 0)
+	goto done;
+    nw = clicon_option_int(h, "CLICON_VALIDATE_WORKERS");
+    nx = xml_child_nr_type(xt, CX_ELMNT);
+    if (nw > 1 && nx > 1 && *xret == NULL){
+	if (nw > nx)
+	    nw = nx;
+	if ((ret = xml_yang_validate_parallel(h, xt, nw, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+	if (ret == 1)
+	    goto unique;
+    }
+    xml_child_iter_init(&it, xt, CX_ELMNT);
+    while ((x = xml_child_iter_next(&it)) != NULL) {
+	if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+ unique:
+    if ((ret = check_list_unique_minmax(xt, xret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    retval = 1;
+ done:
+    if (idx == 1 && validate_leafref_index_end(h) < 0)
+	retval = -1;
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Constraint nodes marked with YANG_FLAG_DEP_SELF, see xml_yang_validate_changed_top
+ */
+struct validate_dep{
+    yang_stmt **vd_vec;
+    int         vd_len;
+};
+
+/*! Mark constraint nodes that may depend on a changed node
+ * @param[in]  yvec  Constraint nodes, see yang_dep_get
+ * @param[in]  ylen  Length of yvec
+ * @param[in]  vd    Marked nodes, to be reset after validation
+ */
+static int
+validate_dep_mark(yang_stmt         **yvec,
+		  int                 ylen,
+		  struct validate_dep *vd)
+{
+    int         retval = -1;
+    yang_stmt  *yc;
+    yang_stmt **vec;
+    int         i;
+
+    for (i=0; i<ylen; i++){
+	yc = yvec[i];
+	if (yang_flag_get(yc, YANG_FLAG_DEP_SELF))
+	    continue;
+	if ((vec = realloc(vd->vd_vec, (vd->vd_len+1)*sizeof(yang_stmt *))) == NULL){
+	    clicon_err(OE_YANG, errno, "realloc");
+	    goto done;
+	}
+	vec[vd->vd_len++] = yc;
+	vd->vd_vec = vec;
+	yang_flag_set(yc, YANG_FLAG_DEP_SELF);
+	/* Ancestors are traversed to find yc */
+	while ((yc = yang_parent_get(yc)) != NULL &&
+	       yang_keyword_get(yc) != Y_SPEC &&
+	       yang_flag_get(yc, YANG_FLAG_DEP_DESC) == 0)
+	    yang_flag_set(yc, YANG_FLAG_DEP_DESC);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Mark constraint nodes that may depend on an added or deleted subtree
+ * @param[in]  xt  Added or deleted XML node
+ * @param[in]  vd  Marked nodes
+ */
+static int
+validate_dep_mark_tree(cxobj               *xt,
+		       struct validate_dep *vd)
+{
+    yang_stmt  *ys;
+    yang_stmt **valvec;
+    int         vallen;
+    yang_stmt **pathvec;
+    int         pathlen;
+    cxobj      *x;
+
+    if ((ys = xml_spec(xt)) == NULL)
+	return 0;
+    yang_dep_get(ys, &valvec, &vallen, &pathvec, &pathlen);
+    if (validate_dep_mark(valvec, vallen, vd) < 0 ||
+	validate_dep_mark(pathvec, pathlen, vd) < 0)
+	return -1;
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
+	if (validate_dep_mark_tree(x, vd) < 0)
+	    return -1;
+    return 0;
+}
 
+/*! Mark constraint nodes that may depend on changed nodes in a target tree
+ * @param[in]  xt  Changed XML node, ie with XML_FLAG_CHANGE
+ * @param[in]  vd  Marked nodes
+ */
+static int
+validate_dep_mark_changed(cxobj               *xt,
+			  struct validate_dep *vd)
+{
+    yang_stmt  *ys;
+    yang_stmt **valvec;
+    int         vallen;
+    cxobj      *x;
+
+    /* The value, eg string value of a container, may have changed but not existence */
+    if ((ys = xml_spec(xt)) != NULL){
+	yang_dep_get(ys, &valvec, &vallen, NULL, NULL);
+	if (validate_dep_mark(valvec, vallen, vd) < 0)
+	    return -1;
+    }
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL){
+	if (xml_flag(x, XML_FLAG_ADD)){
+	    if (validate_dep_mark_tree(x, vd) < 0)
+		return -1;
+	}
+	else if (xml_flag(x, XML_FLAG_CHANGE)){
+	    if (validate_dep_mark_changed(x, vd) < 0)
+		return -1;
+	}
+    }
+    return 0;
+}
+
+/*! Validate a single XML node and its descendants incrementally
+ * @see xml_yang_validate_changed_top
+ */
+static int
+xml_yang_validate_changed(clicon_handle h,
+			  cxobj        *xt, 
+			  cxobj       **xret)
+{
+    int        retval = -1;
+    yang_stmt *ys;
+    int        ret;
+    cxobj     *x;
+    int        changed;
+
+    ys = xml_spec(xt);
+    if (xml_flag(xt, XML_FLAG_ADD) || (ys == NULL && xml_flag(xt, XML_FLAG_CHANGE)))
+	return xml_yang_validate_all(h, xt, xret);
+    changed = xml_flag(xt, XML_FLAG_CHANGE) != 0;
+    /* Unchanged: only check constraints that may depend on changed nodes */
+    if (!changed &&
+	(ys == NULL ||
+	 yang_flag_get(ys, YANG_FLAG_DEP_SELF|YANG_FLAG_DEP_DESC) == 0))
+	goto ok;
+    if (yang_config(ys) == 0)
+	goto ok;
+    switch (yang_keyword_get(ys)){
+    case Y_ANYXML:
+    case Y_ANYDATA:
+	goto ok;
+	break;
+    default:
+	break;
+    }
+    if (changed || yang_flag_get(ys, YANG_FLAG_DEP_SELF)){
+	if ((ret = xml_yang_validate_node(h, xt, ys, !changed, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+    if (changed || yang_flag_get(ys, YANG_FLAG_DEP_DESC)){
+	x = NULL;
+	while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+	    if ((ret = xml_yang_validate_changed(h, x, xret)) < 0)
+		goto done;
+	    if (ret == 0)
+		goto fail;
+	}
+    }
+    if (changed){
+	if ((ret = check_list_unique_minmax(xt, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
+    }
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate XML tree incrementally, ie only changed nodes and nodes that may depend on them
+ *
+ * Same result as xml_yang_validate_all_top() if the tree was valid before the change,
+ * with changed nodes marked with flags as in a commit:
+ * - XML_FLAG_ADD:    the node and its descendants are added and are fully validated
+ * - XML_FLAG_CHANGE: the node or a descendant is changed, removed or added. The node is
+ *                    validated, and its children incrementally
+ * Other nodes are unchanged and are only validated if they have leafref, must or when
+ * constraints that may reference added, changed or deleted nodes according to the
+ * reverse dependencies of the yang spec, see yang_dep_init.
+ * @param[in]  h     Clicon handle
+ * @param[in]  xt    XML top of tree
+ * @param[in]  dvec  Deleted XML nodes, not in xt
+ * @param[in]  dlen  Length of dvec
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see xml_yang_validate_all_top  for validating the whole tree
+ */
+int
+xml_yang_validate_changed_top(clicon_handle h,
+			      cxobj        *xt, 
+			      cxobj       **dvec,
+			      int           dlen,
+			      cxobj       **xret)
+{
+    int                 retval = -1;
+    int                 ret;
+    cxobj              *x;
+    yang_stmt          *yspec;
+    yang_stmt         **yvec;
+    int                 ylen;
+    yang_stmt          *yc;
+    struct validate_dep vd = {NULL, 0};
+    int                 i;
+    int                 idx = 0;
+
+    if ((idx = validate_leafref_index_begin(h)) < 0)
+	goto done;
+    /* Constraints that may depend on any node */
+    if ((yspec = clicon_dbspec_yang(h)) != NULL){
+	yang_dep_get(yspec, &yvec, &ylen, NULL, NULL);
+	if (validate_dep_mark(yvec, ylen, &vd) < 0)
+	    goto done;
+    }
+    for (i=0; i<dlen; i++)
+	if (validate_dep_mark_tree(dvec[i], &vd) < 0)
+	    goto done;
+    if (validate_dep_mark_changed(xt, &vd) < 0)
+	goto done;
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-	if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
-	    return ret;
+	if ((ret = xml_yang_validate_changed(h, x, xret)) < 0)
+	    goto done;
+	if (ret == 0)
+	    goto fail;
     }
-    if ((ret = check_list_unique_minmax(xt, xret)) < 1)
-	return ret;
-    return 1;
+    if ((ret = check_list_unique_minmax(xt, xret)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    retval = 1;
+ done:
+    for (i=0; i<vd.vd_len; i++){
+	yc = vd.vd_vec[i];
+	do {
+	    yang_flag_reset(yc, YANG_FLAG_DEP_SELF|YANG_FLAG_DEP_DESC);
+	} while ((yc = yang_parent_get(yc)) != NULL && yang_keyword_get(yc) != Y_SPEC);
+    }
+    if (vd.vd_vec)
+	free(vd.vd_vec);
+    if (idx == 1 && validate_leafref_index_end(h) < 0)
+	retval = -1;
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
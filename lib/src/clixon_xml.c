@@ -53,6 +53,9 @@
 #include <string.h>
 #include <limits.h>
 #include <assert.h>
+#include <syslog.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -70,22 +73,58 @@
 #include "clixon_yang_module.h"
 #include "clixon_xml_map.h" /* xml_bind_yang */
 #include "clixon_xml_vec.h"
+#include "clixon_xml_vec_internal.h" /* child vector of XML elements */
 #include "clixon_xml_sort.h"
 #include "clixon_xml_io.h"
 #include "clixon_xml_parse.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_xml_bind.h" /* xml_bind_yang_lazy_children */
 
 /*
  * Constants
  */
-/* How many XML children to start with if any. Then add quadratic until threshold when
- * add lineraly 
+/* How many XML children to start with if any, see clixon_xvec_grow for growth
  * Heurestics: if child is body only single child is expected, but element children may
  * have siblings
  */
 #define XML_CHILDVEC_SIZE_START 1        
 #define XML_CHILDVEC_SIZE_START_ELMNT 16 
-#define XML_CHILDVEC_SIZE_THRESHOLD 65536
+
+/* Minimum number of children of an XML node before a key hash table is built for its
+ * list entries, see xml_key_hash_find
+ */
+#define XML_KEY_HASH_MIN 64
+
+/* Minimum number of children of a sorted XML node before children are found by binary
+ * search on yang order, see xml_find_sorted
+ */
+#define XML_FIND_SORTED_MIN 8
+
+/* Child number i of XML element x, skipping the gap of the child vector */
+#define XML_CHILD(x, i) ((x)->x_children.xv_vec[XVEC_POS(&(x)->x_children, (i))])
+
+/* Values of body and attribute nodes up to this length (including NULL) are stored 
+ * inline in the XML node, see union xml_value
+ */
+#define XML_VALUE_INLINE_LEN 16
+
+/* Smallest heap allocation of values, heap values are allocated in powers of two */
+#define XML_VALUE_HEAP_MIN   32
+
+/* Size and alignment of arena blocks that XML nodes are allocated from, see xml_arena_begin
+ * Must be a power of two, the block of a node is found by masking its address 
+ */
+#define XML_ARENA_BLOCKSZ    (64*1024)
+
+/* Size and alignment of chunks of arena blocks backed by huge pages, see xml_arena_pages_set
+ * Must be a multiple of XML_ARENA_BLOCKSZ and of the huge page size
+ */
+#define XML_ARENA_CHUNKSZ    (2*1024*1024)
+
+/* Memory policy of mbind(2), see linux/mempolicy.h */
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
 
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
@@ -93,12 +132,39 @@
 #define is_element(x) (xml_type(x)==CX_ELMNT)
 #define is_bodyattr(x) (xml_type(x)==CX_BODY || xml_type(x)==CX_ATTR)
 
+/* Value of a body or attribute node, see struct xmlbody */
+#define XML_VALUE(x) (((struct xmlbody *)(x))->xb_value)
+
+/* Rarely used field f of an element, or NULL if not allocated, see struct xml_cold */
+#define XML_COLD(x, f) ((x)->x_cold ? (x)->x_cold->f : NULL)
+
 /*
  * Types
  */
 
+/* How the value of a body or attribute node is stored, see union xml_value */
+enum xml_value_mode{
+    XV_NONE = 0, /* No value */
+    XV_INLINE,   /* Small value stored in xv_inline */
+    XV_HEAP,     /* Malloced value in xv_str, size is xml_value_heapsz() of its length */
+    XV_INTERN,   /* Shared value in xv_str, see xml_intern_get() */
+};
+
+/* Value of body and attribute nodes.
+ * Most leaf values are short (numbers, booleans, enums, addresses) and are stored inline
+ * in the node itself. Longer values are malloced, and repeated values of enumeration
+ * and identityref leafs can be shared between nodes, see xml_value_intern
+ * @see enum xml_value_mode
+ */
+union xml_value{
+    char   *xv_str;                          /* XV_HEAP or XV_INTERN */
+    char    xv_inline[XML_VALUE_INLINE_LEN]; /* XV_INLINE */
+};
+
 #ifdef XML_EXPLICIT_INDEX
 static int xml_search_index_free(cxobj *x);
+static int xml_search_index_entry(cxobj *xpp, cxobj *xe, int insert);
+static struct search_index *xml_search_index_add(cxobj *x, char *name);
 
 /* A search index pair consisting of a name of an (index) variable and a vector of xml children
  * the variable should be a potential child of the XML node
@@ -110,7 +176,7 @@ static int xml_search_index_free(cxobj *x);
  *
  *                    index: "i"
  *               +-----+-----+-----+
- * x_childvec:   |  a  |  b  |  c  |
+ * x_children:   |  a  |  b  |  c  |
  *               +-----+-----+-----+
  *                  |     |     |
  *                  v     v     v
@@ -126,6 +192,34 @@ struct search_index{
 };
 #endif
 
+#ifdef XML_SUBTREE_HASH
+static void xml_hash_reset(cxobj *x);
+#endif
+
+#ifdef XML_KEY_HASH
+static int xml_key_hash_insert(cxobj *xp, cxobj *xc);
+static int xml_key_hash_rm(cxobj *xp, cxobj *xc);
+static int xml_key_hash_free(cxobj *xp);
+
+/* Slot in a key hash table, see struct xml_key_hash */
+struct xml_key_slot{
+    uint32_t     ks_hash; /* Hash of yang list and key values of ks_x */
+    struct xml  *ks_x;    /* List entry, or NULL if slot is empty */
+};
+
+/* Hash table of the list entries of an XML node, indexed by yang list and all key values
+ * Open addressing with linear probing, the table has at least twice as many slots as entries.
+ * Entries are verified against the key values of the node on lookup, and missing entries
+ * (eg list entries inserted before their keys were set) are found by binary search instead.
+ * @see xml_key_hash_find
+ */
+struct xml_key_hash{
+    size_t               kh_len;   /* Number of entries */
+    size_t               kh_size;  /* Number of slots, power of two */
+    struct xml_key_slot *kh_slots; /* Vector of slots */
+};
+#endif
+
 /*! xml tree node, with name, type, parent, children, etc 
  * Note that this is a private type not visible from externally, use
  * access functions.
@@ -161,45 +255,62 @@ struct search_index{
  * @see struct xmlbody    For XML body and attributes
  */
 struct xml{
+    /*----- common to all nodes, see struct xmlbody */
     enum cxobj_type   x_type;       /* type of node: element, attribute, body */
-    char             *x_name;       /* name of node */
-    char             *x_prefix;     /* namespace localname N, called prefix */
     uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           x_vmode;      /* body/attribute only: enum xml_value_mode */
+    uint8_t           x_arena;      /* Allocated from an arena block, see xml_arena_begin */
+    char             *x_name;       /* name of node */
     struct xml       *x_up;         /* parent node in hierarchy if any */
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for sorting: 
 				       see xml_enumerate and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-				       memory) cv? */
+    char             *x_prefix;     /* namespace localname N, called prefix */
     /*----- up to here is common to all next is element only */
-    struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
-    int               x_childvec_len;/* Number of children */
-    int               x_childvec_max;/* Length of allocated vector */
-
-
-    cvec             *x_ns_cache;   /* Cached vector of namespaces (set by bind-yang) */
     yang_stmt        *x_spec;       /* Pointer to specification, eg yang, 
 				       by reference, dont free */
-    cg_var           *x_cv;         /* Cached value as cligen variable (set by xml_cmp) */
+    struct clixon_xml_vec x_children; /* Vector of children nodes (with gap) */
+    /*----- end of first cache line (64-bit), next is used on modification and search */
+#ifdef XML_KEY_HASH
+    struct xml_key_hash *x_key_hash; /* Hash of list entry children, see xml_key_hash_find */
+#endif
+#ifdef XML_SUBTREE_HASH
+    uint64_t          x_hash;       /* Cached hash of subtree or 0, see xml_hash */
+#endif
+    struct xml_cold  *x_cold;       /* Rarely used fields or NULL, see xml_cold */
+};
+
+/* Rarely used fields of an XML element, allocated on first use
+ * @see xml_cold
+ */
+struct xml_cold{
+    cvec             *xc_ns_cache;  /* Cached vector of namespaces (set by bind-yang) */
+    cg_var           *xc_cv;        /* Cached value as cligen variable (set by xml_cmp) */
 #ifdef XML_EXPLICIT_INDEX
-    struct search_index *x_search_index; /* explicit search index vectors */
+    struct search_index *xc_search_index; /* explicit search index vectors */
+#endif
+#ifdef XML_PATH_CACHE
+    char             *xc_path[XML_PATH_NR];     /* Cached paths of list entry */
+    uint64_t          xc_path_gen[XML_PATH_NR]; /* Generation of xc_path, see _xml_path_gen */
 #endif
 };
 
 /* Variant of struct xml for use by non-elements to save space
+ * The fields up to xb_prefix are the same as in struct xml
  * @see struct xml  For XML elements
  */
 struct xmlbody{
     enum cxobj_type   xb_type;       /* type of node: element, attribute, body */
-    char             *xb_name;       /* name of node */
-    char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           xb_vmode;      /* enum xml_value_mode */
+    uint8_t           xb_arena;      /* Allocated from an arena block */
+    char             *xb_name;       /* name of node */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
 				       see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    char             *xb_prefix;     /* namespace localname N, called prefix */
+    union xml_value   xb_value;      /* attribute and body nodes have values */
 };
 
 /*
@@ -215,6 +326,13 @@ static const map_str2int xsmap[] = {
     {NULL,           -1}
 };
 
+#ifdef XML_PATH_CACHE
+/* Generation of cached paths, incremented when a node is moved or renamed or a list key
+ * may change. Paths cached in an older generation are obsolete, see xml_path_cache_get
+ */
+static uint64_t _xml_path_gen = 1;
+#endif
+
 /*! Translate from xml type in enum form to string keyword
  * @param[in] type  Xml type
  * @retval    str   String keyword
@@ -228,6 +346,346 @@ xml_type2str(enum cxobj_type type)
 /* Stats */
 uint64_t _stats_nr = 0;
 
+/* Set if any tree is bound with xml_bind_yang_lazy, see xml_spec_lazy_enable */
+static int _xml_lazy = 0;
+
+/* Interned strings shared between XML nodes: values and, if XML_INTERN_NAMES, names
+ * and prefixes. Key is the string, value is a reference count
+ * @see xml_intern_get
+ */
+static clicon_hash_t *_xml_intern = NULL;
+
+/*! Get a shared copy of a string from the intern table
+ * @param[in]  str  String
+ * @retval     s    Shared string, release with xml_intern_put(). Do not modify or free
+ * @retval     NULL Error
+ */
+static char *
+xml_intern_get(const char *str)
+{
+    clicon_hash_t h;
+    size_t        refcnt = 1;
+
+    if (_xml_intern == NULL &&
+	(_xml_intern = clicon_hash_init()) == NULL)
+	return NULL;
+    if ((h = clicon_hash_lookup(_xml_intern, str)) != NULL)
+	(*(size_t*)h->h_val)++;
+    else if ((h = clicon_hash_add(_xml_intern, str, &refcnt, sizeof(refcnt))) == NULL)
+	return NULL;
+    return h->h_key;
+}
+
+/*! Release a shared string, remove it from the intern table if not used
+ * @param[in]  str  Shared string as returned by xml_intern_get
+ * @retval     0    OK
+ * @retval    -1    Error, string not found
+ */
+static int
+xml_intern_put(const char *str)
+{
+    clicon_hash_t h;
+
+    if (_xml_intern == NULL ||
+	(h = clicon_hash_lookup(_xml_intern, str)) == NULL){
+	clicon_err(OE_XML, ENOENT, "String is not interned: %s", str);
+	return -1;
+    }
+    if (--(*(size_t*)h->h_val) == 0)
+	clicon_hash_del(_xml_intern, str);
+    return 0;
+}
+
+/* Header of an arena block. Nodes are allocated after the header by bumping xab_used.
+ * The block is freed when the last node allocated from it is freed.
+ * Blocks backed by huge pages are carved from chunks, and the header of the first block
+ * of a chunk also counts the blocks of the chunk, see xml_arena_chunk_new
+ */
+struct xml_arena_block{
+    size_t   xab_refcnt; /* Nr of live nodes in block (+1 while it is the current block) */
+    size_t   xab_used;   /* Bytes used including header */
+    int      xab_chunk;  /* Block is part of a chunk, else allocated with posix_memalign */
+    size_t   xab_blocks; /* First block of chunk: nr of live blocks (+1 while current chunk) */
+};
+
+/* Arena state: nesting level of xml_arena_begin and current block to allocate from */
+static int                     _xml_arena_level = 0;
+static struct xml_arena_block *_xml_arena_block = NULL;
+
+/* Huge page state: backing of new blocks, NUMA binding, and current chunk to carve from */
+static enum xml_arena_pages    _xml_arena_pages = XML_ARENA_PAGES_NONE;
+static int                     _xml_arena_numa = 0;
+static struct xml_arena_block *_xml_arena_chunk = NULL;
+static size_t                  _xml_arena_chunk_next = 0; /* Next block of chunk */
+
+/*! Back arena blocks with huge pages and bind them to the NUMA node of the caller
+ *
+ * Nodes of large trees, such as the datastore cache, are spread over many blocks, and 
+ * traversing them misses the TLB often with 4K pages. With huge pages, blocks are
+ * carved from 2M chunks that are each mapped by one TLB entry.
+ * A chunk is unmapped when all its blocks are freed.
+ * @param[in]  pages  Backing of arena blocks allocated from now on
+ * @param[in]  numa   If set, prefer memory of chunks on the NUMA node the caller runs on
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @note Only Linux has huge pages and NUMA binding, otherwise blocks are malloced
+ * @see CLICON_XMLDB_HUGEPAGES
+ */
+int
+xml_arena_pages_set(enum xml_arena_pages pages,
+		    int                  numa)
+{
+#ifndef MADV_HUGEPAGE
+    if (pages != XML_ARENA_PAGES_NONE)
+	clicon_log(LOG_WARNING, "%s: huge pages not supported, using regular pages", __FUNCTION__);
+    pages = XML_ARENA_PAGES_NONE;
+#endif
+    _xml_arena_pages = pages;
+    _xml_arena_numa = numa;
+    return 0;
+}
+
+/*! Prefer memory of a chunk on the NUMA node of the calling thread
+ * Must be made before the chunk is touched, since pages are placed on first access.
+ * Failure is not an error, the chunk is then placed according to the default policy.
+ * @param[in]  p    Start of chunk
+ * @param[in]  len  Length of chunk
+ */
+static void
+xml_arena_chunk_numa(void  *p,
+		     size_t len)
+{
+#if defined(SYS_getcpu) && defined(SYS_mbind)
+    unsigned int  cpu;
+    unsigned int  node;
+    unsigned long mask;
+
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) < 0)
+	return;
+    if (node >= 8*sizeof(mask))
+	return;
+    mask = 1UL << node;
+    /* The kernel reads one bit less than maxnode */
+    if (syscall(SYS_mbind, p, len, MPOL_PREFERRED, &mask, 8*sizeof(mask)+1, 0) < 0)
+	clicon_debug(1, "%s mbind node %u: %s", __FUNCTION__, node, strerror(errno));
+#endif
+}
+
+/*! Map a chunk of huge pages that arena blocks are carved from
+ * Explicit huge pages are reserved by the administrator, eg in 
+ * /proc/sys/vm/nr_hugepages. If none are available, transparent huge pages are used
+ * instead from then on.
+ * Transparent huge pages are advised on a chunk aligned to its size, the kernel may
+ * back it with regular pages if no huge page is available.
+ * @retval     xab   First block of chunk
+ * @retval     NULL  Error
+ */
+static struct xml_arena_block *
+xml_arena_chunk_new(void)
+{
+    struct xml_arena_block *xab = NULL;
+    char                   *p;
+    uintptr_t               a;
+    size_t                  len;
+#ifdef MAP_HUGETLB
+    int                     flags;
+#endif
+
+#ifdef MAP_HUGETLB
+    if (_xml_arena_pages == XML_ARENA_PAGES_EXPLICIT){
+	flags = MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB;
+#ifdef MAP_HUGE_2MB
+	flags |= MAP_HUGE_2MB;
+#endif
+	p = mmap(NULL, XML_ARENA_CHUNKSZ, PROT_READ|PROT_WRITE, flags, -1, 0);
+	if (p != MAP_FAILED && ((uintptr_t)p & (XML_ARENA_CHUNKSZ - 1)) == 0)
+	    xab = (struct xml_arena_block *)p;
+	else{
+	    if (p != MAP_FAILED)
+		munmap(p, XML_ARENA_CHUNKSZ);
+	    clicon_log(LOG_WARNING, "%s: no explicit huge pages, using transparent huge pages: %s",
+		       __FUNCTION__, strerror(errno));
+	    _xml_arena_pages = XML_ARENA_PAGES_TRANSPARENT;
+	}
+    }
+#endif
+    if (xab == NULL){
+	/* Map twice the size and trim to a chunk aligned to its size */
+	len = 2*XML_ARENA_CHUNKSZ;
+	if ((p = mmap(NULL, len, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0)) == MAP_FAILED){
+	    clicon_err(OE_XML, errno, "mmap");
+	    return NULL;
+	}
+	a = ((uintptr_t)p + XML_ARENA_CHUNKSZ - 1) & ~((uintptr_t)XML_ARENA_CHUNKSZ - 1);
+	if (a > (uintptr_t)p)
+	    munmap(p, a - (uintptr_t)p);
+	if ((uintptr_t)p + len > a + XML_ARENA_CHUNKSZ)
+	    munmap((char*)a + XML_ARENA_CHUNKSZ, (uintptr_t)p + len - a - XML_ARENA_CHUNKSZ);
+	xab = (struct xml_arena_block *)a;
+#ifdef MADV_HUGEPAGE
+	if (madvise(xab, XML_ARENA_CHUNKSZ, MADV_HUGEPAGE) < 0)
+	    clicon_debug(1, "%s madvise: %s", __FUNCTION__, strerror(errno));
+#endif
+    }
+    if (_xml_arena_numa)
+	xml_arena_chunk_numa(xab, XML_ARENA_CHUNKSZ);
+    xab->xab_blocks = 1; /* Current chunk */
+    return xab;
+}
+
+/*! Release a block of a chunk, unmap the chunk if none of its blocks are used
+ * @param[in]  xab  First block of chunk
+ */
+static void
+xml_arena_chunk_release(struct xml_arena_block *xab)
+{
+    if (--xab->xab_blocks == 0)
+	munmap(xab, XML_ARENA_CHUNKSZ);
+}
+
+/*! Release a reference to an arena block, free it if not used
+ * @param[in]  xab  Arena block
+ */
+static void
+xml_arena_block_release(struct xml_arena_block *xab)
+{
+    if (--xab->xab_refcnt == 0){
+	if (xab->xab_chunk)
+	    xml_arena_chunk_release((struct xml_arena_block *)
+				    ((uintptr_t)xab & ~((uintptr_t)XML_ARENA_CHUNKSZ - 1)));
+	else
+	    free(xab);
+    }
+}
+
+/*! Allocate a new arena block, from a chunk of huge pages if enabled
+ * @retval     xab   Arena block, header not initialized
+ * @retval     NULL  Error
+ */
+static struct xml_arena_block *
+xml_arena_block_new(void)
+{
+    struct xml_arena_block *xab;
+    struct xml_arena_block *xc;
+    int                     ret;
+
+    if (_xml_arena_pages == XML_ARENA_PAGES_NONE){
+	if ((ret = posix_memalign((void**)&xab, XML_ARENA_BLOCKSZ, XML_ARENA_BLOCKSZ)) != 0){
+	    clicon_err(OE_XML, ret, "posix_memalign");
+	    return NULL;
+	}
+	xab->xab_chunk = 0;
+	return xab;
+    }
+    if (_xml_arena_chunk == NULL ||
+	_xml_arena_chunk_next == XML_ARENA_CHUNKSZ/XML_ARENA_BLOCKSZ){
+	if ((xc = xml_arena_chunk_new()) == NULL)
+	    return NULL;
+	if (_xml_arena_chunk)
+	    xml_arena_chunk_release(_xml_arena_chunk);
+	_xml_arena_chunk = xc;
+	_xml_arena_chunk_next = 0;
+    }
+    /* Do not touch xab_blocks, the first block header is also the chunk header */
+    xab = (struct xml_arena_block *)((char*)_xml_arena_chunk + 
+				     _xml_arena_chunk_next++ * XML_ARENA_BLOCKSZ);
+    _xml_arena_chunk->xab_blocks++;
+    xab->xab_chunk = 1;
+    return xab;
+}
+
+/*! Start allocating XML nodes from arena blocks
+ *
+ * Between xml_arena_begin and xml_arena_end, xml_new() allocates nodes by bumping a pointer
+ * in large blocks instead of one malloc per node. This is intended for building large 
+ * trees at once, eg when parsing a file.
+ * A block is freed when all nodes allocated from it are freed, so nodes can be freed or
+ * moved to other trees as usual. Space of freed nodes is not reused until the whole 
+ * block is freed.
+ * Calls can be nested, and must be matched by xml_arena_end.
+ * @retval     0     OK
+ * @see xml_arena_end
+ * @see XML_ARENA
+ */
+int
+xml_arena_begin(void)
+{
+    _xml_arena_level++;
+    return 0;
+}
+
+/*! Stop allocating XML nodes from arena blocks
+ * @retval     0     OK
+ * @see xml_arena_begin
+ */
+int
+xml_arena_end(void)
+{
+    if (_xml_arena_level > 0 && --_xml_arena_level == 0 &&
+	_xml_arena_block != NULL){
+	xml_arena_block_release(_xml_arena_block);
+	_xml_arena_block = NULL;
+    }
+    return 0;
+}
+
+/*! Allocate an XML node from the current arena block
+ * @param[in]  sz   Size of node
+ * @retval     x    Allocated memory, not initialized
+ * @retval     NULL Error
+ */
+static void *
+xml_arena_alloc(size_t sz)
+{
+    struct xml_arena_block *xab;
+    void                   *p;
+    size_t                  hsz;
+
+    sz = (sz + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    hsz = (sizeof(*xab) + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+    if ((xab = _xml_arena_block) == NULL ||
+	xab->xab_used + sz > XML_ARENA_BLOCKSZ){
+	if ((xab = xml_arena_block_new()) == NULL)
+	    return NULL;
+	xab->xab_refcnt = 1; /* Current block */
+	xab->xab_used = hsz;
+	if (_xml_arena_block)
+	    xml_arena_block_release(_xml_arena_block);
+	_xml_arena_block = xab;
+    }
+    p = (char*)xab + xab->xab_used;
+    xab->xab_used += sz;
+    xab->xab_refcnt++;
+    return p;
+}
+
+/*! Free an XML node allocated from an arena block
+ * @param[in]  x    XML node
+ */
+static void
+xml_arena_free(cxobj *x)
+{
+    struct xml_arena_block *xab;
+
+    xab = (struct xml_arena_block *)((uintptr_t)x & ~((uintptr_t)XML_ARENA_BLOCKSZ - 1));
+    xml_arena_block_release(xab);
+}
+
+/*! Heap size of a value of given size
+ * Allocate in powers of two so that appends are amortized without storing capacity
+ * @param[in]  sz   Size of value including NULL
+ * @retval     sz   Size to allocate
+ */
+static size_t
+xml_value_heapsz(size_t sz)
+{
+    size_t hsz = XML_VALUE_HEAP_MIN;
+
+    while (hsz < sz)
+	hsz <<= 1;
+    return hsz;
+}
+
 /*! Get global statistics about XML objects
  */
 int
@@ -250,35 +708,52 @@ xml_stats_one(cxobj    *x,
 	      size_t   *szp)
 {
     size_t sz = 0;
+#ifdef XML_PATH_CACHE
+    int    i;
+#endif
 
+#ifndef XML_INTERN_NAMES /* Interned names are shared */
     if (x->x_name)
 	sz += strlen(x->x_name) + 1;
     if (x->x_prefix)
 	sz += strlen(x->x_prefix) + 1;
+#endif
     switch (xml_type(x)){
     case CX_ELMNT:
 	sz += sizeof(struct xml);
-	sz += x->x_childvec_max*sizeof(struct xml*);
-	if (x->x_ns_cache)
-	    sz += cvec_size(x->x_ns_cache);
-	if (x->x_cv)
-	    sz += cv_size(x->x_cv);
+	sz += x->x_children.xv_max*sizeof(struct xml*);
+	if (x->x_cold){
+	    sz += sizeof(struct xml_cold);
+	    if (x->x_cold->xc_ns_cache)
+		sz += cvec_size(x->x_cold->xc_ns_cache);
+	    if (x->x_cold->xc_cv)
+		sz += cv_size(x->x_cold->xc_cv);
+#ifdef XML_PATH_CACHE
+	    for (i=0; i<XML_PATH_NR; i++)
+		if (x->x_cold->xc_path[i])
+		    sz += strlen(x->x_cold->xc_path[i]) + 1;
+#endif
+	}
 #ifdef XML_EXPLICIT_INDEX
-	if (x->x_search_index){
+	if (XML_COLD(x, xc_search_index)){
 	    /* XXX: only one */
 	    sz += sizeof(struct search_index);
-	    if (x->x_search_index->si_name)
-		sz += strlen(x->x_search_index->si_name)+1;
-	    if (x->x_search_index->si_xvec)
-		sz += clixon_xvec_len(x->x_search_index->si_xvec)*sizeof(struct cxobj*);
+	    if (XML_COLD(x, xc_search_index)->si_name)
+		sz += strlen(XML_COLD(x, xc_search_index)->si_name)+1;
+	    if (XML_COLD(x, xc_search_index)->si_xvec)
+		sz += clixon_xvec_len(XML_COLD(x, xc_search_index)->si_xvec)*sizeof(struct cxobj*);
 	}
+#endif
+#ifdef XML_KEY_HASH
+	if (x->x_key_hash)
+	    sz += sizeof(struct xml_key_hash) + x->x_key_hash->kh_size*sizeof(struct xml_key_slot);
 #endif
 	break;
     case CX_BODY:
     case CX_ATTR:
 	sz += sizeof(struct xmlbody);
-	if (x->x_value_cb)
-	    sz += cbuf_buflen(x->x_value_cb);
+	if (x->x_vmode == XV_HEAP) /* Inline is in struct, interned is shared */
+	    sz += xml_value_heapsz(strlen(XML_VALUE(x).xv_str)+1);
 	break;
     default:
 	break;
@@ -310,19 +785,19 @@ xml_print_stats_one(FILE   *f,
     if (x->x_prefix)
 	fprintf(f, "  prefix: \t%u\n", (unsigned int)strlen(x->x_prefix) + 1);
     if (xml_type(x) == CX_ELMNT){
-	if (x->x_childvec_max)
-	    fprintf(f, "  childvec: \t%u\n", (unsigned int)(x->x_childvec_max*sizeof(struct xml*)));
-	if (x->x_ns_cache)
-	    fprintf(f, "  ns-cache: \t%u\n", (unsigned int)cvec_size(x->x_ns_cache));
-	if (x->x_cv)
-	    fprintf(f, "  value-cv: \t%u\n", (unsigned int)cv_size(x->x_cv));
-	if (x->x_search_index)
+	if (x->x_children.xv_max)
+	    fprintf(f, "  childvec: \t%u\n", (unsigned int)(x->x_children.xv_max*sizeof(struct xml*)));
+	if (XML_COLD(x, xc_ns_cache))
+	    fprintf(f, "  ns-cache: \t%u\n", (unsigned int)cvec_size(x->x_cold->xc_ns_cache));
+	if (XML_COLD(x, xc_cv))
+	    fprintf(f, "  value-cv: \t%u\n", (unsigned int)cv_size(x->x_cold->xc_cv));
+	if (XML_COLD(x, xc_search_index))
 	    fprintf(f, "  search-index: \t%u\n",
-		    (unsigned int)(strlen(x->x_search_index->si_name) + 1 + clixon_xvec_len(x->x_search_index->si_xvec)*sizeof(struct cxobj*)));
+		    (unsigned int)(strlen(XML_COLD(x, xc_search_index)->si_name) + 1 + clixon_xvec_len(XML_COLD(x, xc_search_index)->si_xvec)*sizeof(struct cxobj*)));
     }
     else{
-	if (x->x_value_cb)
-	    fprintf(f, "  value-cb: \t%u\n", cbuf_buflen(x->x_value_cb));
+	if (x->x_vmode == XV_HEAP)
+	    fprintf(f, "  value: \t%u\n", (unsigned int)xml_value_heapsz(strlen(XML_VALUE(x).xv_str)+1));
     }
     return 0;
 }
@@ -381,6 +856,19 @@ xml_name(cxobj *xn)
     return xn->x_name;
 }
 
+/*! Reset sorted flag of the parent of an XML node, its order may have changed
+ * @param[in]  x    XML node
+ * @see XML_FLAG_SORTED
+ */
+static void
+xml_sorted_reset(cxobj *x)
+{
+    cxobj *xp;
+
+    if ((xp = xml_parent(x)) != NULL)
+	xp->x_flags &= ~XML_FLAG_SORTED;
+}
+
 /*! Set name of xnode, name is copied
  * @param[in]  xn    xml node
  * @param[in]  name  new name, null-terminated string, copied by function
@@ -391,6 +879,26 @@ int
 xml_name_set(cxobj *xn, 
 	     char  *name)
 {
+#ifdef XML_INTERN_NAMES
+    char *str = NULL;
+#endif
+
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(xn);
+#endif
+#ifdef XML_PATH_CACHE
+    _xml_path_gen++;
+#endif
+    xml_sorted_reset(xn);
+#ifdef XML_INTERN_NAMES
+
+    /* Get new before releasing old, name may be the old name */
+    if (name && (str = xml_intern_get(name)) == NULL)
+	return -1;
+    if (xn->x_name && xml_intern_put(xn->x_name) < 0)
+	return -1;
+    xn->x_name = str;
+#else
     if (xn->x_name){
 	free(xn->x_name);
 	xn->x_name = NULL;
@@ -401,6 +909,7 @@ xml_name_set(cxobj *xn,
 	    return -1;
 	}
     }
+#endif
     return 0;
 }
 
@@ -424,6 +933,22 @@ int
 xml_prefix_set(cxobj *xn, 
 	       char  *prefix)
 {
+#ifdef XML_INTERN_NAMES
+    char *str = NULL;
+#endif
+
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(xn);
+#endif
+    xml_sorted_reset(xn);
+#ifdef XML_INTERN_NAMES
+
+    if (prefix && (str = xml_intern_get(prefix)) == NULL)
+	return -1;
+    if (xn->x_prefix && xml_intern_put(xn->x_prefix) < 0)
+	return -1;
+    xn->x_prefix = str;
+#else
     if (xn->x_prefix){
 	free(xn->x_prefix);
 	xn->x_prefix = NULL;
@@ -434,9 +959,116 @@ xml_prefix_set(cxobj *xn,
 	    return -1;
 	}
     }
+#endif
     return 0;
 }
 
+/*! Get rarely used fields of an XML element, allocate them if not present
+ * @param[in] x      XML element
+ * @retval    xc     Cold fields of x
+ * @retval    NULL   Error
+ * Fields not used in traversal are kept apart from struct xml so that the fields
+ * accessed when walking a tree are in the same cache line.
+ * @see XML_COLD  to read a field without allocating
+ */
+static struct xml_cold *
+xml_cold(cxobj *x)
+{
+    if (x->x_cold == NULL){
+	if ((x->x_cold = malloc(sizeof(struct xml_cold))) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return NULL;
+	}
+	memset(x->x_cold, 0, sizeof(struct xml_cold));
+    }
+    return x->x_cold;
+}
+
+#ifdef XML_PATH_CACHE
+/*! Make cached paths obsolete if a body of a list key changes
+ * Only if the list entry, ie the parent of the leaf of the body, has a cached path,
+ * since paths of list entries below it are cached together with it
+ * @param[in] xb   Body node
+ */
+static void
+xml_path_body_reset(cxobj *xb)
+{
+    cxobj *xe;
+    int    i;
+
+    if (xml_type(xb) != CX_BODY || xb->x_up == NULL ||
+	(xe = xb->x_up->x_up) == NULL || xe->x_cold == NULL)
+	return;
+    for (i=0; i<XML_PATH_NR; i++)
+	if (xe->x_cold->xc_path[i] != NULL){
+	    _xml_path_gen++;
+	    break;
+	}
+}
+
+/*! Get cached path of a list entry
+ * @param[in]  x     XML list entry
+ * @param[in]  type  Path format
+ * @retval     path  Path from root, valid until the tree is changed
+ * @retval     NULL  Not cached, or obsolete
+ * @see xml_path_cache_set
+ */
+char *
+xml_path_cache_get(cxobj             *x,
+		   enum xml_path_type type)
+{
+    struct xml_cold *xc;
+
+    if (!is_element(x) ||
+	(xc = x->x_cold) == NULL ||
+	xc->xc_path[type] == NULL ||
+	xc->xc_path_gen[type] != _xml_path_gen)
+	return NULL;
+    return xc->xc_path[type];
+}
+
+/*! Set cached path of a list entry, path is copied
+ * @param[in]  x     XML list entry
+ * @param[in]  type  Path format
+ * @param[in]  path  Path from root
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xml_path_cache_set(cxobj             *x,
+		   enum xml_path_type type,
+		   char              *path)
+{
+    struct xml_cold *xc;
+
+    if (!is_element(x))
+	return 0;
+    if ((xc = xml_cold(x)) == NULL)
+	return -1;
+    if (xc->xc_path[type])
+	free(xc->xc_path[type]);
+    if ((xc->xc_path[type] = strdup(path)) == NULL){
+	clicon_err(OE_XML, errno, "strdup");
+	return -1;
+    }
+    xc->xc_path_gen[type] = _xml_path_gen;
+    return 0;
+}
+#endif /* XML_PATH_CACHE */
+
+/*! Clear cached cligen value of a leaf, eg when its body changes
+ * @param[in] x      XML element, or NULL
+ * @see xml_cv
+ */
+static void
+xml_cv_reset(cxobj *x)
+{
+    if (x && x->x_cold && x->x_cold->xc_cv){
+	cv_free(x->x_cold->xc_cv);
+	x->x_cold->xc_cv = NULL;
+    }
+}
+
 /*! Get cached namespace (given prefix)
  * @param[in] x      XML node
  * @param[in] prefix Namespace prefix, or NULL for default
@@ -448,10 +1080,12 @@ char*
 nscache_get(cxobj *x,
 	    char  *prefix)
 {
+    cvec *nsc;
+
     if (!is_element(x))
 	return NULL;
-    if (x->x_ns_cache != NULL)
-	return xml_nsctx_get(x->x_ns_cache, prefix);
+    if ((nsc = XML_COLD(x, xc_ns_cache)) != NULL)
+	return xml_nsctx_get(nsc, prefix);
     return NULL;
 }
 
@@ -467,10 +1101,12 @@ nscache_get_prefix(cxobj *x,
 		   char  *namespace,
 		   char **prefix)
 {
+    cvec *nsc;
+
     if (!is_element(x))
 	return 0;
-    if (x->x_ns_cache != NULL)
-	return xml_nsctx_get_prefix(x->x_ns_cache, namespace, prefix);
+    if ((nsc = XML_COLD(x, xc_ns_cache)) != NULL)
+	return xml_nsctx_get_prefix(nsc, namespace, prefix);
     return 0;
 }
 
@@ -485,7 +1121,7 @@ nscache_get_all(cxobj *x)
 {
     if (!is_element(x))
 	return NULL;
-    return x->x_ns_cache;
+    return XML_COLD(x, xc_ns_cache);
 }
 
 /*! Set cached namespace for specific namespace. Replace if necessary
@@ -501,16 +1137,19 @@ nscache_set(cxobj *x,
 	    char  *prefix,
 	    char  *namespace)
 {
-    int     retval = -1;
+    int              retval = -1;
+    struct xml_cold *xc;
 
     if (!is_element(x))
 	return 0;
-    if (x->x_ns_cache == NULL){
-	if ((x->x_ns_cache = xml_nsctx_init(prefix, namespace)) == NULL)
+    if ((xc = xml_cold(x)) == NULL)
+	goto done;
+    if (xc->xc_ns_cache == NULL){
+	if ((xc->xc_ns_cache = xml_nsctx_init(prefix, namespace)) == NULL)
 	    goto done;
     }
     else 
-	return xml_nsctx_add(x->x_ns_cache, prefix, namespace);
+	return xml_nsctx_add(xc->xc_ns_cache, prefix, namespace);
     retval = 0;
  done:
     return retval;
@@ -527,17 +1166,23 @@ int
 nscache_replace(cxobj *x,
 		cvec  *nsc)
 {
-    int     retval = -1;
+    int              retval = -1;
+    struct xml_cold *xc;
 
     if (!is_element(x))
 	return 0;
-    if (x->x_ns_cache != NULL){
-	xml_nsctx_free(x->x_ns_cache);
-	x->x_ns_cache = NULL;
+    if ((xc = xml_cold(x)) == NULL){
+	if (nsc)
+	    xml_nsctx_free(nsc);
+	goto done;
+    }
+    if (xc->xc_ns_cache != NULL){
+	xml_nsctx_free(xc->xc_ns_cache);
+	xc->xc_ns_cache = NULL;
     }
-    x->x_ns_cache = nsc;
+    xc->xc_ns_cache = nsc;
     retval = 0;
-    // done:
+ done:
     return retval;
 }
 
@@ -554,9 +1199,9 @@ nscache_clear(cxobj *x)
 
     if (!is_element(x))
 	return 0;
-    if (x->x_ns_cache != NULL){
-	xml_nsctx_free(x->x_ns_cache);
-	x->x_ns_cache = NULL;
+    if (XML_COLD(x, xc_ns_cache) != NULL){
+	xml_nsctx_free(x->x_cold->xc_ns_cache);
+	x->x_cold->xc_ns_cache = NULL;
     }
     return 0;
 }
@@ -583,6 +1228,10 @@ int
 xml_parent_set(cxobj *xn, 
 	       cxobj *parent)
 {
+#ifdef XML_PATH_CACHE
+    if (xn->x_up != parent)
+	_xml_path_gen++;
+#endif
     xn->x_up = parent;
     return 0;
 }
@@ -631,21 +1280,55 @@ xml_value(cxobj *xn)
 {
     if (!is_bodyattr(xn))
 	return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    switch (xn->x_vmode){
+    case XV_INLINE:
+	return XML_VALUE(xn).xv_inline;
+    case XV_HEAP:
+    case XV_INTERN:
+	return XML_VALUE(xn).xv_str;
+    default:
+	break;
+    }
+    return NULL;
 }
 
-/*! Set value of xml node, value is copied
+/*! Free value of xml body or attribute node
  * @param[in]  xn    xml node
- * @param[in]  val   new value, null-terminated string, copied by function
- * @retval     -1    on error with clicon-err set
- * @retval     0     OK
  */
-int
-xml_value_set(cxobj *xn, 
-	      char  *val)
+static int
+xml_value_free(cxobj *xn)
+{
+    int retval = -1;
+
+    switch (xn->x_vmode){
+    case XV_HEAP:
+	free(XML_VALUE(xn).xv_str);
+	break;
+    case XV_INTERN:
+	if (xml_intern_put(XML_VALUE(xn).xv_str) < 0)
+	    goto done;
+	break;
+    default:
+	break;
+    }
+    xn->x_vmode = XV_NONE;
+    memset(&XML_VALUE(xn), 0, sizeof(XML_VALUE(xn)));
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Set value of xml node, value is copied, internal function
+ * @see xml_value_set
+ */
+static int
+xml_value_set1(cxobj *xn,
+	       char  *val)
 {
     int    retval = -1;
     size_t sz;
+    char  *str;
+    char   inl[XML_VALUE_INLINE_LEN];
 
     if (!is_bodyattr(xn))
 	return 0;
@@ -653,16 +1336,85 @@ xml_value_set(cxobj *xn,
 	clicon_err(OE_XML, EINVAL, "value is NULL");
 	goto done;
     }
+    if (val == xml_value(xn)) /* Same value */
+	goto ok;
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(xn);
+#endif
+#ifdef XML_PATH_CACHE
+    xml_path_body_reset(xn);
+#endif
+    xml_cv_reset(xn->x_up);
     sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-	if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-	    clicon_err(OE_XML, errno, "cbuf_new");
+    if (sz <= XML_VALUE_INLINE_LEN){
+	memcpy(inl, val, sz); /* val may be part of old value */
+	if (xml_value_free(xn) < 0)
+	    goto done;
+	memcpy(XML_VALUE(xn).xv_inline, inl, sz);
+	xn->x_vmode = XV_INLINE;
+    }
+    else{
+	if ((str = malloc(xml_value_heapsz(sz))) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    goto done;
+	}
+	memcpy(str, val, sz);
+	if (xml_value_free(xn) < 0){
+	    free(str);
 	    goto done;
 	}
+	XML_VALUE(xn).xv_str = str;
+	xn->x_vmode = XV_HEAP;
     }
-    else
-	cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Set value of xml node, value is copied
+ * @param[in]  xn    xml node
+ * @param[in]  val   new value, null-terminated string, copied by function
+ * @retval     -1    on error with clicon-err set
+ * @retval     0     OK
+ */
+int
+xml_value_set(cxobj *xn,
+	      char  *val)
+{
+    int    retval = -1;
+    cxobj *xp;
+#ifdef XML_EXPLICIT_INDEX
+    cxobj *xi;
+    cxobj *xe;
+#endif
+
+    /* Order of leaf-list entry or of list entry (if key) may change */
+    if (xml_type(xn) == CX_BODY && (xp = xml_parent(xn)) != NULL){
+	xml_sorted_reset(xp);
+	if ((xp = xml_parent(xp)) != NULL)
+	    xml_sorted_reset(xp);
+    }
+#ifdef XML_EXPLICIT_INDEX
+    /* Value of a search index variable: move its list entry in the search index */
+    if (xml_type(xn) == CX_BODY &&
+	(xi = xml_parent(xn)) != NULL &&
+	xml_search_index_p(xi)){
+	xe = xml_parent(xi);
+	if (xml_search_child_rm(xe, xi) < 0)
+	    goto done;
+	if (xml_value_set1(xn, val) < 0)
+	    goto done;
+	if (xml_cv_set(xi, NULL) < 0) /* Cached value is obsolete */
+	    goto done;
+	if (xml_search_child_insert(xe, xi) < 0)
+	    goto done;
+	goto ok;
+    }
+#endif
+    if (xml_value_set1(xn, val) < 0)
+	goto done;
+ ok:
     retval = 0;
  done:
     return retval;
@@ -675,11 +1427,14 @@ xml_value_set(cxobj *xn,
  * @retval     new value
  */
 int
-xml_value_append(cxobj *xn, 
+xml_value_append(cxobj *xn,
 		 char  *val)
 {
     int    retval = -1;
+    char  *val0;
+    size_t len0;
     size_t sz;
+    char  *str;
 
     if (!is_bodyattr(xn))
 	return 0;
@@ -687,17 +1442,82 @@ xml_value_append(cxobj *xn,
 	clicon_err(OE_XML, EINVAL, "value is NULL");
 	goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-	if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-	    clicon_err(OE_XML, errno, "cbuf_new");
-	    goto done;
+    if ((val0 = xml_value(xn)) == NULL)
+	return xml_value_set(xn, val);
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(xn);
+#endif
+#ifdef XML_PATH_CACHE
+    xml_path_body_reset(xn);
+#endif
+    xml_cv_reset(xn->x_up);
+    len0 = strlen(val0);
+    sz = len0 + strlen(val) + 1;
+    switch (xn->x_vmode){
+    case XV_INLINE:
+	if (sz <= XML_VALUE_INLINE_LEN){
+	    strcpy(val0 + len0, val);
+	    goto ok;
 	}
+	break;
+    case XV_HEAP: /* Extend in place or reallocate */
+	if (sz > xml_value_heapsz(len0+1)){
+	    if ((str = realloc(val0, xml_value_heapsz(sz))) == NULL){
+		clicon_err(OE_XML, errno, "realloc");
+		goto done;
+	    }
+	    XML_VALUE(xn).xv_str = val0 = str;
+	}
+	strcpy(val0 + len0, val);
+	goto ok;
+	break;
+    default: /* Interned values are shared and cannot be modified */
+	break;
     }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-	clicon_err(OE_XML, errno, "cprintf");
+    if ((str = malloc(xml_value_heapsz(sz))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    memcpy(str, val0, len0);
+    strcpy(str + len0, val);
+    if (xml_value_free(xn) < 0){
+	free(str);
 	goto done;
     }
+    XML_VALUE(xn).xv_str = str;
+    xn->x_vmode = XV_HEAP;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Share value of xml node with other nodes having the same value
+ *
+ * The value is moved to a global intern table and shared with other nodes with the same
+ * interned value. Useful for values that are repeated in many nodes, such as enumeration
+ * and identityref leafs. Small values are stored inline and not interned.
+ * A later xml_value_set() or xml_value_append() makes a private copy.
+ * @param[in]  xn    xml body or attribute node
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @note The returned value of xml_value() of an interned node must not be modified
+ */
+int
+xml_value_intern(cxobj *xn)
+{
+    int   retval = -1;
+    char *str;
+
+    if (!is_bodyattr(xn) || xn->x_vmode != XV_HEAP)
+	goto ok;
+    if ((str = xml_intern_get(XML_VALUE(xn).xv_str)) == NULL)
+	goto done;
+    if (xml_value_free(xn) < 0)
+	goto done;
+    XML_VALUE(xn).xv_str = str;
+    xn->x_vmode = XV_INTERN;
+ ok:
     retval = 0;
  done:
     return retval;
@@ -745,7 +1565,7 @@ xml_child_nr(cxobj *xn)
     }
     if (!is_element(xn))
 	return 0;
-    return xn->x_childvec_len;
+    return xn->x_children.xv_len;
 }
 
 /*! Get number of children of EXCEPT specific type
@@ -809,8 +1629,8 @@ xml_child_i(cxobj *xn,
     }
     if (!is_element(xn))
 	return NULL;
-    if (i < xn->x_childvec_len)
-	return xn->x_childvec[i];
+    if (i < xn->x_children.xv_len)
+	return XML_CHILD(xn, i);
     return NULL;
 }
 
@@ -851,8 +1671,15 @@ xml_child_i_set(cxobj *xt,
 {
     if (!is_element(xt))
 	return NULL;
-    if (i < xt->x_childvec_len)
-	xt->x_childvec[i] = xc;
+    if (i < xt->x_children.xv_len)
+	XML_CHILD(xt, i) = xc;
+    xt->x_flags &= ~XML_FLAG_SORTED;
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(xt);
+#endif
+#ifdef XML_KEY_HASH
+    xml_key_hash_free(xt); /* Replaced child may be in hash */
+#endif
     return 0;
 }
 
@@ -926,21 +1753,113 @@ xml_child_each(cxobj           *xparent,
 	return NULL;
     if (!is_element(xparent))
 	return NULL;
-    for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_childvec_len; i++){
-	xn = xparent->x_childvec[i];
+    for (i=xprev?xprev->_x_vector_i+1:0; i<xparent->x_children.xv_len; i++){
+	xn = XML_CHILD(xparent, i);
 	if (xn == NULL)
 	    continue;
 	if (type != CX_ERROR && xml_type(xn) != type)
 	    continue;
 	break; /* this is next object after previous */
     }
-    if (i < xparent->x_childvec_len) /* found */
+    if (i < xparent->x_children.xv_len) /* found */
 	xn->_x_vector_i = i;
     else
 	xn = NULL;
     return xn;
 }
 
+/*! Initialize an external iterator over the children of an XML node
+ *
+ * As xml_child_each but the cursor is in the iterator instead of in the child nodes,
+ * which are not modified. Loops over the same parent may therefore be nested and a
+ * tree may be read by several threads at once.
+ * @param[out] it       Iterator
+ * @param[in]  xparent  XML parent node, or NULL
+ * @param[in]  type     Type of children, or CX_ERROR for all
+ * @retval     0        OK
+ * @code
+ *   clixon_xml_iter it;
+ *   cxobj          *x;
+ *
+ *   xml_child_iter_init(&it, xparent, CX_ELMNT);
+ *   while ((x = xml_child_iter_next(&it)) != NULL) {
+ *     ...
+ *   }
+ * @endcode
+ * @note Do not add or remove children of the parent while iterating
+ * @see xml_child_each
+ */
+int
+xml_child_iter_init(clixon_xml_iter *it,
+		    cxobj           *xparent,
+		    enum cxobj_type  type)
+{
+    it->xi_parent = (xparent && is_element(xparent)) ? xparent : NULL;
+    it->xi_i = 0;
+    it->xi_type = type;
+    return 0;
+}
+
+/*! Get next child of an external iterator
+ * @param[in,out] it    Iterator
+ * @retval        xn    Next child
+ * @retval        NULL  No more children
+ * @see xml_child_iter_init
+ */
+cxobj *
+xml_child_iter_next(clixon_xml_iter *it)
+{
+    cxobj *xp = it->xi_parent;
+    cxobj *xn;
+
+    if (xp == NULL)
+	return NULL;
+    while (it->xi_i < xp->x_children.xv_len){
+	xn = XML_CHILD(xp, it->xi_i);
+	it->xi_i++;
+	if (xn == NULL)
+	    continue;
+	if (it->xi_type != CX_ERROR && xn->x_type != it->xi_type)
+	    continue;
+	return xn;
+    }
+    return NULL;
+}
+
+
+/*! Insert child xc at position i under parent xp
+ * @param[in]  xp    xml parent node
+ * @param[in]  xc    xml child node
+ * @param[in]  i     Position, 0 <= i <= number of children
+ * @param[in]  start Initial length of vector if not allocated
+ */
+static int
+xml_child_insert_pos1(cxobj *xp,
+		      cxobj *xc,
+		      int    i,
+		      size_t start)
+{
+    if (clixon_xvec_grow(&xp->x_children, 1, start) < 0)
+	return -1;
+    xp->x_flags &= ~XML_FLAG_SORTED; /* Unless inserted in sorted position, see xml_insert */
+    if (clixon_xvec_insert_pos(&xp->x_children, xc, i) < 0)
+	return -1;
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(xp);
+#endif
+    if (xml_type(xc) == CX_BODY)
+	xml_cv_reset(xp);
+#ifdef XML_KEY_HASH
+    if (xp->x_key_hash && xml_key_hash_insert(xp, xc) < 0)
+	return -1;
+#endif
+#ifdef XML_EXPLICIT_INDEX
+    if (XML_COLD(xp, xc_search_index) && xml_type(xc) == CX_ELMNT &&
+	xml_search_index_entry(xp, xc, 1) < 0)
+	return -1;
+#endif
+    return 0;
+}
 
 /*! Extend child vector with one and insert xml node there
  * @note does not do anything with child, you may need to set its parent, etc
@@ -961,20 +1880,7 @@ xml_child_append(cxobj *xp,
      */
     if (xml_type(xc) == CX_ELMNT)
 	start = XML_CHILDVEC_SIZE_START_ELMNT;
-    xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-	if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-	    xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:start;
-	else
-	    xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-	xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-	if (xp->x_childvec == NULL){
-	    clicon_err(OE_XML, errno, "realloc");
-	    return -1;
-	}
-    }
-    xp->x_childvec[xp->x_childvec_len-1] = xc;
-    return 0;
+    return xml_child_insert_pos1(xp, xc, xp->x_children.xv_len, start);
 }
 
 /*! Insert child xc at position i under parent xp
@@ -985,28 +1891,11 @@ xml_child_append(cxobj *xp,
 int
 xml_child_insert_pos(cxobj *xp,
 		     cxobj *xc,
-		     int    i)
-{
-    size_t size;
-   
-    if (!is_element(xp))
-	return 0;
-    xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-	if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-	    xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:XML_CHILDVEC_SIZE_START;
-	else
-	    xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-	xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-	if (xp->x_childvec == NULL){
-	    clicon_err(OE_XML, errno, "realloc");
-	    return -1;
-	}
-    }
-    size = (xml_child_nr(xp) - i - 1)*sizeof(cxobj *);
-    memmove(&xp->x_childvec[i+1], &xp->x_childvec[i], size);
-    xp->x_childvec[i] = xc;
-    return 0;
+		     int    i)
+{
+    if (!is_element(xp))
+	return 0;
+    return xml_child_insert_pos1(xp, xc, i, XML_CHILDVEC_SIZE_START);
 }
 
 /*! Set a childvec to a specific size, fill with children after
@@ -1022,25 +1911,77 @@ xml_childvec_set(cxobj *x,
 {
     if (!is_element(x))
 	return 0;
-    x->x_childvec_len = len;
-    x->x_childvec_max = len;
-    if (x->x_childvec)
-	free(x->x_childvec);
-    if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
-	clicon_err(OE_XML, errno, "calloc");
-	return -1;
-    }
-    return 0;
+    x->x_flags &= ~XML_FLAG_SORTED;
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(x);
+#endif
+#ifdef XML_KEY_HASH
+    xml_key_hash_free(x);
+#endif
+    clixon_xvec_reset(&x->x_children);
+    return clixon_xvec_insert_vec(&x->x_children, 0, NULL, len);
 }
 
 /*! Get the children of an XML node as an XML vector
+ * @note The vector is only valid until next insert or remove of a child
+ * @note The vector may be reordered by the caller, eg by xml_sort
  */
 cxobj **
 xml_childvec_get(cxobj *x)
 {
     if (!is_element(x))
 	return NULL;
-    return x->x_childvec;
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(x);
+#endif
+    clixon_xvec_gap_move(&x->x_children, x->x_children.xv_len);
+    return x->x_children.xv_vec;
+}
+
+/*! Allocate an empty xml node of a type, from an arena block if enabled
+ * @param[in]  type      XML type
+ * @retval     xml       Created xml object without name and parent
+ * @retval     NULL      Error and clicon_err() called
+ * @see xml_new
+ */
+static cxobj *
+xml_node_new(enum cxobj_type type)
+{
+    struct xml *x = NULL;
+    size_t      sz;
+    
+    switch (type){
+    case CX_ELMNT:
+	sz = sizeof(struct xml);
+	break;
+    case CX_ATTR:
+    case CX_BODY:
+	sz = sizeof(struct xmlbody);
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Invalid type: %d", type);
+	return NULL;
+	break;
+    }
+#ifdef XML_ARENA
+    if (_xml_arena_level > 0){
+	if ((x = xml_arena_alloc(sz)) == NULL)
+	    return NULL;
+	memset(x, 0, sz);
+	x->x_arena = 1;
+    }
+    else
+#endif
+    {
+	if ((x = malloc(sz)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    return NULL;
+	}
+	memset(x, 0, sz);
+    }
+    xml_type_set(x, type);
+    _stats_nr++;
+    return x;
 }
 
 /*! Create new xml node given a name and parent. Free with xml_free().
@@ -1066,27 +2007,9 @@ xml_new(char           *name,
 	enum cxobj_type type)
 {
     struct xml *x = NULL;
-    size_t      sz;
     
-    switch (type){
-    case CX_ELMNT:
-	sz = sizeof(struct xml);
-	break;
-    case CX_ATTR:
-    case CX_BODY:
-	sz = sizeof(struct xmlbody);
-	break;
-    default:
-	clicon_err(OE_XML, EINVAL, "Invalid type: %d", type);
-	return NULL;
-	break;
-    }
-    if ((x = malloc(sz)) == NULL){
-	clicon_err(OE_XML, errno, "malloc");
+    if ((x = xml_node_new(type)) == NULL)
 	return NULL;
-    }
-    memset(x, 0, sz);
-    xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
 	return NULL;
     if (xp){
@@ -1095,7 +2018,6 @@ xml_new(char           *name,
 	    return NULL;
 	x->_x_i = xml_child_nr(xp)-1;
     }
-    _stats_nr++;
     return x;
 }
 
@@ -1136,14 +2058,50 @@ xml_new_body(char  *name,
 }
 
 
+/*! Enable yang binding on access of trees bound with xml_bind_yang_lazy
+ * Until enabled, xml_spec of an unbound node does not look at its ancestors
+ * @retval     0     OK
+ * @see xml_bind_yang_lazy
+ */
+int
+xml_spec_lazy_enable(void)
+{
+    _xml_lazy = 1;
+    return 0;
+}
+
+/*! Bind yang to unbound node x if an ancestor has children that are not bound yet
+ * @param[in]  x     XML element without yang spec
+ * @retval     y     Yang spec of x, bound on this access
+ * @retval     NULL  Not bound
+ * @see XML_FLAG_LAZY
+ */
+static yang_stmt *
+xml_spec_lazy(cxobj *x)
+{
+    cxobj *xp;
+
+    if ((xp = x->x_up) == NULL)
+	return NULL;
+    if (xp->x_spec == NULL && xml_spec_lazy(xp) == NULL)
+	return NULL;
+    if ((xp->x_flags & XML_FLAG_LAZY) &&
+	xml_bind_yang_lazy_children(xp) < 0)
+	return NULL;
+    return x->x_spec;
+}
+
 /*! Return yang spec of node. 
  * Not necessarily set. Either has not been set yet (by xml_spec_set( or anyxml.
+ * If the node is in a tree bound with xml_bind_yang_lazy, it is bound on first access
  */
 yang_stmt *
 xml_spec(cxobj *x)
 {
     if (!is_element(x))
 	return NULL;
+    if (x->x_spec == NULL && _xml_lazy)
+	return xml_spec_lazy(x);
     return x->x_spec;
 }
 
@@ -1153,6 +2111,13 @@ xml_spec_set(cxobj     *x,
 {
     if (!is_element(x))
 	return 0;
+    if (x->x_spec != spec){ /* Sort order and typed value depend on yang */
+	xml_sorted_reset(x);
+	xml_cv_reset(x);
+#ifdef XML_PATH_CACHE
+	_xml_path_gen++;          /* So do keys and prefixes of paths */
+#endif
+    }
     x->x_spec = spec;
     return 0;
 }
@@ -1170,7 +2135,7 @@ xml_cv(cxobj *x)
 {
     if (!is_element(x))
 	return NULL;
-    return x->x_cv;
+    return XML_COLD(x, xc_cv);
 }
 
 /*! Set (cached) cligen variable value of xml node
@@ -1185,14 +2150,100 @@ int
 xml_cv_set(cxobj  *x, 
 	   cg_var *cv)
 {
+    struct xml_cold *xc;
+
     if (!is_element(x))
 	return 0;
-    if (x->x_cv)
-	cv_free(x->x_cv);
-    x->x_cv = cv;
+    if (cv == NULL && x->x_cold == NULL)
+	return 0;
+    if ((xc = xml_cold(x)) == NULL)
+	return -1;
+    if (xc->xc_cv)
+	cv_free(xc->xc_cv);
+    xc->xc_cv = cv;
     return 0;
 }
 
+/*! Find first child with prefix and name of a sorted yang bound XML node
+ *
+ * Children of a sorted node are ordered with attributes and children without yang first,
+ * then by the yang order of their data nodes, see xml_cmp.
+ * The first children are searched linearly, then the children of the yang data node
+ * with the name are found by binary search.
+ * @param[in]  xp      XML parent node
+ * @param[in]  prefix  Prefix or NULL (any prefix)
+ * @param[in]  name    Child name
+ * @param[in]  type    CX_ELMNT or -1 for any
+ * @param[out] xcp     First matching child, or NULL if none
+ * @retval     1       Searched, xcp is set
+ * @retval     0       Not searched, search linearly
+ * @note Of data nodes of different namespaces with the same name, only children of the
+ *       first data node is found
+ */
+static int
+xml_find_sorted(cxobj      *xp,
+		const char *prefix,
+		const char *name,
+		int         type,
+		cxobj     **xcp)
+{
+    yang_stmt *yc;
+    cxobj     *xc;
+    char      *xprefix;
+    int        yi;
+    int        low;
+    int        mid;
+    int        upper;
+
+    if (xp->x_children.xv_len < XML_FIND_SORTED_MIN ||
+	(xp->x_flags & (XML_FLAG_SORTED|XML_FLAG_LAZY)) != XML_FLAG_SORTED ||
+	xp->x_spec == NULL ||
+	(type != -1 && type != CX_ELMNT))
+	return 0;
+    if ((yc = yang_find_datanode(xp->x_spec, (char*)name)) == NULL ||
+	(yi = yang_order(yc)) < 0)
+	return 0;
+    *xcp = NULL;
+    upper = xp->x_children.xv_len;
+    /* Attributes and children without yang */
+    for (low=0; low<upper; low++){
+	xc = XML_CHILD(xp, low);
+	if (xc->x_type == CX_ELMNT && xc->x_spec != NULL)
+	    break;
+	if ((type == -1 || xc->x_type == type) &&
+	    xml_name_eq(name, xc->x_name) &&
+	    (prefix == NULL || (xc->x_prefix && xml_name_eq(prefix, xc->x_prefix)))){
+	    *xcp = xc;
+	    return 1;
+	}
+    }
+    /* First child with yang order not less than yi */
+    while (low < upper){
+	mid = (low + upper) / 2;
+	xc = XML_CHILD(xp, mid);
+	if (yang_order(xc->x_spec) < yi)
+	    low = mid + 1;
+	else
+	    upper = mid;
+    }
+    /* Several data nodes may have the same order, eg in different cases */
+    for (; low<xp->x_children.xv_len; low++){
+	xc = XML_CHILD(xp, low);
+	if (yang_order(xc->x_spec) != yi)
+	    break;
+	if (!xml_name_eq(name, xc->x_name))
+	    continue;
+	if (prefix){
+	    xprefix = xc->x_prefix;
+	    if (xprefix == NULL || !xml_name_eq(prefix, xprefix))
+		continue;
+	}
+	*xcp = xc;
+	break;
+    }
+    return 1;
+}
+
 /*! Find an XML node matching name among a parent's children.
  *
  * Get first XML node directly under x_up in the xml hierarchy with
@@ -1206,7 +2257,8 @@ xml_cv_set(cxobj  *x,
  * There are several issues with this function:
  * @note (1) Ignores prefix which means namespaces are ignored
  * @note (2) Does not differentiate between element,attributes and body. You usually want elements.
- * @note (3) Linear scalability and relies on strcmp, does not use search/key indexes
+ * @note (3) Linear scalability and relies on strcmp unless xp is sorted and bound to yang,
+ *           then binary search on yang order, see xml_find_sorted
  * @note (4) Only returns first match, eg a list/leaf-list may have several children with same name
  * @see xml_find_type  A more generic function fixes (1) and (2) above
  */
@@ -1221,8 +2273,10 @@ xml_find(cxobj *xp,
     }
     if (!is_element(xp))
 	return NULL;
+    if (xml_find_sorted(xp, NULL, name, -1, &x) == 1)
+	return x;
     while ((x = xml_child_each(xp, x, -1)) != NULL) 
-	if (strcmp(name, xml_name(x)) == 0)
+	if (xml_name_eq(name, xml_name(x)))
 	    break; /* x is set */
     return x;
 }
@@ -1308,7 +2362,7 @@ xml_wrap_all(cxobj *xp,
 	return NULL;
     if ((xw = xml_new(tag, NULL, CX_ELMNT)) == NULL)
 	goto done;
-    while (xp->x_childvec_len)
+    while (xp->x_children.xv_len)
 	if (xml_addsub(xw, xml_child_i(xp, 0)) < 0)
 	    goto done;
     if (xml_addsub(xp, xw) < 0)
@@ -1343,12 +2397,40 @@ xml_wrap(cxobj *xc,
     return xw;
 }
 
+/*! Get position of a child in its parent
+ *
+ * Search outwards from the gap of the child vector, which is at the last inserted or
+ * removed child. Removing many children in order, eg list entries, then finds each child
+ * in a few steps
+ * @param[in]  xp   XML parent node
+ * @param[in]  xc   XML child node
+ * @retval     i    Position of xc in xp
+ * @retval    -1    Not found
+ */
+static int
+xml_child_pos(cxobj *xp,
+	      cxobj *xc)
+{
+    int len = xp->x_children.xv_len;
+    int gap = xp->x_children.xv_gap;
+    int d;
+
+    for (d=0; gap+d < len || gap-d > 0; d++){
+	if (gap+d < len && XML_CHILD(xp, gap+d) == xc)
+	    return gap+d;
+	if (gap-d > 0 && XML_CHILD(xp, gap-d-1) == xc)
+	    return gap-d-1;
+    }
+    return -1;
+}
+
 /*! Remove and free an xml node child from xml parent
  * @param[in]   xc          xml child node (to be removed and freed)
  * @retval      0           OK
  * @retval      -1
  * @note you cannot remove xchild in the loop (unless yoy keep track of xprev)
- * @note Linear complexity - use xml_child_rm if possible
+ * @note Linear complexity, except for children close to the last removed - use
+ *       xml_child_rm if possible, or xml_purge_children to remove many
  * @see xml_free      Free, dont remove from parent
  * @see xml_child_rm  Remove if child order is known (does not free)
  * Differs from xml_free it is removed from parent.
@@ -1360,13 +2442,9 @@ xml_purge(cxobj *xc)
     int       i;
     cxobj    *xp;
 
-    if ((xp = xml_parent(xc)) != NULL){
-	/* Find child order i in parent*/
-	for (i=0; i<xml_child_nr(xp); i++)
-	    if (xml_child_i(xp, i) == xc)
-		break;
+    if ((xp = xml_parent(xc)) != NULL && is_element(xp)){
 	/* Remove xc from parent */
-	if (i < xml_child_nr(xp))
+	if ((i = xml_child_pos(xp, xc)) >= 0)
 	    if (xml_child_rm(xp, i) < 0)
 		goto done;
     }
@@ -1399,17 +2477,27 @@ xml_child_rm(cxobj *xp,
 	clicon_err(OE_XML, 0, "Child not found");
 	goto done;
     }
-    xml_parent_set(xc, NULL);
-    xp->x_childvec[i] = NULL;
-    xp->x_childvec_len--;
-    if (i<xp->x_childvec_len)
-	memmove(&xp->x_childvec[i], &xp->x_childvec[i+1], (xp->x_childvec_len-i)*sizeof(cxobj*));
 #ifdef XML_EXPLICIT_INDEX
     if (xml_type(xc) == CX_ELMNT){
-	if (xml_search_index_p(xc))
-	    xml_search_child_rm(xp, xc);
-
+	if (xml_search_index_p(xc) &&
+	    xml_search_child_rm(xp, xc) < 0)
+	    goto done;
+	if (XML_COLD(xp, xc_search_index) &&
+	    xml_search_index_entry(xp, xc, 0) < 0)
+	    goto done;
     }
+#endif
+    xml_parent_set(xc, NULL);
+    if (clixon_xvec_rm_pos(&xp->x_children, i) < 0)
+	goto done;
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(xp);
+#endif
+    if (xml_type(xc) == CX_BODY)
+	xml_cv_reset(xp);
+#ifdef XML_KEY_HASH
+    if (xp->x_key_hash && xml_key_hash_rm(xp, xc) < 0)
+	goto done;
 #endif
     retval = 0;
  done:
@@ -1429,19 +2517,11 @@ xml_rm(cxobj *xc)
 {
     int    retval = -1;
     cxobj *xp;
-    cxobj *x;
     int    i;
 
-    if ((xp = xml_parent(xc)) == NULL)
+    if ((xp = xml_parent(xc)) == NULL || !is_element(xp))
 	goto ok;
-    /* Find child in parent XXX: search? */
-    x = NULL; i = 0;
-    while ((x = xml_child_each(xp, x, -1)) != NULL) {
-	if (x == xc)
-	    break;
-	i++;
-    }
-    if (x != NULL)
+    if ((i = xml_child_pos(xp, xc)) >= 0)
 	if (xml_child_rm(xp, i) < 0)
 	    goto done;
  ok:
@@ -1450,6 +2530,14 @@ xml_rm(cxobj *xc)
     return retval;
 }
 
+/*! Test function of xml_rm_children: child is of type */
+static int
+xml_rm_children_fn(cxobj *x,
+		   void  *arg)
+{
+    return xml_type(x) == *(enum cxobj_type*)arg;
+}
+
 /*! Remove all children of specific type
  * @param[in] x    XML node
  * @param[in] type Remove all children of xn of this type
@@ -1460,24 +2548,103 @@ int
 xml_rm_children(cxobj          *xp,
 		enum cxobj_type type)
 {
-    int    retval = -1;
-    cxobj *xc;
-    int    i;
+    return xml_purge_children(xp, xml_rm_children_fn, &type);
+}
 
-    if (!is_element(xp))
+/*! Remove and free many children of an XML node in one pass
+ *
+ * First all children are tested in order, then the children to be removed are freed and
+ * the remaining children are compacted in a single pass of the child vector, instead of
+ * moving the children after each removed child, as when calling xml_purge on each.
+ * Key hash and search indexes of the node are updated once, not per removed child.
+ * The test function may modify the tested child and its descendants, but not add or
+ * remove other children of xp.
+ * @param[in]  xp   XML parent node
+ * @param[in]  fn   Test function: 1: remove and free child, 0: keep, -1: error
+ *                  If NULL, remove all children
+ * @param[in]  arg  Argument to fn
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @code
+ *   static int rm_fn(cxobj *x, void *arg) { return xml_flag(x, XML_FLAG_MARK) != 0; }
+ *   if (xml_purge_children(xt, rm_fn, NULL) < 0)
+ *      err;
+ * @endcode
+ * @see xml_purge  Remove and free a single child
+ */
+int
+xml_purge_children(cxobj         *xp,
+		   xml_applyfn_t *fn,
+		   void          *arg)
+{
+    int      retval = -1;
+    cxobj   *xc;
+    uint8_t *rm = NULL;
+    int      len;
+    int      i;
+    int      j = 0;
+    int      ret;
+    int      body = 0;
+    int      err = 0;
+
+    if (!is_element(xp) || (len = xp->x_children.xv_len) == 0)
 	return 0;
-    for (i=0; i<xml_child_nr(xp);){
-	xc = xml_child_i(xp, i);
-	if (xml_type(xc) != type){
-	    i++;
-	    continue;
-	}
-	if (xml_child_rm(xp, i) < 0)
+    if (fn != NULL){
+	if ((rm = calloc(len, sizeof(uint8_t))) == NULL){
+	    clicon_err(OE_XML, errno, "calloc");
 	    goto done;
+	}
+	for (i=0; i<len; i++){
+	    if ((ret = fn(xml_child_i(xp, i), arg)) < 0)
+		goto done;
+	    if (ret == 1)
+		j++;
+	    rm[i] = (ret == 1);
+	}
+	if (j == 0)
+	    goto ok;
+    }
+    for (i=0; i<len; i++){
+	if (rm && rm[i] == 0)
+	    continue;
+	xc = XML_CHILD(xp, i);
+#ifdef XML_EXPLICIT_INDEX
+	if (xml_type(xc) == CX_ELMNT &&
+	    xml_search_index_p(xc) &&
+	    xml_search_child_rm(xp, xc) < 0)
+	    err++; /* Complete removal before error */
+#endif
+	if (xml_type(xc) == CX_BODY)
+	    body++;
+	xml_parent_set(xc, NULL);
 	xml_free(xc);
+	XML_CHILD(xp, i) = NULL;
     }
+    /* Compact remaining children in one pass */
+    if (clixon_xvec_rm_marked(&xp->x_children, rm) < 0)
+	goto done;
+#ifdef XML_SUBTREE_HASH
+    xml_hash_reset(xp);
+#endif
+    if (body)
+	xml_cv_reset(xp);
+#ifdef XML_KEY_HASH
+    /* Rebuilt on next lookup */
+    xml_key_hash_free(xp);
+#endif
+#ifdef XML_EXPLICIT_INDEX
+    /* Rebuilt on next search, see xml_search_index_build */
+    if (XML_COLD(xp, xc_search_index) &&
+	xml_search_index_free(xp) < 0)
+	goto done;
+#endif
+    if (err)
+	goto done;
+ ok:
     retval = 0;
  done:
+    if (rm)
+	free(rm);
     return retval;
 }
 
@@ -1720,14 +2887,16 @@ xml_find_type(cxobj           *xt,
     
     if (!is_element(xt))
 	return NULL;
+    if (xml_find_sorted(xt, prefix, name, type, &x) == 1)
+	return x;
     while ((x = xml_child_each(xt, x, type)) != NULL) {
 	if (prefix){
 	    xprefix = xml_prefix(x);
-	    pmatch = xprefix ? strcmp(prefix,xprefix)==0 : 0;
+	    pmatch = xprefix ? xml_name_eq(prefix, xprefix) : 0;
 	}
 	else
 	    pmatch = 1;
-	if (pmatch && strcmp(name, xml_name(x)) == 0)
+	if (pmatch && xml_name_eq(name, xml_name(x)))
 	    return x;
     }
     return NULL;
@@ -1756,6 +2925,8 @@ xml_find_value(cxobj      *xt,
     
     if (!is_element(xt))
 	return NULL;
+    if (xml_find_sorted(xt, NULL, name, -1, &x) == 1)
+	return x ? xml_value(x) : NULL;
     while ((x = xml_child_each(xt, x, -1)) != NULL) 
 	if (strcmp(name, xml_name(x)) == 0)
 	    return xml_value(x);
@@ -1781,6 +2952,8 @@ xml_find_body(cxobj      *xt,
 
     if (!is_element(xt))
 	return NULL;
+    if (xml_find_sorted(xt, NULL, name, -1, &x) == 1)
+	return x ? xml_body(x) : NULL;
     while ((x = xml_child_each(xt, x, -1)) != NULL) 
 	if (strcmp(name, xml_name(x)) == 0)
 	    return xml_body(x);
@@ -1835,37 +3008,56 @@ xml_free(cxobj *x)
     if (x == NULL){
 	return 0;
     }
+#ifdef XML_INTERN_NAMES
+    if (x->x_name)
+	xml_intern_put(x->x_name);
+    if (x->x_prefix)
+	xml_intern_put(x->x_prefix);
+#else
     if (x->x_name)
 	free(x->x_name);
     if (x->x_prefix)
 	free(x->x_prefix);
+#endif
     switch (xml_type(x)){
     case CX_ELMNT:
-	for (i=0; i<x->x_childvec_len; i++){
-	    if ((xc = x->x_childvec[i]) != NULL){
+	for (i=0; i<x->x_children.xv_len; i++){
+	    if ((xc = XML_CHILD(x, i)) != NULL){
 		xml_free(xc);
-		x->x_childvec[i] = NULL;
+		XML_CHILD(x, i) = NULL;
 	    }
 	}
-	if (x->x_childvec)
-	    free(x->x_childvec);
-	if (x->x_cv)
-	    cv_free(x->x_cv);
-	if (x->x_ns_cache)
-	    xml_nsctx_free(x->x_ns_cache);
+	clixon_xvec_reset(&x->x_children);
 #ifdef XML_EXPLICIT_INDEX
 	xml_search_index_free(x);
+#endif
+	if (x->x_cold){
+	    if (x->x_cold->xc_cv)
+		cv_free(x->x_cold->xc_cv);
+	    if (x->x_cold->xc_ns_cache)
+		xml_nsctx_free(x->x_cold->xc_ns_cache);
+#ifdef XML_PATH_CACHE
+	    for (i=0; i<XML_PATH_NR; i++)
+		if (x->x_cold->xc_path[i])
+		    free(x->x_cold->xc_path[i]);
+#endif
+	    free(x->x_cold);
+	}
+#ifdef XML_KEY_HASH
+	xml_key_hash_free(x);
 #endif
 	break;
     case CX_BODY:
     case CX_ATTR:
-	if (x->x_value_cb)
-	    cbuf_free(x->x_value_cb);  
+	xml_value_free(x);
 	break;
     default:
 	break;
     }
-    free(x);
+    if (x->x_arena)
+	xml_arena_free(x);
+    else
+	free(x);
     _stats_nr--;
     return 0;
 }
@@ -1899,7 +3091,9 @@ xml_copy_one(cxobj *x0,
 	if ((s = xml_value(x0))){ /* malloced string */
 	    if (xml_value_set(x1, s) < 0)
 		goto done;
-
+	    if (x0->x_vmode == XV_INTERN && /* Keep sharing */
+		xml_value_intern(x1) < 0)
+		goto done;
 	}
 	break;
     default:
@@ -1911,6 +3105,142 @@ xml_copy_one(cxobj *x0,
     return retval;
 }
 
+#ifdef XML_EXPLICIT_INDEX
+/*! Clone the search indexes of x0 to x1 whose children are copies of the children of x0
+ *
+ * The children of x1 must be in the same order as the children of x0, the entries of each
+ * search index vector of x1 are then the copies of the entries of x0, and need not be sorted.
+ * @param[in]  x0  Source XML node
+ * @param[in]  x1  Destination XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+xml_search_index_copy(cxobj *x0,
+		      cxobj *x1)
+{
+    int                  retval = -1;
+    struct search_index *si0;
+    struct search_index *si1;
+    int                  i;
+
+    if ((si0 = XML_COLD(x0, xc_search_index)) == NULL)
+	goto ok;
+    xml_enumerate_children(x0);
+    do {
+	if ((si1 = xml_search_index_add(x1, si0->si_name)) == NULL)
+	    goto done;
+	for (i=0; i<clixon_xvec_len(si0->si_xvec); i++)
+	    if (clixon_xvec_append(si1->si_xvec,
+				   xml_child_i(x1, clixon_xvec_i(si0->si_xvec, i)->_x_i)) < 0)
+		goto done;
+	si0 = NEXTQ(struct search_index *, si0);
+    } while (si0 && si0 != XML_COLD(x0, xc_search_index));
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+#endif
+
+/*! Copy xml tree x0 to a new node x1 without name and children, see xml_node_new
+ *
+ * Unlike xml_new and xml_copy_one, the child vector of each node is allocated once with the
+ * exact number of children, interned names, prefixes and values are shared instead of copied,
+ * and the sort order, hash and search indexes of x0 are kept instead of being recomputed.
+ * @param[in]  x0  Source XML tree
+ * @param[in]  x1  Destination XML node
+ * @retval     0   OK
+ * @retval    -1   Error, x1 may be partially copied and should be freed
+ * @see xml_copy
+ */
+static int
+xml_copy_bulk(cxobj *x0,
+	      cxobj *x1)
+{
+    int    retval = -1;
+    cxobj *xc0;
+    cxobj *xc1;
+    int    n;
+    int    i;
+    size_t sz;
+
+#ifdef XML_INTERN_NAMES
+    if (x0->x_name && (x1->x_name = xml_intern_get(x0->x_name)) == NULL)
+	goto done;
+    if (x0->x_prefix && (x1->x_prefix = xml_intern_get(x0->x_prefix)) == NULL)
+	goto done;
+#else
+    if (x0->x_name && xml_name_set(x1, x0->x_name) < 0)
+	goto done;
+    if (x0->x_prefix && xml_prefix_set(x1, x0->x_prefix) < 0)
+	goto done;
+#endif
+    x1->x_flags = x0->x_flags & (XML_FLAG_DEFAULT | XML_FLAG_TOP);
+    switch (xml_type(x0)){
+    case CX_ELMNT:
+	x1->x_spec = x0->x_spec;
+	if ((n = x0->x_children.xv_len) == 0)
+	    break;
+	if (clixon_xvec_grow(&x1->x_children, n, n) < 0)
+	    goto done;
+	for (i=0; i<n; i++){
+	    xc0 = XML_CHILD(x0, i);
+	    if ((xc1 = xml_node_new(xml_type(xc0))) == NULL)
+		goto done;
+	    /* Attach before recursion so that x1 owns xc1 on error */
+	    xc1->x_up = x1;
+	    xc1->_x_i = i;
+	    if (clixon_xvec_append(&x1->x_children, xc1) < 0){
+		xml_free(xc1);
+		goto done;
+	    }
+	    if (xml_copy_bulk(xc0, xc1) < 0) /* recursion */
+		goto done;
+	}
+	/* Children are copied in the same order */
+	x1->x_flags |= x0->x_flags & XML_FLAG_SORTED;
+#ifdef XML_SUBTREE_HASH
+	x1->x_hash = x0->x_hash;
+#endif
+#ifdef XML_EXPLICIT_INDEX
+	if (xml_search_index_copy(x0, x1) < 0)
+	    goto done;
+#endif
+	break;
+    case CX_BODY:
+    case CX_ATTR:
+	switch (x0->x_vmode){
+	case XV_INLINE:
+	    XML_VALUE(x1) = XML_VALUE(x0);
+	    x1->x_vmode = XV_INLINE;
+	    break;
+	case XV_INTERN: /* Keep sharing */
+	    if ((XML_VALUE(x1).xv_str = xml_intern_get(XML_VALUE(x0).xv_str)) == NULL)
+		goto done;
+	    x1->x_vmode = XV_INTERN;
+	    break;
+	case XV_HEAP:
+	    sz = strlen(XML_VALUE(x0).xv_str)+1;
+	    if ((XML_VALUE(x1).xv_str = malloc(xml_value_heapsz(sz))) == NULL){
+		clicon_err(OE_XML, errno, "malloc");
+		goto done;
+	    }
+	    memcpy(XML_VALUE(x1).xv_str, XML_VALUE(x0).xv_str, sz);
+	    x1->x_vmode = XV_HEAP;
+	    break;
+	default:
+	    break;
+	}
+	break;
+    default:
+	break;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Copy xml tree x0 to other existing tree x1
  *
  * x1 should be a created placeholder. If x1 is non-empty,
@@ -1933,25 +3263,53 @@ xml_copy(cxobj *x0,
     int    retval = -1;
     cxobj *x;
     cxobj *xcopy;
+    int    empty = xml_child_nr(x1) == 0;
 
     if (xml_copy_one(x0, x1) <0)
 	goto done;
     x = NULL;
     while ((x = xml_child_each(x0, x, -1)) != NULL) {
+	if (empty){ /* Copy subtree in bulk, see xml_copy_bulk */
+	    if ((xcopy = xml_node_new(xml_type(x))) == NULL)
+		goto done;
+	    xml_parent_set(xcopy, x1);
+	    if (xml_child_append(x1, xcopy) < 0){
+		xml_free(xcopy);
+		goto done;
+	    }
+	    xcopy->_x_i = xml_child_nr(x1)-1;
+	    if (xml_copy_bulk(x, xcopy) < 0)
+		goto done;
+	    continue;
+	}
 	if ((xcopy = xml_new(xml_name(x), x1, xml_type(x))) == NULL)
 	    goto done;
 	if (xml_copy(x, xcopy) < 0) /* recursion */
 	    goto done;
     }
+    /* Children are copied in the same order */
+    if (empty && xml_flag(x0, XML_FLAG_SORTED))
+	xml_flag_set(x1, XML_FLAG_SORTED);
+#ifdef XML_EXPLICIT_INDEX
+    if (empty && is_element(x0) && is_element(x1) &&
+	XML_COLD(x1, xc_search_index) == NULL &&
+	xml_search_index_copy(x0, x1) < 0)
+	goto done;
+#endif
+#ifdef XML_SUBTREE_HASH
+    /* Exact copy has same hash, and so have all copied descendants */
+    if (empty && is_element(x0) && is_element(x1))
+	x1->x_hash = x0->x_hash;
+#endif
     retval = 0;
   done:
     return retval;
-}
-
-
+}
 
 /*! Create and return a copy of xml tree.
  *
+ * The copy is made in bulk, see xml_copy_bulk, and its nodes are allocated from arena blocks
+ * if XML_ARENA is enabled.
  * @code
  *   cxobj *x1;
  *   x1 = xml_dup(x0);
@@ -1964,10 +3322,17 @@ xml_dup(cxobj *x0)
 {
     cxobj *x1;
 
-    if ((x1 = xml_new("new", NULL, xml_type(x0))) == NULL)
-	return NULL;
-    if (xml_copy(x0, x1) < 0)
-	return NULL;
+#ifdef XML_ARENA
+    xml_arena_begin();
+#endif
+    if ((x1 = xml_node_new(xml_type(x0))) != NULL &&
+	xml_copy_bulk(x0, x1) < 0){
+	xml_free(x1);
+	x1 = NULL;
+    }
+#ifdef XML_ARENA
+    xml_arena_end();
+#endif
     return x1;
 }
 
@@ -2436,8 +3801,8 @@ xml_search_index_free(cxobj *x)
 {
     struct search_index *si;
 
-    while ((si = x->x_search_index) != NULL) {
-	DELQ(si, x->x_search_index, struct search_index *);
+    while ((si = XML_COLD(x, xc_search_index)) != NULL) {
+	DELQ(si, x->x_cold->xc_search_index, struct search_index *);
 	if (si->si_name)
 	    free(si->si_name);
 	if (si->si_xvec)
@@ -2459,6 +3824,8 @@ xml_search_index_add(cxobj *x,
 {
     struct search_index *si = NULL;
 
+    if (xml_cold(x) == NULL)
+	goto done;
     if ((si = malloc(sizeof(struct search_index))) == NULL){
 	clicon_err(OE_XML, errno, "malloc");
 	goto done;
@@ -2476,7 +3843,7 @@ xml_search_index_add(cxobj *x,
 	si = NULL;
 	goto done;
     }
-    ADDQ(si, x->x_search_index);
+    ADDQ(si, x->x_cold->xc_search_index);
  done:
     return si;
 }
@@ -2493,14 +3860,14 @@ xml_search_index_get(cxobj *x,
 {
     struct search_index *si = NULL;
 
-    if ((si = x->x_search_index) != NULL) {
+    if ((si = XML_COLD(x, xc_search_index)) != NULL) {
 	do {
 	    if (strcmp(si->si_name, name) == 0){
 		goto done;
 		break;
 	    }
 	    si = NEXTQ(struct search_index *, si);
-	} while (si && si != x->x_search_index);
+	} while (si && si != XML_COLD(x, xc_search_index));
     }
  done:
     return si;
@@ -2522,92 +3889,289 @@ xml_search_vector_get(cxobj        *xp,
     struct search_index *si;
 
     *xvec = NULL;
-    if ((si = xp->x_search_index) != NULL) {
+    if ((si = XML_COLD(xp, xc_search_index)) != NULL) {
 	do {
 	    if (strcmp(si->si_name, name) == 0){
 		*xvec = si->si_xvec;
 		break;
 	    }
 	    si = NEXTQ(struct search_index *, si);
-	} while (si && si != xp->x_search_index);
+	} while (si && si != XML_COLD(xp, xc_search_index));
+    }
+    return 0;
+}
+
+/*! Find position of a list entry in a search index vector
+ * @param[in]  si    Search index
+ * @param[in]  xe    XML list entry
+ * @param[out] pos   Position of xe if found, otherwise where it should be inserted
+ * @retval     1     Found, xe is in vector at pos
+ * @retval     0     Not found
+ * @retval    -1     Error
+ * @note there may be several entries with equal index variables, the one that is xe is found
+ */
+static int
+xml_search_index_pos(struct search_index *si,
+		     cxobj               *xe,
+		     int                 *pos)
+{
+    int    retval = -1;
+    int    len;
+    int    i;
+    int    j;
+    int    eq = 0;
+
+    len = clixon_xvec_len(si->si_xvec);
+    if ((i = xml_search_indexvar_binary_pos(xe, si->si_name, si->si_xvec, 0, len, len, &eq)) < 0)
+	goto done;
+    *pos = i;
+    if (eq){
+	for (j=i; j>=0 && xml_cmp(xe, clixon_xvec_i(si->si_xvec, j), 0, 0, si->si_name) == 0; j--)
+	    if (clixon_xvec_i(si->si_xvec, j) == xe){
+		*pos = j;
+		goto found;
+	    }
+	for (j=i+1; j<len && xml_cmp(xe, clixon_xvec_i(si->si_xvec, j), 0, 0, si->si_name) == 0; j++)
+	    if (clixon_xvec_i(si->si_xvec, j) == xe){
+		*pos = j;
+		goto found;
+	    }
     }
+    retval = 0;
+ done:
+    return retval;
+ found:
+    retval = 1;
+    goto done;
+}
+
+/*! Remove search index from XML node
+ * @param[in]  xpp   XML node (grandparent of index variables)
+ * @param[in]  si    Search index
+ */
+static int
+xml_search_index_del(cxobj               *xpp,
+		     struct search_index *si)
+{
+    DELQ(si, xpp->x_cold->xc_search_index, struct search_index *);
+    if (si->si_name)
+	free(si->si_name);
+    if (si->si_xvec)
+	clixon_xvec_free(si->si_xvec);
+    free(si);
     return 0;
 }
 
+/*! Insert a list entry into a search index vector, if not already there
+ * @param[in] si  Search index
+ * @param[in] xe  XML list entry
+ */
+static int
+xml_search_index_insert(struct search_index *si,
+			cxobj               *xe)
+{
+    int retval = -1;
+    int ret;
+    int i;
+
+    if ((ret = xml_search_index_pos(si, xe, &i)) < 0)
+	goto done;
+    if (ret == 0 &&
+	clixon_xvec_insert_pos(si->si_xvec, xe, i) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Remove a list entry from a search index vector
+ *
+ * If the entry is not found, its index variable may have changed, and the search index is
+ * removed to be rebuilt on next search, see xml_search_index_build
+ * @param[in] xpp XML parent of list entry
+ * @param[in] si  Search index
+ * @param[in] xe  XML list entry
+ */
+static int
+xml_search_index_rm(cxobj               *xpp,
+		    struct search_index *si,
+		    cxobj               *xe)
+{
+    int retval = -1;
+    int ret;
+    int i;
+
+    if ((ret = xml_search_index_pos(si, xe, &i)) < 0)
+	goto done;
+    if (ret == 0){
+	if (xml_search_index_del(xpp, si) < 0)
+	    goto done;
+    }
+    else if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get list entry and search index of an index variable
+ * @param[in]  xi    XML index variable
+ * @param[out] xe    XML list entry (parent of xi)
+ * @param[out] sip   Search index in grandparent of xi, if any
+ * @retval     1     Search index found
+ * @retval     0     No search index
+ */
+static int
+xml_search_index_var(cxobj                *xi,
+		     cxobj               **xe,
+		     struct search_index **sip)
+{
+    cxobj *xpp;
+
+    if ((*xe = xml_parent(xi)) == NULL ||
+	(xpp = xml_parent(*xe)) == NULL ||
+	(*sip = xml_search_index_get(xpp, xml_name(xi))) == NULL)
+	return 0;
+    return 1;
+}
+
 /*! Insert a new cxobj into search index vector for list for variable "name"
+ * The search index vector is only updated if it exists, it is otherwise built on first search
  * @param[in] xp XML parent object (the list element)
  * @param[in] xi XML index object (that should be added)
+ * @see xml_search_index_build
  */
 int
 xml_search_child_insert(cxobj *xp,
 			cxobj *xi)
 {
-    int                  retval = -1;
-    char                *indexvar;
     struct search_index *si;
-    cxobj               *xpp;
-    int                  i;
-    int                  len;
-    
-    indexvar = xml_name(xi);
-    if ((xpp = xml_parent(xp)) == NULL)
-	goto ok;
-    /* Find base vector in grandparent */
-    if ((si = xml_search_index_get(xpp, indexvar)) == NULL){
-	/* If not found add base vector in grand-parent */	      
-	if ((si = xml_search_index_add(xpp, indexvar)) == NULL)
-	    goto done;
-    }
-    /* Find element position using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, NULL)) < 0)
-	goto done;
-    assert(clixon_xvec_i(si->si_xvec, i) != xp);
-    if (clixon_xvec_insert_pos(si->si_xvec, xp, i) < 0)
-	goto done;
- ok:
-    retval = 0;
- done:    
-    return retval;
+    cxobj               *xe;
+
+    if (xml_search_index_var(xi, &xe, &si) == 0 || xe != xp)
+	return 0;
+    return xml_search_index_insert(si, xp);
 }
 
 /*! Remove a single cxobj from search vector 
  * @param[in] xp  XML parent object (the list element)
- * @param[in] xi  XML index object (that should be added)
+ * @param[in] xi  XML index object (that should be removed)
  */
 int
 xml_search_child_rm(cxobj *xp,
 		    cxobj *xi)
 {
-    int                 retval = -1;
-    cxobj              *xpp;
-    char               *indexvar;
-    int                 i;
-    int                 len;
     struct search_index *si;
-    int                  eq = 0;
-    
-    indexvar = xml_name(xi);
-    if ((xpp = xml_parent(xp)) == NULL)
+    cxobj               *xe;
+
+    if (xml_search_index_var(xi, &xe, &si) == 0 || xe != xp)
+	return 0;
+    return xml_search_index_rm(xml_parent(xp), si, xp);
+}
+
+/*! Insert or remove list entry in all search index vectors of its parent
+ * @param[in] xpp    XML parent of list entry (with search indexes)
+ * @param[in] xe     XML list entry
+ * @param[in] insert 1: insert, 0: remove
+ * @retval    0      OK
+ * @retval   -1      Error
+ */
+static int
+xml_search_index_entry(cxobj *xpp,
+		       cxobj *xe,
+		       int    insert)
+{
+    int                  retval = -1;
+    struct search_index *si;
+    struct search_index *sinext;
+    cxobj               *xi;
+    yang_stmt           *y;
+    int                  last;
+
+    if ((y = xml_spec(xe)) == NULL || yang_keyword_get(y) != Y_LIST)
 	goto ok;
-    /* Find base vector in grandparent */
-    if ((si = xml_search_index_get(xpp, indexvar)) == NULL)
+    if ((si = XML_COLD(xpp, xc_search_index)) == NULL)
 	goto ok;
-    
-    /* Find element using binary search and then remove */
-    len = clixon_xvec_len(si->si_xvec);
-    if ((i = xml_search_indexvar_binary_pos(xp, indexvar, si->si_xvec, 0, len, len, &eq)) < 0)
-	goto done;
-	//    if (clixon_xvec_i(si->si_xvec, i) == xp)
-    if (eq)
-	if (clixon_xvec_rm_pos(si->si_xvec, i) < 0)
-	    goto done;		
+    do {
+	sinext = NEXTQ(struct search_index *, si);
+	last = (sinext == XML_COLD(xpp, xc_search_index));
+	if ((xi = xml_find_type(xe, NULL, si->si_name, CX_ELMNT)) != NULL &&
+	    (y = xml_spec(xi)) != NULL &&
+	    yang_flag_get(y, YANG_FLAG_INDEX) != 0){
+	    if (insert){
+		if (xml_search_index_insert(si, xe) < 0)
+		    goto done;
+	    }
+	    else if (xml_search_index_rm(xpp, si, xe) < 0)
+		goto done;
+	}
+	si = sinext;
+    } while (!last && XML_COLD(xpp, xc_search_index));
  ok:
     retval = 0;
  done:
     return retval;
 }
 
+static char *_xml_search_index_qsort_var = NULL; /* Index variable of xml_search_index_build */
+
+/*! Help function to qsort for sorting a search index vector
+ */
+static int
+xml_search_index_qsort(const void* arg1, 
+		       const void* arg2)
+{
+    return xml_cmp(*(struct xml**)arg1, *(struct xml**)arg2, 0, 0, _xml_search_index_qsort_var);
+}
+
+/*! Build a search index vector of list entries in XML node on first search
+ *
+ * The vector contains all list entries with spec yc that have an index variable.
+ * It is then maintained when list entries and index variables are inserted and removed
+ * @param[in]  xp       XML node, parent of list entries
+ * @param[in]  yc       Yang spec of list entries
+ * @param[in]  indexvar Name of index variable
+ * @param[out] xvec     Search index vector
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xml_search_indexvar
+ */
+int
+xml_search_index_build(cxobj        *xp,
+		       yang_stmt    *yc,
+		       char         *indexvar,
+		       clixon_xvec **xvec)
+{
+    int                  retval = -1;
+    struct search_index *si;
+    cxobj               *xc = NULL;
+    cxobj               *xi;
+    yang_stmt           *yi;
+
+    if ((si = xml_search_index_get(xp, indexvar)) == NULL &&
+	(si = xml_search_index_add(xp, indexvar)) == NULL)
+	goto done;
+    if (clixon_xvec_len(si->si_xvec) == 0){
+	while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL) {
+	    if (xml_spec(xc) != yc)
+		continue;
+	    if ((xi = xml_find_type(xc, NULL, indexvar, CX_ELMNT)) == NULL ||
+		(yi = xml_spec(xi)) == NULL ||
+		yang_flag_get(yi, YANG_FLAG_INDEX) == 0)
+		continue;
+	    if (clixon_xvec_append(si->si_xvec, xc) < 0)
+		goto done;
+	}
+	_xml_search_index_qsort_var = indexvar;
+	clixon_xvec_sort(si->si_xvec, xml_search_index_qsort);
+	_xml_search_index_qsort_var = NULL;
+    }
+    *xvec = si->si_xvec;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Iterator over xml children objects using (explicit) index variable
  *
  * @param[in] xparent xml tree node whose children should be iterated
@@ -2660,3 +4224,401 @@ xml_child_index_each(cxobj           *xparent,
 }
 
 #endif /* XML_EXPLICIT_INDEX */
+
+#ifdef XML_KEY_HASH
+/*! Add a string including its trailing null to a key hash value (FNV-1a)
+ * @param[in]  h     Hash value so far
+ * @param[in]  str   String
+ * @param[in]  len   Length of string including trailing null
+ * @retval     h     New hash value
+ */
+static uint32_t
+xml_key_hash_add(uint32_t h,
+		 char    *str,
+		 size_t   len)
+{
+    size_t i;
+
+    for (i=0; i<len; i++){
+	h ^= (uint8_t)str[i];
+	h *= 16777619;
+    }
+    return h;
+}
+
+/*! Compute key hash of a yang list and key values
+ * @param[in]  y     Yang list
+ * @param[in]  xc    List entry whose key values are used (if not NULL)
+ * @param[in]  cvk   Key values in yang key order (if xc is NULL)
+ * @param[out] hv    Hash value
+ * @retval     1     OK, hash value in hv
+ * @retval     0     Not a list with keys, or a key value is missing
+ */
+static int
+xml_key_hash_val(yang_stmt *y,
+		 cxobj     *xc,
+		 cvec      *cvk,
+		 uint32_t  *hv)
+{
+    cvec     *ycvk;
+    cg_var   *ycv = NULL;
+    char     *val;
+    int       i = 0;
+    uint32_t  h = 2166136261;
+
+    if (y == NULL || yang_keyword_get(y) != Y_LIST)
+	return 0;
+    if ((ycvk = yang_cvec_get(y)) == NULL || cvec_len(ycvk) == 0)
+	return 0;
+    if (xc == NULL && cvec_len(cvk) != cvec_len(ycvk))
+	return 0;
+    h = xml_key_hash_add(h, (char*)&y, sizeof(y));
+    while ((ycv = cvec_each(ycvk, ycv)) != NULL){
+	if (xc)
+	    val = xml_find_body(xc, cv_string_get(ycv));
+	else
+	    val = cv_string_get(cvec_i(cvk, i++));
+	if (val == NULL)
+	    return 0;
+	h = xml_key_hash_add(h, val, strlen(val)+1);
+    }
+    *hv = h;
+    return 1;
+}
+
+/*! Check that the key values of a list entry are equal to given key values
+ * @param[in]  xc    List entry
+ * @param[in]  y     Yang list
+ * @param[in]  cvk   Key values in yang key order
+ * @retval     1     Equal
+ * @retval     0     Not equal
+ */
+static int
+xml_key_hash_match(cxobj     *xc,
+		   yang_stmt *y,
+		   cvec      *cvk)
+{
+    cg_var *ycv = NULL;
+    char   *val;
+    int     i = 0;
+
+    if (xml_spec(xc) != y)
+	return 0;
+    while ((ycv = cvec_each(yang_cvec_get(y), ycv)) != NULL){
+	if ((val = xml_find_body(xc, cv_string_get(ycv))) == NULL ||
+	    strcmp(val, cv_string_get(cvec_i(cvk, i++))))
+	    return 0;
+    }
+    return 1;
+}
+
+/*! Put list entry into a slot of key hash table, no size check
+ */
+static void
+xml_key_hash_slot_put(struct xml_key_hash *kh,
+		      uint32_t             hv,
+		      cxobj               *xc)
+{
+    size_t i;
+
+    i = hv & (kh->kh_size-1);
+    while (kh->kh_slots[i].ks_x != NULL)
+	i = (i+1) & (kh->kh_size-1);
+    kh->kh_slots[i].ks_hash = hv;
+    kh->kh_slots[i].ks_x = xc;
+    kh->kh_len++;
+}
+
+/*! Resize key hash table
+ * @param[in]  kh    Key hash table
+ * @param[in]  size  New number of slots, power of two larger than twice the number of entries
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_key_hash_resize(struct xml_key_hash *kh,
+		    size_t               size)
+{
+    struct xml_key_slot *slots0 = kh->kh_slots;
+    size_t               size0 = kh->kh_size;
+    size_t               i;
+
+    if ((kh->kh_slots = calloc(size, sizeof(struct xml_key_slot))) == NULL){
+	clicon_err(OE_XML, errno, "calloc");
+	kh->kh_slots = slots0;
+	return -1;
+    }
+    kh->kh_size = size;
+    kh->kh_len = 0;
+    for (i=0; i<size0; i++)
+	if (slots0[i].ks_x)
+	    xml_key_hash_slot_put(kh, slots0[i].ks_hash, slots0[i].ks_x);
+    if (slots0)
+	free(slots0);
+    return 0;
+}
+
+/*! Insert a child into key hash table of parent if it is a list entry with all keys set
+ * @param[in]  xp    XML parent node with key hash table
+ * @param[in]  xc    XML child
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_key_hash_insert(cxobj *xp,
+		    cxobj *xc)
+{
+    struct xml_key_hash *kh = xp->x_key_hash;
+    uint32_t             hv;
+
+    if (xml_type(xc) != CX_ELMNT ||
+	xml_key_hash_val(xml_spec(xc), xc, NULL, &hv) == 0)
+	return 0;
+    if (2*(kh->kh_len+1) > kh->kh_size &&
+	xml_key_hash_resize(kh, 2*kh->kh_size) < 0)
+	return -1;
+    xml_key_hash_slot_put(kh, hv, xc);
+    return 0;
+}
+
+/*! Remove a child from the key hash table of parent
+ *
+ * If the child is not found using its present key values, it may have been inserted with 
+ * other key values, and the table is freed to be rebuilt on next lookup.
+ * @param[in]  xp    XML parent node with key hash table
+ * @param[in]  xc    XML child
+ * @retval     0     OK
+ */
+static int
+xml_key_hash_rm(cxobj *xp,
+		cxobj *xc)
+{
+    struct xml_key_hash *kh = xp->x_key_hash;
+    struct xml_key_slot *slots = kh->kh_slots;
+    size_t               mask = kh->kh_size-1;
+    size_t               i;
+    size_t               j;
+    size_t               k;
+    uint32_t             hv;
+
+    if (xml_type(xc) != CX_ELMNT)
+	return 0;
+    if (xml_key_hash_val(xml_spec(xc), xc, NULL, &hv) == 0)
+	return xml_key_hash_free(xp);
+    for (i = hv & mask; slots[i].ks_x != xc; i = (i+1) & mask)
+	if (slots[i].ks_x == NULL)
+	    return xml_key_hash_free(xp);
+    /* Backward shift deletion: move later entries of the probe sequence into the hole */
+    j = i;
+    while (1){
+	j = (j+1) & mask;
+	if (slots[j].ks_x == NULL)
+	    break;
+	k = slots[j].ks_hash & mask;
+	if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+	    continue;
+	slots[i] = slots[j];
+	i = j;
+    }
+    slots[i].ks_x = NULL;
+    kh->kh_len--;
+    return 0;
+}
+
+/*! Free key hash table of XML node
+ * @param[in]  xp    XML node
+ * @retval     0     OK
+ */
+static int
+xml_key_hash_free(cxobj *xp)
+{
+    struct xml_key_hash *kh;
+
+    if ((kh = xp->x_key_hash) != NULL){
+	if (kh->kh_slots)
+	    free(kh->kh_slots);
+	free(kh);
+	xp->x_key_hash = NULL;
+    }
+    return 0;
+}
+
+/*! Build key hash table of all list entry children of an XML node
+ * @param[in]  xp    XML node
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xml_key_hash_build(cxobj *xp)
+{
+    int                  retval = -1;
+    struct xml_key_hash *kh;
+    size_t               size = 16;
+    cxobj               *xc = NULL;
+
+    if ((kh = malloc(sizeof(struct xml_key_hash))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    memset(kh, 0, sizeof(struct xml_key_hash));
+    while (size < 2*(size_t)xml_child_nr(xp))
+	size *= 2;
+    if (xml_key_hash_resize(kh, size) < 0){
+	free(kh);
+	goto done;
+    }
+    xp->x_key_hash = kh;
+    while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL)
+	if (xml_key_hash_insert(xp, xc) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find list entries with given key values using a hash table of the parent
+ *
+ * The hash table is built on first lookup in a parent with at least XML_KEY_HASH_MIN 
+ * children, and is then maintained when children are inserted and removed.
+ * @param[in]  xp    XML parent node
+ * @param[in]  yc    Yang list
+ * @param[in]  cvk   Values of all keys of yc in yang key order
+ * @param[out] xvec  Found list entries are appended to this vector
+ * @retval     1     Found, see xvec
+ * @retval     0     Not found, or no hash table. Use binary search
+ * @retval    -1     Error
+ * @see xml_find_index_yang
+ */
+int
+xml_key_hash_find(cxobj       *xp,
+		  yang_stmt   *yc,
+		  cvec        *cvk,
+		  clixon_xvec *xvec)
+{
+    int                  retval = -1;
+    struct xml_key_hash *kh;
+    size_t               i;
+    uint32_t             hv;
+    cxobj               *xc;
+    int                  found = 0;
+
+    if (!is_element(xp) ||
+	xml_key_hash_val(yc, NULL, cvk, &hv) == 0)
+	goto notfound;
+    if (xp->x_key_hash == NULL){
+	if (xml_child_nr(xp) < XML_KEY_HASH_MIN)
+	    goto notfound;
+	if (xml_key_hash_build(xp) < 0)
+	    goto done;
+    }
+    kh = xp->x_key_hash;
+    for (i = hv & (kh->kh_size-1); (xc = kh->kh_slots[i].ks_x) != NULL; i = (i+1) & (kh->kh_size-1)){
+	if (kh->kh_slots[i].ks_hash != hv || !xml_key_hash_match(xc, yc, cvk))
+	    continue;
+	if (clixon_xvec_append(xvec, xc) < 0)
+	    goto done;
+	found++;
+    }
+    if (!found)
+	goto notfound;
+    retval = 1;
+ done:
+    return retval;
+ notfound:
+    retval = 0;
+    goto done;
+}
+#endif /* XML_KEY_HASH */
+
+#ifdef XML_SUBTREE_HASH
+/*! Invalidate cached subtree hash of a node and its ancestors
+ *
+ * A node with a cached hash has cached hashes in all its descendants. Therefore, 
+ * invalidating can stop at the first ancestor without a cached hash.
+ * @param[in]  x   XML node whose name, value or children are changed
+ */
+static void
+xml_hash_reset(cxobj *x)
+{
+    if (!is_element(x))
+	x = xml_parent(x);
+    for (; x != NULL && x->x_hash != 0; x = xml_parent(x))
+	x->x_hash = 0;
+}
+
+/*! Add bytes to a 64-bit subtree hash value (FNV-1a)
+ * @param[in]  h     Hash value so far
+ * @param[in]  p     Bytes
+ * @param[in]  len   Number of bytes
+ * @retval     h     New hash value
+ */
+static uint64_t
+xml_hash_add(uint64_t    h,
+	     const void *p,
+	     size_t      len)
+{
+    const uint8_t *b = p;
+    size_t         i;
+
+    for (i=0; i<len; i++){
+	h ^= b[i];
+	h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/*! Add a string including its trailing null to a subtree hash value
+ * NULL is added as a byte that is not in UTF-8 strings
+ */
+static uint64_t
+xml_hash_str(uint64_t    h,
+	     const char *str)
+{
+    if (str == NULL)
+	return xml_hash_add(h, "\xff", 1);
+    return xml_hash_add(h, str, strlen(str)+1);
+}
+
+/*! Get hash of content of an XML subtree
+ *
+ * The hash is computed from the type, name, prefix and value of the node and recursively
+ * from the hashes of all its children, including attributes, in order. It does not depend 
+ * on flags or yang binding. The hash of an element is cached in the node and is
+ * invalidated in the node and its ancestors when the subtree is modified via this API.
+ * Thus two subtrees with different hashes are different and two subtrees with equal
+ * hashes are equal (except for hash collisions), and comparing hashes after the first
+ * computation is O(1).
+ * @param[in]  x    XML node
+ * @retval     h    Hash value, not 0
+ * @see xml_diff  which skips subtrees with equal hashes
+ */
+uint64_t
+xml_hash(cxobj *x)
+{
+    uint64_t        h = 0xcbf29ce484222325ULL;
+    enum cxobj_type type;
+    int             i;
+    uint64_t        hc;
+
+    if (is_element(x) && x->x_hash != 0)
+	return x->x_hash;
+    type = xml_type(x);
+    h = xml_hash_add(h, &type, sizeof(type));
+    h = xml_hash_str(h, xml_name(x));
+    h = xml_hash_str(h, xml_prefix(x));
+    if (!is_element(x))
+	h = xml_hash_str(h, xml_value(x));
+    else {
+	/* Not xml_child_each, the caller may iterate over the children of x */
+	for (i=0; i<xml_child_nr(x); i++){
+	    hc = xml_hash(xml_child_i(x, i));
+	    h = xml_hash_add(h, &hc, sizeof(hc));
+	}
+    }
+    if (h == 0)
+	h = 1;
+    if (is_element(x))
+	x->x_hash = h;
+    return h;
+}
+#endif /* XML_SUBTREE_HASH */
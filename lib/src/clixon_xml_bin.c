@@ -0,0 +1,442 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Compact binary encoding of XML trees, used in the internal backend protocol
+ *
+ * The encoding is an alternative to XML text between clients and the backend, it is
+ * decoded without the XML parser. Element and attribute names and prefixes are encoded
+ * as indexes in a string table that is built in the order the names first appear in the
+ * message, so repeated names, eg in list entries, are sent once.
+ *
+ * Encoding, varint is an unsigned LEB128 number:
+ *   message ::= CLIXON_BIN_MAGIC CLIXON_BIN_VERSION varint(nr) node*
+ *   node    ::= type(1 byte) name prefix varint(nr) node*  # element
+ *             | type name prefix value                           # attribute
+ *             | type value                                       # body
+ *   name, prefix ::= varint(0)                        # NULL (prefix only)
+ *             | varint(i)                             # i:th string in table, from 1
+ *             | varint(n+1) varint(len) byte*len 0    # new string, n is table length
+ *   value   ::= varint(0) | varint(len+1) byte*len 0
+ * Strings are NUL-terminated in the message so that decoded strings are referenced in
+ * place.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_bin.h"
+
+/* Encoder state */
+struct bin_enc{
+    cbuf          *be_cb;    /* Output buffer */
+    clicon_hash_t *be_hash;  /* String -> index in table */
+    int            be_len;   /* Number of strings in table */
+};
+
+/* Decoder state */
+struct bin_dec{
+    char          *bd_buf;   /* Input buffer */
+    size_t         bd_len;   /* Length of input buffer */
+    size_t         bd_pos;   /* Position in input buffer */
+    char         **bd_vec;   /* String table, strings point into bd_buf */
+    int            bd_veclen;
+    int            bd_vecmax;
+};
+
+/*! Encode an unsigned number as varint
+ */
+static int
+bin_enc_varint(struct bin_enc *be,
+	       uint32_t        n)
+{
+    char  buf[5];
+    int   i = 0;
+
+    do {
+	buf[i] = n & 0x7f;
+	n >>= 7;
+	if (n)
+	    buf[i] |= 0x80;
+	i++;
+    } while (n);
+    return cbuf_append_buf(be->be_cb, buf, i);
+}
+
+/*! Encode a string value, NULL is encoded as 0
+ */
+static int
+bin_enc_value(struct bin_enc *be,
+	      char           *str)
+{
+    size_t len;
+
+    if (str == NULL)
+	return bin_enc_varint(be, 0);
+    len = strlen(str);
+    if (bin_enc_varint(be, len+1) < 0)
+	return -1;
+    return cbuf_append_buf(be->be_cb, str, len+1); /* including NUL */
+}
+
+/*! Encode a name as index in string table, add it to the table if not found
+ * @param[in]  be   Encoder state
+ * @param[in]  str  Name or prefix, may be NULL
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+bin_enc_name(struct bin_enc *be,
+	     char           *str)
+{
+    int   i;
+    void *p;
+
+    if (str == NULL)
+	return bin_enc_varint(be, 0);
+    if ((p = clicon_hash_value(be->be_hash, str, NULL)) != NULL){
+	memcpy(&i, p, sizeof(i));
+	return bin_enc_varint(be, i+1);
+    }
+    i = be->be_len++;
+    if (clicon_hash_add(be->be_hash, str, &i, sizeof(i)) == NULL)
+	return -1;
+    if (bin_enc_varint(be, i+1) < 0)
+	return -1;
+    if (bin_enc_varint(be, strlen(str)) < 0)
+	return -1;
+    return cbuf_append_buf(be->be_cb, str, strlen(str)+1);
+}
+
+/*! Encode an XML node recursively
+ */
+static int
+bin_enc_node(struct bin_enc *be,
+	     cxobj          *x)
+{
+    int    retval = -1;
+    char   type;
+    cxobj *xc;
+    int    i;
+    int    nr;
+    
+    type = xml_type(x);
+    if (cbuf_append_buf(be->be_cb, &type, 1) < 0)
+	goto done;
+    switch (xml_type(x)){
+    case CX_BODY:
+	if (bin_enc_value(be, xml_value(x)) < 0)
+	    goto done;
+	break;
+    case CX_ATTR:
+	if (bin_enc_name(be, xml_name(x)) < 0)
+	    goto done;
+	if (bin_enc_name(be, xml_prefix(x)) < 0)
+	    goto done;
+	if (bin_enc_value(be, xml_value(x)) < 0)
+	    goto done;
+	break;
+    case CX_ELMNT:
+	if (bin_enc_name(be, xml_name(x)) < 0)
+	    goto done;
+	if (bin_enc_name(be, xml_prefix(x)) < 0)
+	    goto done;
+	nr = xml_child_nr(x);
+	if (bin_enc_varint(be, nr) < 0)
+	    goto done;
+	for (i = 0; i < nr; i++){
+	    xc = xml_child_i(x, i);
+	    if (bin_enc_node(be, xc) < 0)
+		goto done;
+	}
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Unknown XML type %d", xml_type(x));
+	goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Encode an XML tree in compact binary format
+ *
+ * @param[in]  cb   Output buffer, the encoding is appended
+ * @param[in]  x    XML tree including x itself
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_bin2xml  for decoding
+ */
+int
+clixon_xml2bin(cbuf  *cb,
+	       cxobj *x)
+{
+    int            retval = -1;
+    struct bin_enc be = {0,};
+    char           hdr[2] = {CLIXON_BIN_MAGIC, CLIXON_BIN_VERSION};
+
+    be.be_cb = cb;
+    if ((be.be_hash = clicon_hash_init()) == NULL)
+	goto done;
+    if (cbuf_append_buf(cb, hdr, sizeof(hdr)) < 0){
+	clicon_err(OE_XML, errno, "cbuf_append_buf");
+	goto done;
+    }
+    if (bin_enc_varint(&be, 1) < 0)
+	goto done;
+    if (bin_enc_node(&be, x) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (be.be_hash)
+	clicon_hash_free(be.be_hash);
+    return retval;
+}
+
+/*! Decode a varint
+ * @retval  0  OK
+ * @retval -1  Error, malformed encoding
+ */
+static int
+bin_dec_varint(struct bin_dec *bd,
+	       uint32_t       *np)
+{
+    uint32_t n = 0;
+    int      shift = 0;
+    uint8_t  c;
+
+    do {
+	if (bd->bd_pos >= bd->bd_len || shift > 28){
+	    clicon_err(OE_XML, EINVAL, "Malformed binary encoding: varint");
+	    return -1;
+	}
+	c = bd->bd_buf[bd->bd_pos++];
+	n |= (uint32_t)(c & 0x7f) << shift;
+	shift += 7;
+    } while (c & 0x80);
+    *np = n;
+    return 0;
+}
+
+/*! Decode a NUL-terminated string of len bytes referenced in place
+ */
+static int
+bin_dec_str(struct bin_dec *bd,
+	    uint32_t        len,
+	    char          **str)
+{
+    if (len >= bd->bd_len - bd->bd_pos || bd->bd_buf[bd->bd_pos+len] != '\0'){
+	clicon_err(OE_XML, EINVAL, "Malformed binary encoding: string");
+	return -1;
+    }
+    *str = &bd->bd_buf[bd->bd_pos];
+    bd->bd_pos += len + 1;
+    return 0;
+}
+
+/*! Decode a string value
+ */
+static int
+bin_dec_value(struct bin_dec *bd,
+	      char          **str)
+{
+    uint32_t n;
+
+    *str = NULL;
+    if (bin_dec_varint(bd, &n) < 0)
+	return -1;
+    if (n == 0)
+	return 0;
+    return bin_dec_str(bd, n-1, str);
+}
+
+/*! Decode a name as index in string table, or a new string added to the table
+ */
+static int
+bin_dec_name(struct bin_dec *bd,
+	     char          **str)
+{
+    uint32_t n;
+    uint32_t len;
+
+    *str = NULL;
+    if (bin_dec_varint(bd, &n) < 0)
+	return -1;
+    if (n == 0)
+	return 0;
+    if (n <= bd->bd_veclen){
+	*str = bd->bd_vec[n-1];
+	return 0;
+    }
+    if (n != bd->bd_veclen + 1){
+	clicon_err(OE_XML, EINVAL, "Malformed binary encoding: string index");
+	return -1;
+    }
+    if (bin_dec_varint(bd, &len) < 0)
+	return -1;
+    if (bin_dec_str(bd, len, str) < 0)
+	return -1;
+    if (bd->bd_veclen >= bd->bd_vecmax){
+	bd->bd_vecmax = bd->bd_vecmax?2*bd->bd_vecmax:16;
+	if ((bd->bd_vec = realloc(bd->bd_vec, bd->bd_vecmax*sizeof(char*))) == NULL){
+	    clicon_err(OE_XML, errno, "realloc");
+	    return -1;
+	}
+    }
+    bd->bd_vec[bd->bd_veclen++] = *str;
+    return 0;
+}
+
+/*! Decode an XML node recursively and add it to parent
+ */
+static int
+bin_dec_node(struct bin_dec *bd,
+	     cxobj          *xp)
+{
+    int      retval = -1;
+    uint8_t  type;
+    char    *name = NULL;
+    char    *prefix = NULL;
+    char    *value = NULL;
+    cxobj   *x;
+    uint32_t nr;
+    uint32_t i;
+
+    if (bd->bd_pos >= bd->bd_len){
+	clicon_err(OE_XML, EINVAL, "Malformed binary encoding: node");
+	goto done;
+    }
+    type = bd->bd_buf[bd->bd_pos++];
+    switch (type){
+    case CX_BODY:
+	if (bin_dec_value(bd, &value) < 0)
+	    goto done;
+	if ((x = xml_new("body", xp, CX_BODY)) == NULL)
+	    goto done;
+	if (value && xml_value_set(x, value) < 0)
+	    goto done;
+	break;
+    case CX_ATTR:
+    case CX_ELMNT:
+	if (bin_dec_name(bd, &name) < 0)
+	    goto done;
+	if (bin_dec_name(bd, &prefix) < 0)
+	    goto done;
+	if (name == NULL){
+	    clicon_err(OE_XML, EINVAL, "Malformed binary encoding: no name");
+	    goto done;
+	}
+	if ((x = xml_new(name, xp, type)) == NULL)
+	    goto done;
+	if (prefix && xml_prefix_set(x, prefix) < 0)
+	    goto done;
+	if (type == CX_ATTR){
+	    if (bin_dec_value(bd, &value) < 0)
+		goto done;
+	    if (value && xml_value_set(x, value) < 0)
+		goto done;
+	    break;
+	}
+	if (bin_dec_varint(bd, &nr) < 0)
+	    goto done;
+	for (i = 0; i < nr; i++)
+	    if (bin_dec_node(bd, x) < 0)
+		goto done;
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Malformed binary encoding: type %d", type);
+	goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Decode an XML tree in compact binary format
+ *
+ * Decoded trees are added as children of xt. No yang binding or namespace checks are
+ * made.
+ * @param[in]  buf  Binary encoding, starting with CLIXON_BIN_MAGIC
+ * @param[in]  len  Length of buf
+ * @param[in]  xt   XML parent of decoded trees
+ * @retval     0    OK
+ * @retval    -1    Error, including malformed encoding
+ * @see clixon_xml2bin  for encoding
+ */
+int
+clixon_bin2xml(char   *buf,
+	       size_t  len,
+	       cxobj  *xt)
+{
+    int            retval = -1;
+    struct bin_dec bd = {0,};
+    uint32_t       nr;
+    uint32_t       i;
+
+    if (len < 2 || buf[0] != CLIXON_BIN_MAGIC || buf[1] != CLIXON_BIN_VERSION){
+	clicon_err(OE_XML, EINVAL, "Binary encoding: bad header");
+	goto done;
+    }
+    bd.bd_buf = buf;
+    bd.bd_len = len;
+    bd.bd_pos = 2;
+    if (bin_dec_varint(&bd, &nr) < 0)
+	goto done;
+    for (i = 0; i < nr; i++)
+	if (bin_dec_node(&bd, xt) < 0)
+	    goto done;
+    retval = 0;
+ done:
+    if (bd.bd_vec)
+	free(bd.bd_vec);
+    return retval;
+}
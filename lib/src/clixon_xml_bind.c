@@ -115,6 +115,76 @@ strip_whitespace(cxobj *xt)
     return 0;
 }
 
+/*! Share body value of enumeration and identityref leafs between XML nodes
+ *
+ * Such values are typically repeated in many list entries and are interned to save memory.
+ * The type check is made once per yang leaf and cached in the yang flags.
+ * @param[in]   xt     XML leaf node
+ * @param[in]   y      Yang leaf or leaf-list of xt
+ * @retval      0      OK
+ * @retval     -1      Error
+ * @see xml_value_intern
+ */
+static int
+xml_bind_intern(cxobj     *xt,
+		yang_stmt *y)
+{
+    int        retval = -1;
+    yang_stmt *yrestype = NULL;
+    char      *restype;
+    cxobj     *xb;
+    
+    if (yang_flag_get(y, YANG_FLAG_INTERN_DONE) == 0){
+	if (yang_type_get(y, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+	    goto done;
+	restype = yrestype?yang_argument_get(yrestype):NULL;
+	if (restype &&
+	    (strcmp(restype, "enumeration") == 0 || strcmp(restype, "identityref") == 0))
+	    yang_flag_set(y, YANG_FLAG_INTERN);
+	yang_flag_set(y, YANG_FLAG_INTERN_DONE);
+    }
+    if (yang_flag_get(y, YANG_FLAG_INTERN) &&
+	(xb = xml_body_get(xt)) != NULL &&
+	xml_value_intern(xb) < 0)
+	goto done;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Complete yang binding of XML node bound from its parent
+ *
+ * Done when the body of xt is in place: index variables, interned values and cached
+ * typed values depend on it.
+ * @param[in]   xt     XML tree node
+ * @retval      0      OK
+ * @retval     -1      Error
+ * @see populate_self_parent
+ */
+static int
+populate_self_done(cxobj *xt)
+{
+    int        retval = -1;
+    yang_stmt *y;
+
+    if ((y = xml_spec(xt)) == NULL)
+	goto ok;
+#ifdef XML_EXPLICIT_INDEX
+    if (xml_search_index_p(xt))
+	xml_search_child_insert(xml_parent(xt), xt);
+#endif
+    if (yang_keyword_get(y) == Y_LEAF || yang_keyword_get(y) == Y_LEAF_LIST){
+	if (xml_bind_intern(xt, y) < 0)
+	    goto done;
+	if (xml_cv_cache_bind(xt, y) < 0)
+	    goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Associate XML node x with x:s parents yang:s matching child
  *
  * @param[in]   xt     XML tree node
@@ -207,10 +277,6 @@ populate_self_parent(cxobj  *xt,
     }
  set:
     xml_spec_set(xt, y);
-#ifdef XML_EXPLICIT_INDEX
-    if (xml_search_index_p(xt))
-	xml_search_child_insert(xp, xt);
-#endif
     retval = 1;
  done:
     if (cb)
@@ -397,6 +463,8 @@ xml_bind_yang0_opt(cxobj     *xt,
     case YB_PARENT:
 	if ((ret = populate_self_parent(xt, xsibling, xerr)) < 0)
 	    goto done;
+	if (ret == 1 && populate_self_done(xt) < 0)
+	    goto done;
 	break;
     default:
 	clicon_err(OE_XML, EINVAL, "Invalid yang binding: %d", yb);
@@ -476,6 +544,8 @@ xml_bind_yang0(cxobj     *xt,
     case YB_PARENT:
 	if ((ret = populate_self_parent(xt, NULL, xerr)) < 0)
 	    goto done;
+	if (ret == 1 && populate_self_done(xt) < 0)
+	    goto done;
 	break;
     case YB_NONE:
 	ret = 1;
@@ -508,6 +578,151 @@ xml_bind_yang0(cxobj     *xt,
     goto done;
 }
 
+/*! Find yang spec association of the top-level of an XML tree, and the rest on access
+ *
+ * As xml_bind_yang with YB_MODULE, but only the children of xt are bound. The
+ * children of a node are bound when xml_spec() of one of them is first called, so
+ * that only the parts of a large tree that are visited are bound.
+ * @param[in]   xt     XML tree node
+ * @param[in]   yspec  Yang spec
+ * @param[out]  xerr   Reason for failure, or NULL
+ * @retval      1      OK yang assignment made
+ * @retval      0      Partial or no yang assigment made (at least one failed) and xerr set
+ * @retval     -1      Error
+ * @note Errors below the top-level are not reported, such nodes are left unbound
+ * @see xml_bind_yang  Binds the whole tree
+ * @see XML_FLAG_LAZY
+ */
+int
+xml_bind_yang_lazy(cxobj     *xt, 
+		   yang_stmt *yspec,
+		   cxobj    **xerr)
+{
+    int             retval = -1;
+    cxobj          *xc;
+    clixon_xml_iter it;
+    int             ret;
+    int             failed = 0;
+
+    xml_spec_lazy_enable();
+    strip_whitespace(xt);
+    xml_child_iter_init(&it, xt, CX_ELMNT);
+    while ((xc = xml_child_iter_next(&it)) != NULL) {
+	if ((ret = populate_self_top(xc, yspec, xerr)) < 0)
+	    goto done;
+	if (ret == 0)
+	    failed++;
+	else if (ret == 1){
+	    strip_whitespace(xc);
+	    xml_flag_set(xc, XML_FLAG_LAZY);
+	}
+    }
+    if (failed)
+	goto fail;
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Bind yang to the element children of a node, but not to their children
+ *
+ * Called by xml_spec() on first access of a child of a node with XML_FLAG_LAZY set.
+ * Children whose yang is not found are left unbound.
+ * @param[in]   xt     XML node with yang spec
+ * @retval      0      OK
+ * @retval     -1      Error
+ * @see xml_bind_yang_lazy
+ */
+int
+xml_bind_yang_lazy_children(cxobj *xt)
+{
+    int             retval = -1;
+    cxobj          *xc;
+    cxobj          *xc0 = NULL;
+    clixon_xml_iter it;
+    int             ret;
+
+    /* Reset first: binding calls xml_spec on xt and its children */
+    xml_flag_reset(xt, XML_FLAG_LAZY);
+    xml_child_iter_init(&it, xt, CX_ELMNT);
+    while ((xc = xml_child_iter_next(&it)) != NULL) {
+	/* Use the previous bound sibling with same name as role model */
+	if (xc0 && (clicon_strcmp(xml_name(xc0), xml_name(xc)) != 0 ||
+		    clicon_strcmp(xml_prefix(xc0), xml_prefix(xc)) != 0))
+	    xc0 = NULL;
+	if ((ret = populate_self_parent(xc, xc0, NULL)) < 0)
+	    goto done;
+	if (ret != 1){
+	    xc0 = NULL;
+	    continue;
+	}
+	if (populate_self_done(xc) < 0)
+	    goto done;
+	strip_whitespace(xc);
+	xml_flag_set(xc, XML_FLAG_LAZY);
+	xc0 = xc;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Bind yang to a single XML node while it is parsed, at its start tag
+ *
+ * The start tag: name, prefix and attributes of xt are parsed but not its children.
+ * Its parent is bound already. Complete with xml_bind_yang_parse_done() at the end tag.
+ * @param[in]   xt       XML tree node
+ * @param[in]   yb       YB_MODULE: bind from modules, or YB_PARENT: bind from parent
+ * @param[in]   xsibling Sibling node with same yang spec (eg previous list entry), or NULL
+ * @param[in]   yspec    Yang spec
+ * @param[out]  xerr     Reason for failure, or NULL
+ * @retval      1        OK yang assignment made
+ * @retval      2        OK yang assignment not made, children should not be bound
+ * @retval      0        Yang assigment not made and xerr set
+ * @retval     -1        Error
+ * @see xml_bind_yang0   Binds a complete tree after parsing
+ */
+int
+xml_bind_yang_parse(cxobj     *xt, 
+		    yang_bind  yb,
+		    cxobj     *xsibling,
+		    yang_stmt *yspec,
+		    cxobj    **xerr)
+{
+    int retval = -1;
+
+    switch (yb){
+    case YB_MODULE:
+	retval = populate_self_top(xt, yspec, xerr);
+	break;
+    case YB_PARENT:
+	retval = populate_self_parent(xt, xsibling, xerr);
+	break;
+    default:
+	clicon_err(OE_XML, EINVAL, "Invalid yang binding: %d", yb);
+	break;
+    }
+    return retval;
+}
+
+/*! Complete yang binding of a single XML node at its end tag
+ *
+ * @param[in]   xt     XML tree node, bound with xml_bind_yang_parse()
+ * @retval      0      OK
+ * @retval     -1      Error
+ */
+int
+xml_bind_yang_parse_done(cxobj *xt)
+{
+    if (xml_spec(xt) == NULL)
+	return 0;
+    strip_whitespace(xt);
+    return populate_self_done(xt);
+}
+
 /*! Find yang spec association of XML node for incoming RPC starting with <rpc>
  * 
  * Incoming RPC has an "input" structure that is not taken care of by xml_bind_yang
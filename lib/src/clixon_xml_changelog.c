@@ -46,6 +46,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <ctype.h>
 #include <limits.h>
 #include <stdint.h>
 #include <sys/types.h>
@@ -215,55 +216,213 @@ changelog_move(clicon_handle h,
     return retval;
 }
 
-/*! Perform a changelog operation
- * @param[in]  h   Clicon handle
- * @param[in]  xt  XML to upgrade
- * @param[in]  xi  Changelog item
+/* Changelog step operations */
+enum changelog_op_type{
+    CL_OP_RENAME,
+    CL_OP_REPLACE,
+    CL_OP_INSERT,
+    CL_OP_DELETE,
+    CL_OP_MOVE,
+    CL_OP_UNKNOWN
+};
+
+/*! Changelog step compiled before upgrade, see changelog_compile
+ */
+struct changelog_step{
+    char                  *cs_opstr; /* Operation as in changelog */
+    enum changelog_op_type cs_op;    /* Operation */
+    char                  *cs_where; /* xpath to where (target-node) */
+    char                  *cs_when;  /* xpath to when, or NULL */
+    char                  *cs_tag;   /* xpath to new name (rename) */
+    char                  *cs_dst;   /* xpath to destination (move) */
+    cxobj                 *cs_new;   /* new xml (insert, replace) */
+    cvec                  *cs_nsc;   /* Namespace context of changelog item */
+};
+typedef struct changelog_step changelog_step;
+
+/*! Compile the steps of a changelog into a vector
+ * Each step is decoded once, including its namespace context, before any
+ * target is evaluated.
+ * Steps without op or where are skipped
+ * @param[in]  xch   Changelog
+ * @param[out] csvp  Vector of compiled steps, free with changelog_steps_free
+ * @param[out] cslp  Length of vector
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+changelog_compile(cxobj           *xch,
+		  changelog_step **csvp,
+		  int             *cslp)
+{
+    int             retval = -1;
+    cxobj         **vec = NULL;
+    size_t          veclen;
+    changelog_step *csv = NULL;
+    changelog_step *cs;
+    cxobj          *xi;
+    char           *op;
+    int             csl = 0;
+    int             i;
+
+    if (xpath_vec(xch, NULL, "step", &vec, &veclen) < 0)
+	goto done;
+    if (veclen && (csv = calloc(veclen, sizeof(changelog_step))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<veclen; i++){
+	xi = vec[i];
+	if ((op = xml_find_body(xi, "op")) == NULL)
+	    continue;
+	cs = &csv[csl];
+	if ((cs->cs_where = xml_find_body(xi, "where")) == NULL)
+	    continue;
+	cs->cs_opstr = op;
+	if (strcmp(op, "rename") == 0)
+	    cs->cs_op = CL_OP_RENAME;
+	else if (strcmp(op, "replace") == 0)
+	    cs->cs_op = CL_OP_REPLACE;
+	else if (strcmp(op, "insert") == 0)
+	    cs->cs_op = CL_OP_INSERT;
+	else if (strcmp(op, "delete") == 0)
+	    cs->cs_op = CL_OP_DELETE;
+	else if (strcmp(op, "move") == 0)
+	    cs->cs_op = CL_OP_MOVE;
+	else
+	    cs->cs_op = CL_OP_UNKNOWN;
+	cs->cs_when = xml_find_body(xi, "when");
+	cs->cs_tag = xml_find_body(xi, "tag");
+	cs->cs_dst = xml_find_body(xi, "dst");
+	cs->cs_new = xml_find(xi, "new");
+	/* Get namespace context from changelog item */
+	if (xml_nsctx_node(xi, &cs->cs_nsc) < 0)
+	    goto done;
+	csl++;
+    }
+    *csvp = csv;
+    csv = NULL;
+    *cslp = csl;
+    retval = 0;
+ done:
+    if (csv){
+	for (i=0; i<csl; i++)
+	    if (csv[i].cs_nsc)
+		xml_nsctx_free(csv[i].cs_nsc);
+	free(csv);
+    }
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Free vector of compiled changelog steps
+ */
+static int
+changelog_steps_free(changelog_step *csv,
+		     int             csl)
+{
+    int i;
+
+    if (csv == NULL)
+	return 0;
+    for (i=0; i<csl; i++)
+	if (csv[i].cs_nsc)
+	    xml_nsctx_free(csv[i].cs_nsc);
+    free(csv);
+    return 0;
+}
+
+/*! Check if a where xpath is a plain absolute path of child steps, eg /a:x/a:y
+ */
+static int
+changelog_path_plain(char *xpath)
+{
+    char *p;
+
+    if (xpath[0] != '/' || strstr(xpath, "//") != NULL)
+	return 0;
+    for (p = xpath; *p; p++)
+	if (!isalnum((unsigned char)*p) && strchr("/:_.-", *p) == NULL)
+	    return 0;
+    return 1;
+}
+
+/*! Check if two namespace contexts are equal
+ */
+static int
+changelog_nsc_eq(cvec *nsc0,
+		 cvec *nsc1)
+{
+    cg_var *cv0;
+    cg_var *cv1;
+    int     i;
+
+    if (nsc0 == NULL || nsc1 == NULL)
+	return nsc0 == nsc1;
+    if (cvec_len(nsc0) != cvec_len(nsc1))
+	return 0;
+    for (i=0; i<cvec_len(nsc0); i++){
+	cv0 = cvec_i(nsc0, i);
+	cv1 = cvec_i(nsc1, i);
+	if (clicon_strcmp(cv_name_get(cv0), cv_name_get(cv1)) != 0 ||
+	    clicon_strcmp(cv_string_get(cv0), cv_string_get(cv1)) != 0)
+	    return 0;
+    }
+    return 1;
+}
+
+/*! Check if a step has the same targets as the previous step, after it was applied
+ * This is the case if both have the same plain where path and the previous
+ * operation modifies the children of its targets but not the targets themselves.
+ * @param[in]  cs0  Previous step
+ * @param[in]  cs1  Step
+ * @retval     1    Targets of cs0 can be reused for cs1
+ * @retval     0    Targets of cs1 need to be evaluated
+ */
+static int
+changelog_targets_reuse(changelog_step *cs0,
+			changelog_step *cs1)
+{
+    if (cs0->cs_op != CL_OP_INSERT && cs0->cs_op != CL_OP_REPLACE)
+	return 0;
+    if (strcmp(cs0->cs_where, cs1->cs_where) != 0)
+	return 0;
+    if (!changelog_path_plain(cs1->cs_where))
+	return 0;
+    return changelog_nsc_eq(cs0->cs_nsc, cs1->cs_nsc);
+}
 
+/*! Perform a changelog operation on a vector of target nodes
+ * @param[in]  h     Clicon handle
+ * @param[in]  xt    XML to upgrade
+ * @param[in]  cs    Compiled changelog step
+ * @param[in]  wvec  Vector of where(target) nodes
+ * @param[in]  wlen  Length of wvec
+ * @retval     1     OK
+ * @retval     0     Failed
+ * @retval    -1     Error
  * @note XXX error handling!
  * @note XXX xn --> xt  xpath may not match
-*/
+ */
 static int
-changelog_op(clicon_handle h,
-	     cxobj        *xt,
-	     cxobj        *xi)
-
+changelog_op(clicon_handle   h,
+	     cxobj          *xt,
+	     changelog_step *cs,
+	     cxobj         **wvec,
+	     size_t          wlen)
 {
     int     retval = -1;
-    char   *op;
-    char   *whenxpath;   /* xpath to when */
-    char   *tag;         /* xpath to extra path (move) */
-    char   *dst;         /* xpath to extra path (move) */
-    cxobj  *xnew;        /* new xml (insert, replace) */
-    char   *wxpath;      /* xpath to where (target-node) */
-    cxobj **wvec = NULL; /* Vector of where(target) nodes */
-    size_t  wlen;
     cxobj  *xw;
     int     ret;
     xp_ctx *xctx = NULL;
     int     i;
-    cvec   *nsc = NULL;
 
-    /* Get namespace context from changelog item */
-    if (xml_nsctx_node(xi, &nsc) < 0)
-	goto done;
-    if ((op = xml_find_body(xi, "op")) == NULL)
-	goto ok;
-    /* get common variables that may be used in the operations below */
-    tag = xml_find_body(xi, "tag");
-    dst = xml_find_body(xi, "dst");
-    xnew = xml_find(xi, "new");
-    whenxpath = xml_find_body(xi, "when");
-    if ((wxpath = xml_find_body(xi, "where")) == NULL)
-	goto ok;
-    /* Get vector of target nodes meeting the where requirement */
-    if (xpath_vec(xt, nsc, "%s", &wvec, &wlen, wxpath) < 0)
-       goto done;
    for (i=0; i<wlen; i++){
        xw = wvec[i];
        /* If 'when' exists and is false, skip this target */
-       if (whenxpath){
-	   if (xpath_vec_ctx(xw, nsc, whenxpath, 0, &xctx) < 0)
+       if (cs->cs_when){
+	   if (xpath_vec_ctx(xw, cs->cs_nsc, cs->cs_when, 0, &xctx) < 0)
 	       goto done;
 	   if ((ret = ctx2boolean(xctx)) < 0)
 	       goto done;
@@ -275,50 +434,50 @@ changelog_op(clicon_handle h,
 	       continue;
        }
        /* Now switch on operation */
-       if (strcmp(op, "rename") == 0){
-	   ret = changelog_rename(h, xt, xw, nsc, tag);
-       }
-       else if (strcmp(op, "replace") == 0){
-	   ret = changelog_replace(h, xt, xw, xnew);
-       }
-       else if (strcmp(op, "insert") == 0){
-	   ret = changelog_insert(h, xt, xw, xnew);
-       }
-       else if (strcmp(op, "delete") == 0){
+       switch (cs->cs_op){
+       case CL_OP_RENAME:
+	   ret = changelog_rename(h, xt, xw, cs->cs_nsc, cs->cs_tag);
+	   break;
+       case CL_OP_REPLACE:
+	   ret = changelog_replace(h, xt, xw, cs->cs_new);
+	   break;
+       case CL_OP_INSERT:
+	   ret = changelog_insert(h, xt, xw, cs->cs_new);
+	   break;
+       case CL_OP_DELETE:
 	   ret = changelog_delete(h, xt, xw);
-       }
-       else if (strcmp(op, "move") == 0){
-	   ret = changelog_move(h, xt, xw, nsc, dst);
-       }
-       else{
-	   clicon_err(OE_XML, 0, "Unknown operation: %s", op);
+	   break;
+       case CL_OP_MOVE:
+	   ret = changelog_move(h, xt, xw, cs->cs_nsc, cs->cs_dst);
+	   break;
+       default:
+	   clicon_err(OE_XML, 0, "Unknown operation: %s", cs->cs_opstr);
 	   goto done;
+	   break;
        }
        if (ret < 0)
 	   goto done;
        if (ret == 0)
 	   goto fail;
    }
- ok:
     retval = 1;
  done:
-    if (nsc)
-	xml_nsctx_free(nsc);
-    if (wvec)
-	free(wvec);
     if (xctx)
 	ctx_free(xctx);
     return retval;
  fail:
     retval = 0;
-    clicon_debug(1, "%s fail op:%s ", __FUNCTION__, op);
+    clicon_debug(1, "%s fail op:%s ", __FUNCTION__, cs->cs_opstr);
     goto done;
 }
     
 /*! Iterate through one changelog item
+ * The steps are compiled first. Then they are applied in order, since a step may
+ * rename or move the targets of later steps. The targets of consecutive steps with
+ * the same where path are only evaluated once, see changelog_targets_reuse.
  * @param[in]  h   Clicon handle
- * @param[in]  xt  Changelog list
- * @param[in]  xn  XML to upgrade
+ * @param[in]  xt  XML to upgrade
+ * @param[in]  xch Changelog
  */
 static int
 changelog_iterate(clicon_handle h,
@@ -326,17 +485,28 @@ changelog_iterate(clicon_handle h,
 		  cxobj        *xch)
 
 {
-    int        retval = -1;
-    cxobj    **vec = NULL;
-    size_t     veclen;
-    int        ret;
-    int        i;
+    int             retval = -1;
+    changelog_step *csv = NULL;
+    int             csl = 0;
+    cxobj         **wvec = NULL; /* Vector of where(target) nodes */
+    size_t          wlen;
+    int             ret;
+    int             i;
     
-    if (xpath_vec(xch, NULL, "step", &vec, &veclen) < 0)
+    if (changelog_compile(xch, &csv, &csl) < 0)
 	goto done;
     /* Iterate through changelog items */
-    for (i=0; i<veclen; i++){
-	if ((ret = changelog_op(h, xt, vec[i])) < 0)
+    for (i=0; i<csl; i++){
+	if (i == 0 || !changelog_targets_reuse(&csv[i-1], &csv[i])){
+	    if (wvec){
+		free(wvec);
+		wvec = NULL;
+	    }
+	    /* Get vector of target nodes meeting the where requirement */
+	    if (xpath_vec(xt, csv[i].cs_nsc, "%s", &wvec, &wlen, csv[i].cs_where) < 0)
+		goto done;
+	}
+	if ((ret = changelog_op(h, xt, &csv[i], wvec, wlen)) < 0)
 	    goto done;
 	if (ret == 0)
 	    goto fail;
@@ -344,8 +514,9 @@ changelog_iterate(clicon_handle h,
     retval = 1;
  done:
     clicon_debug(1, "%s retval: %d", __FUNCTION__, retval);
-    if (vec)
-	free(vec);
+    if (wvec)
+	free(wvec);
+    changelog_steps_free(csv, csl);
     return retval;
  fail:
     retval = 0;
@@ -53,6 +53,8 @@
 #include <string.h>
 #include <limits.h>
 #include <assert.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 /* cligen */
 #include <cligen/cligen.h>
@@ -73,6 +75,7 @@
 #include "clixon_xml_sort.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_xml_parse.h"
+#include "clixon_xml_map.h"
 #include "clixon_xml_io.h"
 
 /*
@@ -82,11 +85,268 @@
 #define BUFLEN 1024  
 /* Indentation for xml pretty-print. Consider option? */
 #define XML_INDENT 3
+/* Size of output buffer when printing xml to a file */
+#define XML_FILE_CHUNK (64*1024)
 
 /*------------------------------------------------------------------------
  * XML printing functions. Output a parse tree to file, string cligen buf
  *------------------------------------------------------------------------*/
 
+/*! Flush chunk buffer to callback if it has reached chunk size
+ * @param[in]  cb     Chunk buffer
+ * @param[in]  chunk  Chunk size, flush if buffer is at least this size. 0: always flush
+ * @param[in]  fn     Chunk callback
+ * @param[in]  arg    User argument to callback
+ */
+static int
+xml2chunk_flush(cbuf                *cb,
+		size_t               chunk,
+		clicon_xml_chunk_cb *fn,
+		void                *arg)
+{
+    int retval = -1;
+
+    if (cbuf_len(cb) > 0 && cbuf_len(cb) >= chunk){
+	if (fn(arg, cbuf_get(cb), cbuf_len(cb)) < 0)
+	    goto done;
+	cbuf_reset(cb);
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Print a default value that is not in the XML tree to a chunk buffer
+ *
+ * A leaf with its default value, or a non-presence container with its default values
+ * @param[in]  cb     Chunk buffer
+ * @param[in]  yd     Yang leaf or non-presence container, see xml_default_next
+ * @param[in]  ns     Default namespace in scope, or NULL if not known
+ * @param[in]  level  Indentation level for prettyprint
+ * @param[in]  prettyprint insert \n and spaces to make the xml more readable.
+ * @param[in]  depth  Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @see XML_FLAG_REPORT_ALL
+ */
+static int
+xml2chunk_default(cbuf      *cb,
+		  yang_stmt *yd,
+		  char      *ns,
+		  int        level,
+		  int        prettyprint,
+		  int32_t    depth)
+{
+    int        retval = -1;
+    char      *name;
+    char      *myns;
+    char      *val = NULL;
+    yang_stmt *yc = NULL;
+
+    if (depth == 0)
+	goto ok;
+    name = yang_argument_get(yd);
+    myns = yang_find_mynamespace(yd);
+    if (prettyprint)
+	clicon_cbuf_indent(cb, level*XML_INDENT);
+    cbuf_append_str(cb, "<");
+    cbuf_append_str(cb, name);
+    if (myns && (ns == NULL || strcmp(ns, myns) != 0)){
+	cbuf_append_str(cb, " xmlns=\"");
+	cbuf_append_str(cb, myns);
+	cbuf_append_str(cb, "\"");
+    }
+    cbuf_append_str(cb, ">");
+    if (yang_keyword_get(yd) == Y_LEAF){
+	if ((val = cv2str_dup(yang_cv_get(yd))) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv2str_dup");
+	    goto done;
+	}
+	if (xml_chardata_cbuf_append(cb, val) < 0)
+	    goto done;
+    }
+    else { /* Non-presence container */
+	if (prettyprint)
+	    cbuf_append_str(cb, "\n");
+	do {
+	    if (xml_default_next(yd, NULL, 1, &yc) < 0)
+		goto done;
+	    if (yc && xml2chunk_default(cb, yc, myns, level+1, prettyprint, depth-1) < 0)
+		goto done;
+	} while (yc);
+	if (prettyprint)
+	    clicon_cbuf_indent(cb, level*XML_INDENT);
+    }
+    cbuf_append_str(cb, "</");
+    cbuf_append_str(cb, name);
+    cbuf_append_str(cb, ">");
+    if (prettyprint)
+	cbuf_append_str(cb, "\n");
+ ok:
+    retval = 0;
+ done:
+    if (val)
+	free(val);
+    return retval;
+}
+
+/*! Print an XML tree structure to a chunk buffer, see clicon_xml2chunk
+ *
+ * Same output as clicon_xml2cbuf. Names and indentation are appended as raw bytes,
+ * no format strings are parsed.
+ * If defaults is set, default values not in the tree are printed as if they were, in yang
+ * order among the children of each node, see XML_FLAG_REPORT_ALL
+ */
+static int
+xml2chunk_recurse(cbuf                *cb,
+		  cxobj               *x,
+		  int                  level,
+		  int                  prettyprint,
+		  int32_t              depth,
+		  int                  defaults,
+		  size_t               chunk,
+		  clicon_xml_chunk_cb *fn,
+		  void                *arg)
+{
+    int        retval = -1;
+    cxobj     *xc;
+    clixon_xml_iter it;
+    char      *name;
+    int        hasbody;
+    int        haselement;
+    char      *namespace;
+    char      *val;
+    yang_stmt *ys = NULL;
+    yang_stmt *yc;
+    yang_stmt *yd = NULL; /* Next default value not in tree */
+    char      *ns = NULL;
+    
+    if (depth == 0)
+	goto ok;
+    name = xml_name(x);
+    namespace = xml_prefix(x);
+    switch(xml_type(x)){
+    case CX_BODY:
+	if ((val = xml_value(x)) == NULL) /* incomplete tree */
+	    break;
+	if (xml_chardata_cbuf_append(cb, val) < 0)
+	    goto done;
+	break;
+    case CX_ATTR:
+	cbuf_append_str(cb, " ");
+	if (namespace){
+	    cbuf_append_str(cb, namespace);
+	    cbuf_append_str(cb, ":");
+	}
+	cbuf_append_str(cb, name);
+	cbuf_append_str(cb, "=\"");
+	if ((val = xml_value(x)) != NULL)
+	    cbuf_append_str(cb, val);
+	cbuf_append_str(cb, "\"");
+	break;
+    case CX_ELMNT:
+	if (prettyprint)
+	    clicon_cbuf_indent(cb, level*XML_INDENT);
+	cbuf_append_str(cb, "<");
+	if (namespace){
+	    cbuf_append_str(cb, namespace);
+	    cbuf_append_str(cb, ":");
+	}
+	cbuf_append_str(cb, name);
+	hasbody = 0;
+	haselement = 0;
+	xml_child_iter_init(&it, x, CX_ERROR);
+	/* print attributes only */
+	while ((xc = xml_child_iter_next(&it)) != NULL) 
+	    switch (xml_type(xc)){
+	    case CX_ATTR:
+		if (xml2chunk_recurse(cb, xc, level+1, prettyprint, -1, 0, chunk, fn, arg) < 0)
+		    goto done;
+		break;
+	    case CX_BODY:
+		hasbody=1;
+		break;
+	    case CX_ELMNT:
+		haselement=1;
+		break;
+	    default:
+		break;
+	    }
+	if (defaults && hasbody == 0 && (ys = xml_spec(x)) != NULL){
+	    if (xml_default_next(ys, x, 1, &yd) < 0)
+		goto done;
+	    /* The default namespace of an element without prefix is its own namespace */
+	    if (namespace == NULL)
+		ns = yang_find_mynamespace(ys);
+	}
+	/* Check for special case <a/> instead of <a></a> */
+	if (hasbody==0 && haselement==0 && yd == NULL) 
+	    cbuf_append_str(cb, "/>");
+	else{
+	    cbuf_append_str(cb, ">");
+	    if (prettyprint && hasbody == 0)
+		cbuf_append_str(cb, "\n");
+	    xml_child_iter_init(&it, x, CX_ERROR);
+	    while ((xc = xml_child_iter_next(&it)) != NULL){
+		if (xml_type(xc) == CX_ATTR)
+		    continue;
+		/* Default values before xc in yang order */
+		while (yd && (yc = xml_spec(xc)) != NULL && yang_order(yd) < yang_order(yc)){
+		    if (xml2chunk_default(cb, yd, ns, level+1, prettyprint, depth-1) < 0)
+			goto done;
+		    if (xml_default_next(ys, x, 1, &yd) < 0)
+			goto done;
+		}
+		if (xml2chunk_recurse(cb, xc, level+1, prettyprint, depth-1, defaults, chunk, fn, arg) < 0)
+		    goto done;
+	    }
+	    while (yd){
+		if (xml2chunk_default(cb, yd, ns, level+1, prettyprint, depth-1) < 0)
+		    goto done;
+		if (xml_default_next(ys, x, 1, &yd) < 0)
+		    goto done;
+	    }
+	    if (prettyprint && hasbody == 0)
+		clicon_cbuf_indent(cb, level*XML_INDENT);
+	    cbuf_append_str(cb, "</");
+	    if (namespace){
+		cbuf_append_str(cb, namespace);
+		cbuf_append_str(cb, ":");
+	    }
+	    cbuf_append_str(cb, name);
+	    cbuf_append_str(cb, ">");
+	}
+	if (prettyprint)
+	    cbuf_append_str(cb, "\n");
+	if (fn && xml2chunk_flush(cb, chunk, fn, arg) < 0)
+	    goto done;
+	break;
+    default:
+	break;
+    }/* switch */
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/* Output stream and print function of xml2file_write_fn */
+struct xml2file_write {
+    FILE             *fw_f;
+    clicon_output_cb *fw_fn;
+};
+
+/*! Write an encoded body segment to output stream, callback of xml_chardata_write
+ */
+static int
+xml2file_write_fn(void       *arg,
+		  const char *s,
+		  size_t      len)
+{
+    struct xml2file_write *fw = (struct xml2file_write *)arg;
+
+    (*fw->fw_fn)(fw->fw_f, "%.*s", (int)len, s);
+    return 0;
+}
+
 /*! Print an XML tree structure to an output stream and encode chars "<>&"
  *
  * @param[in]   f           UNIX output stream
@@ -95,8 +355,8 @@
  * @param[in]   prettyprint insert \n and spaces tomake the xml more readable.
  * @param[in]   fn          Callback to make print function
  * @see clicon_xml2cbuf
- * One can use clicon_xml2cbuf to get common code, but using fprintf is
- * much faster than using cbuf and then printing that,...
+ * Used for user-defined print callbacks, clicon_xml2file instead writes via a
+ * large output buffer which is faster than one callback per token.
  */
 int
 xml2file_recurse(FILE             *f, 
@@ -109,10 +369,11 @@ xml2file_recurse(FILE             *f,
     char  *name;
     char  *namespace;
     cxobj *xc;
+    clixon_xml_iter it;
     int    hasbody;
     int    haselement;
     char  *val;
-    char  *encstr = NULL; /* xml encoded string */
+    struct xml2file_write fw;
     
     if (x == NULL)
 	goto ok;
@@ -122,9 +383,10 @@ xml2file_recurse(FILE             *f,
     case CX_BODY:
 	if ((val = xml_value(x)) == NULL) /* incomplete tree */
 	    break;
-	if (xml_chardata_encode(&encstr, "%s", val) < 0)
+	fw.fw_f = f;
+	fw.fw_fn = fn;
+	if (xml_chardata_write(val, xml2file_write_fn, &fw) < 0)
 	    goto done;
-	(*fn)(f, "%s", encstr);
 	break;
     case CX_ATTR:
 	(*fn)(f, " ");
@@ -139,9 +401,9 @@ xml2file_recurse(FILE             *f,
 	(*fn)(f, "%s", name);
 	hasbody = 0;
 	haselement = 0;
-	xc = NULL;
+	xml_child_iter_init(&it, x, CX_ERROR);
 	/* print attributes only */
-	while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+	while ((xc = xml_child_iter_next(&it)) != NULL) {
 	    switch (xml_type(xc)){
 	    case CX_ATTR:
 		if (xml2file_recurse(f, xc, level+1, prettyprint, fn) <0)
@@ -166,8 +428,8 @@ xml2file_recurse(FILE             *f,
 	    (*fn)(f, ">");
 	    if (prettyprint && hasbody == 0)
 		    (*fn)(f, "\n");
-	    xc = NULL;
-	    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+	    xml_child_iter_init(&it, x, CX_ERROR);
+	    while ((xc = xml_child_iter_next(&it)) != NULL) {
 		if (xml_type(xc) != CX_ATTR)
 		    if (xml2file_recurse(f, xc, level+1, prettyprint, fn) <0)
 			goto done;
@@ -188,8 +450,57 @@ xml2file_recurse(FILE             *f,
  ok:
     retval = 0;
  done:
-    if (encstr)
-	free(encstr);
+    return retval;
+}
+
+/*! Chunk callback of xml2file_buffered, write chunk to output stream
+ */
+static int
+xml2file_chunk_cb(void  *arg,
+		  char  *buf,
+		  size_t len)
+{
+    if (fwrite(buf, 1, len, (FILE *)arg) != len){
+	clicon_err(OE_UNIX, errno, "fwrite");
+	return -1;
+    }
+    return 0;
+}
+
+/*! Print an XML tree structure to an output stream via a large output buffer
+ *
+ * The tree is serialized into a buffer of XML_FILE_CHUNK bytes which is written
+ * with fwrite whenever it is full, instead of one fprintf per token.
+ * @param[in]   f           UNIX output stream
+ * @param[in]   xn          clicon xml tree
+ * @param[in]   level       how many spaces to insert before each line
+ * @param[in]   prettyprint insert \n and spaces tomake the xml more readable.
+ */
+static int
+xml2file_buffered(FILE  *f, 
+		  cxobj *x, 
+		  int    level, 
+		  int    prettyprint)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if (x == NULL)
+	goto ok;
+    if ((cb = cbuf_new_alloc(XML_FILE_CHUNK+BUFLEN)) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new_alloc");
+	goto done;
+    }
+    if (xml2chunk_recurse(cb, x, level, prettyprint, -1, xml_flag(x, XML_FLAG_REPORT_ALL) != 0,
+			  XML_FILE_CHUNK, xml2file_chunk_cb, f) < 0)
+	goto done;
+    if (xml2chunk_flush(cb, 0, xml2file_chunk_cb, f) < 0) /* last chunk */
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
     return retval;
 }
 
@@ -208,7 +519,7 @@ clicon_xml2file(FILE  *f,
 		int    level, 
 		int    prettyprint)
 {
-    return xml2file_recurse(f, x, level, prettyprint, fprintf);
+    return xml2file_buffered(f, x, level, prettyprint);
 }
 
 /*! Print an XML tree structure to an output stream and encode chars "<>&"
@@ -242,7 +553,7 @@ int
 xml_print(FILE  *f, 
 	  cxobj *x)
 {
-    return xml2file_recurse(f, x, 0, 1, fprintf);
+    return xml2file_buffered(f, x, 0, 1);
 }
 
 /*! Print an XML tree structure to a cligen buffer and encode chars "<>&"
@@ -261,6 +572,7 @@ xml_print(FILE  *f,
  * fprintf(stderr, "%s", cbuf_get(cb));
  * cbuf_free(cb);
  * @endcode
+ * @note If XML_FLAG_REPORT_ALL is set on xn, default values not in the tree are also printed
  * @see  clicon_xml2file
  */
 int
@@ -270,94 +582,8 @@ clicon_xml2cbuf(cbuf   *cb,
 		int     prettyprint,
 		int32_t depth)
 {
-    int    retval = -1;
-    cxobj *xc;
-    char  *name;
-    int    hasbody;
-    int    haselement;
-    char  *namespace;
-    char  *val;
-    
-    if (depth == 0)
-	goto ok;
-    name = xml_name(x);
-    namespace = xml_prefix(x);
-    switch(xml_type(x)){
-    case CX_BODY:
-	if ((val = xml_value(x)) == NULL) /* incomplete tree */
-	    break;
-	if (xml_chardata_cbuf_append(cb, val) < 0)
-	    goto done;
-	break;
-    case CX_ATTR:
-	cbuf_append_str(cb, " ");
-	if (namespace){
-	    cbuf_append_str(cb, namespace);
-	    cbuf_append_str(cb, ":");
-	}
-	cprintf(cb, "%s=\"%s\"", name, xml_value(x));
-	break;
-    case CX_ELMNT:
-	if (prettyprint)
-	    cprintf(cb, "%*s<", level*XML_INDENT, "");
-	else
-	    cbuf_append_str(cb, "<");
-	if (namespace){
-	    cbuf_append_str(cb, namespace);
-	    cbuf_append_str(cb, ":");
-	}
-	cbuf_append_str(cb, name);
-	hasbody = 0;
-	haselement = 0;
-	xc = NULL;
-	/* print attributes only */
-	while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-	    switch (xml_type(xc)){
-	    case CX_ATTR:
-		if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, -1) < 0)
-		    goto done;
-		break;
-	    case CX_BODY:
-		hasbody=1;
-		break;
-	    case CX_ELMNT:
-		haselement=1;
-		break;
-	    default:
-		break;
-	    }
-	/* Check for special case <a/> instead of <a></a> */
-	if (hasbody==0 && haselement==0) 
-	    cbuf_append_str(cb, "/>");
-	else{
-	    cbuf_append_str(cb, ">");
-	    if (prettyprint && hasbody == 0)
-		cbuf_append_str(cb, "\n");
-	    xc = NULL;
-	    while ((xc = xml_child_each(x, xc, -1)) != NULL) 
-		if (xml_type(xc) != CX_ATTR)
-		    if (clicon_xml2cbuf(cb, xc, level+1, prettyprint, depth-1) < 0)
-			goto done;
-	    if (prettyprint && hasbody == 0)
-		cprintf(cb, "%*s", level*XML_INDENT, "");
-	    cbuf_append_str(cb, "</");
-	    if (namespace){
-		cbuf_append_str(cb, namespace);
-		cbuf_append_str(cb, ":");
-	    }
-	    cbuf_append_str(cb, name);
-	    cbuf_append_str(cb, ">");
-	}
-	if (prettyprint)
-	    cbuf_append_str(cb, "\n");
-	break;
-    default:
-	break;
-    }/* switch */
- ok:
-    retval = 0;
- done:
-    return retval;
+    return xml2chunk_recurse(cb, x, level, prettyprint, depth,
+			     xml_flag(x, XML_FLAG_REPORT_ALL) != 0, 0, NULL, NULL);
 }
 
 /*! Return an xml tree as a pretty-printed malloced string.
@@ -384,6 +610,78 @@ clicon_xml2str(cxobj  *x)
     return str;
 }
 
+/*! Print an XML tree structure in bounded chunks via a callback and encode chars "<>&"
+ *
+ * Same output as clicon_xml2cbuf without prettyprint, but instead of building the
+ * whole string, the output is handed to a callback whenever chunk size is reached.
+ * Peak memory is thereby bounded by the chunk size (plus largest body) instead of
+ * the size of the serialized tree.
+ * @param[in]  x      Clicon xml tree
+ * @param[in]  depth  Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[in]  chunk  Chunk size in bytes. Callback is called with chunks of approx this size
+ * @param[in]  fn     Callback called with each chunk, see clicon_xml_chunk_cb
+ * @param[in]  arg    User argument to callback
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clicon_xml2cbuf
+ * @see send_msg_reply_xml  Send XML tree in chunks on socket
+ */
+int
+clicon_xml2chunk(cxobj               *x,
+		 int32_t              depth,
+		 size_t               chunk,
+		 clicon_xml_chunk_cb *fn,
+		 void                *arg)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if ((cb = cbuf_new_alloc(chunk?chunk+BUFLEN:BUFLEN)) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new_alloc");
+	goto done;
+    }
+    if (xml2chunk_recurse(cb, x, 0, 0, depth, xml_flag(x, XML_FLAG_REPORT_ALL) != 0,
+			  chunk, fn, arg) < 0)
+	goto done;
+    if (xml2chunk_flush(cb, 0, fn, arg) < 0) /* last chunk */
+	goto done;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Chunk callback of clicon_xml2len, only count length
+ */
+static int
+xml2len_cb(void  *arg,
+	   char  *buf,
+	   size_t len)
+{
+    *(size_t*)arg += len;
+    return 0;
+}
+
+/*! Compute the length of an XML tree serialized without prettyprint
+ *
+ * Same as strlen of the output of clicon_xml2cbuf(cb, x, 0, 0, depth) but without
+ * building the string.
+ * @param[in]  x      Clicon xml tree
+ * @param[in]  depth  Limit levels of child resources: -1 is all, 0 is none, 1 is node itself
+ * @param[out] len    Length of serialized tree
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+clicon_xml2len(cxobj   *x,
+	       int32_t  depth,
+	       size_t  *len)
+{
+    *len = 0;
+    return clicon_xml2chunk(x, depth, BUFLEN, xml2len_cb, len);
+}
+
 /*! Print actual xml tree datastructures (not xml), mainly for debugging
  * @param[in,out] cb          Cligen buffer to write to
  * @param[in]     xn          Clicon xml tree
@@ -426,6 +724,22 @@ xmltree2cbuf(cbuf  *cb,
 /*--------------------------------------------------------------------
  * XML parsing functions. Create XML parse tree from string and file.
  *--------------------------------------------------------------------*/
+/*! Sort a tree after parsing, or flag it as sorted if the input is known to be sorted
+ * @param[in]  xt        XML tree bound to yang
+ * @param[in]  presorted Input is in canonical order, eg a datastore written by clixon
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see clixon_xml_parse_file_presorted
+ */
+static int
+xml_parse_sort(cxobj *xt,
+	       int    presorted)
+{
+    if (presorted)
+	return xml_apply0(xt, CX_ELMNT, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_SORTED) < 0 ? -1 : 0;
+    return xml_sort_recurse(xt);
+}
+
 /*! Common internal xml parsing function string to parse-tree
  *
  * Given a string containing XML, parse into existing XML tree and return
@@ -454,6 +768,7 @@ static int
 _xml_parse(const char *str, 
 	   yang_bind   yb,
 	   yang_stmt  *yspec,
+	   int         presorted,
 	   cxobj      *xt,
 	   cxobj     **xerr)
 {
@@ -539,7 +854,7 @@ _xml_parse(const char *str,
     /* Sort the complete tree after parsing. Sorting is not really meaningful if Yang
        not bound */
     if (yb != YB_NONE)
-	if (xml_sort_recurse(xt) < 0)
+	if (xml_parse_sort(xt, presorted) < 0)
 	    goto done;
     retval = 1;
   done:
@@ -554,9 +869,502 @@ _xml_parse(const char *str,
     goto done;
 }
 
+/* Characters of XML names, see ncname in clixon_xml_parse.l */
+#define XML_FAST_NAMESTART(c) (((c)>='A' && (c)<='Z') || ((c)>='a' && (c)<='z') || (c)=='_')
+#define XML_FAST_NAMECHAR(c)  (XML_FAST_NAMESTART(c) || ((c)>='0' && (c)<='9') || (c)=='-' || (c)=='.')
+#define XML_FAST_WS(c)        ((c)==' ' || (c)=='\t' || (c)=='\n' || (c)=='\r')
+
+/*! Scan a qualified name: prefix:name or name, in the fast XML parser
+ *
+ * @param[in]  p      Start of name
+ * @param[in]  e      End of buffer
+ * @param[out] cbp    Prefix, if any
+ * @param[out] cbn    Name
+ * @param[out] prefix Set to 1 if prefixed
+ * @retval     p      Pointer to character after name
+ * @retval     NULL   Not a name
+ */
+static const char *
+xml_fast_qname(const char *p,
+	       const char *e,
+	       cbuf       *cbp,
+	       cbuf       *cbn,
+	       int        *prefix)
+{
+    const char *p0 = p;
+
+    *prefix = 0;
+    if (p == e || !XML_FAST_NAMESTART(*p))
+	return NULL;
+    while (++p < e && XML_FAST_NAMECHAR(*p))
+	;
+    if (p < e && *p == ':'){
+	cbuf_reset(cbp);
+	cbuf_append_buf(cbp, (void*)p0, p-p0);
+	*prefix = 1;
+	p0 = ++p;
+	if (p == e || !XML_FAST_NAMESTART(*p))
+	    return NULL;
+	while (++p < e && XML_FAST_NAMECHAR(*p))
+	    ;
+    }
+    cbuf_reset(cbn);
+    cbuf_append_buf(cbn, (void*)p0, p-p0);
+    return p;
+}
+
+/*! Append XML character data to a buffer, translating line ends and predefined entities
+ *
+ * @param[in]  cb  Buffer
+ * @param[in]  p   Start of character data
+ * @param[in]  e   End of character data
+ * @retval     1   OK
+ * @retval     0   Not supported by the fast XML parser, eg an unknown entity
+ * @see xml_chardata_encode
+ */
+static int
+xml_fast_chardata(cbuf       *cb,
+		  const char *p,
+		  const char *e)
+{
+    const char *q;
+    
+    while (p < e){
+	for (q = p; q < e && *q != '&' && *q != '\r'; q++)
+	    ;
+	if (q > p)
+	    cbuf_append_buf(cb, (void*)p, q-p);
+	if (q == e)
+	    break;
+	if (*q == '\r'){
+	    cbuf_append(cb, '\n');
+	    if (++q < e && *q == '\n')
+		q++;
+	}
+	else if (e-q >= 5 && strncmp(q, "&amp;", 5) == 0){
+	    cbuf_append(cb, '&');
+	    q += 5;
+	}
+	else if (e-q >= 4 && strncmp(q, "&lt;", 4) == 0){
+	    cbuf_append(cb, '<');
+	    q += 4;
+	}
+	else if (e-q >= 4 && strncmp(q, "&gt;", 4) == 0){
+	    cbuf_append(cb, '>');
+	    q += 4;
+	}
+	else if (e-q >= 6 && strncmp(q, "&apos;", 6) == 0){
+	    cbuf_append(cb, '\'');
+	    q += 6;
+	}
+	else if (e-q >= 6 && strncmp(q, "&quot;", 6) == 0){
+	    cbuf_append(cb, '"');
+	    q += 6;
+	}
+	else
+	    return 0;
+	p = q;
+    }
+    return 1;
+}
+
+/*! Fast XML parser of the common subset of XML, binding yang while parsing
+ *
+ * Elements, attributes, character data with predefined entities and whitespace are parsed
+ * in one scan of the buffer, using memchr to find the next tag. Yang is bound to each element
+ * at its start tag, from its parent, as xml_bind_yang0 does on the complete tree.
+ * Other XML, ie comments, processing instructions, CDATA sections and syntax errors, are
+ * not supported: then the new nodes are removed and the caller falls back to the regular
+ * parser, which also reports errors.
+ * @param[in]     str   Buffer with XML, need not be NULL-terminated
+ * @param[in]     len   Length of buffer
+ * @param[in]     yb    How to bind yang to XML top-level when parsing, not YB_RPC
+ * @param[in]     yspec Yang specification
+ * @param[in]     xt    Top of XML parse tree. Holds new tree.
+ * @param[out]    xvec  New top-level XML nodes, free after use
+ * @param[out]    xlen  Length of xvec
+ * @param[out]    xerr  Reason for failure (yang assignment not made)
+ * @retval        2     Not supported, nothing added to xt
+ * @retval        1     Parse OK and all yang assignment made
+ * @retval        0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval       -1     Error
+ * @see _xml_parse  Regular parser with same result
+ */
+static int
+xml_parse_fast(const char *str,
+	       size_t      len,
+	       yang_bind   yb,
+	       yang_stmt  *yspec,
+	       cxobj      *xt,
+	       cxobj    ***xvec,
+	       int        *xlen,
+	       cxobj     **xerr)
+{
+    int         retval = -1;
+    const char *p = str;
+    const char *e = str + len;
+    const char *q;
+    cbuf       *cbp = NULL;     /* Prefix */
+    cbuf       *cbn = NULL;     /* Name and attribute value */
+    cbuf       *cbt = NULL;     /* Character data */
+    cxobj      *xerr0;
+    cxobj      *x = xt;         /* Current element */
+    cxobj      *xc;
+    cxobj      *xa;
+    cxobj      *xs;
+    cxobj     **xsvec = NULL;   /* Yang role model of element per depth */
+    int         xsmax = 0;
+    int         depth = 0;
+    int         elem = 0;       /* Current element has element children */
+    int         prefix;
+    char        quote;
+    yang_bind   ybc;
+    int         ret;
+    int         failed = 0;
+    int         i;
+
+    xerr0 = xerr ? *xerr : NULL;
+    if ((cbp = cbuf_new()) == NULL ||
+	(cbn = cbuf_new()) == NULL ||
+	(cbt = cbuf_new()) == NULL){
+	clicon_err(OE_XML, errno, "cbuf_new");
+	goto done;
+    }
+    while (p < e){
+	/* Character data until next tag */
+	if ((q = memchr(p, '<', e-p)) == NULL)
+	    q = e;
+	if (q > p){
+	    if (depth == 0){ /* Top-level is purged, but entities are handled as regular parser */
+		if (memchr(p, '&', q-p) != NULL)
+		    goto unsupported;
+	    }
+	    else if (!elem && xml_fast_chardata(cbt, p, q) == 0)
+		goto unsupported;
+	}
+	if ((p = q) == e)
+	    break;
+	if (++p == e)
+	    goto unsupported;
+	if (*p == '!' || *p == '?') /* Comment, CDATA, processing instruction */
+	    goto unsupported;
+	if (*p == '/'){ /* End tag */
+	    if (depth == 0 ||
+		(p = xml_fast_qname(p+1, e, cbp, cbn, &prefix)) == NULL)
+		goto unsupported;
+	    while (p < e && XML_FAST_WS(*p))
+		p++;
+	    if (p == e || *p++ != '>')
+		goto unsupported;
+	    if (clicon_strcmp(xml_name(x), cbuf_get(cbn)) ||
+		clicon_strcmp(xml_prefix(x), prefix?cbuf_get(cbp):NULL))
+		goto unsupported;
+	    if (!elem && cbuf_len(cbt)){
+		if ((xc = xml_new("body", x, CX_BODY)) == NULL)
+		    goto done;
+		if (xml_value_set(xc, cbuf_get(cbt)) < 0)
+		    goto done;
+	    }
+	    cbuf_reset(cbt);
+	    if (yb != YB_NONE && xml_bind_yang_parse_done(x) < 0)
+		goto done;
+	    x = xml_parent(x);
+	    depth--;
+	    elem = 1;
+	    continue;
+	}
+	/* Start tag */
+	if ((p = xml_fast_qname(p, e, cbp, cbn, &prefix)) == NULL)
+	    goto unsupported;
+	if ((xc = xml_new(cbuf_get(cbn), x, CX_ELMNT)) == NULL)
+	    goto done;
+	if (prefix && xml_prefix_set(xc, cbuf_get(cbp)) < 0)
+	    goto done;
+	if (x == xt && cxvec_append(xc, xvec, xlen) < 0)
+	    goto done;
+	cbuf_reset(cbt);
+	while (1){ /* Attributes */
+	    while (p < e && XML_FAST_WS(*p))
+		p++;
+	    if (p == e)
+		goto unsupported;
+	    if (*p == '>' || *p == '/')
+		break;
+	    if ((p = xml_fast_qname(p, e, cbp, cbn, &prefix)) == NULL)
+		goto unsupported;
+	    while (p < e && XML_FAST_WS(*p))
+		p++;
+	    if (p == e || *p++ != '=')
+		goto unsupported;
+	    while (p < e && XML_FAST_WS(*p))
+		p++;
+	    if (p == e || (*p != '"' && *p != '\''))
+		goto unsupported;
+	    quote = *p++;
+	    if ((q = memchr(p, quote, e-p)) == NULL)
+		goto unsupported;
+	    if ((xa = xml_find_type(xc, prefix?cbuf_get(cbp):NULL, cbuf_get(cbn), CX_ATTR)) == NULL){
+		if ((xa = xml_new(cbuf_get(cbn), xc, CX_ATTR)) == NULL)
+		    goto done;
+		if (prefix && xml_prefix_set(xa, cbuf_get(cbp)) < 0)
+		    goto done;
+	    }
+	    cbuf_reset(cbn);
+	    cbuf_append_buf(cbn, (void*)p, q-p);
+	    if (xml_value_set(xa, cbuf_get(cbn)) < 0)
+		goto done;
+	    p = q + 1;
+	}
+	/* Bind yang as xml_bind_yang0 from module at top or from parent below */
+	ybc = YB_NONE;
+	switch (yb){
+	case YB_MODULE:
+	    ybc = depth==0 ? YB_MODULE : YB_PARENT;
+	    break;
+	case YB_MODULE_NEXT:
+	    ybc = depth==0 ? YB_NONE : depth==1 ? YB_MODULE : YB_PARENT;
+	    break;
+	case YB_PARENT:
+	    ybc = YB_PARENT;
+	    break;
+	default:
+	    break;
+	}
+	if (ybc == YB_PARENT && x != xt && xml_spec(x) == NULL)
+	    ybc = YB_NONE; /* Parent not bound or anyxml */
+	if (depth+1 >= xsmax){
+	    xsmax = xsmax ? 2*xsmax : 16;
+	    if ((xsvec = realloc(xsvec, xsmax*sizeof(cxobj*))) == NULL){
+		clicon_err(OE_XML, errno, "realloc");
+		goto done;
+	    }
+	}
+	xs = NULL;
+	if (ybc == YB_PARENT && x != xt){
+	    /* Role model: previous sibling with same name, or child of role model of parent */
+	    if ((i = xml_child_nr(x)) > 1 &&
+		(xs = xml_child_i(x, i-2)) != NULL &&
+		(xml_type(xs) != CX_ELMNT ||
+		 xml_spec(xs) == NULL ||
+		 clicon_strcmp(xml_name(xs), xml_name(xc)) ||
+		 clicon_strcmp(xml_prefix(xs), xml_prefix(xc))))
+		xs = NULL;
+	    if (xs == NULL && xsvec[depth])
+		xs = xml_find_type(xsvec[depth], xml_prefix(xc), xml_name(xc), CX_ELMNT);
+	}
+	xsvec[depth+1] = xs;
+	if (ybc != YB_NONE){
+	    if ((ret = xml_bind_yang_parse(xc, ybc, xs, yspec, xerr)) < 0)
+		goto done;
+	    if (ret == 0)
+		failed++;
+	}
+	if (*p == '/'){ /* Empty element */
+	    if (++p == e || *p++ != '>')
+		goto unsupported;
+	    if (yb != YB_NONE && xml_bind_yang_parse_done(xc) < 0)
+		goto done;
+	    elem = 1;
+	}
+	else {
+	    p++;
+	    x = xc;
+	    depth++;
+	    elem = 0;
+	}
+    }
+    if (depth != 0)
+	goto unsupported;
+    retval = failed ? 0 : 1;
+ done:
+    if (cbp)
+	cbuf_free(cbp);
+    if (cbn)
+	cbuf_free(cbn);
+    if (cbt)
+	cbuf_free(cbt);
+    if (xsvec)
+	free(xsvec);
+    return retval;
+ unsupported:
+    for (i = 0; i < *xlen; i++)
+	xml_purge((*xvec)[i]);
+    *xlen = 0;
+    if (xerr && *xerr != xerr0){
+	xml_free(*xerr);
+	*xerr = xerr0;
+    }
+    retval = 2;
+    goto done;
+}
+
+/*! Parse XML from buffer into existing XML tree, using fast parser if possible
+ *
+ * @param[in]     str   Buffer with XML, need not be NULL-terminated
+ * @param[in]     len   Length of buffer
+ * @param[in]     yb    How to bind yang to XML top-level when parsing
+ * @param[in]     yspec Yang specification
+ * @param[in,out] xt    Top of XML parse tree. Assume created. Holds new tree.
+ * @param[out]    xerr  Reason for failure (yang assignment not made)
+ * @retval        1     Parse OK and all yang assignment made
+ * @retval        0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval       -1     Error with clicon_err called. Includes parse error
+ * @see _xml_parse
+ */
+static int 
+_xml_parse_buf(const char *str, 
+	       size_t      len,
+	       yang_bind   yb,
+	       yang_stmt  *yspec,
+	       int         presorted,
+	       cxobj      *xt,
+	       cxobj     **xerr)
+{
+    int     retval = -1;
+    char   *str0 = NULL;
+    cxobj **xvec = NULL;
+    int     xlen = 0;
+    int     ret = 2;
+    int     i;
+
+    if (len == 0)
+	return 1; /* OK */
+    if (yb != YB_RPC &&
+	(ret = xml_parse_fast(str, len, yb, yspec, xt, &xvec, &xlen, xerr)) < 0)
+	goto done;
+    if (ret == 2){ /* Not supported by fast parser */
+	if ((str0 = malloc(len+1)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    goto done;
+	}
+	memcpy(str0, str, len);
+	str0[len] = '\0';
+	retval = _xml_parse(str0, yb, yspec, presorted, xt, xerr);
+	goto done;
+    }
+    /* Verify namespaces after parsing */
+    for (i = 0; i < xlen; i++)
+	if (xml2ns_recurse(xvec[i]) < 0)
+	    goto done;
+    if (ret == 0)
+	goto fail;
+    if (yb != YB_NONE)
+	if (xml_parse_sort(xt, presorted) < 0)
+	    goto done;
+    retval = 1;
+ done:
+    if (str0)
+	free(str0);
+    if (xvec)
+	free(xvec);
+    return retval; 
+ fail: /* invalid */
+    retval = 0;
+    goto done;
+}
+
+/*! Read an XML file and parse it into a parse-tree, internal function
+ * @param[in]     fp        A file containing the XML file (as ASCII characters)
+ * @param[in]     yb        How to bind yang to XML top-level when parsing
+ * @param[in]     yspec     Yang specification (only if bind is TOP or CONFIG)
+ * @param[in]     presorted XML is in canonical order, do not verify and sort
+ * @param[in,out] xt        Pointer to XML parse tree. If empty, create.
+ * @param[out]    xerr      Pointer to XML error tree, if retval is 0
+ * @retval        1         Parse OK and all yang assignment made
+ * @retval        0         Parse OK but yang assigment not made (or only partial)
+ * @retval       -1         Error with clicon_err called. Includes parse error
+ * @see clixon_xml_parse_file
+ */
+static int 
+_xml_parse_file(FILE      *fp, 
+		yang_bind  yb,
+		yang_stmt *yspec,
+		int        presorted,
+		cxobj    **xt,
+		cxobj    **xerr)
+{
+    int         retval = -1;
+    int         ret;
+    struct stat st;
+    long        pos;
+    char       *map = NULL;    /* Regular file is mapped */
+    size_t      maplen = 0;
+    char       *xmlbuf = NULL; /* Other files are read */
+    size_t      xmlbuflen = BUFLEN; /* start size */
+    size_t      len = 0;
+    size_t      n;
+    const char *str;
+
+    if (xt==NULL){
+	clicon_err(OE_XML, EINVAL, "xt is NULL");
+	return -1;
+    }
+    if (yb == YB_MODULE && yspec == NULL){
+	clicon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
+	return -1;
+    }
+    if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) &&
+	(pos = ftell(fp)) >= 0 && pos < st.st_size){
+	maplen = st.st_size;
+	if ((map = mmap(NULL, maplen, PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED)
+	    map = NULL;
+	else {
+	    (void)madvise(map, maplen, MADV_SEQUENTIAL);
+	    str = map + pos;
+	    len = maplen - pos;
+	    fseek(fp, 0, SEEK_END); /* As if read */
+	}
+    }
+    if (map == NULL){
+	if ((xmlbuf = malloc(xmlbuflen)) == NULL){
+	    clicon_err(OE_XML, errno, "malloc");
+	    goto done;
+	}
+	while ((n = fread(xmlbuf+len, 1, xmlbuflen-len-1, fp)) > 0){ /* Space: one for the null character */
+	    len += n;
+	    if (len >= xmlbuflen-1){
+		xmlbuflen *= 2;
+		if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
+		    clicon_err(OE_XML, errno, "realloc");
+		    goto done;
+		}
+	    }
+	}
+	if (ferror(fp)){
+	    clicon_err(OE_XML, errno, "read");
+	    goto done;
+	}
+	xmlbuf[len] = '\0';
+	str = xmlbuf;
+    }
+    xml_arena_begin(); /* Allocate nodes of parsed tree from arena blocks */
+    if (*xt == NULL &&
+	(*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+	ret = -1;
+    else
+	ret = _xml_parse_buf(str, len, yb, yspec, presorted, *xt, xerr);
+    xml_arena_end();
+    if (ret < 0)
+	goto done;
+    retval = ret;
+ done:
+    if (retval < 0 && *xt){
+	xml_free(*xt);
+	*xt = NULL;
+    }
+    if (map)
+	munmap(map, maplen);
+    if (xmlbuf)
+	free(xmlbuf);
+    return retval;
+}
+
 /*! Read an XML definition from file and parse it into a parse-tree, advanced API
  *
- * @param[in]     fd    A file descriptor containing the XML file (as ASCII characters)
+ * A regular file is mapped in memory, other files are read. The file is parsed by a fast
+ * parser that binds yang while parsing, or by the regular parser if the XML is not supported
+ * by the fast parser. Both give the same XML tree.
+ * @param[in]     fp    A file containing the XML file (as ASCII characters)
  * @param[in]     yb    How to bind yang to XML top-level when parsing
  * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
  * @param[in,out] xt    Pointer to XML parse tree. If empty, create.
@@ -587,68 +1395,32 @@ clixon_xml_parse_file(FILE      *fp,
 		      cxobj    **xt,
 		      cxobj    **xerr)
 {
-    int   retval = -1;
-    int   ret;
-    int   len = 0;
-    char  ch;
-    char *xmlbuf = NULL;
-    char *ptr;
-    int   xmlbuflen = BUFLEN; /* start size */
-    int   oldxmlbuflen;
-    int   failed = 0;
+    return _xml_parse_file(fp, yb, yspec, 0, xt, xerr);
+}
 
-    if (xt==NULL){
-	clicon_err(OE_XML, EINVAL, "xt is NULL");
-	return -1;
-    }
-    if (yb == YB_MODULE && yspec == NULL){
-	clicon_err(OE_XML, EINVAL, "yspec is required if yb == YB_MODULE");
-	return -1;
-    }
-    if ((xmlbuf = malloc(xmlbuflen)) == NULL){
-	clicon_err(OE_XML, errno, "malloc");
-	goto done;
-    }
-    memset(xmlbuf, 0, xmlbuflen);
-    ptr = xmlbuf;
-    while (1){
-	if ((ret = fread(&ch, 1, 1, fp)) < 0){
-	    clicon_err(OE_XML, errno, "read");
-	    break;
-	}
-	if (ret != 0){
-	    xmlbuf[len++] = ch;
-	}
-	if (ret == 0) {
-	    if (*xt == NULL)
-		if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
-		    goto done;
-	    if ((ret = _xml_parse(ptr, yb, yspec, *xt, xerr)) < 0)
-		goto done;
-	    if (ret == 0)
-		failed++;
-	    break;
-	}
-	if (len >= xmlbuflen-1){ /* Space: one for the null character */
-	    oldxmlbuflen = xmlbuflen;
-	    xmlbuflen *= 2;
-	    if ((xmlbuf = realloc(xmlbuf, xmlbuflen)) == NULL){
-		clicon_err(OE_XML, errno, "realloc");
-		goto done;
-	    }
-	    memset(xmlbuf+oldxmlbuflen, 0, xmlbuflen-oldxmlbuflen);
-	    ptr = xmlbuf;
-	}
-    } /* while */
-    retval = (failed==0) ? 1 : 0;
- done:
-    if (retval < 0 && *xt){
-	free(*xt);
-	*xt = NULL;
-    }
-    if (xmlbuf)
-	free(xmlbuf);
-    return retval;
+/*! Read an XML file in canonical order and parse it into a parse-tree
+ *
+ * As clixon_xml_parse_file but the XML is known to be sorted, eg a datastore file written
+ * by clixon. The parsed tree is flagged as sorted instead of verified and sorted.
+ * @param[in]     fp    A file containing the XML file (as ASCII characters)
+ * @param[in]     yb    How to bind yang to XML top-level when parsing
+ * @param[in]     yspec Yang specification (only if bind is TOP or CONFIG)
+ * @param[in,out] xt    Pointer to XML parse tree. If empty, create.
+ * @param[out]    xerr  Pointer to XML error tree, if retval is 0
+ * @retval        1     Parse OK and all yang assignment made
+ * @retval        0     Parse OK but yang assigment not made (or only partial) and xerr set
+ * @retval       -1     Error with clicon_err called. Includes parse error
+ * @note If the XML is not sorted, searches in the tree may fail
+ * @see clixon_xml_parse_file
+ */
+int 
+clixon_xml_parse_file_presorted(FILE      *fp, 
+				yang_bind  yb,
+				yang_stmt *yspec,
+				cxobj    **xt,
+				cxobj    **xerr)
+{
+    return _xml_parse_file(fp, yb, yspec, 1, xt, xerr);
 }
 
 /*! Read an XML definition from string and parse it into a parse-tree, advanced API
@@ -694,7 +1466,7 @@ clixon_xml_parse_string(const char *str,
 	if ((*xt = xml_new(XML_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
 	    return -1;
     }
-    return _xml_parse(str, yb, yspec, *xt, xerr);
+    return _xml_parse(str, yb, yspec, 0, *xt, xerr);
 }
 
 /*! Read XML from var-arg list and parse it into xml tree
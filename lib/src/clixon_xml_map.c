@@ -521,6 +521,35 @@ cvec2xml_1(cvec   *cvv,
     return retval;
 }
 
+/*! Compare two sibling XML nodes of the merge-join in xml_diff1
+ *
+ * Same as xml_cmp(x0, x1, 0, 0, NULL) but without key lookups for nodes with the same
+ * yang spec that are not lists or leaf-lists, eg containers and leafs, which are
+ * single instance and therefore equal
+ * @param[in]  x0  Child of first XML tree
+ * @param[in]  x1  Child of second XML tree
+ * @retval     0   Equal (structurally), values may differ
+ * @retval    <0   x0 before x1
+ * @retval    >0   x0 after x1
+ */
+static int
+xml_diff_cmp(cxobj *x0,
+	     cxobj *x1)
+{
+    yang_stmt *y0;
+
+    if ((y0 = xml_spec(x0)) != NULL && y0 == xml_spec(x1)){
+	switch (yang_keyword_get(y0)){
+	case Y_LIST:
+	case Y_LEAF_LIST:
+	    break;
+	default:
+	    return 0;
+	}
+    }
+    return xml_cmp(x0, x1, 0, 0, NULL);
+}
+
 /*! Recursive help function to compute differences between two xml trees
  * @param[in]  x0         First XML tree
  * @param[in]  x1         Second XML tree
@@ -543,6 +572,9 @@ cvec2xml_1(cvec   *cvv,
  * (*) "comparing" a&b here is made by xml_cmp() which judges equality from a structural
  *     perspective, ie both have the same yang spec, if they are lists, they have the
  *     the same keys. NOT that the values are equal!
+ * This is a merge-join of the sorted children, ie linear in the number of children.
+ * Identical subtrees, shared or with equal hashes (see xml_hash), are skipped, see
+ * xml_diff_cmp for the comparison.
  * @see xml_diff  API function, this one is internal and recursive
  */
 static int
@@ -559,42 +591,53 @@ xml_diff1(cxobj     *x0,
     int        retval = -1;
     cxobj     *x0c = NULL; /* x0 child */
     cxobj     *x1c = NULL; /* x1 child */
+    clixon_xml_iter it0;
+    clixon_xml_iter it1;
     yang_stmt *yc;
     char      *b1;
     char      *b2;
     int        eq;
 
+    /* Same tree, eg datastore caches shared after copy */
+    if (x0 == x1)
+	goto ok;
+#ifdef XML_SUBTREE_HASH
+    /* Identical subtrees */
+    if (xml_hash(x0) == xml_hash(x1))
+	goto ok;
+#endif
     /* Traverse x0 and x1 in lock-step */
-    x0c = x1c = NULL;    
-    x0c = xml_child_each(x0, x0c, CX_ELMNT);
-    x1c = xml_child_each(x1, x1c, CX_ELMNT);
+    xml_child_iter_init(&it0, x0, CX_ELMNT);
+    xml_child_iter_init(&it1, x1, CX_ELMNT);
+    x0c = xml_child_iter_next(&it0);
+    x1c = xml_child_iter_next(&it1);
     for (;;){
 	if (x0c == NULL && x1c == NULL)
 	    goto ok;
 	else if (x0c == NULL){
 	    if (cxvec_append(x1c, x1vec, x1veclen) < 0) 
 		goto done;
-	    x1c = xml_child_each(x1, x1c, CX_ELMNT);
+	    x1c = xml_child_iter_next(&it1);
 	    continue;
 	}
 	else if (x1c == NULL){
 	    if (cxvec_append(x0c, x0vec, x0veclen) < 0) 
 		goto done;
-	    x0c = xml_child_each(x0, x0c, CX_ELMNT);
+	    x0c = xml_child_iter_next(&it0);
 	    continue;
 	}
 	/* Both x0c and x1c exists, check if they are yang-equal. */
-	eq = xml_cmp(x0c, x1c, 0, 0, NULL);
+	eq = xml_diff_cmp(x0c, x1c);
 	if (eq < 0){
 	    if (cxvec_append(x0c, x0vec, x0veclen) < 0) 
 		goto done;
-	    x0c = xml_child_each(x0, x0c, CX_ELMNT);
+	    x0c = xml_child_iter_next(&it0);
 	    continue;
 	}
 	else if (eq > 0){
 	    if (cxvec_append(x1c, x1vec, x1veclen) < 0) 
 		goto done;
-	    x1c = xml_child_each(x1, x1c, CX_ELMNT);
+	    x1c = xml_child_iter_next(&it1);
 	    continue;
 	}
 	else{ /* equal */
@@ -606,7 +649,7 @@ xml_diff1(cxobj     *x0,
 		/* if x0c and x1c are leafs w bodies, then they may be changed */
 		b1 = xml_body(x0c);
 		b2 = xml_body(x1c);
-		if (b1 == NULL && b2 == NULL)
+		if (b1 == b2) /* Also shared values, see xml_value_intern */
 		    ;
 		else if (b1 == NULL || b2 == NULL || strcmp(b1, b2) != 0){
 		    if (cxvec_append(x0c, changed_x0, changedlen) < 0) 
@@ -622,8 +665,8 @@ xml_diff1(cxobj     *x0,
 			       changed_x0, changed_x1, changedlen)< 0)
 		goto done;
 	}
-	x0c = xml_child_each(x0, x0c, CX_ELMNT);
-	x1c = xml_child_each(x1, x1c, CX_ELMNT);
+	x0c = xml_child_iter_next(&it0);
+	x1c = xml_child_iter_next(&it1);
     }
  ok:
     retval = 0;
@@ -669,7 +712,7 @@ xml_diff(yang_stmt *yspec,
 	goto ok;
     }
     if (x0 == NULL){
-	if (cxvec_append(x0, second, secondlen) < 0) 
+	if (cxvec_append(x1, second, secondlen) < 0) 
 	    goto done;
 	goto ok;
     }
@@ -684,6 +727,66 @@ xml_diff(yang_stmt *yspec,
     return retval;
 }
 
+/* Argument of xml_tree_prune_flagged_sub_fn and xml_tree_prune_flagged_fn */
+struct prune_arg{
+    int        pa_flag;   /* Which flag to test for */
+    int        pa_test;   /* 1: test that flag is set, 0: test that flag is not set */
+    yang_stmt *pa_yt;     /* Yang of parent, or NULL */
+    int        pa_mark;   /* Number of children passing test or with marked descendants */
+    int        pa_anykey; /* Number of key children */
+};
+
+/*! Test a child for xml_tree_prune_flagged_sub: remove if no (grand*)child is marked
+ * Keys are not removed here, see second round of xml_tree_prune_flagged_sub
+ */
+static int
+xml_tree_prune_flagged_sub_fn(cxobj *x,
+			      void  *arg)
+{
+    struct prune_arg *pa = (struct prune_arg *)arg;
+    int               iskey;
+    int               submark;
+
+    if (xml_type(x) != CX_ELMNT)
+	return 0;
+    if (xml_flag(x, pa->pa_flag) == pa->pa_test?pa->pa_flag:0){
+	/* Pass test */
+	pa->pa_mark++;
+	return 0; /* mark and stop here */
+    }
+    /* If it is key dont remove it yet (see second round) */
+    if (pa->pa_yt){
+	if ((iskey = yang_key_match(pa->pa_yt, xml_name(x))) < 0)
+	    return -1;
+	if (iskey){
+	    pa->pa_anykey++;
+	    return 0; /* skip if this is key */
+	}
+    }
+    if (xml_tree_prune_flagged_sub(x, pa->pa_flag, pa->pa_test, &submark) < 0)
+	return -1;
+    /* if xt is list and submark anywhere, then key subs are also marked
+     */
+    if (submark){
+	pa->pa_mark++;
+	return 0;
+    }
+    return 1;
+}
+
+/*! Test a child for second round of xml_tree_prune_flagged_sub: remove keys
+ */
+static int
+xml_tree_prune_flagged_key_fn(cxobj *x,
+			      void  *arg)
+{
+    struct prune_arg *pa = (struct prune_arg *)arg;
+
+    if (xml_type(x) != CX_ELMNT)
+	return 0;
+    return yang_key_match(pa->pa_yt, xml_name(x));
+}
+
 /*! Prune everything that does not pass test or have at least a child* does not
  * @param[in]   xt      XML tree with some node marked
  * @param[in]   flag    Which flag to test for
@@ -692,181 +795,62 @@ xml_diff(yang_stmt *yspec,
  * The function removes all branches that does not pass the test
  * Purge all nodes that dont have MARK flag set recursively.
  * Save all nodes that is MARK:ed or have at least one (grand*)child that is MARKed
+ * Children are removed in one pass of each node, see xml_purge_children
  * @code
  *    xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL);
  * @endcode
  * @note This function seems a little too complex semantics
  * @see xml_tree_prune_flagged for a simpler variant
  */
-#if 1
 int
 xml_tree_prune_flagged_sub(cxobj *xt, 
 			   int    flag,
 			   int    test,
 			   int   *upmark)
 {
-    int        retval = -1;
-    int        submark;
-    int        mark;
-    cxobj     *x;
-    cxobj     *xprev;
-    int        iskey;
-    int        anykey=0;
-    yang_stmt *yt;
+    int              retval = -1;
+    struct prune_arg pa = {0,};
 
-    mark = 0;
-    yt = xml_spec(xt); /* xan be null */
-    x = NULL;
-    xprev = x = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-	if (xml_flag(x, flag) == test?flag:0){
-	    /* Pass test */
-	    mark++;
-	    xprev = x;
-	    continue; /* mark and stop here */
-	}
-	/* If it is key dont remove it yet (see second round) */
-	if (yt){
-	    if ((iskey = yang_key_match(yt, xml_name(x))) < 0)
-		goto done;
-	    if (iskey){
-		anykey++;
-		xprev = x; /* skip if this is key */
-		continue;
-	    }
-	}
-	if (xml_tree_prune_flagged_sub(x, flag, test, &submark) < 0)
-	    goto done;
-	/* if xt is list and submark anywhere, then key subs are also marked
-	 */
-	if (submark)
-	    mark++;
-	else{ /* Safe with xml_child_each if last */
-	    if (xml_purge(x) < 0)
-		goto done;
-	    x = xprev;
-	}
-	xprev = x;
-    }
+    pa.pa_flag = flag;
+    pa.pa_test = test;
+    pa.pa_yt = xml_spec(xt); /* xan be null */
+    if (xml_purge_children(xt, xml_tree_prune_flagged_sub_fn, &pa) < 0)
+	goto done;
     /* Second round: if any keys were found, and no marks detected, purge now */
-    if (anykey && !mark){
-	x = NULL;
-	xprev = x = NULL;
-	while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-	    /* If it is key remove it here */
-	    if (yt){
-		if ((iskey = yang_key_match(yt, xml_name(x))) < 0)
-		    goto done;
-		if (iskey && xml_purge(x) < 0)
-		    goto done;
-		x = xprev;
-	    }
-	    xprev = x; 
-	}
+    if (pa.pa_anykey && !pa.pa_mark){
+	if (xml_purge_children(xt, xml_tree_prune_flagged_key_fn, &pa) < 0)
+	    goto done;
     }
     retval = 0;
  done:
     if (upmark)
-	*upmark = mark;
+	*upmark = pa.pa_mark;
     return retval;
 }
-#else
-/* This is optimized in the sense that xml_purge is replaced with xml_child_rm but it leaks memory,
- * in poarticualr attributes and namespace caches
+
+/*! Test a child for xml_tree_prune_flagged: remove if it passes test, else prune it
  */
-int
-xml_tree_prune_flagged_sub(cxobj *xt, 
-			   int    flag,
-			   int    test,
-			   int   *upmark)
+static int
+xml_tree_prune_flagged_fn(cxobj *x,
+			  void  *arg)
 {
-    int        retval = -1;
-    int        submark;
-    int        mark;
-    cxobj     *x;
-    cxobj     *xprev;
-    int        iskey;
-    int        anykey=0;
-    yang_stmt *yt;
-    int        i;
+    struct prune_arg *pa = (struct prune_arg *)arg;
 
-    mark = 0;
-    yt = xml_spec(xt); /* xan be null */
-    x = NULL;
-    xprev = x = NULL;
-    i = 0;
-    while ((x = xml_child_each(xt, x, -1)) != NULL) {
-	i++;
-	if (xml_type(x) != CX_ELMNT){
-	    xprev = x;
-	    continue;
-	}
-	if (xml_flag(x, flag) == test?flag:0){
-	    /* Pass test */
-	    mark++;
-	    xprev = x;
-	    continue; /* mark and stop here */
-	}
-	/* If it is key dont remove it yet (see second round) */
-	if (yt){
-	    if ((iskey = yang_key_match(yt, xml_name(x))) < 0)
-		goto done;
-	    if (iskey){
-		anykey++;
-		xprev = x; /* skip if this is key */
-		continue;
-	    }
-	}
-	if (xml_tree_prune_flagged_sub(x, flag, test, &submark) < 0)
-	    goto done;
-	/* if xt is list and submark anywhere, then key subs are also marked
-	 */
-	if (submark)
-	    mark++;
-	else{ /* Safe with xml_child_each if last */
-	    if (xml_child_rm(xt, i-1) < 0)
-		goto done;
-	    i--;
-	    x = xprev;
-	}
-	xprev = x;
-    }
-    /* Second round: if any keys were found, and no marks detected, purge now */
-    if (anykey && !mark){
-	x = NULL;
-	xprev = x = NULL;
-	i = 0;
-	while ((x = xml_child_each(xt, x, -1)) != NULL) {
-	    i++;
-	    if (xml_type(x) != CX_ELMNT){
-		xprev = x;
-		continue;
-	    }
-	    /* If it is key remove it here */
-	    if (yt){
-		if ((iskey = yang_key_match(yt, xml_name(x))) < 0)
-		    goto done;
-		if (xml_child_rm(xt, i-1) < 0)
-		    goto done;
-		i--;
-		x = xprev;
-	    }
-	    xprev = x; 
-	}
-    }
-    retval = 0;
- done:
-    if (upmark)
-	*upmark = mark;
-    return retval;
+    if (xml_type(x) != CX_ELMNT)
+	return 0;
+    if (xml_flag(x, pa->pa_flag) == (pa->pa_test?pa->pa_flag:0)) /* Pass test means purge */
+	return 1;
+    if (xml_tree_prune_flagged(x, pa->pa_flag, pa->pa_test) < 0)
+	return -1;
+    return 0;
 }
-#endif
 
 /*! Prune everything that passes test
  * @param[in]   xt      XML tree with some node marked
  * @param[in]   flag    Which flag to test for
  * @param[in]   test    1: test that flag is set, 0: test that flag is not set
  * The function removes all branches that does not pass test
+ * Children are removed in one pass of each node, see xml_purge_children
  * @code
  *    xml_tree_prune_flagged(xt, XML_FLAG_MARK, 1);
  * @endcode
@@ -876,26 +860,11 @@ xml_tree_prune_flagged(cxobj *xt,
 		       int    flag,
 		       int    test)
 {
-    int        retval = -1;
-    cxobj     *x;
-    cxobj     *xprev;
+    struct prune_arg pa = {0,};
 
-    x = NULL;
-    xprev = NULL;
-    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-	if (xml_flag(x, flag) == (test?flag:0)){ 	/* Pass test means purge */
-	    if (xml_purge(x) < 0)
-		goto done;
-	    x = xprev;
-	    continue; 
-	}
-	if (xml_tree_prune_flagged(x, flag, test) < 0)
-	    goto done;
-	xprev = x;
-    }
-    retval = 0;
- done:
-    return retval;
+    pa.pa_flag = flag;
+    pa.pa_test = test;
+    return xml_purge_children(xt, xml_tree_prune_flagged_fn, &pa);
 }
 
 /*! Add prefix:namespace pair to xml node, set cache, etc
@@ -962,6 +931,9 @@ xml_namespace_change(cxobj *x,
        goto done;
     if (ns0 && strcmp(ns0, ns) == 0)
 	goto ok; /* Already has right namespace */ 
+    /* Node is not in the namespace of its yang module anymore, rebind after change */
+    if (xml_spec(x) != NULL)
+	xml_spec_set(x, NULL);
     /* Is namespace already declared? */
     if (xml2prefix(x, ns, &prefix0) == 1){
        /* Yes it is declared and the prefix is prefix0 */
@@ -1233,10 +1205,12 @@ xml_default(cxobj *xt,
 }
 
 /*! Recursively fill in default values in an XML tree
+ * Sub-trees whose yang has no leaf with default value are not traversed
  * @param[in]   xt      XML tree
  * @param[in]   state   If set expand defaults also for state data, otherwise only config
  * @retval      0       OK
  * @retval      -1      Error
+ * @see YANG_FLAG_DEFAULT
  */
 int
 xml_default_recurse(cxobj *xn,
@@ -1253,6 +1227,8 @@ xml_default_recurse(cxobj *xn,
 	if ((y = (yang_stmt*)xml_spec(x)) != NULL){
 	    if (!state && !yang_config(y))
 		continue;
+	    if (!yang_flag_get(y, YANG_FLAG_DEFAULT))
+		continue;
 	}
 	if (xml_default_recurse(x, state) < 0)
 	    goto done;
@@ -1262,6 +1238,84 @@ xml_default_recurse(cxobj *xn,
     return retval;
 }
 
+/*! Get next yang child of an XML node with a default value that is not in the XML tree
+ *
+ * Used to print default values when the tree is serialized, instead of adding them to the
+ * tree, see XML_FLAG_REPORT_ALL. Yang children are returned in yang order, ie the order of
+ * the children of a sorted XML node. A leaf with a default value, or a non-presence
+ * container that xml_default_recurse would create, is returned if there is no XML child
+ * with the same name.
+ * @param[in]     ys     Yang spec of XML node
+ * @param[in]     x      XML node, or NULL if the node itself is not in the tree
+ * @param[in]     state  If set also state data, otherwise only config
+ * @param[in,out] ycp    In: previous yang child, or NULL for first. Out: next, or NULL
+ * @retval        0      OK
+ * @retval       -1      Error
+ * @code
+ *   yang_stmt *yc = NULL;
+ *   do {
+ *      if (xml_default_next(ys, x, 1, &yc) < 0)
+ *         err;
+ *      if (yc)
+ *         print default of yc
+ *   } while (yc);
+ * @endcode
+ * @see xml_default1  Adds the same default values to the tree
+ */
+int
+xml_default_next(yang_stmt  *ys,
+		 cxobj      *x,
+		 int         state,
+		 yang_stmt **ycp)
+{
+    int        retval = -1;
+    yang_stmt *yc = *ycp;
+    int        create;
+
+    *ycp = NULL;
+    if (!yang_flag_get(ys, YANG_FLAG_DEFAULT))
+	goto ok;
+    switch (yang_keyword_get(ys)){
+    case Y_CONTAINER:
+    case Y_LIST:
+    case Y_INPUT:
+    case Y_OUTPUT:
+	break;
+    default:
+	goto ok;
+    }
+    while ((yc = yn_each(ys, yc)) != NULL) {
+	if (!state && !yang_config(yc)) 
+	    continue;
+	switch (yang_keyword_get(yc)){
+	case Y_LEAF:
+	    if (cv_flag(yang_cv_get(yc), V_UNSET))
+		continue;
+	    break;
+	case Y_CONTAINER:
+	    if (yang_find(yc, Y_PRESENCE, NULL) != NULL ||
+		!yang_flag_get(yc, YANG_FLAG_DEFAULT))
+		continue;
+	    if (xml_nopresence_try(yc, &create) < 0)
+		goto done;
+	    if (!create)
+		continue;
+	    break;
+	default:
+	    continue;
+	}
+	if (x == NULL ||
+	    xml_find_type(x, NULL, yang_argument_get(yc), CX_ELMNT) == NULL){
+	    *ycp = yc;
+	    break;
+	}
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Expand and set default values of global top-level on XML tree
  *
  * Not recursive, except in one case with one or several non-presence containers
@@ -1318,9 +1372,7 @@ xml_global_defaults(clicon_handle h,
     cxobj     *xcache = NULL;
     cxobj     *xpart = NULL;
     cxobj    **xvec = NULL;
-    size_t     xlen;
-    int        i;
-    cxobj     *x0;
+    size_t     xlen = 0;
     int        ret;
     char      *key;
     
@@ -1347,20 +1399,12 @@ xml_global_defaults(clicon_handle h,
     /* Iterate through match vector
      * For every node found in x0, mark the tree up to t1
      */
-    for (i=0; i<xlen; i++){
-	x0 = xvec[i];
-	xml_flag_set(x0, XML_FLAG_MARK);
-	xml_apply_ancestor(x0, (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
-    }
+    xml_copy_mark(xvec, xlen);
     /* Create a new tree and copy over the parts from the cache that matches xpath */
     if ((xpart = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
 	goto done;
     if (xml_copy_marked(xcache, xpart) < 0) /* config */
 	goto done;
-    if (xml_apply(xcache, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
-	goto done;
-    if (xml_apply(xpart, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE)) < 0)
-	goto done;
     /* Merge global pruned tree with xt */
     if ((ret = xml_merge(xt, xpart, yspec, NULL)) < 1) /* XXX reason */
 	goto done;
@@ -1368,8 +1412,11 @@ xml_global_defaults(clicon_handle h,
  done:
     if (xpart)
 	xml_free(xpart);
-    if (xvec)
+    if (xvec){
+	/* Marks are not copied, reset in cache only, see xml_copy_one */
+	xml_copy_mark_reset(xvec, xlen);
 	free(xvec);
+    }
     return retval;
 }
 
@@ -1519,10 +1566,24 @@ xml2xpath1(cxobj *x,
     cxobj        *xb;
     char         *b;
     enum rfc_6020 keyword;
+#ifdef XML_PATH_CACHE
+    int           ret;
+    size_t        start;
+    char         *path;
+#endif
     
     if ((xp = xml_parent(x)) == NULL)
 	goto ok;
+#ifdef XML_PATH_CACHE
+    if ((path = xml_path_cache_get(x, XML_PATH_XPATH)) != NULL){
+	cprintf(cb, "%s", path);
+	goto ok;
+    }
+    start = cbuf_len(cb);
+    ret = xml2xpath1(xp, cb);
+#else
     xml2xpath1(xp, cb);
+#endif
     /* XXX: sometimes there should be a /, sometimes not */
     cprintf(cb, "/%s", xml_name(x));
     if ((y = xml_spec(x)) != NULL){
@@ -1546,6 +1607,12 @@ xml2xpath1(cxobj *x,
 		b = xml_body(xb);
 		cprintf(cb, "[%s=\"%s\"]", keyname, b?b:"");
 	    }
+#ifdef XML_PATH_CACHE
+	    /* Cache path of list entry unless the path above is incomplete */
+	    if (ret == 0 &&
+		xml_path_cache_set(x, XML_PATH_XPATH, cbuf_get(cb)+start) < 0)
+		goto done;
+#endif
 	    break;
 	default:
 	    break;
@@ -2236,3 +2303,43 @@ xml_copy_marked(cxobj *x0,
     return retval;
 }
 
+/*! Mark nodes for xml_copy_marked: nodes with XML_FLAG_MARK and ancestors with XML_FLAG_CHANGE
+ * @param[in]  vec   Vector of XML nodes, eg result of xpath_vec
+ * @param[in]  len   Length of vec
+ * @retval     0     OK
+ * @see xml_copy_marked_reset  Reset marks without traversing the tree
+ */
+int
+xml_copy_mark(cxobj **vec,
+	      size_t  len)
+{
+    int i;
+
+    for (i=0; i<len; i++){
+	xml_flag_set(vec[i], XML_FLAG_MARK);
+	xml_apply_ancestor(vec[i], (xml_applyfn_t*)xml_flag_set, (void*)XML_FLAG_CHANGE);
+    }
+    return 0;
+}
+
+/*! Reset marks made by xml_copy_mark, only nodes in vec and their ancestors are visited
+ * Ancestors of a node are visited up to one that is already reset
+ * @param[in]  vec   Vector of XML nodes given to xml_copy_mark
+ * @param[in]  len   Length of vec
+ * @retval     0     OK
+ */
+int
+xml_copy_mark_reset(cxobj **vec,
+		    size_t  len)
+{
+    int    i;
+    cxobj *x;
+
+    for (i=0; i<len; i++){
+	xml_flag_reset(vec[i], XML_FLAG_MARK|XML_FLAG_CHANGE);
+	for (x = xml_parent(vec[i]); x && xml_flag(x, XML_FLAG_CHANGE); x = xml_parent(x))
+	    xml_flag_reset(x, XML_FLAG_CHANGE);
+    }
+    return 0;
+}
+
@@ -386,6 +386,36 @@ xml_nsctx_yang(yang_stmt *yn,
     return retval;
 }
 
+/*! Get shared XML namespace context from Yang node (non-spec)
+ *
+ * Same context as xml_nsctx_yang, which only depends on the module or submodule
+ * of the node. It is built on first use and kept in the module, so that repeated
+ * lookups, eg of leafref paths, must and when xpaths in validation, do not build
+ * and free a new context each time.
+ * @param[in]  yn     Yang statement in module tree (or module itself)
+ * @retval     nsc    XML namespace context, do not free or modify
+ * @retval     NULL   Error
+ * @note Only use after all imported modules are loaded
+ * @see xml_nsctx_yang  For a context owned by caller
+ */
+cvec *
+xml_nsctx_yang_get(yang_stmt *yn)
+{
+    yang_stmt *ymod;
+    cvec      *nsc = NULL;
+
+    if ((ymod = ys_module(yn)) == NULL){
+	clicon_err(OE_YANG, ENOENT, "My yang module not found");
+	return NULL;
+    }
+    if ((nsc = yang_nsc_get(ymod)) != NULL)
+	return nsc;
+    if (xml_nsctx_yang(ymod, &nsc) < 0)
+	return NULL;
+    yang_nsc_set(ymod, nsc);
+    return nsc;
+}
+
 /*! Create and initialize XML namespace context from Yang spec
  *
  * That is, create a "canonical" XML namespace mapping from all loaded yang 
@@ -488,10 +518,21 @@ xml2ns(cxobj *x,
        char  *prefix,
        char **namespace)
 {
-    int    retval = -1;
-    char  *ns = NULL;
-    cxobj *xp;
+    int        retval = -1;
+    char      *ns = NULL;
+    cxobj     *xp;
+    yang_stmt *y;
+    char      *xprefix;
+    cvec      *nsc;
     
+    /* Namespace of a node bound to yang is the namespace of its module */
+    if ((y = xml_spec(x)) != NULL &&
+	yang_keyword_get(y) != Y_SPEC &&
+	((xprefix = xml_prefix(x)) == prefix ||
+	 (xprefix != NULL && prefix != NULL && strcmp(xprefix, prefix) == 0)) &&
+	(nsc = xml_nsctx_yang_get(y)) != NULL &&
+	(ns = xml_nsctx_get(nsc, NULL)) != NULL)
+	goto ok;
     if ((ns = nscache_get(x, prefix)) != NULL)
 	goto ok;
     if (prefix != NULL) /* xmlns:<prefix>="<uri>" */
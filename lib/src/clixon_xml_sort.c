@@ -73,39 +73,55 @@
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
 
-/*! Get xml body value as cligen variable
- * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[out] cvp Pointer to cligen variable containing value of x body
- * @retval     0   OK, cvp contains cv or NULL
- * @retval    -1   Error
- * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Move to clixon_xml.c?
- * As a side-effect sets the cache.
- * Clear cache with xml_cv_set(x, NULL)
+/*
+ * Local variables
  */
-static int
-xml_cv_cache(cxobj   *x,
-	     cg_var **cvp)
+/* Keep cached cligen values of list keys and leaf-lists, see xml_cv_cache_keep */
+static int _xml_cv_keep = 0;
+
+/*! Keep cached cligen values of list keys and leaf-list entries from yang binding
+ *
+ * If set, typed values of list keys and leaf-lists are parsed when bound to yang and
+ * kept until the body changes, instead of being parsed on demand when compared and
+ * cleared after sorting.
+ * Set from option CLICON_XML_CV_CACHE, see xml_cv_cache_bind
+ * @param[in]  val   0: parse on demand (default), 1: parse on bind and keep
+ * @retval     0     OK
+ */
+int
+xml_cv_cache_keep(int val)
+{
+    _xml_cv_keep = val;
+    return 0;
+}
+
+/*! Parse xml body value as cligen variable of its yang type
+ * @param[in]  x      XML node (leaf or leaf-list)
+ * @param[in]  y      Yang spec of x
+ * @param[out] cvp    Cligen variable containing value of x body, free with cv_free
+ * @param[out] reason If invalid value, malloced reason, free after use
+ * @retval     1      OK, cvp set
+ * @retval     0      Invalid value, reason set
+ * @retval    -1      Error
+ * @see xml_cv_cache  which caches the value in x
+ */
+int
+xml_cv_parse(cxobj     *x,
+	     yang_stmt *y,
+	     cg_var   **cvp,
+	     char     **reason)
 {
     int          retval = -1;
     cg_var      *cv = NULL;
-    yang_stmt   *y;
     yang_stmt   *yrestype;
     enum cv_type cvtype;
     int          ret;
-    char        *reason=NULL;
     int          options = 0;
     uint8_t      fraction = 0;
     char        *body;
 		 
     if ((body = xml_body(x)) == NULL)
 	body="";
-    if ((cv = xml_cv(x)) != NULL)
-	goto ok;
-    if ((y = xml_spec(x)) == NULL){
-	clicon_err(OE_XML, EFAULT, "Yang binding missing for xml symbol %s, body:%s", xml_name(x), body);
-	goto done;
-    }
     if (yang_type_get(y, NULL, &yrestype, &options, NULL, NULL, NULL, &fraction) < 0)
 	goto done;
     yang2cv_type(yang_argument_get(yrestype), &cvtype);
@@ -121,10 +137,55 @@ xml_cv_cache(cxobj   *x,
     if (cvtype == CGV_DEC64)
 	cv_dec64_n_set(cv, fraction);
 	
-    if ((ret = cv_parse1(body, cv, &reason)) < 0){
+    if ((ret = cv_parse1(body, cv, reason)) < 0){
 	clicon_err(OE_YANG, errno, "cv_parse1");
 	goto done;
     }
+    if (ret == 0)
+	goto fail;
+    *cvp = cv;
+    cv = NULL;
+    retval = 1;
+ done:
+    if (cv)
+	cv_free(cv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get xml body value as cligen variable
+ * @param[in]  x   XML node (body and leaf/leaf-list)
+ * @param[out] cvp Pointer to cligen variable containing value of x body
+ * @retval     0   OK, cvp contains cv or NULL
+ * @retval    -1   Error
+ * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
+ * Move to clixon_xml.c?
+ * As a side-effect sets the cache.
+ * Clear cache with xml_cv_set(x, NULL), the cache is also cleared if the body changes
+ */
+static int
+xml_cv_cache(cxobj   *x,
+	     cg_var **cvp)
+{
+    int        retval = -1;
+    cg_var    *cv = NULL;
+    yang_stmt *y;
+    int        ret;
+    char      *reason=NULL;
+    char      *body;
+		 
+    if ((cv = xml_cv(x)) != NULL)
+	goto ok;
+    if ((y = xml_spec(x)) == NULL){
+	if ((body = xml_body(x)) == NULL)
+	    body="";
+	clicon_err(OE_XML, EFAULT, "Yang binding missing for xml symbol %s, body:%s", xml_name(x), body);
+	goto done;
+    }
+    if ((ret = xml_cv_parse(x, y, &cv, &reason)) < 0)
+	goto done;
     if (ret == 0){
 	clicon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
 	goto done;
@@ -143,15 +204,76 @@ xml_cv_cache(cxobj   *x,
     return retval;
 }
 
+/*! Set cached cligen value of a list key or leaf-list entry when bound to yang
+ *
+ * Only if enabled with xml_cv_cache_keep. Values that are not valid are not cached,
+ * they are reported by validation.
+ * @param[in]  x   XML leaf or leaf-list node with body in place
+ * @param[in]  y   Yang spec of x
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see populate_self_done
+ */
+int
+xml_cv_cache_bind(cxobj     *x,
+		  yang_stmt *y)
+{
+    int        retval = -1;
+    yang_stmt *yp;
+    cvec      *cvk;
+    cg_var    *cvi = NULL;
+    cg_var    *cv = NULL;
+    char      *reason = NULL;
+    int        ret;
+
+    if (_xml_cv_keep == 0 || xml_cv(x) != NULL)
+	goto ok;
+    switch (yang_keyword_get(y)){
+    case Y_LEAF_LIST:
+	break;
+    case Y_LEAF:
+	if ((yp = yang_parent_get(y)) == NULL ||
+	    yang_keyword_get(yp) != Y_LIST)
+	    goto ok;
+	cvk = yang_cvec_get(yp); /* Use Y_LIST cache, see ys_populate_list() */
+	while ((cvi = cvec_each(cvk, cvi)) != NULL)
+	    if (strcmp(cv_string_get(cvi), yang_argument_get(y)) == 0)
+		break;
+	if (cvi == NULL) /* Not a key */
+	    goto ok;
+	break;
+    default:
+	goto ok;
+    }
+    if ((ret = xml_cv_parse(x, y, &cv, &reason)) < 0)
+	goto done;
+    if (ret == 1){
+	if (xml_cv_set(x, cv) < 0)
+	    goto done;
+	cv = NULL;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (reason)
+	free(reason);
+    if (cv)
+	cv_free(cv);
+    return retval;
+}
+
 static int
 xml_cv_cache_clear(cxobj *xt)
 {
     int    retval = -1;
     cxobj *x = NULL;
 
+    if (_xml_cv_keep) /* Kept until body changes */
+	goto ok;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL)
 	if (xml_cv_set(x, NULL) < 0)
 	    goto done;
+ ok:
     retval = 0;
  done:
     return retval;
@@ -399,6 +521,7 @@ xml_cmp_qsort(const void* arg1,
 
 /*! Sort children of an XML node 
  * Assume populated by yang spec.
+ * The node is flagged as sorted until a child is added unsorted or its order may change
  * @param[in] x0   XML node
  * @retval    -1    Error, aborted at first error encounter
  * @retval     0    OK, all nodes traversed (subparts may have been skipped)
@@ -418,11 +541,14 @@ xml_sort(cxobj *x)
 #endif
     xml_enumerate_children(x);
     qsort(xml_childvec_get(x), xml_child_nr(x), sizeof(cxobj *), xml_cmp_qsort);
+    xml_flag_set(x, XML_FLAG_SORTED);
     return 0;
 }
 
 /*! Recursively sort a tree 
  * Alt to use xml_apply
+ * Nodes flagged as sorted are not verified, eg after xml_insert, only nodes whose
+ * children are appended, eg by parsing, are
  */
 int
 xml_sort_recurse(cxobj *xn)
@@ -506,8 +632,7 @@ xml_find_keys_notsorted(cxobj   *xp,
 }
 
 /*! Find more equal objects in a vector up and down in the array of the present
- * @param[in]  childvec  Vector of children of parent
- * @param[in]  childlen  Length of child vector
+ * @param[in]  xp        Parent xml node
  * @param[in]  x1        XML node to match
  * @param[in]  yangi     Yang order number (according to spec)
  * @param[in]  mid       Where to start from (may be in middle of interval)
@@ -516,8 +641,7 @@ xml_find_keys_notsorted(cxobj   *xp,
  * @retval    -1         Error
  */
 static int
-search_multi_equals(cxobj  **childvec,
-		    size_t   childlen,
+search_multi_equals(cxobj   *xp,
 		    cxobj   *x1,
 		    int      yangi,
 		    int      mid,
@@ -530,7 +654,7 @@ search_multi_equals(cxobj  **childvec,
     yang_stmt *yc;
     
     for (i=mid-1; i>=0; i--){ /* First decrement */
-	xc = childvec[i];
+	xc = xml_child_i(xp, i);
 	yc = xml_spec(xc);
 	if (yangi != yang_order(yc)) /* wrong yang */
 	    break;
@@ -539,8 +663,8 @@ search_multi_equals(cxobj  **childvec,
 	if (clixon_xvec_prepend(xvec, xc) < 0)
 	    goto done;
     }
-    for (i=mid+1; i<childlen; i++){ /* Then increment */
-	xc = childvec[i];
+    for (i=mid+1; i<xml_child_nr(xp); i++){ /* Then increment */
+	xc = xml_child_i(xp, i);
 	yc = xml_spec(xc);
 	if (yangi != yang_order(yc)) /* wrong yang */
 	    break;
@@ -683,6 +807,10 @@ xml_search_indexvar(cxobj   *xp,
     /* Check if (exactly one) explicit indexes in cvk */
     if (xml_search_vector_get(xp, indexvar, &ivec) < 0)
 	goto done;
+    /* Build search index vector on first search */
+    if ((ivec == NULL || clixon_xvec_len(ivec) == 0) &&
+	xml_search_index_build(xp, xml_spec(x1), indexvar, &ivec) < 0)
+	goto done;
     if (ivec){
 	ilen = clixon_xvec_len(ivec);
 	if ((pos = xml_search_indexvar_binary_pos(x1, indexvar,
@@ -764,8 +892,7 @@ xml_search_binary(cxobj   *xp,
 	if (clixon_xvec_append(xvec, xc) < 0)
 	    goto done;
 	/* there may be more? */
-	if (search_multi_equals(xml_childvec_get(xp), xml_child_nr(xp),
-				x1, yangi, mid,	skip1, xvec) < 0)
+	if (search_multi_equals(xp, x1, yangi, mid, skip1, xvec) < 0)
 	    goto done;
     }
     else if (cmp < 0)
@@ -1046,6 +1173,7 @@ xml_insert(cxobj           *xp,
     int        userorder= 0;
     int        yi; /* Global yang-stmt order */
     int        i;
+    int        sorted;
 
     /* Ensure the intermediate state that xp is parent of x but has not yet been
      * added as a child
@@ -1077,8 +1205,12 @@ xml_insert(cxobj           *xp,
 			 userorder, ins, key_val, nsc_key,
 			 low, upper)) < 0)
 	goto done;
+    /* Inserted in sorted position: xp remains sorted */
+    sorted = xml_flag(xp, XML_FLAG_SORTED);
     if (xml_child_insert_pos(xp, xi, i) < 0)
 	goto done;
+    if (sorted)
+	xml_flag_set(xp, XML_FLAG_SORTED);
     xml_parent_set(xi, xp);
     /* clear namespace context cache of child */
     nscache_clear(xi);
@@ -1094,6 +1226,8 @@ xml_insert(cxobj           *xp,
  * @retval      1    Not sortable
  * @retval      0    Sorted
  * @retval     -1    Not sorted
+ * @note the node is flagged as sorted if verified, and is not verified again until
+ *       the flag is reset
  * @see xml_apply
  */
 int
@@ -1112,7 +1246,7 @@ xml_sort_verify(cxobj *x0,
 	goto done;
     }
 #endif
-    if (xml_type(x0) == CX_ELMNT){
+    if (xml_type(x0) == CX_ELMNT && !xml_flag(x0, XML_FLAG_SORTED)){
 	xml_enumerate_children(x0);
 	while ((x = xml_child_each(x0, x, -1)) != NULL) {
 	    if (xprev != NULL){ /* Check xprev <= x */
@@ -1121,6 +1255,7 @@ xml_sort_verify(cxobj *x0,
 	    }
 	    xprev = x;
 	}
+	xml_flag_set(x0, XML_FLAG_SORTED);
     }
     retval = 0;
  done:
@@ -1347,6 +1482,9 @@ xml_find_index_yang(cxobj       *xp,
     char      *encstr;
     int        revert = 0;
     char      *indexvar = NULL;
+#ifdef XML_KEY_HASH
+    int        ret;
+#endif
 
     if (xp == NULL){
 	clicon_err(OE_XML, EINVAL, "xp is NULL");
@@ -1387,6 +1525,14 @@ xml_find_index_yang(cxobj       *xp,
 	}
 	if (revert)
 	    break;
+#ifdef XML_KEY_HASH
+	if (i == cvec_len(ycvk)){ /* All keys given */
+	    if ((ret = xml_key_hash_find(xp, yc, cvk, xvec)) < 0)
+		goto done;
+	    if (ret == 1)
+		goto ok;
+	}
+#endif
 	cprintf(cb, "</%s>", name);
 	break;
     case Y_LEAF_LIST:
@@ -1443,6 +1589,7 @@ xml_find_index_yang(cxobj       *xp,
     }
     if (xml_search_yang(xp, xc, yc, 1, indexvar, xvec) < 0)
 	goto done;
+ ok:
     retval = 1; /* OK */
  done:
     if (cb)
@@ -1553,15 +1700,18 @@ clixon_xml_find_index(cxobj        *xp,
     return retval;
 }
 
-/*! Find positional parameter in xml child list, eg x/y[42]. Note, not optimized
+/*! Find positional parameter in xml child list, eg x/y[42]
  *
- * Create a temporary search object: a list (xc) with a key (xk) and call the binary search.
+ * If the children of xp are sorted in yang order, the first child of yc is found with
+ * a binary search on yang order and the entries of yc are adjacent, so that the entry
+ * at position pos is accessed directly. Otherwise the children are searched linearly.
  * @param[in]  xp     Parent xml node. 
  * @param[in]  yc     Yang spec of list child
- * @param[in]  pos    Position
+ * @param[in]  pos    Position, 0 is the first entry
  * @param[out] xvec   Array of found nodes
  * @retval     0      OK, see xret
  * @retval    -1      Error
+ * @see xml_search_yang
  */
 int
 clixon_xml_find_pos(cxobj        *xp,
@@ -1573,12 +1723,41 @@ clixon_xml_find_pos(cxobj        *xp,
     cxobj     *xc = NULL;
     char      *name;
     uint32_t   u;
+    yang_stmt *y;
+    int        yangi;
+    int        low;
+    int        mid;
+    int        upper;
 
     if (yc == NULL){
 	clicon_err(OE_YANG, ENOENT, "yang spec not found");
 	goto done;
     }
     name = yang_argument_get(yc);
+    if (xml_spec(xp) != NULL){
+	/* Lowest child with yang order of yc, attributes and children without yang first */
+	yangi = yang_order(yc);
+	low = 0;
+	upper = xml_child_nr(xp);
+	while (low < upper){
+	    mid = (low + upper) / 2;
+	    xc = xml_child_i(xp, mid);
+	    if (xml_type(xc) != CX_ELMNT ||
+		(y = xml_spec(xc)) == NULL ||
+		yang_order(y) < yangi)
+		low = mid + 1;
+	    else
+		upper = mid;
+	}
+	if ((size_t)low + pos < (size_t)xml_child_nr(xp) &&
+	    xml_spec(xml_child_i(xp, low)) == yc &&
+	    xml_spec(xc = xml_child_i(xp, low + pos)) == yc){
+	    if (clixon_xvec_append(xvec, xc) < 0)
+		goto done;
+	    goto ok;
+	}
+	xc = NULL;
+    }
     u = 0;
     xc = NULL;
     while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL) {
@@ -1590,7 +1769,187 @@ clixon_xml_find_pos(cxobj        *xp,
 	    break;
 	}
     }
+ ok:
     retval = 0;
  done:
     return retval;
 }
+
+/*! Compare first list key of an XML list entry with a range bound
+ * @param[in]  x       XML list entry
+ * @param[in]  keyname Name of first list key
+ * @param[in]  cvb     Range bound, of same type as key
+ * @param[out] cmp     <0, 0 or >0 if key is less, equal or greater than bound
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @note a missing key is smallest, as in xml_cmp
+ */
+static int
+xml_range_cmp(cxobj  *x,
+	      char   *keyname,
+	      cg_var *cvb,
+	      int    *cmp)
+{
+    cxobj  *xk;
+    cg_var *cv = NULL;
+
+    if ((xk = xml_find(x, keyname)) == NULL || xml_body(xk) == NULL){
+	*cmp = -1;
+	return 0;
+    }
+    if (xml_cv_cache(xk, &cv) < 0)
+	return -1;
+    *cmp = cv_cmp(cv, cvb);
+    return 0;
+}
+
+/*! Find list entries whose first key is within a range, using binary search
+ *
+ * The first entry with a first key greater or equal to the lower bound is found with a
+ * binary search, then entries are scanned in order until the first key is greater than
+ * the upper bound, or does not start with the prefix.
+ * The children of xp must be sorted, ie yc is an ordered-by system list.
+ * Bounds are inclusive and the result is a superset if the caller has strict bounds.
+ * @param[in]  xp     Parent xml node
+ * @param[in]  yc     Yang spec of list child
+ * @param[in]  lower  Lower bound of first key, or prefix, or NULL
+ * @param[in]  upper  Upper bound of first key, or NULL
+ * @param[in]  prefix If set, lower is a prefix of a string key, upper is not used
+ * @param[out] xvec   Found nodes in document order
+ * @retval     1      OK, see xvec
+ * @retval     0      Range scan not applicable: list, key type or bounds, xvec unchanged
+ * @retval    -1      Error
+ * @code
+ *   if ((ret = clixon_xml_find_range(xp, yc, "1000", "2000", 0, xvec)) < 0)
+ *      err;
+ * @endcode
+ * @see clixon_xml_find_pos
+ */
+int
+clixon_xml_find_range(cxobj       *xp,
+		      yang_stmt   *yc,
+		      char        *lower,
+		      char        *upper,
+		      int          prefix,
+		      clixon_xvec *xvec)
+{
+    int          retval = -1;
+    cvec        *cvk;
+    char        *keyname;
+    yang_stmt   *yk;
+    yang_stmt   *yrestype = NULL;
+    int          options = 0;
+    uint8_t      fraction = 0;
+    enum cv_type cvtype;
+    cg_var      *cvl = NULL;
+    cg_var      *cvu = NULL;
+    char        *reason = NULL;
+    cxobj       *xc;
+    cxobj       *xk;
+    yang_stmt   *y;
+    char        *body;
+    size_t       len = 0;
+    int          yangi;
+    int          low;
+    int          mid;
+    int          upp;
+    int          cmp;
+    int          i;
+
+    if (yang_keyword_get(yc) != Y_LIST ||
+	yang_find(yc, Y_ORDERED_BY, "user") != NULL)
+	goto fail;
+#ifndef STATE_ORDERED_BY_SYSTEM
+    if (yang_config_ancestor(yc) == 0)
+	goto fail;
+#endif
+    if (lower == NULL && (upper == NULL || prefix))
+	goto fail;
+    if ((cvk = yang_cvec_get(yc)) == NULL || cvec_len(cvk) == 0)
+	goto fail;
+    keyname = cv_string_get(cvec_i(cvk, 0));
+    if ((yk = yang_find(yc, Y_LEAF, keyname)) == NULL)
+	goto fail;
+    if (yang_type_get(yk, NULL, &yrestype, &options, NULL, NULL, NULL, &fraction) < 0)
+	goto done;
+    yang2cv_type(yang_argument_get(yrestype), &cvtype);
+    /* Key order must be string order for prefixes and number order for bounds */
+    if (prefix){
+	if (cvtype != CGV_STRING || (len = strlen(lower)) == 0)
+	    goto fail;
+	upper = NULL;
+    }
+    else if (!cv_isint(cvtype) && cvtype != CGV_DEC64)
+	goto fail;
+    if (lower){
+	if ((cvl = cv_new(cvtype)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv_new");
+	    goto done;
+	}
+	if (cvtype == CGV_DEC64)
+	    cv_dec64_n_set(cvl, fraction);
+	if (cv_parse1(lower, cvl, &reason) != 1)
+	    goto fail;
+    }
+    if (upper){
+	if ((cvu = cv_new(cvtype)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv_new");
+	    goto done;
+	}
+	if (cvtype == CGV_DEC64)
+	    cv_dec64_n_set(cvu, fraction);
+	if (cv_parse1(upper, cvu, &reason) != 1)
+	    goto fail;
+    }
+    /* Lowest child of yc with first key not less than lower bound */
+    yangi = yang_order(yc);
+    low = 0;
+    upp = xml_child_nr(xp);
+    while (low < upp){
+	mid = (low + upp) / 2;
+	xc = xml_child_i(xp, mid);
+	if (xml_type(xc) != CX_ELMNT ||
+	    (y = xml_spec(xc)) == NULL ||
+	    yang_order(y) < yangi)
+	    cmp = -1;
+	else if (y != yc || cvl == NULL)
+	    cmp = 1;
+	else if (xml_range_cmp(xc, keyname, cvl, &cmp) < 0)
+	    goto done;
+	if (cmp < 0)
+	    low = mid + 1;
+	else
+	    upp = mid;
+    }
+    /* Then scan until upper bound or prefix */
+    for (i=low; i<xml_child_nr(xp); i++){
+	xc = xml_child_i(xp, i);
+	if (xml_spec(xc) != yc)
+	    break;
+	if (cvu){
+	    if (xml_range_cmp(xc, keyname, cvu, &cmp) < 0)
+		goto done;
+	    if (cmp > 0)
+		break;
+	}
+	if (prefix &&
+	    ((xk = xml_find(xc, keyname)) == NULL ||
+	     (body = xml_body(xk)) == NULL ||
+	     strncmp(body, lower, len) != 0))
+	    break;
+	if (clixon_xvec_append(xvec, xc) < 0)
+	    goto done;
+    }
+    retval = 1;
+ done:
+    if (cvl)
+	cv_free(cvl);
+    if (cvu)
+	cv_free(cvu);
+    if (reason)
+	free(reason);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
@@ -65,49 +65,106 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_vec.h"
 
-//typedef struct clixon_xml_vec clixon_xvec; /* struct defined in clicon_xml_vec.c */
+#include "clixon_xml_vec_internal.h" /* internal included by this file and clixon_xml.c */
 
-/* How many XML children to start with if any (and then add exponentialy) */
-#define XVEC_MAX_DEFAULT 4      /* start value */
-#define XVEC_MAX_THRESHOLD 1024 /* exponential growth to here, then linear */
-
-/*! Clixon xml vector concrete implementaion of the abstract clixon_xvec type
- * Contiguous vector (not linked list) so that binary search can be done by direct index access
+/*! Move the gap of an XML object vector so that it starts at object number i
+ *
+ * @param[in]  xv    XML tree vector
+ * @param[in]  i     New start of gap, 0 <= i <= length of vector
+ * @see struct clixon_xml_vec
  */
-struct clixon_xml_vec {
-    cxobj **xv_vec;   /* Sorted vector of xml object pointers */
-    int     xv_len;   /* Length of vector */
-    int     xv_max;   /* Vector allocation */    
-};
+void
+clixon_xvec_gap_move(clixon_xvec *xv,
+		     int          i)
+{
+    cxobj **vec = xv->xv_vec;
+    int     gap = xv->xv_gap;
+    int     gaplen = xv->xv_max - xv->xv_len;
+
+    if (gaplen && i < gap)
+	memmove(&vec[i+gaplen], &vec[i], (gap-i)*sizeof(cxobj*));
+    else if (gaplen && i > gap)
+	memmove(&vec[gap], &vec[gap+gaplen], (i-gap)*sizeof(cxobj*));
+    xv->xv_gap = i;
+}
 
-/*! Increment cxobj vector in an XML object vector 
+/*! Make room for n more objects in an XML object vector
  *
  * Exponential growth to a threshold, then linear
  * @param[in]  xv    XML tree vector
+ * @param[in]  n     Number of objects to make room for
+ * @param[in]  start Initial length of vector if not allocated, eg XVEC_MAX_DEFAULT
  * @retval     0     OK
  * @retval    -1     Error
  */
-static int
-clixon_xvec_inc(clixon_xvec *xv)
+int
+clixon_xvec_grow(clixon_xvec *xv,
+		 int          n,
+		 int          start)
 {
-    int retval = -1;
-    
-    xv->xv_len++;
-    if (xv->xv_len > xv->xv_max){
-	if (xv->xv_max < XVEC_MAX_DEFAULT)
-	    xv->xv_max = XVEC_MAX_DEFAULT;
-	else if (xv->xv_max < XVEC_MAX_THRESHOLD)
-	    xv->xv_max *= 2;                  /* Double the space - exponential */
+    cxobj **vec;
+    int     max;
+
+    if (xv->xv_len + n <= xv->xv_max)
+	return 0;
+    if ((max = xv->xv_max) == 0)
+	max = n > start ? n : start;
+    while (max < xv->xv_len + n){
+	if (max < XVEC_MAX_THRESHOLD)
+	    max *= 2;                  /* Double the space - exponential */
 	else
-	    xv->xv_max += XVEC_MAX_THRESHOLD; /* Add - linear growth */
-	if ((xv->xv_vec = realloc(xv->xv_vec, sizeof(cxobj *) * xv->xv_max)) == NULL){
-	    clicon_err(OE_XML, errno, "realloc");
-	    goto done;
-	}
+	    max += XVEC_MAX_THRESHOLD; /* Add - linear growth */
     }
-    retval = 0;
- done:
-    return retval;
+    /* Make objects contiguous so that the new space is one gap at the end */
+    clixon_xvec_gap_move(xv, xv->xv_len);
+    if ((vec = realloc(xv->xv_vec, max*sizeof(cxobj*))) == NULL){
+	clicon_err(OE_XML, errno, "realloc");
+	return -1;
+    }
+    xv->xv_vec = vec;
+    xv->xv_max = max;
+    return 0;
+}
+
+/*! Shrink an XML object vector if less than a quarter of it is used
+ *
+ * The allocation is halved until at least a quarter is used. Not fitting it to the length
+ * leaves room for objects to be inserted again without growing it.
+ * @param[in]  xv    XML tree vector
+ * @retval     0     OK, also if realloc fails, the vector is then kept
+ */
+static int
+clixon_xvec_shrink(clixon_xvec *xv)
+{
+    cxobj **vec;
+    int     max;
+
+    if (xv->xv_max <= XVEC_SHRINK_MIN || xv->xv_len >= xv->xv_max/4)
+	return 0;
+    max = xv->xv_max;
+    while (max > XVEC_SHRINK_MIN && xv->xv_len < max/4)
+	max /= 2;
+    clixon_xvec_gap_move(xv, xv->xv_len);
+    if ((vec = realloc(xv->xv_vec, max*sizeof(cxobj*))) != NULL){
+	xv->xv_vec = vec;
+	xv->xv_max = max;
+    }
+    return 0;
+}
+
+/*! Free the vector of an XML object vector and make it empty, not the objects
+ *
+ * Used for vectors not allocated with clixon_xvec_new, eg the child vector of an XML node
+ * @param[in]  xv    XML tree vector
+ * @retval     0     OK
+ */
+int
+clixon_xvec_reset(clixon_xvec *xv)
+{
+    if (xv->xv_vec)
+	free(xv->xv_vec);
+    memset(xv, 0, sizeof(*xv));
+    return 0;
 }
 
 /*! Create new XML object vector
@@ -147,16 +204,17 @@ clixon_xvec_dup(clixon_xvec *xv0)
 
     if ((xv1 = clixon_xvec_new()) == NULL)
 	goto done;
-    *xv1 = *xv0;
-    xv1->xv_vec = NULL;
-    if (xv1->xv_max &&
-	(xv1->xv_vec = calloc(xv1->xv_max, sizeof(cxobj*))) == NULL){
+    if (xv0->xv_len == 0)
+	goto done;
+    clixon_xvec_gap_move(xv0, xv0->xv_len);
+    if ((xv1->xv_vec = calloc(xv0->xv_len, sizeof(cxobj*))) == NULL){
 	clicon_err(OE_UNIX, errno, "calloc");
 	free(xv1);
 	xv1 = NULL;
 	goto done;
     }
     memcpy(xv1->xv_vec, xv0->xv_vec, xv0->xv_len*sizeof(cxobj*));
+    xv1->xv_len = xv1->xv_gap = xv1->xv_max = xv0->xv_len;
  done:
     return xv1;
 }
@@ -193,7 +251,7 @@ clixon_xvec_i(clixon_xvec *xv,
 	      int          i)
 {
     if (i < xv->xv_len)
-	return xv->xv_vec[i];
+	return xv->xv_vec[XVEC_POS(xv, i)];
     else
 	return NULL;
 }
@@ -217,13 +275,11 @@ clixon_xvec_extract(clixon_xvec *xv,
 	clicon_err(OE_XML, EINVAL, "xv is NULL");
 	goto done;
     }
+    clixon_xvec_gap_move(xv, xv->xv_len);
     *xvec = xv->xv_vec;
     *xlen = xv->xv_len;
-    if (xv->xv_vec != NULL){
-	xv->xv_len = 0;
-	xv->xv_max = 0;
-	xv->xv_vec = NULL;
-    }
+    if (xv->xv_vec != NULL)
+	memset(xv, 0, sizeof(*xv));
     retval = 0;
  done:
     return retval;
@@ -246,14 +302,7 @@ clixon_xvec_append(clixon_xvec *xv,
 		   cxobj       *x)
 		   
 {
-    int retval = -1;
-
-    if (clixon_xvec_inc(xv) < 0)
-	goto done;
-    xv->xv_vec[xv->xv_len-1] = x;
-    retval = 0;
- done:
-    return retval;
+    return clixon_xvec_insert_pos(xv, x, xv->xv_len);
 }
 
 /*! Prepend a new xml tree to an existing xml vector first in the list
@@ -272,15 +321,7 @@ int
 clixon_xvec_prepend(clixon_xvec *xv,
 		    cxobj       *x)
 {
-    int retval = -1;
-
-    if (clixon_xvec_inc(xv) < 0)
-	goto done;
-    memmove(&xv->xv_vec[1], &xv->xv_vec[0], sizeof(cxobj *) * (xv->xv_len-1));
-    xv->xv_vec[0] = x;
-    retval = 0;
- done:
-    return retval;
+    return clixon_xvec_insert_pos(xv, x, 0);
 }
 
 /*! Insert XML node x at position i in XML object vector
@@ -296,17 +337,36 @@ clixon_xvec_insert_pos(clixon_xvec *xv,
 		       cxobj       *x,
 		       int          i)
 {
-    int    retval = -1;
-    size_t size;
-    
-    if (clixon_xvec_inc(xv) < 0)
-	goto done;
-    size = (xv->xv_len - i -1)*sizeof(cxobj *);
-    memmove(&xv->xv_vec[i+1], &xv->xv_vec[i], size);
-    xv->xv_vec[i] = x;
-    retval = 0;
- done:
-    return retval;
+    return clixon_xvec_insert_vec(xv, i, &x, 1);
+}
+
+/*! Insert n XML nodes at position i in XML object vector
+ * 
+ * Room is made for all nodes at once, and the nodes after position i are moved once
+ * @param[in]  xv    XML tree vector
+ * @param[in]  i     Position, 0 <= i <= length of vector
+ * @param[in]  vec   Vector of n XML nodes, or NULL to insert n NULL entries
+ * @param[in]  n     Number of XML nodes
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see clixon_xvec_rm_marked
+ */
+int
+clixon_xvec_insert_vec(clixon_xvec *xv,
+		       int          i,
+		       cxobj      **vec,
+		       int          n)
+{
+    if (clixon_xvec_grow(xv, n, XVEC_MAX_DEFAULT) < 0)
+	return -1;
+    clixon_xvec_gap_move(xv, i);
+    if (vec)
+	memcpy(&xv->xv_vec[i], vec, n*sizeof(cxobj *));
+    else
+	memset(&xv->xv_vec[i], 0, n*sizeof(cxobj *));
+    xv->xv_len += n;
+    xv->xv_gap += n;
+    return 0;
 }
 
 /*! Remove XML node x from position i in XML object vector
@@ -320,11 +380,56 @@ int
 clixon_xvec_rm_pos(clixon_xvec *xv,
 		   int          i)
 {
-    size_t size;
-    
-    size = (xv->xv_len - i + 1)*sizeof(cxobj *);
-    memmove(&xv->xv_vec[i], &xv->xv_vec[i+1], size);
+    if (i < 0 || i >= xv->xv_len)
+	return 0;
+    /* Removing the object after the gap extends the gap */
+    clixon_xvec_gap_move(xv, i);
+    xv->xv_vec[XVEC_POS(xv, i)] = NULL;
     xv->xv_len--;
+    return clixon_xvec_shrink(xv);
+}
+
+/*! Remove many XML nodes from XML object vector in one pass
+ * 
+ * The remaining nodes are compacted in a single pass, instead of moving the nodes after
+ * each removed node
+ * @param[in]  xv    XML tree vector
+ * @param[in]  rm    Vector of vector length: remove node i if rm[i] is set. If NULL remove all
+ * @retval     0     OK
+ * @see clixon_xvec_insert_vec
+ */
+int
+clixon_xvec_rm_marked(clixon_xvec *xv,
+		      uint8_t     *rm)
+{
+    int len = xv->xv_len;
+    int i;
+    int j = 0;
+
+    clixon_xvec_gap_move(xv, len);
+    for (i=0; i<len; i++)
+	if (rm && rm[i] == 0)
+	    xv->xv_vec[j++] = xv->xv_vec[i];
+    for (i=j; i<len; i++)
+	xv->xv_vec[i] = NULL;
+    xv->xv_len = j;
+    xv->xv_gap = j;
+    return clixon_xvec_shrink(xv);
+}
+
+/*! Sort XML object vector
+ * 
+ * @param[in]  xv    XML tree vector
+ * @param[in]  cmp   Comparison function, as in qsort(3) called with pointers to cxobj*
+ * @retval     0     OK
+ */
+int
+clixon_xvec_sort(clixon_xvec *xv,
+		 int        (*cmp)(const void *, const void *))
+{
+    clixon_xvec_gap_move(xv, xv->xv_len);
+    if (xv->xv_len > 1)
+	qsort(xv->xv_vec, xv->xv_len, sizeof(cxobj *), cmp);
     return 0;
 }
 
@@ -341,7 +446,7 @@ clixon_xvec_print(FILE        *f,
     int i;
     
     for (i=0; i<xv->xv_len; i++)
-	clicon_xml2file(f, xv->xv_vec[i], 0, 1);
+	clicon_xml2file(f, xv->xv_vec[XVEC_POS(xv, i)], 0, 1);
     return 0;
 }
 
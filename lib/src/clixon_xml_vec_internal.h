@@ -0,0 +1,86 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  *
+  * This file defines the internal XML object vector used by the Clixon implementation
+  * It is included by clixon_xml_vec.c, and by clixon_xml.c where it is the child vector
+  * of XML elements. Other accesses should be made via the API in clixon_xml_vec.h
+  */
+
+#ifndef _CLIXON_XML_VEC_INTERNAL_H_
+#define _CLIXON_XML_VEC_INTERNAL_H_
+
+/*
+ * Constants
+ */
+/* Default initial length of vector (then grow exponentially) */
+#define XVEC_MAX_DEFAULT 4
+/* Exponential growth to here, then linear */
+#define XVEC_MAX_THRESHOLD 65536
+/* Vectors longer than this are shrunk when less than a quarter is used */
+#define XVEC_SHRINK_MIN 64
+
+/*! Clixon xml vector concrete implementaion of the abstract clixon_xvec type
+ *
+ * The vector is a gap buffer: the unused part of the allocated vector is kept at the last
+ * insert/remove position instead of at the end. Consecutive inserts and removes close to
+ * each other, such as merging a sorted tree into a large sorted list, then only move the
+ * objects between the operations instead of all objects after them.
+ * Objects are contiguous (the gap is at the end) when the vector is sorted or extracted,
+ * so that binary search can be done by direct index access.
+ *
+ *           0     1     gap               xv_max
+ *           +-----+-----+-----+-----+-----+
+ * xv_vec:   |  a  |  b  |     |     |  c  |  xv_len: 3
+ *           +-----+-----+-----+-----+-----+
+ */
+struct clixon_xml_vec {
+    cxobj **xv_vec;   /* Vector of xml object pointers, with gap */
+    int     xv_len;   /* Number of objects in vector */
+    int     xv_gap;   /* Start of unused gap in vector, see clixon_xvec_gap_move */
+    int     xv_max;   /* Vector allocation */
+};
+
+/* Position in xv_vec of object number i, skipping the gap */
+#define XVEC_POS(xv, i) ((i) < (xv)->xv_gap ? (i) : (i) + (xv)->xv_max - (xv)->xv_len)
+
+/*
+ * Prototypes
+ */
+void clixon_xvec_gap_move(clixon_xvec *xv, int i);
+int  clixon_xvec_grow(clixon_xvec *xv, int n, int start);
+int  clixon_xvec_reset(clixon_xvec *xv);
+
+#endif  /* _CLIXON_XML_VEC_INTERNAL_H_ */
@@ -65,6 +65,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <assert.h>
@@ -183,6 +184,10 @@ xpath_tree_print0(cbuf       *cb,
 	}
     if (xs->xs_strnr)
 	cprintf(cb,"%s ", xs->xs_strnr);
+    if (xs->xs_prof) /* Profiled, see xpath_profile */
+	cprintf(cb, " [evals:%u visits:%u preds:%u opt-hit:%u opt-miss:%u usec:%" PRIu64 "]",
+		xs->xs_prof->xp_evals, xs->xs_prof->xp_visits, xs->xs_prof->xp_preds,
+		xs->xs_prof->xp_opthit, xs->xs_prof->xp_optmiss, xs->xs_prof->xp_usec);
     cprintf(cb, "\n");
     if (xs->xs_c0)
 	xpath_tree_print0(cb, xs->xs_c0,level+1);
@@ -459,6 +464,8 @@ xpath_tree_free(xpath_tree *xs)
 	free(xs->xs_s0);
     if (xs->xs_s1)
 	free(xs->xs_s1);
+    if (xs->xs_prof)
+	free(xs->xs_prof);
     if (xs->xs_c0)
 	xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
@@ -527,6 +534,174 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+#ifdef XPATH_CACHE
+/*! Cached parse tree of an xpath string, see xpath_cache_get
+ * The trees are read-only and shared by all evaluations of the same xpath, eg YANG
+ * when and must statements. Trees in use are not evicted, see xpe_inuse.
+ */
+struct xpath_cache_entry{
+    qelem_t     xpe_q;      /* LRU list, most recently used first */
+    char       *xpe_xpath;  /* xpath string, also hash key */
+    xpath_tree *xpe_tree;   /* parse tree */
+    int         xpe_inuse;  /* number of ongoing evaluations */
+};
+typedef struct xpath_cache_entry xpath_cache_entry;
+
+static clicon_hash_t     *_xpath_cache_hash = NULL; /* xpath string -> entry */
+static xpath_cache_entry *_xpath_cache_lru = NULL;
+static int                _xpath_cache_len = 0;
+static int                _xpath_cache_hits = 0;
+static int                _xpath_cache_misses = 0;
+
+/*! Free a cache entry and remove it from the cache
+ * @param[in]  xpe  Cache entry
+ */
+static int
+xpath_cache_entry_free(xpath_cache_entry *xpe)
+{
+    DELQ(xpe, _xpath_cache_lru, xpath_cache_entry *);
+    clicon_hash_del(_xpath_cache_hash, xpe->xpe_xpath);
+    _xpath_cache_len--;
+    if (xpe->xpe_tree)
+	xpath_tree_free(xpe->xpe_tree);
+    free(xpe->xpe_xpath);
+    free(xpe);
+    return 0;
+}
+
+/*! Get parse tree of xpath from cache, parse and cache it if not found
+ *
+ * The least recently used tree not in use is evicted if the cache is full. If all
+ * are in use, the tree is not cached.
+ * @param[in]  xpath   String with XPATH 1.0 syntax
+ * @param[out] xptree  Parse tree, read-only
+ * @param[out] xpep    Cache entry, release with xpath_cache_put, if NULL free xptree
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xpath_cache_get(const char         *xpath,
+		xpath_tree        **xptree,
+		xpath_cache_entry **xpep)
+{
+    int                retval = -1;
+    xpath_cache_entry *xpe = NULL;
+    xpath_cache_entry *xpe1;
+    void              *p;
+    xpath_tree        *xpt = NULL;
+
+    *xpep = NULL;
+    if (_xpath_cache_hash == NULL &&
+	(_xpath_cache_hash = clicon_hash_init()) == NULL)
+	goto done;
+    if ((p = clicon_hash_value(_xpath_cache_hash, xpath, NULL)) != NULL){
+	memcpy(&xpe, p, sizeof(xpe));
+	_xpath_cache_hits++;
+	if (xpe != _xpath_cache_lru){ /* Move first in LRU list */
+	    DELQ(xpe, _xpath_cache_lru, xpath_cache_entry *);
+	    INSQ(xpe, _xpath_cache_lru);
+	}
+	goto ok;
+    }
+    _xpath_cache_misses++;
+    if (xpath_parse(xpath, &xpt) < 0)
+	goto done;
+    /* Evict least recently used trees not in use */
+    xpe1 = _xpath_cache_lru?PREVQ(xpath_cache_entry *, _xpath_cache_lru):NULL;
+    while (_xpath_cache_len >= XPATH_CACHE_SIZE && xpe1 != NULL){
+	xpe = xpe1;
+	xpe1 = (xpe1 == _xpath_cache_lru)?NULL:PREVQ(xpath_cache_entry *, xpe1);
+	if (xpe->xpe_inuse == 0)
+	    xpath_cache_entry_free(xpe);
+    }
+    xpe = NULL;
+    if (_xpath_cache_len >= XPATH_CACHE_SIZE){ /* All in use: do not cache */
+	*xptree = xpt;
+	xpt = NULL;
+	retval = 0;
+	goto done;
+    }
+    if ((xpe = malloc(sizeof(*xpe))) == NULL){
+	clicon_err(OE_XML, errno, "malloc");
+	goto done;
+    }
+    memset(xpe, 0, sizeof(*xpe));
+    if ((xpe->xpe_xpath = strdup(xpath)) == NULL){
+	clicon_err(OE_XML, errno, "strdup");
+	free(xpe);
+	goto done;
+    }
+    if (clicon_hash_add(_xpath_cache_hash, xpath, &xpe, sizeof(xpe)) == NULL){
+	free(xpe->xpe_xpath);
+	free(xpe);
+	goto done;
+    }
+    xpe->xpe_tree = xpt;
+    xpt = NULL;
+    INSQ(xpe, _xpath_cache_lru);
+    _xpath_cache_len++;
+ ok:
+    xpe->xpe_inuse++;
+    *xptree = xpe->xpe_tree;
+    *xpep = xpe;
+    retval = 0;
+ done:
+    if (xpt)
+	xpath_tree_free(xpt);
+    return retval;
+}
+
+/*! Release parse tree of xpath got from xpath_cache_get
+ * @param[in]  xpe  Cache entry
+ */
+static void
+xpath_cache_put(xpath_cache_entry *xpe)
+{
+    xpe->xpe_inuse--;
+}
+#endif /* XPATH_CACHE */
+
+/*! Free all cached xpath parse trees
+ * @retval     0       OK
+ * @see XPATH_CACHE
+ */
+int
+xpath_cache_clear(void)
+{
+#ifdef XPATH_CACHE
+    while (_xpath_cache_lru != NULL)
+	xpath_cache_entry_free(_xpath_cache_lru);
+    if (_xpath_cache_hash){
+	clicon_hash_free(_xpath_cache_hash);
+	_xpath_cache_hash = NULL;
+    }
+#endif
+    return 0;
+}
+
+/*! Get and reset xpath parse tree cache statistics
+ * @param[out] hits    Number of cache hits
+ * @param[out] misses  Number of cache misses, ie parsed xpaths
+ * @param[out] len     Number of cached parse trees
+ * @see XPATH_CACHE
+ */
+int
+xpath_cache_stats(int *hits,
+		  int *misses,
+		  int *len)
+{
+#ifdef XPATH_CACHE
+    *hits = _xpath_cache_hits;
+    *misses = _xpath_cache_misses;
+    *len = _xpath_cache_len;
+    _xpath_cache_hits = 0;
+    _xpath_cache_misses = 0;
+#else
+    *hits = *misses = *len = 0;
+#endif
+    return 0;
+}
+
 /*! Given XML tree and xpath, parse xpath, eval it and return xpath context, 
  * This is a raw form of xpath where you can do type conversion of the return
  * value, etc, not just a nodeset.
@@ -555,22 +730,99 @@ xpath_vec_ctx(cxobj      *xcur,
     int         retval = -1;
     xpath_tree *xptree = NULL;
     xp_ctx      xc = {0,};
-    
+#ifdef XPATH_CACHE
+    xpath_cache_entry *xpe = NULL;
+#endif
+
+#ifdef XPATH_CACHE
+    if (xpath_cache_get(xpath, &xptree, &xpe) < 0)
+	goto done;
+#else
     if (xpath_parse(xpath, &xptree) < 0)
 	goto done;
+#endif
     xc.xc_type = XT_NODESET;
     xc.xc_node = xcur;
     xc.xc_initial = xcur;
-    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+    if (ctx_nodeset_append(&xc, xcur) < 0)
 	goto done;
     if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
 	goto done;
-    if (xc.xc_nodeset){
-	free(xc.xc_nodeset);
-	xc.xc_nodeset = NULL;
+    retval = 0;
+ done:
+    ctx_nodeset_clear(&xc);
+#ifdef XPATH_CACHE
+    if (xpe)
+	xpath_cache_put(xpe);
+    else
+#endif
+    if (xptree)
+	xpath_tree_free(xptree);
+    return retval;
+}
+
+/*! Evaluate an xpath with profiling and print the parse tree annotated with counters
+ *
+ * The xpath is parsed without the parse tree cache, so that the counters are of this
+ * evaluation only. Each node of the tree is printed with:
+ *   evals     Nr of evaluations of the node
+ *   visits    Nr of XML nodes tested by a step
+ *   preds     Nr of predicate evaluations, one per node in the context of a predicate
+ *   opt-hit   Nr of list lookups made by the list optimizer, see xpath_optimize_check
+ *   opt-miss  Nr of optimizer checks where no lookup could be made
+ *   usec      Time in the node including its children
+ * @param[in]  xcur      XML tree where to search
+ * @param[in]  nsc       External XML namespace context, or NULL
+ * @param[in]  xpath     XPATH syntax
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp       Resulting context if not NULL, free with ctx_free
+ * @param[out] cb        Annotated parse tree
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @code
+ *   if (xpath_profile(x, nsc, "/a/b[c='x']", 0, NULL, cb) < 0)
+ *      err;
+ *   fprintf(stderr, "%s", cbuf_get(cb));
+ * @endcode
+ * @see xpath_vec_ctx
+ */
+int
+xpath_profile(cxobj      *xcur,
+	      cvec       *nsc,
+	      const char *xpath,
+	      int         localonly,
+	      xp_ctx    **xrp,
+	      cbuf       *cb)
+{
+    int         retval = -1;
+    xpath_tree *xptree = NULL;
+    xp_ctx      xc = {0,};
+    xp_ctx     *xr = NULL;
+    int         ret;
+
+    if (xpath_parse(xpath, &xptree) < 0)
+	goto done;
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    if (ctx_nodeset_append(&xc, xcur) < 0)
+	goto done;
+    xp_eval_profile_set(1);
+    ret = xp_eval(&xc, xptree, nsc, localonly, &xr);
+    xp_eval_profile_set(0);
+    if (ret < 0)
+	goto done;
+    if (xpath_tree_print_cb(cb, xptree) < 0)
+	goto done;
+    if (xrp){
+	*xrp = xr;
+	xr = NULL;
     }
     retval = 0;
  done:
+    if (xr)
+	ctx_free(xr);
+    ctx_nodeset_clear(&xc);
     if (xptree)
 	xpath_tree_free(xptree);
     return retval;
@@ -637,6 +889,42 @@ xpath_first(cxobj      *xcur,
     return cx;
 }
 
+/*! XPath nodeset function with parsed xpath, only the first matching entry is returned
+ *
+ * As xpath_first but the xpath is parsed beforehand, eg when the same xpath is 
+ * evaluated many times
+ * @param[in]  xcur    XML tree where to search
+ * @param[in]  nsc     External XML namespace context, or NULL
+ * @param[in]  xptree  Parsed xpath, see xpath_parse
+ * @retval     xml-tree XML tree of first match
+ * @retval     NULL    Error or not found
+ * @see xpath_first
+ */
+cxobj *
+xpath_first_tree(cxobj      *xcur, 
+		 cvec       *nsc,
+		 xpath_tree *xptree)
+{
+    cxobj     *cx = NULL;
+    xp_ctx     xc = {0,};
+    xp_ctx    *xr = NULL;
+
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    if (ctx_nodeset_append(&xc, xcur) < 0)
+	goto done;
+    if (xp_eval(&xc, xptree, nsc, 0, &xr) < 0)
+	goto done;
+    if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
+	cx = xr->xc_nodeset[0];
+ done:
+    ctx_nodeset_clear(&xc);
+    if (xr)
+	ctx_free(xr);
+    return cx;
+}
+
 /*! XPath nodeset function where prefixes are skipped, only first matching is returned
  *
  * Reason for skipping prefix/namespace check may be with incomplete tree, for example.
@@ -63,6 +63,16 @@
 #include "clixon_xpath.h"
 #include "clixon_xpath_parse.h"
 
+/*
+ * Constants
+ */
+/* Node-set allocation: start length, then doubled when full */
+#define CTX_NODESET_START    8
+/* Freed node-set buffers kept for reuse by later evaluations, at most this many */
+#define CTX_POOL_LEN         16
+/* and not larger than this, larger buffers are freed */
+#define CTX_POOL_MAXLEN      4096
+
 /*
  * Variables
  */
@@ -74,12 +84,114 @@ const map_str2int ctxmap[] = {
     {NULL,        -1}
 };
 
+/* Pool of freed node-set buffers and their allocated lengths
+ * Most evaluations make many small node-sets, eg one per step and predicate */
+static cxobj **_ctx_pool[CTX_POOL_LEN];
+static int     _ctx_pool_max[CTX_POOL_LEN];
+static int     _ctx_pool_len = 0;
+
+/*! Release a node-set buffer, keep it in pool for reuse if small enough
+ * @param[in]  vec   Node-set buffer
+ * @param[in]  max   Allocated length of buffer
+ */
+static void
+ctx_nodeset_release(cxobj **vec,
+		    int     max)
+{
+    if (vec == NULL)
+	return;
+    if (_ctx_pool_len < CTX_POOL_LEN &&
+	max > 0 && max <= CTX_POOL_MAXLEN){
+	_ctx_pool[_ctx_pool_len] = vec;
+	_ctx_pool_max[_ctx_pool_len++] = max;
+    }
+    else
+	free(vec);
+}
+
+/*! Free node-set buffers kept for reuse, eg at exit
+ */
+int
+ctx_nodeset_pool_free(void)
+{
+    while (_ctx_pool_len > 0)
+	free(_ctx_pool[--_ctx_pool_len]);
+    return 0;
+}
+
+/*! Append a node to the nodeset of an XPATH context
+ *
+ * The nodeset grows geometrically, so that building a large nodeset does not make one
+ * realloc per node. A new nodeset reuses a released buffer if any.
+ * @param[in]  xc    XPATH context
+ * @param[in]  x     XML node
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see cxvec_append  for plain vectors
+ */
+int
+ctx_nodeset_append(xp_ctx *xc,
+		   cxobj  *x)
+{
+    cxobj **vec;
+    int     max;
+
+    if (xc->xc_size >= xc->xc_max){
+	if (xc->xc_nodeset == NULL && _ctx_pool_len > 0){
+	    _ctx_pool_len--;
+	    xc->xc_nodeset = _ctx_pool[_ctx_pool_len];
+	    xc->xc_max = _ctx_pool_max[_ctx_pool_len];
+	}
+	else{
+	    max = xc->xc_max < CTX_NODESET_START ? CTX_NODESET_START : xc->xc_max*2;
+	    if ((vec = realloc(xc->xc_nodeset, max*sizeof(cxobj *))) == NULL){
+		clicon_err(OE_XML, errno, "realloc");
+		return -1;
+	    }
+	    xc->xc_nodeset = vec;
+	    xc->xc_max = max;
+	}
+    }
+    xc->xc_nodeset[xc->xc_size++] = x;
+    return 0;
+}
+
+/*! Empty the nodeset of an XPATH context and release its buffer for reuse
+ * @param[in]  xc    XPATH context
+ */
+int
+ctx_nodeset_clear(xp_ctx *xc)
+{
+    ctx_nodeset_release(xc->xc_nodeset, xc->xc_max);
+    xc->xc_nodeset = NULL;
+    xc->xc_size = 0;
+    xc->xc_max = 0;
+    return 0;
+}
+
+/*! Move the nodeset of an XPATH context to another, replacing its nodeset
+ * @param[in]  xc    XPATH context, its old nodeset is released
+ * @param[in]  xsrc  XPATH context, its nodeset is empty after the move
+ */
+int
+ctx_nodeset_move(xp_ctx *xc,
+		 xp_ctx *xsrc)
+{
+    ctx_nodeset_release(xc->xc_nodeset, xc->xc_max);
+    xc->xc_nodeset = xsrc->xc_nodeset;
+    xc->xc_size = xsrc->xc_size;
+    xc->xc_max = xsrc->xc_max;
+    xsrc->xc_nodeset = NULL;
+    xsrc->xc_size = 0;
+    xsrc->xc_max = 0;
+    return 0;
+}
+
 /*! Free xpath context */
 int
 ctx_free(xp_ctx *xc)
 {
-    if (xc->xc_nodeset)
-	free(xc->xc_nodeset);
+    ctx_nodeset_release(xc->xc_nodeset, xc->xc_max);
     if (xc->xc_string)
 	free(xc->xc_string);
     free(xc);
@@ -98,12 +210,15 @@ ctx_dup(xp_ctx *xc0)
     }
     memset(xc, 0, sizeof(*xc));
     *xc = *xc0;
+    xc->xc_nodeset = NULL;
+    xc->xc_max = 0;
     if (xc0->xc_size){
 	if ((xc->xc_nodeset = calloc(xc0->xc_size, sizeof(cxobj*))) == NULL){
 	    clicon_err(OE_UNIX, errno, "calloc");
 	    goto done;
 	}
 	memcpy(xc->xc_nodeset, xc0->xc_nodeset, xc->xc_size*sizeof(cxobj*));
+	xc->xc_max = xc0->xc_size;
     }
     if (xc0->xc_string)
 	if ((xc->xc_string = strdup(xc0->xc_string)) == NULL){
@@ -114,6 +229,31 @@ ctx_dup(xp_ctx *xc0)
     return xc;
 }
 
+/*! Duplicate xpath context without its node-set and string
+ *
+ * Use instead of ctx_dup when the node-set of the new context is built from scratch,
+ * to avoid copying the node-set
+ * @param[in]  xc0   XPATH context
+ * @retval     xc    New context with empty node-set, free with ctx_free
+ * @retval     NULL  Error
+ */
+xp_ctx *
+ctx_dup_empty(xp_ctx *xc0)
+{
+    xp_ctx *xc;
+    
+    if ((xc = malloc(sizeof(*xc))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return NULL;
+    }
+    *xc = *xc0;
+    xc->xc_nodeset = NULL;
+    xc->xc_size = 0;
+    xc->xc_max = 0;
+    xc->xc_string = NULL;
+    return xc;
+}
+
 /*! Print XPATH context to CLIgen buf
  * @param[in] cb  CLIgen buf to print to
  * @param[in] xc  XPATH evaluation context
@@ -317,10 +457,10 @@ ctx_nodeset_replace(xp_ctx   *xc,
 		    cxobj   **vec,
 		    size_t    veclen)
 {
-    if (xc->xc_nodeset)
-	free(xc->xc_nodeset);
+    ctx_nodeset_release(xc->xc_nodeset, xc->xc_max);
     xc->xc_nodeset = vec;
     xc->xc_size = veclen;
+    xc->xc_max = veclen;
     return 0;
 }
 
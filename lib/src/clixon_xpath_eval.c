@@ -68,6 +68,7 @@
 #include <assert.h>
 #include <syslog.h>
 #include <fcntl.h>
+#include <time.h>
 #include <math.h> /* NaN */
 
 /* cligen */
@@ -109,6 +110,40 @@ const map_str2int xpopmap[] = {
     {NULL,               -1}
 };
 
+/* Profiling of xp_eval: counters are kept in xs_prof of each evaluated node */
+static int      _xp_profile = 0;
+static uint32_t _xp_visits = 0;   /* XML nodes tested by nodetest_eval while profiling */
+
+/*! Enable or disable profiling of xpath evaluation
+ * @param[in]  enable  If set, counters are added to the evaluated xpath_tree nodes
+ * @retval     0       OK
+ * @see xpath_profile
+ */
+int
+xp_eval_profile_set(int enable)
+{
+    _xp_profile = enable;
+    return 0;
+}
+
+/*! Get profiling counters of an xpath_tree node, create them if not present
+ * @param[in]  xs   XPATH node tree
+ * @retval     xp   Profiling counters
+ * @retval     NULL Error
+ */
+static struct xpath_prof *
+xp_prof_get(xpath_tree *xs)
+{
+    if (xs->xs_prof == NULL){
+	if ((xs->xs_prof = malloc(sizeof(*xs->xs_prof))) == NULL){
+	    clicon_err(OE_UNIX, errno, "malloc");
+	    return NULL;
+	}
+	memset(xs->xs_prof, 0, sizeof(*xs->xs_prof));
+    }
+    return xs->xs_prof;
+}
+
 /*! Eval an XPATH nodetest
  * @retval   -1     Error  XXX: retval -1 not properly handled 
  * @retval    0     No match  
@@ -130,16 +165,16 @@ nodetest_eval_node(cxobj      *x,
     /* Namespaces is s0, name is s1 */
     if (strcmp(xs->xs_s1, "*")==0)
 	return 1;
-    /* get namespace of xml tree */
-    if (xml2ns(x, prefix1, &nsxml) < 0)
-	goto done;
     prefix2 = xs->xs_s0;
     name2 = xs->xs_s1;
     /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) != 0){
+    if (!xml_name_eq(name1, name2)){
 	retval = 0; /* no match */
 	goto done;
     }
+    /* get namespace of xml tree */
+    if (xml2ns(x, prefix1, &nsxml) < 0)
+	goto done;
     /* here names are equal 
      * Now look for namespaces
      * 1) prefix1 and prefix2 point to same namespace <<-- try this first
@@ -160,7 +195,7 @@ nodetest_eval_node(cxobj      *x,
 	else if (prefix1 == NULL || prefix2 == NULL)
 	    retval = 0;
 	else
-	    retval = strcmp(prefix1, prefix2) == 0;
+	    retval = xml_name_eq(prefix1, prefix2);
     }
 #if 0 /* debugging */
     /* If retval == 0 here, then there is name match, but not ns match */
@@ -221,6 +256,8 @@ nodetest_eval(cxobj      *x,
 {
     int   retval = 0; /* NB: no match is default (not error) */
 
+    if (_xp_profile)
+	_xp_visits++;
     if (xs->xs_type == XP_NODE){
 	if (localonly)
 	    retval = nodetest_eval_node_localonly(x, xs, nsc);
@@ -241,15 +278,57 @@ nodetest_eval(cxobj      *x,
     return retval;
 }
 
-/*!
+/*! Recursive part of nodetest_recursive
+ * @param[in]  names      Filter bits of nodetest name, or 0 if no pruning
+ * @see nodetest_recursive
+ */
+static int
+nodetest_recursive1(cxobj      *xn, 
+		    xpath_tree *nodetest,
+		    int         node_type,
+		    uint16_t    flags,
+		    cvec       *nsc,
+		    int         localonly,
+		    uint64_t    names,
+		    xp_ctx     *xr)
+{
+    int        retval = -1;
+    cxobj     *xsub; 
+    yang_stmt *ys;
+
+    xsub = NULL;
+    while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
+	if (nodetest_eval(xsub, nodetest, nsc, localonly) == 1){
+	    clixon_debug(CLIXON_DBG_XPATH, 2, "%s %x %x", __FUNCTION__, flags, xml_flag(xsub, flags));
+	    if (flags==0x0 || xml_flag(xsub, flags))
+		if (ctx_nodeset_append(xr, xsub) < 0)
+		    goto done;
+	    //	    continue; /* Dont go deeper */
+	}
+	/* Skip subtree if no descendant in schema can have the name */
+	if (names &&
+	    (ys = xml_spec(xsub)) != NULL &&
+	    (yang_desc_names_get(ys) & names) != names)
+	    continue;
+	if (nodetest_recursive1(xsub, nodetest, node_type, flags, nsc, localonly, names, xr) < 0)
+	    goto done;
+    }
+    retval = 0;
+  done:
+    return retval;
+}
+
+/*! Find descendants matching a nodetest, ie // descendant axis
+ *
+ * If the nodetest is a name and the tree is yang bound, subtrees whose schema has no
+ * descendant data node with that name are skipped, see yang_desc_names_get
  * @param[in]  xn
  * @param[in]  nodetest   XPATH stack
  * @param[in]  node_type
  * @param[in]  flags
  * @param[in]  nsc        XML Namespace context
  * @param[in]  localonly  Skip prefix and namespace tests (non-standard)
- * @param[out] vec0
- * @param[out] vec0len
+ * @param[out] xr         Matching nodes are appended to nodeset of this context
  */
 int
 nodetest_recursive(cxobj      *xn, 
@@ -258,31 +337,15 @@ nodetest_recursive(cxobj      *xn,
 		   uint16_t    flags,
 		   cvec       *nsc,
 		   int         localonly,
-		   cxobj    ***vec0,
-		   int        *vec0len)
+		   xp_ctx     *xr)
 {
-    int     retval = -1;
-    cxobj  *xsub; 
-    cxobj **vec = *vec0;
-    int     veclen = *vec0len;
+    uint64_t names = 0;
 
-    xsub = NULL;
-    while ((xsub = xml_child_each(xn, xsub, node_type)) != NULL) {
-	if (nodetest_eval(xsub, nodetest, nsc, localonly) == 1){
-	    clicon_debug(2, "%s %x %x", __FUNCTION__, flags, xml_flag(xsub, flags));
-	    if (flags==0x0 || xml_flag(xsub, flags))
-		if (cxvec_append(xsub, &vec, &veclen) < 0)
-		    goto done;
-	    //	    continue; /* Dont go deeper */
-	}
-	if (nodetest_recursive(xsub, nodetest, node_type, flags, nsc, localonly, &vec, &veclen) < 0)
-	    goto done;
-    }
-    retval = 0;
-    *vec0 = vec;
-    *vec0len = veclen;
-  done:
-    return retval;
+    if (node_type == CX_ELMNT &&
+	nodetest && nodetest->xs_type == XP_NODE &&
+	nodetest->xs_s1 && strcmp(nodetest->xs_s1, "*") != 0)
+	names = yang_name_bits(nodetest->xs_s1);
+    return nodetest_recursive1(xn, nodetest, node_type, flags, nsc, localonly, names, xr);
 }
 
 /*! Evaluate xpath step rule of an XML tree
@@ -311,14 +374,24 @@ xp_eval_step(xp_ctx     *xc0,
     cxobj      *x;
     cxobj      *xv;
     cxobj      *xp;
-    cxobj     **vec = NULL;
-    int         veclen = 0;
+    xp_ctx      xn = {0,};  /* Scratch nodeset */
     xpath_tree *nodetest = xs->xs_c0;
     xp_ctx     *xc = NULL;
     int         ret;
+    uint32_t    visits = _xp_visits;
     
-    /* Create new xc */
-    if ((xc = ctx_dup(xc0)) == NULL)
+    /* Create new xc, axes that build a new node-set from xc0 need no copy of it */
+    switch (xs->xs_int){
+    case A_CHILD:
+    case A_DESCENDANT:
+    case A_PARENT:
+	xc = ctx_dup_empty(xc0);
+	break;
+    default:
+	xc = ctx_dup(xc0);
+	break;
+    }
+    if (xc == NULL)
 	goto done;
     switch (xs->xs_int){
     case A_ANCESTOR:
@@ -328,56 +401,58 @@ xp_eval_step(xp_ctx     *xc0,
     case A_ATTRIBUTE: /* principal node type is attribute */
 	break;
     case A_CHILD:
-	if (xc->xc_descendant){
-	    for (i=0; i<xc->xc_size; i++){
-		xv = xc->xc_nodeset[i];
-		if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+	if (xc0->xc_descendant){
+	    for (i=0; i<xc0->xc_size; i++){
+		xv = xc0->xc_nodeset[i];
+		if (nodetest_recursive(xv, nodetest, CX_ELMNT, 0x0, nsc, localonly, &xn) < 0)
 		    goto done;
 	    }
 	    xc->xc_descendant = 0;
 	}
 	else{
-	    for (i=0; i<xc->xc_size; i++){ 
-		xv = xc->xc_nodeset[i];
+	    for (i=0; i<xc0->xc_size; i++){ 
+		xv = xc0->xc_nodeset[i];
 		x = NULL; 
-		if ((ret = xpath_optimize_check(xs, xv, &vec, &veclen)) < 0)
+		if ((ret = xpath_optimize_check(xs, xv, &xn)) < 0)
 		    goto done;
+		if (_xp_profile && xs->xs_prof){
+		    if (ret)
+			xs->xs_prof->xp_opthit++;
+		    else
+			xs->xs_prof->xp_optmiss++;
+		}
 		if (ret == 0){/* regular code, no optimization made */
 		    while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
 			/* xs->xs_c0 is nodetest */
 			if (nodetest == NULL || nodetest_eval(x, nodetest, nsc, localonly) == 1){
-			    if (cxvec_append(x, &vec, &veclen) < 0)
+			    if (ctx_nodeset_append(&xn, x) < 0)
 				goto done;
 			}
 		    }
 		} 
 	    }
 	}
-	ctx_nodeset_replace(xc, vec, veclen);
+	ctx_nodeset_move(xc, &xn);
 	break;
     case A_DESCENDANT_OR_SELF:
 	for (i=0; i<xc->xc_size; i++){
 	    xv = xc->xc_nodeset[i];
-	    if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+	    if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &xn) < 0)
 		goto done;
 	}
-	for (i=0; i<veclen; i++){
-	    x = vec[i];
-	    if (cxvec_append(x, &xc->xc_nodeset, &xc->xc_size) < 0)
+	for (i=0; i<xn.xc_size; i++){
+	    x = xn.xc_nodeset[i];
+	    if (ctx_nodeset_append(xc, x) < 0)
 		goto done;
 	}
-	if (vec){
-	    free(vec);
-	    vec = NULL;
-	}
 	break;
     case A_DESCENDANT:
-	for (i=0; i<xc->xc_size; i++){
-	    xv = xc->xc_nodeset[i];
-	    if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &vec, &veclen) < 0)
+	for (i=0; i<xc0->xc_size; i++){
+	    xv = xc0->xc_nodeset[i];
+	    if (nodetest_recursive(xv, xs->xs_c0, CX_ELMNT, 0x0, nsc, localonly, &xn) < 0)
 		goto done;
 	}
-	ctx_nodeset_replace(xc, vec, veclen);
+	ctx_nodeset_move(xc, &xn);
 	break;
     case A_FOLLOWING:
 	break;
@@ -386,20 +461,13 @@ xp_eval_step(xp_ctx     *xc0,
     case A_NAMESPACE: /* principal node type is namespace */
 	break;
     case A_PARENT:
-	veclen = xc->xc_size;
-	vec = xc->xc_nodeset;
-	xc->xc_size = 0;
-	xc->xc_nodeset = NULL;
-	for (i=0; i<veclen; i++){
-	    x = vec[i];
+	for (i=0; i<xc0->xc_size; i++){
+	    x = xc0->xc_nodeset[i];
 	    if ((xp = xml_parent(x)) != NULL)
-		if (cxvec_append(xp, &xc->xc_nodeset, &xc->xc_size) < 0)
+		if (ctx_nodeset_append(&xn, xp) < 0)
 		    goto done;
 	}
-	if (vec){
-	    free(vec);
-	    vec = NULL;
-	}
+	ctx_nodeset_move(xc, &xn);
 	break;
     case A_PRECEDING:
 	break;
@@ -412,7 +480,11 @@ xp_eval_step(xp_ctx     *xc0,
 	goto done;
 	break;
     }
-    if (xs->xs_c1){
+    if (_xp_profile && xs->xs_prof)
+	xs->xs_prof->xp_visits += _xp_visits - visits;
+    /* Predicates, skip if none: every step has a (possibly empty) predicate list */
+    if (xs->xs_c1 &&
+	(xs->xs_c1->xs_type != XP_PRED || xs->xs_c1->xs_c0 || xs->xs_c1->xs_c1)){
 	if (xp_eval(xc, xs->xs_c1, nsc, localonly, xrp) < 0)
 	    goto done;
     }
@@ -423,11 +495,157 @@ xp_eval_step(xp_ctx     *xc0,
     assert(*xrp);
     retval = 0;
  done:
+    ctx_nodeset_clear(&xn);
     if (xc)
 	ctx_free(xc);
     return retval;
 }
 
+/*! Descend a unary XPath tree node of given type, ie one with only a first child
+ * @param[in]  xs    XPath tree node, may be NULL
+ * @param[in]  type  Expected node type
+ * @retval     xc    First child xs_c0
+ * @retval     NULL  xs is NULL, not of type or has two children
+ */
+static xpath_tree *
+xp_unary(xpath_tree  *xs,
+	 enum xp_type type)
+{
+    if (xs == NULL || xs->xs_type != type || xs->xs_c1 != NULL)
+	return NULL;
+    return xs->xs_c0;
+}
+
+/*! Match an operand being a single child nodetest without predicates, eg k or a:k
+ * @param[in]  xs        XPath tree of type ADD
+ * @retval     nodetest  XPath tree of type NODE
+ * @retval     NULL      No match
+ */
+static xpath_tree *
+xp_pred_name(xpath_tree *xs)
+{
+    xpath_tree *xp;
+
+    xs = xp_unary(xs, XP_ADD);
+    xs = xp_unary(xs, XP_UNION);
+    xs = xp_unary(xs, XP_PATHEXPR);
+    xs = xp_unary(xs, XP_LOCPATH);
+    if ((xs = xp_unary(xs, XP_RELLOCPATH)) == NULL)
+	return NULL;
+    if (xs->xs_type != XP_STEP || xs->xs_int != A_CHILD)
+	return NULL;
+    if ((xp = xs->xs_c1) != NULL && (xp->xs_c0 != NULL || xp->xs_c1 != NULL))
+	return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_NODE || xs->xs_s1 == NULL)
+	return NULL;
+    return xs;
+}
+
+/*! Match an operand being a literal, eg 'x' or 42
+ * @param[in]  xs    XPath tree of type ADD
+ * @retval     xl    XPath tree of type PRIME_STR or PRIME_NR
+ * @retval     NULL  No match
+ */
+static xpath_tree *
+xp_pred_literal(xpath_tree *xs)
+{
+    xs = xp_unary(xs, XP_ADD);
+    xs = xp_unary(xs, XP_UNION);
+    xs = xp_unary(xs, XP_PATHEXPR);
+    if ((xs = xp_unary(xs, XP_FILTEREXPR)) == NULL)
+	return NULL;
+    if (xs->xs_type != XP_PRIME_STR && xs->xs_type != XP_PRIME_NR)
+	return NULL;
+    return xs;
+}
+
+/*! Match a simple predicate expression that can be evaluated without contexts
+ *
+ * Either a position: [<number>] or an equality of a child and a string: [<name>='<str>']
+ * or ['<str>'=<name>]
+ * @param[in]  xe        XPath tree of predicate expression, type EXP
+ * @param[out] nodetest  Nodetest of child in equality
+ * @param[out] xl        Literal: number if nodetest is NULL, otherwise string
+ * @retval     1         Match
+ * @retval     0         No match
+ */
+static int
+xp_pred_simple(xpath_tree  *xe,
+	       xpath_tree **nodetest,
+	       xpath_tree **xl)
+{
+    xpath_tree *xr;
+    xpath_tree *x0;
+    xpath_tree *xn;
+    xpath_tree *xv;
+
+    if ((xe = xp_unary(xe, XP_EXP)) == NULL ||
+	(xr = xp_unary(xe, XP_AND)) == NULL ||
+	xr->xs_type != XP_RELEX)
+	return 0;
+    if (xr->xs_c1 == NULL){ /* [<number>] */
+	if ((xv = xp_pred_literal(xr->xs_c0)) == NULL || xv->xs_type != XP_PRIME_NR)
+	    return 0;
+	*nodetest = NULL;
+	*xl = xv;
+	return 1;
+    }
+    if (xr->xs_int != XO_EQ ||
+	(x0 = xp_unary(xr->xs_c0, XP_RELEX)) == NULL)
+	return 0;
+    if ((xn = xp_pred_name(x0)) != NULL)
+	xv = xp_pred_literal(xr->xs_c1);
+    else if ((xn = xp_pred_name(xr->xs_c1)) != NULL)
+	xv = xp_pred_literal(x0);
+    else
+	return 0;
+    if (xv == NULL || xv->xs_type != XP_PRIME_STR)
+	return 0;
+    *nodetest = xn;
+    *xl = xv;
+    return 1;
+}
+
+/*! Evaluate simple predicate for a node, same result as xp_eval + conversion to boolean
+ * @param[in]  x         XML node, context node of predicate
+ * @param[in]  i         Context position of x
+ * @param[in]  nodetest  Nodetest of child in equality, or NULL if position
+ * @param[in]  xl        Literal
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @retval     1         True
+ * @retval     0         False
+ * @see xp_pred_simple
+ */
+static int
+xp_pred_simple_eval(cxobj      *x,
+		    int         i,
+		    xpath_tree *nodetest,
+		    xpath_tree *xl,
+		    cvec       *nsc,
+		    int         localonly)
+{
+    cxobj *xc = NULL;
+    char  *s1;
+    char  *s2;
+
+    if (nodetest == NULL)
+	return (int)xl->xs_double == i;
+    s2 = xl->xs_s0;
+    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL) {
+	if (nodetest_eval(xc, nodetest, nsc, localonly) != 1)
+	    continue;
+	s1 = xml_body(xc);
+	if (s1 == NULL || s2 == NULL){
+	    if (s1 == NULL && s2 == NULL)
+		return 1;
+	}
+	else if (strcmp(s1, s2) == 0)
+	    return 1;
+    }
+    return 0;
+}
+
 /*! Evaluate xpath predicates rule
  *
  * pred -> pred expr
@@ -451,6 +669,8 @@ xp_eval_step(xp_ctx     *xc0,
  * - if the result is not a number, then the result will be converted as if by a
  *   call to the boolean function. 
  * Thus a location path para[3] is equivalent to para[position()=3].
+ * Simple predicates, a position or an equality of a child and a string, are evaluated
+ * inline without creating contexts, see xp_pred_simple.
  */
 static int
 xp_eval_predicate(xp_ctx     *xc,
@@ -459,71 +679,78 @@ xp_eval_predicate(xp_ctx     *xc,
 		  int         localonly,
 		  xp_ctx    **xrp)
 {
-    int      retval = -1;
-    xp_ctx  *xr0 = NULL;
-    xp_ctx  *xr1 = NULL;
-    xp_ctx  *xrc = NULL;
-    int      i;
-    cxobj   *x;
-    xp_ctx  *xcc;
+    int         retval = -1;
+    xp_ctx     *xr0 = NULL;
+    xp_ctx     *xr1 = NULL;
+    xp_ctx     *xrc = NULL;
+    xp_ctx     *xcc = NULL;
+    xp_ctx     *xs0;       /* Node-set to filter, not copied */
+    int         i;
+    cxobj      *x;
+    xpath_tree *nodetest = NULL;
+    xpath_tree *xl = NULL;
+    int         simple;
+    int         match;
     
-    if (xs->xs_c0 == NULL){ /* empty */
-	if ((xr0 = ctx_dup(xc)) == NULL)
-	    goto done;
-    }
+    if (xs->xs_c0 == NULL) /* empty */
+	xs0 = xc;
     else{ /* eval previous predicates */
 	if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0) 	
 	    goto done;	
+	xs0 = xr0;
     }
     if (xs->xs_c1){
 	/* Loop over each node in the nodeset */
-	assert (xr0->xc_type == XT_NODESET);
-	if ((xr1 = malloc(sizeof(*xr1))) == NULL){
-	    clicon_err(OE_UNIX, errno, "malloc");
+	assert (xs0->xc_type == XT_NODESET);
+	if ((xr1 = ctx_dup_empty(xc)) == NULL)
 	    goto done;
-	}
-	memset(xr1, 0, sizeof(*xr1));
 	xr1->xc_type = XT_NODESET;
-	xr1->xc_node = xc->xc_node;
-	xr1->xc_initial = xc->xc_initial;
-	for (i=0; i<xr0->xc_size; i++){
-	    x = xr0->xc_nodeset[i];
-	    /* Create new context */
-	    if ((xcc = malloc(sizeof(*xcc))) == NULL){
-		clicon_err(OE_XML, errno, "malloc");
-		goto done;
-	    }
-	    memset(xcc, 0, sizeof(*xcc));
-	    xcc->xc_type = XT_NODESET;
-	    xcc->xc_initial = xc->xc_initial;
-	    xcc->xc_node = x;
-	    xcc->xc_position = i;
-	    /* For each node in the node-set to be filtered, the PredicateExpr is
-	     * evaluated with that node as the context node */
-	    if (cxvec_append(x, &xcc->xc_nodeset, &xcc->xc_size) < 0)
+	xr1->xc_descendant = 0;
+	xr1->xc_position = 0;
+	simple = xp_pred_simple(xs->xs_c1, &nodetest, &xl);
+	/* One context for all candidate nodes, reset for each */
+	if (!simple){
+	    if ((xcc = ctx_dup_empty(xc)) == NULL)
 		goto done;
-	    if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
+	    if (ctx_nodeset_append(xcc, xc->xc_node) < 0)
 		goto done;
-	    if (xcc)
-		ctx_free(xcc);
-	    if (xrc->xc_type == XT_NUMBER){
-		/* If the result is a number, the result will be converted to true
-		   if the number is equal to the context position */
-		if ((int)xrc->xc_number == i)
-		    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
-			goto done;		    
-	    }
+	}
+	for (i=0; i<xs0->xc_size; i++){
+	    x = xs0->xc_nodeset[i];
+	    if (_xp_profile && xs->xs_prof)
+		xs->xs_prof->xp_preds++;
+	    if (simple)
+		match = xp_pred_simple_eval(x, i, nodetest, xl, nsc, localonly);
 	    else {
-		/* if PredicateExpr evaluates to true for that node, the node is 
-		   included in the new node-set */
-		if (ctx2boolean(xrc))
-		    if (cxvec_append(x, &xr1->xc_nodeset, &xr1->xc_size) < 0)
-			goto done;		    
-	    }
-	    if (xrc)
+		/* For each node in the node-set to be filtered, the PredicateExpr is
+		 * evaluated with that node as the context node */
+		xcc->xc_type = XT_NODESET;
+		xcc->xc_descendant = 0;
+		xcc->xc_node = x;
+		xcc->xc_position = i;
+		xcc->xc_nodeset[0] = x;
+		xcc->xc_size = 1;
+		if (xp_eval(xcc, xs->xs_c1, nsc, localonly, &xrc) < 0)
+		    goto done;
+		if (xrc->xc_type == XT_NUMBER)
+		    /* If the result is a number, the result will be converted to true
+		       if the number is equal to the context position */
+		    match = ((int)xrc->xc_number == i);
+		else
+		    /* if PredicateExpr evaluates to true for that node, the node is 
+		       included in the new node-set */
+		    match = ctx2boolean(xrc);
 		ctx_free(xrc);
+		xrc = NULL;
+	    }
+	    if (match)
+		if (ctx_nodeset_append(xr1, x) < 0)
+		    goto done;		    
 	}
     }
+    else if (xr0 == NULL)
+	if ((xr0 = ctx_dup(xc)) == NULL)
+	    goto done;
     assert(xr0||xr1);
     if (xr1){
 	*xrp = xr1;
@@ -536,6 +763,10 @@ xp_eval_predicate(xp_ctx     *xc,
 	}
     retval = 0;
  done:
+    if (xcc)
+	ctx_free(xcc);
+    if (xrc)
+	ctx_free(xrc);
     if (xr0)
 	ctx_free(xr0);
     if (xr1)
@@ -543,6 +774,227 @@ xp_eval_predicate(xp_ctx     *xc,
     return retval;
 }
 
+/* Max number of steps in a streamed location path, see xp_eval_stream */
+#define XP_STREAM_STEPS 32
+
+/* Step of a streamed location path */
+struct xp_stream_step{
+    int         ss_axis;        /* A_CHILD, A_PARENT or A_SELF */
+    int         ss_descendant;  /* Child step matches any descendant, ie after // */
+    xpath_tree *ss_nodetest;    /* Nodetest, NULL for parent and self */
+    uint64_t    ss_names;       /* Filter bits of nodetest name, see nodetest_recursive */
+    xpath_tree *ss_preds;       /* Predicates, all [<name>='<str>'] */
+};
+
+/* Streamed location path and callback */
+struct xp_stream{
+    struct xp_stream_step st_step[XP_STREAM_STEPS];
+    int                   st_len;
+    cvec                 *st_nsc;
+    int                   st_localonly;
+    xp_stream_fn         *st_fn;
+    void                 *st_arg;
+};
+
+/*! Check that predicates of a step are all [<name>='<str>'], ie without positions
+ */
+static int
+xp_stream_preds_ok(xpath_tree *xp)
+{
+    xpath_tree *nodetest;
+    xpath_tree *xl;
+
+    for (; xp != NULL && xp->xs_type == XP_PRED; xp = xp->xs_c0)
+	if (xp->xs_c1 &&
+	    (xp_pred_simple(xp->xs_c1, &nodetest, &xl) == 0 || nodetest == NULL))
+	    return 0;
+    return xp == NULL;
+}
+
+/*! Evaluate the predicates of a step for a node, see xp_stream_preds_ok
+ */
+static int
+xp_stream_preds_eval(cxobj      *x,
+		     xpath_tree *xp,
+		     cvec       *nsc,
+		     int         localonly)
+{
+    xpath_tree *nodetest;
+    xpath_tree *xl;
+
+    for (; xp != NULL; xp = xp->xs_c0)
+	if (xp->xs_c1){
+	    xp_pred_simple(xp->xs_c1, &nodetest, &xl);
+	    if (xp_pred_simple_eval(x, 0, nodetest, xl, nsc, localonly) == 0)
+		return 0;
+	}
+    return 1;
+}
+
+/*! Collect the steps of a relative location path into a stream, left to right
+ * @retval  1  OK
+ * @retval  0  Path cannot be streamed
+ */
+static int
+xp_stream_rellocpath(xpath_tree       *xs,
+		     int               descendant,
+		     struct xp_stream *st)
+{
+    xpath_tree            *xstep;
+    struct xp_stream_step *ss;
+    int                    i;
+
+    if (xs == NULL || xs->xs_type != XP_RELLOCPATH)
+	return 0;
+    if (xs->xs_c1){ /* rellocpath / step  or  rellocpath // step */
+	if (xp_stream_rellocpath(xs->xs_c0, descendant, st) == 0)
+	    return 0;
+	descendant = (xs->xs_int == A_DESCENDANT_OR_SELF);
+	xstep = xs->xs_c1;
+    }
+    else
+	xstep = xs->xs_c0;
+    if (xstep == NULL || xstep->xs_type != XP_STEP || st->st_len >= XP_STREAM_STEPS)
+	return 0;
+    ss = &st->st_step[st->st_len];
+    memset(ss, 0, sizeof(*ss));
+    ss->ss_axis = xstep->xs_int;
+    switch (ss->ss_axis){
+    case A_CHILD:
+	if ((ss->ss_nodetest = xstep->xs_c0) == NULL ||
+	    ss->ss_nodetest->xs_type != XP_NODE ||
+	    xp_stream_preds_ok(xstep->xs_c1) == 0)
+	    return 0;
+	/* At most one // since nested descendant searches may give duplicates */
+	if (descendant)
+	    for (i=0; i<st->st_len; i++)
+		if (st->st_step[i].ss_descendant)
+		    return 0;
+	ss->ss_descendant = descendant;
+	if (ss->ss_nodetest->xs_s1 && strcmp(ss->ss_nodetest->xs_s1, "*") != 0)
+	    ss->ss_names = yang_name_bits(ss->ss_nodetest->xs_s1);
+	ss->ss_preds = xstep->xs_c1;
+	break;
+    case A_PARENT:
+    case A_SELF:
+	/* Only leading, after a child step several nodes may have the same parent */
+	if (descendant || (st->st_len != 0 && st->st_step[st->st_len-1].ss_axis == A_CHILD))
+	    return 0;
+	if (xstep->xs_c1 && (xstep->xs_c1->xs_c0 || xstep->xs_c1->xs_c1))
+	    return 0;
+	break;
+    default:
+	return 0;
+    }
+    st->st_len++;
+    return 1;
+}
+
+/*! Apply step i of stream to a context node and call callback for each result node
+ * @retval -1  Error
+ * @retval  0  Continue
+ * @retval  1  Stop, callback requested stop
+ */
+static int
+xp_stream_walk(cxobj            *xv,
+	       struct xp_stream *st,
+	       int               i)
+{
+    struct xp_stream_step *ss;
+    cxobj                 *x;
+    yang_stmt             *ys;
+    int                    ret;
+
+    if (i == st->st_len)
+	return (*st->st_fn)(st->st_arg, xv);
+    ss = &st->st_step[i];
+    switch (ss->ss_axis){
+    case A_PARENT:
+	if ((x = xml_parent(xv)) == NULL)
+	    return 0;
+	return xp_stream_walk(x, st, i+1);
+    case A_SELF:
+	return xp_stream_walk(xv, st, i+1);
+    default:
+	break;
+    }
+    x = NULL;
+    while ((x = xml_child_each(xv, x, CX_ELMNT)) != NULL) {
+	if (nodetest_eval(x, ss->ss_nodetest, st->st_nsc, st->st_localonly) == 1 &&
+	    xp_stream_preds_eval(x, ss->ss_preds, st->st_nsc, st->st_localonly) == 1){
+	    if ((ret = xp_stream_walk(x, st, i+1)) != 0)
+		return ret;
+	}
+	if (ss->ss_descendant){
+	    /* Skip subtree if no descendant in schema can have the name */
+	    if (ss->ss_names &&
+		(ys = xml_spec(x)) != NULL &&
+		(yang_desc_names_get(ys) & ss->ss_names) != ss->ss_names)
+		continue;
+	    if ((ret = xp_stream_walk(x, st, i)) != 0)
+		return ret;
+	}
+    }
+    return 0;
+}
+
+/*! Evaluate a location path without building its node-set
+ *
+ * The callback is called for each node of the resulting node-set in document order
+ * and may stop the evaluation, eg when computing count, sum or existence.
+ * Only paths of child steps with [<name>='<str>'] predicates, at most one //, and
+ * leading . or .. steps are streamed, and only from a single context node.
+ * @param[in]  xc        Context, single node
+ * @param[in]  xs        XPath tree, argument of aggregate function
+ * @param[in]  nsc       XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[in]  fn        Callback: -1 error, 0 continue, 1 stop
+ * @param[in]  arg       Argument to callback
+ * @retval    -1         Error
+ * @retval     0         Path cannot be streamed, use xp_eval
+ * @retval     1         OK, callback has been called for all nodes or stopped
+ */
+int
+xp_eval_stream(xp_ctx       *xc,
+	       xpath_tree   *xs,
+	       cvec         *nsc,
+	       int           localonly,
+	       xp_stream_fn *fn,
+	       void         *arg)
+{
+    struct xp_stream st = {{{0,}},};
+    cxobj           *x;
+    int              descendant = 0;
+
+    if (xc->xc_type != XT_NODESET || xc->xc_size != 1 || xc->xc_descendant)
+	return 0;
+    xs = xp_unary(xs, XP_EXP);
+    xs = xp_unary(xs, XP_AND);
+    xs = xp_unary(xs, XP_RELEX);
+    xs = xp_unary(xs, XP_ADD);
+    xs = xp_unary(xs, XP_UNION);
+    xs = xp_unary(xs, XP_PATHEXPR);
+    if ((xs = xp_unary(xs, XP_LOCPATH)) == NULL)
+	return 0;
+    x = xc->xc_nodeset[0];
+    if (xs->xs_type == XP_ABSPATH){
+	x = xc->xc_node;
+	while (xml_parent(x) != NULL)
+	    x = xml_parent(x);
+	descendant = (xs->xs_int == A_DESCENDANT_OR_SELF);
+	xs = xs->xs_c0;
+    }
+    if (xp_stream_rellocpath(xs, descendant, &st) == 0)
+	return 0;
+    st.st_nsc = nsc;
+    st.st_localonly = localonly;
+    st.st_fn = fn;
+    st.st_arg = arg;
+    if (xp_stream_walk(x, &st, 0) < 0)
+	return -1;
+    return 1;
+}
+
 /*! Given two XPATH contexts, eval logical  operations: or,and
  * The logical operators convert their operands to booleans
  * @param[in]  xc1  Context of operand1
@@ -925,10 +1377,10 @@ xp_union(xp_ctx    *xc1,
     xr->xc_type = XT_NODESET;
 
     for (i=0; i<xc1->xc_size; i++)
-	if (cxvec_append(xc1->xc_nodeset[i], &xr->xc_nodeset, &xr->xc_size) < 0)
+	if (ctx_nodeset_append(xr, xc1->xc_nodeset[i]) < 0)
 	    goto done;
     for (i=0; i<xc2->xc_size; i++){
-	if (cxvec_append(xc2->xc_nodeset[i], &xr->xc_nodeset, &xr->xc_size) < 0)
+	if (ctx_nodeset_append(xr, xc2->xc_nodeset[i]) < 0)
 	    goto done;
     }
     *xrp = xr;
@@ -948,6 +1400,8 @@ xp_union(xp_ctx    *xc1,
  * @param[out] xrp  Resulting context
  * @retval     0    OK
  * @retval    -1    Error
+ * If profiling is enabled, counters and time are added to xs_prof of each node
+ * @see xp_eval_profile_set
  */
 int
 xp_eval(xp_ctx     *xc,
@@ -962,8 +1416,17 @@ xp_eval(xp_ctx     *xc,
     xp_ctx    *xr1 = NULL;
     xp_ctx    *xr2 = NULL;
     int        use_xr0 = 0; /* In 2nd child use transitively result of 1st child */
+    struct xpath_prof *xp = NULL;
+    struct timespec    t0 = {0,};
+    struct timespec    t1;
     
-    if (clicon_debug_get() > 1)
+    if (_xp_profile){
+	if ((xp = xp_prof_get(xs)) == NULL)
+	    goto done;
+	xp->xp_evals++;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+    }
+    if (clixon_debug_enabled(CLIXON_DBG_XPATH, 2))
 	ctx_print(stderr, xc, xpath_tree_int2str(xs->xs_type));
     /* Pre-actions before check first child c0
      */
@@ -1028,11 +1491,21 @@ xp_eval(xp_ctx     *xc,
 		    goto done;
 		goto ok;
 		break;
+	    case XPATHFN_SUM:
+		if (xp_function_sum(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
+		    goto done;
+		goto ok;
+		break;
 	    case XPATHFN_NAME:
 		if (xp_function_name(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
 		    goto done;
 		goto ok;
 		break;
+	    case XPATHFN_STARTS_WITH:
+		if (xp_function_starts_with(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
+		    goto done;
+		goto ok;
+		break;
 	    case XPATHFN_CONTAINS:
 		if (xp_function_contains(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
 		    goto done;
@@ -1043,6 +1516,11 @@ xp_eval(xp_ctx     *xc,
 		    goto done;
 		goto ok;
 		break;
+	    case XPATHFN_BOOLEAN:
+		if (xp_function_boolean(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
+		    goto done;
+		goto ok;
+		break;
 	    case XPATHFN_TRUE:
 		if (xp_function_true(xc, xs->xs_c0, nsc, localonly, xrp) < 0)
 		    goto done;
@@ -1103,7 +1581,7 @@ xp_eval(xp_ctx     *xc,
 	    xr0->xc_type = XT_NODESET;
 	    x = NULL;
 	    while ((x = xml_child_each(xc->xc_node, x, CX_ELMNT)) != NULL) {
-		if (cxvec_append(x, &xr0->xc_nodeset, &xr0->xc_size) < 0)
+		if (ctx_nodeset_append(xr0, x) < 0)
 		    goto done;
 	    }
 	}
@@ -1193,10 +1671,14 @@ xp_eval(xp_ctx     *xc,
 	    xr0 = NULL;
 	}
  ok:
-    if (clicon_debug_get() > 1)
+    if (clixon_debug_enabled(CLIXON_DBG_XPATH, 2))
 	ctx_print(stderr, *xrp, xpath_tree_int2str(xs->xs_type));
     retval = 0;
  done:
+    if (xp){
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	xp->xp_usec += (t1.tv_sec - t0.tv_sec)*1000000 + (t1.tv_nsec - t0.tv_nsec)/1000;
+    }
     if (xr2)
 	ctx_free(xr2);
     if (xr1)
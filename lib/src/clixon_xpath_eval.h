@@ -37,6 +37,16 @@
 #ifndef _CLIXON_XPATH_EVAL_H
 #define _CLIXON_XPATH_EVAL_H
 
+/*
+ * Types
+ */
+/*! Callback for each node of a streamed node-set, see xp_eval_stream
+ * @retval -1  Error
+ * @retval  0  Continue
+ * @retval  1  Stop
+ */
+typedef int (xp_stream_fn)(void *arg, cxobj *x);
+
 /*
  * Variables
  */
@@ -46,5 +56,7 @@ extern const map_str2int xpopmap[];
  * Prototypes
  */
 int xp_eval(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
+int xp_eval_stream(xp_ctx *xc, xpath_tree *xs, cvec *nsc, int localonly, xp_stream_fn *fn, void *arg);
+int xp_eval_profile_set(int enable);
 
 #endif /* _CLIXON_XPATH_EVAL_H */
@@ -228,6 +228,7 @@ derived_from_one(char  *baseidentity,
     yang_stmt *ytype;
     yang_stmt *ybaseid;
     yang_stmt *ymod;
+    yang_stmt *yid;
     cvec      *idrefvec; /* Derived identityref list: (module:id)**/
     char      *node = NULL;
     char      *prefix = NULL;
@@ -279,6 +280,10 @@ derived_from_one(char  *baseidentity,
 	strcmp(baseid, id) == 0){
 	; /* match */
     }
+    else if ((yid = yang_find(ymod, Y_IDENTITY, id)) != NULL &&
+	     yang_identity_derived(yid, ybaseid)){
+	; /* match with resolved identities */
+    }
     else {
 	/* Allocate cbuf */
 	if ((cb = cbuf_new()) == NULL){
@@ -414,9 +419,42 @@ xp_function_position(xp_ctx            *xc,
     return retval;
 }
 
+/*! Stream callback of count, count nodes */
+static int
+xp_count_cb(void  *arg,
+	    cxobj *x)
+{
+    (*(double *)arg)++;
+    return 0;
+}
+
+/*! Stream callback of sum, add number value of nodes */
+static int
+xp_sum_cb(void  *arg,
+	  cxobj *x)
+{
+    char  *body;
+    double n;
+
+    if ((body = xml_body(x)) == NULL || sscanf(body, "%lf", &n) != 1)
+	n = NAN;
+    *(double *)arg += n;
+    return 0;
+}
+
+/*! Stream callback of boolean and not, stop at first node */
+static int
+xp_exists_cb(void  *arg,
+	     cxobj *x)
+{
+    *(int *)arg = 1;
+    return 1;
+}
+
 /*! The count function returns the number of nodes in the argument node-set.
  *
  * Signature: number count(node-set)
+ * The node-set is not built if the argument can be streamed, see xp_eval_stream
  */
 int
 xp_function_count(xp_ctx            *xc,
@@ -428,20 +466,28 @@ xp_function_count(xp_ctx            *xc,
     int         retval = -1;
     xp_ctx     *xr = NULL;
     xp_ctx     *xr0 = NULL;
+    double      n = 0;
+    int         ret;
     
     if (xs == NULL || xs->xs_c0 == NULL){
 	clicon_err(OE_XML, EINVAL, "count expects but did not get one argument");
 	goto done;
     }
-    if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0) 	
+    if ((ret = xp_eval_stream(xc, xs->xs_c0, nsc, localonly, xp_count_cb, &n)) < 0)
 	goto done;
+    if (ret == 0){
+	if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0) 	
+	    goto done;
+	n = xr0->xc_size;
+    }
     if ((xr = malloc(sizeof(*xr))) == NULL){
 	clicon_err(OE_UNIX, errno, "malloc");
 	goto done;
     }
     memset(xr, 0, sizeof(*xr));
+    xr->xc_initial = xc->xc_initial;
     xr->xc_type = XT_NUMBER;
-    xr->xc_number = xr0->xc_number;
+    xr->xc_number = n;
     *xrp = xr;
     retval = 0;
  done:
@@ -450,6 +496,125 @@ xp_function_count(xp_ctx            *xc,
     return retval;
 }
 
+/*! The sum function returns the sum of the number values of the nodes in a node-set.
+ *
+ * Signature: number sum(node-set)
+ * The node-set is not built if the argument can be streamed, see xp_eval_stream
+ */
+int
+xp_function_sum(xp_ctx            *xc,
+		struct xpath_tree *xs,
+		cvec              *nsc,
+		int                localonly,
+		xp_ctx           **xrp)
+{
+    int         retval = -1;
+    xp_ctx     *xr = NULL;
+    xp_ctx     *xr0 = NULL;
+    double      n = 0;
+    int         i;
+    int         ret;
+    
+    if (xs == NULL || xs->xs_c0 == NULL){
+	clicon_err(OE_XML, EINVAL, "sum expects but did not get one argument");
+	goto done;
+    }
+    if ((ret = xp_eval_stream(xc, xs->xs_c0, nsc, localonly, xp_sum_cb, &n)) < 0)
+	goto done;
+    if (ret == 0){
+	if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0) 	
+	    goto done;
+	if (xr0->xc_type != XT_NODESET){
+	    clicon_err(OE_XML, EINVAL, "sum expects a node-set argument");
+	    goto done;
+	}
+	for (i=0; i<xr0->xc_size; i++)
+	    xp_sum_cb(&n, xr0->xc_nodeset[i]);
+    }
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_initial = xc->xc_initial;
+    xr->xc_type = XT_NUMBER;
+    xr->xc_number = n;
+    *xrp = xr;
+    retval = 0;
+ done:
+    if (xr0)
+	ctx_free(xr0);
+    return retval;
+}
+
+/*! Evaluate argument of boolean or not as a boolean
+ *
+ * If the argument is a node-set that can be streamed, stop at the first node
+ * @retval  -1  Error
+ * @retval   0  False
+ * @retval   1  True
+ */
+static int
+xp_function_arg2boolean(xp_ctx            *xc,
+			struct xpath_tree *xs,
+			cvec              *nsc,
+			int                localonly)
+{
+    int         retval = -1;
+    xp_ctx     *xr0 = NULL;
+    int         exists = 0;
+    int         ret;
+
+    if ((ret = xp_eval_stream(xc, xs, nsc, localonly, xp_exists_cb, &exists)) < 0)
+	goto done;
+    if (ret == 1)
+	retval = exists;
+    else{
+	if (xp_eval(xc, xs, nsc, localonly, &xr0) < 0) 	
+	    goto done;
+	retval = ctx2boolean(xr0);
+    }
+ done:
+    if (xr0)
+	ctx_free(xr0);
+    return retval;
+}
+
+/*! The boolean function converts its argument to a boolean
+ *
+ * Signature: boolean boolean(object)
+ */
+int
+xp_function_boolean(xp_ctx            *xc,
+		    struct xpath_tree *xs,
+		    cvec              *nsc,
+		    int                localonly,
+		    xp_ctx           **xrp)
+{
+    int         retval = -1;
+    xp_ctx     *xr = NULL;
+    int         bool;
+    
+    if (xs == NULL || xs->xs_c0 == NULL){
+	clicon_err(OE_XML, EINVAL, "boolean expects but did not get one argument");
+	goto done;
+    }
+    if ((bool = xp_function_arg2boolean(xc, xs->xs_c0, nsc, localonly)) < 0)
+	goto done;
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_initial = xc->xc_initial;
+    xr->xc_type = XT_BOOL;
+    xr->xc_bool = bool;
+    *xrp = xr;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! The name function returns a string of a QName
  *
  * The name function returns a string containing a QName representing the expanded-name
@@ -502,6 +667,66 @@ xp_function_name(xp_ctx            *xc,
     return retval;
 }
 
+/*! Eval xpath function starts-with
+ * @param[in]  xc   Incoming context
+ * @param[in]  xs   XPATH node tree
+ * @param[in]  nsc  XML Namespace context
+ * @param[in]  localonly Skip prefix and namespace tests (non-standard)
+ * @param[out] xrp  Resulting context
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see https://www.w3.org/TR/xpath-10/#NT-FunctionName 4.2 String Functions
+ * @see xpath_optimize_check  where a list key prefix test is a range scan
+ */
+int
+xp_function_starts_with(xp_ctx            *xc,
+			struct xpath_tree *xs,
+			cvec              *nsc,
+			int                localonly,
+			xp_ctx           **xrp)
+{
+    int                retval = -1;
+    xp_ctx            *xr0 = NULL;
+    xp_ctx            *xr1 = NULL;
+    xp_ctx            *xr = NULL;
+    char              *s0 = NULL;
+    char              *s1 = NULL;
+
+    if (xs == NULL || xs->xs_c0 == NULL || xs->xs_c1 == NULL){
+	clicon_err(OE_XML, EINVAL, "starts-with expects but did not get two arguments");
+	goto done;
+    }
+    /* starts-with two arguments in xs: boolean starts-with(string, string) */
+    if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0) 	
+	goto done;
+    if (ctx2string(xr0, &s0) < 0)
+	goto done;
+    if (xp_eval(xc, xs->xs_c1, nsc, localonly, &xr1) < 0) 	
+	goto done;
+    if (ctx2string(xr1, &s1) < 0)
+	goto done;
+    if ((xr = malloc(sizeof(*xr))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(xr, 0, sizeof(*xr));
+    xr->xc_type = XT_BOOL;
+    xr->xc_bool = (strncmp(s0, s1, strlen(s1)) == 0);
+    *xrp = xr;
+    xr = NULL;
+    retval = 0;
+ done:
+    if (xr0)
+	ctx_free(xr0);
+    if (xr1)
+	ctx_free(xr1);
+    if (s0)
+	free(s0);
+    if (s1)
+	free(s1);
+    return retval;
+}
+
 /*! Eval xpath function contains
  * @param[in]  xc   Incoming context
  * @param[in]  xs   XPATH node tree
@@ -574,16 +799,14 @@ xp_function_not(xp_ctx            *xc,
 {
     int         retval = -1;
     xp_ctx     *xr = NULL;
-    xp_ctx     *xr0 = NULL;
     int         bool;
     
     if (xs == NULL || xs->xs_c0 == NULL){
 	clicon_err(OE_XML, EINVAL, "not expects but did not get one argument");
 	goto done;
     }
-    if (xp_eval(xc, xs->xs_c0, nsc, localonly, &xr0) < 0) 	
+    if ((bool = xp_function_arg2boolean(xc, xs->xs_c0, nsc, localonly)) < 0)
 	goto done;
-    bool = ctx2boolean(xr0);
     if ((xr = malloc(sizeof(*xr))) == NULL){
 	clicon_err(OE_UNIX, errno, "malloc");
 	goto done;
@@ -594,8 +817,6 @@ xp_function_not(xp_ctx            *xc,
     *xrp = xr;
     retval = 0;
  done:
-    if (xr0)
-	ctx_free(xr0);
     return retval;
 }
 
@@ -63,7 +63,7 @@ enum clixon_xpath_function{
     XPATHFN_NAME,                   /* XPATH 1.0 4.1 */
     XPATHFN_STRING,                 /* XPATH 1.0 4.2   NYI */
     XPATHFN_CONCAT,                 /* XPATH 1.0 4.2   NYI */
-    XPATHFN_STARTS_WITH,            /* XPATH 1.0 4.2   NYI */
+    XPATHFN_STARTS_WITH,            /* XPATH 1.0 4.2 */
     XPATHFN_CONTAINS,               /* XPATH 1.0 4.2 */
     XPATHFN_SUBSTRING_BEFORE,       /* XPATH 1.0 4.2   NYI */
     XPATHFN_SUBSTRING_AFTER,        /* XPATH 1.0 4.2   NYI */
@@ -71,13 +71,13 @@ enum clixon_xpath_function{
     XPATHFN_STRING_LENGTH,          /* XPATH 1.0 4.2   NYI */
     XPATHFN_NORMALIZE_SPACE,        /* XPATH 1.0 4.2   NYI */
     XPATHFN_TRANSLATE,              /* XPATH 1.0 4.2   NYI */
-    XPATHFN_BOOLEAN,                /* XPATH 1.0 4.3   NYI */
+    XPATHFN_BOOLEAN,                /* XPATH 1.0 4.3 */
     XPATHFN_NOT,                    /* XPATH 1.0 4.3 */
     XPATHFN_TRUE,                   /* XPATH 1.0 4.3 */
     XPATHFN_FALSE,                  /* XPATH 1.0 4.3 */
     XPATHFN_LANG,                   /* XPATH 1.0 4.3   NYI */
     XPATHFN_NUMBER,                 /* XPATH 1.0 4.4   NYI */
-    XPATHFN_SUM,                    /* XPATH 1.0 4.4   NYI */
+    XPATHFN_SUM,                    /* XPATH 1.0 4.4 */
     XPATHFN_FLOOR,                  /* XPATH 1.0 4.4   NYI */
     XPATHFN_CEILING,                /* XPATH 1.0 4.4   NYI */
     XPATHFN_ROUND,                  /* XPATH 1.0 4.4   NYI */
@@ -98,9 +98,12 @@ int xp_function_deref(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonl
 int xp_function_derived_from(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, int self, xp_ctx **xrp);
 int xp_function_position(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 int xp_function_count(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
+int xp_function_sum(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 int xp_function_name(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
+int xp_function_starts_with(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 int xp_function_contains(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 int xp_function_not(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
+int xp_function_boolean(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 int xp_function_true(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 int xp_function_false(xp_ctx *xc, struct xpath_tree *xs, cvec *nsc, int localonly, xp_ctx **xrp);
 
@@ -68,23 +68,40 @@
 #include "clixon_xml_sort.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
+#include "clixon_xpath_function.h"
 #include "clixon_xpath_optimize.h"
 
 #ifdef XPATH_LIST_OPTIMIZE
 static xpath_tree *_xmtop = NULL; /* pattern match tree top */
 static xpath_tree *_xm = NULL;
-static xpath_tree *_xe = NULL;
 static int _optimize_enable = 1;
 static int _optimize_hits = 0;
+static int _optimize_pattern_hits[XPO_NR] = {0,}; /* hits per pattern */
 #endif /* XPATH_LIST_OPTIMIZE */
 
-/* XXX development in clixon_xpath_eval */
+/*! Get and reset xpath optimize statistics
+ * @param[out] hits     Total number of optimized lookups
+ * @param[out] pattern  Number of optimized lookups per pattern, vector of XPO_NR, or NULL
+ * @see enum xpath_optimize_pattern
+ */
 int
-xpath_list_optimize_stats(int *hits)
+xpath_list_optimize_stats(int *hits,
+			  int *pattern)
 {
 #ifdef XPATH_LIST_OPTIMIZE
+    int i;
+
     *hits = _optimize_hits;
     _optimize_hits = 0;
+    for (i=0; i<XPO_NR; i++){
+	if (pattern)
+	    pattern[i] = _optimize_pattern_hits[i];
+	_optimize_pattern_hits[i] = 0;
+    }
+#else
+    *hits = 0;
+    if (pattern)
+	memset(pattern, 0, XPO_NR*sizeof(int));
 #endif
     return 0;
 }
@@ -112,19 +129,18 @@ xpath_optimize_exit(void)
 
 #ifdef XPATH_LIST_OPTIMIZE
 /*! Initialize xpath module
- * XXX move to clixon_xpath.c 
+ * XXX move to clixon_xpath.c
  * @see loop_preds
  */
-int
-xpath_optimize_init(xpath_tree **xm,
-		    xpath_tree **xe)
+static int
+xpath_optimize_init(xpath_tree **xm)
 {
     int         retval = -1;
     xpath_tree *xs;
-    
+
     if (_xm == NULL){
 	/* Initialize xpath-tree */
-	if (xpath_parse("_x[_y='_z']", &_xmtop) < 0) 
+	if (xpath_parse("_x[_y='_z']", &_xmtop) < 0)
 	    goto done;
 	/* Go down two steps */
 	if ((_xm = xpath_tree_traverse(_xmtop, 0, 0, -1)) == NULL)
@@ -133,35 +149,174 @@ xpath_optimize_init(xpath_tree **xm,
 	if ((xs = xpath_tree_traverse(_xm, 0, -1)) == NULL)
 	    goto done;
 	xs->xs_match++;
-	/* get predicates [_y=_z][z=2] */
+	/* get predicates [_y=_z][z=2], matched by loop_preds */
 	if ((xs = xpath_tree_traverse(_xm, 1, -1)) == NULL)
 	    goto done;
 	xs->xs_match++;
-	/* get expression [_y=_z] */
-	if ((_xe = xpath_tree_traverse(xs, 1, -1)) == NULL)
-	    goto done;
-	/* get keyname (_y) */
-	if ((xs = xpath_tree_traverse(_xe, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1)) == NULL)
-	    goto done;
-	xs->xs_match++; /* in loop_preds get name in xs_s1 XXX: leaf-list is different */
-	/* get keyval (_z) */
-	if ((xs = xpath_tree_traverse(_xe, 0, 0, 1, 0, 0, 0, 0, -1)) == NULL)
-	    goto done;
-	xs->xs_match++; /* in loop_preds get value in xs_s0 or xs_strnr */
     }
     *xm = _xm;
-    *xe = _xe;
     retval = 0;
  done:
     return retval;
 }
 
+/*! Descend a unary XPath tree node of given type, ie one with only a first child
+ * @param[in]  xs    XPath tree node, may be NULL
+ * @param[in]  type  Expected node type
+ * @retval     xc    First child xs_c0
+ * @retval     NULL  xs is NULL, not of type or has two children
+ */
+static xpath_tree *
+xpath_optimize_unary(xpath_tree  *xs,
+		     enum xp_type type)
+{
+    if (xs == NULL || xs->xs_type != type || xs->xs_c1 != NULL)
+	return NULL;
+    return xs->xs_c0;
+}
+
+/*! Match an operand being a single child name, eg k or a:k
+ * @param[in]  xs    XPath tree of type ADD
+ * @retval     name  Child name (without prefix)
+ * @retval     NULL  No match
+ */
+static char *
+xpath_optimize_name(xpath_tree *xs)
+{
+    xpath_tree *xp;
+
+    xs = xpath_optimize_unary(xs, XP_ADD);
+    xs = xpath_optimize_unary(xs, XP_UNION);
+    xs = xpath_optimize_unary(xs, XP_PATHEXPR);
+    xs = xpath_optimize_unary(xs, XP_LOCPATH);
+    if ((xs = xpath_optimize_unary(xs, XP_RELLOCPATH)) == NULL)
+	return NULL;
+    /* Step: no axis and no predicates */
+    if (xs->xs_type != XP_STEP || xs->xs_int != A_CHILD)
+	return NULL;
+    if ((xp = xs->xs_c1) != NULL && (xp->xs_c0 != NULL || xp->xs_c1 != NULL))
+	return NULL;
+    if ((xs = xs->xs_c0) == NULL || xs->xs_type != XP_NODE)
+	return NULL;
+    return xs->xs_s1;
+}
 
-/*! Recursive function to loop over all EXPR and pattern match them
+/*! Descend an operand to its primary expression, eg a literal or function call
+ * @param[in]  xs    XPath tree of type ADD
+ * @retval     xp    Primary expression
+ * @retval     NULL  Not a single primary expression
+ */
+static xpath_tree *
+xpath_optimize_primary(xpath_tree *xs)
+{
+    xs = xpath_optimize_unary(xs, XP_ADD);
+    xs = xpath_optimize_unary(xs, XP_UNION);
+    xs = xpath_optimize_unary(xs, XP_PATHEXPR);
+    return xpath_optimize_unary(xs, XP_FILTEREXPR);
+}
+
+/*! Match an operand being a literal string or number, eg 'x' or 42
+ * @param[in]  xs    XPath tree of type ADD
+ * @param[out] val   Literal value as string
+ * @retval     1     Match
+ * @retval     0     No match
+ */
+static int
+xpath_optimize_literal(xpath_tree *xs,
+		       char      **val)
+{
+    if ((xs = xpath_optimize_primary(xs)) == NULL)
+	return 0;
+    switch (xs->xs_type){
+    case XP_PRIME_NR:
+	*val = xs->xs_strnr;
+	break;
+    case XP_PRIME_STR:
+	*val = xs->xs_s0?xs->xs_s0:"";
+	break;
+    default:
+	return 0;
+    }
+    return *val != NULL;
+}
+
+/*! Match a relational expression of the form <name>=<literal> or <literal>=<name>
  *
- * @param[in]  xt    XPath tree of type PRED
- * @param[in]  xepat Pattern matching XPath tree of type EXPR
+ * @param[in]  xs    XPath tree of type RELEX
+ * @param[out] cvk   Vector of <keyname>:<keyval> pairs, one is added on match
+ * @retval    -1     Error
+ * @retval     0     No match
+ * @retval     1     Match
+ */
+static int
+xpath_optimize_eq(xpath_tree *xs,
+		  cvec       *cvk)
+{
+    xpath_tree *x0;
+    char       *name;
+    char       *val = NULL;
+    cg_var     *cvi;
+
+    if (xs == NULL || xs->xs_type != XP_RELEX || xs->xs_int != XO_EQ)
+	return 0;
+    if ((x0 = xpath_optimize_unary(xs->xs_c0, XP_RELEX)) == NULL)
+	return 0;
+    if ((name = xpath_optimize_name(x0)) != NULL){
+	if (xpath_optimize_literal(xs->xs_c1, &val) == 0)
+	    return 0;
+    }
+    else if ((name = xpath_optimize_name(xs->xs_c1)) != NULL){
+	if (xpath_optimize_literal(x0, &val) == 0)
+	    return 0;
+    }
+    else
+	return 0;
+    if (cvec_find(cvk, name) != NULL) /* Same name twice, eg [k='x'][k='y'] */
+	return 0;
+    if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
+	clicon_err(OE_XML, errno, "cvec_add");
+	return -1;
+    }
+    cv_name_set(cvi, name);
+    cv_string_set(cvi, val);
+    return 1;
+}
+
+/*! Match an and-expression of equalities: <name>=<literal> and <name>=<literal> ...
+ *
+ * @param[in]  xs    XPath tree of type AND
  * @param[out] cvk   Vector of <keyname>:<keyval> pairs
+ * @param[out] and   Incremented for every and operator
+ * @retval    -1     Error
+ * @retval     0     No match
+ * @retval     1     Match
+ */
+static int
+xpath_optimize_and(xpath_tree *xs,
+		   cvec       *cvk,
+		   int        *and)
+{
+    int ret;
+
+    if (xs == NULL || xs->xs_type != XP_AND)
+	return 0;
+    if (xs->xs_c1 == NULL)
+	return xpath_optimize_eq(xs->xs_c0, cvk);
+    if (xs->xs_int != XO_AND)
+	return 0;
+    (*and)++;
+    if ((ret = xpath_optimize_and(xs->xs_c0, cvk, and)) <= 0)
+	return ret;
+    return xpath_optimize_eq(xs->xs_c1, cvk);
+}
+
+/*! Recursive function to loop over all predicates and match them as equalities
+ *
+ * Every predicate must be an equality or an and-expression of equalities, the
+ * result is the conjunction of all of them, eg [k1='x'][k2='y' and k3='z']
+ * @param[in]  xt    XPath tree of type PRED
+ * @param[out] cvk   Vector of <keyname>:<keyval> pairs in predicate order
+ * @param[out] and   Incremented for every and operator
  * @retval    -1     Error
  * @retval     0     No match
  * @retval     1     Match
@@ -169,71 +324,194 @@ xpath_optimize_init(xpath_tree **xm,
  */
 static int
 loop_preds(xpath_tree *xt,
-	   xpath_tree *xepat,
-	   cvec       *cvk)
+	   cvec       *cvk,
+	   int        *and)
 {
-    int          retval = -1;
     int          ret;
     xpath_tree  *xe;
-    xpath_tree **vec = NULL;
-    size_t       veclen = 0;
-    cg_var      *cvi;
-	
-    if (xt->xs_type == XP_PRED && xt->xs_c0){
-	if ((ret = loop_preds(xt->xs_c0, xepat, cvk)) < 0)
-	    goto done;
-	if (ret == 0)
-	    goto ok;
+
+    if (xt->xs_type != XP_PRED)
+	return 0;
+    if (xt->xs_c0){
+	if ((ret = loop_preds(xt->xs_c0, cvk, and)) <= 0)
+	    return ret;
     }
-    if ((xe = xt->xs_c1) && (xe->xs_type == XP_EXP)){
-	if ((ret = xpath_tree_eq(xepat, xe, &vec, &veclen)) < 0)
-	    goto done;
-	if (ret == 0)
-	    goto ok;
-	if (veclen != 2)
-	    goto ok;
-	if ((cvi = cvec_add(cvk, CGV_STRING)) == NULL){
-	    clicon_err(OE_XML, errno, "cvec_add");	
-	    goto done;
+    if ((xe = xt->xs_c1) != NULL){
+	/* No or-expressions */
+	if ((xe = xpath_optimize_unary(xe, XP_EXP)) == NULL)
+	    return 0;
+	return xpath_optimize_and(xe, cvk, and);
+    }
+    return 1;
+}
+
+/* Range of first list key from predicates, see xpath_optimize_range */
+struct xpath_range{
+    char *rg_key;     /* Name of first list key */
+    char *rg_lower;   /* Lower bound or prefix, or NULL */
+    char *rg_upper;   /* Upper bound or NULL */
+    int   rg_prefix;  /* rg_lower is a prefix: starts-with(<key>,'<prefix>') */
+};
+
+/*! Match an operand being a number as written by XPath, eg 42 but not 042
+ * @param[in]  xs    XPath tree of type ADD
+ * @param[out] val   Number as string
+ * @retval     1     Match
+ * @retval     0     No match
+ * The key type parses the bound, leading zeros may be read as another base
+ */
+static int
+xpath_optimize_number(xpath_tree *xs,
+		      char      **val)
+{
+    char *nr;
+
+    if ((xs = xpath_optimize_primary(xs)) == NULL ||
+	xs->xs_type != XP_PRIME_NR ||
+	(nr = xs->xs_strnr) == NULL)
+	return 0;
+    if (nr[0] == '0' && nr[1] != '\0' && nr[1] != '.')
+	return 0;
+    *val = nr;
+    return 1;
+}
+
+/*! Match a key range condition: <key> < <number>, <number> <= <key>, etc, or
+ *  starts-with(<key>, '<prefix>')
+ *
+ * @param[in]  xs    XPath tree of type RELEX
+ * @param[out] rg    Range, a bound is set on match
+ * @retval     0     No match
+ * @retval     1     Match
+ */
+static int
+xpath_optimize_bound(xpath_tree         *xs,
+		     struct xpath_range *rg)
+{
+    xpath_tree *x0;
+    xpath_tree *xa;
+    char       *name;
+    char       *val = NULL;
+    int         op;
+    char      **bound;
+
+    if (xs == NULL || xs->xs_type != XP_RELEX)
+	return 0;
+    if (xs->xs_c1 == NULL){ /* starts-with(<key>, '<prefix>') */
+	if ((xs = xpath_optimize_primary(xs->xs_c0)) == NULL ||
+	    xs->xs_type != XP_PRIME_FN ||
+	    xs->xs_int != XPATHFN_STARTS_WITH ||
+	    (xa = xs->xs_c0) == NULL || xa->xs_c1 == NULL)
+	    return 0;
+	/* Arguments are expressions: args -> args , expr */
+	x0 = xpath_optimize_unary(xa->xs_c0, XP_EXP);
+	x0 = xpath_optimize_unary(x0, XP_EXP);
+	x0 = xpath_optimize_unary(x0, XP_AND);
+	x0 = xpath_optimize_unary(x0, XP_RELEX);
+	if ((name = xpath_optimize_name(x0)) == NULL ||
+	    strcmp(name, rg->rg_key) != 0)
+	    return 0;
+	x0 = xpath_optimize_unary(xa->xs_c1, XP_EXP);
+	x0 = xpath_optimize_unary(x0, XP_AND);
+	x0 = xpath_optimize_unary(x0, XP_RELEX);
+	if ((x0 = xpath_optimize_primary(x0)) == NULL ||
+	    x0->xs_type != XP_PRIME_STR ||
+	    x0->xs_s0 == NULL)
+	    return 0;
+	if (rg->rg_lower || rg->rg_upper)
+	    return 0;
+	rg->rg_lower = x0->xs_s0;
+	rg->rg_prefix = 1;
+	return 1;
+    }
+    op = xs->xs_int;
+    if (op != XO_LT && op != XO_LE && op != XO_GT && op != XO_GE)
+	return 0;
+    if ((x0 = xpath_optimize_unary(xs->xs_c0, XP_RELEX)) == NULL)
+	return 0;
+    if ((name = xpath_optimize_name(x0)) != NULL){
+	if (xpath_optimize_number(xs->xs_c1, &val) == 0)
+	    return 0;
+	bound = (op == XO_GT || op == XO_GE) ? &rg->rg_lower : &rg->rg_upper;
+    }
+    else if ((name = xpath_optimize_name(xs->xs_c1)) != NULL){
+	if (xpath_optimize_number(x0, &val) == 0)
+	    return 0;
+	bound = (op == XO_LT || op == XO_LE) ? &rg->rg_lower : &rg->rg_upper;
+    }
+    else
+	return 0;
+    if (strcmp(name, rg->rg_key) != 0 || rg->rg_prefix || *bound != NULL)
+	return 0;
+    *bound = val;
+    return 1;
+}
+
+/*! Match all predicates as key range conditions, possibly in and-expressions
+ *
+ * Eg [k > 1000 and k < 2000] or [starts-with(k,'eth1/')]. Positional and other
+ * predicates do not match, the range scan then would change their context.
+ * @param[in]  xt    XPath tree of type PRED
+ * @param[out] rg    Range of first list key
+ * @retval     0     No match
+ * @retval     1     Match
+ * @see loop_preds
+ */
+static int
+xpath_optimize_range(xpath_tree         *xt,
+		     struct xpath_range *rg)
+{
+    xpath_tree  *xe;
+
+    if (xt->xs_type != XP_PRED)
+	return 0;
+    if (xt->xs_c0 && xpath_optimize_range(xt->xs_c0, rg) == 0)
+	return 0;
+    if ((xe = xt->xs_c1) != NULL){
+	if ((xe = xpath_optimize_unary(xe, XP_EXP)) == NULL)
+	    return 0;
+	while (xe->xs_type == XP_AND && xe->xs_c1 != NULL){
+	    if (xe->xs_int != XO_AND ||
+		xpath_optimize_bound(xe->xs_c1, rg) == 0)
+		return 0;
+	    xe = xe->xs_c0;
 	}
-	cv_name_set(cvi, vec[0]->xs_s1);
-	if (vec[1]->xs_type == XP_PRIME_NR)
-	    cv_string_set(cvi, vec[1]->xs_strnr);
-	else
-	    cv_string_set(cvi, vec[1]->xs_s0);
+	if (xe->xs_type != XP_AND)
+	    return 0;
+	return xpath_optimize_bound(xe->xs_c0, rg);
     }
-    retval = 1;
- done:
-    if (vec)
-	free(vec);
-    return retval;
- ok: /* no match, not special case */
-    retval = 0;
-    goto done;
+    return 1;
 }
 
 /*! Pattern matching to find fastpath
  *
+ * The predicates of a list step are rewritten as a key lookup if they are equalities
+ * that together give all keys of the list, in any order and as separate predicates or
+ * and-expressions. A single equality on an explicit search index is also a lookup.
+ * Bounds and prefix tests on the first key are a range scan of the sorted list.
+ * Nested lists are optimized step by step.
  * @param[in]  xt     XPath tree
  * @param[in]  xv     XML base node
  * @param[out] xvec   Array of found nodes
- * @param[out] xlen   Len of xvec
- * @param[out] key
- * @param[out] keyval
+ * @param[out] xpo    Pattern matched, see enum xpath_optimize_pattern
  * @retval    -1      Error
  * @retval     0      No match - use non-optimized lookup
  * @retval     1      Match
  *  XPath:
- *  y[k=3] # corresponds to: <name>[<keyname>=<keyval>]
+ *  y[k=3]                    # corresponds to: <name>[<keyname>=<keyval>]
+ *  y[k1=3][k2='x']           # all keys as predicates
+ *  y[k2='x' and k1=3]        # all keys in and-expression
+ *  y[k>1000 and k<2000]      # range of first key, numeric
+ *  y[starts-with(k,'eth1/')] # range of first key, string prefix
  */
 static int
 xpath_list_optimize_fn(xpath_tree  *xt,
 		       cxobj       *xv,
-		       clixon_xvec *xvec)
+		       clixon_xvec *xvec,
+		       enum xpath_optimize_pattern *xpo)
 {
     int          retval = -1;
     xpath_tree  *xm = NULL;
-    xpath_tree  *xem = NULL;
     char        *name;
     yang_stmt   *yp;
     yang_stmt   *yc;
@@ -242,21 +520,25 @@ xpath_list_optimize_fn(xpath_tree  *xt,
     size_t       veclen = 0;
     xpath_tree  *xtp;
     int          ret;
-    cvec        *cvk = NULL; /* vector of index keys */
+    cvec        *cvk = NULL; /* vector of predicate equalities */
+    cvec        *cvk1 = NULL; /* vector of index keys in key order */
     cg_var      *cvi;
-    int          i;
-    
+    cg_var      *cvy = NULL;
+    int          and = 0;
+    struct xpath_range rg;
+#ifdef XML_EXPLICIT_INDEX
+    yang_stmt   *yi;
+#endif
+
     /* revert to non-optimized if no yang */
     if ((yp = xml_spec(xv)) == NULL)
 	goto ok;
     /* or if not config data (state data should not be ordered) */
     if (yang_config_ancestor(yp) == 0)
 	goto ok;
-    /* Check yang and that only a list with key as index is a special case can do bin search 
-     * That is, ONLY check optimize cases of this type:_x[_y='_z']
-     * Should we extend this simple example and have more cases (all cases?)
-     */
-    xpath_optimize_init(&xm, &xem);
+    /* Check that the step is of the form _x[...], predicates are matched by loop_preds */
+    if (xpath_optimize_init(&xm) < 0)
+	goto done;
     /* Here is where pattern is checked for equality and where variable binding is made (if
      * equal) */
     if ((ret = xpath_tree_eq(xm, xt, &vec, &veclen)) < 0)
@@ -265,37 +547,44 @@ xpath_list_optimize_fn(xpath_tree  *xt,
 	goto ok; /* no match */
     if (veclen != 2)
 	goto ok;
-    name = vec[0]->xs_s1;
+    if ((name = vec[0]->xs_s1) == NULL)
+	goto ok;
     /* Extract variables */
     if ((yc = yang_find(yp, Y_LIST, name)) == NULL)
 #ifdef NOTYET /* leaf-list is not detected by xpath optimize detection */
 	if ((yc = yang_find(yp, Y_LEAF_LIST, name)) == NULL) /* XXX */
 #endif
-	    goto ok; 
+	    goto ok;
     /* Validate keys */
     if ((cvv = yang_cvec_get(yc)) == NULL)
 	goto ok;
     xtp = vec[1];
     if ((cvk = cvec_new(0)) == NULL){
-	clicon_err(OE_YANG, errno, "cvec_new");	
+	clicon_err(OE_YANG, errno, "cvec_new");
 	goto done;
     }
-    if ((ret = loop_preds(xtp, xem, cvk)) < 0)
+    if ((ret = loop_preds(xtp, cvk, &and)) < 0)
 	goto done;
     if (ret == 0)
-	goto ok;
-
+	goto range;
     if (cvec_len(cvv) != cvec_len(cvk))
-	goto ok;
-    i = 0;
-    cvi = NULL;
-    while ((cvi = cvec_each(cvk, cvi)) != NULL) {
-	if (strcmp(cv_name_get(cvi), cv_string_get(cvec_i(cvv,i))))
-	    goto ok;
-	i++;
+	goto index;
+    /* Rewrite to key order, all keys must be given */
+    if ((cvk1 = cvec_new(0)) == NULL){
+	clicon_err(OE_YANG, errno, "cvec_new");
+	goto done;
     }
+    while ((cvy = cvec_each(cvv, cvy)) != NULL) {
+	if ((cvi = cvec_find(cvk, cv_string_get(cvy))) == NULL)
+	    goto index;
+	if (cvec_append_var(cvk1, cvi) == NULL){
+	    clicon_err(OE_YANG, errno, "cvec_append_var");
+	    goto done;
+	}
+    }
+    *xpo = and?XPO_KEY_AND:XPO_KEY;
     /* Use 2a form since yc allready given to compute cvk */
-    if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
+    if (clixon_xml_find_index(xv, yp, NULL, name, cvk1, xvec) < 0)
 	goto done;
     retval = 1; /* match */
  done:
@@ -303,7 +592,33 @@ xpath_list_optimize_fn(xpath_tree  *xt,
 	free(vec);
     if (cvk)
 	cvec_free(cvk);
+    if (cvk1)
+	cvec_free(cvk1);
     return retval;
+ index: /* Not keys, but may be a single explicit search index: y[i=3] */
+#ifdef XML_EXPLICIT_INDEX
+    if (cvec_len(cvk) == 1 &&
+	(yi = yang_find(yc, Y_LEAF, cv_name_get(cvec_i(cvk, 0)))) != NULL &&
+	yang_flag_get(yi, YANG_FLAG_INDEX) != 0){
+	*xpo = XPO_INDEX;
+	if (clixon_xml_find_index(xv, yp, NULL, name, cvk, xvec) < 0)
+	    goto done;
+	retval = 1;
+	goto done;
+    }
+#endif
+ range: /* Not equalities, but may be a range of the first key: y[k>3 and k<7] */
+    memset(&rg, 0, sizeof(rg));
+    rg.rg_key = cv_string_get(cvec_i(cvv, 0));
+    if (xpath_optimize_range(xtp, &rg) == 0)
+	goto ok;
+    if ((ret = clixon_xml_find_range(xv, yc, rg.rg_lower, rg.rg_upper, rg.rg_prefix, xvec)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    *xpo = XPO_RANGE;
+    retval = 1;
+    goto done;
  ok: /* no match, not special case */
     retval = 0;
     goto done;
@@ -312,33 +627,41 @@ xpath_list_optimize_fn(xpath_tree  *xt,
 
 /*! Identify XPATH special cases and if match, use binary search.
  *
+ * @param[in]  xs   XPATH step
+ * @param[in]  xv   Context node
+ * @param[out] xr   Found nodes are appended to nodeset of this context
  * @retval -1  Error
  * @retval  0  Dont optimize: not special case, do normal processing
- * @retval  1  Optimization made, special case, use x (found if != NULL)
- * XXX Contains glue code between cxobj ** and clixon_xvec code 
+ * @retval  1  Optimization made, special case, found nodes appended to xr
  */
 int
 xpath_optimize_check(xpath_tree *xs,
                      cxobj      *xv,
-	             cxobj    ***xvec0, 
-	             int        *xlen0)
+	             xp_ctx     *xr)
 {
 #ifdef XPATH_LIST_OPTIMIZE
     int          ret;
+    int          i;
     clixon_xvec *xvec = NULL;
-    
+    enum xpath_optimize_pattern xpo = XPO_KEY;
+
     if (!_optimize_enable)
 	return 0; /* use regular code */
     if ((xvec = clixon_xvec_new()) == NULL)
 	return -1;
-    /* Glue code since xpath code uses (old) cxobj ** and search code uses (new) clixon_xvec */
-    if ((ret = xpath_list_optimize_fn(xs, xv, xvec)) < 0)
+    if ((ret = xpath_list_optimize_fn(xs, xv, xvec, &xpo)) < 0){
+	clixon_xvec_free(xvec);
 	return -1;
+    }
     if (ret == 1){
-	if (clixon_xvec_extract(xvec, xvec0, xlen0) < 0)
-	    return -1;
+	for (i=0; i<clixon_xvec_len(xvec); i++)
+	    if (ctx_nodeset_append(xr, clixon_xvec_i(xvec, i)) < 0){
+		clixon_xvec_free(xvec);
+		return -1;
+	    }
 	clixon_xvec_free(xvec);
 	_optimize_hits++;
+	_optimize_pattern_hits[xpo]++;
 	return 1; /* Optimized */
     }
     else{
@@ -240,17 +240,14 @@ xp_primary_function(clixon_xpath_yacc *xpy,
     case XPATHFN_NAMESPACE_URI:
     case XPATHFN_STRING:
     case XPATHFN_CONCAT:
-    case XPATHFN_STARTS_WITH:
     case XPATHFN_SUBSTRING_BEFORE:
     case XPATHFN_SUBSTRING_AFTER:
     case XPATHFN_SUBSTRING:
     case XPATHFN_STRING_LENGTH:
     case XPATHFN_NORMALIZE_SPACE:
     case XPATHFN_TRANSLATE:
-    case XPATHFN_BOOLEAN:
     case XPATHFN_LANG:
     case XPATHFN_NUMBER:
-    case XPATHFN_SUM:
     case XPATHFN_FLOOR:
     case XPATHFN_CEILING:
     case XPATHFN_ROUND:
@@ -268,9 +265,12 @@ xp_primary_function(clixon_xpath_yacc *xpy,
     case XPATHFN_DERIVED_FROM_OR_SELF:
     case XPATHFN_POSITION:
     case XPATHFN_COUNT:
+    case XPATHFN_SUM:
     case XPATHFN_NAME:
+    case XPATHFN_STARTS_WITH:
     case XPATHFN_CONTAINS:
     case XPATHFN_NOT:
+    case XPATHFN_BOOLEAN:
     case XPATHFN_TRUE:
     case XPATHFN_FALSE:
 	break;
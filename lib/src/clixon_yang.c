@@ -84,11 +84,13 @@
 #include "clixon_yang_parse_lib.h"
 #include "clixon_yang_cardinality.h"
 #include "clixon_yang_type.h"
+#include "clixon_yang_dep.h"
 #include "clixon_yang_internal.h" /* internal included by this file only, not API*/
 
 #ifdef XML_EXPLICIT_INDEX
 static int yang_search_index_extension(clicon_handle h, yang_stmt *yext, yang_stmt *ys);
 #endif
+static void yang_index_free(yang_stmt *ys);
 
 /*
  * Local variables
@@ -175,6 +177,18 @@ static const map_str2int ykmap[] = {
 static int yang_type_cache_free(yang_type_cache *ycache);
 static int yang_type_cache_cp(yang_stmt *ynew, yang_stmt *yold);
 
+/* Generation of cached yang order, changed when any yang children are changed,
+ * see yang_order */
+static uint32_t _yang_order_gen = 1;
+
+/* Memo of evaluated if-feature expressions, key: module and expression, value: enabled.
+ * Only set while features are checked, see yang_if_feature_memo_init */
+static clicon_hash_t *_if_feature_memo = NULL;
+
+/* Memo of resolved schema node identifiers, key: context and nodeid, value: yang node.
+ * Only set while no yang nodes are removed, see yang_schema_nodeid_memo_init */
+static clicon_hash_t *_schema_nodeid_memo = NULL;
+
 /* Access functions
  */
 
@@ -244,6 +258,8 @@ yang_argument_set(yang_stmt *ys,
 		  char      *arg)
 {
     ys->ys_argument = arg; /* not strdup/copied */
+    ys->ys_flags &= ~(YANG_FLAG_MAPPED|YANG_FLAG_SHARED);
+    yang_index_reset(ys->ys_parent);
     return 0;
 }
 
@@ -398,6 +414,150 @@ yang_when_nsc_set(yang_stmt *ys,
     return retval;
 }
 
+/*! Get shared namespace context of a module or submodule
+ * @param[in]  ys     Yang module or submodule
+ * @retval     nsc    Namespace context, or NULL if not set
+ * @see xml_nsctx_yang_get
+ */
+cvec *
+yang_nsc_get(yang_stmt *ys)
+{
+    return ys->ys_nsc;
+}
+
+/*! Set shared namespace context of a module or submodule
+ * @param[in]  ys     Yang module or submodule
+ * @param[in]  nsc    Namespace context, consumed and freed with ys
+ * @retval     0      OK
+ */
+int
+yang_nsc_set(yang_stmt *ys, 
+	     cvec      *nsc)
+{
+    if (ys->ys_nsc)
+	cvec_free(ys->ys_nsc);
+    ys->ys_nsc = nsc;
+    return 0;
+}
+
+/*! Get real module and qualified JSON member name of a data node, cached in the node
+ *
+ * RFC 7951 member names are "module:name" if the module differs from the parent
+ * node's, otherwise "name". The real module (resolving submodules) and qualified name
+ * are computed on first call and then kept in the node.
+ * @param[in]  ys     Yang data node
+ * @param[out] ymod   Real module of ys
+ * @param[out] qname  Qualified name "module:name", the unqualified name is the argument
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see ys_real_module
+ */
+int
+yang_json_name_get(yang_stmt  *ys,
+		   yang_stmt **ymod,
+		   char      **qname)
+{
+    int        retval = -1;
+    yang_stmt *ym = NULL;
+    cbuf      *cb = NULL;
+
+    if (ys->ys_json_qname == NULL){
+	if (ys_real_module(ys, &ym) < 0)
+	    goto done;
+	if (ym == NULL){
+	    clicon_err(OE_YANG, ENOENT, "No module of %s", yang_argument_get(ys));
+	    goto done;
+	}
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_YANG, errno, "cbuf_new");
+	    goto done;
+	}
+	cprintf(cb, "%s:%s", yang_argument_get(ym), yang_argument_get(ys));
+	if ((ys->ys_json_qname = strdup(cbuf_get(cb))) == NULL){
+	    clicon_err(OE_YANG, errno, "strdup");
+	    goto done;
+	}
+	ys->ys_json_mod = ym;
+    }
+    *ymod = ys->ys_json_mod;
+    *qname = ys->ys_json_qname;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Derive JSON encoding of a leaf or leaf-list from its resolved type
+ * @param[in]  cvtype   Cligen type of leaf, see clicon_type2cv
+ * @param[in]  restype  Resolved yang type, or NULL if not resolved
+ * @retval     enc      JSON encoding
+ */
+static enum yang_json_enc
+yang_json_enc_derive(enum cv_type cvtype,
+		     char        *restype)
+{
+    switch (cvtype){
+    case CGV_STRING:
+    case CGV_REST:
+	if (restype && strcmp(restype, "identityref") == 0)
+	    return YJ_IDENTITYREF;
+	return YJ_STRING;
+    case CGV_INT8:
+    case CGV_INT16:
+    case CGV_INT32:
+    case CGV_INT64:
+    case CGV_UINT8:
+    case CGV_UINT16:
+    case CGV_UINT32:
+    case CGV_UINT64:
+    case CGV_DEC64:
+    case CGV_BOOL:
+	return YJ_LITERAL;
+    case CGV_VOID:
+	return YJ_EMPTY;
+    default:
+	return YJ_OTHER;
+    }
+}
+
+/*! Get JSON encoding of values of a leaf or leaf-list, cached in the node
+ *
+ * The encoding is derived from the resolved type when the leaf is populated, so that
+ * encoding and decoding of JSON values do not resolve the type of each value.
+ * @param[in]  ys     Yang leaf or leaf-list
+ * @param[out] enc    JSON encoding
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see ys_populate_leaf
+ */
+int
+yang_json_enc_get(yang_stmt          *ys,
+		  enum yang_json_enc *enc)
+{
+    int           retval = -1;
+    yang_stmt    *yrestype;
+    char         *origtype = NULL;
+    char         *restype;
+    enum cv_type  cvtype;
+
+    /* Not populated, eg yang_spec_parse_file was not used */
+    if (ys->ys_json_enc == YJ_NONE){
+	if (yang_type_get(ys, &origtype, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+	    goto done;
+	restype = yrestype?yang_argument_get(yrestype):NULL;
+	if (clicon_type2cv(origtype, restype, ys, &cvtype) < 0)
+	    goto done;
+	ys->ys_json_enc = yang_json_enc_derive(cvtype, restype);
+    }
+    *enc = ys->ys_json_enc;
+    retval = 0;
+ done:
+    if (origtype)
+	free(origtype);
+    return retval;
+}
+
 /* End access functions */
 
 /*! Create new yang specification
@@ -456,8 +616,10 @@ static int
 ys_free1(yang_stmt *ys,
 	 int        self)
 {
+    yang_index_free(ys);
     if (ys->ys_argument){
-	free(ys->ys_argument);
+	if ((ys->ys_flags & (YANG_FLAG_MAPPED|YANG_FLAG_SHARED)) == 0)
+	    free(ys->ys_argument);
 	ys->ys_argument = NULL;
     }
     if (ys->ys_cv){
@@ -476,6 +638,11 @@ ys_free1(yang_stmt *ys,
 	free(ys->ys_when_xpath);
     if (ys->ys_when_nsc)
 	cvec_free(ys->ys_when_nsc);
+    if (ys->ys_nsc)
+	cvec_free(ys->ys_nsc);
+    if (ys->ys_json_qname)
+	free(ys->ys_json_qname);
+    yang_dep_free(ys);
     if (self)
 	free(ys);
     return 0;
@@ -498,6 +665,7 @@ ys_prune(yang_stmt *yp,
     
     if (i >= yp->ys_len)
 	goto done;
+    yang_index_reset(yp);
     yc = yp->ys_stmt[i];
     if (i < yp->ys_len - 1){
 	size = (yp->ys_len - i - 1)*sizeof(struct yang_stmt *);
@@ -522,6 +690,8 @@ ys_free(yang_stmt *ys)
     int i;
     yang_stmt *yc;
 
+    if (ys->ys_keyword == Y_SPEC)
+	yang_lazy_free(ys);
     for (i=0; i<ys->ys_len; i++){
 	if ((yc = ys->ys_stmt[i]) != NULL)
 	    ys_free(yc);
@@ -546,21 +716,17 @@ yn_realloc(yang_stmt *yn)
     return 0;
 }
 
-/*! Copy yang statement recursively from old to new 
+/*! Copy yang statement recursively from old to new, optionally sharing arguments
  * @param[in] ynew  New empty (but created) yang statement (to)
  * @param[in] yold  Old existing yang statement (from)
+ * @param[in] share Arguments of the copy refer to those of yold, see YANG_FLAG_SHARED
  * @retval    0     OK
  * @retval    -1    Error
- * @code
- * yang_stmt *new = ys_new(Y_LEAF);
- * if (ys_cp(new, old) < 0)
- *    err;
- * @endcode
- * @see ys_replace
  */
-int        
-ys_cp(yang_stmt *ynew, 
-      yang_stmt *yold)
+static int
+ys_cp1(yang_stmt *ynew, 
+       yang_stmt *yold,
+       int        share)
 {
     int        retval = -1;
     int        i;
@@ -569,16 +735,26 @@ ys_cp(yang_stmt *ynew,
 
     memcpy(ynew, yold, sizeof(*yold)); 
     ynew->ys_parent = NULL;
+    ynew->ys_dep = NULL;   /* Rebuilt by yang_dep_init */
+    ynew->ys_index = NULL; /* Built on lookup */
+    ynew->ys_nsc = NULL;   /* Built on lookup */
+    ynew->ys_json_mod = NULL;   /* Built on lookup */
+    ynew->ys_json_qname = NULL;
+    ynew->ys_order_gen = 0;     /* Parent may differ */
     if (yold->ys_stmt)
 	if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
 	    clicon_err(OE_YANG, errno, "calloc");
 	    goto done;
 	}
-    if (yold->ys_argument)
-	if ((ynew->ys_argument = strdup(yold->ys_argument)) == NULL){
+    /* Mapped and shared arguments are shared by the copy */
+    if (yold->ys_argument && (yold->ys_flags & (YANG_FLAG_MAPPED|YANG_FLAG_SHARED)) == 0){
+	if (share)
+	    ynew->ys_flags |= YANG_FLAG_SHARED;
+	else if ((ynew->ys_argument = strdup(yold->ys_argument)) == NULL){
 	    clicon_err(OE_YANG, errno, "strdup");
 	    goto done;
 	}
+    }
     if (yold->ys_cv)
 	if ((ynew->ys_cv = cv_dup(yold->ys_cv)) == NULL){
 	    clicon_err(OE_YANG, errno, "cv_dup");
@@ -607,7 +783,7 @@ ys_cp(yang_stmt *ynew,
     }
     for (i=0; i<ynew->ys_len; i++){
 	yco = yold->ys_stmt[i];
-	if ((ycn = ys_dup(yco)) == NULL)
+	if ((ycn = share?ys_dup_shared(yco):ys_dup(yco)) == NULL)
 	    goto done;
 	ynew->ys_stmt[i] = ycn;
 	ycn->ys_parent = ynew;
@@ -617,6 +793,25 @@ ys_cp(yang_stmt *ynew,
     return retval;
 }
 
+/*! Copy yang statement recursively from old to new 
+ * @param[in] ynew  New empty (but created) yang statement (to)
+ * @param[in] yold  Old existing yang statement (from)
+ * @retval    0     OK
+ * @retval    -1    Error
+ * @code
+ * yang_stmt *new = ys_new(Y_LEAF);
+ * if (ys_cp(new, old) < 0)
+ *    err;
+ * @endcode
+ * @see ys_replace
+ */
+int        
+ys_cp(yang_stmt *ynew, 
+      yang_stmt *yold)
+{
+    return ys_cp1(ynew, yold, 0);
+}
+
 /*! Create a new yang node and copy the contents recursively from the original.  *
  * @param[in] old  Old existing yang statement (from)
  * @retval    NULL Error
@@ -645,6 +840,35 @@ ys_dup(yang_stmt *old)
     return nw;
 }
 
+/*! Create a new yang node and copy recursively from the original, sharing arguments
+ *
+ * As ys_dup, but argument strings are not duplicated: the copy refers to the arguments
+ * of the original, see YANG_FLAG_SHARED. Used at grouping expansion where a grouping
+ * may be copied at a large number of uses.
+ * @param[in] old  Old existing yang statement (from)
+ * @retval    nw   New created yang statement
+ * @retval    NULL Error
+ * @note The original must not be freed or have its arguments changed before the copy is
+ *       freed, eg a grouping statement that is kept as long as the yang spec
+ */
+yang_stmt *
+ys_dup_shared(yang_stmt *old)
+{
+    yang_stmt *nw;
+
+    if ((nw = ys_new(old->ys_keyword)) == NULL)
+	return NULL;
+    if (nw->ys_cvec){
+	cvec_free(nw->ys_cvec);
+	nw->ys_cvec = NULL;
+    }
+    if (ys_cp1(nw, old, 1) < 0){
+	ys_free(nw);
+	return NULL;
+    }
+    return nw;
+}
+
 /*! Replace yold with ynew (insert ynew at the exact place of yold). Keep yold pointer as-is.
  *
  * @param[in] yorig  Existing yang statement
@@ -668,6 +892,7 @@ ys_replace(yang_stmt *yorig,
     yang_stmt *yc; /* child */
 
     yp = yang_parent_get(yorig);
+    yang_index_reset(yorig);
     /* Remove old yangs all children */
     yc = NULL;
     while ((yc = yn_each(yorig, yc)) != NULL) 
@@ -701,6 +926,7 @@ yn_insert(yang_stmt *ys_parent,
 {
     int pos = ys_parent->ys_len;
 
+    yang_index_reset(ys_parent);
     if (yn_realloc(ys_parent) < 0)
 	return -1;
     ys_parent->ys_stmt[pos] = ys_child;
@@ -745,6 +971,250 @@ yn_each(yang_stmt *yparent,
     return yc;
 }
 
+/*
+ * Child lookup index, see yang_find and yang_find_datanode
+ * Built on first lookup in yang statements with many children, and reset when the
+ * children of the statement or of a descendant are changed, see yang_index_reset.
+ * Open addressing with linear probing: of children with the same argument, the first
+ * child is found first, as with a linear search.
+ */
+#define YANG_INDEX_MIN 8 /* Min number of children for an index */
+
+struct yang_index{
+    yang_stmt **yx_stmt;  /* Child vector when built, index is reset if changed */
+    int         yx_len;   /* Number of children when built */
+    uint32_t    yx_mask;  /* Size of tables - 1, size is a power of two */
+    yang_stmt **yx_child; /* Children with argument, see yang_find */
+    yang_stmt **yx_data;  /* Data nodes, also in choice/case, see yang_find_datanode */
+};
+
+static uint32_t
+yang_index_hash(const char *str)
+{
+    uint32_t h = 2166136261U;
+
+    while (*str){
+	h ^= (uint8_t)*str++;
+	h *= 16777619U;
+    }
+    return h;
+}
+
+static void
+yang_index_add(yang_stmt **table,
+	       uint32_t    mask,
+	       yang_stmt  *ys)
+{
+    uint32_t h;
+
+    h = yang_index_hash(ys->ys_argument) & mask;
+    while (table[h] != NULL)
+	h = (h+1) & mask;
+    table[h] = ys;
+}
+
+/*! Add data nodes in same order as yang_find_datanode searches */
+static void
+yang_index_add_data(yang_stmt **table,
+		    uint32_t    mask,
+		    yang_stmt  *yn)
+{
+    int        i;
+    int        j;
+    yang_stmt *ys;
+    yang_stmt *yc;
+
+    for (i=0; i<yn->ys_len; i++){
+	ys = yn->ys_stmt[i];
+	if (ys->ys_keyword == Y_CHOICE){
+	    for (j=0; j<ys->ys_len; j++){
+		yc = ys->ys_stmt[j];
+		if (yc->ys_keyword == Y_CASE)
+		    yang_index_add_data(table, mask, yc);
+		else if (yang_datanode(yc) && yc->ys_argument)
+		    yang_index_add(table, mask, yc);
+	    }
+	}
+	else if (yang_datanode(ys) && ys->ys_argument)
+	    yang_index_add(table, mask, ys);
+    }
+}
+
+/*! Count data nodes, see yang_index_add_data */
+static int
+yang_index_count_data(yang_stmt *yn)
+{
+    int        i;
+    int        j;
+    int        n = 0;
+    yang_stmt *ys;
+    yang_stmt *yc;
+
+    for (i=0; i<yn->ys_len; i++){
+	ys = yn->ys_stmt[i];
+	if (ys->ys_keyword == Y_CHOICE){
+	    for (j=0; j<ys->ys_len; j++){
+		yc = ys->ys_stmt[j];
+		if (yc->ys_keyword == Y_CASE)
+		    n += yang_index_count_data(yc);
+		else
+		    n++;
+	    }
+	}
+	else
+	    n++;
+    }
+    return n;
+}
+
+/*! Free index of yang statement */
+static void
+yang_index_free(yang_stmt *ys)
+{
+    struct yang_index *yx;
+
+    if ((yx = ys->ys_index) != NULL){
+	if (yx->yx_child)
+	    free(yx->yx_child);
+	if (yx->yx_data)
+	    free(yx->yx_data);
+	free(yx);
+	ys->ys_index = NULL;
+    }
+}
+
+/*! Reset child lookup index and descendant name filter of yang statement and its ancestors
+ * Must be called when children of a yang statement are changed other than with
+ * yn_insert and ys_prune
+ * @param[in]  ys   Yang statement whose children are changed
+ */
+int
+yang_index_reset(yang_stmt *ys)
+{
+    if (++_yang_order_gen == 0) /* 0 is never current */
+	_yang_order_gen = 1;
+    for (; ys != NULL; ys = ys->ys_parent){
+	yang_index_free(ys);
+	ys->ys_flags &= ~YANG_FLAG_DESCNAMES;
+    }
+    return 0;
+}
+
+/*! Get bits of a name in a descendant name filter
+ * @param[in]  name  Data node name
+ * @retval     bits  Two bits of a 64-bit filter
+ * @see yang_desc_names_get
+ */
+uint64_t
+yang_name_bits(const char *name)
+{
+    uint32_t h = yang_index_hash(name);
+
+    return (1ULL << (h & 63)) | (1ULL << ((h >> 6) & 63));
+}
+
+/*! Get filter of the names of all descendant data nodes of a yang statement
+ *
+ * A 64-bit bloom filter with the bits of yang_name_bits of each descendant data node
+ * name. If not all bits of a name are set, no descendant has that name. Used by XPath
+ * descendant (//) evaluation to skip subtrees that cannot match.
+ * Choice, case, input and output are transparent. Anydata and anyxml may contain any
+ * name and set all bits. Computed on first call and reset with yang_index_reset.
+ * @param[in]  ys     Yang statement
+ * @retval     names  Descendant name filter
+ */
+uint64_t
+yang_desc_names_get(yang_stmt *ys)
+{
+    uint64_t   names = 0;
+    int        i;
+    yang_stmt *yc;
+
+    if (ys->ys_flags & YANG_FLAG_DESCNAMES)
+	return ys->ys_desc_names;
+    if (ys->ys_keyword == Y_ANYDATA || ys->ys_keyword == Y_ANYXML){
+	names = ~0ULL;
+	goto ok;
+    }
+    for (i=0; i<ys->ys_len; i++){
+	yc = ys->ys_stmt[i];
+	switch (yc->ys_keyword){
+	case Y_ANYDATA:
+	case Y_ANYXML:
+	case Y_CONTAINER:
+	case Y_LIST:
+	case Y_LEAF:
+	case Y_LEAF_LIST:
+	case Y_ACTION:
+	case Y_NOTIFICATION:
+	case Y_RPC:
+	    if (yc->ys_argument)
+		names |= yang_name_bits(yc->ys_argument);
+	    names |= yang_desc_names_get(yc);
+	    break;
+	case Y_CHOICE:
+	case Y_CASE:
+	case Y_INPUT:
+	case Y_OUTPUT:
+	    names |= yang_desc_names_get(yc);
+	    break;
+	default:
+	    break;
+	}
+    }
+ ok:
+    ys->ys_desc_names = names;
+    ys->ys_flags |= YANG_FLAG_DESCNAMES;
+    return names;
+}
+
+/*! Get child lookup index of yang statement, build it if not built
+ * @param[in]  yn   Yang statement
+ * @retval     yx   Index
+ * @retval     NULL Few children, or out of memory: search linearly
+ */
+static struct yang_index *
+yang_index_get(yang_stmt *yn)
+{
+    struct yang_index *yx;
+    int                n;
+    uint32_t           size;
+    int                i;
+    yang_stmt         *ys;
+
+    if ((yx = yn->ys_index) != NULL){
+	if (yx->yx_stmt == yn->ys_stmt && yx->yx_len == yn->ys_len)
+	    return yx;
+	yang_index_free(yn);
+    }
+    if (yn->ys_len < YANG_INDEX_MIN)
+	return NULL;
+    n = yang_index_count_data(yn);
+    if (n < yn->ys_len)
+	n = yn->ys_len;
+    for (size = 16; size < 2*n; size *= 2);
+    if ((yx = calloc(1, sizeof(*yx))) == NULL)
+	return NULL;
+    if ((yx->yx_child = calloc(size, sizeof(yang_stmt *))) == NULL ||
+	(yx->yx_data = calloc(size, sizeof(yang_stmt *))) == NULL){
+	if (yx->yx_child)
+	    free(yx->yx_child);
+	free(yx);
+	return NULL;
+    }
+    yx->yx_stmt = yn->ys_stmt;
+    yx->yx_len = yn->ys_len;
+    yx->yx_mask = size - 1;
+    for (i=0; i<yn->ys_len; i++){
+	ys = yn->ys_stmt[i];
+	if (ys->ys_argument)
+	    yang_index_add(yx->yx_child, yx->yx_mask, ys);
+    }
+    yang_index_add_data(yx->yx_data, yx->yx_mask, yn);
+    yn->ys_index = yx;
+    return yx;
+}
+
 /*! Find first child yang_stmt with matching keyword and argument
  *
  * @param[in]  yn         Yang node, current context node.
@@ -767,17 +1237,31 @@ yang_find(yang_stmt  *yn,
     char      *name;
     yang_stmt *yspec;
     yang_stmt *ym;
-
-    for (i=0; i<yn->ys_len; i++){
-	ys = yn->ys_stmt[i];
-	if (keyword == 0 || ys->ys_keyword == keyword){
-	    if (argument == NULL ||
-		(ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)){
+    struct yang_index *yx;
+    uint32_t   h;
+
+    if (argument != NULL && (yx = yang_index_get(yn)) != NULL){
+	h = yang_index_hash(argument) & yx->yx_mask;
+	while ((ys = yx->yx_child[h]) != NULL){
+	    if ((keyword == 0 || ys->ys_keyword == keyword) &&
+		strcmp(argument, ys->ys_argument) == 0){
 		yret = ys;
 		break;
 	    }
+	    h = (h+1) & yx->yx_mask;
 	}
     }
+    else
+	for (i=0; i<yn->ys_len; i++){
+	    ys = yn->ys_stmt[i];
+	    if (keyword == 0 || ys->ys_keyword == keyword){
+		if (argument == NULL ||
+		    (ys->ys_argument && strcmp(argument, ys->ys_argument) == 0)){
+		    yret = ys;
+		    break;
+		}
+	    }
+	}
     /* Special case: if not match and yang node is module or submodule, extend
      * search to include submodules */
     if (yret == NULL &&
@@ -846,7 +1330,20 @@ yang_find_datanode(yang_stmt *yn,
     yang_stmt *yspec;
     yang_stmt *ysmatch = NULL;
     char      *name;
+    struct yang_index *yx;
+    uint32_t   h;
 
+    if (argument != NULL && (yx = yang_index_get(yn)) != NULL){
+	h = yang_index_hash(argument) & yx->yx_mask;
+	while ((ys = yx->yx_data[h]) != NULL){
+	    if (strcmp(argument, ys->ys_argument) == 0){
+		ysmatch = ys;
+		goto match;
+	    }
+	    h = (h+1) & yx->yx_mask;
+	}
+	goto submodule;
+    }
     ys = NULL;
     while ((ys = yn_each(yn, ys)) != NULL){
 	if (yang_keyword_get(ys) == Y_CHOICE){ /* Look for its children */
@@ -880,6 +1377,7 @@ yang_find_datanode(yang_stmt *yn,
     }
     /* Special case: if not match and yang node is module or submodule, extend
      * search to include submodules */
+ submodule:
     if (ysmatch == NULL &&
 	(yang_keyword_get(yn) == Y_MODULE ||
 	 yang_keyword_get(yn) == Y_SUBMODULE)){
@@ -1229,6 +1727,7 @@ order1(yang_stmt *yp,
  * @retval   >=0      Order of child with specified argument
  * @retval    -1      Not found
  * @note special handling if y is child of (sub)module
+ * @note The order is cached until any yang children are changed, see yang_index_reset
  */
 int
 yang_order(yang_stmt *y)
@@ -1239,9 +1738,12 @@ yang_order(yang_stmt *y)
     int         i;
     int         j=0;
     int         tot = 0;
+    int         order = -1;
 
     if (y == NULL)
 	return -1;
+    if (y->ys_order_gen == _yang_order_gen)
+	return y->ys_order;
     /* Some special handling if yp is choice (or case)
      * if so, the real parent (from an xml point of view) is the parents
      * parent. 
@@ -1266,8 +1768,10 @@ yang_order(yang_stmt *y)
 	}
     }
     if (order1(yp, y, &j) == 1)
-	return tot + j;
-    return -1;
+	order = tot + j;
+    y->ys_order = order;
+    y->ys_order_gen = _yang_order_gen;
+    return order;
 }
 
 char *
@@ -1466,6 +1970,54 @@ yang_print(FILE      *f,
     return yang_print_cb(f, yn, fprintf);
 }
 
+/*! Return the number and alloced memory of a yang statement and its descendants
+ * @param[in]     yt   Yang statement, eg yang spec
+ * @param[in,out] nrp  Number of yang statements, incremented
+ * @param[in,out] szp  Size in bytes of yang statements, incremented
+ * @retval        0    OK
+ * @retval       -1    Error
+ * Child lookup indexes and reverse dependencies are not included
+ * @see xml_stats
+ */
+int
+yang_stats(yang_stmt *yt,
+	   uint64_t  *nrp,
+	   size_t    *szp)
+{
+    size_t     sz = 0;
+    yang_stmt *ys = NULL;
+
+    if (yt == NULL){
+	clicon_err(OE_YANG, EINVAL, "yang node is NULL");
+	return -1;
+    }
+    *nrp += 1;
+    sz += sizeof(struct yang_stmt);
+    sz += yt->ys_len*sizeof(struct yang_stmt *);
+    if (yt->ys_argument && (yt->ys_flags & YANG_FLAG_SHARED) == 0)
+	sz += strlen(yt->ys_argument) + 1;
+    if (yt->ys_cv)
+	sz += cv_size(yt->ys_cv);
+    if (yt->ys_cvec)
+	sz += cvec_size(yt->ys_cvec);
+    if (yt->ys_typecache)
+	sz += sizeof(yang_type_cache);
+    if (yt->ys_when_xpath)
+	sz += strlen(yt->ys_when_xpath) + 1;
+    if (yt->ys_when_nsc)
+	sz += cvec_size(yt->ys_when_nsc);
+    if (yt->ys_nsc)
+	sz += cvec_size(yt->ys_nsc);
+    if (yt->ys_json_qname)
+	sz += strlen(yt->ys_json_qname) + 1;
+    if (szp)
+	*szp += sz;
+    while ((ys = yn_each(yt, ys)) != NULL)
+	if (yang_stats(ys, nrp, szp) < 0)
+	    return -1;
+    return 0;
+}
+
 /* Log/debug info about top-level (sub)modules no recursion
  * @param[in]  f         File to print to.
  * @param[in]  yspec     Yang spec
@@ -1541,6 +2093,40 @@ yang_print_cbuf(cbuf      *cb,
     return 0;
 }
 
+/*! Mark yang node and its ancestors as having constraints that may depend on other nodes
+ * @param[in] ys   Yang node with leafref type, or must or when statement
+ * @see YANG_FLAG_XPATH_DEP
+ */
+static void
+ys_xpath_dep_set(yang_stmt *ys)
+{
+    for (; ys != NULL; ys = ys->ys_parent){
+	if (ys->ys_keyword == Y_MODULE || ys->ys_keyword == Y_SUBMODULE ||
+	    ys->ys_keyword == Y_SPEC)
+	    break;
+	if (yang_flag_get(ys, YANG_FLAG_XPATH_DEP))
+	    break;
+	yang_flag_set(ys, YANG_FLAG_XPATH_DEP);
+    }
+}
+
+/*! Mark yang node and its ancestors as having a descendant leaf with default value
+ * @param[in] ys   Yang leaf with default value
+ * @see YANG_FLAG_DEFAULT
+ */
+static void
+ys_default_set(yang_stmt *ys)
+{
+    for (; ys != NULL; ys = ys->ys_parent){
+	if (ys->ys_keyword == Y_MODULE || ys->ys_keyword == Y_SUBMODULE ||
+	    ys->ys_keyword == Y_SPEC)
+	    break;
+	if (yang_flag_get(ys, YANG_FLAG_DEFAULT))
+	    break;
+	yang_flag_set(ys, YANG_FLAG_DEFAULT);
+    }
+}
+
 /*! Populate yang leafs after parsing. Create cv and fill it in.
  *
  * Populate leaf in 2nd round of yang parsing, now that context is complete:
@@ -1634,6 +2220,14 @@ ys_populate_leaf(clicon_handle h,
 	if ((ret = yang_key_match(yparent, ys->ys_argument)) < 0)
 	    goto done;
     }
+    /* 5. Leafref refers to other nodes */
+    if (restype && strcmp(restype, "leafref") == 0)
+	ys_xpath_dep_set(ys);
+    /* 6. Default value, see xml_default_recurse */
+    if (ys->ys_keyword == Y_LEAF && !cv_flag(cv, V_UNSET))
+	ys_default_set(ys);
+    /* 7. JSON encoding, see yang_json_enc_get */
+    ys->ys_json_enc = yang_json_enc_derive(cvtype, restype);
     ys->ys_cv = cv;
     retval = 0;
   done:
@@ -1923,7 +2517,7 @@ ys_populate_identity(clicon_handle h,
 	if (yc->ys_keyword != Y_BASE)
 	    continue;
 	baseid = yang_argument_get(yc); /* on the form: prefix:id */
-	if (((ybaseid = yang_find_identity(ys, baseid))) == NULL){
+	if (((ybaseid = yang_base_identity(yc))) == NULL){
 	    clicon_err(OE_YANG, ENOENT, "No such identity: %s", baseid); 
 	    goto done;
 	}
@@ -1961,6 +2555,62 @@ ys_populate_identity(clicon_handle h,
     return retval;
 }
 
+/*! Get the identity of a base statement, resolved on first call
+ *
+ * The resolved identity is kept in the cv of the base statement, so that 
+ * identity derivation can be checked with pointers at runtime.
+ * @param[in] ybase  Yang base statement of identity or identityref type
+ * @retval    yid    Yang identity statement
+ * @retval    NULL   Not found
+ * @see yang_identity_derived
+ */
+yang_stmt *
+yang_base_identity(yang_stmt *ybase)
+{
+    cg_var    *cv;
+    yang_stmt *yid;
+
+    if ((cv = ybase->ys_cv) != NULL &&
+	cv_type_get(cv) == CGV_VOID &&
+	(yid = cv_void_get(cv)) != NULL)
+	return yid;
+    if ((yid = yang_find_identity(ybase, ybase->ys_argument)) == NULL)
+	return NULL;
+    if (cv == NULL){
+	if ((cv = cv_new(CGV_VOID)) == NULL)
+	    return yid; /* Not cached */
+	ybase->ys_cv = cv;
+    }
+    if (cv_type_get(cv) == CGV_VOID)
+	cv_void_set(cv, yid);
+    return yid;
+}
+
+/*! Check if an identity is derived from a base identity
+ * @param[in] yid     Yang identity statement
+ * @param[in] ybaseid Yang base identity statement
+ * @retval    1       yid is derived from ybaseid
+ * @retval    0       yid is not derived from ybaseid, or base not resolved
+ * @see validate_identityref
+ */
+int
+yang_identity_derived(yang_stmt *yid,
+		      yang_stmt *ybaseid)
+{
+    yang_stmt *yc = NULL;
+    yang_stmt *yb;
+
+    while ((yc = yn_each(yid, yc)) != NULL) {
+	if (yc->ys_keyword != Y_BASE)
+	    continue;
+	if ((yb = yang_base_identity(yc)) == NULL)
+	    continue;
+	if (yb == ybaseid || yang_identity_derived(yb, ybaseid))
+	    return 1;
+    }
+    return 0;
+}
+
 /*! Return 1 if feature is enabled, 0 if not using the populated yang tree
  *
  * @param[in] yspec   yang specification
@@ -2264,9 +2914,16 @@ ys_populate2(yang_stmt    *ys,
 	if (ys_parse(ys, CGV_BOOL) == NULL) 
 	    goto done;
 	break;
+    case Y_MUST:
+    case Y_WHEN:
+	ys_xpath_dep_set(ys->ys_parent);
+	break;
     default:
 	break;
     }
+    /* Augmented when */
+    if (yang_when_xpath_get(ys) != NULL)
+	ys_xpath_dep_set(ys);
     retval = 0;
   done:
     return retval;
@@ -2298,7 +2955,21 @@ yang_if_feature(clicon_handle h,
     yang_stmt  *yfeat; /* feature yang node */
     int         opand = -1; /* -1:not set, 0:or, 1:and */
     int         enabled = 0;
+    int        *memo;
+    cbuf       *cb = NULL;
     
+    /* Same expression in same module evaluated before */
+    if (_if_feature_memo){
+	if ((cb = cbuf_new()) == NULL){
+	    clicon_err(OE_UNIX, errno, "cbuf_new");
+	    goto done;
+	}
+	cprintf(cb, "%p %s", ys_module(ys), ys->ys_argument);
+	if ((memo = clicon_hash_value(_if_feature_memo, cbuf_get(cb), NULL)) != NULL){
+	    retval = *memo;
+	    goto done;
+	}
+    }
     if ((vec = clicon_strsep(ys->ys_argument, " \t\r\n", &nvec)) == NULL)
 	goto done;
     /* Two steps: first detect operators
@@ -2406,10 +3077,14 @@ yang_if_feature(clicon_handle h,
 	    feature = NULL;
 	}
     }
+    if (cb && clicon_hash_add(_if_feature_memo, cbuf_get(cb), &enabled, sizeof(enabled)) == NULL)
+	goto done;
     if (!enabled)
 	goto disabled;
     retval = 1;
  done:
+    if (cb)
+	cbuf_free(cb);
     if (vec)
 	free(vec); 
     if (prefix)
@@ -2422,6 +3097,58 @@ yang_if_feature(clicon_handle h,
     goto done;
 }
 
+/*! Start evaluating each if-feature expression once per module
+ *
+ * While set, the result of an if-feature expression is kept and reused by other
+ * if-feature statements with the same expression in the same module.
+ * Features must not change until yang_if_feature_memo_free
+ * @retval    0   OK
+ * @retval   -1   Error
+ * @see yang_features_populate  Populate features before
+ */
+int
+yang_if_feature_memo_init(void)
+{
+    yang_if_feature_memo_free();
+    if ((_if_feature_memo = clicon_hash_init()) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Stop reusing evaluated if-feature expressions
+ */
+void
+yang_if_feature_memo_free(void)
+{
+    if (_if_feature_memo){
+	clicon_hash_free(_if_feature_memo);
+	_if_feature_memo = NULL;
+    }
+}
+
+/*! Populate all feature statements of a module
+ *
+ * Done for all modules before checking if-feature statements, so that an if-feature
+ * may refer to a feature of a module not yet checked
+ * @param[in] h     Clixon handle
+ * @param[in] ymod  Yang module or submodule
+ * @retval    0     OK
+ * @retval   -1     Error
+ * @see yang_features
+ */
+int
+yang_features_populate(clicon_handle h,
+		       yang_stmt    *ymod)
+{
+    yang_stmt *ys = NULL;
+
+    while ((ys = yn_each(ymod, ys)) != NULL)
+	if (ys->ys_keyword == Y_FEATURE && ys->ys_cv == NULL)
+	    if (ys_populate_feature(h, ys) < 0)
+		return -1;
+    return 0;
+}
+
 /*! Find feature and if-feature nodes, check features and remove disabled nodes
  * @param[in] h   Clixon handle
  * @param[in] yt  Yang statement
@@ -2453,13 +3180,14 @@ yang_features(clicon_handle h,
 	}
 	else
 	    if (ys->ys_keyword == Y_FEATURE){
-		if (ys_populate_feature(h, ys) < 0)
+		if (ys->ys_cv == NULL && ys_populate_feature(h, ys) < 0)
 		    goto done;
 	    } else switch (yang_features(h, ys)){
 	    case -1: /* error */
 		goto done;
 		break;
 	    case 0: /* disabled: remove ys */
+		yang_index_reset(yt);
 		for (j=i+1; j<yt->ys_len; j++)
 		    yt->ys_stmt[j-1] = yt->ys_stmt[j];
 		yt->ys_len--;
@@ -2644,6 +3372,56 @@ schema_nodeid_iterate(yang_stmt    *yn,
     return retval;
 }
 
+/*! Start reusing resolved schema node identifiers
+ *
+ * While set, a schema node identifier that is found is kept and reused by later
+ * lookups with the same identifier from the same context: the module for absolute
+ * identifiers, and the node for descendant identifiers. Not found identifiers are
+ * not kept since nodes may be added, eg by augment.
+ * Yang nodes must not be removed until yang_schema_nodeid_memo_free
+ * @retval    0   OK
+ * @retval   -1   Error
+ */
+int
+yang_schema_nodeid_memo_init(void)
+{
+    yang_schema_nodeid_memo_free();
+    if ((_schema_nodeid_memo = clicon_hash_init()) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Stop reusing resolved schema node identifiers
+ */
+void
+yang_schema_nodeid_memo_free(void)
+{
+    if (_schema_nodeid_memo){
+	clicon_hash_free(_schema_nodeid_memo);
+	_schema_nodeid_memo = NULL;
+    }
+}
+
+/*! Make key of a schema node identifier in the memo
+ * @param[in]  yctx           Context: module or yang spec if absolute, node if descendant
+ * @param[in]  schema_nodeid  Schema node identifier
+ * @retval     cb             Key, free with cbuf_free
+ * @retval     NULL           Error
+ */
+static cbuf *
+schema_nodeid_memo_key(yang_stmt *yctx,
+		       char      *schema_nodeid)
+{
+    cbuf *cb;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	return NULL;
+    }
+    cprintf(cb, "%p %s", yctx, schema_nodeid);
+    return cb;
+}
+
 /*! Given an absolute schema-nodeid (eg /a/b/c) find matching yang spec  
  * @param[in]  yn            Original yang stmt (where call is made)
  * @param[in]  schema_nodeid Absolute schema-node-id, ie /a/b
@@ -2666,12 +3444,15 @@ yang_abs_schema_nodeid(yang_stmt    *yn,
     int           retval = -1;
     cvec         *nodeid_cvv = NULL;
     cvec         *nsc = NULL;
+    cvec         *nscp;
     cg_var       *cv;
     char         *prefix;
     char         *ns;
     yang_stmt    *yspec;
     yang_stmt    *ymod;
     char         *str;
+    cbuf         *key = NULL;
+    yang_stmt   **ymemo;
 
     *yres = NULL;
     yspec = ys_spec(yn);
@@ -2680,6 +3461,16 @@ yang_abs_schema_nodeid(yang_stmt    *yn,
 	clicon_err(OE_YANG, EINVAL, "absolute schema nodeid should start with /");
 	goto done;
     }
+    /* Prefixes depend on the module */
+    if (_schema_nodeid_memo){
+	if ((key = schema_nodeid_memo_key(yang_keyword_get(yn)==Y_SPEC?yn:ys_module(yn),
+					  schema_nodeid)) == NULL)
+	    goto done;
+	if ((ymemo = clicon_hash_value(_schema_nodeid_memo, cbuf_get(key), NULL)) != NULL){
+	    *yres = *ymemo;
+	    goto ok;
+	}
+    }
     /* Split nodeid on the form /p0:i0/p1:i1 to a cvec with [name:p0 value:i0][...]
      */
     if (uri_str2cvec(schema_nodeid, '/', ':', 1, &nodeid_cvv) < 0)
@@ -2697,18 +3488,20 @@ yang_abs_schema_nodeid(yang_stmt    *yn,
 	    cv_name_set(cv, NULL);
 	}
     }
-    /* Make a namespace context from yang for the prefixes (names) of nodeid_cvv */
+    /* Make a namespace context from yang for the prefixes (names) of nodeid_cvv 
+     * The context of a module is shared, see xml_nsctx_yang_get */
     if (yang_keyword_get(yn) == Y_SPEC){
 	if (xml_nsctx_yangspec(yn, &nsc) < 0)
 	    goto done;
+	nscp = nsc;
     }
-    else if (xml_nsctx_yang(yn, &nsc) < 0)
-	    goto done;
+    else if ((nscp = xml_nsctx_yang_get(yn)) == NULL)
+	goto done;
     /* Since this is an _absolute_ schema nodeid start from top 
      * Get namespace */
     cv = cvec_i(nodeid_cvv, 0);
     prefix = cv_name_get(cv);
-    if ((ns = xml_nsctx_get(nsc, prefix)) == NULL){
+    if ((ns = xml_nsctx_get(nscp, prefix)) == NULL){
 	clicon_err(OE_YANG, EFAULT, "No namespace for prefix: %s in schema node identifier: %s",
 		   prefix, schema_nodeid);
 	goto done;
@@ -2720,11 +3513,16 @@ yang_abs_schema_nodeid(yang_stmt    *yn,
 	goto done;
     }
     /* Iterate through cvv to find schemanode using ymod as starting point (since it is absolute) */
-    if (schema_nodeid_iterate(ymod, nodeid_cvv, nsc, yres) < 0)
+    if (schema_nodeid_iterate(ymod, nodeid_cvv, nscp, yres) < 0)
+	goto done;
+    if (key && *yres &&
+	clicon_hash_add(_schema_nodeid_memo, cbuf_get(key), yres, sizeof(*yres)) == NULL)
 	goto done;
  ok:
     retval = 0;
  done:
+    if (key)
+	cbuf_free(key);
     if (nodeid_cvv)
 	cvec_free(nodeid_cvv);
     if (nsc)
@@ -2751,7 +3549,9 @@ yang_desc_schema_nodeid(yang_stmt    *yn,
     cvec         *nodeid_cvv = NULL;
     cg_var       *cv;
     char         *str;
-    cvec         *nsc = NULL;
+    cvec         *nsc;
+    cbuf         *key = NULL;
+    yang_stmt   **ymemo;
     
     if (schema_nodeid == NULL || strlen(schema_nodeid) == 0){
 	clicon_err(OE_YANG, EINVAL, "nodeid is empty");
@@ -2763,6 +3563,14 @@ yang_desc_schema_nodeid(yang_stmt    *yn,
 	clicon_err(OE_YANG, EINVAL, "descendant schema nodeid should not start with /");
 	goto done;
     }
+    if (_schema_nodeid_memo){
+	if ((key = schema_nodeid_memo_key(yn, schema_nodeid)) == NULL)
+	    goto done;
+	if ((ymemo = clicon_hash_value(_schema_nodeid_memo, cbuf_get(key), NULL)) != NULL){
+	    *yres = *ymemo;
+	    goto ok;
+	}
+    }
     /* Split nodeid on the form /p0:i0/p1:i1 to a cvec with [name:p0 value:i0][...]
      */
     if (uri_str2cvec(schema_nodeid, '/', ':', 1, &nodeid_cvv) < 0)
@@ -2780,17 +3588,21 @@ yang_desc_schema_nodeid(yang_stmt    *yn,
 	    cv_name_set(cv, NULL);
 	}
     }
-    /* Make a namespace context from yang for the prefixes (names) of nodeid_cvv */
-    if (xml_nsctx_yang(yn, &nsc) < 0)
+    /* Namespace context from yang for the prefixes (names) of nodeid_cvv, shared by
+     * all nodes of the module */
+    if ((nsc = xml_nsctx_yang_get(yn)) == NULL)
 	goto done;
     /* Iterate through cvv to find schemanode using yn as relative starting point */
     if (schema_nodeid_iterate(yn, nodeid_cvv, nsc, yres) < 0)
 	goto done;
+    if (key && *yres &&
+	clicon_hash_add(_schema_nodeid_memo, cbuf_get(key), yres, sizeof(*yres)) == NULL)
+	goto done;
  ok:
     retval = 0;
  done:
-    if (nsc)
-	cvec_free(nsc);
+    if (key)
+	cbuf_free(key);
     if (nodeid_cvv)
 	cvec_free(nodeid_cvv);
     return retval;
@@ -3153,6 +3965,46 @@ yang_type_cache_get(yang_stmt   *ytype,
     return retval;
 }
 
+/*! Get compiled validator from yang type cache
+ * @param[in]  ytype  Yang type statement
+ * @param[out] yvp    Validator, NULL if not compiled yet
+ * @retval    -1      Error
+ * @retval     0      No cache
+ * @retval     1      OK
+ * @see yang_validator_get
+ */
+int
+yang_type_cache_validator_get(yang_stmt              *ytype,
+			      struct yang_validator **yvp)
+{
+    yang_type_cache *ycache;
+
+    if ((ycache = ytype->ys_typecache) == NULL)
+	return 0;
+    *yvp = ycache->yc_validator;
+    return 1;
+}
+
+/*! Set compiled validator of yang type cache, freed with the cache
+ * @param[in]  ytype  Yang type statement with type cache
+ * @param[in]  yv     Validator
+ */
+int
+yang_type_cache_validator_set(yang_stmt             *ytype,
+			      struct yang_validator *yv)
+{
+    yang_type_cache *ycache;
+
+    if ((ycache = ytype->ys_typecache) == NULL){
+	clicon_err(OE_YANG, ENOENT, "yang type cache");
+	return -1;
+    }
+    if (ycache->yc_validator)
+	yang_validator_free(ycache->yc_validator);
+    ycache->yc_validator = yv;
+    return 0;
+}
+
 /*! Copy yang type cache
  */
 static int
@@ -3195,6 +4047,8 @@ yang_type_cache_free(yang_type_cache *ycache)
     cg_var *cv;
     void   *p;
     
+    if (ycache->yc_validator)
+	yang_validator_free(ycache->yc_validator);
     if (ycache->yc_cvv)
 	cvec_free(ycache->yc_cvv);
     if (ycache->yc_patterns)
@@ -3376,4 +4230,78 @@ yang_search_index_extension(clicon_handle h,
     return retval;
 }
 
+/*! Mark leafs given by CLICON_YANG_SEARCH_INDEX options as search indexes
+ *
+ * Same as the search_index extension, but the search indexes are given in the config
+ * instead of in the YANG modules. Called each time modules are loaded, options referring
+ * to modules not loaded are skipped.
+ * @param[in] h      Clixon handle
+ * @param[in] yspec  Yang spec
+ * @retval    0      OK (warnings may appear)
+ * @retval   -1      Error
+ */
+int
+yang_search_index_config(clicon_handle h,
+			 yang_stmt    *yspec)
+{
+    int        retval = -1;
+    cxobj     *x = NULL;
+    char      *path;
+    char      *step = NULL;
+    char      *prefix = NULL;
+    char      *id = NULL;
+    yang_stmt *ys;
+
+    if (h == NULL || clicon_conf_xml(h) == NULL)
+	goto ok;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+	if (strcmp(xml_name(x), "CLICON_YANG_SEARCH_INDEX") != 0)
+	    continue;
+	if ((path = xml_body(x)) == NULL)
+	    continue;
+	if (path[0] != '/'){
+	    clicon_log(LOG_WARNING, "CLICON_YANG_SEARCH_INDEX %s: should be an absolute schema node identifier", path);
+	    continue;
+	}
+	/* Skip if the module of the first node is not loaded */
+	if ((step = strndup(path+1, strcspn(path+1, "/"))) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	if (nodeid_split(step, &prefix, &id) < 0)
+	    goto done;
+	if (prefix != NULL &&
+	    yang_find_module_by_prefix_yspec(yspec, prefix) != NULL){
+	    if (yang_abs_schema_nodeid(yspec, path, &ys) < 0)
+		goto done;
+	    if (ys == NULL)
+		clicon_debug(1, "%s %s not found", __FUNCTION__, path);
+	    else if (yang_keyword_get(ys) != Y_LEAF)
+		clicon_log(LOG_WARNING, "CLICON_YANG_SEARCH_INDEX %s: not a leaf", path);
+	    else if (yang_list_index_add(ys) < 0)
+		goto done;
+	}
+	free(step);
+	step = NULL;
+	if (prefix){
+	    free(prefix);
+	    prefix = NULL;
+	}
+	if (id){
+	    free(id);
+	    id = NULL;
+	}
+    }
+ ok:
+    retval = 0;
+ done:
+    if (step)
+	free(step);
+    if (prefix)
+	free(prefix);
+    if (id)
+	free(id);
+    return retval;
+}
+
 #endif /* XML_EXPLICIT_INDEX */
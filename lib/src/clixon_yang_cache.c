@@ -0,0 +1,1141 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary cache of parsed and populated YANG specs, see CLICON_YANG_CACHE_DIR
+ *
+ * A yang spec is saved in the cache directory after each yang_spec_parse_module(),
+ * yang_spec_parse_file() and yang_spec_load_dir() call, and loaded instead of parsing
+ * by later processes making the same sequence of calls.
+ * The cache file is named by a key computed from:
+ * - The key of the yang spec before the call, ie the earlier calls
+ * - The call and its arguments
+ * - The clixon version and cache format
+ * - The config options, eg CLICON_FEATURE and CLICON_YANG_DIR
+ * - Name, size and modification time of the yang files in CLICON_YANG_DIR and loaded dirs
+ * - Loaded plugins with extension callbacks
+ * The file contains the expanded yang tree in pre-order. References between yang
+ * statements, such as resolved types and augmented modules, are saved as statement
+ * numbers. Compiled regexps are not saved, they are compiled when first used.
+ * Reverse dependencies are computed again when loaded, see yang_dep_init.
+ * Yang arguments are not copied when loaded but refer to the mapped file, so that
+ * frontend processes loading the same spec share them, see YANG_FLAG_MAPPED.
+ * @note Plugin extension callbacks are not called when a yang spec is loaded from cache
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <syslog.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/param.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_file.h"
+#include "clixon_yang.h"
+#include "clixon_yang_type.h"
+#include "clixon_xml.h"
+#include "clixon_options.h"
+#include "clixon_data.h"
+#include "clixon_yang_module.h"
+#include "clixon_plugin.h"
+#include "clixon_yang_dep.h"
+#include "clixon_yang_internal.h" /* internal included by this file only, not API*/
+#include "clixon_yang_cache.h"
+
+/* Cache file magic and format version, change version if format is changed */
+#define YANG_CACHE_MAGIC   "CLIXONYC"
+#define YANG_CACHE_VERSION 3
+
+/* Null string length in cache file */
+#define YANG_CACHE_NULL    0xffffffff
+
+/* Flags that are dynamic and not saved */
+#define YANG_CACHE_FLAGS_DYNAMIC (YANG_FLAG_MARK|YANG_FLAG_TMP|YANG_FLAG_DEP_SELF|YANG_FLAG_DEP_DESC|YANG_FLAG_MAPPED|YANG_FLAG_DESCNAMES|YANG_FLAG_SHARED)
+
+/* Mapped cache file, kept as long as the process since yang arguments refer to it */
+struct ycmap{
+    void  *m_buf;
+    size_t m_len;
+};
+
+/* Cache read cursor */
+struct ycr{
+    const uint8_t *r_p;   /* Current position */
+    const uint8_t *r_end; /* End of buffer */
+    int            r_err; /* Format error, eg truncated file */
+};
+
+/* Reference to be resolved when all statements are read */
+struct ycref{
+    yang_stmt **rf_ptr;   /* Where to write the reference */
+    uint32_t    rf_i;     /* Statement number */
+};
+
+/* Statements being read */
+struct ycload{
+    yang_stmt   **yl_vec;    /* Statements in pre-order */
+    uint32_t      yl_len;
+    uint32_t      yl_max;
+    struct ycref *yl_refs;   /* References */
+    int           yl_rlen;
+    int           yl_rmax;
+    int           yl_mapped; /* Arguments refer to buffer, see YANG_FLAG_MAPPED */
+};
+
+/*! 64-bit FNV-1a hash of buffer, continued from hash
+ */
+static uint64_t
+yang_cache_hash(uint64_t    hash,
+		const void *buf,
+		size_t      len)
+{
+    const uint8_t *p = buf;
+    size_t         i;
+
+    for (i=0; i<len; i++){
+	hash ^= p[i];
+	hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+/*! Hash string including terminating null, NULL is hashed as empty string
+ */
+static uint64_t
+yang_cache_hash_str(uint64_t    hash,
+		    const char *str)
+{
+    if (str == NULL)
+	str = "";
+    return yang_cache_hash(hash, str, strlen(str)+1);
+}
+
+/*! Hash name, size and modification time of yang files in a directory
+ * @param[in]  hash  Hash to continue
+ * @param[in]  dir   Directory
+ * @retval     hash  New hash. A directory that can not be read is hashed by name only
+ */
+static uint64_t
+yang_cache_hash_dir(uint64_t    hash,
+		    const char *dir)
+{
+    struct dirent *dp = NULL;
+    int            ndp;
+    int            i;
+    char           filename[MAXPATHLEN];
+    struct stat    st;
+
+    hash = yang_cache_hash_str(hash, dir);
+    if ((ndp = clicon_file_dirent(dir, &dp, "(.yang)$", S_IFREG)) < 0){
+	clicon_err_reset();
+	return hash;
+    }
+    for (i=0; i<ndp; i++){
+	snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
+	hash = yang_cache_hash_str(hash, dp[i].d_name);
+	if (stat(filename, &st) == 0){
+	    hash = yang_cache_hash(hash, &st.st_size, sizeof(st.st_size));
+	    hash = yang_cache_hash(hash, &st.st_mtime, sizeof(st.st_mtime));
+	}
+    }
+    if (dp)
+	free(dp);
+    return hash;
+}
+
+/*! Compute cache key of a yang spec load call
+ * @param[in]  h      Clicon handle
+ * @param[in]  yspec  Yang spec
+ * @param[in]  op     Load call, eg "module"
+ * @param[in]  arg    First argument of call, eg module name
+ * @param[in]  arg2   Second argument of call, or NULL
+ * @retval     key    Cache key
+ */
+static uint64_t
+yang_cache_key(clicon_handle h,
+	       yang_stmt    *yspec,
+	       const char   *op,
+	       const char   *arg,
+	       const char   *arg2)
+{
+    uint64_t       hash = 0xcbf29ce484222325ULL;
+    char           name[64];
+    void          *p;
+    uint64_t       key0 = 0;
+    uint64_t       dirs;
+    cxobj         *x;
+    cxobj         *xc;
+    clixon_plugin *cp;
+    struct stat    st;
+    int            version = YANG_CACHE_VERSION;
+
+    /* Key of earlier calls on this yang spec */
+    snprintf(name, sizeof(name), "yang-cache-key-%p", yspec);
+    if ((p = clicon_hash_value(clicon_data(h), name, NULL)) != NULL)
+	key0 = *(uint64_t*)p;
+    hash = yang_cache_hash(hash, &key0, sizeof(key0));
+    hash = yang_cache_hash(hash, &version, sizeof(version));
+    hash = yang_cache_hash_str(hash, CLIXON_VERSION_STRING);
+    hash = yang_cache_hash_str(hash, op);
+    hash = yang_cache_hash_str(hash, arg);
+    hash = yang_cache_hash_str(hash, arg2);
+    if (strcmp(op, "dir") == 0)
+	hash = yang_cache_hash_dir(hash, arg);
+    else if (strcmp(op, "file") == 0 && stat(arg, &st) == 0){
+	hash = yang_cache_hash(hash, &st.st_size, sizeof(st.st_size));
+	hash = yang_cache_hash(hash, &st.st_mtime, sizeof(st.st_mtime));
+    }
+    /* Config options, including CLICON_FEATURE and CLICON_YANG_DIR */
+    if ((x = clicon_conf_xml(h)) != NULL){
+	xc = NULL;
+	while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL){
+	    hash = yang_cache_hash_str(hash, xml_name(xc));
+	    hash = yang_cache_hash_str(hash, xml_body(xc));
+	}
+    }
+    /* Yang files in yang dirs, computed once since directories are read-only here */
+    if ((p = clicon_hash_value(clicon_data(h), "yang-cache-dirs", NULL)) != NULL)
+	dirs = *(uint64_t*)p;
+    else {
+	dirs = 0;
+	if ((x = clicon_conf_xml(h)) != NULL){
+	    xc = NULL;
+	    while ((xc = xml_child_each(x, xc, CX_ELMNT)) != NULL)
+		if (strcmp(xml_name(xc), "CLICON_YANG_DIR") == 0)
+		    dirs = yang_cache_hash_dir(dirs, xml_body(xc));
+	}
+	if (clicon_hash_add(clicon_data(h), "yang-cache-dirs", &dirs, sizeof(dirs)) == NULL)
+	    clicon_err_reset();
+    }
+    hash = yang_cache_hash(hash, &dirs, sizeof(dirs));
+    /* Plugins with extension callbacks may modify the yang spec when parsed */
+    cp = NULL;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL)
+	if (cp->cp_api.ca_extension){
+	    hash = yang_cache_hash_str(hash, cp->cp_name);
+	    if (stat(cp->cp_name, &st) == 0)
+		hash = yang_cache_hash(hash, &st.st_mtime, sizeof(st.st_mtime));
+	}
+    if (hash == 0) /* 0 means no key */
+	hash = 1;
+    return hash;
+}
+
+/*! Set cache key of yang spec after a load call
+ */
+static int
+yang_cache_key_set(clicon_handle h,
+		   yang_stmt    *yspec,
+		   uint64_t      key)
+{
+    char name[64];
+
+    snprintf(name, sizeof(name), "yang-cache-key-%p", yspec);
+    if (clicon_hash_add(clicon_data(h), name, &key, sizeof(key)) == NULL)
+	return -1;
+    return 0;
+}
+
+/*! Get cache key of a yang spec, combined from all its loads with cache enabled
+ *
+ * The key can be used by other caches derived from the yang spec, eg the autocli
+ * @param[in]  h     Clicon handle
+ * @param[in]  yspec Yang spec
+ * @param[out] keyp  Cache key
+ * @retval     1     OK
+ * @retval     0     No key, eg cache not enabled
+ */
+int
+yang_cache_key_get(clicon_handle h,
+		   yang_stmt    *yspec,
+		   uint64_t     *keyp)
+{
+    char  name[64];
+    void *p;
+
+    snprintf(name, sizeof(name), "yang-cache-key-%p", yspec);
+    if (clicon_option_str(h, "CLICON_YANG_CACHE_DIR") == NULL ||
+	(p = clicon_hash_value(clicon_data(h), name, NULL)) == NULL)
+	return 0;
+    *keyp = *(uint64_t*)p;
+    return 1;
+}
+
+/*! Get cache filename of key
+ * @param[in]  h    Clicon handle
+ * @param[in]  key  Cache key
+ * @param[out] cb   Filename
+ * @retval     1    OK
+ * @retval     0    Cache is not enabled
+ */
+static int
+yang_cache_filename(clicon_handle h,
+		    uint64_t      key,
+		    cbuf         *cb)
+{
+    char *dir;
+
+    if ((dir = clicon_option_str(h, "CLICON_YANG_CACHE_DIR")) == NULL)
+	return 0;
+    cprintf(cb, "%s/%016" PRIx64 ".yangc", dir, key);
+    return 1;
+}
+
+/*---------------------------------------------------------------
+ * Write
+ */
+
+static int
+ycw_u8(FILE   *f,
+       uint8_t v)
+{
+    return fwrite(&v, sizeof(v), 1, f) == 1 ? 0 : -1;
+}
+
+static int
+ycw_u32(FILE    *f,
+	uint32_t v)
+{
+    return fwrite(&v, sizeof(v), 1, f) == 1 ? 0 : -1;
+}
+
+static int
+ycw_str(FILE       *f,
+	const char *str)
+{
+    uint32_t len;
+
+    if (str == NULL)
+	return ycw_u32(f, YANG_CACHE_NULL);
+    len = strlen(str);
+    if (ycw_u32(f, len) < 0)
+	return -1;
+    /* Null-terminated so that it can be used in the mapped file */
+    if (fwrite(str, len+1, 1, f) != 1)
+	return -1;
+    return 0;
+}
+
+/*! Write a cligen variable: type, name and value as string
+ */
+static int
+ycw_cv(FILE   *f,
+       cg_var *cv)
+{
+    int   retval = -1;
+    char *str = NULL;
+    enum cv_type type;
+
+    type = cv_type_get(cv);
+    if (ycw_u8(f, type) < 0 ||
+	ycw_str(f, cv_name_get(cv)) < 0 ||
+	ycw_u8(f, type==CGV_DEC64?cv_dec64_n_get(cv):0) < 0 ||
+	ycw_u8(f, cv_flag(cv, V_UNSET|V_INVERT)) < 0)
+	goto done;
+    switch (type){
+    case CGV_ERR:
+    case CGV_EMPTY:
+    case CGV_VOID:
+	break;
+    case CGV_STRING:
+    case CGV_REST:
+	if (cv_string_get(cv) == NULL)
+	    break;
+	/* fall through */
+    default:
+	if ((str = cv2str_dup(cv)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cv2str_dup");
+	    goto done;
+	}
+	break;
+    }
+    if (ycw_str(f, str) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (str)
+	free(str);
+    return retval;
+}
+
+/*! Write an optional cligen variable vector
+ */
+static int
+ycw_cvec(FILE *f,
+	 cvec *cvv)
+{
+    cg_var *cv = NULL;
+
+    if (cvv == NULL)
+	return ycw_u8(f, 0);
+    if (ycw_u8(f, 1) < 0 ||
+	ycw_u32(f, cvec_len(cvv)) < 0)
+	return -1;
+    while ((cv = cvec_each(cvv, cv)) != NULL)
+	if (ycw_cv(f, cv) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Write reference to yang statement as statement number
+ * @retval  1  OK
+ * @retval  0  Statement is not in the yang spec, do not save
+ * @retval -1  Error
+ */
+static int
+ycw_ref(FILE       *f,
+	yang_stmt  *ys,
+	yang_stmt **vec,
+	int         len)
+{
+    int i;
+
+    if (ys == NULL)
+	return ycw_u32(f, YANG_CACHE_NULL) < 0 ? -1 : 1;
+    i = ys->_ys_vector_i;
+    if (i < 0 || i >= len || vec[i] != ys)
+	return 0;
+    return ycw_u32(f, i) < 0 ? -1 : 1;
+}
+
+/*! Number yang statements in pre-order
+ * The statement number is kept in _ys_vector_i while saving, which is otherwise
+ * only used by yn_each
+ */
+static int
+yang_cache_number(yang_stmt   *ys,
+		  yang_stmt ***vecp,
+		  int         *lenp,
+		  int         *maxp)
+{
+    int i;
+
+    if (*lenp >= *maxp){
+	*maxp = *maxp ? 2 * *maxp : 1024;
+	if ((*vecp = realloc(*vecp, *maxp * sizeof(yang_stmt *))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+    }
+    ys->_ys_vector_i = *lenp;
+    (*vecp)[(*lenp)++] = ys;
+    for (i=0; i<ys->ys_len; i++)
+	if (yang_cache_number(ys->ys_stmt[i], vecp, lenp, maxp) < 0)
+	    return -1;
+    return 0;
+}
+
+/*! Write yang statements in pre-order
+ * @retval  1  OK
+ * @retval  0  Yang spec can not be saved, eg reference outside of yang spec
+ * @retval -1  Error
+ */
+static int
+ycw_stmt(FILE       *f,
+	 yang_stmt **vec,
+	 int         len)
+{
+    int              i;
+    yang_stmt       *ys;
+    yang_type_cache *yc;
+    int              ret;
+
+    for (i=0; i<len; i++){
+	ys = vec[i];
+	if (ycw_u32(f, ys->ys_keyword) < 0 ||
+	    ycw_u32(f, ys->ys_flags & ~YANG_CACHE_FLAGS_DYNAMIC) < 0 ||
+	    ycw_u32(f, ys->ys_len) < 0 ||
+	    ycw_str(f, ys->ys_argument) < 0)
+	    return -1;
+	if ((ret = ycw_ref(f, ys->ys_mymodule, vec, len)) <= 0)
+	    return ret;
+	if (ys->ys_cv == NULL){
+	    if (ycw_u8(f, 0) < 0)
+		return -1;
+	}
+	else if (ycw_u8(f, 1) < 0 || ycw_cv(f, ys->ys_cv) < 0)
+	    return -1;
+	if (ycw_cvec(f, ys->ys_cvec) < 0)
+	    return -1;
+	if ((yc = ys->ys_typecache) == NULL){
+	    if (ycw_u8(f, 0) < 0)
+		return -1;
+	}
+	else {
+	    if (ycw_u8(f, 1) < 0 ||
+		ycw_u32(f, yc->yc_options) < 0 ||
+		ycw_cvec(f, yc->yc_cvv) < 0 ||
+		ycw_cvec(f, yc->yc_patterns) < 0 ||
+		ycw_u8(f, yc->yc_fraction) < 0)
+		return -1;
+	    if ((ret = ycw_ref(f, yc->yc_resolved, vec, len)) <= 0)
+		return ret;
+	}
+	if (ycw_str(f, ys->ys_when_xpath) < 0 ||
+	    ycw_cvec(f, ys->ys_when_nsc) < 0)
+	    return -1;
+    }
+    return 1;
+}
+
+/*! Write yang spec in cache format
+ * @param[in]  f      Open file
+ * @param[in]  yspec  Yang spec
+ * @param[in]  key    Key written in header
+ * @retval     1      OK
+ * @retval     0      Yang spec can not be written, eg reference outside of yang spec
+ * @retval    -1      Error
+ * @see yang_cache_parse
+ */
+int
+yang_cache_fwrite(FILE      *f,
+		  yang_stmt *yspec,
+		  uint64_t   key)
+{
+    int         retval = -1;
+    yang_stmt **vec = NULL;
+    int         len = 0;
+    int         max = 0;
+    int         i;
+
+    if (yang_cache_number(yspec, &vec, &len, &max) < 0)
+	goto done;
+    if (fwrite(YANG_CACHE_MAGIC, strlen(YANG_CACHE_MAGIC), 1, f) != 1 ||
+	ycw_u32(f, YANG_CACHE_VERSION) < 0 ||
+	fwrite(&key, sizeof(key), 1, f) != 1 ||
+	ycw_u32(f, len) < 0 ||
+	(retval = ycw_stmt(f, vec, len)) < 0){
+	clicon_err(OE_UNIX, errno, "fwrite");
+	goto done;
+    }
+ done:
+    for (i=0; i<len; i++)
+	vec[i]->_ys_vector_i = 0;
+    if (vec)
+	free(vec);
+    return retval;
+}
+
+/*! Save yang spec in cache
+ *
+ * The file is written to a temporary file which is renamed, so that processes loading
+ * the cache at the same time see the old or the new file.
+ * @param[in]  h      Clicon handle
+ * @param[in]  yspec  Yang spec
+ * @param[in]  key    Cache key from yang_cache_load
+ * @retval     0      OK, also if the yang spec could not be saved
+ * @retval    -1      Error
+ * @see yang_cache_load
+ */
+int
+yang_cache_save(clicon_handle h,
+		yang_stmt    *yspec,
+		uint64_t      key)
+{
+    int         retval = -1;
+    cbuf       *cb = NULL;
+    cbuf       *cbtmp = NULL;
+    FILE       *f = NULL;
+    int         ret = 0;
+
+    if (yang_cache_key_set(h, yspec, key) < 0)
+	goto done;
+    if ((cb = cbuf_new()) == NULL ||
+	(cbtmp = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (yang_cache_filename(h, key, cb) == 0)
+	goto ok;
+    cprintf(cbtmp, "%s.%d", cbuf_get(cb), getpid());
+    if ((f = fopen(cbuf_get(cbtmp), "w")) == NULL){
+	/* Not fatal, eg read-only cache dir */
+	clicon_log(LOG_WARNING, "%s: %s: %s", __FUNCTION__, cbuf_get(cbtmp), strerror(errno));
+	goto ok;
+    }
+    if ((ret = yang_cache_fwrite(f, yspec, key)) < 0)
+	goto done;
+    if (fclose(f) < 0){
+	f = NULL;
+	clicon_err(OE_UNIX, errno, "fclose %s", cbuf_get(cbtmp));
+	goto done;
+    }
+    f = NULL;
+    if (ret == 0){
+	clicon_debug(1, "%s yang spec can not be saved", __FUNCTION__);
+	unlink(cbuf_get(cbtmp));
+	goto ok;
+    }
+    if (rename(cbuf_get(cbtmp), cbuf_get(cb)) < 0){
+	clicon_err(OE_UNIX, errno, "rename %s", cbuf_get(cb));
+	goto done;
+    }
+    clicon_debug(1, "%s %s saved", __FUNCTION__, cbuf_get(cb));
+ ok:
+    retval = 0;
+ done:
+    if (f){
+	fclose(f);
+	unlink(cbuf_get(cbtmp));
+    }
+    if (cb)
+	cbuf_free(cb);
+    if (cbtmp)
+	cbuf_free(cbtmp);
+    return retval;
+}
+
+/*---------------------------------------------------------------
+ * Read
+ */
+
+static uint8_t
+ycr_u8(struct ycr *r)
+{
+    if (r->r_err || r->r_p + 1 > r->r_end){
+	r->r_err = 1;
+	return 0;
+    }
+    return *r->r_p++;
+}
+
+static uint32_t
+ycr_u32(struct ycr *r)
+{
+    uint32_t v;
+
+    if (r->r_err || r->r_p + sizeof(v) > r->r_end){
+	r->r_err = 1;
+	return 0;
+    }
+    memcpy(&v, r->r_p, sizeof(v));
+    r->r_p += sizeof(v);
+    return v;
+}
+
+/*! Read string
+ * @param[out] strp  Malloced string, or NULL
+ * @retval     0     OK, check r_err for format error
+ * @retval    -1     Error
+ */
+static int
+ycr_str(struct ycr *r,
+	char      **strp)
+{
+    uint32_t len;
+
+    *strp = NULL;
+    len = ycr_u32(r);
+    if (r->r_err || len == YANG_CACHE_NULL)
+	return 0;
+    if (r->r_p + len + 1 > r->r_end || r->r_p[len] != '\0'){
+	r->r_err = 1;
+	return 0;
+    }
+    if ((*strp = malloc(len+1)) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	return -1;
+    }
+    memcpy(*strp, r->r_p, len+1);
+    r->r_p += len + 1;
+    return 0;
+}
+
+/*! Read string in place, ie refer to the mapped cache file
+ * Pages of the file that are not written to are shared by all processes
+ * loading the same cache file.
+ * @param[out] strp  String in mapped file, or NULL
+ */
+static void
+ycr_str_mapped(struct ycr *r,
+	       char      **strp)
+{
+    uint32_t len;
+
+    *strp = NULL;
+    len = ycr_u32(r);
+    if (r->r_err || len == YANG_CACHE_NULL)
+	return;
+    if (r->r_p + len + 1 > r->r_end || r->r_p[len] != '\0'){
+	r->r_err = 1;
+	return;
+    }
+    *strp = (char*)r->r_p;
+    r->r_p += len + 1;
+}
+
+/*! Read cligen variable into existing cv of type from file
+ */
+static int
+ycr_cv_value(struct ycr *r,
+	     cg_var     *cv)
+{
+    int   retval = -1;
+    char *name = NULL;
+    char *str = NULL;
+    char *reason = NULL;
+    uint8_t n;
+    uint8_t flags;
+
+    if (ycr_str(r, &name) < 0)
+	goto done;
+    if (name)
+	cv_name_set(cv, name);
+    n = ycr_u8(r);
+    if (cv_type_get(cv) == CGV_DEC64)
+	cv_dec64_n_set(cv, n);
+    flags = ycr_u8(r);
+    if (ycr_str(r, &str) < 0)
+	goto done;
+    if (str && cv_parse1(str, cv, &reason) != 1){
+	clicon_err_reset();
+	r->r_err = 1;
+    }
+    if (flags)
+	cv_flag_set(cv, flags);
+    retval = 0;
+ done:
+    if (name)
+	free(name);
+    if (str)
+	free(str);
+    if (reason)
+	free(reason);
+    return retval;
+}
+
+/*! Read cligen variable
+ * @param[out] cvp  New cv, or NULL on format error
+ */
+static int
+ycr_cv(struct ycr *r,
+       cg_var    **cvp)
+{
+    enum cv_type type;
+
+    *cvp = NULL;
+    type = ycr_u8(r);
+    if (r->r_err)
+	return 0;
+    if ((*cvp = cv_new(type)) == NULL){
+	clicon_err(OE_UNIX, errno, "cv_new");
+	return -1;
+    }
+    return ycr_cv_value(r, *cvp);
+}
+
+/*! Read optional cligen variable vector
+ * @param[out] cvvp  New cvec, or NULL if not present
+ */
+static int
+ycr_cvec(struct ycr *r,
+	 cvec      **cvvp)
+{
+    uint32_t     len;
+    uint32_t     i;
+    enum cv_type type;
+    cg_var      *cv;
+
+    *cvvp = NULL;
+    if (ycr_u8(r) == 0)
+	return 0;
+    len = ycr_u32(r);
+    if (r->r_err)
+	return 0;
+    if ((*cvvp = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	return -1;
+    }
+    for (i=0; i<len && !r->r_err; i++){
+	type = ycr_u8(r);
+	if (r->r_err)
+	    break;
+	if ((cv = cvec_add(*cvvp, type)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_add");
+	    return -1;
+	}
+	if (ycr_cv_value(r, cv) < 0)
+	    return -1;
+    }
+    return 0;
+}
+
+/*! Read reference to yang statement, resolved when all statements are read
+ */
+static int
+ycr_ref(struct ycr    *r,
+	struct ycload *yl,
+	yang_stmt    **ptr)
+{
+    uint32_t i;
+
+    i = ycr_u32(r);
+    if (r->r_err || i == YANG_CACHE_NULL)
+	return 0;
+    if (yl->yl_rlen >= yl->yl_rmax){
+	yl->yl_rmax = yl->yl_rmax ? 2 * yl->yl_rmax : 1024;
+	if ((yl->yl_refs = realloc(yl->yl_refs, yl->yl_rmax * sizeof(struct ycref))) == NULL){
+	    clicon_err(OE_UNIX, errno, "realloc");
+	    return -1;
+	}
+    }
+    yl->yl_refs[yl->yl_rlen].rf_ptr = ptr;
+    yl->yl_refs[yl->yl_rlen].rf_i = i;
+    yl->yl_rlen++;
+    return 0;
+}
+
+/*! Read yang statement and its children in pre-order
+ * @param[in]  r      Read cursor
+ * @param[in]  yl     Statements read
+ * @param[in]  ys     Statement to fill in, created by caller
+ * @retval     0      OK, check r_err for format error
+ * @retval    -1      Error
+ */
+static int
+ycr_stmt(struct ycr    *r,
+	 struct ycload *yl,
+	 yang_stmt     *ys)
+{
+    uint32_t         i;
+    uint32_t         len;
+    yang_stmt       *yc;
+    cvec            *cvv = NULL;
+    cvec            *patterns = NULL;
+    int              options;
+    uint8_t          fraction;
+    int              retval = -1;
+
+    if (yl->yl_len >= yl->yl_max){
+	r->r_err = 1;
+	goto ok;
+    }
+    yl->yl_vec[yl->yl_len++] = ys;
+    ys->ys_flags = ycr_u32(r);
+    len = ycr_u32(r);
+    if (yl->yl_mapped){
+	ys->ys_flags |= YANG_FLAG_MAPPED;
+	ycr_str_mapped(r, &ys->ys_argument);
+    }
+    else if (ycr_str(r, &ys->ys_argument) < 0)
+	goto done;
+    if (ycr_ref(r, yl, &ys->ys_mymodule) < 0)
+	goto done;
+    if (ycr_u8(r) && ycr_cv(r, &ys->ys_cv) < 0)
+	goto done;
+    if (ys->ys_cvec){
+	cvec_free(ys->ys_cvec);
+	ys->ys_cvec = NULL;
+    }
+    if (ycr_cvec(r, &ys->ys_cvec) < 0)
+	goto done;
+    if (ycr_u8(r)){
+	options = ycr_u32(r);
+	if (ycr_cvec(r, &cvv) < 0 ||
+	    ycr_cvec(r, &patterns) < 0)
+	    goto done;
+	fraction = ycr_u8(r);
+	if (r->r_err)
+	    goto ok;
+	if (yang_type_cache_set(ys, NULL, options, cvv, patterns, fraction) < 0)
+	    goto done;
+	if (ycr_ref(r, yl, &ys->ys_typecache->yc_resolved) < 0)
+	    goto done;
+    }
+    if (ycr_str(r, &ys->ys_when_xpath) < 0 ||
+	ycr_cvec(r, &ys->ys_when_nsc) < 0)
+	goto done;
+    for (i=0; i<len && !r->r_err; i++){
+	if ((yc = ys_new(ycr_u32(r))) == NULL)
+	    goto done;
+	if (yn_insert(ys, yc) < 0){
+	    ys_free(yc);
+	    goto done;
+	}
+	if (ycr_stmt(r, yl, yc) < 0)
+	    goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (cvv)
+	cvec_free(cvv);
+    if (patterns)
+	cvec_free(patterns);
+    return retval;
+}
+
+/*! Parse yang spec in cache format
+ * @param[in]  buf    Yang spec in cache format
+ * @param[in]  len    Length of buf
+ * @param[in]  key    Key expected in header
+ * @param[in]  mapped If set, arguments refer to buf which must be kept, else copied
+ * @param[in]  yspec  Yang spec, its modules are replaced if parsed
+ * @retval     1      OK and yspec replaced
+ * @retval     0      Format error, yspec unchanged
+ * @retval    -1      Error
+ * @see yang_cache_fwrite
+ */
+int
+yang_cache_parse(const uint8_t *buf,
+		 size_t         len,
+		 uint64_t       key,
+		 int            mapped,
+		 yang_stmt     *yspec)
+{
+    int           retval = -1;
+    struct ycr    r = {buf, buf+len, 0};
+    struct ycload yl = {0,};
+    yang_stmt    *ytmp = NULL;
+    uint64_t      key1;
+    cvec         *cvv;
+    int           i;
+
+    if (len < strlen(YANG_CACHE_MAGIC) + sizeof(uint32_t) + sizeof(key) ||
+	memcmp(buf, YANG_CACHE_MAGIC, strlen(YANG_CACHE_MAGIC)) != 0)
+	goto fail;
+    r.r_p += strlen(YANG_CACHE_MAGIC);
+    if (ycr_u32(&r) != YANG_CACHE_VERSION)
+	goto fail;
+    memcpy(&key1, r.r_p, sizeof(key1));
+    r.r_p += sizeof(key1);
+    if (key1 != key)
+	goto fail;
+    yl.yl_max = ycr_u32(&r);
+    if (r.r_err || yl.yl_max == 0 || yl.yl_max > len)
+	goto fail;
+    yl.yl_mapped = mapped;
+    if ((yl.yl_vec = calloc(yl.yl_max, sizeof(yang_stmt *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    if (ycr_u32(&r) != Y_SPEC)
+	goto fail;
+    if ((ytmp = ys_new(Y_SPEC)) == NULL)
+	goto done;
+    if (ycr_stmt(&r, &yl, ytmp) < 0)
+	goto done;
+    if (r.r_err || yl.yl_len != yl.yl_max)
+	goto fail;
+    /* Statement 0 is the yang spec itself */
+    yl.yl_vec[0] = yspec;
+    for (i=0; i<yl.yl_rlen; i++){
+	if (yl.yl_refs[i].rf_i >= yl.yl_len)
+	    goto fail;
+	*yl.yl_refs[i].rf_ptr = yl.yl_vec[yl.yl_refs[i].rf_i];
+    }
+    /* Replace modules of yang spec */
+    yang_index_reset(yspec);
+    for (i=0; i<yspec->ys_len; i++)
+	if (yspec->ys_stmt[i])
+	    ys_free(yspec->ys_stmt[i]);
+    if (yspec->ys_stmt)
+	free(yspec->ys_stmt);
+    yspec->ys_stmt = ytmp->ys_stmt;
+    yspec->ys_len = ytmp->ys_len;
+    ytmp->ys_stmt = NULL;
+    ytmp->ys_len = 0;
+    for (i=0; i<yspec->ys_len; i++)
+	yspec->ys_stmt[i]->ys_parent = yspec;
+    yspec->ys_flags = ytmp->ys_flags & ~YANG_FLAG_MAPPED;
+    cvv = yspec->ys_cvec;
+    yspec->ys_cvec = ytmp->ys_cvec;
+    ytmp->ys_cvec = cvv;
+    retval = 1;
+ done:
+    if (ytmp)
+	ys_free(ytmp);
+    if (yl.yl_vec)
+	free(yl.yl_vec);
+    if (yl.yl_refs)
+	free(yl.yl_refs);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get mapping of cache file, mapped once per process
+ * The mapping is private and writable, so that pages are copied if a yang argument is
+ * modified. Pages that are not modified are shared by all processes mapping the file.
+ * @param[in]  h     Clicon handle
+ * @param[in]  key   Cache key
+ * @param[in]  file  Cache filename
+ * @param[out] map   Mapping
+ * @retval     1     OK
+ * @retval     0     No cache file
+ * @retval    -1     Error
+ */
+static int
+yang_cache_map(clicon_handle h,
+	       uint64_t      key,
+	       const char   *file,
+	       struct ycmap *map)
+{
+    int         retval = -1;
+    char        name[64];
+    void       *p;
+    int         fd = -1;
+    struct stat st;
+
+    snprintf(name, sizeof(name), "yang-cache-map-%016" PRIx64, key);
+    if ((p = clicon_hash_value(clicon_data(h), name, NULL)) != NULL){
+	memcpy(map, p, sizeof(*map));
+	goto ok;
+    }
+    if ((fd = open(file, O_RDONLY)) < 0)
+	goto fail;
+    if (fstat(fd, &st) < 0 || st.st_size == 0)
+	goto fail;
+    map->m_len = st.st_size;
+    if ((map->m_buf = mmap(NULL, map->m_len, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+	goto fail;
+ ok:
+    retval = 1;
+ done:
+    if (fd != -1)
+	close(fd);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Load yang spec from cache instead of parsing
+ *
+ * Yang arguments, such as names and descriptions, refer to the mapped cache file and
+ * are shared by all processes loading the same file, eg cli and netconf sessions.
+ * @param[in]  h      Clicon handle
+ * @param[in]  yspec  Yang spec, its modules are replaced if loaded from cache
+ * @param[in]  op     Load call: "module", "file" or "dir"
+ * @param[in]  arg    First argument of call: module name, filename or directory
+ * @param[in]  arg2   Second argument of call, eg revision, or NULL
+ * @param[out] keyp   Cache key, call yang_cache_save with it after parsing. 0 if disabled
+ * @retval     1      Loaded from cache
+ * @retval     0      Not loaded, parse yang and save
+ * @retval    -1      Error
+ * @code
+ *   if ((ret = yang_cache_load(h, yspec, "module", module, revision, &key)) < 0)
+ *      err;
+ *   if (ret == 0){
+ *      // parse yang
+ *      if (key && yang_cache_save(h, yspec, key) < 0)
+ *         err;
+ *   }
+ * @endcode
+ * @note The mapping is kept for the lifetime of the process
+ * @see yang_cache_save
+ */
+int
+yang_cache_load(clicon_handle h,
+		yang_stmt    *yspec,
+		const char   *op,
+		const char   *arg,
+		const char   *arg2,
+		uint64_t     *keyp)
+{
+    int          retval = -1;
+    cbuf        *cb = NULL;
+    uint64_t     key = 0;
+    struct ycmap map = {MAP_FAILED, 0};
+    char         name[64];
+    int          ret;
+
+    *keyp = 0;
+    if (clicon_option_str(h, "CLICON_YANG_CACHE_DIR") == NULL)
+	goto fail;
+    key = yang_cache_key(h, yspec, op, arg, arg2);
+    *keyp = key;
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if (yang_cache_filename(h, key, cb) == 0)
+	goto fail;
+    if ((ret = yang_cache_map(h, key, cbuf_get(cb), &map)) < 0)
+	goto done;
+    if (ret == 0)
+	goto fail;
+    if ((ret = yang_cache_parse(map.m_buf, map.m_len, key, 1, yspec)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_log(LOG_WARNING, "%s: %s: Invalid yang cache file", __FUNCTION__, cbuf_get(cb));
+	goto fail;
+    }
+    /* The yang spec refers to the mapping from here */
+    snprintf(name, sizeof(name), "yang-cache-map-%016" PRIx64, key);
+    if (clicon_hash_value(clicon_data(h), name, NULL) == NULL &&
+	clicon_hash_add(clicon_data(h), name, &map, sizeof(map)) == NULL)
+	goto done;
+    map.m_buf = MAP_FAILED;
+    if (yang_cache_key_set(h, yspec, key) < 0)
+	goto done;
+    /* Reverse dependencies are not saved */
+    if (yang_dep_init(yspec) < 0)
+	goto done;
+    clicon_debug(1, "%s %s loaded", __FUNCTION__, cbuf_get(cb));
+    retval = 1;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+ fail:
+    /* Unmap if not used, ie not loaded before */
+    if (map.m_buf != MAP_FAILED){
+	snprintf(name, sizeof(name), "yang-cache-map-%016" PRIx64, key);
+	if (clicon_hash_value(clicon_data(h), name, NULL) == NULL)
+	    munmap(map.m_buf, map.m_len);
+    }
+    retval = 0;
+    goto done;
+}
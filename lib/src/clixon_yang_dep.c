@@ -0,0 +1,544 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Yang reverse dependencies of leafref, must and when constraints
+ *
+ * For every data node, the index gives the schema nodes with constraints whose xpath may
+ * reference it. It is used in incremental validation to revalidate only constraints that
+ * may depend on changed nodes, see xml_yang_validate_changed_top().
+ * Dependencies are computed from names in the xpaths, without prefixes, and are a
+ * superset of the real dependencies:
+ * - The last step of a location path references the value of the node, eg v in ../a/v
+ * - Other steps reference only the existence of nodes, eg a in ../a/v
+ * - Relative paths with only child and self steps in must and when are within the
+ *   subtree of the constraint node itself and give no dependencies, since any change
+ *   there marks the node itself as changed
+ * - Constraints with xpaths that can not be analyzed, eg wildcards or deref(), depend
+ *   on any node, these are kept in the yang spec node.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <syslog.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include "clixon_string.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_err.h"
+#include "clixon_log.h"
+#include "clixon_yang.h"
+#include "clixon_yang_type.h"
+#include "clixon_xml.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
+#include "clixon_xpath_function.h"
+#include "clixon_yang_internal.h" /* internal included by this file only, not API*/
+#include "clixon_yang_dep.h"
+
+/*! Names referenced by the xpaths of one constraint node
+ */
+struct yang_dep_names{
+    cvec *dn_val;   /* Names of nodes whose value is referenced */
+    cvec *dn_path;  /* Names of nodes in paths */
+    int   dn_any;   /* May reference any node */
+};
+
+/*! Data nodes with the same name, used when building the index
+ */
+struct yang_dep_byname{
+    yang_stmt **db_vec;
+    int         db_len;
+};
+
+/*! Free reverse dependencies of a yang node
+ * @param[in]  ys  Yang node
+ */
+int
+yang_dep_free(yang_stmt *ys)
+{
+    struct yang_dep *yd;
+
+    if ((yd = ys->ys_dep) != NULL){
+	if (yd->yd_val)
+	    free(yd->yd_val);
+	if (yd->yd_path)
+	    free(yd->yd_path);
+	free(yd);
+	ys->ys_dep = NULL;
+    }
+    return 0;
+}
+
+/*! Get reverse dependencies of a yang data node
+ *
+ * @param[in]  ys       Yang data node, or yang spec
+ * @param[out] valvec   Constraint nodes that may reference the value of ys (not copied)
+ * @param[out] vallen   Length of valvec
+ * @param[out] pathvec  Constraint nodes that may reference ys in a path (not copied)
+ * @param[out] pathlen  Length of pathvec
+ * @retval     0        OK
+ * If ys is the yang spec, valvec are the constraint nodes that may reference any node
+ * A constraint node is a leafref leaf or a node with must or when statements.
+ * @see yang_dep_init  which builds the index
+ */
+int
+yang_dep_get(yang_stmt   *ys,
+	     yang_stmt ***valvec,
+	     int         *vallen,
+	     yang_stmt ***pathvec,
+	     int         *pathlen)
+{
+    struct yang_dep *yd = ys->ys_dep;
+
+    if (valvec)
+	*valvec = yd?yd->yd_val:NULL;
+    if (vallen)
+	*vallen = yd?yd->yd_vallen:0;
+    if (pathvec)
+	*pathvec = yd?yd->yd_path:NULL;
+    if (pathlen)
+	*pathlen = yd?yd->yd_pathlen:0;
+    return 0;
+}
+
+/*! Add a constraint node to a reverse dependency vector of a node
+ * @param[in]  ys    Referenced yang node
+ * @param[in]  yc    Constraint node
+ * @param[in]  path  0: value is referenced, 1: referenced in path
+ */
+static int
+yang_dep_add(yang_stmt *ys,
+	     yang_stmt *yc,
+	     int        path)
+{
+    int              retval = -1;
+    struct yang_dep *yd;
+    yang_stmt     ***vecp;
+    int             *lenp;
+    yang_stmt      **vec;
+
+    if ((yd = ys->ys_dep) == NULL){
+	if ((yd = malloc(sizeof(*yd))) == NULL){
+	    clicon_err(OE_YANG, errno, "malloc");
+	    goto done;
+	}
+	memset(yd, 0, sizeof(*yd));
+	ys->ys_dep = yd;
+    }
+    vecp = path?&yd->yd_path:&yd->yd_val;
+    lenp = path?&yd->yd_pathlen:&yd->yd_vallen;
+    /* Constraints are added one at a time, check only last */
+    if (*lenp && (*vecp)[*lenp-1] == yc)
+	goto ok;
+    if ((vec = realloc(*vecp, (*lenp+1)*sizeof(yang_stmt *))) == NULL){
+	clicon_err(OE_YANG, errno, "realloc");
+	goto done;
+    }
+    vec[(*lenp)++] = yc;
+    *vecp = vec;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add a name to a name vector if not already there
+ */
+static int
+yang_dep_name_add(cvec *cvv,
+		  char *name)
+{
+    cg_var *cv;
+
+    if (cvec_find(cvv, name) != NULL)
+	return 0;
+    if ((cv = cvec_add(cvv, CGV_STRING)) == NULL){
+	clicon_err(OE_YANG, errno, "cvec_add");
+	return -1;
+    }
+    cv_name_set(cv, name);
+    return 0;
+}
+
+/*! Check if a relative location path only has child, descendant and self steps
+ * @param[in]  xs  XPath tree of type RELLOCPATH
+ */
+static int
+yang_dep_xpath_local(xpath_tree *xs)
+{
+    xpath_tree *xstep;
+
+    xstep = xs->xs_c1?xs->xs_c1:xs->xs_c0;
+    if (xs->xs_c1 && yang_dep_xpath_local(xs->xs_c0) == 0)
+	return 0;
+    if (xstep == NULL || xstep->xs_type != XP_STEP)
+	return 0;
+    switch (xstep->xs_int){
+    case A_CHILD:
+    case A_DESCENDANT:
+    case A_DESCENDANT_OR_SELF:
+    case A_SELF:
+    case A_ATTRIBUTE:
+	return 1;
+    default:
+	return 0;
+    }
+}
+
+static int yang_dep_xpath(xpath_tree *xs, int local, struct yang_dep_names *dn);
+
+/*! Get names of a step of a location path
+ * @param[in]  xs     XPath tree of type STEP
+ * @param[in]  local  Path is local to the constraint node
+ * @param[in]  last   Last step of location path
+ * @param[out] dn     Names
+ */
+static int
+yang_dep_xpath_step(xpath_tree            *xs,
+		    int                    local,
+		    int                    last,
+		    struct yang_dep_names *dn)
+{
+    xpath_tree *xn;
+
+    if (xs == NULL || xs->xs_type != XP_STEP){
+	dn->dn_any++;
+	return 0;
+    }
+    /* Predicates, relative to this step */
+    if (yang_dep_xpath(xs->xs_c1, local, dn) < 0)
+	return -1;
+    if (local)
+	return 0;
+    if ((xn = xs->xs_c0) == NULL){ /* . or .. */
+	if (last)
+	    dn->dn_any++;
+	return 0;
+    }
+    if (xn->xs_type != XP_NODE || xn->xs_s1 == NULL){ /* *, node(), text() */
+	dn->dn_any++;
+	return 0;
+    }
+    return yang_dep_name_add(last?dn->dn_val:dn->dn_path, xn->xs_s1);
+}
+
+/*! Get names of steps of a location path
+ * @param[in]  xs     XPath tree of type RELLOCPATH
+ * @param[in]  local  Path is local to the constraint node
+ * @param[in]  last   Last step of location path is in this tree
+ * @param[out] dn     Names
+ */
+static int
+yang_dep_xpath_rel(xpath_tree            *xs,
+		   int                    local,
+		   int                    last,
+		   struct yang_dep_names *dn)
+{
+    if (xs->xs_type != XP_RELLOCPATH)
+	return yang_dep_xpath_step(xs, local, last, dn);
+    if (xs->xs_c1 == NULL)
+	return yang_dep_xpath_step(xs->xs_c0, local, last, dn);
+    if (yang_dep_xpath_rel(xs->xs_c0, local, 0, dn) < 0)
+	return -1;
+    return yang_dep_xpath_step(xs->xs_c1, local, last, dn);
+}
+
+/*! Get names referenced by an xpath tree
+ * @param[in]  xs     XPath tree
+ * @param[in]  local  Relative paths are local to the constraint node
+ * @param[out] dn     Names
+ */
+static int
+yang_dep_xpath(xpath_tree            *xs,
+	       int                    local,
+	       struct yang_dep_names *dn)
+{
+    if (xs == NULL)
+	return 0;
+    switch (xs->xs_type){
+    case XP_ABSPATH:
+	if (xs->xs_c0 == NULL) /* Root */
+	    dn->dn_any++;
+	else if (yang_dep_xpath_rel(xs->xs_c0, 0, 1, dn) < 0)
+	    return -1;
+	return 0;
+    case XP_RELLOCPATH:
+	return yang_dep_xpath_rel(xs, local && yang_dep_xpath_local(xs), 1, dn);
+    case XP_PATHEXPR:
+	if (yang_dep_xpath(xs->xs_c0, local, dn) < 0)
+	    return -1;
+	if (xs->xs_c1) /* filterexpr / rellocpath, eg current()/../x */
+	    return yang_dep_xpath_rel(xs->xs_c1, 0, 1, dn);
+	return 0;
+    case XP_PRIME_FN:
+	if (xs->xs_int == XPATHFN_DEREF)
+	    dn->dn_any++;
+	break;
+    default:
+	break;
+    }
+    if (yang_dep_xpath(xs->xs_c0, local, dn) < 0)
+	return -1;
+    return yang_dep_xpath(xs->xs_c1, local, dn);
+}
+
+/*! Get names referenced by an xpath string
+ * @param[in]  xpath  XPath string
+ * @param[in]  local  Relative paths are local to the constraint node
+ * @param[out] dn     Names
+ */
+static int
+yang_dep_xpath_str(char                  *xpath,
+		   int                    local,
+		   struct yang_dep_names *dn)
+{
+    int         retval = -1;
+    xpath_tree *xpt = NULL;
+
+    if (xpath_parse(xpath, &xpt) < 0){ /* Cannot analyze: any */
+	clicon_err_reset();
+	dn->dn_any++;
+	goto ok;
+    }
+    if (yang_dep_xpath(xpt, local, dn) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (xpt)
+	xpath_tree_free(xpt);
+    return retval;
+}
+
+/*! Get names referenced by leafref, must and when constraints of a yang node
+ * @param[in]  ys   Yang data node
+ * @param[out] dn   Names
+ * @retval     1    ys has constraints
+ * @retval     0    ys has no constraints
+ * @retval    -1    Error
+ */
+static int
+yang_dep_names_get(yang_stmt             *ys,
+		   struct yang_dep_names *dn)
+{
+    int        retval = -1;
+    yang_stmt *yc = NULL;
+    yang_stmt *yrestype = NULL;
+    yang_stmt *ypath;
+    char      *xpath;
+    int        found = 0;
+
+    while ((yc = yn_each(ys, yc)) != NULL) {
+	if (yc->ys_keyword != Y_MUST && yc->ys_keyword != Y_WHEN)
+	    continue;
+	found++;
+	if (yang_dep_xpath_str(yc->ys_argument, 1, dn) < 0)
+	    goto done;
+    }
+    /* Augmented when is evaluated in the parent */
+    if ((xpath = yang_when_xpath_get(ys)) != NULL){
+	found++;
+	if (yang_dep_xpath_str(xpath, 0, dn) < 0)
+	    goto done;
+    }
+    if (ys->ys_keyword == Y_LEAF || ys->ys_keyword == Y_LEAF_LIST){
+	if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+	    goto done;
+	if (yrestype && strcmp(yang_argument_get(yrestype), "leafref") == 0){
+	    found++;
+	    if ((ypath = yang_find(yrestype, Y_PATH, NULL)) == NULL)
+		dn->dn_any++;
+	    else if (yang_dep_xpath_str(yang_argument_get(ypath), 0, dn) < 0)
+		goto done;
+	}
+    }
+    retval = found?1:0;
+ done:
+    return retval;
+}
+
+/*! Add data node to name hash, yang_apply callback
+ */
+static int
+yang_dep_byname_fn(yang_stmt *ys,
+		   void      *arg)
+{
+    int                     retval = -1;
+    clicon_hash_t          *hash = (clicon_hash_t *)arg;
+    struct yang_dep_byname  db0 = {NULL, 0};
+    struct yang_dep_byname *db;
+    yang_stmt             **vec;
+
+    yang_dep_free(ys);
+    if (!yang_datanode(ys))
+	goto ok;
+    if ((db = clicon_hash_value(hash, ys->ys_argument, NULL)) == NULL){
+	if (clicon_hash_add(hash, ys->ys_argument, &db0, sizeof(db0)) == NULL)
+	    goto done;
+	if ((db = clicon_hash_value(hash, ys->ys_argument, NULL)) == NULL)
+	    goto done;
+    }
+    if ((vec = realloc(db->db_vec, (db->db_len+1)*sizeof(yang_stmt *))) == NULL){
+	clicon_err(OE_YANG, errno, "realloc");
+	goto done;
+    }
+    vec[db->db_len++] = ys;
+    db->db_vec = vec;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Add constraint node to reverse dependencies of the nodes it references
+ * @param[in]  yc    Constraint node
+ * @param[in]  cvv   Names referenced
+ * @param[in]  hash  Data nodes by name
+ * @param[in]  path  0: values are referenced, 1: referenced in path
+ */
+static int
+yang_dep_names_add(yang_stmt     *yc,
+		   cvec          *cvv,
+		   clicon_hash_t *hash,
+		   int            path)
+{
+    cg_var                 *cv = NULL;
+    struct yang_dep_byname *db;
+    int                     i;
+
+    while ((cv = cvec_each(cvv, cv)) != NULL){
+	if ((db = clicon_hash_value(hash, cv_name_get(cv), NULL)) == NULL)
+	    continue;
+	for (i=0; i<db->db_len; i++)
+	    if (yang_dep_add(db->db_vec[i], yc, path) < 0)
+		return -1;
+    }
+    return 0;
+}
+
+/*! Build reverse dependency index of constraint nodes, yang_apply callback
+ * @see YANG_FLAG_XPATH_DEP  only nodes with this flag may have constraints
+ */
+static int
+yang_dep_index_fn(yang_stmt *ys,
+		  void      *arg)
+{
+    int                   retval = -1;
+    clicon_hash_t        *hash = (clicon_hash_t *)arg;
+    struct yang_dep_names dn = {NULL, NULL, 0};
+    yang_stmt            *yspec;
+    int                   ret;
+
+    if (!yang_datanode(ys) || yang_flag_get(ys, YANG_FLAG_XPATH_DEP) == 0)
+	goto ok;
+    if ((dn.dn_val = cvec_new(0)) == NULL ||
+	(dn.dn_path = cvec_new(0)) == NULL){
+	clicon_err(OE_YANG, errno, "cvec_new");
+	goto done;
+    }
+    if ((ret = yang_dep_names_get(ys, &dn)) < 0)
+	goto done;
+    if (ret == 0)
+	goto ok;
+    if (dn.dn_any){
+	if ((yspec = ys_spec(ys)) != NULL &&
+	    yang_dep_add(yspec, ys, 0) < 0)
+	    goto done;
+	goto ok;
+    }
+    if (yang_dep_names_add(ys, dn.dn_val, hash, 0) < 0)
+	goto done;
+    if (yang_dep_names_add(ys, dn.dn_path, hash, 1) < 0)
+	goto done;
+ ok:
+    retval = 0;
+ done:
+    if (dn.dn_val)
+	cvec_free(dn.dn_val);
+    if (dn.dn_path)
+	cvec_free(dn.dn_path);
+    return retval;
+}
+
+/*! Build reverse dependency index from data nodes to leafref, must and when constraints
+ *
+ * The index of all modules in the yang spec is rebuilt.
+ * @param[in]  yspec  Yang spec
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see yang_dep_get  to get the dependencies of a node
+ */
+int
+yang_dep_init(yang_stmt *yspec)
+{
+    int                     retval = -1;
+    clicon_hash_t          *hash = NULL;
+    char                  **keys = NULL;
+    size_t                  nkeys;
+    struct yang_dep_byname *db;
+    int                     i;
+
+    yang_dep_free(yspec);
+    if ((hash = clicon_hash_init()) == NULL)
+	goto done;
+    /* Data nodes by name, also clear old index */
+    if (yang_apply(yspec, -1, yang_dep_byname_fn, hash) < 0)
+	goto done;
+    if (yang_apply(yspec, -1, yang_dep_index_fn, hash) < 0)
+	goto done;
+    retval = 0;
+ done:
+    if (hash){
+	if (clicon_hash_keys(hash, &keys, &nkeys) == 0){
+	    for (i=0; i<nkeys; i++)
+		if ((db = clicon_hash_value(hash, keys[i], NULL)) != NULL && db->db_vec)
+		    free(db->db_vec);
+	}
+	if (keys)
+	    free(keys);
+	clicon_hash_free(hash);
+    }
+    return retval;
+}
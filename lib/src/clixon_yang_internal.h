@@ -56,9 +56,20 @@ struct yang_type_cache{
     uint8_t    yc_fraction; /* Fraction digits for decimal64 (if 
                                YANG_OPTIONS_FRACTION_DIGITS */
     yang_stmt *yc_resolved; /* Resolved type object, can be NULL - note direct ptr */
+    struct yang_validator *yc_validator; /* Compiled on first validation, not copied */
 };
 typedef struct yang_type_cache yang_type_cache;
 
+/*! Reverse dependencies of a yang data node, see yang_dep_init
+ * Constraint nodes are leafref leafs and nodes with must or when statements
+ */
+struct yang_dep{
+    yang_stmt **yd_val;     /* Constraint nodes that may reference the value of node */
+    int         yd_vallen;
+    yang_stmt **yd_path;    /* Constraint nodes that may reference node in a path */
+    int         yd_pathlen;
+};
+
 /*! yang statement 
  */
 struct yang_stmt{
@@ -90,6 +101,19 @@ struct yang_stmt{
     yang_type_cache   *ys_typecache; /* If ys_keyword==Y_TYPE, cache all typedef data except unions */
     char              *ys_when_xpath; /* Special conditional for a "when"-associated augment xpath */
     cvec              *ys_when_nsc;   /* Special conditional for a "when"-associated augment namespace ctx */
+    struct yang_dep   *ys_dep;        /* Reverse dependencies of leafref/must/when, see yang_dep_init */
+    struct yang_index *ys_index;      /* Child lookup index, see yang_find */
+    cvec              *ys_nsc;        /* Y_MODULE/Y_SUBMODULE: shared namespace context,
+					 see xml_nsctx_yang_get */
+    yang_stmt         *ys_json_mod;   /* Real module (not submodule), see yang_json_name_get */
+    char              *ys_json_qname; /* JSON qualified member name "module:name" */
+    uint8_t            ys_json_enc;   /* Leaf/leaf-list: enum yang_json_enc, see
+					 yang_json_enc_get */
+    uint64_t           ys_desc_names; /* Filter of descendant data node names, valid if
+					 YANG_FLAG_DESCNAMES, see yang_desc_names_get */
+    int                ys_order;     /* Cached yang order, valid if ys_order_gen is current,
+					 see yang_order */
+    uint32_t           ys_order_gen;
     int               _ys_vector_i;   /* internal use: yn_each */
 
 };
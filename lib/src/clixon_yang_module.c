@@ -578,6 +578,12 @@ yang_find_module_by_namespace(yang_stmt *yspec,
 	if (yang_find(ymod, Y_NAMESPACE, ns) != NULL)
 	    break;
     }
+    /* Not found: load if module is lazily loaded, see CLICON_YANG_LAZY */
+    if (ymod == NULL && yang_lazy_load(yspec, ns) == 1)
+	while ((ymod = yn_each(yspec, ymod)) != NULL) {
+	    if (yang_find(ymod, Y_NAMESPACE, ns) != NULL)
+		break;
+	}
  done:
     return ymod;
 }
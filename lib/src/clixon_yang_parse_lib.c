@@ -70,6 +70,7 @@
 #include <assert.h>
 #include <libgen.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <sys/param.h>
 #include <netinet/in.h>
 #include <libgen.h>
@@ -99,6 +100,8 @@
 #include "clixon_yang_type.h"
 #include "clixon_yang_parse.h"
 #include "clixon_yang_cardinality.h"
+#include "clixon_yang_dep.h"
+#include "clixon_yang_cache.h"
 #include "clixon_yang_parse_lib.h"
 
 /* Size of json read buffer when reading from file*/
@@ -454,6 +457,34 @@ ys_do_refine(yang_stmt *yr,
     return retval;
 }
 
+/*! Find the node of a copy of a yang tree that corresponds to a node of the original
+ * @param[in]  yorig  Original, eg a grouping
+ * @param[in]  ycopy  Copy of yorig, eg made by ys_dup_shared, with the same children
+ * @param[in]  ys     Descendant-or-self of yorig
+ * @retval     yc     Corresponding descendant-or-self of ycopy
+ * @retval     NULL   Not found, ys is not a descendant of yorig
+ */
+static yang_stmt *
+ys_copy_find(yang_stmt *yorig,
+	     yang_stmt *ycopy,
+	     yang_stmt *ys)
+{
+    yang_stmt *yp;
+    yang_stmt *yc;
+    int        i;
+
+    if (ys == yorig)
+	return ycopy;
+    if ((yp = yang_parent_get(ys)) == NULL)
+	return NULL;
+    if ((yc = ys_copy_find(yorig, ycopy, yp)) == NULL)
+	return NULL;
+    for (i=0; i<yang_len_get(yp); i++)
+	if (yang_child_i(yp, i) == ys)
+	    return yang_child_i(yc, i);
+    return NULL;
+}
+
 /*! Macro expansion of grouping/uses done in step 2 of yang parsing 
  * RFC7950:
  * Identifiers appearing inside the grouping are resolved
@@ -532,8 +563,10 @@ yang_expand_grouping(yang_stmt *yn)
 	    /* Make a copy of the grouping, then make refinements to this copy
 	     * Note this ygrouping2 object does not gave a parent and does not work in many
 	     * functions which assume a full hierarchy, use the original ygrouping in those cases.
+	     * The copy refers to the arguments of the grouping instead of duplicating them,
+	     * groupings are kept until the yang spec is freed.
 	     */
-	    if ((ygrouping2 = ys_dup(ygrouping)) == NULL)
+	    if ((ygrouping2 = ys_dup_shared(ygrouping)) == NULL)
 		goto done;
 
 	    /* Only replace data/schemanodes and unknowns:
@@ -549,6 +582,7 @@ yang_expand_grouping(yang_stmt *yn)
 	     * yn is parent: the children of ygrouping replaces ys.
 	     * Is there a case when glen == 0?  YES AND THIS BREAKS
 	     */
+	    yang_index_reset(yn);
 	    if (glen != 1){
 		size = (yang_len_get(yn) - i - 1)*sizeof(struct yang_stmt *);
 		yn->ys_len += glen - 1;
@@ -578,6 +612,9 @@ yang_expand_grouping(yang_stmt *yn)
 		/* Not found, try next */
 		if (yrt == NULL) 		
 		    continue;
+		/* Refine the copy, not the grouping that is shared by other uses */
+		if ((yrt = ys_copy_find(ygrouping, ygrouping2, yrt)) == NULL)
+		    continue;
 		/* Do the actual refinement */
 		if (ys_do_refine(yr, yrt) < 0)
 		    goto done;
@@ -1324,10 +1361,19 @@ yang_parse_post(clicon_handle h,
 	if (yang_cardinality(h, yang_child_i(yspec, i), yang_argument_get(yspec->ys_stmt[i])) < 0)
 	    goto done;
     
-    /* 3: Check features/if-features: check if enabled and remove disabled features */
+    /* 3: Check features/if-features: check if enabled and remove disabled features 
+     * Populate features of all modules first, an if-feature may refer to a feature of
+     * a later module. Each if-feature expression of a module is evaluated once.
+     */
+    for (i=modmin; i<modmax; i++) 
+	if (yang_features_populate(h, yang_child_i(yspec, i)) < 0)
+	    goto done;
+    if (yang_if_feature_memo_init() < 0)
+	goto done;
     for (i=modmin; i<modmax; i++) 
 	if (yang_features(h, yang_child_i(yspec, i)) < 0)
 	    goto done;
+    yang_if_feature_memo_free();
     
     /* 4: Go through parse tree and populate it with cv types */
     for (i=modmin; i<modmax; i++){
@@ -1359,6 +1405,9 @@ yang_parse_post(clicon_handle h,
 	yang_apply(ylist[i], -1, (yang_applyfn_t*)yang_flag_reset, (void*)YANG_FLAG_MARK);
     }
 
+    /* No yang nodes are removed from here, resolved schema nodeids may be reused */
+    if (yang_schema_nodeid_memo_init() < 0)
+	goto done;
     /* 7: Top-level augmentation of all modules. 
      * Note: Clixon does not implement augment in USES 
      * Note: There is an ordering problem, where an augment in one module depends on an augment in
@@ -1386,8 +1435,18 @@ yang_parse_post(clicon_handle h,
     for (i=0; i<ylen; i++)
 	if (yang_cardinality(h, ylist[i], yang_argument_get(ylist[i])) < 0)
 	    goto done;
+#ifdef XML_EXPLICIT_INDEX
+    /* 10. Search indexes given in config */
+    if (yang_search_index_config(h, yspec) < 0)
+	goto done;
+#endif
+    /* 11. Reverse dependencies of leafref, must and when, for incremental validation */
+    if (yang_dep_init(yspec) < 0)
+	goto done;
     retval = 0;
  done:
+    yang_if_feature_memo_free();
+    yang_schema_nodeid_memo_free();
     if (ylist)
 	free(ylist);
     return retval;
@@ -1411,6 +1470,8 @@ yang_spec_parse_module(clicon_handle h,
     int         retval = -1;
     int         modmin;       /* Existing number of modules */
     char       *base = NULL;;
+    uint64_t    key = 0;      /* Yang cache key */
+    int         ret;
 
     if (yspec == NULL){
 	clicon_err(OE_YANG, EINVAL, "yang spec is NULL");
@@ -1425,10 +1486,16 @@ yang_spec_parse_module(clicon_handle h,
     /* Do not load module if it already exists */
     if (yang_find(yspec, Y_MODULE, module) != NULL)
 	goto ok;
+    if ((ret = yang_cache_load(h, yspec, "module", module, revision, &key)) < 0)
+	goto done;
+    if (ret == 1)
+	goto ok;
     if (yang_parse_module(h, module, revision, yspec) == NULL)
 	goto done;
     if (yang_parse_post(h, yspec, modmin) < 0)
 	goto done;
+    if (key && yang_cache_save(h, yspec, key) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -1455,6 +1522,8 @@ yang_spec_parse_file(clicon_handle h,
     int         retval = -1;
     int         modmin;       /* Existing number of modules */
     char       *base = NULL;;
+    uint64_t    key = 0;      /* Yang cache key */
+    int         ret;
 
     /* Apply steps 2.. on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
@@ -1471,10 +1540,16 @@ yang_spec_parse_file(clicon_handle h,
 	*index(base, '@') = '\0';
     if (yang_find(yspec, Y_MODULE, base) != NULL)
 	goto ok;
+    if ((ret = yang_cache_load(h, yspec, "file", filename, NULL, &key)) < 0)
+	goto done;
+    if (ret == 1)
+	goto ok;
     if (yang_parse_filename(filename, yspec) == NULL)
 	goto done;
     if (yang_parse_post(h, yspec, modmin) < 0)
 	goto done;
+    if (key && yang_cache_save(h, yspec, key) < 0)
+	goto done;
  ok:
     retval = 0;
  done:
@@ -1483,6 +1558,371 @@ yang_spec_parse_file(clicon_handle h,
     return retval;
 }
 
+/*
+ * Lazy loading of modules in yang_spec_load_dir, see CLICON_YANG_LAZY
+ * Instead of parsing, the namespace of each module file is read and saved, and the
+ * module is parsed when its namespace is first looked up, see yang_lazy_load
+ */
+typedef struct {
+    qelem_t       yz_qelem;	/* List header */
+    clicon_handle yz_h;         /* Clicon handle, for parsing */
+    yang_stmt    *yz_yspec;     /* Yang spec to load module into */
+    char         *yz_ns;        /* Namespace of module */
+    char         *yz_filename;  /* Yang file of module */
+} yang_lazy_t;
+
+/* List of modules not yet loaded */
+static yang_lazy_t *yang_lazy_list = NULL;
+
+/*! Read namespace of yang module file without parsing it
+ * Only the statements before the namespace statement are scanned, ie module header
+ * @param[in]  filename  Yang file
+ * @param[out] nsp       Namespace, malloced. NULL if not found, eg submodule
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+yang_lazy_namespace(const char *filename,
+		    char      **nsp)
+{
+    int    retval = -1;
+    FILE  *f = NULL;
+    char   line[1024];
+    char  *s;
+    char  *e;
+    int    comment = 0;  /* In comment */
+    int    first = 1;    /* First keyword, module or submodule */
+
+    *nsp = NULL;
+    if ((f = fopen(filename, "r")) == NULL){
+	clicon_err(OE_YANG, errno, "fopen(%s)", filename);
+	goto done;
+    }
+    while (fgets(line, sizeof(line), f) != NULL){
+	s = line;
+	if (comment){
+	    if ((s = strstr(s, "*/")) == NULL)
+		continue;
+	    s += 2;
+	    comment = 0;
+	}
+	if ((e = strstr(s, "//")) != NULL)
+	    *e = '\0';
+	if ((e = strstr(s, "/*")) != NULL){
+	    *e = '\0';
+	    if (strstr(e+2, "*/") == NULL)
+		comment = 1;
+	}
+	while (isspace(*s))
+	    s++;
+	if (*s == '\0')
+	    continue;
+	if (first){
+	    if (strncmp(s, "module", strlen("module")) != 0)
+		break; /* submodule, loaded with its module */
+	    first = 0;
+	}
+	if ((s = strstr(s, "namespace")) == NULL ||
+	    !isspace(s[strlen("namespace")]))
+	    continue;
+	s += strlen("namespace");
+	while (isspace(*s))
+	    s++;
+	if (*s == '"' || *s == '\''){
+	    if ((e = index(s+1, *s)) == NULL)
+		break;
+	    s++;
+	}
+	else
+	    for (e = s; *e && *e != ';' && !isspace(*e); e++);
+	if ((*nsp = strndup(s, e-s)) == NULL){
+	    clicon_err(OE_UNIX, errno, "strndup");
+	    goto done;
+	}
+	break;
+    }
+    retval = 0;
+ done:
+    if (f)
+	fclose(f);
+    return retval;
+}
+
+/*! Add module file to be loaded when its namespace is looked up
+ * @param[in]  h         Clicon handle
+ * @param[in]  yspec     Yang spec
+ * @param[in]  filename  Yang file
+ * @retval     1         Added
+ * @retval     0         Not added, no namespace found: parse directly
+ * @retval    -1         Error
+ */
+static int
+yang_lazy_add(clicon_handle h,
+	      yang_stmt    *yspec,
+	      char         *filename)
+{
+    int          retval = -1;
+    yang_lazy_t *yz = NULL;
+    char        *ns = NULL;
+
+    if (yang_lazy_namespace(filename, &ns) < 0)
+	goto done;
+    if (ns == NULL)
+	goto fail;
+    if ((yz = malloc(sizeof(*yz))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(yz, 0, sizeof(*yz));
+    yz->yz_h = h;
+    yz->yz_yspec = yspec;
+    yz->yz_ns = ns;
+    ns = NULL;
+    if ((yz->yz_filename = strdup(filename)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	free(yz->yz_ns);
+	free(yz);
+	goto done;
+    }
+    ADDQ(yz, yang_lazy_list);
+    retval = 1;
+ done:
+    if (ns)
+	free(ns);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+static void
+yang_lazy_free1(yang_lazy_t *yz)
+{
+    DELQ(yz, yang_lazy_list, yang_lazy_t *);
+    if (yz->yz_ns)
+	free(yz->yz_ns);
+    if (yz->yz_filename)
+	free(yz->yz_filename);
+    free(yz);
+}
+
+/*! Load module with namespace if it has been added lazily by yang_spec_load_dir
+ * @param[in]  yspec  Yang spec
+ * @param[in]  ns     Namespace
+ * @retval     1      Module loaded
+ * @retval     0      No module with namespace
+ * @retval    -1      Error
+ * @see yang_find_module_by_namespace  which calls this function if module not found
+ */
+int
+yang_lazy_load(yang_stmt  *yspec,
+	       const char *ns)
+{
+    int           retval = -1;
+    yang_lazy_t  *yz;
+    clicon_handle h;
+    char         *filename = NULL;
+
+    if ((yz = yang_lazy_list) == NULL || ns == NULL)
+	goto fail;
+    do {
+	if (yz->yz_yspec == yspec && strcmp(yz->yz_ns, ns) == 0)
+	    break;
+	yz = NEXTQ(yang_lazy_t *, yz);
+    } while (yz != yang_lazy_list);
+    if (yz->yz_yspec != yspec || strcmp(yz->yz_ns, ns) != 0)
+	goto fail;
+    /* Remove before parsing since parsing may look up namespaces */
+    h = yz->yz_h;
+    filename = yz->yz_filename;
+    yz->yz_filename = NULL;
+    yang_lazy_free1(yz);
+    clicon_debug(1, "%s %s", __FUNCTION__, filename);
+    if (yang_spec_parse_file(h, filename, yspec) < 0)
+	goto done;
+    retval = 1;
+ done:
+    if (filename)
+	free(filename);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Free modules not loaded of a yang spec
+ * @param[in]  yspec  Yang spec, or NULL for all
+ */
+int
+yang_lazy_free(yang_stmt *yspec)
+{
+    yang_lazy_t *yz;
+    yang_lazy_t *ynext;
+    int          n;
+    int          i;
+
+    if ((yz = yang_lazy_list) == NULL)
+	return 0;
+    /* Count since list is circular and entries are removed */
+    n = 0;
+    do {
+	n++;
+	yz = NEXTQ(yang_lazy_t *, yz);
+    } while (yz != yang_lazy_list);
+    yz = yang_lazy_list;
+    for (i=0; i<n; i++){
+	ynext = NEXTQ(yang_lazy_t *, yz);
+	if (yspec == NULL || yz->yz_yspec == yspec)
+	    yang_lazy_free1(yz);
+	yz = ynext;
+    }
+    return 0;
+}
+
+/*! Parse yang files of a directory in parallel worker processes
+ *
+ * Used by yang_spec_load_dir if CLICON_YANG_PARSE_WORKERS is larger than one.
+ * The files are divided between the workers. Each worker parses its files into a
+ * yang spec of its own, which is sent to the parent in yang cache format.
+ * Only lexing and parsing is made by the workers, linking, augments and populate is
+ * made serially by yang_parse_post.
+ * @param[in]  dir     Directory
+ * @param[in]  dp      Yang files in directory
+ * @param[in]  ndp     Number of files
+ * @param[in]  nw      Number of workers
+ * @param[out] ymv     Vector of ndp parsed modules, in ywv, NULL if not parsed
+ * @param[out] ywv     Vector of nw yang specs of workers, free with ys_free
+ * @retval     0       OK, files in ymv that are NULL should be parsed serially
+ * @retval    -1       Error
+ */
+static int
+yang_parse_dir_parallel(char          *dir,
+			struct dirent *dp,
+			int            ndp,
+			int            nw,
+			yang_stmt    **ymv,
+			yang_stmt    **ywv)
+{
+    int        retval = -1;
+    int        w;
+    int        i;
+    int        j;
+    int       *fds = NULL;
+    pid_t     *pids = NULL;
+    int        fd[2];
+    FILE      *f;
+    yang_stmt *ys;
+    char       filename[MAXPATHLEN];
+    uint8_t   *buf = NULL;
+    size_t     len;
+    size_t     max = 0;
+    ssize_t    n;
+    int        status;
+
+    if ((fds = calloc(nw, sizeof(int))) == NULL ||
+	(pids = calloc(nw, sizeof(pid_t))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (w=0; w<nw; w++)
+	fds[w] = -1;
+    for (w=0; w<nw; w++){
+	if (pipe(fd) < 0){
+	    clicon_err(OE_UNIX, errno, "pipe");
+	    goto done;
+	}
+	if ((pids[w] = fork()) < 0){
+	    clicon_err(OE_UNIX, errno, "fork");
+	    close(fd[0]);
+	    close(fd[1]);
+	    goto done;
+	}
+	if (pids[w] == 0){ /* Worker: parse every nw:th file */
+	    close(fd[0]);
+	    if ((f = fdopen(fd[1], "w")) == NULL)
+		_exit(1);
+	    if ((ys = ys_new(Y_SPEC)) == NULL)
+		_exit(1);
+	    if (fwrite(&ndp, sizeof(ndp), 1, f) != 1)
+		_exit(1);
+	    for (i=0; i<ndp; i++){
+		status = 0;
+		if (i % nw == w){
+		    snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
+		    if (yang_parse_filename(filename, ys) != NULL)
+			status = 1;
+		    else /* Parsed again by parent for error message */
+			clicon_err_reset();
+		}
+		if (fputc(status, f) == EOF)
+		    _exit(1);
+	    }
+	    if (yang_cache_fwrite(f, ys, 0) != 1 || fclose(f) != 0)
+		_exit(1);
+	    _exit(0);
+	}
+	close(fd[1]);
+	fds[w] = fd[0];
+    }
+    /* Parent: read yang specs of workers in order */
+    for (w=0; w<nw; w++){
+	len = 0;
+	do {
+	    if (len == max){
+		max = max ? 2*max : 65536;
+		if ((buf = realloc(buf, max)) == NULL){
+		    clicon_err(OE_UNIX, errno, "realloc");
+		    goto done;
+		}
+	    }
+	    if ((n = read(fds[w], buf+len, max-len)) < 0){
+		if (errno == EINTR)
+		    continue;
+		clicon_err(OE_UNIX, errno, "read");
+		goto done;
+	    }
+	    len += n;
+	} while (n > 0);
+	close(fds[w]);
+	fds[w] = -1;
+	if (waitpid(pids[w], &status, 0) != pids[w]){
+	    pids[w] = 0;
+	    continue;
+	}
+	pids[w] = 0;
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+	    len < sizeof(ndp) + ndp ||
+	    memcmp(buf, &ndp, sizeof(ndp)) != 0)
+	    continue; /* Parsed serially */
+	if ((ywv[w] = ys_new(Y_SPEC)) == NULL)
+	    goto done;
+	if (yang_cache_parse(buf+sizeof(ndp)+ndp, len-sizeof(ndp)-ndp, 0, 0, ywv[w]) != 1)
+	    continue;
+	/* Parsed files have one (sub)module each, in file order */
+	j = 0;
+	for (i=0; i<ndp; i++)
+	    if (buf[sizeof(ndp)+i] && j < yang_len_get(ywv[w]))
+		ymv[i] = yang_child_i(ywv[w], j++);
+    }
+    retval = 0;
+ done:
+    if (fds){
+	for (w=0; w<nw; w++)
+	    if (fds[w] != -1)
+		close(fds[w]);
+	free(fds);
+    }
+    if (pids){
+	for (w=0; w<nw; w++)
+	    if (pids[w] > 0)
+		waitpid(pids[w], NULL, 0);
+	free(pids);
+    }
+    if (buf)
+	free(buf);
+    return retval;
+}
+
 /*! Load all yang modules in directory
  * @param[in]  h     Clicon handle
  * @param[in]  dir   Load all yang modules in this directory
@@ -1497,6 +1937,10 @@ yang_spec_parse_file(clicon_handle h,
  * 3) If only x@rev.yang's found, prefer newest (newest revision)
  * There is also an extra failsafe which may not be necessary, which removes
  * the oldest module if 1-3 for some reason fails.
+ * If CLICON_YANG_LAZY is set, modules are not parsed until their namespace is looked
+ * up, see yang_lazy_load
+ * If CLICON_YANG_PARSE_WORKERS is larger than one, files are parsed in parallel, see
+ * yang_parse_dir_parallel
  */
 int
 yang_spec_load_dir(clicon_handle h,
@@ -1519,6 +1963,12 @@ yang_spec_load_dir(clicon_handle h,
     uint32_t       rev0; /* revision in existing module */
     char          *oldbase = NULL;
     int            taken = 0;
+    uint64_t       key = 0;  /* Yang cache key */
+    int            ret;
+    int            lazy;
+    int            nw = 0;    /* Number of parse workers */
+    yang_stmt    **ymv = NULL; /* Modules parsed by workers */
+    yang_stmt    **ywv = NULL; /* Yang specs of workers */
     
     /* Get yang files names from yang module directory. Note that these
      * are sorted alphatetically:
@@ -1530,8 +1980,27 @@ yang_spec_load_dir(clicon_handle h,
 	goto done;
     if (ndp == 0)
 	goto ok;
+    lazy = clicon_option_bool(h, "CLICON_YANG_LAZY");
+    if (!lazy){
+	if ((ret = yang_cache_load(h, yspec, "dir", dir, NULL, &key)) < 0)
+	    goto done;
+	if (ret == 1)
+	    goto ok;
+    }
     /* Apply post steps on new modules, ie ones after modmin. */
     modmin = yang_len_get(yspec);
+    nw = clicon_option_int(h, "CLICON_YANG_PARSE_WORKERS");
+    if (!lazy && nw > 1 && ndp > 1){
+	if (nw > ndp)
+	    nw = ndp;
+	if ((ymv = calloc(ndp, sizeof(yang_stmt *))) == NULL ||
+	    (ywv = calloc(nw, sizeof(yang_stmt *))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+	if (yang_parse_dir_parallel(dir, dp, ndp, nw, ymv, ywv) < 0)
+	    goto done;
+    }
     /* Load all yang files in dir */
     for (i = 0; i < ndp; i++) {
 	/* base = module name [+ @rev ] + .yang */
@@ -1575,7 +2044,23 @@ yang_spec_load_dir(clicon_handle h,
 	}
 	/* Create full filename */
 	snprintf(filename, MAXPATHLEN-1, "%s/%s", dir, dp[i].d_name);
-	if ((ym = yang_parse_filename(filename, yspec)) == NULL)
+	if (lazy){
+	    if ((ret = yang_lazy_add(h, yspec, filename)) < 0)
+		goto done;
+	    if (ret == 1)
+		continue;
+	}
+	if (ymv && (ym = ymv[i]) != NULL){ /* Parsed by worker */
+	    for (j=0; j<yang_len_get(ym->ys_parent); j++)
+		if (ym->ys_parent->ys_stmt[j] == ym)
+		    break;
+	    ys_prune(ym->ys_parent, j);
+	    if (yn_insert(yspec, ym) < 0){
+		ys_free(ym);
+		goto done;
+	    }
+	}
+	else if ((ym = yang_parse_filename(filename, yspec)) == NULL)
 	    goto done;
 	revm = 0;
 	if ((yrev = yang_find(ym, Y_REVISION, NULL)) != NULL)
@@ -1600,9 +2085,19 @@ yang_spec_load_dir(clicon_handle h,
     }
     if (yang_parse_post(h, yspec, modmin) < 0)
 	goto done;
+    if (key && yang_cache_save(h, yspec, key) < 0)
+	goto done;
  ok:
     retval = 0;
   done:
+    if (ywv){
+	for (j=0; j<nw; j++)
+	    if (ywv[j])
+		ys_free(ywv[j]);
+	free(ywv);
+    }
+    if (ymv)
+	free(ymv);
     if (dp)
 	free(dp);
     if (base)
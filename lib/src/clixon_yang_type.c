@@ -60,6 +60,9 @@
  * 3) We know I think when cache is set and when it is not set in the calls
  *    to yang_type_resolve. maybe we should make code easier by a separate
  *    yang_type_resolve_cache() call?
+ * 4) ys_cv_validate compiles a validator from the type cache on first use and
+ *    stores it in the cache, see yang_validator_get. Later validations of the
+ *    same leaf use the validator directly without resolving the type.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -105,6 +108,33 @@
  * Local types and variables
  */
 
+/*! Recently validated value of a pattern, see CLICON_YANG_REGEXP_CACHE
+ */
+struct yang_rxentry{
+    uint32_t rx_hash;  /* Hash of rx_str */
+    char    *rx_str;   /* Value (malloced) */
+    int      rx_match; /* 1 if value matches all patterns, 0 if not */
+};
+
+/*! Compiled validator of a yang type statement, stored in its type cache
+ * Built from the type cache on first validation, see yang_validator_get
+ */
+struct yang_validator{
+    char         *yv_origtype; /* Original type without prefix (malloced) */
+    yang_stmt    *yv_yrestype; /* Resolved type, can be NULL - direct ptr */
+    char         *yv_restype;  /* Name of resolved type - direct ptr */
+    enum cv_type  yv_cvtype;   /* Cligen type, CGV_ERR if not resolved */
+    int           yv_options;  /* See YANG_OPTIONS_* */
+    cvec         *yv_cvv;      /* Range and length - direct ptr to cache */
+    cvec         *yv_regexps;  /* Compiled regexps (voids owned by cache) */
+    struct yang_rxentry *yv_rxcache; /* LRU of pattern results, most recent first */
+    int           yv_rxlen;    /* Number of entries in yv_rxcache */
+    int           yv_rxmax;    /* Max entries of yv_rxcache, 0 if disabled */
+    int           yv_union;    /* Resolved type is union */
+    yang_stmt   **yv_members;  /* Type statements of union members */
+    int           yv_nmembers; /* Length of yv_members */
+};
+
 /* Mapping between yang types <--> cligen types
    Note, first match used wne translating from cv to yang --> order is significant */
 static const map_str2int ytmap[] = {
@@ -371,41 +401,132 @@ clicon_type2cv(char         *origtype,
     return retval;
 }
 
+/*! Look up value in pattern result cache of validator, move it first if found
+ * @param[in]  yv    Validator
+ * @param[in]  str   Value
+ * @param[in]  hash  Hash of str
+ * @retval    -1     Not found
+ * @retval     0     Found, value does not match patterns
+ * @retval     1     Found, value matches patterns
+ */
+static int
+yang_validator_rx_get(yang_validator *yv,
+		      char           *str,
+		      uint32_t        hash)
+{
+    struct yang_rxentry rx;
+    int                 i;
+
+    for (i=0; i<yv->yv_rxlen; i++){
+	if (yv->yv_rxcache[i].rx_hash == hash &&
+	    strcmp(yv->yv_rxcache[i].rx_str, str) == 0)
+	    break;
+    }
+    if (i == yv->yv_rxlen)
+	return -1;
+    if (i > 0){
+	rx = yv->yv_rxcache[i];
+	memmove(&yv->yv_rxcache[1], &yv->yv_rxcache[0], i*sizeof(rx));
+	yv->yv_rxcache[0] = rx;
+    }
+    return yv->yv_rxcache[0].rx_match;
+}
+
+/*! Add value first in pattern result cache of validator, remove least recently used
+ * @param[in]  yv    Validator
+ * @param[in]  str   Value, copied
+ * @param[in]  hash  Hash of str
+ * @param[in]  match 1 if value matches patterns, 0 if not
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+yang_validator_rx_add(yang_validator *yv,
+		      char           *str,
+		      uint32_t        hash,
+		      int             match)
+{
+    int   retval = -1;
+    char *s;
+
+    if (yv->yv_rxcache == NULL &&
+	(yv->yv_rxcache = calloc(yv->yv_rxmax, sizeof(struct yang_rxentry))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    if ((s = strdup(str)) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if (yv->yv_rxlen == yv->yv_rxmax)
+	free(yv->yv_rxcache[--yv->yv_rxlen].rx_str);
+    memmove(&yv->yv_rxcache[1], &yv->yv_rxcache[0],
+	    yv->yv_rxlen*sizeof(struct yang_rxentry));
+    yv->yv_rxcache[0].rx_hash = hash;
+    yv->yv_rxcache[0].rx_str = s;
+    yv->yv_rxcache[0].rx_match = match;
+    yv->yv_rxlen++;
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Validate CLIgen variable with pattern statements
  * @param[in]  h       Clicon handle
  * @param[in]  regexps Vector of compiled regexps
+ * @param[in]  yv      Validator with pattern result cache, or NULL
  * @param[out] reason  If given, and return value is 0, contains malloced string
  * @retval -1  Error (fatal), with errno set to indicate error
  * @retval 0   Validation not OK, malloced reason is returned. Free reason with free()
  * @retval 1   Validation OK
  */
 static int
-cv_validate_pattern(clicon_handle h,
-		    cvec         *regexps,
-		    yang_stmt    *yrestype,
-		    char         *str,
-		    char        **reason)
+cv_validate_pattern(clicon_handle   h,
+		    cvec           *regexps,
+		    yang_validator *yv,
+		    yang_stmt      *yrestype,
+		    char           *str,
+		    char          **reason)
 {
-    int     retval = -1;
-    cg_var *cvr;
-    void   *re = NULL;
-    int     ret;
-
+    int      retval = -1;
+    cg_var  *cvr;
+    void    *re = NULL;
+    int      ret;
+    int      match;
+    char    *s;
+    char    *p;
+    uint32_t hash = 2166136261u; /* FNV-1a */
+
+    s = str?str:"";
+    if (yv && yv->yv_rxmax){
+	for (p = s; *p; p++)
+	    hash = (hash ^ (uint8_t)*p) * 16777619u;
+	if ((match = yang_validator_rx_get(yv, s, hash)) != -1)
+	    goto cached;
+    }
+    match = 1;
     cvr = NULL; /* Loop over compiled regexps */
     while ((cvr = cvec_each(regexps, cvr)) != NULL){
 	re = cv_void_get(cvr);
-	if ((ret = regex_exec(h, re, str?str:"")) < 0)
+	if ((ret = regex_exec(h, re, s)) < 0)
 	    goto done;
 	if (cv_flag(cvr, V_INVERT))
 	    ret = !ret; /* swap 0 and 1 */
 	if (ret == 0){
-	    if (reason)
-		*reason = cligen_reason("regexp match fail: pattern does not match %s",
-					str);
-	    goto fail;
+	    match = 0;
 	    break;
 	}	
     }
+    if (yv && yv->yv_rxmax &&
+	yang_validator_rx_add(yv, s, hash, match) < 0)
+	goto done;
+ cached:
+    if (match == 0){
+	if (reason)
+	    *reason = cligen_reason("regexp match fail: pattern does not match %s",
+				    str);
+	goto fail;
+    }
     retval = 1; /* match */
  done:
     return retval;
@@ -526,6 +647,7 @@ outoflength(uint64_t    u64,
  * @param[in]  cvtype  Resolved type of cv
  *                     string describing reason why validation failed. 
  * @param[in]  regexps Vector of compiled regexps
+ * @param[in]  yv      Validator with pattern result cache, or NULL
  * @param[out] reason  If given, and return value is 0, contains malloced str 
 
  * @retval    -1       Error (fatal), with errno set to indicate error
@@ -541,6 +663,7 @@ cv_validate1(clicon_handle h,
 	     int          options, 
 	     cvec        *cvv,
 	     cvec        *regexps,
+	     yang_validator *yv,
 	     yang_stmt   *yrestype,
 	     char        *restype,
 	     char       **reason)
@@ -549,7 +672,6 @@ cv_validate1(clicon_handle h,
     cg_var         *cv1;
     cg_var         *cv2;
     int             ret;
-    yang_stmt      *yi = NULL;
     char           *str = NULL;
     int             found;
     char          **vec = NULL;
@@ -661,18 +783,9 @@ cv_validate1(clicon_handle h,
 	if (restype){
 	    if (strcmp(restype, "enumeration") == 0){
 		found = 0;
-		yi = NULL;
-		if (str != NULL) {
-		    //		    str = clixon_trim2(str, " \t\n"); /* May be misplaced, strip earlier? */
-		    while ((yi = yn_each(yrestype, yi)) != NULL){
-			if (yang_keyword_get(yi) != Y_ENUM)
-			    continue;
-			if (strcmp(yang_argument_get(yi), str) == 0){
-			    found++;
-			    break;
-			}
-		    }
-		}
+		if (str != NULL &&
+		    yang_find(yrestype, Y_ENUM, str) != NULL)
+		    found++;
 		if (!found){
 		    if (reason)
 			*reason = cligen_reason("'%s' does not match enumeration", str);
@@ -692,15 +805,8 @@ cv_validate1(clicon_handle h,
 		    if ((v = vec[i]) == NULL || !strlen(v))
 			continue;
 		    found = 0;
-		    yi = NULL;
-		    while ((yi = yn_each(yrestype, yi)) != NULL){
-			if (yang_keyword_get(yi) != Y_BIT)
-			    continue;
-			if (strcmp(yang_argument_get(yi), v) == 0){
-			    found++;
-			    break;
-			}
-		    }
+		    if (yang_find(yrestype, Y_BIT, v) != NULL)
+			found++;
 		    if (!found){
 			if (reason)
 			    *reason = cligen_reason("'%s' does not match enumeration", v);
@@ -711,7 +817,7 @@ cv_validate1(clicon_handle h,
 	    }
 	}
 	if (regexps && cvec_len(regexps)) {
-	    if ((ret = cv_validate_pattern(h, regexps, yrestype, str, reason)) < 0)
+	    if ((ret = cv_validate_pattern(h, regexps, yv, yrestype, str, reason)) < 0)
 		goto done;
 	    if (ret == 0)
 		goto fail;
@@ -814,7 +920,7 @@ ys_cv_validate_union_one(clicon_handle h,
 		goto done;
 	}
 	if ((retval = cv_validate1(h, cvt, cvtype, options, cvv, 
-				   regexps, yrt, restype, reason)) < 0)
+				   regexps, NULL, yrt, restype, reason)) < 0)
 	    goto done;
     }
  done:
@@ -882,6 +988,291 @@ ys_cv_validate_union(clicon_handle h,
     return retval;
 }
 
+/*! Free compiled validator of a yang type
+ * @param[in]  yv   Validator
+ * @see yang_validator_get
+ */
+int
+yang_validator_free(yang_validator *yv)
+{
+    int i;
+
+    for (i=0; i<yv->yv_rxlen; i++)
+	free(yv->yv_rxcache[i].rx_str);
+    if (yv->yv_rxcache)
+	free(yv->yv_rxcache);
+    if (yv->yv_origtype)
+	free(yv->yv_origtype);
+    if (yv->yv_regexps) /* Shallow, compiled regexps are freed with type cache */
+	cvec_free(yv->yv_regexps);
+    if (yv->yv_members)
+	free(yv->yv_members);
+    free(yv);
+    return 0;
+}
+
+/*! Get compiled validator of a yang type, compile it from the type cache if needed
+ *
+ * The validator is stored in the type cache of ytype and freed with it. 
+ * Regexps are compiled here and not at populate since the cache is copied in 
+ * yang_parse_post, see NOTE 2 above.
+ * @param[in]  h      Clicon handle
+ * @param[in]  ytype  Yang type statement
+ * @param[out] yvp    Validator, direct pointer
+ * @retval    -1      Error
+ * @retval     0      No type cache, no validator
+ * @retval     1      OK
+ */
+static int
+yang_validator_get(clicon_handle    h,
+		   yang_stmt       *ytype,
+		   yang_validator **yvp)
+{
+    int             retval = -1;
+    yang_validator *yv = NULL;
+    cvec           *patterns = NULL;
+    yang_stmt      *yt;
+    int             i;
+    int             ret;
+
+    if ((ret = yang_type_cache_validator_get(ytype, &yv)) < 0)
+	goto done;
+    if (ret == 0)
+	goto nocache;
+    if (yv != NULL)
+	goto ok;
+    if ((yv = malloc(sizeof(*yv))) == NULL){
+	clicon_err(OE_UNIX, errno, "malloc");
+	goto done;
+    }
+    memset(yv, 0, sizeof(*yv));
+    if ((patterns = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if ((yv->yv_regexps = cvec_new(0)) == NULL){
+	clicon_err(OE_UNIX, errno, "cvec_new");
+	goto done;
+    }
+    if (yang_type_cache_get(ytype, &yv->yv_yrestype, &yv->yv_options, &yv->yv_cvv,
+			    patterns, NULL, yv->yv_regexps, NULL) < 0)
+	goto done;
+    if (cvec_len(patterns)!=0 && cvec_len(yv->yv_regexps)==0){
+	if (compile_pattern2regexp(h, patterns, yv->yv_regexps) < 1)
+	    goto done;
+	if (yang_type_cache_regexp_set(ytype,
+				       clicon_yang_regexp(h),
+				       yv->yv_regexps) < 0)
+	    goto done;
+    }
+    if (cvec_len(yv->yv_regexps) &&
+	(yv->yv_rxmax = clicon_option_int(h, "CLICON_YANG_REGEXP_CACHE")) < 0)
+	yv->yv_rxmax = 0;
+    if (nodeid_split(yang_argument_get(ytype), NULL, &yv->yv_origtype) < 0)
+	goto done;
+    yv->yv_restype = yv->yv_yrestype?yang_argument_get(yv->yv_yrestype):NULL;
+    yv->yv_cvtype = CGV_ERR;
+    if (yv->yv_restype){
+	yang2cv_type(yv->yv_restype, &yv->yv_cvtype);
+	if (strcmp(yv->yv_restype, "union") == 0){
+	    yv->yv_union = 1;
+	    yt = NULL;
+	    while ((yt = yn_each(yv->yv_yrestype, yt)) != NULL)
+		if (yang_keyword_get(yt) == Y_TYPE)
+		    yv->yv_nmembers++;
+	    if (yv->yv_nmembers &&
+		(yv->yv_members = calloc(yv->yv_nmembers, sizeof(yang_stmt *))) == NULL){
+		clicon_err(OE_UNIX, errno, "calloc");
+		goto done;
+	    }
+	    i = 0;
+	    yt = NULL;
+	    while ((yt = yn_each(yv->yv_yrestype, yt)) != NULL)
+		if (yang_keyword_get(yt) == Y_TYPE)
+		    yv->yv_members[i++] = yt;
+	}
+    }
+    if (yang_type_cache_validator_set(ytype, yv) < 0)
+	goto done;
+ ok:
+    *yvp = yv;
+    yv = NULL;
+    retval = 1;
+ done:
+    if (yv)
+	yang_validator_free(yv);
+    if (patterns)
+	cvec_free(patterns);
+    return retval;
+ nocache:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate a value against the members of a union using compiled validators
+ * @param[in]  h        Clixon handle
+ * @param[in]  ys       Yang leaf or leaf-list
+ * @param[out] reason   If given, and return value is 0, contains malloced string
+ * @param[in]  yv       Validator of union type
+ * @param[in]  origtype Original type of ys
+ * @param[in]  val      Value to match
+ * @param[out] ysubp    Sub-type of ys that matches val
+ * @retval -1  Error (fatal), with errno set to indicate error
+ * @retval 0   Validation not OK, malloced reason is returned. Free reason with free()
+ * @retval 1   Validation OK
+ * @see ys_cv_validate_union  for types without cache
+ */
+static int
+ys_cv_validate_union_compiled(clicon_handle   h,
+			      yang_stmt      *ys,
+			      char          **reason,
+			      yang_validator *yv,
+			      char           *origtype,
+			      char           *val,
+			      yang_stmt     **ysubp)
+{
+    int             retval = 1; /* valid */
+    yang_stmt      *yt;
+    yang_validator *yvm;
+    char           *reason1 = NULL;  /* saved reason */
+    enum cv_type    cvtype;
+    cg_var         *cvt = NULL;
+    yang_stmt      *ysubt = NULL;
+    int             i;
+    int             ret;
+
+    for (i=0; i<yv->yv_nmembers; i++){
+	yt = yv->yv_members[i];
+	if ((ret = yang_validator_get(h, yt, &yvm)) < 0){
+	    retval = -1;
+	    goto done;
+	}
+	if (ret == 0){ /* Member type not cached */
+	    if ((retval = ys_cv_validate_union_one(h, ys, reason, yt, origtype, val)) < 0)
+		goto done;
+	}
+	else if (yvm->yv_union){      /* recursive union */
+	    if ((retval = ys_cv_validate_union_compiled(h, ys, reason, yvm, origtype,
+							val, &ysubt)) < 0)
+		goto done;
+	}
+	else if (val == NULL) /* Fail validation on NULL */
+	    retval = 0;
+	else {
+	    if ((cvtype = yvm->yv_cvtype) == CGV_ERR &&
+		clicon_type2cv(origtype, yvm->yv_restype, ys, &cvtype) < 0){
+		retval = -1;
+		goto done;
+	    }
+	    /* reparse value with the member type */
+	    if (cvt == NULL || cv_type_get(cvt) != cvtype){
+		if (cvt)
+		    cv_free(cvt);
+		if ((cvt = cv_new(cvtype)) == NULL){
+		    clicon_err(OE_UNIX, errno, "cv_new");
+		    retval = -1;
+		    goto done;
+		}
+	    }
+	    else
+		cv_reset(cvt);
+	    if ((retval = cv_parse1(val, cvt, reason)) < 0){
+		clicon_err(OE_UNIX, errno, "cv_parse");
+		goto done;
+	    }
+	    if (retval == 1 &&
+		(retval = cv_validate1(h, cvt, cvtype, yvm->yv_options, yvm->yv_cvv,
+				       yvm->yv_regexps, yvm, yvm->yv_yrestype, yvm->yv_restype,
+				       reason)) < 0)
+		goto done;
+	}
+	/* If validation failed, save reason, reset error and continue,
+	 * save latest reason if nothing validates.
+	 */
+	if (retval == 0 && reason && *reason != NULL){
+	    if (reason1)
+		free(reason1);
+	    reason1 = *reason;
+	    *reason = NULL;
+	}
+	/* Enough that one type validates value, return that value
+	 */
+	if (retval == 1) {
+	    if (ysubp)
+		*ysubp = yt;
+	    break;
+	}
+    }
+ done:
+    if (retval == 0 && reason1){
+	*reason = reason1;
+	reason1 = NULL;
+    }
+    if (reason1)
+	free(reason1);
+    if (cvt)
+	cv_free(cvt);
+    return retval;
+}
+
+/*! Validate cligen variable cv of a leaf or leaf-list using its compiled validator
+ * @param[in]  h       Clicon handle     
+ * @param[in]  cv      A cligen variable to validate. This is a correctly parsed cv.
+ * @param[in]  ycv     Cligen variable of yang statement
+ * @param[in]  ys      A yang statement, must be leaf or leaf-list.
+ * @param[in]  yv      Validator of type of ys
+ * @param[out] ysub    Sub-type that matches val (in case of union, otherwise ys)
+ * @param[out] reason  If given, and if return value is 0, contains malloced string
+ * @retval -1  Error (fatal), with errno set to indicate error
+ * @retval 0   Validation not OK, malloced reason is returned. Free reason with free()
+ * @retval 1   Validation OK
+ * @see ys_cv_validate
+ */
+static int
+ys_cv_validate_compiled(clicon_handle   h,
+			cg_var         *cv,
+			cg_var         *ycv,
+			yang_stmt      *ys,
+			yang_validator *yv,
+			yang_stmt     **ysub,
+			char          **reason)
+{
+    int          retval = -1; 
+    enum cv_type cvtype;
+    char        *val;
+
+    if ((cvtype = yv->yv_cvtype) == CGV_ERR &&
+	clicon_type2cv(yv->yv_origtype, yv->yv_restype, ys, &cvtype) < 0)
+	goto done;
+    if (cv_type_get(ycv) != cvtype){
+	/* special case: dbkey has rest syntax-> cv but yang cant have that */
+	if (cvtype == CGV_STRING && cv_type_get(ycv) == CGV_REST)
+	    ;
+	else {
+	    clicon_err(OE_DB, 0, "Type mismatch data:%s != yang:%s", 
+		       cv_type2str(cvtype), cv_type2str(cv_type_get(ycv)));
+	    goto done;
+	}
+    }
+    if (yv->yv_union){
+	/* Instead of NULL, give an empty string to validate, see ys_cv_validate */
+	if ((val = cv_string_get(cv)) == NULL)
+	    val = "";
+	retval = ys_cv_validate_union_compiled(h, ys, reason, yv, yv->yv_origtype,
+					       val, ysub);
+    }
+    else{
+	if ((retval = cv_validate1(h, cv, cvtype, yv->yv_options, yv->yv_cvv,
+				   yv->yv_regexps, yv, yv->yv_yrestype, yv->yv_restype,
+				   reason)) < 0)
+	    goto done;
+	if (ysub)
+	    *ysub = ys;
+    }
+ done:
+    return retval;
+}
+
 /*! Validate cligen variable cv using yang statement as spec
  *
  * @param[in]  h       Clicon handle     
@@ -917,6 +1308,9 @@ ys_cv_validate(clicon_handle h,
     int             retval2;
     char           *val;
     cg_var         *cvt=NULL;
+    yang_stmt      *ytype;
+    yang_validator *yv = NULL;
+    int             ret;
 
     if (reason)
 	*reason=NULL;
@@ -925,6 +1319,15 @@ ys_cv_validate(clicon_handle h,
 	goto done;
     }
     ycv = yang_cv_get(ys);
+    /* Use compiled validator if type is cached, otherwise resolve type */
+    if ((ytype = yang_find(ys, Y_TYPE, NULL)) != NULL){
+	if ((ret = yang_validator_get(h, ytype, &yv)) < 0)
+	    goto done;
+	if (ret == 1){
+	    retval = ys_cv_validate_compiled(h, cv, ycv, ys, yv, ysub, reason);
+	    goto done;
+	}
+    }
     if ((regexps = cvec_new(0)) == NULL){
 	clicon_err(OE_UNIX, errno, "cvec_new");
 	goto done;
@@ -979,7 +1382,7 @@ ys_cv_validate(clicon_handle h,
 		goto done;
 	}
 	if ((retval = cv_validate1(h, cv, cvtype, options, cvv,
-				   regexps, yrestype, restype, reason)) < 0)
+				   regexps, NULL, yrestype, restype, reason)) < 0)
 	    goto done;
 	if (ysub)
 	    *ysub = ys;
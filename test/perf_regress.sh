@@ -0,0 +1,279 @@
+#!/usr/bin/env bash
+# Performance regression harness: measure, store baseline and compare
+# Runs the in-process C benchmarks (clixon_util_bench), system measurements of backend
+# startup, netconf put, commit and get for each list size, and the perf test scripts.
+# Each measurement is repeated and summarized as median and standard deviation in usec.
+# A measurement is a regression if its median is more than <threshold> percent AND more
+# than <sigmas> standard deviations slower than the baseline median.
+# Examples
+# 1. Run and store a baseline
+#    save=true ./perf_regress.sh
+# 2. Run and compare with the baseline in resdir, exit with error on regression
+#    ./perf_regress.sh
+#    baseline=/tmp/baseline-i686.data ./perf_regress.sh
+# 3. Large lists, only system measurements
+#    sizes=10000,100000,1000000 reps=3 bench=false perftests= ./perf_regress.sh
+# 4. Datastore write cost with synced files, put and commit measurements
+#    xmldbsync=fdatasync resdir=/var/tmp/clixon-perf-sync ./perf_regress.sh
+# Result file format, one line per measurement:
+#    <name> <n> <median usec> <stddev usec> <nr of samples>
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_bench:="clixon_util_bench"}
+
+arch=$(arch)
+# Default values
+: ${sizes:=1000,10000,100000} # List sizes, up to 1000000
+: ${reps:=5}        # Repetitions of each measurement
+: ${resdir:=/var/tmp/clixon-perf} # Result dir, also of baseline unless given
+: ${baseline:=$resdir/baseline-$arch.data} # Baseline to compare with, if it exists
+: ${save:=false}    # Store results as baseline
+: ${threshold:=10}  # Regression if slower than this percent of baseline median
+: ${sigmas:=3}      # and slower than this many standard deviations of baseline
+: ${bench:=true}    # Run C benchmarks
+: ${system:=true}   # Run startup, put, commit and get measurements
+: ${perftests:="test_perf_startup.sh test_perf_netconf.sh"} # Scripts timed as a whole
+: ${perfnr:=10000}  # List size of perf test scripts
+: ${xmldbsync:=none} # CLICON_XMLDB_SYNC: none, fdatasync or group
+
+APPNAME=example
+cfg=$dir/perf-conf.xml
+fyang=$dir/perf.yang
+fxml=$dir/data.xml
+samples=$dir/samples
+results=$resdir/perf-$arch.data
+
+if [ ! -d $resdir ]; then
+    mkdir -p $resdir
+fi
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix sc;
+   container x {
+      list y {
+         key "a";
+         leaf a {
+            type int32;
+         }
+         leaf b {
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_XMLDB_SYNC>$xmldbsync</CLICON_XMLDB_SYNC>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+# Generate <n> list entries
+# args: <n>
+function genentries(){
+    seq 0 $(( $1 - 1 )) | awk '{printf "<y><a>%d</a><b>%d</b></y>", $1, $1}'
+}
+
+# Send netconf rpcs in a file, fail on rpc-error
+# args: <file>
+function ncfile(){
+    reply=$($clixon_netconf -qf $cfg < $1)
+    if [ $? -ne 0 ]; then
+	return 1
+    fi
+    if echo "$reply" | grep -q "<rpc-error>"; then
+	echo "$reply"
+	return 1
+    fi
+}
+
+# Send a netconf rpc
+# args: <rpc>
+function ncrpc(){
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS>$1</rpc>]]>]]>" > $dir/rpc.xml
+    ncfile $dir/rpc.xml
+}
+
+# Start backend once with startup db and exit
+function startonce(){
+    sudo $clixon_backend -F1 -D $DBG -s startup -f $cfg 2> /dev/null
+}
+
+# Time a command and add a sample in usec
+# args: <name> <n> <cmd> [<args>]*
+function measure(){
+    name=$1
+    nr=$2
+    shift 2
+    t0=$(date +%s%N)
+    ret=$("$@" 2>&1)
+    if [ $? -ne 0 ]; then
+	err "$name $nr" "$ret"
+    fi
+    t1=$(date +%s%N)
+    echo "$name $nr $(( (t1 - t0) / 1000 ))" >> $samples
+}
+
+# Summarize samples per name and n: <name> <n> <median> <stddev> <nr>
+function summarize(){
+    echo "# name n median_usec stddev_usec samples"
+    sort -k1,1 -k2,2n -k3,3n $samples | awk '
+function flush(){
+    if (cnt == 0)
+	return
+    med = (cnt % 2) ? v[(cnt + 1) / 2] : (v[cnt / 2] + v[cnt / 2 + 1]) / 2
+    sd = (cnt > 1) ? sqrt((sq - sum * sum / cnt) / (cnt - 1)) : 0
+    printf "%s %d %d %d %d\n", name, n, med, sd, cnt
+    cnt = 0; sum = 0; sq = 0
+}
+{
+    if ($1 != name || $2 != n){
+	flush()
+	name = $1; n = $2
+    }
+    v[++cnt] = $3; sum += $3; sq += $3 * $3
+}
+END { flush() }'
+}
+
+# Compare results with baseline, print one line per measurement:
+#   <name> <n> <baseline median> <median> <change> ok|REGRESSION|new
+# Exit status is 1 if there is a regression
+function compare(){
+    awk -v thr=$threshold -v sig=$sigmas '
+/^#/ { next }
+NR == FNR { b[$1 " " $2] = $3; s[$1 " " $2] = $4; next }
+{
+    k = $1 " " $2
+    if (!(k in b)){
+	printf "%s %s - %d - new\n", $1, $2, $3
+	next
+    }
+    sd = (s[k] > $4) ? s[k] : $4
+    st = "ok"
+    if ($3 > b[k] * (1 + thr / 100) && $3 - b[k] > sig * sd){
+	st = "REGRESSION"
+	r++
+    }
+    printf "%s %s %d %d %+.1f%% %s\n", $1, $2, b[k], $3, b[k] ? ($3 - b[k]) * 100 / b[k] : 0, st
+}
+END { exit r > 0 }' $1 $2
+}
+
+echo -n "" > $samples
+sizevec=$(echo $sizes | tr , ' ')
+
+if $bench; then
+    new "C benchmarks sizes $sizes"
+    mkdir -p $dir/bench
+    for (( r=0; r<$reps; r++ )); do
+	ret=$($clixon_util_bench -b $dir/bench -n $sizes -r 1)
+	if [ $? -ne 0 ]; then
+	    err "0" "$?"
+	fi
+	# <name> <n> <ops> <rounds> <usec min> <usec avg> ...
+	echo "$ret" | awk '!/^#/ {print "bench:" $1, $2, $6}' >> $samples
+    done
+fi
+
+if $system; then
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+    fi
+    for n in $sizevec; do
+	new "startup $n"
+	sudo touch $dir/startup_db
+	sudo chmod 666 $dir/startup_db
+	{ echo -n "<config><x xmlns=\"urn:example:clixon\">"; genentries $n; echo "</x></config>"; } > $dir/startup_db
+	for (( r=0; r<$reps; r++ )); do
+	    measure startup $n startonce
+	done
+    done
+
+    if [ $BE -ne 0 ]; then
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+    new "waiting"
+    wait_backend
+
+    for n in $sizevec; do
+	{ echo -n "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>replace</default-operation><config><x xmlns=\"urn:example:clixon\">"; genentries $n; echo "</x></config></edit-config></rpc>]]>]]>"; } > $fxml
+	for (( r=0; r<$reps; r++ )); do
+	    new "put commit get $n"
+	    measure put $n ncfile $fxml
+	    measure commit $n ncrpc "<commit/>"
+	    measure get $n ncrpc "<get-config><source><running/></source></get-config>"
+	    # Reset, not measured
+	    ncrpc "<edit-config><target><candidate/></target><default-operation>none</default-operation><config operation=\"delete\"/></edit-config>" || err "reset" "$reply"
+	    ncrpc "<commit/>" || err "commit" "$reply"
+	done
+    done
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	stop_backend -f $cfg
+    fi
+fi
+
+for t in $perftests; do
+    new "perf test $t"
+    for (( r=0; r<$reps; r++ )); do
+	measure script:$t $perfnr env perfnr=$perfnr ./$t
+    done
+done
+
+summarize > $results
+cat $results
+
+if [ -f $baseline ]; then
+    new "compare with baseline $baseline"
+    report=$(compare $baseline $results)
+    r=$?
+    echo "$report"
+    if [ $r -ne 0 ]; then
+	err "No regressions" "$(echo "$report" | grep REGRESSION)"
+    fi
+fi
+
+if $save; then
+    new "save baseline $baseline"
+    cp $results $baseline
+fi
+
+rm -rf $dir
+
+# unset conditional parameters
+unset clixon_util_bench
+unset sizes
+unset reps
+unset resdir
+unset baseline
+unset save
+unset threshold
+unset sigmas
+unset bench
+unset system
+unset perftests
+unset perfnr
+
+new "endtest"
+endtest
@@ -48,6 +48,9 @@ if [ $BE -ne 0 ]; then
     wait_backend
 fi
 
+new "cli show memory"
+expectpart "$($clixon_cli -1 -f $cfg show memory)" 0 "backend  xml" "backend  datastore running" "backend  yang " "backend  stream-replay" "cli      yang "
+
 new "cli configure top"
 expectpart "$($clixon_cli -1 -f $cfg set interfaces)" 0 "^$"
 
@@ -115,6 +118,21 @@ expectpart "$($clixon_cli -1 -f $cfg -l o load /tmp/foo)" 0 "^$"
 new "cli check load"
 expectpart "$($clixon_cli -1 -f $cfg -l o show conf cli)" 0 "interfaces interface eth/0/0 ipv4 enabled true"
 
+new "cli set description to compare"
+expectpart "$($clixon_cli -1 -f $cfg -l o set interfaces interface eth/0/0 description compared)" 0 "^$"
+
+new "cli show compare text"
+expectpart "$($clixon_cli -1 -f $cfg -l o show compare text)" 0 "^/interfaces/interface\[name=\"eth/0/0\"\]:" "^+ description compared;" --not-- "enabled"
+
+new "cli show compare xml"
+expectpart "$($clixon_cli -1 -f $cfg -l o show compare xml)" 0 "^+ <description xmlns=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\">compared</description>"
+
+new "cli timing of commands"
+expectpart "$(echo -e "show conf cli\nshow timing" | $clixon_cli -f $cfg -o CLICON_CLI_TIMING=true 2>&1)" 0 "^Timing: parse [0-9.]*s rpc [0-9.]*s ([1-9][0-9]*) render [0-9.]*s total [0-9.]*s" "^commands  *1$" "^rpcs  *[1-9]"
+
+new "cli discard"
+expectpart "$($clixon_cli -1 -f $cfg -l o discard)" 0 "^$"
+
 new "cli debug set"
 expectpart "$($clixon_cli -1 -f $cfg -l o debug level 1)" 0 "^$"
 
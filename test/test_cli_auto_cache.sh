@@ -0,0 +1,122 @@
+#!/usr/bin/env bash
+# Auto-cli edit modes with cached configuration, see CLICON_CLI_EDIT_CACHE
+# Configuration read in an edit mode is shown again in modes below it without being
+# read again, until the datastore is changed, eg by an edit in the CLI
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fspec=$dir/automode.cli
+fin=$dir/in
+
+# Use yang in example
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>$dir</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_CLI_EDIT_CACHE>true</CLICON_CLI_EDIT_CACHE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fspec
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H %W> ";
+CLICON_PLUGIN="example_cli";
+
+# Autocli syntax tree operations
+edit @datamodel, cli_auto_edit("datamodel");
+up, cli_auto_up("datamodel");
+top, cli_auto_top("datamodel");
+set @datamodel, cli_auto_set();
+delete("Delete a configuration item") @datamodel, cli_auto_del();
+
+quit("Quit"), cli_quit();
+show("Show a particular state of the system"){
+    configuration("Show configuration"), cli_auto_show("datamodel", "candidate", "xml", false, false);
+}
+EOF
+
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+  <table xmlns="urn:example:clixon">
+    <parameter>
+      <name>a</name>
+      <value>42</value>
+    </parameter>
+  </table>
+</${DATASTORE_TOP}>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+cat <<EOF > $fin
+show config
+edit table parameter a
+show config
+EOF
+new "show top; edit table parameter a; show from cache"
+expectpart "$(cat $fin | $clixon_cli -f $cfg 2>&1)" 0 '<table xmlns="urn:example:clixon"><parameter><name>a</name><value>42</value></parameter></table>$' "/clixon-example:table/parameter=a/>" "<name>a</name><value>42</value>$"
+
+cat <<EOF > $fin
+edit table
+show config
+set parameter b value 71
+show config
+edit parameter b
+show config
+EOF
+new "edit table; show; set value 71; show after edit; edit parameter b; show"
+expectpart "$(cat $fin | $clixon_cli -f $cfg 2>&1)" 0 "<parameter><name>a</name><value>42</value></parameter>$" "<parameter><name>a</name><value>42</value></parameter><parameter><name>b</name><value>71</value></parameter>$" "<name>b</name><value>71</value>$"
+
+cat <<EOF > $fin
+show config
+edit table
+delete parameter b
+up
+show config
+EOF
+new "show top; delete parameter b; show after edit"
+expectpart "$(cat $fin | $clixon_cli -f $cfg 2>&1)" 0 '<table xmlns="urn:example:clixon"><parameter><name>a</name><value>42</value></parameter><parameter><name>b</name><value>71</value></parameter></table>$' '<table xmlns="urn:example:clixon"><parameter><name>a</name><value>42</value></parameter></table>$'
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
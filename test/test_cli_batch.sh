@@ -0,0 +1,147 @@
+#!/usr/bin/env bash
+# CLI batched edits, see CLICON_CLI_BATCH and cli_batch_begin()
+# Commands are piped to the CLI, consecutive edits are sent as one edit-config.
+# Check that the result is the same as without batching, also for overlapping edits,
+# and that edits are sent before show and commit commands.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/$APPNAME.yang
+clidir=$dir/cli
+if [ -d $clidir ]; then
+    rm -rf $clidir/*
+else
+    mkdir $clidir
+fi
+
+# Number of list entries
+nr=20
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>$clidir</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_GENMODEL>2</CLICON_CLI_GENMODEL>
+  <CLICON_CLI_GENMODEL_TYPE>VARS</CLICON_CLI_GENMODEL_TYPE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME {
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $clidir/ex.cli
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H> ";
+
+set @datamodel, cli_set();
+merge @datamodel, cli_merge();
+delete @datamodel, cli_del();
+show config, cli_show_config("candidate", "cli", "/", 0, "set ");
+commit, cli_commit();
+discard, discard_changes();
+batch begin, cli_batch_begin();
+batch end, cli_batch_end();
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+# Edits: create entries, change some values and delete some entries, ie overlapping edits
+cmds=""
+for (( i=0; i<$nr; i++ )); do
+    cmds="${cmds}set table parameter p$i value $i\n"
+done
+cmds="${cmds}set table parameter p1 value x\n"
+cmds="${cmds}delete table parameter p2\n"
+cmds="${cmds}set table parameter p2 value y\n"
+cmds="${cmds}delete table parameter p3\n"
+
+new "cli edits not batched"
+expectpart "$(echo -e "$cmds" | $clixon_cli -f $cfg)" 0 ""
+
+new "cli show not batched"
+SAVED=$($clixon_cli -1 -f $cfg show config)
+expectpart "$SAVED" 0 "set table parameter p0 value 0" "set table parameter p1 value x" "set table parameter p2 value y" --not-- "parameter p3"
+
+new "discard"
+expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
+
+new "cli edits batched"
+expectpart "$(echo -e "$cmds" | $clixon_cli -f $cfg -o CLICON_CLI_BATCH=true)" 0 ""
+
+new "cli show batched"
+ret=$($clixon_cli -1 -f $cfg show config)
+if [ "$ret" != "$SAVED" ]; then
+    err "$SAVED" "$ret"
+fi
+
+new "discard"
+expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
+
+new "cli batched edits are sent before show"
+expectpart "$(echo -e "set table parameter a value 1\nset table parameter b value 2\nshow config" | $clixon_cli -f $cfg -o CLICON_CLI_BATCH=true)" 0 "set table parameter a value 1" "set table parameter b value 2"
+
+new "cli explicit batch and commit"
+expectpart "$(echo -e "batch begin\nset table parameter c value 3\ndelete table parameter a\nbatch end\ncommit" | $clixon_cli -f $cfg)" 0 ""
+
+new "netconf get running"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>b</name><value>2</value></parameter><parameter><name>c</name><value>3</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset nr
+unset cmds
+unset ret
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+# Autocli of one-shot CLI commands, see CLICON_CLI_AUTOCLI_LAZY
+# Only the top-level YANG nodes of the command are generated. Check that commands on
+# a top-level node and on abbreviated node names work as in interactive mode.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_AUTOCLI_LAZY>true</CLICON_CLI_AUTOCLI_LAZY>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "cli set table parameter"
+expectpart "$($clixon_cli -1 -f $cfg set table parameter a value 42)" 0 "^$"
+
+new "cli set abbreviated table parameter"
+expectpart "$($clixon_cli -1 -f $cfg set tab parameter b value 17)" 0 "^$"
+
+new "cli show config"
+expectpart "$($clixon_cli -1 -f $cfg show conf cli)" 0 "set table parameter a value 42" "set table parameter b value 17"
+
+new "cli delete table parameter"
+expectpart "$($clixon_cli -1 -f $cfg delete table parameter b)" 0 "^$"
+
+new "cli show config deleted"
+expectpart "$($clixon_cli -1 -f $cfg show conf cli)" 0 "set table parameter a value 42" --not-- "parameter b"
+
+new "cli discard"
+expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,158 @@
+#!/usr/bin/env bash
+# CLI load of a configuration file in chunks, see CLICON_CLI_LOAD_CHUNK and bulk-load
+# A file with a list is loaded with a small chunk size so that it is sent in several
+# edit-configs, and without chunks. Check that the candidate is the same, and that
+# replace and merge work.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/$APPNAME.yang
+fconfig=$dir/config.xml
+clidir=$dir/cli
+if [ -d $clidir ]; then
+    rm -rf $clidir/*
+else
+    mkdir $clidir
+fi
+
+# Number of list entries
+nr=20
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>$clidir</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME {
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+    leaf x{
+      type string;
+    }
+  }
+}
+EOF
+
+cat <<EOF > $clidir/ex.cli
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H> ";
+
+load <filename:string>, load_config_file("filename", "replace");{
+    merge, load_config_file("filename", "merge");
+}
+discard, discard_changes();
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+# Create file and expected reply
+data=""
+for (( i=0; i<$nr; i++ )); do
+    data="$data<parameter><name>p$i</name><value>$i</value></parameter>"
+done
+cat <<EOF > $fconfig
+<?xml version="1.0" encoding="UTF-8"?>
+<config>
+   <!-- Comment -->
+   <table xmlns="urn:example:clixon">$data<x><![CDATA[<y>]]></x></table>
+</config>
+EOF
+reply="^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\">$data<x>&lt;y&gt;</x></table></data></rpc-reply>]]>]]>$"
+
+new "cli load in chunks"
+expectpart "$($clixon_cli -1 -f $cfg -o CLICON_CLI_LOAD_CHUNK=100 load $fconfig)" 0 "^$"
+
+new "netconf get candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "$reply"
+
+new "discard"
+expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
+
+new "cli load not in chunks"
+expectpart "$($clixon_cli -1 -f $cfg -o CLICON_CLI_LOAD_CHUNK=0 load $fconfig)" 0 "^$"
+
+new "netconf get candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "$reply"
+
+cat <<EOF > $fconfig
+<config>
+   <table xmlns="urn:example:clixon"><parameter><name>q</name><value>1</value></parameter></table>
+</config>
+EOF
+
+new "cli load merge in chunks"
+expectpart "$($clixon_cli -1 -f $cfg -o CLICON_CLI_LOAD_CHUNK=10 load $fconfig merge)" 0 "^$"
+
+new "netconf get candidate merged"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='q']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>q</name><value>1</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "cli load replace in chunks"
+expectpart "$($clixon_cli -1 -f $cfg -o CLICON_CLI_LOAD_CHUNK=10 load $fconfig)" 0 "^$"
+
+new "netconf get candidate replaced"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>q</name><value>1</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "netconf bulk-load end without begin"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><bulk-load xmlns=\"http://clicon.org/lib\"><operation>end</operation></bulk-load></rpc>]]>]]>" "<rpc-error><error-type>protocol</error-type><error-tag>operation-failed</error-tag>"
+
+new "cli load unbalanced file"
+echo "<config><table xmlns=\"urn:example:clixon\">" > $fconfig
+expectpart "$($clixon_cli -1 -f $cfg load $fconfig 2>&1)" 255 "Unexpected end of file"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset nr
+unset data
+unset reply
+
+rm -rf $dir
+
+new "endtest"
+endtest
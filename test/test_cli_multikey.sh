@@ -125,6 +125,19 @@ expectpart "$($clixon_cli -1 -f $cfg set ex y a 2 b v2)" 0 ""
 new "show conf"
 expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><ex xmlns=\"urn:example:clixon\"><x><a>1</a><b>v1</b></x><x><a>1</a><b>v2</b></x><x><a>1</a><b>v3</b></x><x><a>2</a><b>v1</b></x><x><a>2</a><b>v2</b></x><x><a>2</a><b>v3</b></x><y><a>1</a><b>v1</b></y><y><a>2</a><b>v1</b></y><y><a>1</a><b>v2</b></y><y><a>1</a><b>v3</b></y><y><a>2</a><b>v2</b></y></ex></data></rpc-reply>]]>]]>$"
 
+# Server-side values used by CLI completion, duplicates removed
+new "get-values x keys"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-values xmlns=\"http://clicon.org/lib\"><source>candidate</source><xpath xmlns:ex=\"urn:example:clixon\">/ex:ex/ex:x/ex:a</xpath></get-values></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><value xmlns=\"http://clicon.org/lib\">1</value><value xmlns=\"http://clicon.org/lib\">2</value></rpc-reply>]]>]]>$"
+
+new "get-values y keys ordered-by user"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-values xmlns=\"http://clicon.org/lib\"><source>candidate</source><xpath xmlns:ex=\"urn:example:clixon\">/ex:ex/ex:y/ex:a</xpath></get-values></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><value xmlns=\"http://clicon.org/lib\">1</value><value xmlns=\"http://clicon.org/lib\">2</value></rpc-reply>]]>]]>$"
+
+new "get-values x prefix"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-values xmlns=\"http://clicon.org/lib\"><source>candidate</source><xpath xmlns:ex=\"urn:example:clixon\">/ex:ex/ex:x/ex:a</xpath><prefix>2</prefix></get-values></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><value xmlns=\"http://clicon.org/lib\">2</value></rpc-reply>]]>]]>$"
+
+new "get-values x limit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-values xmlns=\"http://clicon.org/lib\"><source>candidate</source><xpath xmlns:ex=\"urn:example:clixon\">/ex:ex/ex:x/ex:b</xpath><limit>2</limit></get-values></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><value xmlns=\"http://clicon.org/lib\">v1</value><value xmlns=\"http://clicon.org/lib\">v2</value></rpc-reply>]]>]]>$"
+
 if [ $BE -ne 0 ]; then
     new "Kill backend"
     # Check if premature kill
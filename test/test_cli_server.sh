@@ -0,0 +1,92 @@
+#!/usr/bin/env bash
+# Persistent CLI server, see CLICON_CLI_SERVER_SOCK
+# Start a cli server with -S and run commands in sessions of attach clients (-A).
+# Check that sessions see configuration edits of each other and that the exit status
+# of a failed command is returned.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+sock=$dir/cli.sock
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_CLI_SERVER_SOCK>$sock</CLICON_CLI_SERVER_SOCK>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+new "start cli server"
+$clixon_cli -S -l s -f $cfg < /dev/null &
+spid=$!
+sleep 1
+if [ ! -S $sock ]; then
+    err "cli server socket $sock"
+fi
+
+new "cli attach set interface"
+expectpart "$($clixon_cli -A $sock -1 set interfaces interface eth/0/0)" 0 "^$"
+
+new "cli attach show configuration in new session"
+expectpart "$($clixon_cli -A $sock -1 show conf cli)" 0 "^set interfaces interface eth/0/0"
+
+new "cli attach failed validate"
+expectpart "$($clixon_cli -A $sock -1 -l o validate)" 255 ""
+
+new "cli attach discard"
+expectpart "$($clixon_cli -A $sock -1 discard)" 0 "^$"
+
+new "cli attach show configuration after discard"
+expectpart "$($clixon_cli -A $sock -1 show conf cli)" 0 "^$"
+
+new "cli attach no server"
+expectpart "$($clixon_cli -A $dir/nosuch.sock -1 show conf cli 2>&1)" 255 ""
+
+new "kill cli server"
+kill $spid
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset sock
+unset spid
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,131 @@
+#!/usr/bin/env bash
+# CLI show of configuration in pages, see CLICON_CLI_SHOW_PAGE
+# A list is read with get-config offset and limit attributes, first check the attributes
+# in netconf, then that the paged CLI show output is the same as non-paged
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/$APPNAME.yang
+clidir=$dir/cli
+if [ -d $clidir ]; then
+    rm -rf $clidir/*
+else
+    mkdir $clidir
+fi
+
+# Number of list entries
+nr=7
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_CLISPEC_DIR>$clidir</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_CLI_GENMODEL>2</CLICON_CLI_GENMODEL>
+  <CLICON_CLI_GENMODEL_TYPE>VARS</CLICON_CLI_GENMODEL_TYPE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME {
+  namespace "urn:example:clixon";
+  prefix ex;
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf value{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $clidir/ex.cli
+CLICON_MODE="example";
+CLICON_PROMPT="%U@%H> ";
+
+set @datamodel, cli_set();
+show config, cli_show_config("candidate", "cli", "/ex:table/ex:parameter", "urn:example:clixon", "set ");
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -z -f $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+# Create list entries
+new "generate config with $nr list entries"
+data="<table xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$nr; i++ )); do
+    data="$data<parameter><name>$i</name><value>$i</value></parameter>"
+done
+data="$data</table>"
+
+new "netconf add $nr list entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$data</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config offset 2 limit 3"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config offset=\"2\" limit=\"3\"><source><candidate/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>2</name><value>2</value></parameter><parameter><name>3</name><value>3</value></parameter><parameter><name>4</name><value>4</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "netconf get-config last page"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config offset=\"6\" limit=\"3\"><source><candidate/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>6</name><value>6</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "netconf get-config invalid limit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config limit=\"x\"><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-attribute</error-tag>"
+
+new "cli show config not paged"
+SAVED=$($clixon_cli -1 -f $cfg show config)
+expectpart "$SAVED" 0 "set table parameter 0 value 0" "set table parameter 6 value 6"
+
+for page in 1 3 $nr 100; do
+    new "cli show config page $page"
+    ret=$($clixon_cli -1 -o CLICON_CLI_SHOW_PAGE=$page -f $cfg show config)
+    if [ "$ret" != "$SAVED" ]; then
+	err "$SAVED" "$ret"
+    fi
+done
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset nr
+unset page
+unset ret
+
+rm -rf $dir
+
+new "endtest"
+endtest
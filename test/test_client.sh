@@ -39,6 +39,7 @@ cat <<EOF > $cfg
   <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
   <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
   <CLICON_XMLDB_FORMAT>$format</CLICON_XMLDB_FORMAT>
+  <CLICON_XMLDB_SHM>$dir/running.shm</CLICON_XMLDB_SHM>
   $RESTCONFIG
 </clixon-config>
 EOF
@@ -104,6 +105,49 @@ main(int    argc,
          goto done;
        printf("%u\n", u); /* for test output */
     }
+    /* Batched get of many values in one request, with cache of unchanged data */
+    {
+       char                name[16];
+       clixon_client_value vec[3] = {
+	   {"/table/parameter[name='a']/value", CLIXON_CLIENT_UINT32},
+	   {"/table/parameter[name='b']/name", CLIXON_CLIENT_STR, name, sizeof(name)},
+	   {"/table/parameter[name='c']/value", CLIXON_CLIENT_UINT32}
+       };
+       int                 i;
+
+       clixon_client_cache_set(ch, 1);
+       for (i=0; i<2; i++)
+	   if (clixon_client_get_batch(ch, "urn:example:clixon-client", "/table", vec, 3) != 2)
+	       goto done;
+       printf("batch %u %s %d\n", vec[0].cv_u.cv_uint32, name, vec[2].cv_found); /* for test output */
+       /* Accumulate edits and send them in one edit-config and commit */
+       if (clixon_client_set_uint32(ch, 7, "urn:example:clixon-client", "/table/parameter[name='c']/value") < 0)
+	   goto done;
+       if (clixon_client_delete(ch, "urn:example:clixon-client", "/table/parameter[name='a']") < 0)
+	   goto done;
+       if (clixon_client_flush_send(ch) < 0)
+	   goto done;
+       if (clixon_client_flush_recv(ch) < 0)
+	   goto done;
+       if (clixon_client_get_batch(ch, "urn:example:clixon-client", "/table", vec, 3) != 2)
+	   goto done;
+       printf("write %d %s %u\n", vec[0].cv_found, name, vec[2].cv_u.cv_uint32); /* for test output */
+    }
+    /* Read values from the image of running in shared memory, without rpc */
+    {
+       clixon_client_shm   shm;
+       clixon_client_value vec[2] = {
+	   {"/table/parameter[name='a']/value", CLIXON_CLIENT_UINT32},
+	   {"/exc:table/exc:parameter[name='c']/value", CLIXON_CLIENT_UINT32}
+       };
+
+       if ((shm = clixon_client_shm_open("$dir/running.shm")) == NULL)
+	   goto done;
+       if (clixon_client_shm_get(shm, vec, 2) != 1)
+	   goto done;
+       printf("shm %d %u\n", vec[0].cv_found, vec[1].cv_u.cv_uint32); /* for test output */
+       clixon_client_shm_close(shm);
+    }
     retval = 0;
   done:
     clixon_client_disconnect(ch);
@@ -142,7 +186,7 @@ if [ $RC -ne 0 ]; then
     wait_restconf
 fi
 
-XML='<table xmlns="urn:example:clixon-client"><parameter><name>a</name><value>42</value></parameter></table>'
+XML='<table xmlns="urn:example:clixon-client"><parameter><name>a</name><value>42</value></parameter><parameter><name>b</name><value>17</value></parameter></table>'
 
 # Add a set of entries using restconf
 new "POST the XML"
@@ -152,7 +196,7 @@ new "Check entries"
 expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/clixon-client:table -H 'Accept: application/yang-data+xml')" 0 'HTTP/1.1 200 OK' "$XML"
 
 new "Run $app"
-expectpart "$($app)" 0 '^42$'
+expectpart "$($app)" 0 '^42$' '^batch 42 b 0$' '^write 0 b 7$' '^shm 0 7$'
 
 if [ $RC -ne 0 ]; then
     new "Kill restconf daemon"
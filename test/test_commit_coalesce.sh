@@ -0,0 +1,140 @@
+#!/usr/bin/env bash
+# Commit coalescing of autocommit edits, see CLICON_COMMIT_COALESCE
+# Edits from N concurrent sessions within the window are committed in one transaction,
+# observed with the transaction log of the example backend plugin (-- -t).
+# If the common commit fails, only the failing edit gets an error
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/coalesce.yang
+flog=$dir/backend.log
+touch $flog
+
+# Number of concurrent edits
+N=5
+
+# Coalescing window in ms
+window=2000
+
+# Used as a trigger for user-validation errors, eg <value>$errnr</value> is invalid
+errnr=42
+
+cat <<EOF > $fyang
+module coalesce{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+	 leaf name{
+	    type string;
+	 }
+	 leaf value{
+	    type string;
+	 }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_AUTOCOMMIT>true</CLICON_AUTOCOMMIT>
+  <CLICON_COMMIT_COALESCE>$window</CLICON_COMMIT_COALESCE>
+</clixon-config>
+EOF
+
+# Edit of parameter $1 with value $2
+function edit(){
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>$1</name><value>$2</value></parameter></table></config></edit-config></rpc>]]>]]>"
+}
+
+# Commit transactions in log since line $1
+function commits(){
+    tail -n +$(($1+1)) $flog | grep -c "main_commit add:"
+}
+
+new "test params: -f $cfg -l f$flog -- -t -v /table/parameter[value=$errnr]"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg -l f$flog -- -t -v /table/parameter[value=$errnr]"
+    start_backend -s init -f $cfg -l f$flog -- -t -v /table/parameter[value=$errnr]
+fi
+
+new "waiting"
+wait_backend
+
+new "single edit is committed at end of window"
+expecteof "$clixon_netconf -qf $cfg" 0 "$(edit x 0)" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+l0=$(wc -l < $flog)
+new "$N concurrent edits"
+for (( i=1; i<=$N; i++ )); do
+    edit p$i $i | $clixon_netconf -qf $cfg > $dir/r$i.xml &
+done
+wait
+
+for (( i=1; i<=$N; i++ )); do
+    new "edit $i ok"
+    expectpart "$(cat $dir/r$i.xml)" 0 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+done
+
+new "$N edits give one commit"
+expectpart "$(commits $l0)" 0 "^1$"
+
+new "the commit has all edits"
+expectpart "$(tail -n +$((l0+1)) $flog | grep "main_commit add:")" 0 "<name>p1</name>" "<name>p$N</name>"
+
+new "running has all edits"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='p$N']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>p$N</name><value>$N</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "concurrent edits, one invalid"
+edit q1 1 | $clixon_netconf -qf $cfg > $dir/r1.xml &
+edit q2 $errnr | $clixon_netconf -qf $cfg > $dir/r2.xml &
+edit q3 3 | $clixon_netconf -qf $cfg > $dir/r3.xml &
+wait
+
+new "valid edit q1 ok"
+expectpart "$(cat $dir/r1.xml)" 0 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "invalid edit q2 fails"
+expectpart "$(cat $dir/r2.xml)" 0 "<rpc-error>" "User error"
+
+new "valid edit q3 ok"
+expectpart "$(cat $dir/r3.xml)" 0 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "running has valid edits only"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[starts-with(ex:name,'q')]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>q1</name><value>1</value></parameter><parameter><name>q3</name><value>3</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -125,6 +125,24 @@ expectpart "$($clixon_cli -1 -f $cfg -l o show options)" 0 'CLICON_MODULE_SET_ID
 new "Start with 2 extra configfiles + command-line"
 expectpart "$($clixon_cli -1 -f $cfg -o CLICON_MODULE_SET_ID=4 -o CLICON_FEATURE=test4 -l o show options)" 0 'CLICON_MODULE_SET_ID: "4"' 'CLICON_FEATURE: "test1"' 'CLICON_FEATURE: "test2"' 'CLICON_FEATURE: "test3"' 'CLICON_FEATURE: "test4"'
 
+cat <<EOF > $cfile2
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_DEBUG_CATEGORIES>event=0,msg=1</CLICON_DEBUG_CATEGORIES>
+</clixon-config>
+EOF
+
+new "Start with debug categories"
+expectpart "$($clixon_cli -1 -f $cfg -l o show options)" 0 'CLICON_DEBUG_CATEGORIES: "event=0,msg=1"'
+
+cat <<EOF > $cfile2
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_DEBUG_CATEGORIES>foo=1</CLICON_DEBUG_CATEGORIES>
+</clixon-config>
+EOF
+
+new "Start with invalid debug category"
+expectpart "$($clixon_cli -1 -f $cfg -l o show options)" 255 "No such debug category: foo"
+
 rm -rf $dir
 
 new "endtest"
@@ -0,0 +1,95 @@
+#!/usr/bin/env bash
+# Datastore files in CBOR format (RFC 9254), CLICON_XMLDB_FORMAT=cbor
+# Values of all encoded types are written and read back unchanged.
+# Just run a binary direct to datastore. No clixon.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+fyang=$dir/cbor.yang
+
+: ${clixon_util_datastore:=clixon_util_datastore}
+
+cat <<EOF2 > $fyang
+module cbor{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf i {
+        type int32;
+      }
+      leaf u {
+        type uint64;
+      }
+      leaf d {
+        type decimal64{
+          fraction-digits 3;
+        }
+      }
+      leaf b {
+        type boolean;
+      }
+      leaf e {
+        type empty;
+      }
+    }
+    leaf-list z {
+      type int8;
+    }
+  }
+}
+EOF2
+
+mydir=$dir/cbor
+
+if [ ! -d $mydir ]; then
+    mkdir $mydir
+fi
+rm -rf $mydir/*
+
+conf="-d candidate -b $mydir -y $fyang -f cbor"
+
+XML='<x xmlns="urn:example:clixon"><y><a>1</a><i>-42</i><u>18446744073709551615</u><d>-0.050</d><b>true</b><e/></y><y><a>2</a><i>7</i><d>12.300</d><b>false</b></y><z>-128</z><z>0</z><z>127</z></x>'
+
+new "datastore init"
+expectpart "$($clixon_util_datastore $conf init)" 0 ""
+
+new "datastore put"
+expectpart "$($clixon_util_datastore $conf put replace "$XML")" 0 ""
+
+new "datastore file starts with self-described CBOR tag"
+expectpart "$(od -An -tx1 -N3 $mydir/candidate_db)" 0 "d9 d9 f7"
+
+new "datastore get"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "^<${DATASTORE_TOP}>$XML</${DATASTORE_TOP}>$"
+
+new "datastore put merge"
+expectpart "$($clixon_util_datastore $conf put merge '<x xmlns="urn:example:clixon"><y><a>3</a><i>01</i></y></x>')" 0 ""
+
+new "datastore get non-canonical value as string"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "<y><a>3</a><i>01</i></y>"
+
+new "datastore delete"
+expectpart "$($clixon_util_datastore $conf delete)" 0 ""
+
+new "datastore init"
+expectpart "$($clixon_util_datastore $conf init)" 0 ""
+
+new "datastore get empty"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "^<${DATASTORE_TOP}/>$"
+
+# unset conditional parameters
+unset clixon_util_datastore
+
+rm -rf $mydir
+
+rm -rf $dir
+
+new "endtest"
+endtest
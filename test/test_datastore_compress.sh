@@ -0,0 +1,87 @@
+#!/usr/bin/env bash
+# Compressed datastore files, CLICON_XMLDB_COMPRESS
+# Files are written compressed if a level is set, and compressed files are read
+# regardless of the option.
+# Just run a binary direct to datastore. No clixon.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+if [ "${WITH_ZSTD}" != yes ]; then
+    echo "...skipped: clixon not configured --with-zstd"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+fyang=$dir/compress.yang
+
+: ${clixon_util_datastore:=clixon_util_datastore}
+
+cat <<EOF2 > $fyang
+module compress{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf b {
+        type string;
+      }
+    }
+  }
+}
+EOF2
+
+mydir=$dir/compress
+
+if [ ! -d $mydir ]; then
+    mkdir $mydir
+fi
+rm -rf $mydir/*
+
+conf="-d candidate -b $mydir -y $fyang"
+
+XML='<x xmlns="urn:example:clixon"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y></x>'
+
+for format in xml json cbor; do
+    new "datastore $format init"
+    expectpart "$($clixon_util_datastore $conf -f $format -z 3 init)" 0 ""
+
+    new "datastore $format put compressed"
+    expectpart "$($clixon_util_datastore $conf -f $format -z 3 put replace "$XML")" 0 ""
+
+    new "datastore $format file starts with zstd magic"
+    expectpart "$(od -An -tx1 -N4 $mydir/candidate_db)" 0 "28 b5 2f fd"
+
+    new "datastore $format get compressed"
+    expectpart "$($clixon_util_datastore $conf -f $format -z 3 get /)" 0 "^<${DATASTORE_TOP}>$XML</${DATASTORE_TOP}>$"
+
+    new "datastore $format get compressed without option"
+    expectpart "$($clixon_util_datastore $conf -f $format get /)" 0 "^<${DATASTORE_TOP}>$XML</${DATASTORE_TOP}>$"
+
+    new "datastore $format merge without option writes uncompressed"
+    expectpart "$($clixon_util_datastore $conf -f $format put merge '<x xmlns="urn:example:clixon"><y><a>3</a><b>three</b></y></x>')" 0 ""
+
+    new "datastore $format file is not compressed"
+    expectpart "$(od -An -tx1 -N4 $mydir/candidate_db)" 0 --not-- "28 b5 2f fd"
+
+    new "datastore $format get uncompressed"
+    expectpart "$($clixon_util_datastore $conf -f $format -z 3 get /)" 0 "<y><a>3</a><b>three</b></y>"
+
+    new "datastore $format delete"
+    expectpart "$($clixon_util_datastore $conf -f $format delete)" 0 ""
+done
+
+# unset conditional parameters
+unset clixon_util_datastore
+
+rm -rf $mydir
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,121 @@
+#!/usr/bin/env bash
+# Datastore cache allocated from huge pages, see CLICON_XMLDB_HUGEPAGES and CLICON_XMLDB_NUMA
+# The trees should be the same as with regular pages. Explicit huge pages fall back to
+# transparent huge pages if none are reserved, eg in /proc/sys/vm/nr_hugepages
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/hugepages.yang
+
+# Number of list entries, more than fit in one chunk of arena blocks
+nr=20000
+
+cat <<EOF > $fyang
+module hugepages{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+      list y {
+         key a;
+         leaf a {
+            type int32;
+         }
+         leaf b {
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+# Startup with list entries, parsed into the datastore cache
+new "generate startup with $nr list entries"
+echo -n "<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\">" > $dir/startup_db.orig
+for (( i=0; i<$nr; i++ )); do
+    echo -n "<y><a>$i</a><b>entry$i</b></y>" >> $dir/startup_db.orig
+done
+echo "</x></${DATASTORE_TOP}>" >> $dir/startup_db.orig
+
+# Run the same tests with different pages
+# 1: CLICON_XMLDB_HUGEPAGES
+function testrun()
+{
+    pages=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_DATASTORE_CACHE>cache</CLICON_DATASTORE_CACHE>
+  <CLICON_XMLDB_HUGEPAGES>$pages</CLICON_XMLDB_HUGEPAGES>
+  <CLICON_XMLDB_NUMA>true</CLICON_XMLDB_NUMA>
+</clixon-config>
+EOF
+
+    cp $dir/startup_db.orig $dir/startup_db
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s startup -f $cfg"
+	start_backend -s startup -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    new "get-config last entry pages:$pages"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='$((nr-1))']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>$((nr-1))</a><b>entry$((nr-1))</b></y></x></data></rpc-reply>]]>]]>$"
+
+    new "delete entries pages:$pages"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><y nc:operation=\"delete\"><a>0</a></y><y nc:operation=\"delete\"><a>1</a></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "commit pages:$pages"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "get-config first entries pages:$pages"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a&lt;3]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>2</a><b>entry2</b></y></x></data></rpc-reply>]]>]]>$"
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "regular pages"
+testrun none
+
+new "transparent huge pages"
+testrun transparent
+
+new "explicit huge pages"
+testrun explicit
+
+unset nr
+unset pages
+
+rm -rf $dir
+
+new "endtest"
+endtest
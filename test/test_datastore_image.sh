@@ -0,0 +1,95 @@
+#!/usr/bin/env bash
+# Datastore file images in nocache mode, CLICON_XMLDB_IMAGE
+# Reads with simple xpaths are served from the mapped image of the datastore file,
+# and give the same result as reading the file. An outdated image is not used.
+# Just run a binary direct to datastore. No clixon.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+fyang=$dir/image.yang
+
+: ${clixon_util_datastore:=clixon_util_datastore}
+
+cat <<EOF2 > $fyang
+module image{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a c";
+      leaf a {
+        type string;
+      }
+      leaf c {
+        type int32;
+      }
+      leaf b {
+        type string;
+      }
+      container d {
+        leaf e {
+          type string;
+        }
+      }
+    }
+    leaf-list z {
+      type string;
+    }
+    leaf g {
+      type string;
+    }
+  }
+}
+EOF2
+
+mydir=$dir/image
+
+if [ ! -d $mydir ]; then
+    mkdir $mydir
+fi
+rm -rf $mydir/*
+
+conf="-d candidate -b $mydir -y $fyang"
+
+XML='<x xmlns="urn:example:clixon"><y><a>2</a><c>1</c><b>two</b><d><e>x</e></d></y><y><a>1</a><c>2</c><b>one</b></y><y><a>1</a><c>1</c><b>first</b></y><z>b</z><z>a</z><g>last</g></x>'
+
+new "datastore init"
+expectpart "$($clixon_util_datastore $conf -i init)" 0 ""
+
+new "datastore put"
+expectpart "$($clixon_util_datastore $conf -i put replace "$XML")" 0 ""
+
+new "datastore image written"
+if [ ! -f $mydir/candidate_db.img ]; then
+    err "$mydir/candidate_db.img" "no image"
+fi
+
+# Compare reads from image with reads from file
+for xpath in "/" "/x" "/x/y" "/x/y[a='1'][c='2']" "/x/y[c='1'][a='2']/d/e" "/x/y/b" "/x/z[.='a']" "/x/g" "/x/y[a='3'][c='3']" "/x/y[b='one']"; do
+    new "datastore get $xpath from image"
+    ref=$($clixon_util_datastore $conf get "$xpath")
+    expectpart "$($clixon_util_datastore $conf -i get "$xpath")" 0 "^$ref$"
+done
+
+new "datastore get list entry from image"
+expectpart "$($clixon_util_datastore $conf -i get "/x/y[a='1'][c='2']")" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>1</a><c>2</c><b>one</b></y></x></${DATASTORE_TOP}>$"
+
+new "write datastore file, image is outdated"
+cat <<EOF2 > $mydir/candidate_db
+<${DATASTORE_TOP}><x xmlns="urn:example:clixon"><g>new</g></x></${DATASTORE_TOP}>
+EOF2
+
+new "datastore get outdated image reads file"
+expectpart "$($clixon_util_datastore $conf -i get /x/g)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><g>new</g></x></${DATASTORE_TOP}>$"
+
+# unset conditional parameters
+unset clixon_util_datastore
+
+rm -rf $mydir
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,117 @@
+#!/usr/bin/env bash
+# Datastore journal mode, see CLICON_XMLDB_PERSIST
+# Edits are appended to <db>_db.journal and replayed on load, the journal is
+# compacted into the datastore file after a number of records.
+# Just run a binary direct to datastore. No clixon.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+fyang=$dir/journal.yang
+
+: ${clixon_util_datastore:=clixon_util_datastore}
+
+cat <<EOF > $fyang
+module journal{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf b {
+        type string;
+      }
+    }
+    leaf g {
+      type string;
+    }
+  }
+}
+EOF
+
+mydir=$dir/journal
+
+if [ ! -d $mydir ]; then
+    mkdir $mydir
+fi
+rm -rf $mydir/*
+
+# Compact after three records
+conf="-d candidate -b $mydir -y $fyang -j 3"
+
+new "datastore init"
+expectpart "$($clixon_util_datastore $conf init)" 0 ""
+
+new "datastore put replace writes datastore file"
+expectpart "$($clixon_util_datastore $conf put replace '<x xmlns="urn:example:clixon"><g>first</g></x>')" 0 ""
+
+new "no journal after replace"
+if [ -f $mydir/candidate_db.journal ]; then
+    err "no $mydir/candidate_db.journal" "journal exists"
+fi
+
+new "datastore put merge appends to journal"
+expectpart "$($clixon_util_datastore $conf put merge '<x xmlns="urn:example:clixon"><y><a>1</a><b>one</b></y></x>')" 0 ""
+
+new "journal exists"
+if [ ! -f $mydir/candidate_db.journal ]; then
+    err "$mydir/candidate_db.journal" "no journal"
+fi
+
+new "datastore file not rewritten"
+expectpart "$(cat $mydir/candidate_db)" 0 "first" --not-- "one"
+
+new "datastore get replays journal"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><g>first</g></x></${DATASTORE_TOP}>$"
+
+new "datastore put delete appends to journal"
+expectpart "$($clixon_util_datastore $conf put delete '<x xmlns="urn:example:clixon"><g/></x>')" 0 ""
+
+new "datastore put merge appends to journal"
+expectpart "$($clixon_util_datastore $conf put merge '<x xmlns="urn:example:clixon"><y><a>2</a><b>two</b></y></x>')" 0 ""
+
+new "datastore get replays journal"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y></x></${DATASTORE_TOP}>$"
+
+new "datastore other db copy"
+expectpart "$($clixon_util_datastore $conf copy kalle)" 0 ""
+
+new "datastore get copied db"
+expectpart "$($clixon_util_datastore -d kalle -b $mydir -y $fyang get /)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y></x></${DATASTORE_TOP}>$"
+
+new "datastore put merge compacts journal"
+expectpart "$($clixon_util_datastore $conf put merge '<x xmlns="urn:example:clixon"><y><a>3</a><b>three</b></y></x>')" 0 ""
+
+new "no journal after compaction"
+if [ -f $mydir/candidate_db.journal ]; then
+    err "no $mydir/candidate_db.journal" "journal exists"
+fi
+
+new "datastore file rewritten"
+expectpart "$(cat $mydir/candidate_db)" 0 "two" "three"
+
+new "datastore get after compaction"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y><y><a>3</a><b>three</b></y></x></${DATASTORE_TOP}>$"
+
+new "datastore put merge appends to journal"
+expectpart "$($clixon_util_datastore $conf put merge '<x xmlns="urn:example:clixon"><g>last</g></x>')" 0 ""
+
+new "datastore delete removes journal"
+expectpart "$($clixon_util_datastore $conf delete)" 0 ""
+if [ -f $mydir/candidate_db.journal ]; then
+    err "no $mydir/candidate_db.journal" "journal exists"
+fi
+
+# unset conditional parameters
+unset clixon_util_datastore
+
+rm -rf $mydir
+
+rm -rf $dir
+
+new "endtest"
+endtest
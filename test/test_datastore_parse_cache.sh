@@ -0,0 +1,103 @@
+#!/usr/bin/env bash
+# Parse cache of datastore files in nocache mode, see CLICON_XMLDB_PARSE_CACHE
+# Repeated reads of an unchanged datastore file copy the cached tree instead of parsing
+# the file. A file changed after it was parsed is parsed again.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/pcache.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_DATASTORE_CACHE>nocache</CLICON_DATASTORE_CACHE>
+  <CLICON_XMLDB_PARSE_CACHE>1000000</CLICON_XMLDB_PARSE_CACHE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module pcache{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+      list y {
+         key a;
+         leaf a {
+            type string;
+         }
+         leaf b {
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "add entries"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config parses candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y></x></data></rpc-reply>]]>]]>$"
+
+new "get-config from parse cache"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a='2']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>2</a><b>two</b></y></x></data></rpc-reply>]]>]]>$"
+
+new "stats parse cache hit"
+expectpart "$(echo "$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" | $clixon_netconf -qf $cfg)" 0 "<parse-cache><entries>[1-9][0-9]*</entries>" "<hits>[1-9][0-9]*</hits>"
+
+new "change datastore file after it was parsed"
+sudo chmod 666 $dir/candidate_db
+cat <<EOF > $dir/candidate_db.new
+<${DATASTORE_TOP}><x xmlns="urn:example:clixon"><y><a>3</a><b>three</b></y></x></${DATASTORE_TOP}>
+EOF
+sudo mv $dir/candidate_db.new $dir/candidate_db
+
+new "get-config of changed file is parsed again"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>3</a><b>three</b></y></x></data></rpc-reply>]]>]]>$"
+
+new "edit after cached read"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>4</a><b>four</b></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config sees edit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>3</a><b>three</b></y><y><a>4</a><b>four</b></y></x></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,140 @@
+#!/usr/bin/env bash
+# Datastore sharded per top-level module, CLICON_XMLDB_SHARD
+# The content of each module is written to a file of its own in <db>_db.d, an edit
+# rewrites only the files of the modules it changes and a copy links the files.
+# Just run a binary direct to datastore. No clixon.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+fyanga=$dir/sharda.yang
+fyangb=$dir/shardb.yang
+
+: ${clixon_util_datastore:=clixon_util_datastore}
+
+cat <<EOF2 > $fyanga
+module sharda{
+   yang-version 1.1;
+   namespace "urn:example:a";
+   prefix a;
+   container x {
+    list y {
+      key "k";
+      leaf k {
+        type string;
+      }
+      leaf v {
+        type string;
+      }
+    }
+  }
+}
+EOF2
+
+cat <<EOF2 > $fyangb
+module shardb{
+   yang-version 1.1;
+   namespace "urn:example:b";
+   prefix b;
+   container z {
+    leaf w {
+      type string;
+    }
+  }
+}
+EOF2
+
+mydir=$dir/shard
+
+if [ ! -d $mydir ]; then
+    mkdir $mydir
+fi
+rm -rf $mydir/*
+
+conf="-b $mydir -y $fyanga -y $fyangb"
+
+XA='<x xmlns="urn:example:a"><y><k>2</k><v>two</v></y><y><k>1</k><v>one</v></y></x>'
+XB='<z xmlns="urn:example:b"><w>first</w></z>'
+XALL="^<${DATASTORE_TOP}><x xmlns=\"urn:example:a\"><y><k>1</k><v>one</v></y><y><k>2</k><v>two</v></y></x><z xmlns=\"urn:example:b\"><w>first</w></z></${DATASTORE_TOP}>$"
+
+new "datastore init"
+expectpart "$($clixon_util_datastore $conf -d candidate -s init)" 0 ""
+
+new "datastore put module a"
+expectpart "$($clixon_util_datastore $conf -d candidate -s put merge "$XA")" 0 ""
+
+new "datastore shard of a written"
+if [ ! -f $mydir/candidate_db.d/sharda.xml ]; then
+    err "$mydir/candidate_db.d/sharda.xml" "no shard"
+fi
+if [ -f $mydir/candidate_db.d/shardb.xml ]; then
+    err "no shard" "$mydir/candidate_db.d/shardb.xml"
+fi
+
+new "datastore file is marked sharded"
+expectpart "$(cat $mydir/candidate_db)" 0 "clixon-sharded=\"true\"" --not-- "urn:example:a"
+
+new "datastore put module b"
+expectpart "$($clixon_util_datastore $conf -d candidate -s put merge "$XB")" 0 ""
+
+new "datastore get all"
+expectpart "$($clixon_util_datastore $conf -d candidate -s get /)" 0 "$XALL"
+
+new "datastore get all without shard option"
+expectpart "$($clixon_util_datastore $conf -d candidate get /)" 0 "$XALL"
+
+ino=$(stat -c %i $mydir/candidate_db.d/sharda.xml)
+
+new "datastore put module b again"
+expectpart "$($clixon_util_datastore $conf -d candidate -s put merge '<z xmlns="urn:example:b"><w>second</w></z>')" 0 ""
+
+new "datastore shard of a not rewritten"
+if [ "$ino" != "$(stat -c %i $mydir/candidate_db.d/sharda.xml)" ]; then
+    err "$ino" "$(stat -c %i $mydir/candidate_db.d/sharda.xml)"
+fi
+
+new "datastore get b"
+expectpart "$($clixon_util_datastore $conf -d candidate -s get /z)" 0 "^<${DATASTORE_TOP}><z xmlns=\"urn:example:b\"><w>second</w></z></${DATASTORE_TOP}>$"
+
+new "datastore copy candidate to running"
+expectpart "$($clixon_util_datastore $conf -d candidate -s copy running)" 0 ""
+
+new "datastore shard of running linked"
+if [ "$ino" != "$(stat -c %i $mydir/running_db.d/sharda.xml)" ]; then
+    err "$ino" "$(stat -c %i $mydir/running_db.d/sharda.xml)"
+fi
+
+new "datastore get running"
+expectpart "$($clixon_util_datastore $conf -d running -s get /x/y/v)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:a\"><y><k>1</k><v>one</v></y><y><k>2</k><v>two</v></y></x></${DATASTORE_TOP}>$"
+
+new "datastore replace with module a only"
+expectpart "$($clixon_util_datastore $conf -d candidate -s put replace "$XA")" 0 ""
+
+new "datastore shard of b removed"
+if [ -f $mydir/candidate_db.d/shardb.xml ]; then
+    err "no shard" "$mydir/candidate_db.d/shardb.xml"
+fi
+
+new "datastore running is unchanged"
+expectpart "$($clixon_util_datastore $conf -d running -s get /z)" 0 "^<${DATASTORE_TOP}><z xmlns=\"urn:example:b\"><w>second</w></z></${DATASTORE_TOP}>$"
+
+new "datastore put without shard option"
+expectpart "$($clixon_util_datastore $conf -d candidate put merge "$XB")" 0 ""
+
+new "datastore shards removed"
+if [ -d $mydir/candidate_db.d ]; then
+    err "no shards" "$mydir/candidate_db.d"
+fi
+
+new "datastore get all not sharded"
+expectpart "$($clixon_util_datastore $conf -d candidate get /)" 0 "$XALL"
+
+# unset conditional parameters
+unset clixon_util_datastore
+
+rm -rf $mydir
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,90 @@
+#!/usr/bin/env bash
+# Datastore files written in sorted order are marked with a clixon-sorted attribute
+# and are not sorted again when read. Files without the attribute, or with a value of
+# other yang modules, are sorted.
+# Just run a binary direct to datastore. No clixon.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+fyang=$dir/sorted.yang
+
+: ${clixon_util_datastore:=clixon_util_datastore}
+
+cat <<EOF2 > $fyang
+module sorted{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type string;
+      }
+      leaf b {
+        type string;
+      }
+    }
+    leaf g {
+      type string;
+    }
+  }
+}
+EOF2
+
+mydir=$dir/sorted
+
+if [ ! -d $mydir ]; then
+    mkdir $mydir
+fi
+rm -rf $mydir/*
+
+conf="-d candidate -b $mydir -y $fyang"
+
+new "datastore init"
+expectpart "$($clixon_util_datastore $conf init)" 0 ""
+
+new "datastore put unsorted"
+expectpart "$($clixon_util_datastore $conf put replace '<x xmlns="urn:example:clixon"><g>last</g><y><a>2</a><b>two</b></y><y><a>1</a><b>one</b></y></x>')" 0 ""
+
+new "datastore file is marked as sorted"
+expectpart "$(cat $mydir/candidate_db)" 0 "^<${DATASTORE_TOP} clixon-sorted=\"[0-9a-f]\{8\}\">"
+mark=$(grep -o "clixon-sorted=\"[0-9a-f]*\"" $mydir/candidate_db)
+
+new "datastore get marked file"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y><g>last</g></x></${DATASTORE_TOP}>$"
+
+new "write unsorted datastore file without mark"
+cat <<EOF2 > $mydir/candidate_db
+<${DATASTORE_TOP}><x xmlns="urn:example:clixon"><g>last</g><y><a>2</a><b>two</b></y><y><a>1</a><b>one</b></y></x></${DATASTORE_TOP}>
+EOF2
+
+new "datastore get unmarked file is sorted"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y><g>last</g></x></${DATASTORE_TOP}>$"
+
+new "write unsorted datastore file with mark of other yang modules"
+cat <<EOF2 > $mydir/candidate_db
+<${DATASTORE_TOP} clixon-sorted="true"><x xmlns="urn:example:clixon"><g>last</g><y><a>2</a><b>two</b></y><y><a>1</a><b>one</b></y></x></${DATASTORE_TOP}>
+EOF2
+
+new "datastore get file with other mark is sorted"
+expectpart "$($clixon_util_datastore $conf get /)" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>one</b></y><y><a>2</a><b>two</b></y><g>last</g></x></${DATASTORE_TOP}>$"
+
+new "datastore put with new revision of yang module"
+sed -i 's/prefix ex;/prefix ex;\n   revision 2026-01-01;/' $fyang
+expectpart "$($clixon_util_datastore $conf put merge '<x xmlns="urn:example:clixon"><y><a>0</a><b>zero</b></y></x>')" 0 ""
+
+new "datastore file is marked with other value"
+expectpart "$(cat $mydir/candidate_db)" 0 "^<${DATASTORE_TOP} clixon-sorted=\"[0-9a-f]\{8\}\">" --not-- "$mark"
+
+# unset conditional parameters
+unset clixon_util_datastore
+unset mark
+
+rm -rf $mydir
+
+rm -rf $dir
+
+new "endtest"
+endtest
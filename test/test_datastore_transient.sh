@@ -0,0 +1,130 @@
+#!/usr/bin/env bash
+# Candidate kept in memory only, see CLICON_XMLDB_TRANSIENT
+# Edits of candidate do not write the candidate file, commit writes running as usual.
+# Uncommitted edits are lost if the backend is killed and restarted, and the
+# flush-datastore RPC writes the candidate file
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/transient.yang
+
+cat <<EOF > $fyang
+module transient{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+	 leaf name{
+	    type string;
+	 }
+	 leaf value{
+	    type string;
+	 }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_DATASTORE_CACHE>cache</CLICON_DATASTORE_CACHE>
+  <CLICON_XMLDB_TRANSIENT>true</CLICON_XMLDB_TRANSIENT>
+</clixon-config>
+EOF
+
+# Edit candidate with parameter $1 and value $2
+function edit(){
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>$1</name><value>$2</value></parameter></table></config></edit-config></rpc>]]>]]>"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "edit candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 "$(edit a 1)" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config candidate"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "no candidate file is written"
+expectpart "$(ls $dir)" 0 "running_db" --not-- "candidate_db" "tmp_db"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "running file is written"
+expectpart "$(cat $dir/running_db)" 0 "<name>a</name><value>1</value>"
+
+new "still no candidate file"
+expectpart "$(ls $dir)" 0 "running_db" --not-- "candidate_db"
+
+new "edit candidate, not committed"
+expecteof "$clixon_netconf -qf $cfg" 0 "$(edit b 2)" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "kill backend without exit"
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    sudo kill -9 $pid
+
+    new "no candidate file after kill"
+    expectpart "$(ls $dir)" 0 "running_db" --not-- "candidate_db"
+
+    new "restart backend -s running -f $cfg"
+    sudo clixon_backend -zf $cfg
+    start_backend -s running -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "candidate edit is lost at restart"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "edit candidate and flush-datastore"
+expecteof "$clixon_netconf -qf $cfg" 0 "$(edit c 3)<rpc $DEFAULTNS><flush-datastore xmlns=\"http://clicon.org/lib\"><target>candidate</target></flush-datastore></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "candidate file is written by flush"
+expectpart "$(cat $dir/candidate_db)" 0 "<name>a</name><value>1</value>" "<name>c</name><value>3</value>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
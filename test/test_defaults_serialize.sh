@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# Default values of state data printed when get replies are serialized, see
+# CLICON_DEFAULTS_SERIALIZE. The replies should be the same as when the default values
+# are added to the reply tree.
+# Use main example -- -sS option to add state via a file
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/defaults.yang
+fstate=$dir/state.xml
+
+cat <<EOF > $fyang
+module defaults{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      leaf a{
+         type int32;
+         default 42;
+      }
+      leaf st{
+         config false;
+         type string;
+         default "state";
+      }
+   }
+   container s{
+      config false;
+      leaf d{
+         type int32;
+         default 7;
+      }
+      leaf e{
+         type string;
+      }
+      container n{
+         leaf m{
+            type int32;
+            default 3;
+         }
+      }
+   }
+}
+EOF
+
+# State of callback, default values not included
+cat <<EOF > $fstate
+<s xmlns="urn:example:clixon"><e>x</e></s>
+EOF
+
+# Expected reply with default values
+DATA='<data><c xmlns="urn:example:clixon"><a>42</a><st>state</st></c><s xmlns="urn:example:clixon"><d>7</d><e>x</e><n><m>3</m></n></s></data>'
+
+# Run the same tests with and without the option
+# 1: CLICON_DEFAULTS_SERIALIZE
+function testrun()
+{
+    serialize=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_DEFAULTS_SERIALIZE>$serialize</CLICON_DEFAULTS_SERIALIZE>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg -- -sS $fstate"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg -- -sS $fstate"
+	start_backend -s init -f $cfg -- -sS $fstate
+    fi
+
+    new "waiting"
+    wait_backend
+
+    new "get serialize:$serialize"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS>$DATA</rpc-reply>]]>]]>$"
+
+    new "get with filter serialize:$serialize"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:s/ex:d\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><s xmlns=\"urn:example:clixon\"><d>7</d></s></data></rpc-reply>]]>]]>$"
+
+    new "get-config with-defaults report-all serialize:$serialize"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config with-defaults=\"report-all\"><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a>42</a></c></data></rpc-reply>]]>]]>$"
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "default values added to tree"
+testrun false
+
+new "default values printed when serialized"
+testrun true
+
+unset DATA
+unset serialize
+
+rm -rf $dir
+
+new "endtest"
+endtest
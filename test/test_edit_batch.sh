@@ -0,0 +1,88 @@
+#!/usr/bin/env bash
+# Many independent edits in one request, see edit-batch in clixon-lib.yang
+# Check the result of each edit, that a failed edit does not affect the others,
+# and that the edits are in the datastore.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/batch.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module batch{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "edit-batch with one failed edit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-batch xmlns=\"http://clicon.org/lib\"><edit><id>e1</id><config><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>1</v></a></c></config></edit><edit><id>e2</id><config><c xmlns=\"urn:example:clixon\"><a><b>b2</b><xx>2</xx></a></c></config></edit><edit><id>e3</id><config><c xmlns=\"urn:example:clixon\"><a><b>b3</b><v>3</v></a></c></config></edit></edit-batch></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><edit xmlns=\"http://clicon.org/lib\"><id>e1</id><ok/></edit><edit xmlns=\"http://clicon.org/lib\"><id>e2</id><error><rpc-error xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><error-type>application</error-type><error-tag>unknown-element</error-tag>.*</rpc-error></error></edit><edit xmlns=\"http://clicon.org/lib\"><id>e3</id><ok/></edit></rpc-reply>]]>]]>$"
+
+new "get-config: edits e1 and e3"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>1</v></a><a><b>b3</b><v>3</v></a></c></data></rpc-reply>]]>]]>$"
+
+new "edit-batch replace"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-batch xmlns=\"http://clicon.org/lib\"><edit><id>r</id><default-operation>replace</default-operation><config><c xmlns=\"urn:example:clixon\"><a><b>b4</b><v>4</v></a></c></config></edit></edit-batch></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><edit xmlns=\"http://clicon.org/lib\"><id>r</id><ok/></edit></rpc-reply>]]>]]>$"
+
+new "get-config: replaced"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b4</b><v>4</v></a></c></data></rpc-reply>]]>]]>$"
+
+new "discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
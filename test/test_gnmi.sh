@@ -0,0 +1,133 @@
+#!/usr/bin/env bash
+# gNMI daemon clixon_gnmi: Capabilities, Set, Get and Subscribe
+# Uses the gnmic client (https://gnmic.kmrd.dev) in insecure (plain-text) mode
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Skip it if not configured --with-gnmi
+if [ "${WITH_GNMI}" != "yes" ]; then
+    echo "...skipped: clixon_gnmi not built"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+# Skip it if no gnmic client
+if ! [ -x "$(command -v gnmic)" ]; then
+    echo "...gnmic not installed"
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+: ${clixon_gnmi:="clixon_gnmi"}
+
+cfg=$dir/conf.xml
+fyang=$dir/gnmi.yang
+GNMIPORT=9339
+: ${gnmic:="gnmic -a 127.0.0.1:$GNMIPORT --insecure --timeout 5s"}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_GNMI_ADDRESS>127.0.0.1</CLICON_GNMI_ADDRESS>
+  <CLICON_GNMI_PORT>$GNMIPORT</CLICON_GNMI_PORT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module gnmi{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+      leaf x{
+         type string;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "start clixon_gnmi -f $cfg"
+sudo pkill -f clixon_gnmi
+$clixon_gnmi -f $cfg -l e -D $DBG &
+gnmipid=$!
+sleep $DEMWAIT
+
+new "gnmi capabilities"
+expectpart "$($gnmic capabilities 2>&1)" 0 "gNMI version: 0.8.0" "JSON_IETF"
+
+new "gnmi set update leaf"
+expectpart "$($gnmic -e json_ietf set --update-path /gnmi:c/x --update-value 42 2>&1)" 0 '"operation": "UPDATE"'
+
+new "gnmi set update list entry"
+expectpart "$($gnmic -e json_ietf set --update-path "/gnmi:c/a[b=b0]/v" --update-value 17 2>&1)" 0 '"operation": "UPDATE"'
+
+new "gnmi get leaf"
+expectpart "$($gnmic -e json_ietf get --path /gnmi:c/x 2>&1)" 0 '"x": "42"'
+
+new "gnmi get list entry"
+expectpart "$($gnmic -e json_ietf get --path "/gnmi:c/a[b=b0]" 2>&1)" 0 '"v": 17'
+
+new "gnmi get unknown path"
+expectpart "$($gnmic -e json_ietf get --path /gnmi:c/xyz 2>&1)" 1 "NotFound"
+
+new "gnmi subscribe once"
+expectpart "$($gnmic -e json_ietf subscribe --mode once --path /gnmi:c/x 2>&1)" 0 '"x": "42"'
+
+new "gnmi set delete leaf"
+expectpart "$($gnmic -e json_ietf set --delete /gnmi:c/x 2>&1)" 0 '"operation": "DELETE"'
+
+new "netconf check leaf deleted"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b0</b><v>17</v></a></c></data></rpc-reply>]]>]]>$"
+
+new "kill clixon_gnmi"
+kill $gnmipid 2> /dev/null
+wait $gnmipid 2> /dev/null
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset gnmic
+unset GNMIPORT
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -47,6 +47,29 @@ module json{
       description "indirect type";
       type gtype;
    }
+   container t{
+     description "Encoding of typed values, see yang_json_enc_get";
+     leaf d{
+       type decimal64{
+         fraction-digits 2;
+       }
+     }
+     leaf b{
+       type boolean;
+     }
+     leaf u{
+       type uint64;
+     }
+     leaf n{
+       type union{
+         type int32;
+         type string;
+       }
+     }
+     leaf-list l{
+       type int16;
+     }
+   }
 }
 EOF
 
@@ -101,6 +124,38 @@ JSON='{"json:c":{"a":937}}'
 new "json parse container back to json"
 expecteofx "$clixon_util_json -jy $fyang" 0 "$JSON" "$JSON"
 
+JSON='{"json:c":{"s":"a\"b\\c\nd"}}'
+new "json string escapes back to json"
+expecteofx "$clixon_util_json -jy $fyang" 0 "$JSON" "$JSON"
+
+new "json unicode escapes to xml"
+expecteofx "$clixon_util_json -y $fyang" 0 '{"json:c":{"s":"\u0041\u00e9"}}' '<c xmlns="urn:example:clixon"><s>Aé</s></c>'
+
+JSON='{"json:t":{"d":3.14,"b":true,"u":18446744073709551615,"n":"x","l":[1,-2]}}'
+new "json typed values back to json"
+expecteofx "$clixon_util_json -jy $fyang" 0 "$JSON" "$JSON"
+
+new "xml typed values to json"
+expecteofx "$clixon_util_xml -ovjy $fyang" 0 '<t xmlns="urn:example:clixon"><d>3.14</d><b>true</b><u>18446744073709551615</u><n>x</n><l>1</l><l>-2</l></t>' "$JSON"
+
+new "json syntax error trailing comma"
+expecteof "$clixon_util_json" 255 '{"a":1,}' '' 2> /dev/null
+
+new "json syntax error unterminated string"
+expecteof "$clixon_util_json" 255 '{"a":"1}' '' 2> /dev/null
+
+# Recursive parser must not overflow the stack, see JSON_DEPTH_MAX
+DEEP=$(printf '%*s' 100000 "" | tr ' ' '[')
+new "json syntax error too deep nesting"
+expecteof "$clixon_util_json" 255 "{\"a\":$DEEP" '' 2> /dev/null
+
+DEEP=$(printf '%*s' 100 "" | tr ' ' '[')1$(printf '%*s' 100 "" | tr ' ' ']')
+new "json nesting below max"
+expecteofx "$clixon_util_json" 0 "{\"a\":$DEEP}" '<a>1</a>'
+
+new "json syntax error empty array in array"
+expecteof "$clixon_util_json" 255 '{"a":[[],1]}' '' 2> /dev/null
+
 # identities translation json -> xml is tricky wrt prefixes, json uses module
 # name, xml uses xml namespace prefixes (or default)
 JSON='{"json:g1":"json:blues"}'
@@ -138,6 +193,7 @@ rm -rf $dir
 # unset conditional parameters 
 unset clixon_util_json
 unset clixon_util_xml
+unset DEEP
 
 new "endtest"
 endtest
@@ -0,0 +1,76 @@
+#!/usr/bin/env bash
+# Netconf chunked framing, RFC 6242 Sec 4.2, see CLICON_NETCONF_CHUNKED
+# After a hello with base:1.1, rpcs are sent in chunks and the replies are chunked.
+# A message may be split in several chunks. Without base:1.1, end-of-message framing is used.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_NETCONF_CHUNKED>true</CLICON_NETCONF_CHUNKED>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+
+    new "waiting"
+    wait_backend
+fi
+
+HELLO10="<hello $DEFAULTNS><capabilities><capability>urn:ietf:params:netconf:base:1.0</capability></capabilities></hello>]]>]]>"
+RPC="<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>"
+REPLY="<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "netconf chunked get-config"
+expectpart "$( (printf '%s' "$DEFAULTHELLO"; printf '\n#%d\n%s\n##\n' ${#RPC} "$RPC") | $clixon_netconf -qf $cfg)" 0 "^#${#REPLY}$" "^$REPLY$" "^##$"
+
+new "netconf chunked get-config in two chunks"
+expectpart "$( (printf '%s' "$DEFAULTHELLO"; printf '\n#%d\n%s\n#%d\n%s\n##\n' 10 "${RPC:0:10}" $((${#RPC}-10)) "${RPC:10}") | $clixon_netconf -qf $cfg)" 0 "^#${#REPLY}$" "^$REPLY$" "^##$"
+
+new "netconf chunked two messages"
+expectpart "$( (printf '%s' "$DEFAULTHELLO"; printf '\n#%d\n%s\n##\n\n#%d\n%s\n##\n' ${#RPC} "$RPC" ${#RPC} "$RPC") | $clixon_netconf -qf $cfg | grep -c "^$REPLY$")" 0 "^2$"
+
+new "netconf base:1.0 hello uses end-of-message framing"
+expecteof "$clixon_netconf -qf $cfg" 0 "$HELLO10$RPC]]>]]>" "^$REPLY]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset HELLO10
+unset RPC
+unset REPLY
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,122 @@
+#!/usr/bin/env bash
+# Partial locks of running, RFC 5717, see CLICON_NETCONF_PARTIAL_LOCK
+# A session holding a partial lock of one list entry blocks commits of that entry by
+# another session, while commits of other entries are made concurrently.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/plock.yang
+PLNS="urn:ietf:params:xml:ns:netconf:partial-lock:1.0"
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_NETCONF_PARTIAL_LOCK>true</CLICON_NETCONF_PARTIAL_LOCK>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module plock{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+# Select of list entry b1
+SELECT="<select xmlns:ex=\"urn:example:clixon\">/ex:c/ex:a[ex:b='b1']</select>"
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "hello advertises partial-lock capability"
+expecteof "$clixon_netconf -f $cfg" 0 "$DEFAULTHELLO" "<capability>urn:ietf:params:netconf:capability:partial-lock:1.0</capability>"
+
+new "add entries b1 and b2 and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>1</v></a><a><b>b2</b><v>2</v></a></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "partial-lock and partial-unlock"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><partial-lock xmlns=\"$PLNS\">$SELECT</partial-lock></rpc>]]>]]><rpc $DEFAULTNS><partial-unlock xmlns=\"$PLNS\"><lock-id>1</lock-id></partial-unlock></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><lock-id xmlns=\"$PLNS\">1</lock-id><locked-node xmlns=\"$PLNS\" xmlns:ex=\"urn:example:clixon\">/ex:c/ex:a\[ex:b='b1'\]</locked-node></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "partial-lock of no nodes fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><partial-lock xmlns=\"$PLNS\"><select xmlns:ex=\"urn:example:clixon\">/ex:c/ex:a[ex:b='b9']</select></partial-lock></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>invalid-value</error-tag>"
+
+new "partial-unlock of unknown lock fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><partial-unlock xmlns=\"$PLNS\"><lock-id>99</lock-id></partial-unlock></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>invalid-value</error-tag>"
+
+# Another session holds a partial lock of b1 in the background
+new "partial-lock b1 in other session"
+(echo "$DEFAULTHELLO<rpc $DEFAULTNS><partial-lock xmlns=\"$PLNS\">$SELECT</partial-lock></rpc>]]>]]>"; sleep 5) | $clixon_netconf -qf $cfg > /dev/null &
+sleep 1
+
+new "lock running fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><lock><target><running/></target></lock></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>lock-denied</error-tag>"
+
+new "partial-lock of same entry fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><partial-lock xmlns=\"$PLNS\">$SELECT</partial-lock></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>lock-denied</error-tag>"
+
+new "commit change of locked b1 fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>11</v></a></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>in-use</error-tag>"
+
+new "discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit change of unlocked b2"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><b>b2</b><v>22</v></a></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# The lock is released when the other session ends
+wait
+
+new "commit change of b1 after other session ended"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>11</v></a></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config running"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>11</v></a><a><b>b2</b><v>22</v></a></c></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+# Test: in-process library benchmarks, see util/clixon_util_bench.c
+# Run all benchmarks for small list sizes and check the output format:
+#   <name> <n> <ops> <rounds> <usec min> <usec avg> <ops per sec> <peak rss kB>
+# Datastore benchmarks are named <name>/<cache mode>
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_bench:="clixon_util_bench"}
+
+# List sizes
+: ${perfsizes:=100,1000}
+
+new "benchmarks sizes $perfsizes"
+ret=$($clixon_util_bench -b $dir -n $perfsizes -r 1)
+if [ $? -ne 0 ]; then
+    err "0" "$?"
+fi
+echo "$ret"
+
+for name in xml_parse xml_bind xml_print xml_apply json_parse json_print xml_sort find_index xpath xpath_noopt xml_diff validate xmldb_put; do
+    new "benchmark $name"
+    match=$(echo "$ret" | grep -E "^$name 1000 [0-9]+ 1 [0-9]+ [0-9]+ [0-9]+ [0-9]+$")
+    if [ -z "$match" ]; then
+	err "$name 1000 <ops> 1 <usec> <usec> <per sec> <rss>" "$ret"
+    fi
+done
+
+for mode in nocache cache cache-zerocopy; do
+    for name in ds_put ds_merge ds_get ds_copy ds_delete; do
+	new "benchmark $name/$mode"
+	match=$(echo "$ret" | grep -E "^$name/$mode 1000 1 1 [0-9]+ [0-9]+ [0-9]+ [0-9]+$")
+	if [ -z "$match" ]; then
+	    err "$name/$mode 1000 1 1 <usec> <usec> <per sec> <rss>" "$ret"
+	fi
+    done
+done
+
+new "benchmark datastore one cache mode"
+ret=$($clixon_util_bench -b $dir -n 1000 -r 2 -c cache ds_get)
+if [ $? -ne 0 ]; then
+    err "0" "$?"
+fi
+match=$(echo "$ret" | grep -E "^ds_get/nocache")
+if [ -n "$match" ]; then
+    err "only ds_get/cache" "$ret"
+fi
+match=$(echo "$ret" | grep -E "^ds_get/cache 1000 1 2 ")
+if [ -z "$match" ]; then
+    err "ds_get/cache 1000 1 2" "$ret"
+fi
+
+new "benchmark invalid cache mode"
+expectpart "$($clixon_util_bench -b $dir -n 100 -c foo ds_get 2>&1)" 255 "Unknown datastore cache mode: foo"
+
+new "benchmark xpath lookups"
+expectpart "$($clixon_util_bench -b $dir -n 1000 -r 1 -l 50 xpath)" 0 "^# name n ops rounds usec_min usec_avg per_sec rss_kb" "xpath 1000 50 1 "
+
+rm -rf $dir
+
+# unset conditional parameters 
+unset clixon_util_bench
+unset perfsizes
+unset match
+unset mode
+
+new "endtest"
+endtest
@@ -16,6 +16,9 @@ s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 # Number of requests made get/put
 : ${perfreq:=10}
 
+# Number of concurrent restconf clients in load test, each makes $perfreq requests
+: ${perfconc:="1 4 16"}
+
 # time function (this is a mess to get right on freebsd/linux)
 # -f %e gives elapsed wall clock time but is not available on all systems
 # so we use time -p for POSIX compliance and awk to get wall clock time
@@ -30,6 +33,39 @@ fyang=$dir/scaling.yang
 fconfig=$dir/large.xml
 fconfig2=$dir/large2.xml
 
+# Restconf load generator: concurrent clients each making $perfreq GET requests on one
+# keep-alive connection (curl reuses the connection for several URLs in one call)
+# Print requests/sec and p99 latency, check that each client used a single connection
+# 1: number of concurrent clients
+function restconf_load()
+{
+    conc=$1
+    ftimes=$dir/times
+    urls=""
+    for (( i=0; i<$perfreq; i++ )); do
+	rnd=$(( ( RANDOM % $perfnr ) ))
+	urls="$urls $RCPROTO://localhost/restconf/data/scaling:x/y=$rnd"
+    done
+    rm -f $ftimes.*
+    t0=$(date +%s.%N)
+    for (( j=0; j<$conc; j++ )); do
+	curl $CURLOPTS -X GET -w "\nstat: %{time_total} %{num_connects}\n" $urls | awk '/^stat:/ {print $2, $3}' > $ftimes.$j &
+    done
+    wait
+    t1=$(date +%s.%N)
+    nreq=$(cat $ftimes.* | wc -l)
+    if [ $nreq -ne $(( $conc * $perfreq )) ]; then
+	err "$(( $conc * $perfreq )) replies" "$nreq"
+    fi
+    nconn=$(cat $ftimes.* | awk '{s += $2} END {print s}')
+    if [ $nconn -ne $conc ]; then
+	err "$conc connections (keep-alive)" "$nconn"
+    fi
+    p99=$(cat $ftimes.* | awk '{print $1}' | sort -n | awk '{t[NR]=$1} END {i=int((NR*99+99)/100); print t[i]}')
+    echo "concurrency: $conc requests: $nreq req/s: $(echo "$t0 $t1 $nreq" | awk '{printf "%.1f", $3/($2-$1)}') p99: ${p99}s"
+    rm -f $ftimes.*
+}
+
 cat <<EOF > $fyang
 module scaling{
    yang-version 1.1;
@@ -144,6 +180,11 @@ new "restconf get large config"
 # XXX for some reason cannot expand $TIMEFN next two tests, need keep variable?
 $TIMEFN curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data 2>&1 > /dev/null | awk '/real/ {print $2}'
 
+for c in $perfconc; do
+    new "restconf load $c concurrent clients $perfreq keep-alive requests each"
+    restconf_load $c
+done
+
 # Delete entries (last since entries are removed from db)
 # netconf
 new "cli delete $perfreq small config"
@@ -217,6 +258,7 @@ unset RESTCONFIG
 unset format
 unset perfnr
 unset perfreq
+unset perfconc
 
 new "endtest"
 endtest
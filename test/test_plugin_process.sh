@@ -0,0 +1,121 @@
+#!/usr/bin/env bash
+# Plugin processes, see ca_trans_process
+# The example backend plugin is started with -- -P -x <xpath>: its transaction callbacks
+# are called in a plugin process, which crashes in the commit callback if <xpath>
+# matches the target.
+# 1. A commit calls the plugin process
+# 2. A crash of the plugin process fails the commit, running is unchanged and the
+#    backend is still running
+# 3. A new plugin process is started at the next commit
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/trans.yang
+flog=$dir/backend.log
+touch $flog
+
+# Used as a trigger for a crash, eg <value>$errnr</value>
+errnr=42
+
+cat <<EOF > $fyang
+module trans{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+	 leaf name{
+	    type string;
+	 }
+	 leaf value{
+	    type string;
+	 }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+# Edit and commit parameter $1 with value $2
+function commit(){
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>$1</name><value>$2</value></parameter></table></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>"
+}
+
+new "test params: -f $cfg -l f$flog -- -t -P -x /table/parameter[value=$errnr]"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg -l f$flog -- -t -P -x /table/parameter[value=$errnr]"
+    start_backend -s init -f $cfg -l f$flog -- -t -P -x /table/parameter[value=$errnr]
+fi
+
+new "waiting"
+wait_backend
+
+new "commit parameter a"
+expecteof "$clixon_netconf -qf $cfg" 0 "$(commit a 1)" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "plugin process commits"
+expectpart "$(cat $flog)" 0 "main_validate" "main_commit"
+
+new "commit parameter b crashes plugin process"
+expecteof "$clixon_netconf -qf $cfg" 0 "$(commit b $errnr)" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><rpc-error>.*Plugin 'example' process failed"
+
+new "transaction is aborted"
+expectpart "$(cat $flog)" 0 "nacm_abort"
+
+if [ $BE -ne 0 ]; then
+    new "backend is running"
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend running" "backend dead"
+    fi
+fi
+
+new "running is unchanged"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "discard-changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit parameter c in new plugin process"
+expecteof "$clixon_netconf -qf $cfg" 0 "$(commit c 3)" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "running with a and c"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>c</name><value>3</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
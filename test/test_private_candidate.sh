@@ -0,0 +1,124 @@
+#!/usr/bin/env bash
+# Private candidates per session, see CLICON_PRIVATE_CANDIDATE
+# Edits of a session are not seen by other sessions until committed.
+# A commit merges the changes of the session with changes committed to running by
+# other sessions since, and fails if both changed the same nodes.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/private.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_PRIVATE_CANDIDATE>true</CLICON_PRIVATE_CANDIDATE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module private{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+# Edit of entry $1 with value $2
+function edit(){
+    echo "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><b>$1</b><v>$2</v></a></c></config></edit-config></rpc>]]>]]>"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "add entries b1 and b2 and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(edit b1 1)$(edit b2 2)<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "edit is seen by the session only"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(edit b1 11)<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>11</v></a><a><b>b2</b><v>2</v></a></c></data></rpc-reply>]]>]]>$"
+
+new "candidate of new session is running"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>1</v></a><a><b>b2</b><v>2</v></a></c></data></rpc-reply>]]>]]>$"
+
+# Session edits b1, and commits after another session has committed b2
+new "edit b1 in session, commit later"
+(echo "$DEFAULTHELLO$(edit b1 11)"; sleep 2; echo "<rpc $DEFAULTNS><commit/></rpc>]]>]]>"; sleep 1) | $clixon_netconf -qf $cfg > $dir/a.xml &
+sleep 1
+
+new "edit b2 in other session and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(edit b2 22)<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+wait
+
+new "commit of b1 is merged"
+expectpart "$(cat $dir/a.xml)" 0 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "get-config running with both changes"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>11</v></a><a><b>b2</b><v>22</v></a></c></data></rpc-reply>]]>]]>$"
+
+# Session edits b1, and commits after another session has committed b1
+new "edit b1 in session, commit later"
+(echo "$DEFAULTHELLO$(edit b1 111)"; sleep 2; echo "<rpc $DEFAULTNS><commit/></rpc>]]>]]>"; sleep 1) | $clixon_netconf -qf $cfg > $dir/a.xml &
+sleep 1
+
+new "edit b1 in other session and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(edit b1 1111)<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+wait
+
+new "commit of b1 conflicts"
+expectpart "$(cat $dir/a.xml)" 0 "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag>"
+
+new "get-config running with other change"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>1111</v></a><a><b>b2</b><v>22</v></a></c></data></rpc-reply>]]>]]>$"
+
+new "discard-changes resets to running"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(edit b3 3)<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]><rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>1111</v></a><a><b>b2</b><v>22</v></a></c></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,101 @@
+#!/usr/bin/env bash
+# Compact binary encoding of the internal backend protocol, see CLICON_PROTO_BINARY
+# Netconf requests are sent to the backend binary encoded. Check that edit-config,
+# get-config and errors give the same result as with XML text.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/moda.yang
+
+cat <<EOF > $fyang
+module moda{
+  namespace "urn:example:a";
+  prefix a;
+  container x{
+    list y{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf v{
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+# Run the same tests with binary and text encoding
+# 1: true or false
+function testrun()
+{
+    binary=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_PROTO_BINARY>$binary</CLICON_PROTO_BINARY>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    new "netconf edit-config with prefixes and repeated names"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a:x xmlns:a=\"urn:example:a\"><a:y><a:name>y1</a:name><a:v>1</a:v></a:y><a:y><a:name>y2</a:name><a:v>2</a:v></a:y></a:x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf edit-config empty key"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><y><name></name></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf get-config"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x\" xmlns:a=\"urn:example:a\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:a\"><y><name/></y><y><name>y1</name><v>1</v></y><y><name>y2</name><v>2</v></y></x></data></rpc-reply>]]>]]>$"
+
+    new "netconf edit-config unknown element"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><y><name>y3</name><w>3</w></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>unknown-element</error-tag><error-info><bad-element>w</bad-element></error-info>"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "binary encoding"
+testrun true
+
+new "text encoding"
+testrun false
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,98 @@
+#!/usr/bin/env bash
+# Push subscriptions of datastore data, see establish-push in clixon-lib.yang
+# A periodic subscription sends the selected data of running, and an on-change
+# subscription sends the changes of a commit that are selected by its xpath-filter.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+NCWAIT=5 # Wait (netconf valgrind may need more time)
+
+cfg=$dir/conf.xml
+fyang=$dir/push.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module push{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+      leaf x{
+         type string;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "add list entry"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><a><b>b0</b><v>0</v></a></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "establish-push without period or on-change"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><establish-push xmlns=\"http://clicon.org/lib\"><xpath-filter>/c</xpath-filter></establish-push></rpc>]]>]]>" "<rpc-error>"
+
+new "periodic push-update"
+expectwait "$clixon_netconf -qf $cfg" "$DEFAULTHELLO<rpc $DEFAULTNS><establish-push xmlns=\"http://clicon.org/lib\"><xpath-filter xmlns:ex=\"urn:example:clixon\">/ex:c/ex:a</xpath-filter><period>50</period></establish-push></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><id xmlns=\"http://clicon.org/lib\">[0-9]+</id></rpc-reply>]]>]]><notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20[^<]*</eventTime><push-update xmlns=\"http://clicon.org/lib\"><id>[0-9]+</id><datastore-contents><c xmlns=\"urn:example:clixon\"><a><b>b0</b><v>0</v></a></c></datastore-contents></push-update></notification>" $NCWAIT
+
+new "on-change push-change-update of selected change"
+expectwait "$clixon_netconf -qf $cfg" "$DEFAULTHELLO<rpc $DEFAULTNS><establish-push xmlns=\"http://clicon.org/lib\"><xpath-filter xmlns:ex=\"urn:example:clixon\">/ex:c/ex:a</xpath-filter><on-change/></establish-push></rpc>]]>]]><rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\"><x>not selected</x><a><b>b1</b><v>1</v></a></c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "<notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20[^<]*</eventTime><push-change-update xmlns=\"http://clicon.org/lib\"><id>[0-9]+</id><datastore-changes><created><c xmlns=\"urn:example:clixon\"><a><b>b1</b><v>1</v></a></c></created></datastore-changes></push-change-update></notification>" $NCWAIT
+
+new "delete-push of unknown id"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><delete-push xmlns=\"http://clicon.org/lib\"><id>4711</id></delete-push></rpc>]]>]]>" "<error-message>No such push subscription</error-message>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset NCWAIT
+
+rm -rf $dir
+
+new "endtest"
+endtest
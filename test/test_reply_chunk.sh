@@ -0,0 +1,83 @@
+#!/usr/bin/env bash
+# Chunked get replies, see CLICON_BACKEND_REPLY_CHUNK
+# Set a small chunk size so that get replies are written in chunks to the client
+# socket, and check that the replies are the same as when built in memory.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+
+# Number of list entries
+: ${perfnr:=200}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_REPLY_CHUNK>64</CLICON_BACKEND_REPLY_CHUNK>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "generate config with $perfnr list entries"
+str="<table xmlns=\"urn:example:clixon\">"
+for (( i=0; i<$perfnr; i++ )); do
+    str+="<parameter><name>$i</name><value>x&lt;$i&gt;</value></parameter>"
+done
+str+="</table>"
+
+new "netconf edit-config"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$str</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get chunked reply"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$str</data></rpc-reply>]]>]]>$"
+
+new "netconf get small reply"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='1']\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>1</name><value>x&lt;1&gt;</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "netconf get chunked reply followed by rpc in same session"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS message-id=\"1\"><get><filter type=\"xpath\" select=\"/ex:table\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]><rpc $DEFAULTNS message-id=\"2\"><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS message-id=\"1\"><data>$str</data></rpc-reply>]]>]]><rpc-reply $DEFAULTNS message-id=\"2\"><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# unset conditional parameters
+unset perfnr
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -171,6 +171,48 @@ function testrun()
 	new "Wrong proto=http on https port, expect bad request"
 	expectpart "$(curl $CURLOPTS -X GET http://$addr:443/.well-known/host-meta)" 0 "HTTP/1.1 400 Bad Request"
     fi
+
+    if [ $proto = https -a "${WITH_RESTCONF}" = "native" ]; then # see restconf_alpn_select_cb
+	if [ "${ENABLE_HTTP2}" = "yes" ]; then
+	    new "ALPN offering h2 and http/1.1 selects h2"
+	    expectpart "$(curl $CURLOPTS --http2 -X GET $proto://$addr/.well-known/host-meta)" 0 'HTTP/2 200' "<Link rel='restconf' href='/restconf'/>"
+	else
+	    new "ALPN offering h2 and http/1.1 selects http/1.1"
+	    expectpart "$(curl $CURLOPTS --http2 -X GET $proto://$addr/.well-known/host-meta)" 0 'HTTP/1.1 200 OK' "<Link rel='restconf' href='/restconf'/>"
+	fi
+
+	new "TLS full handshake, save session"
+	expectpart "$(echo | openssl s_client -tls1_2 -connect $addr:443 -sess_out $dir/tlssess.pem 2>&1)" 0 "New, TLSv1.2"
+
+	new "TLS resumed handshake with saved session ticket"
+	expectpart "$(echo | openssl s_client -tls1_2 -connect $addr:443 -sess_in $dir/tlssess.pem 2>&1)" 0 "Reused, TLSv1.2"
+    fi
+
+    if [ "${WITH_RESTCONF}" = "native" -a "${ENABLE_HTTP2}" = "yes" ]; then # see restconf_http2.c
+	if [ $proto = https ]; then
+	    h2opt=--http2 # ALPN
+	else
+	    h2opt=--http2-prior-knowledge
+	fi
+	new "HTTP/2 POST rpc"
+	expectpart "$(curl $CURLOPTS $h2opt -X POST -H "Content-Type: application/yang-data+json" -d {\"clixon-example:input\":null} $proto://$addr/restconf/operations/clixon-example:empty)" 0 "HTTP/2 204"
+
+	new "HTTP/2 HEAD"
+	expectpart "$(curl $CURLOPTS $h2opt -I -H "Accept: application/yang-data+json" $proto://$addr/restconf/data)" 0 "HTTP/2 200" "content-type: application/yang-data+json"
+
+	if [ -x "$(command -v nghttp)" ]; then
+	    new "HTTP/2 multiplexed requests on one connection"
+	    ret=$(nghttp -nv $proto://$addr/restconf/data/clixon-example:state $proto://$addr/restconf/yang-library-version $proto://$addr/.well-known/host-meta 2>&1)
+	    if [ "$(echo "$ret" | grep -c ':status: 200')" -ne 3 ]; then
+		err "3 replies with :status: 200" "$ret"
+	    fi
+
+	    new "HTTP/2 event stream requires HTTP/1.1"
+	    expectpart "$(nghttp -nv -H 'Accept: text/event-stream' $proto://$addr/streams/EXAMPLE 2>&1)" "0 1" "HTTP_1_1_REQUIRED"
+	else
+	    echo "...nghttp not installed, multiplexed HTTP/2 not tested"
+	fi
+    fi
     
     # Exact match
     new "restconf get restconf resource. RFC 8040 3.3 (json)"
@@ -315,7 +357,7 @@ function testrun()
     expectpart "$(curl $CURLOPTS -X GET -H 'Accept: application/yang-data+json' $proto://$addr/restconf/data/clixon-example:state)" 0 'HTTP/1.1 200 OK' '{"clixon-example:state":{"op":\["41","42","43"\]}}'
 
     new "restconf Re-post eth/0/0 which should generate error"
-    expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"ietf-interfaces:interface":{"name":"eth/0/0","type":"clixon-example:eth","enabled":true}}' $proto://$addr/restconf/data/ietf-interfaces:interfaces)" 0 '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"data-exists","error-severity":"error","error-message":"Data already exists; cannot create new resource"}}}'
+    expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"ietf-interfaces:interface":{"name":"eth/0/0","type":"clixon-example:eth","enabled":true}}' $proto://$addr/restconf/data/ietf-interfaces:interfaces)" 0 '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"data-exists","error-severity":"error","error-message":"Data already exists; cannot create new resource"}}}'
 
     new "Add leaf description using POST"
     expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"ietf-interfaces:description":"The-first-interface"}' $proto://$addr/restconf/data/ietf-interfaces:interfaces/interface=eth%2f0%2f0)" 0 "HTTP/1.1 201 Created"
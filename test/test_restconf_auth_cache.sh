@@ -0,0 +1,228 @@
+#!/usr/bin/env bash
+# Restconf authentication cache, see CLICON_RESTCONF_AUTH_CACHE
+# Users authenticated by the basic auth callback of the main example are cached per
+# credentials. Check that other credentials are not authenticated by the cache, and
+# that a change of NACM in running is seen.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/conf.xml
+
+# The anonymous user
+anonymous=myanonymous
+
+fyang=$dir/myexample.yang
+
+# No ssl
+RCPROTO=http
+
+RESTCONFIG=$(restconf_config user false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_RESTCONF_DIR>/usr/local/lib/$APPNAME/restconf</CLICON_RESTCONF_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_ANONYMOUS_USER>$anonymous</CLICON_ANONYMOUS_USER>
+  <CLICON_RESTCONF_AUTH_CACHE>2</CLICON_RESTCONF_AUTH_CACHE>
+  <CLICON_RESTCONF_AUTH_CACHE_TTL>60</CLICON_RESTCONF_AUTH_CACHE_TTL>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module myexample{
+  yang-version 1.1;
+  namespace "urn:example:auth";
+  prefix ex;
+  import ietf-netconf-acm {
+	prefix nacm;
+  }
+  container top {
+     leaf anonymous{
+        type string;
+     }	   
+     leaf wilma {
+        type string;
+     }
+  }
+}
+EOF
+
+# NACM rules and top/ config
+cat <<EOF > $dir/startup_db
+<${DATASTORE_TOP}>
+   <nacm xmlns="urn:ietf:params:xml:ns:yang:ietf-netconf-acm">
+     <enable-nacm>true</enable-nacm>
+     <read-default>deny</read-default>
+     <write-default>deny</write-default>
+     <exec-default>deny</exec-default>
+     <groups>
+       <group>
+         <name>anonymous</name>
+         <user-name>$anonymous</user-name>
+       </group>
+       <group>
+         <name>limited</name>
+         <user-name>wilma</user-name>
+       </group>
+       <group>
+         <name>admin</name>
+         <user-name>root</user-name>
+         <user-name>$USER</user-name>
+       </group>
+     </groups>
+     <rule-list>
+       <name>data-anon</name>
+       <group>anonymous</group>
+       <rule>
+         <name>allow-get</name>
+         <module-name>ietf-netconf</module-name>
+         <rpc-name>get</rpc-name>
+         <access-operations>exec</access-operations>
+         <action>permit</action>
+       </rule>
+       <rule>
+         <name>allow-anon</name>
+         <module-name>myexample</module-name>
+         <access-operations>*</access-operations>
+         <path xmlns:ex="urn:example:auth">/ex:top/ex:anonymous</path>
+         <action>permit</action>
+       </rule>
+     </rule-list>	
+     <rule-list>
+       <name>data-limited</name>
+       <group>limited</group>
+       <rule>
+         <name>allow-get</name>
+         <module-name>ietf-netconf</module-name>
+         <rpc-name>get</rpc-name>
+         <access-operations>exec</access-operations>
+         <action>permit</action>
+       </rule>
+       <rule>
+         <name>allow-wilma</name>
+         <module-name>myexample</module-name>
+         <access-operations>*</access-operations>
+         <path xmlns:ex="urn:example:auth">/ex:top/ex:wilma</path>
+         <action>permit</action>
+       </rule>
+     </rule-list>
+
+     $NADMIN
+
+   </nacm>
+   <top xmlns="urn:example:auth">
+     <anonymous>42</anonymous>
+     <wilma>71</wilma>
+   </top>
+</${DATASTORE_TOP}>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s startup -f $cfg"
+    start_backend -s startup -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "wait restconf"
+    wait_restconf
+fi
+
+MSGWILMA='{"myexample:top":{"wilma":"71"}}'
+# Authentication failed:
+MSGERR1='{"ietf-restconf:errors":{"error":{"error-type":"protocol","error-tag":"access-denied","error-severity":"error","error-message":"The requested URL was unauthorized"}}}'
+# Authentication OK Authorization failed:
+MSGERR2='{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"access-denied","error-severity":"error","error-message":"default deny"}}}'
+
+new "wilma authenticated"
+expectpart "$(curl $CURLOPTS -u wilma:bar -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 200 OK" "$MSGWILMA"
+
+new "wilma authenticated cached"
+expectpart "$(curl $CURLOPTS -u wilma:bar -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 200 OK" "$MSGWILMA"
+
+new "wilma wrong passwd not cached"
+expectpart "$(curl $CURLOPTS -u wilma:wrong -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 401 Unauthorized" "$MSGERR1"
+
+new "no user not cached"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 401 Unauthorized" "$MSGERR1"
+
+new "andy authenticated"
+expectpart "$(curl $CURLOPTS -u andy:bar -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 403 Forbidden" "$MSGERR2"
+
+new "guest authenticated (cache full)"
+expectpart "$(curl $CURLOPTS -u guest:bar -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 403 Forbidden" "$MSGERR2"
+
+new "wilma authenticated after full cache"
+expectpart "$(curl $CURLOPTS -u wilma:bar -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 200 OK" "$MSGWILMA"
+
+new "netconf remove wilma from group limited"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><groups><group><name>limited</name><user-name xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\" nc:operation=\"delete\">wilma</user-name></group></groups></nacm></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "wilma authenticated, not authorized after NACM change"
+expectpart "$(curl $CURLOPTS -u wilma:bar -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 403 Forbidden" "$MSGERR2"
+
+new "wilma wrong passwd after NACM change"
+expectpart "$(curl $CURLOPTS -u wilma:wrong -X GET $RCPROTO://localhost/restconf/data/myexample:top)" 0 "HTTP/1.1 401 Unauthorized" "$MSGERR1"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# unset conditional parameters
+unset RCPROTO
+unset RESTCONFIG
+unset MSGWILMA
+unset MSGERR1
+unset MSGERR2
+
+rm -rf $dir
+
+new "endtest"
+endtest
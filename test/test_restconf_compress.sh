@@ -0,0 +1,174 @@
+#!/usr/bin/env bash
+# Compressed restconf replies, see CLICON_RESTCONF_COMPRESS_LEVEL
+# The content-coding is negotiated with Accept-Encoding. Replies below the threshold,
+# and replies to clients not accepting a coding, are not compressed.
+# Streamed replies, see CLICON_RESTCONF_STREAM_CHUNK, are compressed while sent.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Compression is made by the reverse proxy in fcgi mode
+if [ "${WITH_RESTCONF}" != "native" -o "${WITH_ZLIB}" != yes ]; then
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi # skip
+fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/list.yang
+
+# Number of list entries
+nr=100
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $fyang
+module list{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+# Create list entries, also the expected JSON
+data=""
+for (( i=0; i<$nr; i++ )); do
+    if [ $i -ne 0 ]; then
+	data="$data,"
+    fi
+    # Zero-padded keys so that the entries are sorted in the order they are created
+    b=$(printf "b%03d" $i)
+    data="$data{\"b\":\"$b\",\"v\":$i}"
+done
+
+# Check that a reply is not compressed
+# 1: reply
+function notcompressed()
+{
+    ret=$1
+
+    match=$(echo "$ret" | grep --null -o "Content-Encoding")
+    if [ -n "$match" ]; then
+	err "no Content-Encoding" "$ret"
+    fi
+}
+
+# Run the same tests streamed and not streamed
+# 1: chunk size, 0 is not streamed
+function testrun()
+{
+    chunk=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_RESTCONF_STREAM_CHUNK>$chunk</CLICON_RESTCONF_STREAM_CHUNK>
+  <CLICON_RESTCONF_COMPRESS_LEVEL>6</CLICON_RESTCONF_COMPRESS_LEVEL>
+  <CLICON_RESTCONF_COMPRESS_THRESHOLD>256</CLICON_RESTCONF_COMPRESS_THRESHOLD>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    if [ $RC -ne 0 ]; then
+	new "kill old restconf daemon"
+	stop_restconf_pre
+
+	new "start restconf daemon"
+	start_restconf -f $cfg
+
+	new "waiting"
+	wait_restconf
+    fi
+
+    new "restconf add $nr list entries"
+    expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data -d "{\"list:c\":{\"a\":[$data]}}")" 0 "HTTP/1.1 201 Created"
+
+    new "restconf get gzip chunk:$chunk"
+    expectpart "$(curl $CURLOPTS --compressed -H "Accept-Encoding: gzip" -X GET $RCPROTO://localhost/restconf/data/list:c)" 0 "HTTP/1.1 200 OK" "Content-Encoding: gzip" "Vary: Accept-Encoding" "{\"list:c\":{\"a\":\[$data\]}}"
+
+    new "restconf get deflate preferred chunk:$chunk"
+    expectpart "$(curl $CURLOPTS --compressed -H "Accept-Encoding: gzip;q=0.5, deflate" -X GET $RCPROTO://localhost/restconf/data/list:c)" 0 "HTTP/1.1 200 OK" "Content-Encoding: deflate" "{\"list:c\":{\"a\":\[$data\]}}"
+
+    new "restconf get gzip not acceptable chunk:$chunk"
+    ret=$(curl $CURLOPTS -H "Accept-Encoding: gzip;q=0" -X GET $RCPROTO://localhost/restconf/data/list:c)
+    expectpart "$ret" 0 "HTTP/1.1 200 OK" "{\"list:c\":{\"a\":\[$data\]}}"
+    notcompressed "$ret"
+
+    new "restconf get without Accept-Encoding chunk:$chunk"
+    ret=$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/list:c)
+    expectpart "$ret" 0 "HTTP/1.1 200 OK" "{\"list:c\":{\"a\":\[$data\]}}"
+    notcompressed "$ret"
+
+    new "restconf get below threshold chunk:$chunk"
+    ret=$(curl $CURLOPTS --compressed -H "Accept-Encoding: gzip" -X GET $RCPROTO://localhost/restconf/data/list:c/a=b001)
+    expectpart "$ret" 0 "HTTP/1.1 200 OK" '{"list:a":\[{"b":"b001","v":1}\]}'
+    notcompressed "$ret"
+
+    if [ $RC -ne 0 ]; then
+	new "Kill restconf daemon"
+	stop_restconf
+    fi
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "streamed"
+testrun 256
+
+new "not streamed"
+testrun 0
+
+# Set by restconf_config
+unset RESTCONFIG
+unset nr
+unset b
+unset ret
+unset match
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,138 @@
+#!/usr/bin/env bash
+# Restconf ETag and If-None-Match with change tokens of the running datastore
+# A GET of config data returns an ETag, a GET with the same tag in If-None-Match is
+# replied with 304 Not Modified until running is changed. State data has no ETag.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/etag.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module etag{
+   yang-version 1.1;
+   namespace "urn:example:etag";
+   prefix ex;
+   container c{
+      leaf x{
+         type int32;
+      }
+   }
+   container s{
+      config false;
+      leaf y{
+         type int32;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "waiting"
+    wait_restconf
+fi
+
+new "netconf datastore-token"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><datastore-token xmlns=\"http://clicon.org/lib\"><datastore>running</datastore></datastore-token></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><token xmlns=\"http://clicon.org/lib\">[0-9a-f]*-[0-9a-f]*</token><modified xmlns=\"http://clicon.org/lib\">[0-9]*</modified></rpc-reply>]]>]]>$"
+
+new "restconf add config"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data -d '{"etag:c":{"x":1}}')" 0 "HTTP/1.1 201 Created"
+
+new "restconf get config with ETag"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/etag:c)" 0 "HTTP/1.1 200 OK" "ETag: \"" "Last-Modified: " '{"etag:c":{"x":1}}'
+
+etag=$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/etag:c | grep -i "^ETag:" | awk '{print $2}' | tr -d '\r')
+
+new "restconf get with If-None-Match not modified"
+expectpart "$(curl $CURLOPTS -X GET -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/etag:c)" 0 "HTTP/1.1 304 Not Modified" "ETag: $etag"
+
+new "restconf get with If-None-Match list not modified"
+expectpart "$(curl $CURLOPTS -X GET -H "If-None-Match: \"x\", W/$etag" $RCPROTO://localhost/restconf/data/etag:c)" 0 "HTTP/1.1 304 Not Modified"
+
+new "restconf get with other If-None-Match"
+expectpart "$(curl $CURLOPTS -X GET -H "If-None-Match: \"x\"" $RCPROTO://localhost/restconf/data/etag:c)" 0 "HTTP/1.1 200 OK" "ETag: $etag" '{"etag:c":{"x":1}}'
+
+new "restconf change config"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/etag:c/x -d '{"etag:x":2}')" 0 "HTTP/1.1 204 No Content"
+
+new "restconf get with old If-None-Match modified"
+ret=$(curl $CURLOPTS -X GET -H "If-None-Match: $etag" $RCPROTO://localhost/restconf/data/etag:c)
+expectpart "$ret" 0 "HTTP/1.1 200 OK" '{"etag:c":{"x":2}}'
+match=$(echo "$ret" | grep -i "^ETag: $etag")
+if [ -n "$match" ]; then
+    err "New ETag" "$match"
+fi
+
+new "restconf get state has no ETag"
+ret=$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/etag:s)
+match=$(echo "$ret" | grep -i "^ETag:")
+if [ -n "$match" ]; then
+    err "No ETag" "$match"
+fi
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+unset etag
+unset match
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,150 @@
+#!/usr/bin/env bash
+# Restconf list pagination with limit and offset query parameters
+# The parameters are sent to the backend as get offset and limit attributes, first check
+# the attributes in netconf, then restconf pages of a list with config and all content
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/list.yang
+
+# Number of list entries
+nr=7
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module list{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+# Create list entries
+data=""
+for (( i=0; i<$nr; i++ )); do
+    if [ $i -ne 0 ]; then
+	data="$data,"
+    fi
+    data="$data{\"b\":\"$i\",\"v\":$i}"
+done
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "waiting"
+    wait_restconf
+fi
+
+new "restconf add $nr list entries"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data -d "{\"list:c\":{\"a\":[$data]}}")" 0 "HTTP/1.1 201 Created"
+
+new "netconf get config offset 2 limit 3"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get content=\"config\" offset=\"2\" limit=\"3\"><filter type=\"xpath\" select=\"/ex:c/ex:a\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>2</b><v>2</v></a><a><b>3</b><v>3</v></a><a><b>4</b><v>4</v></a></c></data></rpc-reply>]]>]]>$"
+
+new "netconf get all offset 5 limit 3"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get offset=\"5\" limit=\"3\"><filter type=\"xpath\" select=\"/ex:c/ex:a\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>5</b><v>5</v></a><a><b>6</b><v>6</v></a></c></data></rpc-reply>]]>]]>$"
+
+new "netconf get invalid limit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get limit=\"x\"/></rpc>]]>]]>" "<error-tag>bad-attribute</error-tag>"
+
+new "netconf get config api-path"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get content=\"config\" api-path=\"/list:c/a=3\"><filter type=\"xpath\" select=\"/ex:c/ex:a[ex:b='3']\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:clixon\"><a><b>3</b><v>3</v></a></c></data></rpc-reply>]]>]]>$"
+
+new "netconf get config api-path not found"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get content=\"config\" api-path=\"/list:c/a=99\"><filter type=\"xpath\" select=\"/ex:c/ex:a[ex:b='99']\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+
+new "restconf get config list entry"
+expectpart "$(curl $CURLOPTS -X GET "$RCPROTO://localhost/restconf/data/list:c/a=3?content=config")" 0 "HTTP/1.1 200 OK" '{"list:a":\[{"b":"3","v":3}\]}'
+
+new "restconf get config page offset 2 limit 3"
+expectpart "$(curl $CURLOPTS -X GET "$RCPROTO://localhost/restconf/data/list:c/a?content=config&offset=2&limit=3")" 0 "HTTP/1.1 200 OK" '{"list:a":\[{"b":"2","v":2},{"b":"3","v":3},{"b":"4","v":4}\]}'
+
+new "restconf get all page offset 5 limit 3"
+expectpart "$(curl $CURLOPTS -X GET "$RCPROTO://localhost/restconf/data/list:c/a?offset=5&limit=3")" 0 "HTTP/1.1 200 OK" '{"list:a":\[{"b":"5","v":5},{"b":"6","v":6}\]}'
+
+new "restconf get first page limit 2"
+expectpart "$(curl $CURLOPTS -X GET "$RCPROTO://localhost/restconf/data/list:c/a?content=config&limit=2")" 0 "HTTP/1.1 200 OK" '{"list:a":\[{"b":"0","v":0},{"b":"1","v":1}\]}'
+
+new "restconf get offset only"
+expectpart "$(curl $CURLOPTS -X GET "$RCPROTO://localhost/restconf/data/list:c/a?content=config&offset=6")" 0 "HTTP/1.1 200 OK" '{"list:a":\[{"b":"6","v":6}\]}'
+
+new "restconf get config data root xml"
+expectpart "$(curl $CURLOPTS -X GET -H "Accept: application/yang-data+xml" "$RCPROTO://localhost/restconf/data?content=config")" 0 "HTTP/1.1 200 OK" "Content-Type: application/yang-data+xml" '<data><c xmlns="urn:example:clixon"><a><b>0</b><v>0</v></a><a><b>1</b><v>1</v></a>'
+
+new "restconf get invalid limit 0"
+expectpart "$(curl $CURLOPTS -X GET "$RCPROTO://localhost/restconf/data/list:c/a?limit=0")" 0 "HTTP/1.1 400 Bad Request" "bad-attribute"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+unset nr
+
+rm -rf $dir
+
+new "endtest"
+endtest
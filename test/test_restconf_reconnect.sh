@@ -0,0 +1,113 @@
+#!/usr/bin/env bash
+# Restconf reconnect of the cached backend socket
+# The backend is restarted while restconf is running, the first request after the
+# restart reconnects to the backend instead of failing on the closed socket.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/reconnect.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module reconnect{
+   yang-version 1.1;
+   namespace "urn:example:reconnect";
+   prefix ex;
+   container c{
+      leaf x{
+         type int32;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "waiting"
+    wait_restconf
+fi
+
+new "restconf add config"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data -d '{"reconnect:c":{"x":1}}')" 0 "HTTP/1.1 201 Created"
+
+new "restconf get config"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/reconnect:c)" 0 "HTTP/1.1 200 OK" '{"reconnect:c":{"x":1}}'
+
+if [ $BE -ne 0 ]; then
+    new "restart backend -s running -f $cfg"
+    stop_backend -f $cfg
+    start_backend -s running -f $cfg
+
+    new "waiting"
+    wait_backend
+
+    new "restconf get config after backend restart"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/reconnect:c)" 0 "HTTP/1.1 200 OK" '{"reconnect:c":{"x":1}}'
+
+    new "restconf change config after backend restart"
+    expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data/reconnect:c/x -d '{"reconnect:x":2}')" 0 "HTTP/1.1 204 No Content"
+fi
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,152 @@
+#!/usr/bin/env bash
+# Streamed restconf GET replies in JSON, see CLICON_RESTCONF_STREAM_CHUNK
+# A list is read with a small chunk size, so that the JSON is sent in several chunks,
+# and with streaming disabled. Check that the JSON is the same.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/list.yang
+
+# Number of list entries
+nr=20
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $fyang
+module list{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+# Create list entries and expected JSON
+data=""
+json=""
+for (( i=0; i<$nr; i++ )); do
+    if [ $i -ne 0 ]; then
+	data="$data,"
+	json="$json,"
+    fi
+    # Zero-padded keys so that the entries are sorted in the order they are created
+    b=$(printf "b%02d" $i)
+    data="$data{\"b\":\"$b\",\"v\":$i}"
+    json="$json{\"b\":\"$b\",\"v\":$i}"
+done
+
+# Run the same tests streamed and not streamed
+# 1: chunk size, 0 is not streamed
+function testrun()
+{
+    chunk=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_RESTCONF_STREAM_CHUNK>$chunk</CLICON_RESTCONF_STREAM_CHUNK>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    if [ $RC -ne 0 ]; then
+	new "kill old restconf daemon"
+	stop_restconf_pre
+
+	new "start restconf daemon"
+	start_restconf -f $cfg
+
+	new "waiting"
+	wait_restconf
+    fi
+
+    new "restconf add $nr list entries"
+    expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data -d "{\"list:c\":{\"a\":[$data]}}")" 0 "HTTP/1.1 201 Created"
+
+    if [ $chunk -eq 0 ]; then
+	encoding="Content-Length:"
+    elif [ "${WITH_RESTCONF}" = "native" ]; then
+	encoding="Transfer-Encoding: chunked"
+    else # Encoding by reverse proxy
+	encoding="HTTP/1.1 200 OK"
+    fi
+
+    new "restconf get container chunk:$chunk"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/list:c)" 0 "HTTP/1.1 200 OK" "$encoding" "{\"list:c\":{\"a\":\[$json\]}}"
+
+    # A list without keys is only a target when paging, see test_restconf_pagination.sh
+    new "restconf get list chunk:$chunk"
+    expectpart "$(curl $CURLOPTS -X GET "$RCPROTO://localhost/restconf/data/list:c/a?offset=0")" 0 "HTTP/1.1 200 OK" "$encoding" "{\"list:a\":\[$json\]}"
+
+    new "restconf get list entry chunk:$chunk"
+    expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/list:c/a=b01)" 0 "HTTP/1.1 200 OK" "Content-Length:" '{"list:a":\[{"b":"b01","v":1}\]}'
+
+    if [ $RC -ne 0 ]; then
+	new "Kill restconf daemon"
+	stop_restconf
+    fi
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "streamed"
+testrun 64
+
+new "not streamed"
+testrun 0
+
+# Set by restconf_config
+unset RESTCONFIG
+unset nr
+unset b
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,135 @@
+#!/usr/bin/env bash
+# Restconf POST, PUT and PATCH with XML bodies that are forwarded to the backend as is
+# Check bodies with xml declaration, comments, prefixes and inherited namespaces, and
+# that bodies with insert attributes (not forwarded) also work.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/body.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module body{
+   yang-version 1.1;
+   namespace "urn:example:body";
+   prefix ex;
+   container c{
+      leaf x{
+         type int32;
+      }
+      list a{
+         key "k";
+         ordered-by user;
+         leaf k{
+            type string;
+         }
+         leaf v{
+            type string;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "waiting"
+    wait_restconf
+fi
+
+new "restconf post xml with declaration and comment"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data -d '<?xml version="1.0" encoding="UTF-8"?><!-- top --><c xmlns="urn:example:body"><x>1</x></c>')" 0 "HTTP/1.1 201 Created" "Location: $RCPROTO://localhost/restconf/data/body:c"
+
+new "restconf post xml again is conflict"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data -d '<c xmlns="urn:example:body"/>')" 0 "HTTP/1.1 409 Conflict"
+
+new "restconf post xml list entry with inherited namespace"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data/body:c -d '<a><k>b</k><v>1 &amp; 2</v></a>')" 0 "HTTP/1.1 201 Created" "Location: $RCPROTO://localhost/restconf/data/body:c/a=b"
+
+new "restconf post xml list entry with prefix"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data/body:c -d '<ex:a xmlns:ex="urn:example:body"><ex:k>c</ex:k></ex:a>')" 0 "HTTP/1.1 201 Created"
+
+new "restconf post xml list entry with insert first"
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+xml" "$RCPROTO://localhost/restconf/data/body:c?insert=first" -d '<a xmlns="urn:example:body"><k>a</k></a>')" 0 "HTTP/1.1 201 Created"
+
+new "restconf put xml leaf"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data/body:c/x -d '<x xmlns="urn:example:body">2</x>')" 0 "HTTP/1.1 204 No Content"
+
+new "restconf put xml new list entry"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data/body:c/a=d -d '<a xmlns="urn:example:body"><k>d</k><v>x</v></a>')" 0 "HTTP/1.1 201 Created"
+
+new "restconf put xml list entry with other key"
+expectpart "$(curl $CURLOPTS -X PUT -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data/body:c/a=d -d '<a xmlns="urn:example:body"><k>e</k></a>')" 0 "HTTP/1.1 412 Precondition Failed"
+
+new "restconf patch xml list entry"
+expectpart "$(curl $CURLOPTS -X PATCH -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data/body:c/a=d -d '<a xmlns="urn:example:body"><k>d</k><v>y</v></a>')" 0 "HTTP/1.1 204 No Content"
+
+new "restconf patch xml non-existing list entry"
+expectpart "$(curl $CURLOPTS -X PATCH -H "Content-Type: application/yang-data+xml" $RCPROTO://localhost/restconf/data/body:c/a=f -d '<a xmlns="urn:example:body"><k>f</k></a>')" 0 "HTTP/1.1 409 Conflict" "If the target resource instance does not exist, the server MUST NOT create it"
+
+new "restconf get config"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/body:c)" 0 "HTTP/1.1 200 OK" '{"body:c":{"x":2,"a":\[{"k":"a"},{"k":"b","v":"1 & 2"},{"k":"c"},{"k":"d","v":"y"}\]}}'
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+# Restconf YANG patch (RFC 8072) with many edits in one transaction
+# A yang-patch in JSON and XML is applied with create, merge, insert, move and delete
+# edits. If one edit fails, no edit is applied and the failed edit is reported.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/patch.yang
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module patch{
+   yang-version 1.1;
+   namespace "urn:example:patch";
+   prefix ex;
+   container c{
+      list a{
+         key k;
+         ordered-by user;
+         leaf k{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "waiting"
+    wait_restconf
+fi
+
+new "restconf yang-patch json create and merge"
+expectpart "$(curl $CURLOPTS -X PATCH -H "Content-Type: application/yang-patch+json" -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/patch:c -d '{"ietf-yang-patch:yang-patch":{"patch-id":"p1","edit":[{"edit-id":"e1","operation":"create","target":"/a=x","value":{"patch:a":[{"k":"x","v":1}]}},{"edit-id":"e2","operation":"create","target":"/a=y","value":{"patch:a":[{"k":"y","v":2}]}},{"edit-id":"e3","operation":"merge","target":"/a=x","value":{"patch:a":[{"k":"x","v":3}]}}]}}')" 0 "HTTP/1.1 200 OK" '{"ietf-yang-patch:yang-patch-status":{"patch-id":"p1","ok":'
+
+new "restconf get after yang-patch"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/patch:c)" 0 "HTTP/1.1 200 OK" '{"patch:c":{"a":\[{"k":"x","v":3},{"k":"y","v":2}\]}}'
+
+new "restconf yang-patch json failed edit"
+expectpart "$(curl $CURLOPTS -X PATCH -H "Content-Type: application/yang-patch+json" -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/patch:c -d '{"ietf-yang-patch:yang-patch":{"patch-id":"p2","edit":[{"edit-id":"e1","operation":"merge","target":"/a=y","value":{"patch:a":[{"k":"y","v":5}]}},{"edit-id":"e2","operation":"create","target":"/a=x","value":{"patch:a":[{"k":"x","v":4}]}}]}}')" 0 "HTTP/1.1 409 Conflict" '{"ietf-yang-patch:yang-patch-status":{"patch-id":"p2","edit-status":{"edit":{"edit-id":"e2","errors":{"error":' '"error-tag":"data-exists"'
+
+new "restconf no edit applied after failed yang-patch"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/patch:c)" 0 "HTTP/1.1 200 OK" '{"patch:c":{"a":\[{"k":"x","v":3},{"k":"y","v":2}\]}}'
+
+new "restconf yang-patch json keys do not match"
+expectpart "$(curl $CURLOPTS -X PATCH -H "Content-Type: application/yang-patch+json" -H "Accept: application/yang-data+json" $RCPROTO://localhost/restconf/data/patch:c -d '{"ietf-yang-patch:yang-patch":{"patch-id":"p3","edit":[{"edit-id":"e1","operation":"replace","target":"/a=x","value":{"patch:a":[{"k":"z","v":1}]}}]}}')" 0 "HTTP/1.1 412 Precondition Failed" '"edit-id":"e1"' "edit target keys do not match data keys"
+
+new "restconf yang-patch xml insert first and move last"
+expectpart "$(curl $CURLOPTS -X PATCH -H "Content-Type: application/yang-patch+xml" -H "Accept: application/yang-data+xml" $RCPROTO://localhost/restconf/data/patch:c -d '<yang-patch xmlns="urn:ietf:params:xml:ns:yang:ietf-yang-patch"><patch-id>p4</patch-id><edit><edit-id>e1</edit-id><operation>insert</operation><target>/a=z</target><where>first</where><value><a xmlns="urn:example:patch"><k>z</k><v>9</v></a></value></edit><edit><edit-id>e2</edit-id><operation>move</operation><target>/a=x</target><where>after</where><point>/a=y</point></edit></yang-patch>')" 0 "HTTP/1.1 200 OK" '<yang-patch-status xmlns="urn:ietf:params:xml:ns:yang:ietf-yang-patch"><patch-id>p4</patch-id><ok/></yang-patch-status>'
+
+new "restconf get after insert and move"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/patch:c)" 0 "HTTP/1.1 200 OK" '{"patch:c":{"a":\[{"k":"z","v":9},{"k":"y","v":2},{"k":"x","v":3}\]}}'
+
+new "restconf yang-patch xml delete and remove"
+expectpart "$(curl $CURLOPTS -X PATCH -H "Content-Type: application/yang-patch+xml" -H "Accept: application/yang-data+xml" $RCPROTO://localhost/restconf/data/patch:c -d '<yang-patch xmlns="urn:ietf:params:xml:ns:yang:ietf-yang-patch"><patch-id>p5</patch-id><edit><edit-id>e1</edit-id><operation>delete</operation><target>/a=z</target></edit><edit><edit-id>e2</edit-id><operation>remove</operation><target>/a=w</target></edit></yang-patch>')" 0 "HTTP/1.1 200 OK" "<ok/>"
+
+new "restconf get after delete"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/patch:c)" 0 "HTTP/1.1 200 OK" '{"patch:c":{"a":\[{"k":"y","v":2},{"k":"x","v":3}\]}}'
+
+new "restconf yang-patch without patch-id"
+expectpart "$(curl $CURLOPTS -X PATCH -H "Content-Type: application/yang-patch+json" $RCPROTO://localhost/restconf/data/patch:c -d '{"ietf-yang-patch:yang-patch":{"comment":"none"}}')" 0 "HTTP/1.1 400 Bad Request" "malformed-message"
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+
+rm -rf $dir
+
+new "endtest"
+endtest
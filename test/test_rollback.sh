@@ -0,0 +1,171 @@
+#!/usr/bin/env bash
+# Rollback of commits, see rollback in clixon-lib.yang and CLICON_COMMIT_ROLLBACK
+# Make N commits, roll back to each of them and commit, the number of commits kept,
+# and roll back after a restart from the reverse change files rollback_<id>.xml
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/rollback.yang
+
+# Number of commits kept
+N=3
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_COMMIT_ROLLBACK>$N</CLICON_COMMIT_ROLLBACK>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module rollback{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container c{
+      list a{
+         key "b";
+         leaf b{
+            type string;
+         }
+         leaf v{
+            type int32;
+         }
+      }
+   }
+}
+EOF
+
+# Running after commit $1: entries b1..b$1 with value $1
+function data(){
+    echo -n "<data>"
+    if [ $1 -gt 0 ]; then
+	echo -n "<c xmlns=\"urn:example:clixon\">"
+	for (( j=1; j<=$1; j++ )); do
+	    echo -n "<a><b>b$j</b><v>$1</v></a>"
+	done
+	echo -n "</c>"
+    fi
+    echo -n "</data>"
+}
+
+# Commit $1: add entry b$1 and set all values to $1
+function commit(){
+    echo -n "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:clixon\">"
+    for (( j=1; j<=$1; j++ )); do
+	echo -n "<a><b>b$j</b><v>$1</v></a>"
+    done
+    echo -n "</c></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>"
+}
+
+# Rollback commit $1
+function rollback(){
+    echo -n "<rpc $DEFAULTNS><rollback xmlns=\"http://clicon.org/lib\"><id>$1</id></rollback></rpc>]]>]]>"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "rollback without commits"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(rollback 0)" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>invalid-value</error-tag>.*No commit 0 to roll back"
+
+# One more commit than kept
+M=$((N+1))
+for (( i=1; i<=$M; i++ )); do
+    new "commit $i"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(commit $i)" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+done
+
+new "running after $M commits"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS>$(data $M)</rpc-reply>]]>]]>$"
+
+# Rollback id is running before commit M-id
+for (( id=0; id<$N; id++ )); do
+    new "rollback $id is running of commit $((M-id-1))"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(rollback $id)<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]><rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS>$(data $((M-id-1)))</rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+done
+
+new "rollback $N is not kept"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(rollback $N)" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>invalid-value</error-tag>.*No commit $N to roll back"
+
+new "reverse change files are bounded by $N"
+expectpart "$(ls $dir)" 0 "rollback_0.xml" "rollback_$((N-1)).xml" --not-- "rollback_$N.xml"
+
+new "candidate is running after discard"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS>$(data $M)</rpc-reply>]]>]]>$"
+
+new "rollback 1 and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(rollback 1)<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "running is rolled back to commit $((M-2))"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS>$(data $((M-2)))</rpc-reply>]]>]]>$"
+
+new "rollback of the rollback is running of commit $M"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(rollback 0)<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]><rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS>$(data $M)</rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    stop_backend -f $cfg
+
+    # Running is kept, the snapshots are not: rollback is made from files
+    new "restart backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "running after restart"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS>$(data $((M-2)))</rpc-reply>]]>]]>$"
+
+new "rollback 0 from file is running of commit $M"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(rollback 0)<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]><rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS>$(data $M)</rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "rollback 1 from files and commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO$(rollback 1)<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+# Rollback 0 undoes the rollback commit, 1 undoes commit M
+new "running is rolled back to commit $((M-1))"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS>$(data $((M-1)))</rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
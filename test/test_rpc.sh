@@ -126,7 +126,7 @@ if [ -z "$match" ]; then
 fi
 
 new "restconf omit mandatory"
-expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"clixon-example:input":null}' $RCPROTO://localhost/restconf/operations/clixon-example:example)" 0 'HTTP/1.1 400 Bad Request' '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"missing-element","error-info":{"bad-element":"x"},"error-severity":"error","error-message":"Mandatory variable of example in module clixon-example"}}}'
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"clixon-example:input":null}' $RCPROTO://localhost/restconf/operations/clixon-example:example)" 0 'HTTP/1.1 400 Bad Request' '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"missing-element","error-info":{"bad-element":"x"},"error-severity":"error","error-message":"Mandatory variable of example in module clixon-example"}}}'
 
 new "restconf add extra w/o yang: should fail"
 if ! $YANG_UNKNOWN_ANYDATA ; then
@@ -134,10 +134,10 @@ expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+jso
 fi
 
 new "restconf wrong method"
-expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"clixon-example:input":{"x":"0"}}' $RCPROTO://localhost/restconf/operations/clixon-example:wrong)" 0 'HTTP/1.1 400 Bad Request' '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"missing-element","error-info":{"bad-element":"wrong"},"error-severity":"error","error-message":"RPC not defined"}}}'
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"clixon-example:input":{"x":"0"}}' $RCPROTO://localhost/restconf/operations/clixon-example:wrong)" 0 'HTTP/1.1 400 Bad Request' '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"missing-element","error-info":{"bad-element":"wrong"},"error-severity":"error","error-message":"RPC not defined"}}}'
 
 new "restconf example missing input"
-expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"clixon-example:input":null}' $RCPROTO://localhost/restconf/operations/ietf-netconf:edit-config)" 0 'HTTP/1.1 400 Bad Request' '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"missing-element","error-info":{"bad-element":"target"},"error-severity":"error","error-message":"Mandatory variable of edit-config in module ietf-netconf"}}}'
+expectpart "$(curl $CURLOPTS -X POST -H "Content-Type: application/yang-data+json" -d '{"clixon-example:input":null}' $RCPROTO://localhost/restconf/operations/ietf-netconf:edit-config)" 0 'HTTP/1.1 400 Bad Request' '{"ietf-restconf:errors":{"error":{"error-type":"application","error-tag":"missing-element","error-info":{"bad-element":"target"},"error-severity":"error","error-message":"Mandatory variable of edit-config in module ietf-netconf"}}}'
 
 new "netconf kill-session missing session-id mandatory"
 expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><kill-session/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>missing-element</error-tag><error-info><bad-element>session-id</bad-element></error-info><error-severity>error</error-severity><error-message>Mandatory variable of kill-session in module ietf-netconf</error-message></rpc-error></rpc-reply>]]>]]>$"
@@ -201,6 +201,53 @@ LIST='<u1 xmlns="urn:example:clixon"><uk>bar</uk><val>1</val></u1><u1 xmlns="urn
 new "netconf example rpc input list with non-unique keys (should fail)"
 expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><example xmlns=\"urn:example:clixon\"><x>mandatory</x>$LIST</example></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-app-tag>data-not-unique</error-app-tag><error-severity>error</error-severity><error-info><non-unique><uk>bar</uk></non-unique></error-info></rpc-error></rpc-reply>]]>]]>$"
 
+new "netconf stats with event callback statistics"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<event><name>server socket</name><calls>[0-9]*</calls><time-total>[0-9]*</time-total><time-max>[0-9]*</time-max></event>"
+
+new "netconf stats with memory statistics"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<memory><name>yang</name><nr>[1-9][0-9]*</nr><size>[1-9][0-9]*</size></memory><memory><name>config-yang</name><nr>[1-9][0-9]*</nr><size>[1-9][0-9]*</size></memory><memory><name>nacm</name><nr>[0-9]*</nr><size>[0-9]*</size></memory><memory><name>stream-replay</name><nr>[0-9]*</nr><size>[0-9]*</size></memory>"
+
+new "netconf commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf stats with commit phase statistics"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<commit-phase><name>diff</name><calls>[1-9][0-9]*</calls><time-total>[0-9]*</time-total><time-max>[0-9]*</time-max><histogram><le>100</le><count>[0-9]*</count></histogram>.*<commit-phase><name>total</name><calls>[1-9][0-9]*</calls>"
+
+new "netconf stats with transaction memory"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<transaction-memory><transactions>[1-9][0-9]*</transactions><last><src-nodes>[0-9]*</src-nodes><target-nodes>[1-9][0-9]*</target-nodes><deleted>[0-9]*</deleted><added>[0-9]*</added><changed>[0-9]*</changed><rss-delta>[-0-9]*</rss-delta><maxrss-delta>[0-9]*</maxrss-delta></last><max>"
+
+new "netconf stats with accept statistics"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<accept><events>[1-9][0-9]*</events><clients>[1-9][0-9]*</clients><batch-max>[1-9][0-9]*</batch-max><errors>[0-9]*</errors><time-total>[0-9]*</time-total><time-max>[0-9]*</time-max><cred-total>[0-9]*</cred-total><cred-max>[0-9]*</cred-max></accept></rpc-reply>"
+
+new "netconf xpath-profile"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><xpath-profile xmlns=\"http://clicon.org/lib\"><xpath>/</xpath></xpath-profile></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><nodes xmlns=\"http://clicon.org/lib\">[0-9]*</nodes><profile xmlns=\"http://clicon.org/lib\">expr:.* \[evals:1 visits:0 preds:0 opt-hit:0 opt-miss:0 usec:[0-9]*\]"
+
+new "netconf xpath-profile invalid xpath"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><xpath-profile xmlns=\"http://clicon.org/lib\"><xpath>/a[</xpath></xpath-profile></rpc>]]>]]>" "<error-tag>invalid-value</error-tag>"
+
+new "netconf sample start"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><sample xmlns=\"http://clicon.org/lib\"><operation>start</operation><file>$dir/sample.folded</file><frequency>997</frequency></sample></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><active xmlns=\"http://clicon.org/lib\">true</active>"
+
+new "netconf sample start when sampling"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><sample xmlns=\"http://clicon.org/lib\"><operation>start</operation></sample></rpc>]]>]]>" "<error-tag>operation-failed</error-tag>"
+
+new "netconf get while sampling"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>"
+
+new "netconf sample stop"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><sample xmlns=\"http://clicon.org/lib\"><operation>stop</operation></sample></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><active xmlns=\"http://clicon.org/lib\">false</active><samples xmlns=\"http://clicon.org/lib\">[0-9]*</samples><dropped xmlns=\"http://clicon.org/lib\">0</dropped><file xmlns=\"http://clicon.org/lib\">$dir/sample.folded</file></rpc-reply>]]>]]>$"
+
+new "sample file written"
+if [ ! -f $dir/sample.folded ]; then
+    err "$dir/sample.folded" "No file"
+fi
+
+new "netconf sample of unknown process"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><sample xmlns=\"http://clicon.org/lib\"><operation>start</operation><process>nonexistent</process></sample></rpc>]]>]]>" "<error-tag>invalid-value</error-tag>"
+
+new "netconf stats with rpc statistics"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<rpc><name>commit</name><calls>[1-9][0-9]*</calls><time-total>[0-9]*</time-total><time-max>[0-9]*</time-max><histogram><le>100</le><count>[0-9]*</count></histogram>.*<histogram><le>inf</le><count>[0-9]*</count></histogram><wait-total>[0-9]*</wait-total><wait-max>[0-9]*</wait-max><bytes-in>[1-9][0-9]*</bytes-in><bytes-out>[1-9][0-9]*</bytes-out></rpc>"
+
 if [ $RC -ne 0 ]; then
     new "Kill restconf daemon"
     stop_restconf 
@@ -0,0 +1,87 @@
+#!/usr/bin/env bash
+# Asynchronous RPC of a backend plugin, see rpc_async_start
+# Uses the async rpc of the main example, which replies after a delay.
+# Check that other clients are served while the reply is pending, and that
+# a client closing its session before the reply cancels the rpc.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fout=$dir/async.out
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "async rpc no delay"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><async xmlns=\"urn:example:clixon\"><x>42</x></async></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><x xmlns=\"urn:example:clixon\">42</x></rpc-reply>]]>]]>$"
+
+new "async rpc with delay in background"
+echo "$DEFAULTHELLO<rpc $DEFAULTNS><async xmlns=\"urn:example:clixon\"><x>99</x><delay>2000</delay></async></rpc>]]>]]>" | $clixon_netconf -qf $cfg > $fout &
+pid=$!
+sleep 0.5
+
+new "other client served while async reply pending"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><empty xmlns=\"urn:example:clixon\"/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "async rpc still pending"
+if ! kill -0 $pid 2> /dev/null; then
+    err "async rpc pending" "async rpc done"
+fi
+
+new "wait for async reply"
+wait $pid
+match=$(grep "<x xmlns=\"urn:example:clixon\">99</x>" $fout)
+if [ -z "$match" ]; then
+    err "<x xmlns=\"urn:example:clixon\">99</x>" "$(cat $fout)"
+fi
+
+new "async rpc client closes before reply"
+echo "$DEFAULTHELLO<rpc $DEFAULTNS><async xmlns=\"urn:example:clixon\"><x>1</x><delay>3000</delay></async></rpc>]]>]]>" | timeout 1 $clixon_netconf -qf $cfg > /dev/null
+
+new "backend alive after cancelled async rpc"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><async xmlns=\"urn:example:clixon\"><x>2</x><delay>100</delay></async></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><x xmlns=\"urn:example:clixon\">2</x></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
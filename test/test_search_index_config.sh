@@ -0,0 +1,118 @@
+#!/usr/bin/env bash
+# Test explicit search index given in config with CLICON_YANG_SEARCH_INDEX
+# Same as the search_index extension but without modifying the YANG module
+# Search using xpath on a non-key leaf, also after the leaf is changed and list entries
+# are added and removed.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/moda.yang
+
+# Number of list entries
+: ${nr:=100}
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_SEARCH_INDEX>/a:x1/a:y/a:i</CLICON_YANG_SEARCH_INDEX>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module moda{
+  namespace "urn:example:a";
+  prefix a;
+  container x1{
+    list y{
+      key k1;
+      leaf k1{
+        type string;
+      }
+      leaf i{
+        description "search index variable given in config";
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "generate config with $nr list entries, index i in reverse order"
+str="<x1 xmlns=\"urn:example:a\">"
+for (( i=0; i<$nr; i++ )); do
+    let ii=$nr-$i-1
+    str+="<y><k1>a$i</k1><i>$ii</i></y>"
+done
+str+="</x1>"
+
+new "netconf edit-config"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$str</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config i=7"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='7']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x1 xmlns=\"urn:example:a\"><y><k1>a92</k1><i>7</i></y></x1></data></rpc-reply>]]>]]>$"
+
+new "netconf change i of a92 to 1000"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y><k1>a92</k1><i>1000</i></y></x1></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config old value i=7"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='7']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+
+new "netconf get-config new value i=1000"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='1000']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x1 xmlns=\"urn:example:a\"><y><k1>a92</k1><i>1000</i></y></x1></data></rpc-reply>]]>]]>$"
+
+new "netconf add entry b with i=7"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y><k1>b</k1><i>7</i></y></x1></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config i=7 added entry"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='7']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x1 xmlns=\"urn:example:a\"><y><k1>b</k1><i>7</i></y></x1></data></rpc-reply>]]>]]>$"
+
+new "netconf add entry c with same i=7"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y><k1>c</k1><i>7</i></y></x1></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf delete entry b"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x1 xmlns=\"urn:example:a\"><y nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><k1>b</k1></y></x1></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get-config i=7 remaining entry c"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x1/a:y[a:i='7']\" xmlns:a=\"urn:example:a\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x1 xmlns=\"urn:example:a\"><y><k1>c</k1><i>7</i></y></x1></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+unset nr
+
+new "endtest"
+endtest
@@ -69,6 +69,28 @@ EOF
     new "hello session-id 2"
     expecteof "$clixon_util_socket -a $family -s $sock -D $DBG" 0 "<hello $DEFAULTNS/>" "<hello $DEFAULTNS><session-id>4</session-id></hello>"
 
+    # Replies are in order of requests also if sent without waiting for replies
+    new "pipelined requests on one session"
+    expecteof "$clixon_util_socket -a $family -s $sock -D $DBG -P" 0 "<hello $DEFAULTNS message-id=\"1\"/><rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc><hello $DEFAULTNS message-id=\"3\"/>" "^<hello $DEFAULTNS message-id=\"1\"><session-id>[0-9]*</session-id></hello><rpc-reply $DEFAULTNS><data/></rpc-reply><hello $DEFAULTNS message-id=\"3\"><session-id>[0-9]*</session-id></hello>$"
+
+    # A client stalled in the middle of a message does not block other clients
+    new "split message, stall 2s"
+    $clixon_util_socket -a $family -s $sock -D $DBG -S 2000 > $dir/split.out <<EOF &
+<hello $DEFAULTNS message-id="7"/>
+EOF
+    pid=$!
+    sleep 0.5
+
+    new "other client served while message is split"
+    expecteof "timeout 1 $clixon_util_socket -a $family -s $sock -D $DBG" 0 "<hello $DEFAULTNS/>" "^<hello $DEFAULTNS><session-id>[0-9]*</session-id></hello>$"
+
+    new "split message reply"
+    wait $pid
+    if [ $? -ne 0 ]; then
+	err "split message reply" "$(cat $dir/split.out)"
+    fi
+    expectpart "$(cat $dir/split.out)" 0 "^<hello $DEFAULTNS message-id=\"7\"><session-id>[0-9]*</session-id></hello>$"
+
     if [ $BE -ne 0 ]; then
 	new "Kill backend"
 	# Check if premature kill
@@ -94,6 +116,7 @@ rm -rf $dir
 
 # unset conditional parameters 
 unset clixon_util_socket
+unset pid
 
 new "endtest"
 endtest
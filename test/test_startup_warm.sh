@@ -0,0 +1,125 @@
+#!/usr/bin/env bash
+# Warm restart of the backend, see CLICON_STARTUP_WARM
+# The test uses the two example backend plugins (main and nacm) that log transaction
+# and resync callbacks with -- -t
+# 1. A first start in running mode makes a full (cold) startup and commits running
+# 2. A restart with running unchanged keeps running: only resync callbacks are called
+# 3. After a commit, running has changed and a restart is cold again
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/warm.yang
+flog=$dir/backend.log
+
+cat <<EOF > $fyang
+module warm{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container table{
+      list parameter{
+         key name;
+	 leaf name{
+	    type string;
+	 }
+	 leaf value{
+	    type string;
+	 }
+      }
+   }
+}
+EOF
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_STARTUP_WARM>true</CLICON_STARTUP_WARM>
+</clixon-config>
+EOF
+
+DATA="<table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter></table>"
+
+# Start backend in running mode with an empty log
+# arg1: cold or warm
+function restart(){
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	rm -f $flog
+	new "start backend -s running -f $cfg -l f$flog -- -t ($1)"
+	start_backend -s running -f $cfg -l f$flog -- -t
+    fi
+    new "waiting"
+    wait_backend
+}
+
+cat <<EOF > $dir/running_db
+<config>$DATA</config>
+EOF
+
+new "test params: -f $cfg"
+
+restart cold
+
+new "first start is cold: running is committed"
+expectpart "$(cat $flog)" 0 "main_validate" "main_commit" "nacm_commit" --not-- "main_resync" "warm restart"
+
+new "running after cold start"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$DATA</data></rpc-reply>]]>]]>$"
+
+new "warm restart stamp is saved"
+expectpart "$(ls $dir)" 0 "startup_warm"
+
+cp $dir/running_db $dir/running_db.cold
+
+restart warm
+
+new "restart is warm: resync only, running is not committed"
+expectpart "$(cat $flog)" 0 "warm restart" "main_resync running" "nacm_resync running" --not-- "main_begin" "main_validate" "main_commit" "nacm_commit"
+
+new "running after warm restart"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$DATA</data></rpc-reply>]]>]]>$"
+
+new "running file is not rewritten"
+expectpart "$(cmp $dir/running_db $dir/running_db.cold && echo same)" 0 "same"
+
+new "change running"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>c</name><value>3</value></parameter></table></config></edit-config></rpc>]]>]]><rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+restart cold
+
+new "restart after change is cold"
+expectpart "$(cat $flog)" 0 "main_validate" "main_commit" --not-- "main_resync" "warm restart"
+
+new "running after cold restart"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><value>1</value></parameter><parameter><name>b</name><value>2</value></parameter><parameter><name>c</name><value>3</value></parameter></table></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
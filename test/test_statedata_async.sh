@@ -0,0 +1,81 @@
+#!/usr/bin/env bash
+# Asynchronous state data, see ca_statedata_start and CLICON_BACKEND_STATEDATA_TIMEOUT
+# The example backend simulates fetching state for some ms with -- -sa <ms>
+# First, state is fetched within the timeout, then the timeout is shorter than the fetch
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+
+# Timeout in ms
+function testrun(){
+    timeout=$1
+    ms=$2
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_STATEDATA_TIMEOUT>$timeout</CLICON_BACKEND_STATEDATA_TIMEOUT>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg -- -sa $ms"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg -- -sa $ms"
+	start_backend -s init -f $cfg -- -sa $ms
+    fi
+
+    new "waiting"
+    wait_backend
+
+    if [ $ms -lt $timeout ]; then
+	new "netconf get async state"
+	expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"ex:state\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><state xmlns=\"urn:example:clixon\"><op>41</op><op>42</op><op>43</op></state></data></rpc-reply>]]>]]>$"
+
+	new "netconf get async state again"
+	expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"ex:state\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><state xmlns=\"urn:example:clixon\"><op>41</op><op>42</op><op>43</op></state></data></rpc-reply>]]>]]>$"
+    else
+	new "netconf get async state timeout"
+	expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"ex:state\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>Internal error, state callback in plugin example_backend timed out</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+	new "netconf get-config is not affected"
+	expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data/></rpc-reply>]]>]]>$"
+    fi
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "async state within timeout"
+testrun 2000 100
+
+new "async state exceeds timeout"
+testrun 200 1000
+
+rm -rf $dir
+
+new "endtest"
+endtest
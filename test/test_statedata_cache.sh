@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+# Backend state data cache, see CLICON_BACKEND_STATEDATA_CACHE
+# The example backend registers a callback on /table/parameter with -- -k
+# It returns the number of calls as stat, which is the same while state is cached
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+
+# State cache time in ms
+TTL=5000
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MODULE_MAIN>clixon-example</CLICON_YANG_MODULE_MAIN>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_BACKEND_STATEDATA_CACHE>$TTL</CLICON_BACKEND_STATEDATA_CACHE>
+</clixon-config>
+EOF
+
+new "test params: -f $cfg -- -k"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg -- -k"
+    start_backend -s init -f $cfg -- -k
+fi
+
+new "waiting"
+wait_backend
+
+new "netconf edit-config"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><table xmlns=\"urn:example:clixon\"><parameter><name>a</name></parameter><parameter><name>b</name></parameter></table></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf commit"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+new "netconf get with key, callback called"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='a']\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><stat>1</stat></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "netconf get with key again, cached"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='a']\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><stat>1</stat></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "netconf get parent, other request, callback called"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><stat>2</stat></parameter><parameter><name>b</name><stat>2</stat></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "netconf get parent again, cached"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><stat>2</stat></parameter><parameter><name>b</name><stat>2</stat></parameter></table></data></rpc-reply>]]>]]>$"
+
+new "wait until cache expired"
+sleep $((TTL/1000+1))
+
+new "netconf get with key after expiry, callback called"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name='a']\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:clixon\"><parameter><name>a</name><stat>3</stat></parameter></table></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset TTL
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+# Persistent replay log of notification streams, see CLICON_STREAM_REPLAY_LOG
+# The EXAMPLE stream of the example backend sends an event every 5s. Events are
+# appended to segments that are rotated when larger than CLICON_STREAM_REPLAY_LOG_SEGMENT.
+# After a restart of the backend, events sent before the restart are replayed from the log.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+NCWAIT=10 # Wait (netconf valgrind may need more time)
+
+cfg=$dir/conf.xml
+fyang=$dir/stream.yang
+logdir=$dir/replay
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_BACKEND_PIDFILE>$dir/restconf.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_STREAM_DISCOVERY_RFC5277>true</CLICON_STREAM_DISCOVERY_RFC5277>
+  <CLICON_STREAM_RETENTION>3600</CLICON_STREAM_RETENTION>
+  <CLICON_STREAM_REPLAY_LOG>$logdir</CLICON_STREAM_REPLAY_LOG>
+  <CLICON_STREAM_REPLAY_LOG_SEGMENT>256</CLICON_STREAM_REPLAY_LOG_SEGMENT>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example {
+   namespace "urn:example:clixon";
+   prefix ex;
+   notification event {
+      leaf event-class {
+         type string;
+      }
+      container reportingEntity {
+         leaf card {
+            type string;
+         }
+      }
+      leaf severity {
+         type string;
+      }
+   }
+}
+EOF
+
+mkdir -p $logdir
+
+# Start time of replay, before any event
+START=$(date -u +"%Y-%m-%dT%H:%M:%SZ")
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "wait for events"
+sleep 12
+
+new "events appended to rotated segments"
+nr=$(sudo ls $logdir/EXAMPLE | grep -c "\.log$")
+if [ $nr -lt 2 ]; then
+    err "at least 2 segments" "$nr"
+fi
+
+# Stop time of replay, before restart
+STOP=$(date -u +"%Y-%m-%dT%H:%M:%SZ")
+sleep 1
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    stop_backend -f $cfg
+
+    new "restart backend -s running -f $cfg"
+    start_backend -s running -f $cfg
+fi
+
+new "waiting"
+wait_backend
+
+new "netconf replay events from before restart"
+expectwait "$clixon_netconf -qf $cfg" "$DEFAULTHELLO<rpc $DEFAULTNS><create-subscription xmlns=\"urn:ietf:params:xml:ns:netmod:notification\"><stream>EXAMPLE</stream><startTime>$START</startTime><stopTime>$STOP</stopTime></create-subscription></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]><notification xmlns=\"urn:ietf:params:xml:ns:netconf:notification:1.0\"><eventTime>20[0-9:T.-]*Z</eventTime><event xmlns=\"urn:example:clixon\"><event-class>fault</event-class>" 2
+
+new "events of restart appended to new segment"
+nr2=$(sudo ls $logdir/EXAMPLE | grep -c "\.log$")
+if [ $nr2 -lt $nr ]; then
+    err "at least $nr segments" "$nr2"
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+unset NCWAIT
+unset START
+unset STOP
+unset nr
+unset nr2
+
+sudo rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,135 @@
+#!/usr/bin/env bash
+# Tracing of requests with CLICON_TRACE_LOG
+# A restconf request with a W3C traceparent header is traced with its trace-id, which
+# is propagated to the backend so that the backend spans of the request, eg rpcs and
+# datastore writes, are logged with the same trace id.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/trace.yang
+flog=$dir/backend.log
+touch $flog
+
+# W3C traceparent header, the last 16 digits of its trace-id is used as trace id
+traceid=4bf92f3577b34da6a3ce929d0e0e4736
+tid=a3ce929d0e0e4736
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_RESTCONF_PRETTY>false</CLICON_RESTCONF_PRETTY>
+  <CLICON_TRACE_LOG>true</CLICON_TRACE_LOG>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module trace{
+   yang-version 1.1;
+   namespace "urn:example:trace";
+   prefix ex;
+   container c{
+      leaf x{
+         type int32;
+      }
+   }
+}
+EOF
+
+new "test params: -f $cfg -l f$flog"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg -l f$flog"
+    start_backend -s init -f $cfg -l f$flog
+fi
+
+new "waiting"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+
+    new "waiting"
+    wait_restconf
+fi
+
+new "restconf add config with traceparent"
+expectpart "$(curl $CURLOPTS -X POST -H "traceparent: 00-$traceid-00f067aa0ba902b7-01" -H "Content-Type: application/yang-data+json" $RCPROTO://localhost/restconf/data -d '{"trace:c":{"x":1}}')" 0 "HTTP/1.1 201 Created"
+
+new "netconf get config without trace id"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:trace\"><x>1</x></c></data></rpc-reply>]]>]]>$"
+
+if [ $BE -ne 0 ]; then
+    new "backend edit-config span with trace id"
+    match=$(grep "trace $tid backend edit-config [0-9]*us" $flog)
+    if [ -z "$match" ]; then
+	err "trace $tid backend edit-config" "$(cat $flog)"
+    fi
+
+    new "backend datastore write span with trace id"
+    match=$(grep "trace $tid xmldb-put candidate [0-9]*us" $flog)
+    if [ -z "$match" ]; then
+	err "trace $tid xmldb-put candidate" "$(cat $flog)"
+    fi
+
+    new "backend commit span with trace id"
+    match=$(grep "trace $tid backend commit [0-9]*us" $flog)
+    if [ -z "$match" ]; then
+	err "trace $tid backend commit" "$(cat $flog)"
+    fi
+
+    new "backend get-config span with new trace id"
+    match=$(grep "trace [0-9a-f]* backend get-config [0-9]*us" $flog | grep -v $tid)
+    if [ -z "$match" ]; then
+	err "trace <id> backend get-config" "$(cat $flog)"
+    fi
+fi
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+# Set by restconf_config
+unset RESTCONFIG
+unset traceid
+unset tid
+unset match
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,171 @@
+#!/usr/bin/env bash
+# Incremental validation, see CLICON_VALIDATE_INCREMENTAL
+# Only changed nodes are validated, and unchanged nodes with leafref, must or when that
+# may reference them according to the reverse dependencies of the yang spec. Check that errors in unchanged nodes caused by changes elsewhere,
+# and min-elements after delete, are detected the same way as with full validation.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/moda.yang
+
+cat <<EOF > $fyang
+module moda{
+  namespace "urn:example:a";
+  prefix a;
+  container x{
+    list a{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf v{
+        type int32;
+      }
+    }
+    list b{
+      key name;
+      leaf name{
+        type string;
+      }
+      leaf ref{
+        description "Unchanged leafref to a deleted entry";
+        type leafref{
+          path "../../a/name";
+        }
+      }
+    }
+    leaf max{
+      description "Unchanged must referencing added entries";
+      type int32;
+      must "count(../a) <= ." {
+        error-message "Too many a";
+      }
+    }
+    list c{
+      key name;
+      min-elements 1;
+      leaf name{
+        type string;
+      }
+    }
+    leaf w{
+      description "Unchanged when referencing a node in another container";
+      when "../../y/flag = 'true'";
+      type string;
+    }
+  }
+  container y{
+    leaf flag{
+      type boolean;
+    }
+  }
+}
+EOF
+
+# Run the same tests with incremental and full validation
+# 1: true or false
+function testrun()
+{
+    incremental=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_VALIDATE_INCREMENTAL>$incremental</CLICON_VALIDATE_INCREMENTAL>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    new "netconf edit-config"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><a><name>a1</name></a><a><name>a2</name><v>1</v></a><b><name>b1</name><ref>a1</ref></b><max>2</max><c><name>c1</name></c><w>w1</w></x><y xmlns=\"urn:example:a\"><flag>true</flag></y></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf commit"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf delete a1 referenced by leafref"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><a nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><name>a1</name></a></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate leafref fails"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>a1</bad-element></error-info><error-severity>error</error-severity><error-message>Leafref validation failed: No leaf a1 matching path ../../a/name</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf add a3"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><a><name>a3</name></a></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate must fails"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>Too many a</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf delete c1"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><c nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><name>c1</name></c></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate min-elements fails"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>protocol</error-type><error-tag>operation-failed</error-tag><error-app-tag>too-few-elements</error-app-tag><error-severity>error</error-severity><error-path>/x/c</error-path></rpc-error></rpc-reply>]]>]]>$"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf change flag referenced by when"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><y xmlns=\"urn:example:a\"><flag>false</flag></y></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate when fails"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>Failed WHEN condition of w in module moda</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf change unrelated value"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><a><name>a2</name><v>2</v></a></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf commit"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><commit/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "incremental validation"
+testrun true
+
+new "full validation"
+testrun false
+
+rm -rf $dir
+
+new "endtest"
+endtest
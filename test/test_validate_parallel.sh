@@ -0,0 +1,124 @@
+#!/usr/bin/env bash
+# Parallel validation of top-level subtrees, see CLICON_VALIDATE_WORKERS
+# Subtrees of several modules are validated by several workers. Check that the
+# result is the same as when validated serially, ie the error of the first subtree
+# that is not valid.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+ydir=$dir/yang
+
+# Number of modules
+nr=4
+
+test -d $ydir || mkdir $ydir
+
+# Module m0 has a limit that the other modules refer to
+cat <<EOF > $ydir/m0.yang
+module m0{
+  namespace "urn:example:m0";
+  prefix m0;
+  container c0{
+    leaf max{
+      type int32;
+    }
+  }
+}
+EOF
+for (( i=1; i<$nr; i++ )); do
+    cat <<EOF > $ydir/m$i.yang
+module m$i{
+  namespace "urn:example:m$i";
+  prefix m$i;
+  import m0 {
+    prefix m0;
+  }
+  container c$i{
+    leaf v{
+      type int32;
+      must ". < /m0:c0/m0:max" {
+        error-message "c$i too large";
+      }
+    }
+  }
+}
+EOF
+done
+
+# Run the same tests with parallel and serial validation
+# 1: number of workers
+function testrun()
+{
+    workers=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$ydir</CLICON_YANG_MAIN_DIR>
+  <CLICON_VALIDATE_INCREMENTAL>false</CLICON_VALIDATE_INCREMENTAL>
+  <CLICON_VALIDATE_WORKERS>$workers</CLICON_VALIDATE_WORKERS>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    new "netconf edit-config workers:$workers"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c0 xmlns=\"urn:example:m0\"><max>10</max></c0><c1 xmlns=\"urn:example:m1\"><v>1</v></c1><c2 xmlns=\"urn:example:m2\"><v>20</v></c2><c3 xmlns=\"urn:example:m3\"><v>30</v></c3></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate first error workers:$workers"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>c2 too large</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+    new "netconf edit-config raise max workers:$workers"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c0 xmlns=\"urn:example:m0\"><max>100</max></c0></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate ok workers:$workers"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "parallel"
+testrun 3
+
+new "serial"
+testrun 0
+
+unset nr
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,118 @@
+#!/usr/bin/env bash
+# State validation on schema level per provider, sampled, see CLICON_VALIDATE_STATE_XML_LEVEL
+# and CLICON_VALIDATE_STATE_XML_SAMPLE
+# On schema level a leafref in state data is not checked, but ranges are.
+# One in two get:s is validated, and failures are counted in the stats rpc.
+# Using the -sS <file> state capability of the main example
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fstate=$dir/state.xml
+fyang=$dir/vstate.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_VALIDATE_STATE_XML>true</CLICON_VALIDATE_STATE_XML>
+  <CLICON_VALIDATE_STATE_XML_LEVEL>schema</CLICON_VALIDATE_STATE_XML_LEVEL>
+  <CLICON_VALIDATE_STATE_XML_SAMPLE>2</CLICON_VALIDATE_STATE_XML_SAMPLE>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module vstate{
+    yang-version 1.1;
+    namespace "urn:example:example";
+    prefix ex;
+    list sender-config{
+        key name;
+        leaf name{
+           type string;
+        }
+    }
+    list sender-state{
+        config false;
+        key ref;
+        leaf ref{
+ 	   type leafref {
+	      path "/ex:sender-config/ex:name";
+	   }
+        }
+        leaf cnt{
+           type uint8{
+              range "0..100";
+           }
+        }
+    }
+}
+EOF
+
+# Leafref to non-existing config, not checked on schema level
+cat <<EOF > $fstate
+   <sender-state xmlns="urn:example:example">
+      <ref>x</ref><cnt>10</cnt>
+   </sender-state>
+EOF
+
+new "test params: -f $cfg -- -sS $fstate"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+	err
+    fi
+    new "start backend -s init -f $cfg -- -sS $fstate"
+    start_backend -s init -f $cfg -- -sS $fstate
+fi
+
+new "waiting"
+wait_backend
+
+new "get validated, leafref not checked"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get content=\"nonconfig\"/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><sender-state xmlns=\"urn:example:example\"><ref>x</ref><cnt>10</cnt></sender-state></data></rpc-reply>]]>]]>$"
+
+# Out of range
+cat <<EOF > $fstate
+   <sender-state xmlns="urn:example:example">
+      <ref>x</ref><cnt>200</cnt>
+   </sender-state>
+EOF
+
+new "get not sampled"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get content=\"nonconfig\"/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><sender-state xmlns=\"urn:example:example\"><ref>x</ref><cnt>200</cnt></sender-state></data></rpc-reply>]]>]]>$"
+
+new "get sampled out of range fails"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get content=\"nonconfig\"/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-info><bad-element>cnt</bad-element></error-info><error-severity>error</error-severity><error-message>Number 200 out of range: 0 - 100. Internal error, state callback returned invalid XML from plugin: example_backend.so</error-message></rpc-error></rpc-reply>]]>]]>$"
+
+new "stats state validation counters"
+expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><stats xmlns=\"http://clicon.org/lib\"/></rpc>]]>]]>" "<state-validate><name>example_backend.so</name><calls>3</calls><validated>2</validated><failures>1</failures></state-validate>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+	err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -18,7 +18,13 @@ APPNAME=example
 cfg=$dir/conf_yang.xml
 fyang=$dir/example-default.yang
 
-cat <<EOF > $cfg
+# Run the tests with the datastore file written with and without indentation
+# 1: CLICON_XMLDB_PRETTY
+function testrun()
+{
+    pretty=$1
+
+    cat <<EOF > $cfg
 <clixon-config xmlns="http://clicon.org/config">
   <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
   <CLICON_FEATURE>ietf-netconf:startup</CLICON_FEATURE>
@@ -36,9 +42,62 @@ cat <<EOF > $cfg
   <CLICON_SOCK>$dir/$APPNAME.sock</CLICON_SOCK>
   <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
   <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>$pretty</CLICON_XMLDB_PRETTY>
 </clixon-config>
 EOF
 
+    new "test params: -f $cfg"
+    # Bring your own backend
+    if [ $BE -ne 0 ]; then
+	# kill old backend (if any)
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend  -s init -f $cfg"
+	start_backend -s init -f $cfg
+
+	new "waiting"
+	wait_backend
+    fi
+
+    new "Set defaults pretty:$pretty"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$XML</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "Check config (Clixon supports explicit) pretty:$pretty"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
+
+    # Clixon extension: defaults="false". Whole datastore sent from the datastore file
+    # if not pretty-printed
+    new "Check config defaults false attribute pretty:$pretty"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config defaults=\"false\"><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$XML</data></rpc-reply>]]>]]>$"
+
+    new "Check config defaults false attribute and filter pretty:$pretty"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config defaults=\"false\"><source><candidate/></source><filter type=\"xpath\" select=\"/ex:c\" xmlns:ex=\"urn:example:default\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$XML</data></rpc-reply>]]>]]>$"
+
+    new "Check config defaults true attribute pretty:$pretty"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config defaults=\"true\"><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
+
+    new "Check config defaults invalid attribute pretty:$pretty"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config defaults=\"explicit\"><source><candidate/></source></get-config></rpc>]]>]]>" "<error-tag>bad-attribute</error-tag>"
+
+    # RFC 6243 with-defaults is not a Clixon attribute and is not interpreted
+    new "Check config with-defaults trim attribute pretty:$pretty"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config with-defaults=\"trim\"><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
 cat <<EOF > $fyang
    module example-default {
       namespace "urn:example:default";
@@ -63,22 +122,6 @@ cat <<EOF > $fyang
    }
 EOF
 
-new "test params: -f $cfg"
-# Bring your own backend
-if [ $BE -ne 0 ]; then
-    # kill old backend (if any)
-    new "kill old backend"
-    sudo clixon_backend -zf $cfg
-    if [ $? -ne 0 ]; then
-	err
-    fi
-    new "start backend  -s init -f $cfg"
-    start_backend -s init -f $cfg
-
-    new "waiting"
-    wait_backend
-fi
-
 # This is the base XML with three values in the server: notset, default, other
 XML='<c xmlns="urn:example:default"><x><k>default</k><y>42</y></x><x><k>notset</k></x><x><k>other</k><y>99</y></x></c>'
 
@@ -95,22 +138,13 @@ TRIM='<c xmlns="urn:example:default"><x><k>default</k></x><x><k>notset</k></x><x
 # (SAME AS Input XML)
 EXPLICIT='<c xmlns="urn:example:default"><x><k>default</k><y>42</y></x><x><k>notset</k><y>42</y></x><x><k>other</k><y>99</y></x></c>'
 
-new "Set defaults"
-expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>$XML</config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+new "pretty datastore file"
+testrun true
 
-new "Check config (Clixon supports explicit)"
-expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data>$EXPLICIT</data></rpc-reply>]]>]]>$"
+new "datastore file without indentation"
+testrun false
 
-if [ $BE -ne 0 ]; then
-    new "Kill backend"
-    # Check if premature kill
-    pid=$(pgrep -u root -f clixon_backend)
-    if [ -z "$pid" ]; then
-	err "backend already dead"
-    fi
-    # kill backend
-    stop_backend -f $cfg
-fi
+unset pretty
 
 rm -rf $dir
 
@@ -29,8 +29,9 @@ expecteof "$clixon_util_xml -o" 255 "<a%/>" ""
 
 LF='
 '
+CR=$'\r'
 new "xml parse content with CR LF -> LF, CR->LF (see https://www.w3.org/TR/REC-xml/#sec-line-ends)"
-ret=$(echo "<x>ab${LF}c${LF}d</x>" | $clixon_util_xml -o)
+ret=$(echo "<x>a${CR}b${LF}c${CR}${LF}d</x>" | $clixon_util_xml -o)
 if [ "$ret" != "<x>a${LF}b${LF}c${LF}d</x>" ]; then
      err '<x>a$LFb$LFc</x>' "$ret"
 fi
@@ -182,6 +183,14 @@ EOF
 )
 expecteof "$clixon_util_xml -o" 0 "$XML" '^<bk:book xmlns:bk="urn:loc.gov:books" xmlns:isbn="urn:ISBN:0-395-36341-6"><bk:title>Cheaper by the Dozen</bk:title><isbn:number>1568491379</isbn:number></bk:book>$'
 
+new "xml parse same result with and without comment (fast and regular parser)"
+expecteof "$clixon_util_xml -o" 0 '<a x="1"> <b> x &amp; y </b> <c/> </a>' '^<a x="1"><b> x &amp; y </b><c/></a>$'
+
+expecteof "$clixon_util_xml -o" 0 '<a x="1"> <b> x &amp; y </b> <c/> <!-- comment --></a>' '^<a x="1"><b> x &amp; y </b><c/></a>$'
+
+new "xml parse end tag mismatch after fast parse"
+expecteof "$clixon_util_xml -o" 255 '<a><b>x</b></c>' ''
+
 rm -rf $dir
 
 # unset conditional parameters 
@@ -0,0 +1,124 @@
+#!/usr/bin/env bash
+# XPATH list optimization, see XPATH_LIST_OPTIMIZE
+# Key equalities in predicates are rewritten as key lookups: multiple keys as separate
+# predicates in any order, and-expressions and nested lists.
+# Bounds and prefix tests on the first key are range scans of the sorted list.
+# Other predicates are evaluated the regular way and must give the same result.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_xpath:=clixon_util_xpath}
+
+xml=$dir/xml.xml
+fyang=$dir/moda.yang
+
+cat <<EOF > $fyang
+module moda{
+  namespace "urn:example:a";
+  prefix a;
+  container x{
+    list a{
+      key "k1 k2";
+      leaf k1{
+        type string;
+      }
+      leaf k2{
+        type string;
+      }
+      list b{
+        key k;
+        leaf k{
+          type string;
+        }
+        leaf v{
+          type string;
+        }
+      }
+    }
+    list c{
+      key id;
+      leaf id{
+        type uint32;
+      }
+    }
+    list d{
+      key name;
+      leaf name{
+        type string;
+      }
+    }
+  }
+}
+EOF
+
+cat <<EOF > $xml
+<x xmlns="urn:example:a">
+  <a><k1>1</k1><k2>1</k2><b><k>3</k><v>x11</v></b></a>
+  <a><k1>1</k1><k2>2</k2><b><k>3</k><v>x12</v></b><b><k>4</k><v>y12</v></b></a>
+  <a><k1>2</k1><k2>1</k2><b><k>3</k><v>x21</v></b></a>
+  <c><id>9</id></c><c><id>1000</id></c><c><id>1500</id></c><c><id>2000</id></c><c><id>30000</id></c>
+  <d><name>eth0/1</name></d><d><name>eth1/1</name></d><d><name>eth1/2</name></d><d><name>eth10</name></d>
+</x>
+EOF
+
+B="<b><k>3</k><v>x12</v></b>"
+
+new "xpath two keys as predicates, nested list"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='1'][a:k2='2']/a:b[a:k='3']")" 0 "^nodeset:0:$B$" "optimize:2 key:2 and:0 index:0"
+
+new "xpath profile of optimized lookup"
+expectpart "$($clixon_util_xpath -P -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='1'][a:k2='2']/a:b[a:k='3']")" 0 "^nodeset:0:$B$" "step:child \[evals:1 visits:0 preds:0 opt-hit:1 opt-miss:0 usec:[0-9]*\]"
+
+new "xpath two keys as predicates reverse order"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k2='2'][a:k1='1']/a:b[a:k='3']")" 0 "^nodeset:0:$B$" "optimize:2 key:2 and:0 index:0"
+
+new "xpath two keys as and-expression"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='1' and a:k2='2']/a:b[a:k='3']")" 0 "^nodeset:0:$B$" "optimize:2 key:1 and:1 index:0"
+
+new "xpath literal first in equality"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a['2'=a:k2 and '1'=a:k1]/a:b['3'=a:k]")" 0 "^nodeset:0:$B$" "optimize:2 key:1 and:1 index:0"
+
+new "xpath keys as numbers"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1=1][a:k2=2]/a:b[a:k=3]")" 0 "^nodeset:0:$B$" "optimize:2 key:2 and:0 index:0"
+
+new "xpath no match"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='2'][a:k2='2']")" 0 "^nodeset:$" "optimize:1 key:1 and:0 index:0"
+
+new "xpath one of two keys is not optimized"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='2']/a:b/a:v")" 0 "^nodeset:0:<v>x21</v>$" "optimize:0 key:0 and:0 index:0"
+
+new "xpath profile of not optimized lookup"
+expectpart "$($clixon_util_xpath -P -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='2']/a:b/a:v")" 0 "^nodeset:0:<v>x21</v>$" "step:child \[evals:1 visits:3 preds:0 opt-hit:0 opt-miss:1 usec:[0-9]*\]" "predicates: \[evals:1 visits:0 preds:3 opt-hit:0 opt-miss:0 usec:[0-9]*\]"
+
+new "xpath or-expression is not optimized"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='2' or a:k2='2']/a:b[a:k='4']/a:v")" 0 "^nodeset:0:<v>y12</v>$" "optimize:2 key:2 and:0 index:0"
+
+new "xpath same key twice is not optimized"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='1'][a:k1='2']")" 0 "^nodeset:$" "optimize:0 key:0 and:0 index:0"
+
+new "xpath keys and other predicate is not optimized"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:a[a:k1='1'][a:k2='2'][a:b/a:k='4']/a:b[a:k='3']/a:v")" 0 "^nodeset:0:<v>x12</v>$" "optimize:1 key:1 and:0 index:0"
+
+new "xpath range of numeric key"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:c[a:id > 1000 and a:id <= 2000]")" 0 "^nodeset:0:<c><id>1500</id></c>1:<c><id>2000</id></c>$" "optimize:1 key:0 and:0 index:0 range:1"
+
+new "xpath range of numeric key, literal first and separate predicates"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:c[1000 <= a:id][a:id < 30000]")" 0 "^nodeset:0:<c><id>1000</id></c>1:<c><id>1500</id></c>2:<c><id>2000</id></c>$" "optimize:1 key:0 and:0 index:0 range:1"
+
+new "xpath range of numeric key, lower bound only"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:c[a:id >= 2000]")" 0 "^nodeset:0:<c><id>2000</id></c>1:<c><id>30000</id></c>$" "optimize:1 key:0 and:0 index:0 range:1"
+
+new "xpath prefix of string key"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:d[starts-with(a:name,'eth1/')]")" 0 "^nodeset:0:<d><name>eth1/1</name></d>1:<d><name>eth1/2</name></d>$" "optimize:1 key:0 and:0 index:0 range:1"
+
+new "xpath range of string key is not optimized"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:d[a:name > 1]")" 0 "^nodeset:$" "optimize:0 key:0 and:0 index:0 range:0"
+
+new "xpath range with positional predicate is not optimized"
+expectpart "$($clixon_util_xpath -s -y $fyang -f $xml -n a:urn:example:a -p "/a:x/a:c[a:id > 1000][2]")" 0 "^nodeset:0:<c><id>2000</id></c>$" "optimize:0 key:0 and:0 index:0 range:0"
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,167 @@
+#!/usr/bin/env bash
+# Binary cache of parsed YANG specs, see CLICON_YANG_CACHE_DIR
+# The YANG spec is saved in the cache dir when first parsed and loaded from it when
+# started again. Check that defaults, patterns, ranges and leafrefs give the same
+# result with a cached YANG spec, and that a modified YANG file is parsed again.
+# The generated autocli syntax is also cached.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/moda.yang
+cachedir=$dir/cache
+
+test -d $cachedir || mkdir -m 777 $cachedir
+rm -f $cachedir/*
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_YANG_CACHE_DIR>$cachedir</CLICON_YANG_CACHE_DIR>
+  <CLICON_CLISPEC_DIR>/usr/local/lib/$APPNAME/clispec</CLICON_CLISPEC_DIR>
+  <CLICON_CLI_DIR>/usr/local/lib/$APPNAME/cli</CLICON_CLI_DIR>
+  <CLICON_CLI_MODE>$APPNAME</CLICON_CLI_MODE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+# Create YANG file
+# 1: default value of leaf d
+function yangfile()
+{
+    def=$1
+
+    cat <<EOF > $fyang
+module moda{
+  namespace "urn:example:a";
+  prefix a;
+  typedef name-type{
+    type string{
+      pattern '[a-z][a-z0-9]*';
+    }
+  }
+  container x{
+    list y{
+      key name;
+      leaf name{
+        type name-type;
+      }
+      leaf v{
+        type int32{
+          range "1..10";
+        }
+      }
+    }
+    leaf r{
+      type leafref{
+        path "../y/name";
+      }
+    }
+    leaf d{
+      type uint8;
+      default $def;
+    }
+  }
+}
+EOF
+}
+
+# Run the same tests with parsed and cached YANG
+# 1: default value of leaf d
+function testrun()
+{
+    def=$1
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    new "netconf edit-config"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><y><name>y1</name><v>1</v></y><r>y1</r></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf get-config default $def"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/a:x\" xmlns:a=\"urn:example:a\"/></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:a\"><y><name>y1</name><v>1</v></y><r>y1</r><d>$def</d></x></data></rpc-reply>]]>]]>$"
+
+    new "netconf edit-config pattern mismatch"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><y><name>Y2</name></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate pattern error"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>name</bad-element></error-info><error-severity>error</error-severity><error-message>regexp match fail:"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf edit-config out of range"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:a\"><y><name>y2</name><v>11</v></y></x></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf validate range error"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>v</bad-element></error-info><error-severity>error</error-severity><error-message>Number 11 out of range: 1 - 10</error-message>"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "cli set list entry"
+    expectpart "$($clixon_cli -1 -f $cfg set x y y3 v 2)" 0 "^$"
+
+    new "cli show config"
+    expectpart "$($clixon_cli -1 -f $cfg show conf cli)" 0 "set x y y3 v 2"
+
+    new "cli discard"
+    expectpart "$($clixon_cli -1 -f $cfg discard)" 0 "^$"
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+yangfile 42
+
+new "parsed yang"
+testrun 42
+
+new "check cache file"
+expectpart "$(ls $cachedir | wc -l)" 0 "^[1-9]"
+
+new "check cli cache file"
+expectpart "$(ls $cachedir/*.cli | wc -l)" 0 "^[1-9]"
+
+new "cached yang"
+testrun 42
+
+new "modified yang"
+sleep 1 # Modification time in seconds
+yangfile 17
+testrun 17
+
+rm -rf $dir
+
+new "endtest"
+endtest
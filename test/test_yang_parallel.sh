@@ -0,0 +1,113 @@
+#!/usr/bin/env bash
+# Parallel parsing of YANG modules in CLICON_YANG_MAIN_DIR, see CLICON_YANG_PARSE_WORKERS
+# Modules importing and augmenting each other are parsed by several workers. Check
+# that the result is the same as when parsed serially.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+ydir=$dir/yang
+
+# Number of modules
+nr=8
+
+test -d $ydir || mkdir $ydir
+
+# Module m0 has a container that the other modules augment
+cat <<EOF > $ydir/m0.yang
+module m0{
+  namespace "urn:example:m0";
+  prefix m0;
+  container c{
+    leaf x{
+      type string;
+    }
+  }
+}
+EOF
+for (( i=1; i<$nr; i++ )); do
+    cat <<EOF > $ydir/m$i.yang
+module m$i{
+  namespace "urn:example:m$i";
+  prefix m$i;
+  import m0 {
+    prefix m0;
+  }
+  augment "/m0:c" {
+    leaf y$i{
+      type int32;
+    }
+  }
+}
+EOF
+done
+
+# Run the same tests with parallel and serial parsing
+# 1: number of workers
+function testrun()
+{
+    workers=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>/usr/local/share/clixon</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$ydir</CLICON_YANG_MAIN_DIR>
+  <CLICON_YANG_PARSE_WORKERS>$workers</CLICON_YANG_PARSE_WORKERS>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>/usr/local/var/$APPNAME</CLICON_XMLDB_DIR>
+  <CLICON_MODULE_LIBRARY_RFC7895>false</CLICON_MODULE_LIBRARY_RFC7895>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+	new "kill old backend"
+	sudo clixon_backend -zf $cfg
+	if [ $? -ne 0 ]; then
+	    err
+	fi
+	new "start backend -s init -f $cfg"
+	start_backend -s init -f $cfg
+    fi
+
+    new "waiting"
+    wait_backend
+
+    new "netconf edit-config workers:$workers"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><c xmlns=\"urn:example:m0\"><x>foo</x><y3 xmlns=\"urn:example:m3\">3</y3><y1 xmlns=\"urn:example:m1\">1</y1></c></config></edit-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    new "netconf get-config workers:$workers"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><data><c xmlns=\"urn:example:m0\"><x>foo</x><y1 xmlns=\"urn:example:m1\">1</y1><y3 xmlns=\"urn:example:m3\">3</y3></c></data></rpc-reply>]]>]]>$"
+
+    new "netconf discard-changes"
+    expecteof "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO<rpc $DEFAULTNS><discard-changes/></rpc>]]>]]>" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+    if [ $BE -ne 0 ]; then
+	new "Kill backend"
+	# Check if premature kill
+	pid=$(pgrep -u root -f clixon_backend)
+	if [ -z "$pid" ]; then
+	    err "backend already dead"
+	fi
+	# kill backend
+	stop_backend -f $cfg
+    fi
+}
+
+new "parallel"
+testrun 3
+
+new "serial"
+testrun 0
+
+unset nr
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,1129 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+ 
+  Copyright (C) 2009-2016 Olof Hagsand and Benny Holmgren
+  Copyright (C) 2017-2019 Olof Hagsand
+  Copyright (C) 2020-2021 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2, 
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  In-process benchmarks of library hot paths: XML and JSON parse and print, yang
+  binding, sorting, list and xpath lookup, diff, validation and datastore put.
+  A list of n entries is created for each size, and each benchmark is run a number of
+  rounds. Only the operation itself is timed, not the setup of its input.
+  Datastore benchmarks (ds_*) use a config of n nested list entries with leafrefs and
+  defaults, and are run once per datastore cache mode, see CLICON_DATASTORE_CACHE.
+  Output is one line per benchmark and size with whitespace-separated fields:
+    <name> <n> <ops> <rounds> <usec min> <usec avg> <ops per sec> <peak rss kB>
+  where ops is the number of operations per round, eg lookups, ops per sec is computed
+  from the average time, and name of datastore benchmarks is <name>/<cache mode>.
+  Example:
+    clixon_util_bench -b /tmp/bench -n 1000,10000,100000 -r 5 xml_parse xpath
+    clixon_util_bench -b /tmp/bench -n 10000 -c nocache,cache ds_get ds_put
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <syslog.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clicon */
+#include <clixon/clixon.h>
+
+/* Command line options to be passed to getopt(3) */
+#define BENCH_OPTS "hDb:n:r:l:c:"
+
+/* Yang of benchmark data, written to the benchmark directory */
+#define BENCH_MODULE "clixon-bench"
+#define BENCH_NS     "urn:example:bench"
+#define BENCH_YANG \
+    "module " BENCH_MODULE "{\n"		\
+    "  yang-version 1.1;\n"			\
+    "  namespace \"" BENCH_NS "\";\n"		\
+    "  prefix b;\n"				\
+    "  container x{\n"				\
+    "    list y{\n"				\
+    "      key a;\n"				\
+    "      leaf a{ type uint32; }\n"		\
+    "      leaf b{ type string; }\n"		\
+    "    }\n"					\
+    "  }\n"					\
+    "  container d{\n"				\
+    "    list if{\n"				\
+    "      key name;\n"				\
+    "      leaf name{ type string; }\n"		\
+    "      leaf mtu{ type uint32; default 1500; }\n"	\
+    "      leaf enabled{ type boolean; default true; }\n" \
+    "      list addr{\n"				\
+    "        key ip;\n"				\
+    "        leaf ip{ type string; }\n"		\
+    "        leaf prefix-length{ type uint8; default 24; }\n" \
+    "      }\n"					\
+    "    }\n"					\
+    "    list route{\n"				\
+    "      key prefix;\n"				\
+    "      leaf prefix{ type string; }\n"		\
+    "      leaf ifname{\n"			\
+    "        type leafref{ path \"../../if/name\"; }\n" \
+    "      }\n"					\
+    "      leaf metric{ type uint32; default 1; }\n" \
+    "    }\n"					\
+    "  }\n"					\
+    "}\n"
+
+/* Number of addr entries of each if entry in datastore benchmark config */
+#define BENCH_ADDR 2
+
+/* Input data of benchmarks of one list size
+ */
+typedef struct {
+    clicon_handle bs_h;
+    yang_stmt    *bs_yspec;
+    uint32_t      bs_n;       /* Nr of list entries */
+    uint32_t      bs_lookups; /* Max nr of lookups per round */
+    char         *bs_xml;     /* XML string of list entries in key order */
+    char         *bs_xmlrev;  /* XML string of list entries in reverse key order */
+    char         *bs_json;    /* JSON string of list entries */
+    cxobj        *bs_xt;      /* Parsed and bound tree of bs_xml */
+    cxobj        *bs_x;       /* Container x of bs_xt */
+    cxobj        *bs_dxt;     /* Datastore benchmark config: container d, n if and route */
+} bench_state;
+
+/* Benchmark function
+ * @param[in]  bs    Benchmark input
+ * @param[out] ops   Nr of operations timed
+ * @param[out] usec  Time of operations in micro-seconds
+ */
+typedef int (bench_fn)(bench_state *bs, uint32_t *ops, uint64_t *usec);
+
+static uint64_t
+bench_usec(struct timeval *t0)
+{
+    struct timeval t1;
+
+    gettimeofday(&t1, NULL);
+    timersub(&t1, t0, &t1);
+    return (uint64_t)t1.tv_sec*1000000 + t1.tv_usec;
+}
+
+/*! Nr of lookups and the key of lookup i, spread over the list
+ */
+static uint32_t
+bench_lookups(bench_state *bs,
+	      uint32_t     max)
+{
+    return bs->bs_n < max ? bs->bs_n : max;
+}
+
+static uint32_t
+bench_key(bench_state *bs,
+	  uint32_t     i)
+{
+    return (uint32_t)(((uint64_t)i * 7919) % bs->bs_n);
+}
+
+static int
+bench_xml_parse(bench_state *bs,
+		uint32_t    *ops,
+		uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *xt = NULL;
+    struct timeval t0;
+
+    gettimeofday(&t0, NULL);
+    if (clixon_xml_parse_string(bs->bs_xml, YB_NONE, NULL, &xt, NULL) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    retval = 0;
+ done:
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+static int
+bench_xml_bind(bench_state *bs,
+	       uint32_t    *ops,
+	       uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *xt = NULL;
+    cxobj         *xerr = NULL;
+    struct timeval t0;
+    int            ret;
+
+    if (clixon_xml_parse_string(bs->bs_xml, YB_NONE, NULL, &xt, NULL) < 0)
+	goto done;
+    gettimeofday(&t0, NULL);
+    if ((ret = xml_bind_yang(xt, YB_MODULE, bs->bs_yspec, &xerr)) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    if (ret == 0){
+	clicon_err(OE_YANG, 0, "xml_bind_yang failed");
+	goto done;
+    }
+    *ops = 1;
+    retval = 0;
+ done:
+    if (xerr)
+	xml_free(xerr);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+static int
+bench_xml_print(bench_state *bs,
+		uint32_t    *ops,
+		uint64_t    *usec)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    struct timeval t0;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    gettimeofday(&t0, NULL);
+    if (clicon_xml2cbuf(cb, bs->bs_x, 0, 0, -1) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! xml_apply callback counting nodes, see bench_xml_apply
+ */
+static int
+bench_xml_apply_fn(cxobj *x,
+		   void  *arg)
+{
+    (*(uint32_t*)arg)++;
+    return 0;
+}
+
+/* Traverse all elements of the datastore benchmark config, one read of each node */
+static int
+bench_xml_apply(bench_state *bs,
+		uint32_t    *ops,
+		uint64_t    *usec)
+{
+    struct timeval t0;
+    uint32_t       nr = 0;
+
+    gettimeofday(&t0, NULL);
+    if (xml_apply(bs->bs_dxt, CX_ELMNT, bench_xml_apply_fn, &nr) < 0)
+	return -1;
+    *usec = bench_usec(&t0);
+    *ops = nr;
+    return 0;
+}
+
+static int
+bench_json_parse(bench_state *bs,
+		 uint32_t    *ops,
+		 uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *xt = NULL;
+    cxobj         *xerr = NULL;
+    struct timeval t0;
+    int            ret;
+
+    gettimeofday(&t0, NULL);
+    if ((ret = clixon_json_parse_string(bs->bs_json, YB_MODULE, bs->bs_yspec, &xt, &xerr)) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    if (ret == 0){
+	clicon_err(OE_XML, 0, "JSON parse failed");
+	goto done;
+    }
+    *ops = 1;
+    retval = 0;
+ done:
+    if (xerr)
+	xml_free(xerr);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+static int
+bench_json_print(bench_state *bs,
+		 uint32_t    *ops,
+		 uint64_t    *usec)
+{
+    int            retval = -1;
+    cbuf          *cb = NULL;
+    struct timeval t0;
+
+    if ((cb = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    gettimeofday(&t0, NULL);
+    if (xml2json_cbuf(cb, bs->bs_x, 0) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    retval = 0;
+ done:
+    if (cb)
+	cbuf_free(cb);
+    return retval;
+}
+
+/*! Sort a bound tree of list entries in reverse order
+ */
+static int
+bench_xml_sort(bench_state *bs,
+	       uint32_t    *ops,
+	       uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *xt = NULL;
+    cxobj         *xerr = NULL;
+    struct timeval t0;
+    int            ret;
+
+    if (clixon_xml_parse_string(bs->bs_xmlrev, YB_NONE, NULL, &xt, NULL) < 0)
+	goto done;
+    if ((ret = xml_bind_yang(xt, YB_MODULE, bs->bs_yspec, &xerr)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_YANG, 0, "xml_bind_yang failed");
+	goto done;
+    }
+    gettimeofday(&t0, NULL);
+    if (xml_sort_recurse(xt) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    retval = 0;
+ done:
+    if (xerr)
+	xml_free(xerr);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Look up list entries by key with clixon_xml_find_index
+ */
+static int
+bench_find_index(bench_state *bs,
+		 uint32_t    *ops,
+		 uint64_t    *usec)
+{
+    int            retval = -1;
+    cvec         **cvkv = NULL;
+    clixon_xvec   *xv = NULL;
+    yang_stmt     *yx;
+    char           key[16];
+    uint32_t       nr;
+    uint32_t       i;
+    struct timeval t0;
+
+    nr = bench_lookups(bs, bs->bs_lookups);
+    yx = xml_spec(bs->bs_x);
+    if ((cvkv = calloc(nr, sizeof(cvec *))) == NULL){
+	clicon_err(OE_UNIX, errno, "calloc");
+	goto done;
+    }
+    for (i=0; i<nr; i++){
+	if ((cvkv[i] = cvec_new(0)) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_new");
+	    goto done;
+	}
+	snprintf(key, sizeof(key), "%u", bench_key(bs, i));
+	if (cvec_add_string(cvkv[i], "a", key) == NULL){
+	    clicon_err(OE_UNIX, errno, "cvec_add_string");
+	    goto done;
+	}
+    }
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	if ((xv = clixon_xvec_new()) == NULL)
+	    goto done;
+	if (clixon_xml_find_index(bs->bs_x, yx, NULL, "y", cvkv[i], xv) < 0)
+	    goto done;
+	if (clixon_xvec_len(xv) != 1){
+	    clicon_err(OE_XML, 0, "Lookup of %s failed", cv_string_get(cvec_i(cvkv[i], 0)));
+	    goto done;
+	}
+	clixon_xvec_free(xv);
+	xv = NULL;
+    }
+    *usec = bench_usec(&t0);
+    *ops = nr;
+    retval = 0;
+ done:
+    if (xv)
+	clixon_xvec_free(xv);
+    if (cvkv){
+	for (i=0; i<nr; i++)
+	    if (cvkv[i])
+		cvec_free(cvkv[i]);
+	free(cvkv);
+    }
+    return retval;
+}
+
+/*! Look up list entries by key with xpath_vec
+ * @param[in]  optimize  Enable list xpath optimization, see XPATH_LIST_OPTIMIZE
+ */
+static int
+bench_xpath_vec(bench_state *bs,
+		int          optimize,
+		uint32_t    *ops,
+		uint64_t    *usec)
+{
+    int            retval = -1;
+    cvec          *nsc = NULL;
+    cxobj        **vec = NULL;
+    size_t         veclen;
+    uint32_t       nr;
+    uint32_t       i;
+    struct timeval t0;
+
+    /* Without optimization each lookup is linear */
+    nr = bench_lookups(bs, optimize?bs->bs_lookups:bs->bs_lookups/10+1);
+    if ((nsc = xml_nsctx_init("b", BENCH_NS)) == NULL)
+	goto done;
+    xpath_list_optimize_set(optimize);
+    gettimeofday(&t0, NULL);
+    for (i=0; i<nr; i++){
+	if (xpath_vec(bs->bs_xt, nsc, "/b:x/b:y[b:a='%u']", &vec, &veclen, bench_key(bs, i)) < 0)
+	    goto done;
+	if (veclen != 1){
+	    clicon_err(OE_XML, 0, "Lookup of %u failed", bench_key(bs, i));
+	    goto done;
+	}
+	free(vec);
+	vec = NULL;
+    }
+    *usec = bench_usec(&t0);
+    *ops = nr;
+    retval = 0;
+ done:
+    xpath_list_optimize_set(1);
+    if (vec)
+	free(vec);
+    if (nsc)
+	cvec_free(nsc);
+    return retval;
+}
+
+static int
+bench_xpath(bench_state *bs,
+	    uint32_t    *ops,
+	    uint64_t    *usec)
+{
+    return bench_xpath_vec(bs, 1, ops, usec);
+}
+
+static int
+bench_xpath_noopt(bench_state *bs,
+		  uint32_t    *ops,
+		  uint64_t    *usec)
+{
+    return bench_xpath_vec(bs, 0, ops, usec);
+}
+
+/*! Diff the tree with a copy where one entry is changed
+ */
+static int
+bench_xml_diff(bench_state *bs,
+	       uint32_t    *ops,
+	       uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *x1 = NULL;
+    cxobj         *xy;
+    cxobj         *xb;
+    cxobj        **dvec = NULL;
+    cxobj        **avec = NULL;
+    cxobj        **scvec = NULL;
+    cxobj        **tcvec = NULL;
+    int            dlen;
+    int            alen;
+    int            clen;
+    struct timeval t0;
+
+    if ((x1 = xml_dup(bs->bs_xt)) == NULL)
+	goto done;
+    if ((xy = xpath_first(x1, NULL, "x/y[a='%u']", bs->bs_n/2)) != NULL &&
+	(xb = xpath_first(xy, NULL, "b")) != NULL)
+	if (xml_value_set(xml_body_get(xb), "changed") < 0)
+	    goto done;
+    gettimeofday(&t0, NULL);
+    if (xml_diff(bs->bs_yspec, bs->bs_xt, x1,
+		 &dvec, &dlen, &avec, &alen, &scvec, &tcvec, &clen) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    retval = 0;
+ done:
+    if (dvec)
+	free(dvec);
+    if (avec)
+	free(avec);
+    if (scvec)
+	free(scvec);
+    if (tcvec)
+	free(tcvec);
+    if (x1)
+	xml_free(x1);
+    return retval;
+}
+
+static int
+bench_validate(bench_state *bs,
+	       uint32_t    *ops,
+	       uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *xerr = NULL;
+    struct timeval t0;
+    int            ret;
+
+    gettimeofday(&t0, NULL);
+    if ((ret = xml_yang_validate_all_top(bs->bs_h, bs->bs_xt, &xerr)) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    if (ret == 0){
+	clicon_err(OE_YANG, 0, "Validation failed");
+	goto done;
+    }
+    *ops = 1;
+    retval = 0;
+ done:
+    if (xerr)
+	xml_free(xerr);
+    return retval;
+}
+
+/*! Replace candidate with the tree
+ */
+static int
+bench_xmldb_put(bench_state *bs,
+		uint32_t    *ops,
+		uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *xt = NULL;
+    cbuf          *cbret = NULL;
+    struct timeval t0;
+    int            ret;
+
+    if ((xt = xml_dup(bs->bs_xt)) == NULL)
+	goto done;
+    if (xml_name_set(xt, NETCONF_INPUT_CONFIG) < 0)
+	goto done;
+    if ((cbret = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    gettimeofday(&t0, NULL);
+    if ((ret = xmldb_put(bs->bs_h, "candidate", OP_REPLACE, xt, NULL, cbret)) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    if (ret == 0){
+	clicon_err(OE_DB, 0, "xmldb_put: %s", cbuf_get(cbret));
+	goto done;
+    }
+    *ops = 1;
+    retval = 0;
+ done:
+    if (cbret)
+	cbuf_free(cbret);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Edit a datastore with a copy of a config tree, not timed
+ * @param[in]  bs    Benchmark input
+ * @param[in]  db    Datastore
+ * @param[in]  op    Top-level operation
+ * @param[in]  x     Config tree, top-level symbol is renamed to <config>
+ */
+static int
+bench_ds_edit(bench_state        *bs,
+	      const char         *db,
+	      enum operation_type op,
+	      cxobj              *x)
+{
+    int    retval = -1;
+    cxobj *xt = NULL;
+    cbuf  *cbret = NULL;
+    int    ret;
+
+    if ((xt = xml_dup(x)) == NULL)
+	goto done;
+    if (xml_name_set(xt, NETCONF_INPUT_CONFIG) < 0)
+	goto done;
+    if ((cbret = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    if ((ret = xmldb_put(bs->bs_h, db, op, xt, NULL, cbret)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_DB, 0, "xmldb_put: %s", cbuf_get(cbret));
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (cbret)
+	cbuf_free(cbret);
+    if (xt)
+	xml_free(xt);
+    return retval;
+}
+
+/*! Replace running with the whole datastore config, including file write
+ * @note the copy of the config made by bench_ds_edit is included in the time
+ */
+static int
+bench_ds_put(bench_state *bs,
+	     uint32_t    *ops,
+	     uint64_t    *usec)
+{
+    struct timeval t0;
+
+    gettimeofday(&t0, NULL);
+    if (bench_ds_edit(bs, "running", OP_REPLACE, bs->bs_dxt) < 0)
+	return -1;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    return 0;
+}
+
+/*! Merge a change of one entry into running, ie a small edit of a large datastore
+ */
+static int
+bench_ds_merge(bench_state *bs,
+	       uint32_t    *ops,
+	       uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *x = NULL;
+    struct timeval t0;
+
+    if (clixon_xml_parse_va(YB_MODULE, bs->bs_yspec, &x, NULL,
+			    "<d xmlns=\"%s\"><if><name>if%u</name><mtu>9000</mtu></if></d>",
+			    BENCH_NS, bs->bs_n/2) < 0)
+	goto done;
+    gettimeofday(&t0, NULL);
+    if (bench_ds_edit(bs, "running", OP_MERGE, x) < 0)
+	goto done;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    retval = 0;
+ done:
+    if (x)
+	xml_free(x);
+    return retval;
+}
+
+/*! Read the whole of running with defaults, as the backend does for get-config
+ */
+static int
+bench_ds_get(bench_state *bs,
+	     uint32_t    *ops,
+	     uint64_t    *usec)
+{
+    int            retval = -1;
+    cxobj         *xt = NULL;
+    struct timeval t0;
+
+    gettimeofday(&t0, NULL);
+    if (xmldb_get0(bs->bs_h, "running", YB_MODULE, NULL, "/", 0, &xt, NULL) < 0)
+	goto done;
+    if (xmldb_get0_clear(bs->bs_h, xt) < 0)
+	goto done;
+    xmldb_get0_free(bs->bs_h, &xt);
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    retval = 0;
+ done:
+    if (xt)
+	xmldb_get0_free(bs->bs_h, &xt);
+    return retval;
+}
+
+/*! Copy running to startup
+ */
+static int
+bench_ds_copy(bench_state *bs,
+	      uint32_t    *ops,
+	      uint64_t    *usec)
+{
+    struct timeval t0;
+
+    gettimeofday(&t0, NULL);
+    if (xmldb_copy(bs->bs_h, "running", "startup") < 0)
+	return -1;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    return 0;
+}
+
+/*! Delete startup, a copy of running
+ */
+static int
+bench_ds_delete(bench_state *bs,
+		uint32_t    *ops,
+		uint64_t    *usec)
+{
+    struct timeval t0;
+
+    if (xmldb_copy(bs->bs_h, "running", "startup") < 0)
+	return -1;
+    gettimeofday(&t0, NULL);
+    if (xmldb_delete(bs->bs_h, "startup") < 0)
+	return -1;
+    *usec = bench_usec(&t0);
+    *ops = 1;
+    return 0;
+}
+
+/* All benchmarks in the order they are run */
+static struct {
+    char     *bn_name;
+    bench_fn *bn_fn;
+    int       bn_ds;   /* Datastore benchmark, run per cache mode */
+} BENCHMARKS[] = {
+    {"xml_parse",   bench_xml_parse, 0},
+    {"xml_bind",    bench_xml_bind, 0},
+    {"xml_print",   bench_xml_print, 0},
+    {"xml_apply",   bench_xml_apply, 0},
+    {"json_parse",  bench_json_parse, 0},
+    {"json_print",  bench_json_print, 0},
+    {"xml_sort",    bench_xml_sort, 0},
+    {"find_index",  bench_find_index, 0},
+    {"xpath",       bench_xpath, 0},
+    {"xpath_noopt", bench_xpath_noopt, 0},
+    {"xml_diff",    bench_xml_diff, 0},
+    {"validate",    bench_validate, 0},
+    {"xmldb_put",   bench_xmldb_put, 0},
+    {"ds_put",      bench_ds_put, 1},
+    {"ds_merge",    bench_ds_merge, 1},
+    {"ds_get",      bench_ds_get, 1},
+    {"ds_copy",     bench_ds_copy, 1},
+    {"ds_delete",   bench_ds_delete, 1},
+    {NULL,          NULL, 0}
+};
+
+/*! Create input data of n list entries
+ * @param[in]  bs   Benchmark state, h, yspec and n set
+ */
+static int
+bench_state_init(bench_state *bs)
+{
+    int      retval = -1;
+    cbuf    *cb = NULL;
+    cbuf    *cbrev = NULL;
+    cbuf    *cbj = NULL;
+    cbuf    *cbd = NULL;
+    cxobj   *xerr = NULL;
+    uint32_t i;
+    uint32_t j;
+    int      ret;
+
+    if ((cb = cbuf_new()) == NULL ||
+	(cbrev = cbuf_new()) == NULL ||
+	(cbj = cbuf_new()) == NULL ||
+	(cbd = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cb, "<x xmlns=\"%s\">", BENCH_NS);
+    cprintf(cbrev, "<x xmlns=\"%s\">", BENCH_NS);
+    cprintf(cbj, "{\"%s:x\":{\"y\":[", BENCH_MODULE);
+    for (i=0; i<bs->bs_n; i++){
+	cprintf(cb, "<y><a>%u</a><b>v%u</b></y>", i, i);
+	cprintf(cbrev, "<y><a>%u</a><b>v%u</b></y>", bs->bs_n-i-1, bs->bs_n-i-1);
+	cprintf(cbj, "%s{\"a\":%u,\"b\":\"v%u\"}", i?",":"", i, i);
+    }
+    cprintf(cb, "</x>");
+    cprintf(cbrev, "</x>");
+    cprintf(cbj, "]}}");
+    if ((bs->bs_xml = strdup(cbuf_get(cb))) == NULL ||
+	(bs->bs_xmlrev = strdup(cbuf_get(cbrev))) == NULL ||
+	(bs->bs_json = strdup(cbuf_get(cbj))) == NULL){
+	clicon_err(OE_UNIX, errno, "strdup");
+	goto done;
+    }
+    if ((ret = clixon_xml_parse_string(bs->bs_xml, YB_MODULE, bs->bs_yspec, &bs->bs_xt, &xerr)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_XML, 0, "Parse of benchmark data failed");
+	goto done;
+    }
+    if ((bs->bs_x = xml_find_type(bs->bs_xt, NULL, "x", CX_ELMNT)) == NULL){
+	clicon_err(OE_XML, 0, "No benchmark data");
+	goto done;
+    }
+    /* Datastore config: if entries with addr sub-lists, and routes referring to them */
+    cprintf(cbd, "<d xmlns=\"%s\">", BENCH_NS);
+    for (i=0; i<bs->bs_n; i++){
+	cprintf(cbd, "<if><name>if%u</name>", i);
+	for (j=0; j<BENCH_ADDR; j++)
+	    cprintf(cbd, "<addr><ip>10.%u.%u.%u</ip></addr>", j, (i>>8)&0xff, i&0xff);
+	cprintf(cbd, "</if>");
+    }
+    for (i=0; i<bs->bs_n; i++)
+	cprintf(cbd, "<route><prefix>192.%u.%u.0/24</prefix><ifname>if%u</ifname></route>",
+		(i>>8)&0xff, i&0xff, i);
+    cprintf(cbd, "</d>");
+    if ((ret = clixon_xml_parse_string(cbuf_get(cbd), YB_MODULE, bs->bs_yspec, &bs->bs_dxt, &xerr)) < 0)
+	goto done;
+    if (ret == 0){
+	clicon_err(OE_XML, 0, "Parse of datastore benchmark data failed");
+	goto done;
+    }
+    retval = 0;
+ done:
+    if (xerr)
+	xml_free(xerr);
+    if (cbd)
+	cbuf_free(cbd);
+    if (cb)
+	cbuf_free(cb);
+    if (cbrev)
+	cbuf_free(cbrev);
+    if (cbj)
+	cbuf_free(cbj);
+    return retval;
+}
+
+static void
+bench_state_free(bench_state *bs)
+{
+    if (bs->bs_xml)
+	free(bs->bs_xml);
+    if (bs->bs_xmlrev)
+	free(bs->bs_xmlrev);
+    if (bs->bs_json)
+	free(bs->bs_json);
+    if (bs->bs_xt)
+	xml_free(bs->bs_xt);
+    if (bs->bs_dxt)
+	xml_free(bs->bs_dxt);
+    memset(bs, 0, sizeof(*bs));
+}
+
+/*! Check if a benchmark is selected on the command line
+ * @param[in]  name  Benchmark name
+ * @param[in]  argc  Nr of selected benchmarks, 0 means all
+ * @param[in]  argv  Names of selected benchmarks
+ */
+static int
+bench_selected(char  *name,
+	       int    argc,
+	       char **argv)
+{
+    int i;
+
+    if (argc == 0)
+	return 1;
+    for (i=0; i<argc; i++)
+	if (strcmp(argv[i], name) == 0)
+	    return 1;
+    return 0;
+}
+
+/*! Run a benchmark a number of rounds and print its result line
+ * @param[in]  bs      Benchmark input
+ * @param[in]  fn      Benchmark function
+ * @param[in]  name    Name of benchmark in output
+ * @param[in]  rounds  Nr of rounds
+ * @retval     0       OK
+ * @retval    -1       Error
+ * Peak RSS is of the whole process so far, it does not decrease between benchmarks
+ */
+static int
+bench_run(bench_state *bs,
+	  bench_fn    *fn,
+	  char        *name,
+	  uint32_t     rounds)
+{
+    uint32_t      ops = 0;
+    uint64_t      usec;
+    uint64_t      umin = UINT64_MAX;
+    uint64_t      usum = 0;
+    uint64_t      uavg;
+    uint32_t      r;
+    struct rusage ru = {0,};
+
+    for (r=0; r<rounds; r++){
+	usec = 0;
+	if (fn(bs, &ops, &usec) < 0)
+	    return -1;
+	if (usec < umin)
+	    umin = usec;
+	usum += usec;
+    }
+    uavg = usum/rounds;
+    getrusage(RUSAGE_SELF, &ru);
+    fprintf(stdout, "%s %u %u %u %" PRIu64 " %" PRIu64 " %" PRIu64 " %ld\n",
+	    name, bs->bs_n, ops, rounds, umin, uavg,
+	    uavg ? (uint64_t)ops*1000000/uavg : 0,
+	    ru.ru_maxrss);
+    fflush(stdout);
+    return 0;
+}
+
+/*! Set datastore cache mode and populate running with the datastore benchmark config
+ * @param[in]  bs      Benchmark input
+ * @param[in]  mode    Value of CLICON_DATASTORE_CACHE
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+bench_ds_mode(bench_state *bs,
+	      char        *mode)
+{
+    clicon_handle h = bs->bs_h;
+
+    if (clicon_option_str_set(h, "CLICON_DATASTORE_CACHE", mode) < 0)
+	return -1;
+    if (clicon_datastore_cache(h) < 0){
+	clicon_err(OE_CFG, 0, "Unknown datastore cache mode: %s", mode);
+	return -1;
+    }
+    /* Drop caches of the previous mode */
+    if (xmldb_clear(h, "running") < 0)
+	return -1;
+    if (xmldb_delete(h, "startup") < 0)
+	return -1;
+    return bench_ds_edit(bs, "running", OP_REPLACE, bs->bs_dxt);
+}
+
+/*! usage
+ */
+static void
+usage(char *argv0)
+{
+    int i;
+
+    fprintf(stderr, "usage:%s <options>* [<benchmark>]*\n"
+		"where options are\n"
+		"\t-h\t\tHelp\n"
+		"\t-D\t\tDebug\n"
+		"\t-b <dir>\tBenchmark directory for yang and datastore files. Mandatory\n"
+		"\t-n <nr>[,<nr>]*\tList sizes. Default: 1000,10000,100000\n"
+		"\t-r <nr>\t\tRounds of each benchmark. Default: 3\n"
+		"\t-l <nr>\t\tMax lookups per round. Default: 1000\n"
+		"\t-c <mode>[,<mode>]*\tDatastore cache modes of ds_* benchmarks. Default: nocache,cache,cache-zerocopy\n"
+		"and benchmark is one of (default all):\n",
+		argv0);
+    for (i=0; BENCHMARKS[i].bn_name; i++)
+	fprintf(stderr, "\t%s\n", BENCHMARKS[i].bn_name);
+    exit(0);
+}
+
+int
+main(int argc, char **argv)
+{
+    int           retval = -1;
+    int           c;
+    clicon_handle h;
+    char         *argv0;
+    char         *dbdir = NULL;
+    char         *sizes = "1000,10000,100000";
+    char        **svec = NULL;
+    int           nsvec;
+    char         *modes = "nocache,cache,cache-zerocopy";
+    char        **mvec = NULL;
+    int           nmvec;
+    uint32_t      rounds = 3;
+    uint32_t      lookups = 1000;
+    yang_stmt    *yspec = NULL;
+    cbuf         *cbf = NULL;
+    FILE         *f = NULL;
+    bench_state   bs = {0,};
+    int           i;
+    int           j;
+    int           k;
+    int           dbg = 0;
+
+    /* In the startup, logs to stderr & debug flag set later */
+    clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR); 
+
+    argv0 = argv[0];
+    if ((h = clicon_handle_init()) == NULL)
+	goto done;
+    clicon_option_str_set(h, "CLICON_XMLDB_FORMAT", "xml"); /* default */
+    while ((c = getopt(argc, argv, BENCH_OPTS)) != -1)
+	switch (c) {
+	case '?' :
+	case 'h' : /* help */
+	    usage(argv0);
+	    break;
+	case 'D' : /* debug */
+	    dbg = 1;	
+	    break;
+	case 'b': /* benchmark directory */
+	    dbdir = optarg;
+	    break;
+	case 'n': /* list sizes */
+	    sizes = optarg;
+	    break;
+	case 'r': /* rounds */
+	    if ((rounds = atoi(optarg)) == 0)
+		usage(argv0);
+	    break;
+	case 'l': /* lookups */
+	    if ((lookups = atoi(optarg)) == 0)
+		usage(argv0);
+	    break;
+	case 'c': /* datastore cache modes */
+	    modes = optarg;
+	    break;
+	}
+    clicon_log_init(__FILE__, dbg?LOG_DEBUG:LOG_INFO, CLICON_LOG_STDERR); 
+    clicon_debug_init(dbg, NULL); 
+    argc -= optind;
+    argv += optind;
+    for (i=0; i<argc; i++){
+	for (j=0; BENCHMARKS[j].bn_name; j++)
+	    if (strcmp(argv[i], BENCHMARKS[j].bn_name) == 0)
+		break;
+	if (BENCHMARKS[j].bn_name == NULL){
+	    clicon_err(OE_UNIX, 0, "Unknown benchmark: %s", argv[i]);
+	    usage(argv0);
+	}
+    }
+    if (dbdir == NULL){
+	clicon_err(OE_DB, 0, "Missing benchmark dir -b option");
+	goto done;
+    }
+    /* Yang of benchmark data */
+    if ((cbf = cbuf_new()) == NULL){
+	clicon_err(OE_UNIX, errno, "cbuf_new");
+	goto done;
+    }
+    cprintf(cbf, "%s/%s.yang", dbdir, BENCH_MODULE);
+    if ((f = fopen(cbuf_get(cbf), "w")) == NULL){
+	clicon_err(OE_UNIX, errno, "fopen(%s)", cbuf_get(cbf));
+	goto done;
+    }
+    fprintf(f, "%s", BENCH_YANG);
+    fclose(f);
+    if ((yspec = yspec_new()) == NULL)
+	goto done;
+    if (yang_spec_parse_file(h, cbuf_get(cbf), yspec) < 0)
+	goto done;
+    clicon_dbspec_yang_set(h, yspec);
+    clicon_option_str_set(h, "CLICON_XMLDB_DIR", dbdir);
+    if (xmldb_connect(h) < 0)
+	goto done;
+    if (xmldb_create(h, "candidate") < 0)
+	goto done;
+    if ((svec = clicon_strsep(sizes, ",", &nsvec)) == NULL)
+	goto done;
+    if ((mvec = clicon_strsep(modes, ",", &nmvec)) == NULL)
+	goto done;
+    fprintf(stdout, "# name n ops rounds usec_min usec_avg per_sec rss_kb\n");
+    for (i=0; i<nsvec; i++){
+	bs.bs_h = h;
+	bs.bs_yspec = yspec;
+	bs.bs_lookups = lookups;
+	if ((bs.bs_n = atoi(svec[i])) == 0)
+	    continue;
+	if (bench_state_init(&bs) < 0)
+	    goto done;
+	for (j=0; BENCHMARKS[j].bn_name; j++){
+	    if (BENCHMARKS[j].bn_ds ||
+		!bench_selected(BENCHMARKS[j].bn_name, argc, argv))
+		continue;
+	    if (bench_run(&bs, BENCHMARKS[j].bn_fn, BENCHMARKS[j].bn_name, rounds) < 0)
+		goto done;
+	}
+	/* Datastore benchmarks, once per cache mode */
+	for (k=0; k<nmvec; k++){
+	    for (j=0; BENCHMARKS[j].bn_name; j++)
+		if (BENCHMARKS[j].bn_ds &&
+		    bench_selected(BENCHMARKS[j].bn_name, argc, argv))
+		    break;
+	    if (BENCHMARKS[j].bn_name == NULL)
+		break;
+	    if (bench_ds_mode(&bs, mvec[k]) < 0)
+		goto done;
+	    for (j=0; BENCHMARKS[j].bn_name; j++){
+		if (!BENCHMARKS[j].bn_ds ||
+		    !bench_selected(BENCHMARKS[j].bn_name, argc, argv))
+		    continue;
+		cbuf_reset(cbf);
+		cprintf(cbf, "%s/%s", BENCHMARKS[j].bn_name, mvec[k]);
+		if (bench_run(&bs, BENCHMARKS[j].bn_fn, cbuf_get(cbf), rounds) < 0)
+		    goto done;
+	    }
+	}
+	bench_state_free(&bs);
+    }
+    if (xmldb_disconnect(h) < 0)
+	goto done;
+    retval = 0;
+ done:
+    bench_state_free(&bs);
+    if (svec)
+	free(svec);
+    if (mvec)
+	free(mvec);
+    if (cbf)
+	cbuf_free(cbf);
+    if (h)
+	clicon_handle_exit(h);
+    if (yspec)
+	ys_free(yspec);
+    return retval;
+}
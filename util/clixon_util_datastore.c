@@ -65,7 +65,7 @@
 #include <clixon/clixon.h>
 
 /* Command line options to be passed to getopt(3) */
-#define DATASTORE_OPTS "hDd:b:f:x:y:"
+#define DATASTORE_OPTS "hDd:b:f:ij:sx:y:z:"
 
 /*! usage
  */
@@ -78,9 +78,13 @@ usage(char *argv0)
 		"\t-D\t\tDebug\n"
 		"\t-d <db>\t\tDatabase name. Default: running. Alt: candidate,startup\n"
 		"\t-b <dir>\tDatabase directory. Mandatory\n"
-	        "\t-f <fmt>\tDatabase format: xml or json\n"
+	        "\t-f <fmt>\tDatabase format: xml, json or cbor\n"
+		"\t-i\t\tNo datastore cache, read from image of datastore file\n"
+		"\t-j <nr>\tJournal mode: append edits and compact after <nr> records (0: never)\n"
+		"\t-s\t\tShard datastore files per module\n"
 		"\t-x <xml>\tXML file. Alternative to put <xml> argument\n"
-		"\t-y <file>\tYang file. Mandatory\n"
+		"\t-y <file>\tYang file. Mandatory, may be repeated\n"
+		"\t-z <level>\tCompress datastore files with zstd at <level>\n"
 		"and command is either:\n"
 		"\tget [<xpath>]\n"
  	        "\tmget <nr> [<xpath>]\n"
@@ -109,7 +113,8 @@ main(int argc, char **argv)
     char               *db = "running";
     char               *cmd = NULL;
     yang_stmt          *yspec = NULL;
-    char               *yangfilename = NULL;
+    cvec               *yangfiles = NULL;
+    cg_var             *cv;
     char               *xmlfilename = NULL;
     char               *dbdir = NULL;
     int                 ret;
@@ -155,6 +160,19 @@ main(int argc, char **argv)
 	        usage(argv0);
 	    clicon_option_str_set(h, "CLICON_XMLDB_FORMAT", optarg);
 	    break;
+	case 'i': /* nocache with file image */
+	    clicon_option_str_set(h, "CLICON_DATASTORE_CACHE", "nocache");
+	    clicon_option_str_set(h, "CLICON_XMLDB_IMAGE", "true");
+	    break;
+	case 'j': /* journal mode */
+	    if (!optarg)
+	        usage(argv0);
+	    clicon_option_str_set(h, "CLICON_XMLDB_PERSIST", "journal");
+	    clicon_option_str_set(h, "CLICON_XMLDB_JOURNAL_COMPACT", optarg);
+	    break;
+	case 's': /* shard per module */
+	    clicon_option_str_set(h, "CLICON_XMLDB_SHARD", "true");
+	    break;
 	case 'x': /* XML file */
 	    if (!optarg)
 	        usage(argv0);
@@ -163,7 +181,16 @@ main(int argc, char **argv)
 	case 'y': /* Yang file */
 	    if (!optarg)
 	        usage(argv0);
-	    yangfilename = optarg;
+	    if (yangfiles == NULL && (yangfiles = cvec_new(0)) == NULL){
+		clicon_err(OE_UNIX, errno, "cvec_new");
+		goto done;
+	    }
+	    cvec_add_string(yangfiles, NULL, optarg);
+	    break;
+	case 'z': /* compression level */
+	    if (!optarg)
+	        usage(argv0);
+	    clicon_option_str_set(h, "CLICON_XMLDB_COMPRESS", optarg);
 	    break;
 	}
     /* 
@@ -181,7 +208,7 @@ main(int argc, char **argv)
 	clicon_err(OE_DB, 0, "Missing dbdir -b option");
 	goto done;
     }
-    if (yangfilename == NULL){
+    if (yangfiles == NULL){
 	clicon_err(OE_YANG, 0, "Missing yang filename -y option");
 	goto done;
     }
@@ -192,8 +219,10 @@ main(int argc, char **argv)
     if ((yspec = yspec_new()) == NULL)
 	goto done;
     /* Parse yang spec from given file */
-    if (yang_spec_parse_file(h, yangfilename, yspec) < 0)
-	goto done;
+    cv = NULL;
+    while ((cv = cvec_each(yangfiles, cv)) != NULL)
+	if (yang_spec_parse_file(h, cv_string_get(cv), yspec) < 0)
+	    goto done;
     clicon_option_str_set(h, "CLICON_XMLDB_DIR", dbdir);
     clicon_dbspec_yang_set(h, yspec);
     if (strcmp(cmd, "get")==0){
@@ -346,6 +375,8 @@ main(int argc, char **argv)
 	clicon_handle_exit(h);
     if (yspec)
 	ys_free(yspec);
+    if (yangfiles)
+	cvec_free(yangfiles);
     return retval;
 }
 
@@ -61,6 +61,28 @@
 /* clixon */
 #include "clixon/clixon.h"
 
+/*! Write all of a buffer to a socket
+ */
+static int
+write_all(int    s,
+	  char  *buf,
+	  size_t len)
+{
+    ssize_t n;
+
+    while (len > 0){
+	if ((n = write(s, buf, len)) < 0){
+	    if (errno == EINTR)
+		continue;
+	    clicon_err(OE_UNIX, errno, "write");
+	    return -1;
+	}
+	buf += n;
+	len -= n;
+    }
+    return 0;
+}
+
 static int
 usage(char *argv0)
 {
@@ -72,6 +94,9 @@ usage(char *argv0)
 	    "\t-s <sockpath> \tPath to unix domain socket (or IP addr)\n"
 	    "\t-f <file>\tXML input file (overrides stdin)\n"
 	    "\t-J \t\tInput as JSON (instead of XML)\n"
+	    "\t-P \t\tPipelined: send each top-level element as a request on one session\n"
+	    "\t\t\twithout waiting for replies, print replies in order on one line\n"
+	    "\t-S <ms> \tSplit: send first half of message, wait <ms> ms, then the rest\n"
 	    ,
 	    argv0);
     exit(0);
@@ -85,6 +110,15 @@ main(int    argc,
     int                c;
     int                logdst = CLICON_LOG_STDERR;
     struct clicon_msg *msg = NULL;
+    struct clicon_msg *reply = NULL;
+    struct clicon_msg **msgv = NULL;
+    char              **retv = NULL;
+    int                len = 0;
+    int                pipelined = 0;
+    int                split = -1; /* ms between parts of message, -1 is not split */
+    uint32_t           mlen;
+    int                eof = 0;
+    int                i;
     char              *sockpath = NULL;
     char              *retdata = NULL;
     int                jsonin = 0;
@@ -108,7 +142,7 @@ main(int    argc,
 
     optind = 1;
     opterr = 0;
-    while ((c = getopt(argc, argv, "hD:s:f:Ja:")) != -1)
+    while ((c = getopt(argc, argv, "hD:s:f:Ja:PS:")) != -1)
 	switch (c) {
 	case 'h':
 	    usage(argv[0]);
@@ -129,6 +163,13 @@ main(int    argc,
 	case 'a':
 	    family = optarg;
 	    break;
+	case 'P':
+	    pipelined++;
+	    break;
+	case 'S':
+	    if (sscanf(optarg, "%d", &split) != 1 || split < 0)
+		usage(argv[0]);
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -165,10 +206,29 @@ main(int    argc,
 	fprintf(stderr, "No xml\n");
 	goto done;
     }
-    if (clicon_xml2cbuf(cb, xc, 0, 0, -1) < 0)
-	goto done;
-    if ((msg = clicon_msg_encode(getpid(), "%s", cbuf_get(cb))) < 0)
-	goto done;
+    if (pipelined){
+	if ((len = xml_child_nr_type(xt, CX_ELMNT)) == 0 ||
+	    (msgv = calloc(len, sizeof(*msgv))) == NULL ||
+	    (retv = calloc(len, sizeof(*retv))) == NULL){
+	    clicon_err(OE_UNIX, errno, "calloc");
+	    goto done;
+	}
+	xc = NULL;
+	i = 0;
+	while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL){
+	    cbuf_reset(cb);
+	    if (clicon_xml2cbuf(cb, xc, 0, 0, -1) < 0)
+		goto done;
+	    if ((msgv[i++] = clicon_msg_encode(getpid(), "%s", cbuf_get(cb))) == NULL)
+		goto done;
+	}
+    }
+    else {
+	if (clicon_xml2cbuf(cb, xc, 0, 0, -1) < 0)
+	    goto done;
+	if ((msg = clicon_msg_encode(getpid(), "%s", cbuf_get(cb))) == NULL)
+	    goto done;
+    }
     if (strcmp(family, "UNIX")==0){
 	if (clicon_rpc_connect_unix(h, sockpath, &s) < 0)
 	    goto done;
@@ -176,10 +236,37 @@ main(int    argc,
     else
 	if (clicon_rpc_connect_inet(h, sockpath, 4535, &s) < 0)
 	    goto done;
-    if (clicon_rpc(s, msg, &retdata) < 0)
-	goto done;
-    close(s);
-    fprintf(stdout, "%s\n", retdata);
+    if (pipelined){
+	if (clicon_rpc_vec(s, msgv, len, retv) < 0)
+	    goto done;
+	close(s);
+	for (i=0; i<len; i++)
+	    fprintf(stdout, "%s", retv[i]);
+	fprintf(stdout, "\n");
+    }
+    else if (split >= 0){
+	/* A stalled client: the backend should serve other clients meanwhile */
+	mlen = ntohl(msg->op_len);
+	if (write_all(s, (char*)msg, mlen/2) < 0)
+	    goto done;
+	usleep(split*1000);
+	if (write_all(s, (char*)msg + mlen/2, mlen - mlen/2) < 0)
+	    goto done;
+	if (clicon_msg_rcv(s, &reply, &eof) < 0)
+	    goto done;
+	close(s);
+	if (eof){
+	    fprintf(stderr, "Unexpected close of socket\n");
+	    goto done;
+	}
+	fprintf(stdout, "%s\n", reply->op_body);
+    }
+    else {
+	if (clicon_rpc(s, msg, &retdata) < 0)
+	    goto done;
+	close(s);
+	fprintf(stdout, "%s\n", retdata);
+    }
     retval = 0;
  done:
     if (fp)
@@ -190,6 +277,22 @@ main(int    argc,
 	xml_free(xt);
     if (msg)
 	free(msg);
+    if (reply)
+	free(reply);
+    if (msgv){
+	for (i=0; i<len; i++)
+	    if (msgv[i])
+		free(msgv[i]);
+	free(msgv);
+    }
+    if (retv){
+	for (i=0; i<len; i++)
+	    if (retv[i])
+		free(retv[i]);
+	free(retv);
+    }
+    if (retdata)
+	free(retdata);
     if (cb)
 	cbuf_free(cb);
     return retval;
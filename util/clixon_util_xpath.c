@@ -59,7 +59,7 @@ See https://www.w3.org/TR/xpath/
 #include "clixon/clixon.h"
 
 /* Command line options to be passed to getopt(3) */
-#define XPATH_OPTS "hD:f:p:i:n:cl:y:Y:"
+#define XPATH_OPTS "hD:f:p:i:n:cl:y:Y:sP"
 
 static int
 usage(char *argv0)
@@ -76,6 +76,8 @@ usage(char *argv0)
 	    "\t-l <s|e|o|f<file>> \tLog on (s)yslog, std(e)rr, std(o)ut or (f)ile (stderr is default)\n"
 	    "\t-y <filename> \tYang filename or dir (load all files)\n"
     	    "\t-Y <dir> \tYang dirs (can be several)\n"
+	    "\t-s \t\tPrint xpath list optimize statistics\n"
+	    "\t-P \t\tPrint xpath parse tree annotated with profiling counters\n"
 	    "and the following extra rules:\n"
 	    "\tif -f is not given, XML input is expected on stdin\n"
 	    "\tif -p is not given, <xpath> is expected as the first line on stdin\n"
@@ -143,6 +145,11 @@ main(int    argc,
     cxobj      *xerr = NULL; /* malloced must be freed */
     int         logdst = CLICON_LOG_STDERR;
     int         dbg = 0;
+    int         stats = 0;
+    int         profile = 0;
+    cbuf       *cbp = NULL;   /* Profile output */
+    int         hits;
+    int         pattern[XPO_NR];
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init("xpath", LOG_DEBUG, logdst); 
@@ -217,6 +224,12 @@ main(int    argc,
 	    if (clicon_option_add(h, "CLICON_YANG_DIR", optarg) < 0)
 		goto done;
 	    break;
+	case 's': /* Print optimize statistics */
+	    stats = 1;
+	    break;
+	case 'P': /* Print profile */
+	    profile = 1;
+	    break;
 	default:
 	    usage(argv[0]);
 	    break;
@@ -352,17 +365,36 @@ main(int    argc,
     }
     else
 	x = x0;
-    if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
+    xpath_list_optimize_stats(&hits, NULL); /* reset */
+    if (profile){
+	if ((cbp = cbuf_new()) == NULL){
+	    clicon_err(OE_XML, errno, "cbuf_new");
+	    goto done;
+	}
+	if (xpath_profile(x, nsc, xpath, 0, &xc, cbp) < 0)
+	    return -1;
+    }
+    else if (xpath_vec_ctx(x, nsc, xpath, 0, &xc) < 0)
 	return -1;
     /* Print results */
     cb = cbuf_new();
     ctx_print2(cb, xc);
     fprintf(stdout, "%s\n", cbuf_get(cb));
+    if (cbp)
+	fprintf(stdout, "%s", cbuf_get(cbp));
+    if (stats){
+	xpath_list_optimize_stats(&hits, pattern);
+	fprintf(stdout, "optimize:%d key:%d and:%d index:%d range:%d\n",
+		hits, pattern[XPO_KEY], pattern[XPO_KEY_AND], pattern[XPO_INDEX],
+		pattern[XPO_RANGE]);
+    }
  ok:
     retval = 0;
  done:
     if (cb)
 	cbuf_free(cb);
+    if (cbp)
+	cbuf_free(cbp);
     if (nsc)
 	xml_nsctx_free(nsc);
     if (xc)